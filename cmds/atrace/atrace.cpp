@@ -26,12 +26,16 @@
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
+#include <sys/stat.h>
 #include <time.h>
 #include <unistd.h>
 #include <zlib.h>
 
+#include <algorithm>
 #include <fstream>
 #include <memory>
+#include <thread>
+#include <vector>
 
 #include <binder/IBinder.h>
 #include <binder/IServiceManager.h>
@@ -920,6 +924,61 @@ static bool preferSdkCategories() {
     return setPreferSdkProperty(tags);
 }
 
+// Move data from the tracing pipe to outFd with splice(2), so that it is not copied through
+// userspace. Returns false without having moved anything if the kernel or outFd does not support
+// it.
+static bool spliceTrace(int traceFD, int outFd)
+{
+    struct stat st;
+    if (fstat(outFd, &st) == -1 ||
+            !(S_ISFIFO(st.st_mode) || S_ISREG(st.st_mode) || S_ISSOCK(st.st_mode))) {
+        return false;
+    }
+
+    // splice needs a pipe on one end, so go through an intermediate one unless outFd is a pipe.
+    int pipeFds[2] = {-1, -1};
+    const bool direct = S_ISFIFO(st.st_mode);
+    if (!direct && pipe2(pipeFds, O_CLOEXEC) == -1) {
+        return false;
+    }
+    const int spliceFd = direct ? outFd : pipeFds[1];
+
+    constexpr size_t kSpliceSize = 64 * 1024;
+    bool spliced = false;
+    while (!g_traceAborted) {
+        ssize_t bytes_in = splice(traceFD, nullptr, spliceFd, nullptr, kSpliceSize,
+                                  SPLICE_F_MOVE);
+        if (bytes_in <= 0) {
+            if (bytes_in == -1 && errno == EINVAL && !spliced) {
+                break;
+            }
+            if (bytes_in == -1 && !g_traceAborted) {
+                fprintf(stderr, "splice returned err %d (%s)\n", errno, strerror(errno));
+            }
+            spliced = true;
+            break;
+        }
+        spliced = true;
+
+        while (!direct && bytes_in > 0) {
+            ssize_t bytes_out = splice(pipeFds[0], nullptr, outFd, nullptr, bytes_in,
+                                       SPLICE_F_MOVE);
+            if (bytes_out <= 0) {
+                fprintf(stderr, "error writing trace: %s (%d)\n", strerror(errno), errno);
+                g_traceAborted = true;
+                break;
+            }
+            bytes_in -= bytes_out;
+        }
+    }
+
+    if (!direct) {
+        close(pipeFds[0]);
+        close(pipeFds[1]);
+    }
+    return spliced;
+}
+
 // Read data from the tracing pipe and forward to stdout
 static void streamTrace()
 {
@@ -930,6 +989,11 @@ static void streamTrace()
                 strerror(errno), errno);
         return;
     }
+    fflush(stdout);
+    if (spliceTrace(traceFD, STDOUT_FILENO)) {
+        close(traceFD);
+        return;
+    }
     while (!g_traceAborted) {
         ssize_t bytes_read = read(traceFD, trace_data, 4096);
         if (bytes_read > 0) {
@@ -943,95 +1007,129 @@ static void streamTrace()
             break;
         }
     }
+    close(traceFD);
 }
 
-// Read the current kernel trace and write it to stdout.
-static void dumpTrace(int outFd)
+// A chunk of the trace, compressed independently as a raw deflate stream.
+struct CompressedChunk {
+    std::vector<uint8_t> in;
+    std::vector<uint8_t> out;
+    uLong adler = 0;
+    bool ok = false;
+};
+
+// Compress the chunk, ending with a sync flush so that chunks can be concatenated into a single
+// stream, or with the final block if finish is set.
+static void compressChunk(CompressedChunk* chunk, bool finish)
 {
-    ALOGI("Dumping trace");
-    int traceFD = open((g_traceFolder + k_tracePath).c_str(), O_RDWR);
-    if (traceFD == -1) {
-        fprintf(stderr, "error opening %s: %s (%d)\n", k_tracePath,
-                strerror(errno), errno);
+    z_stream zs;
+    memset(&zs, 0, sizeof(zs));
+    chunk->ok = false;
+    if (deflateInit2(&zs, Z_DEFAULT_COMPRESSION, Z_DEFLATED, -MAX_WBITS, 8,
+                     Z_DEFAULT_STRATEGY) != Z_OK) {
         return;
     }
 
-    if (g_compress) {
-        z_stream zs;
-        memset(&zs, 0, sizeof(zs));
-
-        int result = deflateInit(&zs, Z_DEFAULT_COMPRESSION);
-        if (result != Z_OK) {
-            fprintf(stderr, "error initializing zlib: %d\n", result);
-            close(traceFD);
-            return;
-        }
+    // Leave room for the sync flush marker on top of the worst case expansion.
+    chunk->out.resize(deflateBound(&zs, chunk->in.size()) + 16);
+    zs.next_in = chunk->in.data();
+    zs.avail_in = chunk->in.size();
+    zs.next_out = chunk->out.data();
+    zs.avail_out = chunk->out.size();
 
-        constexpr size_t bufSize = 64*1024;
-        std::unique_ptr<uint8_t> in(new uint8_t[bufSize]);
-        std::unique_ptr<uint8_t> out(new uint8_t[bufSize]);
-        if (!in || !out) {
-            fprintf(stderr, "couldn't allocate buffers\n");
-            close(traceFD);
-            return;
-        }
-
-        int flush = Z_NO_FLUSH;
-
-        zs.next_out = reinterpret_cast<Bytef*>(out.get());
-        zs.avail_out = bufSize;
+    int result = deflate(&zs, finish ? Z_FINISH : Z_SYNC_FLUSH);
+    chunk->ok = (finish ? result == Z_STREAM_END : result == Z_OK) && zs.avail_in == 0;
+    chunk->out.resize(chunk->out.size() - zs.avail_out);
+    chunk->adler = adler32(adler32(0L, Z_NULL, 0), chunk->in.data(), chunk->in.size());
+    deflateEnd(&zs);
+}
 
-        do {
+// Read the trace and write it to outFd as a zlib stream. The trace is split into chunks that are
+// deflated in parallel and concatenated, so that compressing a large buffer is not bound to a
+// single core. Chunks do not share history, which costs a negligible amount of compression.
+static void compressTrace(int traceFD, int outFd)
+{
+    constexpr size_t kChunkSize = 1024 * 1024;
+    const size_t nThreads = std::clamp(std::thread::hardware_concurrency(), 1u, 4u);
+    std::vector<CompressedChunk> chunks(nThreads);
+
+    // zlib header for the default compression level and a 32K window.
+    static const uint8_t kZlibHeader[] = {0x78, 0x9c};
+    if (!android::base::WriteFully(outFd, kZlibHeader, sizeof(kZlibHeader))) {
+        fprintf(stderr, "error writing deflated trace: %s (%d)\n", strerror(errno), errno);
+        return;
+    }
 
-            if (zs.avail_in == 0) {
-                // More input is needed.
-                result = read(traceFD, in.get(), bufSize);
-                if (result < 0) {
-                    fprintf(stderr, "error reading trace: %s (%d)\n",
-                            strerror(errno), errno);
-                    result = Z_STREAM_END;
-                    break;
-                } else if (result == 0) {
-                    flush = Z_FINISH;
-                } else {
-                    zs.next_in = reinterpret_cast<Bytef*>(in.get());
-                    zs.avail_in = result;
+    uLong adler = adler32(0L, Z_NULL, 0);
+    bool eof = false;
+    while (!eof) {
+        size_t nChunks = 0;
+        for (; nChunks < nThreads && !eof; nChunks++) {
+            CompressedChunk& chunk = chunks[nChunks];
+            chunk.in.resize(kChunkSize);
+            size_t size = 0;
+            while (size < kChunkSize) {
+                ssize_t rc = TEMP_FAILURE_RETRY(read(traceFD, chunk.in.data() + size,
+                                                     kChunkSize - size));
+                if (rc < 0) {
+                    fprintf(stderr, "error reading trace: %s (%d)\n", strerror(errno), errno);
                 }
-            }
-
-            if (zs.avail_out == 0) {
-                // Need to write the output.
-                result = write(outFd, out.get(), bufSize);
-                if ((size_t)result < bufSize) {
-                    fprintf(stderr, "error writing deflated trace: %s (%d)\n",
-                            strerror(errno), errno);
-                    result = Z_STREAM_END; // skip deflate error message
-                    zs.avail_out = bufSize; // skip the final write
+                if (rc <= 0) {
+                    eof = true;
                     break;
                 }
-                zs.next_out = reinterpret_cast<Bytef*>(out.get());
-                zs.avail_out = bufSize;
+                size += rc;
             }
+            chunk.in.resize(size);
+        }
 
-        } while ((result = deflate(&zs, flush)) == Z_OK);
-
-        if (result != Z_STREAM_END) {
-            fprintf(stderr, "error deflating trace: %s\n", zs.msg);
+        // The last chunk carries the final block, which may be empty.
+        std::vector<std::thread> threads;
+        for (size_t i = 0; i < nChunks; i++) {
+            const bool finish = eof && i == nChunks - 1;
+            threads.emplace_back(compressChunk, &chunks[i], finish);
+        }
+        for (auto& thread : threads) {
+            thread.join();
         }
 
-        if (zs.avail_out < bufSize) {
-            size_t bytes = bufSize - zs.avail_out;
-            result = write(outFd, out.get(), bytes);
-            if ((size_t)result < bytes) {
+        for (size_t i = 0; i < nChunks; i++) {
+            const CompressedChunk& chunk = chunks[i];
+            if (!chunk.ok) {
+                fprintf(stderr, "error deflating trace\n");
+                return;
+            }
+            if (!android::base::WriteFully(outFd, chunk.out.data(), chunk.out.size())) {
                 fprintf(stderr, "error writing deflated trace: %s (%d)\n",
                         strerror(errno), errno);
+                return;
             }
+            adler = adler32_combine(adler, chunk.adler, chunk.in.size());
         }
+    }
 
-        result = deflateEnd(&zs);
-        if (result != Z_OK) {
-            fprintf(stderr, "error cleaning up zlib: %d\n", result);
-        }
+    const uint8_t trailer[] = {
+        static_cast<uint8_t>(adler >> 24), static_cast<uint8_t>(adler >> 16),
+        static_cast<uint8_t>(adler >> 8), static_cast<uint8_t>(adler),
+    };
+    if (!android::base::WriteFully(outFd, trailer, sizeof(trailer))) {
+        fprintf(stderr, "error writing deflated trace: %s (%d)\n", strerror(errno), errno);
+    }
+}
+
+// Read the current kernel trace and write it to stdout.
+static void dumpTrace(int outFd)
+{
+    ALOGI("Dumping trace");
+    int traceFD = open((g_traceFolder + k_tracePath).c_str(), O_RDWR);
+    if (traceFD == -1) {
+        fprintf(stderr, "error opening %s: %s (%d)\n", k_tracePath,
+                strerror(errno), errno);
+        return;
+    }
+
+    if (g_compress) {
+        compressTrace(traceFD, outFd);
     } else {
         char buf[4096];
         ssize_t rc;
@@ -50,6 +50,8 @@ void WaitForTask(std::future<std::string> future, const std::string& title, int
 DumpPool::DumpPool(const std::string& tmp_root) : tmp_root_(tmp_root), shutdown_(false),
         log_duration_(true) {
     assert(!tmp_root.empty());
+    max_running_.fill(MAX_THREAD_COUNT);
+    running_.fill(0);
     deleteTempFiles(tmp_root_);
 }
 
@@ -58,7 +60,7 @@ DumpPool::~DumpPool() {
     if (shutdown_ || threads_.empty()) {
         return;
     }
-    while (!tasks_.empty()) tasks_.pop();
+    tasks_.clear();
 
     shutdown_ = true;
     condition_variable_.notify_all();
@@ -92,6 +94,13 @@ void DumpPool::deleteTempFiles() {
     deleteTempFiles(tmp_root_);
 }
 
+void DumpPool::setMaxConcurrentTasks(Resource resource, int max_tasks) {
+    assert(max_tasks > 0);
+    std::unique_lock lock(lock_);
+    max_running_[static_cast<size_t>(resource)] = max_tasks;
+    condition_variable_.notify_all();
+}
+
 void DumpPool::setLogDuration(bool log_duration) {
     log_duration_ = log_duration;
 }
@@ -163,18 +172,33 @@ void DumpPool::setThreadName(const pthread_t thread, int id) {
     pthread_setname_np(thread, name.data());
 }
 
+bool DumpPool::takeRunnableTaskLocked(QueuedTask* task) {
+    for (auto it = tasks_.begin(); it != tasks_.end(); ++it) {
+        const size_t resource = static_cast<size_t>(it->resource);
+        if (running_[resource] < max_running_[resource]) {
+            *task = std::move(*it);
+            tasks_.erase(it);
+            running_[resource]++;
+            return true;
+        }
+    }
+    return false;
+}
+
 void DumpPool::loop() {
     std::unique_lock lock(lock_);
     while (!shutdown_) {
-        if (tasks_.empty()) {
+        QueuedTask task;
+        if (!takeRunnableTaskLocked(&task)) {
             condition_variable_.wait(lock);
             continue;
         } else {
-            std::packaged_task<std::string()> task = std::move(tasks_.front());
-            tasks_.pop();
             lock.unlock();
-            std::invoke(task);
+            std::invoke(task.task);
             lock.lock();
+            running_[static_cast<size_t>(task.resource)]--;
+            // A task of the same resource may have been waiting for this one.
+            condition_variable_.notify_all();
         }
     }
 }
@@ -17,8 +17,9 @@
 #ifndef FRAMEWORK_NATIVE_CMD_DUMPPOOL_H_
 #define FRAMEWORK_NATIVE_CMD_DUMPPOOL_H_
 
+#include <array>
+#include <deque>
 #include <future>
-#include <queue>
 #include <string>
 
 #include <android-base/file.h>
@@ -76,6 +77,18 @@ class DumpPool {
   friend class android::os::dumpstate::DumpPoolTest;
 
   public:
+    /*
+     * The resource a task mostly uses. Tasks using the same resource slow each
+     * other down, so how many of them run at once can be limited with
+     * setMaxConcurrentTasks, while tasks using other resources keep running.
+     */
+    enum class Resource {
+        DEFAULT,  // binder calls and anything else
+        CPU,      // e.g. commands sampling or walking all processes
+        IO,       // e.g. copying large files
+        COUNT,
+    };
+
     /*
      * Creates a thread pool.
      *
@@ -110,9 +123,19 @@ class DumpPool {
      */
     template<class F, class... Args>
     std::future<std::string> enqueueTask(const std::string& duration_title, F&& f, Args&&... args) {
+        return enqueueTask(Resource::DEFAULT, duration_title, std::forward<F>(f),
+                std::forward<Args>(args)...);
+    }
+
+    /*
+     * Same as above, for a task mostly using |resource|.
+     */
+    template<class F, class... Args>
+    std::future<std::string> enqueueTask(Resource resource, const std::string& duration_title,
+            F&& f, Args&&... args) {
         std::function<void(void)> func = std::bind(std::forward<F>(f),
                 std::forward<Args>(args)...);
-        auto future = post(duration_title, func);
+        auto future = post(resource, duration_title, func);
         if (threads_.empty()) {
             start();
         }
@@ -130,15 +153,33 @@ class DumpPool {
      */
     template<class F, class... Args> std::future<std::string> enqueueTaskWithFd(
             const std::string& duration_title, F&& f, Args&&... args) {
+        return enqueueTaskWithFd(Resource::DEFAULT, duration_title, std::forward<F>(f),
+                std::forward<Args>(args)...);
+    }
+
+    /*
+     * Same as above, for a task mostly using |resource|.
+     */
+    template<class F, class... Args> std::future<std::string> enqueueTaskWithFd(
+            Resource resource, const std::string& duration_title, F&& f, Args&&... args) {
         std::function<void(int)> func = std::bind(std::forward<F>(f),
                 std::forward<Args>(args)...);
-        auto future = post(duration_title, func);
+        auto future = post(resource, duration_title, func);
         if (threads_.empty()) {
             start();
         }
         return future;
     }
 
+    /*
+     * Limits how many tasks using |resource| run at once. Other queued tasks
+     * are started ahead of them meanwhile. There is no limit by default,
+     * other than the number of threads.
+     *
+     * |max_tasks| the maximum number of tasks, at least 1.
+     */
+    void setMaxConcurrentTasks(Resource resource, int max_tasks);
+
     /*
      * Deletes temporary files created by DumpPool.
      */
@@ -152,7 +193,8 @@ class DumpPool {
     template<class T> void invokeTask(T dump_func, const std::string& duration_title, int out_fd);
 
     template<class T>
-    std::future<std::string> post(const std::string& duration_title, T dump_func) {
+    std::future<std::string> post(Resource resource, const std::string& duration_title,
+            T dump_func) {
         Task packaged_task([=]() {
             std::unique_ptr<TmpFile> tmp_file_ptr = createTempFile();
             if (!tmp_file_ptr) {
@@ -164,7 +206,7 @@ class DumpPool {
         });
         std::unique_lock lock(lock_);
         auto future = packaged_task.get_future();
-        tasks_.push(std::move(packaged_task));
+        tasks_.push_back({std::move(packaged_task), resource});
         condition_variable_.notify_one();
         return future;
     }
@@ -197,8 +239,19 @@ class DumpPool {
     std::mutex lock_;  // A lock for the tasks_.
     std::condition_variable condition_variable_;
 
+    struct QueuedTask {
+        Task task;
+        Resource resource = Resource::DEFAULT;
+    };
+
+    // Takes the first task whose resource has room for one more, if any.
+    bool takeRunnableTaskLocked(QueuedTask* task);
+
     std::vector<std::thread> threads_;
-    std::queue<Task> tasks_;
+    std::deque<QueuedTask> tasks_;
+    static constexpr size_t kResourceCount = static_cast<size_t>(Resource::COUNT);
+    std::array<int, kResourceCount> max_running_;  // Protected by lock_.
+    std::array<int, kResourceCount> running_;      // Protected by lock_.
 
     DISALLOW_COPY_AND_ASSIGN(DumpPool);
 };
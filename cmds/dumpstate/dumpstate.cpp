@@ -68,6 +68,7 @@
 #include <stdlib.h>
 #include <string.h>
 #include <sys/capability.h>
+#include <sys/eventfd.h>
 #include <sys/inotify.h>
 #include <sys/klog.h>
 #include <sys/mount.h>
@@ -84,14 +85,18 @@
 
 #include <chrono>
 #include <cmath>
+#include <condition_variable>
+#include <deque>
 #include <fstream>
 #include <functional>
 #include <future>
 #include <memory>
+#include <mutex>
 #include <numeric>
 #include <regex>
 #include <set>
 #include <string>
+#include <thread>
 #include <utility>
 #include <vector>
 
@@ -250,6 +255,8 @@ static const std::string DUMP_NETSTATS_PROTO_TASK = "DUMP NETSTATS PROTO";
 static const std::string DUMP_HALS_TASK = "DUMP HALS";
 static const std::string DUMP_BOARD_TASK = "dumpstate_board()";
 static const std::string DUMP_CHECKINS_TASK = "DUMP CHECKINS";
+static const std::string DUMP_CPU_INFO_TASK = "CPU INFO";
+static const std::string DUMP_PROCESSES_AND_THREADS_TASK = "PROCESSES AND THREADS";
 static const std::string SERIALIZE_PERFETTO_TRACE_TASK = "SERIALIZE PERFETTO TRACE";
 
 namespace android {
@@ -374,6 +381,10 @@ static int DumpFile(const std::string& title, const std::string& path) {
 // Relative directory (inside the zip) for all files copied as-is into the bugreport.
 static const std::string ZIP_ROOT_DIR = "FS";
 
+// Lists the SHA-256, size, and whether it is stored or left out of each zip entry.
+static const std::string kEntryManifest = "entries.manifest";
+// Entries smaller than this are always stored, a reference wouldn't save much.
+static constexpr off_t kMinReferencedEntrySize = 4096;
 static const std::string kProtoPath = "proto/";
 static const std::string kProtoExt = ".proto";
 static const std::string kDumpstateBoardFiles[] = {
@@ -846,6 +857,141 @@ static const std::set<std::string> PROBLEMATIC_FILE_EXTENSIONS = {
       ".shb", ".sys", ".vb",  ".vbe", ".vbs", ".vxd", ".wsc", ".wsf", ".wsh"
 };
 
+static std::string HexDigest(SHA256_CTX* ctx) {
+    uint8_t digest[SHA256_DIGEST_LENGTH];
+    SHA256_Final(digest, ctx);
+    std::string hex;
+    for (uint8_t byte : digest) {
+        hex += StringPrintf("%02x", byte);
+    }
+    return hex;
+}
+
+/*
+ * Returns the SHA-256 of regular file |fd| and rewinds it, or an empty string on
+ * failure.
+ */
+static std::string HashRegularFile(const std::string& entry_name, int fd) {
+    SHA256_CTX ctx;
+    SHA256_Init(&ctx);
+    std::vector<uint8_t> buffer(65536);
+    while (1) {
+        ssize_t bytes_read = TEMP_FAILURE_RETRY(read(fd, buffer.data(), buffer.size()));
+        if (bytes_read == 0) {
+            break;
+        } else if (bytes_read == -1) {
+            MYLOGE("read(%s): %s\n", entry_name.c_str(), strerror(errno));
+            return "";
+        }
+        SHA256_Update(&ctx, buffer.data(), bytes_read);
+    }
+    if (lseek(fd, 0, SEEK_SET) == -1) {
+        MYLOGE("lseek(%s): %s\n", entry_name.c_str(), strerror(errno));
+        return "";
+    }
+    return HexDigest(&ctx);
+}
+
+/*
+ * Reads |fd| until EOF on another thread, and passes what is read to |write| on
+ * the calling thread. A process writing to a pipe this way doesn't block while
+ * |write| compresses earlier data, unless it gets kReadAheadChunks ahead.
+ *
+ * Returns TIMED_OUT if EOF isn't reached within |timeout|, or UNKNOWN_ERROR as
+ * soon as |write| fails.
+ */
+static status_t ReadFdAhead(const std::string& entry_name, int fd,
+                            std::chrono::milliseconds timeout,
+                            const std::function<bool(const uint8_t*, size_t)>& write) {
+    static constexpr size_t kReadAheadChunks = 16;
+    static constexpr size_t kChunkSize = 65536;
+
+    android::base::unique_fd cancel_fd(eventfd(0, EFD_CLOEXEC));
+    if (cancel_fd == -1) {
+        MYLOGE("eventfd() for zip entry %s: %s\n", entry_name.c_str(), strerror(errno));
+        return -errno;
+    }
+    std::mutex lock;
+    std::condition_variable cv;
+    std::deque<std::vector<uint8_t>> chunks;
+    bool done = false;
+    bool cancelled = false;
+    status_t read_status = OK;
+
+    std::thread reader([&] {
+        auto end = std::chrono::steady_clock::now() + timeout;
+        // lambda to recalculate the timeout.
+        auto time_left_ms = [end]() {
+            auto now = std::chrono::steady_clock::now();
+            auto diff = std::chrono::duration_cast<std::chrono::milliseconds>(end - now);
+            return std::max(diff.count(), 0LL);
+        };
+        struct pollfd pfds[] = {{fd, POLLIN, 0}, {cancel_fd.get(), POLLIN, 0}};
+        status_t status = OK;
+        while (true) {
+            {
+                std::unique_lock guard(lock);
+                cv.wait(guard, [&] { return cancelled || chunks.size() < kReadAheadChunks; });
+                if (cancelled) break;
+            }
+            int rc = TEMP_FAILURE_RETRY(poll(pfds, 2, time_left_ms()));
+            if (rc < 0) {
+                MYLOGE("Error in poll while adding from fd to zip entry %s:%s\n",
+                       entry_name.c_str(), strerror(errno));
+                status = -errno;
+                break;
+            } else if (rc == 0) {
+                MYLOGE("Timed out adding from fd to zip entry %s:%s Timeout:%lldms\n",
+                       entry_name.c_str(), strerror(errno), timeout.count());
+                status = TIMED_OUT;
+                break;
+            } else if (pfds[1].revents != 0) {
+                break;
+            }
+            std::vector<uint8_t> chunk(kChunkSize);
+            ssize_t bytes_read = TEMP_FAILURE_RETRY(read(fd, chunk.data(), chunk.size()));
+            if (bytes_read == 0) {
+                break;
+            } else if (bytes_read == -1) {
+                MYLOGE("read(%s): %s\n", entry_name.c_str(), strerror(errno));
+                status = -errno;
+                break;
+            }
+            chunk.resize(bytes_read);
+            std::lock_guard guard(lock);
+            chunks.push_back(std::move(chunk));
+            cv.notify_all();
+        }
+        std::lock_guard guard(lock);
+        read_status = status;
+        done = true;
+        cv.notify_all();
+    });
+
+    status_t status = OK;
+    while (true) {
+        std::vector<uint8_t> chunk;
+        {
+            std::unique_lock guard(lock);
+            cv.wait(guard, [&] { return done || !chunks.empty(); });
+            if (chunks.empty()) break;
+            chunk = std::move(chunks.front());
+            chunks.pop_front();
+            cv.notify_all();
+        }
+        if (!write(chunk.data(), chunk.size())) {
+            status = UNKNOWN_ERROR;
+            std::lock_guard guard(lock);
+            cancelled = true;
+            cv.notify_all();
+            eventfd_write(cancel_fd.get(), 1);
+            break;
+        }
+    }
+    reader.join();
+    return status != OK ? status : read_status;
+}
+
 status_t Dumpstate::AddZipEntryFromFd(const std::string& entry_name, int fd,
                                       std::chrono::milliseconds timeout = 0ms) {
     std::string valid_name = entry_name;
@@ -861,6 +1007,21 @@ status_t Dumpstate::AddZipEntryFromFd(const std::string& entry_name, int fd,
         }
     }
 
+    bool add_to_manifest = !options_->previous_manifest.empty();
+    std::string hash;
+    struct stat st;
+    if (add_to_manifest && fstat(fd, &st) == 0 && S_ISREG(st.st_mode) &&
+        st.st_size >= kMinReferencedEntrySize) {
+        hash = HashRegularFile(valid_name, fd);
+        if (previous_entry_hashes_.count(hash) != 0) {
+            MYLOGD("Skipping zip entry %s, the previous bugreport has it\n", valid_name.c_str());
+            entry_manifest_ += StringPrintf("%s %lld ref %s\n", hash.c_str(),
+                                            static_cast<long long>(st.st_size),
+                                            valid_name.c_str());
+            return OK;
+        }
+    }
+
     // Logging statement  below is useful to time how long each entry takes, but it's too verbose.
     // MYLOGD("Adding zip entry %s\n", entry_name.c_str());
     size_t flags = ZipWriter::kCompress | ZipWriter::kDefaultCompression;
@@ -882,43 +1043,42 @@ status_t Dumpstate::AddZipEntryFromFd(const std::string& entry_name, int fd,
         }
     };
     auto scope_guard = android::base::make_scope_guard(finish_entry);
-    auto start = std::chrono::steady_clock::now();
-    auto end = start + timeout;
-    struct pollfd pfd = {fd, POLLIN};
-
-    std::vector<uint8_t> buffer(65536);
-    while (1) {
-        if (timeout.count() > 0) {
-            // lambda to recalculate the timeout.
-            auto time_left_ms = [end]() {
-                auto now = std::chrono::steady_clock::now();
-                auto diff = std::chrono::duration_cast<std::chrono::milliseconds>(end - now);
-                return std::max(diff.count(), 0LL);
-            };
-
-            int rc = TEMP_FAILURE_RETRY(poll(&pfd, 1, time_left_ms()));
-            if (rc < 0) {
-                MYLOGE("Error in poll while adding from fd to zip entry %s:%s\n",
-                       entry_name.c_str(), strerror(errno));
-                return -errno;
-            } else if (rc == 0) {
-                MYLOGE("Timed out adding from fd to zip entry %s:%s Timeout:%lldms\n",
-                       entry_name.c_str(), strerror(errno), timeout.count());
-                return TIMED_OUT;
-            }
-        }
-
-        ssize_t bytes_read = TEMP_FAILURE_RETRY(read(fd, buffer.data(), buffer.size()));
-        if (bytes_read == 0) {
-            break;
-        } else if (bytes_read == -1) {
-            MYLOGE("read(%s): %s\n", entry_name.c_str(), strerror(errno));
-            return -errno;
-        }
-        err = zip_writer_->WriteBytes(buffer.data(), bytes_read);
+    // Entries which weren't hashed beforehand are hashed as they are written.
+    bool hash_while_writing = add_to_manifest && hash.empty();
+    SHA256_CTX ctx;
+    SHA256_Init(&ctx);
+    long long entry_size = 0;
+    auto write_bytes = [&](const uint8_t* data, size_t size) {
+        int32_t err = zip_writer_->WriteBytes(data, size);
         if (err) {
             MYLOGE("zip_writer_->WriteBytes(): %s\n", ZipWriter::ErrorCodeString(err));
-            return UNKNOWN_ERROR;
+            return false;
+        }
+        if (hash_while_writing) {
+            SHA256_Update(&ctx, data, size);
+        }
+        entry_size += size;
+        return true;
+    };
+    if (timeout.count() > 0) {
+        // The fd is fed by a running process, let it write ahead of the compression.
+        status_t status = ReadFdAhead(entry_name, fd, timeout, write_bytes);
+        if (status != OK) {
+            return status;
+        }
+    } else {
+        std::vector<uint8_t> buffer(65536);
+        while (1) {
+            ssize_t bytes_read = TEMP_FAILURE_RETRY(read(fd, buffer.data(), buffer.size()));
+            if (bytes_read == 0) {
+                break;
+            } else if (bytes_read == -1) {
+                MYLOGE("read(%s): %s\n", entry_name.c_str(), strerror(errno));
+                return -errno;
+            }
+            if (!write_bytes(buffer.data(), bytes_read)) {
+                return UNKNOWN_ERROR;
+            }
         }
     }
 
@@ -929,9 +1089,38 @@ status_t Dumpstate::AddZipEntryFromFd(const std::string& entry_name, int fd,
         return UNKNOWN_ERROR;
     }
 
+    if (add_to_manifest) {
+        if (hash_while_writing) {
+            hash = HexDigest(&ctx);
+        }
+        entry_manifest_ += StringPrintf("%s %lld stored %s\n", hash.c_str(), entry_size,
+                                        valid_name.c_str());
+    }
     return OK;
 }
 
+void Dumpstate::LoadPreviousManifest() {
+    if (options_->previous_manifest.empty()) {
+        return;
+    }
+    std::string content;
+    if (!android::base::ReadFileToString(options_->previous_manifest, &content)) {
+        // Still write a manifest, for the next bugreport.
+        MYLOGI("Cannot read previous manifest %s: %s\n", options_->previous_manifest.c_str(),
+               strerror(errno));
+        return;
+    }
+    // The hashes of referenced entries count too, the previous bugreports have them.
+    for (const std::string& line : android::base::Split(content, "\n")) {
+        std::vector<std::string> fields = android::base::Split(line, " ");
+        if (fields.size() >= 4 && fields[0].size() == SHA256_DIGEST_LENGTH * 2) {
+            previous_entry_hashes_.insert(fields[0]);
+        }
+    }
+    MYLOGD("Read %zu entry hashes from previous manifest %s\n", previous_entry_hashes_.size(),
+           options_->previous_manifest.c_str());
+}
+
 bool Dumpstate::AddZipEntry(const std::string& entry_name, const std::string& entry_path) {
     android::base::unique_fd fd(
         TEMP_FAILURE_RETRY(open(entry_path.c_str(), O_RDONLY | O_NONBLOCK | O_CLOEXEC)));
@@ -1655,6 +1844,28 @@ static void DumpAppInfos(int out_fd = STDOUT_FILENO) {
             DUMPSYS_COMPONENTS_OPTIONS, 0, out_fd);
 }
 
+/*
+ * |out_fd| A fd to support the DumpPool to output results to a temporary file.
+ * Dumpstate can pick up later and output to the bugreport. Using STDOUT_FILENO
+ * if it's not running in the parallel task.
+ */
+static void DumpCpuInfo(int out_fd = STDOUT_FILENO) {
+    RunCommand("CPU INFO", {"top", "-b", "-n", "1", "-H", "-s", "6", "-o",
+                            "pid,tid,user,pr,ni,%cpu,s,virt,res,pcy,cmd,name"},
+               CommandOptions::DEFAULT, false, out_fd);
+}
+
+/*
+ * |out_fd| A fd to support the DumpPool to output results to a temporary file.
+ * Dumpstate can pick up later and output to the bugreport. Using STDOUT_FILENO
+ * if it's not running in the parallel task.
+ */
+static void DumpProcessesAndThreads(int out_fd = STDOUT_FILENO) {
+    RunCommand("PROCESSES AND THREADS",
+               {"ps", "-A", "-T", "-Z", "-O", "pri,nice,rtprio,sched,pcy,time"},
+               CommandOptions::DEFAULT, false, out_fd);
+}
+
 // Dumps various things. Returns early with status USER_CONSENT_DENIED if user denies consent
 // via the consent they are shown. Ignores other errors that occur while running various
 // commands. The consent checking is currently done around long running tasks, which happen to
@@ -1664,12 +1875,20 @@ Dumpstate::RunStatus Dumpstate::dumpstate() {
 
     // Enqueue slow functions into the thread pool, if the parallel run is enabled.
     std::future<std::string> dump_hals, dump_incident_report, dump_board, dump_checkins,
-        dump_netstats_report;
+        dump_netstats_report, dump_cpu_info, dump_processes_and_threads;
     if (ds.dump_pool_) {
         // Pool was shutdown in DumpstateDefaultAfterCritical method in order to
         // drop root user. Restarts it.
         ds.dump_pool_->start(/* thread_counts = */3);
-
+        // Both walk every thread in /proc, running them together only makes
+        // each of them slower.
+        ds.dump_pool_->setMaxConcurrentTasks(DumpPool::Resource::CPU, 1);
+
+        dump_cpu_info = ds.dump_pool_->enqueueTaskWithFd(
+            DumpPool::Resource::CPU, DUMP_CPU_INFO_TASK, &DumpCpuInfo, _1);
+        dump_processes_and_threads = ds.dump_pool_->enqueueTaskWithFd(
+            DumpPool::Resource::CPU, DUMP_PROCESSES_AND_THREADS_TASK, &DumpProcessesAndThreads,
+            _1);
         dump_hals = ds.dump_pool_->enqueueTaskWithFd(DUMP_HALS_TASK, &DumpHals, _1);
         dump_incident_report = ds.dump_pool_->enqueueTask(
             DUMP_INCIDENT_REPORT_TASK, &DumpIncidentReport);
@@ -1687,8 +1906,11 @@ Dumpstate::RunStatus Dumpstate::dumpstate() {
     RunCommand("UPTIME", {"uptime"});
     DumpBlockStatFiles();
     DumpFile("MEMORY INFO", "/proc/meminfo");
-    RunCommand("CPU INFO", {"top", "-b", "-n", "1", "-H", "-s", "6", "-o",
-                            "pid,tid,user,pr,ni,%cpu,s,virt,res,pcy,cmd,name"});
+    if (ds.dump_pool_) {
+        WaitForTask(std::move(dump_cpu_info));
+    } else {
+        DumpCpuInfo();
+    }
 
     RUN_SLOW_FUNCTION_WITH_CONSENT_CHECK(RunCommand, "BUGREPORT_PROCDUMP", {"bugreport_procdump"},
                                          CommandOptions::AS_ROOT);
@@ -1705,8 +1927,11 @@ Dumpstate::RunStatus Dumpstate::dumpstate() {
 
     DumpFile("KERNEL CPUFREQ", "/sys/devices/system/cpu/cpu0/cpufreq/stats/time_in_state");
 
-    RunCommand("PROCESSES AND THREADS",
-               {"ps", "-A", "-T", "-Z", "-O", "pri,nice,rtprio,sched,pcy,time"});
+    if (ds.dump_pool_) {
+        WaitForTask(std::move(dump_processes_and_threads));
+    } else {
+        DumpProcessesAndThreads();
+    }
 
     if (ds.dump_pool_) {
         WAIT_TASK_WITH_CONSENT_CHECK(std::move(dump_hals));
@@ -2709,7 +2934,7 @@ void Dumpstate::DumpstateBoard(int out_fd) {
 static void ShowUsage() {
     fprintf(stderr,
             "usage: dumpstate [-h] [-b soundfile] [-e soundfile] [-o directory] [-p] "
-            "[-s] [-S] [-q] [-P] [-R] [-L] [-V version]\n"
+            "[-s] [-S] [-q] [-P] [-R] [-L] [-D manifest] [-V version]\n"
             "  -h: display this help message\n"
             "  -b: play sound file instead of vibrate, at beginning of job\n"
             "  -e: play sound file instead of vibrate, at end of job\n"
@@ -2722,6 +2947,8 @@ static void ShowUsage() {
             "  -R: take bugreport in remote mode (shouldn't be used with -P)\n"
             "  -w: start binder service and make it wait for a call to startBugreport\n"
             "  -L: output limited information that is safe for submission in feedback reports\n"
+            "  -D: list the zip entries in entries.manifest, leaving out those listed in the\n"
+            "      given manifest of a previous bugreport\n"
             "  -v: prints the dumpstate header and exit\n");
 }
 
@@ -2767,6 +2994,12 @@ bool Dumpstate::FinishZipFile() {
     }
     fprintf(stderr, "\n");
 
+    if (!options_->previous_manifest.empty() &&
+        !AddTextZipEntry(kEntryManifest, entry_manifest_)) {
+        MYLOGE("Failed to add %s to .zip file\n", kEntryManifest.c_str());
+        return false;
+    }
+
     int32_t err = zip_writer_->Finish();
     if (err != 0) {
         MYLOGE("zip_writer_->Finish(): %s\n", ZipWriter::ErrorCodeString(err));
@@ -2869,6 +3102,7 @@ static bool PrepareToWriteToFile() {
         return false;
     }
     ds.zip_writer_.reset(new ZipWriter(ds.zip_file.get()));
+    ds.LoadPreviousManifest();
     ds.AddTextZipEntry("version.txt", ds.version_);
     return true;
 }
@@ -3007,7 +3241,7 @@ void Dumpstate::DumpOptions::Initialize(BugreportMode bugreport_mode,
 Dumpstate::RunStatus Dumpstate::DumpOptions::Initialize(int argc, char* argv[]) {
     RunStatus status = RunStatus::OK;
     int c;
-    while ((c = getopt(argc, argv, "dho:svqzpLPBRSV:w")) != -1) {
+    while ((c = getopt(argc, argv, "dho:svqzpLPBRSD:V:w")) != -1) {
         switch (c) {
             // clang-format off
             case 'o': out_dir = optarg;              break;
@@ -3019,6 +3253,7 @@ Dumpstate::RunStatus Dumpstate::DumpOptions::Initialize(int argc, char* argv[])
             case 'P': do_progress_updates = true;    break;
             case 'R': is_remote_mode = true;         break;
             case 'L': limited_only = true;           break;
+            case 'D': previous_manifest = optarg;    break;
             case 'V':
             case 'd':
             case 'z':
@@ -22,6 +22,7 @@
 #include <stdbool.h>
 #include <stdio.h>
 
+#include <set>
 #include <string>
 #include <vector>
 
@@ -281,6 +282,11 @@ class Dumpstate {
     android::status_t AddZipEntryFromFd(const std::string& entry_name, int fd,
                                         std::chrono::milliseconds timeout);
 
+    /*
+     * Reads the manifest of a previous bugreport set in the options, if any.
+     */
+    void LoadPreviousManifest();
+
     /*
      * Adds a text entry to the existing zip file.
      */
@@ -441,6 +447,9 @@ class Dumpstate {
         // Notification title and description
         std::string notification_title;
         std::string notification_description;
+        // Manifest of a previous bugreport. When set, the zip entries are hashed and listed in
+        // a manifest entry, and those the previous bugreport already has are left out.
+        std::string previous_manifest;
 
         /* Initializes options from commandline arguments. */
         RunStatus Initialize(int argc, char* argv[]);
@@ -541,6 +550,12 @@ class Dumpstate {
     // parallel run is enabled.
     std::unique_ptr<android::os::dumpstate::TaskQueue> zip_entry_tasks_;
 
+    // SHA-256 of the zip entries listed in DumpOptions::previous_manifest.
+    std::set<std::string> previous_entry_hashes_;
+
+    // Manifest of the zip entries added so far, when DumpOptions::previous_manifest is set.
+    std::string entry_manifest_;
+
     // A callback to IncidentCompanion service, which checks user consent for sharing the
     // bugreport with the calling app. If the user has not responded yet to the dialog it will
     // be neither confirmed nor denied.
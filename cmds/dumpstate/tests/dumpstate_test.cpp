@@ -38,6 +38,7 @@
 #include <unistd.h>
 #include <ziparchive/zip_archive.h>
 
+#include <atomic>
 #include <filesystem>
 #include <thread>
 
@@ -431,6 +432,26 @@ TEST_F(DumpOptionsTest, InitializePartial2) {
     EXPECT_FALSE(options_.limited_only);
 }
 
+TEST_F(DumpOptionsTest, InitializePreviousManifest) {
+    // clang-format off
+    char* argv[] = {
+        const_cast<char*>("dumpstate"),
+        const_cast<char*>("-D"),
+        const_cast<char*>("/data/misc/last-bugreport/entries.manifest"),
+    };
+    // clang-format on
+
+    Dumpstate::RunStatus status = options_.Initialize(ARRAY_SIZE(argv), argv);
+
+    EXPECT_EQ(status, Dumpstate::RunStatus::OK);
+    EXPECT_EQ(options_.previous_manifest, "/data/misc/last-bugreport/entries.manifest");
+
+    // Other options retain default values
+    EXPECT_TRUE(options_.do_vibrate);
+    EXPECT_FALSE(options_.stream_to_socket);
+    EXPECT_FALSE(options_.limited_only);
+}
+
 TEST_F(DumpOptionsTest, InitializeHelp) {
     // clang-format off
     char* argv[] = {
@@ -1782,6 +1803,38 @@ TEST_F(DumpPoolTest, EnqueueTask_withDurationLog) {
     EXPECT_THAT(getTempFileCounts(kTestDataPath), Eq(0));
 }
 
+TEST_F(DumpPoolTest, EnqueueTask_withResourceLimit) {
+    std::atomic<int> running_io = 0;
+    std::atomic<int> max_running_io = 0;
+    auto io_func = [&]() {
+        int running = ++running_io;
+        int max_running = max_running_io;
+        while (running > max_running &&
+               !max_running_io.compare_exchange_weak(max_running, running)) {
+        }
+        usleep(100000);
+        running_io--;
+    };
+    bool run_cpu = false;
+    auto cpu_func = [&]() {
+        run_cpu = true;
+    };
+    setLogDuration(/* log_duration = */false);
+    dump_pool_->setMaxConcurrentTasks(DumpPool::Resource::IO, 1);
+    auto t1 = dump_pool_->enqueueTask(DumpPool::Resource::IO, "", io_func);
+    auto t2 = dump_pool_->enqueueTask(DumpPool::Resource::IO, "", io_func);
+    auto t3 = dump_pool_->enqueueTask(DumpPool::Resource::CPU, "", cpu_func);
+
+    // The CPU task doesn't wait for the IO tasks.
+    WaitForTask(std::move(t3), "", out_fd_.get());
+    EXPECT_TRUE(run_cpu);
+    WaitForTask(std::move(t1), "", out_fd_.get());
+    WaitForTask(std::move(t2), "", out_fd_.get());
+
+    EXPECT_THAT(max_running_io.load(), Eq(1));
+    EXPECT_THAT(getTempFileCounts(kTestDataPath), Eq(0));
+}
+
 class TaskQueueTest : public DumpstateBaseTest {
 public:
     void SetUp() {
@@ -15,8 +15,11 @@
  */
 
 #include <algorithm>
+#include <atomic>
 #include <chrono>
+#include <condition_variable>
 #include <iomanip>
+#include <mutex>
 #include <thread>
 
 #include <android-base/file.h>
@@ -39,6 +42,7 @@
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
+#include <sys/mman.h>
 #include <sys/poll.h>
 #include <sys/socket.h>
 #include <sys/time.h>
@@ -65,14 +69,20 @@ static void usage() {
         "usage: dumpsys\n"
         "         To dump all services.\n"
         "or:\n"
-        "       dumpsys [-t TIMEOUT] [--priority LEVEL] [--clients] [--dump] [--pid] [--thread] "
-        "[--help | "
+        "       dumpsys [-t TIMEOUT] [-j JOBS] [--priority LEVEL] [--clients] [--dump] [--pid] "
+        "[--thread] "
+        "[--binder-stats[=enable|disable]] [--help | "
         "-l | --skip SERVICES "
         "| SERVICE [ARGS]]\n"
         "         --help: shows this help\n"
         "         -l: only list services, do not dump them\n"
         "         -t TIMEOUT_SEC: TIMEOUT to use in seconds instead of default 10 seconds\n"
         "         -T TIMEOUT_MS: TIMEOUT to use in milliseconds instead of default 10 seconds\n"
+        "         -j JOBS: dump up to JOBS services at once when dumping several of them. The\n"
+        "               dumps are still printed one after the other, in the usual order\n"
+        "         --binder-stats: dump per-method binder transaction statistics of the\n"
+        "               server process instead of usual dump (requires root)\n"
+        "         --binder-stats=enable|disable: start or stop collecting them\n"
         "         --clients: dump client PIDs instead of usual dump\n"
         "         --dump: ask the service to dump itself (this is the default)\n"
         "         --pid: dump PID instead of usual dump\n"
@@ -135,13 +145,15 @@ int Dumpsys::main(int argc, char* const argv[]) {
     bool asProto = false;
     int dumpTypeFlags = 0;
     int timeoutArgMs = 10000;
+    size_t jobs = 1;
     int priorityFlags = IServiceManager::DUMP_FLAG_PRIORITY_ALL;
     static struct option longOptions[] = {
         {"help", no_argument, 0, 0},           {"clients", no_argument, 0, 0},
         {"dump", no_argument, 0, 0},           {"pid", no_argument, 0, 0},
         {"priority", required_argument, 0, 0}, {"proto", no_argument, 0, 0},
         {"skip", no_argument, 0, 0},           {"stability", no_argument, 0, 0},
-        {"thread", no_argument, 0, 0},         {0, 0, 0, 0}};
+        {"thread", no_argument, 0, 0},         {"binder-stats", optional_argument, 0, 0},
+        {0, 0, 0, 0}};
 
     // Must reset optind, otherwise subsequent calls will fail (wouldn't happen on main.cpp, but
     // happens on test cases).
@@ -150,7 +162,7 @@ int Dumpsys::main(int argc, char* const argv[]) {
         int c;
         int optionIndex = 0;
 
-        c = getopt_long(argc, argv, "+t:T:l", longOptions, &optionIndex);
+        c = getopt_long(argc, argv, "+t:T:j:l", longOptions, &optionIndex);
 
         if (c == -1) {
             break;
@@ -182,6 +194,18 @@ int Dumpsys::main(int argc, char* const argv[]) {
                 dumpTypeFlags |= TYPE_THREAD;
             } else if (!strcmp(longOptions[optionIndex].name, "clients")) {
                 dumpTypeFlags |= TYPE_CLIENTS;
+            } else if (!strcmp(longOptions[optionIndex].name, "binder-stats")) {
+                if (optarg == nullptr) {
+                    dumpTypeFlags |= TYPE_BINDER_STATS;
+                } else if (!strcmp(optarg, "enable")) {
+                    dumpTypeFlags |= TYPE_BINDER_STATS_ENABLE;
+                } else if (!strcmp(optarg, "disable")) {
+                    dumpTypeFlags |= TYPE_BINDER_STATS_DISABLE;
+                } else {
+                    fprintf(stderr, "\n");
+                    usage();
+                    return -1;
+                }
             }
             break;
 
@@ -208,6 +232,18 @@ int Dumpsys::main(int argc, char* const argv[]) {
             }
             break;
 
+        case 'j':
+            {
+                char* endptr;
+                long value = strtol(optarg, &endptr, 10);
+                if (*endptr != '\0' || value <= 0) {
+                    fprintf(stderr, "Error: invalid number of jobs: '%s'\n", optarg);
+                    return -1;
+                }
+                jobs = value;
+            }
+            break;
+
         case 'l':
             showListOnly = true;
             break;
@@ -271,37 +307,121 @@ int Dumpsys::main(int argc, char* const argv[]) {
         return 0;
     }
 
+    const std::chrono::milliseconds timeout(timeoutArgMs);
+    const bool addSeparator = (N > 1);
+    if (jobs > 1 && N > 1) {
+        Vector<String16> servicesToDump;
+        for (const String16& serviceName : services) {
+            if (!IsSkipped(skippedServices, serviceName)) servicesToDump.add(serviceName);
+        }
+        dumpServicesInParallel(servicesToDump, jobs, dumpTypeFlags, args, priorityFlags,
+                               addSeparator, timeout, asProto);
+        return 0;
+    }
+
     for (size_t i = 0; i < N; i++) {
         const String16& serviceName = services[i];
         if (IsSkipped(skippedServices, serviceName)) continue;
 
-        if (startDumpThread(dumpTypeFlags, serviceName, args) == OK) {
-            bool addSeparator = (N > 1);
-            if (addSeparator) {
-                writeDumpHeader(STDOUT_FILENO, serviceName, priorityFlags);
-            }
-            std::chrono::duration<double> elapsedDuration;
-            size_t bytesWritten = 0;
-            status_t status =
-                writeDump(STDOUT_FILENO, serviceName, std::chrono::milliseconds(timeoutArgMs),
-                          asProto, elapsedDuration, bytesWritten);
-
-            if (status == TIMED_OUT) {
-                std::cout << std::endl
-                     << "*** SERVICE '" << serviceName << "' DUMP TIMEOUT (" << timeoutArgMs
-                     << "ms) EXPIRED ***" << std::endl
-                     << std::endl;
-            }
+        dumpService(STDOUT_FILENO, dumpTypeFlags, serviceName, args, priorityFlags, addSeparator,
+                    timeout, asProto);
+    }
+
+    return 0;
+}
+
+void Dumpsys::dumpService(int fd, int dumpTypeFlags, const String16& serviceName,
+                          const Vector<String16>& args, int priorityFlags, bool addSeparator,
+                          std::chrono::milliseconds timeout, bool asProto) {
+    if (startDumpThread(dumpTypeFlags, serviceName, args) != OK) {
+        return;
+    }
+    if (addSeparator) {
+        writeDumpHeader(fd, serviceName, priorityFlags);
+    }
+    std::chrono::duration<double> elapsedDuration;
+    size_t bytesWritten = 0;
+    status_t status = writeDump(fd, serviceName, timeout, asProto, elapsedDuration, bytesWritten);
 
-            if (addSeparator) {
-                writeDumpFooter(STDOUT_FILENO, serviceName, elapsedDuration);
+    if (status == TIMED_OUT) {
+        WriteStringToFd(StringPrintf("\n*** SERVICE '%s' DUMP TIMEOUT (%lldms) EXPIRED ***\n\n",
+                                     String8(serviceName).c_str(),
+                                     static_cast<long long>(timeout.count())),
+                        fd);
+    }
+
+    if (addSeparator) {
+        writeDumpFooter(fd, serviceName, elapsedDuration);
+    }
+    bool dumpComplete = (status == OK);
+    stopDumpThread(dumpComplete);
+}
+
+void Dumpsys::dumpServicesInParallel(const Vector<String16>& services, size_t jobs,
+                                     int dumpTypeFlags, const Vector<String16>& args,
+                                     int priorityFlags, bool addSeparator,
+                                     std::chrono::milliseconds timeout, bool asProto) {
+    const auto start = std::chrono::steady_clock::now();
+
+    // Each service is dumped into its own memfd, then printed once all the ones before it have
+    // been, so that the output is the same as when dumping one service at a time.
+    struct Result {
+        unique_fd fd;
+        bool done = false;
+    };
+    std::vector<Result> results(services.size());
+    std::mutex lock;
+    std::condition_variable doneCondition;
+    std::atomic<size_t> next = 0;
+
+    auto worker = [&]() {
+        for (size_t i = next++; i < services.size(); i = next++) {
+            unique_fd fd(memfd_create("dumpsys", MFD_CLOEXEC));
+            if (fd.ok()) {
+                Dumpsys dumpsys(sm_);
+                dumpsys.dumpService(fd.get(), dumpTypeFlags, services[i], args, priorityFlags,
+                                    addSeparator, timeout, asProto);
+            } else {
+                std::cerr << "Failed to create buffer to dump service " << services[i] << ": "
+                          << strerror(errno) << std::endl;
             }
-            bool dumpComplete = (status == OK);
-            stopDumpThread(dumpComplete);
+            std::lock_guard<std::mutex> guard(lock);
+            results[i].fd = std::move(fd);
+            results[i].done = true;
+            doneCondition.notify_all();
         }
+    };
+
+    std::vector<std::thread> threads;
+    for (size_t i = 0; i < std::min(jobs, services.size()); i++) {
+        threads.emplace_back(worker);
     }
 
-    return 0;
+    for (Result& result : results) {
+        unique_fd fd;
+        {
+            std::unique_lock<std::mutex> guard(lock);
+            doneCondition.wait(guard, [&] { return result.done; });
+            fd = std::move(result.fd);
+        }
+        if (!fd.ok() || lseek(fd.get(), 0, SEEK_SET) != 0) continue;
+
+        char buf[4096];
+        ssize_t rc;
+        while ((rc = TEMP_FAILURE_RETRY(read(fd.get(), buf, sizeof(buf)))) > 0) {
+            if (!WriteFully(STDOUT_FILENO, buf, rc)) break;
+        }
+    }
+
+    for (std::thread& thread : threads) {
+        thread.join();
+    }
+
+    const std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+    WriteStringToFd(StringPrintf("--------- %.3fs was the total duration of dumpsys for %zu "
+                                 "services with %zu jobs\n",
+                                 elapsed.count(), services.size(), jobs),
+                    STDOUT_FILENO);
 }
 
 Vector<String16> Dumpsys::listServices(int priorityFilterFlags, bool filterByProto) const {
@@ -406,6 +526,16 @@ static status_t dumpClientsToFd(const sp<IBinder>& service, const unique_fd& fd)
     return OK;
 }
 
+static status_t dumpBinderStatsToFd(const sp<IBinder>& service, const unique_fd& fd) {
+    std::string stats;
+    status_t status = service->dumpTransactionStats(&stats);
+    if (status != OK) {
+        return status;
+    }
+    WriteStringToFd(stats, fd.get());
+    return OK;
+}
+
 static void reportDumpError(const String16& serviceName, status_t error, const char* context) {
     if (error == OK) return;
 
@@ -450,6 +580,15 @@ status_t Dumpsys::startDumpThread(int dumpTypeFlags, const String16& serviceName
             status_t err = dumpClientsToFd(service, remote_end);
             reportDumpError(serviceName, err, "dumping clients info");
         }
+        if (dumpTypeFlags & (TYPE_BINDER_STATS_ENABLE | TYPE_BINDER_STATS_DISABLE)) {
+            status_t err = service->setTransactionStatsEnabled(dumpTypeFlags &
+                                                               TYPE_BINDER_STATS_ENABLE);
+            reportDumpError(serviceName, err, "setting binder stats");
+        }
+        if (dumpTypeFlags & TYPE_BINDER_STATS) {
+            status_t err = dumpBinderStatsToFd(service, remote_end);
+            reportDumpError(serviceName, err, "dumping binder stats");
+        }
 
         // other types always act as a header, this is usually longer
         if (dumpTypeFlags & TYPE_DUMP) {
@@ -57,6 +57,9 @@ class Dumpsys {
         TYPE_STABILITY = 0x4,  // dump stability information of server
         TYPE_THREAD = 0x8,     // dump thread usage of server only
         TYPE_CLIENTS = 0x10,   // dump pid of clients
+        TYPE_BINDER_STATS = 0x20,          // dump binder transaction stats of server
+        TYPE_BINDER_STATS_ENABLE = 0x40,   // start collecting binder transaction stats
+        TYPE_BINDER_STATS_DISABLE = 0x80,  // stop collecting binder transaction stats
     };
 
     /**
@@ -126,6 +129,17 @@ class Dumpsys {
     }
 
   private:
+    // Dumps a service to fd, with a header and footer if addSeparator is set.
+    void dumpService(int fd, int dumpTypeFlags, const String16& serviceName,
+                     const Vector<String16>& args, int priorityFlags, bool addSeparator,
+                     std::chrono::milliseconds timeout, bool asProto);
+
+    // Dumps up to jobs services at once, and prints them to stdout in order.
+    void dumpServicesInParallel(const Vector<String16>& services, size_t jobs, int dumpTypeFlags,
+                                const Vector<String16>& args, int priorityFlags,
+                                bool addSeparator, std::chrono::milliseconds timeout,
+                                bool asProto);
+
     android::IServiceManager* sm_;
     std::thread activeThread_;
     mutable android::base::unique_fd redirectFd_;
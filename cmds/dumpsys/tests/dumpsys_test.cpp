@@ -454,6 +454,26 @@ TEST_F(DumpsysTest, DumpMultipleServices) {
     AssertDumped("running3", "dump3");
 }
 
+// Tests 'dumpsys -j 2' with some services running
+TEST_F(DumpsysTest, DumpMultipleServicesInParallel) {
+    ExpectListServices({"running1", "stopped2", "running3", "running4"});
+    ExpectDumpAndHang("running1", 1, "dump1");
+    ExpectCheckService("stopped2", false);
+    ExpectDump("running3", "dump3");
+    ExpectDump("running4", "dump4");
+
+    CallMain({"-j", "2"});
+
+    AssertRunningServices({"running1", "running3", "running4"});
+    AssertDumped("running1", "dump1");
+    AssertStopped("stopped2");
+    AssertDumped("running3", "dump3");
+    AssertDumped("running4", "dump4");
+    // The slow first dump is still printed first.
+    AssertOutputFormat("(.|\n)*dump1(.|\n)*dump3(.|\n)*dump4(.|\n)*");
+    AssertOutputContains("was the total duration of dumpsys for 4 services with 2 jobs\n");
+}
+
 // Tests 'dumpsys --skip skipped3 skipped5', which should skip these services
 TEST_F(DumpsysTest, DumpWithSkip) {
     ExpectListServices({"running1", "stopped2", "skipped3", "running4", "skipped5"});
@@ -657,6 +677,20 @@ TEST_F(DumpsysTest, ListServiceWithClients) {
     const std::string format("Client PIDs are not available for local binders.\n");
     AssertOutputFormat(format);
 }
+
+// Tests 'dumpsys --binder-stats=enable service_name' and 'dumpsys --binder-stats service_name'
+TEST_F(DumpsysTest, ListServiceWithBinderStats) {
+    ExpectCheckService("Locksmith");
+
+    CallMain({"--binder-stats=enable", "Locksmith"});
+    CallMain({"--binder-stats", "Locksmith"});
+    AssertOutputContains("Binder transaction stats (enabled)");
+
+    CallMain({"--binder-stats=disable", "Locksmith"});
+    CallMain({"--binder-stats", "Locksmith"});
+    AssertOutputContains("Binder transaction stats (disabled)");
+}
+
 // Tests 'dumpsys --thread --stability'
 TEST_F(DumpsysTest, ListAllServicesWithMultipleOptions) {
     ExpectListServices({"Locksmith", "Valet"});
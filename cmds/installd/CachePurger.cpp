@@ -0,0 +1,116 @@
+/*
+ * Copyright (C) 2024 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#define ATRACE_TAG ATRACE_TAG_PACKAGE_MANAGER
+
+#include "CachePurger.h"
+
+#include <sys/resource.h>
+#include <unistd.h>
+#include <utils/Trace.h>
+
+#include <android-base/logging.h>
+#include <cutils/iosched_policy.h>
+#include <system/thread_defs.h>
+
+namespace android {
+namespace installd {
+
+// The lowest priority of the best effort IO class. The idle class is not used, since it could
+// keep freeCache from making any progress while the foreground is doing IO.
+static constexpr int kPurgeIoPriority = 7;
+
+CachePurger::CachePurger(size_t maxThreads) : mMaxThreads(maxThreads) {
+}
+
+CachePurger::~CachePurger() {
+    {
+        std::lock_guard lock(mLock);
+        mStopping = true;
+    }
+    mWorkAvailable.notify_all();
+    for (auto& thread : mThreads) {
+        thread.join();
+    }
+}
+
+void CachePurger::purge(const std::shared_ptr<CacheTracker>& tracker,
+                        const std::shared_ptr<CacheItem>& item) {
+    std::lock_guard lock(mLock);
+    TrackerQueue& queue = mQueues[tracker.get()];
+    if (queue.tracker == nullptr) {
+        queue.tracker = tracker;
+    }
+    queue.items.push_back(item);
+    mPendingItems++;
+    if (queue.scheduled) {
+        // The thread purging this tracker will get to it.
+        return;
+    }
+    queue.scheduled = true;
+    mReady.push_back(tracker.get());
+    if (mIdleThreads == 0 && mThreads.size() < mMaxThreads) {
+        mThreads.emplace_back(&CachePurger::threadMain, this);
+    } else {
+        mWorkAvailable.notify_one();
+    }
+}
+
+void CachePurger::waitForIdle() {
+    std::unique_lock lock(mLock);
+    mIdle.wait(lock, [this] { return mPendingItems == 0; });
+}
+
+void CachePurger::threadMain() {
+    if (setpriority(PRIO_PROCESS, gettid(), ANDROID_PRIORITY_BACKGROUND) < 0) {
+        PLOG(WARNING) << "Failed to lower the priority of the cache purging thread";
+    }
+    if (android_set_ioprio(gettid(), IoSchedClass_BE, kPurgeIoPriority) < 0) {
+        PLOG(WARNING) << "Failed to lower the IO priority of the cache purging thread";
+    }
+
+    std::unique_lock lock(mLock);
+    while (true) {
+        mIdleThreads++;
+        mWorkAvailable.wait(lock, [this] { return mStopping || !mReady.empty(); });
+        mIdleThreads--;
+        if (mReady.empty()) {
+            return;
+        }
+
+        TrackerQueue& queue = mQueues[mReady.front()];
+        mReady.pop_front();
+        while (!queue.items.empty()) {
+            auto item = std::move(queue.items.front());
+            queue.items.pop_front();
+
+            lock.unlock();
+            ATRACE_BEGIN("purge");
+            item->purge();
+            queue.tracker->onItemPurged(item);
+            ATRACE_END();
+            lock.lock();
+
+            if (--mPendingItems == 0) {
+                mIdle.notify_all();
+            }
+        }
+        queue.scheduled = false;
+    }
+}
+
+}  // namespace installd
+}  // namespace android
@@ -0,0 +1,82 @@
+/*
+ * Copyright (C) 2024 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef ANDROID_INSTALLD_CACHE_PURGER_H
+#define ANDROID_INSTALLD_CACHE_PURGER_H
+
+#include <condition_variable>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+#include <android-base/macros.h>
+
+#include "CacheItem.h"
+#include "CacheTracker.h"
+
+namespace android {
+namespace installd {
+
+/**
+ * Purges cache items on a bounded pool of background threads with low CPU and IO priority.
+ * Items of the same tracker are purged one after the other in the order they were submitted,
+ * since a directory is only purged once the items inside it are; items of different trackers
+ * are purged in parallel.
+ */
+class CachePurger {
+public:
+    explicit CachePurger(size_t maxThreads);
+    ~CachePurger();
+
+    void purge(const std::shared_ptr<CacheTracker>& tracker,
+               const std::shared_ptr<CacheItem>& item);
+
+    // Wait until all the submitted items are purged.
+    void waitForIdle();
+
+private:
+    struct TrackerQueue {
+        std::shared_ptr<CacheTracker> tracker;
+        std::deque<std::shared_ptr<CacheItem>> items;
+        // Whether a thread is purging the items of this tracker, or is about to.
+        bool scheduled = false;
+    };
+
+    const size_t mMaxThreads;
+
+    std::mutex mLock;
+    std::condition_variable mWorkAvailable;
+    std::condition_variable mIdle;
+    std::unordered_map<CacheTracker*, TrackerQueue> mQueues;
+    // Trackers that have items to purge and no thread purging them.
+    std::deque<CacheTracker*> mReady;
+    size_t mPendingItems = 0;
+    size_t mIdleThreads = 0;
+    bool mStopping = false;
+    std::vector<std::thread> mThreads;
+
+    void threadMain();
+
+    DISALLOW_COPY_AND_ASSIGN(CachePurger);
+};
+
+}  // namespace installd
+}  // namespace android
+
+#endif  // ANDROID_INSTALLD_CACHE_PURGER_H
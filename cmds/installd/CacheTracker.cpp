@@ -18,21 +18,45 @@
 
 #include "CacheTracker.h"
 
+#include <algorithm>
+
 #include <fts.h>
 #include <sys/xattr.h>
 #include <utils/Trace.h>
 
 #include <android-base/logging.h>
 #include <android-base/stringprintf.h>
+#include <android-base/strings.h>
 
 #include "QuotaUtils.h"
 #include "utils.h"
 
+using android::base::StartsWith;
 using android::base::StringPrintf;
 
 namespace android {
 namespace installd {
 
+using DirectoryStamp = CacheSnapshot::DirectoryStamp;
+
+DirectoryStamp CacheSnapshot::DirectoryStamp::fromStat(const struct stat& st) {
+    return {st.st_ino, st.st_mtim, st.st_ctim};
+}
+
+DirectoryStamp CacheSnapshot::DirectoryStamp::read(const std::string& path) {
+    struct stat st;
+    if (lstat(path.c_str(), &st) != 0) {
+        return {};
+    }
+    return fromStat(st);
+}
+
+bool CacheSnapshot::DirectoryStamp::operator==(const DirectoryStamp& other) const {
+    return inode == other.inode && modified.tv_sec == other.modified.tv_sec &&
+            modified.tv_nsec == other.modified.tv_nsec && changed.tv_sec == other.changed.tv_sec &&
+            changed.tv_nsec == other.changed.tv_nsec;
+}
+
 CacheTracker::CacheTracker(userid_t userId, appid_t appId, const std::string& uuid)
       : cacheUsed(0),
         cacheQuota(0),
@@ -120,6 +144,7 @@ void CacheTracker::loadItemsFrom(const std::string& path) {
 
         switch (p->fts_info) {
         case FTS_D: {
+            mSnapshot->directories[p->fts_path] = DirectoryStamp::fromStat(*p->fts_statp);
             auto item = static_cast<CacheItem*>(p->fts_pointer);
             item->group |= (getxattr(p->fts_path, kXattrCacheGroup, nullptr, 0) >= 0);
             item->tombstone |= (getxattr(p->fts_path, kXattrCacheTombstone, nullptr, 0) >= 0);
@@ -130,6 +155,9 @@ void CacheTracker::loadItemsFrom(const std::string& path) {
                     if (p->fts_info == FTS_DP && p->fts_level == item->level) break;
                     switch (p->fts_info) {
                     case FTS_D:
+                        mSnapshot->directories[p->fts_path] =
+                                DirectoryStamp::fromStat(*p->fts_statp);
+                        [[fallthrough]];
                     case FTS_DEFAULT:
                     case FTS_F:
                     case FTS_SL:
@@ -163,11 +191,18 @@ void CacheTracker::loadItemsFrom(const std::string& path) {
 
 void CacheTracker::loadItems() {
     items.clear();
+    mSnapshot = std::make_unique<CacheSnapshot>();
+    mSnapshot->dataPaths = mDataPaths;
 
     ATRACE_BEGIN("loadItems");
     for (const auto& path : mDataPaths) {
-        loadItemsFrom(read_path_inode(path, "cache", kXattrInodeCache));
-        loadItemsFrom(read_path_inode(path, "code_cache", kXattrInodeCodeCache));
+        auto cachePath = read_path_inode(path, "cache", kXattrInodeCache);
+        auto codeCachePath = read_path_inode(path, "code_cache", kXattrInodeCodeCache);
+        // Also remember the cache directories that do not exist yet, to notice when they appear.
+        stampDirectory(cachePath);
+        stampDirectory(codeCachePath);
+        loadItemsFrom(cachePath);
+        loadItemsFrom(codeCachePath);
     }
     ATRACE_END();
 
@@ -184,18 +219,95 @@ void CacheTracker::loadItems() {
         return left->directory;
     };
     std::stable_sort(items.begin(), items.end(), cmp);
+    mSnapshot->items = items;
     ATRACE_END();
 }
 
 void CacheTracker::ensureItems() {
     if (mItemsLoaded) {
         return;
+    } else if (isSnapshotCurrent()) {
+        items = mSnapshot->items;
+        mItemsLoaded = true;
     } else {
         loadItems();
         mItemsLoaded = true;
     }
 }
 
+void CacheTracker::setSnapshot(std::unique_ptr<CacheSnapshot> snapshot) {
+    mSnapshot = std::move(snapshot);
+}
+
+std::unique_ptr<CacheSnapshot> CacheTracker::takeSnapshot() {
+    return std::move(mSnapshot);
+}
+
+bool CacheTracker::isSnapshotCurrent() {
+    if (mSnapshot == nullptr || mSnapshot->dataPaths != mDataPaths) {
+        return false;
+    }
+
+    ATRACE_BEGIN("checkSnapshot");
+    bool current = true;
+    for (const auto& [path, stamp] : mSnapshot->directories) {
+        if (!(DirectoryStamp::read(path) == stamp)) {
+            current = false;
+            break;
+        }
+    }
+    ATRACE_END();
+    return current;
+}
+
+void CacheTracker::stampDirectory(const std::string& path) {
+    mSnapshot->directories[path] = DirectoryStamp::read(path);
+}
+
+void CacheTracker::onItemPurged(const std::shared_ptr<CacheItem>& item) {
+    if (mSnapshot == nullptr) {
+        return;
+    }
+
+    // Items are purged from the back, so look for it there first.
+    auto& snapshotItems = mSnapshot->items;
+    auto it = std::find(snapshotItems.rbegin(), snapshotItems.rend(), item);
+    if (it != snapshotItems.rend()) {
+        snapshotItems.erase(std::next(it).base());
+    }
+
+    auto& directories = mSnapshot->directories;
+    const auto path = item->buildPath();
+    if (item->directory) {
+        // Tombstone directories survive the purge, so restamp whatever is left of the tree.
+        auto restamp = [&directories](auto dir) {
+            struct stat st;
+            if (lstat(dir->first.c_str(), &st) == 0) {
+                dir->second = DirectoryStamp::fromStat(st);
+                return std::next(dir);
+            }
+            return directories.erase(dir);
+        };
+        auto dir = directories.find(path);
+        if (dir != directories.end()) {
+            restamp(dir);
+        }
+        const auto prefix = path + "/";
+        dir = directories.lower_bound(prefix);
+        while (dir != directories.end() && StartsWith(dir->first, prefix)) {
+            dir = restamp(dir);
+        }
+    }
+
+    const auto separator = path.rfind('/');
+    if (separator != std::string::npos) {
+        auto parent = directories.find(path.substr(0, separator));
+        if (parent != directories.end()) {
+            parent->second = DirectoryStamp::read(parent->first);
+        }
+    }
+}
+
 int CacheTracker::getCacheRatio() {
     if (cacheQuota == 0) {
         return 0;
@@ -17,6 +17,7 @@
 #ifndef ANDROID_INSTALLD_CACHE_TRACKER_H
 #define ANDROID_INSTALLD_CACHE_TRACKER_H
 
+#include <map>
 #include <memory>
 #include <string>
 #include <queue>
@@ -32,6 +33,31 @@
 namespace android {
 namespace installd {
 
+/**
+ * The items that a CacheTracker found in the cache directories of a UID, kept between freeCache
+ * calls. They are reused instead of walking the directories again as long as none of the
+ * directories they were found in has changed since. Files that are rewritten in place do not change
+ * their directory, so their size and modified time may be out of date until it changes.
+ */
+struct CacheSnapshot {
+    struct DirectoryStamp {
+        ino_t inode = 0;
+        struct timespec modified = {};
+        struct timespec changed = {};
+
+        // Returns an empty stamp if the directory does not exist.
+        static DirectoryStamp read(const std::string& path);
+        static DirectoryStamp fromStat(const struct stat& st);
+
+        bool operator==(const DirectoryStamp& other) const;
+    };
+
+    std::vector<std::string> dataPaths;
+    std::map<std::string, DirectoryStamp> directories;
+    // Sorted like CacheTracker::items.
+    std::vector<std::shared_ptr<CacheItem>> items;
+};
+
 /**
  * Cache tracker for a single UID. Each tracker is used in two modes: first
  * for loading lightweight "stats", and then by loading detailed "items"
@@ -51,6 +77,14 @@ public:
 
     void ensureItems();
 
+    // Offer the snapshot taken by a previous tracker of this UID, which ensureItems() uses if it is
+    // still current.
+    void setSnapshot(std::unique_ptr<CacheSnapshot> snapshot);
+    // Drop a purged item from the snapshot, and account for the changes the purge made to the
+    // directories, so that the snapshot stays current.
+    void onItemPurged(const std::shared_ptr<CacheItem>& item);
+    std::unique_ptr<CacheSnapshot> takeSnapshot();
+
     int getCacheRatio();
 
     int64_t cacheUsed;
@@ -65,9 +99,12 @@ private:
     const std::string& mUuid;
 
     std::vector<std::string> mDataPaths;
+    std::unique_ptr<CacheSnapshot> mSnapshot;
 
     bool loadQuotaStats();
     void loadItemsFrom(const std::string& path);
+    bool isSnapshotCurrent();
+    void stampDirectory(const std::string& path);
 
     DISALLOW_COPY_AND_ASSIGN(CacheTracker);
 };
@@ -36,6 +36,7 @@
 #include <sys/xattr.h>
 #include <unistd.h>
 #include <algorithm>
+#include <atomic>
 #include <filesystem>
 #include <fstream>
 #include <functional>
@@ -71,6 +72,7 @@
 #include "otapreopt_utils.h"
 #include "utils.h"
 
+#include "CachePurger.h"
 #include "CacheTracker.h"
 #include "CrateManager.h"
 #include "MatchExtensionGen.h"
@@ -85,6 +87,7 @@
 
 using android::base::ParseUint;
 using android::base::Split;
+using android::base::StartsWith;
 using android::base::StringPrintf;
 using android::base::unique_fd;
 using android::os::ParcelFileDescriptor;
@@ -98,6 +101,15 @@ static constexpr const char* kTestUuid = "TEST";
 
 static constexpr const mode_t kRollbackFolderMode = 0700;
 
+// The most threads freeCache deletes cache items on at the same time.
+static constexpr const size_t kFreeCacheMaxThreads = 4;
+
+// The most threads createAppDataBatched creates app data on at the same time.
+static constexpr const size_t kCreateAppDataMaxThreads = 4;
+
+// The most profman processes mergeProfilesBatched runs at the same time.
+static constexpr const size_t kMergeProfilesMaxThreads = 4;
+
 static constexpr const char* kCpPath = "/system/bin/cp";
 static constexpr const char* kXattrDefault = "user.default";
 
@@ -996,13 +1008,29 @@ binder::Status InstalldNativeService::createAppDataBatched(
 
     // Locking is performed depeer in the callstack.
 
-    std::vector<android::os::CreateAppDataResult> results;
-    for (const auto &arg : args) {
-        android::os::CreateAppDataResult result;
-        createAppData(arg, &result);
-        results.push_back(result);
-    }
-    *_aidl_return = results;
+    // Most of the time goes to restorecon and other filesystem calls, and createAppData() only
+    // holds the locks of its own package and user, so different packages are created on a few
+    // threads at the same time. The worker threads are not binder threads, so the calls they make
+    // are checked against installd's own uid; the caller was checked above.
+    std::vector<android::os::CreateAppDataResult> results(args.size());
+    std::atomic<size_t> next = 0;
+    auto createNext = [&]() {
+        for (size_t i = next++; i < args.size(); i = next++) {
+            createAppData(args[i], &results[i]);
+        }
+    };
+    const size_t threadCount =
+            std::min({args.size(), kCreateAppDataMaxThreads,
+                      static_cast<size_t>(std::max(1u, std::thread::hardware_concurrency()))});
+    std::vector<std::thread> threads;
+    for (size_t i = 1; i < threadCount; i++) {
+        threads.emplace_back(createNext);
+    }
+    createNext();
+    for (auto& thread : threads) {
+        thread.join();
+    }
+    *_aidl_return = std::move(results);
     return ok();
 }
 
@@ -2086,6 +2114,10 @@ binder::Status InstalldNativeService::destroyUserData(const std::optional<std::s
     return res;
 }
 
+static std::string getCacheSnapshotKey(const std::string& uuid, uid_t uid) {
+    return StringPrintf("%s:%d", uuid.c_str(), uid);
+}
+
 binder::Status InstalldNativeService::freeCache(const std::optional<std::string>& uuid,
         int64_t targetFreeBytes, int32_t flags) {
     ENFORCE_UID(AID_SYSTEM);
@@ -2194,6 +2226,14 @@ binder::Status InstalldNativeService::freeCache(const std::optional<std::string>
 #endif
                             tracker->cacheQuota = 67108864;
                         }
+                        {
+                            std::lock_guard<std::recursive_mutex> lock(mCacheSnapshotsLock);
+                            auto snapshot = mCacheSnapshots.find(getCacheSnapshotKey(uuidString,
+                                                                                     uid));
+                            if (snapshot != mCacheSnapshots.end()) {
+                                tracker->setSnapshot(std::move(snapshot->second));
+                            }
+                        }
                         trackers[uid] = tracker;
                     }
                     fts_set(fts, p, FTS_SKIP);
@@ -2217,8 +2257,10 @@ binder::Status InstalldNativeService::freeCache(const std::optional<std::string>
         atrace_pm_end();
 
         // 3. Bounce across the queue, freeing items from whichever tracker is
-        // the most over their assigned quota
+        // the most over their assigned quota. The items are purged in the
+        // background, in parallel for different trackers
         atrace_pm_begin("bounce");
+        CachePurger purger(kFreeCacheMaxThreads);
         std::shared_ptr<CacheTracker> active;
         while (active || !queue.empty()) {
             // Only look at apps under quota when explicitly requested
@@ -2254,7 +2296,7 @@ binder::Status InstalldNativeService::freeCache(const std::optional<std::string>
 
                 LOG(DEBUG) << "Purging " << item->toString() << " from " << active->toString();
                 if (!noop) {
-                    item->purge();
+                    purger.purge(active, item);
                 }
                 active->cacheUsed -= item->size;
                 needed -= item->size;
@@ -2264,6 +2306,7 @@ binder::Status InstalldNativeService::freeCache(const std::optional<std::string>
                 // Verify that we're actually done before bailing, since sneaky
                 // apps might be using hardlinks
                 if (needed <= 0) {
+                    purger.waitForIdle();
                     free = data_disk_free(data_path);
                     needed = targetFreeBytes - free;
                     if (needed <= 0) {
@@ -2274,8 +2317,29 @@ binder::Status InstalldNativeService::freeCache(const std::optional<std::string>
                 }
             }
         }
+        purger.waitForIdle();
         atrace_pm_end();
 
+        // 4. Keep the items found this time for the next call, and forget the UIDs that no longer
+        // have cache directories on this volume
+        {
+            std::lock_guard<std::recursive_mutex> lock(mCacheSnapshotsLock);
+            const auto prefix = uuidString + ":";
+            for (auto it = mCacheSnapshots.begin(); it != mCacheSnapshots.end();) {
+                if (StartsWith(it->first, prefix)) {
+                    it = mCacheSnapshots.erase(it);
+                } else {
+                    ++it;
+                }
+            }
+            for (const auto& [uid, tracker] : trackers) {
+                auto snapshot = tracker->takeSnapshot();
+                if (snapshot != nullptr) {
+                    mCacheSnapshots[getCacheSnapshotKey(uuidString, uid)] = std::move(snapshot);
+                }
+            }
+        }
+
     } else {
         return error("Legacy cache logic no longer supported");
     }
@@ -2576,6 +2640,60 @@ static bool ownsExternalStorage(int32_t appId) {
     }
     return false;
 }
+// Measures the dalvik cache once for all the apps, instead of walking it for the GID of each app
+// that getAppSize() is called for. The sizes are reused until a directory of the cache changes,
+// which happens whenever a file is created, renamed or removed in it.
+int64_t InstalldNativeService::getDalvikCacheSizeForGid(gid_t gid) {
+    std::lock_guard<std::recursive_mutex> lock(mDalvikCacheSizesLock);
+
+    bool current = mDalvikCacheSizes.has_value();
+    if (current) {
+        for (const auto& [path, stamp] : mDalvikCacheSizes->directories) {
+            if (!(CacheSnapshot::DirectoryStamp::read(path) == stamp)) {
+                current = false;
+                break;
+            }
+        }
+    }
+
+    if (!current) {
+        atrace_pm_begin("measure");
+        mDalvikCacheSizes.emplace();
+        FTS* fts;
+        FTSENT* p;
+        auto path = create_data_dalvik_cache_path();
+        char* argv[] = {(char*)path.c_str(), nullptr};
+        if (!(fts = fts_open(argv, FTS_PHYSICAL | FTS_NOCHDIR | FTS_XDEV, nullptr))) {
+            if (errno != ENOENT) {
+                PLOG(ERROR) << "Failed to fts_open " << path;
+            }
+            // Measure again next time.
+            mDalvikCacheSizes.reset();
+            atrace_pm_end();
+            return 0;
+        }
+        while ((p = fts_read(fts)) != nullptr) {
+            switch (p->fts_info) {
+            case FTS_D:
+                mDalvikCacheSizes->directories[p->fts_path] =
+                        CacheSnapshot::DirectoryStamp::fromStat(*p->fts_statp);
+                [[fallthrough]];
+            case FTS_DEFAULT:
+            case FTS_F:
+            case FTS_SL:
+            case FTS_SLNONE:
+                mDalvikCacheSizes->sizes[p->fts_statp->st_gid] += p->fts_statp->st_blocks * 512;
+                break;
+            }
+        }
+        fts_close(fts);
+        atrace_pm_end();
+    }
+
+    auto size = mDalvikCacheSizes->sizes.find(gid);
+    return size != mDalvikCacheSizes->sizes.end() ? size->second : 0;
+}
+
 binder::Status InstalldNativeService::getAppSize(const std::optional<std::string>& uuid,
         const std::vector<std::string>& packageNames, int32_t userId, int32_t flags,
         int32_t appId, const std::vector<int64_t>& ceDataInodes,
@@ -2701,8 +2819,7 @@ binder::Status InstalldNativeService::getAppSize(const std::optional<std::string
             atrace_pm_begin("dalvik");
             int32_t sharedGid = multiuser_get_shared_gid(0, appId);
             if (sharedGid != -1) {
-                calculate_tree_size(create_data_dalvik_cache_path(), &stats.codeSize,
-                        sharedGid, -1);
+                stats.codeSize += getDalvikCacheSizeForGid(sharedGid);
             }
             atrace_pm_end();
         }
@@ -3236,6 +3353,44 @@ binder::Status InstalldNativeService::mergeProfiles(int32_t uid, const std::stri
     return ok();
 }
 
+binder::Status InstalldNativeService::mergeProfilesBatched(
+        const std::vector<android::os::MergeProfilesArgs>& args,
+        std::vector<int32_t>* _aidl_return) {
+    ENFORCE_UID(AID_SYSTEM);
+    for (const auto& arg : args) {
+        CHECK_ARGUMENT_PACKAGE_NAME(arg.packageName);
+    }
+
+    // Locking is performed deeper in the callstack.
+
+    // Each merge waits for a profman process, and mergeProfiles() only holds the lock of its own
+    // package, so as for createAppDataBatched, a few packages are merged at the same time.
+    std::vector<int32_t> results(args.size(), PROFILES_ANALYSIS_DONT_OPTIMIZE_SMALL_DELTA);
+    std::atomic<size_t> next = 0;
+    auto mergeNext = [&]() {
+        for (size_t i = next++; i < args.size(); i = next++) {
+            int result;
+            if (mergeProfiles(args[i].uid, args[i].packageName, args[i].profileName, &result)
+                        .isOk()) {
+                results[i] = result;
+            }
+        }
+    };
+    const size_t threadCount =
+            std::min({args.size(), kMergeProfilesMaxThreads,
+                      static_cast<size_t>(std::max(1u, std::thread::hardware_concurrency()))});
+    std::vector<std::thread> threads;
+    for (size_t i = 1; i < threadCount; i++) {
+        threads.emplace_back(mergeNext);
+    }
+    mergeNext();
+    for (auto& thread : threads) {
+        thread.join();
+    }
+    *_aidl_return = std::move(results);
+    return ok();
+}
+
 binder::Status InstalldNativeService::createProfileSnapshot(int32_t appId,
         const std::string& packageName, const std::string& profileName,
         const std::string& classpath, bool* _aidl_return) {
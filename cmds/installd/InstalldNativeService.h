@@ -22,6 +22,8 @@
 #include <sys/stat.h>
 #include <unistd.h>
 
+#include <map>
+#include <optional>
 #include <shared_mutex>
 #include <unordered_map>
 #include <vector>
@@ -30,6 +32,7 @@
 #include <binder/BinderService.h>
 #include <cutils/multiuser.h>
 
+#include "CacheTracker.h"
 #include "android/os/BnInstalld.h"
 #include "installd_constants.h"
 
@@ -149,6 +152,8 @@ public:
 
     binder::Status mergeProfiles(int32_t uid, const std::string& packageName,
             const std::string& profileName, int* _aidl_return);
+    binder::Status mergeProfilesBatched(const std::vector<android::os::MergeProfilesArgs>& args,
+                                        std::vector<int32_t>* _aidl_return);
     binder::Status dumpProfiles(int32_t uid, const std::string& packageName,
                                 const std::string& profileName, const std::string& codePath,
                                 bool dumpClassesAndMethods, bool* _aidl_return);
@@ -229,8 +234,22 @@ private:
     /* Map from UID to cache quota size */
     std::unordered_map<uid_t, int64_t> mCacheQuotas;
 
+    std::recursive_mutex mDalvikCacheSizesLock;
+    /* Sizes of the files in the dalvik cache by GID, and the directories they were found in */
+    struct DalvikCacheSizes {
+        std::map<std::string, CacheSnapshot::DirectoryStamp> directories;
+        std::unordered_map<gid_t, int64_t> sizes;
+    };
+    std::optional<DalvikCacheSizes> mDalvikCacheSizes;
+
+    std::recursive_mutex mCacheSnapshotsLock;
+    /* Map from volume UUID and UID to the cache items found by the last freeCache */
+    std::unordered_map<std::string, std::unique_ptr<CacheSnapshot>> mCacheSnapshots;
+
     std::string findDataMediaPath(const std::optional<std::string>& uuid, userid_t userid);
 
+    int64_t getDalvikCacheSizeForGid(gid_t gid);
+
     binder::Status createAppDataLocked(const std::optional<std::string>& uuid,
                                        const std::string& packageName, int32_t userId,
                                        int32_t flags, int32_t appId, int32_t previousAppId,
@@ -28,14 +28,19 @@
 #include <sys/wait.h>
 #include <unistd.h>
 
+#include <algorithm>
 #include <array>
 #include <iomanip>
 #include <mutex>
+#include <optional>
+#include <thread>
+#include <unordered_map>
 #include <unordered_set>
 
 #include <android-base/file.h>
 #include <android-base/logging.h>
 #include <android-base/no_destructor.h>
+#include <android-base/parseint.h>
 #include <android-base/properties.h>
 #include <android-base/stringprintf.h>
 #include <android-base/strings.h>
@@ -56,6 +61,7 @@
 
 #include "dexopt.h"
 #include "dexopt_return_codes.h"
+#include "dexopt_scheduler.h"
 #include "execv_helper.h"
 #include "globals.h"
 #include "installd_constants.h"
@@ -70,6 +76,8 @@ using android::base::Basename;
 using android::base::EndsWith;
 using android::base::GetBoolProperty;
 using android::base::GetProperty;
+using android::base::ParseByteCount;
+using android::base::ParseUint;
 using android::base::ReadFdToString;
 using android::base::ReadFully;
 using android::base::StringPrintf;
@@ -153,6 +161,84 @@ class DexOptStatus {
 
 android::base::NoDestructor<DexOptStatus> dexopt_status_;
 
+// Remembers the primary profiles that profman found not worth compiling, so that merging them
+// again before any of them changed returns the same result without running profman. Background
+// dexopt merges the profiles of every package, and most of them haven't changed since last time.
+class ProfileMergeHistory {
+ public:
+    struct FileStamp {
+        dev_t dev;
+        ino_t ino;
+        off_t size;
+        int64_t mtime_ns;
+
+        bool operator==(const FileStamp& other) const {
+            return dev == other.dev && ino == other.ino && size == other.size &&
+                    mtime_ns == other.mtime_ns;
+        }
+        bool operator!=(const FileStamp& other) const { return !(*this == other); }
+    };
+
+    // Returns the result of the last merge of these profiles, if none of them changed since.
+    std::optional<int> find(const std::string& key, const std::vector<FileStamp>& stamps) {
+        std::lock_guard<std::mutex> lock(lock_);
+        auto it = merges_.find(key);
+        if (it == merges_.end() || it->second.stamps != stamps) {
+            return std::nullopt;
+        }
+        return it->second.result;
+    }
+
+    // Records the result of merging the profiles, as they were before the merge. Since they are
+    // stamped before profman reads them, a profile written during the merge is merged again.
+    void insert(const std::string& key, std::vector<FileStamp>&& stamps, int result) {
+        std::lock_guard<std::mutex> lock(lock_);
+        merges_.insert_or_assign(key, Merge{std::move(stamps), result});
+    }
+
+    void erase(const std::string& key) {
+        std::lock_guard<std::mutex> lock(lock_);
+        merges_.erase(key);
+    }
+
+    static bool get_stamps(const std::vector<unique_fd>& profile_fds,
+                           const unique_fd& reference_profile_fd,
+                           /*out*/ std::vector<FileStamp>* stamps) {
+        stamps->clear();
+        auto add = [&](const unique_fd& fd) {
+            struct stat st;
+            if (fstat(fd.get(), &st) != 0) {
+                return false;
+            }
+            stamps->push_back({st.st_dev, st.st_ino, st.st_size,
+                               st.st_mtim.tv_sec * 1'000'000'000LL + st.st_mtim.tv_nsec});
+            return true;
+        };
+        if (!add(reference_profile_fd)) {
+            return false;
+        }
+        for (const unique_fd& fd : profile_fds) {
+            if (!add(fd)) {
+                return false;
+            }
+        }
+        return true;
+    }
+
+ private:
+    struct Merge {
+        std::vector<FileStamp> stamps;
+        int result;
+    };
+
+    std::mutex lock_;
+    std::unordered_map<std::string, Merge> merges_ GUARDED_BY(lock_);
+};
+
+android::base::NoDestructor<ProfileMergeHistory> profile_merge_history_;
+
+android::base::NoDestructor<android::installd::DexoptScheduler> dexopt_scheduler_;
+
 } // namespace
 
 namespace android {
@@ -360,6 +446,56 @@ static bool ShouldUseSwapFileForDexopt() {
     return kDefaultProvideSwapFile;
 }
 
+static uint64_t GetByteCountProperty(const std::string& key) {
+    uint64_t bytes = 0;
+    std::string value = GetProperty(key, "");
+    if (!value.empty() && !ParseByteCount(value.c_str(), &bytes)) {
+        LOG(WARNING) << "Invalid byte count for " << key << ": " << value;
+        bytes = 0;
+    }
+    return bytes;
+}
+
+static std::string GetPropertyWithBackup(const std::string& key, const std::string& backup_key) {
+    std::string value = GetProperty(key, "");
+    return value.empty() ? GetProperty(backup_key, "") : value;
+}
+
+// The budget within which dex2oat processes run at the same time. Limits are off by default.
+static DexoptScheduler::Budget GetDex2oatBudget() {
+    DexoptScheduler::Budget budget;
+    ParseUint(GetProperty("dalvik.vm.dex2oat-max-jobs", ""), &budget.max_jobs);
+    ParseUint(GetProperty("dalvik.vm.dex2oat-thread-budget", ""), &budget.max_threads);
+    budget.max_memory_bytes = GetByteCountProperty("dalvik.vm.dex2oat-memory-budget");
+    return budget;
+}
+
+// What a dex2oat process takes of the budget, going by the same properties that RunDex2Oat passes
+// to it.
+static DexoptScheduler::Job GetDex2oatJob(bool boot_complete, bool for_restore,
+                                          bool background_job_compile) {
+    DexoptScheduler::Job job;
+    job.priority = boot_complete && background_job_compile
+            ? DexoptScheduler::Priority::kBackground
+            : DexoptScheduler::Priority::kForeground;
+
+    std::string threads = !boot_complete
+            ? GetProperty("dalvik.vm.boot-dex2oat-threads", "")
+            : (for_restore ? GetPropertyWithBackup("dalvik.vm.restore-dex2oat-threads",
+                                                   "dalvik.vm.dex2oat-threads")
+                           : (background_job_compile
+                                      ? GetPropertyWithBackup(
+                                                "dalvik.vm.background-dex2oat-threads",
+                                                "dalvik.vm.dex2oat-threads")
+                                      : GetProperty("dalvik.vm.dex2oat-threads", "")));
+    if (!ParseUint(threads, &job.threads) || job.threads == 0) {
+        // dex2oat uses a thread per CPU by default.
+        job.threads = std::max(1u, std::thread::hardware_concurrency());
+    }
+    job.memory_bytes = GetByteCountProperty("dalvik.vm.dex2oat-Xmx");
+    return job;
+}
+
 static void SetDex2OatScheduling(bool set_to_bg) {
     if (set_to_bg) {
         if (!SetTaskProfiles(0, {"Dex2OatBootComplete"})) {
@@ -670,6 +806,18 @@ static int analyze_profiles(uid_t uid, const std::string& package_name,
         return PROFILES_ANALYSIS_DONT_OPTIMIZE_EMPTY_PROFILES;
     }
 
+    const bool for_boot_image = IsBootClassPathProfilingEnable();
+    const std::string merge_key = StringPrintf("%u:%s:%s:%d", uid, package_name.c_str(),
+                                               location.c_str(), for_boot_image);
+    std::vector<ProfileMergeHistory::FileStamp> stamps;
+    if (!is_secondary_dex) {
+        if (!ProfileMergeHistory::get_stamps(profiles_fd, reference_profile_fd, &stamps)) {
+            stamps.clear();
+        } else if (std::optional<int> result = profile_merge_history_->find(merge_key, stamps)) {
+            return *result;
+        }
+    }
+
     RunProfman profman_merge;
     const std::vector<unique_fd>& apk_fds = std::vector<unique_fd>();
     const std::vector<std::string>& dex_locations = std::vector<std::string>();
@@ -679,7 +827,7 @@ static int analyze_profiles(uid_t uid, const std::string& package_name,
             apk_fds,
             dex_locations,
             /* for_snapshot= */ false,
-            IsBootClassPathProfilingEnable());
+            for_boot_image);
     pid_t pid = fork();
     if (pid == 0) {
         /* child -- drop privileges before continuing */
@@ -692,6 +840,8 @@ static int analyze_profiles(uid_t uid, const std::string& package_name,
     bool empty_profiles = false;
     bool should_clear_current_profiles = false;
     bool should_clear_reference_profile = false;
+    // Whether merging the same profiles again would give the same result.
+    bool result_is_final = false;
     if (!WIFEXITED(return_code)) {
         LOG(WARNING) << "profman failed for location " << location << ": " << return_code;
         cleanup_output_fd(reference_profile_fd.get());
@@ -707,12 +857,14 @@ static int analyze_profiles(uid_t uid, const std::string& package_name,
                 need_to_compile = false;
                 should_clear_current_profiles = false;
                 should_clear_reference_profile = false;
+                result_is_final = true;
                 break;
             case PROFMAN_BIN_RETURN_CODE_SKIP_COMPILATION_EMPTY_PROFILES:
                 need_to_compile = false;
                 empty_profiles = true;
                 should_clear_current_profiles = false;
                 should_clear_reference_profile = false;
+                result_is_final = true;
                 break;
             case PROFMAN_BIN_RETURN_CODE_BAD_PROFILES:
                 LOG(WARNING) << "Bad profiles for location " << location;
@@ -764,6 +916,13 @@ static int analyze_profiles(uid_t uid, const std::string& package_name,
     } else {
         result = PROFILES_ANALYSIS_DONT_OPTIMIZE_SMALL_DELTA;
     }
+    if (!is_secondary_dex) {
+        if (result_is_final && !stamps.empty()) {
+            profile_merge_history_->insert(merge_key, std::move(stamps), result);
+        } else {
+            profile_merge_history_->erase(merge_key);
+        }
+    }
     return result;
 }
 
@@ -1608,6 +1767,7 @@ static std::string join_fds(const std::vector<unique_fd>& fds) {
 
 void control_dexopt_blocking(bool block) {
     dexopt_status_->control_dexopt_blocking(block);
+    dexopt_scheduler_->SetBlocked(block);
 }
 
 bool is_dexopt_blocked() {
@@ -1968,9 +2128,20 @@ int dexopt(const char* dex_path, uid_t uid, const char* pkgname, const char* ins
                       enable_hidden_api_checks, generate_compact_dex, compile_without_image,
                       background_job_compile, compilation_reason);
 
+    // Wait for the dex2oat processes that are running for other packages to leave room for this
+    // one.
+    const DexoptScheduler::Job job =
+            GetDex2oatJob(boot_complete, for_restore, background_job_compile);
+    if (!dexopt_scheduler_->Acquire(job, GetDex2oatBudget())) {
+        *completed = false;
+        reference_profile.DisableCleanup();
+        return 0;
+    }
+
     bool cancelled = false;
     pid_t pid = dexopt_status_->check_cancellation_and_fork(&cancelled);
     if (cancelled) {
+        dexopt_scheduler_->Release(job);
         *completed = false;
         reference_profile.DisableCleanup();
         return 0;
@@ -1992,6 +2163,7 @@ int dexopt(const char* dex_path, uid_t uid, const char* pkgname, const char* ins
         runner.Exec(DexoptReturnCodes::kDex2oatExec);
     } else {
         int res = wait_child_with_timeout(pid, kLongTimeoutMs);
+        dexopt_scheduler_->Release(job);
         bool cancelled = dexopt_status_->check_if_killed_and_remove_dexopt_pid(pid);
         if (res == 0) {
             LOG(VERBOSE) << "DexInv: --- END '" << dex_path << "' (success) ---";
@@ -0,0 +1,83 @@
+/*
+ * Copyright (C) 2024 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "dexopt_scheduler.h"
+
+namespace android {
+namespace installd {
+
+bool DexoptScheduler::Acquire(const Job& job, const Budget& budget) {
+    std::unique_lock<std::mutex> lock(lock_);
+    const bool foreground = job.priority == Priority::kForeground;
+    if (foreground) {
+        waiting_foreground_jobs_++;
+    }
+    changed_.wait(lock, [&]() REQUIRES(lock_) {
+        return blocked_ ||
+                (CanRunLocked(job, budget) && (foreground || waiting_foreground_jobs_ == 0));
+    });
+    if (foreground) {
+        waiting_foreground_jobs_--;
+        // Background jobs may have been waiting for this one to go ahead.
+        changed_.notify_all();
+    }
+    if (blocked_) {
+        return false;
+    }
+
+    running_jobs_++;
+    running_threads_ += job.threads;
+    running_memory_bytes_ += job.memory_bytes;
+    return true;
+}
+
+void DexoptScheduler::Release(const Job& job) {
+    {
+        std::lock_guard<std::mutex> lock(lock_);
+        running_jobs_--;
+        running_threads_ -= job.threads;
+        running_memory_bytes_ -= job.memory_bytes;
+    }
+    changed_.notify_all();
+}
+
+void DexoptScheduler::SetBlocked(bool blocked) {
+    {
+        std::lock_guard<std::mutex> lock(lock_);
+        blocked_ = blocked;
+    }
+    changed_.notify_all();
+}
+
+bool DexoptScheduler::CanRunLocked(const Job& job, const Budget& budget) const {
+    if (running_jobs_ == 0) {
+        return true;
+    }
+    if (budget.max_jobs != 0 && running_jobs_ + 1 > budget.max_jobs) {
+        return false;
+    }
+    if (budget.max_threads != 0 && running_threads_ + job.threads > budget.max_threads) {
+        return false;
+    }
+    if (budget.max_memory_bytes != 0 &&
+        running_memory_bytes_ + job.memory_bytes > budget.max_memory_bytes) {
+        return false;
+    }
+    return true;
+}
+
+}  // namespace installd
+}  // namespace android
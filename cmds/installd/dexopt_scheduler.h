@@ -0,0 +1,81 @@
+/*
+ * Copyright (C) 2024 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef ANDROID_INSTALLD_DEXOPT_SCHEDULER_H
+#define ANDROID_INSTALLD_DEXOPT_SCHEDULER_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include <condition_variable>
+#include <mutex>
+
+#include <android-base/thread_annotations.h>
+
+namespace android {
+namespace installd {
+
+// DexoptScheduler decides how many dex2oat processes run at the same time. dexopt calls for
+// different packages come in on different binder threads, and each one waits until its dex2oat
+// fits in the budget left by the ones running. Jobs of the foreground class, which apps being
+// installed or the boot are waiting for, go ahead of background jobs.
+class DexoptScheduler {
+  public:
+    enum class Priority {
+        kForeground,
+        kBackground,
+    };
+
+    // A limit of 0 means no limit. A job that does not fit in the budget on its own still runs, but
+    // only when no other job does.
+    struct Budget {
+        size_t max_jobs = 0;
+        size_t max_threads = 0;
+        uint64_t max_memory_bytes = 0;
+    };
+
+    struct Job {
+        Priority priority = Priority::kForeground;
+        size_t threads = 1;
+        uint64_t memory_bytes = 0;
+    };
+
+    // Wait until the job fits in the budget. Returns false if dexopt is blocked, either before or
+    // while waiting, in which case the job must not run.
+    bool Acquire(const Job& job, const Budget& budget);
+
+    // Give back what an acquired job used, once it is done.
+    void Release(const Job& job);
+
+    // While blocked, Acquire() returns false right away.
+    void SetBlocked(bool blocked);
+
+  private:
+    bool CanRunLocked(const Job& job, const Budget& budget) const REQUIRES(lock_);
+
+    std::mutex lock_;
+    std::condition_variable changed_;
+    bool blocked_ GUARDED_BY(lock_) = false;
+    size_t running_jobs_ GUARDED_BY(lock_) = 0;
+    size_t running_threads_ GUARDED_BY(lock_) = 0;
+    uint64_t running_memory_bytes_ GUARDED_BY(lock_) = 0;
+    size_t waiting_foreground_jobs_ GUARDED_BY(lock_) = 0;
+};
+
+}  // namespace installd
+}  // namespace android
+
+#endif  // ANDROID_INSTALLD_DEXOPT_SCHEDULER_H
@@ -0,0 +1,157 @@
+/*
+ * Copyright (C) 2024 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <atomic>
+#include <chrono>
+#include <thread>
+
+#include <gtest/gtest.h>
+
+#include "dexopt_scheduler.h"
+
+namespace android {
+namespace installd {
+
+using Budget = DexoptScheduler::Budget;
+using Job = DexoptScheduler::Job;
+using Priority = DexoptScheduler::Priority;
+
+// How long to wait to be reasonably sure that a thread is blocked.
+static constexpr std::chrono::milliseconds kBlockedTimeout(100);
+
+class DexoptSchedulerTest : public testing::Test {
+  protected:
+    DexoptScheduler scheduler_;
+
+    // Acquire the job on another thread, and set acquired once it is.
+    std::thread AcquireAsync(const Job& job, const Budget& budget, std::atomic<bool>* acquired,
+                             bool* result) {
+        return std::thread([this, job, budget, acquired, result] {
+            *result = scheduler_.Acquire(job, budget);
+            *acquired = true;
+        });
+    }
+};
+
+TEST_F(DexoptSchedulerTest, NoLimitsByDefault) {
+    const Budget budget;
+    const Job job{Priority::kForeground, /*threads=*/8, /*memory_bytes=*/1 << 30};
+    EXPECT_TRUE(scheduler_.Acquire(job, budget));
+    EXPECT_TRUE(scheduler_.Acquire(job, budget));
+    EXPECT_TRUE(scheduler_.Acquire(job, budget));
+    scheduler_.Release(job);
+    scheduler_.Release(job);
+    scheduler_.Release(job);
+}
+
+TEST_F(DexoptSchedulerTest, JobOverBudgetRunsAlone) {
+    const Budget budget{/*max_jobs=*/0, /*max_threads=*/4, /*max_memory_bytes=*/0};
+    const Job job{Priority::kForeground, /*threads=*/8, /*memory_bytes=*/0};
+    EXPECT_TRUE(scheduler_.Acquire(job, budget));
+    scheduler_.Release(job);
+}
+
+TEST_F(DexoptSchedulerTest, WaitsForThreadBudget) {
+    const Budget budget{/*max_jobs=*/0, /*max_threads=*/4, /*max_memory_bytes=*/0};
+    const Job job{Priority::kForeground, /*threads=*/3, /*memory_bytes=*/0};
+    ASSERT_TRUE(scheduler_.Acquire(job, budget));
+
+    std::atomic<bool> acquired = false;
+    bool result = false;
+    std::thread thread = AcquireAsync(job, budget, &acquired, &result);
+    std::this_thread::sleep_for(kBlockedTimeout);
+    EXPECT_FALSE(acquired);
+
+    scheduler_.Release(job);
+    thread.join();
+    EXPECT_TRUE(result);
+    scheduler_.Release(job);
+}
+
+TEST_F(DexoptSchedulerTest, WaitsForMemoryBudget) {
+    const Budget budget{/*max_jobs=*/0, /*max_threads=*/0, /*max_memory_bytes=*/1000};
+    const Job job{Priority::kForeground, /*threads=*/1, /*memory_bytes=*/600};
+    ASSERT_TRUE(scheduler_.Acquire(job, budget));
+
+    std::atomic<bool> acquired = false;
+    bool result = false;
+    std::thread thread = AcquireAsync(job, budget, &acquired, &result);
+    std::this_thread::sleep_for(kBlockedTimeout);
+    EXPECT_FALSE(acquired);
+
+    scheduler_.Release(job);
+    thread.join();
+    EXPECT_TRUE(result);
+    scheduler_.Release(job);
+}
+
+TEST_F(DexoptSchedulerTest, ForegroundGoesAheadOfBackground) {
+    const Budget budget{/*max_jobs=*/1, /*max_threads=*/0, /*max_memory_bytes=*/0};
+    const Job foreground{Priority::kForeground, /*threads=*/1, /*memory_bytes=*/0};
+    const Job background{Priority::kBackground, /*threads=*/1, /*memory_bytes=*/0};
+    ASSERT_TRUE(scheduler_.Acquire(background, budget));
+
+    std::atomic<bool> foregroundAcquired = false;
+    bool foregroundResult = false;
+    std::thread foregroundThread =
+            AcquireAsync(foreground, budget, &foregroundAcquired, &foregroundResult);
+    std::this_thread::sleep_for(kBlockedTimeout);
+
+    std::atomic<bool> backgroundAcquired = false;
+    bool backgroundResult = false;
+    std::thread backgroundThread =
+            AcquireAsync(background, budget, &backgroundAcquired, &backgroundResult);
+    std::this_thread::sleep_for(kBlockedTimeout);
+    EXPECT_FALSE(foregroundAcquired);
+    EXPECT_FALSE(backgroundAcquired);
+
+    // The foreground job runs first, and the background one only once it is done.
+    scheduler_.Release(background);
+    foregroundThread.join();
+    EXPECT_TRUE(foregroundResult);
+    std::this_thread::sleep_for(kBlockedTimeout);
+    EXPECT_FALSE(backgroundAcquired);
+
+    scheduler_.Release(foreground);
+    backgroundThread.join();
+    EXPECT_TRUE(backgroundResult);
+    scheduler_.Release(background);
+}
+
+TEST_F(DexoptSchedulerTest, BlockingCancelsWaitingJobs) {
+    const Budget budget{/*max_jobs=*/1, /*max_threads=*/0, /*max_memory_bytes=*/0};
+    const Job job{Priority::kForeground, /*threads=*/1, /*memory_bytes=*/0};
+    ASSERT_TRUE(scheduler_.Acquire(job, budget));
+
+    std::atomic<bool> acquired = false;
+    bool result = true;
+    std::thread thread = AcquireAsync(job, budget, &acquired, &result);
+    std::this_thread::sleep_for(kBlockedTimeout);
+    EXPECT_FALSE(acquired);
+
+    scheduler_.SetBlocked(true);
+    thread.join();
+    EXPECT_FALSE(result);
+    EXPECT_FALSE(scheduler_.Acquire(job, budget));
+
+    scheduler_.Release(job);
+    scheduler_.SetBlocked(false);
+    EXPECT_TRUE(scheduler_.Acquire(job, budget));
+    scheduler_.Release(job);
+}
+
+}  // namespace installd
+}  // namespace android
@@ -15,7 +15,9 @@
  */
 
 #include <fcntl.h>
+#include <inttypes.h>
 #include <linux/unistd.h>
+#include <stdio.h>
 #include <sys/mount.h>
 #include <sys/stat.h>
 #include <sys/wait.h>
@@ -25,11 +27,16 @@
 #include <array>
 #include <fstream>
 #include <iostream>
+#include <mutex>
 #include <sstream>
+#include <thread>
+#include <vector>
 
 #include <android-base/file.h>
 #include <android-base/logging.h>
 #include <android-base/macros.h>
+#include <android-base/parseint.h>
+#include <android-base/properties.h>
 #include <android-base/scopeguard.h>
 #include <android-base/stringprintf.h>
 #include <android-base/strings.h>
@@ -44,6 +51,9 @@
 #define LOG_TAG "otapreopt_chroot"
 #endif
 
+using android::base::GetProperty;
+using android::base::ParseByteCount;
+using android::base::ParseUint;
 using android::base::StringPrintf;
 
 namespace android {
@@ -134,6 +144,64 @@ static void TryExtraMount(const char* name, const char* slot, const char* target
     (void)TryMountWithFstypes(block_device.c_str(), target);
 }
 
+static uint64_t GetByteCountProperty(const std::string& key) {
+    uint64_t bytes = 0;
+    std::string value = GetProperty(key, "");
+    if (!value.empty() && !ParseByteCount(value.c_str(), &bytes)) {
+        LOG(WARNING) << "Invalid byte count for " << key << ": " << value;
+        bytes = 0;
+    }
+    return bytes;
+}
+
+// Returns the MemAvailable line of /proc/meminfo in bytes, or 0 if it cannot be read.
+static uint64_t GetAvailableMemoryBytes() {
+    std::ifstream meminfo("/proc/meminfo");
+    std::string line;
+    while (std::getline(meminfo, line)) {
+        uint64_t kilobytes = 0;
+        if (sscanf(line.c_str(), "MemAvailable: %" SCNu64 " kB", &kilobytes) == 1) {
+            return kilobytes * 1024;
+        }
+    }
+    return 0;
+}
+
+// Returns how many otapreopt processes run at the same time, each compiling its own packages.
+// Up to dalvik.vm.otapreopt-max-jobs of them run, which is 1 by default, as long as the dex2oat
+// threads of all of them fit in the CPUs and their dex2oat heaps fit in the memory budget.
+static size_t GetOtapreoptJobCount() {
+    size_t max_jobs = 1;
+    if (!ParseUint(GetProperty("dalvik.vm.otapreopt-max-jobs", ""), &max_jobs) ||
+        max_jobs <= 1) {
+        return 1;
+    }
+
+    // Each dex2oat gets the thread count of RunDex2Oat, which is a thread per CPU by default.
+    const size_t cpus = std::max(1u, std::thread::hardware_concurrency());
+    size_t job_threads = 0;
+    if (!ParseUint(GetProperty("dalvik.vm.dex2oat-threads", ""), &job_threads) ||
+        job_threads == 0) {
+        job_threads = cpus;
+    }
+    size_t jobs = std::min(max_jobs, std::max<size_t>(1, cpus / job_threads));
+
+    // Without an -Xmx for dex2oat there is nothing to go by, so memory does not limit the jobs.
+    const uint64_t job_memory_bytes = GetByteCountProperty("dalvik.vm.dex2oat-Xmx");
+    if (job_memory_bytes != 0) {
+        uint64_t memory_budget = GetByteCountProperty("dalvik.vm.otapreopt-memory-budget");
+        if (memory_budget == 0) {
+            // The device is in use while the OTA is compiled, so leave it half of what is free.
+            memory_budget = GetAvailableMemoryBytes() / 2;
+        }
+        jobs = std::min<size_t>(jobs, std::max<uint64_t>(1, memory_budget / job_memory_bytes));
+    }
+
+    LOG(INFO) << "Running " << jobs << " otapreopt jobs with " << job_threads
+              << " dex2oat threads each";
+    return jobs;
+}
+
 // Entry for otapreopt_chroot. Expected parameters are:
 //
 //   [cmd] [status-fd] [target-slot-suffix]
@@ -143,8 +211,9 @@ static void TryExtraMount(const char* name, const char* slot, const char* target
 //
 //   "dexopt" [dexopt-params]
 //
-// are then read from stdin until EOF and passed on to /system/bin/otapreopt one
-// by one. After each call a line with the current command count is written to
+// are then read from stdin until EOF and passed on to /system/bin/otapreopt,
+// running as many of them at the same time as GetOtapreoptJobCount() allows.
+// After each call a line with the count of finished commands is written to
 // stdout and flushed.
 static int otapreopt_chroot(const int argc, char **arg) {
     // Validate arguments
@@ -350,34 +419,59 @@ static int otapreopt_chroot(const int argc, char **arg) {
         exit(218);
     }
 
-    // Now go on and read dexopt lines from stdin and pass them on to otapreopt.
+    // Now go on and read dexopt lines from stdin and pass them on to otapreopt. Every job takes
+    // the next line when it is done with its previous one, so that the packages are spread over
+    // the jobs as they come.
+    std::mutex lock;
+    int count = 0;
+    int finished = 0;
+    auto run_commands = [&]() {
+        for (std::array<char, 10000> linebuf;;) {
+            std::vector<std::string> cmd{"/system/bin/otapreopt", slot_suffix};
+            {
+                std::lock_guard<std::mutex> guard(lock);
+                std::cin.clear();
+                if (!std::cin.getline(&linebuf[0], linebuf.size())) {
+                    return;
+                }
+                ++count;
+                // Subtract one from gcount() since getline() counts the newline.
+                std::string line(&linebuf[0], std::cin.gcount() - 1);
+
+                if (std::cin.fail()) {
+                    LOG(ERROR) << "Command exceeds max length " << linebuf.size()
+                               << " - skipped: " << line;
+                    std::cout << ++finished << std::endl;
+                    continue;
+                }
 
-    int count = 1;
-    for (std::array<char, 10000> linebuf;
-         std::cin.clear(), std::cin.getline(&linebuf[0], linebuf.size()); ++count) {
-        // Subtract one from gcount() since getline() counts the newline.
-        std::string line(&linebuf[0], std::cin.gcount() - 1);
+                std::vector<std::string> tokenized_line = android::base::Tokenize(line, " ");
+                std::move(tokenized_line.begin(), tokenized_line.end(), std::back_inserter(cmd));
 
-        if (std::cin.fail()) {
-            LOG(ERROR) << "Command exceeds max length " << linebuf.size() << " - skipped: " << line;
-            continue;
-        }
-
-        std::vector<std::string> tokenized_line = android::base::Tokenize(line, " ");
-        std::vector<std::string> cmd{"/system/bin/otapreopt", slot_suffix};
-        std::move(tokenized_line.begin(), tokenized_line.end(), std::back_inserter(cmd));
+                LOG(INFO) << "Command " << count << ": " << android::base::Join(cmd, " ");
+            }
 
-        LOG(INFO) << "Command " << count << ": " << android::base::Join(cmd, " ");
+            // Fork and execute otapreopt in its own process.
+            std::string error_msg;
+            bool exec_result = Exec(cmd, &error_msg);
+            if (!exec_result) {
+                LOG(ERROR) << "Running otapreopt failed: " << error_msg;
+            }
 
-        // Fork and execute otapreopt in its own process.
-        std::string error_msg;
-        bool exec_result = Exec(cmd, &error_msg);
-        if (!exec_result) {
-            LOG(ERROR) << "Running otapreopt failed: " << error_msg;
+            // Print the count to stdout and flush to indicate progress.
+            std::lock_guard<std::mutex> guard(lock);
+            std::cout << ++finished << std::endl;
         }
+    };
 
-        // Print the count to stdout and flush to indicate progress.
-        std::cout << count << std::endl;
+    const size_t job_count = GetOtapreoptJobCount();
+    std::vector<std::thread> jobs;
+    for (size_t i = 1; i < job_count; ++i) {
+        jobs.emplace_back(run_commands);
+    }
+    run_commands();
+    for (std::thread& job : jobs) {
+        job.join();
     }
 
     LOG(INFO) << "No more dexopt commands";
@@ -86,6 +86,11 @@ static void touch(const char* path, int len, int time) {
     ::utime(fullPath.c_str(), &times);
 }
 
+static void chown(const char* path, uid_t uid) {
+    const std::string fullPath = StringPrintf("/data/local/tmp/user/0/%s", path);
+    ::chown(fullPath.c_str(), uid, uid);
+}
+
 static int exists(const char* path) {
     const std::string fullPath = StringPrintf("/data/local/tmp/user/0/%s", path);
     return ::access(fullPath.c_str(), F_OK);
@@ -159,6 +164,37 @@ TEST_F(CacheTest, FreeCache_All) {
     EXPECT_EQ(-1, exists("com.example/cache/foo/two"));
 }
 
+TEST_F(CacheTest, FreeCache_MultipleApps) {
+    LOG(INFO) << "FreeCache_MultipleApps";
+
+    // Give each app its own UID, so that their caches are purged in parallel
+    mkdir("com.example");
+    chown("com.example", 10001);
+    touch("com.example/normal", 1 * kMbInBytes, 60);
+    mkdir("com.example/cache");
+    mkdir("com.example/cache/foo");
+    touch("com.example/cache/foo/one", 1 * kMbInBytes, 60);
+    touch("com.example/cache/foo/two", 2 * kMbInBytes, 120);
+
+    mkdir("com.example2");
+    chown("com.example2", 10002);
+    touch("com.example2/normal", 1 * kMbInBytes, 60);
+    mkdir("com.example2/cache");
+    mkdir("com.example2/cache/bar");
+    touch("com.example2/cache/bar/one", 1 * kMbInBytes, 90);
+    touch("com.example2/cache/bar/two", 2 * kMbInBytes, 150);
+
+    service->freeCache(testUuid, kTbInBytes,
+            FLAG_FREE_CACHE_V2 | FLAG_FREE_CACHE_V2_DEFY_QUOTA);
+
+    EXPECT_EQ(0, exists("com.example/normal"));
+    EXPECT_EQ(-1, exists("com.example/cache/foo/one"));
+    EXPECT_EQ(-1, exists("com.example/cache/foo/two"));
+    EXPECT_EQ(0, exists("com.example2/normal"));
+    EXPECT_EQ(-1, exists("com.example2/cache/bar/one"));
+    EXPECT_EQ(-1, exists("com.example2/cache/bar/two"));
+}
+
 TEST_F(CacheTest, FreeCache_NonAggressive) {
     LOG(INFO) << "FreeCache_NonAggressive";
 
@@ -237,6 +273,32 @@ TEST_F(CacheTest, FreeCache_Age) {
     EXPECT_EQ(-1, exists("com.example/cache/foo/two"));
 }
 
+TEST_F(CacheTest, FreeCache_NewItemsAfterFree) {
+    LOG(INFO) << "FreeCache_NewItemsAfterFree";
+
+    mkdir("com.example");
+    mkdir("com.example/cache");
+    mkdir("com.example/cache/foo");
+    touch("com.example/cache/foo/one", kMbInBytes, 60);
+    touch("com.example/cache/foo/two", kMbInBytes, 120);
+
+    service->freeCache(testUuid, free() + kKbInBytes,
+            FLAG_FREE_CACHE_V2 | FLAG_FREE_CACHE_V2_DEFY_QUOTA);
+
+    EXPECT_EQ(-1, exists("com.example/cache/foo/one"));
+    EXPECT_EQ(0, exists("com.example/cache/foo/two"));
+
+    // The items found by the previous call must not hide the ones created since
+    mkdir("com.example/cache/bar");
+    touch("com.example/cache/bar/three", kMbInBytes, 30);
+
+    service->freeCache(testUuid, free() + kKbInBytes,
+            FLAG_FREE_CACHE_V2 | FLAG_FREE_CACHE_V2_DEFY_QUOTA);
+
+    EXPECT_EQ(0, exists("com.example/cache/foo/two"));
+    EXPECT_EQ(-1, exists("com.example/cache/bar/three"));
+}
+
 TEST_F(CacheTest, FreeCache_Tombstone) {
     LOG(INFO) << "FreeCache_Tombstone";
 
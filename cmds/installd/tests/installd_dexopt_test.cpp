@@ -1316,6 +1316,24 @@ TEST_F(ProfileTest, ProfileMergeFailWrongPackage) {
             PROFILES_ANALYSIS_DONT_OPTIMIZE_EMPTY_PROFILES);
 }
 
+TEST_F(ProfileTest, ProfileMergeBatchedOk) {
+    LOG(INFO) << "ProfileMergeBatchedOk";
+
+    SetupProfiles(/*setup_ref*/ true);
+    std::vector<android::os::MergeProfilesArgs> args(2);
+    args[0].uid = kTestAppUid;
+    args[0].packageName = package_name_;
+    args[0].profileName = "primary.prof";
+    args[1].uid = kTestAppUid;
+    args[1].packageName = "not.there";
+    args[1].profileName = "primary.prof";
+    std::vector<int32_t> results;
+    ASSERT_BINDER_SUCCESS(service_->mergeProfilesBatched(args, &results));
+    EXPECT_EQ((std::vector<int32_t>{PROFILES_ANALYSIS_OPTIMIZE,
+                                    PROFILES_ANALYSIS_DONT_OPTIMIZE_EMPTY_PROFILES}),
+              results);
+}
+
 TEST_F(ProfileTest, ProfileDirOk) {
     LOG(INFO) << "ProfileDirOk";
 
@@ -1184,6 +1184,29 @@ TEST_F(SdkSandboxDataTest, CreateAppData_CreatesSdkPackageData) {
     CheckFileAccess(fooDePath, kSystemUid, kSystemUid, S_IFDIR | 0751);
 }
 
+TEST_F(SdkSandboxDataTest, CreateAppDataBatched_CreatesDataOfEachPackage) {
+    std::vector<android::os::CreateAppDataArgs> args;
+    for (int i = 0; i < 10; i++) {
+        args.push_back(createAppDataArgs("com.foo" + std::to_string(i)));
+    }
+    // An invalid package name only fails its own result.
+    args.push_back(createAppDataArgs("../com.foo"));
+
+    std::vector<android::os::CreateAppDataResult> results;
+    ASSERT_BINDER_SUCCESS(service->createAppDataBatched(args, &results));
+    ASSERT_EQ(args.size(), results.size());
+
+    for (int i = 0; i < 10; i++) {
+        EXPECT_EQ(binder::Status::EX_NONE, results[i].exceptionCode) << "For package: " << i;
+        const std::string packageName = "com.foo" + std::to_string(i);
+        CheckFileAccess("misc_ce/0/sdksandbox/" + packageName, kSystemUid, kSystemUid,
+                        S_IFDIR | 0751);
+        CheckFileAccess("misc_de/0/sdksandbox/" + packageName, kSystemUid, kSystemUid,
+                        S_IFDIR | 0751);
+    }
+    EXPECT_NE(binder::Status::EX_NONE, results.back().exceptionCode);
+}
+
 TEST_F(SdkSandboxDataTest, CreateAppData_CreatesSdkPackageData_WithoutSdkFlag) {
     android::os::CreateAppDataResult result;
     android::os::CreateAppDataArgs args = createAppDataArgs("com.foo");
@@ -19,6 +19,7 @@
 #include <getopt.h>
 
 #include <algorithm>
+#include <atomic>
 #include <fstream>
 #include <functional>
 #include <iomanip>
@@ -26,6 +27,7 @@
 #include <map>
 #include <regex>
 #include <sstream>
+#include <thread>
 
 #include <android-base/file.h>
 #include <android-base/hex.h>
@@ -211,6 +213,7 @@ bool ListCommand::getPidInfo(
 }
 
 const BinderPidInfo* ListCommand::getPidInfoCached(pid_t serverPid) {
+    std::lock_guard<std::mutex> lock(mCachedPidInfosMutex);
     auto pair = mCachedPidInfos.insert({serverPid, BinderPidInfo{}});
     if (pair.second /* did insertion take place? */) {
         if (!getPidInfo(serverPid, &pair.first->second)) {
@@ -619,16 +622,45 @@ Status ListCommand::fetchBinderized(const sp<IServiceManager> &manager) {
         return DUMP_BINDERIZED_ERROR;
     }
 
-    Status status = OK;
     std::map<std::string, TableEntry> allTableEntries;
+    std::vector<TableEntry*> entries;
     for (const auto& fqInstanceName : *fqInstanceNames) {
+        auto [it, inserted] = allTableEntries.try_emplace(fqInstanceName);
+        if (!inserted) continue;
         // create entry and default assign all fields.
-        TableEntry& entry = allTableEntries[fqInstanceName];
+        TableEntry& entry = it->second;
         entry.interfaceName = fqInstanceName;
         entry.transport = mode;
         entry.serviceStatus = ServiceStatus::NON_RESPONSIVE;
+        entries.push_back(&entry);
+    }
+
+    // Each IPC in fetchBinderizedEntry has its own timeout, so fetch entries concurrently for a
+    // non-responsive HAL to only delay its own entry.
+    std::vector<std::stringstream> warnings(entries.size());
+    std::vector<Status> statuses(entries.size(), OK);
+    std::atomic<size_t> nextEntry = 0;
+    const auto fetchEntries = [&] {
+        for (size_t i = nextEntry++; i < entries.size(); i = nextEntry++) {
+            statuses[i] = fetchBinderizedEntry(manager, entries[i], warnings[i]);
+        }
+    };
+    const size_t threadCount =
+            std::min(entries.size(),
+                     static_cast<size_t>(std::max(std::thread::hardware_concurrency(), 1u)) * 2);
+    std::vector<std::thread> threads;
+    for (size_t i = 1; i < threadCount; ++i) {
+        threads.emplace_back(fetchEntries);
+    }
+    fetchEntries();
+    for (auto& thread : threads) {
+        thread.join();
+    }
 
-        status |= fetchBinderizedEntry(manager, &entry);
+    Status status = OK;
+    for (size_t i = 0; i < entries.size(); ++i) {
+        err() << warnings[i].str();
+        status |= statuses[i];
     }
 
     for (auto& pair : allTableEntries) {
@@ -638,10 +670,10 @@ Status ListCommand::fetchBinderized(const sp<IServiceManager> &manager) {
 }
 
 Status ListCommand::fetchBinderizedEntry(const sp<IServiceManager> &manager,
-                                         TableEntry *entry) {
+                                         TableEntry *entry, std::ostream &warnings) {
     Status status = OK;
     const auto handleError = [&](Status additionalError, const std::string& msg) {
-        err() << "Warning: Skipping \"" << entry->interfaceName << "\": " << msg << std::endl;
+        warnings << "Warning: Skipping \"" << entry->interfaceName << "\": " << msg << std::endl;
         status |= DUMP_BINDERIZED_ERROR | additionalError;
     };
 
@@ -20,6 +20,7 @@
 #include <stdint.h>
 
 #include <fstream>
+#include <mutex>
 #include <string>
 #include <vector>
 
@@ -99,14 +100,16 @@ protected:
     Status fetchManifestHals();
     Status fetchLazyHals();
 
+    // Entries are fetched concurrently, so warnings are written to the given stream rather than
+    // err(), to be printed in order once all entries are fetched.
     Status fetchBinderizedEntry(const sp<::android::hidl::manager::V1_0::IServiceManager> &manager,
-                                TableEntry *entry);
+                                TableEntry *entry, std::ostream &warnings);
 
     // Get relevant information for a PID by parsing files under
     // /dev/binderfs/binder_logs or /d/binder.
     // It is a virtual member function so that it can be mocked.
     virtual bool getPidInfo(pid_t serverPid, BinderPidInfo *info) const;
-    // Retrieve from mCachedPidInfos and call getPidInfo if necessary.
+    // Retrieve from mCachedPidInfos and call getPidInfo if necessary. Thread-safe.
     const BinderPidInfo* getPidInfoCached(pid_t serverPid);
 
     void dumpTable(const NullableOStream<std::ostream>& out) const;
@@ -185,7 +188,9 @@ protected:
     // If an entry exist and not empty, it contains the cached content of /proc/{pid}/cmdline.
     std::map<pid_t, std::string> mCmdlines;
 
-    // Cache for getPidInfo.
+    // Cache for getPidInfo, shared by the threads fetching binderized entries so that the
+    // binder state of each PID is parsed once.
+    std::mutex mCachedPidInfosMutex;
     std::map<pid_t, BinderPidInfo> mCachedPidInfos;
 
     // Cache for getPartition.
@@ -46,8 +46,10 @@ static std::string getPidcon(pid_t pid) {
     return result;
 }
 
-static struct selabel_handle* getSehandle() {
+// Sets reloaded if service_contexts was (re)loaded, which invalidates previous lookups.
+static struct selabel_handle* getSehandle(bool* reloaded) {
     static struct selabel_handle* gSehandle = nullptr;
+    *reloaded = false;
     if (gSehandle != nullptr && selinux_status_updated()) {
         selabel_close(gSehandle);
         gSehandle = nullptr;
@@ -57,6 +59,7 @@ static struct selabel_handle* getSehandle() {
         gSehandle = kIsVendor
             ? selinux_android_vendor_service_context_handle()
             : selinux_android_service_context_handle();
+        *reloaded = true;
     }
 
     CHECK(gSehandle != nullptr);
@@ -161,15 +164,25 @@ bool Access::actionAllowed(const CallingContext& sctx, const char* tctx, const c
 
 bool Access::actionAllowedFromLookup(const CallingContext& sctx, const std::string& name, const char *perm) {
 #ifdef __ANDROID__
-    char *tctx = nullptr;
-    if (selabel_lookup(getSehandle(), &tctx, name.c_str(), SELABEL_CTX_ANDROID_SERVICE) != 0) {
-        LOG(ERROR) << "SELinux: No match for " << name << " in service_contexts.\n";
-        return false;
+    bool reloaded;
+    struct selabel_handle* sehandle = getSehandle(&reloaded);
+    // Callers control the names, so bound the cache rather than letting it grow without limit.
+    if (reloaded || mServiceContexts.size() >= kMaxCachedServiceContexts) {
+        mServiceContexts.clear();
     }
 
-    bool allowed = actionAllowed(sctx, tctx, perm, name);
-    freecon(tctx);
-    return allowed;
+    auto it = mServiceContexts.find(name);
+    if (it == mServiceContexts.end()) {
+        char *tctx = nullptr;
+        if (selabel_lookup(sehandle, &tctx, name.c_str(), SELABEL_CTX_ANDROID_SERVICE) != 0) {
+            LOG(ERROR) << "SELinux: No match for " << name << " in service_contexts.\n";
+            return false;
+        }
+        it = mServiceContexts.emplace(name, tctx).first;
+        freecon(tctx);
+    }
+
+    return actionAllowed(sctx, it->second.c_str(), perm, name);
 #else
     (void)sctx;
     (void)name;
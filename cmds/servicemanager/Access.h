@@ -16,6 +16,7 @@
 
 #pragma once
 
+#include <map>
 #include <string>
 #include <sys/types.h>
 
@@ -53,6 +54,11 @@ private:
             const char *perm);
 
     char* mThisProcessContext = nullptr;
+
+    // Every lookup is checked against service_contexts, so remember the target context of
+    // recently used names until the policy is reloaded.
+    static constexpr size_t kMaxCachedServiceContexts = 1024;
+    std::map<std::string, std::string> mServiceContexts;
 };
 
 };
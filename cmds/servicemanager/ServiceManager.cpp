@@ -16,6 +16,7 @@
 
 #include "ServiceManager.h"
 
+#include <android-base/file.h>
 #include <android-base/logging.h>
 #include <android-base/properties.h>
 #include <android-base/scopeguard.h>
@@ -26,6 +27,7 @@
 #include <binder/Stability.h>
 #include <cutils/android_filesystem_config.h>
 #include <cutils/multiuser.h>
+#include <inttypes.h>
 #include <thread>
 
 #if !defined(VENDORSERVICEMANAGER) && !defined(__ANDROID_RECOVERY__)
@@ -49,6 +51,16 @@ using ::android::internal::Stability;
 
 namespace android {
 
+// A lazy service that is asked for again within this time of exiting is likely to be used
+// regularly, so it is then kept running for kLazyServiceKeepRunningTime after it starts, saving
+// its clients from waiting for it to restart each time.
+constexpr std::chrono::seconds kLazyServiceRestartWindow = std::chrono::seconds(60);
+constexpr std::chrono::seconds kLazyServiceKeepRunningTime = std::chrono::seconds(120);
+
+static int64_t toMs(std::chrono::nanoseconds duration) {
+    return std::chrono::duration_cast<std::chrono::milliseconds>(duration).count();
+}
+
 #if defined(VENDORSERVICEMANAGER) || defined(__ANDROID_RECOVERY__)
 #define SM_PERFETTO_TRACE_FUNC(...)
 #else
@@ -419,6 +431,18 @@ Status ServiceManager::checkService(const std::string& name, os::Service* outSer
     return Status::ok();
 }
 
+Status ServiceManager::checkServices(const std::vector<std::string>& names,
+                                     std::vector<os::Service>* outServices) {
+    SM_PERFETTO_TRACE_FUNC();
+
+    outServices->clear();
+    outServices->reserve(names.size());
+    for (const auto& name : names) {
+        outServices->push_back(tryGetService(name, false));
+    }
+    return Status::ok();
+}
+
 os::Service ServiceManager::tryGetService(const std::string& name, bool startIfNotFound) {
     std::optional<std::string> accessorName;
 #ifndef VENDORSERVICEMANAGER
@@ -460,6 +484,10 @@ sp<IBinder> ServiceManager::tryGetBinder(const std::string& name, bool startIfNo
     }
 
     if (!out && startIfNotFound) {
+        LazyServiceHistory& history = mNameToLazyServiceHistory[name];
+        if (!history.startRequested) {
+            history.startRequested = std::chrono::steady_clock::now();
+        }
         tryStartService(ctx, name);
     }
 
@@ -575,6 +603,27 @@ Status ServiceManager::addService(const std::string& name, const sp<IBinder>& bi
             .ctx = ctx,
     };
 
+    if (auto it = mNameToLazyServiceHistory.find(name);
+        it != mNameToLazyServiceHistory.end() && it->second.startRequested) {
+        LazyServiceHistory& history = it->second;
+        const auto now = std::chrono::steady_clock::now();
+        const std::chrono::nanoseconds latency = now - *history.startRequested;
+        history.coldStarts++;
+        history.totalColdStartLatency += latency;
+        history.maxColdStartLatency = std::max(history.maxColdStartLatency, latency);
+        ALOGI("%s Lazy service '%s' registered %" PRId64 "ms after it was first requested",
+              ctx.toDebugString().c_str(), name.c_str(), toMs(latency));
+
+        if (history.lastShutdown &&
+            *history.startRequested - *history.lastShutdown < kLazyServiceRestartWindow) {
+            ALOGI("Keeping lazy service '%s' running, since it was needed again soon after it "
+                  "exited.",
+                  name.c_str());
+            history.keepRunningUntil = now + kLazyServiceKeepRunningTime;
+        }
+        history.startRequested.reset();
+    }
+
     if (auto it = mNameToRegistrationCallback.find(name); it != mNameToRegistrationCallback.end()) {
         // If someone is currently waiting on the service, notify the service that
         // we're waiting and flush it to the service.
@@ -1090,6 +1139,21 @@ Status ServiceManager::tryUnregisterService(const std::string& name, const sp<IB
                                          "Can't unregister, pending client.");
     }
 
+    const auto now = std::chrono::steady_clock::now();
+    auto historyIt = mNameToLazyServiceHistory.find(name);
+    if (historyIt != mNameToLazyServiceHistory.end() &&
+        now < historyIt->second.keepRunningUntil) {
+        ALOGI("%s Tried to unregister %s, but it is likely to be needed again soon.",
+              ctx.toDebugString().c_str(), name.c_str());
+
+        // As for services with clients, this makes the next periodic client check tell the
+        // service that it has none again, so that it tries to unregister later.
+        serviceIt->second.guaranteeClient = true;
+
+        return Status::fromExceptionCode(Status::EX_ILLEGAL_STATE,
+                                         "Can't unregister, likely to be used soon.");
+    }
+
     // - kernel driver will hold onto one refcount (during this transaction)
     // - servicemanager has a refcount (guaranteed by this transaction)
     constexpr size_t kKnownClients = 2;
@@ -1109,6 +1173,7 @@ Status ServiceManager::tryUnregisterService(const std::string& name, const sp<IB
 
     ALOGI("%s Unregistering %s", ctx.toDebugString().c_str(), name.c_str());
     mNameToService.erase(name);
+    mNameToLazyServiceHistory[name].lastShutdown = now;
 
     return Status::ok();
 }
@@ -1165,10 +1230,34 @@ Status ServiceManager::getServiceDebugInfo(std::vector<ServiceDebugInfo>* outRet
     return Status::ok();
 }
 
+status_t ServiceManager::dump(int fd, const Vector<String16>& /*args*/) {
+    if (!mAccess->canList(mAccess->getCallingContext())) {
+        return PERMISSION_DENIED;
+    }
+
+    std::string out = "Lazy services:\n";
+    const auto now = std::chrono::steady_clock::now();
+    for (const auto& [name, history] : mNameToLazyServiceHistory) {
+        out += "  " + name + ": " + std::to_string(history.coldStarts) + " cold starts";
+        if (history.coldStarts > 0) {
+            const auto averageLatency = history.totalColdStartLatency / history.coldStarts;
+            out += ", " + std::to_string(toMs(averageLatency)) + "ms on average, " +
+                    std::to_string(toMs(history.maxColdStartLatency)) + "ms at most";
+        }
+        if (now < history.keepRunningUntil) {
+            out += ", kept running for " + std::to_string(toMs(history.keepRunningUntil - now)) +
+                    "ms";
+        }
+        out += "\n";
+    }
+    return base::WriteStringToFd(out, fd) ? OK : UNKNOWN_ERROR;
+}
+
 void ServiceManager::clear() {
     mNameToService.clear();
     mNameToRegistrationCallback.clear();
     mNameToClientCallback.clear();
+    mNameToLazyServiceHistory.clear();
 }
 
 }  // namespace android
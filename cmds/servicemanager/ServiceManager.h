@@ -24,6 +24,10 @@
 #include "perfetto/public/te_category_macros.h"
 #endif // !defined(VENDORSERVICEMANAGER) && !defined(__ANDROID_RECOVERY__)
 
+#include <chrono>
+#include <map>
+#include <optional>
+
 #include "Access.h"
 
 namespace android {
@@ -67,9 +71,14 @@ public:
                                           const sp<IClientCallback>& cb) override;
     binder::Status tryUnregisterService(const std::string& name, const sp<IBinder>& binder) override;
     binder::Status getServiceDebugInfo(std::vector<ServiceDebugInfo>* outReturn) override;
+    binder::Status checkServices(const std::vector<std::string>& names,
+                                 std::vector<os::Service>* outServices) override;
     void binderDied(const wp<IBinder>& who) override;
     void handleClientCallbacks();
 
+    // Prints how long lazy services took to start.
+    status_t dump(int fd, const Vector<String16>& args) override;
+
     /**
      *  This API is added for debug purposes. It clears members which hold service and callback
      * information.
@@ -94,6 +103,21 @@ private:
         ~Service();
     };
 
+    // Kept for lazy services even while they aren't running, to measure how long they take to
+    // start, and to keep those that are restarted soon after exiting running for a while.
+    struct LazyServiceHistory {
+        // when a client first asked for the service, if it hasn't been registered since
+        std::optional<std::chrono::steady_clock::time_point> startRequested;
+        // when the service last unregistered itself
+        std::optional<std::chrono::steady_clock::time_point> lastShutdown;
+        // tryUnregisterService refuses to let the service exit until then
+        std::chrono::steady_clock::time_point keepRunningUntil;
+
+        size_t coldStarts = 0;
+        std::chrono::nanoseconds totalColdStartLatency{0};
+        std::chrono::nanoseconds maxColdStartLatency{0};
+    };
+
     using ServiceCallbackMap = std::map<std::string, std::vector<sp<IServiceCallback>>>;
     using ClientCallbackMap = std::map<std::string, std::vector<sp<IClientCallback>>>;
     using ServiceMap = std::map<std::string, Service>;
@@ -123,6 +147,7 @@ private:
     ServiceMap mNameToService;
     ServiceCallbackMap mNameToRegistrationCallback;
     ClientCallbackMap mNameToClientCallback;
+    std::map<std::string, LazyServiceHistory> mNameToLazyServiceHistory;
 
     std::unique_ptr<Access> mAccess;
 };
@@ -0,0 +1,63 @@
+/*
+ * Copyright (C) 2024 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <android/os/IServiceManager.h>
+#include <benchmark/benchmark.h>
+#include <binder/IServiceManager.h>
+#include <binder/ProcessState.h>
+
+#include <string>
+
+using android::defaultServiceManager;
+using android::interface_cast;
+using android::ProcessState;
+using android::sp;
+using android::os::IServiceManager;
+using android::os::Service;
+
+// Talks to servicemanager directly, so that lookups aren't served by the libbinder client cache.
+static sp<IServiceManager> getAidlServiceManager() {
+    return interface_cast<IServiceManager>(ProcessState::self()->getContextObject(nullptr));
+}
+
+// Each call is one lookup in the servicemanager running on the device. Run with several threads
+// to see how lookup latency grows when many processes query it at once, like during boot.
+static void BM_checkService(benchmark::State& state, const std::string& name) {
+    sp<IServiceManager> sm = getAidlServiceManager();
+    Service service;
+    for (auto _ : state) {
+        if (!sm->checkService(name, &service).isOk()) {
+            state.SkipWithError("checkService failed");
+            return;
+        }
+    }
+    state.SetItemsProcessed(state.iterations());
+}
+BENCHMARK_CAPTURE(BM_checkService, found, std::string("manager"))
+        ->ThreadRange(1, 16)
+        ->UseRealTime();
+BENCHMARK_CAPTURE(BM_checkService, missing, std::string("servicemanager_benchmark.missing"))
+        ->ThreadRange(1, 16)
+        ->UseRealTime();
+
+int main(int argc, char** argv) {
+    ::benchmark::Initialize(&argc, argv);
+    if (::benchmark::ReportUnrecognizedArguments(argc, argv)) return 1;
+    // Make sure servicemanager is up before measuring anything.
+    (void)defaultServiceManager();
+    ::benchmark::RunSpecifiedBenchmarks();
+    return 0;
+}
@@ -212,6 +212,24 @@ TEST(GetService, NonExistant) {
     EXPECT_EQ(nullptr, outBinder);
 }
 
+TEST(GetService, CheckServicesInOrder) {
+    auto sm = getPermissiveServiceManager();
+    sp<IBinder> foo = getBinder();
+    sp<IBinder> bar = getBinder();
+
+    EXPECT_TRUE(sm->addService("foo", foo, false /*allowIsolated*/,
+        IServiceManager::DUMP_FLAG_PRIORITY_DEFAULT).isOk());
+    EXPECT_TRUE(sm->addService("bar", bar, false /*allowIsolated*/,
+        IServiceManager::DUMP_FLAG_PRIORITY_DEFAULT).isOk());
+
+    std::vector<Service> out;
+    EXPECT_TRUE(sm->checkServices({"bar", "baz", "foo"}, &out).isOk());
+    ASSERT_EQ(3u, out.size());
+    EXPECT_EQ(bar, out[0].get<Service::Tag::binder>());
+    EXPECT_EQ(nullptr, out[1].get<Service::Tag::binder>());
+    EXPECT_EQ(foo, out[2].get<Service::Tag::binder>());
+}
+
 TEST(GetService, NoPermissionsForGettingService) {
     std::unique_ptr<MockAccess> access = std::make_unique<NiceMock<MockAccess>>();
 
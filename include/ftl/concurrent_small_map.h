@@ -0,0 +1,194 @@
+/*
+ * Copyright 2024 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include <ftl/optional.h>
+#include <ftl/small_map.h>
+
+#include <atomic>
+#include <cstddef>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <utility>
+
+namespace android::ftl {
+
+// SmallMap that any number of threads may read concurrently with a writer. Reads are wait-free:
+// they never take a lock, never retry, and never wait for a writer. Writers are serialized with
+// each other.
+//
+// The map is kept in two instances, following the Left-Right technique. Readers look up the
+// instance that was last published, and count themselves against the current version while doing
+// so. A writer updates the other instance, publishes it, waits for the readers of the previous
+// version to leave, and then applies the same update to the instance they were reading. Hence the
+// mapped values are stored twice, and a write costs about twice as much as on a SmallMap, plus the
+// wait for in-flight readers.
+//
+// Reads see the map either before or after a given write, never in between, but consecutive reads
+// may see different versions. Values are returned by copy, or visited under a read via `read`.
+//
+// Example usage:
+//
+//   ftl::ConcurrentSmallMap<int, std::string, 3> map;
+//   assert(map.empty());
+//
+//   assert(map.try_emplace(123, "abc"));
+//   assert(!map.try_emplace(123, "def"));
+//   assert(map.get(123) == "abc");
+//
+//   assert(!map.emplace_or_replace(123, "xyz"));
+//   const auto size = [](const std::string& s) { return s.size(); };
+//   assert(map.read([&](const auto& map) { return map.get(123).transform(size); }) == 3u);
+//
+//   map.write([](auto& map) { map.try_emplace(-1, 3u, '?'); });
+//   assert(map.get(-1) == "???");
+//
+//   assert(map.erase(123));
+//   assert(!map.contains(123));
+//
+template <typename K, typename V, std::size_t N, typename KeyEqual = std::equal_to<K>>
+class ConcurrentSmallMap final {
+ public:
+  using Map = SmallMap<K, V, N, KeyEqual>;
+
+  using key_type = typename Map::key_type;
+  using mapped_type = typename Map::mapped_type;
+  using size_type = typename Map::size_type;
+
+  ConcurrentSmallMap() = default;
+  explicit ConcurrentSmallMap(const Map& map) : maps_{map, map} {}
+
+  ConcurrentSmallMap(const ConcurrentSmallMap&) = delete;
+  ConcurrentSmallMap& operator=(const ConcurrentSmallMap&) = delete;
+
+  // Calls the function with a const reference to the latest published map, and returns its result.
+  //
+  // The function must not write to this map, since the write would wait for the read to finish.
+  // References into the map must not outlive the call.
+  //
+  template <typename F>
+  decltype(auto) read(F f) const {
+    const std::size_t version = version_.load();
+    readers_[version].count.fetch_add(1);
+
+    struct Leave {
+      ~Leave() { count.fetch_sub(1); }
+      std::atomic<std::size_t>& count;
+    } leave{readers_[version].count};
+
+    return f(std::as_const(maps_[published_.load()]));
+  }
+
+  // Returns a copy of the value for the given key, or std::nullopt if the key was not found.
+  Optional<mapped_type> get(const key_type& key) const {
+    return read([&key](const Map& map) -> Optional<mapped_type> {
+      return map.get(key).transform([](const mapped_type& v) { return v; });
+    });
+  }
+
+  bool contains(const key_type& key) const {
+    return read([&key](const Map& map) { return map.contains(key); });
+  }
+
+  size_type size() const {
+    return read([](const Map& map) { return map.size(); });
+  }
+
+  bool empty() const {
+    return read([](const Map& map) { return map.empty(); });
+  }
+
+  // Calls the function with a mutable reference to each instance of the map in turn, and returns
+  // the result of the second call. Reads started before the first call finished see the map as it
+  // was before the write, and reads started after it see the map after the write.
+  //
+  // The function is called twice, so it must update both instances the same way: it must not move
+  // from its captures, nor depend on state that the first call changes.
+  //
+  template <typename F>
+  decltype(auto) write(F f) {
+    std::lock_guard lock(write_mutex_);
+
+    const std::size_t published = published_.load(std::memory_order_relaxed);
+    f(maps_[1 - published]);
+    published_.store(1 - published);
+
+    // New readers now read the updated instance. Wait for the ones that may still be reading the
+    // other one: first for any left on the next version by the previous write, then for those on
+    // the current version once new readers are counted against the next one.
+    const std::size_t version = version_.load(std::memory_order_relaxed);
+    wait_for_readers(1 - version);
+    version_.store(1 - version);
+    wait_for_readers(version);
+
+    return f(maps_[published]);
+  }
+
+  // Inserts a mapping unless it exists. Returns whether the mapping was inserted.
+  template <typename... Args>
+  bool try_emplace(const key_type& key, Args&&... args) {
+    return write([&](Map& map) { return map.try_emplace(key, args...).second; });
+  }
+
+  // Replaces a mapping if it exists. Returns whether the mapping was replaced.
+  template <typename... Args>
+  bool try_replace(const key_type& key, Args&&... args) {
+    return write([&](Map& map) { return map.try_replace(key, args...) != map.end(); });
+  }
+
+  // Inserts or replaces a mapping. Returns true on emplace, or false on replace.
+  template <typename... Args>
+  bool emplace_or_replace(const key_type& key, Args&&... args) {
+    return write([&](Map& map) { return map.emplace_or_replace(key, args...).second; });
+  }
+
+  // Removes a mapping if it exists, and returns whether it did.
+  bool erase(const key_type& key) {
+    return write([&key](Map& map) { return map.erase(key); });
+  }
+
+  // Removes all mappings.
+  void clear() {
+    write([](Map& map) { map.clear(); });
+  }
+
+ private:
+  // Padded to a cache line, so that readers on either version do not contend with each other.
+  struct alignas(64) Readers {
+    std::atomic<std::size_t> count = 0;
+  };
+
+  void wait_for_readers(std::size_t version) const {
+    while (readers_[version].count.load() != 0) {
+      std::this_thread::yield();
+    }
+  }
+
+  Map maps_[2];
+
+  // Index of the instance that readers read.
+  std::atomic<std::size_t> published_ = 0;
+
+  // Index of the reader count that readers count themselves against.
+  std::atomic<std::size_t> version_ = 0;
+  mutable Readers readers_[2];
+
+  std::mutex write_mutex_;
+};
+
+}  // namespace android::ftl
@@ -0,0 +1,576 @@
+/*
+ * Copyright 2024 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <iterator>
+#include <memory>
+#include <new>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#elif defined(__ARM_NEON) && defined(__aarch64__)
+#include <arm_neon.h>
+#endif
+
+#include <ftl/details/hash.h>
+
+namespace android::ftl::details {
+
+// Open addressing hash table shared by FlatHashMap and FlatHashSet, based on the SwissTable design.
+//
+// Each slot has a control byte, which is either empty, deleted, or holds the 7 low bits of the hash
+// of its key (H2). The control bytes are probed a group at a time, comparing all the bytes of the
+// group against H2 at once, so that keys are only compared for the few slots likely to match. The
+// remaining bits of the hash (H1) pick the group where probing starts.
+//
+// The capacity is 0 or a power of two minus one, and at least a group minus one. The control bytes
+// are followed by a sentinel for iteration, and a copy of the first group minus one bytes, so that
+// a group can be loaded at any position without wrapping around.
+
+using ctrl_t = std::int8_t;
+
+inline constexpr ctrl_t kCtrlEmpty = -128;
+inline constexpr ctrl_t kCtrlDeleted = -2;
+inline constexpr ctrl_t kCtrlSentinel = -1;
+
+constexpr bool is_full(ctrl_t ctrl) {
+  return ctrl >= 0;
+}
+
+// Positions within a group, iterated from the lowest. Lanes are (1 << Shift) bits wide, of which
+// only one is set for a position in the set.
+template <typename T, int Shift, std::size_t Width>
+class GroupMask {
+ public:
+  explicit constexpr GroupMask(T mask) : mask_(mask) {}
+
+  explicit operator bool() const { return mask_ != 0; }
+
+  // Number of positions below the lowest one, which must exist.
+  std::size_t trailing_zeros() const {
+    return static_cast<std::size_t>(__builtin_ctzll(mask_)) >> Shift;
+  }
+
+  // Number of positions above the highest one, which must exist.
+  std::size_t leading_zeros() const {
+    constexpr int kUnusedBits = 64 - static_cast<int>(Width << Shift);
+    return static_cast<std::size_t>(__builtin_clzll(mask_) - kUnusedBits) >> Shift;
+  }
+
+  std::size_t operator*() const { return trailing_zeros(); }
+  GroupMask& operator++() {
+    mask_ &= mask_ - 1;
+    return *this;
+  }
+
+  GroupMask begin() const { return *this; }
+  GroupMask end() const { return GroupMask(0); }
+  bool operator!=(const GroupMask& other) const { return mask_ != other.mask_; }
+
+ private:
+  T mask_;
+};
+
+#if defined(__SSE2__)
+
+struct Group {
+  static constexpr std::size_t kWidth = 16;
+  using Mask = GroupMask<std::uint32_t, 0, kWidth>;
+
+  explicit Group(const ctrl_t* pos)
+      : ctrl_(_mm_loadu_si128(reinterpret_cast<const __m128i*>(pos))) {}
+
+  Mask match(ctrl_t h2) const { return to_mask(_mm_cmpeq_epi8(_mm_set1_epi8(h2), ctrl_)); }
+  Mask match_empty() const { return to_mask(_mm_cmpeq_epi8(_mm_set1_epi8(kCtrlEmpty), ctrl_)); }
+  Mask match_empty_or_deleted() const {
+    return to_mask(_mm_cmpgt_epi8(_mm_set1_epi8(kCtrlSentinel), ctrl_));
+  }
+
+ private:
+  static Mask to_mask(__m128i lanes) {
+    return Mask(static_cast<std::uint32_t>(_mm_movemask_epi8(lanes)));
+  }
+
+  __m128i ctrl_;
+};
+
+#elif defined(__ARM_NEON) && defined(__aarch64__)
+
+struct Group {
+  static constexpr std::size_t kWidth = 16;
+  using Mask = GroupMask<std::uint64_t, 2, kWidth>;
+
+  explicit Group(const ctrl_t* pos) : ctrl_(vld1q_s8(pos)) {}
+
+  Mask match(ctrl_t h2) const { return to_mask(vceqq_s8(ctrl_, vdupq_n_s8(h2))); }
+  Mask match_empty() const { return to_mask(vceqq_s8(ctrl_, vdupq_n_s8(kCtrlEmpty))); }
+  Mask match_empty_or_deleted() const {
+    return to_mask(vcltq_s8(ctrl_, vdupq_n_s8(kCtrlSentinel)));
+  }
+
+ private:
+  // NEON has no movemask, so narrow each byte lane to 4 bits, and keep one of them.
+  static Mask to_mask(uint8x16_t lanes) {
+    const uint8x8_t narrowed = vshrn_n_u16(vreinterpretq_u16_u8(lanes), 4);
+    return Mask(vget_lane_u64(vreinterpret_u64_u8(narrowed), 0) & 0x8888888888888888ull);
+  }
+
+  int8x16_t ctrl_;
+};
+
+#else
+
+struct Group {
+  static constexpr std::size_t kWidth = 16;
+  using Mask = GroupMask<std::uint32_t, 0, kWidth>;
+
+  explicit Group(const ctrl_t* pos) { std::memcpy(ctrl_, pos, kWidth); }
+
+  Mask match(ctrl_t h2) const {
+    return match_if([h2](ctrl_t ctrl) { return ctrl == h2; });
+  }
+  Mask match_empty() const {
+    return match_if([](ctrl_t ctrl) { return ctrl == kCtrlEmpty; });
+  }
+  Mask match_empty_or_deleted() const {
+    return match_if([](ctrl_t ctrl) { return ctrl < kCtrlSentinel; });
+  }
+
+ private:
+  template <typename F>
+  Mask match_if(F f) const {
+    std::uint32_t mask = 0;
+    for (std::size_t i = 0; i < kWidth; i++) {
+      if (f(ctrl_[i])) mask |= 1u << i;
+    }
+    return Mask(mask);
+  }
+
+  ctrl_t ctrl_[kWidth];
+};
+
+#endif
+
+// Control bytes of tables without capacity, which lookups probe without finding anything.
+alignas(16) inline constexpr ctrl_t kEmptyGroup[Group::kWidth] = {
+    kCtrlSentinel, kCtrlEmpty, kCtrlEmpty, kCtrlEmpty, kCtrlEmpty, kCtrlEmpty,
+    kCtrlEmpty,    kCtrlEmpty, kCtrlEmpty, kCtrlEmpty, kCtrlEmpty, kCtrlEmpty,
+    kCtrlEmpty,    kCtrlEmpty, kCtrlEmpty, kCtrlEmpty};
+
+// Spreads the bits of a hash that may be weak, e.g. std::hash of integers is the identity, so that
+// both H1 and H2 depend on all of them.
+__attribute__((no_sanitize("unsigned-integer-overflow")))
+constexpr std::uint64_t mix_hash(std::uint64_t hash) {
+  return shift_mix(hash * kPrime2) * kPrime2;
+}
+
+template <typename T, typename Key, typename KeyOf, std::size_t N, typename Hash, typename KeyEqual>
+class FlatHashTable {
+ public:
+  using value_type = T;
+  using size_type = std::size_t;
+
+  template <bool Const>
+  class Iterator {
+   public:
+    using iterator_category = std::forward_iterator_tag;
+    using value_type = T;
+    using difference_type = std::ptrdiff_t;
+    using pointer = std::conditional_t<Const, const T*, T*>;
+    using reference = std::conditional_t<Const, const T&, T&>;
+
+    Iterator() = default;
+
+    template <bool C = Const, typename = std::enable_if_t<C>>
+    Iterator(const Iterator<false>& other) : ctrl_(other.ctrl_), slot_(other.slot_) {}
+
+    reference operator*() const { return *std::launder(slot_); }
+    pointer operator->() const { return std::launder(slot_); }
+
+    Iterator& operator++() {
+      ++ctrl_;
+      ++slot_;
+      skip_free();
+      return *this;
+    }
+
+    Iterator operator++(int) {
+      Iterator it = *this;
+      ++*this;
+      return it;
+    }
+
+    friend bool operator==(const Iterator& lhs, const Iterator& rhs) {
+      return lhs.ctrl_ == rhs.ctrl_;
+    }
+    friend bool operator!=(const Iterator& lhs, const Iterator& rhs) { return !(lhs == rhs); }
+
+   private:
+    friend class FlatHashTable;
+    template <bool>
+    friend class Iterator;
+
+    Iterator(const ctrl_t* ctrl, pointer slot) : ctrl_(ctrl), slot_(slot) { skip_free(); }
+
+    // Stops at the next full slot, or at the sentinel.
+    void skip_free() {
+      while (*ctrl_ < kCtrlSentinel) {
+        ++ctrl_;
+        ++slot_;
+      }
+    }
+
+    const ctrl_t* ctrl_ = nullptr;
+    pointer slot_ = nullptr;
+  };
+
+  using iterator = Iterator<false>;
+  using const_iterator = Iterator<true>;
+
+  static constexpr size_type kGroupWidth = Group::kWidth;
+  static constexpr size_type kMinCapacity = kGroupWidth - 1;
+
+  // Tables are filled up to 7/8 of their capacity before growing.
+  static constexpr size_type max_load(size_type capacity) { return capacity - capacity / 8; }
+
+  static constexpr size_type capacity_for(size_type size) {
+    if (size == 0) return 0;
+    size_type capacity = kMinCapacity;
+    while (max_load(capacity) < size) capacity = capacity * 2 + 1;
+    return capacity;
+  }
+
+  static constexpr size_type kInlineCapacity = capacity_for(N);
+
+  FlatHashTable() { init(); }
+  ~FlatHashTable() { destroy(); }
+
+  FlatHashTable(const FlatHashTable& other) : FlatHashTable() { copy(other); }
+  FlatHashTable(FlatHashTable&& other) : FlatHashTable() { take(std::move(other)); }
+
+  FlatHashTable& operator=(const FlatHashTable& other) {
+    if (this != &other) {
+      clear();
+      copy(other);
+    }
+    return *this;
+  }
+
+  FlatHashTable& operator=(FlatHashTable&& other) {
+    if (this != &other) {
+      destroy();
+      init();
+      take(std::move(other));
+    }
+    return *this;
+  }
+
+  size_type size() const { return size_; }
+  size_type capacity() const { return capacity_; }
+  bool dynamic() const { return capacity_ != 0 && !is_inline(); }
+
+  iterator begin() { return iterator(ctrl_, slots_); }
+  const_iterator begin() const { return const_iterator(ctrl_, slots_); }
+  iterator end() { return iterator(ctrl_ + capacity_, slots_ + capacity_); }
+  const_iterator end() const { return const_iterator(ctrl_ + capacity_, slots_ + capacity_); }
+
+  iterator find(const Key& key) { return find(key, hash_of(key)); }
+  const_iterator find(const Key& key) const {
+    return const_cast<FlatHashTable&>(*this).find(key);
+  }
+
+  // Constructs an element from the arguments unless one exists for the key. Returns an iterator to
+  // the inserted or existing element, and whether it was inserted. The arguments must not refer to
+  // elements of the table, since inserting may move them.
+  template <typename... Args>
+  std::pair<iterator, bool> try_emplace(const Key& key, Args&&... args) {
+    const std::uint64_t hash = hash_of(key);
+    if (const auto it = find(key, hash); it != end()) {
+      return {it, false};
+    }
+
+    size_type index = find_first_non_full(hash);
+    if (growth_left_ == 0 && ctrl_[index] != kCtrlDeleted) {
+      grow();
+      index = find_first_non_full(hash);
+    }
+    if (ctrl_[index] == kCtrlEmpty) {
+      growth_left_--;
+    }
+    new (slots_ + index) T(std::forward<Args>(args)...);
+    set_ctrl(index, h2(hash));
+    size_++;
+    return {iterator_at(index), true};
+  }
+
+  // Replaces the element with one constructed from the arguments, which must have the same key.
+  // The arguments may refer to the element being replaced.
+  template <typename... Args>
+  void replace(iterator it, Args&&... args) {
+    T element(std::forward<Args>(args)...);
+    T* const slot = std::launder(it.slot_);
+    std::destroy_at(slot);
+    new (slot) T(std::move(element));
+  }
+
+  void erase(const_iterator it) {
+    const auto index = static_cast<size_type>(it.ctrl_ - ctrl_);
+    std::destroy_at(std::launder(slots_ + index));
+    size_--;
+
+    // The slot can be marked empty rather than deleted if no probe can have gone past it while
+    // full, that is if there was an empty slot in every window of a group around it.
+    const auto empty_after = Group(ctrl_ + index).match_empty();
+    const auto empty_before = Group(ctrl_ + ((index - kGroupWidth) & capacity_)).match_empty();
+    if (empty_before && empty_after &&
+        empty_after.trailing_zeros() + empty_before.leading_zeros() < kGroupWidth) {
+      set_ctrl(index, kCtrlEmpty);
+      growth_left_++;
+    } else {
+      set_ctrl(index, kCtrlDeleted);
+    }
+  }
+
+  void clear() {
+    if (capacity_ == 0) return;
+    destroy_elements();
+    reset_ctrl();
+    size_ = 0;
+    growth_left_ = max_load(capacity_);
+  }
+
+  void reserve(size_type size) {
+    if (const size_type capacity = capacity_for(size); capacity > capacity_) {
+      rehash(capacity);
+    }
+  }
+
+ private:
+  // The storage of up to kInlineCapacity slots within the table.
+  template <size_type Capacity, typename = void>
+  struct InlineStorage {
+    ctrl_t ctrl[Capacity + kGroupWidth];
+    std::aligned_storage_t<sizeof(T), alignof(T)> slots[Capacity];
+  };
+
+  template <typename Void>
+  struct InlineStorage<0, Void> {};
+
+  static constexpr ctrl_t h2(std::uint64_t hash) { return static_cast<ctrl_t>(hash & 0x7f); }
+  static constexpr size_type h1(std::uint64_t hash) { return static_cast<size_type>(hash >> 7); }
+
+  static std::uint64_t hash_of(const Key& key) {
+    return mix_hash(static_cast<std::uint64_t>(Hash{}(key)));
+  }
+
+  bool is_inline() const {
+    if constexpr (kInlineCapacity > 0) {
+      return ctrl_ == inline_.ctrl;
+    } else {
+      return false;
+    }
+  }
+
+  void init() {
+    if constexpr (kInlineCapacity > 0) {
+      ctrl_ = inline_.ctrl;
+      slots_ = reinterpret_cast<T*>(inline_.slots);
+      capacity_ = kInlineCapacity;
+      reset_ctrl();
+    } else {
+      ctrl_ = const_cast<ctrl_t*>(kEmptyGroup);
+      slots_ = nullptr;
+      capacity_ = 0;
+    }
+    size_ = 0;
+    growth_left_ = max_load(capacity_);
+  }
+
+  void destroy() {
+    destroy_elements();
+    if (dynamic()) {
+      deallocate(ctrl_, slots_, capacity_);
+    }
+  }
+
+  void destroy_elements() {
+    if constexpr (!std::is_trivially_destructible_v<T>) {
+      for (size_type i = 0; i < capacity_; i++) {
+        if (is_full(ctrl_[i])) std::destroy_at(std::launder(slots_ + i));
+      }
+    }
+  }
+
+  void copy(const FlatHashTable& other) {
+    reserve(other.size());
+    for (const T& element : other) {
+      insert_unique(element);
+    }
+  }
+
+  void take(FlatHashTable&& other) {
+    if (other.dynamic()) {
+      destroy();
+      ctrl_ = other.ctrl_;
+      slots_ = other.slots_;
+      capacity_ = other.capacity_;
+      size_ = other.size_;
+      growth_left_ = other.growth_left_;
+      other.init();
+      return;
+    }
+
+    reserve(other.size());
+    for (T& element : other) {
+      insert_unique(std::move(element));
+    }
+    other.clear();
+  }
+
+  static void allocate(size_type capacity, ctrl_t*& ctrl, T*& slots) {
+    ctrl = new ctrl_t[capacity + kGroupWidth];
+    slots = std::allocator<T>().allocate(capacity);
+  }
+
+  static void deallocate(ctrl_t* ctrl, T* slots, size_type capacity) {
+    delete[] ctrl;
+    std::allocator<T>().deallocate(slots, capacity);
+  }
+
+  void reset_ctrl() {
+    std::memset(ctrl_, kCtrlEmpty, capacity_ + kGroupWidth);
+    ctrl_[capacity_] = kCtrlSentinel;
+  }
+
+  // Sets the control byte of the slot, and of its copy after the sentinel if it has one.
+  void set_ctrl(size_type index, ctrl_t ctrl) {
+    ctrl_[index] = ctrl;
+    ctrl_[((index - (kGroupWidth - 1)) & capacity_) + (kGroupWidth - 1)] = ctrl;
+  }
+
+  iterator iterator_at(size_type index) { return iterator(ctrl_ + index, slots_ + index); }
+
+  iterator find(const Key& key, std::uint64_t hash) {
+    const ctrl_t h = h2(hash);
+    size_type pos = h1(hash) & capacity_;
+    size_type step = 0;
+    while (true) {
+      const Group group(ctrl_ + pos);
+      for (const size_type i : group.match(h)) {
+        const size_type index = (pos + i) & capacity_;
+        if (KeyEqual{}(KeyOf{}(*std::launder(slots_ + index)), key)) {
+          return iterator_at(index);
+        }
+      }
+      if (group.match_empty()) return end();
+
+      // Triangular probing visits every group once the capacity plus one is a power of two.
+      step += kGroupWidth;
+      pos = (pos + step) & capacity_;
+    }
+  }
+
+  size_type find_first_non_full(std::uint64_t hash) const {
+    size_type pos = h1(hash) & capacity_;
+    size_type step = 0;
+    while (true) {
+      if (const auto mask = Group(ctrl_ + pos).match_empty_or_deleted()) {
+        return (pos + mask.trailing_zeros()) & capacity_;
+      }
+      step += kGroupWidth;
+      pos = (pos + step) & capacity_;
+    }
+  }
+
+  // Inserts an element whose key is not in the table, which must have room and no deleted slots.
+  template <typename U>
+  void insert_unique(U&& element) {
+    const std::uint64_t hash = hash_of(KeyOf{}(element));
+    const size_type index = find_first_non_full(hash);
+    new (slots_ + index) T(std::forward<U>(element));
+    set_ctrl(index, h2(hash));
+    size_++;
+    growth_left_--;
+  }
+
+  // Makes room for one more element, by dropping the deleted slots if enough of them make up the
+  // load, or by doubling the capacity otherwise.
+  void grow() {
+    if (capacity_ != 0 && size_ <= max_load(capacity_) / 2) {
+      rehash(capacity_);
+    } else {
+      rehash(capacity_ == 0 ? kMinCapacity : capacity_ * 2 + 1);
+    }
+  }
+
+  void rehash(size_type capacity) {
+    if (capacity == capacity_) {
+      std::vector<T> elements;
+      elements.reserve(size_);
+      for (T& element : *this) {
+        elements.push_back(std::move(element));
+      }
+      destroy_elements();
+      reset_ctrl();
+      size_ = 0;
+      growth_left_ = max_load(capacity_);
+      for (T& element : elements) {
+        insert_unique(std::move(element));
+      }
+      return;
+    }
+
+    ctrl_t* const old_ctrl = ctrl_;
+    T* const old_slots = slots_;
+    const size_type old_capacity = capacity_;
+    const bool was_dynamic = dynamic();
+
+    allocate(capacity, ctrl_, slots_);
+    capacity_ = capacity;
+    reset_ctrl();
+    size_ = 0;
+    growth_left_ = max_load(capacity_);
+
+    for (size_type i = 0; i < old_capacity; i++) {
+      if (is_full(old_ctrl[i])) {
+        T* const slot = std::launder(old_slots + i);
+        insert_unique(std::move(*slot));
+        std::destroy_at(slot);
+      }
+    }
+    if (was_dynamic) {
+      deallocate(old_ctrl, old_slots, old_capacity);
+    }
+  }
+
+  ctrl_t* ctrl_;
+  T* slots_;
+  size_type capacity_;
+  size_type size_;
+  // Number of elements that can be inserted before growing, counting deleted slots as used.
+  size_type growth_left_;
+
+  [[no_unique_address]] InlineStorage<kInlineCapacity> inline_;
+};
+
+}  // namespace android::ftl::details
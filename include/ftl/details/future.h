@@ -21,6 +21,9 @@ namespace android::ftl {
 template <typename, template <typename> class>
 class Future;
 
+template <typename, typename>
+class FutureChain;
+
 namespace details {
 
 template <typename T>
@@ -43,6 +46,11 @@ struct future_result<Future<T, FutureImpl>> {
   using type = T;
 };
 
+template <typename Source, typename F>
+struct future_result<FutureChain<Source, F>> {
+  using type = typename FutureChain<Source, F>::value_type;
+};
+
 template <typename T>
 using future_result_t = typename future_result<T>::type;
 
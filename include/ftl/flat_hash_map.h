@@ -0,0 +1,225 @@
+/*
+ * Copyright 2024 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include <ftl/details/flat_hash_table.h>
+#include <ftl/optional.h>
+
+#include <cstddef>
+#include <functional>
+#include <initializer_list>
+#include <tuple>
+#include <utility>
+
+namespace android::ftl {
+
+// Associative container with unique, unordered keys, for lookups on hot paths. Unlike
+// std::unordered_map, key-value pairs are stored in a flat open addressing table rather than in
+// nodes, and lookups compare a group of 16 slots at once using SIMD where available. Unlike
+// SmallMap, lookups take constant rather than linear time, so the map scales past a few entries.
+//
+// The table is allocated statically while it holds at most N mappings, and relocated to dynamic
+// memory past that. The static capacity is rounded up to the table's own, which is at least 15.
+// FlatHashMap<K, V, 0> allocates on the heap on first insertion.
+//
+// Inserting may move mappings, so it invalidates all iterators and references. Erasing only
+// invalidates those to the erased mapping. The iteration order is unspecified.
+//
+// The API follows SmallMap: lookup is done via getters that can optionally transform the value,
+// and try_replace and emplace_or_replace destructively replace values in place.
+//
+// Example usage:
+//
+//   ftl::FlatHashMap<int, std::string, 4> map;
+//   assert(map.empty());
+//   assert(!map.dynamic());
+//
+//   map.try_emplace(123, "abc");
+//   map.try_emplace(-1);
+//   map.try_emplace(42, 3u, '?');
+//   assert(map.size() == 3u);
+//
+//   assert(map.contains(123));
+//   assert(map.get(42).transform([](const std::string& s) { return s.size(); }) == 3u);
+//
+//   const auto opt = map.get(-1);
+//   assert(opt);
+//
+//   std::string& ref = *opt;
+//   assert(ref.empty());
+//   ref = "xyz";
+//
+//   map.emplace_or_replace(0, "vanilla", 2u, 3u);
+//   assert(map.erase(123));
+//
+//   assert(map == FlatHashMap<int, std::string, 4>({{-1, "xyz"}, {0, "nil"}, {42, "???"}}));
+//
+template <typename K, typename V, std::size_t N, typename Hash = std::hash<K>,
+          typename KeyEqual = std::equal_to<K>>
+class FlatHashMap final {
+  struct KeyOf {
+    const K& operator()(const std::pair<const K, V>& pair) const { return pair.first; }
+  };
+
+  using Table = details::FlatHashTable<std::pair<const K, V>, K, KeyOf, N, Hash, KeyEqual>;
+
+ public:
+  using key_type = K;
+  using mapped_type = V;
+
+  using value_type = typename Table::value_type;
+  using size_type = typename Table::size_type;
+
+  using reference = value_type&;
+  using iterator = typename Table::iterator;
+
+  using const_reference = const value_type&;
+  using const_iterator = typename Table::const_iterator;
+
+  // Creates an empty map.
+  FlatHashMap() = default;
+
+  // Copies key-value pairs, of which the first is kept for duplicate keys.
+  FlatHashMap(std::initializer_list<value_type> list) {
+    reserve(list.size());
+    for (const auto& [k, v] : list) {
+      try_emplace(k, v);
+    }
+  }
+
+  static constexpr size_type static_capacity() { return Table::kInlineCapacity; }
+
+  size_type size() const { return table_.size(); }
+  bool empty() const { return size() == 0; }
+
+  // Returns the number of slots in the table, of which up to 7/8 are used before it grows.
+  size_type capacity() const { return table_.capacity(); }
+
+  // Returns whether the map is backed by dynamic storage.
+  bool dynamic() const { return table_.dynamic(); }
+
+  iterator begin() { return table_.begin(); }
+  const_iterator begin() const { return cbegin(); }
+  const_iterator cbegin() const { return table_.begin(); }
+
+  iterator end() { return table_.end(); }
+  const_iterator end() const { return cend(); }
+  const_iterator cend() const { return table_.end(); }
+
+  // Returns whether a mapping exists for the given key.
+  bool contains(const key_type& key) const { return find(key) != end(); }
+
+  // Returns a reference to the value for the given key, or std::nullopt if the key was not found.
+  auto get(const key_type& key) const -> Optional<std::reference_wrapper<const mapped_type>> {
+    if (const auto it = find(key); it != end()) {
+      return std::cref(it->second);
+    }
+    return {};
+  }
+
+  auto get(const key_type& key) -> Optional<std::reference_wrapper<mapped_type>> {
+    if (const auto it = find(key); it != end()) {
+      return std::ref(it->second);
+    }
+    return {};
+  }
+
+  // Returns an iterator to an existing mapping for the given key, or the end() iterator otherwise.
+  const_iterator find(const key_type& key) const { return table_.find(key); }
+  iterator find(const key_type& key) { return table_.find(key); }
+
+  // Inserts a mapping unless it exists. Returns an iterator to the inserted or existing mapping,
+  // and whether the mapping was inserted. The arguments must not refer to mappings of this map.
+  template <typename... Args>
+  std::pair<iterator, bool> try_emplace(const key_type& key, Args&&... args) {
+    return table_.try_emplace(key, std::piecewise_construct, std::forward_as_tuple(key),
+                              std::forward_as_tuple(std::forward<Args>(args)...));
+  }
+
+  // Replaces a mapping if it exists, and returns an iterator to it. Returns the end() iterator
+  // otherwise.
+  //
+  // The value is replaced via move constructor, so type V does not need to define copy/move
+  // assignment, e.g. its data members may be const.
+  //
+  // The arguments may directly or indirectly refer to the mapping being replaced.
+  //
+  template <typename... Args>
+  iterator try_replace(const key_type& key, Args&&... args) {
+    const auto it = find(key);
+    if (it == end()) return it;
+    table_.replace(it, std::piecewise_construct, std::forward_as_tuple(key),
+                   std::forward_as_tuple(std::forward<Args>(args)...));
+    return it;
+  }
+
+  // In-place counterpart of std::unordered_map's insert_or_assign. Returns true on emplace, or
+  // false on replace.
+  template <typename... Args>
+  std::pair<iterator, bool> emplace_or_replace(const key_type& key, Args&&... args) {
+    if (const auto it = find(key); it != end()) {
+      table_.replace(it, std::piecewise_construct, std::forward_as_tuple(key),
+                     std::forward_as_tuple(std::forward<Args>(args)...));
+      return {it, false};
+    }
+    return try_emplace(key, std::forward<Args>(args)...);
+  }
+
+  // Removes a mapping if it exists, and returns whether it did.
+  bool erase(const key_type& key) {
+    const auto it = find(key);
+    if (it == end()) return false;
+    table_.erase(it);
+    return true;
+  }
+
+  // Removes the mapping at the iterator, which must be dereferenceable.
+  void erase(const_iterator it) { table_.erase(it); }
+
+  // Removes all mappings, but keeps the capacity.
+  void clear() { table_.clear(); }
+
+  // Grows the table so that it holds the given number of mappings without growing again.
+  void reserve(size_type size) { table_.reserve(size); }
+
+ private:
+  Table table_;
+};
+
+// Returns whether the key-value pairs of two maps are equal.
+template <typename K, typename V, std::size_t N, std::size_t M, typename H, typename E>
+bool operator==(const FlatHashMap<K, V, N, H, E>& lhs, const FlatHashMap<K, V, M, H, E>& rhs) {
+  if (lhs.size() != rhs.size()) return false;
+
+  for (const auto& [k, v] : lhs) {
+    const auto& lv = v;
+    if (!rhs.get(k).transform([&lv](const V& rv) { return lv == rv; }).value_or(false)) {
+      return false;
+    }
+  }
+
+  return true;
+}
+
+// TODO: Remove in C++20.
+template <typename K, typename V, std::size_t N, std::size_t M, typename H, typename E>
+inline bool operator!=(const FlatHashMap<K, V, N, H, E>& lhs,
+                       const FlatHashMap<K, V, M, H, E>& rhs) {
+  return !(lhs == rhs);
+}
+
+}  // namespace android::ftl
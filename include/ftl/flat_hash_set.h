@@ -0,0 +1,146 @@
+/*
+ * Copyright 2024 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include <ftl/details/flat_hash_table.h>
+
+#include <cstddef>
+#include <functional>
+#include <initializer_list>
+#include <utility>
+
+namespace android::ftl {
+
+// Set counterpart of FlatHashMap, with the same open addressing table, static capacity, and
+// iterator invalidation rules.
+//
+// Example usage:
+//
+//   ftl::FlatHashSet<int, 4> set;
+//   assert(set.empty());
+//
+//   assert(set.insert(123).second);
+//   assert(!set.insert(123).second);
+//   assert(set.contains(123));
+//
+//   set.insert(-1);
+//   assert(set.size() == 2u);
+//   assert(!set.dynamic());
+//
+//   assert(set.erase(123));
+//   assert(set == FlatHashSet<int, 4>({-1}));
+//
+template <typename K, std::size_t N, typename Hash = std::hash<K>,
+          typename KeyEqual = std::equal_to<K>>
+class FlatHashSet final {
+  struct KeyOf {
+    const K& operator()(const K& key) const { return key; }
+  };
+
+  using Table = details::FlatHashTable<K, K, KeyOf, N, Hash, KeyEqual>;
+
+ public:
+  using key_type = K;
+  using value_type = K;
+  using size_type = typename Table::size_type;
+
+  using const_reference = const value_type&;
+  using const_iterator = typename Table::const_iterator;
+  using iterator = const_iterator;
+
+  // Creates an empty set.
+  FlatHashSet() = default;
+
+  // Copies keys, of which duplicates are dropped.
+  FlatHashSet(std::initializer_list<value_type> list) {
+    reserve(list.size());
+    for (const auto& key : list) {
+      insert(key);
+    }
+  }
+
+  static constexpr size_type static_capacity() { return Table::kInlineCapacity; }
+
+  size_type size() const { return table_.size(); }
+  bool empty() const { return size() == 0; }
+
+  // Returns the number of slots in the table, of which up to 7/8 are used before it grows.
+  size_type capacity() const { return table_.capacity(); }
+
+  // Returns whether the set is backed by dynamic storage.
+  bool dynamic() const { return table_.dynamic(); }
+
+  const_iterator begin() const { return table_.begin(); }
+  const_iterator cbegin() const { return table_.begin(); }
+  const_iterator end() const { return table_.end(); }
+  const_iterator cend() const { return table_.end(); }
+
+  bool contains(const key_type& key) const { return find(key) != end(); }
+
+  // Returns an iterator to the given key, or the end() iterator if the key was not found.
+  const_iterator find(const key_type& key) const { return table_.find(key); }
+
+  // Inserts the key unless it exists. Returns an iterator to the inserted or existing key, and
+  // whether it was inserted.
+  std::pair<const_iterator, bool> insert(const key_type& key) {
+    return table_.try_emplace(key, key);
+  }
+
+  std::pair<const_iterator, bool> insert(key_type&& key) {
+    return table_.try_emplace(key, std::move(key));
+  }
+
+  // Removes a key if it exists, and returns whether it did.
+  bool erase(const key_type& key) {
+    const auto it = find(key);
+    if (it == end()) return false;
+    table_.erase(it);
+    return true;
+  }
+
+  // Removes the key at the iterator, which must be dereferenceable.
+  void erase(const_iterator it) { table_.erase(it); }
+
+  // Removes all keys, but keeps the capacity.
+  void clear() { table_.clear(); }
+
+  // Grows the table so that it holds the given number of keys without growing again.
+  void reserve(size_type size) { table_.reserve(size); }
+
+ private:
+  Table table_;
+};
+
+// Returns whether two sets have the same keys.
+template <typename K, std::size_t N, std::size_t M, typename H, typename E>
+bool operator==(const FlatHashSet<K, N, H, E>& lhs, const FlatHashSet<K, M, H, E>& rhs) {
+  if (lhs.size() != rhs.size()) return false;
+
+  for (const auto& key : lhs) {
+    if (!rhs.contains(key)) return false;
+  }
+
+  return true;
+}
+
+// TODO: Remove in C++20.
+template <typename K, std::size_t N, std::size_t M, typename H, typename E>
+inline bool operator!=(const FlatHashSet<K, N, H, E>& lhs, const FlatHashSet<K, M, H, E>& rhs) {
+  return !(lhs == rhs);
+}
+
+}  // namespace android::ftl
@@ -111,9 +111,14 @@ enum {
     AMOTION_EVENT_PRIVATE_FLAG_SUPPORTS_DIRECTIONAL_ORIENTATION = static_cast<int32_t>(
             android::os::MotionEventFlag::PRIVATE_FLAG_SUPPORTS_DIRECTIONAL_ORIENTATION),
 
+    /** Private flag, not used in Java. */
+    AMOTION_EVENT_PRIVATE_FLAG_UNBATCHED =
+            static_cast<int32_t>(android::os::MotionEventFlag::PRIVATE_FLAG_UNBATCHED),
+
     /** Mask for all private flags that are not used in Java. */
     AMOTION_EVENT_PRIVATE_FLAG_MASK = AMOTION_EVENT_PRIVATE_FLAG_SUPPORTS_ORIENTATION |
-            AMOTION_EVENT_PRIVATE_FLAG_SUPPORTS_DIRECTIONAL_ORIENTATION,
+            AMOTION_EVENT_PRIVATE_FLAG_SUPPORTS_DIRECTIONAL_ORIENTATION |
+            AMOTION_EVENT_PRIVATE_FLAG_UNBATCHED,
 };
 
 /**
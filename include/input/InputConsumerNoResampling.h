@@ -16,6 +16,7 @@
 
 #pragma once
 
+#include <deque>
 #include <map>
 #include <memory>
 #include <optional>
@@ -101,6 +102,13 @@ public:
      */
     bool consumeBatchedInputEvents(std::optional<nsecs_t> requestedFrameTime);
 
+    /**
+     * Provides the time at which the frame that the events are being consumed for is expected to
+     * be presented, as reported by the frame timeline of VsyncEventData. The resampler may use it
+     * to predict the pointer positions at that time. Call it before consumeBatchedInputEvents.
+     */
+    void setExpectedPresentationTime(nsecs_t expectedPresentationTime);
+
     /**
      * Returns true when there is *likely* a pending batch or a pending event in the channel.
      *
@@ -153,7 +161,7 @@ private:
      * events. Therefore, events should only be erased from the queue after they've been
      * successfully written to the InputChannel.
      */
-    std::queue<InputMessage> mOutboundQueue;
+    std::deque<InputMessage> mOutboundQueue;
     /**
      * Try to send all of the events in mOutboundQueue over the InputChannel. Not all events might
      * actually get sent, because it's possible that the channel is blocked.
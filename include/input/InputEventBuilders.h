@@ -104,6 +104,11 @@ public:
         return *this;
     }
 
+    InputMessageBuilder& flags(int32_t flags) {
+        mFlags = flags;
+        return *this;
+    }
+
     InputMessageBuilder& pointer(PointerBuilder pointerBuilder) {
         mPointers.push_back(pointerBuilder);
         return *this;
@@ -123,6 +128,7 @@ public:
         message.body.motion.displayId = mDisplayId.val();
         message.body.motion.action = mAction;
         message.body.motion.downTime = mDownTime;
+        message.body.motion.flags = mFlags;
 
         for (size_t i = 0; i < mPointers.size(); ++i) {
             message.body.motion.pointers[i].properties = mPointers[i].buildProperties();
@@ -142,6 +148,7 @@ private:
     ui::LogicalDisplayId mDisplayId{ui::LogicalDisplayId::DEFAULT};
     int32_t mAction{AMOTION_EVENT_ACTION_MOVE};
     nsecs_t mDownTime{mEventTime};
+    int32_t mFlags{0};
 
     std::vector<PointerBuilder> mPointers;
 };
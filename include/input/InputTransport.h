@@ -28,8 +28,10 @@
  * The InputConsumer is used by the application to receive events from the input dispatcher.
  */
 
+#include <span>
 #include <string>
 #include <unordered_map>
+#include <vector>
 
 #include <android-base/chrono_utils.h>
 #include <android-base/result.h>
@@ -221,6 +223,7 @@ struct InputMessage {
 
     bool isValid(size_t actualSize) const;
     size_t size() const;
+    // Only initializes the first size() bytes of msg, which are the ones to send.
     void getSanitizedCopy(InputMessage* msg) const;
 };
 
@@ -265,6 +268,17 @@ public:
      */
     virtual status_t sendMessage(const InputMessage* msg);
 
+    /* Send messages to the other endpoint, in order, with as few system calls as possible.
+     *
+     * Messages are sent until one can't be. The number of messages sent is returned in
+     * |outSentCount|, and the status is the one sendMessage would have returned for the first
+     * message which wasn't sent.
+     *
+     * Return OK if all the messages were sent.
+     */
+    virtual status_t sendMessages(std::span<const InputMessage* const> msgs,
+                                  size_t& outSentCount);
+
     /* Receive a message sent by the other endpoint.
      *
      * If there is no message present, try again after poll() indicates that the fd
@@ -277,6 +291,15 @@ public:
      */
     virtual android::base::Result<InputMessage> receiveMessage();
 
+    /* Receive up to |maxCount| messages sent by the other endpoint, with as few system calls as
+     * possible.
+     *
+     * Return the messages received in order, at least one on success.
+     * Return the error receiveMessage would have returned if no message was received, or
+     * BAD_VALUE if any of the messages received is invalid.
+     */
+    virtual android::base::Result<std::vector<InputMessage>> receiveMessages(size_t maxCount);
+
     /* Tells whether there is a message in the channel available to be received.
      *
      * This is only a performance hint and may return false negative results. Clients should not
@@ -20,6 +20,9 @@
 #include <input/Input.h>
 #include "rust/cxx.h"
 
+#include <array>
+#include <optional>
+
 namespace android {
 
 namespace input {
@@ -55,6 +58,24 @@ public:
 
 private:
     rust::Box<android::input::verifier::InputVerifier> mVerifier;
+    const bool mShouldLog;
+
+    // The last MOVE or HOVER_MOVE that the rust verifier accepted. These don't change the state of
+    // the verifier, so exact repeats of it, which are most of a gesture, are accepted here without
+    // crossing into rust.
+    struct Move {
+        int32_t deviceId;
+        int32_t source;
+        int32_t action;
+        int32_t flags;
+        uint32_t pointerCount;
+        std::array<int32_t, MAX_POINTERS> pointerIds;
+    };
+    std::optional<Move> mLastMove;
+
+    bool isRepeatOfLastMove(int32_t deviceId, int32_t source, int32_t action,
+                            uint32_t pointerCount, const PointerProperties* pointerProperties,
+                            int32_t flags) const;
 };
 
 } // namespace android
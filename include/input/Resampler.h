@@ -16,6 +16,7 @@
 
 #pragma once
 
+#include <array>
 #include <chrono>
 #include <optional>
 #include <vector>
@@ -54,6 +55,14 @@ struct Resampler {
      * frameTime > resampleTime. Resample latency is defined as frameTime - resampleTime.
      */
     virtual std::chrono::nanoseconds getResampleLatency() const = 0;
+
+    /**
+     * Informs the resampler of the time at which the frame that is being prepared is expected to
+     * be presented, as reported by the frame timeline of VsyncEventData. It applies to the
+     * following calls to resampleMotionEvent, until a new value is provided. Resamplers that do
+     * not predict past frameTime ignore it.
+     */
+    virtual void setExpectedPresentationTime(std::chrono::nanoseconds /*presentationTime*/) {}
 };
 
 class LegacyResampler final : public Resampler {
@@ -151,4 +160,80 @@ private:
 
     inline static void addSampleToMotionEvent(const Sample& sample, MotionEvent& motionEvent);
 };
+
+/**
+ * Resampler that predicts where the pointers will be when the frame is presented, rather than
+ * where they were RESAMPLE_LATENCY before frameTime.
+ *
+ * The position and velocity of every pointer are tracked on each axis by a Kalman filter with a
+ * constant velocity model, which smooths the noise of the samples while following changes of
+ * direction. At resampling time, the filter state is projected to the expected presentation time
+ * provided through setExpectedPresentationTime, or to frameTime if it isn't known. The prediction
+ * is limited to one frame at 60Hz past the latest sample, so that a late frame or a stale
+ * presentation time can't move the pointers far from the real input.
+ *
+ * Since the resampled sample is predicted from the samples up to frameTime, futureSample is not
+ * used, and events are consumed without any resample latency.
+ */
+class PredictiveResampler final : public Resampler {
+public:
+    void resampleMotionEvent(std::chrono::nanoseconds frameTime, MotionEvent& motionEvent,
+                             const InputMessage* futureSample) override;
+
+    std::chrono::nanoseconds getResampleLatency() const override;
+
+    void setExpectedPresentationTime(std::chrono::nanoseconds presentationTime) override;
+
+private:
+    /**
+     * Estimate of the position and velocity along one axis, and of their covariance, in pixels and
+     * seconds.
+     */
+    struct AxisFilter {
+        float position{0};
+        float velocity{0};
+        float positionVariance{0};
+        float covariance{0};
+        float velocityVariance{0};
+
+        void reset(float measuredPosition);
+        void update(float dt, float measuredPosition);
+        float predict(float dt) const;
+    };
+
+    struct PointerFilter {
+        ToolType toolType{ToolType::UNKNOWN};
+        std::chrono::nanoseconds lastEventTime{0};
+        size_t sampleCount{0};
+        AxisFilter x;
+        AxisFilter y;
+    };
+
+    std::optional<DeviceId> mPreviousDeviceId;
+
+    std::optional<std::chrono::nanoseconds> mExpectedPresentationTime;
+
+    /**
+     * The event time of the latest sample given to the filters. Samples that are not newer than it
+     * have already been processed.
+     */
+    std::chrono::nanoseconds mLatestSampleTime{0};
+
+    /**
+     * The filters of the pointers of the latest sample, indexed by pointer id.
+     */
+    std::array<std::optional<PointerFilter>, MAX_POINTER_ID + 1> mFilters;
+
+    /**
+     * Gives the samples of motionEvent that have not been processed yet to the filters, and drops
+     * the filters of the pointers that are no longer present.
+     */
+    void updateFilters(const MotionEvent& motionEvent);
+
+    /**
+     * Returns whether every pointer of motionEvent has a filter that can be projected into the
+     * future.
+     */
+    bool canPredict(const MotionEvent& motionEvent) const;
+};
 } // namespace android
@@ -115,7 +115,9 @@ public:
         float jerkAlpha = 1;
     };
 
-    // Creates a model from an encoded Flatbuffer model.
+    // Creates a model from an encoded Flatbuffer model. The model file is only mapped and verified
+    // once, and is shared by all the models of the process that are alive at the same time. Each
+    // model still has its own interpreter, so they can be invoked independently.
     static std::unique_ptr<TfLiteMotionPredictorModel> create();
 
     ~TfLiteMotionPredictorModel();
@@ -146,8 +148,13 @@ public:
     std::span<const float> outputPressure() const;
 
 private:
-    explicit TfLiteMotionPredictorModel(std::unique_ptr<android::base::MappedFile> model,
-                                        Config config);
+    // The immutable parts of a loaded model: the mapped Flatbuffer, the model built from it, and
+    // its config.
+    struct SharedModel;
+
+    explicit TfLiteMotionPredictorModel(std::shared_ptr<const SharedModel> model);
+
+    static std::shared_ptr<const SharedModel> loadSharedModel();
 
     void allocateTensors();
     void attachInputTensors();
@@ -163,9 +170,7 @@ private:
     const TfLiteTensor* mOutputPhi = nullptr;
     const TfLiteTensor* mOutputPressure = nullptr;
 
-    std::unique_ptr<android::base::MappedFile> mFlatBuffer;
-    std::unique_ptr<tflite::ErrorReporter> mErrorReporter;
-    std::unique_ptr<tflite::FlatBufferModel> mModel;
+    std::shared_ptr<const SharedModel> mSharedModel;
     std::unique_ptr<tflite::Interpreter> mInterpreter;
     tflite::SignatureRunner* mRunner = nullptr;
 
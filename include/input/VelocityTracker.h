@@ -21,6 +21,7 @@
 #include <input/RingBuffer.h>
 #include <utils/BitSet.h>
 #include <utils/Timers.h>
+#include <array>
 #include <map>
 #include <set>
 
@@ -47,9 +48,10 @@ public:
         INT1 = android::os::IInputConstants::VELOCITY_TRACKER_STRATEGY_INT1,
         INT2 = android::os::IInputConstants::VELOCITY_TRACKER_STRATEGY_INT2,
         LEGACY = android::os::IInputConstants::VELOCITY_TRACKER_STRATEGY_LEGACY,
+        ILSQ2 = android::os::IInputConstants::VELOCITY_TRACKER_STRATEGY_ILSQ2,
         MIN = IMPULSE,
-        MAX = LEGACY,
-        ftl_last = LEGACY,
+        MAX = ILSQ2,
+        ftl_last = ILSQ2,
     };
 
     /*
@@ -233,6 +235,54 @@ private:
     const Weighting mWeighting;
 };
 
+/*
+ * Velocity tracker algorithm based on unweighted second-order least-squares, like LSQ2.
+ * Instead of fitting the polynomial to the whole history on every query, it keeps running sums of
+ * the powers of the sample times and positions, which are updated as samples enter or leave the
+ * horizon. Both adding a movement and getting the velocity take constant time.
+ */
+class IncrementalLeastSquaresVelocityTrackerStrategy : public VelocityTrackerStrategy {
+public:
+    IncrementalLeastSquaresVelocityTrackerStrategy();
+    ~IncrementalLeastSquaresVelocityTrackerStrategy() override;
+
+    void clearPointer(int32_t pointerId) override;
+    void addMovement(nsecs_t eventTime, int32_t pointerId, float position) override;
+    std::optional<float> getVelocity(int32_t pointerId) const override;
+
+private:
+    // Same horizon and history size as the LeastSquaresVelocityTrackerStrategy.
+    static constexpr nsecs_t HORIZON = 100 * 1000000; // 100 ms
+    static constexpr size_t HISTORY_SIZE = 20;
+
+    // The samples of a pointer that are within the horizon, in chronological order, stored in a
+    // ring of parallel arrays.
+    struct History {
+        std::array<nsecs_t, HISTORY_SIZE> eventTimes;
+        std::array<float, HISTORY_SIZE> positions;
+        size_t start;
+        size_t size;
+
+        // The sample times are measured in seconds relative to this time, which is moved forward
+        // as old samples leave the horizon to keep the sums well conditioned.
+        nsecs_t origin;
+        // timeSums[k] is the sum of t^k over the samples, and timePositionSums[k] is the sum of
+        // t^k * position.
+        std::array<double, 5> timeSums;
+        std::array<double, 3> timePositionSums;
+
+        nsecs_t eventTimeAt(size_t index) const;
+    };
+
+    static void accumulate(History& history, nsecs_t eventTime, float position, double sign);
+    static void popFront(History& history);
+    static void popBack(History& history);
+    static void rebase(History& history);
+
+    BitSet32 mPointerIdBits;
+    std::array<History, MAX_POINTER_ID + 1> mHistories;
+};
+
 /*
  * Velocity tracker algorithm that uses an IIR filter.
  */
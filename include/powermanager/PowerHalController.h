@@ -78,8 +78,10 @@ private:
     std::unique_ptr<HalConnector> mHalConnector;
 
     // Shared pointers to keep global pointer and allow local copies to be used in
-    // different threads
-    std::shared_ptr<HalWrapper> mConnectedHal GUARDED_BY(mConnectedHalMutex) = nullptr;
+    // different threads. This is read with std::atomic_load so that calls on a
+    // connected handle do not contend on mConnectedHalMutex, which only guards
+    // connecting and resetting the handle.
+    std::shared_ptr<HalWrapper> mConnectedHal = nullptr;
     const std::shared_ptr<HalWrapper> mDefaultHal = std::make_shared<EmptyHalWrapper>();
 
     std::shared_ptr<HalWrapper> initHal();
@@ -31,6 +31,7 @@
 
 #include <binder/Status.h>
 
+#include <atomic>
 #include <utility>
 
 namespace android {
@@ -175,20 +176,21 @@ protected:
     const char* getUnsupportedMessage() override;
 
 private:
-    // Control access to the boost and mode supported arrays.
+    // Serialize the support checks of the boost and mode supported arrays, so that each is only
+    // queried once. Known support is read without locking.
     std::mutex mBoostMutex;
     std::mutex mModeMutex;
     std::shared_ptr<aidl::android::hardware::power::IPower> mHandle;
-    std::array<HalSupport,
+    std::array<std::atomic<HalSupport>,
                static_cast<int32_t>(
                        *(ndk::enum_range<aidl::android::hardware::power::Boost>().end() - 1)) +
                        1>
-            mBoostSupportedArray GUARDED_BY(mBoostMutex) = {HalSupport::UNKNOWN};
-    std::array<HalSupport,
+            mBoostSupportedArray = {HalSupport::UNKNOWN};
+    std::array<std::atomic<HalSupport>,
                static_cast<int32_t>(
                        *(ndk::enum_range<aidl::android::hardware::power::Mode>().end() - 1)) +
                        1>
-            mModeSupportedArray GUARDED_BY(mModeMutex) = {HalSupport::UNKNOWN};
+            mModeSupportedArray = {HalSupport::UNKNOWN};
 };
 
 }; // namespace power
@@ -25,6 +25,9 @@
 #include <android-base/thread_annotations.h>
 #include "HalResult.h"
 
+#include <mutex>
+#include <vector>
+
 namespace android::power {
 
 // Wrapper for power hint sessions, which allows for better mocking,
@@ -46,9 +49,21 @@ public:
                                     bool in_enabled);
     virtual HalResult<aidl::android::hardware::power::SessionConfig> getSessionConfig();
 
+    // Queues a work duration to be sent in a single reportActualWorkDuration call with
+    // the others queued, once maxBatchSize durations are queued. This saves a binder
+    // transaction per frame for callers that can tolerate reports being delayed.
+    virtual HalResult<void> queueActualWorkDuration(
+            const ::aidl::android::hardware::power::WorkDuration& duration, size_t maxBatchSize);
+    // Sends the queued work durations, if any.
+    virtual HalResult<void> flushActualWorkDurations();
+
 private:
     std::shared_ptr<aidl::android::hardware::power::IPowerHintSession> mSession;
     int32_t mInterfaceVersion;
+
+    std::mutex mQueueMutex;
+    std::vector<::aidl::android::hardware::power::WorkDuration> mQueuedDurations
+            GUARDED_BY(mQueueMutex);
 };
 
 } // namespace android::power
\ No newline at end of file
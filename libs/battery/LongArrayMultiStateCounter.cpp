@@ -18,6 +18,12 @@
 #include "LongArrayMultiStateCounter.h"
 #include <log/log.h>
 
+#include <algorithm>
+
+#if defined(__aarch64__)
+#include <arm_neon.h>
+#endif
+
 namespace android {
 namespace battery {
 
@@ -31,12 +37,29 @@ bool LongArrayMultiStateCounter::delta(const std::vector<uint64_t>& previousValu
         return false;
     }
 
+    const uint64_t* previous = previousValue.data();
+    const uint64_t* next = newValue.data();
+    uint64_t* out = outValue->data();
+    size_t i = 0;
     bool is_delta_valid = true;
-    for (int i = size - 1; i >= 0; i--) {
-        if (newValue[i] >= previousValue[i]) {
-            (*outValue)[i] = newValue[i] - previousValue[i];
+#if defined(__aarch64__)
+    // Two elements at a time: a lane where the value went down is masked to 0 and clears its lane
+    // of the validity mask.
+    uint64x2_t valid = vdupq_n_u64(~0ULL);
+    for (; i + 2 <= size; i += 2) {
+        uint64x2_t p = vld1q_u64(previous + i);
+        uint64x2_t n = vld1q_u64(next + i);
+        uint64x2_t increased = vcgeq_u64(n, p);
+        vst1q_u64(out + i, vandq_u64(vsubq_u64(n, p), increased));
+        valid = vandq_u64(valid, increased);
+    }
+    is_delta_valid = (vgetq_lane_u64(valid, 0) & vgetq_lane_u64(valid, 1)) != 0;
+#endif
+    for (; i < size; i++) {
+        if (next[i] >= previous[i]) {
+            out[i] = next[i] - previous[i];
         } else {
-            (*outValue)[i] = 0;
+            out[i] = 0;
             is_delta_valid = false;
         }
     }
@@ -47,14 +70,26 @@ template <>
 void LongArrayMultiStateCounter::add(std::vector<uint64_t>* value1,
                                      const std::vector<uint64_t>& value2, const uint64_t numerator,
                                      const uint64_t denominator) const {
+    const uint64_t* in = value2.data();
+    uint64_t* out = value1->data();
+    size_t size = value2.size();
     if (numerator != denominator) {
-        for (int i = value2.size() - 1; i >= 0; i--) {
-            // The caller ensures that denominator != 0
-            (*value1)[i] += value2[i] * numerator / denominator;
+        for (size_t i = 0; i < size; i++) {
+            // Most CPU frequencies are not used between two updates, and a division is expensive,
+            // so skip their zero deltas. The caller ensures that denominator != 0
+            if (in[i] != 0) {
+                out[i] += in[i] * numerator / denominator;
+            }
         }
     } else {
-        for (int i = value2.size() - 1; i >= 0; i--) {
-            (*value1)[i] += value2[i];
+        size_t i = 0;
+#if defined(__aarch64__)
+        for (; i + 2 <= size; i += 2) {
+            vst1q_u64(out + i, vaddq_u64(vld1q_u64(out + i), vld1q_u64(in + i)));
+        }
+#endif
+        for (; i < size; i++) {
+            out[i] += in[i];
         }
     }
 }
@@ -75,5 +110,24 @@ std::string LongArrayMultiStateCounter::valueToString(const std::vector<uint64_t
     return s.str();
 }
 
+void updateValues(LongArrayMultiStateCounter* const* counters, size_t counterCount,
+                  const uint64_t* values, size_t arrayLength, time_t timestamp,
+                  uint64_t* outDeltas) {
+    std::vector<uint64_t> value(arrayLength);
+    for (size_t i = 0; i < counterCount; i++) {
+        const uint64_t* counterValues = values + i * arrayLength;
+        std::copy(counterValues, counterValues + arrayLength, value.begin());
+        const std::vector<uint64_t>& delta = counters[i]->updateValue(value, timestamp);
+        if (outDeltas != nullptr) {
+            uint64_t* counterDeltas = outDeltas + i * arrayLength;
+            if (delta.size() == arrayLength) {
+                std::copy(delta.begin(), delta.end(), counterDeltas);
+            } else {
+                std::fill(counterDeltas, counterDeltas + arrayLength, 0);
+            }
+        }
+    }
+}
+
 } // namespace battery
 } // namespace android
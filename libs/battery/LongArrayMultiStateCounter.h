@@ -25,5 +25,16 @@ namespace battery {
 
 typedef MultiStateCounter<std::vector<uint64_t>> LongArrayMultiStateCounter;
 
+/**
+ * Updates each counter with its own value, as updateValue does, all with the same timestamp.
+ * The values of all counters are laid out one after the other in a single array of
+ * counterCount * arrayLength elements, as they would be in one Java long[] for all UIDs, so that
+ * they can all be updated in a single native call. If outDeltas is not null, it gets the deltas
+ * returned by updateValue in the same layout.
+ */
+void updateValues(LongArrayMultiStateCounter* const* counters, size_t counterCount,
+                  const uint64_t* values, size_t arrayLength, time_t timestamp,
+                  uint64_t* outDeltas);
+
 } // namespace battery
 } // namespace android
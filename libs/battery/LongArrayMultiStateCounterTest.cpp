@@ -65,5 +65,35 @@ TEST_F(LongArrayMultiStateCounterTest, toString) {
                  testCounter.toString().c_str());
 }
 
+TEST_F(LongArrayMultiStateCounterTest, updateValues) {
+    // Odd array size, for the elements left after the vectorized loops.
+    LongArrayMultiStateCounter counter1(2, std::vector<uint64_t>(3));
+    LongArrayMultiStateCounter counter2(2, std::vector<uint64_t>(3));
+    LongArrayMultiStateCounter* counters[] = {&counter1, &counter2};
+    counter1.setState(0, 1000);
+    counter2.setState(1, 1000);
+
+    const uint64_t initialValues[] = {0, 0, 0, 10, 20, 30};
+    updateValues(counters, 2, initialValues, 3, 1000, nullptr);
+    counter1.setState(1, 2000);
+
+    // The second counter goes down in its last element, so its delta is invalid.
+    const uint64_t values[] = {100, 200, 300, 20, 40, 10};
+    uint64_t deltas[6];
+    updateValues(counters, 2, values, 3, 3000, deltas);
+
+    EXPECT_EQ(std::vector<uint64_t>({50, 100, 150}), counter1.getCount(0));
+    EXPECT_EQ(std::vector<uint64_t>({50, 100, 150}), counter1.getCount(1));
+    EXPECT_EQ(std::vector<uint64_t>({0, 0, 0}), counter2.getCount(0));
+    EXPECT_EQ(std::vector<uint64_t>({0, 0, 0}), counter2.getCount(1));
+    EXPECT_EQ(std::vector<uint64_t>({100, 200, 300, 0, 0, 0}),
+              std::vector<uint64_t>(std::begin(deltas), std::end(deltas)));
+
+    const uint64_t nextValues[] = {100, 200, 300, 30, 50, 20};
+    updateValues(counters, 2, nextValues, 3, 4000, deltas);
+    EXPECT_EQ(std::vector<uint64_t>({0, 0, 0}), counter2.getCount(0));
+    EXPECT_EQ(std::vector<uint64_t>({10, 10, 10}), counter2.getCount(1));
+}
+
 } // namespace battery
 } // namespace android
@@ -15,6 +15,7 @@
  */
 #include "BackendUnifiedServiceManager.h"
 
+#include <android/os/BnServiceCallback.h>
 #include <android/os/IAccessor.h>
 #include <binder/RpcSession.h>
 
@@ -33,6 +34,36 @@ constexpr bool kUseCache = false;
 using AidlServiceManager = android::os::IServiceManager;
 using IAccessor = android::os::IAccessor;
 
+// Each service known to be absent keeps a notification registered with servicemanager, so bound
+// how many a process can hold.
+constexpr size_t kMaxAbsentServices = 64;
+
+namespace {
+
+// Drops a service from the negative cache once servicemanager reports it as registered.
+class AbsentServiceInvalidation : public os::BnServiceCallback {
+public:
+    AbsentServiceInvalidation(std::weak_ptr<BinderCacheWithInvalidation> cache,
+                              const sp<AidlServiceManager>& sm)
+          : mCache(cache), mServiceManager(sm) {}
+
+    binder::Status onRegistration(const std::string& name, const sp<IBinder>&) override {
+        if (std::shared_ptr<BinderCacheWithInvalidation> cache = mCache.lock()) {
+            cache->removeAbsent(name);
+        }
+        // A later lookup that finds the service absent again registers a new callback.
+        mServiceManager->unregisterForNotifications(name,
+                                                    sp<os::IServiceCallback>::fromExisting(this));
+        return binder::Status::ok();
+    }
+
+private:
+    std::weak_ptr<BinderCacheWithInvalidation> mCache;
+    sp<AidlServiceManager> mServiceManager;
+};
+
+} // namespace
+
 static const char* kStaticCachableList[] = {
         // go/keep-sorted start
         "accessibility",
@@ -138,6 +169,40 @@ bool BackendUnifiedServiceManager::returnIfCached(const std::string& serviceName
     return false;
 }
 
+void BackendUnifiedServiceManager::updateAbsentCache(const std::string& serviceName,
+                                                     const os::Service& service) {
+    if (!kUseCache) {
+        return;
+    }
+    if (service.getTag() != os::Service::Tag::binder ||
+        service.get<os::Service::Tag::binder>() != nullptr) {
+        return;
+    }
+    // The entry is only invalidated by a notification, which needs a thread to receive it.
+    if (ProcessState::self()->getThreadPoolMaxTotalThreadCount() <= 0) {
+        return;
+    }
+    if (mCacheForGetService->absentCount() >= kMaxAbsentServices ||
+        !mCacheForGetService->setAbsent(serviceName)) {
+        return;
+    }
+    // The entry exists before registering, so a notification for a service that has been added
+    // in the meantime can't be missed. servicemanager sends one right away in that case.
+    sp<AbsentServiceInvalidation> callback =
+            sp<AbsentServiceInvalidation>::make(mCacheForGetService, mTheRealServiceManager);
+    if (!mTheRealServiceManager->registerForNotifications(serviceName, callback).isOk()) {
+        // For instance, isolated apps can't register for notifications.
+        mCacheForGetService->removeAbsent(serviceName);
+    }
+}
+
+bool BackendUnifiedServiceManager::isKnownAbsent(const std::string& serviceName) {
+    if (!kUseCache) {
+        return false;
+    }
+    return mCacheForGetService->isKnownAbsent(serviceName);
+}
+
 BackendUnifiedServiceManager::BackendUnifiedServiceManager(const sp<AidlServiceManager>& impl)
       : mTheRealServiceManager(impl) {
     mCacheForGetService = std::make_shared<BinderCacheWithInvalidation>();
@@ -179,16 +244,72 @@ binder::Status BackendUnifiedServiceManager::checkService(const ::std::string& n
         return binder::Status::ok();
     }
 
+    if (isKnownAbsent(name)) {
+        // Locally injected accessors may still provide the service.
+        return toBinderService(name, os::Service::make<os::Service::Tag::binder>(nullptr), _out);
+    }
+
     binder::Status status = mTheRealServiceManager->checkService(name, &service);
     if (status.isOk()) {
         status = toBinderService(name, service, _out);
         if (status.isOk()) {
+            updateAbsentCache(name, service);
             return updateCache(name, service);
         }
     }
     return status;
 }
 
+binder::Status BackendUnifiedServiceManager::checkServices(
+        const ::std::vector<::std::string>& names, ::std::vector<os::Service>* _out) {
+    _out->resize(names.size());
+
+    std::vector<std::string> lookupNames;
+    std::vector<size_t> lookupIndices;
+    for (size_t i = 0; i < names.size(); i++) {
+        if (returnIfCached(names[i], &(*_out)[i])) {
+            continue;
+        }
+        if (isKnownAbsent(names[i])) {
+            binder::Status status =
+                    toBinderService(names[i], os::Service::make<os::Service::Tag::binder>(nullptr),
+                                    &(*_out)[i]);
+            if (!status.isOk()) {
+                return status;
+            }
+            continue;
+        }
+        lookupNames.push_back(names[i]);
+        lookupIndices.push_back(i);
+    }
+    if (lookupNames.empty()) {
+        return binder::Status::ok();
+    }
+
+    std::vector<os::Service> services;
+    binder::Status status = mTheRealServiceManager->checkServices(lookupNames, &services);
+    if (!status.isOk()) {
+        return status;
+    }
+    if (services.size() != lookupNames.size()) {
+        ALOGE("checkServices returned %zu services for %zu names", services.size(),
+              lookupNames.size());
+        return binder::Status::fromStatusT(BAD_VALUE);
+    }
+    for (size_t i = 0; i < lookupNames.size(); i++) {
+        status = toBinderService(lookupNames[i], services[i], &(*_out)[lookupIndices[i]]);
+        if (!status.isOk()) {
+            return status;
+        }
+        updateAbsentCache(lookupNames[i], services[i]);
+        status = updateCache(lookupNames[i], services[i]);
+        if (!status.isOk()) {
+            return status;
+        }
+    }
+    return binder::Status::ok();
+}
+
 binder::Status BackendUnifiedServiceManager::toBinderService(const ::std::string& name,
                                                              const os::Service& in,
                                                              os::Service* _out) {
@@ -20,6 +20,7 @@
 #include <binder/IPCThreadState.h>
 #include <map>
 #include <memory>
+#include <set>
 
 namespace android {
 
@@ -94,8 +95,32 @@ public:
 
     bool isClientSideCachingEnabled(const std::string& serviceName);
 
+    // Services which servicemanager reported as not registered. Each entry is only kept while a
+    // notification is registered for it, which removes the entry once the service is added.
+    bool isKnownAbsent(const std::string& key) const {
+        std::lock_guard<std::mutex> lock(mCacheMutex);
+        return mAbsent.count(key) != 0;
+    }
+
+    // Returns false if the service was already known to be absent.
+    bool setAbsent(const std::string& key) {
+        std::lock_guard<std::mutex> lock(mCacheMutex);
+        return mAbsent.insert(key).second;
+    }
+
+    size_t absentCount() const {
+        std::lock_guard<std::mutex> lock(mCacheMutex);
+        return mAbsent.size();
+    }
+
+    void removeAbsent(const std::string& key) {
+        std::lock_guard<std::mutex> lock(mCacheMutex);
+        mAbsent.erase(key);
+    }
+
 private:
     std::map<std::string, Entry> mCache;
+    std::set<std::string> mAbsent;
     mutable std::mutex mCacheMutex;
 };
 
@@ -129,6 +154,8 @@ public:
     binder::Status tryUnregisterService(const ::std::string& name,
                                         const sp<IBinder>& service) override;
     binder::Status getServiceDebugInfo(::std::vector<os::ServiceDebugInfo>* _aidl_return) override;
+    binder::Status checkServices(const ::std::vector<::std::string>& names,
+                                 ::std::vector<os::Service>* _out) override;
 
     // for legacy ABI
     const String16& getInterfaceDescriptor() const override {
@@ -142,6 +169,8 @@ private:
                                    os::Service* _out);
     binder::Status updateCache(const std::string& serviceName, const os::Service& service);
     bool returnIfCached(const std::string& serviceName, os::Service* _out);
+    void updateAbsentCache(const std::string& serviceName, const os::Service& service);
+    bool isKnownAbsent(const std::string& serviceName);
 };
 
 sp<BackendUnifiedServiceManager> getBackendUnifiedServiceManager();
@@ -27,12 +27,15 @@
 #include <binder/Parcel.h>
 #include <binder/RecordedTransaction.h>
 #include <binder/RpcServer.h>
+#include <binder/TransactionStats.h>
 #include <binder/unique_fd.h>
 #include <pthread.h>
 
 #include <inttypes.h>
 #include <stdio.h>
 
+#include <chrono>
+
 #ifdef __linux__
 #include <linux/sched.h>
 #endif
@@ -216,6 +219,63 @@ status_t IBinder::setRpcClientDebug(unique_fd socketFd, const sp<IBinder>& keepA
     return transact(SET_RPC_CLIENT_TRANSACTION, data, &reply);
 }
 
+// Commands of TRANSACTION_STATS_TRANSACTION.
+enum : int32_t {
+    TRANSACTION_STATS_DUMP = 0,
+    TRANSACTION_STATS_ENABLE = 1,
+    TRANSACTION_STATS_DISABLE = 2,
+};
+
+status_t IBinder::setTransactionStatsEnabled(bool enabled) {
+    if (this->localBinder() != nullptr) {
+        binder::debug::TransactionStats::setEnabled(enabled);
+        return OK;
+    }
+
+    Parcel data;
+    Parcel reply;
+    status_t status =
+            data.writeInt32(enabled ? TRANSACTION_STATS_ENABLE : TRANSACTION_STATS_DISABLE);
+    if (status != OK) return status;
+    return transact(TRANSACTION_STATS_TRANSACTION, data, &reply);
+}
+
+status_t IBinder::dumpTransactionStats(std::string* out) {
+    if (this->localBinder() != nullptr) {
+        *out = binder::debug::TransactionStats::dump();
+        return OK;
+    }
+
+    Parcel data;
+    Parcel reply;
+    status_t status = data.writeInt32(TRANSACTION_STATS_DUMP);
+    if (status != OK) return status;
+    status = transact(TRANSACTION_STATS_TRANSACTION, data, &reply);
+    if (status != OK) return status;
+    return reply.readUtf8FromUtf16(out);
+}
+
+static status_t handleTransactionStatsTransaction(const Parcel& data, Parcel* reply) {
+    uid_t uid = IPCThreadState::self()->getCallingUid();
+    if (uid != kUidRoot) {
+        ALOGE("Binder transaction stats not allowed because client %" PRIu32 " is not root", uid);
+        return PERMISSION_DENIED;
+    }
+    int32_t command;
+    if (status_t status = data.readInt32(&command); status != OK) return status;
+    switch (command) {
+        case TRANSACTION_STATS_DUMP:
+            LOG_ALWAYS_FATAL_IF(reply == nullptr, "reply == nullptr");
+            return reply->writeUtf8AsUtf16(binder::debug::TransactionStats::dump());
+        case TRANSACTION_STATS_ENABLE:
+        case TRANSACTION_STATS_DISABLE:
+            binder::debug::TransactionStats::setEnabled(command == TRANSACTION_STATS_ENABLE);
+            return OK;
+        default:
+            return BAD_VALUE;
+    }
+}
+
 void IBinder::withLock(const std::function<void()>& doWithLock) {
     BBinder* local = localBinder();
     if (local) {
@@ -381,6 +441,11 @@ status_t BBinder::transact(
         reply->markSensitive();
     }
 
+    const bool recordStats = code >= FIRST_CALL_TRANSACTION && code <= LAST_CALL_TRANSACTION &&
+            binder::debug::TransactionStats::isEnabled();
+    const auto startTime = recordStats ? std::chrono::steady_clock::now()
+                                       : std::chrono::steady_clock::time_point();
+
     status_t err = NO_ERROR;
     switch (code) {
         case PING_TRANSACTION:
@@ -404,6 +469,9 @@ status_t BBinder::transact(
             err = setRpcClientDebug(data);
             break;
         }
+        case TRANSACTION_STATS_TRANSACTION:
+            err = handleTransactionStatsTransaction(data, reply);
+            break;
         default:
             err = onTransact(code, data, reply, flags);
             break;
@@ -418,6 +486,14 @@ status_t BBinder::transact(
         }
     }
 
+    if (recordStats) [[unlikely]] {
+        const auto latency = std::chrono::steady_clock::now() - startTime;
+        binder::debug::TransactionStats::
+                record(getInterfaceDescriptor(), code, true /*incoming*/,
+                       std::chrono::duration_cast<std::chrono::nanoseconds>(latency).count(),
+                       data.dataSize(), reply ? reply->dataSize() : 0);
+    }
+
     if (kEnableKernelIpc && mRecordingOn && code != START_RECORDING_TRANSACTION) [[unlikely]] {
         Extras* e = mExtras.load(std::memory_order_acquire);
         RpcMutexUniqueLock lock(e->mLock);
@@ -24,9 +24,12 @@
 #include <binder/RpcSession.h>
 #include <binder/Stability.h>
 #include <binder/Trace.h>
+#include <binder/TransactionStats.h>
 
 #include <stdio.h>
 
+#include <chrono>
+
 #include "BuildFlags.h"
 #include "file.h"
 
@@ -394,6 +397,11 @@ status_t BpBinder::transact(
             }
         }
 
+        const bool recordStats = code >= FIRST_CALL_TRANSACTION &&
+                code <= LAST_CALL_TRANSACTION && binder::debug::TransactionStats::isEnabled();
+        const auto startTime = recordStats ? std::chrono::steady_clock::now()
+                                           : std::chrono::steady_clock::time_point();
+
         status_t status;
         if (isRpcBinder()) [[unlikely]] {
             status = rpcSession()->transact(sp<IBinder>::fromExisting(this), code, data, reply,
@@ -414,6 +422,16 @@ status_t BpBinder::transact(
 
         if (status == DEAD_OBJECT) mAlive = 0;
 
+        if (recordStats) [[unlikely]] {
+            const auto latency = std::chrono::steady_clock::now() - startTime;
+            // Fetches the descriptor on first use, with an INTERFACE_TRANSACTION which isn't
+            // recorded itself.
+            binder::debug::TransactionStats::
+                    record(getInterfaceDescriptor(), code, false /*incoming*/,
+                           std::chrono::duration_cast<std::chrono::nanoseconds>(latency).count(),
+                           data.dataSize(), reply ? reply->dataSize() : 0);
+        }
+
         return status;
     }
 
@@ -531,27 +549,44 @@ void BpBinder::sendObituary()
         return;
     }
 
+    if (prepareObituary() && !isRpcBinder()) {
+        if constexpr (kEnableKernelIpc) {
+            IPCThreadState::self()->flushCommands();
+        }
+    }
+    reportObituaries();
+}
+
+bool BpBinder::prepareObituary()
+{
     ALOGV("Sending obituary for proxy %p handle %d, mObitsSent=%s\n", this, binderHandle(),
           mObitsSent ? "true" : "false");
 
     mAlive = 0;
-    if (mObitsSent) return;
+    if (mObitsSent) return false;
 
-    mLock.lock();
-    Vector<Obituary>* obits = mObituaries;
-    if(obits != nullptr) {
-        ALOGV("Clearing sent death notification: %p handle %d\n", this, binderHandle());
-        if (!isRpcBinder()) {
-            if constexpr (kEnableKernelIpc) {
-                IPCThreadState* self = IPCThreadState::self();
-                self->clearDeathNotification(binderHandle(), this);
-                self->flushCommands();
-            }
+    RpcMutexLockGuard _l(mLock);
+    mObitsSent = 1;
+    if (mObituaries == nullptr) return false;
+
+    ALOGV("Clearing sent death notification: %p handle %d\n", this, binderHandle());
+    if (!isRpcBinder()) {
+        if constexpr (kEnableKernelIpc) {
+            IPCThreadState::self()->clearDeathNotification(binderHandle(), this);
         }
+    }
+    return true;
+}
+
+void BpBinder::reportObituaries()
+{
+    Vector<Obituary>* obits;
+    {
+        RpcMutexLockGuard _l(mLock);
+        // linkToDeath and unlinkToDeath leave mObituaries alone once mObitsSent is set.
+        obits = mObituaries;
         mObituaries = nullptr;
     }
-    mObitsSent = 1;
-    mLock.unlock();
 
     ALOGV("Reporting death of proxy %p for %zu recipients\n",
         this, obits ? obits->size() : 0U);
@@ -34,6 +34,7 @@
 #include <sys/ioctl.h>
 #include <sys/resource.h>
 #include <unistd.h>
+#include <vector>
 
 #include "Utils.h"
 #include "binder_module.h"
@@ -688,10 +689,17 @@ status_t IPCThreadState::getAndExecuteCommand()
         }
 
         size_t newThreadsCount = mProcess->mExecutingThreadsCount.fetch_add(1) + 1;
+        size_t peak = mProcess->mPeakExecutingThreadsCount.load(std::memory_order_relaxed);
+        while (newThreadsCount > peak &&
+               !mProcess->mPeakExecutingThreadsCount
+                        .compare_exchange_weak(peak, newThreadsCount, std::memory_order_relaxed)) {
+        }
         if (newThreadsCount >= mProcess->mMaxThreads) {
             auto expected = ProcessState::never();
-            mProcess->mStarvationStartTime
-                    .compare_exchange_strong(expected, std::chrono::steady_clock::now());
+            if (mProcess->mStarvationStartTime
+                        .compare_exchange_strong(expected, std::chrono::steady_clock::now())) {
+                mProcess->mStarvationCount++;
+            }
         }
 
         result = executeCommand(cmd);
@@ -703,6 +711,9 @@ status_t IPCThreadState::getAndExecuteCommand()
                     mProcess->mStarvationStartTime.exchange(ProcessState::never());
             if (starvationStartTime != ProcessState::never()) {
                 auto starvationTime = std::chrono::steady_clock::now() - starvationStartTime;
+                mProcess->mTotalStarvationNs +=
+                        std::chrono::duration_cast<std::chrono::nanoseconds>(starvationTime)
+                                .count();
                 if (starvationTime > 100ms) {
                     ALOGE("binder thread pool (%zu threads) starved for %" PRId64 " ms", maxThreads,
                           to_ms(starvationTime));
@@ -866,6 +877,15 @@ status_t IPCThreadState::transact(int32_t handle,
 
     LOG_ONEWAY(">>>> SEND from pid %d uid %d %s", getpid(), getuid(),
         (flags & TF_ONE_WAY) == 0 ? "READ REPLY" : "ONE WAY");
+
+    if (mOnewayBatchDepth > 0) [[unlikely]] {
+        if ((flags & TF_ONE_WAY) != 0) {
+            return queueOnewayTransaction(handle, code, data, flags);
+        }
+        // the queued transactions were made first, so they must be sent first
+        sendOnewayBatch();
+    }
+
     err = writeTransactionData(BC_TRANSACTION, flags, handle, code, data, nullptr);
 
     if (err != NO_ERROR) {
@@ -923,6 +943,72 @@ status_t IPCThreadState::transact(int32_t handle,
     return err;
 }
 
+void IPCThreadState::beginOnewayBatch()
+{
+    mOnewayBatchDepth++;
+}
+
+status_t IPCThreadState::flushOnewayBatch()
+{
+    LOG_ALWAYS_FATAL_IF(mOnewayBatchDepth == 0, "flushOnewayBatch without beginOnewayBatch");
+    if (--mOnewayBatchDepth > 0) {
+        return NO_ERROR;
+    }
+
+    sendOnewayBatch();
+    const status_t err = mOnewayBatchError;
+    mOnewayBatchError = NO_ERROR;
+    return err;
+}
+
+status_t IPCThreadState::queueOnewayTransaction(int32_t handle, uint32_t code, const Parcel& data,
+                                                uint32_t flags)
+{
+    // The command in mOut only points at the data, which the caller may free
+    // as soon as we return, so it must refer to a copy which owns its binders
+    // and file descriptors until the driver has consumed it.
+    auto copy = std::make_unique<Parcel>();
+    status_t err = data.errorCheck();
+    if (err == NO_ERROR) {
+        err = copy->appendFrom(&data, 0, data.dataSize());
+    }
+    if (err == NO_ERROR) {
+        err = writeTransactionData(BC_TRANSACTION, flags, handle, code, *copy, nullptr);
+    }
+    if (err != NO_ERROR) {
+        return (mLastError = err);
+    }
+    mOnewayBatch.push_back(std::move(copy));
+
+    // bound the memory held by copies for very long bursts
+    constexpr size_t kMaxOnewayBatch = 64;
+    if (mOnewayBatch.size() >= kMaxOnewayBatch) {
+        sendOnewayBatch();
+    }
+    return NO_ERROR;
+}
+
+void IPCThreadState::sendOnewayBatch()
+{
+    // The first call writes all of the queued transactions, and the driver
+    // returns a BR_TRANSACTION_COMPLETE or an error for each of them.
+    for (size_t i = 0; i < mOnewayBatch.size(); i++) {
+        const status_t err = waitForResponse(nullptr, nullptr);
+        if (err == NO_ERROR) continue;
+
+        if (mOnewayBatchError == NO_ERROR) {
+            mOnewayBatchError = err;
+        }
+        if (err != DEAD_OBJECT && err != FAILED_TRANSACTION) {
+            // The driver itself failed, so the rest won't be answered, and
+            // mOut can't keep referring to the copies freed below.
+            mOut.setDataSize(0);
+            break;
+        }
+    }
+    mOnewayBatch.clear();
+}
+
 void IPCThreadState::incStrongHandle(int32_t handle, BpBinder *proxy)
 {
     LOG_REMOTEREFS("IPCThreadState::incStrongHandle(%d)\n", handle);
@@ -1028,6 +1114,8 @@ IPCThreadState::IPCThreadState()
         mPropagateWorkSource(false),
         mIsLooper(false),
         mIsFlushing(false),
+        mOnewayBatchDepth(0),
+        mOnewayBatchError(NO_ERROR),
         mStrictModePolicy(0),
         mLastTransactionBinderFlags(0),
         mCallRestriction(mProcess->mCallRestriction) {
@@ -1244,7 +1332,15 @@ status_t IPCThreadState::talkWithDriver(bool doReceive)
 
     if (err >= NO_ERROR) {
         if (bwr.write_consumed > 0) {
-            if (bwr.write_consumed < mOut.dataSize()) {
+            if (bwr.write_consumed < mOut.dataSize() && !mOnewayBatch.empty()) {
+                // A queued oneway transaction failed, and the driver stopped
+                // before the commands behind it. They are written again once
+                // its error has been read.
+                std::vector<uint8_t> remaining(mOut.data() + bwr.write_consumed,
+                                               mOut.data() + mOut.dataSize());
+                mOut.setDataSize(0);
+                mOut.write(remaining.data(), remaining.size());
+            } else if (bwr.write_consumed < mOut.dataSize()) {
                 std::ostringstream logStream;
                 printReturnCommandParcel(logStream, mIn);
                 LOG_ALWAYS_FATAL("Driver did not consume write buffer. "
@@ -1538,10 +1634,30 @@ status_t IPCThreadState::executeCommand(int32_t cmd)
 
     case BR_DEAD_BINDER:
         {
-            BpBinder *proxy = (BpBinder*)mIn.readPointer();
-            proxy->sendObituary();
-            mOut.writeInt32(BC_DEAD_BINDER_DONE);
-            mOut.writePointer((uintptr_t)proxy);
+            // When a process dies, the driver usually returns the BR_DEAD_BINDER of all the
+            // proxies linked to it back to back. Clear the death notifications of those already
+            // read with a single write, rather than one write per proxy, before notifying their
+            // recipients. BC_DEAD_BINDER_DONE has to wait for the recipients, because the driver
+            // then releases its weak reference on the proxy.
+            std::vector<BpBinder*> proxies{(BpBinder*)mIn.readPointer()};
+            while (mIn.dataAvail() >= sizeof(int32_t)) {
+                const size_t pos = mIn.dataPosition();
+                if (mIn.readInt32() != BR_DEAD_BINDER) {
+                    mIn.setDataPosition(pos);
+                    break;
+                }
+                proxies.push_back((BpBinder*)mIn.readPointer());
+            }
+            bool flush = false;
+            for (BpBinder* proxy : proxies) {
+                flush |= proxy->getPrivateAccessor().prepareObituary();
+            }
+            if (flush) flushCommands();
+            for (BpBinder* proxy : proxies) {
+                proxy->getPrivateAccessor().reportObituaries();
+                mOut.writeInt32(BC_DEAD_BINDER_DONE);
+                mOut.writePointer((uintptr_t)proxy);
+            }
         } break;
 
     case BR_CLEAR_DEATH_NOTIFICATION_DONE:
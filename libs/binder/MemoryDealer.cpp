@@ -24,6 +24,14 @@
 #include <utils/SortedVector.h>
 #include <utils/String8.h>
 
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <map>
+#include <mutex>
+#include <set>
+#include <vector>
+
 #include <stdint.h>
 #include <stdio.h>
 #include <stdlib.h>
@@ -121,10 +129,11 @@ private:
 
 class SimpleBestFitAllocator
 {
+public:
     enum {
         PAGE_ALIGNED = 0x00000001
     };
-public:
+
     explicit SimpleBestFitAllocator(size_t size);
     ~SimpleBestFitAllocator();
 
@@ -133,6 +142,7 @@ public:
     size_t      size() const;
     void        dump(const char* what) const;
     void        dump(String8& res, const char* what) const;
+    void        getStats(MemoryDealer::Stats* stats) const;
 
     static size_t getAllocationAlignment() { return kMemoryAlign; }
 
@@ -162,6 +172,53 @@ private:
 
 // ----------------------------------------------------------------------------
 
+/*
+ * Splits whole pages of a SimpleBestFitAllocator into blocks of a few fixed
+ * sizes. Freeing a block only takes the lock of its size class, and a page
+ * goes back to the SimpleBestFitAllocator once all its blocks are free.
+ */
+
+class SizeClassAllocator
+{
+public:
+    SizeClassAllocator(SimpleBestFitAllocator* pages, size_t heapSize);
+
+    // Returns NO_MEMORY if size doesn't fit a size class, or if there is no
+    // free page for a new slab.
+    ssize_t     allocate(size_t size);
+    // Returns false if offset isn't in a slab.
+    bool        deallocate(size_t offset);
+    void        dump(String8& res) const;
+    void        getStats(MemoryDealer::Stats* stats) const;
+
+private:
+    static constexpr std::array<size_t, 7> kBlockSizes = {32, 64, 128, 256, 512, 1024,
+                                                          MemoryDealer::kMaxSizeClassSize};
+
+    struct slab_t {
+        // indices of the free blocks of the page
+        std::vector<uint16_t> freeBlocks;
+    };
+
+    struct size_class_t {
+        mutable std::mutex lock;
+        size_t blockSize = 0;
+        size_t blocksPerSlab = 0;
+        size_t usedBlocks = 0;
+        // slabs by offset of their page, and the ones with free blocks
+        std::map<size_t, slab_t> slabs;
+        std::set<size_t> partialSlabs;
+    };
+
+    SimpleBestFitAllocator* const mPages;
+    const size_t mPageSize;
+    // 1 + index of the size class owning each page of the heap, or 0
+    std::vector<std::atomic<uint8_t>> mPageClass;
+    std::array<size_class_t, kBlockSizes.size()> mClasses;
+};
+
+// ----------------------------------------------------------------------------
+
 Allocation::Allocation(
         const sp<MemoryDealer>& dealer,
         const sp<IMemoryHeap>& heap, ssize_t offset, size_t size)
@@ -227,18 +284,30 @@ Allocation::~Allocation()
 // ----------------------------------------------------------------------------
 
 MemoryDealer::MemoryDealer(size_t size, const char* name, uint32_t flags)
+      : MemoryDealer(size, name, flags, Options()) {}
+
+MemoryDealer::MemoryDealer(size_t size, const char* name, uint32_t flags, const Options& options)
       : mHeap(sp<MemoryHeapBase>::make(size, flags, name)),
-        mAllocator(new SimpleBestFitAllocator(size)) {}
+        mAllocator(new SimpleBestFitAllocator(size)),
+        mSizeClasses(options.useSizeClasses ? new SizeClassAllocator(mAllocator, mAllocator->size())
+                                            : nullptr) {}
 
 MemoryDealer::~MemoryDealer()
 {
+    delete mSizeClasses;
     delete mAllocator;
 }
 
 sp<IMemory> MemoryDealer::allocate(size_t size)
 {
     sp<IMemory> memory;
-    const ssize_t offset = allocator()->allocate(size);
+    ssize_t offset = NO_MEMORY;
+    if (mSizeClasses != nullptr && size > 0) {
+        offset = mSizeClasses->allocate(size);
+    }
+    if (offset < 0) {
+        offset = allocator()->allocate(size);
+    }
     if (offset >= 0) {
         memory = sp<Allocation>::make(sp<MemoryDealer>::fromExisting(this), heap(), offset, size);
     }
@@ -247,12 +316,30 @@ sp<IMemory> MemoryDealer::allocate(size_t size)
 
 void MemoryDealer::deallocate(size_t offset)
 {
+    if (mSizeClasses != nullptr && mSizeClasses->deallocate(offset)) {
+        return;
+    }
     allocator()->deallocate(offset);
 }
 
 void MemoryDealer::dump(const char* what) const
 {
     allocator()->dump(what);
+    if (mSizeClasses != nullptr) {
+        String8 result;
+        mSizeClasses->dump(result);
+        ALOGD("%s", result.c_str());
+    }
+}
+
+MemoryDealer::Stats MemoryDealer::getStats() const
+{
+    Stats stats;
+    allocator()->getStats(&stats);
+    if (mSizeClasses != nullptr) {
+        mSizeClasses->getStats(&stats);
+    }
+    return stats;
 }
 
 const sp<IMemoryHeap>& MemoryDealer::heap() const {
@@ -477,5 +564,123 @@ void SimpleBestFitAllocator::dump_l(String8& result,
     result.append(buffer);
 }
 
+void SimpleBestFitAllocator::getStats(MemoryDealer::Stats* stats) const
+{
+    std::unique_lock<std::mutex> _l(mLock);
+    stats->heapSize = mHeapSize;
+    for (chunk_t const* cur = mList.head(); cur; cur = cur->next) {
+        const size_t size = cur->size * kMemoryAlign;
+        if (cur->free) {
+            stats->freeBytes += size;
+            stats->largestFreeRange = std::max(stats->largestFreeRange, size);
+            stats->freeRangeCount++;
+        } else {
+            stats->usedBytes += size;
+        }
+    }
+}
+
+// ----------------------------------------------------------------------------
+
+SizeClassAllocator::SizeClassAllocator(SimpleBestFitAllocator* pages, size_t heapSize)
+      : mPages(pages), mPageSize(getpagesize()), mPageClass(heapSize / mPageSize)
+{
+    for (size_t i = 0; i < kBlockSizes.size(); i++) {
+        mClasses[i].blockSize = kBlockSizes[i];
+        mClasses[i].blocksPerSlab = mPageSize / kBlockSizes[i];
+    }
+}
+
+ssize_t SizeClassAllocator::allocate(size_t size)
+{
+    const auto blockSize = std::lower_bound(kBlockSizes.begin(), kBlockSizes.end(), size);
+    if (blockSize == kBlockSizes.end()) {
+        return NO_MEMORY;
+    }
+    const size_t index = blockSize - kBlockSizes.begin();
+    size_class_t& sizeClass = mClasses[index];
+
+    std::unique_lock<std::mutex> _l(sizeClass.lock);
+    if (sizeClass.partialSlabs.empty()) {
+        const ssize_t page = mPages->allocate(mPageSize, SimpleBestFitAllocator::PAGE_ALIGNED);
+        if (page < 0) {
+            return NO_MEMORY;
+        }
+        slab_t& slab = sizeClass.slabs[page];
+        slab.freeBlocks.reserve(sizeClass.blocksPerSlab);
+        for (size_t i = sizeClass.blocksPerSlab; i > 0; i--) {
+            slab.freeBlocks.push_back(i - 1);
+        }
+        sizeClass.partialSlabs.insert(page);
+        mPageClass[page / mPageSize].store(static_cast<uint8_t>(index + 1),
+                                           std::memory_order_release);
+    }
+
+    // Fill the slabs at the lowest offsets first, so that the others can empty.
+    const size_t page = *sizeClass.partialSlabs.begin();
+    slab_t& slab = sizeClass.slabs[page];
+    const size_t block = slab.freeBlocks.back();
+    slab.freeBlocks.pop_back();
+    if (slab.freeBlocks.empty()) {
+        sizeClass.partialSlabs.erase(page);
+    }
+    sizeClass.usedBlocks++;
+    return page + block * sizeClass.blockSize;
+}
+
+bool SizeClassAllocator::deallocate(size_t offset)
+{
+    const size_t pageIndex = offset / mPageSize;
+    if (pageIndex >= mPageClass.size()) {
+        return false;
+    }
+    // A page can't change owner while one of its blocks is still allocated.
+    const uint8_t owner = mPageClass[pageIndex].load(std::memory_order_acquire);
+    if (owner == 0) {
+        return false;
+    }
+    size_class_t& sizeClass = mClasses[owner - 1];
+    const size_t page = pageIndex * mPageSize;
+
+    std::unique_lock<std::mutex> _l(sizeClass.lock);
+    auto slab = sizeClass.slabs.find(page);
+    LOG_ALWAYS_FATAL_IF(slab == sizeClass.slabs.end(), "no slab for block at offset 0x%08zX",
+                        offset);
+    slab->second.freeBlocks.push_back((offset - page) / sizeClass.blockSize);
+    sizeClass.usedBlocks--;
+    sizeClass.partialSlabs.insert(page);
+
+    // Keep the last slab of a class, so that the same page isn't taken and
+    // given back over and over.
+    if (slab->second.freeBlocks.size() == sizeClass.blocksPerSlab && sizeClass.slabs.size() > 1) {
+        sizeClass.partialSlabs.erase(page);
+        sizeClass.slabs.erase(slab);
+        mPageClass[pageIndex].store(0, std::memory_order_release);
+        mPages->deallocate(page);
+    }
+    return true;
+}
+
+void SizeClassAllocator::dump(String8& result) const
+{
+    result.append("  size classes:\n");
+    for (const size_class_t& sizeClass : mClasses) {
+        std::unique_lock<std::mutex> _l(sizeClass.lock);
+        if (sizeClass.slabs.empty()) continue;
+        result.appendFormat("  %5zu: %zu slabs, %zu/%zu blocks used\n", sizeClass.blockSize,
+                            sizeClass.slabs.size(), sizeClass.usedBlocks,
+                            sizeClass.slabs.size() * sizeClass.blocksPerSlab);
+    }
+}
+
+void SizeClassAllocator::getStats(MemoryDealer::Stats* stats) const
+{
+    for (const size_class_t& sizeClass : mClasses) {
+        std::unique_lock<std::mutex> _l(sizeClass.lock);
+        const size_t totalBlocks = sizeClass.slabs.size() * sizeClass.blocksPerSlab;
+        stats->sizeClassUsedBytes += sizeClass.usedBlocks * sizeClass.blockSize;
+        stats->sizeClassFreeBytes += (totalBlocks - sizeClass.usedBlocks) * sizeClass.blockSize;
+    }
+}
 
 } // namespace android
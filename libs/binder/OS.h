@@ -44,6 +44,15 @@ LIBBINDER_INTERNAL_EXPORTED ssize_t
 receiveMessageFromSocket(const RpcTransportFd& socket, iovec* iovs, int niovs,
                          std::vector<std::variant<unique_fd, borrowed_fd>>* ancillaryFds);
 
+// Copies |size| bytes into a new memory FD, sealed so that neither side can change them
+// afterwards. Used to hand large payloads to the peer without copying them through the socket.
+status_t createSealedBlob(const void* data, size_t size, unique_fd* outFd);
+
+// Maps a blob from createSealedBlob read-only, after checking that it is sealed and holds at
+// least |size| bytes. Release with unmapSealedBlob.
+status_t mapSealedBlob(borrowed_fd fd, size_t size, const uint8_t** outData);
+void unmapSealedBlob(const uint8_t* data, size_t size);
+
 uint64_t GetThreadId();
 
 bool report_sysprop_change();
@@ -19,11 +19,15 @@
 #include "file.h"
 
 #include <binder/RpcTransportRaw.h>
+#include <fcntl.h>
 #include <log/log.h>
 #include <string.h>
+#include <sys/mman.h>
 #include <sys/socket.h>
+#include <sys/stat.h>
 
 using android::binder::ReadFully;
+using android::binder::WriteFully;
 
 namespace android::binder::os {
 
@@ -65,6 +69,60 @@ status_t dupFileDescriptor(int oldFd, int* newFd) {
     return OK;
 }
 
+#if defined(__linux__)
+status_t createSealedBlob(const void* data, size_t size, unique_fd* outFd) {
+    unique_fd fd(memfd_create("RpcBlob", MFD_CLOEXEC | MFD_ALLOW_SEALING));
+    if (!fd.ok()) {
+        return -errno;
+    }
+    // Written rather than mapped, because F_SEAL_WRITE can't be applied while a writable
+    // mapping exists.
+    if (!WriteFully(fd, data, size)) {
+        return -errno;
+    }
+    if (fcntl(fd.get(), F_ADD_SEALS,
+              F_SEAL_SHRINK | F_SEAL_GROW | F_SEAL_WRITE | F_SEAL_SEAL) != 0) {
+        return -errno;
+    }
+    *outFd = std::move(fd);
+    return OK;
+}
+
+status_t mapSealedBlob(borrowed_fd fd, size_t size, const uint8_t** outData) {
+    constexpr int kRequiredSeals = F_SEAL_SHRINK | F_SEAL_WRITE;
+    int seals = fcntl(fd.get(), F_GET_SEALS);
+    if (seals < 0 || (seals & kRequiredSeals) != kRequiredSeals) {
+        ALOGE("Blob FD %d is not sealed", fd.get());
+        return BAD_VALUE;
+    }
+    struct stat st;
+    if (fstat(fd.get(), &st) != 0 || static_cast<size_t>(st.st_size) < size) {
+        ALOGE("Blob FD %d is smaller than %zu bytes", fd.get(), size);
+        return BAD_VALUE;
+    }
+    void* mapping = mmap(nullptr, size, PROT_READ, MAP_SHARED, fd.get(), 0);
+    if (mapping == MAP_FAILED) {
+        return -errno;
+    }
+    *outData = static_cast<const uint8_t*>(mapping);
+    return OK;
+}
+
+void unmapSealedBlob(const uint8_t* data, size_t size) {
+    munmap(const_cast<uint8_t*>(data), size);
+}
+#else
+status_t createSealedBlob(const void*, size_t, unique_fd*) {
+    return INVALID_OPERATION;
+}
+
+status_t mapSealedBlob(borrowed_fd, size_t, const uint8_t**) {
+    return INVALID_OPERATION;
+}
+
+void unmapSealedBlob(const uint8_t*, size_t) {}
+#endif // __linux__
+
 std::unique_ptr<RpcTransportCtxFactory> makeDefaultRpcTransportCtxFactory() {
     return RpcTransportCtxFactoryRaw::make();
 }
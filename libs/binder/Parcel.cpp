@@ -1244,7 +1244,9 @@ restart_write:
 status_t Parcel::writeUtf8AsUtf16(const std::string& str) {
     const uint8_t* strData = (uint8_t*)str.data();
     const size_t strLen= str.length();
-    const ssize_t utf16Len = utf8_to_utf16_length(strData, strLen);
+    const bool ascii = isAscii(str.data(), strLen);
+    const ssize_t utf16Len = ascii ? static_cast<ssize_t>(strLen)
+                                   : utf8_to_utf16_length(strData, strLen);
     if (utf16Len < 0 || utf16Len > std::numeric_limits<int32_t>::max()) {
         return BAD_VALUE;
     }
@@ -1260,7 +1262,12 @@ status_t Parcel::writeUtf8AsUtf16(const std::string& str) {
         return NO_MEMORY;
     }
 
-    utf8_to_utf16(strData, strLen, (char16_t*)dst, (size_t) utf16Len + 1);
+    if (ascii) {
+        asciiToUtf16(str.data(), strLen, (char16_t*)dst);
+        ((char16_t*)dst)[strLen] = 0;
+    } else {
+        utf8_to_utf16(strData, strLen, (char16_t*)dst, (size_t) utf16Len + 1);
+    }
 
     return NO_ERROR;
 }
@@ -2222,6 +2229,12 @@ status_t Parcel::readUtf8FromUtf16(std::string* str) const {
        return NO_ERROR;
     }
 
+    if (isAscii(src, utf16Size)) {
+        str->resize(utf16Size);
+        asciiToUtf8(src, utf16Size, str->data());
+        return NO_ERROR;
+    }
+
     // Allow for closing '\0'
     ssize_t utf8Size = utf16_to_utf8_length(src, utf16Size) + 1;
     if (utf8Size < 1) {
@@ -2945,8 +2958,10 @@ void Parcel::freeDataNoInit()
             gParcelGlobalAllocCount--;
             if (mDeallocZero) {
                 zeroMemory(mData, mDataSize);
+                free(mData);
+            } else {
+                freeDataBuffer(mData, mDataCapacity);
             }
-            free(mData);
         }
         auto* kernelFields = maybeKernelFields();
         if (kernelFields && kernelFields->mObjects) free(kernelFields->mObjects);
@@ -2977,6 +2992,72 @@ status_t Parcel::growData(size_t len)
             : continueWrite(std::max(newSize, (size_t) 128));
 }
 
+#ifndef BINDER_RPC_SINGLE_THREADED
+// Most Parcels are small and short-lived, one or two per transaction, so data
+// buffers up to this size are all allocated with this capacity, and a few are
+// kept per thread once freed, to be reused by the next Parcel.
+static constexpr size_t kPooledDataCapacity = 256;
+static constexpr size_t kMaxPooledDataBuffers = 4;
+
+namespace {
+// Trivially destructible, so that it can still be used by Parcels destroyed
+// after the closer below, e.g. from pthread key destructors on thread exit.
+struct DataBufferPool {
+    uint8_t* buffers[kMaxPooledDataBuffers];
+    size_t count;
+    bool closed;
+};
+thread_local DataBufferPool tDataBufferPool;
+
+struct DataBufferPoolCloser {
+    ~DataBufferPoolCloser() {
+        while (tDataBufferPool.count > 0) {
+            free(tDataBufferPool.buffers[--tDataBufferPool.count]);
+        }
+        tDataBufferPool.closed = true;
+    }
+};
+
+// Returns whether buffers can still be added to this thread's pool. The closer
+// is registered early, when the thread first allocates a pooled buffer, so that
+// it runs on thread exit even if the thread's last Parcels are freed late.
+bool openDataBufferPool() {
+    thread_local DataBufferPoolCloser closer;
+    (void)closer;
+    return !tDataBufferPool.closed;
+}
+} // namespace
+#endif // BINDER_RPC_SINGLE_THREADED
+
+// Allocates a data buffer of at least `desired` bytes, returning its actual
+// capacity in `capacity`.
+static uint8_t* allocDataBuffer(size_t desired, size_t* capacity) {
+#ifndef BINDER_RPC_SINGLE_THREADED
+    if (desired <= kPooledDataCapacity) {
+        *capacity = kPooledDataCapacity;
+        if (openDataBufferPool() && tDataBufferPool.count > 0) {
+            return tDataBufferPool.buffers[--tDataBufferPool.count];
+        }
+        return (uint8_t*)malloc(kPooledDataCapacity);
+    }
+#endif // BINDER_RPC_SINGLE_THREADED
+    *capacity = desired;
+    return (uint8_t*)malloc(desired);
+}
+
+static void freeDataBuffer(uint8_t* data, size_t capacity) {
+#ifndef BINDER_RPC_SINGLE_THREADED
+    if (capacity == kPooledDataCapacity && tDataBufferPool.count < kMaxPooledDataBuffers &&
+        openDataBufferPool()) {
+        tDataBufferPool.buffers[tDataBufferPool.count++] = data;
+        return;
+    }
+#else
+    (void)capacity;
+#endif // BINDER_RPC_SINGLE_THREADED
+    free(data);
+}
+
 static uint8_t* reallocZeroFree(uint8_t* data, size_t oldCapacity, size_t newCapacity, bool zero) {
     if (!zero) {
         return (uint8_t*)realloc(data, newCapacity);
@@ -3255,7 +3336,8 @@ status_t Parcel::continueWrite(size_t desired)
 
     } else {
         // This is the first data.  Easy!
-        uint8_t* data = (uint8_t*)malloc(desired);
+        size_t capacity;
+        uint8_t* data = allocDataBuffer(desired, &capacity);
         if (!data) {
             mError = NO_MEMORY;
             return NO_MEMORY;
@@ -3269,15 +3351,15 @@ status_t Parcel::continueWrite(size_t desired)
                   kernelFields ? kernelFields->mObjectsCapacity : 0, desired);
         }
 
-        LOG_ALLOC("Parcel %p: allocating with %zu capacity", this, desired);
-        gParcelGlobalAllocSize += desired;
+        LOG_ALLOC("Parcel %p: allocating with %zu capacity", this, capacity);
+        gParcelGlobalAllocSize += capacity;
         gParcelGlobalAllocCount++;
 
         mData = data;
         mDataSize = mDataPos = 0;
         ALOGV("continueWrite Setting data size of %p to %zu", this, mDataSize);
         ALOGV("continueWrite Setting data pos of %p to %zu", this, mDataPos);
-        mDataCapacity = desired;
+        mDataCapacity = capacity;
     }
 
     return NO_ERROR;
@@ -58,6 +58,14 @@ bool getValue(const android::String16& key, T* out, const map<android::String16,
     return true;
 }
 
+// Returns the value for a key read from a parcel, inserting it if needed. writeToParcelInner()
+// writes the keys of each type in order, so hinting at the end of the map makes inserting the keys
+// of a natively written bundle constant time, rather than searching the map for each of them.
+template <typename T>
+T* valueForParcelKey(android::String16&& key, map<android::String16, T>* map) {
+    return &map->emplace_hint(map->end(), std::move(key), T())->second;
+}
+
 template <typename T>
 set<android::String16> getKeys(const map<android::String16, T>& map) {
     if (map.empty()) return set<android::String16>();
@@ -423,47 +431,56 @@ status_t PersistableBundle::readFromParcelInner(const Parcel* parcel, size_t len
          */
         switch (value_type) {
             case VAL_STRING: {
-                RETURN_IF_FAILED(parcel->readString16(&mStringMap[key]));
+                RETURN_IF_FAILED(parcel->readString16(
+                        valueForParcelKey(std::move(key), &mStringMap)));
                 break;
             }
             case VAL_INTEGER: {
-                RETURN_IF_FAILED(parcel->readInt32(&mIntMap[key]));
+                RETURN_IF_FAILED(parcel->readInt32(valueForParcelKey(std::move(key), &mIntMap)));
                 break;
             }
             case VAL_LONG: {
-                RETURN_IF_FAILED(parcel->readInt64(&mLongMap[key]));
+                RETURN_IF_FAILED(parcel->readInt64(valueForParcelKey(std::move(key), &mLongMap)));
                 break;
             }
             case VAL_DOUBLE: {
-                RETURN_IF_FAILED(parcel->readDouble(&mDoubleMap[key]));
+                RETURN_IF_FAILED(parcel->readDouble(
+                        valueForParcelKey(std::move(key), &mDoubleMap)));
                 break;
             }
             case VAL_BOOLEAN: {
-                RETURN_IF_FAILED(parcel->readBool(&mBoolMap[key]));
+                RETURN_IF_FAILED(parcel->readBool(valueForParcelKey(std::move(key), &mBoolMap)));
                 break;
             }
             case VAL_STRINGARRAY: {
-                RETURN_IF_FAILED(parcel->readString16Vector(&mStringVectorMap[key]));
+                RETURN_IF_FAILED(parcel->readString16Vector(
+                        valueForParcelKey(std::move(key), &mStringVectorMap)));
                 break;
             }
             case VAL_INTARRAY: {
-                RETURN_IF_FAILED(parcel->readInt32Vector(&mIntVectorMap[key]));
+                RETURN_IF_FAILED(parcel->readInt32Vector(
+                        valueForParcelKey(std::move(key), &mIntVectorMap)));
                 break;
             }
             case VAL_LONGARRAY: {
-                RETURN_IF_FAILED(parcel->readInt64Vector(&mLongVectorMap[key]));
+                RETURN_IF_FAILED(parcel->readInt64Vector(
+                        valueForParcelKey(std::move(key), &mLongVectorMap)));
                 break;
             }
             case VAL_BOOLEANARRAY: {
-                RETURN_IF_FAILED(parcel->readBoolVector(&mBoolVectorMap[key]));
+                RETURN_IF_FAILED(parcel->readBoolVector(
+                        valueForParcelKey(std::move(key), &mBoolVectorMap)));
                 break;
             }
             case VAL_PERSISTABLEBUNDLE: {
-                RETURN_IF_FAILED(mPersistableBundleMap[key].readFromParcel(parcel));
+                PersistableBundle* value =
+                        valueForParcelKey(std::move(key), &mPersistableBundleMap);
+                RETURN_IF_FAILED(value->readFromParcel(parcel));
                 break;
             }
             case VAL_DOUBLEARRAY: {
-                RETURN_IF_FAILED(parcel->readDoubleVector(&mDoubleVectorMap[key]));
+                RETURN_IF_FAILED(parcel->readDoubleVector(
+                        valueForParcelKey(std::move(key), &mDoubleVectorMap)));
                 break;
             }
             default: {
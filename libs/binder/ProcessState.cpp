@@ -310,17 +310,24 @@ void ProcessState::setCallRestriction(CallRestriction restriction) {
     mCallRestriction = restriction;
 }
 
-ProcessState::handle_entry* ProcessState::lookupHandleLocked(int32_t handle)
+ProcessState::HandleTableShard& ProcessState::handleTableShard(int32_t handle)
 {
-    const size_t N=mHandleToObject.size();
-    if (N <= (size_t)handle) {
+    return mHandleToObject[(uint32_t)handle % kHandleTableShards];
+}
+
+ProcessState::handle_entry* ProcessState::lookupHandleLocked(HandleTableShard& shard,
+                                                             int32_t handle)
+{
+    const size_t index = (uint32_t)handle / kHandleTableShards;
+    const size_t N=shard.entries.size();
+    if (N <= index) {
         handle_entry e;
         e.binder = nullptr;
         e.refs = nullptr;
-        status_t err = mHandleToObject.insertAt(e, N, handle+1-N);
+        status_t err = shard.entries.insertAt(e, N, index+1-N);
         if (err < NO_ERROR) return nullptr;
     }
-    return &mHandleToObject.editItemAt(handle);
+    return &shard.entries.editItemAt(index);
 }
 
 // see b/166779391: cannot change the VNDK interface, so access like this
@@ -331,11 +338,12 @@ sp<IBinder> ProcessState::getStrongProxyForHandle(int32_t handle)
     sp<IBinder> result;
     std::function<void()> postTask;
 
-    std::unique_lock<std::mutex> _l(mLock);
+    HandleTableShard& shard = handleTableShard(handle);
+    std::unique_lock<std::mutex> _l(shard.lock);
 
     if (handle == 0 && the_context_object != nullptr) return the_context_object;
 
-    handle_entry* e = lookupHandleLocked(handle);
+    handle_entry* e = lookupHandleLocked(shard, handle);
 
     if (e != nullptr) {
         // We need to create a new BpBinder if there isn't currently one, OR we
@@ -399,9 +407,10 @@ sp<IBinder> ProcessState::getStrongProxyForHandle(int32_t handle)
 
 void ProcessState::expungeHandle(int32_t handle, IBinder* binder)
 {
-    std::unique_lock<std::mutex> _l(mLock);
+    HandleTableShard& shard = handleTableShard(handle);
+    std::unique_lock<std::mutex> _l(shard.lock);
 
-    handle_entry* e = lookupHandleLocked(handle);
+    handle_entry* e = lookupHandleLocked(shard, handle);
 
     // This handle may have already been replaced with a new BpBinder
     // (if someone failed the AttemptIncWeak() above); we don't want
@@ -497,6 +506,18 @@ size_t ProcessState::getThreadPoolMaxTotalThreadCount() const {
     return mCurrentThreads;
 }
 
+ProcessState::ThreadPoolStats ProcessState::getThreadPoolStats() const {
+    return ThreadPoolStats{
+            .maxThreads = mMaxThreads,
+            .currentThreads = mCurrentThreads,
+            .kernelStartedThreads = mKernelStartedThreads,
+            .executingThreads = mExecutingThreadsCount,
+            .peakExecutingThreads = mPeakExecutingThreadsCount,
+            .saturationCount = mStarvationCount,
+            .totalSaturationTime = std::chrono::nanoseconds(mTotalStarvationNs),
+    };
+}
+
 bool ProcessState::isThreadPoolStarted() const {
     return mThreadPoolStarted;
 }
@@ -579,6 +600,9 @@ ProcessState::ProcessState(const char* driver)
         mCurrentThreads(0),
         mKernelStartedThreads(0),
         mStarvationStartTime(never()),
+        mPeakExecutingThreadsCount(0),
+        mStarvationCount(0),
+        mTotalStarvationNs(0),
         mForked(false),
         mThreadPoolStarted(false),
         mThreadPoolSeq(1),
@@ -102,6 +102,18 @@ size_t RpcSession::getMaxOutgoingThreads() {
     return mMaxOutgoingConnections;
 }
 
+void RpcSession::setMaxAsyncConnections(size_t connections) {
+    RpcMutexLockGuard _l(mMutex);
+    LOG_ALWAYS_FATAL_IF(mStartedSetup,
+                        "Must set max async connections before setting up connections");
+    mMaxAsyncConnections = connections;
+}
+
+size_t RpcSession::getMaxAsyncConnections() {
+    RpcMutexLockGuard _l(mMutex);
+    return mMaxAsyncConnections;
+}
+
 bool RpcSession::setProtocolVersionInternal(uint32_t version, bool checkStarted) {
     if (!RpcState::validateProtocolVersion(version)) {
         return false;
@@ -429,6 +441,13 @@ void RpcSession::join(sp<RpcSession>&& session, PreJoinSetupResult&& setupResult
     if (setupResult.status == OK) {
         LOG_ALWAYS_FATAL_IF(!connection, "must have connection if setup succeeded");
         [[maybe_unused]] JavaThreadAttacher javaThreadAttacher;
+        // Each incoming connection keeps a thread parked here, even while it is
+        // idle. This can't be replaced by a shared event loop (io_uring, epoll)
+        // without changing the threading contract: a nested transaction must be
+        // handled by the thread which is blocked in the outer call on the other
+        // side, and that thread may block for an arbitrary amount of time while
+        // executing a command. To bound the cost of many clients, limit the
+        // number of threads per session with RpcServer::setMaxThreads.
         while (true) {
             status_t status = session->state()->getAndExecuteCommand(connection, session,
                                                                      RpcState::CommandType::ANY);
@@ -898,11 +917,26 @@ status_t RpcSession::ExclusiveConnection::find(const sp<RpcSession>& session, Co
         sp<RpcConnection> exclusive;
         sp<RpcConnection> available;
 
+        // The last mMaxAsyncConnections outgoing connections are reserved for
+        // oneway transactions, as long as at least one is left for everything
+        // else, so that synchronous calls never wait behind a burst of them.
+        const size_t numOutgoing = session->mConnections.mOutgoing.size();
+        size_t availableBegin = 0;
+        size_t availableEnd = numOutgoing;
+        if (session->mMaxAsyncConnections > 0 && numOutgoing > session->mMaxAsyncConnections) {
+            const size_t asyncBegin = numOutgoing - session->mMaxAsyncConnections;
+            if (use == ConnectionUse::CLIENT_ASYNC) {
+                availableBegin = asyncBegin;
+            } else {
+                availableEnd = asyncBegin;
+            }
+        }
+
         // CHECK FOR DEDICATED CLIENT SOCKET
         //
         // A server/looper should always use a dedicated connection if available
         findConnection(tid, &exclusive, &available, session->mConnections.mOutgoing,
-                       session->mConnections.mOutgoingOffset);
+                       session->mConnections.mOutgoingOffset, availableBegin, availableEnd);
 
         // WARNING: this assumes a server cannot request its client to send
         // a transaction, as mIncoming is excluded below.
@@ -924,7 +958,8 @@ status_t RpcSession::ExclusiveConnection::find(const sp<RpcSession>& session, Co
             sp<RpcConnection> exclusiveIncoming;
             // server connections are always assigned to a thread
             findConnection(tid, &exclusiveIncoming, nullptr /*available*/,
-                           session->mConnections.mIncoming, 0 /* index hint */);
+                           session->mConnections.mIncoming, 0 /* index hint */, 0,
+                           session->mConnections.mIncoming.size());
 
             // asynchronous calls cannot be nested, we currently allow ref count
             // calls to be nested (so that you can use this without having extra
@@ -981,17 +1016,20 @@ status_t RpcSession::ExclusiveConnection::find(const sp<RpcSession>& session, Co
 void RpcSession::ExclusiveConnection::findConnection(uint64_t tid, sp<RpcConnection>* exclusive,
                                                      sp<RpcConnection>* available,
                                                      std::vector<sp<RpcConnection>>& sockets,
-                                                     size_t socketsIndexHint) {
+                                                     size_t socketsIndexHint,
+                                                     size_t availableBegin, size_t availableEnd) {
     LOG_ALWAYS_FATAL_IF(sockets.size() > 0 && socketsIndexHint >= sockets.size(),
                         "Bad index %zu >= %zu", socketsIndexHint, sockets.size());
 
     if (*exclusive != nullptr) return; // consistent with break below
 
     for (size_t i = 0; i < sockets.size(); i++) {
-        sp<RpcConnection>& socket = sockets[(i + socketsIndexHint) % sockets.size()];
+        const size_t index = (i + socketsIndexHint) % sockets.size();
+        sp<RpcConnection>& socket = sockets[index];
 
         // take first available connection (intuition = caching)
-        if (available && *available == nullptr && socket->exclusiveTid == std::nullopt) {
+        if (available && *available == nullptr && socket->exclusiveTid == std::nullopt &&
+            index >= availableBegin && index < availableEnd) {
             *available = socket;
             continue;
         }
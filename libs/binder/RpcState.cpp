@@ -24,6 +24,7 @@
 #include <binder/RpcServer.h>
 
 #include "Debug.h"
+#include "OS.h"
 #include "RpcWireFormat.h"
 #include "Utils.h"
 
@@ -66,6 +67,40 @@ static bool enableAncillaryFds(RpcSession::FileDescriptorTransportMode mode) {
     LOG_ALWAYS_FATAL("Invalid FileDescriptorTransportMode: %d", static_cast<int>(mode));
 }
 
+// Below this, copying Parcel data through the socket is cheaper than creating and mapping a memory
+// FD for it.
+constexpr size_t kOutOfLineDataThreshold = 256 * 1024;
+
+static bool shouldSendOutOfLine(const sp<RpcSession>& session, size_t dataSize,
+                                const std::vector<std::variant<unique_fd, borrowed_fd>>* fds) {
+    // Linux kernel supports up to 253 (from SCM_MAX_FD) for unix sockets, and the blob needs one.
+    constexpr size_t kMaxFdsPerMsg = 253;
+    return dataSize >= kOutOfLineDataThreshold &&
+            session->getProtocolVersion().value() >=
+            RPC_WIRE_PROTOCOL_VERSION_RPC_HEADER_FEATURE_OUT_OF_LINE_DATA &&
+            session->getFileDescriptorTransportMode() ==
+            RpcSession::FileDescriptorTransportMode::UNIX &&
+            (fds == nullptr || fds->size() < kMaxFdsPerMsg);
+}
+
+// Takes the out of line data FD, which is always sent last, and maps it.
+static status_t mapOutOfLineData(size_t size,
+                                 std::vector<std::variant<unique_fd, borrowed_fd>>* ancillaryFds,
+                                 const uint8_t** outData) {
+    if (size == 0 || ancillaryFds->empty()) {
+        ALOGE("Out of line data of %zu bytes without a file descriptor", size);
+        return BAD_VALUE;
+    }
+    auto* fd = std::get_if<unique_fd>(&ancillaryFds->back());
+    if (fd == nullptr) {
+        ALOGE("Out of line data file descriptor is not owned");
+        return BAD_VALUE;
+    }
+    unique_fd blob = std::move(*fd);
+    ancillaryFds->pop_back();
+    return binder::os::mapSealedBlob(blob, size, outData);
+}
+
 RpcState::RpcState() {}
 RpcState::~RpcState() {}
 
@@ -568,8 +603,27 @@ status_t RpcState::transactAddress(const sp<RpcSession::RpcConnection>& connecti
     Span<const uint32_t> objectTableSpan = Span<const uint32_t>{rpcFields->mObjectPositions.data(),
                                                                 rpcFields->mObjectPositions.size()};
 
+    // Large Parcel data goes in a sealed memory FD, so that it isn't copied through the socket.
+    // The receiver maps it instead of reading it.
+    const std::vector<std::variant<unique_fd, borrowed_fd>>* ancillaryFds = rpcFields->mFds.get();
+    std::vector<std::variant<unique_fd, borrowed_fd>> fdsWithOutOfLineData;
+    unique_fd outOfLineData;
+    if (shouldSendOutOfLine(session, data.dataSize(), ancillaryFds) &&
+        binder::os::createSealedBlob(data.data(), data.dataSize(), &outOfLineData) == OK) {
+        if (ancillaryFds != nullptr) {
+            fdsWithOutOfLineData.reserve(ancillaryFds->size() + 1);
+            for (const auto& fd : *ancillaryFds) {
+                fdsWithOutOfLineData.emplace_back(
+                        std::visit([](const auto& fd) { return borrowed_fd(fd.get()); }, fd));
+            }
+        }
+        fdsWithOutOfLineData.emplace_back(borrowed_fd(outOfLineData.get()));
+        ancillaryFds = &fdsWithOutOfLineData;
+    }
+    const size_t inlineDataSize = outOfLineData.ok() ? 0 : data.dataSize();
+
     uint32_t bodySize;
-    LOG_ALWAYS_FATAL_IF(__builtin_add_overflow(sizeof(RpcWireTransaction), data.dataSize(),
+    LOG_ALWAYS_FATAL_IF(__builtin_add_overflow(sizeof(RpcWireTransaction), inlineDataSize,
                                                &bodySize) ||
                                 __builtin_add_overflow(objectTableSpan.byteSize(), bodySize,
                                                        &bodySize),
@@ -586,6 +640,7 @@ status_t RpcState::transactAddress(const sp<RpcSession::RpcConnection>& connecti
             .asyncNumber = asyncNumber,
             // bodySize didn't overflow => this cast is safe
             .parcelDataSize = static_cast<uint32_t>(data.dataSize()),
+            .options = outOfLineData.ok() ? RPC_WIRE_TRANSACTION_OPTION_OUT_OF_LINE_DATA : 0,
     };
 
     // Oneway calls have no sync point, so if many are sent before, whether this
@@ -598,7 +653,7 @@ status_t RpcState::transactAddress(const sp<RpcSession::RpcConnection>& connecti
     iovec iovs[]{
             {&command, sizeof(RpcWireHeader)},
             {&transaction, sizeof(RpcWireTransaction)},
-            {const_cast<uint8_t*>(data.data()), data.dataSize()},
+            {const_cast<uint8_t*>(data.data()), inlineDataSize},
             objectTableSpan.toIovec(),
     };
     auto altPoll = [&] {
@@ -618,7 +673,7 @@ status_t RpcState::transactAddress(const sp<RpcSession::RpcConnection>& connecti
         return drainCommands(connection, session, CommandType::CONTROL_ONLY);
     };
     if (status_t status = rpcSend(connection, session, "transaction", iovs, countof(iovs),
-                                  std::ref(altPoll), rpcFields->mFds.get());
+                                  std::ref(altPoll), ancillaryFds);
         status != OK) {
         // rpcSend calls shutdownAndWait, so all refcounts should be reset. If we ever tolerate
         // errors here, then we may need to undo the binder-sent counts for the transaction as
@@ -956,8 +1011,39 @@ processTransactInternalTailCall:
                                           transactionData.size() -
                                                   offsetof(RpcWireTransaction, data)};
         Span<const uint32_t> objectTableSpan;
+
+        const uint8_t* outOfLineData = nullptr;
+        auto unmapOutOfLineData = make_scope_guard([&]() {
+            if (outOfLineData != nullptr) {
+                binder::os::unmapSealedBlob(outOfLineData, transaction->parcelDataSize);
+            }
+        });
         if (session->getProtocolVersion().value() >=
-            RPC_WIRE_PROTOCOL_VERSION_RPC_HEADER_FEATURE_EXPLICIT_PARCEL_SIZE) {
+                    RPC_WIRE_PROTOCOL_VERSION_RPC_HEADER_FEATURE_OUT_OF_LINE_DATA &&
+            (transaction->options & RPC_WIRE_TRANSACTION_OPTION_OUT_OF_LINE_DATA)) {
+            if (status_t status =
+                        mapOutOfLineData(transaction->parcelDataSize, &ancillaryFds,
+                                         &outOfLineData);
+                status != OK) {
+                ALOGE("Failed to map out of line Parcel data: %s. Terminating!",
+                      statusToString(status).c_str());
+                (void)session->shutdownAndWait(false);
+                return BAD_VALUE;
+            }
+            // Only the object table is left in the transaction body.
+            std::optional<Span<const uint32_t>> maybeSpan =
+                    parcelSpan.reinterpret<const uint32_t>();
+            if (!maybeSpan.has_value()) {
+                ALOGE("Bad object table size for out of line RpcWireTransaction: %zu. "
+                      "Terminating!",
+                      parcelSpan.byteSize());
+                (void)session->shutdownAndWait(false);
+                return BAD_VALUE;
+            }
+            objectTableSpan = *maybeSpan;
+            parcelSpan = {outOfLineData, transaction->parcelDataSize};
+        } else if (session->getProtocolVersion().value() >=
+                   RPC_WIRE_PROTOCOL_VERSION_RPC_HEADER_FEATURE_EXPLICIT_PARCEL_SIZE) {
             std::optional<Span<const uint8_t>> objectTableBytes =
                     parcelSpan.splitOff(transaction->parcelDataSize);
             if (!objectTableBytes.has_value()) {
@@ -0,0 +1,580 @@
+/*
+ * Copyright (C) 2024 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#define LOG_TAG "RpcShmTransport"
+#include <log/log.h>
+
+#include <fcntl.h>
+#include <poll.h>
+#include <stddef.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
+
+#include <algorithm>
+#include <atomic>
+#include <deque>
+
+#include <binder/RpcTransportShm.h>
+
+#include "FdTrigger.h"
+#include "OS.h"
+#include "RpcState.h"
+#include "RpcTransportUtils.h"
+
+namespace android {
+
+using namespace android::binder::impl;
+using android::binder::borrowed_fd;
+using android::binder::unique_fd;
+
+namespace {
+
+constexpr uint32_t kHelloMagic = 0x4d485352; // "RSHM"
+constexpr size_t kMinRingSize = 4 * 1024;
+constexpr size_t kMaxRingSize = 64 * 1024 * 1024;
+// Same as the limit on FDs per message in OS_unix_base.cpp.
+constexpr uint32_t kMaxFdsPerRecord = 253;
+// How often to re-check a ring before going to sleep on the socket. Spinning briefly avoids a
+// doorbell round trip when the peer is about to respond anyway.
+constexpr int kSpinCount = 64;
+
+// Sent by each side right after connecting. A ringSize of 0 means the sender can't use shared
+// memory on this connection, in which case both sides fall back to the raw socket.
+struct Hello {
+    uint32_t magic;
+    uint32_t ringSize;
+};
+
+// Lives at the start of each ring's shared memory. Both processes map it, so the positions are
+// only ever compared against values the reading side tracks itself.
+struct RingHeader {
+    // Total bytes written, advanced by the writer.
+    alignas(64) std::atomic<uint64_t> head;
+    // Total bytes read, advanced by the reader.
+    alignas(64) std::atomic<uint64_t> tail;
+    // Set by a side which is about to sleep on the socket until the other one rings the doorbell.
+    alignas(64) std::atomic<uint32_t> readerWaiting;
+    std::atomic<uint32_t> writerWaiting;
+};
+static_assert(std::atomic<uint64_t>::is_always_lock_free);
+static_assert(std::atomic<uint32_t>::is_always_lock_free);
+
+constexpr size_t kRingDataOffset = (sizeof(RingHeader) + 63) & ~size_t{63};
+
+// Precedes the bytes of every interruptableWriteFully call in the ring, so that the reader knows
+// how many FDs, sent separately over the socket, go along with them.
+struct RecordHeader {
+    uint32_t size;
+    uint32_t fdCount;
+};
+
+bool isValidRingSize(size_t size) {
+    return size >= kMinRingSize && size <= kMaxRingSize && (size & (size - 1)) == 0;
+}
+
+class Ring {
+public:
+    Ring() = default;
+    Ring(const Ring&) = delete;
+    Ring& operator=(const Ring&) = delete;
+    ~Ring() {
+        if (mMapping != nullptr) munmap(mMapping, kRingDataOffset + mSize);
+    }
+
+    // Creates a new, sealed ring and returns the FD to share with the peer.
+    status_t create(size_t size, unique_fd* outFd) {
+        unique_fd fd(memfd_create("RpcTransportShm", MFD_CLOEXEC | MFD_ALLOW_SEALING));
+        if (!fd.ok()) {
+            int savedErrno = errno;
+            ALOGW("memfd_create: %s", strerror(savedErrno));
+            return -savedErrno;
+        }
+        if (ftruncate(fd.get(), static_cast<off_t>(kRingDataOffset + size)) != 0 ||
+            fcntl(fd.get(), F_ADD_SEALS, F_SEAL_SHRINK | F_SEAL_GROW | F_SEAL_SEAL) != 0) {
+            int savedErrno = errno;
+            ALOGW("Failed to size memfd: %s", strerror(savedErrno));
+            return -savedErrno;
+        }
+        if (status_t status = map(fd, size); status != OK) return status;
+        *outFd = std::move(fd);
+        return OK;
+    }
+
+    // Maps a ring created by the peer, after checking that it can't be resized under us.
+    status_t attach(const unique_fd& fd, size_t size) {
+        int seals = fcntl(fd.get(), F_GET_SEALS);
+        constexpr int kRequiredSeals = F_SEAL_SHRINK | F_SEAL_GROW;
+        if (seals < 0 || (seals & kRequiredSeals) != kRequiredSeals) {
+            ALOGE("Peer ring is not sealed");
+            return BAD_VALUE;
+        }
+        struct stat st;
+        if (fstat(fd.get(), &st) != 0 ||
+            static_cast<size_t>(st.st_size) != kRingDataOffset + size) {
+            ALOGE("Peer ring has an unexpected size");
+            return BAD_VALUE;
+        }
+        return map(fd, size);
+    }
+
+    RingHeader& header() const { return *reinterpret_cast<RingHeader*>(mMapping); }
+    size_t size() const { return mSize; }
+
+    void copyIn(uint64_t position, const uint8_t* data, size_t size) {
+        const size_t offset = position & (mSize - 1);
+        const size_t first = std::min(size, mSize - offset);
+        memcpy(mData + offset, data, first);
+        memcpy(mData, data + first, size - first);
+    }
+
+    void copyOut(uint64_t position, uint8_t* data, size_t size) const {
+        const size_t offset = position & (mSize - 1);
+        const size_t first = std::min(size, mSize - offset);
+        memcpy(data, mData + offset, first);
+        memcpy(data + first, mData, size - first);
+    }
+
+private:
+    status_t map(const unique_fd& fd, size_t size) {
+        void* mapping = mmap(nullptr, kRingDataOffset + size, PROT_READ | PROT_WRITE, MAP_SHARED,
+                             fd.get(), 0);
+        if (mapping == MAP_FAILED) {
+            int savedErrno = errno;
+            ALOGW("mmap: %s", strerror(savedErrno));
+            return -savedErrno;
+        }
+        mMapping = mapping;
+        mData = static_cast<uint8_t*>(mapping) + kRingDataOffset;
+        mSize = size;
+        return OK;
+    }
+
+    void* mMapping = nullptr;
+    uint8_t* mData = nullptr;
+    size_t mSize = 0;
+};
+
+bool isUnixSocket(const RpcTransportFd& socket) {
+    sockaddr_storage addr;
+    socklen_t addrLen = sizeof(addr);
+    if (getsockname(socket.fd.get(), reinterpret_cast<sockaddr*>(&addr), &addrLen) != 0) {
+        return false;
+    }
+    return addr.ss_family == AF_UNIX;
+}
+
+} // namespace
+
+// RpcTransport which moves data through a pair of shared memory rings, falling back to the raw
+// socket when either side couldn't set them up. The socket still carries FDs, and a byte whenever
+// the other side went to sleep waiting on a ring, which also lets poll() notice when the peer
+// goes away.
+class RpcTransportShm : public RpcTransport {
+public:
+    explicit RpcTransportShm(android::RpcTransportFd socket) : mSocket(std::move(socket)) {}
+
+    status_t handshake(FdTrigger* fdTrigger, size_t ringSize) {
+        auto tx = std::make_unique<Ring>();
+        unique_fd txFd;
+        if (!isUnixSocket(mSocket) || tx->create(ringSize, &txFd) != OK) {
+            ringSize = 0;
+        }
+
+        Hello hello{.magic = kHelloMagic, .ringSize = static_cast<uint32_t>(ringSize)};
+        std::vector<std::variant<unique_fd, borrowed_fd>> txFds;
+        if (ringSize != 0) txFds.emplace_back(borrowed_fd(txFd.get()));
+        iovec iov{&hello, sizeof(hello)};
+        if (status_t status = writeSocket(fdTrigger, &iov, 1, std::nullopt, &txFds);
+            status != OK) {
+            return status;
+        }
+
+        Hello peerHello;
+        std::vector<std::variant<unique_fd, borrowed_fd>> rxFds;
+        iov = {&peerHello, sizeof(peerHello)};
+        if (status_t status = readSocket(fdTrigger, &iov, 1, std::nullopt, &rxFds);
+            status != OK) {
+            return status;
+        }
+        if (peerHello.magic != kHelloMagic) {
+            ALOGE("Peer is not using the shared memory transport");
+            return BAD_VALUE;
+        }
+        if (ringSize == 0 || peerHello.ringSize == 0) {
+            LOG_RPC_DETAIL("Shared memory unavailable, using the raw socket");
+            return OK;
+        }
+        if (!isValidRingSize(peerHello.ringSize) || rxFds.size() != 1) {
+            ALOGE("Invalid ring from peer");
+            return BAD_VALUE;
+        }
+
+        auto rx = std::make_unique<Ring>();
+        if (status_t status = rx->attach(std::get<unique_fd>(rxFds[0]), peerHello.ringSize);
+            status != OK) {
+            return status;
+        }
+        mTx = std::move(tx);
+        mRx = std::move(rx);
+        return OK;
+    }
+
+    status_t pollRead(void) override {
+        if (!mRx) return pollSocket();
+
+        if (mRxRecordRemaining > 0 || rxAvailable() != 0) return OK;
+        // Nothing in the ring, so anything on the socket is a doorbell or FDs. Consume it to
+        // notice hangups, then check again in case data arrived in the meantime.
+        if (status_t status = drainSocket(); status != OK) return status;
+        return rxAvailable() != 0 ? OK : WOULD_BLOCK;
+    }
+
+    status_t interruptableWriteFully(
+            FdTrigger* fdTrigger, iovec* iovs, int niovs,
+            const std::optional<SmallFunction<status_t()>>& altPoll,
+            const std::vector<std::variant<unique_fd, borrowed_fd>>* ancillaryFds) override {
+        if (!mTx) return writeSocket(fdTrigger, iovs, niovs, altPoll, ancillaryFds);
+
+        MAYBE_WAIT_IN_FLAKE_MODE;
+        if (niovs < 0) return BAD_VALUE;
+        if (fdTrigger->isTriggered()) return DEAD_OBJECT;
+
+        size_t size = 0;
+        for (int i = 0; i < niovs; i++) size += iovs[i].iov_len;
+        const size_t fdCount = ancillaryFds != nullptr ? ancillaryFds->size() : 0;
+        if (size == 0 && fdCount == 0) return OK;
+        if (size > UINT32_MAX || fdCount > kMaxFdsPerRecord) return BAD_VALUE;
+
+        if (fdCount > 0) {
+            // The FDs go ahead of the record, so they are already queued on the socket when the
+            // peer reads its header.
+            uint8_t byte = 0;
+            iovec iov{&byte, sizeof(byte)};
+            if (status_t status = writeSocket(fdTrigger, &iov, 1, altPoll, ancillaryFds);
+                status != OK) {
+                return status;
+            }
+        }
+
+        RecordHeader record{.size = static_cast<uint32_t>(size),
+                            .fdCount = static_cast<uint32_t>(fdCount)};
+        if (status_t status = writeRing(fdTrigger, altPoll, reinterpret_cast<uint8_t*>(&record),
+                                        sizeof(record));
+            status != OK) {
+            return status;
+        }
+        for (int i = 0; i < niovs; i++) {
+            if (status_t status = writeRing(fdTrigger, altPoll,
+                                            static_cast<uint8_t*>(iovs[i].iov_base),
+                                            iovs[i].iov_len);
+                status != OK) {
+                return status;
+            }
+        }
+        return OK;
+    }
+
+    status_t interruptableReadFully(
+            FdTrigger* fdTrigger, iovec* iovs, int niovs,
+            const std::optional<SmallFunction<status_t()>>& altPoll,
+            std::vector<std::variant<unique_fd, borrowed_fd>>* ancillaryFds) override {
+        if (!mRx) return readSocket(fdTrigger, iovs, niovs, altPoll, ancillaryFds);
+
+        MAYBE_WAIT_IN_FLAKE_MODE;
+        if (niovs < 0) return BAD_VALUE;
+        if (fdTrigger->isTriggered()) return DEAD_OBJECT;
+
+        for (int i = 0; i < niovs; i++) {
+            uint8_t* data = static_cast<uint8_t*>(iovs[i].iov_base);
+            size_t size = iovs[i].iov_len;
+            while (size > 0) {
+                if (mRxRecordRemaining == 0) {
+                    if (status_t status = startRecord(fdTrigger, altPoll, ancillaryFds);
+                        status != OK) {
+                        return status;
+                    }
+                    continue;
+                }
+                const size_t chunk = std::min(size, mRxRecordRemaining);
+                if (status_t status = readRing(fdTrigger, altPoll, data, chunk); status != OK) {
+                    return status;
+                }
+                data += chunk;
+                size -= chunk;
+                mRxRecordRemaining -= chunk;
+            }
+        }
+        return OK;
+    }
+
+    bool isWaiting() override { return mSocket.isInPollingState(); }
+
+private:
+    status_t pollSocket() {
+        uint8_t buf;
+        ssize_t ret = TEMP_FAILURE_RETRY(
+                ::recv(mSocket.fd.get(), &buf, sizeof(buf), MSG_PEEK | MSG_DONTWAIT));
+        if (ret < 0) {
+            int savedErrno = errno;
+            if (savedErrno == EAGAIN || savedErrno == EWOULDBLOCK) {
+                return WOULD_BLOCK;
+            }
+
+            LOG_RPC_DETAIL("RpcTransport poll(): %s", strerror(savedErrno));
+            return -savedErrno;
+        } else if (ret == 0) {
+            return DEAD_OBJECT;
+        }
+
+        return OK;
+    }
+
+    status_t writeSocket(FdTrigger* fdTrigger, iovec* iovs, int niovs,
+                         const std::optional<SmallFunction<status_t()>>& altPoll,
+                         const std::vector<std::variant<unique_fd, borrowed_fd>>* ancillaryFds) {
+        bool sentFds = false;
+        auto send = [&](iovec* iovs, int niovs) -> ssize_t {
+            ssize_t ret = binder::os::sendMessageOnSocket(mSocket, iovs, niovs,
+                                                          sentFds ? nullptr : ancillaryFds);
+            sentFds |= ret > 0;
+            return ret;
+        };
+        return interruptableReadOrWrite(mSocket, fdTrigger, iovs, niovs, send, "sendmsg", POLLOUT,
+                                        altPoll);
+    }
+
+    status_t readSocket(FdTrigger* fdTrigger, iovec* iovs, int niovs,
+                        const std::optional<SmallFunction<status_t()>>& altPoll,
+                        std::vector<std::variant<unique_fd, borrowed_fd>>* ancillaryFds) {
+        auto recv = [&](iovec* iovs, int niovs) -> ssize_t {
+            return binder::os::receiveMessageFromSocket(mSocket, iovs, niovs, ancillaryFds);
+        };
+        return interruptableReadOrWrite(mSocket, fdTrigger, iovs, niovs, recv, "recvmsg", POLLIN,
+                                        altPoll);
+    }
+
+    // Consumes whatever is queued on the socket without blocking, keeping any FDs for the record
+    // they were sent with.
+    status_t drainSocket() {
+        while (true) {
+            uint8_t buf[64];
+            iovec iov{buf, sizeof(buf)};
+            std::vector<std::variant<unique_fd, borrowed_fd>> fds;
+            ssize_t ret = binder::os::receiveMessageFromSocket(mSocket, &iov, 1, &fds);
+            if (ret < 0) {
+                int savedErrno = errno;
+                if (savedErrno == EAGAIN || savedErrno == EWOULDBLOCK) return OK;
+                LOG_RPC_DETAIL("RpcTransport recvmsg(): %s", strerror(savedErrno));
+                return -savedErrno;
+            }
+            if (ret == 0) return DEAD_OBJECT;
+            for (auto& fd : fds) {
+                mPendingFds.push_back(std::move(std::get<unique_fd>(fd)));
+            }
+        }
+    }
+
+    // Lets the peer know there is something to do, if it went to sleep waiting for it. Failures
+    // are ignored: a full socket wakes the peer up anyway, and a dead one is noticed on the next
+    // poll.
+    void ringDoorbell(std::atomic<uint32_t>& waiting) {
+        if (waiting.exchange(0) == 0) return;
+        uint8_t byte = 0;
+        iovec iov{&byte, sizeof(byte)};
+        (void)binder::os::sendMessageOnSocket(mSocket, &iov, 1, nullptr);
+    }
+
+    // Waits until |ready| returns true, sleeping on the socket after announcing it through
+    // |waiting| so that the peer rings the doorbell.
+    template <typename Ready>
+    status_t waitFor(FdTrigger* fdTrigger, const std::optional<SmallFunction<status_t()>>& altPoll,
+                     std::atomic<uint32_t>& waiting, Ready ready) {
+        for (int i = 0; i < kSpinCount; i++) {
+            if (ready()) return OK;
+        }
+        while (true) {
+            waiting.store(1);
+            if (ready()) {
+                waiting.store(0);
+                return OK;
+            }
+            if (altPoll) {
+                if (status_t status = (*altPoll)(); status != OK) return status;
+                if (fdTrigger->isTriggered()) return DEAD_OBJECT;
+            } else if (status_t status = fdTrigger->triggerablePoll(mSocket, POLLIN);
+                       status != OK) {
+                return status;
+            }
+            // The peer may have written its last bytes and hung up, so look at the ring before
+            // the socket.
+            if (ready()) {
+                waiting.store(0);
+                return OK;
+            }
+            if (status_t status = drainSocket(); status != OK) return status;
+        }
+    }
+
+    size_t rxAvailable() {
+        return static_cast<size_t>(mRx->header().head.load() - mRxTail);
+    }
+
+    status_t writeRing(FdTrigger* fdTrigger,
+                       const std::optional<SmallFunction<status_t()>>& altPoll,
+                       const uint8_t* data, size_t size) {
+        RingHeader& header = mTx->header();
+        while (size > 0) {
+            size_t space = 0;
+            bool corrupt = false;
+            auto hasSpace = [&] {
+                const uint64_t used = mTxHead - header.tail.load();
+                corrupt = used > mTx->size();
+                space = corrupt ? 0 : mTx->size() - used;
+                return corrupt || space > 0;
+            };
+            if (status_t status = waitFor(fdTrigger, altPoll, header.writerWaiting, hasSpace);
+                status != OK) {
+                return status;
+            }
+            if (corrupt) {
+                ALOGE("Peer corrupted the transmit ring");
+                return BAD_VALUE;
+            }
+
+            const size_t chunk = std::min(size, space);
+            mTx->copyIn(mTxHead, data, chunk);
+            mTxHead += chunk;
+            header.head.store(mTxHead);
+            ringDoorbell(header.readerWaiting);
+            data += chunk;
+            size -= chunk;
+        }
+        return OK;
+    }
+
+    status_t readRing(FdTrigger* fdTrigger, const std::optional<SmallFunction<status_t()>>& altPoll,
+                      uint8_t* data, size_t size) {
+        RingHeader& header = mRx->header();
+        while (size > 0) {
+            size_t available = 0;
+            bool corrupt = false;
+            auto hasData = [&] {
+                available = rxAvailable();
+                corrupt = available > mRx->size();
+                return corrupt || available > 0;
+            };
+            if (status_t status = waitFor(fdTrigger, altPoll, header.readerWaiting, hasData);
+                status != OK) {
+                return status;
+            }
+            if (corrupt) {
+                ALOGE("Peer corrupted the receive ring");
+                return BAD_VALUE;
+            }
+
+            const size_t chunk = std::min(size, available);
+            mRx->copyOut(mRxTail, data, chunk);
+            mRxTail += chunk;
+            header.tail.store(mRxTail);
+            ringDoorbell(header.writerWaiting);
+            data += chunk;
+            size -= chunk;
+        }
+        return OK;
+    }
+
+    // Reads the next record header and hands out the FDs that came with it, dropping them if the
+    // caller doesn't want any, like recvmsg does.
+    status_t startRecord(FdTrigger* fdTrigger,
+                         const std::optional<SmallFunction<status_t()>>& altPoll,
+                         std::vector<std::variant<unique_fd, borrowed_fd>>* ancillaryFds) {
+        RecordHeader record;
+        if (status_t status = readRing(fdTrigger, altPoll, reinterpret_cast<uint8_t*>(&record),
+                                       sizeof(record));
+            status != OK) {
+            return status;
+        }
+        if (record.fdCount > kMaxFdsPerRecord) {
+            ALOGE("Record with %u FDs exceeds the limit", record.fdCount);
+            return BAD_VALUE;
+        }
+        while (mPendingFds.size() < record.fdCount) {
+            if (status_t status = fdTrigger->triggerablePoll(mSocket, POLLIN); status != OK) {
+                return status;
+            }
+            if (status_t status = drainSocket(); status != OK) return status;
+        }
+        for (uint32_t i = 0; i < record.fdCount; i++) {
+            if (ancillaryFds != nullptr) ancillaryFds->emplace_back(std::move(mPendingFds.front()));
+            mPendingFds.pop_front();
+        }
+        mRxRecordRemaining = record.size;
+        return OK;
+    }
+
+    android::RpcTransportFd mSocket;
+    std::unique_ptr<Ring> mTx;
+    std::unique_ptr<Ring> mRx;
+    // Local copies of the positions this side advances, so the peer can't make us overrun.
+    uint64_t mTxHead = 0;
+    uint64_t mRxTail = 0;
+    size_t mRxRecordRemaining = 0;
+    std::deque<unique_fd> mPendingFds;
+};
+
+// RpcTransportCtx with shared memory rings.
+class RpcTransportCtxShm : public RpcTransportCtx {
+public:
+    explicit RpcTransportCtxShm(size_t ringSize) : mRingSize(ringSize) {}
+
+    std::unique_ptr<RpcTransport> newTransport(android::RpcTransportFd socket,
+                                               FdTrigger* fdTrigger) const override {
+        auto transport = std::make_unique<RpcTransportShm>(std::move(socket));
+        if (status_t status = transport->handshake(fdTrigger, mRingSize); status != OK) {
+            ALOGE("Shared memory transport handshake failed: %s", statusToString(status).c_str());
+            return nullptr;
+        }
+        return transport;
+    }
+    std::vector<uint8_t> getCertificate(RpcCertificateFormat) const override { return {}; }
+
+private:
+    const size_t mRingSize;
+};
+
+std::unique_ptr<RpcTransportCtx> RpcTransportCtxFactoryShm::newServerCtx() const {
+    return std::make_unique<RpcTransportCtxShm>(mRingSize);
+}
+
+std::unique_ptr<RpcTransportCtx> RpcTransportCtxFactoryShm::newClientCtx() const {
+    return std::make_unique<RpcTransportCtxShm>(mRingSize);
+}
+
+const char* RpcTransportCtxFactoryShm::toCString() const {
+    return "shm";
+}
+
+std::unique_ptr<RpcTransportCtxFactory> RpcTransportCtxFactoryShm::make(size_t ringSize) {
+    if (!isValidRingSize(ringSize)) {
+        ALOGE("Invalid ring size %zu", ringSize);
+        return nullptr;
+    }
+    return std::unique_ptr<RpcTransportCtxFactoryShm>(new RpcTransportCtxFactoryShm(ringSize));
+}
+
+} // namespace android
@@ -129,6 +129,13 @@ struct RpcDecStrong {
 };
 static_assert(sizeof(RpcDecStrong) == 16);
 
+/**
+ * The Parcel data isn't part of the transaction body. Instead, it is in a
+ * sealed memory FD, which is the last of the ancillary FDs sent along with the
+ * transaction.
+ */
+constexpr uint32_t RPC_WIRE_TRANSACTION_OPTION_OUT_OF_LINE_DATA = 1 << 0;
+
 struct RpcWireTransaction {
     RpcWireAddress address;
     uint32_t code;
@@ -136,10 +143,15 @@ struct RpcWireTransaction {
 
     uint64_t asyncNumber;
 
-    // The size of the Parcel data directly following RpcWireTransaction.
+    // The size of the Parcel data directly following RpcWireTransaction, or in
+    // the out of line FD.
     uint32_t parcelDataSize;
 
-    uint32_t reserved[3];
+    // RPC_WIRE_TRANSACTION_OPTION_*, only transmitted starting at
+    // RPC_WIRE_PROTOCOL_VERSION_RPC_HEADER_FEATURE_OUT_OF_LINE_DATA.
+    uint32_t options;
+
+    uint32_t reserved[2];
 
     uint8_t data[];
 };
@@ -0,0 +1,205 @@
+/*
+ * Copyright (C) 2024 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <binder/RpcThreads.h>
+#include <binder/TransactionStats.h>
+#include <utils/String8.h>
+
+#include <inttypes.h>
+#include <algorithm>
+#include <atomic>
+#include <map>
+#include <set>
+#include <tuple>
+
+namespace android::binder::debug {
+
+namespace {
+
+struct Key {
+    String16 descriptor;
+    uint32_t code;
+    bool incoming;
+
+    bool operator<(const Key& other) const {
+        return std::tie(descriptor, code, incoming) <
+                std::tie(other.descriptor, other.code, other.incoming);
+    }
+};
+
+struct Stats {
+    uint64_t count = 0;
+    uint64_t totalLatencyNs = 0;
+    uint64_t maxLatencyNs = 0;
+    uint64_t totalDataBytes = 0;
+    uint64_t totalReplyBytes = 0;
+    std::array<uint64_t, TransactionStats::kLatencyBuckets> latencyHistogram = {};
+
+    void merge(const Stats& other) {
+        count += other.count;
+        totalLatencyNs += other.totalLatencyNs;
+        maxLatencyNs = std::max(maxLatencyNs, other.maxLatencyNs);
+        totalDataBytes += other.totalDataBytes;
+        totalReplyBytes += other.totalReplyBytes;
+        for (size_t i = 0; i < latencyHistogram.size(); i++) {
+            latencyHistogram[i] += other.latencyHistogram[i];
+        }
+    }
+};
+
+using StatsMap = std::map<Key, Stats>;
+
+// Statistics recorded by one thread. Its lock is only contended by snapshot() and reset().
+struct Shard {
+    RpcMutex mutex;
+    StatsMap stats;
+};
+
+std::atomic<bool> gEnabled = false;
+
+[[clang::no_destroy]] RpcMutex gShardsMutex;
+[[clang::no_destroy]] std::set<Shard*> gShards;
+// Statistics of threads which have exited.
+[[clang::no_destroy]] StatsMap gRetiredStats;
+
+void mergeInto(StatsMap* into, const StatsMap& from) {
+    for (const auto& [key, stats] : from) {
+        (*into)[key].merge(stats);
+    }
+}
+
+class ShardRegistration {
+public:
+    ShardRegistration() {
+        RpcMutexLockGuard lock(gShardsMutex);
+        gShards.insert(&mShard);
+    }
+    ~ShardRegistration() {
+        RpcMutexLockGuard lock(gShardsMutex);
+        gShards.erase(&mShard);
+        mergeInto(&gRetiredStats, mShard.stats);
+    }
+    Shard& shard() { return mShard; }
+
+private:
+    Shard mShard;
+};
+
+Shard& getShard() {
+#ifdef BINDER_RPC_SINGLE_THREADED
+    [[clang::no_destroy]] static ShardRegistration registration;
+#else
+    thread_local ShardRegistration registration;
+#endif
+    return registration.shard();
+}
+
+size_t latencyBucket(uint64_t latencyNs) {
+    const uint64_t latencyUs = latencyNs / 1000;
+    if (latencyUs == 0) return 0;
+    const size_t log2 = 63 - __builtin_clzll(latencyUs);
+    return std::min(log2, TransactionStats::kLatencyBuckets - 1);
+}
+
+} // namespace
+
+void TransactionStats::setEnabled(bool enabled) {
+    gEnabled.store(enabled, std::memory_order_relaxed);
+}
+
+bool TransactionStats::isEnabled() {
+    return gEnabled.load(std::memory_order_relaxed);
+}
+
+void TransactionStats::reset() {
+    RpcMutexLockGuard lock(gShardsMutex);
+    for (Shard* shard : gShards) {
+        RpcMutexLockGuard shardLock(shard->mutex);
+        shard->stats.clear();
+    }
+    gRetiredStats.clear();
+}
+
+void TransactionStats::record(const String16& descriptor, uint32_t code, bool incoming,
+                              uint64_t latencyNs, size_t dataBytes, size_t replyBytes) {
+    Shard& shard = getShard();
+    RpcMutexLockGuard lock(shard.mutex);
+    Stats& stats = shard.stats[Key{descriptor, code, incoming}];
+    stats.count++;
+    stats.totalLatencyNs += latencyNs;
+    stats.maxLatencyNs = std::max(stats.maxLatencyNs, latencyNs);
+    stats.totalDataBytes += dataBytes;
+    stats.totalReplyBytes += replyBytes;
+    stats.latencyHistogram[latencyBucket(latencyNs)]++;
+}
+
+std::vector<TransactionStats::Entry> TransactionStats::snapshot() {
+    StatsMap merged;
+    {
+        RpcMutexLockGuard lock(gShardsMutex);
+        merged = gRetiredStats;
+        for (Shard* shard : gShards) {
+            RpcMutexLockGuard shardLock(shard->mutex);
+            mergeInto(&merged, shard->stats);
+        }
+    }
+
+    std::vector<Entry> entries;
+    entries.reserve(merged.size());
+    for (const auto& [key, stats] : merged) {
+        entries.push_back(Entry{
+                .descriptor = String8(key.descriptor).c_str(),
+                .code = key.code,
+                .incoming = key.incoming,
+                .count = stats.count,
+                .totalLatencyNs = stats.totalLatencyNs,
+                .maxLatencyNs = stats.maxLatencyNs,
+                .totalDataBytes = stats.totalDataBytes,
+                .totalReplyBytes = stats.totalReplyBytes,
+                .latencyHistogram = stats.latencyHistogram,
+        });
+    }
+    return entries;
+}
+
+std::string TransactionStats::dump() {
+    String8 out;
+    out.appendFormat("Binder transaction stats (%s):\n", isEnabled() ? "enabled" : "disabled");
+    for (const Entry& entry : snapshot()) {
+        out.appendFormat("  %s %s code %" PRIu32 ": count %" PRIu64 ", avg %" PRIu64
+                         "us, max %" PRIu64 "us, avg data %" PRIu64 "B, avg reply %" PRIu64 "B\n",
+                         entry.incoming ? "in " : "out",
+                         entry.descriptor.empty() ? "<unknown>" : entry.descriptor.c_str(),
+                         entry.code, entry.count, entry.totalLatencyNs / entry.count / 1000,
+                         entry.maxLatencyNs / 1000, entry.totalDataBytes / entry.count,
+                         entry.totalReplyBytes / entry.count);
+        out.append("    latency histogram (us):");
+        for (size_t i = 0; i < entry.latencyHistogram.size(); i++) {
+            if (entry.latencyHistogram[i] == 0) continue;
+            if (i + 1 == entry.latencyHistogram.size()) {
+                out.appendFormat(" >=%" PRIu64 ":%" PRIu64, uint64_t{1} << i,
+                                 entry.latencyHistogram[i]);
+            } else {
+                out.appendFormat(" <%" PRIu64 ":%" PRIu64, uint64_t{2} << i,
+                                 entry.latencyHistogram[i]);
+            }
+        }
+        out.append("\n");
+    }
+    return out.c_str();
+}
+
+} // namespace android::binder::debug
@@ -21,6 +21,7 @@
 #include <chrono>
 #include <cstdint>
 #include <optional>
+#include <type_traits>
 
 #include <binder/Common.h>
 #include <log/log.h>
@@ -128,6 +129,31 @@ struct Span {
 // Android is little-endian.
 LIBBINDER_INTERNAL_EXPORTED std::string HexString(const void* bytes, size_t len);
 
+// Returns true if all the characters of str are ASCII, so that it has the same code units in UTF-8
+// and UTF-16. Most strings in transactions are, such as descriptors and package names. This scans
+// the whole string without branching, so that the compiler can vectorize it.
+template <typename Char>
+inline bool isAscii(const Char* str, size_t len) {
+    using Unit = std::make_unsigned_t<Char>;
+    Unit bits = 0;
+    for (size_t i = 0; i < len; i++) {
+        bits |= static_cast<Unit>(str[i]);
+    }
+    return bits < 0x80;
+}
+
+// Widens or narrows the len characters of an ASCII string, without writing a terminating null.
+inline void asciiToUtf16(const char* src, size_t len, char16_t* dst) {
+    for (size_t i = 0; i < len; i++) {
+        dst[i] = static_cast<unsigned char>(src[i]);
+    }
+}
+inline void asciiToUtf8(const char16_t* src, size_t len, char* dst) {
+    for (size_t i = 0; i < len; i++) {
+        dst[i] = static_cast<char>(src[i]);
+    }
+}
+
 // Converts any std::chrono duration to the number of milliseconds
 template <class Rep, class Period>
 uint64_t to_ms(std::chrono::duration<Rep, Period> duration) {
@@ -158,6 +158,10 @@ public:
         const sp<RpcSession>& rpcSession() const { return mBinder->rpcSession(); }
 
         void onFrozenStateChanged(bool isFrozen) { mMutableBinder->onFrozenStateChanged(isFrozen); }
+        // sendObituary() in two steps, so that the death notifications of many proxies can be
+        // cleared with a single write to the driver.
+        bool prepareObituary() { return mMutableBinder->prepareObituary(); }
+        void reportObituaries() { mMutableBinder->reportObituaries(); }
         const BpBinder* mBinder;
         BpBinder* mMutableBinder;
     };
@@ -216,6 +220,11 @@ private:
         bool initialStateReceived = false;
     };
 
+    // Marks the proxy as dead and queues the clearing of its death notification on the calling
+    // thread, without flushing it. Returns whether there are recipients to notify with
+    // reportObituaries().
+    bool prepareObituary();
+    void reportObituaries();
     void reportOneDeath(const Obituary& obit);
     bool isDescriptorCached() const;
 
@@ -24,6 +24,7 @@
 #include <utils/Vector.h>
 
 #include <functional>
+#include <string>
 
 // linux/binder.h defines this, but we don't want to include it here in order to
 // avoid exporting the kernel headers
@@ -65,6 +66,7 @@ public:
         EXTENSION_TRANSACTION = B_PACK_CHARS('_', 'E', 'X', 'T'),
         DEBUG_PID_TRANSACTION = B_PACK_CHARS('_', 'P', 'I', 'D'),
         SET_RPC_CLIENT_TRANSACTION = B_PACK_CHARS('_', 'R', 'P', 'C'),
+        TRANSACTION_STATS_TRANSACTION = B_PACK_CHARS('_', 'S', 'T', 'S'),
 
         // See android.os.IBinder.TWEET_TRANSACTION
         // Most importantly, messages can be anything not exceeding 130 UTF-8
@@ -182,6 +184,19 @@ public:
     [[nodiscard]] status_t setRpcClientDebug(binder::unique_fd socketFd,
                                              const sp<IBinder>& keepAliveBinder);
 
+    /**
+     * Start or stop collecting binder transaction statistics in the process hosting this
+     * binder, for debugging. See binder/TransactionStats.h. For remote binders, this is only
+     * allowed for root.
+     */
+    status_t                setTransactionStatsEnabled(bool enabled);
+
+    /**
+     * Dump the binder transaction statistics collected in the process hosting this binder, for
+     * debugging. For remote binders, this is only allowed for root.
+     */
+    status_t                dumpTransactionStats(std::string* out);
+
     // NOLINTNEXTLINE(google-default-arguments)
     virtual status_t        transact(   uint32_t code,
                                         const Parcel& data,
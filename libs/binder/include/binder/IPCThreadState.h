@@ -22,6 +22,9 @@
 #include <utils/Errors.h>
 #include <utils/Vector.h>
 
+#include <memory>
+#include <vector>
+
 #if defined(_WIN32)
 typedef  int  uid_t;
 #endif
@@ -166,6 +169,29 @@ public:
     LIBBINDER_EXPORTED status_t transact(int32_t handle, uint32_t code, const Parcel& data,
                                          Parcel* reply, uint32_t flags);
 
+    /**
+     * Batch oneway transactions made on this thread, so that a burst of them
+     * is written to the driver with a single ioctl instead of one each.
+     *
+     * Until the matching flushOnewayBatch, oneway transactions are copied and
+     * queued instead of being sent, and return NO_ERROR; errors from them are
+     * returned by flushOnewayBatch instead. A synchronous transaction made in
+     * the meantime sends the queued ones first, so ordering is preserved.
+     * Calls may be nested, and only the outermost flushOnewayBatch sends.
+     *
+     * Usage:
+     *     IPCThreadState::self()->beginOnewayBatch();
+     *     for (const auto& listener : listeners) {
+     *         listener->onEvent(...); // oneway
+     *     }
+     *     status_t status = IPCThreadState::self()->flushOnewayBatch();
+     *
+     * A batch must be flushed before returning from a binder call which
+     * started it.
+     */
+    LIBBINDER_EXPORTED void beginOnewayBatch();
+    LIBBINDER_EXPORTED status_t flushOnewayBatch();
+
     LIBBINDER_EXPORTED void incStrongHandle(int32_t handle, BpBinder* proxy);
     LIBBINDER_EXPORTED void decStrongHandle(int32_t handle);
     LIBBINDER_EXPORTED void incWeakHandle(int32_t handle, BpBinder* proxy);
@@ -218,6 +244,9 @@ private:
     [[nodiscard]] status_t writeTransactionData(int32_t cmd, uint32_t binderFlags, int32_t handle,
                                                 uint32_t code, const Parcel& data,
                                                 status_t* statusBuffer);
+    [[nodiscard]] status_t queueOnewayTransaction(int32_t handle, uint32_t code,
+                                                  const Parcel& data, uint32_t flags);
+    void sendOnewayBatch();
     [[nodiscard]] status_t getAndExecuteCommand();
     [[nodiscard]] status_t executeCommand(int32_t command);
     void processPendingDerefs();
@@ -251,6 +280,12 @@ private:
             bool                mIsLooper;
             bool mIsFlushing;
             bool mHasExplicitIdentity;
+            // Depth of beginOnewayBatch calls, and the transactions queued
+            // since the outermost one. The copies back the BC_TRANSACTION
+            // commands in mOut until the driver has consumed them.
+            size_t mOnewayBatchDepth;
+            std::vector<std::unique_ptr<Parcel>> mOnewayBatch;
+            status_t mOnewayBatchError;
             int32_t             mStrictModePolicy;
             int32_t             mLastTransactionBinderFlags;
             CallRestriction     mCallRestriction;
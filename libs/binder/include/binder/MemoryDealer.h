@@ -27,17 +27,44 @@ namespace android {
 // ----------------------------------------------------------------------------
 
 class SimpleBestFitAllocator;
+class SizeClassAllocator;
 
 // ----------------------------------------------------------------------------
 
 class MemoryDealer : public RefBase {
 public:
+    struct Options {
+        // Serve allocations of up to kMaxSizeClassSize bytes from size classes. Each size class
+        // takes whole pages of the heap and splits them into blocks of its size, so many small
+        // allocations don't fragment the heap, and each class has its own lock.
+        bool useSizeClasses = false;
+    };
+    static constexpr size_t kMaxSizeClassSize = 2048;
+
+    struct Stats {
+        size_t heapSize = 0;
+        // Bytes of the heap in use, rounded up to getAllocationAlignment(). Pages taken by size
+        // classes are counted as a whole.
+        size_t usedBytes = 0;
+        // Free bytes of the heap, the size of the largest free range, and the number of free
+        // ranges. Free blocks of size classes are not included.
+        size_t freeBytes = 0;
+        size_t largestFreeRange = 0;
+        size_t freeRangeCount = 0;
+        // Bytes of size class blocks in use and free.
+        size_t sizeClassUsedBytes = 0;
+        size_t sizeClassFreeBytes = 0;
+    };
+
     LIBBINDER_EXPORTED explicit MemoryDealer(
             size_t size, const char* name = nullptr,
             uint32_t flags = 0 /* or bits such as MemoryHeapBase::READ_ONLY */);
+    LIBBINDER_EXPORTED MemoryDealer(size_t size, const char* name, uint32_t flags,
+                                    const Options& options);
 
     LIBBINDER_EXPORTED virtual sp<IMemory> allocate(size_t size);
     LIBBINDER_EXPORTED virtual void dump(const char* what) const;
+    LIBBINDER_EXPORTED Stats getStats() const;
 
     // allocations are aligned to some value. return that value so clients can account for it.
     LIBBINDER_EXPORTED static size_t getAllocationAlignment();
@@ -55,6 +82,7 @@ private:
 
     sp<IMemoryHeap>             mHeap;
     SimpleBestFitAllocator*     mAllocator;
+    SizeClassAllocator*         mSizeClasses;
 };
 
 // ----------------------------------------------------------------------------
@@ -130,6 +130,28 @@ public:
      */
     LIBBINDER_EXPORTED bool isThreadPoolStarted() const;
 
+    struct ThreadPoolStats {
+        // See setThreadPoolMaxThreadCount.
+        size_t maxThreads = 0;
+        // Threads which have joined the thread pool, and how many of them the kernel started.
+        size_t currentThreads = 0;
+        size_t kernelStartedThreads = 0;
+        // Threads executing a command right now, and the most that ever did at once.
+        size_t executingThreads = 0;
+        size_t peakExecutingThreads = 0;
+        // How many times all maxThreads threads were busy, and for how long in total. While
+        // saturated, incoming transactions wait in the kernel. Only periods which have ended
+        // are counted in the total time.
+        uint64_t saturationCount = 0;
+        std::chrono::nanoseconds totalSaturationTime{0};
+    };
+    /**
+     * Get statistics about the usage of the thread pool, to help choose its size. The kernel
+     * only starts threads up to setThreadPoolMaxThreadCount when all threads are busy, so a
+     * pool that is rarely saturated may use a lower maximum.
+     */
+    LIBBINDER_EXPORTED ThreadPoolStats getThreadPoolStats() const;
+
     enum class DriverFeature {
         ONEWAY_SPAM_DETECTION,
         EXTENDED_ERROR,
@@ -160,7 +182,18 @@ private:
         RefBase::weakref_type* refs;
     };
 
-    handle_entry* lookupHandleLocked(int32_t handle);
+    // Handles are spread over shards, each with its own lock, so that threads receiving
+    // different proxies at once don't wait on each other. The driver hands out the lowest free
+    // handles, so they are spread evenly.
+    static constexpr size_t kHandleTableShards = 16;
+    struct HandleTableShard {
+        std::mutex lock;
+        // Entry i is for handle i * kHandleTableShards + shard index.
+        Vector<handle_entry> entries;
+    };
+
+    HandleTableShard& handleTableShard(int32_t handle);
+    handle_entry* lookupHandleLocked(HandleTableShard& shard, int32_t handle);
 
     String8 mDriverName;
     int mDriverFD;
@@ -181,12 +214,17 @@ private:
     std::atomic_size_t mKernelStartedThreads;
     // Time when thread pool was emptied
     std::atomic<std::chrono::steady_clock::time_point> mStarvationStartTime;
+    // Highest value of mExecutingThreadsCount.
+    std::atomic_size_t mPeakExecutingThreadsCount;
+    // Number and total duration of periods during which the thread pool was emptied.
+    std::atomic_uint64_t mStarvationCount;
+    std::atomic_int64_t mTotalStarvationNs;
 
     static constexpr auto never = &std::chrono::steady_clock::time_point::min;
 
-    mutable std::mutex mLock; // protects everything below.
+    HandleTableShard mHandleToObject[kHandleTableShards];
 
-    Vector<handle_entry> mHandleToObject;
+    mutable std::mutex mLock; // protects everything below.
 
     bool mForked;
     std::atomic_bool mThreadPoolStarted;
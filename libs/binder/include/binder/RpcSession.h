@@ -47,6 +47,13 @@ constexpr uint32_t RPC_WIRE_PROTOCOL_VERSION = 1;
 // * RpcWireTransaction and RpcWireReplyV1 include the parcel data size.
 constexpr uint32_t RPC_WIRE_PROTOCOL_VERSION_RPC_HEADER_FEATURE_EXPLICIT_PARCEL_SIZE = 1;
 
+// Starting with this version:
+//
+// * RpcWireTransaction may carry its parcel data out of line, in a sealed
+//   memory FD sent after the Parcel's own FDs (unix domain sockets only).
+constexpr uint32_t RPC_WIRE_PROTOCOL_VERSION_RPC_HEADER_FEATURE_OUT_OF_LINE_DATA =
+        RPC_WIRE_PROTOCOL_VERSION_EXPERIMENTAL;
+
 /**
  * This represents a session (group of connections) between a client
  * and a server. Multiple connections are needed for multiple parallel "binder"
@@ -95,6 +102,20 @@ public:
     LIBBINDER_EXPORTED void setMaxOutgoingConnections(size_t connections);
     LIBBINDER_EXPORTED size_t getMaxOutgoingThreads();
 
+    /**
+     * Reserve this many of the outgoing connections for oneway transactions. Synchronous and
+     * ref count calls then only use the remaining connections, so a burst of oneway traffic
+     * cannot leave them queued behind asynchronous work on the other side. Since each incoming
+     * connection on the server is serviced by its own thread, this also dedicates that many of
+     * the threads given to RpcServer::setMaxThreads to asynchronous work.
+     *
+     * By default, this is 0, and all transactions share the outgoing connections. If fewer
+     * outgoing connections than this plus one are set up, the reservation is ignored. This must
+     * be called before setting up this connection as a client.
+     */
+    LIBBINDER_EXPORTED void setMaxAsyncConnections(size_t connections);
+    LIBBINDER_EXPORTED size_t getMaxAsyncConnections();
+
     /**
      * By default, the minimum of the supported versions of the client and the
      * server will be used. Usually, this API should only be used for debugging.
@@ -336,10 +357,12 @@ private:
         const sp<RpcConnection>& get() { return mConnection; }
 
     private:
+        // 'available' is only taken from sockets with an index in [availableBegin, availableEnd)
         static void findConnection(uint64_t tid, sp<RpcConnection>* exclusive,
                                    sp<RpcConnection>* available,
                                    std::vector<sp<RpcConnection>>& sockets,
-                                   size_t socketsIndexHint);
+                                   size_t socketsIndexHint, size_t availableBegin,
+                                   size_t availableEnd);
 
         sp<RpcSession> mSession; // avoid deallocation
         sp<RpcConnection> mConnection;
@@ -385,6 +408,7 @@ private:
     bool mStartedSetup = false;
     size_t mMaxIncomingThreads = 0;
     size_t mMaxOutgoingConnections = kDefaultMaxOutgoingConnections;
+    size_t mMaxAsyncConnections = 0;
     std::optional<uint32_t> mProtocolVersion;
     FileDescriptorTransportMode mFileDescriptorTransportMode = FileDescriptorTransportMode::NONE;
 
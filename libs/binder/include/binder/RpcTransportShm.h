@@ -0,0 +1,52 @@
+/*
+ * Copyright (C) 2024 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+// Wraps the transport layer of RPC. Implementation moves data through shared memory rings, using
+// the socket only for setup, FDs and wakeups.
+// Note: don't use directly. You probably want newServerRpcTransportCtx / newClientRpcTransportCtx.
+
+#pragma once
+
+#include <memory>
+
+#include <binder/Common.h>
+#include <binder/RpcTransport.h>
+
+namespace android {
+
+// RpcTransportCtxFactory that exchanges a shared memory ring per direction with the peer when
+// the connection is a UNIX domain socket, and otherwise behaves like RpcTransportCtxFactoryRaw.
+// Both sides of a session must use this factory, since the rings are negotiated in a handshake
+// the raw transport doesn't know about.
+class RpcTransportCtxFactoryShm : public RpcTransportCtxFactory {
+public:
+    static constexpr size_t kDefaultRingSize = 256 * 1024;
+
+    // |ringSize| must be a power of two between 4KiB and 64MiB.
+    LIBBINDER_EXPORTED static std::unique_ptr<RpcTransportCtxFactory> make(
+            size_t ringSize = kDefaultRingSize);
+
+    LIBBINDER_EXPORTED std::unique_ptr<RpcTransportCtx> newServerCtx() const override;
+    LIBBINDER_EXPORTED std::unique_ptr<RpcTransportCtx> newClientCtx() const override;
+    LIBBINDER_EXPORTED const char* toCString() const override;
+
+private:
+    explicit RpcTransportCtxFactoryShm(size_t ringSize) : mRingSize(ringSize) {}
+
+    const size_t mRingSize;
+};
+
+} // namespace android
@@ -0,0 +1,82 @@
+/*
+ * Copyright (C) 2024 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include <binder/Common.h>
+#include <utils/String16.h>
+
+#include <array>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace android {
+
+namespace binder::debug {
+
+// Per-process statistics of binder user transactions (FIRST_CALL_TRANSACTION to
+// LAST_CALL_TRANSACTION), keyed by interface descriptor, transaction code and direction.
+//
+// Collection is off by default. While it is off, a transaction only pays for one relaxed atomic
+// load. While it is on, each thread records into its own table, so threads never contend with
+// each other, only with a concurrent snapshot(). Outgoing transactions are recorded by BpBinder
+// and incoming ones by BBinder, so calls to a local binder are only recorded as incoming. The
+// latency of an outgoing oneway transaction only covers sending it.
+//
+// Statistics of another process can be controlled and dumped through any binder it hosts, see
+// IBinder::setTransactionStatsEnabled and IBinder::dumpTransactionStats, or
+// `dumpsys --binder-stats`.
+class TransactionStats {
+public:
+    // latencyHistogram[i] counts transactions that took [2^i, 2^(i+1)) microseconds. The first
+    // bucket also counts faster transactions, and the last one slower transactions.
+    static constexpr size_t kLatencyBuckets = 20;
+
+    struct Entry {
+        std::string descriptor;
+        uint32_t code = 0;
+        // Handled by a local binder, rather than sent to a remote one.
+        bool incoming = false;
+        uint64_t count = 0;
+        uint64_t totalLatencyNs = 0;
+        uint64_t maxLatencyNs = 0;
+        uint64_t totalDataBytes = 0;
+        uint64_t totalReplyBytes = 0;
+        std::array<uint64_t, kLatencyBuckets> latencyHistogram = {};
+    };
+
+    LIBBINDER_EXPORTED static void setEnabled(bool enabled);
+    LIBBINDER_EXPORTED static bool isEnabled();
+
+    // Drops everything recorded so far.
+    LIBBINDER_EXPORTED static void reset();
+
+    // Everything recorded since the last reset, sorted by descriptor, code and direction. This
+    // can be used to export the statistics, for instance to a Perfetto data source.
+    LIBBINDER_EXPORTED static std::vector<Entry> snapshot();
+
+    // Human readable table of snapshot().
+    LIBBINDER_EXPORTED static std::string dump();
+
+    // Called by libbinder for each user transaction while enabled.
+    static void record(const String16& descriptor, uint32_t code, bool incoming,
+                       uint64_t latencyNs, size_t dataBytes, size_t replyBytes);
+};
+
+} // namespace binder::debug
+
+} // namespace android
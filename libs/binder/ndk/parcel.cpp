@@ -24,6 +24,7 @@
 
 #include <limits>
 
+#include "../Utils.h"
 #include "ibinder_internal.h"
 #include "parcel_internal.h"
 #include "status_internal.h"
@@ -96,7 +97,8 @@ binder_status_t WriteArray(AParcel* parcel, const T* array, int32_t length) {
     return STATUS_OK;
 }
 
-// Each element in a char16_t array is converted to an int32_t (not packed).
+// Each element in a char16_t array is converted to an int32_t (not packed), in space reserved for
+// the whole array at once.
 template <>
 binder_status_t WriteArray<char16_t>(AParcel* parcel, const char16_t* array, int32_t length) {
     binder_status_t status = WriteAndValidateArraySize(parcel, array == nullptr, length);
@@ -104,14 +106,13 @@ binder_status_t WriteArray<char16_t>(AParcel* parcel, const char16_t* array, int
     if (length <= 0) return STATUS_OK;
 
     int32_t size = 0;
-    if (__builtin_smul_overflow(sizeof(char16_t), length, &size)) return STATUS_NO_MEMORY;
+    if (__builtin_smul_overflow(sizeof(int32_t), length, &size)) return STATUS_NO_MEMORY;
 
-    Parcel* rawParcel = parcel->get();
+    int32_t* const data = static_cast<int32_t*>(parcel->get()->writeInplace(size));
+    if (data == nullptr) return STATUS_NO_MEMORY;
 
     for (int32_t i = 0; i < length; i++) {
-        status = rawParcel->writeChar(array[i]);
-
-        if (status != STATUS_OK) return PruneStatusT(status);
+        data[i] = static_cast<int32_t>(array[i]);
     }
 
     return STATUS_OK;
@@ -150,7 +151,7 @@ binder_status_t ReadArray(const AParcel* parcel, void* arrayData,
     return STATUS_OK;
 }
 
-// Each element in a char16_t array is converted to an int32_t (not packed)
+// Each element in a char16_t array is converted from an int32_t (not packed)
 template <>
 binder_status_t ReadArray<char16_t>(const AParcel* parcel, void* arrayData,
                                     ContiguousArrayAllocator<char16_t> allocator) {
@@ -174,40 +175,46 @@ binder_status_t ReadArray<char16_t>(const AParcel* parcel, void* arrayData,
     if (array == nullptr) return STATUS_NO_MEMORY;
 
     int32_t size = 0;
-    if (__builtin_smul_overflow(sizeof(char16_t), length, &size)) return STATUS_NO_MEMORY;
+    if (__builtin_smul_overflow(sizeof(int32_t), length, &size)) return STATUS_NO_MEMORY;
 
-    for (int32_t i = 0; i < length; i++) {
-        status_t status = rawParcel->readChar(array + i);
+    const int32_t* const data = static_cast<const int32_t*>(rawParcel->readInplace(size));
+    if (data == nullptr) return STATUS_NOT_ENOUGH_DATA;
 
-        if (status != STATUS_OK) return PruneStatusT(status);
+    for (int32_t i = 0; i < length; i++) {
+        array[i] = static_cast<char16_t>(data[i]);
     }
 
     return STATUS_OK;
 }
 
+// Each element is converted to an int32_t (not packed), like Parcel::writeBool, in space reserved
+// for the whole array at once.
 template <typename T>
 binder_status_t WriteArray(AParcel* parcel, const void* arrayData, int32_t length,
-                           ArrayGetter<T> getter, status_t (Parcel::*write)(T)) {
+                           ArrayGetter<T> getter) {
     // we have no clue if arrayData represents a null object or not, we can only infer from length
     bool arrayIsNull = length < 0;
     binder_status_t status = WriteAndValidateArraySize(parcel, arrayIsNull, length);
     if (status != STATUS_OK) return status;
     if (length <= 0) return STATUS_OK;
 
-    Parcel* rawParcel = parcel->get();
+    int32_t size = 0;
+    if (__builtin_smul_overflow(sizeof(int32_t), length, &size)) return STATUS_NO_MEMORY;
 
-    for (int32_t i = 0; i < length; i++) {
-        status = (rawParcel->*write)(getter(arrayData, i));
+    int32_t* const data = static_cast<int32_t*>(parcel->get()->writeInplace(size));
+    if (data == nullptr) return STATUS_NO_MEMORY;
 
-        if (status != STATUS_OK) return PruneStatusT(status);
+    for (int32_t i = 0; i < length; i++) {
+        data[i] = static_cast<int32_t>(getter(arrayData, i));
     }
 
     return STATUS_OK;
 }
 
+// Each element is converted from an int32_t (not packed), like Parcel::readBool.
 template <typename T>
 binder_status_t ReadArray(const AParcel* parcel, void* arrayData, ArrayAllocator<T> allocator,
-                          ArraySetter<T> setter, status_t (Parcel::*read)(T*) const) {
+                          ArraySetter<T> setter) {
     const Parcel* rawParcel = parcel->get();
 
     int32_t length;
@@ -225,12 +232,14 @@ binder_status_t ReadArray(const AParcel* parcel, void* arrayData, ArrayAllocator
 
     if (length <= 0) return STATUS_OK;
 
-    for (int32_t i = 0; i < length; i++) {
-        T readTarget;
-        status_t status = (rawParcel->*read)(&readTarget);
-        if (status != STATUS_OK) return PruneStatusT(status);
+    int32_t size = 0;
+    if (__builtin_smul_overflow(sizeof(int32_t), length, &size)) return STATUS_NO_MEMORY;
 
-        setter(arrayData, i, readTarget);
+    const int32_t* const data = static_cast<const int32_t*>(rawParcel->readInplace(size));
+    if (data == nullptr) return STATUS_NOT_ENOUGH_DATA;
+
+    for (int32_t i = 0; i < length; i++) {
+        setter(arrayData, i, static_cast<T>(data[i]));
     }
 
     return STATUS_OK;
@@ -338,7 +347,8 @@ binder_status_t AParcel_writeString(AParcel* parcel, const char* string, int32_t
     }
 
     const uint8_t* str8 = (uint8_t*)string;
-    const ssize_t len16 = utf8_to_utf16_length(str8, length);
+    const bool ascii = isAscii(string, length);
+    const ssize_t len16 = ascii ? length : utf8_to_utf16_length(str8, length);
 
     if (len16 < 0 || len16 >= std::numeric_limits<int32_t>::max()) {
         ALOGW("Invalid string length: %zd", len16);
@@ -355,7 +365,12 @@ binder_status_t AParcel_writeString(AParcel* parcel, const char* string, int32_t
         return STATUS_NO_MEMORY;
     }
 
-    utf8_to_utf16(str8, length, (char16_t*)str16, (size_t)len16 + 1);
+    if (ascii) {
+        asciiToUtf16(string, length, (char16_t*)str16);
+        ((char16_t*)str16)[length] = 0;
+    } else {
+        utf8_to_utf16(str8, length, (char16_t*)str16, (size_t)len16 + 1);
+    }
 
     return STATUS_OK;
 }
@@ -375,8 +390,9 @@ binder_status_t AParcel_readString(const AParcel* parcel, void* stringData,
 
     ssize_t len8;
 
-    if (len16 == 0) {
-        len8 = 1;
+    const bool ascii = isAscii(str16, len16);
+    if (ascii) {
+        len8 = len16 + 1;
     } else {
         len8 = utf16_to_utf8_length(str16, len16) + 1;
     }
@@ -394,7 +410,12 @@ binder_status_t AParcel_readString(const AParcel* parcel, void* stringData,
         return STATUS_NO_MEMORY;
     }
 
-    utf16_to_utf8(str16, len16, str8, len8);
+    if (ascii) {
+        asciiToUtf8(str16, len16, str8);
+        str8[len16] = '\0';
+    } else {
+        utf16_to_utf8(str16, len16, str8, len8);
+    }
 
     return STATUS_OK;
 }
@@ -618,7 +639,7 @@ binder_status_t AParcel_writeDoubleArray(AParcel* parcel, const double* arrayDat
 
 binder_status_t AParcel_writeBoolArray(AParcel* parcel, const void* arrayData, int32_t length,
                                        AParcel_boolArrayGetter getter) {
-    return WriteArray<bool>(parcel, arrayData, length, getter, &Parcel::writeBool);
+    return WriteArray<bool>(parcel, arrayData, length, getter);
 }
 
 binder_status_t AParcel_writeCharArray(AParcel* parcel, const char16_t* arrayData, int32_t length) {
@@ -662,7 +683,7 @@ binder_status_t AParcel_readDoubleArray(const AParcel* parcel, void* arrayData,
 binder_status_t AParcel_readBoolArray(const AParcel* parcel, void* arrayData,
                                       AParcel_boolArrayAllocator allocator,
                                       AParcel_boolArraySetter setter) {
-    return ReadArray<bool>(parcel, arrayData, allocator, setter, &Parcel::readBool);
+    return ReadArray<bool>(parcel, arrayData, allocator, setter);
 }
 
 binder_status_t AParcel_readCharArray(const AParcel* parcel, void* arrayData,
@@ -16,6 +16,13 @@
 
 use std::future::Future;
 use std::pin::Pin;
+#[cfg(not(trusty))]
+use std::{
+    pin::pin,
+    sync::Arc,
+    task::{Context, Poll, Wake, Waker},
+    thread::Thread,
+};
 
 /// A type alias for a pinned, boxed future that lets you write shorter code without littering it
 /// with Pin and Send bounds.
@@ -62,3 +69,75 @@ pub trait BinderAsyncRuntime {
     /// Block on the provided future, running it to completion and returning its output.
     fn block_on<F: Future>(&self, future: F) -> F::Output;
 }
+
+/// A [`BinderAsyncPool`] which runs binder transactions on the thread polling the future.
+///
+/// Binder transactions block the calling thread until the reply arrives, so this is mostly
+/// useful together with [`CurrentThreadRuntime`], or any executor where one future is polled per
+/// thread, to avoid handing every transaction over to another thread. It also lets the binder
+/// driver apply its deadlock prevention to calls made while handling a transaction, because they
+/// are sent from the binder thread handling it.
+#[cfg(not(trusty))]
+pub enum CurrentThread {}
+
+#[cfg(not(trusty))]
+impl BinderAsyncPool for CurrentThread {
+    fn spawn<'a, F1, F2, Fut, A, B, E>(spawn_me: F1, after_spawn: F2) -> BoxFuture<'a, Result<B, E>>
+    where
+        F1: FnOnce() -> A,
+        F2: FnOnce(A) -> Fut,
+        Fut: Future<Output = Result<B, E>>,
+        F1: Send + 'static,
+        F2: Send + 'a,
+        Fut: Send + 'a,
+        A: Send + 'static,
+        B: Send + 'a,
+        E: From<crate::StatusCode>,
+    {
+        Box::pin(async move { after_spawn(spawn_me()).await })
+    }
+}
+
+/// A [`BinderAsyncRuntime`] which drives the future of each incoming transaction on the binder
+/// thread that received it, without any other thread or a separate runtime.
+///
+/// The binder thread is parked while the future is pending, and resumed when it is woken, so the
+/// method implementation may await futures completed from other threads. Those futures must not
+/// depend on a runtime of their own, such as Tokio timers or IO.
+///
+/// ```text
+/// let service = BnFoo::new_async_binder(FooService, CurrentThreadRuntime, features);
+/// ```
+#[cfg(not(trusty))]
+#[derive(Clone, Copy, Debug, Default)]
+pub struct CurrentThreadRuntime;
+
+#[cfg(not(trusty))]
+struct ThreadWaker(Thread);
+
+#[cfg(not(trusty))]
+impl Wake for ThreadWaker {
+    fn wake(self: Arc<Self>) {
+        self.0.unpark();
+    }
+
+    fn wake_by_ref(self: &Arc<Self>) {
+        self.0.unpark();
+    }
+}
+
+#[cfg(not(trusty))]
+impl BinderAsyncRuntime for CurrentThreadRuntime {
+    fn block_on<F: Future>(&self, future: F) -> F::Output {
+        let mut future = pin!(future);
+        let waker = Waker::from(Arc::new(ThreadWaker(std::thread::current())));
+        let mut context = Context::from_waker(&waker);
+        loop {
+            if let Poll::Ready(output) = future.as_mut().poll(&mut context) {
+                return output;
+            }
+            // A spurious wakeup only causes an extra poll.
+            std::thread::park();
+        }
+    }
+}
@@ -389,7 +389,8 @@ mod tests {
     };
     // Import from impl API for testing only, should not be necessary as long as
     // you are using AIDL.
-    use binder::binder_impl::{Binder, IBinderInternal, TransactionCode};
+    use binder::binder_impl::{Binder, BinderAsyncRuntime, IBinderInternal, TransactionCode};
+    use binder::{CurrentThread, CurrentThreadRuntime};
 
     use binder_tokio::Tokio;
 
@@ -589,6 +590,18 @@ mod tests {
         assert_eq!(test_client.test().await.unwrap(), "trivial_client_test");
     }
 
+    #[test]
+    fn trivial_client_current_thread() {
+        let service_name = "trivial_client_test";
+        let _process = ScopedServiceProcess::new(service_name);
+        let test_client: Strong<dyn IATest<CurrentThread>> =
+            binder::get_interface(service_name).expect("Did not get manager binder service");
+        assert_eq!(
+            CurrentThreadRuntime.block_on(test_client.test()).unwrap(),
+            "trivial_client_test"
+        );
+    }
+
     #[test]
     fn wait_for_trivial_client() {
         let service_name = "wait_for_trivial_client_test";
@@ -216,12 +216,38 @@ TEST(BinderAllocation, SmallTransaction) {
     size_t mallocs = 0;
     const auto on_malloc = OnMalloc([&](size_t bytes) {
         mallocs++;
-        // Parcel should allocate a small amount by default
-        EXPECT_EQ(bytes, 128u);
+        // Parcel should allocate a small, poolable amount by default
+        EXPECT_EQ(bytes, 256u);
     });
     manager->checkService(empty_descriptor);
 
-    EXPECT_EQ(mallocs, 1u);
+    // none if an earlier Parcel on this thread left its data to be reused
+    EXPECT_LE(mallocs, 1u);
+}
+
+TEST(BinderAllocation, SmallTransactionReusesParcelData) {
+    String16 empty_descriptor = String16("");
+    sp<IServiceManager> manager = defaultServiceManager();
+
+    // leaves a small data buffer for this thread to reuse
+    manager->checkService(empty_descriptor);
+
+    const auto m = ScopeDisallowMalloc();
+    manager->checkService(empty_descriptor);
+}
+
+TEST(BinderAllocation, SmallParcelsReuseData) {
+    { // first use on this thread may allocate
+        Parcel p;
+        p.writeInt32(0);
+    }
+
+    const auto m = ScopeDisallowMalloc();
+    for (size_t i = 0; i < 10; i++) {
+        Parcel p;
+        p.writeInt32(0);
+        imaginary_use = p.data();
+    }
 }
 
 TEST(RpcBinderAllocation, SetupRpcServer) {
@@ -24,7 +24,10 @@
 #include "fakeservicemanager/FakeServiceManager.h"
 
 #include <sys/prctl.h>
+#include <algorithm>
+#include <map>
 #include <thread>
+#include <vector>
 
 using namespace android;
 
@@ -63,6 +66,7 @@ public:
     MockAidlServiceManager() : innerSm() {}
 
     binder::Status checkService(const ::std::string& name, os::Service* _out) override {
+        checkServiceCount++;
         sp<IBinder> binder = innerSm.getService(String16(name.c_str()));
         *_out = os::Service::make<os::Service::Tag::binder>(binder);
         return binder::Status::ok();
@@ -70,18 +74,42 @@ public:
 
     binder::Status addService(const std::string& name, const sp<IBinder>& service,
                               bool allowIsolated, int32_t dumpPriority) override {
-        return binder::Status::fromStatusT(
+        binder::Status status = binder::Status::fromStatusT(
                 innerSm.addService(String16(name.c_str()), service, allowIsolated, dumpPriority));
+        if (status.isOk()) {
+            // Copied, since callbacks may unregister themselves.
+            std::vector<sp<os::IServiceCallback>> callbacks = registrationCallbacks[name];
+            for (const auto& callback : callbacks) {
+                callback->onRegistration(name, service);
+            }
+        }
+        return status;
+    }
+
+    binder::Status registerForNotifications(const std::string& name,
+                                            const sp<os::IServiceCallback>& callback) override {
+        registrationCallbacks[name].push_back(callback);
+        return binder::Status::ok();
+    }
+
+    binder::Status unregisterForNotifications(const std::string& name,
+                                              const sp<os::IServiceCallback>& callback) override {
+        auto& callbacks = registrationCallbacks[name];
+        callbacks.erase(std::remove(callbacks.begin(), callbacks.end(), callback),
+                        callbacks.end());
+        return binder::Status::ok();
     }
 
     FakeServiceManager innerSm;
+    std::map<std::string, std::vector<sp<os::IServiceCallback>>> registrationCallbacks;
+    size_t checkServiceCount = 0;
 };
 
 class LibbinderCacheTest : public ::testing::Test {
 protected:
     void SetUp() override {
-        sp<MockAidlServiceManager> sm = sp<MockAidlServiceManager>::make();
-        mServiceManager = getServiceManagerShimFromAidlServiceManagerForTests(sm);
+        mAidlServiceManager = sp<MockAidlServiceManager>::make();
+        mServiceManager = getServiceManagerShimFromAidlServiceManagerForTests(mAidlServiceManager);
     }
 
     void TearDown() override {}
@@ -108,6 +136,7 @@ public:
         }
     }
 
+    sp<MockAidlServiceManager> mAidlServiceManager;
     sp<android::IServiceManager> mServiceManager;
 };
 
@@ -171,6 +200,21 @@ TEST_F(LibbinderCacheTest, NullBinderNotCached) {
     EXPECT_EQ(binder2, result);
 }
 
+TEST_F(LibbinderCacheTest, AbsentServiceCachedUntilRegistered) {
+    String16 serviceName = String16("NewLibbinderCacheTest");
+
+    // Absent services are remembered regardless of the static list.
+    EXPECT_EQ(nullptr, mServiceManager->checkService(serviceName));
+    EXPECT_EQ(nullptr, mServiceManager->checkService(serviceName));
+    EXPECT_EQ(kUseLibbinderCache ? 1u : 2u, mAidlServiceManager->checkServiceCount);
+
+    // Registering the service invalidates the entry.
+    sp<IBinder> binder = sp<BBinder>::make();
+    EXPECT_EQ(OK, mServiceManager->addService(serviceName, binder));
+    EXPECT_EQ(binder, mServiceManager->checkService(serviceName));
+    EXPECT_TRUE(mAidlServiceManager->registrationCallbacks[String8(serviceName).c_str()].empty());
+}
+
 TEST_F(LibbinderCacheTest, DoNotCacheServiceNotInList) {
     sp<IBinder> binder1 = sp<BBinder>::make();
     sp<IBinder> binder2 = sp<BBinder>::make();
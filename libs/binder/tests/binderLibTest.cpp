@@ -20,8 +20,10 @@
 #include <stdio.h>
 #include <stdlib.h>
 
+#include <algorithm>
 #include <chrono>
 #include <fstream>
+#include <numeric>
 #include <thread>
 
 #include <gmock/gmock.h>
@@ -39,6 +41,7 @@
 #include <binder/RpcServer.h>
 #include <binder/RpcSession.h>
 #include <binder/Status.h>
+#include <binder/TransactionStats.h>
 #include <binder/unique_fd.h>
 #include <input/BlockingQueue.h>
 #include <processgroup/processgroup.h>
@@ -134,7 +137,8 @@ enum BinderLibTestTranscationCode {
     BINDER_LIB_TEST_LOCK_UNLOCK,
     BINDER_LIB_TEST_PROCESS_LOCK,
     BINDER_LIB_TEST_UNLOCK_AFTER_MS,
-    BINDER_LIB_TEST_PROCESS_TEMPORARY_LOCK
+    BINDER_LIB_TEST_PROCESS_TEMPORARY_LOCK,
+    BINDER_LIB_TEST_GET_THREAD_POOL_STATS,
 };
 
 pid_t start_server_process(int arg2, bool usePoll = false)
@@ -617,6 +621,28 @@ TEST_F(BinderLibTest, NopTransaction) {
                 StatusEq(NO_ERROR));
 }
 
+TEST_F(BinderLibTest, NopTransactionRecordedInStats) {
+    using android::binder::debug::TransactionStats;
+    TransactionStats::reset();
+    TransactionStats::setEnabled(true);
+    Parcel data, reply;
+    EXPECT_THAT(m_server->transact(BINDER_LIB_TEST_NOP_TRANSACTION, data, &reply),
+                StatusEq(NO_ERROR));
+    TransactionStats::setEnabled(false);
+
+    std::vector<TransactionStats::Entry> entries = TransactionStats::snapshot();
+    auto it = std::find_if(entries.begin(), entries.end(), [](const auto& entry) {
+        return !entry.incoming && entry.code == BINDER_LIB_TEST_NOP_TRANSACTION;
+    });
+    ASSERT_NE(it, entries.end());
+    EXPECT_EQ(1u, it->count);
+    EXPECT_EQ(1u,
+              std::accumulate(it->latencyHistogram.begin(), it->latencyHistogram.end(),
+                              uint64_t{0}));
+    EXPECT_EQ(data.dataSize(), it->totalDataBytes);
+    TransactionStats::reset();
+}
+
 TEST_F(BinderLibTest, NopTransactionOneway) {
     Parcel data, reply;
     EXPECT_THAT(m_server->transact(BINDER_LIB_TEST_NOP_TRANSACTION, data, &reply, TF_ONE_WAY),
@@ -1823,6 +1849,23 @@ TEST_F(BinderLibTest, ThreadPoolAvailableThreads) {
     EXPECT_EQ(replyi, kKernelThreads + 2);
 }
 
+TEST_F(BinderLibTest, ThreadPoolStats) {
+    Parcel data, reply;
+    sp<IBinder> server = addServer();
+    ASSERT_TRUE(server != nullptr);
+    EXPECT_THAT(server->transact(BINDER_LIB_TEST_GET_THREAD_POOL_STATS, data, &reply),
+                StatusEq(NO_ERROR));
+    uint64_t maxThreads = reply.readUint64();
+    uint64_t currentThreads = reply.readUint64();
+    uint64_t executingThreads = reply.readUint64();
+    uint64_t peakExecutingThreads = reply.readUint64();
+    EXPECT_EQ(static_cast<uint64_t>(kKernelThreads), maxThreads);
+    EXPECT_GE(currentThreads, 1u);
+    // At least this transaction is being executed.
+    EXPECT_GE(executingThreads, 1u);
+    EXPECT_GE(peakExecutingThreads, executingThreads);
+}
+
 TEST_F(BinderLibTest, ThreadPoolStarted) {
     Parcel data, reply;
     sp<IBinder> server = addServer();
@@ -2465,6 +2508,14 @@ public:
                 reply->writeInt32(ProcessState::self()->getThreadPoolMaxTotalThreadCount());
                 return NO_ERROR;
             }
+            case BINDER_LIB_TEST_GET_THREAD_POOL_STATS: {
+                ProcessState::ThreadPoolStats stats = ProcessState::self()->getThreadPoolStats();
+                reply->writeUint64(stats.maxThreads);
+                reply->writeUint64(stats.currentThreads);
+                reply->writeUint64(stats.executingThreads);
+                reply->writeUint64(stats.peakExecutingThreads);
+                return NO_ERROR;
+            }
             case BINDER_LIB_TEST_IS_THREADPOOL_STARTED: {
                 reply->writeBool(ProcessState::self()->isThreadPoolStarted());
                 return NO_ERROR;
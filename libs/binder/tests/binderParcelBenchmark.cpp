@@ -14,9 +14,14 @@
  * limitations under the License.
  */
 
+#include <android/binder_parcel.h>
 #include <binder/Parcel.h>
+#include <binder/PersistableBundle.h>
 #include <benchmark/benchmark.h>
 
+#include <string>
+#include <vector>
+
 // Usage: atest binderParcelBenchmark
 
 // For static assert(false) we need a template version to avoid early failure.
@@ -65,6 +70,13 @@ static void VectorArgs(benchmark::internal::Benchmark* b) {
     }
 }
 
+// Construct a series of args { 1 << 10, 1 << 12, ..., 1 << 20 }
+static void BulkArgs(benchmark::internal::Benchmark* b) {
+    for (int i = 10; i <= 20; i += 2) {
+        b->Args({1 << i});
+    }
+}
+
 template <typename T>
 static void BM_ParcelVector(benchmark::State& state) {
     const size_t elements = state.range(0);
@@ -83,6 +95,7 @@ static void BM_ParcelVector(benchmark::State& state) {
         benchmark::ClobberMemory();
     }
     state.SetComplexityN(elements);
+    state.SetBytesProcessed(int64_t(state.iterations()) * int64_t(elements * sizeof(T)));
 }
 
 /*
@@ -163,10 +176,155 @@ static void BM_Int64Vector(benchmark::State& state) {
     BM_ParcelVector<int64_t>(state);
 }
 
+/*
+  A new Parcel for each write, the way each transaction makes one. Parcels of
+  up to 256 bytes reuse data buffers freed earlier on the same thread, so this
+  measures the cost with no malloc or free, up to and past that size.
+*/
+static void BM_ParcelLifecycle(benchmark::State& state) {
+    const size_t elements = state.range(0);
+
+    while (state.KeepRunning()) {
+        android::Parcel p;
+        for (size_t i = 0; i < elements; i++) {
+            p.writeInt32(0);
+        }
+        benchmark::DoNotOptimize(p.data());
+    }
+    state.SetComplexityN(elements);
+}
+
+// NDK arrays are written from, and read into, std::vector through the callbacks that the NDK
+// C++ wrappers use.
+template <typename T>
+static bool ndkAllocate(void* arrayData, int32_t length, T** outBuffer) {
+    auto* v = static_cast<std::vector<T>*>(arrayData);
+    v->resize(length);
+    *outBuffer = v->data();
+    return true;
+}
+
+static bool ndkAllocateBool(void* arrayData, int32_t length) {
+    static_cast<std::vector<bool>*>(arrayData)->resize(length);
+    return true;
+}
+
+static bool ndkGetBool(const void* arrayData, size_t index) {
+    return (*static_cast<const std::vector<bool>*>(arrayData))[index];
+}
+
+static void ndkSetBool(void* arrayData, size_t index, bool value) {
+    (*static_cast<std::vector<bool>*>(arrayData))[index] = value;
+}
+
+template <typename T>
+static void ndkWriteArray(AParcel* p, const std::vector<T>& v) {
+    if constexpr (std::is_same_v<T, bool>) {
+        AParcel_writeBoolArray(p, &v, v.size(), ndkGetBool);
+    } else if constexpr (std::is_same_v<T, char16_t>) {
+        AParcel_writeCharArray(p, v.data(), v.size());
+    } else if constexpr (std::is_same_v<T, int32_t>) {
+        AParcel_writeInt32Array(p, v.data(), v.size());
+    } else if constexpr (std::is_same_v<T, int64_t>) {
+        AParcel_writeInt64Array(p, v.data(), v.size());
+    } else {
+        static_assert(dependent_false_v<T>);
+    }
+}
+
+template <typename T>
+static void ndkReadArray(const AParcel* p, std::vector<T>* v) {
+    if constexpr (std::is_same_v<T, bool>) {
+        AParcel_readBoolArray(p, v, ndkAllocateBool, ndkSetBool);
+    } else if constexpr (std::is_same_v<T, char16_t>) {
+        AParcel_readCharArray(p, v, ndkAllocate<char16_t>);
+    } else if constexpr (std::is_same_v<T, int32_t>) {
+        AParcel_readInt32Array(p, v, ndkAllocate<int32_t>);
+    } else if constexpr (std::is_same_v<T, int64_t>) {
+        AParcel_readInt64Array(p, v, ndkAllocate<int64_t>);
+    } else {
+        static_assert(dependent_false_v<T>);
+    }
+}
+
+template <typename T>
+static void BM_NdkParcelArray(benchmark::State& state) {
+    const size_t elements = state.range(0);
+
+    std::vector<T> v1(elements);
+    std::vector<T> v2(elements);
+    AParcel* p = AParcel_create();
+    while (state.KeepRunning()) {
+        AParcel_setDataPosition(p, 0);
+        ndkWriteArray(p, v1);
+
+        AParcel_setDataPosition(p, 0);
+        ndkReadArray(p, &v2);
+
+        benchmark::DoNotOptimize(v2.size());
+        benchmark::ClobberMemory();
+    }
+    AParcel_delete(p);
+    state.SetComplexityN(elements);
+    state.SetBytesProcessed(int64_t(state.iterations()) * int64_t(elements * sizeof(T)));
+}
+
+static void BM_NdkBoolArray(benchmark::State& state) {
+    BM_NdkParcelArray<bool>(state);
+}
+
+static void BM_NdkCharArray(benchmark::State& state) {
+    BM_NdkParcelArray<char16_t>(state);
+}
+
+static void BM_NdkInt32Array(benchmark::State& state) {
+    BM_NdkParcelArray<int32_t>(state);
+}
+
+static void BM_NdkInt64Array(benchmark::State& state) {
+    BM_NdkParcelArray<int64_t>(state);
+}
+
+// Reads a bundle with the given number of int and string entries, as passed to jobs.
+static void BM_PersistableBundle(benchmark::State& state) {
+    const size_t entries = state.range(0);
+
+    android::os::PersistableBundle bundle;
+    for (size_t i = 0; i < entries; i++) {
+        const android::String16 key(std::to_string(i).c_str());
+        bundle.putInt(key + android::String16("_int"), i);
+        bundle.putString(key + android::String16("_string"), key);
+    }
+    android::Parcel p;
+    bundle.writeToParcel(&p);
+
+    while (state.KeepRunning()) {
+        p.setDataPosition(0);
+        android::os::PersistableBundle read;
+        read.readFromParcel(&p);
+
+        benchmark::DoNotOptimize(read.size());
+        benchmark::ClobberMemory();
+    }
+    state.SetComplexityN(entries);
+}
+
 BENCHMARK(BM_BoolVector)->Apply(VectorArgs);
 BENCHMARK(BM_ByteVector)->Apply(VectorArgs);
 BENCHMARK(BM_CharVector)->Apply(VectorArgs);
 BENCHMARK(BM_Int32Vector)->Apply(VectorArgs);
 BENCHMARK(BM_Int64Vector)->Apply(VectorArgs);
+BENCHMARK(BM_ParcelLifecycle)->Apply(VectorArgs);
+BENCHMARK(BM_PersistableBundle)->RangeMultiplier(4)->Range(1, 256);
+
+// Bulk throughput, for 1K to 1M elements.
+BENCHMARK(BM_BoolVector)->Apply(BulkArgs);
+BENCHMARK(BM_CharVector)->Apply(BulkArgs);
+BENCHMARK(BM_Int32Vector)->Apply(BulkArgs);
+BENCHMARK(BM_Int64Vector)->Apply(BulkArgs);
+BENCHMARK(BM_NdkBoolArray)->Apply(VectorArgs)->Apply(BulkArgs);
+BENCHMARK(BM_NdkCharArray)->Apply(VectorArgs)->Apply(BulkArgs);
+BENCHMARK(BM_NdkInt32Array)->Apply(VectorArgs)->Apply(BulkArgs);
+BENCHMARK(BM_NdkInt64Array)->Apply(VectorArgs)->Apply(BulkArgs);
 
 BENCHMARK_MAIN();
@@ -355,6 +355,31 @@ TEST(Parcel, Utf8AsUtf16Write) {
     });
 }
 
+TEST(Parcel, Utf8Utf16RoundTrip) {
+    const std::vector<std::string> tokens = {"", "android.os.IServiceManager", "caf\xc3\xa9",
+                                             "\xf0\x9f\x98\x80!"};
+    for (const std::string& token : tokens) {
+        parcelOpSameLength([&] (Parcel* p) {
+            EXPECT_EQ(OK, p->writeUtf8AsUtf16(token));
+        }, [&] (Parcel* p) {
+            std::string s;
+            EXPECT_EQ(OK, p->readUtf8FromUtf16(&s));
+            EXPECT_EQ(token, s);
+        });
+    }
+}
+
+TEST(Parcel, Utf8AsUtf16WriteNonAscii) {
+    std::string token = "caf\xc3\xa9";
+    parcelOpSameLength([&] (Parcel* p) {
+        p->writeUtf8AsUtf16(token);
+    }, [&] (Parcel* p) {
+        String16 s;
+        EXPECT_EQ(OK, p->readString16(&s));
+        EXPECT_EQ(s, String16(u"caf\u00e9"));
+    });
+}
+
 template <typename T>
 using readFunc = status_t (Parcel::*)(T* out) const;
 template <typename T>
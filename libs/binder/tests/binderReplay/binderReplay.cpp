@@ -0,0 +1,277 @@
+/*
+ * Copyright (C) 2024 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <binder/IBinder.h>
+#include <binder/IServiceManager.h>
+#include <binder/Parcel.h>
+#include <binder/RecordedTransaction.h>
+#include <binder/unique_fd.h>
+
+#include <fcntl.h>
+#include <inttypes.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <map>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+using android::defaultServiceManager;
+using android::IBinder;
+using android::OK;
+using android::Parcel;
+using android::sp;
+using android::status_t;
+using android::String16;
+using android::binder::unique_fd;
+using android::binder::debug::RecordedTransaction;
+using Clock = std::chrono::steady_clock;
+
+namespace {
+
+struct Options {
+    const char* serviceName = nullptr;
+    std::vector<const char*> recordingPaths;
+    // 1 replays at the recorded pace, 2 twice as fast, and 0 as fast as possible.
+    double speed = 1.0;
+    size_t concurrency = 1;
+    size_t loops = 1;
+};
+
+struct ScheduledTransaction {
+    // From the first recorded transaction.
+    std::chrono::nanoseconds offset;
+    size_t index;
+};
+
+struct Recordings {
+    std::vector<RecordedTransaction> transactions;
+    // In timestamp order across files.
+    std::vector<ScheduledTransaction> schedule;
+};
+
+struct CodeStats {
+    std::vector<uint64_t> latenciesNs;
+    size_t errors = 0;
+};
+
+struct Results {
+    std::mutex mutex;
+    std::map<uint32_t, CodeStats> byCode;
+    // How late transactions were sent compared to their schedule.
+    std::vector<uint64_t> lagsNs;
+};
+
+void printHelp(const char* toolName) {
+    std::cout << "Usage: \n\n"
+              << toolName
+              << " [-s SPEED] [-j CONCURRENCY] [-n LOOPS] <service_name> <recording_path>...\n\n"
+                 "Replays recorded transactions against a running service, keeping the recorded\n"
+                 "time between them, and reports the latency of each transaction code.\n\n"
+                 "  -s SPEED: scale the recorded timing, 2 replays twice as fast, 0 as fast as\n"
+                 "            possible (default 1)\n"
+                 "  -j CONCURRENCY: number of threads sending transactions (default 1)\n"
+                 "  -n LOOPS: number of times to replay the recordings (default 1)\n\n"
+                 "*Use record_binder tool for recording binder transactions. Transactions\n"
+                 "carrying binders or file descriptors can't be replayed and are skipped."
+              << std::endl;
+}
+
+bool parseOptions(int argc, char** argv, Options* options) {
+    int opt;
+    while ((opt = getopt(argc, argv, "s:j:n:h")) != -1) {
+        char* end = nullptr;
+        switch (opt) {
+            case 's':
+                options->speed = strtod(optarg, &end);
+                if (*end != '\0' || options->speed < 0) return false;
+                break;
+            case 'j':
+                options->concurrency = strtoul(optarg, &end, 10);
+                if (*end != '\0' || options->concurrency == 0) return false;
+                break;
+            case 'n':
+                options->loops = strtoul(optarg, &end, 10);
+                if (*end != '\0' || options->loops == 0) return false;
+                break;
+            default:
+                return false;
+        }
+    }
+    if (argc - optind < 2) return false;
+    options->serviceName = argv[optind];
+    for (int i = optind + 1; i < argc; i++) {
+        options->recordingPaths.push_back(argv[i]);
+    }
+    return true;
+}
+
+std::chrono::nanoseconds toDuration(timespec ts) {
+    return std::chrono::seconds(ts.tv_sec) + std::chrono::nanoseconds(ts.tv_nsec);
+}
+
+bool readRecordings(const Options& options, Recordings* recordings) {
+    size_t skipped = 0;
+    for (const char* path : options.recordingPaths) {
+        unique_fd fd(open(path, O_RDONLY | O_CLOEXEC));
+        if (!fd.ok()) {
+            std::cerr << "Failed to open recording file at path " << path
+                      << " with error: " << strerror(errno) << std::endl;
+            return false;
+        }
+        while (auto transaction = RecordedTransaction::fromFile(fd)) {
+            if (!transaction->getObjectOffsets().empty()) {
+                skipped++;
+                continue;
+            }
+            recordings->schedule.push_back(ScheduledTransaction{
+                    .offset = toDuration(transaction->getTimestamp()),
+                    .index = recordings->transactions.size(),
+            });
+            recordings->transactions.push_back(std::move(*transaction));
+        }
+    }
+    if (recordings->schedule.empty()) {
+        std::cerr << "No replayable transaction has been found in the recordings, " << skipped
+                  << " skipped." << std::endl;
+        return false;
+    }
+    auto& schedule = recordings->schedule;
+    std::stable_sort(schedule.begin(), schedule.end(),
+                     [](const auto& a, const auto& b) { return a.offset < b.offset; });
+    const std::chrono::nanoseconds first = schedule.front().offset;
+    for (ScheduledTransaction& scheduled : schedule) {
+        scheduled.offset -= first;
+    }
+    std::cout << "Replaying " << schedule.size() << " transactions, " << skipped
+              << " skipped because they carry binders or file descriptors." << std::endl;
+    return true;
+}
+
+void replay(const Options& options, const sp<IBinder>& binder, const Recordings& recordings,
+            Results* results) {
+    const auto& schedule = recordings.schedule;
+    const std::chrono::nanoseconds loopDuration = schedule.back().offset;
+    const size_t total = schedule.size() * options.loops;
+    std::atomic<size_t> next = 0;
+    const Clock::time_point start = Clock::now();
+
+    auto worker = [&]() {
+        for (size_t i = next++; i < total; i = next++) {
+            const ScheduledTransaction& transaction = schedule[i % schedule.size()];
+            const size_t loop = i / schedule.size();
+
+            Clock::time_point scheduled = start;
+            if (options.speed > 0) {
+                scheduled += std::chrono::duration_cast<Clock::duration>(
+                        (loopDuration * loop + transaction.offset) / options.speed);
+                std::this_thread::sleep_until(scheduled);
+            }
+
+            const RecordedTransaction& recording = recordings.transactions[transaction.index];
+            Parcel data;
+            data.setData(recording.getDataParcel().data(), recording.getDataParcel().dataSize());
+            Parcel reply;
+            const bool oneway = recording.getFlags() & IBinder::FLAG_ONEWAY;
+
+            const Clock::time_point sent = Clock::now();
+            status_t status = binder->transact(recording.getCode(), data,
+                                               oneway ? nullptr : &reply, recording.getFlags());
+            const Clock::time_point done = Clock::now();
+
+            std::lock_guard<std::mutex> lock(results->mutex);
+            CodeStats& stats = results->byCode[recording.getCode()];
+            if (status != OK) {
+                stats.errors++;
+            }
+            stats.latenciesNs.push_back(
+                    std::chrono::duration_cast<std::chrono::nanoseconds>(done - sent).count());
+            if (options.speed > 0) {
+                results->lagsNs.push_back(
+                        std::chrono::duration_cast<std::chrono::nanoseconds>(sent - scheduled)
+                                .count());
+            }
+        }
+    };
+
+    std::vector<std::thread> threads;
+    for (size_t i = 0; i < options.concurrency; i++) {
+        threads.emplace_back(worker);
+    }
+    for (auto& thread : threads) {
+        thread.join();
+    }
+
+    const auto elapsed = std::chrono::duration<double>(Clock::now() - start);
+    std::cout << "Replayed " << total << " transactions in " << elapsed.count() << "s"
+              << std::endl;
+}
+
+void printDistribution(const char* name, std::vector<uint64_t>& samplesNs) {
+    std::sort(samplesNs.begin(), samplesNs.end());
+    const auto percentileUs = [&](double p) {
+        return samplesNs[static_cast<size_t>(p * (samplesNs.size() - 1))] / 1000.0;
+    };
+    printf("%-12s %8zu %10.1f %10.1f %10.1f %10.1f", name, samplesNs.size(), percentileUs(0.5),
+           percentileUs(0.9), percentileUs(0.99), samplesNs.back() / 1000.0);
+}
+
+void printResults(Results* results) {
+    printf("%-12s %8s %10s %10s %10s %10s %8s\n", "code", "count", "p50(us)", "p90(us)",
+           "p99(us)", "max(us)", "errors");
+    for (auto& [code, stats] : results->byCode) {
+        const std::string name = std::to_string(code);
+        printDistribution(name.c_str(), stats.latenciesNs);
+        printf(" %8zu\n", stats.errors);
+    }
+    if (!results->lagsNs.empty()) {
+        printDistribution("send lag", results->lagsNs);
+        printf("\n");
+    }
+}
+
+} // namespace
+
+int main(int argc, char** argv) {
+    Options options;
+    if (!parseOptions(argc, argv, &options)) {
+        printHelp(argv[0]);
+        return 1;
+    }
+
+    Recordings recordings;
+    if (!readRecordings(options, &recordings)) {
+        return 1;
+    }
+
+    sp<IBinder> binder = defaultServiceManager()->checkService(String16(options.serviceName));
+    if (binder == nullptr) {
+        std::cerr << "Can't find service: " << options.serviceName << std::endl;
+        return 1;
+    }
+
+    Results results;
+    replay(options, binder, recordings, &results);
+    printResults(&results);
+    return 0;
+}
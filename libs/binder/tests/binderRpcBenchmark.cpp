@@ -28,10 +28,14 @@
 #include <binder/RpcTlsTestUtils.h>
 #include <binder/RpcTlsUtils.h>
 #include <binder/RpcTransportRaw.h>
+#include <binder/RpcTransportShm.h>
 #include <binder/RpcTransportTls.h>
 #include <openssl/ssl.h>
 
+#include <algorithm>
+#include <chrono>
 #include <thread>
+#include <vector>
 
 #include <signal.h>
 #include <sys/prctl.h>
@@ -54,6 +58,7 @@ using android::RpcServer;
 using android::RpcSession;
 using android::RpcTransportCtxFactory;
 using android::RpcTransportCtxFactoryRaw;
+using android::RpcTransportCtxFactoryShm;
 using android::RpcTransportCtxFactoryTls;
 using android::sp;
 using android::status_t;
@@ -118,6 +123,7 @@ enum Transport {
     KERNEL,
     RPC,
     RPC_TLS,
+    RPC_SHM,
 };
 
 static const std::initializer_list<int64_t> kTransportList = {
@@ -126,8 +132,13 @@ static const std::initializer_list<int64_t> kTransportList = {
 #endif
         Transport::RPC,
         Transport::RPC_TLS,
+        Transport::RPC_SHM,
 };
 
+// The most client threads used by BM_scalingForTransportAndBytes, and the number of threads of
+// each RPC server, so that the clients don't have to wait for a connection.
+static constexpr int kMaxScalingThreads = 8;
+
 std::unique_ptr<RpcTransportCtxFactory> makeFactoryTls() {
     auto pkey = android::makeKeyPairForSelfSignedCert();
     CHECK_NE(pkey.get(), nullptr);
@@ -145,6 +156,8 @@ static sp<IBinder> gRpcBinder;
 // Skip certificate validation to simplify the setup process.
 static sp<RpcSession> gSessionTls = RpcSession::make(makeFactoryTls());
 static sp<IBinder> gRpcTlsBinder;
+static sp<RpcSession> gSessionShm = RpcSession::make(RpcTransportCtxFactoryShm::make());
+static sp<IBinder> gRpcShmBinder;
 #ifdef __BIONIC__
 static const String16 kKernelBinderInstance = String16(u"binderRpcBenchmark-control");
 static sp<IBinder> gKernelBinder;
@@ -161,6 +174,8 @@ static sp<IBinder> getBinderForOptions(benchmark::State& state) {
             return gRpcBinder;
         case RPC_TLS:
             return gRpcTlsBinder;
+        case RPC_SHM:
+            return gRpcShmBinder;
         default:
             LOG(FATAL) << "Unknown transport value: " << transport;
             return nullptr;
@@ -181,6 +196,9 @@ static void SetLabel(benchmark::State& state) {
         case RPC_TLS:
             state.SetLabel("rpc_tls");
             break;
+        case RPC_SHM:
+            state.SetLabel("rpc_shm");
+            break;
         default:
             LOG(FATAL) << "Unknown transport value: " << transport;
     }
@@ -248,7 +266,46 @@ void BM_throughputForTransportAndBytes(benchmark::State& state) {
 }
 BENCHMARK(BM_throughputForTransportAndBytes)
         ->ArgsProduct({kTransportList,
-                       {64, 1024, 2048, 4096, 8182, 16364, 32728, 65535, 65536, 65537}});
+                       {64, 1024, 2048, 4096, 8182, 16364, 32728, 65535, 65536, 65537, 262144}});
+
+// Measures the latency of each call while several client threads make calls at the same time, to
+// show contention in IPCThreadState, RpcState or the transports. Run with
+// --benchmark_format=json for a machine-readable report. The percentiles are those of each
+// thread, averaged over the threads.
+void BM_scalingForTransportAndBytes(benchmark::State& state) {
+    sp<IBinder> binder = getBinderForOptions(state);
+    sp<IBinderRpcBenchmark> iface = interface_cast<IBinderRpcBenchmark>(binder);
+    CHECK(iface != nullptr);
+
+    std::vector<uint8_t> bytes = std::vector<uint8_t>(state.range(1));
+    std::vector<int64_t> latenciesNs;
+
+    for (auto _ : state) {
+        std::vector<uint8_t> out;
+        auto start = std::chrono::steady_clock::now();
+        Status ret = iface->repeatBytes(bytes, &out);
+        auto end = std::chrono::steady_clock::now();
+        CHECK(ret.isOk()) << ret;
+        latenciesNs.push_back(
+                std::chrono::duration_cast<std::chrono::nanoseconds>(end - start).count());
+    }
+
+    if (!latenciesNs.empty()) {
+        std::sort(latenciesNs.begin(), latenciesNs.end());
+        auto percentileUs = [&](size_t percent) {
+            return benchmark::Counter(latenciesNs[percent * latenciesNs.size() / 100] / 1000.0,
+                                      benchmark::Counter::kAvgThreads);
+        };
+        state.counters["p50_us"] = percentileUs(50);
+        state.counters["p99_us"] = percentileUs(99);
+    }
+
+    SetLabel(state);
+}
+BENCHMARK(BM_scalingForTransportAndBytes)
+        ->ArgsProduct({kTransportList, {64, 4096, 65536}})
+        ->ThreadRange(1, kMaxScalingThreads)
+        ->UseRealTime();
 
 void BM_collectProxies(benchmark::State& state) {
     sp<IBinder> binder = getBinderForOptions(state);
@@ -305,6 +362,7 @@ void forkRpcServer(const char* addr, const sp<RpcServer>& server) {
     if (0 == fork()) {
         prctl(PR_SET_PDEATHSIG, SIGHUP); // racey, okay
         server->setRootObject(sp<MyBinderRpcBenchmark>::make());
+        server->setMaxThreads(kMaxScalingThreads);
         CHECK_EQ(OK, server->setupUnixDomainServer(addr));
         server->join();
         exit(1);
@@ -356,6 +414,12 @@ int main(int argc, char** argv) {
     setupClient(gSessionTls, tlsAddr.c_str());
     gRpcTlsBinder = gSessionTls->getRootObject();
 
+    std::string shmAddr = tmp + "/binderRpcShmBenchmark";
+    (void)unlink(shmAddr.c_str());
+    forkRpcServer(shmAddr.c_str(), RpcServer::make(RpcTransportCtxFactoryShm::make()));
+    setupClient(gSessionShm, shmAddr.c_str());
+    gRpcShmBinder = gSessionShm->getRootObject();
+
     ::benchmark::RunSpecifiedBenchmarks();
     return 0;
 }
@@ -363,6 +363,7 @@ std::unique_ptr<ProcessSession> BinderRpc::createRpcTestSocketServerProcessEtc(
         LOG_ALWAYS_FATAL_IF(!session->setProtocolVersion(clientVersion));
         session->setMaxIncomingThreads(numIncoming);
         session->setMaxOutgoingConnections(options.numOutgoingConnections);
+        session->setMaxAsyncConnections(options.numAsyncConnections);
         session->setFileDescriptorTransportMode(options.clientFileDescriptorTransportMode);
 
         sockaddr_storage addr{};
@@ -532,6 +533,30 @@ TEST_P(BinderRpc, ThreadPoolLimitOutgoing) {
     testThreadPoolOverSaturated(proc.rootIface, kNumCalls, 200 /*ms*/);
 }
 
+TEST_P(BinderRpc, SyncCallNotBlockedByAsyncConnections) {
+    if (clientOrServerSingleThreaded()) {
+        GTEST_SKIP() << "This test requires multiple threads";
+    }
+
+    constexpr size_t kReallyLongTimeMs = 100;
+    constexpr size_t kSleepMs = kReallyLongTimeMs * 5;
+
+    // one connection, and so one server thread, for each kind of call
+    auto proc = createRpcTestSocketServerProcess({.numThreads = 2, .numAsyncConnections = 1});
+
+    // keep the server thread handling oneway calls busy, with another queued
+    // behind it
+    EXPECT_OK(proc.rootIface->sleepMsAsync(kSleepMs));
+    EXPECT_OK(proc.rootIface->sleepMsAsync(kSleepMs));
+
+    size_t epochMsBefore = epochMillis();
+
+    EXPECT_OK(proc.rootIface->sleepMs(0));
+
+    size_t epochMsAfter = epochMillis();
+    EXPECT_LT(epochMsAfter, epochMsBefore + kReallyLongTimeMs);
+}
+
 TEST_P(BinderRpc, ThreadingStressTest) {
     if (clientOrServerSingleThreaded()) {
         GTEST_SKIP() << "This test requires multiple threads";
@@ -1043,6 +1068,24 @@ TEST_P(BinderRpc, SendMaxFiles) {
     EXPECT_EQ(result, std::string(253, 'a'));
 }
 
+TEST_P(BinderRpc, SendLargeDataWithFdTransport) {
+    if (!supportsFdTransport()) {
+        GTEST_SKIP() << "Would fail trivially (which is tested by BinderRpc::SendFiles)";
+    }
+
+    // Large enough to be sent out of line, on protocol versions that support it.
+    auto proc = createRpcTestSocketServerProcess({
+            .clientFileDescriptorTransportMode = RpcSession::FileDescriptorTransportMode::UNIX,
+            .serverSupportedFileDescriptorTransportModes =
+                    {RpcSession::FileDescriptorTransportMode::UNIX},
+    });
+
+    std::string single = std::string(512 * 1024, 'a');
+    std::string doubled;
+    EXPECT_OK(proc.rootIface->doubleString(single, &doubled));
+    EXPECT_EQ(single + single, doubled);
+}
+
 TEST_P(BinderRpc, SendTooManyFiles) {
     if (!supportsFdTransport()) {
         GTEST_SKIP() << "Would fail trivially (which is tested by BinderRpc::SendFiles)";
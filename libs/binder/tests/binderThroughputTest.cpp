@@ -64,6 +64,10 @@ struct ProcResults {
     uint64_t worst() {
         return *max_element(data.begin(), data.end());
     }
+    // Requires data to be sorted and not empty.
+    double percentile_ms(size_t percent) {
+        return data[(percent * data.size()) / 100] / 1.0E6;
+    }
     void dump_to_file(string filename) {
         ofstream output;
         output.open(filename);
@@ -108,10 +112,10 @@ struct ProcResults {
         double average = (double)total_time / data.size() / 1.0E6;
         cout << "average:" << average << "ms worst:" << worst << "ms best:" << best << "ms" << endl;
 
-        double percentile_50 = data[(50 * data.size()) / 100] / 1.0E6;
-        double percentile_90 = data[(90 * data.size()) / 100] / 1.0E6;
-        double percentile_95 = data[(95 * data.size()) / 100] / 1.0E6;
-        double percentile_99 = data[(99 * data.size()) / 100] / 1.0E6;
+        double percentile_50 = percentile_ms(50);
+        double percentile_90 = percentile_ms(90);
+        double percentile_95 = percentile_ms(95);
+        double percentile_99 = percentile_ms(99);
         cout << "50%: " << percentile_50 << " ";
         cout << "90%: " << percentile_90 << " ";
         cout << "95%: " << percentile_95 << " ";
@@ -207,6 +211,7 @@ void worker_fx(int num,
                int iterations,
                int payload_size,
                bool cs_pair,
+               int oneway_batch,
                Pipe p)
 {
     // Create BinderWorkerService and for go.
@@ -250,12 +255,34 @@ void worker_fx(int num,
                 data.writeInt32(0);
                 sz -= sizeof(uint32_t);
             }
-            start = chrono::high_resolution_clock::now();
-            status_t ret = workers[target]->transact(BINDER_NOP, data, &reply);
-            end = chrono::high_resolution_clock::now();
-
-            uint64_t cur_time = uint64_t(chrono::duration_cast<chrono::nanoseconds>(end - start).count());
-            results.add_time(cur_time);
+            status_t ret;
+            if (oneway_batch > 0) {
+                // Each sample is the time to send a whole batch, queued
+                // and flushed, from its first transaction to the flush.
+                bool first = i % oneway_batch == 0;
+                bool last = (i + 1) % oneway_batch == 0 || i + 1 == iterations;
+                if (first) {
+                    start = chrono::high_resolution_clock::now();
+                    if (oneway_batch > 1) IPCThreadState::self()->beginOnewayBatch();
+                }
+                ret = workers[target]->transact(BINDER_NOP, data, nullptr, IBinder::FLAG_ONEWAY);
+                if (last) {
+                    if (oneway_batch > 1) {
+                        status_t flushRet = IPCThreadState::self()->flushOnewayBatch();
+                        if (ret == NO_ERROR) ret = flushRet;
+                    }
+                    end = chrono::high_resolution_clock::now();
+                    results.add_time(uint64_t(
+                            chrono::duration_cast<chrono::nanoseconds>(end - start).count()));
+                }
+            } else {
+                start = chrono::high_resolution_clock::now();
+                ret = workers[target]->transact(BINDER_NOP, data, &reply);
+                end = chrono::high_resolution_clock::now();
+
+                uint64_t cur_time = uint64_t(chrono::duration_cast<chrono::nanoseconds>(end - start).count());
+                results.add_time(cur_time);
+            }
 
             if (ret != NO_ERROR) {
                cout << "thread " << num << " failed " << ret << "i : " << i << endl;
@@ -275,7 +302,8 @@ void worker_fx(int num,
     exit(EXIT_SUCCESS);
 }
 
-Pipe make_worker(int num, int iterations, int worker_count, int payload_size, bool cs_pair)
+Pipe make_worker(int num, int iterations, int worker_count, int payload_size, bool cs_pair,
+                 int oneway_batch)
 {
     auto pipe_pair = Pipe::createPipePair();
     pid_t pid = fork();
@@ -284,7 +312,7 @@ Pipe make_worker(int num, int iterations, int worker_count, int payload_size, bo
         return std::move(get<0>(pipe_pair));
     } else {
         /* child */
-        worker_fx(num, worker_count, iterations, payload_size, cs_pair,
+        worker_fx(num, worker_count, iterations, payload_size, cs_pair, oneway_batch,
                   std::move(get<1>(pipe_pair)));
         /* never get here */
         return std::move(get<0>(pipe_pair));
@@ -306,12 +334,19 @@ void signal_all(vector<Pipe>& v)
     }
 }
 
-void run_main(int iterations, int workers, int payload_size, int cs_pair,
-              bool training_round = false, bool dump_to_file = false, string dump_filename = "") {
+struct RunResults {
+    double iterations_per_sec = 0;
+    double percentile_50_ms = 0;
+    double percentile_99_ms = 0;
+};
+
+RunResults run_main(int iterations, int workers, int payload_size, int cs_pair, int oneway_batch,
+                    bool training_round = false, bool dump_to_file = false,
+                    string dump_filename = "") {
     vector<Pipe> pipes;
     // Create all the workers and wait for them to spawn.
     for (int i = 0; i < workers; i++) {
-        pipes.push_back(make_worker(i, iterations, workers, payload_size, cs_pair));
+        pipes.push_back(make_worker(i, iterations, workers, payload_size, cs_pair, oneway_batch));
     }
     wait_all(pipes);
     // All workers have now been spawned and added themselves to service
@@ -363,6 +398,36 @@ void run_main(int iterations, int workers, int payload_size, int cs_pair,
         }
         tot_results.dump();
     }
+
+    RunResults run_results;
+    run_results.iterations_per_sec = iterations_per_sec;
+    if (!training_round && !tot_results.data.empty()) {
+        // dump() sorted the data.
+        run_results.percentile_50_ms = tot_results.percentile_ms(50);
+        run_results.percentile_99_ms = tot_results.percentile_ms(99);
+    }
+    return run_results;
+}
+
+// Runs every combination of the given worker counts and payload sizes, and prints one CSV line
+// per run, so that contention regressions show up as a change in how the results scale.
+void run_scaling(int iterations, const vector<int>& worker_counts,
+                 const vector<int>& payload_sizes, int cs_pair, int oneway_batch) {
+    vector<tuple<int, int, RunResults>> runs;
+    for (int workers : worker_counts) {
+        for (int payload_size : payload_sizes) {
+            cout << "Start run: " << workers << " workers, " << payload_size << " bytes" << endl;
+            runs.emplace_back(workers, payload_size,
+                              run_main(iterations, workers, payload_size, cs_pair, oneway_batch));
+            cout << endl;
+        }
+    }
+
+    cout << "workers,payload_size,iterations_per_sec,p50_ms,p99_ms" << endl;
+    for (const auto& [workers, payload_size, results] : runs) {
+        cout << workers << "," << payload_size << "," << results.iterations_per_sec << ","
+             << results.percentile_50_ms << "," << results.percentile_99_ms << endl;
+    }
 }
 
 int main(int argc, char *argv[])
@@ -371,10 +436,12 @@ int main(int argc, char *argv[])
     int iterations = 10000;
     int payload_size = 0;
     bool cs_pair = false;
+    int oneway_batch = 0;
     bool training_round = false;
     int max_time_us;
     bool dump_to_file = false;
     string dump_filename;
+    bool scaling = false;
 
     // Parse arguments.
     for (int i = 1; i < argc; i++) {
@@ -382,11 +449,14 @@ int main(int argc, char *argv[])
             cout << "Usage: binderThroughputTest [OPTIONS]" << endl;
             cout << "\t-i N    : Specify number of iterations." << endl;
             cout << "\t-m N    : Specify expected max latency in microseconds." << endl;
+            cout << "\t-o N    : Send oneway transactions, flushed in batches of N." << endl;
             cout << "\t-p      : Split workers into client/server pairs." << endl;
             cout << "\t-s N    : Specify payload size." << endl;
             cout << "\t-t      : Run training round." << endl;
             cout << "\t-w N    : Specify total number of workers." << endl;
             cout << "\t-d FILE : Dump raw data to file." << endl;
+            cout << "\t-S      : Sweep worker counts and payload sizes, and print a CSV summary."
+                 << endl;
             return 0;
         }
         if (string(argv[i]) == "-w") {
@@ -416,6 +486,21 @@ int main(int argc, char *argv[])
             i++;
             continue;
         }
+        if (string(argv[i]) == "-o") {
+            if (i + 1 == argc) {
+                cout << "-o requires an argument\n" << endl;
+                exit(EXIT_FAILURE);
+            }
+            // Batches of 1 send each oneway transaction on its own, for
+            // comparison with larger batches.
+            oneway_batch = atoi(argv[i+1]);
+            if (oneway_batch <= 0) {
+                cout << "Batch size -o must be positive." << endl;
+                exit(EXIT_FAILURE);
+            }
+            i++;
+            continue;
+        }
         if (string(argv[i]) == "-p") {
             // client/server pairs instead of spreading
             // requests to all workers. If true, half
@@ -423,6 +508,12 @@ int main(int argc, char *argv[])
             cs_pair = true;
             continue;
         }
+        if (string(argv[i]) == "-S") {
+            // Ignores -w and -s, and runs each combination of the worker counts and payload
+            // sizes below instead.
+            scaling = true;
+            continue;
+        }
         if (string(argv[i]) == "-t") {
             // Run one training round before actually collecting data
             // to get an approximation of max latency.
@@ -457,12 +548,18 @@ int main(int argc, char *argv[])
         }
     }
 
+    if (scaling) {
+        run_scaling(iterations, {2, 4, 8, 16}, {0, 1024, 16384}, cs_pair, oneway_batch);
+        return 0;
+    }
+
     if (training_round) {
         cout << "Start training round" << endl;
-        run_main(iterations, workers, payload_size, cs_pair, true);
+        run_main(iterations, workers, payload_size, cs_pair, oneway_batch, true);
         cout << "Completed training round" << endl << endl;
     }
 
-    run_main(iterations, workers, payload_size, cs_pair, false, dump_to_file, dump_filename);
+    run_main(iterations, workers, payload_size, cs_pair, oneway_batch, false, dump_to_file,
+             dump_filename);
     return 0;
 }
@@ -36,7 +36,8 @@ extern "C" int LLVMFuzzerTestOneInput(const uint8_t* data, size_t size) {
     size_t dSize = fdp.ConsumeIntegralInRange<size_t>(0, kMaxDealerSize);
     std::string name = fdp.ConsumeRandomLengthString(fdp.remaining_bytes());
     uint32_t flags = fdp.ConsumeIntegral<uint32_t>();
-    sp<MemoryDealer> dealer = new MemoryDealer(dSize, name.c_str(), flags);
+    MemoryDealer::Options options{.useSizeClasses = fdp.ConsumeBool()};
+    sp<MemoryDealer> dealer = new MemoryDealer(dSize, name.c_str(), flags, options);
 
     // This is used to track offsets that have been freed already to avoid an expected fatal log.
     std::unordered_set<size_t> free_list;
@@ -45,6 +46,7 @@ extern "C" int LLVMFuzzerTestOneInput(const uint8_t* data, size_t size) {
         fdp.PickValueInArray<std::function<void()>>({
                 [&]() -> void { dealer->getAllocationAlignment(); },
                 [&]() -> void { dealer->getMemoryHeap(); },
+                [&]() -> void { dealer->getStats(); },
                 [&]() -> void {
                     std::string randString = fdp.ConsumeRandomLengthString(fdp.remaining_bytes());
                     dealer->dump(randString.c_str());
@@ -75,6 +75,16 @@ status_t dupFileDescriptor(int oldFd, int* newFd) {
     return OK;
 }
 
+status_t createSealedBlob(const void*, size_t, unique_fd*) {
+    return INVALID_OPERATION;
+}
+
+status_t mapSealedBlob(borrowed_fd, size_t, const uint8_t**) {
+    return INVALID_OPERATION;
+}
+
+void unmapSealedBlob(const uint8_t*, size_t) {}
+
 std::unique_ptr<RpcTransportCtxFactory> makeDefaultRpcTransportCtxFactory() {
     return RpcTransportCtxFactoryTipcTrusty::make();
 }
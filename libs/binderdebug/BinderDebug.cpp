@@ -14,13 +14,18 @@
  * limitations under the License.
  */
 
+#include <android-base/file.h>
 #include <android-base/logging.h>
 #include <android-base/parseint.h>
 #include <android-base/strings.h>
+#include <android-base/unique_fd.h>
 #include <binder/Binder.h>
+#include <fcntl.h>
 #include <sys/types.h>
+#include <charconv>
 #include <fstream>
-#include <regex>
+#include <functional>
+#include <string_view>
 
 #include <binderdebug/BinderDebug.h>
 
@@ -39,92 +44,191 @@ static std::string contextToString(BinderDebugContext context) {
     }
 }
 
-static status_t scanBinderContext(pid_t pid, const std::string& contextName,
-                                  std::function<void(const std::string&)> eachLine) {
-    std::ifstream ifs("/dev/binderfs/binder_logs/proc/" + std::to_string(pid));
-    if (!ifs.is_open()) {
-        ifs.open("/d/binder/proc/" + std::to_string(pid));
-        if (!ifs.is_open()) {
+// Reads a whole binder log file, so that it is parsed in place rather than line by line.
+static status_t readBinderLog(const std::string& name, std::string* content) {
+    base::unique_fd fd(open(("/dev/binderfs/binder_logs/" + name).c_str(), O_RDONLY | O_CLOEXEC));
+    if (!fd.ok()) {
+        fd.reset(open(("/d/binder/" + name).c_str(), O_RDONLY | O_CLOEXEC));
+        if (!fd.ok()) {
             return -errno;
         }
     }
+    content->clear();
+    if (!base::ReadFdToString(fd, content)) {
+        return -errno;
+    }
+    return OK;
+}
 
+// Splits line into the tokens separated by spaces, dropping empty ones.
+static void tokenize(std::string_view line, std::vector<std::string_view>* tokens) {
+    tokens->clear();
+    while (!line.empty()) {
+        size_t start = line.find_first_not_of(' ');
+        if (start == std::string_view::npos) break;
+        line.remove_prefix(start);
+        size_t end = std::min(line.find(' '), line.size());
+        tokens->push_back(line.substr(0, end));
+        line.remove_prefix(end);
+    }
+}
+
+template <typename T>
+static bool parseNumber(std::string_view token, T* value, int base = 10) {
+    auto [ptr, ec] = std::from_chars(token.data(), token.data() + token.size(), *value, base);
+    return ec == std::errc() && ptr == token.data() + token.size();
+}
+
+// Calls eachLine with the lines of the procs in content for the given context, along with the
+// pid of the proc. The sections of the procs start with lines such as:
+// proc 2300
+// context hwbinder
+static void scanBinderContexts(std::string_view content, const std::string& contextName,
+                               const std::function<void(pid_t, std::string_view)>& eachLine) {
+    pid_t pid = -1;
     bool isDesiredContext = false;
-    std::string line;
-    while (getline(ifs, line)) {
-        if (base::StartsWith(line, "context")) {
-            isDesiredContext = base::Split(line, " ").back() == contextName;
+    while (!content.empty()) {
+        size_t end = std::min(content.find('\n'), content.size());
+        std::string_view line = content.substr(0, end);
+        content.remove_prefix(std::min(end + 1, content.size()));
+
+        if (line.substr(0, 5) == "proc ") {
+            if (!parseNumber(line.substr(5), &pid)) pid = -1;
+            isDesiredContext = false;
+            continue;
+        }
+        if (line.substr(0, 7) == "context") {
+            size_t pos = line.rfind(' ');
+            isDesiredContext = pos != std::string_view::npos && line.substr(pos + 1) == contextName;
             continue;
         }
         if (!isDesiredContext) {
             continue;
         }
-        eachLine(line);
+        eachLine(pid, line);
     }
+}
+
+static status_t scanBinderContext(pid_t pid, const std::string& contextName,
+                                  const std::function<void(std::string_view)>& eachLine) {
+    std::string content;
+    status_t ret = readBinderLog("proc/" + std::to_string(pid), &content);
+    if (ret != OK) {
+        return ret;
+    }
+    scanBinderContexts(content, contextName, [&](pid_t, std::string_view line) { eachLine(line); });
     return OK;
 }
 
 // Examples of what we are looking at:
 // node 66730: u00007590061890e0 c0000759036130950 pri 0:120 hs 1 hw 1 ls 0 lw 0 is 2 iw 2 tr 1 proc 2300 1790
 // thread 2999: l 00 need_return 1 tr 0
-status_t getBinderPidInfo(BinderDebugContext context, pid_t pid, BinderPidInfo* pidInfo) {
-    std::smatch match;
-    static const std::regex kReferencePrefix("^\\s*node \\d+:\\s+u([0-9a-f]+)\\s+c([0-9a-f]+)\\s+");
-    static const std::regex kThreadPrefix("^\\s*thread \\d+:\\s+l\\s+(\\d)(\\d)");
-    std::string contextStr = contextToString(context);
-    status_t ret = scanBinderContext(pid, contextStr, [&](const std::string& line) {
-        if (base::StartsWith(line, "  node")) {
-            std::vector<std::string> splitString = base::Tokenize(line, " ");
-            bool pids = false;
-            uint64_t ptr = 0;
-            for (const auto& token : splitString) {
-                if (base::StartsWith(token, "u")) {
-                    const std::string ptrString = "0x" + token.substr(1);
-                    if (!::android::base::ParseUint(ptrString.c_str(), &ptr)) {
-                        LOG(ERROR) << "Failed to parse pointer: " << ptrString;
+static void parsePidInfoLine(std::string_view line, std::vector<std::string_view>* tokens,
+                             BinderPidInfo* pidInfo) {
+    if (line.substr(0, 6) == "  node") {
+        tokenize(line, tokens);
+        bool pids = false;
+        uint64_t ptr = 0;
+        for (const auto& token : *tokens) {
+            if (token[0] == 'u') {
+                if (!parseNumber(token.substr(1), &ptr, 16)) {
+                    LOG(ERROR) << "Failed to parse pointer: 0x" << token.substr(1);
+                    return;
+                }
+            } else {
+                // The last numbers in the line after "proc" are all client PIDs
+                if (token == "proc") {
+                    pids = true;
+                } else if (pids) {
+                    int32_t pid;
+                    if (!parseNumber(token, &pid)) {
+                        LOG(ERROR) << "Failed to parse pid int: " << token;
                         return;
                     }
-                } else {
-                    // The last numbers in the line after "proc" are all client PIDs
-                    if (token == "proc") {
-                        pids = true;
-                    } else if (pids) {
-                        int32_t pid;
-                        if (!::android::base::ParseInt(token, &pid)) {
-                            LOG(ERROR) << "Failed to parse pid int: " << token;
-                            return;
-                        }
-                        if (ptr == 0) {
-                            LOG(ERROR) << "We failed to parse the pointer, so we can't add the refPids";
-                            return;
-                        }
-                        pidInfo->refPids[ptr].push_back(pid);
+                    if (ptr == 0) {
+                        LOG(ERROR) << "We failed to parse the pointer, so we can't add the refPids";
+                        return;
                     }
+                    pidInfo->refPids[ptr].push_back(pid);
                 }
             }
-        } else if (base::StartsWith(line, "  thread")) {
-            auto pos = line.find("l ");
-            if (pos != std::string::npos) {
-                // "1" is waiting in binder driver
-                // "2" is poll. It's impossible to tell if these are in use.
-                //     and HIDL default code doesn't use it.
-                bool isInUse = line.at(pos + 2) != '1';
-                // "0" is a thread that has called into binder
-                // "1" is looper thread
-                // "2" is main looper thread
-                bool isBinderThread = line.at(pos + 3) != '0';
-                if (!isBinderThread) {
-                    return;
-                }
-                if (isInUse) {
-                    pidInfo->threadUsage++;
-                }
+        }
+    } else if (line.substr(0, 8) == "  thread") {
+        auto pos = line.find("l ");
+        if (pos != std::string_view::npos && pos + 3 < line.size()) {
+            // "1" is waiting in binder driver
+            // "2" is poll. It's impossible to tell if these are in use.
+            //     and HIDL default code doesn't use it.
+            bool isInUse = line[pos + 2] != '1';
+            // "0" is a thread that has called into binder
+            // "1" is looper thread
+            // "2" is main looper thread
+            bool isBinderThread = line[pos + 3] != '0';
+            if (!isBinderThread) {
+                return;
+            }
+            if (isInUse) {
+                pidInfo->threadUsage++;
+            }
+
+            pidInfo->threadCount++;
+        }
+    }
+}
+
+status_t getBinderPidInfo(BinderDebugContext context, pid_t pid, BinderPidInfo* pidInfo) {
+    std::vector<std::string_view> tokens;
+    return scanBinderContext(pid, contextToString(context), [&](std::string_view line) {
+        parsePidInfoLine(line, &tokens, pidInfo);
+    });
+}
 
-                pidInfo->threadCount++;
+status_t getBinderPidInfos(BinderDebugContext context, const std::vector<pid_t>& pids,
+                           std::map<pid_t, BinderPidInfo>* pidInfos) {
+    std::string contextStr = contextToString(context);
+    std::string content;
+    if (readBinderLog("state", &content) != OK) {
+        // Fall back to the files of each pid, e.g. if only those are readable.
+        status_t ret = pids.empty() ? OK : NAME_NOT_FOUND;
+        for (pid_t pid : pids) {
+            BinderPidInfo pidInfo{};
+            status_t pidRet = getBinderPidInfo(context, pid, &pidInfo);
+            if (pidRet == OK) {
+                (*pidInfos)[pid] = std::move(pidInfo);
+                ret = OK;
+            } else if (ret != OK) {
+                ret = pidRet;
             }
         }
+        return ret;
+    }
+
+    // The state file holds the same sections as the files of each pid, for all pids.
+    std::map<pid_t, BinderPidInfo*> wanted;
+    for (pid_t pid : pids) {
+        wanted.emplace(pid, nullptr);
+    }
+    std::string_view remaining = content;
+    while (!remaining.empty()) {
+        size_t end = std::min(remaining.find('\n'), remaining.size());
+        std::string_view line = remaining.substr(0, end);
+        remaining.remove_prefix(std::min(end + 1, remaining.size()));
+        pid_t pid;
+        if (line.substr(0, 5) == "proc " && parseNumber(line.substr(5), &pid)) {
+            // Found pids have an entry even without a section for the context.
+            if (auto it = wanted.find(pid); it != wanted.end() && it->second == nullptr) {
+                it->second = &(*pidInfos)[pid];
+            }
+        }
+    }
+
+    std::vector<std::string_view> tokens;
+    scanBinderContexts(content, contextStr, [&](pid_t pid, std::string_view line) {
+        auto it = wanted.find(pid);
+        if (it == wanted.end() || it->second == nullptr) return;
+        parsePidInfoLine(line, &tokens, it->second);
     });
-    return ret;
+    return OK;
 }
 
 // Examples of what we are looking at:
@@ -132,27 +236,26 @@ status_t getBinderPidInfo(BinderDebugContext context, pid_t pid, BinderPidInfo*
 // node 29413: u00007803fc982e80 c000078042c982210 pri 0:139 hs 1 hw 1 ls 0 lw 0 is 2 iw 2 tr 1 proc 488 683
 status_t getBinderClientPids(BinderDebugContext context, pid_t pid, pid_t servicePid,
                              int32_t handle, std::vector<pid_t>* pids) {
-    std::smatch match;
-    static const std::regex kNodeNumber("^\\s+ref \\d+:\\s+desc\\s+(\\d+)\\s+node\\s+(\\d+).*");
     std::string contextStr = contextToString(context);
-    int32_t node;
-    status_t ret = scanBinderContext(pid, contextStr, [&](const std::string& line) {
-        if (!base::StartsWith(line, "  ref")) return;
+    std::vector<std::string_view> splitString;
+    int32_t node = -1;
+    status_t ret = scanBinderContext(pid, contextStr, [&](std::string_view line) {
+        if (line.substr(0, 5) != "  ref") return;
 
-        std::vector<std::string> splitString = base::Tokenize(line, " ");
+        tokenize(line, &splitString);
         if (splitString.size() < 12) {
             LOG(ERROR) << "Failed to parse binder_logs ref entry. Expecting size greater than 11, but got: " << splitString.size();
             return;
         }
         int32_t desc;
-        if (!::android::base::ParseInt(splitString[3].c_str(), &desc)) {
+        if (!parseNumber(splitString[3], &desc)) {
             LOG(ERROR) << "Failed to parse desc int: " << splitString[3];
             return;
         }
         if (handle != desc) {
             return;
         }
-        if (!::android::base::ParseInt(splitString[5].c_str(), &node)) {
+        if (!parseNumber(splitString[5], &node)) {
             LOG(ERROR) << "Failed to parse node int: " << splitString[5];
             return;
         }
@@ -162,19 +265,19 @@ status_t getBinderClientPids(BinderDebugContext context, pid_t pid, pid_t servic
         return ret;
     }
 
-    ret = scanBinderContext(servicePid, contextStr, [&](const std::string& line) {
-        if (!base::StartsWith(line, "  node")) return;
+    ret = scanBinderContext(servicePid, contextStr, [&](std::string_view line) {
+        if (line.substr(0, 6) != "  node") return;
 
-        std::vector<std::string> splitString = base::Tokenize(line, " ");
+        tokenize(line, &splitString);
         if (splitString.size() < 21) {
             LOG(ERROR) << "Failed to parse binder_logs node entry. Expecting size greater than 20, but got: " << splitString.size();
             return;
         }
 
         // remove the colon
-        const std::string nodeString = splitString[1].substr(0, splitString[1].size() - 1);
+        const std::string_view nodeString = splitString[1].substr(0, splitString[1].size() - 1);
         int32_t matchedNode;
-        if (!::android::base::ParseInt(nodeString.c_str(), &matchedNode)) {
+        if (!parseNumber(nodeString, &matchedNode)) {
             LOG(ERROR) << "Failed to parse node int: " << nodeString;
             return;
         }
@@ -188,7 +291,7 @@ status_t getBinderClientPids(BinderDebugContext context, pid_t pid, pid_t servic
                 pidsSection = true;
             } else if (pidsSection == true) {
                 int32_t pid;
-                if (!::android::base::ParseInt(token.c_str(), &pid)) {
+                if (!parseNumber(token, &pid)) {
                     LOG(ERROR) << "Failed to parse PID int: " << token;
                     return;
                 }
@@ -38,6 +38,13 @@ enum class BinderDebugContext {
  * pid is the pid of the service
  */
 status_t getBinderPidInfo(BinderDebugContext context, pid_t pid, BinderPidInfo* pidInfo);
+/**
+ * Gets the info of each of the given service pids, reading the state of all processes at once
+ * from /dev/binderfs/binder_logs/state rather than one file per pid. pidInfos gets an entry for
+ * each pid that was found.
+ */
+status_t getBinderPidInfos(BinderDebugContext context, const std::vector<pid_t>& pids,
+                           std::map<pid_t, BinderPidInfo>* pidInfos);
 /**
  * pid is typically the pid of this process that is making the query
  */
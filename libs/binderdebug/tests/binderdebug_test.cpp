@@ -60,6 +60,18 @@ TEST(BinderDebugTests, BinderThreads) {
     EXPECT_GE(pidInfo.threadCount, 1);
 }
 
+TEST(BinderDebugTests, BinderPidInfos) {
+    BinderPidInfo pidInfo{};
+    ASSERT_EQ(getBinderPidInfo(BinderDebugContext::BINDER, getpid(), &pidInfo), OK);
+
+    std::map<pid_t, BinderPidInfo> pidInfos;
+    const auto& status = getBinderPidInfos(BinderDebugContext::BINDER, {getpid()}, &pidInfos);
+    ASSERT_EQ(status, OK);
+    ASSERT_EQ(pidInfos.count(getpid()), 1u);
+    EXPECT_EQ(pidInfos[getpid()].refPids.size(), pidInfo.refPids.size());
+    EXPECT_EQ(pidInfos[getpid()].threadCount, pidInfo.threadCount);
+}
+
 extern "C" {
 int main(int argc, char** argv) {
     ::testing::InitGoogleTest(&argc, argv);
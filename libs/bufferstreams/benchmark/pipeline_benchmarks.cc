@@ -0,0 +1,93 @@
+/*
+ * Copyright 2024 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <benchmark/benchmark.h>
+
+#include <gui/BufferItem.h>
+#include <gui/BufferQueue.h>
+#include <gui/IConsumerListener.h>
+#include <gui/IProducerListener.h>
+#include <system/window.h>
+#include <ui/Fence.h>
+#include <ui/GraphicBuffer.h>
+
+namespace android {
+
+namespace {
+
+// Matches the stream config of the Rust benchmark.
+constexpr uint32_t kWidth = 1280;
+constexpr uint32_t kHeight = 720;
+constexpr uint64_t kUsage = GraphicBuffer::USAGE_SW_READ_OFTEN;
+
+class StubConsumerListener : public BnConsumerListener {
+public:
+    void onFrameAvailable(const BufferItem&) override {}
+    void onBuffersReleased() override {}
+    void onSidebandStreamChanged() override {}
+};
+
+// Hands a buffer from the producer to the consumer of a BufferQueue and back, on a single thread,
+// with the given number of buffers the producer may dequeue. This is the BufferQueue counterpart
+// of sending a frame from a BufferPoolPublisher to a subscriber that returns it right away.
+static void bufferQueue(benchmark::State& state) {
+    sp<IGraphicBufferProducer> producer;
+    sp<IGraphicBufferConsumer> consumer;
+    BufferQueue::createBufferQueue(&producer, &consumer);
+    consumer->consumerConnect(sp<StubConsumerListener>::make(), false);
+    consumer->setDefaultBufferSize(kWidth, kHeight);
+    IGraphicBufferProducer::QueueBufferOutput output;
+    producer->connect(sp<StubProducerListener>::make(), NATIVE_WINDOW_API_CPU, false, &output);
+    producer->setMaxDequeuedBufferCount(static_cast<int>(state.range(0)));
+
+    IGraphicBufferProducer::QueueBufferInput input(0, true, HAL_DATASPACE_UNKNOWN,
+                                                   Rect::INVALID_RECT,
+                                                   NATIVE_WINDOW_SCALING_MODE_FREEZE, 0,
+                                                   Fence::NO_FENCE);
+    for (auto _ : state) {
+        int slot;
+        sp<Fence> fence;
+        const status_t result =
+                producer->dequeueBuffer(&slot, &fence, kWidth, kHeight, HAL_PIXEL_FORMAT_RGBA_8888,
+                                        kUsage, nullptr, nullptr);
+        if (result < 0) {
+            state.SkipWithError("dequeueBuffer failed");
+            break;
+        }
+        if (result & IGraphicBufferProducer::BUFFER_NEEDS_REALLOCATION) {
+            sp<GraphicBuffer> buffer;
+            producer->requestBuffer(slot, &buffer);
+        }
+        if (producer->queueBuffer(slot, input, &output) != NO_ERROR) {
+            state.SkipWithError("queueBuffer failed");
+            break;
+        }
+
+        BufferItem item;
+        if (consumer->acquireBuffer(&item, 0) != NO_ERROR) {
+            state.SkipWithError("acquireBuffer failed");
+            break;
+        }
+        consumer->releaseBuffer(item.mSlot, item.mFrameNumber, Fence::NO_FENCE);
+    }
+
+    producer->disconnect(NATIVE_WINDOW_API_CPU);
+    consumer->consumerDisconnect();
+}
+BENCHMARK(bufferQueue)->Arg(1)->Arg(3);
+
+} // namespace
+} // namespace android
@@ -0,0 +1,106 @@
+// Copyright (C) 2024 The Android Open Source Project
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+//! Benchmark for a producer to consumer pipeline built from libbufferstreams publishers
+
+#![allow(dead_code)]
+#![allow(missing_docs)]
+
+use bufferstreams::{
+    buffers::Buffer, publishers::testing::TestPublisher, publishers::BufferPoolPublisher,
+    BufferError, BufferPublisher, BufferSubscriber, BufferSubscription, Frame, StreamConfig,
+};
+use criterion::*;
+use nativewindow::*;
+
+const STREAM_CONFIG: StreamConfig = StreamConfig {
+    width: 1280,
+    height: 720,
+    layers: 1,
+    format: AHardwareBuffer_Format::AHARDWAREBUFFER_FORMAT_R8G8B8A8_UNORM,
+    usage: AHardwareBuffer_UsageFlags::AHARDWAREBUFFER_USAGE_CPU_READ_OFTEN,
+    stride: 0,
+};
+
+/// A consumer that keeps `in_flight` frames requested, and returns each buffer as soon as it
+/// receives it.
+struct ReturningSubscriber {
+    in_flight: u64,
+    subscription: Option<Box<dyn BufferSubscription>>,
+}
+
+impl ReturningSubscriber {
+    fn new(in_flight: u64) -> Self {
+        Self { in_flight, subscription: None }
+    }
+}
+
+impl BufferSubscriber for ReturningSubscriber {
+    fn get_subscriber_stream_config(&self) -> StreamConfig {
+        STREAM_CONFIG
+    }
+
+    fn on_subscribe(&mut self, subscription: Box<dyn BufferSubscription>) {
+        subscription.request(self.in_flight);
+        self.subscription = Some(subscription);
+    }
+
+    fn on_next(&mut self, frame: Frame) {
+        drop(frame);
+        self.subscription.as_ref().unwrap().request(1);
+    }
+
+    fn on_error(&mut self, _error: BufferError) {}
+
+    fn on_complete(&mut self) {}
+}
+
+fn criterion_benchmark(c: &mut Criterion) {
+    let mut group = c.benchmark_group("producer_to_consumer");
+
+    for pool_size in [1, 3] {
+        group.bench_with_input(
+            BenchmarkId::new("buffer_pool_publisher", pool_size),
+            &pool_size,
+            |b, &pool_size| {
+                let mut publisher = BufferPoolPublisher::new(STREAM_CONFIG, pool_size).unwrap();
+                publisher.subscribe(ReturningSubscriber::new(pool_size as u64));
+
+                let mut present_time = 0;
+                b.iter(|| {
+                    present_time += 1;
+                    assert!(publisher.send_next_frame(present_time));
+                })
+            },
+        );
+    }
+
+    // Sends a newly allocated buffer every frame, as a publisher without a pool would.
+    group.bench_function("unpooled_publisher", |b| {
+        let mut publisher = TestPublisher::new(STREAM_CONFIG);
+        publisher.subscribe(ReturningSubscriber::new(1));
+
+        let mut present_time = 0;
+        b.iter(|| {
+            present_time += 1;
+            let buffer = Buffer::new_unowned(STREAM_CONFIG.create_hardware_buffer().unwrap());
+            assert!(publisher.send_frame(Frame { buffer, present_time, fence: 0 }));
+        })
+    });
+
+    group.finish();
+}
+
+criterion_group!(benches, criterion_benchmark);
+criterion_main!(benches);
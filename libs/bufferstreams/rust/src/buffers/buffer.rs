@@ -14,6 +14,8 @@
 
 //! Wrapper around the HardwareBuffer
 
+use std::sync::Arc;
+
 use nativewindow::*;
 
 use super::{buffer_owner::NoBufferOwner, BufferOwner};
@@ -22,19 +24,25 @@ use super::{buffer_owner::NoBufferOwner, BufferOwner};
 ///
 /// This buffer may be associated with a buffer pool to which it will be returned to it when dropped.
 pub struct Buffer {
-    buffer_owner: Box<dyn BufferOwner>,
+    buffer_owner: Arc<dyn BufferOwner>,
     hardware_buffer: HardwareBuffer,
 }
 
 impl Buffer {
     /// Create new buffer with a custom [BufferOwner].
     pub fn new(buffer_owner: Box<dyn BufferOwner>, hardware_buffer: HardwareBuffer) -> Self {
+        Self { buffer_owner: buffer_owner.into(), hardware_buffer }
+    }
+
+    /// Create new buffer with a [BufferOwner] shared with other buffers, e.g. all buffers of a
+    /// buffer pool. Unlike [Buffer::new], this does not allocate.
+    pub fn new_shared(buffer_owner: Arc<dyn BufferOwner>, hardware_buffer: HardwareBuffer) -> Self {
         Self { buffer_owner, hardware_buffer }
     }
 
     /// Create a new buffer with no association to any buffer pool.
     pub fn new_unowned(hardware_buffer: HardwareBuffer) -> Self {
-        Self { buffer_owner: Box::new(NoBufferOwner), hardware_buffer }
+        Self { buffer_owner: Arc::new(NoBufferOwner), hardware_buffer }
     }
 
     /// Get the id of the underlying buffer.
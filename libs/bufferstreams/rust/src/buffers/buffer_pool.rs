@@ -56,7 +56,11 @@ impl BufferOwner for BufferPoolOwner {
 ///
 /// A buffer pool can be of arbitrary size. It creates and then holds references to all buffers
 /// associated with it.
-pub struct BufferPool(Arc<Mutex<BufferPoolInner>>);
+pub struct BufferPool {
+    inner: Arc<Mutex<BufferPoolInner>>,
+    // Shared by all buffers handed out, so that acquiring a buffer does not allocate.
+    owner: Arc<dyn BufferOwner>,
+}
 
 impl BufferPool {
     /// Creates a new buffer pool of size pool_size. All buffers will be created according to
@@ -74,23 +78,22 @@ impl BufferPool {
                 return None;
             }
         }
-        Some(Self(Arc::new(Mutex::new(BufferPoolInner {
+        let inner = Arc::new(Mutex::new(BufferPoolInner {
             size: pool_size,
             hardware_buffers,
             available_buffers,
-        }))))
+        }));
+        let owner = Arc::new(BufferPoolOwner(Arc::downgrade(&inner)));
+        Some(Self { inner, owner })
     }
 
     /// Try to acquire the next available buffer in the buffer pool.
     ///
     /// If all buffers are in use it will return None.
     pub fn next_buffer(&mut self) -> Option<Buffer> {
-        let mut inner = self.0.lock().unwrap();
+        let mut inner = self.inner.lock().unwrap();
         if let Some(buffer_id) = inner.available_buffers.pop() {
-            Some(Buffer::new(
-                Box::new(BufferPoolOwner(Arc::downgrade(&self.0))),
-                inner.hardware_buffers[&buffer_id].clone(),
-            ))
+            Some(Buffer::new_shared(self.owner.clone(), inner.hardware_buffers[&buffer_id].clone()))
         } else {
             None
         }
@@ -98,9 +101,15 @@ impl BufferPool {
 
     /// Gets the size of the buffer pool.
     pub fn size(&self) -> usize {
-        let inner = self.0.lock().unwrap();
+        let inner = self.inner.lock().unwrap();
         inner.size
     }
+
+    /// Gets the number of buffers that are not in use.
+    pub fn available(&self) -> usize {
+        let inner = self.inner.lock().unwrap();
+        inner.available_buffers.len()
+    }
 }
 
 #[cfg(test)]
@@ -134,4 +143,14 @@ mod test {
         drop(next_buffer);
         assert!(buffer_pool.next_buffer().is_some());
     }
+
+    #[test]
+    fn buffers_outlive_buffer_pool() {
+        let mut buffer_pool = BufferPool::new(2, STREAM_CONFIG).unwrap();
+        let next_buffer = buffer_pool.next_buffer().unwrap();
+        assert_eq!(buffer_pool.available(), 1);
+
+        drop(buffer_pool);
+        drop(next_buffer);
+    }
 }
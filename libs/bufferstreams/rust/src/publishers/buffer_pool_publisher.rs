@@ -18,6 +18,10 @@ use crate::{
 };
 
 /// The [BufferPoolPublisher] submits buffers from a pool over to the subscriber.
+///
+/// Frames are only sent while the subscriber has requests pending and the pool has a buffer that
+/// the subscriber has returned, so a slow subscriber holds the publisher back instead of buffers
+/// piling up.
 pub struct BufferPoolPublisher {
     stream_config: StreamConfig,
     buffer_pool: BufferPool,
@@ -39,10 +43,14 @@ impl BufferPoolPublisher {
 
     /// If the [SharedBufferSubscription] is ready for a [Frame], a buffer will be requested from
     /// [BufferPool] and sent over to the [BufferSubscriber].
+    ///
+    /// A request is only taken once a buffer is available, so requests made while all buffers are
+    /// in use are served when the subscriber returns one.
     pub fn send_next_frame(&mut self, present_time: i64) -> bool {
         if let Some(subscriber) = self.subscriber.as_mut() {
-            if self.subscription.take_request() {
-                if let Some(buffer) = self.buffer_pool.next_buffer() {
+            if let Some(buffer) = self.buffer_pool.next_buffer() {
+                // If no request is pending, the buffer goes back to the pool when dropped.
+                if self.subscription.take_request() {
                     let frame = Frame { buffer, present_time, fence: 0 };
 
                     subscriber.on_next(frame);
@@ -52,6 +60,21 @@ impl BufferPoolPublisher {
         }
         false
     }
+
+    /// Sends as many frames as both the pending requests and the available buffers allow, and
+    /// returns how many were sent.
+    pub fn send_available_frames(&mut self, present_time: i64) -> usize {
+        let mut sent = 0;
+        while self.send_next_frame(present_time) {
+            sent += 1;
+        }
+        sent
+    }
+
+    /// Gets the number of buffers in the pool, whether or not they are in use.
+    pub fn pool_size(&self) -> usize {
+        self.buffer_pool.size()
+    }
 }
 
 impl BufferPublisher for BufferPoolPublisher {
@@ -105,4 +128,42 @@ mod test {
         assert!(matches!(events.last().unwrap(), TestingSubscriberEvent::Next(_)));
         assert_eq!(buffer_pool_publisher.subscription.pending_requests(), 0);
     }
+
+    #[test]
+    fn test_request_waits_for_returned_buffer() {
+        let subscriber = SharedSubscriber::new(TestSubscriber::new(STREAM_CONFIG));
+
+        let mut buffer_pool_publisher = BufferPoolPublisher::new(STREAM_CONFIG, 1).unwrap();
+        buffer_pool_publisher.subscribe(subscriber.clone());
+
+        subscriber.map_inner(|s| s.request(2));
+        assert!(buffer_pool_publisher.send_next_frame(1));
+
+        // The only buffer is held by the subscriber, so the second request stays pending.
+        assert!(!buffer_pool_publisher.send_next_frame(2));
+        assert_eq!(buffer_pool_publisher.subscription.pending_requests(), 1);
+
+        // Dropping the frame returns its buffer to the pool.
+        drop(subscriber.map_inner_mut(|s| s.take_events()));
+        assert!(buffer_pool_publisher.send_next_frame(3));
+        assert_eq!(buffer_pool_publisher.subscription.pending_requests(), 0);
+    }
+
+    #[test]
+    fn test_send_available_frames() {
+        let subscriber = SharedSubscriber::new(TestSubscriber::new(STREAM_CONFIG));
+
+        let mut buffer_pool_publisher = BufferPoolPublisher::new(STREAM_CONFIG, 3).unwrap();
+        buffer_pool_publisher.subscribe(subscriber.clone());
+        assert_eq!(buffer_pool_publisher.pool_size(), 3);
+
+        assert_eq!(buffer_pool_publisher.send_available_frames(1), 0);
+
+        subscriber.map_inner(|s| s.request(2));
+        assert_eq!(buffer_pool_publisher.send_available_frames(1), 2);
+
+        subscriber.map_inner(|s| s.request(5));
+        assert_eq!(buffer_pool_publisher.send_available_frames(2), 1);
+        assert_eq!(buffer_pool_publisher.subscription.pending_requests(), 4);
+    }
 }
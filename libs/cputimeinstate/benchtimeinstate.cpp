@@ -0,0 +1,73 @@
+/*
+ * Copyright 2024 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <benchmark/benchmark.h>
+
+#include <cputimeinstate.h>
+
+namespace android {
+namespace bpf {
+
+static void BM_getUidsCpuFreqTimes(benchmark::State &state) {
+    if (!isTrackingUidTimesSupported()) {
+        state.SkipWithError("time in state tracking is not supported");
+        return;
+    }
+    for (auto _ : state) {
+        benchmark::DoNotOptimize(getUidsCpuFreqTimes());
+    }
+}
+BENCHMARK(BM_getUidsCpuFreqTimes);
+
+static void BM_getUidsUpdatedCpuFreqTimesFlat(benchmark::State &state) {
+    if (!isTrackingUidTimesSupported()) {
+        state.SkipWithError("time in state tracking is not supported");
+        return;
+    }
+    uid_cpu_freq_times_t times;
+    for (auto _ : state) {
+        benchmark::DoNotOptimize(getUidsUpdatedCpuFreqTimes(nullptr, &times));
+    }
+    state.counters["uids"] = times.uids.size();
+}
+BENCHMARK(BM_getUidsUpdatedCpuFreqTimesFlat);
+
+static void BM_getUidsConcurrentTimes(benchmark::State &state) {
+    if (!isTrackingUidTimesSupported()) {
+        state.SkipWithError("time in state tracking is not supported");
+        return;
+    }
+    for (auto _ : state) {
+        benchmark::DoNotOptimize(getUidsConcurrentTimes());
+    }
+}
+BENCHMARK(BM_getUidsConcurrentTimes);
+
+static void BM_getUidsUpdatedConcurrentTimesFlat(benchmark::State &state) {
+    if (!isTrackingUidTimesSupported()) {
+        state.SkipWithError("time in state tracking is not supported");
+        return;
+    }
+    uid_concurrent_times_t times;
+    for (auto _ : state) {
+        benchmark::DoNotOptimize(getUidsUpdatedConcurrentTimes(nullptr, &times));
+    }
+    state.counters["uids"] = times.uids.size();
+}
+BENCHMARK(BM_getUidsUpdatedConcurrentTimesFlat);
+
+} // namespace bpf
+} // namespace android
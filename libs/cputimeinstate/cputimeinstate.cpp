@@ -22,8 +22,12 @@
 #include <dirent.h>
 #include <errno.h>
 #include <inttypes.h>
+#include <string.h>
+#include <sys/syscall.h>
 #include <sys/sysinfo.h>
+#include <unistd.h>
 
+#include <algorithm>
 #include <mutex>
 #include <numeric>
 #include <optional>
@@ -349,6 +353,187 @@ static std::optional<bool> uidUpdatedSince(uint32_t uid, uint64_t lastUpdate,
     return true;
 }
 
+static int lookupMapBatch(const unique_fd &mapFd, const void *inBatch, void *outBatch, void *keys,
+                          void *values, uint32_t *count) {
+    union bpf_attr attr;
+    memset(&attr, 0, sizeof(attr));
+    attr.batch.in_batch = reinterpret_cast<uintptr_t>(inBatch);
+    attr.batch.out_batch = reinterpret_cast<uintptr_t>(outBatch);
+    attr.batch.keys = reinterpret_cast<uintptr_t>(keys);
+    attr.batch.values = reinterpret_cast<uintptr_t>(values);
+    attr.batch.count = *count;
+    attr.batch.map_fd = static_cast<uint32_t>(mapFd.get());
+    int ret = syscall(__NR_bpf, BPF_MAP_LOOKUP_BATCH, &attr, sizeof(attr));
+    *count = attr.batch.count;
+    return ret;
+}
+
+// Calls fn with each key of a map and its nValues values, which is gNCpus for per-CPU maps, until
+// fn returns false. Entries are read in batches with BPF_MAP_LOOKUP_BATCH, or one by one on kernels
+// that do not support it. Returns false on error or if fn returned false.
+template <typename Key, typename Value, typename Fn>
+static bool forEachMapEntry(const unique_fd &mapFd, uint32_t nValues, Fn fn) {
+    uint32_t batchSize = 64;
+    std::vector<Key> keys(batchSize);
+    std::vector<Value> vals(batchSize * nValues);
+
+    Key inBatch, outBatch;
+    bool first = true;
+    while (true) {
+        uint32_t count = batchSize;
+        int ret = lookupMapBatch(mapFd, first ? nullptr : &inBatch, &outBatch, keys.data(),
+                                 vals.data(), &count);
+        if (ret && errno == ENOSPC && count == 0) {
+            // A hash bucket holds more entries than fit in the batch.
+            batchSize *= 2;
+            keys.resize(batchSize);
+            vals.resize(batchSize * nValues);
+            continue;
+        }
+        if (ret && errno != ENOENT) {
+            if (first) break;
+            return false;
+        }
+        for (uint32_t i = 0; i < count; ++i) {
+            if (!fn(keys[i], &vals[i * nValues])) return false;
+        }
+        if (ret) return true;
+        inBatch = outBatch;
+        first = false;
+    }
+
+    // Fall back to iterating key by key.
+    Key key, prevKey;
+    if (getFirstMapKey(mapFd, &key)) return errno == ENOENT;
+    do {
+        if (findMapEntry(mapFd, &key, vals.data())) return false;
+        if (!fn(key, vals.data())) return false;
+    } while (prevKey = key, !getNextMapKey(mapFd, &prevKey, &key));
+    return errno == ENOENT;
+}
+
+// Assigns UIDs to rows of a flat result with open addressing, so that it only allocates to grow.
+class UidRows {
+  public:
+    UidRows(std::vector<uint32_t> *uids, std::vector<uint64_t> *times, size_t stride)
+          : mUids(uids), mTimes(times), mStride(stride) {
+        mUids->clear();
+        mTimes->clear();
+        mSlots.assign(256, 0);
+    }
+
+    // Returns the row of uid, or nullptr if it has none.
+    uint64_t *find(uint32_t uid) {
+        const uint32_t row = mSlots[findSlot(uid)];
+        return row ? rowData(row - 1) : nullptr;
+    }
+
+    // Returns the row of uid, which is added with zero times if needed.
+    uint64_t *findOrAdd(uint32_t uid) {
+        size_t slot = findSlot(uid);
+        if (!mSlots[slot]) {
+            if (2 * (mUids->size() + 1) > mSlots.size()) {
+                grow();
+                slot = findSlot(uid);
+            }
+            mUids->push_back(uid);
+            mTimes->resize(mTimes->size() + mStride, 0);
+            mSlots[slot] = mUids->size();
+        }
+        return rowData(mSlots[slot] - 1);
+    }
+
+  private:
+    uint64_t *rowData(size_t row) { return mTimes->data() + row * mStride; }
+
+    size_t findSlot(uint32_t uid) const {
+        const size_t mask = mSlots.size() - 1;
+        size_t slot = (uid * 0x9e3779b1u) & mask;
+        while (mSlots[slot] && (*mUids)[mSlots[slot] - 1] != uid) slot = (slot + 1) & mask;
+        return slot;
+    }
+
+    void grow() {
+        mSlots.assign(mSlots.size() * 2, 0);
+        for (size_t row = 0; row < mUids->size(); ++row) {
+            mSlots[findSlot((*mUids)[row])] = row + 1;
+        }
+    }
+
+    std::vector<uint32_t> *const mUids;
+    std::vector<uint64_t> *const mTimes;
+    const size_t mStride;
+    // Row + 1 of the UIDs, or 0 for unused slots.
+    std::vector<uint32_t> mSlots;
+};
+
+// Returns whether the times of uid should be read given lastUpdate, which may be null. A row is
+// only added for UIDs that were updated, so the map lookup is skipped for UIDs that have one. The
+// UID skipped last is remembered, as its other buckets tend to follow.
+static std::optional<bool> uidRowUpdatedSince(UidRows &rows, uint32_t uid, uint64_t *lastUpdate,
+                                              uint64_t *newLastUpdate,
+                                              std::optional<uint32_t> *skippedUid) {
+    if (!lastUpdate || rows.find(uid)) return true;
+    if (*skippedUid == uid) return false;
+    auto uidUpdated = uidUpdatedSince(uid, *lastUpdate, newLastUpdate);
+    if (uidUpdated.has_value() && !*uidUpdated) *skippedUid = uid;
+    return uidUpdated;
+}
+
+// Returns the offsets of the per-cluster lists in a flat row that starts with start values, and sets
+// stride to the size of the row.
+template <typename T>
+static std::vector<size_t> getClusterOffsets(const std::vector<std::vector<T>> &clusters,
+                                             size_t start, size_t *stride) {
+    std::vector<size_t> offsets;
+    *stride = start;
+    for (const auto &cluster : clusters) {
+        offsets.push_back(*stride);
+        *stride += cluster.size();
+    }
+    return offsets;
+}
+
+// Adds the per-CPU times of a uid_time_in_state_map bucket to a flat row.
+static void addCpuFreqTimes(uint32_t bucket, const tis_val_t *vals,
+                            const std::vector<size_t> &policyOffsets, uint64_t *row) {
+    const uint32_t offset = bucket * FREQS_PER_ENTRY;
+    for (uint32_t i = 0; i < gNPolicies; ++i) {
+        if (offset >= gPolicyFreqs[i].size()) continue;
+        const uint32_t count =
+                std::min<uint32_t>(FREQS_PER_ENTRY, gPolicyFreqs[i].size() - offset);
+        uint64_t *times = row + policyOffsets[i] + offset;
+        for (const auto &cpu : gPolicyCpus[i]) {
+            const uint64_t *ar = vals[gCpuIndexMap[cpu]].ar;
+            for (uint32_t j = 0; j < count; ++j) times[j] += ar[j];
+        }
+    }
+}
+
+// Adds the per-CPU times of a uid_concurrent_times_map bucket to a flat row. Returns false if the
+// bucket is invalid.
+static bool addConcurrentTimes(uint32_t bucket, const concurrent_val_t *vals,
+                               const std::vector<size_t> &policyOffsets, uint64_t *row) {
+    if (bucket > (gNCpus - 1) / CPUS_PER_ENTRY) return false;
+
+    const uint32_t offset = bucket * CPUS_PER_ENTRY;
+    const uint32_t activeCount = std::min<uint32_t>(CPUS_PER_ENTRY, gNCpus - offset);
+    for (uint32_t cpu = 0; cpu < gNCpus; ++cpu) {
+        for (uint32_t j = 0; j < activeCount; ++j) row[offset + j] += vals[cpu].active[j];
+    }
+    for (uint32_t policy = 0; policy < gNPolicies; ++policy) {
+        if (offset >= gPolicyCpus[policy].size()) continue;
+        const uint32_t count =
+                std::min<uint32_t>(CPUS_PER_ENTRY, gPolicyCpus[policy].size() - offset);
+        uint64_t *times = row + policyOffsets[policy] + offset;
+        for (const auto &cpu : gPolicyCpus[policy]) {
+            const uint64_t *policyTimes = vals[gCpuIndexMap[cpu]].policy;
+            for (uint32_t j = 0; j < count; ++j) times[j] += policyTimes[j];
+        }
+    }
+    return true;
+}
+
 // Retrieve the times in ns that each uid spent running at each CPU freq.
 // Return contains no value on error, otherwise it contains a map from uids to vectors of vectors
 // using the format:
@@ -406,6 +591,34 @@ getUidsUpdatedCpuFreqTimes(uint64_t *lastUpdate) {
     return map;
 }
 
+// Retrieve the times in ns that each uid spent running at each CPU freq, excluding UIDs that have
+// not run since before lastUpdate if it is not null, into the reused buffers of out.
+// Returns false on error.
+bool getUidsUpdatedCpuFreqTimes(uint64_t *lastUpdate, uid_cpu_freq_times_t *out) {
+    if (!gInitialized && !initGlobals()) return false;
+
+    size_t stride;
+    const auto policyOffsets = getClusterOffsets(gPolicyFreqs, 0, &stride);
+    out->stride = stride;
+
+    UidRows rows(&out->uids, &out->times, stride);
+    uint64_t newLastUpdate = lastUpdate ? *lastUpdate : 0;
+    std::optional<uint32_t> skippedUid;
+    const bool ok = forEachMapEntry<time_key_t, tis_val_t>(
+            gTisMapFd, gNCpus, [&](const time_key_t &key, const tis_val_t *vals) {
+                auto uidUpdated = uidRowUpdatedSince(rows, key.uid, lastUpdate, &newLastUpdate,
+                                                     &skippedUid);
+                if (!uidUpdated.has_value()) return false;
+                if (!*uidUpdated) return true;
+
+                addCpuFreqTimes(key.bucket, vals, policyOffsets, rows.findOrAdd(key.uid));
+                return true;
+            });
+    if (!ok) return false;
+    if (lastUpdate && newLastUpdate > *lastUpdate) *lastUpdate = newLastUpdate;
+    return true;
+}
+
 static bool verifyConcurrentTimes(const concurrent_time_t &ct) {
     uint64_t activeSum = std::accumulate(ct.active.begin(), ct.active.end(), (uint64_t)0);
     uint64_t policySum = 0;
@@ -536,6 +749,158 @@ std::optional<std::unordered_map<uint32_t, concurrent_time_t>> getUidsUpdatedCon
     return ret;
 }
 
+// Retrieve the times in ns that each uid spent running concurrently with each possible number of
+// other tasks, excluding UIDs that have not run since before lastUpdate if it is not null, into the
+// reused buffers of out.
+// Returns false on error.
+bool getUidsUpdatedConcurrentTimes(uint64_t *lastUpdate, uid_concurrent_times_t *out) {
+    if (!gInitialized && !initGlobals()) return false;
+
+    size_t stride;
+    const auto policyOffsets = getClusterOffsets(gPolicyCpus, gNCpus, &stride);
+    out->stride = stride;
+
+    UidRows rows(&out->uids, &out->times, stride);
+    uint64_t newLastUpdate = lastUpdate ? *lastUpdate : 0;
+    std::optional<uint32_t> skippedUid;
+    const bool ok = forEachMapEntry<time_key_t, concurrent_val_t>(
+            gConcurrentMapFd, gNCpus, [&](const time_key_t &key, const concurrent_val_t *vals) {
+                if (key.bucket > (gNCpus - 1) / CPUS_PER_ENTRY) return false;
+                auto uidUpdated = uidRowUpdatedSince(rows, key.uid, lastUpdate, &newLastUpdate,
+                                                     &skippedUid);
+                if (!uidUpdated.has_value()) return false;
+                if (!*uidUpdated) return true;
+
+                return addConcurrentTimes(key.bucket, vals, policyOffsets,
+                                          rows.findOrAdd(key.uid));
+            });
+    if (!ok) return false;
+
+    for (size_t i = 0; i < out->uids.size(); ++i) {
+        uint64_t *row = out->times.data() + i * stride;
+        const uint64_t activeSum = std::accumulate(row, row + gNCpus, (uint64_t)0);
+        const uint64_t policySum = std::accumulate(row + gNCpus, row + stride, (uint64_t)0);
+        if (activeSum == policySum) continue;
+
+        auto val = getUidConcurrentTimes(out->uids[i], false);
+        if (!val.has_value()) continue;
+        std::copy(val->active.begin(), val->active.end(), row);
+        for (uint32_t policy = 0; policy < gNPolicies; ++policy) {
+            std::copy(val->policy[policy].begin(), val->policy[policy].end(),
+                      row + policyOffsets[policy]);
+        }
+    }
+    if (lastUpdate && newLastUpdate > *lastUpdate) *lastUpdate = newLastUpdate;
+    return true;
+}
+
+// Reads the times of the UIDs that ran since the previous read of state into state->deltas, with
+// readRow adding the current times of a UID to a zeroed row of stride values. The times of a UID
+// are reported in full if they decreased, e.g. because its data was cleared.
+// Returns false on error.
+template <typename ReadRow>
+static bool getUidTimeDeltas(uid_time_deltas_t *state, size_t stride, ReadRow readRow) {
+    if (state->stride != stride) *state = {.stride = stride};
+    state->uids.clear();
+    state->deltas.clear();
+
+    // Updates that occurred during the previous read may have been missed, as in
+    // uidUpdatedSince().
+    constexpr uint64_t NSEC_PER_SEC = 1000000000;
+    const uint64_t lastUpdate = state->lastUpdate;
+    uint64_t newLastUpdate = lastUpdate;
+    std::vector<uint32_t> updatedUids;
+    const bool ok = forEachMapEntry<uint32_t, uint64_t>(
+            gUidLastUpdateMapFd, 1, [&](const uint32_t &uid, const uint64_t *uidLastUpdate) {
+                if (*uidLastUpdate + NSEC_PER_SEC < lastUpdate) return true;
+                newLastUpdate = std::max(newLastUpdate, *uidLastUpdate);
+                updatedUids.push_back(uid);
+                return true;
+            });
+    if (!ok) return false;
+
+    std::vector<uint64_t> current(stride);
+    for (const uint32_t uid : updatedUids) {
+        std::fill(current.begin(), current.end(), 0);
+        if (!readRow(uid, current.data())) return false;
+
+        const auto [it, inserted] = state->rows.try_emplace(uid, state->totals.size() / stride);
+        if (inserted) state->totals.resize(state->totals.size() + stride, 0);
+        uint64_t *total = state->totals.data() + it->second * stride;
+
+        bool reset = false, changed = false;
+        for (size_t i = 0; i < stride; ++i) {
+            reset |= current[i] < total[i];
+            changed |= current[i] != total[i];
+        }
+        if (!changed) continue;
+
+        state->uids.push_back(uid);
+        for (size_t i = 0; i < stride; ++i) {
+            state->deltas.push_back(reset ? current[i] : current[i] - total[i]);
+        }
+        std::copy(current.begin(), current.end(), total);
+    }
+
+    state->lastUpdate = newLastUpdate;
+    return true;
+}
+
+// Reads the change in the times in ns that each uid spent running at each CPU freq.
+bool getUidCpuFreqTimeDeltas(uid_time_deltas_t *state) {
+    if (!gInitialized && !initGlobals()) return false;
+
+    size_t stride;
+    const auto policyOffsets = getClusterOffsets(gPolicyFreqs, 0, &stride);
+    uint32_t maxFreqCount = 0;
+    for (const auto &freqList : gPolicyFreqs) {
+        maxFreqCount = std::max<uint32_t>(maxFreqCount, freqList.size());
+    }
+
+    std::vector<tis_val_t> vals(gNCpus);
+    return getUidTimeDeltas(state, stride, [&](uint32_t uid, uint64_t *row) {
+        for (uint32_t bucket = 0; bucket <= (maxFreqCount - 1) / FREQS_PER_ENTRY; ++bucket) {
+            const time_key_t key = {.uid = uid, .bucket = bucket};
+            if (findMapEntry(gTisMapFd, &key, vals.data())) {
+                if (errno != ENOENT) return false;
+                continue;
+            }
+            addCpuFreqTimes(bucket, vals.data(), policyOffsets, row);
+        }
+        return true;
+    });
+}
+
+// Reads the change in the times in ns that each uid spent running concurrently with each possible
+// number of other tasks.
+bool getUidConcurrentTimeDeltas(uid_time_deltas_t *state) {
+    if (!gInitialized && !initGlobals()) return false;
+
+    size_t stride;
+    const auto policyOffsets = getClusterOffsets(gPolicyCpus, gNCpus, &stride);
+
+    std::vector<concurrent_val_t> vals(gNCpus);
+    return getUidTimeDeltas(state, stride, [&](uint32_t uid, uint64_t *row) {
+        for (bool retry : {true, false}) {
+            for (uint32_t bucket = 0; bucket <= (gNCpus - 1) / CPUS_PER_ENTRY; ++bucket) {
+                const time_key_t key = {.uid = uid, .bucket = bucket};
+                if (findMapEntry(gConcurrentMapFd, &key, vals.data())) {
+                    if (errno != ENOENT) return false;
+                    continue;
+                }
+                addConcurrentTimes(bucket, vals.data(), policyOffsets, row);
+            }
+
+            // As for getUidConcurrentTimes(), retry once if the map was read mid-update.
+            const uint64_t activeSum = std::accumulate(row, row + gNCpus, (uint64_t)0);
+            const uint64_t policySum = std::accumulate(row + gNCpus, row + stride, (uint64_t)0);
+            if (activeSum == policySum || !retry) break;
+            std::fill(row, row + stride, 0);
+        }
+        return true;
+    });
+}
+
 // Clear all time in state data for a given uid. Returns false on error, true otherwise.
 // This is only suitable for clearing data when an app is uninstalled; if called on a UID with
 // running tasks it will cause time in state vs. concurrent time totals to be inconsistent for that
@@ -32,6 +32,19 @@ std::optional<std::unordered_map<uint32_t, std::vector<std::vector<uint64_t>>>>
     getUidsUpdatedCpuFreqTimes(uint64_t *lastUpdate);
 std::optional<std::vector<std::vector<uint32_t>>> getCpuFreqs();
 
+// Flat counterpart of the map returned by getUidsUpdatedCpuFreqTimes(). The buffers are reused by
+// each call, so that polling with the same instance stops allocating once they fit every UID.
+struct uid_cpu_freq_times_t {
+    // UIDs, in no particular order.
+    std::vector<uint32_t> uids;
+    // The times of uids[i] start at times[i * stride], laid out as the concatenation of the
+    // per-cluster vectors returned by getUidCpuFreqTimes().
+    std::vector<uint64_t> times;
+    size_t stride = 0;
+};
+
+bool getUidsUpdatedCpuFreqTimes(uint64_t *lastUpdate, uid_cpu_freq_times_t *out);
+
 struct concurrent_time_t {
     std::vector<uint64_t> active;
     std::vector<std::vector<uint64_t>> policy;
@@ -41,8 +54,42 @@ std::optional<concurrent_time_t> getUidConcurrentTimes(uint32_t uid, bool retry
 std::optional<std::unordered_map<uint32_t, concurrent_time_t>> getUidsConcurrentTimes();
 std::optional<std::unordered_map<uint32_t, concurrent_time_t>>
     getUidsUpdatedConcurrentTimes(uint64_t *lastUpdate);
+
+// Flat counterpart of the map returned by getUidsUpdatedConcurrentTimes(), with buffers reused as
+// for uid_cpu_freq_times_t.
+struct uid_concurrent_times_t {
+    // UIDs, in no particular order.
+    std::vector<uint32_t> uids;
+    // The times of uids[i] start at times[i * stride], laid out as the active times followed by the
+    // concatenation of the per-cluster policy times of concurrent_time_t.
+    std::vector<uint64_t> times;
+    size_t stride = 0;
+};
+
+bool getUidsUpdatedConcurrentTimes(uint64_t *lastUpdate, uid_concurrent_times_t *out);
 bool clearUidTimes(unsigned int uid);
 
+// State for periodically reading how the times of each UID changed since the previous read. Only
+// the UIDs that ran since then are read, so the cost of a read scales with the active UIDs rather
+// than with all UIDs. A given instance must only be passed to one of the functions below.
+struct uid_time_deltas_t {
+    // UIDs whose times changed since the previous read, in no particular order. The first read
+    // reports the full times of every UID.
+    std::vector<uint32_t> uids;
+    // The changes of uids[i] start at deltas[i * stride], in the layout of uid_cpu_freq_times_t or
+    // uid_concurrent_times_t for the respective functions.
+    std::vector<uint64_t> deltas;
+    size_t stride = 0;
+
+    // Times reported so far, carried across reads.
+    uint64_t lastUpdate = 0;
+    std::unordered_map<uint32_t, size_t> rows;
+    std::vector<uint64_t> totals;
+};
+
+bool getUidCpuFreqTimeDeltas(uid_time_deltas_t *state);
+bool getUidConcurrentTimeDeltas(uid_time_deltas_t *state);
+
 bool startTrackingProcessCpuTimes(pid_t pid);
 bool startAggregatingTaskCpuTimes(pid_t pid, uint16_t aggregationKey);
 std::optional<std::unordered_map<uint16_t, std::vector<std::vector<uint64_t>>>>
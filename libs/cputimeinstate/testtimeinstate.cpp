@@ -209,6 +209,82 @@ TEST_F(TimeInStateTest, AllUidUpdatedTimeInState) {
     }
 }
 
+// Returns the per-cluster times of a row of a flat result, with the given cluster sizes.
+template <typename T>
+vector<vector<uint64_t>> unflattenTimes(const uint64_t *row, const vector<vector<T>> &clusters) {
+    vector<vector<uint64_t>> times;
+    for (const auto &cluster : clusters) {
+        times.emplace_back(row, row + cluster.size());
+        row += cluster.size();
+    }
+    return times;
+}
+
+TEST_F(TimeInStateTest, FlatAndAllUidTimeInStateConsistent) {
+    auto freqs = getCpuFreqs();
+    ASSERT_TRUE(freqs.has_value());
+
+    uint64_t zero = 0;
+    for (uint64_t *lastUpdate : {(uint64_t *)nullptr, &zero}) {
+        auto map = getUidsCpuFreqTimes();
+        ASSERT_TRUE(map.has_value());
+
+        uid_cpu_freq_times_t flat;
+        ASSERT_TRUE(getUidsUpdatedCpuFreqTimes(lastUpdate, &flat));
+        ASSERT_FALSE(flat.uids.empty());
+        ASSERT_EQ(flat.times.size(), flat.uids.size() * flat.stride);
+
+        size_t stride = 0;
+        for (const auto &freqList : *freqs) stride += freqList.size();
+        ASSERT_EQ(flat.stride, stride);
+
+        for (size_t i = 0; i < flat.uids.size(); ++i) {
+            const uint32_t uid = flat.uids[i];
+            if (map->find(uid) == map->end()) continue;
+            ASSERT_NO_FATAL_FAILURE(
+                    TestCheckUpdate((*map)[uid],
+                                    unflattenTimes(&flat.times[i * flat.stride], *freqs)));
+        }
+    }
+}
+
+void TestUidTimeDeltas(bool (*getDeltas)(uid_time_deltas_t *)) {
+    uid_time_deltas_t state;
+    ASSERT_TRUE(getDeltas(&state));
+    ASSERT_FALSE(state.uids.empty());
+    ASSERT_NE(state.lastUpdate, (uint64_t)0);
+    ASSERT_EQ(state.deltas.size(), state.uids.size() * state.stride);
+    const size_t firstCount = state.uids.size();
+
+    // Sleep briefly to trigger a context switch, ensuring we see at least one update.
+    struct timespec ts;
+    ts.tv_sec = 0;
+    ts.tv_nsec = 1000000;
+    nanosleep (&ts, NULL);
+
+    const uint64_t oldLastUpdate = state.lastUpdate;
+    ASSERT_TRUE(getDeltas(&state));
+    ASSERT_FALSE(state.uids.empty());
+    ASSERT_LT(state.uids.size(), firstCount);
+    ASSERT_NE(state.lastUpdate, oldLastUpdate);
+    ASSERT_EQ(state.deltas.size(), state.uids.size() * state.stride);
+
+    for (size_t i = 0; i < state.uids.size(); ++i) {
+        const auto begin = state.deltas.begin() + i * state.stride;
+        const uint64_t sum = std::accumulate(begin, begin + state.stride, (uint64_t)0);
+        ASSERT_GT(sum, (uint64_t)0);
+        ASSERT_LE(sum, 2 * NSEC_PER_SEC * get_nprocs_conf());
+    }
+}
+
+TEST_F(TimeInStateTest, UidCpuFreqTimeDeltas) {
+    ASSERT_NO_FATAL_FAILURE(TestUidTimeDeltas(getUidCpuFreqTimeDeltas));
+}
+
+TEST_F(TimeInStateTest, UidConcurrentTimeDeltas) {
+    ASSERT_NO_FATAL_FAILURE(TestUidTimeDeltas(getUidConcurrentTimeDeltas));
+}
+
 TEST_F(TimeInStateTest, TotalAndAllUidTimeInStateConsistent) {
     auto allUid = getUidsCpuFreqTimes();
     auto total = getTotalCpuFreqTimes();
@@ -312,6 +388,32 @@ TEST_F(TimeInStateTest, AllUidUpdatedConcurrentTimes) {
     }
 }
 
+TEST_F(TimeInStateTest, FlatAndAllUidConcurrentTimesConsistent) {
+    auto map = getUidsConcurrentTimes();
+    ASSERT_TRUE(map.has_value());
+    ASSERT_FALSE(map->empty());
+
+    uid_concurrent_times_t flat;
+    ASSERT_TRUE(getUidsUpdatedConcurrentTimes(nullptr, &flat));
+    ASSERT_FALSE(flat.uids.empty());
+    ASSERT_EQ(flat.times.size(), flat.uids.size() * flat.stride);
+
+    for (size_t i = 0; i < flat.uids.size(); ++i) {
+        const uint32_t uid = flat.uids[i];
+        if (map->find(uid) == map->end()) continue;
+        const auto &before = (*map)[uid];
+        size_t stride = before.active.size();
+        for (const auto &policy : before.policy) stride += policy.size();
+        ASSERT_EQ(flat.stride, stride);
+
+        const uint64_t *row = &flat.times[i * flat.stride];
+        vector<uint64_t> active(row, row + before.active.size());
+        ASSERT_NO_FATAL_FAILURE(TestCheckUpdate({before.active}, {active}));
+        ASSERT_NO_FATAL_FAILURE(TestCheckUpdate(
+                before.policy, unflattenTimes(row + before.active.size(), before.policy)));
+    }
+}
+
 TEST_F(TimeInStateTest, SingleAndAllUidConcurrentTimesConsistent) {
     uint64_t zero = 0;
     auto maps = {getUidsConcurrentTimes(), getUidsUpdatedConcurrentTimes(&zero)};
@@ -0,0 +1,144 @@
+/*
+ * Copyright 2024 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <ftl/concurrent_small_map.h>
+#include <gtest/gtest.h>
+
+#include <atomic>
+#include <string>
+#include <thread>
+#include <vector>
+
+using namespace std::string_literals;
+
+namespace android::test {
+
+using ftl::ConcurrentSmallMap;
+
+// Keep in sync with example usage in header file.
+TEST(ConcurrentSmallMap, Example) {
+  ftl::ConcurrentSmallMap<int, std::string, 3> map;
+  EXPECT_TRUE(map.empty());
+
+  EXPECT_TRUE(map.try_emplace(123, "abc"));
+  EXPECT_FALSE(map.try_emplace(123, "def"));
+  EXPECT_EQ(map.get(123), "abc");
+
+  EXPECT_FALSE(map.emplace_or_replace(123, "xyz"));
+  const auto size = [](const std::string& s) { return s.size(); };
+  EXPECT_EQ(map.read([&](const auto& map) { return map.get(123).transform(size); }), 3u);
+
+  map.write([](auto& map) { map.try_emplace(-1, 3u, '?'); });
+  EXPECT_EQ(map.get(-1), "???");
+
+  EXPECT_TRUE(map.erase(123));
+  EXPECT_FALSE(map.contains(123));
+}
+
+TEST(ConcurrentSmallMap, Construct) {
+  const ftl::SmallMap<int, std::string, 3> small_map =
+      ftl::init::map<int, std::string>(1, "a")(2, "b");
+  ConcurrentSmallMap<int, std::string, 3> map(small_map);
+
+  EXPECT_EQ(map.size(), 2u);
+  EXPECT_EQ(map.get(1), "a");
+  EXPECT_EQ(map.get(2), "b");
+  EXPECT_TRUE(map.read([&](const auto& map) { return map == small_map; }));
+}
+
+TEST(ConcurrentSmallMap, WritesApplyToBothInstances) {
+  ConcurrentSmallMap<int, std::string, 2> map;
+
+  // Each write alternates the instance that readers read, so every write is seen by reads no
+  // matter how many came before it.
+  for (int i = 0; i < 5; i++) {
+    EXPECT_TRUE(map.try_emplace(i, std::to_string(i)));
+    EXPECT_EQ(map.size(), static_cast<std::size_t>(i + 1));
+  }
+  for (int i = 0; i < 5; i++) {
+    EXPECT_EQ(map.get(i), std::to_string(i));
+  }
+
+  EXPECT_TRUE(map.try_replace(3, "three"));
+  EXPECT_FALSE(map.try_replace(5, "five"));
+  EXPECT_EQ(map.get(3), "three"s);
+  EXPECT_EQ(map.get(5), std::nullopt);
+
+  EXPECT_TRUE(map.emplace_or_replace(5, "five"));
+  EXPECT_EQ(map.get(5), "five"s);
+
+  EXPECT_TRUE(map.erase(0));
+  EXPECT_FALSE(map.erase(0));
+  EXPECT_EQ(map.size(), 5u);
+
+  map.clear();
+  EXPECT_TRUE(map.empty());
+  map.clear();
+  EXPECT_TRUE(map.empty());
+}
+
+TEST(ConcurrentSmallMap, WriteReturnsResult) {
+  ConcurrentSmallMap<int, int, 2> map;
+  EXPECT_TRUE(map.write([](auto& map) { return map.try_emplace(1, 10).second; }));
+  EXPECT_FALSE(map.write([](auto& map) { return map.try_emplace(1, 20).second; }));
+  EXPECT_EQ(map.get(1), 10);
+}
+
+TEST(ConcurrentSmallMap, ConcurrentReadsSeeWholeWrites) {
+  // Every write sets all the values to the same number, so a read observing two different values
+  // would have seen a partial write.
+  constexpr int kKeys = 4;
+  constexpr int kWrites = 2000;
+
+  ConcurrentSmallMap<int, int, kKeys> map;
+  for (int key = 0; key < kKeys; key++) {
+    map.try_emplace(key, 0);
+  }
+
+  std::atomic<bool> done = false;
+  std::atomic<bool> torn = false;
+  std::vector<std::thread> readers;
+  for (int i = 0; i < 4; i++) {
+    readers.emplace_back([&] {
+      int last = 0;
+      while (!done) {
+        const auto [first, consistent] = map.read([](const auto& map) {
+          const int first = map.get(0).value();
+          for (const auto& [key, value] : map) {
+            if (value != first) return std::make_pair(first, false);
+          }
+          return std::make_pair(first, true);
+        });
+        // Versions only go forward.
+        if (!consistent || first < last) torn = true;
+        last = first;
+      }
+    });
+  }
+
+  for (int i = 1; i <= kWrites; i++) {
+    map.write([i](auto& map) {
+      for (auto& [key, value] : map) value = i;
+    });
+  }
+  done = true;
+  for (auto& reader : readers) reader.join();
+
+  EXPECT_FALSE(torn);
+  EXPECT_EQ(map.get(kKeys - 1), kWrites);
+}
+
+}  // namespace android::test
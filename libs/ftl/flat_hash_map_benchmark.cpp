@@ -0,0 +1,132 @@
+/*
+ * Copyright 2024 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <benchmark/benchmark.h>
+#include <ftl/flat_hash_map.h>
+#include <ftl/small_map.h>
+
+#include <algorithm>
+#include <cstdint>
+#include <random>
+#include <unordered_map>
+#include <vector>
+
+namespace android {
+namespace {
+
+// Keys shaped like layer and connection ids: sparse, and mostly increasing.
+std::vector<std::uint32_t> make_keys(std::size_t count, std::uint32_t seed) {
+  std::mt19937 random(seed);
+  std::vector<std::uint32_t> keys;
+  std::uint32_t key = 0;
+  for (std::size_t i = 0; i < count; i++) {
+    key += 1 + random() % 16;
+    keys.push_back(key);
+  }
+  std::shuffle(keys.begin(), keys.end(), random);
+  return keys;
+}
+
+// Values the size of a small record, e.g. a layer snapshot index and a couple of flags.
+struct Value {
+  std::uint64_t data[2] = {};
+};
+
+template <typename Map>
+void insert(Map& map, std::uint32_t key) {
+  map.try_emplace(key);
+}
+
+template <typename Map>
+bool contains(const Map& map, std::uint32_t key) {
+  return map.find(key) != map.end();
+}
+
+template <typename Map>
+void BM_FindHit(benchmark::State& state) {
+  const auto keys = make_keys(static_cast<std::size_t>(state.range(0)), 0);
+  Map map;
+  for (const auto key : keys) insert(map, key);
+
+  std::size_t i = 0;
+  for (auto _ : state) {
+    benchmark::DoNotOptimize(contains(map, keys[i]));
+    if (++i == keys.size()) i = 0;
+  }
+}
+
+template <typename Map>
+void BM_FindMiss(benchmark::State& state) {
+  const auto keys = make_keys(static_cast<std::size_t>(state.range(0)), 0);
+  Map map;
+  for (const auto key : keys) insert(map, key);
+
+  // Odd keys past the largest one are never in the map.
+  std::uint32_t key = *std::max_element(keys.begin(), keys.end()) + 1;
+  for (auto _ : state) {
+    benchmark::DoNotOptimize(contains(map, key));
+    key += 2;
+  }
+}
+
+// Builds a map of the given size from scratch, as when a frame's layers are collected.
+template <typename Map>
+void BM_Build(benchmark::State& state) {
+  const auto keys = make_keys(static_cast<std::size_t>(state.range(0)), 0);
+  for (auto _ : state) {
+    Map map;
+    for (const auto key : keys) insert(map, key);
+    benchmark::DoNotOptimize(map);
+  }
+}
+
+// Replaces the oldest key with a new one, as layers are destroyed and created.
+template <typename Map>
+void BM_Churn(benchmark::State& state) {
+  const auto count = static_cast<std::size_t>(state.range(0));
+  auto keys = make_keys(count * 2, 0);
+  Map map;
+  for (std::size_t i = 0; i < count; i++) insert(map, keys[i]);
+
+  std::size_t oldest = 0;
+  std::size_t next = count;
+  for (auto _ : state) {
+    map.erase(keys[oldest]);
+    insert(map, keys[next]);
+    if (++oldest == keys.size()) oldest = 0;
+    if (++next == keys.size()) next = 0;
+  }
+}
+
+using UnorderedMap = std::unordered_map<std::uint32_t, Value>;
+using SmallMap = ftl::SmallMap<std::uint32_t, Value, 16>;
+using FlatHashMap = ftl::FlatHashMap<std::uint32_t, Value, 16>;
+
+// SmallMap lookups take linear time, so it only runs on the sizes where it is an alternative.
+#define BENCHMARK_MAPS(benchmark_fn)                                                 \
+  BENCHMARK_TEMPLATE(benchmark_fn, UnorderedMap)->RangeMultiplier(4)->Range(4, 1024); \
+  BENCHMARK_TEMPLATE(benchmark_fn, SmallMap)->RangeMultiplier(4)->Range(4, 64);       \
+  BENCHMARK_TEMPLATE(benchmark_fn, FlatHashMap)->RangeMultiplier(4)->Range(4, 1024)
+
+BENCHMARK_MAPS(BM_FindHit);
+BENCHMARK_MAPS(BM_FindMiss);
+BENCHMARK_MAPS(BM_Build);
+BENCHMARK_MAPS(BM_Churn);
+
+#undef BENCHMARK_MAPS
+
+}  // namespace
+}  // namespace android
@@ -0,0 +1,288 @@
+/*
+ * Copyright 2024 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <ftl/flat_hash_map.h>
+#include <gtest/gtest.h>
+
+#include <cstdint>
+#include <memory>
+#include <random>
+#include <string>
+#include <unordered_map>
+
+namespace android::test {
+
+using ftl::FlatHashMap;
+
+// Keep in sync with example usage in header file.
+TEST(FlatHashMap, Example) {
+  ftl::FlatHashMap<int, std::string, 4> map;
+  EXPECT_TRUE(map.empty());
+  EXPECT_FALSE(map.dynamic());
+
+  map.try_emplace(123, "abc");
+  map.try_emplace(-1);
+  map.try_emplace(42, 3u, '?');
+  EXPECT_EQ(map.size(), 3u);
+
+  EXPECT_TRUE(map.contains(123));
+  EXPECT_EQ(map.get(42).transform([](const std::string& s) { return s.size(); }), 3u);
+
+  const auto opt = map.get(-1);
+  ASSERT_TRUE(opt);
+
+  std::string& ref = *opt;
+  EXPECT_TRUE(ref.empty());
+  ref = "xyz";
+
+  map.emplace_or_replace(0, "vanilla", 2u, 3u);
+  EXPECT_TRUE(map.erase(123));
+
+  EXPECT_EQ(map, (FlatHashMap<int, std::string, 4>({{-1, "xyz"}, {0, "nil"}, {42, "???"}})));
+}
+
+TEST(FlatHashMap, Construct) {
+  {
+    // Default constructor.
+    FlatHashMap<int, std::string, 0> map;
+    EXPECT_TRUE(map.empty());
+    EXPECT_EQ(map.capacity(), 0u);
+    EXPECT_FALSE(map.dynamic());
+    EXPECT_EQ(map.begin(), map.end());
+    EXPECT_FALSE(map.contains(0));
+  }
+  {
+    // Static capacity is rounded up to the table's.
+    FlatHashMap<int, std::string, 3> map;
+    EXPECT_EQ(map.static_capacity(), 15u);
+    EXPECT_EQ(map.capacity(), 15u);
+    EXPECT_FALSE(map.dynamic());
+    EXPECT_EQ(map.begin(), map.end());
+  }
+  {
+    // Initializer list, keeping the first of duplicate keys.
+    FlatHashMap<int, std::string, 4> map = {{1, "a"}, {2, "b"}, {1, "c"}};
+    EXPECT_EQ(map.size(), 2u);
+    EXPECT_EQ(map.find(1)->second, "a");
+    EXPECT_EQ(map.find(2)->second, "b");
+  }
+}
+
+TEST(FlatHashMap, Grow) {
+  FlatHashMap<int, int, 4> map;
+  for (int i = 0; i < 1000; i++) {
+    EXPECT_TRUE(map.try_emplace(i, i * 2).second);
+  }
+  EXPECT_EQ(map.size(), 1000u);
+  EXPECT_TRUE(map.dynamic());
+  EXPECT_LE(map.size(), map.capacity() - map.capacity() / 8);
+
+  for (int i = 0; i < 1000; i++) {
+    EXPECT_EQ(map.get(i), i * 2);
+  }
+  EXPECT_FALSE(map.contains(1000));
+  EXPECT_FALSE(map.contains(-1));
+
+  std::size_t count = 0;
+  for (const auto& [k, v] : map) {
+    EXPECT_EQ(v, k * 2);
+    count++;
+  }
+  EXPECT_EQ(count, 1000u);
+}
+
+TEST(FlatHashMap, Reserve) {
+  FlatHashMap<int, int, 0> map;
+  map.reserve(100);
+  const auto capacity = map.capacity();
+  EXPECT_GE(capacity - capacity / 8, 100u);
+
+  for (int i = 0; i < 100; i++) map.try_emplace(i, i);
+  EXPECT_EQ(map.capacity(), capacity);
+}
+
+TEST(FlatHashMap, TryEmplace) {
+  FlatHashMap<int, std::string, 2> map;
+
+  {
+    const auto [it, ok] = map.try_emplace(1, "a");
+    EXPECT_TRUE(ok);
+    EXPECT_EQ(it->first, 1);
+    EXPECT_EQ(it->second, "a");
+  }
+  {
+    const auto [it, ok] = map.try_emplace(1, "b");
+    EXPECT_FALSE(ok);
+    EXPECT_EQ(it->second, "a");
+  }
+}
+
+TEST(FlatHashMap, TryReplace) {
+  FlatHashMap<int, std::string, 2> map = {{1, "a"}, {2, "b"}};
+
+  EXPECT_EQ(map.try_replace(3, "c"), map.end());
+
+  const auto it = map.try_replace(1, std::string("abc"), 1u);
+  ASSERT_NE(it, map.end());
+  EXPECT_EQ(it->second, "bc");
+
+  // The arguments may refer to the value being replaced.
+  map.try_replace(2, map.get(2)->get() + "b");
+  EXPECT_EQ(map.find(2)->second, "bb");
+}
+
+TEST(FlatHashMap, EmplaceOrReplace) {
+  FlatHashMap<int, std::string, 2> map;
+
+  EXPECT_TRUE(map.emplace_or_replace(1, "a").second);
+  EXPECT_FALSE(map.emplace_or_replace(1, "b").second);
+  EXPECT_EQ(map.find(1)->second, "b");
+  EXPECT_EQ(map.size(), 1u);
+}
+
+TEST(FlatHashMap, Erase) {
+  FlatHashMap<int, std::string, 4> map = {{1, "a"}, {2, "b"}, {3, "c"}};
+
+  EXPECT_FALSE(map.erase(4));
+  EXPECT_TRUE(map.erase(2));
+  EXPECT_FALSE(map.erase(2));
+  EXPECT_EQ(map, (FlatHashMap<int, std::string, 4>({{1, "a"}, {3, "c"}})));
+
+  map.erase(map.find(1));
+  EXPECT_EQ(map, (FlatHashMap<int, std::string, 4>({{3, "c"}})));
+
+  map.clear();
+  EXPECT_TRUE(map.empty());
+  EXPECT_EQ(map.begin(), map.end());
+  EXPECT_FALSE(map.contains(3));
+}
+
+TEST(FlatHashMap, EraseWhileIterating) {
+  FlatHashMap<int, int, 0> map;
+  for (int i = 0; i < 100; i++) map.try_emplace(i, i);
+
+  for (auto it = map.begin(); it != map.end(); ++it) {
+    if (it->first % 2) map.erase(it);
+  }
+  EXPECT_EQ(map.size(), 50u);
+  for (int i = 0; i < 100; i++) {
+    EXPECT_EQ(map.contains(i), i % 2 == 0);
+  }
+}
+
+// Erasing and inserting distinct keys leaves deleted slots behind, which must be reclaimed rather
+// than grow the table forever.
+TEST(FlatHashMap, Churn) {
+  FlatHashMap<int, int, 0> map;
+  for (int i = 0; i < 10; i++) map.try_emplace(i, i);
+  const auto capacity = map.capacity();
+
+  for (int i = 10; i < 10000; i++) {
+    EXPECT_TRUE(map.erase(i - 10));
+    EXPECT_TRUE(map.try_emplace(i, i).second);
+  }
+  EXPECT_EQ(map.size(), 10u);
+  EXPECT_EQ(map.capacity(), capacity);
+  for (int i = 9990; i < 10000; i++) {
+    EXPECT_EQ(map.get(i), i);
+  }
+}
+
+// All keys have the same hash, so they end up in a single probe sequence.
+TEST(FlatHashMap, Collisions) {
+  struct BadHash {
+    std::size_t operator()(int) const { return 0; }
+  };
+
+  FlatHashMap<int, int, 0, BadHash> map;
+  for (int i = 0; i < 100; i++) {
+    EXPECT_TRUE(map.try_emplace(i, i).second);
+  }
+  for (int i = 0; i < 100; i += 3) {
+    EXPECT_TRUE(map.erase(i));
+  }
+  for (int i = 0; i < 100; i++) {
+    EXPECT_EQ(map.contains(i), i % 3 != 0);
+  }
+}
+
+TEST(FlatHashMap, CopyAndMove) {
+  FlatHashMap<int, std::string, 2> small = {{1, "a"}, {2, "b"}};
+  FlatHashMap<int, std::string, 2> large;
+  for (int i = 0; i < 100; i++) large.try_emplace(i, std::to_string(i));
+  ASSERT_FALSE(small.dynamic());
+  ASSERT_TRUE(large.dynamic());
+
+  {
+    auto copy = small;
+    EXPECT_EQ(copy, small);
+    auto moved = std::move(copy);
+    EXPECT_EQ(moved, small);
+    EXPECT_FALSE(moved.dynamic());
+  }
+  {
+    auto copy = large;
+    EXPECT_EQ(copy, large);
+    auto moved = std::move(copy);
+    EXPECT_EQ(moved, large);
+    EXPECT_TRUE(copy.empty());
+    copy.try_emplace(1, "a");
+    EXPECT_EQ(copy.find(1)->second, "a");
+  }
+  {
+    auto map = small;
+    map = large;
+    EXPECT_EQ(map, large);
+    map = std::move(small);
+    EXPECT_EQ(map, (FlatHashMap<int, std::string, 2>({{1, "a"}, {2, "b"}})));
+  }
+}
+
+TEST(FlatHashMap, MoveOnlyValues) {
+  FlatHashMap<int, std::unique_ptr<int>, 0> map;
+  for (int i = 0; i < 100; i++) {
+    map.try_emplace(i, std::make_unique<int>(i));
+  }
+
+  auto moved = std::move(map);
+  for (int i = 0; i < 100; i++) {
+    EXPECT_EQ(*moved.get(i)->get(), i);
+  }
+}
+
+TEST(FlatHashMap, MatchesUnorderedMap) {
+  std::mt19937 random(0);
+  std::uniform_int_distribution<std::uint32_t> keys(0, 500);
+
+  FlatHashMap<std::uint32_t, std::uint32_t, 4> map;
+  std::unordered_map<std::uint32_t, std::uint32_t> expected;
+
+  for (std::uint32_t i = 0; i < 20000; i++) {
+    const std::uint32_t key = keys(random);
+    if (random() % 3 == 0) {
+      EXPECT_EQ(map.erase(key), expected.erase(key) == 1);
+    } else {
+      EXPECT_EQ(map.emplace_or_replace(key, i).second, expected.insert_or_assign(key, i).second);
+    }
+    ASSERT_EQ(map.size(), expected.size());
+  }
+
+  for (const auto& [k, v] : expected) {
+    EXPECT_EQ(map.get(k), v);
+  }
+}
+
+}  // namespace android::test
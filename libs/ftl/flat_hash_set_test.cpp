@@ -0,0 +1,81 @@
+/*
+ * Copyright 2024 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <ftl/flat_hash_set.h>
+#include <gtest/gtest.h>
+
+#include <string>
+
+using namespace std::string_literals;
+
+namespace android::test {
+
+using ftl::FlatHashSet;
+
+// Keep in sync with example usage in header file.
+TEST(FlatHashSet, Example) {
+  ftl::FlatHashSet<int, 4> set;
+  EXPECT_TRUE(set.empty());
+
+  EXPECT_TRUE(set.insert(123).second);
+  EXPECT_FALSE(set.insert(123).second);
+  EXPECT_TRUE(set.contains(123));
+
+  set.insert(-1);
+  EXPECT_EQ(set.size(), 2u);
+  EXPECT_FALSE(set.dynamic());
+
+  EXPECT_TRUE(set.erase(123));
+  EXPECT_EQ(set, (FlatHashSet<int, 4>({-1})));
+}
+
+TEST(FlatHashSet, Strings) {
+  FlatHashSet<std::string, 0> set = {"abc", "def", "abc"};
+  EXPECT_EQ(set.size(), 2u);
+
+  std::string ghi = "ghi";
+  const auto [it, ok] = set.insert(std::move(ghi));
+  EXPECT_TRUE(ok);
+  EXPECT_EQ(*it, "ghi");
+
+  EXPECT_TRUE(set.contains("abc"));
+  EXPECT_FALSE(set.contains("xyz"));
+
+  EXPECT_EQ(set, (FlatHashSet<std::string, 4>({"ghi", "def", "abc"})));
+  EXPECT_NE(set, (FlatHashSet<std::string, 4>({"ghi", "def"})));
+}
+
+TEST(FlatHashSet, Grow) {
+  FlatHashSet<int, 4> set;
+  for (int i = 0; i < 1000; i++) {
+    EXPECT_TRUE(set.insert(i).second);
+  }
+  EXPECT_TRUE(set.dynamic());
+
+  for (int i = 0; i < 1000; i += 2) {
+    set.erase(set.find(i));
+  }
+  EXPECT_EQ(set.size(), 500u);
+
+  int sum = 0;
+  for (const int key : set) {
+    EXPECT_EQ(key % 2, 1);
+    sum += key;
+  }
+  EXPECT_EQ(sum, 500 * 500);
+}
+
+}  // namespace android::test
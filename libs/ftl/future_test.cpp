@@ -50,6 +50,14 @@ TEST(Future, Example) {
 
     EXPECT_EQ(chain.get(), 'b');
   }
+  {
+    auto chain = ftl::yield(2).then([](int x) { return x * 3; }).then([](int x) { return x + 1; });
+    EXPECT_EQ(chain.get(), 7);
+  }
+  {
+    ftl::Future<int> future = ftl::yield(2).then([](int x) { return x * 3; });
+    EXPECT_EQ(future.get(), 6);
+  }
 }
 
 namespace {
@@ -102,6 +110,57 @@ TEST(Future, Chain) {
   decrement_thread.join();
 }
 
+TEST(Future, ChainIsLazy) {
+  int calls = 0;
+  auto chain = ftl::yield(1)
+                   .then([&calls](int x) {
+                     calls++;
+                     return x + 1;
+                   })
+                   .then([&calls](int x) {
+                     calls++;
+                     return ftl::yield(x * 2);
+                   });
+
+  EXPECT_TRUE(chain.valid());
+  EXPECT_EQ(chain.wait_for(std::chrono::seconds(0)), std::future_status::deferred);
+  EXPECT_EQ(calls, 0);
+
+  EXPECT_EQ(chain.get(), 4);
+  EXPECT_EQ(calls, 2);
+}
+
+TEST(Future, ChainConversion) {
+  int calls = 0;
+  const auto increment = [&calls](int x) {
+    calls++;
+    return x + 1;
+  };
+
+  ftl::Future<int> future = ftl::yield(1).then(increment).then(increment);
+  ftl::SharedFuture<int> shared = std::move(future).then(increment).share();
+  EXPECT_EQ(calls, 0);
+
+  EXPECT_EQ(shared.get(), 4);
+  EXPECT_EQ(shared.get(), 4);
+  EXPECT_EQ(calls, 3);
+
+  // A chain on a shared future copies its result, and leaves the source future valid.
+  auto chain = ftl::SharedFuture<int>(shared).then([](const int& x) -> const int& { return x; });
+  EXPECT_EQ(chain.get(), 4);
+  EXPECT_EQ(shared.get(), 4);
+}
+
+TEST(Future, ChainMoveOnly) {
+  auto chain = ftl::yield(std::make_unique<int>(1))
+                   .then([ptr = std::make_unique<int>(2)](std::unique_ptr<int> x) {
+                     return std::make_unique<int>(*x + *ptr);
+                   });
+
+  ftl::Future<std::unique_ptr<int>> future = std::move(chain);
+  EXPECT_EQ(*future.get(), 3);
+}
+
 TEST(Future, WaitFor) {
   using namespace std::chrono_literals;
   {
@@ -35,6 +35,8 @@
 #include <sys/prctl.h>
 #include <utils/Trace.h>
 
+#include <algorithm>
+#include <chrono>
 #include <memory>
 #include <string>
 #include <thread>
@@ -77,6 +79,10 @@ enum NativeLibrary {
     VNDKSP = 1,
 };
 
+// How long target stats are collected before being sent to GpuService in one batch. Most of them
+// come in bursts while an app creates its instances, devices and swapchains.
+static constexpr std::chrono::milliseconds kTargetStatsFlushDelay(1000);
+
 static constexpr const char* kNativeLibrariesSystemConfigPath[] =
         {"/apex/com.android.vndk.v{}/etc/llndk.libraries.{}.txt",
          "/apex/com.android.vndk.v{}/etc/vndksp.libraries.{}.txt"};
@@ -498,11 +504,15 @@ void GraphicsEnv::addVulkanEngineName(const char* engineName) {
     std::lock_guard<std::mutex> lock(mStatsLock);
     if (!readyToSendGpuStatsLocked()) return;
 
-    const sp<IGpuService> gpuService = getGpuService();
-    if (gpuService) {
-        gpuService->addVulkanEngineName(mGpuStats.appPackageName, mGpuStats.driverVersionCode,
-                                        engineName);
+    const std::string name(engineName);
+    if (std::find(mSentEngineNames.cbegin(), mSentEngineNames.cend(), name) !=
+                mSentEngineNames.cend() ||
+        std::find(mPendingEngineNames.cbegin(), mPendingEngineNames.cend(), name) !=
+                mPendingEngineNames.cend()) {
+        return;
     }
+    mPendingEngineNames.push_back(name);
+    scheduleTargetStatsFlushLocked();
 }
 
 bool GraphicsEnv::readyToSendGpuStatsLocked() {
@@ -522,11 +532,103 @@ void GraphicsEnv::setTargetStatsArray(const GpuStatsInfo::Stats stats, const uin
     std::lock_guard<std::mutex> lock(mStatsLock);
     if (!readyToSendGpuStatsLocked()) return;
 
+    addTargetStatsLocked(stats, values, valueCount);
+}
+
+void GraphicsEnv::addTargetStatsLocked(const GpuStatsInfo::Stats stats, const uint64_t* values,
+                                       const uint32_t valueCount) {
+    if (valueCount == 0) return;
+
+    const std::vector<uint64_t>& sent = mSentTargetStats[stats];
+    std::vector<uint64_t>& pending = mPendingTargetStats[stats];
+    switch (stats) {
+        case GpuStatsInfo::Stats::VULKAN_INSTANCE_EXTENSION:
+        case GpuStatsInfo::Stats::VULKAN_DEVICE_EXTENSION:
+            // Extensions are kept as a set of hashes.
+            for (uint32_t i = 0; i < valueCount; i++) {
+                if (std::find(sent.cbegin(), sent.cend(), values[i]) == sent.cend() &&
+                    std::find(pending.cbegin(), pending.cend(), values[i]) == pending.cend()) {
+                    pending.push_back(values[i]);
+                }
+            }
+            break;
+        case GpuStatsInfo::Stats::CREATED_VULKAN_API_VERSION: {
+            // The last version set wins.
+            const uint64_t version = values[valueCount - 1];
+            if (sent.size() == 1 && sent[0] == version) {
+                pending.clear();
+            } else {
+                pending = {version};
+            }
+            break;
+        }
+        case GpuStatsInfo::Stats::VULKAN_DEVICE_FEATURES_ENABLED: {
+            // Feature bits are merged together.
+            uint64_t features = pending.empty() ? 0 : pending[0];
+            for (uint32_t i = 0; i < valueCount; i++) {
+                features |= values[i];
+            }
+            const uint64_t sentFeatures = sent.empty() ? 0 : sent[0];
+            if (features & ~sentFeatures) {
+                pending = {features | sentFeatures};
+            }
+            break;
+        }
+        default:
+            // The rest only record that the stat was seen.
+            if (sent.empty() && pending.empty()) {
+                pending.push_back(values[0]);
+            }
+            break;
+    }
+
+    if (pending.empty()) {
+        mPendingTargetStats.erase(stats);
+        return;
+    }
+    scheduleTargetStatsFlushLocked();
+}
+
+void GraphicsEnv::scheduleTargetStatsFlushLocked() {
+    if (mTargetStatsFlushScheduled) return;
+    mTargetStatsFlushScheduled = true;
+
+    std::thread flushTargetStatsThread([this]() {
+        std::this_thread::sleep_for(kTargetStatsFlushDelay);
+        std::lock_guard<std::mutex> lock(mStatsLock);
+        flushTargetStatsLocked();
+    });
+    flushTargetStatsThread.detach();
+}
+
+void GraphicsEnv::flushTargetStatsLocked() {
+    ATRACE_CALL();
+
+    mTargetStatsFlushScheduled = false;
+    if (mPendingTargetStats.empty() && mPendingEngineNames.empty()) return;
+
+    std::vector<GpuStatsInfo::TargetStats> batch;
+    batch.reserve(mPendingTargetStats.size());
+    for (auto& [stats, values] : mPendingTargetStats) {
+        std::vector<uint64_t>& sent = mSentTargetStats[stats];
+        if (stats == GpuStatsInfo::Stats::VULKAN_INSTANCE_EXTENSION ||
+            stats == GpuStatsInfo::Stats::VULKAN_DEVICE_EXTENSION) {
+            sent.insert(sent.end(), values.cbegin(), values.cend());
+        } else {
+            sent = values;
+        }
+        batch.push_back({stats, std::move(values)});
+    }
+    mPendingTargetStats.clear();
+    mSentEngineNames.insert(mSentEngineNames.end(), mPendingEngineNames.cbegin(),
+                            mPendingEngineNames.cend());
+
     const sp<IGpuService> gpuService = getGpuService();
     if (gpuService) {
-        gpuService->setTargetStatsArray(mGpuStats.appPackageName, mGpuStats.driverVersionCode,
-                                        stats, values, valueCount);
+        gpuService->setTargetStatsBatch(mGpuStats.appPackageName, mGpuStats.driverVersionCode,
+                                        batch, mPendingEngineNames);
     }
+    mPendingEngineNames.clear();
 }
 
 void GraphicsEnv::sendGpuStatsLocked(GpuStatsInfo::Api api, bool isDriverLoaded,
@@ -567,6 +669,11 @@ void GraphicsEnv::sendGpuStatsLocked(GpuStatsInfo::Api api, bool isDriverLoaded,
                                 mGpuStats.appPackageName, mGpuStats.vulkanVersion, driver,
                                 isIntendedDriverLoaded, driverLoadingTime);
     }
+
+    // GpuService may have dropped the app stats since, so the target stats seen from now on are
+    // sent again.
+    mSentTargetStats.clear();
+    mSentEngineNames.clear();
 }
 
 bool GraphicsEnv::setInjectLayersPrSetDumpable() {
@@ -728,6 +835,14 @@ const std::string& GraphicsEnv::getLayerPaths() {
     return mLayerPaths;
 }
 
+void GraphicsEnv::setLayerCacheDir(const std::string& cacheDir) {
+    mLayerCacheDir = cacheDir;
+}
+
+const std::string& GraphicsEnv::getLayerCacheDir() {
+    return mLayerCacheDir;
+}
+
 const std::string& GraphicsEnv::getDebugLayers() {
     return mDebugLayers;
 }
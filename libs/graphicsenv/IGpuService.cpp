@@ -90,6 +90,29 @@ public:
                            IBinder::FLAG_ONEWAY);
     }
 
+    void setTargetStatsBatch(const std::string& appPackageName, const uint64_t driverVersionCode,
+                             const std::vector<GpuStatsInfo::TargetStats>& stats,
+                             const std::vector<std::string>& engineNames) override {
+        Parcel data, reply;
+        data.writeInterfaceToken(IGpuService::getInterfaceDescriptor());
+
+        data.writeUtf8AsUtf16(appPackageName);
+        data.writeUint64(driverVersionCode);
+        data.writeUint32(static_cast<uint32_t>(stats.size()));
+        for (const auto& targetStats : stats) {
+            data.writeInt32(static_cast<int32_t>(targetStats.stats));
+            data.writeUint32(static_cast<uint32_t>(targetStats.values.size()));
+            data.write(targetStats.values.data(), targetStats.values.size() * sizeof(uint64_t));
+        }
+        data.writeUint32(static_cast<uint32_t>(engineNames.size()));
+        for (const auto& engineName : engineNames) {
+            data.writeCString(engineName.c_str());
+        }
+
+        remote()->transact(BnGpuService::SET_TARGET_STATS_BATCH, data, &reply,
+                           IBinder::FLAG_ONEWAY);
+    }
+
     void setUpdatableDriverPath(const std::string& driverPath) override {
         Parcel data, reply;
         data.writeInterfaceToken(IGpuService::getInterfaceDescriptor());
@@ -119,6 +142,19 @@ public:
         }
         return driverPath;
     }
+
+    uint64_t getGpuActiveDuration(uint32_t uid) override {
+        Parcel data, reply;
+        data.writeInterfaceToken(IGpuService::getInterfaceDescriptor());
+        data.writeUint32(uid);
+
+        status_t error = remote()->transact(BnGpuService::GET_GPU_ACTIVE_DURATION, data, &reply);
+        uint64_t activeDurationNs = 0;
+        if (error == OK) {
+            error = reply.readUint64(&activeDurationNs);
+        }
+        return error == OK ? activeDurationNs : 0;
+    }
 };
 
 IMPLEMENT_META_INTERFACE(GpuService, "android.graphicsenv.IGpuService");
@@ -225,6 +261,47 @@ status_t BnGpuService::onTransact(uint32_t code, const Parcel& data, Parcel* rep
             addVulkanEngineName(appPackageName, driverVersionCode, engineName);
             return OK;
         }
+        case SET_TARGET_STATS_BATCH: {
+            CHECK_INTERFACE(IGpuService, data, reply);
+
+            std::string appPackageName;
+            if ((status = data.readUtf8FromUtf16(&appPackageName)) != OK) return status;
+
+            uint64_t driverVersionCode;
+            if ((status = data.readUint64(&driverVersionCode)) != OK) return status;
+
+            uint32_t statsCount;
+            if ((status = data.readUint32(&statsCount)) != OK) return status;
+
+            std::vector<GpuStatsInfo::TargetStats> stats;
+            for (uint32_t i = 0; i < statsCount; i++) {
+                int32_t targetStats;
+                if ((status = data.readInt32(&targetStats)) != OK) return status;
+
+                uint32_t valueCount;
+                if ((status = data.readUint32(&valueCount)) != OK) return status;
+                if (valueCount > data.dataAvail() / sizeof(uint64_t)) return BAD_VALUE;
+
+                std::vector<uint64_t> values(valueCount);
+                if ((status = data.read(values.data(), valueCount * sizeof(uint64_t))) != OK) {
+                    return status;
+                }
+                stats.push_back({static_cast<GpuStatsInfo::Stats>(targetStats), std::move(values)});
+            }
+
+            uint32_t engineNameCount;
+            if ((status = data.readUint32(&engineNameCount)) != OK) return status;
+
+            std::vector<std::string> engineNames;
+            for (uint32_t i = 0; i < engineNameCount; i++) {
+                const char* engineName;
+                if ((engineName = data.readCString()) == nullptr) return BAD_VALUE;
+                engineNames.emplace_back(engineName);
+            }
+
+            setTargetStatsBatch(appPackageName, driverVersionCode, stats, engineNames);
+            return OK;
+        }
         case SET_UPDATABLE_DRIVER_PATH: {
             CHECK_INTERFACE(IGpuService, data, reply);
 
@@ -240,6 +317,14 @@ status_t BnGpuService::onTransact(uint32_t code, const Parcel& data, Parcel* rep
             std::string driverPath = getUpdatableDriverPath();
             return reply->writeUtf8AsUtf16(driverPath);
         }
+        case GET_GPU_ACTIVE_DURATION: {
+            CHECK_INTERFACE(IGpuService, data, reply);
+
+            uint32_t uid;
+            if ((status = data.readUint32(&uid)) != OK) return status;
+
+            return reply->writeUint64(getGpuActiveDuration(uid));
+        }
         case SHELL_COMMAND_TRANSACTION: {
             int in = dup(data.readFileDescriptor());
             int out = dup(data.readFileDescriptor());
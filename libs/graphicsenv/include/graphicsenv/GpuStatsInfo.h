@@ -130,6 +130,12 @@ public:
         SKIP_TELEMETRY = 1,
     };
 
+    // Values of one target stats type, as sent to GpuService in a batch.
+    struct TargetStats {
+        Stats stats;
+        std::vector<uint64_t> values;
+    };
+
     GpuStatsInfo() = default;
     GpuStatsInfo(const GpuStatsInfo&) = default;
     virtual ~GpuStatsInfo() = default;
@@ -19,6 +19,7 @@
 
 #include <graphicsenv/GpuStatsInfo.h>
 
+#include <map>
 #include <mutex>
 #include <string>
 #include <vector>
@@ -134,6 +135,10 @@ public:
     NativeLoaderNamespace* getAppNamespace();
     // Get additional layer search paths.
     const std::string& getLayerPaths();
+    // Set the directory where the layers found in the search paths are cached.
+    void setLayerCacheDir(const std::string& cacheDir);
+    // Get the directory where the layers found in the search paths are cached.
+    const std::string& getLayerCacheDir();
     // Set the Vulkan debug layers.
     void setDebugLayers(const std::string& layers);
     // Set the GL debug layers.
@@ -152,6 +157,13 @@ private:
     bool readyToSendGpuStatsLocked();
     // Send the initial complete GpuStats to GpuService.
     void sendGpuStatsLocked(GpuStatsInfo::Api api, bool isDriverLoaded, int64_t driverLoadingTime);
+    // Merge target stats into the pending batch, leaving out what GpuService already has.
+    void addTargetStatsLocked(const GpuStatsInfo::Stats stats, const uint64_t* values,
+                              const uint32_t valueCount);
+    // Schedule the pending batch to be sent, unless it already is.
+    void scheduleTargetStatsFlushLocked();
+    // Send the pending batch of target stats and engine names to GpuService.
+    void flushTargetStatsLocked();
 
     GraphicsEnv() = default;
 
@@ -195,6 +207,15 @@ private:
     bool mActivityLaunched = false;
     // Information bookkept for GpuStats.
     GpuStatsInfo mGpuStats;
+    // Target stats and engine names waiting to be sent to GpuService in the next batch.
+    std::map<GpuStatsInfo::Stats, std::vector<uint64_t>> mPendingTargetStats;
+    std::vector<std::string> mPendingEngineNames;
+    // Target stats and engine names sent since the driver stats were last sent. GpuService only
+    // keeps whether a stat was seen, so there is no need to send them again.
+    std::map<GpuStatsInfo::Stats, std::vector<uint64_t>> mSentTargetStats;
+    std::vector<std::string> mSentEngineNames;
+    // Whether the pending batch is scheduled to be sent.
+    bool mTargetStatsFlushScheduled = false;
 
     /**
      * Debug layers.
@@ -205,6 +226,8 @@ private:
     std::string mDebugLayersGLES;
     // Additional debug layers search path.
     std::string mLayerPaths;
+    // Directory to cache the layers found in the search paths.
+    std::string mLayerCacheDir;
     // This App's namespace to open native libraries.
     NativeLoaderNamespace* mAppNamespace = nullptr;
 };
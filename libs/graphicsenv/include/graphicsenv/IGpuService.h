@@ -48,6 +48,11 @@ public:
                                      const uint32_t valueCount) = 0;
     virtual void addVulkanEngineName(const std::string& appPackageName,
                                      const uint64_t driverVersionCode, const char* engineName) = 0;
+    // set a batch of target stats and vulkan engine names at once.
+    virtual void setTargetStatsBatch(const std::string& appPackageName,
+                                     const uint64_t driverVersionCode,
+                                     const std::vector<GpuStatsInfo::TargetStats>& stats,
+                                     const std::vector<std::string>& engineNames) = 0;
 
     // setter and getter for updatable driver path.
     virtual void setUpdatableDriverPath(const std::string& driverPath) = 0;
@@ -55,6 +60,10 @@ public:
 
     // sets ANGLE as system GLES driver if enabled==true by setting persist.graphics.egl to true.
     virtual void toggleAngleAsSystemDriver(bool enabled) = 0;
+
+    // get the total GPU active time of uid in nanoseconds, which lags behind the GPU by a few tens
+    // of milliseconds at most. Returns 0 if not available.
+    virtual uint64_t getGpuActiveDuration(uint32_t uid) = 0;
 };
 
 class BnGpuService : public BnInterface<IGpuService> {
@@ -67,6 +76,8 @@ public:
         TOGGLE_ANGLE_AS_SYSTEM_DRIVER,
         SET_TARGET_STATS_ARRAY,
         ADD_VULKAN_ENGINE_NAME,
+        GET_GPU_ACTIVE_DURATION,
+        SET_TARGET_STATS_BATCH,
         // Always append new enum to the end.
     };
 
@@ -1337,6 +1337,13 @@ status_t BLASTBufferQueue::BufferReleaseReader::readBlocking(ReleaseCallbackId&
     return mEndpoint->readReleaseFence(outId, outFence, outMaxAcquiredBufferCount);
 }
 
+status_t BLASTBufferQueue::BufferReleaseReader::readNonBlocking(
+        ReleaseCallbackId& outId, sp<Fence>& outFence, uint32_t& outMaxAcquiredBufferCount) {
+    // The consumer end of the channel is non-blocking, so this returns WOULD_BLOCK once drained.
+    std::lock_guard lock{mMutex};
+    return mEndpoint->readReleaseFence(outId, outFence, outMaxAcquiredBufferCount);
+}
+
 void BLASTBufferQueue::BufferReleaseReader::interruptBlockingRead() {
     uint64_t value = 1;
     if (write(mEventFd.get(), &value, sizeof(uint64_t)) == -1) {
@@ -1344,24 +1351,49 @@ void BLASTBufferQueue::BufferReleaseReader::interruptBlockingRead() {
     }
 }
 
+void BLASTBufferQueue::releaseBuffersFromChannel(const std::vector<BufferRelease>& releases) {
+    // Buffers of sync transactions also register a release callback, in case the transaction is
+    // merged and the buffer overwritten before it reaches SurfaceFlinger. Once SurfaceFlinger has
+    // released a buffer through the channel that callback won't be called, so drop it.
+    const auto listener = TransactionCompletedListener::getInstance();
+    for (const auto& release : releases) {
+        listener->removeReleaseBufferCallback(release.id);
+    }
+
+    std::lock_guard _lock{mMutex};
+    BBQ_TRACE("releases=%zu", releases.size());
+    for (const auto& release : releases) {
+        releaseBufferCallbackLocked(release.id, release.fence, release.maxAcquiredBufferCount,
+                                    false /* fakeRelease */);
+    }
+}
+
 void BLASTBufferQueue::BufferReleaseThread::start(const sp<BLASTBufferQueue>& bbq) {
     mRunning = std::make_shared<std::atomic_bool>(true);
     mReader = bbq->mBufferReleaseReader;
     std::thread([running = mRunning, reader = mReader, weakBbq = wp<BLASTBufferQueue>(bbq)]() {
         pthread_setname_np(pthread_self(), "BufferReleaseThread");
+        std::vector<BufferRelease> releases;
         while (*running) {
-            ReleaseCallbackId id;
-            sp<Fence> fence;
-            uint32_t maxAcquiredBufferCount;
-            if (status_t status = reader->readBlocking(id, fence, maxAcquiredBufferCount);
+            BufferRelease release;
+            if (status_t status = reader->readBlocking(release.id, release.fence,
+                                                       release.maxAcquiredBufferCount);
                 status != OK) {
                 continue;
             }
+            // SurfaceFlinger often releases several buffers at once, e.g. when a frame is
+            // dropped, so pick up everything that is pending before waking up the BBQ.
+            releases.push_back(std::move(release));
+            while (reader->readNonBlocking(release.id, release.fence,
+                                           release.maxAcquiredBufferCount) == OK) {
+                releases.push_back(std::move(release));
+            }
             sp<BLASTBufferQueue> bbq = weakBbq.promote();
             if (!bbq) {
                 return;
             }
-            bbq->releaseBufferCallback(id, fence, maxAcquiredBufferCount);
+            bbq->releaseBuffersFromChannel(releases);
+            releases.clear();
         }
     }).detach();
 }
@@ -262,7 +262,9 @@ status_t BufferQueueConsumer::acquireBuffer(BufferItem* outBuffer,
             return NO_BUFFER_AVAILABLE;
         } else {
             slot = front->mSlot;
-            *outBuffer = *front;
+            // The item is erased from the queue below, so take its contents
+            // rather than copying them while holding the lock.
+            *outBuffer = std::move(*front);
         }
 
         ATRACE_BUFFER_INDEX(slot);
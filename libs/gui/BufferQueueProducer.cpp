@@ -97,7 +97,24 @@ status_t BufferQueueProducer::requestBuffer(int slot, sp<GraphicBuffer>* buf) {
     ATRACE_CALL();
     BQ_LOGV("requestBuffer: slot %d", slot);
     std::lock_guard<std::mutex> lock(mCore->mMutex);
+    return requestBufferLocked(slot, buf);
+}
+
+status_t BufferQueueProducer::requestBuffers(const std::vector<int32_t>& slots,
+                                             std::vector<RequestBufferOutput>* outputs) {
+    ATRACE_CALL();
+    BQ_LOGV("requestBuffers: %zu slots", slots.size());
+    outputs->clear();
+    outputs->reserve(slots.size());
+    std::lock_guard<std::mutex> lock(mCore->mMutex);
+    for (int32_t slot : slots) {
+        RequestBufferOutput& output = outputs->emplace_back();
+        output.result = requestBufferLocked(static_cast<int>(slot), &output.buffer);
+    }
+    return NO_ERROR;
+}
 
+status_t BufferQueueProducer::requestBufferLocked(int slot, sp<GraphicBuffer>* buf) {
     if (mCore->mIsAbandoned) {
         BQ_LOGE("requestBuffer: BufferQueue has been abandoned");
         return NO_INIT;
@@ -427,6 +444,9 @@ status_t BufferQueueProducer::dequeueBuffer(int* outSlot, sp<android::Fence>* ou
     sp<IConsumerListener> listener;
     bool callOnFrameDequeued = false;
     uint64_t bufferId = 0; // Only used if callOnFrameDequeued == true
+    // Freeing a buffer may call into the allocator, so a buffer that is
+    // replaced is released after mCore->mMutex is dropped.
+    sp<GraphicBuffer> replacedBuffer;
 #if COM_ANDROID_GRAPHICS_LIBGUI_FLAGS(BQ_EXTENDEDALLOCATE)
     std::vector<gui::AdditionalOptions> allocOptions;
     uint32_t allocOptionsGenId = 0;
@@ -536,7 +556,7 @@ status_t BufferQueueProducer::dequeueBuffer(int* outSlot, sp<android::Fence>* ou
                 }
             }
             mSlots[found].mAcquireCalled = false;
-            mSlots[found].mGraphicBuffer = nullptr;
+            replacedBuffer = std::move(mSlots[found].mGraphicBuffer);
             mSlots[found].mRequestBufferCalled = false;
             mSlots[found].mEglDisplay = EGL_NO_DISPLAY;
             mSlots[found].mEglFence = EGL_NO_SYNC_KHR;
@@ -590,6 +610,9 @@ status_t BufferQueueProducer::dequeueBuffer(int* outSlot, sp<android::Fence>* ou
         listener = mCore->mConsumerListener;
     } // Autolock scope
 
+    // Release the old buffer before allocating its replacement.
+    replacedBuffer.clear();
+
     if (returnFlags & BUFFER_NEEDS_REALLOCATION) {
         BQ_LOGV("dequeueBuffer: allocating a new buffer for slot %d", *outSlot);
 
@@ -695,65 +718,106 @@ status_t BufferQueueProducer::detachBuffer(int slot) {
     BQ_LOGV("detachBuffer: slot %d", slot);
 
     sp<IConsumerListener> listener;
-    bool callOnFrameDetached = false;
-    uint64_t bufferId = 0; // Only used if callOnFrameDetached is true
+    uint64_t bufferId = 0;
     {
         std::lock_guard<std::mutex> lock(mCore->mMutex);
-
-        if (mCore->mIsAbandoned) {
-            BQ_LOGE("detachBuffer: BufferQueue has been abandoned");
-            return NO_INIT;
+        status_t result = detachBufferLocked(slot, &bufferId);
+        if (result != NO_ERROR) {
+            return result;
         }
+        listener = mCore->mConsumerListener;
+    }
 
-        if (mCore->mConnectedApi == BufferQueueCore::NO_CONNECTED_API) {
-            BQ_LOGE("detachBuffer: BufferQueue has no connected producer");
-            return NO_INIT;
-        }
+    if (listener != nullptr && bufferId != 0) {
+        listener->onFrameDetached(bufferId);
+    }
 
-        if (mCore->mSharedBufferMode || mCore->mSharedBufferSlot == slot) {
-            BQ_LOGE("detachBuffer: cannot detach a buffer in shared buffer mode");
-            return BAD_VALUE;
-        }
+    if (listener != nullptr) {
+        listener->onBuffersReleased();
+    }
 
-        if (slot < 0 || slot >= BufferQueueDefs::NUM_BUFFER_SLOTS) {
-            BQ_LOGE("detachBuffer: slot index %d out of range [0, %d)",
-                    slot, BufferQueueDefs::NUM_BUFFER_SLOTS);
-            return BAD_VALUE;
-        } else if (!mSlots[slot].mBufferState.isDequeued()) {
-            // TODO(http://b/140581935): This message is BQ_LOGW because it
-            // often logs when no actionable errors are present. Return to
-            // using BQ_LOGE after ensuring this only logs during errors.
-            BQ_LOGW("detachBuffer: slot %d is not owned by the producer "
-                    "(state = %s)", slot, mSlots[slot].mBufferState.string());
-            return BAD_VALUE;
-        } else if (!mSlots[slot].mRequestBufferCalled) {
-            BQ_LOGE("detachBuffer: buffer in slot %d has not been requested",
-                    slot);
-            return BAD_VALUE;
-        }
+    return NO_ERROR;
+}
+
+status_t BufferQueueProducer::detachBuffers(const std::vector<int32_t>& slots,
+                                            std::vector<status_t>* results) {
+    ATRACE_CALL();
+    BQ_LOGV("detachBuffers: %zu slots", slots.size());
+    results->clear();
+    results->reserve(slots.size());
 
+    sp<IConsumerListener> listener;
+    std::vector<uint64_t> bufferIds(slots.size(), 0);
+    bool anyDetached = false;
+    {
+        std::lock_guard<std::mutex> lock(mCore->mMutex);
+        for (size_t i = 0; i < slots.size(); i++) {
+            status_t result = detachBufferLocked(slots[i], &bufferIds[i]);
+            results->push_back(result);
+            anyDetached |= result == NO_ERROR;
+        }
         listener = mCore->mConsumerListener;
-        auto gb = mSlots[slot].mGraphicBuffer;
-        if (gb != nullptr) {
-            callOnFrameDetached = true;
-            bufferId = gb->getId();
+    }
+
+    if (listener != nullptr) {
+        for (uint64_t bufferId : bufferIds) {
+            if (bufferId != 0) {
+                listener->onFrameDetached(bufferId);
+            }
+        }
+        if (anyDetached) {
+            listener->onBuffersReleased();
         }
-        mSlots[slot].mBufferState.detachProducer();
-        mCore->mActiveBuffers.erase(slot);
-        mCore->mFreeSlots.insert(slot);
-        mCore->clearBufferSlotLocked(slot);
-        mCore->mDequeueCondition.notify_all();
-        VALIDATE_CONSISTENCY();
     }
 
-    if (listener != nullptr && callOnFrameDetached) {
-        listener->onFrameDetached(bufferId);
+    return NO_ERROR;
+}
+
+status_t BufferQueueProducer::detachBufferLocked(int slot, uint64_t* outBufferId) {
+    *outBufferId = 0;
+
+    if (mCore->mIsAbandoned) {
+        BQ_LOGE("detachBuffer: BufferQueue has been abandoned");
+        return NO_INIT;
     }
 
-    if (listener != nullptr) {
-        listener->onBuffersReleased();
+    if (mCore->mConnectedApi == BufferQueueCore::NO_CONNECTED_API) {
+        BQ_LOGE("detachBuffer: BufferQueue has no connected producer");
+        return NO_INIT;
     }
 
+    if (mCore->mSharedBufferMode || mCore->mSharedBufferSlot == slot) {
+        BQ_LOGE("detachBuffer: cannot detach a buffer in shared buffer mode");
+        return BAD_VALUE;
+    }
+
+    if (slot < 0 || slot >= BufferQueueDefs::NUM_BUFFER_SLOTS) {
+        BQ_LOGE("detachBuffer: slot index %d out of range [0, %d)",
+                slot, BufferQueueDefs::NUM_BUFFER_SLOTS);
+        return BAD_VALUE;
+    } else if (!mSlots[slot].mBufferState.isDequeued()) {
+        // TODO(http://b/140581935): This message is BQ_LOGW because it
+        // often logs when no actionable errors are present. Return to
+        // using BQ_LOGE after ensuring this only logs during errors.
+        BQ_LOGW("detachBuffer: slot %d is not owned by the producer "
+                "(state = %s)", slot, mSlots[slot].mBufferState.string());
+        return BAD_VALUE;
+    } else if (!mSlots[slot].mRequestBufferCalled) {
+        BQ_LOGE("detachBuffer: buffer in slot %d has not been requested",
+                slot);
+        return BAD_VALUE;
+    }
+
+    auto gb = mSlots[slot].mGraphicBuffer;
+    if (gb != nullptr) {
+        *outBufferId = gb->getId();
+    }
+    mSlots[slot].mBufferState.detachProducer();
+    mCore->mActiveBuffers.erase(slot);
+    mCore->mFreeSlots.insert(slot);
+    mCore->clearBufferSlotLocked(slot);
+    mCore->mDequeueCondition.notify_all();
+    VALIDATE_CONSISTENCY();
     return NO_ERROR;
 }
 
@@ -889,228 +953,273 @@ status_t BufferQueueProducer::queueBuffer(int slot,
     ATRACE_CALL();
     ATRACE_BUFFER_INDEX(slot);
 
-    int64_t requestedPresentTimestamp;
-    bool isAutoTimestamp;
-    android_dataspace dataSpace;
-    Rect crop(Rect::EMPTY_RECT);
-    int scalingMode;
-    uint32_t transform;
-    uint32_t stickyTransform;
-    sp<Fence> acquireFence;
-    bool getFrameTimestamps = false;
-    input.deflate(&requestedPresentTimestamp, &isAutoTimestamp, &dataSpace,
-            &crop, &scalingMode, &transform, &acquireFence, &stickyTransform,
-            &getFrameTimestamps);
-    const Region& surfaceDamage = input.getSurfaceDamage();
-    const HdrMetadata& hdrMetadata = input.getHdrMetadata();
-
-    if (acquireFence == nullptr) {
+    QueuedFrame frame;
+    status_t result = prepareQueueBuffer(input, &frame);
+    if (result != NO_ERROR) {
+        return result;
+    }
+
+    { // Autolock scope
+        std::lock_guard<std::mutex> lock(mCore->mMutex);
+        result = queueBufferLocked(slot, &frame, output);
+        if (result != NO_ERROR) {
+            return result;
+        }
+    } // Autolock scope
+
+    onBufferQueued(frame, output);
+    return NO_ERROR;
+}
+
+status_t BufferQueueProducer::queueBuffers(const std::vector<QueueBufferInput>& inputs,
+                                           std::vector<QueueBufferOutput>* outputs) {
+    ATRACE_CALL();
+    BQ_LOGV("queueBuffers: %zu buffers", inputs.size());
+    outputs->clear();
+    outputs->resize(inputs.size());
+
+    std::vector<QueuedFrame> frames(inputs.size());
+    for (size_t i = 0; i < inputs.size(); i++) {
+        (*outputs)[i].result = prepareQueueBuffer(inputs[i], &frames[i]);
+    }
+
+    { // Autolock scope
+        std::lock_guard<std::mutex> lock(mCore->mMutex);
+        for (size_t i = 0; i < inputs.size(); i++) {
+            QueueBufferOutput& output = (*outputs)[i];
+            if (output.result == NO_ERROR) {
+                output.result = queueBufferLocked(inputs[i].slot, &frames[i], &output);
+            }
+        }
+    } // Autolock scope
+
+    // The callback tickets were taken in order above, so the frames are
+    // delivered to the consumer in the order they were queued.
+    for (size_t i = 0; i < inputs.size(); i++) {
+        if ((*outputs)[i].result == NO_ERROR) {
+            onBufferQueued(frames[i], &(*outputs)[i]);
+        }
+    }
+    return NO_ERROR;
+}
+
+status_t BufferQueueProducer::prepareQueueBuffer(const QueueBufferInput& input,
+                                                 QueuedFrame* outFrame) const {
+    input.deflate(&outFrame->requestedPresentTimestamp, &outFrame->isAutoTimestamp,
+            &outFrame->dataSpace, &outFrame->crop, &outFrame->scalingMode,
+            &outFrame->transform, &outFrame->acquireFence, &outFrame->stickyTransform,
+            &outFrame->getFrameTimestamps);
+
+    if (outFrame->acquireFence == nullptr) {
         BQ_LOGE("queueBuffer: fence is NULL");
         return BAD_VALUE;
     }
 
-    auto acquireFenceTime = std::make_shared<FenceTime>(acquireFence);
-
-    switch (scalingMode) {
+    switch (outFrame->scalingMode) {
         case NATIVE_WINDOW_SCALING_MODE_FREEZE:
         case NATIVE_WINDOW_SCALING_MODE_SCALE_TO_WINDOW:
         case NATIVE_WINDOW_SCALING_MODE_SCALE_CROP:
         case NATIVE_WINDOW_SCALING_MODE_NO_SCALE_CROP:
             break;
         default:
-            BQ_LOGE("queueBuffer: unknown scaling mode %d", scalingMode);
+            BQ_LOGE("queueBuffer: unknown scaling mode %d", outFrame->scalingMode);
             return BAD_VALUE;
     }
 
-    sp<IConsumerListener> frameAvailableListener;
-    sp<IConsumerListener> frameReplacedListener;
-    int callbackTicket = 0;
-    uint64_t currentFrameNumber = 0;
-    BufferItem item;
-    int connectedApi;
-    bool enableEglCpuThrottling = true;
-    sp<Fence> lastQueuedFence;
-
-    { // Autolock scope
-        std::lock_guard<std::mutex> lock(mCore->mMutex);
+    outFrame->acquireFenceTime = std::make_shared<FenceTime>(outFrame->acquireFence);
+
+    // Fill in the parts of the BufferItem that only depend on the input here,
+    // so that the damage and HDR metadata aren't copied under mCore->mMutex.
+    BufferItem& item = outFrame->item;
+    item.mCrop = outFrame->crop;
+    item.mTransform = outFrame->transform &
+            ~static_cast<uint32_t>(NATIVE_WINDOW_TRANSFORM_INVERSE_DISPLAY);
+    item.mTransformToDisplayInverse =
+            (outFrame->transform & NATIVE_WINDOW_TRANSFORM_INVERSE_DISPLAY) != 0;
+    item.mScalingMode = static_cast<uint32_t>(outFrame->scalingMode);
+    item.mTimestamp = outFrame->requestedPresentTimestamp;
+    item.mIsAutoTimestamp = outFrame->isAutoTimestamp;
+    item.mHdrMetadata = input.getHdrMetadata();
+    item.mFence = outFrame->acquireFence;
+    item.mFenceTime = outFrame->acquireFenceTime;
+    item.mSurfaceDamage = input.getSurfaceDamage();
+    item.mQueuedBuffer = true;
+    return NO_ERROR;
+}
 
-        if (mCore->mIsAbandoned) {
-            BQ_LOGE("queueBuffer: BufferQueue has been abandoned");
-            return NO_INIT;
-        }
+status_t BufferQueueProducer::queueBufferLocked(int slot, QueuedFrame* frame,
+                                                QueueBufferOutput* output) {
+    if (mCore->mIsAbandoned) {
+        BQ_LOGE("queueBuffer: BufferQueue has been abandoned");
+        return NO_INIT;
+    }
 
-        if (mCore->mConnectedApi == BufferQueueCore::NO_CONNECTED_API) {
-            BQ_LOGE("queueBuffer: BufferQueue has no connected producer");
-            return NO_INIT;
-        }
+    if (mCore->mConnectedApi == BufferQueueCore::NO_CONNECTED_API) {
+        BQ_LOGE("queueBuffer: BufferQueue has no connected producer");
+        return NO_INIT;
+    }
 
-        if (slot < 0 || slot >= BufferQueueDefs::NUM_BUFFER_SLOTS) {
-            BQ_LOGE("queueBuffer: slot index %d out of range [0, %d)",
-                    slot, BufferQueueDefs::NUM_BUFFER_SLOTS);
-            return BAD_VALUE;
-        } else if (!mSlots[slot].mBufferState.isDequeued()) {
-            BQ_LOGE("queueBuffer: slot %d is not owned by the producer "
-                    "(state = %s)", slot, mSlots[slot].mBufferState.string());
-            return BAD_VALUE;
-        } else if (!mSlots[slot].mRequestBufferCalled) {
-            BQ_LOGE("queueBuffer: slot %d was queued without requesting "
-                    "a buffer", slot);
-            return BAD_VALUE;
-        }
+    if (slot < 0 || slot >= BufferQueueDefs::NUM_BUFFER_SLOTS) {
+        BQ_LOGE("queueBuffer: slot index %d out of range [0, %d)",
+                slot, BufferQueueDefs::NUM_BUFFER_SLOTS);
+        return BAD_VALUE;
+    } else if (!mSlots[slot].mBufferState.isDequeued()) {
+        BQ_LOGE("queueBuffer: slot %d is not owned by the producer "
+                "(state = %s)", slot, mSlots[slot].mBufferState.string());
+        return BAD_VALUE;
+    } else if (!mSlots[slot].mRequestBufferCalled) {
+        BQ_LOGE("queueBuffer: slot %d was queued without requesting "
+                "a buffer", slot);
+        return BAD_VALUE;
+    }
 
-        // If shared buffer mode has just been enabled, cache the slot of the
-        // first buffer that is queued and mark it as the shared buffer.
-        if (mCore->mSharedBufferMode && mCore->mSharedBufferSlot ==
-                BufferQueueCore::INVALID_BUFFER_SLOT) {
-            mCore->mSharedBufferSlot = slot;
-            mSlots[slot].mBufferState.mShared = true;
-        }
+    // If shared buffer mode has just been enabled, cache the slot of the
+    // first buffer that is queued and mark it as the shared buffer.
+    if (mCore->mSharedBufferMode && mCore->mSharedBufferSlot ==
+            BufferQueueCore::INVALID_BUFFER_SLOT) {
+        mCore->mSharedBufferSlot = slot;
+        mSlots[slot].mBufferState.mShared = true;
+    }
 
-        BQ_LOGV("queueBuffer: slot=%d/%" PRIu64 " time=%" PRIu64 " dataSpace=%d"
-                " validHdrMetadataTypes=0x%x crop=[%d,%d,%d,%d] transform=%#x scale=%s",
-                slot, mCore->mFrameCounter + 1, requestedPresentTimestamp, dataSpace,
-                hdrMetadata.validTypes, crop.left, crop.top, crop.right, crop.bottom,
-                transform,
-                BufferItem::scalingModeName(static_cast<uint32_t>(scalingMode)));
-
-        const sp<GraphicBuffer>& graphicBuffer(mSlots[slot].mGraphicBuffer);
-        Rect bufferRect(graphicBuffer->getWidth(), graphicBuffer->getHeight());
-        Rect croppedRect(Rect::EMPTY_RECT);
-        crop.intersect(bufferRect, &croppedRect);
-        if (croppedRect != crop) {
-            BQ_LOGE("queueBuffer: crop rect is not contained within the "
-                    "buffer in slot %d", slot);
-            return BAD_VALUE;
-        }
+    BufferItem& item = frame->item;
+    const Rect& crop = frame->crop;
+    BQ_LOGV("queueBuffer: slot=%d/%" PRIu64 " time=%" PRIu64 " dataSpace=%d"
+            " validHdrMetadataTypes=0x%x crop=[%d,%d,%d,%d] transform=%#x scale=%s",
+            slot, mCore->mFrameCounter + 1, frame->requestedPresentTimestamp, frame->dataSpace,
+            item.mHdrMetadata.validTypes, crop.left, crop.top, crop.right, crop.bottom,
+            frame->transform,
+            BufferItem::scalingModeName(static_cast<uint32_t>(frame->scalingMode)));
+
+    const sp<GraphicBuffer>& graphicBuffer(mSlots[slot].mGraphicBuffer);
+    Rect bufferRect(graphicBuffer->getWidth(), graphicBuffer->getHeight());
+    Rect croppedRect(Rect::EMPTY_RECT);
+    crop.intersect(bufferRect, &croppedRect);
+    if (croppedRect != crop) {
+        BQ_LOGE("queueBuffer: crop rect is not contained within the "
+                "buffer in slot %d", slot);
+        return BAD_VALUE;
+    }
 
-        // Override UNKNOWN dataspace with consumer default
-        if (dataSpace == HAL_DATASPACE_UNKNOWN) {
-            dataSpace = mCore->mDefaultBufferDataSpace;
-        }
+    // Override UNKNOWN dataspace with consumer default
+    if (frame->dataSpace == HAL_DATASPACE_UNKNOWN) {
+        frame->dataSpace = mCore->mDefaultBufferDataSpace;
+    }
 
-        mSlots[slot].mFence = acquireFence;
-        mSlots[slot].mBufferState.queue();
-
-        // Increment the frame counter and store a local version of it
-        // for use outside the lock on mCore->mMutex.
-        ++mCore->mFrameCounter;
-        currentFrameNumber = mCore->mFrameCounter;
-        mSlots[slot].mFrameNumber = currentFrameNumber;
-
-        item.mAcquireCalled = mSlots[slot].mAcquireCalled;
-        item.mGraphicBuffer = mSlots[slot].mGraphicBuffer;
-        item.mCrop = crop;
-        item.mTransform = transform &
-                ~static_cast<uint32_t>(NATIVE_WINDOW_TRANSFORM_INVERSE_DISPLAY);
-        item.mTransformToDisplayInverse =
-                (transform & NATIVE_WINDOW_TRANSFORM_INVERSE_DISPLAY) != 0;
-        item.mScalingMode = static_cast<uint32_t>(scalingMode);
-        item.mTimestamp = requestedPresentTimestamp;
-        item.mIsAutoTimestamp = isAutoTimestamp;
-        item.mDataSpace = dataSpace;
-        item.mHdrMetadata = hdrMetadata;
-        item.mFrameNumber = currentFrameNumber;
-        item.mSlot = slot;
-        item.mFence = acquireFence;
-        item.mFenceTime = acquireFenceTime;
-        item.mIsDroppable = mCore->mAsyncMode ||
-                (mConsumerIsSurfaceFlinger && mCore->mQueueBufferCanDrop) ||
-                (mCore->mLegacyBufferDrop && mCore->mQueueBufferCanDrop) ||
-                (mCore->mSharedBufferMode && mCore->mSharedBufferSlot == slot);
-        item.mSurfaceDamage = surfaceDamage;
-        item.mQueuedBuffer = true;
-        item.mAutoRefresh = mCore->mSharedBufferMode && mCore->mAutoRefresh;
-        item.mApi = mCore->mConnectedApi;
-
-        mStickyTransform = stickyTransform;
-
-        // Cache the shared buffer data so that the BufferItem can be recreated.
-        if (mCore->mSharedBufferMode) {
-            mCore->mSharedBufferCache.crop = crop;
-            mCore->mSharedBufferCache.transform = transform;
-            mCore->mSharedBufferCache.scalingMode = static_cast<uint32_t>(
-                    scalingMode);
-            mCore->mSharedBufferCache.dataspace = dataSpace;
-        }
+    mSlots[slot].mFence = frame->acquireFence;
+    mSlots[slot].mBufferState.queue();
+
+    // Increment the frame counter and store a local version of it
+    // for use outside the lock on mCore->mMutex.
+    ++mCore->mFrameCounter;
+    frame->frameNumber = mCore->mFrameCounter;
+    mSlots[slot].mFrameNumber = frame->frameNumber;
+
+    item.mAcquireCalled = mSlots[slot].mAcquireCalled;
+    item.mGraphicBuffer = mSlots[slot].mGraphicBuffer;
+    item.mDataSpace = frame->dataSpace;
+    item.mFrameNumber = frame->frameNumber;
+    item.mSlot = slot;
+    item.mIsDroppable = mCore->mAsyncMode ||
+            (mConsumerIsSurfaceFlinger && mCore->mQueueBufferCanDrop) ||
+            (mCore->mLegacyBufferDrop && mCore->mQueueBufferCanDrop) ||
+            (mCore->mSharedBufferMode && mCore->mSharedBufferSlot == slot);
+    item.mAutoRefresh = mCore->mSharedBufferMode && mCore->mAutoRefresh;
+    item.mApi = mCore->mConnectedApi;
+
+    mStickyTransform = frame->stickyTransform;
+
+    // Cache the shared buffer data so that the BufferItem can be recreated.
+    if (mCore->mSharedBufferMode) {
+        mCore->mSharedBufferCache.crop = crop;
+        mCore->mSharedBufferCache.transform = frame->transform;
+        mCore->mSharedBufferCache.scalingMode = static_cast<uint32_t>(
+                frame->scalingMode);
+        mCore->mSharedBufferCache.dataspace = frame->dataSpace;
+    }
 
-        output->bufferReplaced = false;
-        if (mCore->mQueue.empty()) {
-            // When the queue is empty, we can ignore mDequeueBufferCannotBlock
-            // and simply queue this buffer
-            mCore->mQueue.push_back(item);
-            frameAvailableListener = mCore->mConsumerListener;
-        } else {
-            // When the queue is not empty, we need to look at the last buffer
-            // in the queue to see if we need to replace it
-            const BufferItem& last = mCore->mQueue.itemAt(
-                    mCore->mQueue.size() - 1);
-            if (last.mIsDroppable) {
-
-                if (!last.mIsStale) {
-                    mSlots[last.mSlot].mBufferState.freeQueued();
-
-                    // After leaving shared buffer mode, the shared buffer will
-                    // still be around. Mark it as no longer shared if this
-                    // operation causes it to be free.
-                    if (!mCore->mSharedBufferMode &&
-                            mSlots[last.mSlot].mBufferState.isFree()) {
-                        mSlots[last.mSlot].mBufferState.mShared = false;
-                    }
-                    // Don't put the shared buffer on the free list.
-                    if (!mSlots[last.mSlot].mBufferState.isShared()) {
-                        mCore->mActiveBuffers.erase(last.mSlot);
-                        mCore->mFreeBuffers.push_back(last.mSlot);
-                        output->bufferReplaced = true;
-                    }
+    output->bufferReplaced = false;
+    if (mCore->mQueue.empty()) {
+        // When the queue is empty, we can ignore mDequeueBufferCannotBlock
+        // and simply queue this buffer
+        mCore->mQueue.push_back(item);
+        frame->frameAvailableListener = mCore->mConsumerListener;
+    } else {
+        // When the queue is not empty, we need to look at the last buffer
+        // in the queue to see if we need to replace it
+        const BufferItem& last = mCore->mQueue.itemAt(
+                mCore->mQueue.size() - 1);
+        if (last.mIsDroppable) {
+
+            if (!last.mIsStale) {
+                mSlots[last.mSlot].mBufferState.freeQueued();
+
+                // After leaving shared buffer mode, the shared buffer will
+                // still be around. Mark it as no longer shared if this
+                // operation causes it to be free.
+                if (!mCore->mSharedBufferMode &&
+                        mSlots[last.mSlot].mBufferState.isFree()) {
+                    mSlots[last.mSlot].mBufferState.mShared = false;
                 }
-
-                // Make sure to merge the damage rect from the frame we're about
-                // to drop into the new frame's damage rect.
-                if (last.mSurfaceDamage.bounds() == Rect::INVALID_RECT ||
-                    item.mSurfaceDamage.bounds() == Rect::INVALID_RECT) {
-                    item.mSurfaceDamage = Region::INVALID_REGION;
-                } else {
-                    item.mSurfaceDamage |= last.mSurfaceDamage;
+                // Don't put the shared buffer on the free list.
+                if (!mSlots[last.mSlot].mBufferState.isShared()) {
+                    mCore->mActiveBuffers.erase(last.mSlot);
+                    mCore->mFreeBuffers.push_back(last.mSlot);
+                    output->bufferReplaced = true;
                 }
+            }
 
-                // Overwrite the droppable buffer with the incoming one
-                mCore->mQueue.editItemAt(mCore->mQueue.size() - 1) = item;
-                frameReplacedListener = mCore->mConsumerListener;
+            // Make sure to merge the damage rect from the frame we're about
+            // to drop into the new frame's damage rect.
+            if (last.mSurfaceDamage.bounds() == Rect::INVALID_RECT ||
+                item.mSurfaceDamage.bounds() == Rect::INVALID_RECT) {
+                item.mSurfaceDamage = Region::INVALID_REGION;
             } else {
-                mCore->mQueue.push_back(item);
-                frameAvailableListener = mCore->mConsumerListener;
+                item.mSurfaceDamage |= last.mSurfaceDamage;
             }
+
+            // Overwrite the droppable buffer with the incoming one
+            mCore->mQueue.editItemAt(mCore->mQueue.size() - 1) = item;
+            frame->frameReplacedListener = mCore->mConsumerListener;
+        } else {
+            mCore->mQueue.push_back(item);
+            frame->frameAvailableListener = mCore->mConsumerListener;
         }
+    }
 
-        mCore->mBufferHasBeenQueued = true;
-        mCore->mDequeueCondition.notify_all();
-        mCore->mLastQueuedSlot = slot;
+    mCore->mBufferHasBeenQueued = true;
+    mCore->mDequeueCondition.notify_all();
+    mCore->mLastQueuedSlot = slot;
 
-        output->width = mCore->mDefaultWidth;
-        output->height = mCore->mDefaultHeight;
-        output->transformHint = mCore->mTransformHintInUse = mCore->mTransformHint;
-        output->numPendingBuffers = static_cast<uint32_t>(mCore->mQueue.size());
-        output->nextFrameNumber = mCore->mFrameCounter + 1;
+    output->width = mCore->mDefaultWidth;
+    output->height = mCore->mDefaultHeight;
+    output->transformHint = mCore->mTransformHintInUse = mCore->mTransformHint;
+    output->numPendingBuffers = static_cast<uint32_t>(mCore->mQueue.size());
+    output->nextFrameNumber = mCore->mFrameCounter + 1;
 
-        ATRACE_INT(mCore->mConsumerName.c_str(), static_cast<int32_t>(mCore->mQueue.size()));
+    ATRACE_INT(mCore->mConsumerName.c_str(), static_cast<int32_t>(mCore->mQueue.size()));
 #ifndef NO_BINDER
-        mCore->mOccupancyTracker.registerOccupancyChange(mCore->mQueue.size());
+    mCore->mOccupancyTracker.registerOccupancyChange(mCore->mQueue.size());
 #endif
-        // Take a ticket for the callback functions
-        callbackTicket = mNextCallbackTicket++;
+    // Take a ticket for the callback functions
+    frame->callbackTicket = mNextCallbackTicket++;
 
-        VALIDATE_CONSISTENCY();
+    VALIDATE_CONSISTENCY();
 
-        connectedApi = mCore->mConnectedApi;
-        if (flags::bq_producer_throttles_only_async_mode()) {
-            enableEglCpuThrottling = mCore->mAsyncMode || mCore->mDequeueBufferCannotBlock;
-        }
-        lastQueuedFence = std::move(mLastQueueBufferFence);
+    frame->connectedApi = mCore->mConnectedApi;
+    if (flags::bq_producer_throttles_only_async_mode()) {
+        frame->enableEglCpuThrottling = mCore->mAsyncMode || mCore->mDequeueBufferCannotBlock;
+    }
+    frame->lastQueuedFence = std::move(mLastQueueBufferFence);
 
-        mLastQueueBufferFence = std::move(acquireFence);
-        mLastQueuedCrop = item.mCrop;
-        mLastQueuedTransform = item.mTransform;
-    } // Autolock scope
+    mLastQueueBufferFence = frame->acquireFence;
+    mLastQueuedCrop = item.mCrop;
+    mLastQueuedTransform = item.mTransform;
+
+    return NO_ERROR;
+}
+
+void BufferQueueProducer::onBufferQueued(QueuedFrame& frame, QueueBufferOutput* output) {
+    BufferItem& item = frame.item;
 
     // It is okay not to clear the GraphicBuffer when the consumer is SurfaceFlinger because
     // it is guaranteed that the BufferQueue is inside SurfaceFlinger's process and
@@ -1122,27 +1231,27 @@ status_t BufferQueueProducer::queueBuffer(int slot,
     // Update and get FrameEventHistory.
     nsecs_t postedTime = systemTime(SYSTEM_TIME_MONOTONIC);
     NewFrameEventsEntry newFrameEventsEntry = {
-        currentFrameNumber,
+        frame.frameNumber,
         postedTime,
-        requestedPresentTimestamp,
-        std::move(acquireFenceTime)
+        frame.requestedPresentTimestamp,
+        std::move(frame.acquireFenceTime)
     };
     addAndGetFrameTimestamps(&newFrameEventsEntry,
-            getFrameTimestamps ? &output->frameTimestamps : nullptr);
+            frame.getFrameTimestamps ? &output->frameTimestamps : nullptr);
 
     // Call back without the main BufferQueue lock held, but with the callback
     // lock held so we can ensure that callbacks occur in order
 
     { // scope for the lock
         std::unique_lock<std::mutex> lock(mCallbackMutex);
-        while (callbackTicket != mCurrentCallbackTicket) {
+        while (frame.callbackTicket != mCurrentCallbackTicket) {
             mCallbackCondition.wait(lock);
         }
 
-        if (frameAvailableListener != nullptr) {
-            frameAvailableListener->onFrameAvailable(item);
-        } else if (frameReplacedListener != nullptr) {
-            frameReplacedListener->onFrameReplaced(item);
+        if (frame.frameAvailableListener != nullptr) {
+            frame.frameAvailableListener->onFrameAvailable(item);
+        } else if (frame.frameReplacedListener != nullptr) {
+            frame.frameReplacedListener->onFrameReplaced(item);
         }
 
         ++mCurrentCallbackTicket;
@@ -1150,14 +1259,12 @@ status_t BufferQueueProducer::queueBuffer(int slot,
     }
 
     // Wait without lock held
-    if (connectedApi == NATIVE_WINDOW_API_EGL && enableEglCpuThrottling) {
+    if (frame.connectedApi == NATIVE_WINDOW_API_EGL && frame.enableEglCpuThrottling) {
         // Waiting here allows for two full buffers to be queued but not a
         // third. In the event that frames take varying time, this makes a
         // small trade-off in favor of latency rather than throughput.
-        lastQueuedFence->waitForever("Throttling EGL Production");
+        frame.lastQueuedFence->waitForever("Throttling EGL Production");
     }
-
-    return NO_ERROR;
 }
 
 status_t BufferQueueProducer::cancelBuffer(int slot, const sp<Fence>& fence) {
@@ -1165,69 +1272,105 @@ status_t BufferQueueProducer::cancelBuffer(int slot, const sp<Fence>& fence) {
     BQ_LOGV("cancelBuffer: slot %d", slot);
 
     sp<IConsumerListener> listener;
-    bool callOnFrameCancelled = false;
-    uint64_t bufferId = 0; // Only used if callOnFrameCancelled == true
+    uint64_t bufferId = 0;
     {
         std::lock_guard<std::mutex> lock(mCore->mMutex);
-
-        if (mCore->mIsAbandoned) {
-            BQ_LOGE("cancelBuffer: BufferQueue has been abandoned");
-            return NO_INIT;
+        status_t result = cancelBufferLocked(slot, fence, &bufferId);
+        if (result != NO_ERROR) {
+            return result;
         }
+        listener = mCore->mConsumerListener;
+    }
 
-        if (mCore->mConnectedApi == BufferQueueCore::NO_CONNECTED_API) {
-            BQ_LOGE("cancelBuffer: BufferQueue has no connected producer");
-            return NO_INIT;
-        }
+    if (listener != nullptr && bufferId != 0) {
+        listener->onFrameCancelled(bufferId);
+    }
 
-        if (mCore->mSharedBufferMode) {
-            BQ_LOGE("cancelBuffer: cannot cancel a buffer in shared buffer mode");
-            return BAD_VALUE;
+    return NO_ERROR;
+}
+
+status_t BufferQueueProducer::cancelBuffers(const std::vector<CancelBufferInput>& inputs,
+                                            std::vector<status_t>* results) {
+    ATRACE_CALL();
+    BQ_LOGV("cancelBuffers: %zu buffers", inputs.size());
+    results->clear();
+    results->reserve(inputs.size());
+
+    sp<IConsumerListener> listener;
+    std::vector<uint64_t> bufferIds(inputs.size(), 0);
+    {
+        std::lock_guard<std::mutex> lock(mCore->mMutex);
+        for (size_t i = 0; i < inputs.size(); i++) {
+            results->push_back(cancelBufferLocked(inputs[i].slot, inputs[i].fence, &bufferIds[i]));
         }
+        listener = mCore->mConsumerListener;
+    }
 
-        if (slot < 0 || slot >= BufferQueueDefs::NUM_BUFFER_SLOTS) {
-            BQ_LOGE("cancelBuffer: slot index %d out of range [0, %d)", slot,
-                    BufferQueueDefs::NUM_BUFFER_SLOTS);
-            return BAD_VALUE;
-        } else if (!mSlots[slot].mBufferState.isDequeued()) {
-            BQ_LOGE("cancelBuffer: slot %d is not owned by the producer "
-                    "(state = %s)",
-                    slot, mSlots[slot].mBufferState.string());
-            return BAD_VALUE;
-        } else if (fence == nullptr) {
-            BQ_LOGE("cancelBuffer: fence is NULL");
-            return BAD_VALUE;
+    if (listener != nullptr) {
+        for (uint64_t bufferId : bufferIds) {
+            if (bufferId != 0) {
+                listener->onFrameCancelled(bufferId);
+            }
         }
+    }
 
-        mSlots[slot].mBufferState.cancel();
+    return NO_ERROR;
+}
 
-        // After leaving shared buffer mode, the shared buffer will still be around.
-        // Mark it as no longer shared if this operation causes it to be free.
-        if (!mCore->mSharedBufferMode && mSlots[slot].mBufferState.isFree()) {
-            mSlots[slot].mBufferState.mShared = false;
-        }
+status_t BufferQueueProducer::cancelBufferLocked(int slot, const sp<Fence>& fence,
+                                                 uint64_t* outBufferId) {
+    *outBufferId = 0;
 
-        // Don't put the shared buffer on the free list.
-        if (!mSlots[slot].mBufferState.isShared()) {
-            mCore->mActiveBuffers.erase(slot);
-            mCore->mFreeBuffers.push_back(slot);
-        }
+    if (mCore->mIsAbandoned) {
+        BQ_LOGE("cancelBuffer: BufferQueue has been abandoned");
+        return NO_INIT;
+    }
 
-        auto gb = mSlots[slot].mGraphicBuffer;
-        if (gb != nullptr) {
-            callOnFrameCancelled = true;
-            bufferId = gb->getId();
-        }
-        mSlots[slot].mFence = fence;
-        mCore->mDequeueCondition.notify_all();
-        listener = mCore->mConsumerListener;
-        VALIDATE_CONSISTENCY();
+    if (mCore->mConnectedApi == BufferQueueCore::NO_CONNECTED_API) {
+        BQ_LOGE("cancelBuffer: BufferQueue has no connected producer");
+        return NO_INIT;
     }
 
-    if (listener != nullptr && callOnFrameCancelled) {
-        listener->onFrameCancelled(bufferId);
+    if (mCore->mSharedBufferMode) {
+        BQ_LOGE("cancelBuffer: cannot cancel a buffer in shared buffer mode");
+        return BAD_VALUE;
     }
 
+    if (slot < 0 || slot >= BufferQueueDefs::NUM_BUFFER_SLOTS) {
+        BQ_LOGE("cancelBuffer: slot index %d out of range [0, %d)", slot,
+                BufferQueueDefs::NUM_BUFFER_SLOTS);
+        return BAD_VALUE;
+    } else if (!mSlots[slot].mBufferState.isDequeued()) {
+        BQ_LOGE("cancelBuffer: slot %d is not owned by the producer "
+                "(state = %s)",
+                slot, mSlots[slot].mBufferState.string());
+        return BAD_VALUE;
+    } else if (fence == nullptr) {
+        BQ_LOGE("cancelBuffer: fence is NULL");
+        return BAD_VALUE;
+    }
+
+    mSlots[slot].mBufferState.cancel();
+
+    // After leaving shared buffer mode, the shared buffer will still be around.
+    // Mark it as no longer shared if this operation causes it to be free.
+    if (!mCore->mSharedBufferMode && mSlots[slot].mBufferState.isFree()) {
+        mSlots[slot].mBufferState.mShared = false;
+    }
+
+    // Don't put the shared buffer on the free list.
+    if (!mSlots[slot].mBufferState.isShared()) {
+        mCore->mActiveBuffers.erase(slot);
+        mCore->mFreeBuffers.push_back(slot);
+    }
+
+    auto gb = mSlots[slot].mGraphicBuffer;
+    if (gb != nullptr) {
+        *outBufferId = gb->getId();
+    }
+    mSlots[slot].mFence = fence;
+    mCore->mDequeueCondition.notify_all();
+    VALIDATE_CONSISTENCY();
     return NO_ERROR;
 }
 
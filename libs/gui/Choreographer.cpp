@@ -153,8 +153,12 @@ void Choreographer::postFrameCallbackDelayed(AChoreographer_frameCallback cb,
     if (callback.dueTime <= now) {
         if (std::this_thread::get_id() != mThreadId) {
             if (mLooper != nullptr) {
-                Message m{MSG_SCHEDULE_VSYNC};
-                mLooper->sendMessage(this, m);
+                // A pending message schedules the vsync for all the callbacks
+                // posted before it is handled.
+                if (!mScheduleVsyncPending.exchange(true)) {
+                    Message m{MSG_SCHEDULE_VSYNC};
+                    mLooper->sendMessage(this, m);
+                }
             } else {
                 scheduleVsync();
             }
@@ -226,6 +230,12 @@ void Choreographer::unregisterRefreshRateCallback(AChoreographer_refreshRateCall
 }
 
 void Choreographer::scheduleLatestConfigRequest() {
+    // handleRefreshRateUpdates() dispatches the latest vsync period to all
+    // callbacks, so there is no need to wake up the looper thread again until
+    // it runs.
+    if (mRefreshRateUpdatePending.exchange(true)) {
+        return;
+    }
     if (mLooper != nullptr) {
         Message m{MSG_HANDLE_REFRESH_RATE_UPDATES};
         mLooper->sendMessage(this, m);
@@ -264,6 +274,9 @@ void Choreographer::scheduleCallbacks() {
 }
 
 void Choreographer::handleRefreshRateUpdates() {
+    // Cleared before loading the vsync period, so that later updates are
+    // scheduled again.
+    mRefreshRateUpdatePending = false;
     std::vector<RefreshRateCallback> callbacks{};
     const nsecs_t pendingPeriod = gChoreographers.mLastKnownVsync.load();
     const nsecs_t lastPeriod = mLatestVsyncPeriod;
@@ -375,6 +388,7 @@ void Choreographer::handleMessage(const Message& message) {
             scheduleCallbacks();
             break;
         case MSG_SCHEDULE_VSYNC:
+            mScheduleVsyncPending = false;
             scheduleVsync();
             break;
         case MSG_HANDLE_REFRESH_RATE_UPDATES:
@@ -444,6 +444,10 @@ status_t ConsumerBase::discardFreeBuffers() {
         CB_LOGE("discardFreeBuffers: ConsumerBase is abandoned!");
         return NO_INIT;
     }
+    return discardFreeBuffersLocked();
+}
+
+status_t ConsumerBase::discardFreeBuffersLocked() {
     status_t err = mConsumer->discardFreeBuffers();
     if (err != OK) {
         return err;
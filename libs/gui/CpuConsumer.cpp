@@ -101,16 +101,18 @@ static bool isPossiblyYUV(PixelFormat format) {
     }
 }
 
-status_t CpuConsumer::lockBufferItem(const BufferItem& item, LockedBuffer* outBuffer) const {
+status_t CpuConsumer::lockBufferItem(const BufferItem& item, LockedBuffer* outBuffer) {
     android_ycbcr ycbcr = android_ycbcr();
 
     PixelFormat format = item.mGraphicBuffer->getPixelFormat();
     PixelFormat flexFormat = format;
-    if (isPossiblyYUV(format)) {
+    LockMode& lockMode = mLockModes[item.mSlot];
+    if (lockMode != LockMode::FLAT && isPossiblyYUV(format)) {
         int fenceFd = item.mFence.get() ? item.mFence->dup() : -1;
         status_t err = item.mGraphicBuffer->lockAsyncYCbCr(GraphicBuffer::USAGE_SW_READ_OFTEN,
                                                            item.mCrop, &ycbcr, fenceFd);
         if (err == OK) {
+            lockMode = LockMode::YCBCR;
             flexFormat = HAL_PIXEL_FORMAT_YCbCr_420_888;
             if (format != HAL_PIXEL_FORMAT_YCbCr_420_888) {
                 CC_LOGV("locking buffer of format %#x as flex YUV", format);
@@ -138,6 +140,7 @@ status_t CpuConsumer::lockBufferItem(const BufferItem& item, LockedBuffer* outBu
             CC_LOGE("Unable to lock buffer for CPU reading: %s (%d)", strerror(-err), err);
             return err;
         }
+        lockMode = LockMode::FLAT;
 
         outBuffer->data = reinterpret_cast<uint8_t*>(bufferPointer);
         outBuffer->stride = item.mGraphicBuffer->getStride();
@@ -162,6 +165,11 @@ status_t CpuConsumer::lockBufferItem(const BufferItem& item, LockedBuffer* outBu
     return OK;
 }
 
+void CpuConsumer::freeBufferLocked(int slotIndex) {
+    mLockModes[slotIndex] = LockMode::UNKNOWN;
+    ConsumerBase::freeBufferLocked(slotIndex);
+}
+
 status_t CpuConsumer::lockNextBuffer(LockedBuffer *nativeBuffer) {
     status_t err;
 
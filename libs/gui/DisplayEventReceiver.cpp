@@ -17,6 +17,7 @@
 #define LOG_TAG "DisplayEventReceiver"
 
 #include <string.h>
+#include <sys/mman.h>
 
 #include <utils/Errors.h>
 
@@ -61,6 +62,10 @@ DisplayEventReceiver::DisplayEventReceiver(gui::ISurfaceComposer::VsyncSource vs
 }
 
 DisplayEventReceiver::~DisplayEventReceiver() {
+    if (mSharedVsyncEventData) {
+        munmap(const_cast<gui::SharedVsyncEventData*>(mSharedVsyncEventData),
+               sizeof(gui::SharedVsyncEventData));
+    }
 }
 
 status_t DisplayEventReceiver::initCheck() const {
@@ -107,6 +112,48 @@ status_t DisplayEventReceiver::getLatestVsyncEventData(
     return NO_INIT;
 }
 
+status_t DisplayEventReceiver::getSharedVsyncEventData(nsecs_t* outTimestamp,
+                                                       VsyncEventData* outVsyncEventData) {
+    if (!mSharedVsyncEventData) {
+        if (const status_t err = mapSharedVsyncEventData(); err != NO_ERROR) {
+            return err;
+        }
+    }
+    return mSharedVsyncEventData->read(outTimestamp, outVsyncEventData) ? NO_ERROR : WOULD_BLOCK;
+}
+
+status_t DisplayEventReceiver::mapSharedVsyncEventData() {
+    if (mSharedVsyncEventDataError) {
+        return *mSharedVsyncEventDataError;
+    }
+    if (mEventConnection == nullptr) {
+        return NO_INIT;
+    }
+
+    std::optional<os::ParcelFileDescriptor> memory;
+    auto status = mEventConnection->getSharedVsyncEventData(&memory);
+    if (!status.isOk()) {
+        ALOGE("Failed to get shared vsync event data: %s", status.toString8().c_str());
+        mSharedVsyncEventDataError = status.transactionError();
+        return *mSharedVsyncEventDataError;
+    }
+    if (!memory) {
+        mSharedVsyncEventDataError = INVALID_OPERATION;
+        return *mSharedVsyncEventDataError;
+    }
+
+    void* address = mmap(nullptr, sizeof(gui::SharedVsyncEventData), PROT_READ, MAP_SHARED,
+                         memory->get(), 0);
+    if (address == MAP_FAILED) {
+        const int error = errno;
+        ALOGE("Failed to map shared vsync event data: %s", strerror(error));
+        mSharedVsyncEventDataError = -error;
+        return *mSharedVsyncEventDataError;
+    }
+    mSharedVsyncEventData = static_cast<const gui::SharedVsyncEventData*>(address);
+    return NO_ERROR;
+}
+
 ssize_t DisplayEventReceiver::getEvents(DisplayEventReceiver::Event* events,
         size_t count) {
     return DisplayEventReceiver::getEvents(mDataChannel.get(), events, count);
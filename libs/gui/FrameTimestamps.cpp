@@ -82,10 +82,8 @@ bool FrameEvents::hasReleaseInfo() const {
 }
 
 void FrameEvents::checkFencesForCompletion() {
-    acquireFence->getSignalTime();
-    gpuCompositionDoneFence->getSignalTime();
-    displayPresentFence->getSignalTime();
-    releaseFence->getSignalTime();
+    FenceTime::updateSignalTimes({acquireFence.get(), gpuCompositionDoneFence.get(),
+                                  displayPresentFence.get(), releaseFence.get()});
 }
 
 static void dumpFenceTime(std::string& outString, const char* name, bool pending,
@@ -385,11 +385,11 @@ status_t GLConsumer::acquireBufferLocked(BufferItem *item,
     }
 
     // If item->mGraphicBuffer is not null, this buffer has not been acquired
-    // before, so any prior EglImage created is using a stale buffer. This
-    // replaces any old EglImage with a new one (using the new buffer).
+    // in this slot before, so any prior EglImage of the slot is using a stale
+    // buffer. This replaces it with the EglImage of the new buffer.
     if (item->mGraphicBuffer != nullptr) {
         int slot = item->mSlot;
-        mEglSlots[slot].mEglImage = new EglImage(item->mGraphicBuffer);
+        mEglSlots[slot].mEglImage = findEglImageLocked(item->mGraphicBuffer);
     }
 
     return NO_ERROR;
@@ -957,21 +957,64 @@ status_t GLConsumer::doGLFenceWaitLocked() const {
     return NO_ERROR;
 }
 
+sp<GLConsumer::EglImage> GLConsumer::findEglImageLocked(
+        const sp<GraphicBuffer>& graphicBuffer) {
+    const uint64_t bufferId = graphicBuffer->getId();
+    sp<EglImage> image;
+    // The current texture may still be showing a buffer whose slot was freed.
+    if (mCurrentTexture == BufferQueue::INVALID_BUFFER_SLOT &&
+            mCurrentTextureImage != nullptr &&
+            mCurrentTextureImage->graphicBuffer() != nullptr &&
+            mCurrentTextureImage->graphicBuffer()->getId() == bufferId) {
+        image = mCurrentTextureImage;
+    }
+    for (size_t i = 0; i < mFreedEglImages.size(); i++) {
+        if (mFreedEglImages[i]->graphicBuffer()->getId() == bufferId) {
+            image = mFreedEglImages[i];
+            mFreedEglImages.removeAt(i);
+            break;
+        }
+    }
+    if (image == nullptr) {
+        return new EglImage(graphicBuffer);
+    }
+
+    GLC_LOGV("findEglImageLocked: reusing image of buffer %#" PRIx64, bufferId);
+    // ConsumerBase tells slot buffers apart by their handles, so the image
+    // must use the GraphicBuffer of the slot from now on.
+    image->setGraphicBuffer(graphicBuffer);
+    return image;
+}
+
 void GLConsumer::freeBufferLocked(int slotIndex) {
     GLC_LOGV("freeBufferLocked: slotIndex=%d", slotIndex);
     if (slotIndex == mCurrentTexture) {
         mCurrentTexture = BufferQueue::INVALID_BUFFER_SLOT;
     }
-    mEglSlots[slotIndex].mEglImage.clear();
+    sp<EglImage>& image = mEglSlots[slotIndex].mEglImage;
+    if (image != nullptr && image->graphicBuffer() != nullptr) {
+        if (mFreedEglImages.size() >= MAX_FREED_EGL_IMAGES) {
+            mFreedEglImages.removeAt(0);
+        }
+        mFreedEglImages.push_back(image);
+    }
+    image.clear();
     ConsumerBase::freeBufferLocked(slotIndex);
 }
 
 void GLConsumer::abandonLocked() {
     GLC_LOGV("abandonLocked");
     mCurrentTextureImage.clear();
+    mFreedEglImages.clear();
     ConsumerBase::abandonLocked();
 }
 
+status_t GLConsumer::discardFreeBuffersLocked() {
+    status_t err = ConsumerBase::discardFreeBuffersLocked();
+    mFreedEglImages.clear();
+    return err;
+}
+
 status_t GLConsumer::setConsumerUsageBits(uint64_t usage) {
     return ConsumerBase::setConsumerUsageBits(usage | DEFAULT_USAGE_FLAGS);
 }
@@ -1017,6 +1060,7 @@ status_t GLConsumer::EglImage::createIfNeeded(EGLDisplay eglDisplay,
         eglTerminate(mEglDisplay);
         mEglImage = EGL_NO_IMAGE_KHR;
         mEglDisplay = EGL_NO_DISPLAY;
+        mImageGraphicBuffer.clear();
     }
 
     // If there's no image, create one.
@@ -1038,6 +1082,17 @@ status_t GLConsumer::EglImage::createIfNeeded(EGLDisplay eglDisplay,
     return OK;
 }
 
+void GLConsumer::EglImage::setGraphicBuffer(
+        const sp<GraphicBuffer>& graphicBuffer) {
+    if (mGraphicBuffer == graphicBuffer) {
+        return;
+    }
+    if (mEglImage != EGL_NO_IMAGE_KHR && mImageGraphicBuffer == nullptr) {
+        mImageGraphicBuffer = mGraphicBuffer;
+    }
+    mGraphicBuffer = graphicBuffer;
+}
+
 void GLConsumer::EglImage::bindToTextureTarget(uint32_t texTarget) {
     glEGLImageTargetTexture2DOES(texTarget,
             static_cast<GLeglImageOES>(mEglImage));
@@ -0,0 +1,214 @@
+/*
+ * Copyright (C) 2024 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#define LOG_TAG "JankDataChannel"
+
+#include <sys/mman.h>
+
+#include <atomic>
+#include <cerrno>
+#include <cinttypes>
+#include <cstring>
+
+#include <cutils/ashmem.h>
+#include <log/log.h>
+
+#include <gui/JankDataChannel.h>
+
+namespace android::gui {
+
+// The layout of the shared memory is a Header followed by the Records of the ring. Every field is
+// atomic, as the producer may overwrite a record while the consumer reads it, and the consumer
+// must be able to detect that.
+struct JankDataChannel::Header {
+    // Number of entries written since the ring was created.
+    std::atomic<uint64_t> writeCount;
+};
+
+struct JankDataChannel::Record {
+    // 2 * index + 1 while the entry with that index is being written, 2 * index + 2 once written.
+    std::atomic<uint64_t> sequence;
+    std::atomic<int64_t> frameVsyncId;
+    std::atomic<int64_t> frameIntervalNs;
+    std::atomic<int64_t> scheduledAppFrameTimeNs;
+    std::atomic<int64_t> actualAppFrameTimeNs;
+    std::atomic<int32_t> layerId;
+    std::atomic<int32_t> jankType;
+};
+
+namespace {
+
+// The producer and the consumer are in different processes, so the atomics must not fall back to
+// locks in either of them.
+static_assert(std::atomic<uint64_t>::is_always_lock_free);
+static_assert(std::atomic<int64_t>::is_always_lock_free);
+static_assert(std::atomic<int32_t>::is_always_lock_free);
+
+constexpr uint64_t writingSequence(uint64_t index) {
+    return 2 * index + 1;
+}
+
+constexpr uint64_t writtenSequence(uint64_t index) {
+    return 2 * index + 2;
+}
+
+} // namespace
+
+size_t JankDataChannel::capacityForSize(size_t size) {
+    return size < sizeof(Header) ? 0 : (size - sizeof(Header)) / sizeof(Record);
+}
+
+size_t JankDataChannel::sizeForCapacity(size_t capacity) {
+    return sizeof(Header) + capacity * sizeof(Record);
+}
+
+JankDataChannel::Producer::Producer(android::base::unique_fd fd, void* memory, size_t size)
+      : mFd(std::move(fd)), mMemory(memory), mSize(size), mCapacity(capacityForSize(size)) {}
+
+JankDataChannel::Producer::~Producer() {
+    munmap(mMemory, mSize);
+}
+
+void JankDataChannel::Producer::write(int32_t layerId, const JankData& data) {
+    const uint64_t index = mWriteCount++;
+    auto* records = reinterpret_cast<Record*>(static_cast<Header*>(mMemory) + 1);
+    Record& record = records[index % mCapacity];
+
+    // Mark the record as being written before any of its fields change.
+    record.sequence.store(writingSequence(index), std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_release);
+
+    record.frameVsyncId.store(data.frameVsyncId, std::memory_order_relaxed);
+    record.frameIntervalNs.store(data.frameIntervalNs, std::memory_order_relaxed);
+    record.scheduledAppFrameTimeNs.store(data.scheduledAppFrameTimeNs, std::memory_order_relaxed);
+    record.actualAppFrameTimeNs.store(data.actualAppFrameTimeNs, std::memory_order_relaxed);
+    record.layerId.store(layerId, std::memory_order_relaxed);
+    record.jankType.store(data.jankType, std::memory_order_relaxed);
+
+    record.sequence.store(writtenSequence(index), std::memory_order_release);
+    static_cast<Header*>(mMemory)->writeCount.store(mWriteCount, std::memory_order_release);
+}
+
+JankDataChannel::Consumer::Consumer(android::base::unique_fd fd, const void* memory, size_t size)
+      : mFd(std::move(fd)), mMemory(memory), mSize(size), mCapacity(capacityForSize(size)) {}
+
+JankDataChannel::Consumer::~Consumer() {
+    munmap(const_cast<void*>(mMemory), mSize);
+}
+
+size_t JankDataChannel::Consumer::read(std::vector<Entry>& outEntries) {
+    const auto* header = static_cast<const Header*>(mMemory);
+    const auto* records = reinterpret_cast<const Record*>(header + 1);
+
+    const uint64_t writeCount = header->writeCount.load(std::memory_order_acquire);
+    if (writeCount < mReadCount) {
+        ALOGE("Write count went back from %" PRIu64 " to %" PRIu64, mReadCount, writeCount);
+        mReadCount = writeCount;
+        return 0;
+    }
+
+    size_t dropped = 0;
+    if (writeCount - mReadCount > mCapacity) {
+        dropped = static_cast<size_t>(writeCount - mCapacity - mReadCount);
+        mReadCount = writeCount - mCapacity;
+    }
+
+    for (; mReadCount < writeCount; mReadCount++) {
+        const Record& record = records[mReadCount % mCapacity];
+        const uint64_t sequence = writtenSequence(mReadCount);
+        if (record.sequence.load(std::memory_order_acquire) != sequence) {
+            // Already overwritten by an entry written after the write count was loaded.
+            dropped++;
+            continue;
+        }
+
+        Entry entry;
+        entry.data.frameVsyncId = record.frameVsyncId.load(std::memory_order_relaxed);
+        entry.data.frameIntervalNs = record.frameIntervalNs.load(std::memory_order_relaxed);
+        entry.data.scheduledAppFrameTimeNs =
+                record.scheduledAppFrameTimeNs.load(std::memory_order_relaxed);
+        entry.data.actualAppFrameTimeNs =
+                record.actualAppFrameTimeNs.load(std::memory_order_relaxed);
+        entry.layerId = record.layerId.load(std::memory_order_relaxed);
+        entry.data.jankType = record.jankType.load(std::memory_order_relaxed);
+
+        // Discard the entry if it was overwritten while its fields were loaded.
+        std::atomic_thread_fence(std::memory_order_acquire);
+        if (record.sequence.load(std::memory_order_relaxed) != sequence) {
+            dropped++;
+            continue;
+        }
+        outEntries.push_back(std::move(entry));
+    }
+    return dropped;
+}
+
+status_t JankDataChannel::createProducer(const std::string& name, size_t capacity,
+                                         std::unique_ptr<Producer>& outProducer) {
+    if (capacity == 0) {
+        return BAD_VALUE;
+    }
+
+    const size_t size = sizeForCapacity(capacity);
+    android::base::unique_fd fd(ashmem_create_region(name.c_str(), size));
+    if (!fd.ok()) {
+        const int error = errno;
+        ALOGE("[%s] Failed to create shared memory. errno=%d message='%s'", name.c_str(), error,
+              strerror(error));
+        return -error;
+    }
+
+    void* memory = mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd.get(), 0);
+    if (memory == MAP_FAILED) {
+        const int error = errno;
+        ALOGE("[%s] Failed to map shared memory. errno=%d message='%s'", name.c_str(), error,
+              strerror(error));
+        return -error;
+    }
+
+    // Only this mapping may write to the ring.
+    if (ashmem_set_prot_region(fd.get(), PROT_READ) != 0) {
+        const int error = errno;
+        ALOGE("[%s] Failed to make shared memory read-only. errno=%d message='%s'", name.c_str(),
+              error, strerror(error));
+        munmap(memory, size);
+        return -error;
+    }
+
+    outProducer = std::make_unique<Producer>(std::move(fd), memory, size);
+    return OK;
+}
+
+status_t JankDataChannel::createConsumer(android::base::unique_fd fd,
+                                         std::unique_ptr<Consumer>& outConsumer) {
+    const int size = ashmem_get_size_region(fd.get());
+    if (size < 0 || capacityForSize(static_cast<size_t>(size)) == 0) {
+        ALOGE("Invalid shared memory size %d", size);
+        return BAD_VALUE;
+    }
+
+    void* memory = mmap(nullptr, static_cast<size_t>(size), PROT_READ, MAP_SHARED, fd.get(), 0);
+    if (memory == MAP_FAILED) {
+        const int error = errno;
+        ALOGE("Failed to map shared memory. errno=%d message='%s'", error, strerror(error));
+        return -error;
+    }
+
+    outConsumer = std::make_unique<Consumer>(std::move(fd), memory, static_cast<size_t>(size));
+    return OK;
+}
+
+} // namespace android::gui
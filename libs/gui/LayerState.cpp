@@ -19,6 +19,7 @@
 #include <cinttypes>
 
 #include <android/gui/ISurfaceComposerClient.h>
+#include <android-base/properties.h>
 #include <android/native_window.h>
 #include <binder/Parcel.h>
 #include <gui/FrameRateUtils.h>
@@ -97,102 +98,201 @@ layer_state_t::layer_state_t()
     hdrMetadata.validTypes = 0;
 }
 
-status_t layer_state_t::write(Parcel& output) const
-{
+status_t layer_state_t::write(Parcel& output) const {
+    // Read once, since transactions are written at animation rates.
+    static const bool sDeltaEncoded =
+            base::GetBoolProperty("debug.sf.layer_state_delta_parcel", true);
+    return write(output, sDeltaEncoded);
+}
+
+status_t layer_state_t::write(Parcel& output, bool deltaEncoded) const {
+    const auto changed = [&](uint64_t changes) { return !deltaEncoded || (what & changes); };
+
     SAFE_PARCEL(output.writeStrongBinder, surface);
     SAFE_PARCEL(output.writeInt32, layerId);
     SAFE_PARCEL(output.writeUint64, what);
-    SAFE_PARCEL(output.writeFloat, x);
-    SAFE_PARCEL(output.writeFloat, y);
-    SAFE_PARCEL(output.writeInt32, z);
-    SAFE_PARCEL(output.writeUint32, layerStack.id);
-    SAFE_PARCEL(output.writeUint32, flags);
-    SAFE_PARCEL(output.writeUint32, mask);
-    SAFE_PARCEL(matrix.write, output);
-    SAFE_PARCEL(output.write, crop);
-    SAFE_PARCEL(SurfaceControl::writeNullableToParcel, output, relativeLayerSurfaceControl);
-    SAFE_PARCEL(SurfaceControl::writeNullableToParcel, output, parentSurfaceControlForChild);
-    SAFE_PARCEL(output.writeFloat, color.r);
-    SAFE_PARCEL(output.writeFloat, color.g);
-    SAFE_PARCEL(output.writeFloat, color.b);
-    SAFE_PARCEL(output.writeFloat, color.a);
-    SAFE_PARCEL(windowInfoHandle->writeToParcel, &output);
-    SAFE_PARCEL(output.write, transparentRegion);
-    SAFE_PARCEL(output.writeUint32, bufferTransform);
-    SAFE_PARCEL(output.writeBool, transformToDisplayInverse);
-    SAFE_PARCEL(output.writeUint32, static_cast<uint32_t>(dataspace));
-    SAFE_PARCEL(output.write, hdrMetadata);
-    SAFE_PARCEL(output.write, surfaceDamageRegion);
-    SAFE_PARCEL(output.writeInt32, api);
-
-    if (sidebandStream) {
-        SAFE_PARCEL(output.writeBool, true);
-        SAFE_PARCEL(output.writeNativeHandle, sidebandStream->handle());
-    } else {
-        SAFE_PARCEL(output.writeBool, false);
-    }
-
-    SAFE_PARCEL(output.write, colorTransform.asArray(), 16 * sizeof(float));
-    SAFE_PARCEL(output.writeFloat, cornerRadius);
-    SAFE_PARCEL(output.writeUint32, backgroundBlurRadius);
-    SAFE_PARCEL(output.writeParcelable, metadata);
-    SAFE_PARCEL(output.writeFloat, bgColor.r);
-    SAFE_PARCEL(output.writeFloat, bgColor.g);
-    SAFE_PARCEL(output.writeFloat, bgColor.b);
-    SAFE_PARCEL(output.writeFloat, bgColor.a);
-    SAFE_PARCEL(output.writeUint32, static_cast<uint32_t>(bgColorDataspace));
-    SAFE_PARCEL(output.writeBool, colorSpaceAgnostic);
-    SAFE_PARCEL(output.writeVectorSize, listeners);
+    SAFE_PARCEL(output.writeBool, deltaEncoded);
+    if (changed(ePositionChanged)) {
+        SAFE_PARCEL(output.writeFloat, x);
+        SAFE_PARCEL(output.writeFloat, y);
+    }
+    if (changed(eLayerChanged | eRelativeLayerChanged)) {
+        SAFE_PARCEL(output.writeInt32, z);
+    }
+    if (changed(eLayerStackChanged)) {
+        SAFE_PARCEL(output.writeUint32, layerStack.id);
+    }
+    if (changed(eFlagsChanged)) {
+        SAFE_PARCEL(output.writeUint32, flags);
+        SAFE_PARCEL(output.writeUint32, mask);
+    }
+    if (changed(eMatrixChanged)) {
+        SAFE_PARCEL(matrix.write, output);
+    }
+    if (changed(eCropChanged)) {
+        SAFE_PARCEL(output.write, crop);
+    }
+    if (changed(eRelativeLayerChanged)) {
+        SAFE_PARCEL(SurfaceControl::writeNullableToParcel, output, relativeLayerSurfaceControl);
+    }
+    if (changed(eReparent)) {
+        SAFE_PARCEL(SurfaceControl::writeNullableToParcel, output, parentSurfaceControlForChild);
+    }
+    if (changed(eColorChanged)) {
+        SAFE_PARCEL(output.writeFloat, color.r);
+        SAFE_PARCEL(output.writeFloat, color.g);
+        SAFE_PARCEL(output.writeFloat, color.b);
+    }
+    if (changed(eAlphaChanged)) {
+        SAFE_PARCEL(output.writeFloat, color.a);
+    }
+    if (changed(eInputInfoChanged)) {
+        SAFE_PARCEL(windowInfoHandle->writeToParcel, &output);
+    }
+    if (changed(eTransparentRegionChanged)) {
+        SAFE_PARCEL(output.write, transparentRegion);
+    }
+    if (changed(eBufferTransformChanged)) {
+        SAFE_PARCEL(output.writeUint32, bufferTransform);
+    }
+    if (changed(eTransformToDisplayInverseChanged)) {
+        SAFE_PARCEL(output.writeBool, transformToDisplayInverse);
+    }
+    if (changed(eDataspaceChanged)) {
+        SAFE_PARCEL(output.writeUint32, static_cast<uint32_t>(dataspace));
+    }
+    if (changed(eHdrMetadataChanged)) {
+        SAFE_PARCEL(output.write, hdrMetadata);
+    }
+    if (changed(eSurfaceDamageRegionChanged)) {
+        SAFE_PARCEL(output.write, surfaceDamageRegion);
+    }
+    if (changed(eApiChanged)) {
+        SAFE_PARCEL(output.writeInt32, api);
+    }
 
+    if (changed(eSidebandStreamChanged)) {
+        if (sidebandStream) {
+            SAFE_PARCEL(output.writeBool, true);
+            SAFE_PARCEL(output.writeNativeHandle, sidebandStream->handle());
+        } else {
+            SAFE_PARCEL(output.writeBool, false);
+        }
+    }
+
+    if (changed(eColorTransformChanged)) {
+        SAFE_PARCEL(output.write, colorTransform.asArray(), 16 * sizeof(float));
+    }
+    if (changed(eCornerRadiusChanged)) {
+        SAFE_PARCEL(output.writeFloat, cornerRadius);
+    }
+    if (changed(eBackgroundBlurRadiusChanged)) {
+        SAFE_PARCEL(output.writeUint32, backgroundBlurRadius);
+    }
+    if (changed(eMetadataChanged)) {
+        SAFE_PARCEL(output.writeParcelable, metadata);
+    }
+    if (changed(eBackgroundColorChanged)) {
+        SAFE_PARCEL(output.writeFloat, bgColor.r);
+        SAFE_PARCEL(output.writeFloat, bgColor.g);
+        SAFE_PARCEL(output.writeFloat, bgColor.b);
+        SAFE_PARCEL(output.writeFloat, bgColor.a);
+        SAFE_PARCEL(output.writeUint32, static_cast<uint32_t>(bgColorDataspace));
+    }
+    if (changed(eColorSpaceAgnosticChanged)) {
+        SAFE_PARCEL(output.writeBool, colorSpaceAgnostic);
+    }
+
+    // Listeners are registered even for layers that are gone, so they are always written.
+    SAFE_PARCEL(output.writeVectorSize, listeners);
     for (auto listener : listeners) {
         SAFE_PARCEL(output.writeStrongBinder, listener.transactionCompletedListener);
         SAFE_PARCEL(output.writeParcelableVector, listener.callbackIds);
     }
-    SAFE_PARCEL(output.writeFloat, shadowRadius);
-    SAFE_PARCEL(output.writeInt32, frameRateSelectionPriority);
-    SAFE_PARCEL(output.writeFloat, frameRate);
-    SAFE_PARCEL(output.writeByte, frameRateCompatibility);
-    SAFE_PARCEL(output.writeByte, changeFrameRateStrategy);
-    SAFE_PARCEL(output.writeByte, defaultFrameRateCompatibility);
-    SAFE_PARCEL(output.writeByte, frameRateCategory);
-    SAFE_PARCEL(output.writeBool, frameRateCategorySmoothSwitchOnly);
-    SAFE_PARCEL(output.writeByte, frameRateSelectionStrategy);
-    SAFE_PARCEL(output.writeUint32, fixedTransformHint);
-    SAFE_PARCEL(output.writeBool, autoRefresh);
-    SAFE_PARCEL(output.writeBool, dimmingEnabled);
-
-    SAFE_PARCEL(output.writeUint32, blurRegions.size());
-    for (auto region : blurRegions) {
-        SAFE_PARCEL(output.writeUint32, region.blurRadius);
-        SAFE_PARCEL(output.writeFloat, region.cornerRadiusTL);
-        SAFE_PARCEL(output.writeFloat, region.cornerRadiusTR);
-        SAFE_PARCEL(output.writeFloat, region.cornerRadiusBL);
-        SAFE_PARCEL(output.writeFloat, region.cornerRadiusBR);
-        SAFE_PARCEL(output.writeFloat, region.alpha);
-        SAFE_PARCEL(output.writeInt32, region.left);
-        SAFE_PARCEL(output.writeInt32, region.top);
-        SAFE_PARCEL(output.writeInt32, region.right);
-        SAFE_PARCEL(output.writeInt32, region.bottom);
-    }
-
-    SAFE_PARCEL(output.write, stretchEffect);
-    SAFE_PARCEL(output.writeParcelable, edgeExtensionParameters);
-    SAFE_PARCEL(output.write, bufferCrop);
-    SAFE_PARCEL(output.write, destinationFrame);
-    SAFE_PARCEL(output.writeInt32, static_cast<uint32_t>(trustedOverlay));
-
-    SAFE_PARCEL(output.writeUint32, static_cast<uint32_t>(dropInputMode));
+    if (changed(eShadowRadiusChanged)) {
+        SAFE_PARCEL(output.writeFloat, shadowRadius);
+    }
+    if (changed(eFrameRateSelectionPriority)) {
+        SAFE_PARCEL(output.writeInt32, frameRateSelectionPriority);
+    }
+    if (changed(eFrameRateChanged)) {
+        SAFE_PARCEL(output.writeFloat, frameRate);
+        SAFE_PARCEL(output.writeByte, frameRateCompatibility);
+        SAFE_PARCEL(output.writeByte, changeFrameRateStrategy);
+    }
+    if (changed(eDefaultFrameRateCompatibilityChanged)) {
+        SAFE_PARCEL(output.writeByte, defaultFrameRateCompatibility);
+    }
+    if (changed(eFrameRateCategoryChanged)) {
+        SAFE_PARCEL(output.writeByte, frameRateCategory);
+        SAFE_PARCEL(output.writeBool, frameRateCategorySmoothSwitchOnly);
+    }
+    if (changed(eFrameRateSelectionStrategyChanged)) {
+        SAFE_PARCEL(output.writeByte, frameRateSelectionStrategy);
+    }
+    if (changed(eFixedTransformHintChanged)) {
+        SAFE_PARCEL(output.writeUint32, fixedTransformHint);
+    }
+    if (changed(eAutoRefreshChanged)) {
+        SAFE_PARCEL(output.writeBool, autoRefresh);
+    }
+    if (changed(eDimmingEnabledChanged)) {
+        SAFE_PARCEL(output.writeBool, dimmingEnabled);
+    }
+
+    if (changed(eBlurRegionsChanged)) {
+        SAFE_PARCEL(output.writeUint32, blurRegions.size());
+        for (auto region : blurRegions) {
+            SAFE_PARCEL(output.writeUint32, region.blurRadius);
+            SAFE_PARCEL(output.writeFloat, region.cornerRadiusTL);
+            SAFE_PARCEL(output.writeFloat, region.cornerRadiusTR);
+            SAFE_PARCEL(output.writeFloat, region.cornerRadiusBL);
+            SAFE_PARCEL(output.writeFloat, region.cornerRadiusBR);
+            SAFE_PARCEL(output.writeFloat, region.alpha);
+            SAFE_PARCEL(output.writeInt32, region.left);
+            SAFE_PARCEL(output.writeInt32, region.top);
+            SAFE_PARCEL(output.writeInt32, region.right);
+            SAFE_PARCEL(output.writeInt32, region.bottom);
+        }
+    }
+
+    if (changed(eStretchChanged)) {
+        SAFE_PARCEL(output.write, stretchEffect);
+    }
+    if (changed(eEdgeExtensionChanged)) {
+        SAFE_PARCEL(output.writeParcelable, edgeExtensionParameters);
+    }
+    if (changed(eBufferCropChanged)) {
+        SAFE_PARCEL(output.write, bufferCrop);
+    }
+    if (changed(eDestinationFrameChanged)) {
+        SAFE_PARCEL(output.write, destinationFrame);
+    }
+    if (changed(eTrustedOverlayChanged)) {
+        SAFE_PARCEL(output.writeInt32, static_cast<uint32_t>(trustedOverlay));
+    }
+    if (changed(eDropInputModeChanged)) {
+        SAFE_PARCEL(output.writeUint32, static_cast<uint32_t>(dropInputMode));
+    }
 
+    // The buffer is checked for barriers and stalls outside of eBufferChanged, so its presence is
+    // always written.
     const bool hasBufferData = (bufferData != nullptr);
     SAFE_PARCEL(output.writeBool, hasBufferData);
     if (hasBufferData) {
         SAFE_PARCEL(output.writeParcelable, *bufferData);
     }
-    SAFE_PARCEL(output.writeParcelable, trustedPresentationThresholds);
-    SAFE_PARCEL(output.writeParcelable, trustedPresentationListener);
-    SAFE_PARCEL(output.writeFloat, currentHdrSdrRatio);
-    SAFE_PARCEL(output.writeFloat, desiredHdrSdrRatio);
-    SAFE_PARCEL(output.writeInt32, static_cast<int32_t>(cachingHint));
+    if (changed(eTrustedPresentationInfoChanged)) {
+        SAFE_PARCEL(output.writeParcelable, trustedPresentationThresholds);
+        SAFE_PARCEL(output.writeParcelable, trustedPresentationListener);
+    }
+    if (changed(eExtendedRangeBrightnessChanged | eDesiredHdrHeadroomChanged)) {
+        SAFE_PARCEL(output.writeFloat, currentHdrSdrRatio);
+        SAFE_PARCEL(output.writeFloat, desiredHdrSdrRatio);
+    }
+    if (changed(eCachingHintChanged)) {
+        SAFE_PARCEL(output.writeInt32, static_cast<int32_t>(cachingHint));
+    }
 
     const bool hasBufferReleaseChannel = (bufferReleaseChannel != nullptr);
     SAFE_PARCEL(output.writeBool, hasBufferReleaseChannel);
@@ -208,67 +308,121 @@ status_t layer_state_t::read(const Parcel& input)
     SAFE_PARCEL(input.readNullableStrongBinder, &surface);
     SAFE_PARCEL(input.readInt32, &layerId);
     SAFE_PARCEL(input.readUint64, &what);
-    SAFE_PARCEL(input.readFloat, &x);
-    SAFE_PARCEL(input.readFloat, &y);
-    SAFE_PARCEL(input.readInt32, &z);
-    SAFE_PARCEL(input.readUint32, &layerStack.id);
+    // Fields that were not written keep their current values.
+    bool deltaEncoded;
+    SAFE_PARCEL(input.readBool, &deltaEncoded);
+    const auto changed = [&](uint64_t changes) { return !deltaEncoded || (what & changes); };
 
-    SAFE_PARCEL(input.readUint32, &flags);
+    if (changed(ePositionChanged)) {
+        SAFE_PARCEL(input.readFloat, &x);
+        SAFE_PARCEL(input.readFloat, &y);
+    }
+    if (changed(eLayerChanged | eRelativeLayerChanged)) {
+        SAFE_PARCEL(input.readInt32, &z);
+    }
+    if (changed(eLayerStackChanged)) {
+        SAFE_PARCEL(input.readUint32, &layerStack.id);
+    }
 
-    SAFE_PARCEL(input.readUint32, &mask);
+    if (changed(eFlagsChanged)) {
+        SAFE_PARCEL(input.readUint32, &flags);
+        SAFE_PARCEL(input.readUint32, &mask);
+    }
 
-    SAFE_PARCEL(matrix.read, input);
-    SAFE_PARCEL(input.read, crop);
+    if (changed(eMatrixChanged)) {
+        SAFE_PARCEL(matrix.read, input);
+    }
+    if (changed(eCropChanged)) {
+        SAFE_PARCEL(input.read, crop);
+    }
 
-    SAFE_PARCEL(SurfaceControl::readNullableFromParcel, input, &relativeLayerSurfaceControl);
-    SAFE_PARCEL(SurfaceControl::readNullableFromParcel, input, &parentSurfaceControlForChild);
+    if (changed(eRelativeLayerChanged)) {
+        SAFE_PARCEL(SurfaceControl::readNullableFromParcel, input, &relativeLayerSurfaceControl);
+    }
+    if (changed(eReparent)) {
+        SAFE_PARCEL(SurfaceControl::readNullableFromParcel, input, &parentSurfaceControlForChild);
+    }
 
     float tmpFloat = 0;
-    SAFE_PARCEL(input.readFloat, &tmpFloat);
-    color.r = tmpFloat;
-    SAFE_PARCEL(input.readFloat, &tmpFloat);
-    color.g = tmpFloat;
-    SAFE_PARCEL(input.readFloat, &tmpFloat);
-    color.b = tmpFloat;
-    SAFE_PARCEL(input.readFloat, &tmpFloat);
-    color.a = tmpFloat;
+    if (changed(eColorChanged)) {
+        SAFE_PARCEL(input.readFloat, &tmpFloat);
+        color.r = tmpFloat;
+        SAFE_PARCEL(input.readFloat, &tmpFloat);
+        color.g = tmpFloat;
+        SAFE_PARCEL(input.readFloat, &tmpFloat);
+        color.b = tmpFloat;
+    }
+    if (changed(eAlphaChanged)) {
+        SAFE_PARCEL(input.readFloat, &tmpFloat);
+        color.a = tmpFloat;
+    }
 
-    SAFE_PARCEL(windowInfoHandle->readFromParcel, &input);
+    if (changed(eInputInfoChanged)) {
+        SAFE_PARCEL(windowInfoHandle->readFromParcel, &input);
+    }
 
-    SAFE_PARCEL(input.read, transparentRegion);
-    SAFE_PARCEL(input.readUint32, &bufferTransform);
-    SAFE_PARCEL(input.readBool, &transformToDisplayInverse);
+    if (changed(eTransparentRegionChanged)) {
+        SAFE_PARCEL(input.read, transparentRegion);
+    }
+    if (changed(eBufferTransformChanged)) {
+        SAFE_PARCEL(input.readUint32, &bufferTransform);
+    }
+    if (changed(eTransformToDisplayInverseChanged)) {
+        SAFE_PARCEL(input.readBool, &transformToDisplayInverse);
+    }
 
     uint32_t tmpUint32 = 0;
-    SAFE_PARCEL(input.readUint32, &tmpUint32);
-    dataspace = static_cast<ui::Dataspace>(tmpUint32);
+    if (changed(eDataspaceChanged)) {
+        SAFE_PARCEL(input.readUint32, &tmpUint32);
+        dataspace = static_cast<ui::Dataspace>(tmpUint32);
+    }
 
-    SAFE_PARCEL(input.read, hdrMetadata);
-    SAFE_PARCEL(input.read, surfaceDamageRegion);
-    SAFE_PARCEL(input.readInt32, &api);
+    if (changed(eHdrMetadataChanged)) {
+        SAFE_PARCEL(input.read, hdrMetadata);
+    }
+    if (changed(eSurfaceDamageRegionChanged)) {
+        SAFE_PARCEL(input.read, surfaceDamageRegion);
+    }
+    if (changed(eApiChanged)) {
+        SAFE_PARCEL(input.readInt32, &api);
+    }
 
     bool tmpBool = false;
-    SAFE_PARCEL(input.readBool, &tmpBool);
-    if (tmpBool) {
-        sidebandStream = NativeHandle::create(input.readNativeHandle(), true);
-    }
-
-    SAFE_PARCEL(input.read, &colorTransform, 16 * sizeof(float));
-    SAFE_PARCEL(input.readFloat, &cornerRadius);
-    SAFE_PARCEL(input.readUint32, &backgroundBlurRadius);
-    SAFE_PARCEL(input.readParcelable, &metadata);
-
-    SAFE_PARCEL(input.readFloat, &tmpFloat);
-    bgColor.r = tmpFloat;
-    SAFE_PARCEL(input.readFloat, &tmpFloat);
-    bgColor.g = tmpFloat;
-    SAFE_PARCEL(input.readFloat, &tmpFloat);
-    bgColor.b = tmpFloat;
-    SAFE_PARCEL(input.readFloat, &tmpFloat);
-    bgColor.a = tmpFloat;
-    SAFE_PARCEL(input.readUint32, &tmpUint32);
-    bgColorDataspace = static_cast<ui::Dataspace>(tmpUint32);
-    SAFE_PARCEL(input.readBool, &colorSpaceAgnostic);
+    if (changed(eSidebandStreamChanged)) {
+        SAFE_PARCEL(input.readBool, &tmpBool);
+        if (tmpBool) {
+            sidebandStream = NativeHandle::create(input.readNativeHandle(), true);
+        }
+    }
+
+    if (changed(eColorTransformChanged)) {
+        SAFE_PARCEL(input.read, &colorTransform, 16 * sizeof(float));
+    }
+    if (changed(eCornerRadiusChanged)) {
+        SAFE_PARCEL(input.readFloat, &cornerRadius);
+    }
+    if (changed(eBackgroundBlurRadiusChanged)) {
+        SAFE_PARCEL(input.readUint32, &backgroundBlurRadius);
+    }
+    if (changed(eMetadataChanged)) {
+        SAFE_PARCEL(input.readParcelable, &metadata);
+    }
+
+    if (changed(eBackgroundColorChanged)) {
+        SAFE_PARCEL(input.readFloat, &tmpFloat);
+        bgColor.r = tmpFloat;
+        SAFE_PARCEL(input.readFloat, &tmpFloat);
+        bgColor.g = tmpFloat;
+        SAFE_PARCEL(input.readFloat, &tmpFloat);
+        bgColor.b = tmpFloat;
+        SAFE_PARCEL(input.readFloat, &tmpFloat);
+        bgColor.a = tmpFloat;
+        SAFE_PARCEL(input.readUint32, &tmpUint32);
+        bgColorDataspace = static_cast<ui::Dataspace>(tmpUint32);
+    }
+    if (changed(eColorSpaceAgnosticChanged)) {
+        SAFE_PARCEL(input.readBool, &colorSpaceAgnostic);
+    }
 
     int32_t numListeners = 0;
     SAFE_PARCEL_READ_SIZE(input.readInt32, &numListeners, input.dataSize());
@@ -280,49 +434,81 @@ status_t layer_state_t::read(const Parcel& input)
         SAFE_PARCEL(input.readParcelableVector, &callbackIds);
         listeners.emplace_back(listener, callbackIds);
     }
-    SAFE_PARCEL(input.readFloat, &shadowRadius);
-    SAFE_PARCEL(input.readInt32, &frameRateSelectionPriority);
-    SAFE_PARCEL(input.readFloat, &frameRate);
-    SAFE_PARCEL(input.readByte, &frameRateCompatibility);
-    SAFE_PARCEL(input.readByte, &changeFrameRateStrategy);
-    SAFE_PARCEL(input.readByte, &defaultFrameRateCompatibility);
-    SAFE_PARCEL(input.readByte, &frameRateCategory);
-    SAFE_PARCEL(input.readBool, &frameRateCategorySmoothSwitchOnly);
-    SAFE_PARCEL(input.readByte, &frameRateSelectionStrategy);
-    SAFE_PARCEL(input.readUint32, &tmpUint32);
-    fixedTransformHint = static_cast<ui::Transform::RotationFlags>(tmpUint32);
-    SAFE_PARCEL(input.readBool, &autoRefresh);
-    SAFE_PARCEL(input.readBool, &dimmingEnabled);
-
-    uint32_t numRegions = 0;
-    SAFE_PARCEL(input.readUint32, &numRegions);
-    blurRegions.clear();
-    for (uint32_t i = 0; i < numRegions; i++) {
-        BlurRegion region;
-        SAFE_PARCEL(input.readUint32, &region.blurRadius);
-        SAFE_PARCEL(input.readFloat, &region.cornerRadiusTL);
-        SAFE_PARCEL(input.readFloat, &region.cornerRadiusTR);
-        SAFE_PARCEL(input.readFloat, &region.cornerRadiusBL);
-        SAFE_PARCEL(input.readFloat, &region.cornerRadiusBR);
-        SAFE_PARCEL(input.readFloat, &region.alpha);
-        SAFE_PARCEL(input.readInt32, &region.left);
-        SAFE_PARCEL(input.readInt32, &region.top);
-        SAFE_PARCEL(input.readInt32, &region.right);
-        SAFE_PARCEL(input.readInt32, &region.bottom);
-        blurRegions.push_back(region);
-    }
-
-    SAFE_PARCEL(input.read, stretchEffect);
-    SAFE_PARCEL(input.readParcelable, &edgeExtensionParameters);
-    SAFE_PARCEL(input.read, bufferCrop);
-    SAFE_PARCEL(input.read, destinationFrame);
-    uint32_t trustedOverlayInt;
-    SAFE_PARCEL(input.readUint32, &trustedOverlayInt);
-    trustedOverlay = static_cast<gui::TrustedOverlay>(trustedOverlayInt);
-
-    uint32_t mode;
-    SAFE_PARCEL(input.readUint32, &mode);
-    dropInputMode = static_cast<gui::DropInputMode>(mode);
+    if (changed(eShadowRadiusChanged)) {
+        SAFE_PARCEL(input.readFloat, &shadowRadius);
+    }
+    if (changed(eFrameRateSelectionPriority)) {
+        SAFE_PARCEL(input.readInt32, &frameRateSelectionPriority);
+    }
+    if (changed(eFrameRateChanged)) {
+        SAFE_PARCEL(input.readFloat, &frameRate);
+        SAFE_PARCEL(input.readByte, &frameRateCompatibility);
+        SAFE_PARCEL(input.readByte, &changeFrameRateStrategy);
+    }
+    if (changed(eDefaultFrameRateCompatibilityChanged)) {
+        SAFE_PARCEL(input.readByte, &defaultFrameRateCompatibility);
+    }
+    if (changed(eFrameRateCategoryChanged)) {
+        SAFE_PARCEL(input.readByte, &frameRateCategory);
+        SAFE_PARCEL(input.readBool, &frameRateCategorySmoothSwitchOnly);
+    }
+    if (changed(eFrameRateSelectionStrategyChanged)) {
+        SAFE_PARCEL(input.readByte, &frameRateSelectionStrategy);
+    }
+    if (changed(eFixedTransformHintChanged)) {
+        SAFE_PARCEL(input.readUint32, &tmpUint32);
+        fixedTransformHint = static_cast<ui::Transform::RotationFlags>(tmpUint32);
+    }
+    if (changed(eAutoRefreshChanged)) {
+        SAFE_PARCEL(input.readBool, &autoRefresh);
+    }
+    if (changed(eDimmingEnabledChanged)) {
+        SAFE_PARCEL(input.readBool, &dimmingEnabled);
+    }
+
+    if (changed(eBlurRegionsChanged)) {
+        uint32_t numRegions = 0;
+        SAFE_PARCEL(input.readUint32, &numRegions);
+        blurRegions.clear();
+        for (uint32_t i = 0; i < numRegions; i++) {
+            BlurRegion region;
+            SAFE_PARCEL(input.readUint32, &region.blurRadius);
+            SAFE_PARCEL(input.readFloat, &region.cornerRadiusTL);
+            SAFE_PARCEL(input.readFloat, &region.cornerRadiusTR);
+            SAFE_PARCEL(input.readFloat, &region.cornerRadiusBL);
+            SAFE_PARCEL(input.readFloat, &region.cornerRadiusBR);
+            SAFE_PARCEL(input.readFloat, &region.alpha);
+            SAFE_PARCEL(input.readInt32, &region.left);
+            SAFE_PARCEL(input.readInt32, &region.top);
+            SAFE_PARCEL(input.readInt32, &region.right);
+            SAFE_PARCEL(input.readInt32, &region.bottom);
+            blurRegions.push_back(region);
+        }
+    }
+
+    if (changed(eStretchChanged)) {
+        SAFE_PARCEL(input.read, stretchEffect);
+    }
+    if (changed(eEdgeExtensionChanged)) {
+        SAFE_PARCEL(input.readParcelable, &edgeExtensionParameters);
+    }
+    if (changed(eBufferCropChanged)) {
+        SAFE_PARCEL(input.read, bufferCrop);
+    }
+    if (changed(eDestinationFrameChanged)) {
+        SAFE_PARCEL(input.read, destinationFrame);
+    }
+    if (changed(eTrustedOverlayChanged)) {
+        uint32_t trustedOverlayInt;
+        SAFE_PARCEL(input.readUint32, &trustedOverlayInt);
+        trustedOverlay = static_cast<gui::TrustedOverlay>(trustedOverlayInt);
+    }
+
+    if (changed(eDropInputModeChanged)) {
+        uint32_t mode;
+        SAFE_PARCEL(input.readUint32, &mode);
+        dropInputMode = static_cast<gui::DropInputMode>(mode);
+    }
 
     bool hasBufferData;
     SAFE_PARCEL(input.readBool, &hasBufferData);
@@ -333,17 +519,23 @@ status_t layer_state_t::read(const Parcel& input)
         bufferData = nullptr;
     }
 
-    SAFE_PARCEL(input.readParcelable, &trustedPresentationThresholds);
-    SAFE_PARCEL(input.readParcelable, &trustedPresentationListener);
+    if (changed(eTrustedPresentationInfoChanged)) {
+        SAFE_PARCEL(input.readParcelable, &trustedPresentationThresholds);
+        SAFE_PARCEL(input.readParcelable, &trustedPresentationListener);
+    }
 
-    SAFE_PARCEL(input.readFloat, &tmpFloat);
-    currentHdrSdrRatio = tmpFloat;
-    SAFE_PARCEL(input.readFloat, &tmpFloat);
-    desiredHdrSdrRatio = tmpFloat;
+    if (changed(eExtendedRangeBrightnessChanged | eDesiredHdrHeadroomChanged)) {
+        SAFE_PARCEL(input.readFloat, &tmpFloat);
+        currentHdrSdrRatio = tmpFloat;
+        SAFE_PARCEL(input.readFloat, &tmpFloat);
+        desiredHdrSdrRatio = tmpFloat;
+    }
 
-    int32_t tmpInt32;
-    SAFE_PARCEL(input.readInt32, &tmpInt32);
-    cachingHint = static_cast<gui::CachingHint>(tmpInt32);
+    if (changed(eCachingHintChanged)) {
+        int32_t tmpInt32;
+        SAFE_PARCEL(input.readInt32, &tmpInt32);
+        cachingHint = static_cast<gui::CachingHint>(tmpInt32);
+    }
 
     bool hasBufferReleaseChannel;
     SAFE_PARCEL(input.readBool, &hasBufferReleaseChannel);
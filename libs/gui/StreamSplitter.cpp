@@ -57,7 +57,7 @@ status_t StreamSplitter::createSplitter(
 }
 
 StreamSplitter::StreamSplitter(const sp<IGraphicBufferConsumer>& inputQueue)
-      : mIsAbandoned(false), mMutex(), mReleaseCondition(),
+      : mIsAbandoned(false), mFrameMutex(), mMutex(), mReleaseCondition(),
         mOutstandingBuffers(0), mInput(inputQueue), mOutputs(), mBuffers() {}
 
 StreamSplitter::~StreamSplitter() {
@@ -103,44 +103,52 @@ void StreamSplitter::setName(const String8 &name) {
 
 void StreamSplitter::onFrameAvailable(const BufferItem& /* item */) {
     ATRACE_CALL();
-    Mutex::Autolock lock(mMutex);
+    Mutex::Autolock frameLock(mFrameMutex);
 
-    // The current policy is that if any one consumer is consuming buffers too
-    // slowly, the splitter will stall the rest of the outputs by not acquiring
-    // any more buffers from the input. This will cause back pressure on the
-    // input queue, slowing down its producer.
-
-    // If there are too many outstanding buffers, we block until a buffer is
-    // released back to the input in onBufferReleased
-    while (mOutstandingBuffers >= MAX_OUTSTANDING_BUFFERS) {
-        mReleaseCondition.wait(mMutex);
-
-        // If the splitter is abandoned while we are waiting, the release
-        // condition variable will be broadcast, and we should just return
-        // without attempting to do anything more (since the input queue will
-        // also be abandoned).
-        if (mIsAbandoned) {
-            return;
+    BufferItem bufferItem;
+    sp<BufferTracker> tracker;
+    Vector<sp<IGraphicBufferProducer> > outputs;
+    {
+        Mutex::Autolock lock(mMutex);
+
+        // The current policy is that if any one consumer is consuming buffers
+        // too slowly, the splitter will stall the rest of the outputs by not
+        // acquiring any more buffers from the input. This will cause back
+        // pressure on the input queue, slowing down its producer.
+
+        // If there are too many outstanding buffers, we block until a buffer
+        // is released back to the input in onBufferReleased
+        while (mOutstandingBuffers >= MAX_OUTSTANDING_BUFFERS) {
+            mReleaseCondition.wait(mMutex);
+
+            // If the splitter is abandoned while we are waiting, the release
+            // condition variable will be broadcast, and we should just return
+            // without attempting to do anything more (since the input queue
+            // will also be abandoned).
+            if (mIsAbandoned) {
+                return;
+            }
         }
-    }
-    ++mOutstandingBuffers;
+        ++mOutstandingBuffers;
 
-    // Acquire and detach the buffer from the input
-    BufferItem bufferItem;
-    status_t status = mInput->acquireBuffer(&bufferItem, /* presentWhen */ 0);
-    LOG_ALWAYS_FATAL_IF(status != NO_ERROR,
-            "acquiring buffer from input failed (%d)", status);
+        // Acquire and detach the buffer from the input
+        status_t status = mInput->acquireBuffer(&bufferItem, /* presentWhen */ 0);
+        LOG_ALWAYS_FATAL_IF(status != NO_ERROR,
+                "acquiring buffer from input failed (%d)", status);
 
-    ALOGV("acquired buffer %#" PRIx64 " from input",
-            bufferItem.mGraphicBuffer->getId());
+        ALOGV("acquired buffer %#" PRIx64 " from input",
+                bufferItem.mGraphicBuffer->getId());
 
-    status = mInput->detachBuffer(bufferItem.mSlot);
-    LOG_ALWAYS_FATAL_IF(status != NO_ERROR,
-            "detaching buffer from input failed (%d)", status);
+        status = mInput->detachBuffer(bufferItem.mSlot);
+        LOG_ALWAYS_FATAL_IF(status != NO_ERROR,
+                "detaching buffer from input failed (%d)", status);
 
-    // Initialize our reference count for this buffer
-    mBuffers.add(bufferItem.mGraphicBuffer->getId(),
-            new BufferTracker(bufferItem.mGraphicBuffer));
+        // Initialize our reference count for this buffer. Outputs may release
+        // it as soon as it is queued to them, so it must be tracked first.
+        outputs = mOutputs;
+        tracker = new BufferTracker(bufferItem.mGraphicBuffer, outputs.size());
+        mBuffers.add(bufferItem.mGraphicBuffer->getId(), tracker);
+    }
 
     IGraphicBufferProducer::QueueBufferInput queueInput(
             bufferItem.mTimestamp, bufferItem.mIsAutoTimestamp,
@@ -149,17 +157,17 @@ void StreamSplitter::onFrameAvailable(const BufferItem& /* item */) {
             bufferItem.mTransform, bufferItem.mFence);
 
     // Attach and queue the buffer to each of the outputs
-    Vector<sp<IGraphicBufferProducer> >::iterator output = mOutputs.begin();
-    for (; output != mOutputs.end(); ++output) {
+    Vector<sp<IGraphicBufferProducer> >::iterator output = outputs.begin();
+    for (; output != outputs.end(); ++output) {
         int slot;
-        status = (*output)->attachBuffer(&slot, bufferItem.mGraphicBuffer);
+        status_t status = (*output)->attachBuffer(&slot, bufferItem.mGraphicBuffer);
         if (status == NO_INIT) {
             // If we just discovered that this output has been abandoned, note
             // that, increment the release count so that we still release this
             // buffer eventually, and move on to the next output
+            Mutex::Autolock lock(mMutex);
             onAbandonedLocked();
-            mBuffers.editValueFor(bufferItem.mGraphicBuffer->getId())->
-                    incrementReleaseCountLocked();
+            tracker->incrementReleaseCountLocked();
             continue;
         } else {
             LOG_ALWAYS_FATAL_IF(status != NO_ERROR,
@@ -172,9 +180,9 @@ void StreamSplitter::onFrameAvailable(const BufferItem& /* item */) {
             // If we just discovered that this output has been abandoned, note
             // that, increment the release count so that we still release this
             // buffer eventually, and move on to the next output
+            Mutex::Autolock lock(mMutex);
             onAbandonedLocked();
-            mBuffers.editValueFor(bufferItem.mGraphicBuffer->getId())->
-                    incrementReleaseCountLocked();
+            tracker->incrementReleaseCountLocked();
             continue;
         } else {
             LOG_ALWAYS_FATAL_IF(status != NO_ERROR,
@@ -189,11 +197,13 @@ void StreamSplitter::onFrameAvailable(const BufferItem& /* item */) {
 void StreamSplitter::onBufferReleasedByOutput(
         const sp<IGraphicBufferProducer>& from) {
     ATRACE_CALL();
-    Mutex::Autolock lock(mMutex);
 
+    // Detaching is a call to the output, which doesn't need our lock.
     sp<GraphicBuffer> buffer;
     sp<Fence> fence;
     status_t status = from->detachNextBuffer(&buffer, &fence);
+
+    Mutex::Autolock lock(mMutex);
     if (status == NO_INIT) {
         // If we just discovered that this output has been abandoned, note that,
         // but we can't do anything else, since buffer is invalid
@@ -216,8 +226,8 @@ void StreamSplitter::onBufferReleasedByOutput(
     // Check to see if this is the last outstanding reference to this buffer
     size_t releaseCount = tracker->incrementReleaseCountLocked();
     ALOGV("buffer %#" PRIx64 " reference count %zu (of %zu)", buffer->getId(),
-            releaseCount, mOutputs.size());
-    if (releaseCount < mOutputs.size()) {
+            releaseCount, tracker->getOutputCount());
+    if (releaseCount < tracker->getOutputCount()) {
         return;
     }
 
@@ -275,12 +285,23 @@ void StreamSplitter::OutputListener::binderDied(const wp<IBinder>& /* who */) {
     mSplitter->onAbandonedLocked();
 }
 
-StreamSplitter::BufferTracker::BufferTracker(const sp<GraphicBuffer>& buffer)
-      : mBuffer(buffer), mMergedFence(Fence::NO_FENCE), mReleaseCount(0) {}
+StreamSplitter::BufferTracker::BufferTracker(const sp<GraphicBuffer>& buffer,
+        size_t outputCount)
+      : mBuffer(buffer), mMergedFence(Fence::NO_FENCE),
+        mOutputCount(outputCount), mReleaseCount(0) {}
 
 StreamSplitter::BufferTracker::~BufferTracker() {}
 
 void StreamSplitter::BufferTracker::mergeFence(const sp<Fence>& with) {
+    // Fences can't be changed once created, so a single valid fence can be
+    // shared as it is rather than merged into a new one with a sync_merge.
+    if (with == nullptr || !with->isValid()) {
+        return;
+    }
+    if (!mMergedFence->isValid()) {
+        mMergedFence = with;
+        return;
+    }
     mMergedFence = Fence::merge(String8("StreamSplitter"), mMergedFence, with);
 }
 
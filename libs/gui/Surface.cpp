@@ -25,9 +25,11 @@
 #include <cstdint>
 #include <deque>
 #include <mutex>
+#include <optional>
 #include <thread>
 
 #include <inttypes.h>
+#include <pthread.h>
 
 #include <android/gui/DisplayStatInfo.h>
 #include <android/native_window.h>
@@ -93,6 +95,163 @@ void Surface::ProducerDeathListenerProxy::binderDied(const wp<IBinder>&) {
 }
 #endif // COM_ANDROID_GRAPHICS_LIBGUI_FLAGS(WB_PLATFORM_API_IMPROVEMENTS)
 
+// Dequeues one buffer at a time on a worker thread on behalf of the Surface. The thread owns a
+// reference to this object, so that it can finish a blocking IGBP::dequeueBuffer after the Surface
+// is gone and give the buffer back.
+class Surface::DequeueAhead {
+public:
+    struct Buffer {
+        IGraphicBufferProducer::DequeueBufferInput input;
+        status_t result = NO_INIT;
+        int slot = -1;
+        sp<Fence> fence;
+        uint64_t bufferAge = 0;
+        FrameEventHistoryDelta frameTimestamps;
+    };
+
+    explicit DequeueAhead(const sp<IGraphicBufferProducer>& producer) : mProducer(producer) {}
+
+    static std::shared_ptr<DequeueAhead> start(const sp<IGraphicBufferProducer>& producer) {
+        auto dequeueAhead = std::make_shared<DequeueAhead>(producer);
+        std::thread([dequeueAhead] {
+            pthread_setname_np(pthread_self(), "SurfaceDqAhead");
+            dequeueAhead->threadMain();
+        }).detach();
+        return dequeueAhead;
+    }
+
+    // Asks for a buffer with the given input, unless one is already dequeued or on its way.
+    void request(const IGraphicBufferProducer::DequeueBufferInput& input) {
+        {
+            std::lock_guard lock(mMutex);
+            if (mStopping || mRequest || mInFlight || mBuffer) {
+                return;
+            }
+            mRequest = input;
+        }
+        mCondition.notify_all();
+    }
+
+    // Waits for a requested buffer and hands it out if it was dequeued with the given input.
+    // Gives it back otherwise, in which case the caller dequeues on its own.
+    bool take(const IGraphicBufferProducer::DequeueBufferInput& input, Buffer* outBuffer) {
+        std::optional<Buffer> buffer;
+        {
+            std::unique_lock lock(mMutex);
+            mCondition.wait(lock, [this] { return mStopping || (!mRequest && !mInFlight); });
+            buffer = std::move(mBuffer);
+            mBuffer.reset();
+        }
+        if (!buffer) {
+            return false;
+        }
+        const auto& dequeued = buffer->input;
+        if (buffer->result >= 0 && dequeued.width == input.width &&
+            dequeued.height == input.height && dequeued.format == input.format &&
+            dequeued.usage == input.usage && dequeued.getTimestamps == input.getTimestamps) {
+            *outBuffer = std::move(*buffer);
+            return true;
+        }
+        cancel(*buffer);
+        return false;
+    }
+
+    // Gives back the dequeued buffer. One still being dequeued is given back once it arrives.
+    void discard() {
+        std::optional<Buffer> buffer;
+        {
+            std::lock_guard lock(mMutex);
+            mRequest.reset();
+            mDiscardInFlight = mInFlight;
+            buffer = std::move(mBuffer);
+            mBuffer.reset();
+        }
+        mCondition.notify_all();
+        if (buffer) {
+            cancel(*buffer);
+        }
+    }
+
+    void stop() {
+        discard();
+        {
+            std::lock_guard lock(mMutex);
+            mStopping = true;
+        }
+        mCondition.notify_all();
+    }
+
+private:
+    void cancel(const Buffer& buffer) {
+        if (buffer.result < 0) {
+            return;
+        }
+        // The Surface never saw this reallocation, so it would keep using the buffer it had cached
+        // for the slot. Empty the slot instead, so that the next dequeue from it reallocates again.
+        if (buffer.result & IGraphicBufferProducer::BUFFER_NEEDS_REALLOCATION) {
+            sp<GraphicBuffer> graphicBuffer;
+            if (mProducer->requestBuffer(buffer.slot, &graphicBuffer) == NO_ERROR &&
+                mProducer->detachBuffer(buffer.slot) == NO_ERROR) {
+                return;
+            }
+        }
+        mProducer->cancelBuffer(buffer.slot, buffer.fence);
+    }
+
+    void threadMain() {
+        std::unique_lock lock(mMutex);
+        while (true) {
+            mCondition.wait(lock, [this] { return mStopping || mRequest; });
+            if (mStopping) {
+                return;
+            }
+            Buffer buffer;
+            buffer.input = *mRequest;
+            mRequest.reset();
+            mInFlight = true;
+            lock.unlock();
+
+            {
+                ATRACE_NAME("dequeueAhead");
+                const auto& input = buffer.input;
+                buffer.result =
+                        mProducer->dequeueBuffer(&buffer.slot, &buffer.fence, input.width,
+                                                 input.height, input.format, input.usage,
+                                                 &buffer.bufferAge,
+                                                 input.getTimestamps ? &buffer.frameTimestamps
+                                                                     : nullptr);
+            }
+            if (buffer.result >= 0 && (buffer.slot < 0 || buffer.slot >= NUM_BUFFER_SLOTS)) {
+                ALOGE("dequeueAhead: IGraphicBufferProducer returned invalid slot number %d",
+                      buffer.slot);
+                buffer.result = FAILED_TRANSACTION;
+            }
+
+            lock.lock();
+            mInFlight = false;
+            if (mDiscardInFlight || mStopping) {
+                mDiscardInFlight = false;
+                lock.unlock();
+                cancel(buffer);
+                lock.lock();
+            } else {
+                mBuffer = std::move(buffer);
+            }
+            mCondition.notify_all();
+        }
+    }
+
+    const sp<IGraphicBufferProducer> mProducer;
+
+    std::mutex mMutex;
+    std::condition_variable mCondition;
+    std::optional<IGraphicBufferProducer::DequeueBufferInput> mRequest;
+    bool mInFlight = false;
+    bool mDiscardInFlight = false;
+    std::optional<Buffer> mBuffer;
+    bool mStopping = false;
+};
+
 Surface::Surface(const sp<IGraphicBufferProducer>& bufferProducer, bool controlledByApp,
                  const sp<IBinder>& surfaceControlHandle)
       : mGraphicBufferProducer(bufferProducer),
@@ -150,6 +309,9 @@ Surface::Surface(const sp<IGraphicBufferProducer>& bufferProducer, bool controll
 }
 
 Surface::~Surface() {
+    if (mDequeueAhead) {
+        mDequeueAhead->stop();
+    }
     if (mConnectedToCpu) {
         Surface::disconnect(NATIVE_WINDOW_API_CPU);
     }
@@ -215,6 +377,23 @@ status_t Surface::setDequeueTimeout(nsecs_t timeout) {
     return mGraphicBufferProducer->setDequeueTimeout(timeout);
 }
 
+status_t Surface::setDequeueAhead(bool enabled) {
+    Mutex::Autolock lock(mMutex);
+    if (enabled && !mDequeueAhead) {
+        mDequeueAhead = DequeueAhead::start(mGraphicBufferProducer);
+    } else if (!enabled && mDequeueAhead) {
+        mDequeueAhead->stop();
+        mDequeueAhead.reset();
+    }
+    return NO_ERROR;
+}
+
+void Surface::discardDequeuedAheadLocked() {
+    if (mDequeueAhead) {
+        mDequeueAhead->discard();
+    }
+}
+
 status_t Surface::getLastQueuedBuffer(sp<GraphicBuffer>* outBuffer,
         sp<Fence>* outFence, float outTransformMatrix[16]) {
     return mGraphicBufferProducer->getLastQueuedBuffer(outBuffer, outFence,
@@ -620,6 +799,7 @@ int Surface::dequeueBuffer(android_native_buffer_t** buffer, int* fenceFd) {
     ALOGV("Surface::dequeueBuffer");
 
     IGraphicBufferProducer::DequeueBufferInput dqInput;
+    std::shared_ptr<DequeueAhead> dequeueAhead;
     {
         Mutex::Autolock lock(mMutex);
         if (mReportRemovedBuffers) {
@@ -637,6 +817,7 @@ int Surface::dequeueBuffer(android_native_buffer_t** buffer, int* fenceFd) {
                 return OK;
             }
         }
+        dequeueAhead = mDequeueAhead;
     } // Drop the lock so that we can still touch the Surface while blocking in IGBP::dequeueBuffer
 
     int buf = -1;
@@ -644,11 +825,22 @@ int Surface::dequeueBuffer(android_native_buffer_t** buffer, int* fenceFd) {
     nsecs_t startTime = systemTime();
 
     FrameEventHistoryDelta frameTimestamps;
-    status_t result = mGraphicBufferProducer->dequeueBuffer(&buf, &fence, dqInput.width,
-                                                            dqInput.height, dqInput.format,
-                                                            dqInput.usage, &mBufferAge,
-                                                            dqInput.getTimestamps ?
-                                                                    &frameTimestamps : nullptr);
+    status_t result;
+    DequeueAhead::Buffer dequeuedAhead;
+    if (dequeueAhead && dequeueAhead->take(dqInput, &dequeuedAhead)) {
+        ATRACE_NAME("dequeued ahead");
+        result = dequeuedAhead.result;
+        buf = dequeuedAhead.slot;
+        fence = std::move(dequeuedAhead.fence);
+        mBufferAge = dequeuedAhead.bufferAge;
+        frameTimestamps = std::move(dequeuedAhead.frameTimestamps);
+    } else {
+        result = mGraphicBufferProducer->dequeueBuffer(&buf, &fence, dqInput.width,
+                                                       dqInput.height, dqInput.format,
+                                                       dqInput.usage, &mBufferAge,
+                                                       dqInput.getTimestamps ? &frameTimestamps
+                                                                             : nullptr);
+    }
     mLastDequeueDuration = systemTime() - startTime;
 
     if (result < 0) {
@@ -801,6 +993,7 @@ int Surface::dequeueBuffers(std::vector<BatchBuffer>* buffers) {
         }
 
         getDequeueBufferInputLocked(&input);
+        discardDequeuedAheadLocked();
     } // Drop the lock so that we can still touch the Surface while blocking in IGBP::dequeueBuffers
 
     std::vector<DequeueBufferInput> dequeueInput(numBufferRequested, input);
@@ -1192,6 +1385,12 @@ void Surface::onBufferQueuedLocked(int slot, sp<Fence> fence,
         static gui::FenceMonitor gpuCompletionThread("GPU completion");
         gpuCompletionThread.queueFence(fence);
     }
+
+    if (mDequeueAhead && !mSharedBufferMode) {
+        IGraphicBufferProducer::DequeueBufferInput dqInput;
+        getDequeueBufferInputLocked(&dqInput);
+        mDequeueAhead->request(dqInput);
+    }
 }
 
 #if COM_ANDROID_GRAPHICS_LIBGUI_FLAGS(WB_PLATFORM_API_IMPROVEMENTS)
@@ -2127,6 +2326,7 @@ int Surface::disconnect(int api, IGraphicBufferProducer::DisconnectMode mode) {
     ATRACE_CALL();
     ALOGV("Surface::disconnect");
     Mutex::Autolock lock(mMutex);
+    discardDequeuedAheadLocked();
     mRemovedBuffers.clear();
     mSharedBufferSlot = BufferItem::INVALID_BUFFER_SLOT;
     mSharedBufferHasBeenQueued = false;
@@ -2171,6 +2371,7 @@ int Surface::detachNextBuffer(sp<GraphicBuffer>* outBuffer,
     }
 
     Mutex::Autolock lock(mMutex);
+    discardDequeuedAheadLocked();
     if (mReportRemovedBuffers) {
         mRemovedBuffers.clear();
     }
@@ -2209,6 +2410,7 @@ int Surface::attachBuffer(ANativeWindowBuffer* buffer)
     ALOGV("Surface::attachBuffer");
 
     Mutex::Autolock lock(mMutex);
+    discardDequeuedAheadLocked();
     if (mReportRemovedBuffers) {
         mRemovedBuffers.clear();
     }
@@ -2267,6 +2469,7 @@ int Surface::setBufferCount(int bufferCount)
     ATRACE_CALL();
     ALOGV("Surface::setBufferCount");
     Mutex::Autolock lock(mMutex);
+    discardDequeuedAheadLocked();
 
     status_t err = NO_ERROR;
     if (bufferCount == 0) {
@@ -2291,6 +2494,7 @@ int Surface::setMaxDequeuedBufferCount(int maxDequeuedBuffers) {
     ATRACE_CALL();
     ALOGV("Surface::setMaxDequeuedBufferCount");
     Mutex::Autolock lock(mMutex);
+    discardDequeuedAheadLocked();
 
     status_t err = mGraphicBufferProducer->setMaxDequeuedBufferCount(
             maxDequeuedBuffers);
@@ -2304,6 +2508,7 @@ int Surface::setAsyncMode(bool async) {
     ATRACE_CALL();
     ALOGV("Surface::setAsyncMode");
     Mutex::Autolock lock(mMutex);
+    discardDequeuedAheadLocked();
 
     status_t err = mGraphicBufferProducer->setAsyncMode(async);
     ALOGE_IF(err, "IGraphicBufferProducer::setAsyncMode(%d) returned %s",
@@ -2316,6 +2521,7 @@ int Surface::setSharedBufferMode(bool sharedBufferMode) {
     ATRACE_CALL();
     ALOGV("Surface::setSharedBufferMode (%d)", sharedBufferMode);
     Mutex::Autolock lock(mMutex);
+    discardDequeuedAheadLocked();
 
     status_t err = mGraphicBufferProducer->setSharedBufferMode(
             sharedBufferMode);
@@ -15,6 +15,7 @@
  */
 
 #define LOG_TAG "SurfaceComposerClient"
+#define ATRACE_TAG ATRACE_TAG_GRAPHICS
 
 #include <semaphore.h>
 #include <stdint.h>
@@ -45,9 +46,11 @@
 
 #include <gui/AidlUtil.h>
 #include <gui/BufferItemConsumer.h>
+#include <gui/Choreographer.h>
 #include <gui/CpuConsumer.h>
 #include <gui/IGraphicBufferProducer.h>
 #include <gui/ISurfaceComposer.h>
+#include <gui/JankDataChannel.h>
 #include <gui/LayerState.h>
 #include <gui/Surface.h>
 #include <gui/SurfaceComposerClient.h>
@@ -225,6 +228,115 @@ status_t JankDataListener::flushJankData() {
     return statusTFromBinderStatus(status);
 }
 
+namespace {
+
+// Reads the jank data channel of this process, which the composer writes the jank data of all the
+// layers with a JankDataListenerFanOut to, and forwards the jank data to the fan-outs.
+class JankDataChannelReader : public gui::BnJankListener {
+public:
+    // Returns the reader of this process, after opening its channel on first use. Returns nullptr
+    // if the channel could not be opened, in which case the fan-outs receive their jank data from
+    // the composer directly.
+    static sp<JankDataChannelReader> getInstance();
+
+    void addFanOut(int32_t layerId, const sp<JankDataListenerFanOut>& fanout);
+
+    binder::Status onJankData(const std::vector<gui::JankData>& /*jankData*/) override {
+        return binder::Status::ok();
+    }
+
+    binder::Status onJankDataPublished() override;
+
+private:
+    std::mutex mMutex;
+    std::unique_ptr<gui::JankDataChannel::Consumer> mConsumer GUARDED_BY(mMutex);
+    // The fan-outs are kept alive by the composer until their removal.
+    std::unordered_multimap<int32_t, wp<JankDataListenerFanOut>> mFanOuts GUARDED_BY(mMutex);
+};
+
+sp<JankDataChannelReader> JankDataChannelReader::getInstance() {
+    static const sp<JankDataChannelReader> sInstance = []() -> sp<JankDataChannelReader> {
+        auto reader = sp<JankDataChannelReader>::make();
+        std::optional<os::ParcelFileDescriptor> channel;
+        binder::Status status =
+                ComposerServiceAIDL::getComposerService()->openJankDataChannel(reader, &channel);
+        if (!status.isOk() || !channel) {
+            ALOGW("Failed to open jank data channel: %s", status.toString8().c_str());
+            return nullptr;
+        }
+
+        std::unique_ptr<gui::JankDataChannel::Consumer> consumer;
+        if (gui::JankDataChannel::createConsumer(channel->release(), consumer) != OK) {
+            ALOGE("Failed to map jank data channel");
+            return nullptr;
+        }
+
+        std::scoped_lock<std::mutex> lock(reader->mMutex);
+        reader->mConsumer = std::move(consumer);
+        return reader;
+    }();
+    return sInstance;
+}
+
+void JankDataChannelReader::addFanOut(int32_t layerId, const sp<JankDataListenerFanOut>& fanout) {
+    std::scoped_lock<std::mutex> lock(mMutex);
+
+    auto range = mFanOuts.equal_range(layerId);
+    for (auto it = range.first; it != range.second;) {
+        if (it->second.promote() == nullptr) {
+            it = mFanOuts.erase(it);
+        } else {
+            it++;
+        }
+    }
+    mFanOuts.emplace(layerId, fanout);
+}
+
+binder::Status JankDataChannelReader::onJankDataPublished() {
+    struct Forward {
+        int32_t layerId;
+        sp<JankDataListenerFanOut> fanout;
+        std::vector<gui::JankData> jankData;
+    };
+    std::vector<Forward> toForward;
+    {
+        std::scoped_lock<std::mutex> lock(mMutex);
+
+        std::vector<gui::JankDataChannel::Entry> entries;
+        if (const size_t dropped = mConsumer->read(entries); dropped > 0) {
+            ALOGW("Jank data of %zu frames was overwritten before it was read", dropped);
+        }
+
+        std::unordered_map<int32_t, std::vector<gui::JankData>> jankDataByLayer;
+        for (auto& entry : entries) {
+            jankDataByLayer[entry.layerId].push_back(std::move(entry.data));
+        }
+
+        for (auto& [layerId, jankData] : jankDataByLayer) {
+            auto range = mFanOuts.equal_range(layerId);
+            for (auto it = range.first; it != range.second;) {
+                if (sp<JankDataListenerFanOut> fanout = it->second.promote()) {
+                    toForward.push_back({layerId, std::move(fanout), jankData});
+                    it++;
+                } else {
+                    it = mFanOuts.erase(it);
+                }
+            }
+        }
+    }
+
+    for (const auto& [layerId, fanout, jankData] : toForward) {
+        if (!fanout->onJankData(jankData).isOk()) {
+            // The last listener of the fan-out is gone, so stop the composer from writing its
+            // jank data, as it would have for a fan-out that receives onJankData directly.
+            ComposerServiceAIDL::getComposerService()->removeJankListener(layerId, fanout, 0);
+        }
+    }
+    return binder::Status::ok();
+}
+
+} // namespace
+
 std::mutex JankDataListenerFanOut::sFanoutInstanceMutex;
 std::unordered_map<int32_t, sp<JankDataListenerFanOut>> JankDataListenerFanOut::sFanoutInstances;
 
@@ -277,6 +389,11 @@ status_t JankDataListenerFanOut::addListener(sp<SurfaceControl> sc, sp<JankDataL
     sFanoutInstanceMutex.unlock();
 
     if (registerNeeded) {
+        // The channel must be open before the fan-out is registered, for the composer to write the
+        // jank data of the fan-out to it.
+        if (sp<JankDataChannelReader> reader = JankDataChannelReader::getInstance()) {
+            reader->addFanOut(layerId, fanout);
+        }
         binder::Status status =
                 ComposerServiceAIDL::getComposerService()->addJankListener(layer, fanout);
         return statusTFromBinderStatus(status);
@@ -1271,11 +1388,132 @@ private:
     timespec mTimeoutTimespec;
 };
 
+class SurfaceComposerClient::Transaction::Coalescer : public RefBase {
+public:
+    Coalescer(sp<IBinder> applyToken, Choreographer* choreographer)
+          : mApplyToken(std::move(applyToken)), mChoreographer(choreographer) {}
+
+    void add(Transaction& transaction) {
+        bool scheduleFlush;
+        {
+            std::scoped_lock lock(mMutex);
+            mPending.mAnimation |= transaction.mAnimation;
+            mPending.mDesiredPresentTime = transaction.mDesiredPresentTime;
+            mPending.merge(std::move(transaction));
+            mPendingCount++;
+            scheduleFlush = !mFlushScheduled;
+            mFlushScheduled = true;
+        }
+        if (scheduleFlush) {
+            // Released by onVsync.
+            incStrong(this);
+            mChoreographer->postFrameCallbackDelayed(nullptr, &Coalescer::onVsync, nullptr, this,
+                                                     0, CALLBACK_ANIMATION);
+        }
+    }
+
+    void flush() {
+        Transaction transaction;
+        size_t count;
+        {
+            std::scoped_lock lock(mMutex);
+            if (mPendingCount == 0) {
+                return;
+            }
+            transaction.mAnimation = mPending.mAnimation;
+            transaction.mDesiredPresentTime = mPending.mDesiredPresentTime;
+            transaction.merge(std::move(mPending));
+            count = std::exchange(mPendingCount, 0);
+        }
+        ATRACE_FORMAT("Apply %zu coalesced transactions", count);
+        transaction.mApplyToken = mApplyToken;
+        transaction.applyNow(/*synchronous=*/false, /*oneWay=*/false);
+    }
+
+private:
+    static void onVsync(int64_t /*frameTimeNanos*/, void* data) {
+        Coalescer* coalescer = static_cast<Coalescer*>(data);
+        {
+            std::scoped_lock lock(coalescer->mMutex);
+            coalescer->mFlushScheduled = false;
+        }
+        coalescer->flush();
+        coalescer->decStrong(coalescer);
+    }
+
+    const sp<IBinder> mApplyToken;
+    Choreographer* const mChoreographer;
+
+    std::mutex mMutex;
+    Transaction mPending GUARDED_BY(mMutex);
+    size_t mPendingCount GUARDED_BY(mMutex) = 0;
+    bool mFlushScheduled GUARDED_BY(mMutex) = false;
+};
+
+std::mutex SurfaceComposerClient::Transaction::sCoalescersMutex;
+std::unordered_map<sp<IBinder>, sp<SurfaceComposerClient::Transaction::Coalescer>, IBinderHash>
+        SurfaceComposerClient::Transaction::sCoalescers;
+std::atomic<size_t> SurfaceComposerClient::Transaction::sCoalescerCount = 0;
+
+sp<SurfaceComposerClient::Transaction::Coalescer>
+SurfaceComposerClient::Transaction::getCoalescer(const sp<IBinder>& applyToken) {
+    std::scoped_lock lock(sCoalescersMutex);
+    const auto it = sCoalescers.find(applyToken);
+    return it == sCoalescers.end() ? nullptr : it->second;
+}
+
+status_t SurfaceComposerClient::Transaction::setCoalescing(const sp<IBinder>& applyToken,
+                                                           bool enabled) {
+    if (applyToken == nullptr) {
+        return BAD_VALUE;
+    }
+    if (enabled) {
+        Choreographer* choreographer = Choreographer::getForThread();
+        if (choreographer == nullptr) {
+            return INVALID_OPERATION;
+        }
+        std::scoped_lock lock(sCoalescersMutex);
+        sCoalescers.try_emplace(applyToken, sp<Coalescer>::make(applyToken, choreographer));
+        sCoalescerCount = sCoalescers.size();
+        return NO_ERROR;
+    }
+
+    sp<Coalescer> coalescer;
+    {
+        std::scoped_lock lock(sCoalescersMutex);
+        const auto it = sCoalescers.find(applyToken);
+        if (it == sCoalescers.end()) {
+            return NO_ERROR;
+        }
+        coalescer = std::move(it->second);
+        sCoalescers.erase(it);
+        sCoalescerCount = sCoalescers.size();
+    }
+    coalescer->flush();
+    return NO_ERROR;
+}
+
 status_t SurfaceComposerClient::Transaction::apply(bool synchronous, bool oneWay) {
     if (mStatus != NO_ERROR) {
         return mStatus;
     }
 
+    if (sCoalescerCount.load(std::memory_order_relaxed) > 0) {
+        if (sp<Coalescer> coalescer =
+                    getCoalescer(mApplyToken ? mApplyToken : getDefaultApplyToken())) {
+            if (!synchronous && !oneWay && mIsAutoTimestamp) {
+                coalescer->add(*this);
+                mId = generateId();
+                return NO_ERROR;
+            }
+            // Keeps the transactions on this token in order.
+            coalescer->flush();
+        }
+    }
+    return applyNow(synchronous, oneWay);
+}
+
+status_t SurfaceComposerClient::Transaction::applyNow(bool synchronous, bool oneWay) {
     std::shared_ptr<SyncCallback> syncCallback = std::make_shared<SyncCallback>();
     if (synchronous) {
         syncCallback->init();
@@ -26,6 +26,41 @@ namespace android::gui {
 static_assert(VsyncEventData::kFrameTimelinesCapacity == 7,
               "Must update value in DisplayEventReceiver.java#FRAME_TIMELINES_CAPACITY (and here)");
 
+void SharedVsyncEventData::write(int64_t newTimestamp, uint32_t newCount,
+                                 const VsyncEventData& newVsyncData) {
+    const uint32_t seq = sequence.load(std::memory_order_relaxed);
+    sequence.store(seq + 1, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_release);
+    timestamp = newTimestamp;
+    count = newCount;
+    vsyncData = newVsyncData;
+    sequence.store(seq + 2, std::memory_order_release);
+}
+
+bool SharedVsyncEventData::read(int64_t* outTimestamp, VsyncEventData* outVsyncData) const {
+    // The writer publishes a few hundred bytes once per vsync, so a handful of retries is enough
+    // unless the writer is preempted mid-update.
+    constexpr int kMaxAttempts = 4;
+    for (int attempt = 0; attempt < kMaxAttempts; attempt++) {
+        const uint32_t seq = sequence.load(std::memory_order_acquire);
+        if (seq == 0) {
+            return false;
+        }
+        if (seq % 2) {
+            continue;
+        }
+        const int64_t readTimestamp = timestamp;
+        const VsyncEventData readVsyncData = vsyncData;
+        std::atomic_thread_fence(std::memory_order_acquire);
+        if (sequence.load(std::memory_order_relaxed) == seq) {
+            *outTimestamp = readTimestamp;
+            *outVsyncData = readVsyncData;
+            return true;
+        }
+    }
+    return false;
+}
+
 int64_t VsyncEventData::preferredVsyncId() const {
     return frameTimelines[preferredFrameTimelineIndex].vsyncId;
 }
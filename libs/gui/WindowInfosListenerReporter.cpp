@@ -45,6 +45,8 @@ status_t WindowInfosListenerReporter::addWindowInfosListener(
             if (status == OK) {
                 mWindowInfosPublisher = std::move(listenerInfo.windowInfosPublisher);
                 mListenerId = listenerInfo.listenerId;
+                mLastUpdate.reset();
+                mWindowInfosPublisher->enableDeltaUpdates(mListenerId);
             }
         }
 
@@ -52,9 +54,9 @@ status_t WindowInfosListenerReporter::addWindowInfosListener(
             mWindowInfosListeners.insert(windowInfosListener);
         }
 
-        if (outInitialInfo != nullptr) {
-            outInitialInfo->first = mLastWindowInfos;
-            outInitialInfo->second = mLastDisplayInfos;
+        if (outInitialInfo != nullptr && mLastUpdate) {
+            outInitialInfo->first = mLastUpdate->windowInfos;
+            outInitialInfo->second = mLastUpdate->displayInfos;
         }
     }
 
@@ -76,8 +78,7 @@ status_t WindowInfosListenerReporter::removeWindowInfosListener(
             status = statusTFromBinderStatus(s);
             // Clear the last stored state since we're disabling updates and don't want to hold
             // stale values
-            mLastWindowInfos.clear();
-            mLastDisplayInfos.clear();
+            mLastUpdate.reset();
         }
 
         if (status == OK) {
@@ -89,25 +90,34 @@ status_t WindowInfosListenerReporter::removeWindowInfosListener(
 }
 
 binder::Status WindowInfosListenerReporter::onWindowInfosChanged(
-        const gui::WindowInfosUpdate& update) {
+        const gui::WindowInfosUpdate& receivedUpdate) {
     std::unordered_set<sp<WindowInfosListener>, gui::SpHash<WindowInfosListener>>
             windowInfosListeners;
+    std::shared_ptr<const gui::WindowInfosUpdate> update;
 
     {
         std::scoped_lock lock(mListenersMutex);
+        auto fullUpdate = std::make_shared<gui::WindowInfosUpdate>(receivedUpdate);
+        if (fullUpdate->applyDelta(mLastUpdate ? *mLastUpdate : gui::WindowInfosUpdate{}) != OK) {
+            // The base of the delta is gone, so drop it and ask for a full update instead.
+            mWindowInfosPublisher->enableDeltaUpdates(mListenerId);
+            mWindowInfosPublisher->ackWindowInfosReceived(receivedUpdate.vsyncId, mListenerId);
+            return binder::Status::ok();
+        }
+
         for (auto listener : mWindowInfosListeners) {
             windowInfosListeners.insert(listener);
         }
 
-        mLastWindowInfos = update.windowInfos;
-        mLastDisplayInfos = update.displayInfos;
+        mLastUpdate = std::move(fullUpdate);
+        update = mLastUpdate;
     }
 
     for (auto listener : windowInfosListeners) {
-        listener->onWindowInfosChanged(update);
+        listener->onWindowInfosChanged(*update);
     }
 
-    mWindowInfosPublisher->ackWindowInfosReceived(update.vsyncId, mListenerId);
+    mWindowInfosPublisher->ackWindowInfosReceived(update->vsyncId, mListenerId);
 
     return binder::Status::ok();
 }
@@ -119,6 +129,10 @@ void WindowInfosListenerReporter::reconnect(const sp<gui::ISurfaceComposer>& com
         composerService->addWindowInfosListener(this, &listenerInfo);
         mWindowInfosPublisher = std::move(listenerInfo.windowInfosPublisher);
         mListenerId = listenerInfo.listenerId;
+        mLastUpdate.reset();
+        if (mWindowInfosPublisher) {
+            mWindowInfosPublisher->enableDeltaUpdates(mListenerId);
+        }
     }
 }
 
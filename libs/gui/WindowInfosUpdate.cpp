@@ -17,8 +17,101 @@
 #include <gui/WindowInfosUpdate.h>
 #include <private/gui/ParcelUtils.h>
 
+#include <cinttypes>
+#include <unordered_map>
+#include <unordered_set>
+
 namespace android::gui {
 
+namespace {
+
+// WindowInfo::operator== leaves out a few fields that listeners still depend on.
+bool isSameWindow(const WindowInfo& a, const WindowInfo& b) {
+    return a == b && a.windowToken == b.windowToken && a.alpha == b.alpha &&
+            a.touchableRegionCropHandle == b.touchableRegionCropHandle &&
+            a.focusTransferTarget == b.focusTransferTarget;
+}
+
+} // namespace
+
+std::optional<WindowInfosUpdate> WindowInfosUpdate::createDelta(
+        const WindowInfosUpdate& base) const {
+    if (base.version == 0 || version == 0) {
+        return std::nullopt;
+    }
+
+    std::unordered_map<int32_t, const WindowInfo*> baseWindows;
+    baseWindows.reserve(base.windowInfos.size());
+    for (const auto& windowInfo : base.windowInfos) {
+        if (!baseWindows.try_emplace(windowInfo.id, &windowInfo).second) {
+            return std::nullopt;
+        }
+    }
+
+    WindowInfosUpdate delta;
+    delta.displayInfos = displayInfos;
+    delta.vsyncId = vsyncId;
+    delta.timestamp = timestamp;
+    delta.version = version;
+    delta.baseVersion = base.version;
+    delta.windowIds.reserve(windowInfos.size());
+    std::unordered_set<int32_t> seenIds;
+    seenIds.reserve(windowInfos.size());
+    for (const auto& windowInfo : windowInfos) {
+        if (!seenIds.insert(windowInfo.id).second) {
+            return std::nullopt;
+        }
+        delta.windowIds.push_back(windowInfo.id);
+        const auto it = baseWindows.find(windowInfo.id);
+        if (it == baseWindows.end() || !isSameWindow(*it->second, windowInfo)) {
+            delta.windowInfos.push_back(windowInfo);
+        }
+    }
+
+    // Every window changed, e.g. the whole screen is animating, so the ids are pure overhead.
+    if (delta.windowInfos.size() == windowInfos.size()) {
+        return std::nullopt;
+    }
+    return delta;
+}
+
+status_t WindowInfosUpdate::applyDelta(const WindowInfosUpdate& base) {
+    if (!isDelta()) {
+        return OK;
+    }
+    if (base.version != baseVersion) {
+        ALOGE("%s: Delta against version %" PRId64 " applied to version %" PRId64, __func__,
+              baseVersion, base.version);
+        return BAD_VALUE;
+    }
+
+    std::unordered_map<int32_t, const WindowInfo*> knownWindows;
+    knownWindows.reserve(base.windowInfos.size() + windowInfos.size());
+    for (const auto& windowInfo : base.windowInfos) {
+        knownWindows.emplace(windowInfo.id, &windowInfo);
+    }
+    // Added and changed windows replace the ones from the base update.
+    for (const auto& windowInfo : windowInfos) {
+        knownWindows.insert_or_assign(windowInfo.id, &windowInfo);
+    }
+
+    std::vector<WindowInfo> fullWindowInfos;
+    fullWindowInfos.reserve(windowIds.size());
+    for (int32_t id : windowIds) {
+        const auto it = knownWindows.find(id);
+        if (it == knownWindows.end()) {
+            ALOGE("%s: Delta references unknown window %" PRId32, __func__, id);
+            return BAD_VALUE;
+        }
+        fullWindowInfos.push_back(*it->second);
+    }
+
+    windowInfos = std::move(fullWindowInfos);
+    windowIds.clear();
+    baseVersion = 0;
+    return OK;
+}
+
 status_t WindowInfosUpdate::readFromParcel(const android::Parcel* parcel) {
     if (parcel == nullptr) {
         ALOGE("%s: Null parcel", __func__);
@@ -43,6 +136,9 @@ status_t WindowInfosUpdate::readFromParcel(const android::Parcel* parcel) {
 
     SAFE_PARCEL(parcel->readInt64, &vsyncId);
     SAFE_PARCEL(parcel->readInt64, &timestamp);
+    SAFE_PARCEL(parcel->readInt64, &version);
+    SAFE_PARCEL(parcel->readInt64, &baseVersion);
+    SAFE_PARCEL(parcel->readInt32Vector, &windowIds);
 
     return OK;
 }
@@ -65,6 +161,9 @@ status_t WindowInfosUpdate::writeToParcel(android::Parcel* parcel) const {
 
     SAFE_PARCEL(parcel->writeInt64, vsyncId);
     SAFE_PARCEL(parcel->writeInt64, timestamp);
+    SAFE_PARCEL(parcel->writeInt64, version);
+    SAFE_PARCEL(parcel->writeInt64, baseVersion);
+    SAFE_PARCEL(parcel->writeInt32Vector, windowIds);
 
     return OK;
 }
@@ -332,6 +332,12 @@ private:
         status_t readBlocking(ReleaseCallbackId& outId, sp<Fence>& outReleaseFence,
                               uint32_t& outMaxAcquiredBufferCount);
 
+        // Reads a buffer release message if one is pending, without blocking.
+        //
+        // Returns OK if a message was read, WOULD_BLOCK if there was none.
+        status_t readNonBlocking(ReleaseCallbackId& outId, sp<Fence>& outReleaseFence,
+                                 uint32_t& outMaxAcquiredBufferCount);
+
         // Signals the reader's eventfd to wake up any threads waiting on readBlocking.
         void interruptBlockingRead();
 
@@ -347,6 +353,16 @@ private:
     std::shared_ptr<BufferReleaseReader> mBufferReleaseReader;
     std::shared_ptr<gui::BufferReleaseChannel::ProducerEndpoint> mBufferReleaseProducer;
 
+    struct BufferRelease {
+        ReleaseCallbackId id;
+        sp<Fence> fence;
+        uint32_t maxAcquiredBufferCount;
+    };
+
+    // Handles the releases read from the BufferReleaseChannel in one go, so
+    // that a burst of releases takes mMutex once.
+    void releaseBuffersFromChannel(const std::vector<BufferRelease>& releases);
+
     class BufferReleaseThread {
     public:
         BufferReleaseThread() = default;
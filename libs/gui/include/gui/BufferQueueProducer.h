@@ -18,9 +18,12 @@
 #define ANDROID_GUI_BUFFERQUEUEPRODUCER_H
 
 #include <gui/AdditionalOptions.h>
+#include <gui/BufferItem.h>
 #include <gui/BufferQueueDefs.h>
 
+#include <gui/IConsumerListener.h>
 #include <gui/IGraphicBufferProducer.h>
+#include <ui/FenceTime.h>
 
 namespace android {
 
@@ -128,6 +131,27 @@ public:
     // will usually be the one obtained from dequeueBuffer.
     virtual status_t cancelBuffer(int slot, const sp<Fence>& fence);
 
+    // The batched operations below take the BufferQueue lock once for the
+    // whole batch rather than once per buffer. Dequeueing and attaching may
+    // wait for a free slot or allocate, so those keep the default
+    // implementations that call into the non-batched versions.
+
+    // See IGraphicBufferProducer::requestBuffers
+    status_t requestBuffers(const std::vector<int32_t>& slots,
+                            std::vector<RequestBufferOutput>* outputs) override;
+
+    // See IGraphicBufferProducer::detachBuffers
+    status_t detachBuffers(const std::vector<int32_t>& slots,
+                           std::vector<status_t>* results) override;
+
+    // See IGraphicBufferProducer::queueBuffers
+    status_t queueBuffers(const std::vector<QueueBufferInput>& inputs,
+                          std::vector<QueueBufferOutput>* outputs) override;
+
+    // See IGraphicBufferProducer::cancelBuffers
+    status_t cancelBuffers(const std::vector<CancelBufferInput>& inputs,
+                           std::vector<status_t>* results) override;
+
     // Query native window attributes.  The "what" values are enumerated in
     // window.h (e.g. NATIVE_WINDOW_FORMAT).
     virtual int query(int what, int* outValue);
@@ -245,6 +269,48 @@ private:
     status_t waitForFreeSlotThenRelock(FreeSlotCaller caller, std::unique_lock<std::mutex>& lock,
             int* found) const;
 
+    // State of a queued frame that is carried from queueBufferLocked to
+    // onBufferQueued, which runs after mCore->mMutex is released.
+    struct QueuedFrame {
+        int64_t requestedPresentTimestamp = 0;
+        bool isAutoTimestamp = false;
+        android_dataspace dataSpace = HAL_DATASPACE_UNKNOWN;
+        Rect crop = Rect::EMPTY_RECT;
+        int scalingMode = 0;
+        uint32_t transform = 0;
+        uint32_t stickyTransform = 0;
+        sp<Fence> acquireFence;
+        std::shared_ptr<FenceTime> acquireFenceTime;
+        bool getFrameTimestamps = false;
+
+        BufferItem item;
+        sp<IConsumerListener> frameAvailableListener;
+        sp<IConsumerListener> frameReplacedListener;
+        int callbackTicket = 0;
+        uint64_t frameNumber = 0;
+        int connectedApi = 0;
+        bool enableEglCpuThrottling = true;
+        sp<Fence> lastQueuedFence;
+    };
+
+    // Validates the input of queueBuffer and fills in the parts of the frame
+    // that don't depend on the BufferQueue state, without the lock held.
+    status_t prepareQueueBuffer(const QueueBufferInput& input, QueuedFrame* outFrame) const;
+
+    // The parts of requestBuffer, detachBuffer, queueBuffer and cancelBuffer
+    // that run with mCore->mMutex held. Listeners of detached and cancelled
+    // buffers must be called after the lock is released, so their buffer ids
+    // are returned through outBufferId, or 0 if the slot had no buffer.
+    status_t requestBufferLocked(int slot, sp<GraphicBuffer>* buf);
+    status_t detachBufferLocked(int slot, uint64_t* outBufferId);
+    status_t queueBufferLocked(int slot, QueuedFrame* frame, QueueBufferOutput* output);
+    status_t cancelBufferLocked(int slot, const sp<Fence>& fence, uint64_t* outBufferId);
+
+    // Updates the frame timestamps, calls the consumer listener in the order
+    // frames were queued, and throttles EGL producers. Must be called without
+    // mCore->mMutex held for every frame that queueBufferLocked succeeded on.
+    void onBufferQueued(QueuedFrame& frame, QueueBufferOutput* output);
+
     sp<BufferQueueCore> mCore;
 
     // This references mCore->mSlots. Lock mCore->mMutex while accessing.
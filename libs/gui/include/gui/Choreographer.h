@@ -21,6 +21,7 @@
 #include <jni.h>
 #include <utils/Looper.h>
 
+#include <atomic>
 #include <mutex>
 #include <queue>
 #include <thread>
@@ -142,6 +143,12 @@ private:
     VsyncEventData mLastVsyncEventData;
     bool mInCallback = false;
 
+    // Whether a MSG_SCHEDULE_VSYNC message or refresh rate update is already
+    // pending, so that requests made before it is handled are coalesced into
+    // one wakeup of the looper thread.
+    std::atomic<bool> mScheduleVsyncPending = false;
+    std::atomic<bool> mRefreshRateUpdatePending = false;
+
     const sp<Looper> mLooper;
     const std::thread::id mThreadId;
 
@@ -213,6 +213,16 @@ protected:
     // This method must be called with mMutex locked.
     virtual void abandonLocked();
 
+    // discardFreeBuffersLocked is the implementation of discardFreeBuffers. It
+    // frees the slots of the buffers discarded by the consumer.
+    //
+    // Derived classes can override this method to also drop buffers they hold
+    // on to outside of the slots.  If it is overridden, the derived class's
+    // implementation must call ConsumerBase::discardFreeBuffersLocked.
+    //
+    // This method must be called with mMutex locked.
+    virtual status_t discardFreeBuffersLocked();
+
     // dumpLocked dumps the current state of the ConsumerBase object to the
     // result string.  Each line is prefixed with the string pointed to by the
     // prefix argument.  The buffer argument points to a buffer that may be
@@ -148,12 +148,29 @@ class CpuConsumer : public ConsumerBase
         }
     };
 
+    // How the buffer in a slot is locked for CPU reading
+    enum class LockMode {
+        // Not locked yet since the buffer was allocated
+        UNKNOWN,
+        // Locked with lockAsyncYCbCr
+        YCBCR,
+        // Locked with lockAsync, as lockAsyncYCbCr is not supported
+        FLAT,
+    };
+
     size_t findAcquiredBufferLocked(uintptr_t id) const;
 
-    status_t lockBufferItem(const BufferItem& item, LockedBuffer* outBuffer) const;
+    status_t lockBufferItem(const BufferItem& item, LockedBuffer* outBuffer);
+
+    // Invalidates the lock mode cached for the slot when its buffer is freed.
+    virtual void freeBufferLocked(int slotIndex) override;
 
     Vector<AcquiredBuffer> mAcquiredBuffers;
 
+    // Lock mode of the buffer in each slot, so that buffers that do not support
+    // lockAsyncYCbCr are not locked twice on every frame.
+    LockMode mLockModes[BufferQueueDefs::NUM_BUFFER_SLOTS] = {};
+
     // Count of currently locked buffers
     size_t mCurrentLockedBuffers;
 };
@@ -188,10 +188,23 @@ public:
      */
     status_t getLatestVsyncEventData(ParcelableVsyncEventData* outVsyncEventData) const;
 
+    /**
+     * getSharedVsyncEventData() reads the latest vsync event that SurfaceFlinger published in
+     * shared memory, without a binder call once the memory is mapped. Returns INVALID_OPERATION
+     * if SurfaceFlinger does not publish vsync events in shared memory, and WOULD_BLOCK if no
+     * event could be read.
+     */
+    status_t getSharedVsyncEventData(nsecs_t* outTimestamp, VsyncEventData* outVsyncEventData);
+
 private:
+    status_t mapSharedVsyncEventData();
+
     sp<IDisplayEventConnection> mEventConnection;
     std::unique_ptr<gui::BitTube> mDataChannel;
     std::optional<status_t> mInitError;
+
+    const gui::SharedVsyncEventData* mSharedVsyncEventData = nullptr;
+    std::optional<status_t> mSharedVsyncEventDataError;
 };
 
 inline bool operator==(DisplayEventReceiver::Event::FrameRateOverride lhs,
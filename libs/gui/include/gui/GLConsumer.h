@@ -254,9 +254,14 @@ public:
 protected:
 
     // abandonLocked overrides the ConsumerBase method to clear
-    // mCurrentTextureImage in addition to the ConsumerBase behavior.
+    // mCurrentTextureImage and mFreedEglImages in addition to the ConsumerBase
+    // behavior.
     virtual void abandonLocked();
 
+    // discardFreeBuffersLocked overrides the ConsumerBase method to clear
+    // mFreedEglImages, so that their buffers are freed too.
+    virtual status_t discardFreeBuffersLocked() override;
+
     // dumpLocked overrides the ConsumerBase method to dump GLConsumer-
     // specific info in addition to the ConsumerBase behavior.
     virtual void dumpLocked(String8& result, const char* prefix) const;
@@ -322,7 +327,8 @@ private:
         explicit EglImage(sp<GraphicBuffer> graphicBuffer);
 
         // createIfNeeded creates an EGLImage if required (we haven't created
-        // one yet, or the EGLDisplay or crop-rect has changed).
+        // one yet, or the EGLDisplay has changed). The crop is applied by the
+        // texture transform matrix, so the image doesn't depend on it.
         status_t createIfNeeded(EGLDisplay display,
                                 bool forceCreate = false);
 
@@ -330,6 +336,12 @@ private:
         // texture in the specified texture target.
         void bindToTextureTarget(uint32_t texTarget);
 
+        // setGraphicBuffer replaces the buffer of this image with another
+        // GraphicBuffer of the same buffer, as when the buffer is attached to
+        // a slot again and so is imported again. The EGLImage is kept, along
+        // with the GraphicBuffer it was created from.
+        void setGraphicBuffer(const sp<GraphicBuffer>& graphicBuffer);
+
         const sp<GraphicBuffer>& graphicBuffer() { return mGraphicBuffer; }
         const native_handle* graphicBufferHandle() {
             return mGraphicBuffer == nullptr ? nullptr : mGraphicBuffer->handle;
@@ -357,14 +369,24 @@ private:
         // mEGLDisplay is the EGLDisplay that was used to create mEglImage.
         EGLDisplay mEglDisplay;
 
-        // mCropRect is the crop rectangle passed to EGL when mEglImage
-        // was created.
-        Rect mCropRect;
+        // mImageGraphicBuffer is the buffer that mEglImage was created from,
+        // once setGraphicBuffer has replaced mGraphicBuffer.
+        sp<GraphicBuffer> mImageGraphicBuffer;
     };
 
+    // findEglImageLocked returns the EglImage to use for a buffer newly
+    // acquired into a slot. It is the EglImage that was last used for the same
+    // buffer, if it is the current texture or if it was freed recently, so that
+    // a buffer that comes back into a slot doesn't need a new EGLImage.
+    // Otherwise it is a new EglImage.
+    //
+    // This method must be called with mMutex locked.
+    sp<EglImage> findEglImageLocked(const sp<GraphicBuffer>& graphicBuffer);
+
     // freeBufferLocked frees up the given buffer slot. If the slot has been
     // initialized this will release the reference to the GraphicBuffer in that
-    // slot and destroy the EGLImage in that slot.  Otherwise it has no effect.
+    // slot and keep the EGLImage of that slot in mFreedEglImages.  Otherwise it
+    // has no effect.
     //
     // This method must be called with mMutex locked.
     virtual void freeBufferLocked(int slotIndex);
@@ -498,6 +520,15 @@ private:
     // of the buffer allocated to a slot.
     EglSlot mEglSlots[BufferQueueDefs::NUM_BUFFER_SLOTS];
 
+    // mFreedEglImages holds the EglImages of the buffers most recently freed
+    // from their slots, oldest first. Producers that detach and attach a fixed
+    // set of buffers, such as a StreamSplitter, free every buffer from its slot
+    // once it has been consumed, and would otherwise need a new EGLImage for
+    // each frame. It holds at most MAX_FREED_EGL_IMAGES images, since each one
+    // keeps its buffer allocated.
+    static constexpr size_t MAX_FREED_EGL_IMAGES = 4;
+    Vector<sp<EglImage>> mFreedEglImages;
+
     // mCurrentTexture is the buffer slot index of the buffer that is currently
     // bound to the OpenGL texture. It is initialized to INVALID_BUFFER_SLOT,
     // indicating that no buffer slot is currently bound to the texture. Note,
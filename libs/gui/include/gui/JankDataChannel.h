@@ -0,0 +1,119 @@
+/*
+ * Copyright (C) 2024 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include <android-base/unique_fd.h>
+
+#include <android/gui/JankData.h>
+#include <utils/Errors.h>
+
+namespace android::gui {
+
+/**
+ * Ring of jank data in shared memory, which SurfaceFlinger appends the jank data of all the layers
+ * with jank listeners in a process to, and which that process reads on its own schedule. This
+ * avoids copying each batch of jank data through binder.
+ *
+ * The ring has a single producer and a single consumer. The producer never waits for the consumer,
+ * and never reads from the shared memory: if the consumer falls behind by more than the capacity of
+ * the ring, the oldest entries are overwritten, and counted as dropped when reading.
+ */
+class JankDataChannel {
+private:
+    struct Header;
+    struct Record;
+
+public:
+    struct Entry {
+        int32_t layerId;
+        JankData data;
+    };
+
+    class Producer {
+    public:
+        Producer(android::base::unique_fd fd, void* memory, size_t size);
+        ~Producer();
+
+        Producer(const Producer&) = delete;
+        void operator=(const Producer&) = delete;
+
+        /**
+         * Read-only file descriptor of the ring, to be passed to the consumer.
+         */
+        const android::base::unique_fd& getFd() const { return mFd; }
+
+        void write(int32_t layerId, const JankData& data);
+
+    private:
+        android::base::unique_fd mFd;
+        void* mMemory;
+        size_t mSize;
+        size_t mCapacity;
+        uint64_t mWriteCount = 0;
+    };
+
+    class Consumer {
+    public:
+        Consumer(android::base::unique_fd fd, const void* memory, size_t size);
+        ~Consumer();
+
+        Consumer(const Consumer&) = delete;
+        void operator=(const Consumer&) = delete;
+
+        /**
+         * Appends the entries written since the last read to outEntries, oldest first.
+         *
+         * Returns the number of entries that were overwritten before they could be read.
+         */
+        size_t read(std::vector<Entry>& outEntries);
+
+    private:
+        android::base::unique_fd mFd;
+        const void* mMemory;
+        size_t mSize;
+        size_t mCapacity;
+        uint64_t mReadCount = 0;
+    };
+
+    /**
+     * Creates the shared memory of a ring that holds the given number of entries, and maps it for
+     * writing.
+     *
+     * Returns OK on success.
+     */
+    static status_t createProducer(const std::string& name, size_t capacity,
+                                   std::unique_ptr<Producer>& outProducer);
+
+    /**
+     * Maps the ring shared by a producer for reading.
+     *
+     * Returns OK on success, or BAD_VALUE if the file descriptor does not hold a ring.
+     */
+    static status_t createConsumer(android::base::unique_fd fd,
+                                   std::unique_ptr<Consumer>& outConsumer);
+
+private:
+    static size_t capacityForSize(size_t size);
+    static size_t sizeForCapacity(size_t capacity);
+};
+
+} // namespace android::gui
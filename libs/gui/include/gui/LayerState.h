@@ -227,7 +227,10 @@ struct layer_state_t {
     layer_state_t();
 
     void merge(const layer_state_t& other);
+    // Writes only the fields covered by what, unless debug.sf.layer_state_delta_parcel is false.
+    // read() accepts either encoding.
     status_t write(Parcel& output) const;
+    status_t write(Parcel& output, bool deltaEncoded) const;
     status_t read(const Parcel& input);
     // Compares two layer_state_t structs and returns a set of change flags describing all the
     // states that are different.
@@ -74,6 +74,10 @@ private:
     // can block if there are too many outstanding buffers. If it blocks, it
     // will resume when onBufferReleasedByOutput releases a buffer back to the
     // input.
+    //
+    // Only the bookkeeping is done with mMutex held. The buffer is attached and
+    // queued to the outputs without it, so that outputs releasing earlier
+    // buffers are not held up by the binder calls to the other outputs.
     virtual void onFrameAvailable(const BufferItem& item);
 
     // From IConsumerListener
@@ -94,7 +98,8 @@ private:
     // generated the callback, update our state tracking to see if this is the
     // last output releasing the buffer, and if so, release it to the input.
     // If we release the buffer to the input, we allow a blocked
-    // onFrameAvailable call to proceed.
+    // onFrameAvailable call to proceed. The buffer is detached from the output
+    // before mMutex is taken.
     void onBufferReleasedByOutput(const sp<IGraphicBufferProducer>& from);
 
     // When this is called, the splitter disconnects from (i.e., abandons) its
@@ -128,9 +133,10 @@ private:
 
     class BufferTracker : public LightRefBase<BufferTracker> {
     public:
-        explicit BufferTracker(const sp<GraphicBuffer>& buffer);
+        BufferTracker(const sp<GraphicBuffer>& buffer, size_t outputCount);
 
         const sp<GraphicBuffer>& getBuffer() const { return mBuffer; }
+        size_t getOutputCount() const { return mOutputCount; }
         const sp<Fence>& getMergedFence() const { return mMergedFence; }
 
         void mergeFence(const sp<Fence>& with);
@@ -150,6 +156,9 @@ private:
 
         sp<GraphicBuffer> mBuffer; // One instance that holds this native handle
         sp<Fence> mMergedFence;
+        // The number of outputs the buffer was sent to, which must all release
+        // it before it goes back to the input. Outputs added later don't count.
+        const size_t mOutputCount;
         size_t mReleaseCount;
     };
 
@@ -167,6 +176,10 @@ private:
     // communicate with it further.
     bool mIsAbandoned;
 
+    // mFrameMutex is held for the whole of onFrameAvailable, so that frames
+    // are queued to the outputs in the order they were acquired even though
+    // mMutex is released while queueing them.
+    Mutex mFrameMutex;
     Mutex mMutex;
     Condition mReleaseCondition;
     int mOutstandingBuffers;
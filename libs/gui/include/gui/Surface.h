@@ -31,6 +31,7 @@
 #include <utils/Mutex.h>
 #include <utils/RefBase.h>
 
+#include <memory>
 #include <shared_mutex>
 #include <unordered_set>
 
@@ -222,6 +223,16 @@ public:
     // See IGraphicBufferProducer::setDequeueTimeout
     status_t setDequeueTimeout(nsecs_t timeout);
 
+    /*
+     * Enables or disables dequeue-ahead. When enabled, every queueBuffer
+     * asks a worker thread to dequeue the next buffer right away, so that a
+     * producer with a steady frame rate finds it ready and dequeueBuffer
+     * doesn't block on the consumer releasing a buffer. The buffer is given
+     * back to the queue if the size, format or usage changes before it is
+     * dequeued. Disabled by default. Not used in shared buffer mode.
+     */
+    status_t setDequeueAhead(bool enabled);
+
     /*
      * Wait for frame number to increase past lastFrame for at most
      * timeoutNs. Useful for one thread to wait for another unknown
@@ -514,6 +525,13 @@ protected:
     friend class ProducerDeathListenerProxy;
 #endif // COM_ANDROID_GRAPHICS_LIBGUI_FLAGS(WB_PLATFORM_API_IMPROVEMENTS)
 
+    // Dequeues buffers ahead of the producer, see setDequeueAhead.
+    class DequeueAhead;
+
+    // Gives back the buffer dequeued ahead, if any, before calls that change
+    // how many buffers the producer may have dequeued.
+    void discardDequeuedAheadLocked();
+
     void querySupportedTimestampsLocked() const;
 
     void freeAllBuffers();
@@ -742,6 +760,10 @@ protected:
 
     // Buffers that are successfully dequeued/attached and handed to clients
     std::unordered_set<int> mDequeuedSlots;
+
+    // Set while dequeue-ahead is enabled. Shared with its worker thread,
+    // which may outlive the Surface while blocked in IGBP::dequeueBuffer.
+    std::shared_ptr<DequeueAhead> mDequeueAhead;
 };
 
 } // namespace android
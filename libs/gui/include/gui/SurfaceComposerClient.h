@@ -19,6 +19,7 @@
 #include <stdint.h>
 #include <sys/types.h>
 
+#include <atomic>
 #include <set>
 #include <thread>
 #include <unordered_map>
@@ -438,6 +439,16 @@ public:
     private:
         static sp<IBinder> sApplyToken;
         static std::mutex sApplyTokenMutex;
+
+        // Merges the transactions applied on one apply token, see setCoalescing.
+        class Coalescer;
+        static std::mutex sCoalescersMutex;
+        static std::unordered_map<sp<IBinder>, sp<Coalescer>, IBinderHash> sCoalescers;
+        // Lets apply() skip the lookup while no token coalesces.
+        static std::atomic<size_t> sCoalescerCount;
+        static sp<Coalescer> getCoalescer(const sp<IBinder>& applyToken);
+        status_t applyNow(bool synchronous, bool oneWay);
+
         void releaseBufferIfOverwriting(const layer_state_t& state);
         static void mergeFrameTimelineInfo(FrameTimelineInfo& t, const FrameTimelineInfo& other);
         // Tracks registered callbacks
@@ -807,6 +818,18 @@ public:
         static sp<IBinder> getDefaultApplyToken();
         static void setDefaultApplyToken(sp<IBinder> applyToken);
 
+        /**
+         * Coalesces the transactions applied on applyToken that are neither synchronous, one way
+         * nor given a desired present time, and applies them as one on the next vsync of the
+         * calling thread's Choreographer. This saves a binder call per apply() for clients that
+         * apply several times a frame. Other transactions on the token flush the pending ones
+         * first, so the order in which they reach SurfaceFlinger is kept.
+         *
+         * The calling thread needs a Looper, and must turn coalescing off before it exits.
+         * Turning it off applies the pending transactions right away.
+         */
+        static status_t setCoalescing(const sp<IBinder>& applyToken, bool enabled);
+
         static status_t sendSurfaceFlushJankDataTransaction(const sp<SurfaceControl>& sc);
     };
 
@@ -899,6 +922,10 @@ public:
 
     binder::Status onJankData(const std::vector<gui::JankData>& jankData) override;
 
+    // The jank data written to the jank data channel of this process is forwarded to onJankData by
+    // the reader of the channel instead.
+    binder::Status onJankDataPublished() override { return binder::Status::ok(); }
+
     static status_t addListener(sp<SurfaceControl> sc, sp<JankDataListener> listener);
     static status_t removeListener(sp<JankDataListener> listener);
 
@@ -19,6 +19,7 @@
 #include <android/gui/FrameTimelineInfo.h>
 
 #include <array>
+#include <atomic>
 
 namespace android::gui {
 // Plain Old Data (POD) vsync data structure. For example, it can be easily used in the
@@ -60,6 +61,27 @@ struct VsyncEventData {
     int64_t preferredExpectedPresentationTime() const;
 };
 
+// Latest vsync event of an EventThread, published by SurfaceFlinger in memory that is mapped
+// read-only into its clients. Clients read the vsync timeline without a binder call, and without
+// requesting an event on their BitTube. The single writer sets the sequence number to an odd
+// value while it updates the event, so that readers retry instead of reading a torn event.
+struct SharedVsyncEventData {
+    std::atomic<uint32_t> sequence;
+    int64_t timestamp;
+    uint32_t count;
+    VsyncEventData vsyncData;
+
+    // Publishes a vsync event. Must only be called by the writer.
+    void write(int64_t timestamp, uint32_t count, const VsyncEventData&);
+
+    // Copies the latest vsync event. Returns false if no event was published yet, or if the
+    // writer kept updating the event while it was read.
+    bool read(int64_t* outTimestamp, VsyncEventData* outVsyncData) const;
+};
+
+static_assert(std::atomic<uint32_t>::is_always_lock_free,
+              "SharedVsyncEventData requires an address-free sequence number");
+
 struct ParcelableVsyncEventData : public Parcelable {
     VsyncEventData vsync;
 
@@ -180,6 +180,8 @@ struct WindowInfo : public Parcelable {
                 static_cast<uint32_t>(os::InputConfig::GLOBAL_STYLUS_BLOCKS_TOUCH),
         SENSITIVE_FOR_PRIVACY =
                 static_cast<uint32_t>(os::InputConfig::SENSITIVE_FOR_PRIVACY),
+        LOW_LATENCY_INPUT =
+                static_cast<uint32_t>(os::InputConfig::LOW_LATENCY_INPUT),
         // clang-format on
     };
 
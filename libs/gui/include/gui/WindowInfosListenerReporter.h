@@ -23,6 +23,7 @@
 #include <gui/SpHash.h>
 #include <gui/WindowInfosListener.h>
 #include <gui/WindowInfosUpdate.h>
+#include <memory>
 #include <unordered_set>
 
 namespace android {
@@ -44,8 +45,8 @@ private:
     std::unordered_set<sp<gui::WindowInfosListener>, gui::SpHash<gui::WindowInfosListener>>
             mWindowInfosListeners GUARDED_BY(mListenersMutex);
 
-    std::vector<gui::WindowInfo> mLastWindowInfos GUARDED_BY(mListenersMutex);
-    std::vector<gui::DisplayInfo> mLastDisplayInfos GUARDED_BY(mListenersMutex);
+    // The last full update, which SurfaceFlinger sends deltas against.
+    std::shared_ptr<const gui::WindowInfosUpdate> mLastUpdate GUARDED_BY(mListenersMutex);
 
     sp<gui::IWindowInfosPublisher> mWindowInfosPublisher;
     int64_t mListenerId;
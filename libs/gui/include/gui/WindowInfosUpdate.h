@@ -20,6 +20,8 @@
 #include <gui/DisplayInfo.h>
 #include <gui/WindowInfo.h>
 
+#include <optional>
+
 namespace android::gui {
 
 struct WindowInfosUpdate : public Parcelable {
@@ -37,6 +39,24 @@ struct WindowInfosUpdate : public Parcelable {
     int64_t vsyncId;
     int64_t timestamp;
 
+    // Assigned by SurfaceFlinger to every update it sends, in increasing order.
+    int64_t version = 0;
+    // If non-zero, this update is a delta against the update with this version. windowInfos then
+    // only holds the windows that were added or changed, and windowIds holds the id of every
+    // window in z-order. Windows missing from windowIds were removed. displayInfos is always
+    // complete.
+    int64_t baseVersion = 0;
+    std::vector<int32_t> windowIds;
+
+    bool isDelta() const { return baseVersion != 0; }
+
+    // Returns a delta that turns base into this update, or nullopt if the windows can't be told
+    // apart by id or the delta would not be smaller than the full update.
+    std::optional<WindowInfosUpdate> createDelta(const WindowInfosUpdate& base) const;
+    // Turns this delta into a full update using the windows of base. Returns BAD_VALUE if base
+    // isn't the update this delta was created against, in which case this update is unchanged.
+    status_t applyDelta(const WindowInfosUpdate& base);
+
     status_t writeToParcel(android::Parcel*) const override;
     status_t readFromParcel(const android::Parcel*) override;
 };
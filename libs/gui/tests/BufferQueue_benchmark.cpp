@@ -0,0 +1,143 @@
+/*
+ * Copyright 2024 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <algorithm>
+#include <atomic>
+#include <thread>
+#include <vector>
+
+#include <benchmark/benchmark.h>
+
+#include <gui/BufferItem.h>
+#include <gui/BufferQueue.h>
+#include <gui/IConsumerListener.h>
+#include <gui/IProducerListener.h>
+#include <system/window.h>
+#include <ui/Fence.h>
+#include <ui/GraphicBuffer.h>
+
+namespace android {
+
+namespace {
+
+constexpr uint64_t kProducerUsage =
+        GraphicBuffer::USAGE_SW_READ_RARELY | GraphicBuffer::USAGE_SW_WRITE_RARELY;
+
+class StubConsumerListener : public BnConsumerListener {
+public:
+    void onFrameAvailable(const BufferItem&) override {}
+    void onBuffersReleased() override {}
+    void onSidebandStreamChanged() override {}
+};
+
+// A BufferQueue whose consumer acquires and releases on another thread as fast
+// as it can, so that the producer contends with it for the BufferQueue lock.
+class ContendedBufferQueue {
+public:
+    ContendedBufferQueue(int bufferCount, bool contended) {
+        BufferQueue::createBufferQueue(&mProducer, &mConsumer);
+        mConsumer->consumerConnect(sp<StubConsumerListener>::make(), false);
+        mConsumer->setMaxAcquiredBufferCount(1);
+        IGraphicBufferProducer::QueueBufferOutput output;
+        mProducer->connect(sp<StubProducerListener>::make(), NATIVE_WINDOW_API_CPU, false,
+                           &output);
+        mProducer->setMaxDequeuedBufferCount(bufferCount);
+        // In async mode queued frames replace the pending one and dequeueing
+        // doesn't block, so the producer measures time spent waiting for the
+        // BufferQueue lock rather than the speed of the consumer.
+        mProducer->setAsyncMode(true);
+
+        if (contended) {
+            mConsumerThread = std::thread([this] { consumeLoop(); });
+        }
+    }
+
+    ~ContendedBufferQueue() {
+        mStop = true;
+        if (mConsumerThread.joinable()) {
+            mConsumerThread.join();
+        }
+        mProducer->disconnect(NATIVE_WINDOW_API_CPU);
+        mConsumer->consumerDisconnect();
+    }
+
+    // Dequeues and queues one buffer, returning false if none was available.
+    bool produceFrame() {
+        int slot;
+        sp<Fence> fence;
+        const status_t result = mProducer->dequeueBuffer(&slot, &fence, 64, 64,
+                                                         HAL_PIXEL_FORMAT_RGBA_8888,
+                                                         kProducerUsage, nullptr, nullptr);
+        if (result < 0) {
+            return false;
+        }
+        if (result & IGraphicBufferProducer::BUFFER_NEEDS_REALLOCATION) {
+            sp<GraphicBuffer> buffer;
+            mProducer->requestBuffer(slot, &buffer);
+        }
+        IGraphicBufferProducer::QueueBufferInput input(0, true, HAL_DATASPACE_UNKNOWN,
+                                                       Rect::INVALID_RECT,
+                                                       NATIVE_WINDOW_SCALING_MODE_FREEZE, 0,
+                                                       Fence::NO_FENCE);
+        IGraphicBufferProducer::QueueBufferOutput output;
+        return mProducer->queueBuffer(slot, input, &output) == NO_ERROR;
+    }
+
+private:
+    void consumeLoop() {
+        while (!mStop) {
+            BufferItem item;
+            if (mConsumer->acquireBuffer(&item, 0) != NO_ERROR) {
+                continue;
+            }
+            mConsumer->releaseBuffer(item.mSlot, item.mFrameNumber, Fence::NO_FENCE);
+        }
+    }
+
+    sp<IGraphicBufferProducer> mProducer;
+    sp<IGraphicBufferConsumer> mConsumer;
+    std::atomic_bool mStop = false;
+    std::thread mConsumerThread;
+};
+
+// Measures how long a dequeue and queue take on the producer thread, with and
+// without a consumer thread acquiring and releasing buffers at the same time,
+// and reports the tail latency.
+static void produceFrameLatency(benchmark::State& state) {
+    ContendedBufferQueue queue(3, state.range(0) != 0);
+
+    std::vector<nsecs_t> latencies;
+    latencies.reserve(state.max_iterations);
+    for (auto _ : state) {
+        const nsecs_t start = systemTime();
+        const bool produced = queue.produceFrame();
+        latencies.push_back(systemTime() - start);
+        benchmark::DoNotOptimize(produced);
+    }
+
+    if (latencies.empty()) return;
+    std::sort(latencies.begin(), latencies.end());
+    const auto percentile = [&](double p) {
+        return static_cast<double>(latencies[static_cast<size_t>(p * (latencies.size() - 1))]);
+    };
+    state.counters["p50_ns"] = percentile(0.5);
+    state.counters["p99_ns"] = percentile(0.99);
+    state.counters["max_ns"] = static_cast<double>(latencies.back());
+}
+BENCHMARK(produceFrameLatency)->Arg(0)->Arg(1)->UseRealTime();
+
+} // namespace
+} // namespace android
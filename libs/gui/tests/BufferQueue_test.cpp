@@ -1192,6 +1192,73 @@ TEST_F(BufferQueueTest, TestBufferReplacedInQueueBuffer) {
     ASSERT_EQ(true, output.bufferReplaced);
 }
 
+TEST_F(BufferQueueTest, TestBatchedBufferOperations) {
+    createBufferQueue();
+    sp<MockConsumer> mc(new MockConsumer);
+    ASSERT_EQ(OK, mConsumer->consumerConnect(mc, true));
+    IGraphicBufferProducer::QueueBufferOutput output;
+    ASSERT_EQ(OK,
+              mProducer->connect(new StubProducerListener, NATIVE_WINDOW_API_CPU, false, &output));
+    ASSERT_EQ(OK, mProducer->setMaxDequeuedBufferCount(4));
+    ASSERT_EQ(OK, mConsumer->setMaxAcquiredBufferCount(2));
+
+    std::vector<int32_t> slots;
+    for (size_t i = 0; i < 4; ++i) {
+        int slot = BufferQueue::INVALID_BUFFER_SLOT;
+        sp<Fence> fence;
+        ASSERT_EQ(IGraphicBufferProducer::BUFFER_NEEDS_REALLOCATION,
+                  mProducer->dequeueBuffer(&slot, &fence, 0, 0, 0, TEST_PRODUCER_USAGE_BITS,
+                                           nullptr, nullptr));
+        slots.push_back(slot);
+    }
+
+    std::vector<IGraphicBufferProducer::RequestBufferOutput> requestOutputs;
+    ASSERT_EQ(OK, mProducer->requestBuffers(slots, &requestOutputs));
+    ASSERT_EQ(slots.size(), requestOutputs.size());
+    for (const auto& requestOutput : requestOutputs) {
+        ASSERT_EQ(OK, requestOutput.result);
+        ASSERT_NE(nullptr, requestOutput.buffer);
+    }
+
+    // Queue the first two buffers, along with one that was never dequeued.
+    std::vector<IGraphicBufferProducer::QueueBufferInput> queueInputs;
+    for (int32_t slot : {slots[0], slots[1], -1}) {
+        queueInputs.emplace_back(0ull, true, HAL_DATASPACE_UNKNOWN, Rect::INVALID_RECT,
+                                 NATIVE_WINDOW_SCALING_MODE_FREEZE, 0, Fence::NO_FENCE, 0, false,
+                                 slot);
+    }
+    std::vector<IGraphicBufferProducer::QueueBufferOutput> queueOutputs;
+    ASSERT_EQ(OK, mProducer->queueBuffers(queueInputs, &queueOutputs));
+    ASSERT_EQ(queueInputs.size(), queueOutputs.size());
+    ASSERT_EQ(OK, queueOutputs[0].result);
+    ASSERT_EQ(1u, queueOutputs[0].numPendingBuffers);
+    ASSERT_EQ(OK, queueOutputs[1].result);
+    ASSERT_EQ(2u, queueOutputs[1].numPendingBuffers);
+    ASSERT_EQ(BAD_VALUE, queueOutputs[2].result);
+
+    // The frames reach the consumer in the order of the batch.
+    BufferItem item;
+    ASSERT_EQ(OK, mConsumer->acquireBuffer(&item, 0));
+    ASSERT_EQ(slots[0], item.mSlot);
+    ASSERT_EQ(1u, item.mFrameNumber);
+    ASSERT_EQ(OK, mConsumer->acquireBuffer(&item, 0));
+    ASSERT_EQ(slots[1], item.mSlot);
+    ASSERT_EQ(2u, item.mFrameNumber);
+
+    std::vector<IGraphicBufferProducer::CancelBufferInput> cancelInputs(2);
+    cancelInputs[0].slot = slots[2];
+    cancelInputs[0].fence = Fence::NO_FENCE;
+    cancelInputs[1].slot = slots[0];
+    cancelInputs[1].fence = Fence::NO_FENCE;
+    std::vector<status_t> cancelResults;
+    ASSERT_EQ(OK, mProducer->cancelBuffers(cancelInputs, &cancelResults));
+    ASSERT_EQ((std::vector<status_t>{OK, BAD_VALUE}), cancelResults);
+
+    std::vector<status_t> detachResults;
+    ASSERT_EQ(OK, mProducer->detachBuffers({slots[3], slots[2]}, &detachResults));
+    ASSERT_EQ((std::vector<status_t>{OK, BAD_VALUE}), detachResults);
+}
+
 TEST_F(BufferQueueTest, TestStaleBufferHandleSentAfterDisconnect) {
     createBufferQueue();
     sp<MockConsumer> mc(new MockConsumer);
@@ -0,0 +1,223 @@
+/*
+ * Copyright 2024 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <algorithm>
+#include <chrono>
+#include <deque>
+#include <limits>
+#include <memory>
+#include <thread>
+#include <vector>
+
+#include <benchmark/benchmark.h>
+
+#include <gui/BLASTBufferQueue.h>
+#include <gui/FrameTimestamps.h>
+#include <gui/Surface.h>
+#include <gui/SurfaceComposerClient.h>
+#include <system/window.h>
+#include <ui/DisplayState.h>
+#include <utils/String8.h>
+
+namespace android {
+
+namespace {
+
+using namespace std::chrono_literals;
+
+// Frames are resolved once this many newer frames have been queued, which leaves SurfaceFlinger
+// time to latch and present them while staying well inside the producer's frame event history.
+constexpr size_t kResolveLag = 4;
+
+struct StreamStats {
+    std::vector<nsecs_t> queueToLatch;
+    std::vector<nsecs_t> latchToPresent;
+    size_t frames = 0;
+    size_t dropped = 0;
+};
+
+// One BLASTBufferQueue backed layer, queueing empty buffers from the CPU and reading back when
+// SurfaceFlinger latched and presented them.
+class BufferStream {
+public:
+    BufferStream(const sp<SurfaceComposerClient>& client, const sp<SurfaceControl>& parent,
+                 int index, ui::Size size) {
+        const String8 name = String8::format("BufferStream_benchmark#%d", index);
+        mSurfaceControl = client->createSurface(name, size.width, size.height,
+                                                PIXEL_FORMAT_RGBA_8888,
+                                                ISurfaceComposerClient::eFXSurfaceBufferState,
+                                                parent->getHandle());
+        mBlastBufferQueue = sp<BLASTBufferQueue>::make(name.c_str(), mSurfaceControl, size.width,
+                                                       size.height, PIXEL_FORMAT_RGBA_8888);
+        mSurface = mBlastBufferQueue->getSurface(false);
+        mSurface->enableFrameTimestamps(true);
+        native_window_api_connect(mSurface.get(), NATIVE_WINDOW_API_CPU);
+        native_window_set_usage(mSurface.get(), GRALLOC_USAGE_SW_WRITE_RARELY);
+    }
+
+    ~BufferStream() { native_window_api_disconnect(mSurface.get(), NATIVE_WINDOW_API_CPU); }
+
+    const sp<SurfaceControl>& getSurfaceControl() const { return mSurfaceControl; }
+
+    // Queues one frame and resolves the ones that were queued long enough ago.
+    void produceFrame(StreamStats& stats) {
+        const uint64_t frameNumber = mSurface->getNextFrameNumber();
+        ANativeWindow* window = mSurface.get();
+        ANativeWindowBuffer* buffer;
+        if (native_window_dequeue_buffer_and_wait(window, &buffer) != NO_ERROR) {
+            stats.frames++;
+            stats.dropped++;
+            return;
+        }
+        if (window->queueBuffer(window, buffer, -1) != NO_ERROR) {
+            stats.frames++;
+            stats.dropped++;
+            return;
+        }
+        mPendingFrames.push_back({frameNumber, systemTime()});
+        while (mPendingFrames.size() > kResolveLag) {
+            resolveFrame(mPendingFrames.front(), stats);
+            mPendingFrames.pop_front();
+        }
+    }
+
+    // Resolves the frames still in flight. Callers should give SurfaceFlinger a few vsyncs to
+    // present them first.
+    void drain(StreamStats& stats) {
+        for (const auto& frame : mPendingFrames) {
+            resolveFrame(frame, stats);
+        }
+        mPendingFrames.clear();
+    }
+
+private:
+    struct PendingFrame {
+        uint64_t frameNumber;
+        nsecs_t queueTime;
+    };
+
+    void resolveFrame(const PendingFrame& frame, StreamStats& stats) {
+        stats.frames++;
+        nsecs_t latchTime = FrameEvents::TIMESTAMP_PENDING;
+        nsecs_t presentTime = FrameEvents::TIMESTAMP_PENDING;
+        const status_t status =
+                mSurface->getFrameTimestamps(frame.frameNumber, nullptr, nullptr, &latchTime,
+                                             nullptr, nullptr, nullptr, &presentTime, nullptr,
+                                             nullptr);
+        // A frame that was replaced before SurfaceFlinger latched it, or that never reached the
+        // display, has no valid latch or present time.
+        if (status != NO_ERROR || latchTime < 0 || presentTime < 0) {
+            stats.dropped++;
+            return;
+        }
+        stats.queueToLatch.push_back(latchTime - frame.queueTime);
+        stats.latchToPresent.push_back(presentTime - latchTime);
+    }
+
+    sp<SurfaceControl> mSurfaceControl;
+    sp<BLASTBufferQueue> mBlastBufferQueue;
+    sp<Surface> mSurface;
+    std::deque<PendingFrame> mPendingFrames;
+};
+
+void reportPercentiles(benchmark::State& state, const char* name, std::vector<nsecs_t>& samples) {
+    if (samples.empty()) return;
+    std::sort(samples.begin(), samples.end());
+    const auto percentile = [&](double p) {
+        return static_cast<double>(samples[static_cast<size_t>(p * (samples.size() - 1))]);
+    };
+    const std::string prefix(name);
+    state.counters[prefix + "_p50_ns"] = percentile(0.5);
+    state.counters[prefix + "_p99_ns"] = percentile(0.99);
+    state.counters[prefix + "_max_ns"] = static_cast<double>(samples.back());
+}
+
+// Queues frames on a number of layers at a fixed rate, end to end through SurfaceFlinger and the
+// composer, and reports how long frames wait to be latched, how long presenting them takes once
+// latched, and how many never make it to the display.
+static void bufferStreamLatency(benchmark::State& state) {
+    const int layerCount = static_cast<int>(state.range(0));
+    const auto framePeriod = std::chrono::nanoseconds(1s) / state.range(1);
+
+    const sp<SurfaceComposerClient> client = sp<SurfaceComposerClient>::make();
+    const auto ids = SurfaceComposerClient::getPhysicalDisplayIds();
+    if (ids.empty()) {
+        state.SkipWithError("no physical display");
+        return;
+    }
+    const sp<IBinder> displayToken = SurfaceComposerClient::getPhysicalDisplayToken(ids.front());
+    ui::DisplayState displayState;
+    if (SurfaceComposerClient::getDisplayState(displayToken, &displayState) != NO_ERROR) {
+        state.SkipWithError("failed to get display state");
+        return;
+    }
+    const ui::Size displaySize = displayState.layerStackSpaceRect;
+
+    const sp<SurfaceControl> root =
+            client->createSurface(String8("BufferStream_benchmark"), displaySize.width,
+                                  displaySize.height, PIXEL_FORMAT_RGBA_8888,
+                                  ISurfaceComposerClient::eFXContainerSurface,
+                                  /*parent*/ nullptr);
+    std::vector<std::unique_ptr<BufferStream>> streams;
+    SurfaceComposerClient::Transaction t;
+    t.setLayerStack(root, ui::DEFAULT_LAYER_STACK)
+            .setLayer(root, std::numeric_limits<int32_t>::max())
+            .show(root);
+    for (int i = 0; i < layerCount; i++) {
+        streams.push_back(std::make_unique<BufferStream>(client, root, i, displaySize));
+        t.setLayer(streams.back()->getSurfaceControl(), i).show(streams.back()->getSurfaceControl());
+    }
+    t.apply(/*synchronous*/ true);
+
+    StreamStats stats;
+    auto nextFrame = std::chrono::steady_clock::now();
+    for (auto _ : state) {
+        for (auto& stream : streams) {
+            stream->produceFrame(stats);
+        }
+        nextFrame += framePeriod;
+        std::this_thread::sleep_until(nextFrame);
+    }
+    state.PauseTiming();
+    std::this_thread::sleep_for(framePeriod * kResolveLag + 100ms);
+    for (auto& stream : streams) {
+        stream->drain(stats);
+    }
+
+    streams.clear();
+    SurfaceComposerClient::Transaction().reparent(root, nullptr).apply(/*synchronous*/ true);
+    state.ResumeTiming();
+
+    reportPercentiles(state, "queue_to_latch", stats.queueToLatch);
+    reportPercentiles(state, "latch_to_present", stats.latchToPresent);
+    state.counters["frames"] = static_cast<double>(stats.frames);
+    state.counters["dropped"] = static_cast<double>(stats.dropped);
+    if (stats.frames > 0) {
+        state.counters["drop_rate"] =
+                static_cast<double>(stats.dropped) / static_cast<double>(stats.frames);
+    }
+}
+BENCHMARK(bufferStreamLatency)
+        ->ArgNames({"layers", "fps"})
+        ->Args({1, 60})
+        ->Args({1, 120})
+        ->Args({4, 60})
+        ->Args({4, 120})
+        ->Args({8, 60})
+        ->UseRealTime();
+
+} // namespace
+} // namespace android
@@ -20,6 +20,7 @@
 #include <android/choreographer.h>
 #include <gtest/gtest.h>
 #include <gui/Choreographer.h>
+#include <gui/SurfaceComposerClient.h>
 #include <utils/Looper.h>
 #include <chrono>
 #include <future>
@@ -83,4 +84,32 @@ TEST_F(ChoreographerTest, InputCallbackBeforeAnimation) {
                                            animationCb.frameTime.count());
 }
 
+TEST_F(ChoreographerTest, CoalescedTransactionsApplyOnVsync) {
+    sp<Looper> looper = Looper::prepare(0);
+    sp<IBinder> applyToken = sp<BBinder>::make();
+    ASSERT_EQ(NO_ERROR, SurfaceComposerClient::Transaction::setCoalescing(applyToken, true));
+
+    std::atomic<int> committed = 0;
+    auto onCommitted = [&committed](void*, nsecs_t, const sp<Fence>&,
+                                    const std::vector<SurfaceControlStats>&) { committed++; };
+    for (int i = 0; i < 3; i++) {
+        SurfaceComposerClient::Transaction t;
+        t.setApplyToken(applyToken);
+        t.addTransactionCommittedCallback(onCommitted, nullptr);
+        t.apply();
+    }
+
+    auto startTime = std::chrono::system_clock::now();
+    while (committed.load() < 3) {
+        static constexpr int32_t timeoutMs = 1000;
+        looper->pollOnce(timeoutMs / 10);
+        auto elapsedMs = std::chrono::duration_cast<std::chrono::milliseconds>(
+                std::chrono::system_clock::now() - startTime);
+        ASSERT_LE(elapsedMs.count(), timeoutMs) << "Timed out waiting for coalesced transactions. "
+                                                << "committed=" << committed.load();
+    }
+
+    ASSERT_EQ(NO_ERROR, SurfaceComposerClient::Transaction::setCoalescing(applyToken, false));
+}
+
 } // namespace android
\ No newline at end of file
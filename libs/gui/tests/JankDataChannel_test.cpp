@@ -0,0 +1,142 @@
+/*
+ * Copyright (C) 2024 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <fcntl.h>
+#include <sys/mman.h>
+
+#include <thread>
+#include <vector>
+
+#include <gtest/gtest.h>
+#include <gui/JankDataChannel.h>
+
+using android::gui::JankData;
+using android::gui::JankDataChannel;
+
+namespace android {
+
+namespace {
+
+JankData makeJankData(int64_t vsyncId) {
+    JankData data;
+    data.frameVsyncId = vsyncId;
+    data.jankType = static_cast<int32_t>(vsyncId % 7);
+    data.frameIntervalNs = 8333333;
+    data.scheduledAppFrameTimeNs = 2 * vsyncId;
+    data.actualAppFrameTimeNs = 3 * vsyncId;
+    return data;
+}
+
+class JankDataChannelTest : public testing::Test {
+protected:
+    void open(size_t capacity) {
+        ASSERT_EQ(OK, JankDataChannel::createProducer("test", capacity, mProducer));
+        base::unique_fd fd(fcntl(mProducer->getFd().get(), F_DUPFD_CLOEXEC, 0));
+        ASSERT_EQ(OK, JankDataChannel::createConsumer(std::move(fd), mConsumer));
+    }
+
+    std::unique_ptr<JankDataChannel::Producer> mProducer;
+    std::unique_ptr<JankDataChannel::Consumer> mConsumer;
+};
+
+} // namespace
+
+TEST_F(JankDataChannelTest, readsWrittenEntries) {
+    ASSERT_NO_FATAL_FAILURE(open(8));
+
+    std::vector<JankDataChannel::Entry> entries;
+    EXPECT_EQ(0u, mConsumer->read(entries));
+    EXPECT_TRUE(entries.empty());
+
+    mProducer->write(123, makeJankData(1000));
+    mProducer->write(456, makeJankData(1001));
+
+    EXPECT_EQ(0u, mConsumer->read(entries));
+    ASSERT_EQ(2u, entries.size());
+    EXPECT_EQ(123, entries[0].layerId);
+    EXPECT_EQ(makeJankData(1000), entries[0].data);
+    EXPECT_EQ(456, entries[1].layerId);
+    EXPECT_EQ(makeJankData(1001), entries[1].data);
+
+    // Entries are only read once.
+    entries.clear();
+    EXPECT_EQ(0u, mConsumer->read(entries));
+    EXPECT_TRUE(entries.empty());
+}
+
+TEST_F(JankDataChannelTest, countsOverwrittenEntriesAsDropped) {
+    ASSERT_NO_FATAL_FAILURE(open(4));
+
+    for (int64_t vsyncId = 0; vsyncId < 10; vsyncId++) {
+        mProducer->write(123, makeJankData(vsyncId));
+    }
+
+    std::vector<JankDataChannel::Entry> entries;
+    EXPECT_EQ(6u, mConsumer->read(entries));
+    ASSERT_EQ(4u, entries.size());
+    for (size_t i = 0; i < entries.size(); i++) {
+        EXPECT_EQ(makeJankData(static_cast<int64_t>(6 + i)), entries[i].data);
+    }
+}
+
+TEST_F(JankDataChannelTest, readsConsistentEntriesWhileWritten) {
+    ASSERT_NO_FATAL_FAILURE(open(16));
+
+    constexpr int64_t kEntryCount = 100000;
+    std::thread producer([&] {
+        for (int64_t vsyncId = 0; vsyncId < kEntryCount; vsyncId++) {
+            mProducer->write(static_cast<int32_t>(vsyncId), makeJankData(vsyncId));
+        }
+    });
+
+    size_t read = 0;
+    size_t dropped = 0;
+    int64_t lastVsyncId = -1;
+    std::vector<JankDataChannel::Entry> entries;
+    while (read + dropped < kEntryCount) {
+        entries.clear();
+        dropped += mConsumer->read(entries);
+        for (const auto& entry : entries) {
+            ASSERT_GT(entry.data.frameVsyncId, lastVsyncId);
+            ASSERT_EQ(entry.layerId, entry.data.frameVsyncId);
+            ASSERT_EQ(makeJankData(entry.data.frameVsyncId), entry.data);
+            lastVsyncId = entry.data.frameVsyncId;
+        }
+        read += entries.size();
+    }
+    producer.join();
+
+    EXPECT_EQ(static_cast<size_t>(kEntryCount), read + dropped);
+}
+
+TEST_F(JankDataChannelTest, consumerIsReadOnly) {
+    ASSERT_NO_FATAL_FAILURE(open(8));
+
+    const int fd = mProducer->getFd().get();
+    void* memory = mmap(nullptr, 1, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    EXPECT_EQ(MAP_FAILED, memory);
+    if (memory != MAP_FAILED) {
+        munmap(memory, 1);
+    }
+}
+
+TEST_F(JankDataChannelTest, rejectsTooSmallMemory) {
+    base::unique_fd fd(memfd_create("empty", MFD_CLOEXEC));
+    std::unique_ptr<JankDataChannel::Consumer> consumer;
+    EXPECT_EQ(BAD_VALUE, JankDataChannel::createConsumer(std::move(fd), consumer));
+}
+
+} // namespace android
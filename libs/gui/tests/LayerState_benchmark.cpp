@@ -0,0 +1,68 @@
+/*
+ * Copyright 2024 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <benchmark/benchmark.h>
+
+#include <binder/Parcel.h>
+#include <gui/LayerState.h>
+
+namespace android {
+
+namespace {
+
+// What an animation typically changes on each frame.
+layer_state_t makeAnimationState() {
+    layer_state_t state;
+    state.layerId = 1;
+    state.what = layer_state_t::ePositionChanged | layer_state_t::eAlphaChanged |
+            layer_state_t::eMatrixChanged;
+    state.x = 10.0f;
+    state.y = 20.0f;
+    state.color.a = 0.5f;
+    state.matrix.dsdx = state.matrix.dsdy = 0.9f;
+    return state;
+}
+
+// Writes the state with the encoding given by the first argument, 0 for full and 1 for delta.
+static void encodeLayerState(benchmark::State& benchState) {
+    const layer_state_t state = makeAnimationState();
+    const bool deltaEncoded = benchState.range(0) != 0;
+    Parcel parcel;
+    for (auto _ : benchState) {
+        parcel.setDataSize(0);
+        state.write(parcel, deltaEncoded);
+        benchmark::DoNotOptimize(parcel.data());
+    }
+    benchState.counters["parcel_bytes"] = static_cast<double>(parcel.dataSize());
+}
+BENCHMARK(encodeLayerState)->Arg(0)->Arg(1);
+
+static void decodeLayerState(benchmark::State& benchState) {
+    const bool deltaEncoded = benchState.range(0) != 0;
+    Parcel parcel;
+    makeAnimationState().write(parcel, deltaEncoded);
+    for (auto _ : benchState) {
+        parcel.setDataPosition(0);
+        layer_state_t state;
+        state.read(parcel);
+        benchmark::DoNotOptimize(state);
+    }
+    benchState.counters["parcel_bytes"] = static_cast<double>(parcel.dataSize());
+}
+BENCHMARK(decodeLayerState)->Arg(0)->Arg(1);
+
+} // namespace
+} // namespace android
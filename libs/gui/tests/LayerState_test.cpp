@@ -0,0 +1,77 @@
+/*
+ * Copyright 2024 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <gtest/gtest.h>
+
+#include <binder/Parcel.h>
+
+#include <gui/LayerState.h>
+
+namespace android {
+namespace test {
+
+TEST(LayerState, DeltaParcellingWritesChangedFields) {
+    layer_state_t state;
+    state.layerId = 7;
+    state.what = layer_state_t::ePositionChanged | layer_state_t::eAlphaChanged;
+    state.x = 12.5f;
+    state.y = -3.0f;
+    state.color.a = 0.25f;
+    // Not covered by what, so not sent.
+    state.cornerRadius = 8.0f;
+
+    Parcel delta;
+    ASSERT_EQ(NO_ERROR, state.write(delta, /*deltaEncoded*/ true));
+    Parcel full;
+    ASSERT_EQ(NO_ERROR, state.write(full, /*deltaEncoded*/ false));
+    EXPECT_LT(delta.dataSize(), full.dataSize());
+
+    delta.setDataPosition(0);
+    layer_state_t state2;
+    ASSERT_EQ(NO_ERROR, state2.read(delta));
+    EXPECT_EQ(state.layerId, state2.layerId);
+    EXPECT_EQ(state.what, state2.what);
+    EXPECT_EQ(state.x, state2.x);
+    EXPECT_EQ(state.y, state2.y);
+    EXPECT_EQ(state.color.a, state2.color.a);
+    EXPECT_EQ(0.0f, state2.cornerRadius);
+    EXPECT_EQ(delta.dataSize(), delta.dataPosition());
+}
+
+TEST(LayerState, FullParcellingWritesAllFields) {
+    layer_state_t state;
+    state.what = layer_state_t::ePositionChanged;
+    state.x = 1.0f;
+    state.cornerRadius = 8.0f;
+    BlurRegion region{};
+    region.blurRadius = 4;
+    state.blurRegions.push_back(region);
+
+    Parcel p;
+    ASSERT_EQ(NO_ERROR, state.write(p, /*deltaEncoded*/ false));
+    p.setDataPosition(0);
+
+    layer_state_t state2;
+    ASSERT_EQ(NO_ERROR, state2.read(p));
+    EXPECT_EQ(state.x, state2.x);
+    EXPECT_EQ(state.cornerRadius, state2.cornerRadius);
+    ASSERT_EQ(1u, state2.blurRegions.size());
+    EXPECT_EQ(4u, state2.blurRegions[0].blurRadius);
+    EXPECT_EQ(p.dataSize(), p.dataPosition());
+}
+
+} // namespace test
+} // namespace android
@@ -180,6 +180,60 @@ TEST_F(StreamSplitterTest, OneInputMultipleOutputs) {
                                            nullptr, nullptr));
 }
 
+TEST_F(StreamSplitterTest, OutputAddedWhileBufferIsOut) {
+    sp<IGraphicBufferProducer> inputProducer;
+    sp<IGraphicBufferConsumer> inputConsumer;
+    BufferQueue::createBufferQueue(&inputProducer, &inputConsumer);
+
+    sp<IGraphicBufferProducer> outputProducer;
+    sp<IGraphicBufferConsumer> outputConsumer;
+    BufferQueue::createBufferQueue(&outputProducer, &outputConsumer);
+    ASSERT_EQ(OK, outputConsumer->consumerConnect(new FakeListener, false));
+
+    sp<IGraphicBufferProducer> lateOutputProducer;
+    sp<IGraphicBufferConsumer> lateOutputConsumer;
+    BufferQueue::createBufferQueue(&lateOutputProducer, &lateOutputConsumer);
+    ASSERT_EQ(OK, lateOutputConsumer->consumerConnect(new FakeListener, false));
+
+    sp<StreamSplitter> splitter;
+    status_t status = StreamSplitter::createSplitter(inputConsumer, &splitter);
+    ASSERT_EQ(OK, status);
+    ASSERT_EQ(OK, splitter->addOutput(outputProducer));
+    ASSERT_EQ(OK, outputProducer->allowAllocation(false));
+
+    IGraphicBufferProducer::QueueBufferOutput qbOutput;
+    ASSERT_EQ(OK,
+              inputProducer->connect(new StubProducerListener, NATIVE_WINDOW_API_CPU, false,
+                                     &qbOutput));
+
+    int slot;
+    sp<Fence> fence;
+    sp<GraphicBuffer> buffer;
+    ASSERT_EQ(IGraphicBufferProducer::BUFFER_NEEDS_REALLOCATION,
+              inputProducer->dequeueBuffer(&slot, &fence, 0, 0, 0, GRALLOC_USAGE_SW_WRITE_OFTEN,
+                                           nullptr, nullptr));
+    ASSERT_EQ(OK, inputProducer->requestBuffer(slot, &buffer));
+
+    IGraphicBufferProducer::QueueBufferInput qbInput(0, false,
+            HAL_DATASPACE_UNKNOWN, Rect(0, 0, 1, 1),
+            NATIVE_WINDOW_SCALING_MODE_FREEZE, 0, Fence::NO_FENCE);
+    ASSERT_EQ(OK, inputProducer->queueBuffer(slot, qbInput, &qbOutput));
+    ASSERT_EQ(OK, inputProducer->allowAllocation(false));
+
+    // The buffer was only sent to the first output, so it goes back to the
+    // input once that output releases it
+    ASSERT_EQ(OK, splitter->addOutput(lateOutputProducer));
+
+    BufferItem item;
+    ASSERT_EQ(OK, outputConsumer->acquireBuffer(&item, 0));
+    ASSERT_EQ(OK, outputConsumer->releaseBuffer(item.mSlot, item.mFrameNumber,
+            EGL_NO_DISPLAY, EGL_NO_SYNC_KHR, Fence::NO_FENCE));
+
+    ASSERT_EQ(IGraphicBufferProducer::BUFFER_NEEDS_REALLOCATION,
+              inputProducer->dequeueBuffer(&slot, &fence, 0, 0, 0, GRALLOC_USAGE_SW_WRITE_OFTEN,
+                                           nullptr, nullptr));
+}
+
 TEST_F(StreamSplitterTest, OutputAbandonment) {
     sp<IGraphicBufferProducer> inputProducer;
     sp<IGraphicBufferConsumer> inputConsumer;
@@ -1015,6 +1015,12 @@ public:
         return binder::Status::ok();
     }
 
+    binder::Status openJankDataChannel(
+            const sp<gui::IJankListener>& /*listener*/,
+            std::optional<os::ParcelFileDescriptor>* /*outChannel*/) override {
+        return binder::Status::ok();
+    }
+
 protected:
     IBinder* onAsBinder() override { return nullptr; }
 
@@ -2235,6 +2241,46 @@ TEST_F(SurfaceTest, BatchIllegalOperations) {
     ASSERT_EQ(NO_ERROR, surface->disconnect(NATIVE_WINDOW_API_CPU));
 }
 
+TEST_F(SurfaceTest, DequeueAhead) {
+    sp<CpuConsumer> cpuConsumer = new CpuConsumer(1);
+    sp<Surface> surface = cpuConsumer->getSurface();
+    sp<ANativeWindow> window(surface);
+    sp<StubSurfaceListener> listener = new StubSurfaceListener();
+
+    ASSERT_EQ(OK, surface->connect(NATIVE_WINDOW_API_CPU, /*listener*/listener,
+            /*reportBufferRemoval*/false));
+    ASSERT_EQ(NO_ERROR, native_window_set_buffer_count(window.get(), 4));
+    ASSERT_EQ(NO_ERROR, native_window_set_buffers_dimensions(window.get(), 16, 16));
+    ASSERT_EQ(NO_ERROR, surface->setDequeueAhead(true));
+
+    ANativeWindowBuffer* buffer;
+    int fence;
+    CpuConsumer::LockedBuffer lockedBuffer;
+    for (int i = 0; i < 3; i++) {
+        ASSERT_EQ(NO_ERROR, window->dequeueBuffer(window.get(), &buffer, &fence));
+        EXPECT_EQ(16, buffer->width);
+        ASSERT_EQ(NO_ERROR, window->queueBuffer(window.get(), buffer, fence));
+        ASSERT_EQ(NO_ERROR, cpuConsumer->lockNextBuffer(&lockedBuffer));
+        ASSERT_EQ(NO_ERROR, cpuConsumer->unlockBuffer(lockedBuffer));
+    }
+
+    // The buffer dequeued ahead is given back once the requested size changes.
+    ASSERT_EQ(NO_ERROR, native_window_set_buffers_dimensions(window.get(), 32, 32));
+    ASSERT_EQ(NO_ERROR, window->dequeueBuffer(window.get(), &buffer, &fence));
+    EXPECT_EQ(32, buffer->width);
+    ASSERT_EQ(NO_ERROR, window->cancelBuffer(window.get(), buffer, fence));
+
+    // It is also given back before the buffer count changes.
+    ASSERT_EQ(NO_ERROR, window->dequeueBuffer(window.get(), &buffer, &fence));
+    ASSERT_EQ(NO_ERROR, window->queueBuffer(window.get(), buffer, fence));
+    ASSERT_EQ(NO_ERROR, cpuConsumer->lockNextBuffer(&lockedBuffer));
+    ASSERT_EQ(NO_ERROR, cpuConsumer->unlockBuffer(lockedBuffer));
+    ASSERT_EQ(NO_ERROR, native_window_set_buffer_count(window.get(), 2));
+
+    ASSERT_EQ(NO_ERROR, surface->setDequeueAhead(false));
+    ASSERT_EQ(NO_ERROR, surface->disconnect(NATIVE_WINDOW_API_CPU));
+}
+
 #if COM_ANDROID_GRAPHICS_LIBGUI_FLAGS(WB_PLATFORM_API_IMPROVEMENTS)
 
 TEST_F(SurfaceTest, PlatformBufferMethods) {
@@ -23,6 +23,7 @@
 namespace android {
 
 using gui::ParcelableVsyncEventData;
+using gui::SharedVsyncEventData;
 using gui::VsyncEventData;
 using FrameTimeline = gui::VsyncEventData::FrameTimeline;
 
@@ -56,5 +57,39 @@ TEST(ParcelableVsyncEventData, Parcelling) {
     }
 }
 
+TEST(SharedVsyncEventData, readsLatestEvent) {
+    SharedVsyncEventData shared{};
+    int64_t timestamp = 0;
+    VsyncEventData data{};
+    EXPECT_FALSE(shared.read(&timestamp, &data));
+
+    VsyncEventData published{};
+    published.frameInterval = 789;
+    published.preferredFrameTimelineIndex = 0;
+    published.frameTimelinesLength = 1;
+    published.frameTimelines[0] = FrameTimeline{1, 2, 3};
+    shared.write(100, 1, published);
+    published.frameTimelines[0] = FrameTimeline{4, 5, 6};
+    shared.write(200, 2, published);
+
+    ASSERT_TRUE(shared.read(&timestamp, &data));
+    EXPECT_EQ(200, timestamp);
+    EXPECT_EQ(789, data.frameInterval);
+    EXPECT_EQ(4, data.preferredVsyncId());
+    EXPECT_EQ(5, data.preferredDeadlineTimestamp());
+    EXPECT_EQ(6, data.preferredExpectedPresentationTime());
+}
+
+TEST(SharedVsyncEventData, doesNotReadEventBeingWritten) {
+    SharedVsyncEventData shared{};
+    shared.write(100, 1, VsyncEventData{});
+
+    // The writer bumps the sequence number to an odd value while it updates the event.
+    shared.sequence.fetch_add(1);
+    int64_t timestamp = 0;
+    VsyncEventData data{};
+    EXPECT_FALSE(shared.read(&timestamp, &data));
+}
+
 } // namespace test
 } // namespace android
@@ -20,6 +20,7 @@
 #include <binder/Parcel.h>
 
 #include <gui/WindowInfo.h>
+#include <gui/WindowInfosUpdate.h>
 
 using std::chrono_literals::operator""s;
 
@@ -28,6 +29,7 @@ namespace android {
 using gui::InputApplicationInfo;
 using gui::TouchOcclusionMode;
 using gui::WindowInfo;
+using gui::WindowInfosUpdate;
 using ui::Size;
 
 namespace test {
@@ -116,5 +118,82 @@ TEST(InputApplicationInfo, Parcelling) {
     ASSERT_EQ(i, i2);
 }
 
+static WindowInfo makeWindowInfo(int32_t id, Rect frame) {
+    WindowInfo info;
+    info.id = id;
+    info.name = "Window " + std::to_string(id);
+    info.frame = frame;
+    info.alpha = 1.0f;
+    return info;
+}
+
+TEST(WindowInfosUpdate, DeltaRoundTrip) {
+    WindowInfosUpdate base;
+    base.windowInfos = {makeWindowInfo(1, Rect(0, 0, 10, 10)), makeWindowInfo(2, Rect(5, 5, 8, 8)),
+                        makeWindowInfo(3, Rect(1, 1, 2, 2)), makeWindowInfo(4, Rect(0, 0, 4, 4))};
+    base.version = 1;
+
+    // Window 2 moves, window 3 is removed, window 5 is added and windows 1 and 4 swap places.
+    WindowInfosUpdate next;
+    next.windowInfos = {makeWindowInfo(4, Rect(0, 0, 4, 4)), makeWindowInfo(2, Rect(6, 6, 9, 9)),
+                        makeWindowInfo(5, Rect(2, 2, 3, 3)), makeWindowInfo(1, Rect(0, 0, 10, 10))};
+    next.vsyncId = 42;
+    next.version = 2;
+
+    std::optional<WindowInfosUpdate> delta = next.createDelta(base);
+    ASSERT_TRUE(delta);
+    EXPECT_TRUE(delta->isDelta());
+    EXPECT_EQ(delta->baseVersion, 1);
+    EXPECT_EQ(delta->vsyncId, 42);
+    EXPECT_EQ(delta->windowIds, (std::vector<int32_t>{4, 2, 5, 1}));
+    ASSERT_EQ(delta->windowInfos.size(), 2u);
+    EXPECT_EQ(delta->windowInfos[0], next.windowInfos[1]);
+    EXPECT_EQ(delta->windowInfos[1], next.windowInfos[2]);
+
+    Parcel p;
+    ASSERT_EQ(OK, delta->writeToParcel(&p));
+    p.setDataPosition(0);
+    WindowInfosUpdate received;
+    ASSERT_EQ(OK, received.readFromParcel(&p));
+
+    ASSERT_EQ(OK, received.applyDelta(base));
+    EXPECT_FALSE(received.isDelta());
+    EXPECT_EQ(received.version, 2);
+    EXPECT_EQ(received.windowInfos, next.windowInfos);
+}
+
+TEST(WindowInfosUpdate, DeltaRequiresMatchingBase) {
+    WindowInfosUpdate base;
+    base.windowInfos = {makeWindowInfo(1, Rect(0, 0, 10, 10)), makeWindowInfo(2, Rect(5, 5, 8, 8))};
+    base.version = 1;
+
+    WindowInfosUpdate next = base;
+    next.windowInfos[1].frame = Rect(6, 6, 9, 9);
+    next.version = 2;
+
+    std::optional<WindowInfosUpdate> delta = next.createDelta(base);
+    ASSERT_TRUE(delta);
+
+    WindowInfosUpdate otherBase = base;
+    otherBase.version = 3;
+    EXPECT_EQ(BAD_VALUE, delta->applyDelta(otherBase));
+    EXPECT_TRUE(delta->isDelta());
+}
+
+TEST(WindowInfosUpdate, NoDeltaWhenEveryWindowChanged) {
+    WindowInfosUpdate base;
+    base.windowInfos = {makeWindowInfo(1, Rect(0, 0, 10, 10))};
+    base.version = 1;
+
+    WindowInfosUpdate next;
+    next.windowInfos = {makeWindowInfo(1, Rect(0, 0, 20, 20))};
+    next.version = 2;
+    EXPECT_FALSE(next.createDelta(base));
+
+    // Windows that share an id can't be told apart.
+    next.windowInfos = {makeWindowInfo(1, Rect(0, 0, 10, 10)), makeWindowInfo(1, Rect(0, 0, 1, 1))};
+    EXPECT_FALSE(next.createDelta(base));
+}
+
 } // namespace test
 } // namespace android
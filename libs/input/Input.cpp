@@ -224,6 +224,20 @@ float transformAngle(const ui::Transform& transform, float angleRadians, bool is
     return atan2f(transformedPoint.x, -transformedPoint.y);
 }
 
+// Transforms the axes of the coords other than X and Y, as calculateTransformedCoordsInPlace does.
+static void transformNonPositionalAxesInPlace(PointerCoords& coords, int32_t flags,
+                                              const ui::Transform& transform) {
+    const vec2 relativeXy =
+            transformWithoutTranslation(transform,
+                                        {coords.getAxisValue(AMOTION_EVENT_AXIS_RELATIVE_X),
+                                         coords.getAxisValue(AMOTION_EVENT_AXIS_RELATIVE_Y)});
+    coords.setAxisValue(AMOTION_EVENT_AXIS_RELATIVE_X, relativeXy.x);
+    coords.setAxisValue(AMOTION_EVENT_AXIS_RELATIVE_Y, relativeXy.y);
+
+    coords.setAxisValue(AMOTION_EVENT_AXIS_ORIENTATION,
+                        transformOrientation(transform, coords, flags));
+}
+
 std::string inputEventSourceToString(int32_t source) {
     if (source == AINPUT_SOURCE_UNKNOWN) {
         return "UNKNOWN";
@@ -783,10 +797,29 @@ void MotionEvent::applyTransform(const std::array<float, 9>& matrix) {
     ui::Transform transform;
     transform.set(matrix);
 
-    // Apply the transformation to all samples.
-    std::for_each(mSamplePointerCoords.begin(), mSamplePointerCoords.end(), [&](PointerCoords& c) {
-        calculateTransformedCoordsInPlace(c, mSource, mFlags, transform);
-    });
+    // Apply the transformation to all samples. The positions of pointer events are transformed as
+    // one batch, and the other axes of each sample after that.
+    if (!shouldDisregardTransformation(mSource) && !shouldDisregardOffset(mSource)) {
+        std::vector<vec2> xys;
+        xys.reserve(mSamplePointerCoords.size());
+        for (const PointerCoords& c : mSamplePointerCoords) {
+            xys.push_back(c.getXYValue());
+        }
+        transform.transform(xys.data(), xys.data(), xys.size());
+
+        for (size_t i = 0; i < mSamplePointerCoords.size(); i++) {
+            PointerCoords& c = mSamplePointerCoords[i];
+            const vec2 xy = roundTransformedCoords(xys[i]);
+            c.setAxisValue(AMOTION_EVENT_AXIS_X, xy.x);
+            c.setAxisValue(AMOTION_EVENT_AXIS_Y, xy.y);
+            transformNonPositionalAxesInPlace(c, mFlags, transform);
+        }
+    } else {
+        std::for_each(mSamplePointerCoords.begin(), mSamplePointerCoords.end(),
+                      [&](PointerCoords& c) {
+                          calculateTransformedCoordsInPlace(c, mSource, mFlags, transform);
+                      });
+    }
 
     if (mRawXCursorPosition != AMOTION_EVENT_INVALID_CURSOR_POSITION &&
         mRawYCursorPosition != AMOTION_EVENT_INVALID_CURSOR_POSITION) {
@@ -1098,15 +1131,7 @@ void MotionEvent::calculateTransformedCoordsInPlace(PointerCoords& coords, uint3
     coords.setAxisValue(AMOTION_EVENT_AXIS_X, xy.x);
     coords.setAxisValue(AMOTION_EVENT_AXIS_Y, xy.y);
 
-    const vec2 relativeXy =
-            transformWithoutTranslation(transform,
-                                        {coords.getAxisValue(AMOTION_EVENT_AXIS_RELATIVE_X),
-                                         coords.getAxisValue(AMOTION_EVENT_AXIS_RELATIVE_Y)});
-    coords.setAxisValue(AMOTION_EVENT_AXIS_RELATIVE_X, relativeXy.x);
-    coords.setAxisValue(AMOTION_EVENT_AXIS_RELATIVE_Y, relativeXy.y);
-
-    coords.setAxisValue(AMOTION_EVENT_AXIS_ORIENTATION,
-                        transformOrientation(transform, coords, flags));
+    transformNonPositionalAxesInPlace(coords, flags, transform);
 }
 
 PointerCoords MotionEvent::calculateTransformedCoords(uint32_t source, int32_t flags,
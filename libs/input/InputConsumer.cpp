@@ -313,9 +313,12 @@ status_t InputConsumer::consume(InputEventFactoryInterface* factory, bool consum
                     }
                 }
 
-                // Start a new batch if needed.
-                if (mMsg.body.motion.action == AMOTION_EVENT_ACTION_MOVE ||
-                    mMsg.body.motion.action == AMOTION_EVENT_ACTION_HOVER_MOVE) {
+                // Start a new batch if needed. Events for low-latency windows are never batched.
+                const bool unbatched =
+                        (mMsg.body.motion.flags & AMOTION_EVENT_PRIVATE_FLAG_UNBATCHED);
+                if (!unbatched &&
+                    (mMsg.body.motion.action == AMOTION_EVENT_ACTION_MOVE ||
+                     mMsg.body.motion.action == AMOTION_EVENT_ACTION_HOVER_MOVE)) {
                     Batch batch;
                     batch.samples.push_back(mMsg);
                     mBatches.push_back(batch);
@@ -837,6 +840,9 @@ ssize_t InputConsumer::findTouchState(int32_t deviceId, int32_t source) const {
 }
 
 bool InputConsumer::canAddSample(const Batch& batch, const InputMessage* msg) {
+    if (msg->body.motion.flags & AMOTION_EVENT_PRIVATE_FLAG_UNBATCHED) {
+        return false;
+    }
     const InputMessage& head = batch.samples[0];
     uint32_t pointerCount = msg->body.motion.pointerCount;
     if (head.body.motion.pointerCount != pointerCount ||
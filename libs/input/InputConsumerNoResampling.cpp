@@ -17,6 +17,7 @@
 #define LOG_TAG "InputConsumerNoResampling"
 #define ATRACE_TAG ATRACE_TAG_INPUT
 
+#include <algorithm>
 #include <chrono>
 
 #include <inttypes.h>
@@ -46,6 +47,12 @@ using std::chrono::nanoseconds;
 const bool DEBUG_TRANSPORT_CONSUMER =
         __android_log_is_loggable(ANDROID_LOG_DEBUG, LOG_TAG "Consumer", ANDROID_LOG_INFO);
 
+/**
+ * Maximum number of messages sent or received by one system call. Finish signals are sent for all
+ * the messages of a batched motion event at once, and input can arrive at a high rate.
+ */
+constexpr size_t MAX_MESSAGES_PER_SYSCALL = 8;
+
 std::unique_ptr<KeyEvent> createKeyEvent(const InputMessage& msg) {
     std::unique_ptr<KeyEvent> event = std::make_unique<KeyEvent>();
     event->initialize(msg.body.key.eventId, msg.body.key.deviceId, msg.body.key.source,
@@ -241,15 +248,24 @@ int InputConsumerNoResampling::handleReceiveCallback(int events) {
 
 void InputConsumerNoResampling::processOutboundEvents() {
     while (!mOutboundQueue.empty()) {
-        const InputMessage& outboundMsg = mOutboundQueue.front();
+        // Send the queued messages in batches, a batch of finish signals is typically produced
+        // for each batched motion event.
+        std::vector<const InputMessage*> outboundMsgs;
+        for (size_t i = 0; i < std::min(mOutboundQueue.size(), MAX_MESSAGES_PER_SYSCALL); i++) {
+            outboundMsgs.push_back(&mOutboundQueue[i]);
+        }
 
-        const status_t result = mChannel->sendMessage(&outboundMsg);
-        if (result == OK) {
+        size_t sentCount;
+        const status_t result = mChannel->sendMessages(outboundMsgs, sentCount);
+        for (size_t i = 0; i < sentCount; i++) {
+            const InputMessage& outboundMsg = mOutboundQueue.front();
             if (outboundMsg.header.type == InputMessage::Type::FINISHED) {
                 ATRACE_ASYNC_END("InputConsumer processing", /*cookie=*/outboundMsg.header.seq);
             }
             // Successful send. Erase the entry and keep trying to send more
-            mOutboundQueue.pop();
+            mOutboundQueue.pop_front();
+        }
+        if (result == OK) {
             continue;
         }
 
@@ -270,12 +286,12 @@ void InputConsumerNoResampling::processOutboundEvents() {
 
 void InputConsumerNoResampling::finishInputEvent(uint32_t seq, bool handled) {
     ensureCalledOnLooperThread(__func__);
-    mOutboundQueue.push(createFinishedMessage(seq, handled, popConsumeTime(seq)));
+    mOutboundQueue.push_back(createFinishedMessage(seq, handled, popConsumeTime(seq)));
     // also produce finish events for all batches for this seq (if any)
     const auto it = mBatchedSequenceNumbers.find(seq);
     if (it != mBatchedSequenceNumbers.end()) {
         for (uint32_t subSeq : it->second) {
-            mOutboundQueue.push(createFinishedMessage(subSeq, handled, popConsumeTime(subSeq)));
+            mOutboundQueue.push_back(createFinishedMessage(subSeq, handled, popConsumeTime(subSeq)));
         }
         mBatchedSequenceNumbers.erase(it);
     }
@@ -292,7 +308,7 @@ bool InputConsumerNoResampling::probablyHasInput() const {
 void InputConsumerNoResampling::reportTimeline(int32_t inputEventId, nsecs_t gpuCompletedTime,
                                                nsecs_t presentTime) {
     ensureCalledOnLooperThread(__func__);
-    mOutboundQueue.push(createTimelineMessage(inputEventId, gpuCompletedTime, presentTime));
+    mOutboundQueue.push_back(createTimelineMessage(inputEventId, gpuCompletedTime, presentTime));
     processOutboundEvents();
 }
 
@@ -325,8 +341,11 @@ void InputConsumerNoResampling::handleMessages(std::vector<InputMessage>&& messa
             const int32_t action = msg.body.motion.action;
             const DeviceId deviceId = msg.body.motion.deviceId;
             const int32_t source = msg.body.motion.source;
-            const bool batchableEvent = (action == AMOTION_EVENT_ACTION_MOVE ||
-                                         action == AMOTION_EVENT_ACTION_HOVER_MOVE) &&
+            // Events for low-latency windows are delivered as they arrive.
+            const bool unbatched = (msg.body.motion.flags & AMOTION_EVENT_PRIVATE_FLAG_UNBATCHED);
+            const bool batchableEvent = !unbatched &&
+                    (action == AMOTION_EVENT_ACTION_MOVE ||
+                     action == AMOTION_EVENT_ACTION_HOVER_MOVE) &&
                     (isFromSource(source, AINPUT_SOURCE_CLASS_POINTER) ||
                      isFromSource(source, AINPUT_SOURCE_CLASS_JOYSTICK));
             if (batchableEvent) {
@@ -368,19 +387,21 @@ void InputConsumerNoResampling::handleMessages(std::vector<InputMessage>&& messa
 std::vector<InputMessage> InputConsumerNoResampling::readAllMessages() {
     std::vector<InputMessage> messages;
     while (true) {
-        android::base::Result<InputMessage> result = mChannel->receiveMessage();
+        android::base::Result<std::vector<InputMessage>> result =
+                mChannel->receiveMessages(MAX_MESSAGES_PER_SYSCALL);
         if (result.ok()) {
-            const InputMessage& msg = *result;
-            const auto [_, inserted] =
-                    mConsumeTimes.emplace(msg.header.seq, systemTime(SYSTEM_TIME_MONOTONIC));
-            LOG_ALWAYS_FATAL_IF(!inserted, "Already have a consume time for seq=%" PRIu32,
-                                msg.header.seq);
-
-            // Trace the event processing timeline - event was just read from the socket
-            // TODO(b/329777420): distinguish between multiple instances of InputConsumer
-            // in the same process.
-            ATRACE_ASYNC_BEGIN("InputConsumer processing", /*cookie=*/msg.header.seq);
-            messages.push_back(msg);
+            const nsecs_t consumeTime = systemTime(SYSTEM_TIME_MONOTONIC);
+            for (const InputMessage& msg : *result) {
+                const auto [_, inserted] = mConsumeTimes.emplace(msg.header.seq, consumeTime);
+                LOG_ALWAYS_FATAL_IF(!inserted, "Already have a consume time for seq=%" PRIu32,
+                                    msg.header.seq);
+
+                // Trace the event processing timeline - event was just read from the socket
+                // TODO(b/329777420): distinguish between multiple instances of InputConsumer
+                // in the same process.
+                ATRACE_ASYNC_BEGIN("InputConsumer processing", /*cookie=*/msg.header.seq);
+                messages.push_back(msg);
+            }
         } else { // !result.ok()
             switch (result.error().code()) {
                 case WOULD_BLOCK: {
@@ -526,6 +547,13 @@ bool InputConsumerNoResampling::consumeBatchedInputEvents(
     return consumeBatchedInputEvents(/*deviceId=*/std::nullopt, requestedFrameTime);
 }
 
+void InputConsumerNoResampling::setExpectedPresentationTime(nsecs_t expectedPresentationTime) {
+    ensureCalledOnLooperThread(__func__);
+    if (mResampler != nullptr) {
+        mResampler->setExpectedPresentationTime(nanoseconds{expectedPresentationTime});
+    }
+}
+
 void InputConsumerNoResampling::ensureCalledOnLooperThread(const char* func) const {
     sp<Looper> callingThreadLooper = Looper::getForThread();
     if (callingThreadLooper != mLooper) {
@@ -540,12 +568,8 @@ std::string InputConsumerNoResampling::dump() const {
         out += "mOutboundQueue: <empty>\n";
     } else {
         out += "mOutboundQueue:\n";
-        // Make a copy of mOutboundQueue for printing destructively. Unfortunately std::queue
-        // doesn't provide a good way to iterate over the entire container.
-        std::queue<InputMessage> tmpQueue = mOutboundQueue;
-        while (!tmpQueue.empty()) {
-            out += std::string("  ") + outboundMessageToString(tmpQueue.front()) + "\n";
-            tmpQueue.pop();
+        for (const InputMessage& msg : mOutboundQueue) {
+            out += std::string("  ") + outboundMessageToString(msg) + "\n";
         }
     }
 
@@ -174,11 +174,13 @@ size_t InputMessage::size() const {
 }
 
 /**
- * There could be non-zero bytes in-between InputMessage fields. Force-initialize the entire
- * memory to zero, then only copy the valid bytes on a per-field basis.
+ * There could be non-zero bytes in-between InputMessage fields. Force-initialize the memory that
+ * will be sent to zero, then only copy the valid bytes on a per-field basis. The rest of the
+ * message isn't sent: clearing it would cost more than the copy for events with few pointers,
+ * which are most of the high rate stylus and touch samples.
  */
 void InputMessage::getSanitizedCopy(InputMessage* msg) const {
-    memset(msg, 0, sizeof(*msg));
+    memset(msg, 0, size());
 
     // Write the header
     msg->header.type = header.type;
@@ -422,6 +424,58 @@ status_t InputChannel::sendMessage(const InputMessage* msg) {
     return OK;
 }
 
+status_t InputChannel::sendMessages(std::span<const InputMessage* const> msgs,
+                                    size_t& outSentCount) {
+    ATRACE_NAME_IF(ATRACE_ENABLED(),
+                   StringPrintf("sendMessages(inputChannel=%s, count=%zu)", name.c_str(),
+                                msgs.size()));
+    outSentCount = 0;
+    std::vector<InputMessage> cleanMsgs(msgs.size());
+    std::vector<iovec> iovecs(msgs.size());
+    std::vector<mmsghdr> headers(msgs.size());
+    for (size_t i = 0; i < msgs.size(); i++) {
+        msgs[i]->getSanitizedCopy(&cleanMsgs[i]);
+        iovecs[i] = {.iov_base = &cleanMsgs[i], .iov_len = msgs[i]->size()};
+        headers[i].msg_hdr = {.msg_iov = &iovecs[i], .msg_iovlen = 1};
+    }
+
+    while (outSentCount < msgs.size()) {
+        int nSent;
+        do {
+            nSent = ::sendmmsg(getFd(), headers.data() + outSentCount, msgs.size() - outSentCount,
+                               MSG_DONTWAIT | MSG_NOSIGNAL);
+        } while (nSent == -1 && errno == EINTR);
+
+        if (nSent < 0) {
+            int error = errno;
+            ALOGD_IF(DEBUG_CHANNEL_MESSAGES, "channel '%s' ~ error sending message of type %s, %s",
+                     name.c_str(), ftl::enum_string(msgs[outSentCount]->header.type).c_str(),
+                     strerror(error));
+            if (error == EAGAIN || error == EWOULDBLOCK) {
+                return WOULD_BLOCK;
+            }
+            if (error == EPIPE || error == ENOTCONN || error == ECONNREFUSED ||
+                error == ECONNRESET) {
+                return DEAD_OBJECT;
+            }
+            return -error;
+        }
+
+        for (int i = 0; i < nSent; i++, outSentCount++) {
+            if (headers[outSentCount].msg_len != iovecs[outSentCount].iov_len) {
+                ALOGD_IF(DEBUG_CHANNEL_MESSAGES,
+                         "channel '%s' ~ error sending message type %s, send was incomplete",
+                         name.c_str(), ftl::enum_string(msgs[outSentCount]->header.type).c_str());
+                return DEAD_OBJECT;
+            }
+            ALOGD_IF(DEBUG_CHANNEL_MESSAGES, "channel '%s' ~ sent message of type %s",
+                     name.c_str(), ftl::enum_string(msgs[outSentCount]->header.type).c_str());
+        }
+        // sendmmsg stops early when the socket is full, the next call reports why.
+    }
+    return OK;
+}
+
 android::base::Result<InputMessage> InputChannel::receiveMessage() {
     ssize_t nRead;
     InputMessage msg;
@@ -466,6 +520,72 @@ android::base::Result<InputMessage> InputChannel::receiveMessage() {
     return msg;
 }
 
+android::base::Result<std::vector<InputMessage>> InputChannel::receiveMessages(size_t maxCount) {
+    std::vector<InputMessage> msgs(maxCount);
+    std::vector<iovec> iovecs(maxCount);
+    std::vector<mmsghdr> headers(maxCount);
+    for (size_t i = 0; i < maxCount; i++) {
+        iovecs[i] = {.iov_base = &msgs[i], .iov_len = sizeof(InputMessage)};
+        headers[i].msg_hdr = {.msg_iov = &iovecs[i], .msg_iovlen = 1};
+    }
+
+    int nRead;
+    do {
+        nRead = ::recvmmsg(getFd(), headers.data(), maxCount, MSG_DONTWAIT, /*timeout=*/nullptr);
+    } while (nRead == -1 && errno == EINTR);
+
+    if (nRead < 0) {
+        int error = errno;
+        ALOGD_IF(DEBUG_CHANNEL_MESSAGES, "channel '%s' ~ receive messages failed, errno=%d",
+                 name.c_str(), errno);
+        if (error == EAGAIN || error == EWOULDBLOCK) {
+            return android::base::Error(WOULD_BLOCK);
+        }
+        if (error == EPIPE || error == ENOTCONN || error == ECONNREFUSED) {
+            return android::base::Error(DEAD_OBJECT);
+        }
+        return android::base::Error(-error);
+    }
+
+    if (nRead == 0) {
+        ALOGD_IF(DEBUG_CHANNEL_MESSAGES,
+                 "channel '%s' ~ receive message failed because peer was closed", name.c_str());
+        return android::base::Error(DEAD_OBJECT);
+    }
+
+    size_t count = 0;
+    for (; count < size_t(nRead); count++) {
+        const size_t msgLength = headers[count].msg_len;
+        if (msgLength == 0) { // check for EOF
+            if (count > 0) {
+                // Return what was received before, the next call reports the EOF.
+                break;
+            }
+            ALOGD_IF(DEBUG_CHANNEL_MESSAGES,
+                     "channel '%s' ~ receive message failed because peer was closed",
+                     name.c_str());
+            return android::base::Error(DEAD_OBJECT);
+        }
+        const InputMessage& msg = msgs[count];
+        if (!msg.isValid(msgLength)) {
+            ALOGE("channel '%s' ~ received invalid message of size %zu", name.c_str(), msgLength);
+            return android::base::Error(BAD_VALUE);
+        }
+        ALOGD_IF(DEBUG_CHANNEL_MESSAGES, "channel '%s' ~ received message of type %s",
+                 name.c_str(), ftl::enum_string(msg.header.type).c_str());
+        if (ATRACE_ENABLED()) {
+            // Add an additional trace point to include data about the received message.
+            std::string message =
+                    StringPrintf("receiveMessage(inputChannel=%s, seq=0x%" PRIx32 ", type=%s)",
+                                 name.c_str(), msg.header.seq,
+                                 ftl::enum_string(msg.header.type).c_str());
+            ATRACE_NAME(message.c_str());
+        }
+    }
+    msgs.resize(count);
+    return msgs;
+}
+
 bool InputChannel::probablyHasInput() const {
     struct pollfd pfds = {.fd = fd.get(), .events = POLLIN};
     if (::poll(&pfds, /*nfds=*/1, /*timeout=*/0) <= 0) {
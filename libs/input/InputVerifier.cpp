@@ -31,12 +31,39 @@ namespace android {
 // --- InputVerifier ---
 
 InputVerifier::InputVerifier(const std::string& name)
-      : mVerifier(android::input::verifier::create(rust::String::lossy(name))){};
+      : mVerifier(android::input::verifier::create(rust::String::lossy(name))),
+        // Matches the tag that the rust verifier checks to log every event.
+        mShouldLog(android::base::ShouldLog(android::base::LogSeverity::DEBUG,
+                                            "InputVerifierLogEvents")){};
+
+bool InputVerifier::isRepeatOfLastMove(DeviceId deviceId, int32_t source, int32_t action,
+                                       uint32_t pointerCount,
+                                       const PointerProperties* pointerProperties,
+                                       int32_t flags) const {
+    if (!mLastMove || mLastMove->deviceId != deviceId || mLastMove->source != source ||
+        mLastMove->action != action || mLastMove->flags != flags ||
+        mLastMove->pointerCount != pointerCount) {
+        return false;
+    }
+    for (size_t i = 0; i < pointerCount; i++) {
+        if (mLastMove->pointerIds[i] != pointerProperties[i].id) {
+            return false;
+        }
+    }
+    return true;
+}
 
 Result<void> InputVerifier::processMovement(DeviceId deviceId, int32_t source, int32_t action,
                                             uint32_t pointerCount,
                                             const PointerProperties* pointerProperties,
                                             const PointerCoords* pointerCoords, int32_t flags) {
+    const bool isMove =
+            action == AMOTION_EVENT_ACTION_MOVE || action == AMOTION_EVENT_ACTION_HOVER_MOVE;
+    if (isMove && !mShouldLog &&
+        isRepeatOfLastMove(deviceId, source, action, pointerCount, pointerProperties, flags)) {
+        return {};
+    }
+
     std::vector<RustPointerProperties> rpp;
     for (size_t i = 0; i < pointerCount; i++) {
         rpp.emplace_back(RustPointerProperties{.id = pointerProperties[i].id});
@@ -46,13 +73,27 @@ Result<void> InputVerifier::processMovement(DeviceId deviceId, int32_t source, i
             android::input::verifier::process_movement(*mVerifier, deviceId, source, action,
                                                        properties, static_cast<uint32_t>(flags));
     if (errorMessage.empty()) {
+        if (isMove && pointerCount <= MAX_POINTERS) {
+            mLastMove = Move{.deviceId = deviceId,
+                             .source = source,
+                             .action = action,
+                             .flags = flags,
+                             .pointerCount = pointerCount};
+            for (size_t i = 0; i < pointerCount; i++) {
+                mLastMove->pointerIds[i] = pointerProperties[i].id;
+            }
+        } else {
+            mLastMove.reset();
+        }
         return {};
     } else {
+        mLastMove.reset();
         return Error() << errorMessage;
     }
 }
 
 void InputVerifier::resetDevice(DeviceId deviceId) {
+    mLastMove.reset();
     android::input::verifier::reset_device(*mVerifier, deviceId);
 }
 
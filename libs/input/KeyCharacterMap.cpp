@@ -31,6 +31,8 @@
 #include <utils/Timers.h>
 #include <utils/Tokenizer.h>
 
+#include "ParsedFileCache.h"
+
 // Enables debug output for the parser.
 #define DEBUG_PARSER 0
 
@@ -86,6 +88,17 @@ KeyCharacterMap::KeyCharacterMap(const std::string& filename) : mLoadFileName(fi
 
 base::Result<std::shared_ptr<KeyCharacterMap>> KeyCharacterMap::load(const std::string& filename,
                                                                      Format format) {
+    // Maps can be combined with overlays and remapped after loading, so callers get a copy of the
+    // cached map, which still avoids parsing the file again.
+    static auto& sCache = *new ParsedFileCache<const KeyCharacterMap>();
+    const std::string cacheKey = filename + ":" + std::to_string(static_cast<int>(format));
+    const std::optional<FileVersion> version = FileVersion::of(filename);
+    if (version) {
+        if (std::shared_ptr<const KeyCharacterMap> map = sCache.find(cacheKey, *version)) {
+            return std::make_shared<KeyCharacterMap>(*map);
+        }
+    }
+
     Tokenizer* tokenizer;
     status_t status = Tokenizer::open(String8(filename.c_str()), &tokenizer);
     if (status) {
@@ -100,6 +113,9 @@ base::Result<std::shared_ptr<KeyCharacterMap>> KeyCharacterMap::load(const std::
     std::unique_ptr<Tokenizer> t(tokenizer);
     status = map->load(t.get(), format);
     if (status == OK) {
+        if (version) {
+            sCache.insert(cacheKey, *version, std::make_shared<const KeyCharacterMap>(*map));
+        }
         return map;
     }
     return Errorf("Load KeyCharacterMap failed {}.", status);
@@ -34,6 +34,8 @@
 #include <string_view>
 #include <unordered_map>
 
+#include "ParsedFileCache.h"
+
 /**
  * Log debug output for the parser.
  * Enable this via "adb shell setprop log.tag.KeyLayoutMapParser DEBUG" (requires restart)
@@ -137,6 +139,16 @@ base::Result<std::shared_ptr<KeyLayoutMap>> KeyLayoutMap::loadContents(const std
 
 base::Result<std::shared_ptr<KeyLayoutMap>> KeyLayoutMap::load(const std::string& filename,
                                                                const char* contents) {
+    // Maps are immutable, so every device with the same layout file can share the same one.
+    static auto& sCache = *new ParsedFileCache<KeyLayoutMap>();
+    const std::optional<FileVersion> version =
+            contents == nullptr ? FileVersion::of(filename) : std::nullopt;
+    if (version) {
+        if (std::shared_ptr<KeyLayoutMap> map = sCache.find(filename, *version)) {
+            return map;
+        }
+    }
+
     Tokenizer* tokenizer;
     status_t status;
     if (contents == nullptr) {
@@ -160,6 +172,9 @@ base::Result<std::shared_ptr<KeyLayoutMap>> KeyLayoutMap::load(const std::string
         return Errorf("Missing kernel config");
     }
     map->mLoadFileName = filename;
+    if (version) {
+        sCache.insert(filename, *version, map);
+    }
     return ret;
 }
 
@@ -0,0 +1,92 @@
+/*
+ * Copyright 2024 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include <android-base/thread_annotations.h>
+#include <sys/stat.h>
+
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <string>
+#include <unordered_map>
+
+namespace android {
+
+/**
+ * Identifies the contents of a file on disk, so that a file that was replaced or modified since it
+ * was last read can be told apart.
+ */
+struct FileVersion {
+    dev_t device;
+    ino_t inode;
+    off_t size;
+    struct timespec modificationTime;
+
+    static std::optional<FileVersion> of(const std::string& path) {
+        struct stat st;
+        if (stat(path.c_str(), &st) != 0) {
+            return std::nullopt;
+        }
+#if defined(__APPLE__)
+        const struct timespec& mtime = st.st_mtimespec;
+#else
+        const struct timespec& mtime = st.st_mtim;
+#endif
+        return FileVersion{st.st_dev, st.st_ino, st.st_size, mtime};
+    }
+
+    bool operator==(const FileVersion& other) const {
+        return device == other.device && inode == other.inode && size == other.size &&
+                modificationTime.tv_sec == other.modificationTime.tv_sec &&
+                modificationTime.tv_nsec == other.modificationTime.tv_nsec;
+    }
+};
+
+/**
+ * Process-wide cache of objects parsed from configuration files, so that the files are only parsed
+ * again when they change on disk, e.g. when the same keyboard is reconnected.
+ */
+template <typename T>
+class ParsedFileCache {
+public:
+    // Returns the object cached for the key, if it was parsed from the given version of its file.
+    std::shared_ptr<T> find(const std::string& key, const FileVersion& version) const {
+        std::scoped_lock lock(mLock);
+        const auto it = mEntries.find(key);
+        if (it == mEntries.end() || !(it->second.version == version)) {
+            return nullptr;
+        }
+        return it->second.object;
+    }
+
+    void insert(const std::string& key, const FileVersion& version, std::shared_ptr<T> object) {
+        std::scoped_lock lock(mLock);
+        mEntries.insert_or_assign(key, Entry{version, std::move(object)});
+    }
+
+private:
+    struct Entry {
+        FileVersion version;
+        std::shared_ptr<T> object;
+    };
+
+    mutable std::mutex mLock;
+    std::unordered_map<std::string, Entry> mEntries GUARDED_BY(mLock);
+};
+
+} // namespace android
@@ -17,6 +17,7 @@
 #define LOG_TAG "LegacyResampler"
 
 #include <algorithm>
+#include <bitset>
 #include <chrono>
 
 #include <android-base/logging.h>
@@ -57,6 +58,20 @@ constexpr std::chrono::milliseconds RESAMPLE_MAX_DELTA{20};
 
 constexpr std::chrono::milliseconds RESAMPLE_MAX_PREDICTION{8};
 
+// PredictiveResampler never projects the pointers more than a frame at 60Hz past the latest
+// sample.
+constexpr std::chrono::milliseconds PREDICTION_MAX_HORIZON{16};
+
+// Variance of the position reported by the touch sensor, in px^2.
+constexpr float MEASUREMENT_VARIANCE = 1.0f;
+
+// Spectral density of the acceleration of the pointers, in px^2/s^3. Larger values let the filter
+// follow the changes of direction faster, at the cost of less smoothing.
+constexpr float ACCELERATION_NOISE = 1E6f;
+
+// Variance of the velocity of a pointer that was just put down, in (px/s)^2.
+constexpr float INITIAL_VELOCITY_VARIANCE = 1E8f;
+
 bool canResampleTool(ToolType toolType) {
     return toolType == ToolType::FINGER || toolType == ToolType::MOUSE ||
             toolType == ToolType::STYLUS || toolType == ToolType::UNKNOWN;
@@ -75,6 +90,9 @@ PointerCoords calculateResampledCoords(const PointerCoords& a, const PointerCoor
     resampledCoords.setAxisValue(AMOTION_EVENT_AXIS_Y, lerp(a.getY(), b.getY(), alpha));
     return resampledCoords;
 }
+float toSeconds(nanoseconds duration) {
+    return std::chrono::duration<float>(duration).count();
+}
 } // namespace
 
 void LegacyResampler::updateLatestSamples(const MotionEvent& motionEvent) {
@@ -263,4 +281,152 @@ void LegacyResampler::resampleMotionEvent(nanoseconds frameTime, MotionEvent& mo
         addSampleToMotionEvent(*sample, motionEvent);
     }
 }
+
+// --- PredictiveResampler ---
+
+void PredictiveResampler::AxisFilter::reset(float measuredPosition) {
+    position = measuredPosition;
+    velocity = 0;
+    positionVariance = MEASUREMENT_VARIANCE;
+    covariance = 0;
+    velocityVariance = INITIAL_VELOCITY_VARIANCE;
+}
+
+void PredictiveResampler::AxisFilter::update(float dt, float measuredPosition) {
+    // Project the state to the time of the measurement.
+    const float predictedPosition = predict(dt);
+    const float dt2 = dt * dt;
+    const float predictedPositionVariance = positionVariance + 2 * dt * covariance +
+            dt2 * velocityVariance + ACCELERATION_NOISE * dt2 * dt / 3;
+    const float predictedCovariance =
+            covariance + dt * velocityVariance + ACCELERATION_NOISE * dt2 / 2;
+    const float predictedVelocityVariance = velocityVariance + ACCELERATION_NOISE * dt;
+
+    // Correct it with the measurement, weighted by the confidence in each of them.
+    const float innovationVariance = predictedPositionVariance + MEASUREMENT_VARIANCE;
+    const float positionGain = predictedPositionVariance / innovationVariance;
+    const float velocityGain = predictedCovariance / innovationVariance;
+    const float innovation = measuredPosition - predictedPosition;
+    position = predictedPosition + positionGain * innovation;
+    velocity += velocityGain * innovation;
+    positionVariance = (1 - positionGain) * predictedPositionVariance;
+    covariance = (1 - positionGain) * predictedCovariance;
+    velocityVariance = predictedVelocityVariance - velocityGain * predictedCovariance;
+}
+
+float PredictiveResampler::AxisFilter::predict(float dt) const {
+    return position + velocity * dt;
+}
+
+void PredictiveResampler::updateFilters(const MotionEvent& motionEvent) {
+    const size_t numSamples = motionEvent.getHistorySize() + 1;
+    const size_t numPointers = motionEvent.getPointerCount();
+    for (size_t sampleIndex = 0; sampleIndex < numSamples; ++sampleIndex) {
+        const nanoseconds eventTime{motionEvent.getHistoricalEventTime(sampleIndex)};
+        if (eventTime <= mLatestSampleTime) {
+            continue;
+        }
+        mLatestSampleTime = eventTime;
+        for (size_t pointerIndex = 0; pointerIndex < numPointers; ++pointerIndex) {
+            const PointerProperties& properties = *motionEvent.getPointerProperties(pointerIndex);
+            const PointerCoords& coords =
+                    motionEvent.getSamplePointerCoords()[sampleIndex * numPointers + pointerIndex];
+            std::optional<PointerFilter>& filter = mFilters[properties.id];
+            // A long gap between the samples is most likely a new gesture, which should not be
+            // predicted from the movement of the previous one.
+            if (!filter || filter->toolType != properties.toolType ||
+                eventTime - filter->lastEventTime > RESAMPLE_MAX_DELTA) {
+                filter = PointerFilter{.toolType = properties.toolType};
+                filter->x.reset(coords.getX());
+                filter->y.reset(coords.getY());
+            } else {
+                const float dt = toSeconds(eventTime - filter->lastEventTime);
+                filter->x.update(dt, coords.getX());
+                filter->y.update(dt, coords.getY());
+            }
+            filter->lastEventTime = eventTime;
+            filter->sampleCount++;
+        }
+    }
+
+    std::bitset<MAX_POINTER_ID + 1> presentPointerIds;
+    for (size_t pointerIndex = 0; pointerIndex < numPointers; ++pointerIndex) {
+        presentPointerIds.set(motionEvent.getPointerId(pointerIndex));
+    }
+    for (size_t id = 0; id < mFilters.size(); ++id) {
+        if (!presentPointerIds.test(id)) {
+            mFilters[id].reset();
+        }
+    }
+}
+
+bool PredictiveResampler::canPredict(const MotionEvent& motionEvent) const {
+    for (size_t pointerIndex = 0; pointerIndex < motionEvent.getPointerCount(); ++pointerIndex) {
+        const std::optional<PointerFilter>& filter =
+                mFilters[motionEvent.getPointerId(pointerIndex)];
+        if (!canResampleTool(motionEvent.getToolType(pointerIndex))) {
+            LOG_IF(INFO, debugResampling())
+                    << "Not resampled. Cannot resample "
+                    << ftl::enum_string(motionEvent.getToolType(pointerIndex)) << " ToolType.";
+            return false;
+        }
+        if (!filter || filter->sampleCount < 2) {
+            LOG_IF(INFO, debugResampling()) << "Not resampled. Not enough data.";
+            return false;
+        }
+    }
+    return true;
+}
+
+nanoseconds PredictiveResampler::getResampleLatency() const {
+    return nanoseconds{0};
+}
+
+void PredictiveResampler::setExpectedPresentationTime(nanoseconds presentationTime) {
+    mExpectedPresentationTime = presentationTime;
+}
+
+void PredictiveResampler::resampleMotionEvent(nanoseconds frameTime, MotionEvent& motionEvent,
+                                              const InputMessage* /*futureSample*/) {
+    if (mPreviousDeviceId && *mPreviousDeviceId != motionEvent.getDeviceId()) {
+        mFilters.fill(std::nullopt);
+        mLatestSampleTime = nanoseconds{0};
+    }
+    mPreviousDeviceId = motionEvent.getDeviceId();
+
+    updateFilters(motionEvent);
+    if (!canPredict(motionEvent)) {
+        return;
+    }
+
+    // A presentation time that is earlier than the frame time is left over from a previous frame.
+    nanoseconds resampleTime = (mExpectedPresentationTime && *mExpectedPresentationTime > frameTime)
+            ? *mExpectedPresentationTime
+            : frameTime;
+    const nanoseconds latestEventTime{motionEvent.getEventTime()};
+    if (resampleTime - latestEventTime > PREDICTION_MAX_HORIZON) {
+        LOG_IF(INFO, debugResampling())
+                << "Resample time is too far in the future. Adjusting prediction from "
+                << (resampleTime - latestEventTime) << " to "
+                << nanoseconds{PREDICTION_MAX_HORIZON} << "ns.";
+        resampleTime = latestEventTime + PREDICTION_MAX_HORIZON;
+    }
+    if (resampleTime <= latestEventTime) {
+        LOG_IF(INFO, debugResampling()) << "Not resampled. The latest sample is recent enough.";
+        return;
+    }
+
+    const size_t numPointers = motionEvent.getPointerCount();
+    const PointerCoords* latestCoords =
+            &motionEvent.getSamplePointerCoords()[motionEvent.getHistorySize() * numPointers];
+    std::vector<PointerCoords> resampledCoords(latestCoords, latestCoords + numPointers);
+    for (size_t i = 0; i < numPointers; ++i) {
+        const PointerFilter& filter = *mFilters[motionEvent.getPointerId(i)];
+        const float dt = toSeconds(resampleTime - filter.lastEventTime);
+        resampledCoords[i].isResampled = true;
+        resampledCoords[i].setAxisValue(AMOTION_EVENT_AXIS_X, filter.x.predict(dt));
+        resampledCoords[i].setAxisValue(AMOTION_EVENT_AXIS_Y, filter.y.predict(dt));
+    }
+    motionEvent.addSample(resampleTime.count(), resampledCoords.data(), motionEvent.getId());
+}
 } // namespace android
@@ -26,6 +26,7 @@
 #include <cstddef>
 #include <cstdint>
 #include <memory>
+#include <mutex>
 #include <span>
 #include <type_traits>
 #include <utility>
@@ -252,7 +253,34 @@ void TfLiteMotionPredictorBuffers::pushSample(int64_t timestamp,
     mInputOrientation.pushBack(orientation);
 }
 
+struct TfLiteMotionPredictorModel::SharedModel {
+    std::unique_ptr<android::base::MappedFile> flatBuffer;
+    std::unique_ptr<tflite::ErrorReporter> errorReporter;
+    std::unique_ptr<tflite::FlatBufferModel> model;
+    Config config;
+};
+
 std::unique_ptr<TfLiteMotionPredictorModel> TfLiteMotionPredictorModel::create() {
+    // A FlatBufferModel can be used by several interpreters, so only keep one copy of it for all
+    // the predictors of the process. It is released when the last model using it is destroyed.
+    static std::mutex sLock;
+    static std::weak_ptr<const SharedModel> sSharedModel;
+
+    std::shared_ptr<const SharedModel> sharedModel;
+    {
+        std::scoped_lock lock(sLock);
+        sharedModel = sSharedModel.lock();
+        if (!sharedModel) {
+            sharedModel = loadSharedModel();
+            sSharedModel = sharedModel;
+        }
+    }
+    return std::unique_ptr<TfLiteMotionPredictorModel>(
+            new TfLiteMotionPredictorModel(std::move(sharedModel)));
+}
+
+std::shared_ptr<const TfLiteMotionPredictorModel::SharedModel>
+TfLiteMotionPredictorModel::loadSharedModel() {
     const std::string modelPath = getModelPath();
     android::base::unique_fd fd(open(modelPath.c_str(), O_RDONLY));
     if (fd == -1) {
@@ -286,23 +314,23 @@ std::unique_ptr<TfLiteMotionPredictorModel> TfLiteMotionPredictorModel::create()
             .jerkAlpha = parseXMLFloat(*configRoot, "jerk-alpha"),
     };
 
-    return std::unique_ptr<TfLiteMotionPredictorModel>(
-            new TfLiteMotionPredictorModel(std::move(modelBuffer), std::move(config)));
+    auto sharedModel = std::make_shared<SharedModel>();
+    sharedModel->flatBuffer = std::move(modelBuffer);
+    sharedModel->errorReporter = std::make_unique<LoggingErrorReporter>();
+    sharedModel->model =
+            tflite::FlatBufferModel::VerifyAndBuildFromBuffer(sharedModel->flatBuffer->data(),
+                                                              sharedModel->flatBuffer->size(),
+                                                              /*extra_verifier=*/nullptr,
+                                                              sharedModel->errorReporter.get());
+    LOG_ALWAYS_FATAL_IF(!sharedModel->model);
+    sharedModel->config = std::move(config);
+    return sharedModel;
 }
 
-TfLiteMotionPredictorModel::TfLiteMotionPredictorModel(
-        std::unique_ptr<android::base::MappedFile> model, Config config)
-      : mFlatBuffer(std::move(model)), mConfig(std::move(config)) {
-    CHECK(mFlatBuffer);
-    mErrorReporter = std::make_unique<LoggingErrorReporter>();
-    mModel = tflite::FlatBufferModel::VerifyAndBuildFromBuffer(mFlatBuffer->data(),
-                                                               mFlatBuffer->size(),
-                                                               /*extra_verifier=*/nullptr,
-                                                               mErrorReporter.get());
-    LOG_ALWAYS_FATAL_IF(!mModel);
-
+TfLiteMotionPredictorModel::TfLiteMotionPredictorModel(std::shared_ptr<const SharedModel> model)
+      : mSharedModel(std::move(model)), mConfig(mSharedModel->config) {
     auto resolver = createOpResolver();
-    tflite::InterpreterBuilder builder(*mModel, *resolver);
+    tflite::InterpreterBuilder builder(*mSharedModel->model, *resolver);
 
     if (builder(&mInterpreter) != kTfLiteOk || !mInterpreter) {
         LOG_ALWAYS_FATAL("Failed to build interpreter");
@@ -206,6 +206,9 @@ std::unique_ptr<VelocityTrackerStrategy> VelocityTracker::createStrategy(
         case VelocityTracker::Strategy::LEGACY:
             return std::make_unique<LegacyVelocityTrackerStrategy>();
 
+        case VelocityTracker::Strategy::ILSQ2:
+            return std::make_unique<IncrementalLeastSquaresVelocityTrackerStrategy>();
+
         default:
             break;
     }
@@ -756,6 +759,155 @@ float LeastSquaresVelocityTrackerStrategy::chooseWeight(int32_t pointerId, uint3
     }
 }
 
+// --- IncrementalLeastSquaresVelocityTrackerStrategy ---
+
+// The sums of the 4th powers of the times are accumulated, so they are kept in double precision.
+static constexpr double SECONDS_PER_NANO_PRECISE = 1E-9;
+
+IncrementalLeastSquaresVelocityTrackerStrategy::IncrementalLeastSquaresVelocityTrackerStrategy() {}
+
+IncrementalLeastSquaresVelocityTrackerStrategy::~IncrementalLeastSquaresVelocityTrackerStrategy() {}
+
+nsecs_t IncrementalLeastSquaresVelocityTrackerStrategy::History::eventTimeAt(size_t index) const {
+    return eventTimes[(start + index) % HISTORY_SIZE];
+}
+
+void IncrementalLeastSquaresVelocityTrackerStrategy::clearPointer(int32_t pointerId) {
+    mPointerIdBits.clearBit(pointerId);
+}
+
+void IncrementalLeastSquaresVelocityTrackerStrategy::accumulate(History& history,
+                                                                nsecs_t eventTime, float position,
+                                                                double sign) {
+    const double t = (eventTime - history.origin) * SECONDS_PER_NANO_PRECISE;
+    double tk = sign;
+    for (size_t k = 0; k < history.timeSums.size(); k++) {
+        history.timeSums[k] += tk;
+        if (k < history.timePositionSums.size()) {
+            history.timePositionSums[k] += tk * position;
+        }
+        tk *= t;
+    }
+}
+
+void IncrementalLeastSquaresVelocityTrackerStrategy::popFront(History& history) {
+    accumulate(history, history.eventTimes[history.start], history.positions[history.start],
+               /*sign=*/-1);
+    history.start = (history.start + 1) % HISTORY_SIZE;
+    history.size--;
+}
+
+void IncrementalLeastSquaresVelocityTrackerStrategy::popBack(History& history) {
+    const size_t index = (history.start + history.size - 1) % HISTORY_SIZE;
+    accumulate(history, history.eventTimes[index], history.positions[index], /*sign=*/-1);
+    history.size--;
+}
+
+/**
+ * Recompute the sums relative to the oldest sample. Removing samples from the sums accumulates
+ * rounding errors, and the sums lose precision when the samples are far from the origin, so this
+ * is done once the origin has fallen out of the horizon. That happens at most once per horizon, so
+ * the cost is amortized over the samples.
+ */
+void IncrementalLeastSquaresVelocityTrackerStrategy::rebase(History& history) {
+    history.origin = history.size > 0 ? history.eventTimeAt(0) : 0;
+    history.timeSums.fill(0);
+    history.timePositionSums.fill(0);
+    for (size_t i = 0; i < history.size; i++) {
+        const size_t index = (history.start + i) % HISTORY_SIZE;
+        accumulate(history, history.eventTimes[index], history.positions[index], /*sign=*/1);
+    }
+}
+
+void IncrementalLeastSquaresVelocityTrackerStrategy::addMovement(nsecs_t eventTime,
+                                                                 int32_t pointerId,
+                                                                 float position) {
+    History& history = mHistories[pointerId];
+    if (!mPointerIdBits.hasBit(pointerId)) {
+        mPointerIdBits.markBit(pointerId);
+        history.start = 0;
+        history.size = 0;
+        history.origin = eventTime;
+        history.timeSums.fill(0);
+        history.timePositionSums.fill(0);
+    }
+
+    if (history.size != 0 && history.eventTimeAt(history.size - 1) == eventTime) {
+        // Same as in AccumulatingVelocityTrackerStrategy: a movement with the same event time
+        // replaces the previous one.
+        popBack(history);
+    }
+    if (history.size == HISTORY_SIZE) {
+        popFront(history);
+    }
+
+    const size_t index = (history.start + history.size) % HISTORY_SIZE;
+    history.eventTimes[index] = eventTime;
+    history.positions[index] = position;
+    history.size++;
+    accumulate(history, eventTime, position, /*sign=*/1);
+
+    // Clear movements that do not fall within the horizon of the latest movement.
+    while (eventTime - history.eventTimeAt(0) > HORIZON) {
+        popFront(history);
+    }
+    if (history.eventTimeAt(0) - history.origin > HORIZON) {
+        rebase(history);
+    }
+}
+
+std::optional<float> IncrementalLeastSquaresVelocityTrackerStrategy::getVelocity(
+        int32_t pointerId) const {
+    if (!mPointerIdBits.hasBit(pointerId)) {
+        return std::nullopt; // no data
+    }
+    const History& history = mHistories[pointerId];
+    if (history.size < 2) {
+        return std::nullopt;
+    }
+
+    // Shift the sums so that the time is measured relative to the latest movement, like in
+    // solveUnweightedLeastSquaresDeg2, using the binomial expansion of (t - d)^k.
+    const double d =
+            (history.eventTimeAt(history.size - 1) - history.origin) * SECONDS_PER_NANO_PRECISE;
+    const std::array<double, 5>& s = history.timeSums;
+    const std::array<double, 3>& sy = history.timePositionSums;
+    const double count = history.size;
+    const double d2 = d * d;
+    const double d3 = d2 * d;
+    const double d4 = d3 * d;
+    const double sxi = s[1] - d * s[0];
+    const double sxi2 = s[2] - 2 * d * s[1] + d2 * s[0];
+    const double syi = sy[0];
+    const double sxiyi = sy[1] - d * sy[0];
+
+    const double Sxx = sxi2 - sxi * sxi / count;
+    const double Sxy = sxiyi - sxi * syi / count;
+    if (history.size == 2) {
+        // Not enough samples for a second-order fit, so fall back to a straight line, like the
+        // LeastSquaresVelocityTrackerStrategy does.
+        if (Sxx == 0) {
+            return std::nullopt;
+        }
+        return Sxy / Sxx;
+    }
+
+    const double sxi3 = s[3] - 3 * d * s[2] + 3 * d2 * s[1] - d3 * s[0];
+    const double sxi4 = s[4] - 4 * d * s[3] + 6 * d2 * s[2] - 4 * d3 * s[1] + d4 * s[0];
+    const double sxi2yi = sy[2] - 2 * d * sy[1] + d2 * sy[0];
+
+    const double Sxx2 = sxi3 - sxi * sxi2 / count;
+    const double Sx2y = sxi2yi - sxi2 * syi / count;
+    const double Sx2x2 = sxi4 - sxi2 * sxi2 / count;
+
+    const double denominator = Sxx * Sx2x2 - Sxx2 * Sxx2;
+    if (denominator == 0) {
+        ALOGW("division by 0 when computing velocity, Sxx=%f, Sx2x2=%f, Sxx2=%f", Sxx, Sx2x2, Sxx2);
+        return std::nullopt;
+    }
+    return (Sxy * Sx2x2 - Sx2y * Sxx2) / denominator;
+}
+
 // --- IntegratingVelocityTrackerStrategy ---
 
 IntegratingVelocityTrackerStrategy::IntegratingVelocityTrackerStrategy(uint32_t degree) :
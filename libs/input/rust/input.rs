@@ -217,6 +217,8 @@ bitflags! {
         /// PRIVATE_FLAG_SUPPORTS_DIRECTIONAL_ORIENTATION
         const PRIVATE_FLAG_SUPPORTS_DIRECTIONAL_ORIENTATION =
                 MotionEventFlag::PRIVATE_FLAG_SUPPORTS_DIRECTIONAL_ORIENTATION.0 as u32;
+        /// PRIVATE_FLAG_UNBATCHED
+        const PRIVATE_FLAG_UNBATCHED = MotionEventFlag::PRIVATE_FLAG_UNBATCHED.0 as u32;
         /// FLAG_IS_ACCESSIBILITY_EVENT
         const IS_ACCESSIBILITY_EVENT = MotionEventFlag::IS_ACCESSIBILITY_EVENT.0 as u32;
         /// FLAG_TAINTED
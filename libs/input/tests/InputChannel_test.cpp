@@ -193,6 +193,45 @@ TEST_F(InputChannelTest, SendSignal_WhenPeerClosed_ReturnsAnError) {
             << "sendMessage should have returned DEAD_OBJECT";
 }
 
+TEST_F(InputChannelTest, SendAndReceiveMessages_InBatches) {
+    std::unique_ptr<InputChannel> serverChannel, clientChannel;
+    status_t result =
+            InputChannel::openInputChannelPair("channel name", serverChannel, clientChannel);
+    ASSERT_EQ(OK, result) << "should have successfully opened a channel pair";
+
+    std::vector<InputMessage> serverMsgs(5);
+    std::vector<const InputMessage*> serverMsgPtrs;
+    for (size_t i = 0; i < serverMsgs.size(); i++) {
+        serverMsgs[i].header.type = InputMessage::Type::FOCUS;
+        serverMsgs[i].header.seq = i + 1;
+        serverMsgs[i].body.focus.hasFocus = i % 2 == 0;
+        serverMsgPtrs.push_back(&serverMsgs[i]);
+    }
+    size_t sentCount;
+    EXPECT_EQ(OK, serverChannel->sendMessages(serverMsgPtrs, sentCount));
+    EXPECT_EQ(serverMsgs.size(), sentCount);
+
+    // Messages are received in order, up to the requested count.
+    android::base::Result<std::vector<InputMessage>> clientMsgs = clientChannel->receiveMessages(3);
+    ASSERT_TRUE(clientMsgs.ok());
+    ASSERT_EQ(3u, clientMsgs->size());
+    clientMsgs = clientChannel->receiveMessages(3);
+    ASSERT_TRUE(clientMsgs.ok());
+    ASSERT_EQ(2u, clientMsgs->size());
+    EXPECT_EQ(4u, (*clientMsgs)[0].header.seq);
+    EXPECT_EQ(5u, (*clientMsgs)[1].header.seq);
+    EXPECT_TRUE((*clientMsgs)[1].body.focus.hasFocus);
+
+    clientMsgs = clientChannel->receiveMessages(3);
+    EXPECT_EQ(WOULD_BLOCK, clientMsgs.error().code())
+            << "receiveMessages should have returned WOULD_BLOCK";
+
+    serverChannel.reset(); // close server channel
+    clientMsgs = clientChannel->receiveMessages(3);
+    EXPECT_EQ(DEAD_OBJECT, clientMsgs.error().code())
+            << "receiveMessages should have returned DEAD_OBJECT";
+}
+
 TEST_F(InputChannelTest, SendAndReceive_MotionClassification) {
     std::unique_ptr<InputChannel> serverChannel, clientChannel;
     status_t result = InputChannel::openInputChannelPair("channel name",
@@ -244,4 +244,38 @@ TEST_F(InputConsumerTest, BatchedEventsMultiDeviceConsumption) {
     mClientTestChannel->assertFinishMessage(/*seq=*/2, /*handled=*/true);
     mClientTestChannel->assertFinishMessage(/*seq=*/3, /*handled=*/true);
 }
+
+TEST_F(InputConsumerTest, UnbatchedMoveIsDeliveredImmediately) {
+    mClientTestChannel->enqueueMessage(InputMessageBuilder{InputMessage::Type::MOTION, /*seq=*/0}
+                                               .eventTime(nanoseconds{0ms}.count())
+                                               .action(AMOTION_EVENT_ACTION_DOWN)
+                                               .flags(AMOTION_EVENT_PRIVATE_FLAG_UNBATCHED)
+                                               .build());
+    mClientTestChannel->enqueueMessage(InputMessageBuilder{InputMessage::Type::MOTION, /*seq=*/1}
+                                               .eventTime(nanoseconds{5ms}.count())
+                                               .action(AMOTION_EVENT_ACTION_MOVE)
+                                               .flags(AMOTION_EVENT_PRIVATE_FLAG_UNBATCHED)
+                                               .build());
+    mClientTestChannel->enqueueMessage(InputMessageBuilder{InputMessage::Type::MOTION, /*seq=*/2}
+                                               .eventTime(nanoseconds{10ms}.count())
+                                               .action(AMOTION_EVENT_ACTION_MOVE)
+                                               .flags(AMOTION_EVENT_PRIVATE_FLAG_UNBATCHED)
+                                               .build());
+
+    invokeLooperCallback();
+
+    // Every sample is delivered on its own, without waiting for the next frame.
+    assertReceivedMotionEvent(WithMotionAction(AMOTION_EVENT_ACTION_DOWN));
+    std::unique_ptr<MotionEvent> firstMove = mMotionEvents.pop();
+    ASSERT_NE(firstMove, nullptr);
+    EXPECT_EQ(firstMove->getHistorySize(), 0UL);
+    std::unique_ptr<MotionEvent> secondMove = mMotionEvents.pop();
+    ASSERT_NE(secondMove, nullptr);
+    EXPECT_EQ(secondMove->getHistorySize(), 0UL);
+    EXPECT_FALSE(mConsumer->probablyHasInput());
+
+    mClientTestChannel->assertFinishMessage(/*seq=*/0, /*handled=*/true);
+    mClientTestChannel->assertFinishMessage(/*seq=*/1, /*handled=*/true);
+    mClientTestChannel->assertFinishMessage(/*seq=*/2, /*handled=*/true);
+}
 } // namespace android
@@ -153,6 +153,32 @@ TEST_F(InputDeviceKeyMapTest, keyCharacterMapApplyOverlayTest) {
     ASSERT_NE(mapKeyResult, OK) << "Mapping exists for KEY_E for " << frenchOverlayPath;
 }
 
+TEST_F(InputDeviceKeyMapTest, reloadedKeyLayoutMapIsShared) {
+    base::Result<std::shared_ptr<KeyLayoutMap>> ret = KeyLayoutMap::load(mKeyMap.keyLayoutFile);
+    ASSERT_TRUE(ret.ok()) << "Cannot load KeyLayout at " << mKeyMap.keyLayoutFile;
+    ASSERT_EQ(mKeyMap.keyLayoutMap, *ret);
+}
+
+TEST_F(InputDeviceKeyMapTest, reloadedKeyCharacterMapIsNotOverlaid) {
+    std::string frenchOverlayPath = base::GetExecutableDirectory() + "/data/french.kcm";
+    base::Result<std::shared_ptr<KeyCharacterMap>> frenchOverlay =
+            KeyCharacterMap::load(frenchOverlayPath, KeyCharacterMap::Format::OVERLAY);
+    ASSERT_TRUE(frenchOverlay.ok()) << "Cannot load KeyCharacterMap at " << frenchOverlayPath;
+
+    // Apply the French overlay to the map loaded first
+    mKeyMap.keyCharacterMap->combine(*frenchOverlay->get());
+
+    base::Result<std::shared_ptr<KeyCharacterMap>> ret =
+            KeyCharacterMap::load(mKeyMap.keyCharacterMapFile, KeyCharacterMap::Format::BASE);
+    ASSERT_TRUE(ret.ok()) << "Cannot load KeyCharacterMap at " << mKeyMap.keyCharacterMapFile;
+    ASSERT_NE(mKeyMap.keyCharacterMap, *ret);
+    ASSERT_NE(*mKeyMap.keyCharacterMap, *ret->get());
+
+    // Removing the overlay reloads the base map from its file
+    mKeyMap.keyCharacterMap->clearLayoutOverlay();
+    ASSERT_EQ(*mKeyMap.keyCharacterMap, *ret->get());
+}
+
 TEST_F(InputDeviceKeyMapTest, keyCharacterMapBadAxisLabel) {
     std::string klPath = base::GetExecutableDirectory() + "/data/bad_axis_label.kl";
 
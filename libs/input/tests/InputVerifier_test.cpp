@@ -51,4 +51,40 @@ TEST(InputVerifierTest, ProcessSourceClassPointer) {
     ASSERT_TRUE(result.ok());
 }
 
+TEST(InputVerifierTest, RepeatedMovesAreVerifiedAgainstCurrentPointers) {
+    InputVerifier verifier("Verify repeated moves");
+
+    std::vector<PointerProperties> properties;
+    properties.push_back({});
+    properties.back().clear();
+    properties.back().id = 0;
+    properties.back().toolType = ToolType::FINGER;
+
+    std::vector<PointerCoords> coords;
+    coords.push_back({});
+    coords.back().clear();
+
+    const auto process = [&](int32_t action) {
+        return verifier.processMovement(/*deviceId=*/0, AINPUT_SOURCE_TOUCHSCREEN, action,
+                                        /*pointerCount=*/properties.size(), properties.data(),
+                                        coords.data(), /*flags=*/0);
+    };
+
+    ASSERT_TRUE(process(AMOTION_EVENT_ACTION_DOWN).ok());
+    ASSERT_TRUE(process(AMOTION_EVENT_ACTION_MOVE).ok());
+    ASSERT_TRUE(process(AMOTION_EVENT_ACTION_MOVE).ok());
+
+    // A move with a pointer that is not down is still rejected after accepted moves.
+    properties.back().id = 1;
+    ASSERT_FALSE(process(AMOTION_EVENT_ACTION_MOVE).ok());
+
+    // Once the gesture ends, a repeat of its move is rejected.
+    verifier.resetDevice(/*deviceId=*/0);
+    properties.back().id = 0;
+    ASSERT_TRUE(process(AMOTION_EVENT_ACTION_DOWN).ok());
+    ASSERT_TRUE(process(AMOTION_EVENT_ACTION_MOVE).ok());
+    ASSERT_TRUE(process(AMOTION_EVENT_ACTION_UP).ok());
+    ASSERT_FALSE(process(AMOTION_EVENT_ACTION_MOVE).ok());
+}
+
 } // namespace android
@@ -870,4 +870,110 @@ TEST_F(ResamplerTest, MultiplePointerShouldNotResampleToolTypeExtrapolation) {
 
     assertMotionEventIsNotResampled(originalMotionEvent, motionEvent);
 }
+
+/**
+ * Same setup as ResamplerTest, with the PredictiveResampler. The samples move at a constant velocity
+ * of 1 pixel per millisecond, so the filter converges after a few samples and the predicted
+ * position is close to the linear extrapolation. The predicted positions are not exact, so they are
+ * compared with a larger tolerance.
+ */
+class PredictiveResamplerTest : public ResamplerTest {
+protected:
+    static constexpr float PREDICTION_TOLERANCE = 0.05f;
+
+    PredictiveResamplerTest() { mResampler = std::make_unique<PredictiveResampler>(); }
+
+    /**
+     * Creates a MOVE of a single pointer, with samples every 5ms from 5ms to lastSampleTime.
+     */
+    static MotionEvent createConstantVelocityMove(std::chrono::milliseconds lastSampleTime,
+                                                  DeviceId deviceId = 0) {
+        std::vector<InputSample> samples;
+        for (std::chrono::milliseconds time = 5ms; time <= lastSampleTime; time += 5ms) {
+            const float position = time.count();
+            samples.push_back(InputSample{time, {{.id = 0, .x = position, .y = 2 * position}}});
+        }
+        return InputStream{samples, AMOTION_EVENT_ACTION_MOVE, deviceId};
+    }
+
+    void assertMotionEventIsPredictedAt(const MotionEvent& original, const MotionEvent& resampled,
+                                        std::chrono::milliseconds expectedTime) {
+        assertMotionEventMetaDataDidNotMutate(original, resampled);
+        ASSERT_EQ(original.getHistorySize() + 1, resampled.getHistorySize());
+        EXPECT_EQ(std::chrono::nanoseconds{expectedTime}.count(), resampled.getEventTime());
+        const PointerCoords& coords =
+                resampled.getSamplePointerCoords()[resampled.getHistorySize()];
+        EXPECT_TRUE(coords.isResampled);
+        EXPECT_NEAR(expectedTime.count(), coords.getX(), PREDICTION_TOLERANCE);
+        EXPECT_NEAR(2 * expectedTime.count(), coords.getY(), PREDICTION_TOLERANCE);
+    }
+};
+
+TEST_F(PredictiveResamplerTest, NotEnoughDataToPredict) {
+    MotionEvent motionEvent = createConstantVelocityMove(5ms);
+    const MotionEvent originalMotionEvent = motionEvent;
+
+    mResampler->resampleMotionEvent(16ms, motionEvent, /*futureSample=*/nullptr);
+
+    assertMotionEventIsNotResampled(originalMotionEvent, motionEvent);
+}
+
+TEST_F(PredictiveResamplerTest, HasNoResampleLatency) {
+    EXPECT_EQ(std::chrono::nanoseconds{0}, mResampler->getResampleLatency());
+}
+
+TEST_F(PredictiveResamplerTest, PredictsToFrameTimeWithoutPresentationTime) {
+    MotionEvent motionEvent = createConstantVelocityMove(50ms);
+    const MotionEvent originalMotionEvent = motionEvent;
+
+    mResampler->resampleMotionEvent(53ms, motionEvent, /*futureSample=*/nullptr);
+
+    assertMotionEventIsPredictedAt(originalMotionEvent, motionEvent, 53ms);
+}
+
+TEST_F(PredictiveResamplerTest, PredictsToExpectedPresentationTime) {
+    MotionEvent motionEvent = createConstantVelocityMove(50ms);
+    const MotionEvent originalMotionEvent = motionEvent;
+
+    mResampler->setExpectedPresentationTime(60ms);
+    mResampler->resampleMotionEvent(53ms, motionEvent, /*futureSample=*/nullptr);
+
+    assertMotionEventIsPredictedAt(originalMotionEvent, motionEvent, 60ms);
+}
+
+TEST_F(PredictiveResamplerTest, StalePresentationTimeIsIgnored) {
+    MotionEvent motionEvent = createConstantVelocityMove(50ms);
+    const MotionEvent originalMotionEvent = motionEvent;
+
+    mResampler->setExpectedPresentationTime(40ms);
+    mResampler->resampleMotionEvent(53ms, motionEvent, /*futureSample=*/nullptr);
+
+    assertMotionEventIsPredictedAt(originalMotionEvent, motionEvent, 53ms);
+}
+
+TEST_F(PredictiveResamplerTest, PredictionIsLimitedToOneFrame) {
+    MotionEvent motionEvent = createConstantVelocityMove(50ms);
+    const MotionEvent originalMotionEvent = motionEvent;
+
+    mResampler->setExpectedPresentationTime(100ms);
+    mResampler->resampleMotionEvent(53ms, motionEvent, /*futureSample=*/nullptr);
+
+    assertMotionEventIsPredictedAt(originalMotionEvent, motionEvent, 66ms);
+}
+
+TEST_F(PredictiveResamplerTest, DeviceChangeResetsTheFilters) {
+    MotionEvent motionFromFirstDevice = createConstantVelocityMove(50ms, /*deviceId=*/0);
+    mResampler->resampleMotionEvent(53ms, motionFromFirstDevice, /*futureSample=*/nullptr);
+
+    MotionEvent motionFromSecondDevice =
+            InputStream{{InputSample{55ms, {{.id = 0, .x = 1.0f, .y = 1.0f}}}},
+                        AMOTION_EVENT_ACTION_MOVE,
+                        .deviceId = 1};
+    const MotionEvent originalMotionEvent = motionFromSecondDevice;
+
+    mResampler->resampleMotionEvent(58ms, motionFromSecondDevice, /*futureSample=*/nullptr);
+
+    assertMotionEventIsNotResampled(originalMotionEvent, motionFromSecondDevice);
+}
+
 } // namespace android
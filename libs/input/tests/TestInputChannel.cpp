@@ -73,6 +73,26 @@ base::Result<InputMessage> TestInputChannel::receiveMessage() {
     return message;
 }
 
+status_t TestInputChannel::sendMessages(std::span<const InputMessage* const> messages,
+                                        size_t& outSentCount) {
+    for (outSentCount = 0; outSentCount < messages.size(); outSentCount++) {
+        sendMessage(messages[outSentCount]);
+    }
+    return OK;
+}
+
+base::Result<std::vector<InputMessage>> TestInputChannel::receiveMessages(size_t maxCount) {
+    if (mReceivedMessages.empty()) {
+        return base::Error(WOULD_BLOCK);
+    }
+    std::vector<InputMessage> messages;
+    while (!mReceivedMessages.empty() && messages.size() < maxCount) {
+        messages.push_back(mReceivedMessages.front());
+        mReceivedMessages.pop();
+    }
+    return messages;
+}
+
 bool TestInputChannel::probablyHasInput() const {
     return !mReceivedMessages.empty();
 }
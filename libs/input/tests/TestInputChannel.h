@@ -18,6 +18,7 @@
 
 #include <queue>
 #include <string>
+#include <vector>
 
 #include <android-base/result.h>
 #include <gtest/gtest.h>
@@ -48,6 +49,17 @@ public:
      */
     base::Result<InputMessage> receiveMessage() override;
 
+    /**
+     * Pushes messages to mSentMessages, see sendMessage.
+     */
+    status_t sendMessages(std::span<const InputMessage* const> messages,
+                          size_t& outSentCount) override;
+
+    /**
+     * Returns up to maxCount InputMessages from mReceivedMessages, see receiveMessage.
+     */
+    base::Result<std::vector<InputMessage>> receiveMessages(size_t maxCount) override;
+
     /**
      * Returns if mReceivedMessages is not empty.
      */
@@ -20,6 +20,7 @@
 #include <ios>
 #include <iterator>
 #include <string>
+#include <vector>
 
 #include <gmock/gmock.h>
 #include <gtest/gtest.h>
@@ -165,5 +166,31 @@ TEST(TfLiteMotionPredictorTest, ModelOutput) {
             std::all_of(model->outputPressure().begin(), model->outputPressure().end(), is_valid));
 }
 
+TEST(TfLiteMotionPredictorTest, ModelsSharingWeights_AreIndependent) {
+    std::unique_ptr<TfLiteMotionPredictorModel> model1 = TfLiteMotionPredictorModel::create();
+    std::unique_ptr<TfLiteMotionPredictorModel> model2 = TfLiteMotionPredictorModel::create();
+    TfLiteMotionPredictorBuffers buffers1(model1->inputLength());
+    TfLiteMotionPredictorBuffers buffers2(model2->inputLength());
+
+    buffers1.pushSample(/*timestamp=*/1, {.position = {.x = 100, .y = 200}, .pressure = 0.2});
+    buffers1.pushSample(/*timestamp=*/2, {.position = {.x = 150, .y = 250}, .pressure = 0.4});
+    buffers1.pushSample(/*timestamp=*/3, {.position = {.x = 180, .y = 280}, .pressure = 0.6});
+    buffers2.pushSample(/*timestamp=*/1, {.position = {.x = 100, .y = 200}, .pressure = 0.2});
+    buffers2.pushSample(/*timestamp=*/2, {.position = {.x = 100, .y = 250}, .pressure = 0.4});
+    buffers2.pushSample(/*timestamp=*/3, {.position = {.x = 100, .y = 320}, .pressure = 0.6});
+    buffers1.copyTo(*model1);
+    ASSERT_TRUE(model1->invoke());
+    const std::vector<float> output1(model1->outputR().begin(), model1->outputR().end());
+
+    // Invoking the second model must not affect the results of the first one.
+    buffers2.copyTo(*model2);
+    ASSERT_TRUE(model2->invoke());
+    EXPECT_EQ(output1, std::vector<float>(model1->outputR().begin(), model1->outputR().end()));
+
+    // Destroying one of the models doesn't invalidate the other.
+    model1.reset();
+    ASSERT_TRUE(model2->invoke());
+}
+
 } // namespace
 } // namespace android
@@ -0,0 +1,85 @@
+/*
+ * Copyright (C) 2024 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <benchmark/benchmark.h>
+
+#include <math.h>
+
+#include <input/Input.h>
+#include <input/VelocityTracker.h>
+
+namespace android {
+
+namespace {
+
+// A touch screen reporting at 240Hz.
+constexpr nsecs_t SAMPLE_INTERVAL = 4'166'667;
+constexpr int32_t POINTER_ID = 0;
+// The trajectory is x(t) = AMPLITUDE * sin(FREQUENCY * t), in pixels, with t in seconds.
+constexpr double AMPLITUDE = 500;
+constexpr double FREQUENCY = 2 * M_PI;
+
+double getPosition(nsecs_t eventTime) {
+    return AMPLITUDE * sin(FREQUENCY * eventTime * 1E-9);
+}
+
+double getExpectedVelocity(nsecs_t eventTime) {
+    return AMPLITUDE * FREQUENCY * cos(FREQUENCY * eventTime * 1E-9);
+}
+
+/**
+ * Adds one sample and queries the velocity, like a view does for every move event. The mean
+ * absolute difference from the velocity of the trajectory is reported, to compare the accuracy of
+ * the strategies as well as their cost.
+ */
+void benchmarkAddAndQuery(benchmark::State& state, VelocityTracker::Strategy strategy) {
+    VelocityTracker tracker(strategy);
+    nsecs_t eventTime = 0;
+    double totalError = 0;
+    size_t queries = 0;
+    for (auto _ : state) {
+        eventTime += SAMPLE_INTERVAL;
+        tracker.addMovement(eventTime, POINTER_ID, AMOTION_EVENT_AXIS_X, getPosition(eventTime));
+        const std::optional<float> velocity =
+                tracker.getVelocity(AMOTION_EVENT_AXIS_X, POINTER_ID);
+        benchmark::DoNotOptimize(velocity);
+        if (velocity) {
+            totalError += fabs(*velocity - getExpectedVelocity(eventTime));
+            queries++;
+        }
+    }
+    state.counters["error_px_per_s"] = queries > 0 ? totalError / queries : 0;
+}
+
+void BM_VelocityTracker_LSQ2(benchmark::State& state) {
+    benchmarkAddAndQuery(state, VelocityTracker::Strategy::LSQ2);
+}
+
+void BM_VelocityTracker_ILSQ2(benchmark::State& state) {
+    benchmarkAddAndQuery(state, VelocityTracker::Strategy::ILSQ2);
+}
+
+void BM_VelocityTracker_IMPULSE(benchmark::State& state) {
+    benchmarkAddAndQuery(state, VelocityTracker::Strategy::IMPULSE);
+}
+
+} // namespace
+
+BENCHMARK(BM_VelocityTracker_LSQ2);
+BENCHMARK(BM_VelocityTracker_ILSQ2);
+BENCHMARK(BM_VelocityTracker_IMPULSE);
+
+} // namespace android
@@ -252,6 +252,12 @@ static void computeAndCheckVelocity(const VelocityTracker::Strategy strategy,
                                     int32_t axis, std::optional<float> targetVelocity,
                                     uint32_t pointerId = DEFAULT_POINTER_ID) {
     checkVelocity(computePlanarVelocity(strategy, motions, axis, pointerId), targetVelocity);
+    if (strategy == VelocityTracker::Strategy::LSQ2) {
+        // The incremental implementation should produce the same fit as LSQ2.
+        checkVelocity(computePlanarVelocity(VelocityTracker::Strategy::ILSQ2, motions, axis,
+                                            pointerId),
+                      targetVelocity);
+    }
 }
 
 static void computeAndCheckAxisScrollVelocity(
@@ -280,6 +286,12 @@ static void computeAndCheckQuadraticVelocity(const std::vector<PlanarMotionEvent
 
     EXPECT_NEAR_BY_FRACTION(*velocityX, velocity, QUADRATIC_VELOCITY_TOLERANCE);
     EXPECT_NEAR_BY_FRACTION(*velocityY, velocity, QUADRATIC_VELOCITY_TOLERANCE);
+
+    std::optional<float> incrementalVelocityX =
+            computePlanarVelocity(VelocityTracker::Strategy::ILSQ2, motions, AMOTION_EVENT_AXIS_X,
+                                  DEFAULT_POINTER_ID);
+    ASSERT_TRUE(incrementalVelocityX);
+    EXPECT_NEAR_BY_FRACTION(*incrementalVelocityX, velocity, QUADRATIC_VELOCITY_TOLERANCE);
 }
 
 /*
@@ -457,6 +469,47 @@ TEST_F(VelocityTrackerTest, TestApiInteractionsWithNoMotionEvents) {
     vt.clear();
 }
 
+/**
+ * The incremental strategy evicts the old samples from its sums rather than refitting them, so
+ * feed it a long stream that goes well past the horizon and the history size, and make sure that
+ * it stays in agreement with LSQ2.
+ */
+TEST_F(VelocityTrackerTest, IncrementalLsq2MatchesLsq2OnLongStreams) {
+    VelocityTracker lsq2(VelocityTracker::Strategy::LSQ2);
+    VelocityTracker ilsq2(VelocityTracker::Strategy::ILSQ2);
+    // Start far from 0, like real event times, to exercise the precision of the sums.
+    nsecs_t eventTime = 1000 * 1'000'000'000LL;
+    for (size_t i = 0; i < 500; i++) {
+        // Samples at about 240Hz, with some jitter, along a curved path.
+        eventTime += 4'000'000 + (i % 3) * 500'000;
+        const float position = 300 * sinf(i * 0.05f) + 0.01f * i * i;
+        lsq2.addMovement(eventTime, DEFAULT_POINTER_ID, AMOTION_EVENT_AXIS_X, position);
+        ilsq2.addMovement(eventTime, DEFAULT_POINTER_ID, AMOTION_EVENT_AXIS_X, position);
+        const std::optional<float> expected =
+                lsq2.getVelocity(AMOTION_EVENT_AXIS_X, DEFAULT_POINTER_ID);
+        const std::optional<float> actual =
+                ilsq2.getVelocity(AMOTION_EVENT_AXIS_X, DEFAULT_POINTER_ID);
+        ASSERT_EQ(expected.has_value(), actual.has_value()) << "at sample " << i;
+        if (expected) {
+            // LSQ2 is computed in single precision, so allow for its rounding errors, in
+            // particular when the velocity is close to 0.
+            EXPECT_NEAR(*actual, *expected, 0.01f * fabsf(*expected) + 1) << "at sample " << i;
+        }
+    }
+}
+
+TEST_F(VelocityTrackerTest, IncrementalLsq2NeedsTwoSamples) {
+    VelocityTracker vt(VelocityTracker::Strategy::ILSQ2);
+    vt.addMovement(nsecs_t(10'000'000), DEFAULT_POINTER_ID, AMOTION_EVENT_AXIS_X, 100);
+    EXPECT_FALSE(vt.getVelocity(AMOTION_EVENT_AXIS_X, DEFAULT_POINTER_ID));
+
+    vt.addMovement(nsecs_t(20'000'000), DEFAULT_POINTER_ID, AMOTION_EVENT_AXIS_X, 110);
+    checkVelocity(vt.getVelocity(AMOTION_EVENT_AXIS_X, DEFAULT_POINTER_ID), 1000);
+
+    vt.clearPointer(DEFAULT_POINTER_ID);
+    EXPECT_FALSE(vt.getVelocity(AMOTION_EVENT_AXIS_X, DEFAULT_POINTER_ID));
+}
+
 TEST_F(VelocityTrackerTest, ThreePointsPositiveVelocityTest) {
     // Same coordinate is reported 2 times in a row
     // It is difficult to determine the correct answer here, but at least the direction
@@ -26,6 +26,7 @@
 #include <stdexcept>
 
 #include <math/quat.h>
+#include <math/TSimdHelpers.h>
 #include <math/TVecHelpers.h>
 
 #include  <utils/String8.h>
@@ -233,6 +234,13 @@ CONSTEXPR MATRIX PURE fastInverse3(const MATRIX& x) {
 template <typename MATRIX>
 inline constexpr MATRIX PURE inverse(const MATRIX& matrix) {
     static_assert(MATRIX::NUM_ROWS == MATRIX::NUM_COLS, "only square matrices can be inverted");
+#if MATH_SIMD
+    if constexpr (simd::isFloat4x4<MATRIX>()) {
+        MATRIX inverted(MATRIX::NO_INIT);
+        simd::inverse4x4(&matrix[0][0], &inverted[0][0]);
+        return inverted;
+    }
+#endif
     return (MATRIX::NUM_ROWS == 2) ? fastInverse2<MATRIX>(matrix) :
           ((MATRIX::NUM_ROWS == 3) ? fastInverse3<MATRIX>(matrix) :
                     gaussJordanInverse<MATRIX>(matrix));
@@ -253,6 +261,15 @@ CONSTEXPR MATRIX_R PURE multiply(const MATRIX_A& lhs, const MATRIX_B& rhs) {
             "invalid dimension of matrix multiply result.");
 
     MATRIX_R res(MATRIX_R::NO_INIT);
+#if MATH_SIMD
+    if constexpr (simd::isFloat4x4<MATRIX_R>() && simd::isFloat4x4<MATRIX_A>() &&
+                  simd::isFloat4x4<MATRIX_B>()) {
+        if (!__builtin_is_constant_evaluated()) {
+            simd::multiply4x4(&lhs[0][0], &rhs[0][0], &res[0][0]);
+            return res;
+        }
+    }
+#endif
     for (size_t col = 0; col < MATRIX_R::NUM_COLS; ++col) {
         res[col] = lhs * rhs[col];
     }
@@ -0,0 +1,231 @@
+/*
+ * Copyright 2024 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include <stddef.h>
+
+#include <type_traits>
+
+/*
+ * No user serviceable parts here.
+ *
+ * Don't use this file directly, instead include math/mat4.h
+ */
+
+/*
+ * MATH_SIMD is 1 when the float 4x4 matrix operations below are used in place
+ * of the generic templates. They need NEON or SSE, and `if constexpr` so that
+ * they are only instantiated for float matrices.
+ */
+#if __cplusplus >= 201703L && (defined(__ARM_NEON) || defined(__SSE__)) && defined(__has_builtin)
+#if __has_builtin(__builtin_shufflevector) && __has_builtin(__builtin_is_constant_evaluated)
+#define MATH_SIMD 1
+#endif
+#endif
+
+#ifndef MATH_SIMD
+#define MATH_SIMD 0
+#endif
+
+#if MATH_SIMD
+
+#if defined(__ARM_NEON)
+#include <arm_neon.h>
+#else
+#include <xmmintrin.h>
+#endif
+
+namespace android {
+namespace details {
+namespace simd {
+// -------------------------------------------------------------------------------------
+
+#if defined(__ARM_NEON)
+typedef float32x4_t vfloat4;
+
+inline vfloat4 load(const float* p)         { return vld1q_f32(p); }
+inline void store(float* p, vfloat4 v)      { vst1q_f32(p, v); }
+inline vfloat4 splat(float f)               { return vdupq_n_f32(f); }
+inline float first(vfloat4 v)               { return vgetq_lane_f32(v, 0); }
+inline vfloat4 add(vfloat4 a, vfloat4 b)    { return vaddq_f32(a, b); }
+inline vfloat4 sub(vfloat4 a, vfloat4 b)    { return vsubq_f32(a, b); }
+inline vfloat4 mul(vfloat4 a, vfloat4 b)    { return vmulq_f32(a, b); }
+#else
+typedef __m128 vfloat4;
+
+inline vfloat4 load(const float* p)         { return _mm_loadu_ps(p); }
+inline void store(float* p, vfloat4 v)      { _mm_storeu_ps(p, v); }
+inline vfloat4 splat(float f)               { return _mm_set1_ps(f); }
+inline float first(vfloat4 v)               { return _mm_cvtss_f32(v); }
+inline vfloat4 add(vfloat4 a, vfloat4 b)    { return _mm_add_ps(a, b); }
+inline vfloat4 sub(vfloat4 a, vfloat4 b)    { return _mm_sub_ps(a, b); }
+inline vfloat4 mul(vfloat4 a, vfloat4 b)    { return _mm_mul_ps(a, b); }
+#endif
+
+// { a[X], a[Y], b[Z], b[W] }
+template <int X, int Y, int Z, int W>
+inline vfloat4 shuffle(vfloat4 a, vfloat4 b) {
+    return __builtin_shufflevector(a, b, X, Y, Z + 4, W + 4);
+}
+
+// { v[X], v[Y], v[Z], v[W] }
+template <int X, int Y, int Z, int W>
+inline vfloat4 swizzle(vfloat4 v) {
+    return __builtin_shufflevector(v, v, X, Y, Z, W);
+}
+
+template <int I>
+inline vfloat4 lane(vfloat4 v) {
+    return swizzle<I, I, I, I>(v);
+}
+
+// Whether the generic matrix templates can use the functions below for MATRIX.
+template <typename MATRIX>
+constexpr bool isFloat4x4() {
+    return std::is_same<typename MATRIX::value_type, float>::value &&
+            MATRIX::NUM_ROWS == 4 && MATRIX::NUM_COLS == 4;
+}
+
+// Returns the column-major 4x4 matrix with columns c0 to c3, multiplied by v.
+inline vfloat4 transform(vfloat4 c0, vfloat4 c1, vfloat4 c2, vfloat4 c3, vfloat4 v) {
+    return add(add(mul(c0, lane<0>(v)), mul(c1, lane<1>(v))),
+               add(mul(c2, lane<2>(v)), mul(c3, lane<3>(v))));
+}
+
+/*
+ * The functions below operate on arrays of floats, in the column-major layout
+ * of TMat44<float> and TVec4<float>. The output may alias the inputs.
+ */
+
+// out = m * v
+inline void transform4(const float* m, const float* v, float* out) {
+    store(out, transform(load(m), load(m + 4), load(m + 8), load(m + 12), load(v)));
+}
+
+// out[i] = m * in[i], for count vectors.
+inline void transform4(const float* m, const float* in, float* out, size_t count) {
+    const vfloat4 c0 = load(m);
+    const vfloat4 c1 = load(m + 4);
+    const vfloat4 c2 = load(m + 8);
+    const vfloat4 c3 = load(m + 12);
+    for (size_t i = 0; i < count; ++i) {
+        store(out + 4 * i, transform(c0, c1, c2, c3, load(in + 4 * i)));
+    }
+}
+
+// out = lhs * rhs
+inline void multiply4x4(const float* lhs, const float* rhs, float* out) {
+    const vfloat4 c0 = load(lhs);
+    const vfloat4 c1 = load(lhs + 4);
+    const vfloat4 c2 = load(lhs + 8);
+    const vfloat4 c3 = load(lhs + 12);
+    for (size_t col = 0; col < 4; ++col) {
+        store(out + 4 * col, transform(c0, c1, c2, c3, load(rhs + 4 * col)));
+    }
+}
+
+// 2x2 matrices below are packed in a vector as { m00, m01, m10, m11 }.
+
+// a * b
+inline vfloat4 mat2Mul(vfloat4 a, vfloat4 b) {
+    return add(mul(a, swizzle<0, 3, 0, 3>(b)),
+               mul(swizzle<1, 0, 3, 2>(a), swizzle<2, 1, 2, 1>(b)));
+}
+
+// adjugate(a) * b
+inline vfloat4 mat2AdjMul(vfloat4 a, vfloat4 b) {
+    return sub(mul(swizzle<3, 3, 0, 0>(a), b),
+               mul(swizzle<1, 1, 2, 2>(a), swizzle<2, 3, 0, 1>(b)));
+}
+
+// a * adjugate(b)
+inline vfloat4 mat2MulAdj(vfloat4 a, vfloat4 b) {
+    return sub(mul(a, swizzle<3, 0, 3, 0>(b)),
+               mul(swizzle<1, 0, 3, 2>(a), swizzle<2, 1, 2, 1>(b)));
+}
+
+/*
+ * out = inverse(m)
+ *
+ * The matrix is split in 2x2 blocks
+ *
+ * | A B |
+ * | C D |
+ *
+ * and inverted blockwise from their adjugates and determinants, without
+ * pivoting. Since inverse(transpose(m)) = transpose(inverse(m)), the blocks of
+ * the transpose can be taken directly from the columns.
+ *
+ * @warning As for the generic inverse, the result is undefined if the matrix is
+ * singular.
+ */
+inline void inverse4x4(const float* m, float* out) {
+    const vfloat4 c0 = load(m);
+    const vfloat4 c1 = load(m + 4);
+    const vfloat4 c2 = load(m + 8);
+    const vfloat4 c3 = load(m + 12);
+
+    const vfloat4 A = shuffle<0, 1, 0, 1>(c0, c1);
+    const vfloat4 B = shuffle<2, 3, 2, 3>(c0, c1);
+    const vfloat4 C = shuffle<0, 1, 0, 1>(c2, c3);
+    const vfloat4 D = shuffle<2, 3, 2, 3>(c2, c3);
+
+    // { |A|, |B|, |C|, |D| }
+    const vfloat4 dets = sub(mul(shuffle<0, 2, 0, 2>(c0, c2), shuffle<1, 3, 1, 3>(c1, c3)),
+                             mul(shuffle<1, 3, 1, 3>(c0, c2), shuffle<0, 2, 0, 2>(c1, c3)));
+    const vfloat4 detA = lane<0>(dets);
+    const vfloat4 detB = lane<1>(dets);
+    const vfloat4 detC = lane<2>(dets);
+    const vfloat4 detD = lane<3>(dets);
+
+    const vfloat4 adjD_C = mat2AdjMul(D, C);
+    const vfloat4 adjA_B = mat2AdjMul(A, B);
+
+    // The inverse is | X Y | / |M|, with the adjugates of its blocks being:
+    //                | Z W |
+    const vfloat4 adjX = sub(mul(detD, A), mat2Mul(B, adjD_C));
+    const vfloat4 adjW = sub(mul(detA, D), mat2Mul(C, adjA_B));
+    const vfloat4 adjY = sub(mul(detB, C), mat2MulAdj(D, adjA_B));
+    const vfloat4 adjZ = sub(mul(detC, B), mat2MulAdj(A, adjD_C));
+
+    // |M| = |A| |D| + |B| |C| - trace(adjugate(A) B adjugate(D) C)
+    vfloat4 trace = mul(adjA_B, swizzle<0, 2, 1, 3>(adjD_C));
+    trace = add(trace, swizzle<1, 0, 3, 2>(trace));
+    trace = add(trace, swizzle<2, 3, 0, 1>(trace));
+    const float det = first(sub(add(mul(detA, detD), mul(detB, detC)), trace));
+
+    // Taking the adjugates back flips the sign of their anti-diagonals.
+    static const float kAdjugateSigns[4] = { 1, -1, -1, 1 };
+    const vfloat4 scale = mul(load(kAdjugateSigns), splat(1 / det));
+
+    const vfloat4 X = mul(adjX, scale);
+    const vfloat4 Y = mul(adjY, scale);
+    const vfloat4 Z = mul(adjZ, scale);
+    const vfloat4 W = mul(adjW, scale);
+
+    store(out,      shuffle<3, 1, 3, 1>(X, Y));
+    store(out + 4,  shuffle<2, 0, 2, 0>(X, Y));
+    store(out + 8,  shuffle<3, 1, 3, 1>(Z, W));
+    store(out + 12, shuffle<2, 0, 2, 0>(Z, W));
+}
+
+// -------------------------------------------------------------------------------------
+}  // namespace simd
+}  // namespace details
+}  // namespace android
+
+#endif  // MATH_SIMD
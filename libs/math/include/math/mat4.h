@@ -530,6 +530,15 @@ CONSTEXPR TMat44<T> TMat44<T>::lookAt(const TVec3<A>& eye, const TVec3<B>& cente
 // matrix * column-vector, result is a vector of the same type than the input vector
 template <typename T, typename U>
 CONSTEXPR typename TMat44<T>::col_type PURE operator *(const TMat44<T>& lhs, const TVec4<U>& rhs) {
+#if MATH_SIMD
+    if constexpr (std::is_same<T, float>::value && std::is_same<U, float>::value) {
+        if (!__builtin_is_constant_evaluated()) {
+            typename TMat44<T>::col_type result(TMat44<T>::col_type::NO_INIT);
+            simd::transform4(lhs.asArray(), &rhs[0], &result[0]);
+            return result;
+        }
+    }
+#endif
     // Result is initialized to zero.
     typename TMat44<T>::col_type result;
     for (size_t col = 0; col < TMat44<T>::NUM_COLS; ++col) {
@@ -538,6 +547,22 @@ CONSTEXPR typename TMat44<T>::col_type PURE operator *(const TMat44<T>& lhs, con
     return result;
 }
 
+// out[i] = matrix * in[i] for count column-vectors, e.g. to transform a batch of points given
+// as {x, y, z, 1}. out may alias in.
+template <typename T>
+void transform(const TMat44<T>& lhs, const TVec4<T>* in, TVec4<T>* out, size_t count) {
+#if MATH_SIMD
+    if constexpr (std::is_same<T, float>::value) {
+        simd::transform4(lhs.asArray(), reinterpret_cast<const float*>(in),
+                         reinterpret_cast<float*>(out), count);
+        return;
+    }
+#endif
+    for (size_t i = 0; i < count; ++i) {
+        out[i] = lhs * in[i];
+    }
+}
+
 // mat44 * vec3, result is vec3( mat44 * {vec3, 1} )
 template <typename T, typename U>
 CONSTEXPR typename TMat44<T>::col_type PURE operator *(const TMat44<T>& lhs, const TVec3<U>& rhs) {
@@ -0,0 +1,106 @@
+/*
+ * Copyright 2024 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <benchmark/benchmark.h>
+
+#include <math/mat4.h>
+
+#include <random>
+#include <vector>
+
+namespace android {
+namespace {
+
+// Returns an invertible transform, as found in compositing and sensor code.
+template <typename T>
+details::TMat44<T> makeTransform(std::default_random_engine& engine) {
+    std::uniform_real_distribution<T> distribution(0.5, 2.0);
+    auto rand = [&] { return distribution(engine); };
+
+    using M44T = details::TMat44<T>;
+    using V4T = details::TVec4<T>;
+    return M44T::translate(V4T(rand(), rand(), rand(), 1)) *
+            M44T::eulerZYX(rand(), rand(), rand()) * M44T::scale(V4T(rand(), rand(), rand(), 1));
+}
+
+template <typename T>
+void BM_Multiply(benchmark::State& state) {
+    std::default_random_engine engine(1);
+    details::TMat44<T> lhs = makeTransform<T>(engine);
+    const details::TMat44<T> rhs = makeTransform<T>(engine);
+
+    for (auto _ : state) {
+        benchmark::DoNotOptimize(lhs);
+        benchmark::DoNotOptimize(lhs * rhs);
+    }
+}
+
+template <typename T>
+void BM_Inverse(benchmark::State& state) {
+    std::default_random_engine engine(2);
+    details::TMat44<T> m = makeTransform<T>(engine);
+
+    for (auto _ : state) {
+        benchmark::DoNotOptimize(m);
+        benchmark::DoNotOptimize(inverse(m));
+    }
+}
+
+template <typename T>
+void BM_TransformVector(benchmark::State& state) {
+    std::default_random_engine engine(3);
+    const details::TMat44<T> m = makeTransform<T>(engine);
+    details::TVec4<T> v(1, 2, 3, 1);
+
+    for (auto _ : state) {
+        benchmark::DoNotOptimize(v);
+        benchmark::DoNotOptimize(m * v);
+    }
+}
+
+// Transforms the given number of points in a batch.
+template <typename T>
+void BM_TransformPoints(benchmark::State& state) {
+    std::default_random_engine engine(4);
+    const details::TMat44<T> m = makeTransform<T>(engine);
+
+    std::uniform_real_distribution<T> distribution(-100, 100);
+    std::vector<details::TVec4<T>> points(static_cast<size_t>(state.range(0)));
+    for (auto& point : points) {
+        point = details::TVec4<T>(distribution(engine), distribution(engine),
+                                  distribution(engine), 1);
+    }
+    std::vector<details::TVec4<T>> transformed(points.size());
+
+    for (auto _ : state) {
+        transform(m, points.data(), transformed.data(), points.size());
+        benchmark::DoNotOptimize(transformed.data());
+        benchmark::ClobberMemory();
+    }
+    state.SetItemsProcessed(static_cast<int64_t>(state.iterations() * points.size()));
+}
+
+BENCHMARK(BM_Multiply<float>);
+BENCHMARK(BM_Multiply<double>);
+BENCHMARK(BM_Inverse<float>);
+BENCHMARK(BM_Inverse<double>);
+BENCHMARK(BM_TransformVector<float>);
+BENCHMARK(BM_TransformVector<double>);
+BENCHMARK(BM_TransformPoints<float>)->Arg(4)->Arg(64)->Arg(1024);
+BENCHMARK(BM_TransformPoints<double>)->Arg(4)->Arg(64)->Arg(1024);
+
+} // namespace
+} // namespace android
@@ -688,6 +688,97 @@ TYPED_TEST(MatTestT, ToQuaternionPointTransformation44) {
     }
 }
 
+//------------------------------------------------------------------------------
+TYPED_TEST(MatTestT, Multiply4) {
+    typedef ::android::details::TMat44<TypeParam> M44T;
+
+    std::default_random_engine generator(171717);
+    std::uniform_real_distribution<TypeParam> distribution(-10.0, 10.0);
+    auto rand_gen = std::bind(distribution, generator);
+
+    for (size_t i = 0; i < 100; ++i) {
+        M44T a, b;
+        for (size_t col = 0; col < 4; ++col) {
+            for (size_t row = 0; row < 4; ++row) {
+                a[col][row] = rand_gen();
+                b[col][row] = rand_gen();
+            }
+        }
+
+        const M44T ab = a * b;
+        for (size_t col = 0; col < 4; ++col) {
+            for (size_t row = 0; row < 4; ++row) {
+                double expected = 0;
+                for (size_t k = 0; k < 4; ++k) {
+                    expected += double(a[k][row]) * double(b[col][k]);
+                }
+                EXPECT_NEAR(ab[col][row], expected, 1e-4);
+            }
+        }
+
+        M44T c(a);
+        c *= b;
+        EXPECT_EQ(ab, c);
+    }
+}
+
+//------------------------------------------------------------------------------
+TYPED_TEST(MatTestT, Transform4) {
+    typedef ::android::details::TMat44<TypeParam> M44T;
+    typedef ::android::details::TVec4<TypeParam> V4T;
+    typedef ::android::details::TVec3<TypeParam> V3T;
+
+    std::default_random_engine generator(424242);
+    std::uniform_real_distribution<TypeParam> distribution(-10.0, 10.0);
+    auto rand_gen = std::bind(distribution, generator);
+
+    const M44T m = M44T::translate(V4T(rand_gen(), rand_gen(), rand_gen(), 1)) *
+            M44T::eulerZYX(rand_gen(), rand_gen(), rand_gen()) *
+            M44T::scale(V4T(rand_gen(), rand_gen(), rand_gen(), 1));
+
+    V4T points[17];
+    V4T transformed[17];
+    for (V4T& point : points) {
+        point = V4T(rand_gen(), rand_gen(), rand_gen(), 1);
+    }
+
+    transform(m, points, transformed, 17);
+    for (size_t i = 0; i < 17; ++i) {
+        const V4T expected = m[0] * points[i].x + m[1] * points[i].y + m[2] * points[i].z + m[3];
+        for (size_t j = 0; j < 4; ++j) {
+            EXPECT_NEAR(transformed[i][j], expected[j], 1e-4);
+        }
+        EXPECT_EQ(m * points[i], transformed[i]);
+        EXPECT_EQ(m * V3T(points[i].xyz), transformed[i]);
+    }
+
+    // In place.
+    transform(m, points, points, 17);
+    for (size_t i = 0; i < 17; ++i) {
+        EXPECT_EQ(transformed[i], points[i]);
+    }
+}
+
+//------------------------------------------------------------------------------
+TYPED_TEST(MatTestT, InverseTransform4) {
+    typedef ::android::details::TMat44<TypeParam> M44T;
+    typedef ::android::details::TVec4<TypeParam> V4T;
+
+    std::default_random_engine generator(8675309);
+    std::uniform_real_distribution<TypeParam> distribution(0.5, 2.0);
+    auto rand_gen = std::bind(distribution, generator);
+
+    for (size_t i = 0; i < 100; ++i) {
+        const M44T m = M44T::translate(V4T(rand_gen(), rand_gen(), rand_gen(), 1)) *
+                M44T::eulerZYX(rand_gen(), rand_gen(), rand_gen()) *
+                M44T::scale(V4T(rand_gen(), rand_gen(), rand_gen(), 1));
+        TEST_MATRIX_INVERSE(m, 100.0 * std::numeric_limits<TypeParam>::epsilon());
+    }
+
+    M44T perspective = M44T::frustum(-1, 1, -1, 1, 1, 100);
+    TEST_MATRIX_INVERSE(perspective, 100.0 * std::numeric_limits<TypeParam>::epsilon());
+}
+
 #undef TEST_MATRIX_INVERSE
 
 }; // namespace android
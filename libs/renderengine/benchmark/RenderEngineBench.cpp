@@ -274,6 +274,79 @@ void BM_homescreen_blur(benchmark::State& benchState, Args&&... args) {
     benchDrawLayers(*re, layers, benchState, "homescreen_blurred");
 }
 
+/**
+ * Draw a blurred shade over the homescreen. If animated is set, the homescreen scrolls under the
+ * shade in every frame, so its blur is generated each time. Otherwise only the first frame
+ * generates it, and the others reuse it.
+ */
+template <class... Args>
+void BM_blurBackdrop(benchmark::State& benchState, Args&&... args) {
+    auto args_tuple = std::make_tuple(std::move(args)...);
+    auto re = createRenderEngine(static_cast<RenderEngine::Threaded>(std::get<0>(args_tuple)),
+                                 static_cast<RenderEngine::GraphicsApi>(std::get<1>(args_tuple)),
+                                 static_cast<RenderEngine::BlurAlgorithm>(std::get<2>(args_tuple)));
+    const bool animated = std::get<3>(args_tuple);
+
+    auto [width, height] = getDisplaySize();
+    auto srcBuffer = createTexture(*re, kHomescreenPath);
+    auto outputBuffer = allocateBuffer(*re, width, height);
+
+    const Rect displayRect(0, 0, static_cast<int32_t>(width), static_cast<int32_t>(height));
+    DisplaySettings display{
+            .physicalDisplay = displayRect,
+            .clip = displayRect,
+            .maxLuminance = 500,
+    };
+
+    const FloatRect layerRect(0, 0, width, height);
+    LayerSettings layer{
+            .geometry =
+                    Geometry{
+                            .boundaries = layerRect,
+                    },
+            .source =
+                    PixelSource{
+                            .buffer =
+                                    Buffer{
+                                            .buffer = srcBuffer,
+                                    },
+                    },
+            .alpha = half(1.0f),
+    };
+    LayerSettings blurLayer{
+            .geometry =
+                    Geometry{
+                            .boundaries = layerRect,
+                    },
+            .source =
+                    PixelSource{
+                            .solidColor = half3(0.1f),
+                    },
+            .alpha = half(0.5f),
+            .backgroundBlurRadius = 60,
+    };
+    auto layers = std::vector<LayerSettings>{layer, blurLayer};
+
+    // Buffers are only known to be unchanged while they keep the same acquire fence, as with a
+    // wallpaper that is not redrawn, so give the homescreen the fence of a first frame.
+    sp<Fence> fence =
+            re->drawLayers(display, layers, outputBuffer, base::unique_fd()).get().value();
+    fence->waitForever(LOG_TAG);
+    layers[0].source.buffer.fence = fence;
+
+    // This loop starts and stops the timer.
+    float offset = 0.f;
+    for (auto _ : benchState) {
+        if (animated) {
+            offset = offset < 100.f ? offset + 1.f : 0.f;
+            layers[0].geometry.positionTransform = mat4::translate(vec4(0.f, -offset, 0.f, 0.f));
+        }
+        sp<Fence> waitFence =
+                re->drawLayers(display, layers, outputBuffer, base::unique_fd()).get().value();
+        waitFence->waitForever(LOG_TAG);
+    }
+}
+
 template <class... Args>
 void BM_homescreen_edgeExtension(benchmark::State& benchState, Args&&... args) {
     auto args_tuple = std::make_tuple(std::move(args)...);
@@ -309,6 +382,82 @@ void BM_homescreen_edgeExtension(benchmark::State& benchState, Args&&... args) {
     benchDrawLayers(*re, layers, benchState, "homescreen_edge_extension");
 }
 
+/**
+ * Draw a realistic stack of layers: the homescreen wallpaper, a number of partially overlapping
+ * windows and translucent system bars. If occluded is set, a fullscreen opaque app is placed
+ * below the system bars, hiding everything underneath it, as with an app launched over other
+ * apps.
+ */
+template <class... Args>
+void BM_layerStack(benchmark::State& benchState, Args&&... args) {
+    auto args_tuple = std::make_tuple(std::move(args)...);
+    auto re = createRenderEngine(static_cast<RenderEngine::Threaded>(std::get<0>(args_tuple)),
+                                 static_cast<RenderEngine::GraphicsApi>(std::get<1>(args_tuple)));
+    const auto layerCount = static_cast<size_t>(std::get<2>(args_tuple));
+    const bool occluded = std::get<3>(args_tuple);
+
+    auto [width, height] = getDisplaySize();
+    auto srcBuffer = createTexture(*re, kHomescreenPath);
+    const auto makeBufferLayer = [&](const FloatRect& rect, bool isOpaque, float alpha) {
+        return LayerSettings{
+                .geometry =
+                        Geometry{
+                                .boundaries = rect,
+                        },
+                .source =
+                        PixelSource{
+                                .buffer =
+                                        Buffer{
+                                                .buffer = srcBuffer,
+                                                .isOpaque = isOpaque,
+                                        },
+                        },
+                .alpha = half(alpha),
+        };
+    };
+    const auto makeColorLayer = [](const FloatRect& rect, half3 color, float alpha) {
+        return LayerSettings{
+                .geometry =
+                        Geometry{
+                                .boundaries = rect,
+                        },
+                .source =
+                        PixelSource{
+                                .solidColor = color,
+                        },
+                .alpha = half(alpha),
+        };
+    };
+
+    // The system bars and the occluding app are part of the count.
+    constexpr size_t kSystemBarCount = 2;
+    const size_t windowCount = layerCount - kSystemBarCount - (occluded ? 1 : 0) - 1;
+    const float w = static_cast<float>(width);
+    const float h = static_cast<float>(height);
+
+    std::vector<LayerSettings> layers;
+    layers.reserve(layerCount);
+    layers.push_back(makeBufferLayer(FloatRect(0, 0, w, h), /*isOpaque*/ true, 1.0f));
+    for (size_t i = 0; i < windowCount; i++) {
+        // Cascade the windows so that each overlaps the previous ones, alternating between
+        // translucent buffers and opaque dim/scrim colors.
+        const float offset = static_cast<float>(i % 10) * w * 0.05f;
+        const FloatRect rect(offset, offset, offset + w * 0.5f, offset + h * 0.5f);
+        if (i % 2) {
+            layers.push_back(makeColorLayer(rect, half3(0.2f, 0.4f, 0.6f), 0.6f));
+        } else {
+            layers.push_back(makeBufferLayer(rect, /*isOpaque*/ false, 0.9f));
+        }
+    }
+    if (occluded) {
+        layers.push_back(makeBufferLayer(FloatRect(0, 0, w, h), /*isOpaque*/ true, 1.0f));
+    }
+    layers.push_back(makeColorLayer(FloatRect(0, 0, w, h * 0.04f), half3(0.f), 0.3f));
+    layers.push_back(makeColorLayer(FloatRect(0, h * 0.95f, w, h), half3(0.f), 0.3f));
+
+    benchDrawLayers(*re, layers, benchState, occluded ? "layer_stack_occluded" : "layer_stack");
+}
+
 BENCHMARK_CAPTURE(BM_homescreen_blur, gaussian, RenderEngine::Threaded::YES,
                   RenderEngine::GraphicsApi::GL, RenderEngine::BlurAlgorithm::GAUSSIAN);
 
@@ -318,8 +467,28 @@ BENCHMARK_CAPTURE(BM_homescreen_blur, kawase, RenderEngine::Threaded::YES,
 BENCHMARK_CAPTURE(BM_homescreen_blur, kawase_dual_filter, RenderEngine::Threaded::YES,
                   RenderEngine::GraphicsApi::GL, RenderEngine::BlurAlgorithm::KAWASE_DUAL_FILTER);
 
+BENCHMARK_CAPTURE(BM_blurBackdrop, static, RenderEngine::Threaded::YES,
+                  RenderEngine::GraphicsApi::GL, RenderEngine::BlurAlgorithm::KAWASE_DUAL_FILTER,
+                  false);
+
+BENCHMARK_CAPTURE(BM_blurBackdrop, animated, RenderEngine::Threaded::YES,
+                  RenderEngine::GraphicsApi::GL, RenderEngine::BlurAlgorithm::KAWASE_DUAL_FILTER,
+                  true);
+
 BENCHMARK_CAPTURE(BM_homescreen, SkiaGLThreaded, RenderEngine::Threaded::YES,
                   RenderEngine::GraphicsApi::GL);
 
 BENCHMARK_CAPTURE(BM_homescreen_edgeExtension, SkiaGLThreaded, RenderEngine::Threaded::YES,
                   RenderEngine::GraphicsApi::GL);
+
+BENCHMARK_CAPTURE(BM_layerStack, visible10, RenderEngine::Threaded::YES,
+                  RenderEngine::GraphicsApi::GL, 10, false);
+
+BENCHMARK_CAPTURE(BM_layerStack, occluded10, RenderEngine::Threaded::YES,
+                  RenderEngine::GraphicsApi::GL, 10, true);
+
+BENCHMARK_CAPTURE(BM_layerStack, visible30, RenderEngine::Threaded::YES,
+                  RenderEngine::GraphicsApi::GL, 30, false);
+
+BENCHMARK_CAPTURE(BM_layerStack, occluded30, RenderEngine::Threaded::YES,
+                  RenderEngine::GraphicsApi::GL, 30, true);
@@ -105,6 +105,14 @@ struct DisplaySettings {
 
     // For now, meaningful primarily when the TonemappingStrategy is Local
     float targetHdrSdrRatio = 1.f;
+
+    // Region of the output buffer, in buffer coordinates, that needs to be redrawn. The rest of
+    // the buffer is assumed to still hold the result of an earlier identical composition, and is
+    // left untouched. If empty, the entire buffer is redrawn.
+    //
+    // This is not compared by operator==, since it only changes which pixels are drawn and not
+    // what the result looks like.
+    Region damage;
 };
 
 static inline bool operator==(const DisplaySettings& lhs, const DisplaySettings& rhs) {
@@ -161,6 +169,8 @@ static inline void PrintTo(const DisplaySettings& settings, ::std::ostream* os)
         << aidl::android::hardware::graphics::composer3::toString(settings.dimmingStage).c_str();
     *os << "\n    .renderIntent = "
         << aidl::android::hardware::graphics::composer3::toString(settings.renderIntent).c_str();
+    *os << "\n    .damage = ";
+    PrintTo(settings.damage, os);
     *os << "\n}";
 }
 
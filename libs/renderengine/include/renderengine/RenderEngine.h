@@ -49,6 +49,12 @@
  */
 #define PROPERTY_DEBUG_RENDERENGINE_CAPTURE_FILENAME "debug.renderengine.capture_filename"
 
+/**
+ * Path of the file in which to persist the shaders Skia compiles for RenderEngine, so that they
+ * can be loaded back on the next boot. Disabled when empty.
+ */
+#define PROPERTY_DEBUG_RENDERENGINE_SHADER_CACHE_PATH "debug.renderengine.shader_cache_path"
+
 /**
  * Switches the cross-window background blur algorithm.
  */
@@ -664,6 +664,17 @@ void Cache::primeShaderCache(SkiaRenderEngine* renderengine, PrimeCacheConfig co
         ALOGD("%d Shaders already compiled before Cache::primeShaderCache ran\n", previousCount);
     }
 
+    // The persistent cache holds what was compiled on previous boots, which includes both the
+    // shaders synthesized below and those seen in the field, so it supersedes the draws below.
+    const nsecs_t precompileTimeBefore = systemTime();
+    if (const int precompiled = renderengine->precompilePersistedShaders(); precompiled > 0) {
+        const float compileTimeMs =
+                static_cast<float>(systemTime() - precompileTimeBefore) / 1.0E6;
+        ALOGD("Shader cache precompiled %d persisted shaders in %f ms\n", precompiled,
+              compileTimeMs);
+        return;
+    }
+
     // The loop is beneficial for debugging and should otherwise be optimized out by the compiler.
     // Adding additional bounds to the loop is useful for verifying that the size of the dst buffer
     // does not impact the shader compilation counts by triggering different behaviors in RE/Skia.
@@ -0,0 +1,287 @@
+/*
+ * Copyright 2024 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#undef LOG_TAG
+#define LOG_TAG "RenderEngine"
+#define ATRACE_TAG ATRACE_TAG_GRAPHICS
+
+#include "PersistentShaderCache.h"
+
+#include <android-base/file.h>
+#include <android-base/stringprintf.h>
+#include <common/trace.h>
+#include <log/log.h>
+#include <pthread.h>
+
+#include <cerrno>
+#include <cinttypes>
+#include <cstdio>
+#include <cstring>
+#include <string_view>
+
+namespace android::renderengine::skia {
+
+namespace {
+
+constexpr uint32_t kMagic = 0x43534552; // "RESC"
+// Bump when the layout of the file changes.
+constexpr uint32_t kVersion = 1;
+
+void appendU32(std::string& out, uint32_t value) {
+    out.append(reinterpret_cast<const char*>(&value), sizeof(value));
+}
+
+void appendBytes(std::string& out, const void* data, size_t size) {
+    appendU32(out, static_cast<uint32_t>(size));
+    out.append(static_cast<const char*>(data), size);
+}
+
+// FNV-1a, to catch truncated or corrupted files.
+uint32_t checksum(const char* data, size_t size) {
+    uint32_t hash = 2166136261u;
+    for (size_t i = 0; i < size; i++) {
+        hash = (hash ^ static_cast<uint8_t>(data[i])) * 16777619u;
+    }
+    return hash;
+}
+
+class Reader {
+public:
+    Reader(const std::string& contents) : mData(contents.data()), mSize(contents.size()) {}
+
+    bool readU32(uint32_t& value) {
+        if (mSize - mOffset < sizeof(value)) return false;
+        std::memcpy(&value, mData + mOffset, sizeof(value));
+        mOffset += sizeof(value);
+        return true;
+    }
+
+    bool readBytes(const char*& data, uint32_t& size) {
+        if (!readU32(size) || mSize - mOffset < size) return false;
+        data = mData + mOffset;
+        mOffset += size;
+        return true;
+    }
+
+private:
+    const char* const mData;
+    const size_t mSize;
+    size_t mOffset = 0;
+};
+
+} // namespace
+
+PersistentShaderCache::PersistentShaderCache(std::string path, std::string fingerprint,
+                                             size_t maxBytes, std::chrono::milliseconds writeDelay)
+      : mPath(std::move(path)),
+        mFingerprint(std::move(fingerprint)),
+        mMaxBytes(maxBytes),
+        mWriteDelay(writeDelay) {
+    {
+        std::lock_guard lock(mMutex);
+        readFromDisk();
+    }
+    mWriter = std::thread([this] {
+        pthread_setname_np(pthread_self(), "REShaderCache");
+        writerLoop();
+    });
+}
+
+PersistentShaderCache::~PersistentShaderCache() {
+    {
+        std::lock_guard lock(mMutex);
+        mStopping = true;
+    }
+    mCondition.notify_all();
+    mWriter.join();
+    flush();
+}
+
+sk_sp<SkData> PersistentShaderCache::load(const SkData& key) {
+    std::lock_guard lock(mMutex);
+    const auto it = mEntries.find(std::string(static_cast<const char*>(key.data()), key.size()));
+    if (it == mEntries.end()) {
+        mMisses++;
+        return nullptr;
+    }
+    mHits++;
+    return it->second;
+}
+
+void PersistentShaderCache::store(const SkData& key, const SkData& data) {
+    {
+        std::lock_guard lock(mMutex);
+        std::string keyString(static_cast<const char*>(key.data()), key.size());
+        size_t totalBytes = mTotalBytes + keyString.size() + data.size();
+        const auto it = mEntries.find(keyString);
+        if (it != mEntries.end()) {
+            totalBytes -= it->first.size() + it->second->size();
+        }
+        if (totalBytes > mMaxBytes) {
+            mDroppedStores++;
+            return;
+        }
+        mEntries.insert_or_assign(std::move(keyString), SkData::MakeWithCopy(data.data(),
+                                                                             data.size()));
+        mTotalBytes = totalBytes;
+        mDirty = true;
+    }
+    mCondition.notify_all();
+}
+
+void PersistentShaderCache::forEachEntry(
+        const std::function<void(const SkData& key, const SkData& data)>& callback) const {
+    std::lock_guard lock(mMutex);
+    for (const auto& [key, data] : mEntries) {
+        const sk_sp<SkData> keyData = SkData::MakeWithoutCopy(key.data(), key.size());
+        callback(*keyData, *data);
+    }
+}
+
+size_t PersistentShaderCache::getEntryCount() const {
+    std::lock_guard lock(mMutex);
+    return mEntries.size();
+}
+
+bool PersistentShaderCache::flush() {
+    // Serializes writers, so that an older snapshot never replaces a newer one.
+    std::lock_guard writeLock(mWriteMutex);
+    std::string contents;
+    {
+        std::lock_guard lock(mMutex);
+        if (!mDirty) return true;
+        contents = serializeLocked();
+        mDirty = false;
+        mWrites++;
+    }
+    return writeToDisk(contents);
+}
+
+void PersistentShaderCache::dump(std::string& result) const {
+    std::lock_guard lock(mMutex);
+    base::StringAppendF(&result,
+                        "Persistent shader cache %s: %zu entries (%zu loaded), %zu bytes, "
+                        "%" PRIu64 " hits, %" PRIu64 " misses, %" PRIu64 " dropped, %" PRIu64
+                        " writes\n",
+                        mPath.c_str(), mEntries.size(), mLoadedEntries, mTotalBytes, mHits,
+                        mMisses, mDroppedStores, mWrites);
+}
+
+void PersistentShaderCache::readFromDisk() {
+    std::string contents;
+    if (!base::ReadFileToString(mPath, &contents)) {
+        return;
+    }
+    SFTRACE_CALL();
+
+    const auto discard = [&](const char* reason) {
+        ALOGI("Discarding persistent shader cache %s: %s", mPath.c_str(), reason);
+        mEntries.clear();
+        mTotalBytes = 0;
+    };
+
+    if (contents.size() < sizeof(uint32_t)) {
+        return discard("truncated");
+    }
+    const size_t payloadSize = contents.size() - sizeof(uint32_t);
+    uint32_t expectedChecksum;
+    std::memcpy(&expectedChecksum, contents.data() + payloadSize, sizeof(expectedChecksum));
+    if (checksum(contents.data(), payloadSize) != expectedChecksum) {
+        return discard("bad checksum");
+    }
+    contents.resize(payloadSize);
+
+    Reader reader(contents);
+    uint32_t magic, version, count;
+    const char* fingerprint;
+    uint32_t fingerprintSize;
+    if (!reader.readU32(magic) || magic != kMagic || !reader.readU32(version) ||
+        version != kVersion) {
+        return discard("unknown format");
+    }
+    if (!reader.readBytes(fingerprint, fingerprintSize) ||
+        std::string_view(fingerprint, fingerprintSize) != mFingerprint) {
+        return discard("fingerprint changed");
+    }
+    if (!reader.readU32(count)) {
+        return discard("truncated");
+    }
+    for (uint32_t i = 0; i < count; i++) {
+        const char* key;
+        const char* data;
+        uint32_t keySize, dataSize;
+        if (!reader.readBytes(key, keySize) || !reader.readBytes(data, dataSize)) {
+            return discard("truncated");
+        }
+        if (mTotalBytes + keySize + dataSize > mMaxBytes) {
+            break;
+        }
+        mEntries.insert_or_assign(std::string(key, keySize), SkData::MakeWithCopy(data, dataSize));
+        mTotalBytes += keySize + dataSize;
+    }
+    mLoadedEntries = mEntries.size();
+    ALOGD("Loaded %zu entries from persistent shader cache %s", mLoadedEntries, mPath.c_str());
+}
+
+std::string PersistentShaderCache::serializeLocked() const {
+    std::string out;
+    out.reserve(mTotalBytes + mFingerprint.size() + (mEntries.size() * 2 + 5) * sizeof(uint32_t));
+    appendU32(out, kMagic);
+    appendU32(out, kVersion);
+    appendBytes(out, mFingerprint.data(), mFingerprint.size());
+    appendU32(out, static_cast<uint32_t>(mEntries.size()));
+    for (const auto& [key, data] : mEntries) {
+        appendBytes(out, key.data(), key.size());
+        appendBytes(out, data->data(), data->size());
+    }
+    appendU32(out, checksum(out.data(), out.size()));
+    return out;
+}
+
+bool PersistentShaderCache::writeToDisk(const std::string& contents) const {
+    SFTRACE_CALL();
+    // Write to a temporary file first, so that a crash mid-write leaves the previous file intact.
+    const std::string tmpPath = mPath + ".tmp";
+    if (!base::WriteStringToFile(contents, tmpPath)) {
+        ALOGW("Failed to write persistent shader cache %s: %s", tmpPath.c_str(), strerror(errno));
+        return false;
+    }
+    if (std::rename(tmpPath.c_str(), mPath.c_str()) != 0) {
+        ALOGW("Failed to rename persistent shader cache to %s: %s", mPath.c_str(),
+              strerror(errno));
+        std::remove(tmpPath.c_str());
+        return false;
+    }
+    return true;
+}
+
+void PersistentShaderCache::writerLoop() {
+    std::unique_lock lock(mMutex);
+    while (true) {
+        mCondition.wait(lock, [this]() REQUIRES(mMutex) { return mStopping || mDirty; });
+        // Coalesce stores that follow in quick succession. The destructor flushes whatever is
+        // left when stopping.
+        if (mStopping ||
+            mCondition.wait_for(lock, mWriteDelay, [this]() REQUIRES(mMutex) { return mStopping; })) {
+            return;
+        }
+        lock.unlock();
+        flush();
+        lock.lock();
+    }
+}
+
+} // namespace android::renderengine::skia
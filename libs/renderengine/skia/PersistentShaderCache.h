@@ -0,0 +1,103 @@
+/*
+ * Copyright 2024 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include <SkData.h>
+#include <SkRefCnt.h>
+#include <android-base/thread_annotations.h>
+
+#include <chrono>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <unordered_map>
+
+namespace android::renderengine::skia {
+
+/**
+ * On-disk cache of the shaders and pipelines that Skia compiled for RenderEngine.
+ *
+ * Entries are recorded as Skia stores them during normal use, so the file ends up holding exactly
+ * the programs this device draws with. The file is tagged with a fingerprint of the build and GPU
+ * driver, and is discarded when either changes since the cached binaries would be unusable.
+ *
+ * Writes are batched and done on a background thread, so store() never blocks on I/O.
+ */
+class PersistentShaderCache {
+public:
+    // Caps the size of the file. Stores beyond this are dropped.
+    static constexpr size_t kMaxBytes = 4 * 1024 * 1024;
+    // Stores tend to come in bursts, e.g. when a new kind of layer is first drawn, so wait for
+    // them to settle before writing the file.
+    static constexpr std::chrono::milliseconds kWriteDelay = std::chrono::seconds(5);
+
+    // Loads the cache at path, unless it was written with a different fingerprint.
+    PersistentShaderCache(std::string path, std::string fingerprint, size_t maxBytes = kMaxBytes,
+                          std::chrono::milliseconds writeDelay = kWriteDelay);
+    // Writes any pending entries before returning.
+    ~PersistentShaderCache();
+
+    PersistentShaderCache(const PersistentShaderCache&) = delete;
+    PersistentShaderCache& operator=(const PersistentShaderCache&) = delete;
+
+    sk_sp<SkData> load(const SkData& key) EXCLUDES(mMutex);
+    void store(const SkData& key, const SkData& data) EXCLUDES(mMutex);
+
+    // Invokes the callback on every entry, e.g. to precompile them.
+    void forEachEntry(const std::function<void(const SkData& key, const SkData& data)>&) const
+            EXCLUDES(mMutex);
+    size_t getEntryCount() const EXCLUDES(mMutex);
+
+    // Writes pending entries now rather than after the write delay. Returns false on I/O errors.
+    bool flush() EXCLUDES(mWriteMutex, mMutex);
+
+    void dump(std::string& result) const EXCLUDES(mMutex);
+
+private:
+    void readFromDisk() REQUIRES(mMutex);
+    std::string serializeLocked() const REQUIRES(mMutex);
+    bool writeToDisk(const std::string& contents) const;
+    void writerLoop() EXCLUDES(mMutex);
+
+    const std::string mPath;
+    const std::string mFingerprint;
+    const size_t mMaxBytes;
+    const std::chrono::milliseconds mWriteDelay;
+
+    // Acquired before mMutex.
+    std::mutex mWriteMutex;
+    mutable std::mutex mMutex;
+    std::condition_variable mCondition;
+    std::unordered_map<std::string, sk_sp<SkData>> mEntries GUARDED_BY(mMutex);
+    size_t mTotalBytes GUARDED_BY(mMutex) = 0;
+    bool mDirty GUARDED_BY(mMutex) = false;
+    bool mStopping GUARDED_BY(mMutex) = false;
+
+    size_t mLoadedEntries GUARDED_BY(mMutex) = 0;
+    uint64_t mHits GUARDED_BY(mMutex) = 0;
+    uint64_t mMisses GUARDED_BY(mMutex) = 0;
+    uint64_t mDroppedStores GUARDED_BY(mMutex) = 0;
+    uint64_t mWrites GUARDED_BY(mMutex) = 0;
+
+    std::thread mWriter;
+};
+
+} // namespace android::renderengine::skia
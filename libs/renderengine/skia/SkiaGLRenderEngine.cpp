@@ -539,6 +539,12 @@ int SkiaGLRenderEngine::getContextPriority() {
     return value;
 }
 
+std::string SkiaGLRenderEngine::getDriverFingerprint() const {
+    const GLExtensions& extensions = GLExtensions::getInstance();
+    return base::StringPrintf("%s|%s|%s", extensions.getVendor(), extensions.getRenderer(),
+                              extensions.getVersion());
+}
+
 void SkiaGLRenderEngine::appendBackendSpecificInfoToDump(std::string& result) {
     const GLExtensions& extensions = GLExtensions::getInstance();
     StringAppendF(&result, "\n ------------RE GLES------------\n");
@@ -49,12 +49,15 @@
 #include <SkString.h>
 #include <SkSurface.h>
 #include <SkTileMode.h>
+#include <android-base/properties.h>
 #include <android-base/stringprintf.h>
+#include <android/hardware_buffer.h>
 #include <common/FlagManager.h>
 #include <common/trace.h>
 #include <gui/FenceMonitor.h>
 #include <include/gpu/ganesh/GrBackendSemaphore.h>
 #include <include/gpu/ganesh/GrContextOptions.h>
+#include <include/gpu/ganesh/GrDirectContext.h>
 #include <include/gpu/ganesh/GrTypes.h>
 #include <include/gpu/ganesh/SkSurfaceGanesh.h>
 #include <pthread.h>
@@ -65,11 +68,13 @@
 #include <ui/GraphicBuffer.h>
 #include <ui/HdrRenderTypeUtils.h>
 
+#include <algorithm>
 #include <cmath>
 #include <cstdint>
 #include <deque>
 #include <memory>
 #include <numeric>
+#include <span>
 
 #include "Cache.h"
 #include "ColorSpaces.h"
@@ -225,6 +230,50 @@ static inline bool layerHasBlur(const android::renderengine::LayerSettings& laye
     return false;
 }
 
+// Returns true if the pixels of the layer are known to be unchanged for as long as its settings
+// are. Buffers without an acquire fence, or with front buffer usage, may be written in place.
+static inline bool layerContentIsStable(const android::renderengine::LayerSettings& layer) {
+    const auto& buffer = layer.source.buffer;
+    if (!buffer.buffer) {
+        return true;
+    }
+    return buffer.fence != nullptr && buffer.fence != android::Fence::NO_FENCE &&
+            !(buffer.buffer->getUsage() & AHARDWAREBUFFER_USAGE_FRONT_BUFFER);
+}
+
+// Returns true if the layer draws opaque pixels over all of clip, which is in layer stack space,
+// so that nothing underneath it can contribute to the output.
+static inline bool layerOccludesClip(const android::renderengine::LayerSettings& layer,
+                                     const android::Rect& clip, bool colorTransformModifiesAlpha) {
+    if (layer.skipContentDraw || layer.alpha != 1.0f || colorTransformModifiesAlpha) {
+        return false;
+    }
+    if (const auto& buffer = layer.source.buffer.buffer) {
+        // A8 buffers are drawn as a mask, regardless of isOpaque.
+        if (!layer.source.buffer.isOpaque || buffer->getPixelFormat() == PIXEL_FORMAT_R_8) {
+            return false;
+        }
+    }
+    if (layer.colorTransform != android::mat4() || layer.geometry.roundedCornersRadius.x > 0.f ||
+        layer.geometry.roundedCornersRadius.y > 0.f || layer.stretchEffect.hasEffect() ||
+        layer.edgeExtensionEffect.hasEffect()) {
+        return false;
+    }
+
+    // Only handle scales and translations, which map the bounds to another rect.
+    const android::mat4& m = layer.geometry.positionTransform;
+    if (m[0][1] != 0.f || m[1][0] != 0.f || m[0][3] != 0.f || m[1][3] != 0.f || m[3][3] != 1.f) {
+        return false;
+    }
+    const android::FloatRect& b = layer.geometry.boundaries;
+    const float left = m[0][0] * b.left + m[3][0];
+    const float right = m[0][0] * b.right + m[3][0];
+    const float top = m[1][1] * b.top + m[3][1];
+    const float bottom = m[1][1] * b.bottom + m[3][1];
+    return std::min(left, right) <= clip.left && std::max(left, right) >= clip.right &&
+            std::min(top, bottom) <= clip.top && std::max(top, bottom) >= clip.bottom;
+}
+
 static inline SkColor getSkColor(const android::vec4& color) {
     return SkColorSetARGB(color.a * 255, color.r * 255, color.g * 255, color.b * 255);
 }
@@ -263,9 +312,9 @@ std::future<void> SkiaRenderEngine::primeCache(PrimeCacheConfig config) {
 }
 
 sk_sp<SkData> SkiaRenderEngine::SkSLCacheMonitor::load(const SkData& key) {
-    // This "cache" does not actually cache anything. It just allows us to
-    // monitor Skia's internal cache. So this method always returns null.
-    return nullptr;
+    // Unless persisted, this "cache" does not actually cache anything. It just
+    // allows us to monitor Skia's internal cache, so this method returns null.
+    return mPersistentCache ? mPersistentCache->load(key) : nullptr;
 }
 
 void SkiaRenderEngine::SkSLCacheMonitor::store(const SkData& key, const SkData& data,
@@ -273,12 +322,39 @@ void SkiaRenderEngine::SkSLCacheMonitor::store(const SkData& key, const SkData&
     mShadersCachedSinceLastCall++;
     mTotalShadersCompiled++;
     SFTRACE_FORMAT("SF cache: %i shaders", mTotalShadersCompiled);
+    if (mPersistentCache) {
+        mPersistentCache->store(key, data);
+    }
+}
+
+void SkiaRenderEngine::SkSLCacheMonitor::enablePersistentCache(std::string path,
+                                                               std::string fingerprint) {
+    mPersistentCache =
+            std::make_unique<PersistentShaderCache>(std::move(path), std::move(fingerprint));
 }
 
 int SkiaRenderEngine::reportShadersCompiled() {
     return mSkSLCacheMonitor.totalShadersCompiled();
 }
 
+int SkiaRenderEngine::precompilePersistedShaders() {
+    const PersistentShaderCache* cache = mSkSLCacheMonitor.getPersistentCache();
+    if (!cache || !mContext) {
+        return 0;
+    }
+    SFTRACE_CALL();
+    // Not every Ganesh backend supports precompiling, e.g. Vulkan only uses the entries as they
+    // are loaded on first use.
+    const sk_sp<GrDirectContext> grContext = mContext->grDirectContext();
+    int precompiled = 0;
+    cache->forEachEntry([&](const SkData& key, const SkData& data) {
+        if (grContext->precompileShader(key, data)) {
+            precompiled++;
+        }
+    });
+    return precompiled;
+}
+
 void SkiaRenderEngine::setEnableTracing(bool tracingEnabled) {
     SkAndroidFrameworkTraceUtil::setEnableTracing(tracingEnabled);
 }
@@ -321,6 +397,8 @@ void SkiaRenderEngine::finishRenderingAndAbandonContexts() {
     if (mBlurFilter) {
         delete mBlurFilter;
     }
+    mBlurCache.clear();
+    mShadowCache.clear();
 
     // Leftover textures may hold refs to backend-specific Skia contexts, which must be released
     // before ~SkiaGpuContext is called.
@@ -410,6 +488,15 @@ void SkiaRenderEngine::ensureContextsCreated() {
         return;
     }
 
+    const std::string cachePath =
+            base::GetProperty(PROPERTY_DEBUG_RENDERENGINE_SHADER_CACHE_PATH, "");
+    if (const std::string driverFingerprint = getDriverFingerprint();
+        !cachePath.empty() && !driverFingerprint.empty()) {
+        mSkSLCacheMonitor.enablePersistentCache(cachePath,
+                                                base::GetProperty("ro.build.fingerprint", "") +
+                                                        "|" + driverFingerprint);
+    }
+
     std::tie(mContext, mProtectedContext) = createContexts();
 }
 
@@ -602,6 +689,66 @@ sk_sp<SkShader> SkiaRenderEngine::createRuntimeEffectShader(
     return shader;
 }
 
+size_t SkiaRenderEngine::BlurCache::countUnchangedLayers(const SkiaGpuContext* context,
+                                                          const DisplaySettings& display,
+                                                          std::span<const LayerSettings> layers) {
+    std::vector<LayerSettings> strippedLayers;
+    std::vector<uint64_t> bufferIds;
+    strippedLayers.reserve(layers.size());
+    bufferIds.reserve(layers.size());
+    for (const auto& layer : layers) {
+        const auto& buffer = layer.source.buffer.buffer;
+        bufferIds.push_back(buffer ? buffer->getId() : 0);
+        strippedLayers.push_back(layer);
+        strippedLayers.back().source.buffer.buffer = nullptr;
+    }
+
+    size_t count = 0;
+    if (context == mContext && display == mDisplay) {
+        const size_t size = std::min(layers.size(), mLayers.size());
+        while (count < size && layerContentIsStable(layers[count]) &&
+               bufferIds[count] == mBufferIds[count] && strippedLayers[count] == mLayers[count]) {
+            count++;
+        }
+    }
+
+    mContext = context;
+    mDisplay = display;
+    mLayers = std::move(strippedLayers);
+    mBufferIds = std::move(bufferIds);
+    mNextEntries.clear();
+    return count;
+}
+
+sk_sp<SkImage> SkiaRenderEngine::BlurCache::find(size_t layerIndex, uint32_t radius,
+                                                 const SkRect& blurRect) const {
+    for (const auto& entry : mEntries) {
+        if (entry.layerIndex == layerIndex && entry.radius == radius &&
+            entry.blurRect == blurRect) {
+            return entry.image;
+        }
+    }
+    return nullptr;
+}
+
+void SkiaRenderEngine::BlurCache::add(size_t layerIndex, uint32_t radius, const SkRect& blurRect,
+                                      sk_sp<SkImage> image) {
+    mNextEntries.push_back({layerIndex, radius, blurRect, std::move(image)});
+}
+
+void SkiaRenderEngine::BlurCache::commit() {
+    std::swap(mEntries, mNextEntries);
+    mNextEntries.clear();
+}
+
+void SkiaRenderEngine::BlurCache::clear() {
+    mContext = nullptr;
+    mLayers.clear();
+    mBufferIds.clear();
+    mEntries.clear();
+    mNextEntries.clear();
+}
+
 void SkiaRenderEngine::initCanvas(SkCanvas* canvas, const DisplaySettings& display) {
     if (CC_UNLIKELY(mCapture->isCaptureRunning())) {
         // Record display settings when capture is running.
@@ -766,6 +913,52 @@ void SkiaRenderEngine::drawLayersInternal(
             ? maxLayerWhitePoint / display.targetLuminanceNits
             : 1.f;
 
+    // Layers below the topmost layer that opaquely covers the display cannot contribute to the
+    // output, so skip them entirely: no texture import, fence wait, or draw. The white point above
+    // still considers every layer so that dimming is unaffected. Captures keep every layer so that
+    // they reflect what was requested.
+    size_t firstVisibleLayer = 0;
+    if (!mCapture->isCaptureRunning()) {
+        for (size_t i = layers.size(); i > 0; i--) {
+            if (layerOccludesClip(layers[i - 1], display.clip, ctModifiesAlpha)) {
+                firstVisibleLayer = i - 1;
+                break;
+            }
+        }
+    }
+    if (firstVisibleLayer > 0) {
+        SFTRACE_FORMAT_INSTANT("Skipping %zu occluded layers", firstVisibleLayer);
+    }
+    const std::span<const LayerSettings> visibleLayers =
+            std::span(layers).subspan(firstVisibleLayer);
+
+    // Blurs of a backdrop that is drawn as in the previous call are reused from that call. Captures
+    // skip the cache so that they record every draw.
+    const bool anyLayerHasBlur =
+            std::any_of(visibleLayers.begin(), visibleLayers.end(),
+                        [&](const auto& layer) { return layerHasBlur(layer, ctModifiesAlpha); });
+    const bool useBlurCache = mBlurFilter && anyLayerHasBlur && !mCapture->isCaptureRunning();
+    size_t unchangedLayerCount = 0;
+    if (useBlurCache) {
+        unchangedLayerCount = mBlurCache.countUnchangedLayers(context, display, visibleLayers);
+    } else {
+        mBlurCache.clear();
+    }
+    const auto getOrGenerateBlur = [&](size_t layerIndex, uint32_t radius,
+                                       const sk_sp<SkImage>& blurInput, const SkRect& blurRect) {
+        sk_sp<SkImage> image;
+        if (layerIndex <= unchangedLayerCount) {
+            image = mBlurCache.find(layerIndex, radius, blurRect);
+        }
+        if (!image) {
+            image = mBlurFilter->generate(context, radius, blurInput, blurRect);
+        }
+        if (useBlurCache) {
+            mBlurCache.add(layerIndex, radius, blurRect, image);
+        }
+        return image;
+    };
+
     // Find if any layers have requested blur, we'll use that info to decide when to render to an
     // offscreen buffer and when to render to the native buffer.
     sk_sp<SkSurface> activeSurface(dstSurface);
@@ -774,7 +967,7 @@ void SkiaRenderEngine::drawLayersInternal(
     const LayerSettings* blurCompositionLayer = nullptr;
     if (mBlurFilter) {
         bool requiresCompositionLayer = false;
-        for (const auto& layer : layers) {
+        for (const auto& layer : visibleLayers) {
             // if the layer doesn't have blur or it is not visible then continue
             if (!layerHasBlur(layer, ctModifiesAlpha)) {
                 continue;
@@ -798,14 +991,27 @@ void SkiaRenderEngine::drawLayersInternal(
     }
 
     AutoSaveRestore surfaceAutoSaveRestore(canvas);
-    // Clear the entire canvas with a transparent black to prevent ghost images.
+    // When only part of the buffer is damaged, the rest still holds an earlier composition, so
+    // restrict all drawing to the damage. Blurs spread content beyond the damage, so those always
+    // redraw everything.
+    if (!display.damage.isEmpty() && !anyLayerHasBlur) {
+        SkRegion damage;
+        for (const Rect& rect : display.damage) {
+            damage.op(SkIRect::MakeLTRB(rect.left, rect.top, rect.right, rect.bottom),
+                      SkRegion::kUnion_Op);
+        }
+        SFTRACE_FORMAT_INSTANT("Partial redraw of %dx%d", damage.getBounds().width(),
+                               damage.getBounds().height());
+        canvas->clipRegion(damage);
+    }
+    // Clear the canvas with a transparent black to prevent ghost images.
     canvas->clear(SK_ColorTRANSPARENT);
     initCanvas(canvas, display);
 
     if (kPrintLayerSettings) {
         logSettings(display);
     }
-    for (const auto& layer : layers) {
+    for (const auto& layer : visibleLayers) {
         SFTRACE_FORMAT("DrawLayer: %s", layer.name.c_str());
 
         if (kPrintLayerSettings) {
@@ -869,6 +1075,7 @@ void SkiaRenderEngine::drawLayersInternal(
                                  layer.geometry.roundedCornersRadius);
         if (mBlurFilter && layerHasBlur(layer, ctModifiesAlpha)) {
             std::unordered_map<uint32_t, sk_sp<SkImage>> cachedBlurs;
+            const size_t layerIndex = static_cast<size_t>(&layer - visibleLayers.data());
 
             // if multiple layers have blur, then we need to take a snapshot now because
             // only the lowest layer will have blurImage populated earlier
@@ -901,8 +1108,8 @@ void SkiaRenderEngine::drawLayersInternal(
             if (blurRect.width() > 0 && blurRect.height() > 0) {
                 if (layer.backgroundBlurRadius > 0) {
                     SFTRACE_NAME("BackgroundBlur");
-                    auto blurredImage = mBlurFilter->generate(context, layer.backgroundBlurRadius,
-                                                              blurInput, blurRect);
+                    auto blurredImage = getOrGenerateBlur(layerIndex, layer.backgroundBlurRadius,
+                                                          blurInput, blurRect);
 
                     cachedBlurs[layer.backgroundBlurRadius] = blurredImage;
 
@@ -915,8 +1122,8 @@ void SkiaRenderEngine::drawLayersInternal(
                     if (cachedBlurs[region.blurRadius] == nullptr) {
                         SFTRACE_NAME("BlurRegion");
                         cachedBlurs[region.blurRadius] =
-                                mBlurFilter->generate(context, region.blurRadius, blurInput,
-                                                      blurRect);
+                                getOrGenerateBlur(layerIndex, region.blurRadius, blurInput,
+                                                  blurRect);
                     }
 
                     mBlurFilter->drawBlurRegion(canvas, getBlurRRect(region), region.blurRadius,
@@ -1197,6 +1404,7 @@ void SkiaRenderEngine::drawLayersInternal(
 
     surfaceAutoSaveRestore.restore();
     mCapture->endCapture();
+    mBlurCache.commit();
 
     LOG_ALWAYS_FATAL_IF(activeSurface != dstSurface);
     auto drawFence = sp<Fence>::make(flushAndSubmit(context, dstSurface));
@@ -1257,14 +1465,84 @@ void SkiaRenderEngine::drawShadow(SkCanvas* canvas,
                                   const SkRRect& casterRRect,
                                   const ShadowSettings& settings) {
     SFTRACE_CALL();
-    const float casterZ = settings.length / 2.0f;
+    const SkPath casterPath = SkPath::RRect(casterRRect);
+    const SkPoint3 zPlaneParams = SkPoint3::Make(0, 0, settings.length / 2.0f);
+    const SkPoint3 lightPos = getSkPoint3(settings.lightPos);
     const auto flags =
             settings.casterIsTranslucent ? kTransparentOccluder_ShadowFlag : kNone_ShadowFlag;
+    const auto drawShadowTo = [&](SkCanvas* target, const SkPoint3& targetLightPos) {
+        SkShadowUtils::DrawShadow(target, casterPath, zPlaneParams, targetLightPos,
+                                  settings.lightRadius, getSkColor(settings.ambientColor),
+                                  getSkColor(settings.spotColor), flags);
+    };
+
+    // Captures record the shadow itself rather than a cached image of it.
+    if (CC_UNLIKELY(mCapture->isCaptureRunning())) {
+        drawShadowTo(canvas, lightPos);
+        return;
+    }
 
-    SkShadowUtils::DrawShadow(canvas, SkPath::RRect(casterRRect), SkPoint3::Make(0, 0, casterZ),
-                              getSkPoint3(settings.lightPos), settings.lightRadius,
-                              getSkColor(settings.ambientColor), getSkColor(settings.spotColor),
-                              flags);
+    const auto* context = getActiveContext();
+    if (context != mShadowCacheContext) {
+        mShadowCache.clear();
+        mShadowCacheContext = context;
+    }
+
+    // The light is in device space, so a shadow can only be reused under the same transform.
+    const SkMatrix& matrix = canvas->getTotalMatrix();
+    auto it = std::find_if(mShadowCache.begin(), mShadowCache.end(), [&](const auto& shadow) {
+        return shadow.matrix == matrix && shadow.casterRRect == casterRRect &&
+                shadow.settings == settings;
+    });
+    if (it != mShadowCache.end()) {
+        std::rotate(mShadowCache.begin(), it, it + 1);
+    } else {
+        // Shadows that extend beyond the canvas would need a larger texture, so draw those
+        // directly.
+        SkRect localBounds;
+        if (!SkShadowUtils::GetLocalBounds(matrix, casterPath, zPlaneParams, lightPos,
+                                           settings.lightRadius, flags, &localBounds)) {
+            drawShadowTo(canvas, lightPos);
+            return;
+        }
+        const SkIRect deviceBounds = matrix.mapRect(localBounds).roundOut();
+        const SkImageInfo& canvasInfo = canvas->imageInfo();
+        if (deviceBounds.isEmpty() ||
+            !SkIRect::MakeSize(canvasInfo.dimensions()).contains(deviceBounds)) {
+            drawShadowTo(canvas, lightPos);
+            return;
+        }
+        sk_sp<SkSurface> surface =
+                canvas->makeSurface(canvasInfo.makeDimensions(deviceBounds.size()));
+        if (!surface) {
+            drawShadowTo(canvas, lightPos);
+            return;
+        }
+
+        SFTRACE_NAME("RenderShadow");
+        SkCanvas* shadowCanvas = surface->getCanvas();
+        shadowCanvas->clear(SK_ColorTRANSPARENT);
+        shadowCanvas->translate(-deviceBounds.x(), -deviceBounds.y());
+        shadowCanvas->concat(matrix);
+        drawShadowTo(shadowCanvas,
+                     SkPoint3::Make(lightPos.fX - deviceBounds.x(),
+                                    lightPos.fY - deviceBounds.y(), lightPos.fZ));
+
+        if (mShadowCache.size() == kMaxCachedShadows) {
+            mShadowCache.pop_back();
+        }
+        mShadowCache.insert(mShadowCache.begin(),
+                            CachedShadow{.matrix = matrix,
+                                         .casterRRect = casterRRect,
+                                         .settings = settings,
+                                         .origin = deviceBounds.topLeft(),
+                                         .image = surface->makeImageSnapshot()});
+    }
+
+    const auto& shadow = mShadowCache.front();
+    SkAutoCanvasRestore acr(canvas, true);
+    canvas->resetMatrix();
+    canvas->drawImage(shadow.image, shadow.origin.x(), shadow.origin.y());
 }
 
 void SkiaRenderEngine::onActiveDisplaySizeChanged(ui::Size size) {
@@ -1298,6 +1576,9 @@ void SkiaRenderEngine::dump(std::string& result) {
     StringAppendF(&result, "RenderEngine is in protected context: %d\n", mInProtectedContext);
     StringAppendF(&result, "RenderEngine shaders cached since last dump/primeCache: %d\n",
                   mSkSLCacheMonitor.shadersCachedSinceLastCall());
+    if (const auto* cache = mSkSLCacheMonitor.getPersistentCache()) {
+        cache->dump(result);
+    }
 
     std::vector<ResourcePair> cpuResourceMap = {
             {"skia/sk_resource_cache/bitmap_", "Bitmaps"},
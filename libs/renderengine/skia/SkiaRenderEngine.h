@@ -20,7 +20,11 @@
 #include <renderengine/RenderEngine.h>
 
 #include <android-base/thread_annotations.h>
+#include <include/core/SkImage.h>
 #include <include/core/SkImageInfo.h>
+#include <include/core/SkMatrix.h>
+#include <include/core/SkRRect.h>
+#include <include/core/SkRect.h>
 #include <include/core/SkSurface.h>
 #include <include/gpu/ganesh/GrBackendSemaphore.h>
 #include <include/gpu/ganesh/GrContextOptions.h>
@@ -30,9 +34,12 @@
 
 #include <memory>
 #include <mutex>
+#include <span>
 #include <unordered_map>
+#include <vector>
 
 #include "AutoBackendTexture.h"
+#include "PersistentShaderCache.h"
 #include "android-base/macros.h"
 #include "compat/SkiaGpuContext.h"
 #include "debug/SkiaCapture.h"
@@ -69,6 +76,8 @@ public:
     }
     void onActiveDisplaySizeChanged(ui::Size size) override final;
     int reportShadersCompiled();
+    // Compiles the shaders persisted on previous boots, returning how many were compiled.
+    int precompilePersistedShaders();
 
     virtual void setEnableTracing(bool tracingEnabled) override final;
 
@@ -92,6 +101,10 @@ protected:
     virtual base::unique_fd flushAndSubmit(SkiaGpuContext* context,
                                            sk_sp<SkSurface> dstSurface) = 0;
     virtual void appendBackendSpecificInfoToDump(std::string& result) = 0;
+    // Identifies the GPU driver, so that persisted shaders are discarded when it changes. Backends
+    // whose contexts don't use mSkSLCacheMonitor return an empty string, which disables the
+    // persistent shader cache.
+    virtual std::string getDriverFingerprint() const { return {}; }
 
     size_t getMaxTextureSize() const override final;
     size_t getMaxViewportDims() const override final;
@@ -101,7 +114,7 @@ protected:
     bool isProtected() const { return mInProtectedContext; }
 
     // Implements PersistentCache as a way to monitor what SkSL shaders Skia has
-    // cached.
+    // cached, and optionally to persist them across boots.
     class SkSLCacheMonitor : public GrContextOptions::PersistentCache {
     public:
         SkSLCacheMonitor() = default;
@@ -119,9 +132,13 @@ protected:
 
         int totalShadersCompiled() const { return mTotalShadersCompiled; }
 
+        void enablePersistentCache(std::string path, std::string fingerprint);
+        PersistentShaderCache* getPersistentCache() const { return mPersistentCache.get(); }
+
     private:
         int mShadersCachedSinceLastCall = 0;
         int mTotalShadersCompiled = 0;
+        std::unique_ptr<PersistentShaderCache> mPersistentCache;
     };
 
     SkSLCacheMonitor mSkSLCacheMonitor;
@@ -136,7 +153,7 @@ private:
             const sp<GraphicBuffer>& buffer, bool isOutputBuffer) REQUIRES(mRenderingMutex);
     void initCanvas(SkCanvas* canvas, const DisplaySettings& display);
     void drawShadow(SkCanvas* canvas, const SkRRect& casterRRect,
-                    const ShadowSettings& shadowSettings);
+                    const ShadowSettings& shadowSettings) REQUIRES(mRenderingMutex);
     void drawLayersInternal(const std::shared_ptr<std::promise<FenceResult>>&& resultPromise,
                             const DisplaySettings& display,
                             const std::vector<LayerSettings>& layers,
@@ -188,6 +205,56 @@ private:
     sp<Fence> mLastDrawFence;
     BlurFilter* mBlurFilter = nullptr;
 
+    // Blurs generated by the previous drawLayers call, which are reused for the layers whose
+    // backdrop is drawn exactly as in that call, e.g. a shade over a static wallpaper.
+    class BlurCache {
+    public:
+        // Returns the number of leading layers that draw the same pixels as in the previous call.
+        size_t countUnchangedLayers(const SkiaGpuContext* context, const DisplaySettings& display,
+                                    std::span<const LayerSettings> layers);
+
+        // Returns the blur of the backdrop of the layer at layerIndex, if it was generated with the
+        // same radius and rect.
+        sk_sp<SkImage> find(size_t layerIndex, uint32_t radius, const SkRect& blurRect) const;
+        void add(size_t layerIndex, uint32_t radius, const SkRect& blurRect, sk_sp<SkImage> image);
+
+        // Drops the blurs of the previous call, and keeps those added since countUnchangedLayers.
+        void commit();
+        void clear();
+
+    private:
+        struct Entry {
+            size_t layerIndex;
+            uint32_t radius;
+            SkRect blurRect;
+            sk_sp<SkImage> image;
+        };
+
+        const SkiaGpuContext* mContext = nullptr;
+        DisplaySettings mDisplay;
+        // The layers are stored without their ExternalTexture, so as not to extend its lifetime,
+        // and compared by buffer ID instead.
+        std::vector<LayerSettings> mLayers;
+        std::vector<uint64_t> mBufferIds;
+        std::vector<Entry> mEntries;
+        std::vector<Entry> mNextEntries;
+    };
+    BlurCache mBlurCache GUARDED_BY(mRenderingMutex);
+
+    // Shadows rendered by earlier calls to drawShadow, most recently used first. They are reused
+    // while their caster, transform and light are unchanged, as with the shadows of windows that
+    // are not moving.
+    struct CachedShadow {
+        SkMatrix matrix;
+        SkRRect casterRRect;
+        ShadowSettings settings;
+        SkIPoint origin;
+        sk_sp<SkImage> image;
+    };
+    static constexpr size_t kMaxCachedShadows = 8;
+    const SkiaGpuContext* mShadowCacheContext GUARDED_BY(mRenderingMutex) = nullptr;
+    std::vector<CachedShadow> mShadowCache GUARDED_BY(mRenderingMutex);
+
     // Object to capture commands send to Skia.
     std::unique_ptr<SkiaCapture> mCapture;
 
@@ -168,6 +168,10 @@ int SkiaVkRenderEngine::getContextPriority() {
     }
 }
 
+std::string SkiaVkRenderEngine::getDriverFingerprint() const {
+    return sVulkanInterface.getDriverFingerprint();
+}
+
 void SkiaVkRenderEngine::appendBackendSpecificInfoToDump(std::string& result) {
     StringAppendF(&result, "\n ------------RE Vulkan----------\n");
     StringAppendF(&result, "\n Vulkan device initialized: %d\n", sVulkanInterface.isInitialized());
@@ -82,6 +82,7 @@ protected:
     bool supportsProtectedContentImpl() const override;
     bool useProtectedContextImpl(GrProtected isProtected) override;
     void appendBackendSpecificInfoToDump(std::string& result) override;
+    std::string getDriverFingerprint() const override;
 
     // TODO: b/300533018 - refactor this to be non-static
     static VulkanInterface& getVulkanInterface(bool protectedContext);
@@ -22,6 +22,7 @@
 #include <include/gpu/GpuTypes.h>
 #include <include/gpu/vk/VulkanBackendContext.h>
 
+#include <android-base/stringprintf.h>
 #include <log/log_main.h>
 #include <utils/Timers.h>
 
@@ -315,6 +316,11 @@ void VulkanInterface::init(bool protectedContent) {
 
     vkGetPhysicalDeviceProperties2(physicalDevice, &physDevProps);
     const uint32_t physicalDeviceApiVersion = physDevProps.properties.apiVersion;
+    mDriverFingerprint = base::StringPrintf("%s|%04" PRIx32 ":%04" PRIx32 "|%" PRIu32,
+                                            physDevProps.properties.deviceName,
+                                            physDevProps.properties.vendorID,
+                                            physDevProps.properties.deviceID,
+                                            physDevProps.properties.driverVersion);
     if (physicalDeviceApiVersion < VK_MAKE_VERSION(1, 1, 0)) {
         BAIL("Vulkan physical device API version %" PRIu32 ".%" PRIu32 ".%" PRIu32 " < 1.1.0",
              VK_VERSION_MAJOR(physicalDeviceApiVersion), VK_VERSION_MINOR(physicalDeviceApiVersion),
@@ -602,6 +608,7 @@ void VulkanInterface::teardown() {
 
     mInstanceExtensionNames.clear();
     mDeviceExtensionNames.clear();
+    mDriverFingerprint.clear();
 }
 
 } // namespace skia
@@ -56,6 +56,8 @@ public:
     bool isRealtimePriority() const { return mIsRealtimePriority; }
     const std::vector<std::string>& getInstanceExtensionNames() { return mInstanceExtensionNames; }
     const std::vector<std::string>& getDeviceExtensionNames() { return mDeviceExtensionNames; }
+    // Identifies the physical device and its driver build.
+    const std::string& getDriverFingerprint() const { return mDriverFingerprint; }
 
 private:
     struct VulkanFuncs {
@@ -96,6 +98,7 @@ private:
 
     std::vector<std::string> mInstanceExtensionNames;
     std::vector<std::string> mDeviceExtensionNames;
+    std::string mDriverFingerprint;
 };
 
 } // namespace skia
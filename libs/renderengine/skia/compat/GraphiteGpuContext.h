@@ -58,6 +58,10 @@ private:
     DISALLOW_COPY_AND_ASSIGN(GraphiteGpuContext);
 
     std::shared_ptr<skgpu::graphite::Context> mContext;
+    // All drawing records into this one Recorder on the RenderEngine thread. Recording with a
+    // Recorder per worker thread would also need per-Recorder texture and surface caches, since
+    // AutoBackendTexture wraps buffers for a single Recorder, and an ordering of their Recordings
+    // in flushAndSubmit, which only knows about the fences of a single drawLayers call.
     std::shared_ptr<skgpu::graphite::Recorder> mRecorder;
 };
 
@@ -66,4 +66,13 @@ TEST(DisplaySettingsTest, renderIntent) {
 
     ASSERT_FALSE(a == b);
 }
+
+TEST(DisplaySettingsTest, damageIsIgnored) {
+    DisplaySettings a, b;
+    ASSERT_EQ(a, b);
+
+    a.damage = Region(Rect(10, 10));
+
+    ASSERT_EQ(a, b);
+}
 } // namespace android::renderengine
@@ -0,0 +1,101 @@
+/*
+ * Copyright 2024 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#undef LOG_TAG
+#define LOG_TAG "PersistentShaderCacheTest"
+
+#include <android-base/file.h>
+#include <gtest/gtest.h>
+
+#include <string>
+
+#include "../skia/PersistentShaderCache.h"
+
+namespace android::renderengine::skia {
+namespace {
+
+sk_sp<SkData> makeData(const std::string& string) {
+    return SkData::MakeWithCopy(string.data(), string.size());
+}
+
+std::string toString(const sk_sp<SkData>& data) {
+    return data ? std::string(static_cast<const char*>(data->data()), data->size()) : "";
+}
+
+class PersistentShaderCacheTest : public testing::Test {
+protected:
+    std::unique_ptr<PersistentShaderCache> makeCache(const std::string& fingerprint,
+                                                     size_t maxBytes =
+                                                             PersistentShaderCache::kMaxBytes) {
+        return std::make_unique<PersistentShaderCache>(mPath, fingerprint, maxBytes);
+    }
+
+    TemporaryDir mDir;
+    const std::string mPath = std::string(mDir.path) + "/shader_cache";
+};
+
+TEST_F(PersistentShaderCacheTest, entriesPersistAcrossInstances) {
+    {
+        auto cache = makeCache("fingerprint");
+        EXPECT_EQ(nullptr, cache->load(*makeData("key")));
+        cache->store(*makeData("key"), *makeData("program"));
+        EXPECT_EQ("program", toString(cache->load(*makeData("key"))));
+    }
+
+    auto cache = makeCache("fingerprint");
+    EXPECT_EQ(1u, cache->getEntryCount());
+    EXPECT_EQ("program", toString(cache->load(*makeData("key"))));
+}
+
+TEST_F(PersistentShaderCacheTest, discardsEntriesFromAnotherDriver) {
+    {
+        auto cache = makeCache("fingerprint");
+        cache->store(*makeData("key"), *makeData("program"));
+        ASSERT_TRUE(cache->flush());
+    }
+
+    auto cache = makeCache("another fingerprint");
+    EXPECT_EQ(0u, cache->getEntryCount());
+    EXPECT_EQ(nullptr, cache->load(*makeData("key")));
+}
+
+TEST_F(PersistentShaderCacheTest, discardsCorruptedFile) {
+    {
+        auto cache = makeCache("fingerprint");
+        cache->store(*makeData("key"), *makeData("program"));
+    }
+    std::string contents;
+    ASSERT_TRUE(base::ReadFileToString(mPath, &contents));
+    contents[contents.size() / 2] ^= 0xff;
+    ASSERT_TRUE(base::WriteStringToFile(contents, mPath));
+
+    EXPECT_EQ(0u, makeCache("fingerprint")->getEntryCount());
+}
+
+TEST_F(PersistentShaderCacheTest, dropsStoresOverBudget) {
+    auto cache = makeCache("fingerprint", /*maxBytes*/ 16);
+    cache->store(*makeData("key1"), *makeData("program1"));
+    cache->store(*makeData("key2"), *makeData("program2"));
+
+    EXPECT_EQ(1u, cache->getEntryCount());
+    EXPECT_EQ(nullptr, cache->load(*makeData("key2")));
+    // Replacing an entry only accounts for the difference in size.
+    cache->store(*makeData("key1"), *makeData("program0"));
+    EXPECT_EQ("program0", toString(cache->load(*makeData("key1"))));
+}
+
+} // namespace
+} // namespace android::renderengine::skia
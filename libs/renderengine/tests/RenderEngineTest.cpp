@@ -2569,6 +2569,50 @@ TEST_P(RenderEngineTest, testDisableBlendingBuffer) {
     expectBufferColor(rect, 0, 128, 0, 128);
 }
 
+TEST_P(RenderEngineTest, testOpaqueLayerOccludesLayersBelow) {
+    if (!GetParam()->apiSupported()) {
+        GTEST_SKIP();
+    }
+    initializeRenderEngine();
+
+    const auto rect = fullscreenRect();
+    const renderengine::DisplaySettings display{
+            .physicalDisplay = rect,
+            .clip = rect,
+    };
+
+    const renderengine::LayerSettings redLayer{
+            .geometry.boundaries = rect.toFloatRect(),
+            .source.solidColor = half3(1.0f, 0.0f, 0.0f),
+            .alpha = 1.0f,
+    };
+    renderengine::LayerSettings blueLayer{
+            .geometry.boundaries = rect.toFloatRect(),
+            .source.solidColor = half3(0.0f, 0.0f, 1.0f),
+            .alpha = 1.0f,
+    };
+    const renderengine::LayerSettings greenLayer{
+            .geometry.boundaries = FloatRect(0.f, 0.f, 1.f, 1.f),
+            .source.solidColor = half3(0.0f, 1.0f, 0.0f),
+            .alpha = 1.0f,
+    };
+
+    // The blue layer covers the display, so the red layer cannot show through, but layers above
+    // it are still drawn.
+    std::vector<renderengine::LayerSettings> layers{redLayer, blueLayer, greenLayer};
+    invokeDraw(display, layers);
+    expectBufferColor(Rect(1, 1, rect.right, rect.bottom), 0, 0, 255, 255);
+    expectBufferColor(Point(0, 0), 0, 255, 0, 255);
+
+    // Once scaled down, the blue layer only covers the left half of the display, and the red
+    // layer must show through on the right.
+    blueLayer.geometry.positionTransform = mat4::scale(vec4(0.5f, 1.0f, 1.0f, 1.0f));
+    layers = {redLayer, blueLayer};
+    invokeDraw(display, layers);
+    expectBufferColor(Rect(0, 0, rect.width() / 2, rect.bottom), 0, 0, 255, 255);
+    expectBufferColor(Rect(rect.width() / 2, 0, rect.right, rect.bottom), 255, 0, 0, 255);
+}
+
 TEST_P(RenderEngineTest, testDimming) {
     if (!GetParam()->apiSupported()) {
         GTEST_SKIP();
@@ -19,6 +19,7 @@
 #include "RenderEngineThreaded.h"
 
 #include <sched.h>
+#include <algorithm>
 #include <chrono>
 #include <future>
 
@@ -104,6 +105,11 @@ void RenderEngineThreaded::threadMain(CreateInstanceFactory factory) NO_THREAD_S
                 mFunctionCalls.pop();
                 return std::make_optional<Work>(task);
             }
+            if (!mPendingImports.empty()) {
+                PendingImport import = std::move(mPendingImports.front());
+                mPendingImports.pop_front();
+                return std::make_optional<Work>(makeImportWork(std::move(import)));
+            }
             return std::nullopt;
         };
 
@@ -115,7 +121,7 @@ void RenderEngineThreaded::threadMain(CreateInstanceFactory factory) NO_THREAD_S
 
         std::unique_lock<std::mutex> lock(mThreadMutex);
         mCondition.wait(lock, [this]() REQUIRES(mThreadMutex) {
-            return !mRunning || !mFunctionCalls.empty();
+            return !mRunning || !mFunctionCalls.empty() || !mPendingImports.empty();
         });
     }
 
@@ -172,6 +178,29 @@ void RenderEngineThreaded::dump(std::string& result) {
     mCondition.notify_one();
     // Note: This is an rvalue.
     result.assign(resultFuture.get());
+
+    std::lock_guard lock(mThreadMutex);
+    base::StringAppendF(&result, "RenderEngine pending texture imports: %zu\n",
+                        mPendingImports.size());
+}
+
+RenderEngineThreaded::Work RenderEngineThreaded::makeImportWork(PendingImport&& import) {
+    return [import = std::move(import)](renderengine::RenderEngine& instance) {
+        SFTRACE_NAME("REThreaded::mapExternalTextureBuffer");
+        instance.mapExternalTextureBuffer(import.buffer, import.isRenderable);
+    };
+}
+
+void RenderEngineThreaded::promotePendingImportsLocked(
+        const std::function<bool(uint64_t bufferId)>& isUsed) {
+    for (auto it = mPendingImports.begin(); it != mPendingImports.end();) {
+        if (isUsed(it->buffer->getId())) {
+            mFunctionCalls.push(makeImportWork(std::move(*it)));
+            it = mPendingImports.erase(it);
+        } else {
+            it++;
+        }
+    }
 }
 
 void RenderEngineThreaded::mapExternalTextureBuffer(const sp<GraphicBuffer>& buffer,
@@ -181,10 +210,11 @@ void RenderEngineThreaded::mapExternalTextureBuffer(const sp<GraphicBuffer>& buf
     // for the futures.
     {
         std::lock_guard lock(mThreadMutex);
-        mFunctionCalls.push([=](renderengine::RenderEngine& instance) {
-            SFTRACE_NAME("REThreaded::mapExternalTextureBuffer");
-            instance.mapExternalTextureBuffer(buffer, isRenderable);
-        });
+        if (mPendingImports.size() >= kMaxPendingImports) {
+            mFunctionCalls.push(makeImportWork(std::move(mPendingImports.front())));
+            mPendingImports.pop_front();
+        }
+        mPendingImports.push_back({buffer, isRenderable});
     }
     mCondition.notify_one();
 }
@@ -195,6 +225,15 @@ void RenderEngineThreaded::unmapExternalTextureBuffer(sp<GraphicBuffer>&& buffer
     // for the futures.
     {
         std::lock_guard lock(mThreadMutex);
+        // If the buffer is released before it was imported, drop both requests.
+        if (const auto it = std::find_if(mPendingImports.begin(), mPendingImports.end(),
+                                         [&](const PendingImport& import) {
+                                             return import.buffer->getId() == buffer->getId();
+                                         });
+            it != mPendingImports.end()) {
+            mPendingImports.erase(it);
+            return;
+        }
         mFunctionCalls.push(
                 [=, buffer = std::move(buffer)](renderengine::RenderEngine& instance) mutable {
                     SFTRACE_NAME("REThreaded::unmapExternalTextureBuffer");
@@ -269,6 +308,15 @@ ftl::Future<FenceResult> RenderEngineThreaded::drawLayers(
     {
         std::lock_guard lock(mThreadMutex);
         mNeedsPostRenderCleanup = true;
+        if (!mPendingImports.empty()) {
+            promotePendingImportsLocked([&](uint64_t bufferId) {
+                return (buffer && buffer->getId() == bufferId) ||
+                        std::any_of(layers.begin(), layers.end(), [&](const LayerSettings& layer) {
+                               return layer.source.buffer.buffer &&
+                                       layer.source.buffer.buffer->getId() == bufferId;
+                           });
+            });
+        }
         mFunctionCalls.push(
                 [resultPromise, display, layers, buffer, fd](renderengine::RenderEngine& instance) {
                     SFTRACE_NAME("REThreaded::drawLayers");
@@ -292,6 +340,12 @@ ftl::Future<FenceResult> RenderEngineThreaded::drawGainmap(
     {
         std::lock_guard lock(mThreadMutex);
         mNeedsPostRenderCleanup = true;
+        if (!mPendingImports.empty()) {
+            promotePendingImportsLocked([&](uint64_t bufferId) {
+                return (sdr && sdr->getId() == bufferId) || (hdr && hdr->getId() == bufferId) ||
+                        (gainmap && gainmap->getId() == bufferId);
+            });
+        }
         mFunctionCalls.push([resultPromise, sdr, sdrFence = std::move(sdrFence), hdr,
                              hdrFence = std::move(hdrFence), hdrSdrRatio, dataspace,
                              gainmap](renderengine::RenderEngine& instance) mutable {
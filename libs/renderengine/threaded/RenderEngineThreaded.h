@@ -18,6 +18,8 @@
 
 #include <android-base/thread_annotations.h>
 #include <condition_variable>
+#include <deque>
+#include <functional>
 #include <mutex>
 #include <queue>
 #include <thread>
@@ -90,6 +92,11 @@ private:
     void waitUntilInitialized() const;
     static status_t setSchedFifo(bool enabled);
 
+    // Queues the pending imports of the buffers that a draw is about to sample or render to, so
+    // that they run before the draw rather than after it.
+    void promotePendingImportsLocked(const std::function<bool(uint64_t bufferId)>& isUsed)
+            REQUIRES(mThreadMutex);
+
     // No-op. This method is only called on leaf implementations of RenderEngine.
     void useProtectedContext(bool) override {}
 
@@ -104,9 +111,20 @@ private:
     std::atomic<bool> mNeedsPostRenderCleanup = false;
 
     using Work = std::function<void(renderengine::RenderEngine&)>;
+    struct PendingImport {
+        sp<GraphicBuffer> buffer;
+        bool isRenderable;
+    };
+    static Work makeImportWork(PendingImport&& import);
     mutable std::queue<Work> mFunctionCalls GUARDED_BY(mThreadMutex);
     mutable std::condition_variable mCondition;
 
+    // Texture imports run when mFunctionCalls is empty, so that importing new buffers, e.g. when
+    // an app launches, does not delay composition. At most kMaxPendingImports are deferred; older
+    // requests are then queued in order.
+    static constexpr size_t kMaxPendingImports = 32;
+    std::deque<PendingImport> mPendingImports GUARDED_BY(mThreadMutex);
+
     // Used to allow select thread safe methods to be accessed without requiring the
     // method to be invoked on the RenderEngine thread
     std::atomic_bool mIsInitialized = false;
@@ -18,6 +18,7 @@
 
 #include <stdint.h>
 #include <sys/types.h>
+#include <sys/uio.h>
 
 #include <utils/Errors.h>
 #include <utils/RefBase.h>
@@ -55,6 +56,12 @@ public:
         return sendObjects(tube, events, count, sizeof(T));
     }
 
+    // send objects (sized blobs) gathered from several buffers as a single message, as if they had
+    // been copied one after the other into one buffer and sent with sendObjects. All objects are
+    // guaranteed to be written or the call fails.
+    static ssize_t sendGatheredObjects(const sp<BitTube>& tube,
+            const struct iovec* buffers, size_t bufferCount, size_t objSize);
+
     // receive objects (sized blobs). If the receiving buffer isn't large enough,
     // excess messages are silently discarded.
     template <typename T>
@@ -72,6 +79,10 @@ private:
     // send a message. The write is guaranteed to send the whole message or fail.
     ssize_t write(void const* vaddr, size_t size);
 
+    // send a message made of several buffers. The write is guaranteed to send the whole message or
+    // fail.
+    ssize_t writev(const struct iovec* buffers, size_t bufferCount);
+
     // receive a message. the passed buffer must be at least as large as the
     // write call used to send the message, excess data is silently discarded.
     ssize_t read(void* vaddr, size_t size);
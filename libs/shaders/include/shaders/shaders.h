@@ -73,7 +73,7 @@ struct LinearEffect {
 static inline bool operator==(const LinearEffect& lhs, const LinearEffect& rhs) {
     return lhs.inputDataspace == rhs.inputDataspace && lhs.outputDataspace == rhs.outputDataspace &&
             lhs.undoPremultipliedAlpha == rhs.undoPremultipliedAlpha &&
-            lhs.fakeOutputDataspace == rhs.fakeOutputDataspace;
+            lhs.fakeOutputDataspace == rhs.fakeOutputDataspace && lhs.type == rhs.type;
 }
 
 struct LinearEffectHasher {
@@ -86,7 +86,8 @@ struct LinearEffectHasher {
         size_t result = std::hash<ui::Dataspace>{}(le.inputDataspace);
         result = HashCombine(result, std::hash<ui::Dataspace>{}(le.outputDataspace));
         result = HashCombine(result, std::hash<bool>{}(le.undoPremultipliedAlpha));
-        return HashCombine(result, std::hash<ui::Dataspace>{}(le.fakeOutputDataspace));
+        result = HashCombine(result, std::hash<ui::Dataspace>{}(le.fakeOutputDataspace));
+        return HashCombine(result, std::hash<int>{}(le.type));
     }
 };
 
@@ -94,9 +95,14 @@ struct LinearEffectHasher {
 // Typical use-cases supported:
 // 1. Apply tone-mapping
 // 2. Apply color transform matrices in linear space
+//
+// Shader strings are cached for the lifetime of the process, so each LinearEffect is only
+// generated once. When the effect does not change luminance, i.e. its input and output are both
+// SDR or both PQ, tone-mapping is left out of the shader.
 std::string buildLinearEffectSkSL(const LinearEffect& linearEffect);
 
-// Generates a list of uniforms to set on the LinearEffect shader above.
+// Generates a list of uniforms to set on the LinearEffect shader above. The uniforms that only
+// depend on the LinearEffect are computed once per effect.
 std::vector<tonemap::ShaderUniform> buildLinearEffectUniforms(
         const LinearEffect& linearEffect, const mat4& colorTransform, float maxDisplayLuminance,
         float currentDisplayLuminanceNits, float maxLuminance, AHardwareBuffer* buffer = nullptr,
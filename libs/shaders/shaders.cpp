@@ -19,7 +19,10 @@
 #include <tonemap/tonemap.h>
 
 #include <cmath>
+#include <memory>
+#include <mutex>
 #include <optional>
+#include <unordered_map>
 
 #include <math/mat4.h>
 #include <system/graphics-base-v1.0.h>
@@ -27,6 +30,8 @@
 
 namespace android::shaders {
 
+ColorSpace toColorSpace(ui::Dataspace dataspace);
+
 namespace {
 
 aidl::android::hardware::graphics::common::Dataspace toAidlDataspace(ui::Dataspace dataspace) {
@@ -165,6 +170,30 @@ void generateOOTF(ui::Dataspace inputDataspace, ui::Dataspace outputDataspace,
         )");
 }
 
+// Whether the OOTF of an effect leaves the luminance unchanged, so that tone-mapping can be left out
+// of its shader. This is the case for SDR to SDR and PQ to PQ, whose luminances are scaled to and
+// normalized from the same range and which tonemappers do not remap. HLG to HLG is excluded, since
+// tonemappers may still adjust the HLG OOTF to the display.
+bool isIdentityOOTF(ui::Dataspace inputDataspace, ui::Dataspace outputDataspace) {
+    const auto inputTransfer = inputDataspace & HAL_DATASPACE_TRANSFER_MASK;
+    const auto outputTransfer = outputDataspace & HAL_DATASPACE_TRANSFER_MASK;
+    if (inputTransfer == HAL_DATASPACE_TRANSFER_HLG || outputTransfer == HAL_DATASPACE_TRANSFER_HLG) {
+        return false;
+    }
+    return (inputTransfer == HAL_DATASPACE_TRANSFER_ST2084) ==
+            (outputTransfer == HAL_DATASPACE_TRANSFER_ST2084);
+}
+
+// Specialization of generateOOTF for effects where isIdentityOOTF holds: scaling the luminance,
+// applying a gain of 1, and normalizing it back reduces to the conversion to XYZ.
+void generateIdentityOOTF(std::string& shader) {
+    shader.append(R"(
+            float3 OOTF(float3 linearRGB) {
+                return ToXYZ(linearRGB);
+            }
+        )");
+}
+
 void generateOETF(std::string& shader) {
     // Only support gamma 2.2 for now
     shader.append(R"(
@@ -228,12 +257,14 @@ std::vector<uint8_t> buildUniformValue(T value) {
     return result;
 }
 
-} // namespace
-
-std::string buildLinearEffectSkSL(const LinearEffect& linearEffect) {
+std::string generateLinearEffectSkSL(const LinearEffect& linearEffect) {
     std::string shaderString;
     generateXYZTransforms(shaderString);
-    generateOOTF(linearEffect.inputDataspace, linearEffect.outputDataspace, shaderString);
+    if (isIdentityOOTF(linearEffect.inputDataspace, linearEffect.outputDataspace)) {
+        generateIdentityOOTF(shaderString);
+    } else {
+        generateOOTF(linearEffect.inputDataspace, linearEffect.outputDataspace, shaderString);
+    }
 
     const bool needsCustomOETF = (linearEffect.fakeOutputDataspace & HAL_DATASPACE_TRANSFER_MASK) ==
             HAL_DATASPACE_TRANSFER_GAMMA2_2;
@@ -245,6 +276,64 @@ std::string buildLinearEffectSkSL(const LinearEffect& linearEffect) {
     return shaderString;
 }
 
+// The shader and uniforms of a LinearEffect that do not depend on the per-layer parameters.
+struct LinearEffectData {
+    std::string skSL;
+
+    // Whether the shader includes tone-mapping, and so needs the libtonemap uniforms.
+    bool tonemaps;
+
+    std::vector<uint8_t> rgbToXyz;
+    std::vector<uint8_t> xyzToSrcRgb;
+
+    // in_colorTransform is xyzToOutputRgb * colorTransform * outputRgbToXyz.
+    mat4 xyzToOutputRgb;
+    mat4 outputRgbToXyz;
+};
+
+std::unique_ptr<const LinearEffectData> createLinearEffectData(const LinearEffect& linearEffect) {
+    const auto inputColorSpace = toColorSpace(linearEffect.inputDataspace);
+    const auto outputColorSpace = toColorSpace(linearEffect.outputDataspace);
+    const auto linearExtendedSRGB = ColorSpace::linearExtendedSRGB();
+
+    return std::make_unique<const LinearEffectData>(LinearEffectData{
+            .skSL = generateLinearEffectSkSL(linearEffect),
+            .tonemaps = !isIdentityOOTF(linearEffect.inputDataspace, linearEffect.outputDataspace),
+            .rgbToXyz = buildUniformValue<mat3>(linearExtendedSRGB.getRGBtoXYZ()),
+            .xyzToSrcRgb = buildUniformValue<mat3>(inputColorSpace.getXYZtoRGB()),
+            // Transforms xyz colors to linear source colors, then applies the color transform,
+            // then transforms to linear extended RGB for skia to color manage.
+            // TODO: the color transform ideally should be applied in the source colorspace, but
+            // doing that breaks renderengine tests
+            .xyzToOutputRgb = mat4(linearExtendedSRGB.getXYZtoRGB()) *
+                    mat4(outputColorSpace.getRGBtoXYZ()),
+            .outputRgbToXyz = mat4(outputColorSpace.getXYZtoRGB()),
+    });
+}
+
+// Returns the data for a LinearEffect, which is computed on first use and then shared by all
+// callers in the process. The number of distinct effects is bounded by the dataspaces in use, so
+// entries are never evicted, and references to them remain valid.
+const LinearEffectData& getLinearEffectData(const LinearEffect& linearEffect) {
+    static std::mutex sMutex;
+    static std::unordered_map<LinearEffect, std::unique_ptr<const LinearEffectData>,
+                              LinearEffectHasher>
+            sEffects;
+
+    std::lock_guard lock(sMutex);
+    auto& data = sEffects[linearEffect];
+    if (!data) {
+        data = createLinearEffectData(linearEffect);
+    }
+    return *data;
+}
+
+} // namespace
+
+std::string buildLinearEffectSkSL(const LinearEffect& linearEffect) {
+    return getLinearEffectData(linearEffect).skSL;
+}
+
 ColorSpace toColorSpace(ui::Dataspace dataspace) {
     switch (dataspace & HAL_DATASPACE_STANDARD_MASK) {
         case HAL_DATASPACE_STANDARD_BT709:
@@ -276,26 +365,18 @@ std::vector<tonemap::ShaderUniform> buildLinearEffectUniforms(
         const LinearEffect& linearEffect, const mat4& colorTransform, float maxDisplayLuminance,
         float currentDisplayLuminanceNits, float maxLuminance, AHardwareBuffer* buffer,
         aidl::android::hardware::graphics::composer3::RenderIntent renderIntent) {
-    std::vector<tonemap::ShaderUniform> uniforms;
+    const LinearEffectData& data = getLinearEffectData(linearEffect);
 
-    auto inputColorSpace = toColorSpace(linearEffect.inputDataspace);
-    auto outputColorSpace = toColorSpace(linearEffect.outputDataspace);
-
-    uniforms.push_back(
-            {.name = "in_rgbToXyz",
-             .value = buildUniformValue<mat3>(ColorSpace::linearExtendedSRGB().getRGBtoXYZ())});
-    uniforms.push_back({.name = "in_xyzToSrcRgb",
-                        .value = buildUniformValue<mat3>(inputColorSpace.getXYZtoRGB())});
-    // Transforms xyz colors to linear source colors, then applies the color transform, then
-    // transforms to linear extended RGB for skia to color manage.
+    std::vector<tonemap::ShaderUniform> uniforms;
+    uniforms.push_back({.name = "in_rgbToXyz", .value = data.rgbToXyz});
+    uniforms.push_back({.name = "in_xyzToSrcRgb", .value = data.xyzToSrcRgb});
     uniforms.push_back({.name = "in_colorTransform",
-                        .value = buildUniformValue<mat4>(
-                                mat4(ColorSpace::linearExtendedSRGB().getXYZtoRGB()) *
-                                // TODO: the color transform ideally should be applied
-                                // in the source colorspace, but doing that breaks
-                                // renderengine tests
-                                mat4(outputColorSpace.getRGBtoXYZ()) * colorTransform *
-                                mat4(outputColorSpace.getXYZtoRGB()))});
+                        .value = buildUniformValue<mat4>(data.xyzToOutputRgb * colorTransform *
+                                                         data.outputRgbToXyz)});
+
+    if (!data.tonemaps) {
+        return uniforms;
+    }
 
     tonemap::Metadata metadata{.displayMaxLuminance = maxDisplayLuminance,
                                // If the input luminance is unknown, use display luminance (aka,
@@ -309,8 +390,8 @@ std::vector<tonemap::ShaderUniform> buildLinearEffectUniforms(
                                .buffer = buffer,
                                .renderIntent = renderIntent};
 
-    for (const auto uniform : tonemap::getToneMapper()->generateShaderSkSLUniforms(metadata)) {
-        uniforms.push_back(uniform);
+    for (auto& uniform : tonemap::getToneMapper()->generateShaderSkSLUniforms(metadata)) {
+        uniforms.push_back(std::move(uniform));
     }
 
     return uniforms;
@@ -26,6 +26,7 @@ namespace android {
 
 using testing::Contains;
 using testing::HasSubstr;
+using testing::Not;
 
 struct ShadersTest : public ::testing::Test {};
 
@@ -93,4 +94,49 @@ TEST_F(ShadersTest, buildLinearEffectUniforms_selectsGamutTransformMatrices) {
     EXPECT_THAT(uniforms, Contains(UniformNameEq("in_colorTransform")));
 }
 
+TEST_F(ShadersTest, buildLinearEffectSkSL_skipsTonemappingForSdr) {
+    const shaders::LinearEffect effect =
+            shaders::LinearEffect{.inputDataspace = ui::Dataspace::V0_SRGB,
+                                  .outputDataspace = ui::Dataspace::DISPLAY_P3};
+
+    EXPECT_THAT(shaders::buildLinearEffectSkSL(effect), Not(HasSubstr("libtonemap_")));
+
+    const auto uniforms =
+            shaders::buildLinearEffectUniforms(effect, mat4(), 1.f, 1.f, 1.f, nullptr,
+                                               aidl::android::hardware::graphics::composer3::
+                                                       RenderIntent::COLORIMETRIC);
+    EXPECT_THAT(uniforms, Not(Contains(UniformNameEq("in_libtonemap_displayMaxLuminance"))));
+}
+
+TEST_F(ShadersTest, buildLinearEffectSkSL_tonemapsHdrToSdr) {
+    const shaders::LinearEffect effect =
+            shaders::LinearEffect{.inputDataspace = ui::Dataspace::BT2020_ITU_PQ,
+                                  .outputDataspace = ui::Dataspace::DISPLAY_P3};
+
+    EXPECT_THAT(shaders::buildLinearEffectSkSL(effect),
+                HasSubstr("libtonemap_LookupTonemapGain("));
+
+    const auto uniforms =
+            shaders::buildLinearEffectUniforms(effect, mat4(), 1.f, 1.f, 1.f, nullptr,
+                                               aidl::android::hardware::graphics::composer3::
+                                                       RenderIntent::COLORIMETRIC);
+    EXPECT_THAT(uniforms, Contains(UniformNameEq("in_libtonemap_displayMaxLuminance")));
+}
+
+TEST_F(ShadersTest, buildLinearEffectSkSL_distinguishesTypes) {
+    const shaders::LinearEffect shader =
+            shaders::LinearEffect{.inputDataspace = ui::Dataspace::BT2020_ITU_HLG,
+                                  .outputDataspace = ui::Dataspace::DISPLAY_P3,
+                                  .type = shaders::LinearEffect::Shader};
+    const shaders::LinearEffect colorFilter =
+            shaders::LinearEffect{.inputDataspace = ui::Dataspace::BT2020_ITU_HLG,
+                                  .outputDataspace = ui::Dataspace::DISPLAY_P3,
+                                  .type = shaders::LinearEffect::ColorFilter};
+
+    EXPECT_EQ(shaders::buildLinearEffectSkSL(shader), shaders::buildLinearEffectSkSL(shader));
+    EXPECT_THAT(shaders::buildLinearEffectSkSL(shader), HasSubstr("uniform shader child;"));
+    EXPECT_THAT(shaders::buildLinearEffectSkSL(colorFilter),
+                Not(HasSubstr("uniform shader child;")));
+}
+
 } // namespace android
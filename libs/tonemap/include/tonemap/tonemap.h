@@ -21,6 +21,9 @@
 #include <android/hardware_buffer.h>
 #include <math/vec3.h>
 
+#include <cstddef>
+#include <memory>
+#include <mutex>
 #include <string>
 #include <vector>
 
@@ -83,6 +86,41 @@ struct Color {
     vec3 xyz;
 };
 
+// Table of tonemapping gains for fixed dataspaces and metadata, for CPU consumers that tonemap
+// many colors at once, such as screenshots and region sampling.
+//
+// The gains are sampled at logarithmically spaced luminances, and linearly interpolated in
+// between, so they match ToneMapper::lookupTonemapGain() up to a small relative error.
+class GainLut {
+public:
+    // The component of a Color that the gain is a function of.
+    enum class Input {
+        // The maximum of the components of Color::linearRGB
+        MaxRGB,
+        // The Y component of Color::xyz
+        Luminance,
+    };
+
+    Input getInput() const { return mInput; }
+
+    // Returns the gain for a single color.
+    float lookup(const Color& color) const;
+
+    // Writes the gains for count colors to gains. This is vectorized where possible, so it should
+    // be preferred over calling lookup() per color.
+    void lookup(const Color* colors, float* gains, size_t count) const;
+
+private:
+    friend class ToneMapper;
+
+    GainLut(Input input, std::vector<float> table) : mInput(input), mTable(std::move(table)) {}
+
+    float sample(float value) const;
+
+    const Input mInput;
+    const std::vector<float> mTable;
+};
+
 class ToneMapper {
 public:
     virtual ~ToneMapper() {}
@@ -148,6 +186,39 @@ public:
             aidl::android::hardware::graphics::common::Dataspace sourceDataspace,
             aidl::android::hardware::graphics::common::Dataspace destinationDataspace,
             const std::vector<Color>& colors, const Metadata& metadata) = 0;
+
+    // Returns a table of the gains computed by lookupTonemapGain(), for the given dataspaces and
+    // metadata. Tables are cached, so this only evaluates the tonemapping curve again when the
+    // arguments change, e.g. with the display brightness. The metadata attached to
+    // metadata.buffer, if any, is not considered.
+    std::shared_ptr<const GainLut> getTonemapGainLut(
+            aidl::android::hardware::graphics::common::Dataspace sourceDataspace,
+            aidl::android::hardware::graphics::common::Dataspace destinationDataspace,
+            const Metadata& metadata);
+
+protected:
+    // Returns the component of colors that gains computed by lookupTonemapGain() depend on.
+    virtual GainLut::Input getGainLutInput() const { return GainLut::Input::MaxRGB; }
+
+private:
+    struct GainLutKey {
+        aidl::android::hardware::graphics::common::Dataspace sourceDataspace;
+        aidl::android::hardware::graphics::common::Dataspace destinationDataspace;
+        float displayMaxLuminance;
+        float contentMaxLuminance;
+        float currentDisplayLuminance;
+        aidl::android::hardware::graphics::composer3::RenderIntent renderIntent;
+
+        bool operator==(const GainLutKey&) const = default;
+    };
+
+    // Number of tables kept in mGainLuts, enough for transitions between a few displays or
+    // brightness levels.
+    static constexpr size_t kMaxCachedGainLuts = 4;
+
+    std::mutex mGainLutMutex;
+    // Most recently used first.
+    std::vector<std::pair<GainLutKey, std::shared_ptr<const GainLut>>> mGainLuts;
 };
 
 // Retrieves a tonemapper instance.
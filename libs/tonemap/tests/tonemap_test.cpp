@@ -18,6 +18,7 @@
 #include <gtest/gtest.h>
 #include <tonemap/tonemap.h>
 #include <cmath>
+#include <vector>
 
 namespace android {
 
@@ -85,4 +86,64 @@ TEST_F(TonemapTest, generateTonemapGainShaderSkSL_containsEntryPointForHLG) {
     EXPECT_THAT(shader, HasSubstr("float libtonemap_LookupTonemapGain(vec3 linearRGB, vec3 xyz)"));
 }
 
+using aidl::android::hardware::graphics::common::Dataspace;
+
+std::vector<tonemap::Color> makeColors() {
+    std::vector<tonemap::Color> colors;
+    for (float nits = 0.01f; nits < 12000.f; nits *= 1.07f) {
+        colors.push_back({.linearRGB = vec3(nits, nits * 0.5f, nits * 0.25f),
+                          .xyz = vec3(nits * 0.8f, nits, nits * 0.9f)});
+    }
+    colors.push_back({.linearRGB = vec3(0.f), .xyz = vec3(0.f)});
+    colors.push_back({.linearRGB = vec3(-1.f), .xyz = vec3(-1.f)});
+    return colors;
+}
+
+TEST_F(TonemapTest, getTonemapGainLut_matchesLookupTonemapGain) {
+    const tonemap::Metadata metadata{.displayMaxLuminance = 600.f,
+                                     .contentMaxLuminance = 4000.f,
+                                     .currentDisplayLuminance = 300.f};
+    const std::vector<tonemap::Color> colors = makeColors();
+
+    for (const auto& [source, destination] :
+         {std::pair(Dataspace::BT2020_ITU_PQ, Dataspace::DISPLAY_P3),
+          std::pair(Dataspace::BT2020_ITU_HLG, Dataspace::DISPLAY_P3),
+          std::pair(Dataspace::BT2020_ITU_PQ, Dataspace::BT2020_ITU_HLG),
+          std::pair(Dataspace::BT2020_ITU_HLG, Dataspace::BT2020_ITU_PQ),
+          std::pair(Dataspace::DISPLAY_P3, Dataspace::BT2020_ITU_PQ)}) {
+        const auto expected =
+                tonemap::getToneMapper()->lookupTonemapGain(source, destination, colors, metadata);
+        const auto lut = tonemap::getToneMapper()->getTonemapGainLut(source, destination, metadata);
+
+        std::vector<float> gains(colors.size());
+        lut->lookup(colors.data(), gains.data(), colors.size());
+
+        for (size_t i = 0; i < colors.size(); i++) {
+            EXPECT_NEAR(expected[i], gains[i], expected[i] * 1e-2) << "color " << i;
+            EXPECT_EQ(lut->lookup(colors[i]), gains[i]) << "color " << i;
+        }
+    }
+}
+
+TEST_F(TonemapTest, getTonemapGainLut_isCached) {
+    tonemap::Metadata metadata{.displayMaxLuminance = 500.f,
+                               .contentMaxLuminance = 1000.f,
+                               .currentDisplayLuminance = 500.f};
+    auto* const toneMapper = tonemap::getToneMapper();
+
+    const auto lut = toneMapper->getTonemapGainLut(Dataspace::BT2020_ITU_PQ,
+                                                   Dataspace::DISPLAY_P3, metadata);
+    EXPECT_EQ(lut,
+              toneMapper->getTonemapGainLut(Dataspace::BT2020_ITU_PQ, Dataspace::DISPLAY_P3,
+                                            metadata));
+    EXPECT_NE(lut,
+              toneMapper->getTonemapGainLut(Dataspace::BT2020_ITU_HLG, Dataspace::DISPLAY_P3,
+                                            metadata));
+
+    metadata.currentDisplayLuminance = 250.f;
+    EXPECT_NE(lut,
+              toneMapper->getTonemapGainLut(Dataspace::BT2020_ITU_PQ, Dataspace::DISPLAY_P3,
+                                            metadata));
+}
+
 } // namespace android
@@ -18,6 +18,7 @@
 
 #include <algorithm>
 #include <cstdint>
+#include <cstring>
 #include <mutex>
 #include <type_traits>
 
@@ -48,6 +49,29 @@ std::vector<uint8_t> buildUniformValue(T value) {
     return result;
 }
 
+// Gain tables are sampled at floats whose bit patterns are evenly spaced, which places
+// 2^kGainLutStepsPerOctaveLog2 samples in each octave of luminance, from 2^-12 to 2^14 nits. This is
+// dense enough to follow the curves across their whole range, and lets the table be indexed with
+// integer arithmetic on the bits of the input.
+static const constexpr int kGainLutStepsPerOctaveLog2 = 5;
+static const constexpr int kGainLutShift = 23 - kGainLutStepsPerOctaveLog2;
+static const constexpr int32_t kGainLutMinBits = (127 - 12) << 23;
+static const constexpr int32_t kGainLutMaxBits = (127 + 14) << 23;
+static const constexpr size_t kGainLutSize =
+        ((kGainLutMaxBits - kGainLutMinBits) >> kGainLutShift) + 1;
+
+float bitsToFloat(int32_t bits) {
+    float value;
+    std::memcpy(&value, &bits, sizeof(value));
+    return value;
+}
+
+int32_t floatToBits(float value) {
+    int32_t bits;
+    std::memcpy(&bits, &value, sizeof(bits));
+    return bits;
+}
+
 // Refer to BT2100-2
 float computeHlgGamma(float currentDisplayBrightnessNits) {
     // BT 2100-2's recommendation for taking into account the nominal max
@@ -65,6 +89,9 @@ float computeHlgGamma(float currentDisplayBrightnessNits) {
 }
 
 class ToneMapperO : public ToneMapper {
+protected:
+    GainLut::Input getGainLutInput() const override { return GainLut::Input::Luminance; }
+
 public:
     std::string generateTonemapGainShaderSkSL(
             aidl::android::hardware::graphics::common::Dataspace sourceDataspace,
@@ -730,6 +757,109 @@ public:
 
 } // namespace
 
+float GainLut::sample(float value) const {
+    // Negative inputs compare lower than kGainLutMinBits as signed integers, and NaN higher than
+    // kGainLutMaxBits, so the index is always in range.
+    const int32_t offset =
+            std::clamp(floatToBits(value), kGainLutMinBits, kGainLutMaxBits) - kGainLutMinBits;
+    const int32_t index = offset >> kGainLutShift;
+    const float t = static_cast<float>(offset & ((1 << kGainLutShift) - 1)) *
+            (1.f / static_cast<float>(1 << kGainLutShift));
+
+    const float gain = mTable[index] + (mTable[index + 1] - mTable[index]) * t;
+    return value > 0.f ? gain : 1.f;
+}
+
+float GainLut::lookup(const Color& color) const {
+    return sample(mInput == Input::MaxRGB
+                          ? std::max({color.linearRGB.r, color.linearRGB.g, color.linearRGB.b})
+                          : color.xyz.y);
+}
+
+void GainLut::lookup(const Color* colors, float* gains, size_t count) const {
+    // Computing the inputs of a block of colors first leaves only branchless loops over
+    // contiguous floats, which the compiler vectorizes.
+    static const constexpr size_t kBlockSize = 64;
+    float values[kBlockSize];
+
+    for (size_t begin = 0; begin < count; begin += kBlockSize) {
+        const size_t size = std::min(kBlockSize, count - begin);
+        const Color* block = colors + begin;
+
+        if (mInput == Input::MaxRGB) {
+            for (size_t i = 0; i < size; i++) {
+                const vec3& rgb = block[i].linearRGB;
+                values[i] = std::max(rgb.r, std::max(rgb.g, rgb.b));
+            }
+        } else {
+            for (size_t i = 0; i < size; i++) {
+                values[i] = block[i].xyz.y;
+            }
+        }
+
+        for (size_t i = 0; i < size; i++) {
+            gains[begin + i] = sample(values[i]);
+        }
+    }
+}
+
+std::shared_ptr<const GainLut> ToneMapper::getTonemapGainLut(
+        aidl::android::hardware::graphics::common::Dataspace sourceDataspace,
+        aidl::android::hardware::graphics::common::Dataspace destinationDataspace,
+        const Metadata& metadata) {
+    const GainLutKey key{.sourceDataspace = sourceDataspace,
+                         .destinationDataspace = destinationDataspace,
+                         .displayMaxLuminance = metadata.displayMaxLuminance,
+                         .contentMaxLuminance = metadata.contentMaxLuminance,
+                         .currentDisplayLuminance = metadata.currentDisplayLuminance,
+                         .renderIntent = metadata.renderIntent};
+
+    {
+        std::lock_guard lock(mGainLutMutex);
+        const auto it = std::find_if(mGainLuts.begin(), mGainLuts.end(),
+                                     [&key](const auto& entry) { return entry.first == key; });
+        if (it != mGainLuts.end()) {
+            std::rotate(mGainLuts.begin(), it, it + 1);
+            return mGainLuts.front().second;
+        }
+    }
+
+    // Evaluate the curve outside of the lock, with colors whose inputs are the sampled luminances
+    // regardless of getGainLutInput().
+    std::vector<Color> colors;
+    colors.reserve(kGainLutSize);
+    for (size_t i = 0; i < kGainLutSize; i++) {
+        const float value =
+                bitsToFloat(kGainLutMinBits + static_cast<int32_t>(i << kGainLutShift));
+        colors.push_back({.linearRGB = vec3(value), .xyz = vec3(value)});
+    }
+
+    const Metadata lutMetadata{.displayMaxLuminance = metadata.displayMaxLuminance,
+                               .contentMaxLuminance = metadata.contentMaxLuminance,
+                               .currentDisplayLuminance = metadata.currentDisplayLuminance,
+                               .renderIntent = metadata.renderIntent};
+    const std::vector<Gain> gains =
+            lookupTonemapGain(sourceDataspace, destinationDataspace, colors, lutMetadata);
+
+    std::vector<float> table(gains.begin(), gains.end());
+    // Repeat the last gain, to interpolate at the maximum input without a bounds check.
+    table.push_back(table.back());
+    std::shared_ptr<const GainLut> lut(new GainLut(getGainLutInput(), std::move(table)));
+
+    std::lock_guard lock(mGainLutMutex);
+    // Another thread may have cached a table for the same key in the meantime.
+    if (const auto it = std::find_if(mGainLuts.begin(), mGainLuts.end(),
+                                     [&key](const auto& entry) { return entry.first == key; });
+        it != mGainLuts.end()) {
+        return it->second;
+    }
+    mGainLuts.insert(mGainLuts.begin(), {key, lut});
+    if (mGainLuts.size() > kMaxCachedGainLuts) {
+        mGainLuts.pop_back();
+    }
+    return lut;
+}
+
 ToneMapper* getToneMapper() {
     static std::once_flag sOnce;
     static std::unique_ptr<ToneMapper> sToneMapper;
@@ -18,10 +18,30 @@
 
 #include <stdint.h>
 
+#include <atomic>
+
+#include <cutils/trace.h>
+
 namespace tracing_perfetto {
 
+namespace internal {
+
+// Bitmask of the TRACE_CATEGORY_* categories enabled in a Perfetto session. It is updated by
+// Perfetto as sessions start and stop, and may briefly be a superset of the enabled categories.
+extern std::atomic_uint64_t perfetto_enabled_categories;
+
+}  // namespace internal
+
 void registerWithPerfetto(bool test = false);
 
+// Returns whether events in |category| may be traced with either Perfetto or atrace. Unlike
+// isTagEnabled, this is inlined and only reads cached state, so it is cheap enough to guard the
+// arguments of trace calls on hot paths.
+inline bool isCategoryEnabled(uint64_t category) {
+  return (internal::perfetto_enabled_categories.load(std::memory_order_relaxed) & category) ||
+      atrace_is_tag_enabled(category);
+}
+
 void traceBegin(uint64_t category, const char* name);
 
 void traceEnd(uint64_t category);
@@ -30,6 +50,14 @@ void traceAsyncBegin(uint64_t category, const char* name, int32_t cookie);
 
 void traceFormatBegin(uint64_t category, const char* fmt, ...);
 
+// Begins a slice with integer arguments. With Perfetto, the arguments are recorded as debug
+// annotations so that the interned name stays constant. With atrace, they are appended to the name
+// as " argName=value".
+void traceBeginWithArgs(uint64_t category, const char* name, const char* argName, int64_t arg);
+
+void traceBeginWithArgs(uint64_t category, const char* name, const char* arg1Name, int64_t arg1,
+                        const char* arg2Name, int64_t arg2);
+
 void traceAsyncEnd(uint64_t category, const char* name, int32_t cookie);
 
 void traceAsyncBeginForTrack(uint64_t category, const char* name,
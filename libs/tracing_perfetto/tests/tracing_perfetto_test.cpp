@@ -48,6 +48,8 @@
 #include "protos/perfetto/trace/trace.pb.h"
 #include "protos/perfetto/trace/trace_packet.pb.h"
 #include "protos/perfetto/trace/interned_data/interned_data.pb.h"
+#include "protos/perfetto/trace/track_event/debug_annotation.pb.h"
+#include "protos/perfetto/trace/track_event/track_event.pb.h"
 
 #include <fstream>
 #include <iterator>
@@ -223,4 +225,42 @@ TEST_F_WITH_FLAGS(TracingPerfettoTest, traceInstantWithPerfettoAndAtraceConcurre
   verifyAtraceEvent(atrace_trace, event_name);
   verifyAtraceEvent(perfetto_trace, event_name);
 }
+
+TEST_F_WITH_FLAGS(TracingPerfettoTest, isCategoryEnabledWithPerfetto,
+                  REQUIRES_FLAGS_ENABLED(PERFETTO_SDK_TRACING)) {
+  TracingSession tracing_session =
+      TracingSession::Builder().add_enabled_category("input").Build();
+
+  EXPECT_TRUE(tracing_perfetto::isCategoryEnabled(TRACE_CATEGORY_INPUT));
+  EXPECT_EQ(tracing_perfetto::isTagEnabled(TRACE_CATEGORY_INPUT),
+            tracing_perfetto::isCategoryEnabled(TRACE_CATEGORY_INPUT));
+
+  stopSession(tracing_session);
+}
+
+TEST_F_WITH_FLAGS(TracingPerfettoTest, traceBeginWithArgsWithPerfetto,
+                  REQUIRES_FLAGS_ENABLED(PERFETTO_SDK_TRACING)) {
+  std::string event_category = "input";
+  std::string event_name = "traceBeginWithArgsWithPerfetto";
+  constexpr int64_t kArg = 42;
+
+  TracingSession tracing_session =
+      TracingSession::Builder().add_enabled_category(event_category).Build();
+
+  tracing_perfetto::traceBeginWithArgs(TRACE_CATEGORY_INPUT, event_name.c_str(), "arg", kArg);
+  tracing_perfetto::traceEnd(TRACE_CATEGORY_INPUT);
+
+  Trace trace = stopSession(tracing_session);
+
+  verifyTrackEvent(trace, event_category, event_name);
+
+  bool found = false;
+  for (const TracePacket& packet : trace.packet()) {
+    if (!packet.has_track_event()) continue;
+    for (const auto& annotation : packet.track_event().debug_annotations()) {
+      found |= annotation.has_int_value() && annotation.int_value() == kArg;
+    }
+  }
+  EXPECT_TRUE(found);
+}
 }  // namespace tracing_perfetto
@@ -17,7 +17,9 @@
 #include "tracing_perfetto.h"
 
 #include <cutils/trace.h>
+#include <cinttypes>
 #include <cstdarg>
+#include <cstdio>
 
 #include "perfetto/public/te_category_macros.h"
 #include "trace_categories.h"
@@ -65,6 +67,37 @@ void traceFormatBegin(uint64_t category, const char* fmt, ...) {
   }
 }
 
+void traceBeginWithArgs(uint64_t category, const char* name, const char* argName, int64_t arg) {
+  struct PerfettoTeCategory* perfettoTeCategory =
+      internal::toPerfettoCategory(category);
+
+  if (internal::shouldPreferAtrace(perfettoTeCategory, category)) {
+    const int BUFFER_SIZE = 256;
+    char buf[BUFFER_SIZE];
+    snprintf(buf, BUFFER_SIZE, "%s %s=%" PRId64, name, argName, arg);
+    atrace_begin(category, buf);
+  } else if (internal::isPerfettoCategoryEnabled(perfettoTeCategory)) {
+    internal::perfettoTraceBeginWithArgs(*perfettoTeCategory, name, argName, arg);
+  }
+}
+
+void traceBeginWithArgs(uint64_t category, const char* name, const char* arg1Name, int64_t arg1,
+                        const char* arg2Name, int64_t arg2) {
+  struct PerfettoTeCategory* perfettoTeCategory =
+      internal::toPerfettoCategory(category);
+
+  if (internal::shouldPreferAtrace(perfettoTeCategory, category)) {
+    const int BUFFER_SIZE = 256;
+    char buf[BUFFER_SIZE];
+    snprintf(buf, BUFFER_SIZE, "%s %s=%" PRId64 " %s=%" PRId64, name, arg1Name, arg1, arg2Name,
+             arg2);
+    atrace_begin(category, buf);
+  } else if (internal::isPerfettoCategoryEnabled(perfettoTeCategory)) {
+    internal::perfettoTraceBeginWithArgs(*perfettoTeCategory, name, arg1Name, arg1, arg2Name,
+                                         arg2);
+  }
+}
+
 void traceEnd(uint64_t category) {
   struct PerfettoTeCategory* perfettoTeCategory =
       internal::toPerfettoCategory(category);
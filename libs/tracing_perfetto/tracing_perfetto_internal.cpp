@@ -45,6 +45,7 @@
   C(thermal, "thermal", "Thermal category")
 
 #include <atomic>
+#include <iterator>
 #include <mutex>
 
 #include <android_os.h>
@@ -58,6 +59,7 @@
 #include "perfetto/public/te_macros.h"
 #include "perfetto/public/track_event.h"
 #include "trace_categories.h"
+#include "tracing_perfetto.h"
 #include "tracing_perfetto_internal.h"
 
 #ifdef __BIONIC__
@@ -69,6 +71,8 @@ namespace tracing_perfetto {
 
 namespace internal {
 
+std::atomic_uint64_t perfetto_enabled_categories = 0;
+
 namespace {
 PERFETTO_TE_CATEGORIES_DECLARE(FRAMEWORK_CATEGORIES);
 
@@ -95,66 +99,37 @@ static uint32_t system_property_serial(const prop_info* pi [[maybe_unused]]) {
   return last_prefer_seq_num;
 }
 
+#define CATEGORY_POINTER(name, ...) &name,
+
+// Indexed by the bit of the corresponding TRACE_CATEGORY_*, in the same order.
+struct PerfettoTeCategory* const kCategories[] = {FRAMEWORK_CATEGORIES(CATEGORY_POINTER)};
+
+#undef CATEGORY_POINTER
+
+static_assert(std::size(kCategories) == __builtin_ctzll(TRACE_CATEGORY_THERMAL) + 1,
+              "FRAMEWORK_CATEGORIES must match trace_categories.h");
+
 struct PerfettoTeCategory* toCategory(uint64_t inCategory) {
-  switch (inCategory) {
-    case TRACE_CATEGORY_ALWAYS:
-      return &always;
-    case TRACE_CATEGORY_GRAPHICS:
-      return &graphics;
-    case TRACE_CATEGORY_INPUT:
-      return &input;
-    case TRACE_CATEGORY_VIEW:
-      return &view;
-    case TRACE_CATEGORY_WEBVIEW:
-      return &webview;
-    case TRACE_CATEGORY_WINDOW_MANAGER:
-      return &windowmanager;
-    case TRACE_CATEGORY_ACTIVITY_MANAGER:
-      return &activitymanager;
-    case TRACE_CATEGORY_SYNC_MANAGER:
-      return &syncmanager;
-    case TRACE_CATEGORY_AUDIO:
-      return &audio;
-    case TRACE_CATEGORY_VIDEO:
-      return &video;
-    case TRACE_CATEGORY_CAMERA:
-      return &camera;
-    case TRACE_CATEGORY_HAL:
-      return &hal;
-    case TRACE_CATEGORY_APP:
-      return &app;
-    case TRACE_CATEGORY_RESOURCES:
-      return &resources;
-    case TRACE_CATEGORY_DALVIK:
-      return &dalvik;
-    case TRACE_CATEGORY_RS:
-      return &rs;
-    case TRACE_CATEGORY_BIONIC:
-      return &bionic;
-    case TRACE_CATEGORY_POWER:
-      return &power;
-    case TRACE_CATEGORY_PACKAGE_MANAGER:
-      return &packagemanager;
-    case TRACE_CATEGORY_SYSTEM_SERVER:
-      return &systemserver;
-    case TRACE_CATEGORY_DATABASE:
-      return &database;
-    case TRACE_CATEGORY_NETWORK:
-      return &network;
-    case TRACE_CATEGORY_ADB:
-      return &adb;
-    case TRACE_CATEGORY_VIBRATOR:
-      return &vibrator;
-    case TRACE_CATEGORY_AIDL:
-      return &aidl;
-    case TRACE_CATEGORY_NNAPI:
-      return &nnapi;
-    case TRACE_CATEGORY_RRO:
-      return &rro;
-    case TRACE_CATEGORY_THERMAL:
-      return &thermal;
-    default:
-      return nullptr;
+  // Only single categories map to a Perfetto category.
+  if (inCategory == 0 || (inCategory & (inCategory - 1)) != 0) {
+    return nullptr;
+  }
+
+  const size_t index = __builtin_ctzll(inCategory);
+  return index < std::size(kCategories) ? kCategories[index] : nullptr;
+}
+
+void onCategoryStateChanged(struct PerfettoTeCategoryImpl*, PerfettoDsInstanceIndex,
+                            bool created, bool global_state_changed, void* user_arg) {
+  if (!global_state_changed) {
+    return;
+  }
+
+  const uint64_t category = reinterpret_cast<uintptr_t>(user_arg);
+  if (created) {
+    perfetto_enabled_categories.fetch_or(category, std::memory_order_relaxed);
+  } else {
+    perfetto_enabled_categories.fetch_and(~category, std::memory_order_relaxed);
   }
 }
 
@@ -217,6 +192,12 @@ bool shouldPreferAtrace(PerfettoTeCategory *perfettoCategory, uint64_t atraceCat
 }
 
 struct PerfettoTeCategory* toPerfettoCategory(uint64_t category) {
+  // Filter on the cached bitmask first, so that disabled categories cost a single load.
+  if (PERFETTO_LIKELY(
+          (perfetto_enabled_categories.load(std::memory_order_relaxed) & category) == 0)) {
+    return nullptr;
+  }
+
   struct PerfettoTeCategory* perfettoCategory = toCategory(category);
   if (perfettoCategory == nullptr) {
     return nullptr;
@@ -239,6 +220,17 @@ void registerWithPerfetto(bool test) {
     PerfettoProducerInit(args);
     PerfettoTeInit();
     PERFETTO_TE_REGISTER_CATEGORIES(FRAMEWORK_CATEGORIES);
+
+    for (size_t i = 0; i < std::size(kCategories); i++) {
+      const uint64_t category = uint64_t{1} << i;
+      PerfettoTeCategoryImplSetCallback(kCategories[i]->impl, onCategoryStateChanged,
+                                        reinterpret_cast<void*>(static_cast<uintptr_t>(category)));
+
+      // Account for a session that started before the callback was set.
+      if (PERFETTO_ATOMIC_LOAD_EXPLICIT(kCategories[i]->enabled, PERFETTO_MEMORY_ORDER_RELAXED)) {
+        perfetto_enabled_categories.fetch_or(category, std::memory_order_relaxed);
+      }
+    }
   });
 }
 
@@ -246,6 +238,18 @@ void perfettoTraceBegin(const struct PerfettoTeCategory& category, const char* n
   PERFETTO_TE(category, PERFETTO_TE_SLICE_BEGIN(name));
 }
 
+void perfettoTraceBeginWithArgs(const struct PerfettoTeCategory& category, const char* name,
+                                const char* argName, int64_t arg) {
+  PERFETTO_TE(category, PERFETTO_TE_SLICE_BEGIN(name), PERFETTO_TE_ARG_INT64(argName, arg));
+}
+
+void perfettoTraceBeginWithArgs(const struct PerfettoTeCategory& category, const char* name,
+                                const char* arg1Name, int64_t arg1, const char* arg2Name,
+                                int64_t arg2) {
+  PERFETTO_TE(category, PERFETTO_TE_SLICE_BEGIN(name), PERFETTO_TE_ARG_INT64(arg1Name, arg1),
+              PERFETTO_TE_ARG_INT64(arg2Name, arg2));
+}
+
 void perfettoTraceEnd(const struct PerfettoTeCategory& category) {
   PERFETTO_TE(category, PERFETTO_TE_SLICE_END());
 }
@@ -33,6 +33,13 @@ void registerWithPerfetto(bool test = false);
 
 void perfettoTraceBegin(const struct PerfettoTeCategory& category, const char* name);
 
+void perfettoTraceBeginWithArgs(const struct PerfettoTeCategory& category, const char* name,
+                                const char* argName, int64_t arg);
+
+void perfettoTraceBeginWithArgs(const struct PerfettoTeCategory& category, const char* name,
+                                const char* arg1Name, int64_t arg1, const char* arg2Name,
+                                int64_t arg2);
+
 void perfettoTraceEnd(const struct PerfettoTeCategory& category);
 
 void perfettoTraceAsyncBegin(const struct PerfettoTeCategory& category, const char* name,
@@ -21,7 +21,9 @@
 #include <cutils/compiler.h>  // For CC_[UN]LIKELY
 #include <utils/Log.h>
 #include <inttypes.h>
+#include <poll.h>
 #include <stdlib.h>
+#include <unistd.h>
 
 #include <memory>
 
@@ -171,6 +173,50 @@ nsecs_t FenceTime::getSignalTime() {
     return signalTime;
 }
 
+void FenceTime::updateSignalTimes(const std::vector<FenceTime*>& fenceTimes) {
+    std::vector<FenceTime*> pending;
+    std::vector<sp<Fence>> fences;
+    std::vector<pollfd> pollFds;
+    for (FenceTime* fenceTime : fenceTimes) {
+        if (!fenceTime ||
+            fenceTime->mSignalTime.load(std::memory_order_relaxed) != Fence::SIGNAL_TIME_PENDING) {
+            continue;
+        }
+
+        // Hold references to the fences so that their fds stay open until
+        // the poll returns, as in getSignalTime().
+        sp<Fence> fence;
+        {
+            std::lock_guard<std::mutex> lock(fenceTime->mMutex);
+            fence = fenceTime->mFence;
+        }
+        if (!fence.get()) {
+            // Another thread set the signal time just before we checked.
+            continue;
+        }
+        if (fence->get() < 0 || CC_UNLIKELY(fenceTime->mState == State::FORCED_VALID_FOR_TEST)) {
+            // There is nothing to poll, e.g. for mocked fences.
+            fenceTime->getSignalTime();
+            continue;
+        }
+        pending.push_back(fenceTime);
+        fences.push_back(std::move(fence));
+        pollFds.push_back({fences.back()->get(), POLLIN, 0});
+    }
+    if (pollFds.empty()) {
+        return;
+    }
+
+    int ret = TEMP_FAILURE_RETRY(poll(pollFds.data(), pollFds.size(), 0));
+    for (size_t i = 0; i < pending.size(); i++) {
+        // Query each fence if the poll failed, so that errors are handled by
+        // getSignalTime() as they would be without batching.
+        if (ret < 0 || pollFds[i].revents != 0) {
+            pending[i]->getSignalTime();
+        }
+    }
+}
+
 nsecs_t FenceTime::getCachedSignalTime() const {
     // memory_order_acquire since we don't have a lock fallback path
     // that will do an acquire.
@@ -96,13 +96,17 @@ void GraphicBufferAllocator::dump(std::string& result, bool less) const {
         std::string sizeStr = (rec.size)
                 ? base::StringPrintf("%7.2f KiB", static_cast<double>(rec.size) / 1024.0)
                 : "unknown";
-        StringAppendF(&result, "%14p | %11s | %4u (%4u) x %4u | %6u | %8X | 0x%8" PRIx64 " | %s\n",
+        StringAppendF(&result,
+                      "%14p | %11s | %4u (%4u) x %4u | %6u | %8X | 0x%8" PRIx64 " | %s%s\n",
                       list.keyAt(i), sizeStr.c_str(), rec.width, rec.stride, rec.height,
-                      rec.layerCount, rec.format, rec.usage, rec.requestorName.c_str());
+                      rec.layerCount, rec.format, rec.usage, rec.requestorName.c_str(),
+                      rec.recycled ? " (recycled)" : "");
         total += rec.size;
     }
     StringAppendF(&result, "Total allocated by GraphicBufferAllocator (estimate): %.2f KB\n",
                   static_cast<double>(total) / 1024.0);
+    StringAppendF(&result, "Kept for recycling: %zu buffers, %.2f KB\n", mRecycledBuffers.size(),
+                  static_cast<double>(mRecycledSize) / 1024.0);
 
     result.append(mAllocator->dumpDebugInfo(less));
 }
@@ -134,18 +138,36 @@ auto GraphicBufferAllocator::allocate(const AllocationRequest& request) -> Alloc
         return AllocationResult(BAD_VALUE);
     }
 
-    auto result = mAllocator->allocate(request);
-    if (result.status == UNKNOWN_TRANSACTION) {
-        if (!request.extras.empty()) {
-            ALOGE("Failed to allocate with additional options, allocator version mis-match? "
-                  "gralloc version = %d",
-                  (int)mMapper.getMapperVersion());
-            return result;
+    const bool recyclable = request.recyclable && request.importBuffer && request.extras.empty();
+    if (recyclable) {
+        if (auto result = recycle(request)) {
+            return *result;
         }
-        // If there's no additional options, fall back to previous allocate version
-        result.status = mAllocator->allocate(request.requestorName, request.width, request.height,
-                                             request.format, request.layerCount, request.usage,
-                                             &result.stride, &result.handle, request.importBuffer);
+    }
+
+    const auto allocateFromGralloc = [&] {
+        auto result = mAllocator->allocate(request);
+        if (result.status == UNKNOWN_TRANSACTION && request.extras.empty()) {
+            // If there's no additional options, fall back to previous allocate version
+            result.status = mAllocator->allocate(request.requestorName, request.width,
+                                                 request.height, request.format,
+                                                 request.layerCount, request.usage,
+                                                 &result.stride, &result.handle,
+                                                 request.importBuffer);
+        }
+        return result;
+    };
+
+    auto result = allocateFromGralloc();
+    if (result.status == NO_MEMORY && trimRecycledBuffers() > 0) {
+        result = allocateFromGralloc();
+    }
+
+    if (result.status == UNKNOWN_TRANSACTION && !request.extras.empty()) {
+        ALOGE("Failed to allocate with additional options, allocator version mis-match? "
+              "gralloc version = %d",
+              (int)mMapper.getMapperVersion());
+        return result;
     }
 
     if (result.status != NO_ERROR) {
@@ -159,6 +181,7 @@ auto GraphicBufferAllocator::allocate(const AllocationRequest& request) -> Alloc
     if (!request.importBuffer) {
         return result;
     }
+    mMapper.onBufferImported(result.handle);
     size_t bufSize;
 
     // if stride has no meaning or is too large,
@@ -181,6 +204,7 @@ auto GraphicBufferAllocator::allocate(const AllocationRequest& request) -> Alloc
     rec.usage = request.usage;
     rec.size = bufSize;
     rec.requestorName = request.requestorName;
+    rec.recyclable = recyclable;
     list.add(result.handle, rec);
 
     return result;
@@ -215,6 +239,10 @@ status_t GraphicBufferAllocator::allocateHelper(uint32_t width, uint32_t height,
 
     status_t error = mAllocator->allocate(requestorName, width, height, format, layerCount, usage,
                                           stride, handle, importBuffer);
+    if (error == NO_MEMORY && trimRecycledBuffers() > 0) {
+        error = mAllocator->allocate(requestorName, width, height, format, layerCount, usage,
+                                     stride, handle, importBuffer);
+    }
     if (error != NO_ERROR) {
         ALOGE("Failed to allocate (%u x %u) layerCount %u format %d "
               "usage %" PRIx64 ": %d",
@@ -225,6 +253,7 @@ status_t GraphicBufferAllocator::allocateHelper(uint32_t width, uint32_t height,
     if (!importBuffer) {
         return NO_ERROR;
     }
+    mMapper.onBufferImported(*handle);
     size_t bufSize;
 
     // if stride has no meaning or is too large,
@@ -280,17 +309,104 @@ status_t GraphicBufferAllocator::free(buffer_handle_t handle)
 {
     ATRACE_CALL();
 
-    // We allocated a buffer from the allocator and imported it into the
-    // mapper to get the handle.  We just need to free the handle now.
-    mMapper.freeBuffer(handle);
+    std::vector<buffer_handle_t> evicted;
+    {
+        Mutex::Autolock _l(sLock);
+        const ssize_t index = sAllocList.indexOfKey(handle);
+        if (index >= 0 && sAllocList.valueAt(index).recyclable) {
+            // Keep the buffer imported, for the next request with the same parameters.
+            alloc_rec_t& rec = sAllocList.editValueAt(index);
+            rec.recycled = true;
+            mRecycledBuffers.push_back({handle, systemTime()});
+            mRecycledSize += rec.size;
+            evictRecycledBuffersLocked(false, &evicted);
+            handle = nullptr;
+        }
+    }
+
+    if (handle) {
+        // We allocated a buffer from the allocator and imported it into the
+        // mapper to get the handle.  We just need to free the handle now.
+        mMapper.freeBuffer(handle);
 
-    Mutex::Autolock _l(sLock);
-    KeyedVector<buffer_handle_t, alloc_rec_t>& list(sAllocList);
-    list.removeItem(handle);
+        Mutex::Autolock _l(sLock);
+        KeyedVector<buffer_handle_t, alloc_rec_t>& list(sAllocList);
+        list.removeItem(handle);
+    }
+
+    for (buffer_handle_t evictedHandle : evicted) {
+        mMapper.freeBuffer(evictedHandle);
+    }
 
     return NO_ERROR;
 }
 
+auto GraphicBufferAllocator::recycle(const AllocationRequest& request)
+        -> std::optional<AllocationResult> {
+    std::optional<AllocationResult> result;
+    std::vector<buffer_handle_t> evicted;
+    {
+        Mutex::Autolock _l(sLock);
+        evictRecycledBuffersLocked(false, &evicted);
+
+        // Prefer the most recently freed buffer.
+        for (auto it = mRecycledBuffers.rbegin(); it != mRecycledBuffers.rend(); ++it) {
+            alloc_rec_t& rec = sAllocList.editValueFor(it->handle);
+            if (rec.width != request.width || rec.height != request.height ||
+                rec.format != request.format || rec.layerCount != request.layerCount ||
+                rec.usage != request.usage) {
+                continue;
+            }
+
+            rec.recycled = false;
+            rec.requestorName = request.requestorName;
+            mRecycledSize -= rec.size;
+            result.emplace(it->handle, rec.stride);
+            mRecycledBuffers.erase(std::next(it).base());
+            break;
+        }
+    }
+
+    for (buffer_handle_t evictedHandle : evicted) {
+        mMapper.freeBuffer(evictedHandle);
+    }
+
+    return result;
+}
+
+void GraphicBufferAllocator::evictRecycledBuffersLocked(bool trimAll,
+                                                        std::vector<buffer_handle_t>* outHandles) {
+    const nsecs_t now = systemTime();
+    while (!mRecycledBuffers.empty()) {
+        const recycled_buffer_t& oldest = mRecycledBuffers.front();
+        if (!trimAll && mRecycledBuffers.size() <= kMaxRecycledBuffers &&
+            mRecycledSize <= kMaxRecycledSize && now - oldest.freeTime <= kMaxRecycledAge) {
+            break;
+        }
+
+        mRecycledSize -= sAllocList.valueFor(oldest.handle).size;
+        sAllocList.removeItem(oldest.handle);
+        outHandles->push_back(oldest.handle);
+        mRecycledBuffers.erase(mRecycledBuffers.begin());
+    }
+}
+
+size_t GraphicBufferAllocator::trimRecycledBuffers() {
+    ATRACE_CALL();
+
+    std::vector<buffer_handle_t> evicted;
+    {
+        Mutex::Autolock _l(sLock);
+        evictRecycledBuffersLocked(true, &evicted);
+    }
+
+    for (buffer_handle_t evictedHandle : evicted) {
+        mMapper.freeBuffer(evictedHandle);
+    }
+
+    return evicted.size();
+}
+
 bool GraphicBufferAllocator::supportsAdditionalOptions() const {
     return mAllocator->supportsAdditionalOptions();
 }
@@ -114,6 +114,7 @@ status_t GraphicBufferMapper::importBuffer(const native_handle_t* rawHandle, uin
         return static_cast<status_t>(error);
     }
 
+    onBufferImported(bufferHandle);
     *outHandle = bufferHandle;
 
     return NO_ERROR;
@@ -121,7 +122,16 @@ status_t GraphicBufferMapper::importBuffer(const native_handle_t* rawHandle, uin
 
 status_t GraphicBufferMapper::importBufferNoValidate(const native_handle_t* rawHandle,
                                                      buffer_handle_t* outHandle) {
-    return mMapper->importBuffer(rawHandle, outHandle);
+    const status_t error = mMapper->importBuffer(rawHandle, outHandle);
+    if (error == NO_ERROR) {
+        onBufferImported(*outHandle);
+    }
+    return error;
+}
+
+void GraphicBufferMapper::onBufferImported(buffer_handle_t bufferHandle) {
+    std::lock_guard lock(mBufferInfoMutex);
+    mBufferInfos[bufferHandle] = {};
 }
 
 void GraphicBufferMapper::getTransportSize(buffer_handle_t handle,
@@ -134,6 +144,10 @@ status_t GraphicBufferMapper::freeBuffer(buffer_handle_t handle)
 {
     ATRACE_CALL();
 
+    {
+        std::lock_guard lock(mBufferInfoMutex);
+        mBufferInfos.erase(handle);
+    }
     mMapper->freeBuffer(handle);
 
     return NO_ERROR;
@@ -229,8 +243,42 @@ status_t GraphicBufferMapper::isSupported(uint32_t width, uint32_t height,
     return mMapper->isSupported(width, height, format, layerCount, usage, outSupported);
 }
 
+template <typename T>
+status_t GraphicBufferMapper::getCachedBufferInfo(
+        buffer_handle_t bufferHandle, std::optional<T> CachedBufferInfo::*field,
+        status_t (GrallocMapper::*get)(buffer_handle_t, T*) const, T* outValue) {
+    {
+        std::lock_guard lock(mBufferInfoMutex);
+        const auto it = mBufferInfos.find(bufferHandle);
+        if (it == mBufferInfos.end()) {
+            return (mMapper.get()->*get)(bufferHandle, outValue);
+        }
+        if (const std::optional<T>& value = it->second.*field) {
+            *outValue = *value;
+            return OK;
+        }
+    }
+
+    // Don't hold the lock while calling into the mapper.
+    T value;
+    const status_t status = (mMapper.get()->*get)(bufferHandle, &value);
+    if (status != OK) {
+        return status;
+    }
+
+    {
+        std::lock_guard lock(mBufferInfoMutex);
+        if (const auto it = mBufferInfos.find(bufferHandle); it != mBufferInfos.end()) {
+            it->second.*field = value;
+        }
+    }
+    *outValue = std::move(value);
+    return OK;
+}
+
 status_t GraphicBufferMapper::getBufferId(buffer_handle_t bufferHandle, uint64_t* outBufferId) {
-    return mMapper->getBufferId(bufferHandle, outBufferId);
+    return getCachedBufferInfo(bufferHandle, &CachedBufferInfo::bufferId,
+                               &GrallocMapper::getBufferId, outBufferId);
 }
 
 status_t GraphicBufferMapper::getName(buffer_handle_t bufferHandle, std::string* outName) {
@@ -238,39 +286,47 @@ status_t GraphicBufferMapper::getName(buffer_handle_t bufferHandle, std::string*
 }
 
 status_t GraphicBufferMapper::getWidth(buffer_handle_t bufferHandle, uint64_t* outWidth) {
-    return mMapper->getWidth(bufferHandle, outWidth);
+    return getCachedBufferInfo(bufferHandle, &CachedBufferInfo::width, &GrallocMapper::getWidth,
+                               outWidth);
 }
 
 status_t GraphicBufferMapper::getHeight(buffer_handle_t bufferHandle, uint64_t* outHeight) {
-    return mMapper->getHeight(bufferHandle, outHeight);
+    return getCachedBufferInfo(bufferHandle, &CachedBufferInfo::height, &GrallocMapper::getHeight,
+                               outHeight);
 }
 
 status_t GraphicBufferMapper::getLayerCount(buffer_handle_t bufferHandle, uint64_t* outLayerCount) {
-    return mMapper->getLayerCount(bufferHandle, outLayerCount);
+    return getCachedBufferInfo(bufferHandle, &CachedBufferInfo::layerCount,
+                               &GrallocMapper::getLayerCount, outLayerCount);
 }
 
 status_t GraphicBufferMapper::getPixelFormatRequested(buffer_handle_t bufferHandle,
                                                       ui::PixelFormat* outPixelFormatRequested) {
-    return mMapper->getPixelFormatRequested(bufferHandle, outPixelFormatRequested);
+    return getCachedBufferInfo(bufferHandle, &CachedBufferInfo::pixelFormatRequested,
+                               &GrallocMapper::getPixelFormatRequested, outPixelFormatRequested);
 }
 
 status_t GraphicBufferMapper::getPixelFormatFourCC(buffer_handle_t bufferHandle,
                                                    uint32_t* outPixelFormatFourCC) {
-    return mMapper->getPixelFormatFourCC(bufferHandle, outPixelFormatFourCC);
+    return getCachedBufferInfo(bufferHandle, &CachedBufferInfo::pixelFormatFourCC,
+                               &GrallocMapper::getPixelFormatFourCC, outPixelFormatFourCC);
 }
 
 status_t GraphicBufferMapper::getPixelFormatModifier(buffer_handle_t bufferHandle,
                                                      uint64_t* outPixelFormatModifier) {
-    return mMapper->getPixelFormatModifier(bufferHandle, outPixelFormatModifier);
+    return getCachedBufferInfo(bufferHandle, &CachedBufferInfo::pixelFormatModifier,
+                               &GrallocMapper::getPixelFormatModifier, outPixelFormatModifier);
 }
 
 status_t GraphicBufferMapper::getUsage(buffer_handle_t bufferHandle, uint64_t* outUsage) {
-    return mMapper->getUsage(bufferHandle, outUsage);
+    return getCachedBufferInfo(bufferHandle, &CachedBufferInfo::usage, &GrallocMapper::getUsage,
+                               outUsage);
 }
 
 status_t GraphicBufferMapper::getAllocationSize(buffer_handle_t bufferHandle,
                                                 uint64_t* outAllocationSize) {
-    return mMapper->getAllocationSize(bufferHandle, outAllocationSize);
+    return getCachedBufferInfo(bufferHandle, &CachedBufferInfo::allocationSize,
+                               &GrallocMapper::getAllocationSize, outAllocationSize);
 }
 
 status_t GraphicBufferMapper::getProtectedContent(buffer_handle_t bufferHandle,
@@ -313,13 +369,14 @@ status_t GraphicBufferMapper::getChromaSiting(buffer_handle_t bufferHandle,
 
 status_t GraphicBufferMapper::getPlaneLayouts(buffer_handle_t bufferHandle,
                                               std::vector<ui::PlaneLayout>* outPlaneLayouts) {
-    return mMapper->getPlaneLayouts(bufferHandle, outPlaneLayouts);
+    return getCachedBufferInfo(bufferHandle, &CachedBufferInfo::planeLayouts,
+                               &GrallocMapper::getPlaneLayouts, outPlaneLayouts);
 }
 
 ui::Result<std::vector<ui::PlaneLayout>> GraphicBufferMapper::getPlaneLayouts(
         buffer_handle_t bufferHandle) {
     std::vector<ui::PlaneLayout> temp;
-    status_t status = mMapper->getPlaneLayouts(bufferHandle, &temp);
+    status_t status = getPlaneLayouts(bufferHandle, &temp);
     if (status == OK) {
         return std::move(temp);
     } else {
@@ -381,5 +438,47 @@ status_t GraphicBufferMapper::setSmpte2094_10(buffer_handle_t bufferHandle,
     return mMapper->setSmpte2094_10(bufferHandle, smpte2094_10);
 }
 
+ui::Result<GraphicBufferMapper::BufferInfo> GraphicBufferMapper::getBufferInfo(
+        buffer_handle_t bufferHandle) {
+    ATRACE_CALL();
+
+    BufferInfo info;
+    status_t status = getBufferId(bufferHandle, &info.bufferId);
+    if (status == OK) status = getWidth(bufferHandle, &info.width);
+    if (status == OK) status = getHeight(bufferHandle, &info.height);
+    if (status == OK) status = getLayerCount(bufferHandle, &info.layerCount);
+    if (status == OK) status = getPixelFormatRequested(bufferHandle, &info.pixelFormatRequested);
+    if (status == OK) status = getPixelFormatFourCC(bufferHandle, &info.pixelFormatFourCC);
+    if (status == OK) status = getPixelFormatModifier(bufferHandle, &info.pixelFormatModifier);
+    if (status == OK) status = getUsage(bufferHandle, &info.usage);
+    if (status == OK) status = getAllocationSize(bufferHandle, &info.allocationSize);
+    if (status == OK) status = getPlaneLayouts(bufferHandle, &info.planeLayouts);
+
+    if (status != OK) {
+        return base::unexpected(ui::Error::statusToCode(status));
+    }
+    return info;
+}
+
+ui::Result<GraphicBufferMapper::LockedPlanes> GraphicBufferMapper::lockPlanes(
+        buffer_handle_t handle, int64_t usage, const Rect& bounds, unique_fd&& acquireFence) {
+    ATRACE_CALL();
+
+    LockedPlanes result;
+    status_t status = getPlaneLayouts(handle, &result.planeLayouts);
+    if (status != OK) {
+        return base::unexpected(ui::Error::statusToCode(status));
+    }
+
+    int32_t bytesPerPixel;
+    int32_t bytesPerStride;
+    status = mMapper->lock(handle, usage, bounds, acquireFence.release(), &result.address,
+                           &bytesPerPixel, &bytesPerStride);
+    if (status != OK) {
+        return base::unexpected(ui::Error::statusToCode(status));
+    }
+    return result;
+}
+
 // ---------------------------------------------------------------------------
 }; // namespace android
@@ -18,6 +18,7 @@
 
 #include <inttypes.h>
 #include <limits.h>
+#include <stddef.h>
 
 #include <android-base/stringprintf.h>
 
@@ -45,6 +46,12 @@
 #include <core/SkRegion.h>
 #endif
 
+#if defined(__aarch64__)
+#include <arm_neon.h>
+#elif defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
 namespace android {
 // ----------------------------------------------------------------------------
 
@@ -66,14 +73,96 @@ const Region Region::INVALID_REGION(Rect::INVALID_RECT);
 
 // ----------------------------------------------------------------------------
 
+// The per-rect loops below treat a Rect as one 128-bit vector of its four edges, in the order
+// {left, top, right, bottom}.
+static_assert(sizeof(Rect) == 4 * sizeof(int32_t));
+static_assert(offsetof(Rect, left) == 0 && offsetof(Rect, top) == 4 &&
+              offsetof(Rect, right) == 8 && offsetof(Rect, bottom) == 12);
+
+// Returns true if every rect in p has the same left and right edges as the rect at the same index
+// in q, which is how the rasterizer decides whether two adjacent spans can be merged vertically.
+static inline bool haveSameColumns(const Rect* p, const Rect* q, size_t count) {
+#if defined(__aarch64__)
+    const uint32x4_t columns = {~0u, 0, ~0u, 0};
+    for (size_t i = 0; i < count; i++) {
+        const uint32x4_t equal = vceqq_s32(vld1q_s32(&p[i].left), vld1q_s32(&q[i].left));
+        if (vmaxvq_u32(vbicq_u32(columns, equal))) return false;
+    }
+    return true;
+#elif defined(__SSE2__)
+    // One bit per byte of the comparison, so the columns are bytes 0-3 and 8-11.
+    constexpr int kColumns = 0x0F0F;
+    for (size_t i = 0; i < count; i++) {
+        const __m128i equal =
+                _mm_cmpeq_epi32(_mm_loadu_si128(reinterpret_cast<const __m128i*>(&p[i])),
+                                _mm_loadu_si128(reinterpret_cast<const __m128i*>(&q[i])));
+        if ((_mm_movemask_epi8(equal) & kColumns) != kColumns) return false;
+    }
+    return true;
+#else
+    for (size_t i = 0; i < count; i++) {
+        if ((p[i].left != q[i].left) || (p[i].right != q[i].right)) return false;
+    }
+    return true;
+#endif
+}
+
+// Sets the bottom edge of every rect.
+static inline void setBottoms(Rect* rects, size_t count, int32_t bottom) {
+#if defined(__aarch64__)
+    const uint32x4_t bottoms = {0, 0, 0, ~0u};
+    const int32x4_t value = vdupq_n_s32(bottom);
+    for (size_t i = 0; i < count; i++) {
+        int32_t* const rect = &rects[i].left;
+        vst1q_s32(rect, vbslq_s32(bottoms, value, vld1q_s32(rect)));
+    }
+#elif defined(__SSE2__)
+    const __m128i bottoms = _mm_set_epi32(-1, 0, 0, 0);
+    const __m128i value = _mm_and_si128(bottoms, _mm_set1_epi32(bottom));
+    for (size_t i = 0; i < count; i++) {
+        __m128i* const rect = reinterpret_cast<__m128i*>(&rects[i]);
+        _mm_storeu_si128(rect, _mm_or_si128(_mm_andnot_si128(bottoms, _mm_loadu_si128(rect)),
+                                            value));
+    }
+#else
+    for (size_t i = 0; i < count; i++) {
+        rects[i].bottom = bottom;
+    }
+#endif
+}
+
+// Offsets every rect by (dx, dy).
+static inline void offsetRects(Rect* rects, size_t count, int32_t dx, int32_t dy) {
+#if defined(__aarch64__)
+    const int32x4_t offset = {dx, dy, dx, dy};
+    for (size_t i = 0; i < count; i++) {
+        int32_t* const rect = &rects[i].left;
+        vst1q_s32(rect, vaddq_s32(vld1q_s32(rect), offset));
+    }
+#elif defined(__SSE2__)
+    const __m128i offset = _mm_set_epi32(dy, dx, dy, dx);
+    for (size_t i = 0; i < count; i++) {
+        __m128i* const rect = reinterpret_cast<__m128i*>(&rects[i]);
+        _mm_storeu_si128(rect, _mm_add_epi32(_mm_loadu_si128(rect), offset));
+    }
+#else
+    for (size_t i = 0; i < count; i++) {
+        rects[i].offsetBy(dx, dy);
+    }
+#endif
+}
+
+// ----------------------------------------------------------------------------
+
 Region::Region() {
     mStorage.push_back(Rect(0, 0));
 }
 
-Region::Region(const Region& rhs)
+Region::Region(const Region& rhs) : mSharedStorage(rhs.mSharedStorage)
 {
-    mStorage.clear();
-    mStorage.insert(mStorage.begin(), rhs.mStorage.begin(), rhs.mStorage.end());
+    if (!mSharedStorage) {
+        mStorage.insert(mStorage.begin(), rhs.mStorage.begin(), rhs.mStorage.end());
+    }
 #if defined(VALIDATE_REGIONS)
     validate(rhs, "rhs copy-ctor");
 #endif
@@ -210,6 +299,7 @@ Region Region::createTJunctionFreeRegion(const Region& r) {
                                    outputRegion.mStorage, direction_LTR);
     outputRegion.mStorage.push_back(
             r.getBounds()); // to make region valid, mStorage must end with bounds
+    outputRegion.shareStorage();
 
 #if defined(VALIDATE_REGIONS)
     validate(outputRegion, "T-Junction free region");
@@ -230,15 +320,18 @@ Region& Region::operator = (const Region& rhs)
     }
 
     mStorage.clear();
-    mStorage.insert(mStorage.begin(), rhs.mStorage.begin(), rhs.mStorage.end());
+    mSharedStorage = rhs.mSharedStorage;
+    if (!mSharedStorage) {
+        mStorage.insert(mStorage.begin(), rhs.mStorage.begin(), rhs.mStorage.end());
+    }
     return *this;
 }
 
 Region& Region::makeBoundsSelf()
 {
-    if (mStorage.size() >= 2) {
+    if (storageSize() >= 2) {
         const Rect bounds(getBounds());
-        mStorage.clear();
+        resetStorage();
         mStorage.push_back(bounds);
     }
     return *this;
@@ -262,25 +355,25 @@ bool Region::contains(int x, int y) const {
 
 void Region::clear()
 {
-    mStorage.clear();
+    resetStorage();
     mStorage.push_back(Rect(0, 0));
 }
 
 void Region::set(const Rect& r)
 {
-    mStorage.clear();
+    resetStorage();
     mStorage.push_back(r);
 }
 
 void Region::set(int32_t w, int32_t h)
 {
-    mStorage.clear();
+    resetStorage();
     mStorage.push_back(Rect(w, h));
 }
 
 void Region::set(uint32_t w, uint32_t h)
 {
-    mStorage.clear();
+    resetStorage();
     mStorage.push_back(Rect(w, h));
 }
 
@@ -307,6 +400,12 @@ bool Region::hasSameRects(const Region& other) const {
 void Region::addRectUnchecked(int l, int t, int r, int b)
 {
     Rect rect(l,t,r,b);
+    if (mSharedStorage) {
+        // Regions are usually built up by adding many rects, so don't share the storage again
+        // after each one.
+        mStorage.assign(mSharedStorage->begin(), mSharedStorage->end());
+        mSharedStorage.reset();
+    }
     mStorage.insert(mStorage.end() - 1, rect);
 }
 
@@ -364,8 +463,8 @@ Region& Region::translateSelf(int x, int y) {
 }
 
 Region& Region::scaleSelf(float sx, float sy) {
-    size_t count = mStorage.size();
-    Rect* rects = mStorage.data();
+    size_t count = storageSize();
+    Rect* rects = editStorageData();
     while (count) {
         rects->left = static_cast<int32_t>(static_cast<float>(rects->left) * sx + 0.5f);
         rects->right = static_cast<int32_t>(static_cast<float>(rects->right) * sx + 0.5f);
@@ -467,17 +566,22 @@ const Region Region::operation(const Region& rhs, int dx, int dy, uint32_t op) c
 
 // This is our region rasterizer, which merges rects and spans together
 // to obtain an optimal region.
+//
+// The region is built in a per-thread buffer that keeps its capacity across operations, and then
+// copied into the destination, so that neither small nor large results allocate more than once.
 class Region::rasterizer : public region_operator<Rect>::region_rasterizer
 {
     Rect bounds;
-    FatVector<Rect>& storage;
+    Region& region;
+    std::vector<Rect>& storage;
     Rect* head;
     Rect* tail;
     FatVector<Rect> span;
     Rect* cur;
 public:
     explicit rasterizer(Region& reg)
-        : bounds(INT_MAX, 0, INT_MIN, 0), storage(reg.mStorage), head(), tail(), cur() {
+        : bounds(INT_MAX, 0, INT_MIN, 0), region(reg), storage(getScratchStorage()), head(),
+          tail(), cur() {
         storage.clear();
     }
 
@@ -491,6 +595,11 @@ private:
     template<typename T>
     static inline T max(T rhs, T lhs) { return rhs > lhs ? rhs : lhs; }
 
+    static std::vector<Rect>& getScratchStorage() {
+        static thread_local std::vector<Rect> sStorage;
+        return sStorage;
+    }
+
     void flushSpan();
 };
 
@@ -510,6 +619,7 @@ Region::rasterizer::~rasterizer()
         bounds.right = 0;
     }
     storage.push_back(bounds);
+    region.assignStorage(storage.data(), storage.size());
 }
 
 void Region::rasterizer::operator()(const Rect& rect)
@@ -532,27 +642,12 @@ void Region::rasterizer::flushSpan()
 {
     bool merge = false;
     if (tail-head == ssize_t(span.size())) {
-        Rect const* p = span.data();
-        Rect const* q = head;
-        if (p->top == q->bottom) {
-            merge = true;
-            while (q != tail) {
-                if ((p->left != q->left) || (p->right != q->right)) {
-                    merge = false;
-                    break;
-                }
-                p++;
-                q++;
-            }
+        if (span.front().top == head->bottom) {
+            merge = haveSameColumns(span.data(), head, span.size());
         }
     }
     if (merge) {
-        const int bottom = span.front().bottom;
-        Rect* r = head;
-        while (r != tail) {
-            r->bottom = bottom;
-            r++;
-        }
+        setBottoms(head, span.size(), span.front().bottom);
     } else {
         bounds.left = min(span.front().left, bounds.left);
         bounds.right = max(span.back().right, bounds.right);
@@ -565,7 +660,7 @@ void Region::rasterizer::flushSpan()
 
 bool Region::validate(const Region& reg, const char* name, bool silent)
 {
-    if (reg.mStorage.empty()) {
+    if (reg.storageSize() == 0) {
         ALOGE_IF(!silent, "%s: mStorage is empty, which is never valid", name);
         // return immediately as the code below assumes mStorage is non-empty
         return false;
@@ -630,7 +725,7 @@ bool Region::validate(const Region& reg, const char* name, bool silent)
                 reg.getBounds().left, reg.getBounds().top, 
                 reg.getBounds().right, reg.getBounds().bottom);
     }
-    if (reg.mStorage.size() == 2) {
+    if (reg.storageSize() == 2) {
         result = false;
         ALOGE_IF(!silent, "%s: mStorage size is 2, which is never valid", name);
     }
@@ -799,13 +894,7 @@ void Region::translate(Region& reg, int dx, int dy)
 #if defined(VALIDATE_REGIONS)
         validate(reg, "translate (before)");
 #endif
-        size_t count = reg.mStorage.size();
-        Rect* rects = reg.mStorage.data();
-        while (count) {
-            rects->offsetBy(dx, dy);
-            rects++;
-            count--;
-        }
+        offsetRects(reg.editStorageData(), reg.storageSize(), dx, dy);
 #if defined(VALIDATE_REGIONS)
         validate(reg, "translate (after)");
 #endif
@@ -820,8 +909,41 @@ void Region::translate(Region& dst, const Region& reg, int dx, int dy)
 
 // ----------------------------------------------------------------------------
 
+Rect* Region::editStorageData() {
+    if (!mSharedStorage) {
+        return mStorage.data();
+    }
+    if (mSharedStorage.use_count() > 1) {
+        mSharedStorage = std::make_shared<std::vector<Rect>>(*mSharedStorage);
+    }
+    return mSharedStorage->data();
+}
+
+void Region::resetStorage() {
+    mSharedStorage.reset();
+    mStorage.clear();
+}
+
+void Region::assignStorage(const Rect* rects, size_t count) {
+    if (count > kMaxInlineStorage) {
+        mSharedStorage = std::make_shared<std::vector<Rect>>(rects, rects + count);
+        mStorage.clear();
+    } else {
+        mSharedStorage.reset();
+        mStorage.assign(rects, rects + count);
+    }
+}
+
+void Region::shareStorage() {
+    if (mStorage.size() > kMaxInlineStorage) {
+        assignStorage(mStorage.data(), mStorage.size());
+    }
+}
+
+// ----------------------------------------------------------------------------
+
 size_t Region::getFlattenedSize() const {
-    return sizeof(uint32_t) + mStorage.size() * sizeof(Rect);
+    return sizeof(uint32_t) + storageSize() * sizeof(Rect);
 }
 
 status_t Region::flatten(void* buffer, size_t size) const {
@@ -833,8 +955,10 @@ status_t Region::flatten(void* buffer, size_t size) const {
     }
     // Cast to uint32_t since the size of a size_t can vary between 32- and
     // 64-bit processes
-    FlattenableUtils::write(buffer, size, static_cast<uint32_t>(mStorage.size()));
-    for (auto rect : mStorage) {
+    FlattenableUtils::write(buffer, size, static_cast<uint32_t>(storageSize()));
+    const Rect* const rects = storageData();
+    for (size_t i = 0; i < storageSize(); i++) {
+        const Rect& rect = rects[i];
         status_t result = rect.flatten(buffer, size);
         if (result != NO_ERROR) {
             return result;
@@ -880,25 +1004,25 @@ status_t Region::unflatten(void const* buffer, size_t size) {
         ALOGE("Region::unflatten() failed, invalid region");
         return BAD_VALUE;
     }
-    mStorage.clear();
-    mStorage.insert(mStorage.begin(), result.mStorage.begin(), result.mStorage.end());
+    result.shareStorage();
+    *this = result;
     return NO_ERROR;
 }
 
 // ----------------------------------------------------------------------------
 
 Region::const_iterator Region::begin() const {
-    return mStorage.data();
+    return storageData();
 }
 
 Region::const_iterator Region::end() const {
     // Workaround for b/77643177
-    // mStorage should never be empty, but somehow it is and it's causing
+    // The storage should never be empty, but somehow it is and it's causing
     // an abort in ubsan
-    if (mStorage.empty()) return mStorage.data();
+    if (storageSize() == 0) return storageData();
 
-    size_t numRects = isRect() ? 1 : mStorage.size() - 1;
-    return mStorage.data() + numRects;
+    size_t numRects = isRect() ? 1 : storageSize() - 1;
+    return storageData() + numRects;
 }
 
 Rect const* Region::getArray(size_t* count) const {
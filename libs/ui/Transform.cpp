@@ -21,6 +21,7 @@
 
 #include <android-base/stringprintf.h>
 #include <cutils/compiler.h>
+#include <ui/FatVector.h>
 #include <ui/Region.h>
 #include <ui/Transform.h>
 #include <utils/String8.h>
@@ -257,8 +258,58 @@ Rect Transform::makeBounds(int w, int h) const {
     return transform( Rect(w, h) );
 }
 
-Rect Transform::transform(const Rect& bounds, bool roundOutwards) const {
+namespace {
+
+Rect roundRect(float left, float top, float right, float bottom, bool roundOutwards) {
     Rect r;
+    if (roundOutwards) {
+        r.left   = static_cast<int32_t>(floorf(left));
+        r.top    = static_cast<int32_t>(floorf(top));
+        r.right  = static_cast<int32_t>(ceilf(right));
+        r.bottom = static_cast<int32_t>(ceilf(bottom));
+    } else {
+        r.left   = static_cast<int32_t>(floorf(left + 0.5f));
+        r.top    = static_cast<int32_t>(floorf(top + 0.5f));
+        r.right  = static_cast<int32_t>(floorf(right + 0.5f));
+        r.bottom = static_cast<int32_t>(floorf(bottom + 0.5f));
+    }
+    return r;
+}
+
+// Calls f with a function that maps points like Transform::transform(vec2), specialized for the
+// kind of transform. The products are kept apart from the sums so that they are not fused, and
+// round as they do in the full matrix product, where the other product is zero.
+template <typename F>
+void withPointMapper(const Transform& t, F f) {
+    const float a = t.dsdx();
+    const float b = t.dtdx();
+    const float c = t.dtdy();
+    const float d = t.dsdy();
+    const float x = t.tx();
+    const float y = t.ty();
+
+    if (t.getType() <= Transform::TRANSLATE) {
+        f([x, y](vec2 p) { return vec2(p.x + x, p.y + y); });
+    } else if (!t.preserveRects()) {
+        f([&t](vec2 p) { return t.transform(p); });
+    } else if (t.getOrientation() & Transform::ROT_90) {
+        f([b, c, x, y](vec2 p) {
+            const float px = b * p.y;
+            const float py = c * p.x;
+            return vec2(px + x, py + y);
+        });
+    } else {
+        f([a, d, x, y](vec2 p) {
+            const float px = a * p.x;
+            const float py = d * p.y;
+            return vec2(px + x, py + y);
+        });
+    }
+}
+
+} // namespace
+
+Rect Transform::transform(const Rect& bounds, bool roundOutwards) const {
     vec2 lt( bounds.left,  bounds.top    );
     vec2 rt( bounds.right, bounds.top    );
     vec2 lb( bounds.left,  bounds.bottom );
@@ -269,19 +320,9 @@ Rect Transform::transform(const Rect& bounds, bool roundOutwards) const {
     lb = transform(lb);
     rb = transform(rb);
 
-    if (roundOutwards) {
-        r.left   = static_cast<int32_t>(floorf(std::min({lt[0], rt[0], lb[0], rb[0]})));
-        r.top    = static_cast<int32_t>(floorf(std::min({lt[1], rt[1], lb[1], rb[1]})));
-        r.right  = static_cast<int32_t>(ceilf(std::max({lt[0], rt[0], lb[0], rb[0]})));
-        r.bottom = static_cast<int32_t>(ceilf(std::max({lt[1], rt[1], lb[1], rb[1]})));
-    } else {
-        r.left   = static_cast<int32_t>(floorf(std::min({lt[0], rt[0], lb[0], rb[0]}) + 0.5f));
-        r.top    = static_cast<int32_t>(floorf(std::min({lt[1], rt[1], lb[1], rb[1]}) + 0.5f));
-        r.right  = static_cast<int32_t>(floorf(std::max({lt[0], rt[0], lb[0], rb[0]}) + 0.5f));
-        r.bottom = static_cast<int32_t>(floorf(std::max({lt[1], rt[1], lb[1], rb[1]}) + 0.5f));
-    }
-
-    return r;
+    return roundRect(std::min({lt[0], rt[0], lb[0], rb[0]}), std::min({lt[1], rt[1], lb[1], rb[1]}),
+                     std::max({lt[0], rt[0], lb[0], rb[0]}), std::max({lt[1], rt[1], lb[1], rb[1]}),
+                     roundOutwards);
 }
 
 FloatRect Transform::transform(const FloatRect& bounds) const {
@@ -304,14 +345,61 @@ FloatRect Transform::transform(const FloatRect& bounds) const {
     return r;
 }
 
+void Transform::transform(const vec2* in, vec2* out, size_t count) const {
+    withPointMapper(*this, [in, out, count](auto map) {
+        for (size_t i = 0; i < count; i++) {
+            out[i] = map(in[i]);
+        }
+    });
+}
+
+void Transform::transform(const Rect* in, Rect* out, size_t count, bool roundOutwards) const {
+    if (!preserveRects()) {
+        for (size_t i = 0; i < count; i++) {
+            out[i] = transform(in[i], roundOutwards);
+        }
+        return;
+    }
+
+    // Each edge maps to an edge, so the other two corners map to the same coordinates.
+    withPointMapper(*this, [in, out, count, roundOutwards](auto map) {
+        for (size_t i = 0; i < count; i++) {
+            const vec2 lt = map(vec2(in[i].left, in[i].top));
+            const vec2 rb = map(vec2(in[i].right, in[i].bottom));
+            out[i] = roundRect(std::min(lt[0], rb[0]), std::min(lt[1], rb[1]),
+                               std::max(lt[0], rb[0]), std::max(lt[1], rb[1]), roundOutwards);
+        }
+    });
+}
+
+void Transform::transform(const FloatRect* in, FloatRect* out, size_t count) const {
+    if (!preserveRects()) {
+        for (size_t i = 0; i < count; i++) {
+            out[i] = transform(in[i]);
+        }
+        return;
+    }
+
+    withPointMapper(*this, [in, out, count](auto map) {
+        for (size_t i = 0; i < count; i++) {
+            const vec2 lt = map(vec2(in[i].left, in[i].top));
+            const vec2 rb = map(vec2(in[i].right, in[i].bottom));
+            out[i] = FloatRect(std::min(lt[0], rb[0]), std::min(lt[1], rb[1]),
+                               std::max(lt[0], rb[0]), std::max(lt[1], rb[1]));
+        }
+    });
+}
+
 Region Transform::transform(const Region& reg) const {
     Region out;
     if (CC_UNLIKELY(type() > TRANSLATE)) {
         if (CC_LIKELY(preserveRects())) {
-            Region::const_iterator it = reg.begin();
-            Region::const_iterator const end = reg.end();
-            while (it != end) {
-                out.orSelf(transform(*it++));
+            size_t count;
+            const Rect* rects = reg.getArray(&count);
+            FatVector<Rect> transformed(count);
+            transform(rects, transformed.data(), count);
+            for (const Rect& rect : transformed) {
+                out.orSelf(rect);
             }
         } else {
             out.set(transform(reg.bounds()));
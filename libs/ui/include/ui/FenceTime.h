@@ -26,6 +26,7 @@
 #include <mutex>
 #include <queue>
 #include <unordered_map>
+#include <vector>
 
 namespace android {
 
@@ -109,6 +110,12 @@ public:
     // Gets the cached timestamp without attempting to query the Fence.
     nsecs_t getCachedSignalTime() const;
 
+    // Updates the cached timestamps of the given FenceTimes, which may be null,
+    // with a single poll of their pending fences. Only the fences that have
+    // signaled are then queried for their timestamp, so this saves a syscall
+    // per fence that is still pending. Use getCachedSignalTime() afterwards.
+    static void updateSignalTimes(const std::vector<FenceTime*>& fenceTimes);
+
     // Returns a snapshot of the FenceTime in its current state.
     Snapshot getSnapshot() const;
 
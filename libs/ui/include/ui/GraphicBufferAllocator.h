@@ -21,6 +21,7 @@
 #include <stdint.h>
 
 #include <memory>
+#include <optional>
 #include <string>
 #include <vector>
 
@@ -32,6 +33,7 @@
 #include <utils/KeyedVector.h>
 #include <utils/Mutex.h>
 #include <utils/Singleton.h>
+#include <utils/Timers.h>
 
 namespace android {
 
@@ -57,6 +59,12 @@ public:
         uint64_t usage;
         std::string requestorName;
         std::vector<AdditionalOptions> extras;
+        // Whether the buffer may be kept once freed, and handed out again for a later request with
+        // the same dimensions, format, layer count and usage, without going through gralloc.
+        // Recycled buffers keep their previous contents, and other processes that imported them
+        // can still access them, so only set this for buffers that never leave this process.
+        // Requests with extras are never recycled.
+        bool recyclable = false;
     };
 
     struct AllocationResult {
@@ -102,6 +110,12 @@ public:
 
     status_t free(buffer_handle_t handle);
 
+    /**
+     * Frees the buffers kept for recycling, e.g. under memory pressure. Returns the number of
+     * buffers freed. This is also done when gralloc runs out of memory.
+     */
+    size_t trimRecycledBuffers();
+
     uint64_t getTotalSize() const;
 
     void dump(std::string& res, bool less = true) const;
@@ -119,15 +133,39 @@ protected:
         uint64_t usage;
         size_t size;
         std::string requestorName;
+        bool recyclable = false;
+        // Set while the buffer is kept in mRecycledBuffers.
+        bool recycled = false;
+    };
+
+    // Bounds of the buffers kept for recycling.
+    static constexpr size_t kMaxRecycledBuffers = 8;
+    static constexpr size_t kMaxRecycledSize = 32 * 1024 * 1024;
+    static constexpr nsecs_t kMaxRecycledAge = s2ns(2);
+
+    struct recycled_buffer_t {
+        buffer_handle_t handle;
+        nsecs_t freeTime;
     };
 
     status_t allocateHelper(uint32_t w, uint32_t h, PixelFormat format, uint32_t layerCount,
                             uint64_t usage, buffer_handle_t* handle, uint32_t* stride,
                             std::string requestorName, bool importBuffer);
 
+    // Returns a recycled buffer matching the request, if any.
+    std::optional<AllocationResult> recycle(const AllocationRequest& request);
+
+    // Removes the recycled buffers that exceed the bounds above, or all of them if trimAll is set,
+    // and appends them to outHandles. They must then be freed without holding sLock.
+    void evictRecycledBuffersLocked(bool trimAll, std::vector<buffer_handle_t>* outHandles);
+
     static Mutex sLock;
     static KeyedVector<buffer_handle_t, alloc_rec_t> sAllocList;
 
+    // Least recently freed first, guarded by sLock.
+    std::vector<recycled_buffer_t> mRecycledBuffers;
+    size_t mRecycledSize = 0;
+
     friend class Singleton<GraphicBufferAllocator>;
     GraphicBufferAllocator();
     ~GraphicBufferAllocator();
@@ -21,6 +21,10 @@
 #include <sys/types.h>
 
 #include <memory>
+#include <mutex>
+#include <optional>
+#include <unordered_map>
+#include <vector>
 
 #include <android-base/unique_fd.h>
 #include <ui/GraphicTypes.h>
@@ -170,6 +174,48 @@ public:
     status_t setSmpte2094_10(buffer_handle_t bufferHandle,
                              std::optional<std::vector<uint8_t>> smpte2094_10);
 
+    /**
+     * Gralloc metadata that is fixed when the buffer is allocated.
+     */
+    struct BufferInfo {
+        uint64_t bufferId = 0;
+        uint64_t width = 0;
+        uint64_t height = 0;
+        uint64_t layerCount = 0;
+        ui::PixelFormat pixelFormatRequested{};
+        uint32_t pixelFormatFourCC = 0;
+        uint64_t pixelFormatModifier = 0;
+        uint64_t usage = 0;
+        uint64_t allocationSize = 0;
+        std::vector<ui::PlaneLayout> planeLayouts;
+    };
+
+    /**
+     * Gets all of the BufferInfo metadata of a buffer at once.
+     *
+     * The metadata in BufferInfo is cached for buffers imported or allocated in this process, until
+     * they are freed. Repeated queries, including through the individual getters above, then don't
+     * call into the mapper. Metadata that can be set, such as the dataspace, is never cached, since
+     * other processes may change it.
+     *
+     * This is supported by gralloc 4.0+.
+     */
+    ui::Result<BufferInfo> getBufferInfo(buffer_handle_t bufferHandle);
+
+    struct LockedPlanes {
+        void* address = nullptr;
+        std::vector<ui::PlaneLayout> planeLayouts;
+    };
+
+    /**
+     * Locks a buffer, and gets the layout of its planes relative to address. This is the
+     * counterpart of lockYCbCr for arbitrary formats, with the plane layouts from the cache above.
+     *
+     * This is supported by gralloc 4.0+.
+     */
+    ui::Result<LockedPlanes> lockPlanes(buffer_handle_t handle, int64_t usage, const Rect& bounds,
+                                       base::unique_fd&& acquireFence = {});
+
     const GrallocMapper& getGrallocMapper() const {
         return reinterpret_cast<const GrallocMapper&>(*mMapper);
     }
@@ -178,12 +224,42 @@ public:
 
 private:
     friend class Singleton<GraphicBufferMapper>;
+    friend class GraphicBufferAllocator;
 
     GraphicBufferMapper();
 
+    // The BufferInfo of a buffer, as far as it was queried.
+    struct CachedBufferInfo {
+        std::optional<uint64_t> bufferId;
+        std::optional<uint64_t> width;
+        std::optional<uint64_t> height;
+        std::optional<uint64_t> layerCount;
+        std::optional<ui::PixelFormat> pixelFormatRequested;
+        std::optional<uint32_t> pixelFormatFourCC;
+        std::optional<uint64_t> pixelFormatModifier;
+        std::optional<uint64_t> usage;
+        std::optional<uint64_t> allocationSize;
+        std::optional<std::vector<ui::PlaneLayout>> planeLayouts;
+    };
+
+    // Starts caching the metadata of an imported buffer, until it is passed to freeBuffer. Handles
+    // that this class did not import are not cached, since nothing would tell when they are freed,
+    // and their address reused.
+    void onBufferImported(buffer_handle_t bufferHandle);
+
+    // Returns a field of the cached metadata, and queries it from the mapper if needed.
+    template <typename T>
+    status_t getCachedBufferInfo(buffer_handle_t bufferHandle,
+                                 std::optional<T> CachedBufferInfo::*field,
+                                 status_t (GrallocMapper::*get)(buffer_handle_t, T*) const,
+                                 T* outValue);
+
     std::unique_ptr<const GrallocMapper> mMapper;
 
     Version mMapperVersion;
+
+    std::mutex mBufferInfoMutex;
+    std::unordered_map<buffer_handle_t, CachedBufferInfo> mBufferInfos;
 };
 
 // ---------------------------------------------------------------------------
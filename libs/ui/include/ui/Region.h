@@ -19,7 +19,9 @@
 
 #include <stdint.h>
 #include <sys/types.h>
+#include <memory>
 #include <ostream>
+#include <vector>
 
 #include <math/HashCombine.h>
 #include <ui/Rect.h>
@@ -49,9 +51,9 @@ public:
         Region& operator = (const Region& rhs);
 
     inline  bool        isEmpty() const     { return getBounds().isEmpty(); }
-    inline  bool        isRect() const      { return mStorage.size() == 1; }
+    inline  bool        isRect() const      { return storageSize() == 1; }
 
-    inline  Rect        getBounds() const   { return mStorage[mStorage.size() - 1]; }
+    inline  Rect        getBounds() const   { return storageData()[storageSize() - 1]; }
     inline  Rect        bounds() const      { return getBounds(); }
 
             bool        contains(const Point& point) const;
@@ -177,11 +179,35 @@ private:
     static bool validate(const Region& reg,
             const char* name, bool silent = false);
 
-    // mStorage is a (manually) sorted array of Rects describing the region
+    inline const Rect* storageData() const {
+        return mSharedStorage ? mSharedStorage->data() : mStorage.data();
+    }
+    inline size_t storageSize() const {
+        return mSharedStorage ? mSharedStorage->size() : mStorage.size();
+    }
+    // Returns the storage for modifying the rects in place, copying it first if it is shared
+    // with another region.
+    Rect* editStorageData();
+    // Clears the storage, leaving it unshared.
+    void resetStorage();
+    // Replaces the storage with the given rects, which must not point into it.
+    void assignStorage(const Rect* rects, size_t count);
+    // Moves the contents of mStorage into shared storage if they don't fit inline.
+    void shareStorage();
+
+    // Regions with up to this many entries in their storage are stored inline.
+    static constexpr size_t kMaxInlineStorage = 4;
+
+    // The storage is a (manually) sorted array of Rects describing the region
     // with an extra Rect as the last element which is set to the
     // bounds of the region. However, if the region is
-    // a simple Rect then mStorage contains only that rect.
-    FatVector<Rect> mStorage;
+    // a simple Rect then the storage contains only that rect.
+    //
+    // Small regions, which are by far the most common, are stored inline in mStorage so that
+    // they never allocate. Larger regions computed by boolean operations are moved to
+    // mSharedStorage, which copies of the region share until one of them is modified.
+    FatVector<Rect, kMaxInlineStorage> mStorage;
+    std::shared_ptr<std::vector<Rect>> mSharedStorage;
 };
 
 
@@ -103,6 +103,15 @@ public:
     vec2 transform(const vec2& v) const;
     vec3 transform(const vec3& v) const;
 
+    // Batched counterparts of the above, which write the transforms of count elements of in to
+    // the same elements of out. The results are the same, but the kind of transform is only looked
+    // up once for the batch, so translations, scales and rotations by multiples of 90 degrees skip
+    // the full matrix product. out may alias in.
+    void    transform(const vec2* in, vec2* out, size_t count) const;
+    void    transform(const Rect* in, Rect* out, size_t count,
+                      bool roundOutwards = false) const;
+    void    transform(const FloatRect* in, FloatRect* out, size_t count) const;
+
     // Expands from the internal 3x3 matrix to an equivalent 4x4 matrix
     mat4 asMatrix4() const;
 
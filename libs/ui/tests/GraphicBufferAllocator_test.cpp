@@ -53,6 +53,17 @@ public:
                     allocate)
                 .WillOnce(DoAll(SetArgPointee<6>(stride), Return(err)));
     }
+    void setUpAllocateExpectations(std::initializer_list<buffer_handle_t> handles) {
+        auto& expectation =
+                EXPECT_CALL(*(reinterpret_cast<const mock::MockGrallocAllocator*>(
+                                    mAllocator.get())),
+                            allocate)
+                        .Times(static_cast<int>(handles.size()));
+        for (const buffer_handle_t handle : handles) {
+            expectation.WillOnce(
+                    DoAll(SetArgPointee<6>(kTestWidth), SetArgPointee<7>(handle), Return(NO_ERROR)));
+        }
+    }
     std::unique_ptr<const GrallocAllocator>& getAllocator() { return mAllocator; }
 };
 
@@ -113,4 +124,61 @@ TEST_F(GraphicBufferAllocatorTest, AllocateLargeStride) {
     ASSERT_EQ(NO_ERROR, err);
     ASSERT_EQ(expectedStride, stride);
 }
+
+TEST_F(GraphicBufferAllocatorTest, RecyclesFreedBuffer) {
+    // The handles are never dereferenced, since recycled buffers are not freed by the mapper.
+    static const native_handle_t kHandle{};
+    mAllocator.setUpAllocateExpectations({&kHandle});
+
+    const GraphicBufferAllocator::AllocationRequest request = {
+            .importBuffer = true,
+            .width = kTestWidth,
+            .height = kTestHeight,
+            .format = PIXEL_FORMAT_RGBA_8888,
+            .layerCount = kTestLayerCount,
+            .usage = kTestUsage,
+            .requestorName = "GraphicBufferAllocatorTest",
+            .recyclable = true,
+    };
+
+    auto result = mAllocator.allocate(request);
+    ASSERT_EQ(NO_ERROR, result.status);
+    ASSERT_EQ(&kHandle, result.handle);
+    ASSERT_EQ(NO_ERROR, mAllocator.free(result.handle));
+
+    result = mAllocator.allocate(request);
+    ASSERT_EQ(NO_ERROR, result.status);
+    EXPECT_EQ(&kHandle, result.handle);
+    EXPECT_EQ(kTestWidth, result.stride);
+}
+
+TEST_F(GraphicBufferAllocatorTest, RecyclesOnlyMatchingBuffer) {
+    static const native_handle_t kHandle{};
+    static const native_handle_t kOtherHandle{};
+    mAllocator.setUpAllocateExpectations({&kHandle, &kOtherHandle});
+
+    GraphicBufferAllocator::AllocationRequest request = {
+            .importBuffer = true,
+            .width = kTestWidth,
+            .height = kTestHeight,
+            .format = PIXEL_FORMAT_RGBA_8888,
+            .layerCount = kTestLayerCount,
+            .usage = kTestUsage,
+            .requestorName = "GraphicBufferAllocatorTest",
+            .recyclable = true,
+    };
+
+    auto result = mAllocator.allocate(request);
+    ASSERT_EQ(&kHandle, result.handle);
+    ASSERT_EQ(NO_ERROR, mAllocator.free(result.handle));
+
+    GraphicBufferAllocator::AllocationRequest otherRequest = request;
+    otherRequest.usage |= GraphicBuffer::USAGE_HW_TEXTURE;
+    result = mAllocator.allocate(otherRequest);
+    EXPECT_EQ(&kOtherHandle, result.handle);
+
+    // The first buffer is still kept for requests that match it.
+    result = mAllocator.allocate(request);
+    EXPECT_EQ(&kHandle, result.handle);
+}
 } // namespace android
@@ -17,6 +17,7 @@
 #define LOG_TAG "GraphicBufferTest"
 
 #include <ui/GraphicBuffer.h>
+#include <ui/GraphicBufferMapper.h>
 
 #include <gtest/gtest.h>
 
@@ -66,4 +67,51 @@ TEST_F(GraphicBufferTest, AllocateBadDimensions) {
     ASSERT_EQ(BAD_VALUE, gb2->initCheck());
 }
 
+TEST_F(GraphicBufferTest, GetBufferInfoMatchesGetters) {
+    GraphicBufferMapper& mapper = GraphicBufferMapper::get();
+    if (mapper.getMapperVersion() < GraphicBufferMapper::GRALLOC_4) {
+        GTEST_SKIP() << "Buffer metadata requires gralloc 4.0+";
+    }
+
+    sp<GraphicBuffer> gb(new GraphicBuffer(kTestWidth, kTestHeight, PIXEL_FORMAT_RGBA_8888,
+                                           kTestLayerCount, kTestUsage, std::string("test")));
+    ASSERT_EQ(NO_ERROR, gb->initCheck());
+
+    const auto info = mapper.getBufferInfo(gb->getNativeBuffer()->handle);
+    ASSERT_TRUE(info.has_value());
+    EXPECT_EQ(kTestWidth, info->width);
+    EXPECT_EQ(kTestHeight, info->height);
+    EXPECT_EQ(kTestLayerCount, info->layerCount);
+    EXPECT_FALSE(info->planeLayouts.empty());
+
+    // Queries after the first are answered from the cache, and must agree with it.
+    uint64_t bufferId = 0;
+    ASSERT_EQ(NO_ERROR, mapper.getBufferId(gb->getNativeBuffer()->handle, &bufferId));
+    EXPECT_EQ(info->bufferId, bufferId);
+
+    const auto planeLayouts = mapper.getPlaneLayouts(gb->getNativeBuffer()->handle);
+    ASSERT_TRUE(planeLayouts.has_value());
+    EXPECT_EQ(info->planeLayouts, *planeLayouts);
+}
+
+TEST_F(GraphicBufferTest, LockPlanes) {
+    GraphicBufferMapper& mapper = GraphicBufferMapper::get();
+    if (mapper.getMapperVersion() < GraphicBufferMapper::GRALLOC_4) {
+        GTEST_SKIP() << "Buffer metadata requires gralloc 4.0+";
+    }
+
+    sp<GraphicBuffer> gb(new GraphicBuffer(kTestWidth, kTestHeight, PIXEL_FORMAT_RGBA_8888,
+                                           kTestLayerCount, kTestUsage, std::string("test")));
+    ASSERT_EQ(NO_ERROR, gb->initCheck());
+
+    const buffer_handle_t handle = gb->getNativeBuffer()->handle;
+    const auto locked =
+            mapper.lockPlanes(handle, kTestUsage, Rect(static_cast<int32_t>(kTestWidth),
+                                                       static_cast<int32_t>(kTestHeight)));
+    ASSERT_TRUE(locked.has_value());
+    EXPECT_NE(nullptr, locked->address);
+    EXPECT_EQ(1u, locked->planeLayouts.size());
+    EXPECT_EQ(OK, mapper.unlock(handle));
+}
+
 } // namespace android
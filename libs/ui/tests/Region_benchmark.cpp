@@ -0,0 +1,116 @@
+/*
+ * Copyright 2024 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <algorithm>
+
+#include <benchmark/benchmark.h>
+#include <ui/Rect.h>
+#include <ui/Region.h>
+
+namespace android {
+namespace {
+
+constexpr int32_t kDisplayWidth = 1080;
+constexpr int32_t kDisplayHeight = 2400;
+
+// A region shaped like the visible region of a window partly covered by others: a column of
+// rows, each split into a few spans, with rows of equal spans that the rasterizer can merge.
+// rectCount is approximate.
+Region makeRegion(int rectCount, int32_t offset) {
+    constexpr int kSpansPerRow = 4;
+    const int rows = std::max(1, rectCount / kSpansPerRow);
+    const int32_t rowHeight = kDisplayHeight / rows;
+    const int32_t spanWidth = kDisplayWidth / (2 * kSpansPerRow);
+    Region region;
+    for (int row = 0; row < rows; row++) {
+        const int32_t shift = offset + (row / 2 % 3) * 16;
+        for (int span = 0; span < kSpansPerRow; span++) {
+            const int32_t left = shift + span * 2 * spanWidth;
+            region.orSelf(Rect(left, row * rowHeight, left + spanWidth, (row + 1) * rowHeight));
+        }
+    }
+    return region;
+}
+
+void BM_merge(benchmark::State& state) {
+    const Region lhs = makeRegion(static_cast<int>(state.range(0)), 0);
+    const Region rhs = makeRegion(static_cast<int>(state.range(0)), 40);
+    for (auto _ : state) {
+        benchmark::DoNotOptimize(lhs.merge(rhs));
+    }
+}
+BENCHMARK(BM_merge)->Arg(1)->Arg(4)->Arg(16)->Arg(64)->Arg(256);
+
+void BM_intersect(benchmark::State& state) {
+    const Region lhs = makeRegion(static_cast<int>(state.range(0)), 0);
+    const Region rhs = makeRegion(static_cast<int>(state.range(0)), 40);
+    for (auto _ : state) {
+        benchmark::DoNotOptimize(lhs.intersect(rhs));
+    }
+}
+BENCHMARK(BM_intersect)->Arg(1)->Arg(4)->Arg(16)->Arg(64)->Arg(256);
+
+void BM_subtract(benchmark::State& state) {
+    const Region lhs = makeRegion(static_cast<int>(state.range(0)), 0);
+    const Region rhs = makeRegion(static_cast<int>(state.range(0)), 40);
+    for (auto _ : state) {
+        benchmark::DoNotOptimize(lhs.subtract(rhs));
+    }
+}
+BENCHMARK(BM_subtract)->Arg(1)->Arg(4)->Arg(16)->Arg(64)->Arg(256);
+
+// Cropping a touchable region to the window bounds.
+void BM_intersectRect(benchmark::State& state) {
+    const Region region = makeRegion(static_cast<int>(state.range(0)), 0);
+    const Rect crop(100, 200, kDisplayWidth - 100, kDisplayHeight - 200);
+    for (auto _ : state) {
+        benchmark::DoNotOptimize(region.intersect(crop));
+    }
+}
+BENCHMARK(BM_intersectRect)->Arg(1)->Arg(4)->Arg(16)->Arg(64)->Arg(256);
+
+// Stacking opaque regions, as visible region computation does for every layer.
+void BM_orSelf(benchmark::State& state) {
+    const Region rhs = makeRegion(static_cast<int>(state.range(0)), 40);
+    for (auto _ : state) {
+        Region region = makeRegion(static_cast<int>(state.range(0)), 0);
+        region.orSelf(rhs);
+        benchmark::DoNotOptimize(region);
+    }
+}
+BENCHMARK(BM_orSelf)->Arg(1)->Arg(4)->Arg(16)->Arg(64)->Arg(256);
+
+// Copying regions into snapshots and composition state.
+void BM_copy(benchmark::State& state) {
+    const Region region = makeRegion(static_cast<int>(state.range(0)), 0);
+    for (auto _ : state) {
+        Region copy(region);
+        benchmark::DoNotOptimize(copy);
+    }
+}
+BENCHMARK(BM_copy)->Arg(1)->Arg(4)->Arg(16)->Arg(64)->Arg(256);
+
+void BM_translate(benchmark::State& state) {
+    Region region = makeRegion(static_cast<int>(state.range(0)), 0);
+    for (auto _ : state) {
+        region.translateSelf(1, -1);
+        benchmark::DoNotOptimize(region);
+    }
+}
+BENCHMARK(BM_translate)->Arg(1)->Arg(4)->Arg(16)->Arg(64)->Arg(256);
+
+} // namespace
+} // namespace android
@@ -179,5 +179,69 @@ TEST_F(RegionTest, RegionHash) {
     EXPECT_NE(std::hash<Region>{}(region1), std::hash<Region>{}(region2));
 }
 
+TEST_F(RegionTest, MergesSpansWithSameColumns) {
+    Region region;
+    region.orSelf(Rect(0, 0, 10, 10));
+    region.orSelf(Rect(20, 0, 30, 10));
+    region.orSelf(Rect(0, 10, 10, 20));
+    region.orSelf(Rect(20, 10, 30, 20));
+
+    size_t count;
+    const Rect* rects = region.getArray(&count);
+    ASSERT_EQ(2u, count);
+    EXPECT_EQ(Rect(0, 0, 10, 20), rects[0]);
+    EXPECT_EQ(Rect(20, 0, 30, 20), rects[1]);
+
+    region.orSelf(Rect(0, 20, 10, 30));
+    region.orSelf(Rect(25, 20, 30, 30));
+    rects = region.getArray(&count);
+    ASSERT_EQ(4u, count);
+    EXPECT_EQ(Rect(0, 20, 10, 30), rects[2]);
+    EXPECT_EQ(Rect(25, 20, 30, 30), rects[3]);
+    EXPECT_EQ(Rect(0, 0, 30, 30), region.getBounds());
+}
+
+TEST_F(RegionTest, CopiesShareLargeRegions) {
+    Region region;
+    for (int i = 0; i < 8; i++) {
+        region.orSelf(Rect(i * 20, i * 20, i * 20 + 10, i * 20 + 10));
+    }
+    const Region original = region;
+
+    Region copy(region);
+    EXPECT_TRUE(copy.isTriviallyEqual(region));
+
+    copy.translateSelf(1, 1);
+    EXPECT_FALSE(copy.isTriviallyEqual(region));
+    EXPECT_TRUE(region.hasSameRects(original));
+    EXPECT_EQ(Rect(1, 1, 151, 151), copy.getBounds());
+
+    copy = region;
+    copy.orSelf(Rect(0, 0, 200, 200));
+    EXPECT_TRUE(region.hasSameRects(original));
+    EXPECT_TRUE(copy.isRect());
+}
+
+TEST_F(RegionTest, CopiesDontShareSmallRegions) {
+    Region region(Rect(0, 0, 10, 10));
+    Region copy(region);
+    EXPECT_FALSE(copy.isTriviallyEqual(region));
+    EXPECT_TRUE(copy.hasSameRects(region));
+}
+
+TEST_F(RegionTest, Translate) {
+    Region region;
+    region.orSelf(Rect(0, 0, 10, 10));
+    region.orSelf(Rect(20, 20, 30, 30));
+    region.translateSelf(5, -5);
+
+    size_t count;
+    const Rect* rects = region.getArray(&count);
+    ASSERT_EQ(2u, count);
+    EXPECT_EQ(Rect(5, -5, 15, 5), rects[0]);
+    EXPECT_EQ(Rect(25, 15, 35, 25), rects[1]);
+    EXPECT_EQ(Rect(5, -5, 35, 25), region.getBounds());
+}
+
 }; // namespace android
 
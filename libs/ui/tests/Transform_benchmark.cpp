@@ -0,0 +1,124 @@
+/*
+ * Copyright 2024 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <vector>
+
+#include <benchmark/benchmark.h>
+#include <ui/Rect.h>
+#include <ui/Transform.h>
+
+namespace android::ui {
+namespace {
+
+enum Kind { kTranslate, kScale, kRotate90, kSkew };
+
+Transform makeTransform(int64_t kind) {
+    Transform translate;
+    translate.set(12.5f, -7.25f);
+
+    Transform t;
+    switch (kind) {
+        case kTranslate:
+            return translate;
+        case kScale:
+            t.set(1.5f, 0.f, 0.f, 0.75f);
+            break;
+        case kRotate90:
+            t = Transform(Transform::ROT_90, 1080, 2400);
+            break;
+        default:
+            t.set(0.866f, 0.5f, -0.5f, 0.866f);
+            break;
+    }
+    return translate * t;
+}
+
+std::vector<Rect> makeRects(size_t count) {
+    std::vector<Rect> rects;
+    for (size_t i = 0; i < count; i++) {
+        const int32_t offset = static_cast<int32_t>(i * 7 % 1000);
+        rects.emplace_back(offset, 2 * offset, offset + 80, 2 * offset + 120);
+    }
+    return rects;
+}
+
+std::vector<vec2> makePoints(size_t count) {
+    std::vector<vec2> points;
+    for (size_t i = 0; i < count; i++) {
+        points.emplace_back(static_cast<float>(i % 1080) + 0.5f, static_cast<float>(i % 2400));
+    }
+    return points;
+}
+
+void BM_transformRect(benchmark::State& state) {
+    const Transform t = makeTransform(state.range(0));
+    const std::vector<Rect> rects = makeRects(static_cast<size_t>(state.range(1)));
+    std::vector<Rect> out(rects.size());
+    for (auto _ : state) {
+        for (size_t i = 0; i < rects.size(); i++) {
+            out[i] = t.transform(rects[i]);
+        }
+        benchmark::DoNotOptimize(out.data());
+    }
+}
+
+void BM_transformRects(benchmark::State& state) {
+    const Transform t = makeTransform(state.range(0));
+    const std::vector<Rect> rects = makeRects(static_cast<size_t>(state.range(1)));
+    std::vector<Rect> out(rects.size());
+    for (auto _ : state) {
+        t.transform(rects.data(), out.data(), rects.size());
+        benchmark::DoNotOptimize(out.data());
+    }
+}
+
+void BM_transformPoint(benchmark::State& state) {
+    const Transform t = makeTransform(state.range(0));
+    const std::vector<vec2> points = makePoints(static_cast<size_t>(state.range(1)));
+    std::vector<vec2> out(points.size());
+    for (auto _ : state) {
+        for (size_t i = 0; i < points.size(); i++) {
+            out[i] = t.transform(points[i]);
+        }
+        benchmark::DoNotOptimize(out.data());
+    }
+}
+
+void BM_transformPoints(benchmark::State& state) {
+    const Transform t = makeTransform(state.range(0));
+    const std::vector<vec2> points = makePoints(static_cast<size_t>(state.range(1)));
+    std::vector<vec2> out(points.size());
+    for (auto _ : state) {
+        t.transform(points.data(), out.data(), points.size());
+        benchmark::DoNotOptimize(out.data());
+    }
+}
+
+void kindsAndCounts(benchmark::internal::Benchmark* b) {
+    for (const int64_t kind : {kTranslate, kScale, kRotate90, kSkew}) {
+        for (const int64_t count : {4, 64}) {
+            b->Args({kind, count});
+        }
+    }
+}
+
+BENCHMARK(BM_transformRect)->Apply(kindsAndCounts);
+BENCHMARK(BM_transformRects)->Apply(kindsAndCounts);
+BENCHMARK(BM_transformPoint)->Apply(kindsAndCounts);
+BENCHMARK(BM_transformPoints)->Apply(kindsAndCounts);
+
+} // namespace
+} // namespace android::ui
@@ -14,8 +14,11 @@
  * limitations under the License.
  */
 
+#include <ui/Region.h>
 #include <ui/Transform.h>
 
+#include <vector>
+
 #include <gtest/gtest.h>
 
 namespace android::ui {
@@ -46,4 +49,87 @@ TEST(TransformTest, inverseRotation_hasCorrectType) {
     testRotationFlagsForInverse(Transform::FLIP_V, Transform::FLIP_V, false);
 }
 
+namespace {
+
+std::vector<Transform> makeTransforms() {
+    std::vector<Transform> transforms;
+    for (const auto flags : {Transform::ROT_0, Transform::ROT_90, Transform::ROT_180,
+                             Transform::ROT_270, Transform::FLIP_H, Transform::FLIP_V}) {
+        transforms.emplace_back(flags, 1080, 2400);
+    }
+
+    Transform translate;
+    translate.set(12.5f, -7.25f);
+    transforms.push_back(translate);
+
+    Transform scale;
+    scale.set(1.5f, 0.f, 0.f, 0.75f);
+    transforms.push_back(scale * translate);
+
+    Transform rotateScale;
+    rotateScale.set(0.f, 2.f, -0.5f, 0.f);
+    transforms.push_back(translate * rotateScale);
+
+    Transform skew;
+    skew.set(0.866f, 0.5f, -0.5f, 0.866f);
+    transforms.push_back(translate * skew);
+
+    transforms.emplace_back();
+    return transforms;
+}
+
+} // namespace
+
+TEST(TransformTest, transformPoints_matchesSingle) {
+    const std::vector<vec2> points = {{0.f, 0.f},     {1.f, 2.f},      {-3.5f, 100.25f},
+                                      {1080.f, 2400.f}, {533.3f, -0.1f}, {-0.f, 7.f}};
+    for (const Transform& t : makeTransforms()) {
+        std::vector<vec2> transformed(points.size());
+        t.transform(points.data(), transformed.data(), points.size());
+        for (size_t i = 0; i < points.size(); i++) {
+            EXPECT_EQ(t.transform(points[i]), transformed[i]);
+        }
+
+        std::vector<vec2> inPlace = points;
+        t.transform(inPlace.data(), inPlace.data(), inPlace.size());
+        EXPECT_EQ(transformed, inPlace);
+    }
+}
+
+TEST(TransformTest, transformRects_matchesSingle) {
+    const std::vector<Rect> rects = {Rect(0, 0, 1080, 2400), Rect(10, 20, 30, 40),
+                                     Rect(-5, -5, 5, 5), Rect(3, 3, 3, 3), Rect(17, 1, 1001, 999)};
+    for (const Transform& t : makeTransforms()) {
+        for (const bool roundOutwards : {false, true}) {
+            std::vector<Rect> transformed(rects.size());
+            t.transform(rects.data(), transformed.data(), rects.size(), roundOutwards);
+            for (size_t i = 0; i < rects.size(); i++) {
+                EXPECT_EQ(t.transform(rects[i], roundOutwards), transformed[i]);
+            }
+        }
+
+        std::vector<FloatRect> floatRects;
+        for (const Rect& rect : rects) {
+            floatRects.push_back(rect.toFloatRect());
+        }
+        std::vector<FloatRect> transformed(floatRects.size());
+        t.transform(floatRects.data(), transformed.data(), floatRects.size());
+        for (size_t i = 0; i < floatRects.size(); i++) {
+            EXPECT_EQ(t.transform(floatRects[i]), transformed[i]);
+        }
+    }
+}
+
+TEST(TransformTest, transformRegion) {
+    Region region(Rect(0, 0, 100, 100));
+    region.orSelf(Rect(200, 50, 300, 400));
+
+    const Transform t(Transform::ROT_90, 1080, 2400);
+    Region expected;
+    for (const Rect& rect : region) {
+        expected.orSelf(t.transform(rect));
+    }
+    EXPECT_TRUE(expected.hasSameRects(t.transform(region)));
+}
+
 } // namespace android::ui
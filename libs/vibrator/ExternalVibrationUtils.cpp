@@ -25,6 +25,16 @@
 #include <log/log.h>
 #include <vibrator/ExternalVibrationUtils.h>
 
+#if defined(__aarch64__)
+#include <arm_neon.h>
+#define HAPTIC_SIMD 1
+#elif defined(__SSE__)
+#include <xmmintrin.h>
+#define HAPTIC_SIMD 1
+#else
+#define HAPTIC_SIMD 0
+#endif
+
 namespace android::os {
 
 namespace {
@@ -111,80 +121,194 @@ float applyOldHapticScale(float value, float gamma, float maxAmplitudeRatio) {
                 * maxAmplitudeRatio * HAPTIC_MAX_AMPLITUDE_FLOAT * sign;
 }
 
-float applyNewHapticScale(float value, float scaleFactor) {
-    if (android_os_vibrator_haptics_scale_v2_enabled()) {
-        if (scaleFactor <= 1 || value == 0) {
-            return value * scaleFactor;
-        } else {
-            // Using S * x / (1 + (S - 1) * x^2) as the scale up function to converge to 1.0.
-            return (value * scaleFactor) / (1 + (scaleFactor - 1) * value * value);
-        }
-    }
-    float scale = powf(scaleFactor, 1.0f / SCALE_GAMMA);
-    if (scaleFactor <= 1) {
-        // Scale down is simply a gamma corrected application of scaleFactor to the intensity.
-        // Scale up requires a different curve to ensure the intensity will not become > 1.
-        return value * scale;
+float applyNewHapticScaleV2(float value, float scaleFactor) {
+    if (scaleFactor <= 1 || value == 0) {
+        return value * scaleFactor;
     }
+    // Using S * x / (1 + (S - 1) * x^2) as the scale up function to converge to 1.0.
+    return (value * scaleFactor) / (1 + (scaleFactor - 1) * value * value);
+}
 
-    float sign = value >= 0 ? 1.0f : -1.0f;
-    float extraScale = powf(scaleFactor, 4.0f - scaleFactor);
-    float x = fabsf(value) * scale * extraScale;
-    float maxX = scale * extraScale; // scaled x for intensity == 1
-
-    float expX = expf(x);
-    float expMaxX = expf(maxX);
-
-    // Using f = tanh as the scale up function so the max value will converge.
-    // a = 1/f(maxX), used to scale f so that a*f(maxX) = 1 (the value will converge to 1).
-    float a = (expMaxX + 1.0f) / (expMaxX - 1.0f);
-    float fx = (expX - 1.0f) / (expX + 1.0f);
+/*
+ * Scales each haptic sample of a buffer as given by a HapticScale and a limit. Everything that does
+ * not depend on the sample, from the aconfig flags to the constants of the scale up curves, is
+ * worked out once per buffer instead of once per sample.
+ */
+class HapticScaler {
+public:
+    HapticScaler(HapticScale scale, float limit) {
+        if (!isnan(limit) && limit != 0) {
+            mLimit = fabsf(limit);
+        }
+        if (!isValidHapticScale(scale)) {
+            return;
+        }
+        if (scale.isScaleMute()) {
+            mMute = true;
+            return;
+        }
+        if (scale.isScaleNone()) {
+            return;
+        }
 
-    return sign * std::clamp(a * fx, 0.0f, 1.0f);
-}
+        HapticLevel hapticLevel = scale.getLevel();
+        float adaptiveScaleFactor = scale.getAdaptiveScaleFactor();
+        if (adaptiveScaleFactor >= 0 && adaptiveScaleFactor != 1.0f) {
+            mAdaptiveScaleFactor = adaptiveScaleFactor;
+        }
+        if (hapticLevel == HapticLevel::NONE) {
+            return;
+        }
 
-void applyHapticScale(float* buffer, size_t length, HapticScale scale) {
-    if (scale.isScaleMute()) {
-        memset(buffer, 0, length * sizeof(float));
-        return;
-    }
-    if (scale.isScaleNone()) {
-        return;
-    }
-    HapticLevel hapticLevel = scale.getLevel();
-    float scaleFactor = getHapticScaleFactor(scale);
-    float adaptiveScaleFactor = scale.getAdaptiveScaleFactor();
-    float oldGamma = getOldHapticScaleGamma(hapticLevel);
-    float oldMaxAmplitudeRatio = getOldHapticMaxAmplitudeRatio(hapticLevel);
-
-    for (size_t i = 0; i < length; i++) {
-        if (hapticLevel != HapticLevel::NONE) {
-            if (android_os_vibrator_fix_audio_coupled_haptics_scaling() ||
-                android_os_vibrator_haptics_scale_v2_enabled()) {
-                buffer[i] = applyNewHapticScale(buffer[i], scaleFactor);
-            } else {
-                buffer[i] = applyOldHapticScale(buffer[i], oldGamma, oldMaxAmplitudeRatio);
+        if (android_os_vibrator_haptics_scale_v2_enabled()) {
+            mCurve = Curve::NEW_V2;
+            mScaleFactor = getHapticScaleFactor(scale);
+        } else if (android_os_vibrator_fix_audio_coupled_haptics_scaling()) {
+            float scaleFactor = getHapticScaleFactor(scale);
+            mScaleFactor = powf(scaleFactor, 1.0f / SCALE_GAMMA);
+            if (scaleFactor <= 1) {
+                // Scale down is simply a gamma corrected application of scaleFactor to the
+                // intensity.
+                mCurve = Curve::NEW_V2;
+                return;
             }
+            // Scale up requires a different curve to ensure the intensity will not become > 1.
+            mCurve = Curve::NEW;
+            mScaleFactor *= powf(scaleFactor, 4.0f - scaleFactor);
+            // mScaleFactor is the scaled x for intensity == 1.
+            float expMaxX = expf(mScaleFactor);
+            // Using f = tanh as the scale up function so the max value will converge.
+            // a = 1/f(maxX), used to scale f so that a*f(maxX) = 1 (the value will converge to 1).
+            mTanhScale = (expMaxX + 1.0f) / (expMaxX - 1.0f);
+        } else {
+            mCurve = Curve::OLD;
+            mOldGamma = getOldHapticScaleGamma(hapticLevel);
+            mOldMaxAmplitudeRatio = getOldHapticMaxAmplitudeRatio(hapticLevel);
         }
+    }
 
-        if (adaptiveScaleFactor >= 0 && adaptiveScaleFactor != 1.0f) {
-            buffer[i] *= adaptiveScaleFactor;
+    // Scales and limits every stride-th sample of the buffer, from the first one.
+    void apply(float* buffer, size_t length, size_t stride) const {
+        if (mMute) {
+            for (size_t i = 0; i < length; i += stride) {
+                buffer[i] = 0;
+            }
+            return;
+        }
+        if (mCurve == Curve::NONE && mAdaptiveScaleFactor == 1.0f && mLimit == 0) {
+            return;
+        }
+        size_t i = 0;
+        if (stride == 1 && (mCurve == Curve::NONE || mCurve == Curve::NEW_V2)) {
+            i = applyVectorized(buffer, length);
+        }
+        for (; i < length; i += stride) {
+            buffer[i] = applyToSample(buffer[i]);
         }
     }
-}
 
-void clipHapticData(float* buffer, size_t length, float limit) {
-    if (isnan(limit) || limit == 0) {
-        return;
+private:
+    enum class Curve {
+        NONE,
+        OLD,
+        NEW,
+        NEW_V2,
+    };
+
+    float applyToSample(float value) const {
+        switch (mCurve) {
+            case Curve::NONE:
+                break;
+            case Curve::OLD:
+                value = applyOldHapticScale(value, mOldGamma, mOldMaxAmplitudeRatio);
+                break;
+            case Curve::NEW: {
+                float sign = value >= 0 ? 1.0f : -1.0f;
+                float expX = expf(fabsf(value) * mScaleFactor);
+                float fx = (expX - 1.0f) / (expX + 1.0f);
+                value = sign * std::clamp(mTanhScale * fx, 0.0f, 1.0f);
+                break;
+            }
+            case Curve::NEW_V2:
+                value = applyNewHapticScaleV2(value, mScaleFactor);
+                break;
+        }
+        value *= mAdaptiveScaleFactor;
+        if (mLimit != 0 && fabsf(value) > mLimit) {
+            value = value >= 0 ? mLimit : -mLimit;
+        }
+        return value;
     }
-    limit = fabsf(limit);
-    for (size_t i = 0; i < length; i++) {
-        float sign = buffer[i] >= 0 ? 1.0 : -1.0;
-        if (fabsf(buffer[i]) > limit) {
-            buffer[i] = limit * sign;
+
+#if HAPTIC_SIMD
+#if defined(__aarch64__)
+    typedef float32x4_t vfloat4;
+
+    static vfloat4 load(const float* p) { return vld1q_f32(p); }
+    static void store(float* p, vfloat4 v) { vst1q_f32(p, v); }
+    static vfloat4 splat(float f) { return vdupq_n_f32(f); }
+    static vfloat4 add(vfloat4 a, vfloat4 b) { return vaddq_f32(a, b); }
+    static vfloat4 mul(vfloat4 a, vfloat4 b) { return vmulq_f32(a, b); }
+    static vfloat4 div(vfloat4 a, vfloat4 b) { return vdivq_f32(a, b); }
+    // Both keep a NaN in v, as the scalar limit does.
+    static vfloat4 min(vfloat4 limit, vfloat4 v) { return vminq_f32(limit, v); }
+    static vfloat4 max(vfloat4 limit, vfloat4 v) { return vmaxq_f32(limit, v); }
+#else
+    typedef __m128 vfloat4;
+
+    static vfloat4 load(const float* p) { return _mm_loadu_ps(p); }
+    static void store(float* p, vfloat4 v) { _mm_storeu_ps(p, v); }
+    static vfloat4 splat(float f) { return _mm_set1_ps(f); }
+    static vfloat4 add(vfloat4 a, vfloat4 b) { return _mm_add_ps(a, b); }
+    static vfloat4 mul(vfloat4 a, vfloat4 b) { return _mm_mul_ps(a, b); }
+    static vfloat4 div(vfloat4 a, vfloat4 b) { return _mm_div_ps(a, b); }
+    // Both keep a NaN in v, as the scalar limit does, since SSE returns the second operand then.
+    static vfloat4 min(vfloat4 limit, vfloat4 v) { return _mm_min_ps(limit, v); }
+    static vfloat4 max(vfloat4 limit, vfloat4 v) { return _mm_max_ps(limit, v); }
+#endif
+
+    // Scales and limits the samples 4 at a time, for the curves that need no transcendental
+    // functions. Returns how many samples were done, which leaves fewer than 4 to the caller.
+    size_t applyVectorized(float* buffer, size_t length) const {
+        const bool scaleUp = mCurve == Curve::NEW_V2 && mScaleFactor > 1;
+        const vfloat4 scaleFactor = splat(mCurve == Curve::NEW_V2 ? mScaleFactor : 1.0f);
+        const vfloat4 scaleUpFactor = splat(mScaleFactor - 1);
+        const vfloat4 one = splat(1.0f);
+        const vfloat4 adaptiveScaleFactor = splat(mAdaptiveScaleFactor);
+        const vfloat4 limit = splat(mLimit);
+        const vfloat4 negativeLimit = splat(-mLimit);
+
+        size_t i = 0;
+        for (; i + 4 <= length; i += 4) {
+            vfloat4 v = load(buffer + i);
+            vfloat4 scaled = mul(v, scaleFactor);
+            if (scaleUp) {
+                scaled = div(scaled, add(one, mul(scaleUpFactor, mul(v, v))));
+            }
+            v = mul(scaled, adaptiveScaleFactor);
+            if (mLimit != 0) {
+                v = max(negativeLimit, min(limit, v));
+            }
+            store(buffer + i, v);
         }
+        return i;
     }
-}
+#else
+    size_t applyVectorized(float*, size_t) const { return 0; }
+#endif
+
+    bool mMute = false;
+    Curve mCurve = Curve::NONE;
+    // For NEW_V2, the factor of the curve. For NEW, the gamma corrected factor of the curve, times
+    // the extra scale of the tanh curve.
+    float mScaleFactor = 1.0f;
+    float mTanhScale = 1.0f;
+    float mOldGamma = 1.0f;
+    float mOldMaxAmplitudeRatio = 1.0f;
+    float mAdaptiveScaleFactor = 1.0f;
+    // 0 for no limit.
+    float mLimit = 0;
+};
 
 } // namespace
 
@@ -202,10 +326,19 @@ bool isValidHapticScale(HapticScale scale) {
 }
 
 void scaleHapticData(float* buffer, size_t length, HapticScale scale, float limit) {
-    if (isValidHapticScale(scale)) {
-        applyHapticScale(buffer, length, scale);
+    HapticScaler(scale, limit).apply(buffer, length, 1 /* stride */);
+}
+
+void scaleInterleavedHapticData(float* buffer, size_t frameCount, size_t audioChannelCount,
+                                size_t hapticChannelCount, HapticScale scale, float limit) {
+    if (frameCount == 0) {
+        return;
+    }
+    const HapticScaler scaler(scale, limit);
+    const size_t frameSize = audioChannelCount + hapticChannelCount;
+    for (size_t channel = audioChannelCount; channel < frameSize; channel++) {
+        scaler.apply(buffer + channel, frameCount * frameSize - channel, frameSize);
     }
-    clipHapticData(buffer, length, limit);
 }
 
 } // namespace android::os
@@ -83,6 +83,13 @@ bool isValidHapticScale(HapticScale scale);
  */
 void scaleHapticData(float* buffer, size_t length, HapticScale scale, float limit);
 
+/* Same as scaleHapticData, for a buffer of frameCount interleaved frames that each start with
+ * audioChannelCount audio samples, followed by hapticChannelCount haptic samples. Only the haptic
+ * samples are changed, so that audio-coupled haptics can be scaled in place.
+ */
+void scaleInterleavedHapticData(float* buffer, size_t frameCount, size_t audioChannelCount,
+                                size_t hapticChannelCount, HapticScale scale, float limit);
+
 } // namespace android::os
 
 #endif // ANDROID_EXTERNAL_VIBRATION_UTILS_H
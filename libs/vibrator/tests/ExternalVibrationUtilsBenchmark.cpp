@@ -0,0 +1,93 @@
+/*
+ * Copyright (C) 2024 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <benchmark/benchmark.h>
+#include <vibrator/ExternalVibrationUtils.h>
+
+#include <algorithm>
+#include <cmath>
+#include <vector>
+
+using android::os::HapticLevel;
+using android::os::HapticScale;
+
+namespace {
+
+// A mix buffer of the audio thread holds this many frames, e.g. 20ms at 48kHz.
+constexpr size_t kFrameCount = 960;
+constexpr float kLimit = 0.8f;
+
+std::vector<float> makeHapticData(size_t length) {
+    std::vector<float> data(length);
+    for (size_t i = 0; i < length; i++) {
+        data[i] = sinf(static_cast<float>(i) * 0.05f);
+    }
+    return data;
+}
+
+HapticScale getScale(benchmark::State& state) {
+    // The level of the scale comes as its int value, to be listed by the benchmark names.
+    return HapticScale(static_cast<HapticLevel>(state.range(0)), -1 /* scaleFactor */,
+                       0.9f /* adaptiveScaleFactor */);
+}
+
+void BM_ScaleHapticData(benchmark::State& state) {
+    const std::vector<float> input = makeHapticData(kFrameCount);
+    std::vector<float> buffer(input.size());
+    const HapticScale scale = getScale(state);
+
+    for (auto _ : state) {
+        // Scaling the same samples over and over would turn them into slow denormals, so start
+        // from the input every time, as the audio thread does with each new mix buffer.
+        std::copy(input.begin(), input.end(), buffer.begin());
+        android::os::scaleHapticData(buffer.data(), buffer.size(), scale, kLimit);
+        benchmark::ClobberMemory();
+    }
+    state.SetItemsProcessed(static_cast<int64_t>(state.iterations() * buffer.size()));
+}
+
+// Stereo audio with one haptic channel, scaled in place.
+void BM_ScaleInterleavedHapticData(benchmark::State& state) {
+    constexpr size_t kAudioChannelCount = 2;
+    constexpr size_t kHapticChannelCount = 1;
+    const std::vector<float> input =
+            makeHapticData(kFrameCount * (kAudioChannelCount + kHapticChannelCount));
+    std::vector<float> buffer(input.size());
+    const HapticScale scale = getScale(state);
+
+    for (auto _ : state) {
+        // Scaling the same samples over and over would turn them into slow denormals, so start
+        // from the input every time, as the audio thread does with each new mix buffer.
+        std::copy(input.begin(), input.end(), buffer.begin());
+        android::os::scaleInterleavedHapticData(buffer.data(), kFrameCount, kAudioChannelCount,
+                                                kHapticChannelCount, scale, kLimit);
+        benchmark::ClobberMemory();
+    }
+    state.SetItemsProcessed(static_cast<int64_t>(state.iterations() * kFrameCount));
+}
+
+void HapticLevels(benchmark::internal::Benchmark* b) {
+    for (HapticLevel level : {HapticLevel::NONE, HapticLevel::LOW, HapticLevel::VERY_HIGH}) {
+        b->Arg(static_cast<int64_t>(level));
+    }
+}
+
+BENCHMARK(BM_ScaleHapticData)->Apply(HapticLevels);
+BENCHMARK(BM_ScaleInterleavedHapticData)->Apply(HapticLevels);
+
+} // namespace
+
+BENCHMARK_MAIN();
@@ -378,3 +378,52 @@ TEST_F_WITH_FLAGS(
     scaleBuffer(HapticLevel::VERY_LOW, 2 /* adaptiveScaleFactor */, 0.7f /* limit */);
     EXPECT_FLOATS_NEARLY_EQ(expectedClippedVeryLow, mBuffer, TEST_BUFFER_LENGTH, TEST_TOLERANCE);
 }
+
+TEST_F(ExternalVibrationUtilsTest, TestLongBufferScaledAsEachSample) {
+    // Long enough for the vectorized loop, with a remainder for the scalar one.
+    constexpr size_t length = 11;
+    float buffer[length];
+    for (size_t i = 0; i < length; i++) {
+        buffer[i] = TEST_BUFFER[i % TEST_BUFFER_LENGTH] * (1 - 0.05f * i);
+    }
+
+    for (HapticScale scale : {HapticScale(HapticLevel::VERY_HIGH),
+                              HapticScale(HapticLevel::LOW, -1 /* scaleFactor */, 0.5f),
+                              HapticScale(HapticLevel::NONE, -1 /* scaleFactor */, 1.5f),
+                              HapticScale(HapticLevel::HIGH, 2.0f /* scaleFactor */, 1.0f)}) {
+        float expected[length];
+        std::copy(std::begin(buffer), std::end(buffer), std::begin(expected));
+        for (size_t i = 0; i < length; i++) {
+            os::scaleHapticData(&expected[i], 1, scale, 0.6f /* limit */);
+        }
+
+        float actual[length];
+        std::copy(std::begin(buffer), std::end(buffer), std::begin(actual));
+        os::scaleHapticData(&actual[0], length, scale, 0.6f /* limit */);
+        SCOPED_TRACE(scale.toString());
+        EXPECT_FLOATS_NEARLY_EQ(expected, actual, length, 1e-6f);
+    }
+}
+
+TEST_F(ExternalVibrationUtilsTest, TestInterleavedScaleOnlyChangesHapticChannels) {
+    constexpr size_t audioChannelCount = 2;
+    constexpr size_t frameSize = audioChannelCount + 1;
+    constexpr float audioSample = 0.9f;
+    float frames[TEST_BUFFER_LENGTH * frameSize];
+    for (size_t i = 0; i < TEST_BUFFER_LENGTH; i++) {
+        std::fill_n(&frames[i * frameSize], audioChannelCount, audioSample);
+        frames[i * frameSize + audioChannelCount] = TEST_BUFFER[i];
+    }
+
+    HapticScale scale(HapticLevel::VERY_HIGH, -1 /* scaleFactor */, 0.8f);
+    scaleBuffer(scale, 0.5f /* limit */);
+    os::scaleInterleavedHapticData(&frames[0], TEST_BUFFER_LENGTH, audioChannelCount,
+                                   1 /* hapticChannelCount */, scale, 0.5f /* limit */);
+
+    for (size_t i = 0; i < TEST_BUFFER_LENGTH; i++) {
+        EXPECT_EQ(audioSample, frames[i * frameSize]) << " at frame: " << i;
+        EXPECT_EQ(audioSample, frames[i * frameSize + 1]) << " at frame: " << i;
+        EXPECT_NEAR(mBuffer[i], frames[i * frameSize + audioChannelCount], 1e-6f)
+                << " at frame: " << i;
+    }
+}
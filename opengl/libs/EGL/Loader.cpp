@@ -225,6 +225,7 @@ void Loader::unload_system_driver(egl_connection_t* cnx) {
                        ->hooks[egl_connection_t::GLESv1_INDEX]
                        ->gl);
     uninit_api(egl_names, (__eglMustCastToProperFunctionPointerType*)&cnx->egl);
+    defer_gles1_api(nullptr);
 
     if (cnx->dso) {
         ALOGD("Unload system gl driver.");
@@ -374,6 +375,8 @@ void* Loader::open(egl_connection_t* cnx) {
 
 void Loader::close(egl_connection_t* cnx)
 {
+    defer_gles1_api(nullptr);
+
     driver_t* hnd = (driver_t*) cnx->dso;
     delete hnd;
     cnx->dso = nullptr;
@@ -604,9 +607,7 @@ Loader::driver_t* Loader::attempt_to_load_angle(egl_connection_t* cnx) {
         initialize_api(dso, cnx, EGL);
         hnd = new driver_t(dso);
 
-        dso = load_angle("GLESv1_CM", ns);
-        initialize_api(dso, cnx, GLESv1_CM);
-        hnd->set(dso, GLESv1_CM);
+        defer_gles1_api([ns]() { return load_angle("GLESv1_CM", ns); });
 
         dso = load_angle("GLESv2", ns);
         initialize_api(dso, cnx, GLESv2);
@@ -642,7 +643,8 @@ Loader::driver_t* Loader::attempt_to_load_updated_driver(egl_connection_t* cnx)
     driver_t* hnd = nullptr;
     void* dso = load_updated_driver("GLES", ns);
     if (dso) {
-        initialize_api(dso, cnx, EGL | GLESv1_CM | GLESv2);
+        initialize_api(dso, cnx, EGL | GLESv2);
+        defer_gles1_api([dso]() { return dso; });
         hnd = new driver_t(dso);
         return hnd;
     }
@@ -652,9 +654,7 @@ Loader::driver_t* Loader::attempt_to_load_updated_driver(egl_connection_t* cnx)
         initialize_api(dso, cnx, EGL);
         hnd = new driver_t(dso);
 
-        dso = load_updated_driver("GLESv1_CM", ns);
-        initialize_api(dso, cnx, GLESv1_CM);
-        hnd->set(dso, GLESv1_CM);
+        defer_gles1_api([ns]() { return load_updated_driver("GLESv1_CM", ns); });
 
         dso = load_updated_driver("GLESv2", ns);
         initialize_api(dso, cnx, GLESv2);
@@ -676,7 +676,8 @@ Loader::driver_t* Loader::attempt_to_load_system_driver(egl_connection_t* cnx, c
     driver_t* hnd = nullptr;
     void* dso = load_system_driver("GLES", suffix, exact);
     if (dso) {
-        initialize_api(dso, cnx, EGL | GLESv1_CM | GLESv2);
+        initialize_api(dso, cnx, EGL | GLESv2);
+        defer_gles1_api([dso]() { return dso; });
         hnd = new driver_t(dso);
         return hnd;
     }
@@ -685,9 +686,11 @@ Loader::driver_t* Loader::attempt_to_load_system_driver(egl_connection_t* cnx, c
         initialize_api(dso, cnx, EGL);
         hnd = new driver_t(dso);
 
-        dso = load_system_driver("GLESv1_CM", suffix, exact);
-        initialize_api(dso, cnx, GLESv1_CM);
-        hnd->set(dso, GLESv1_CM);
+        // The suffix may not outlive this call
+        defer_gles1_api([suffix = std::string(suffix ? suffix : ""), exact]() {
+            return load_system_driver("GLESv1_CM", suffix.empty() ? nullptr : suffix.c_str(),
+                                      exact);
+        });
 
         dso = load_system_driver("GLESv2", suffix, exact);
         initialize_api(dso, cnx, GLESv2);
@@ -696,6 +699,29 @@ Loader::driver_t* Loader::attempt_to_load_system_driver(egl_connection_t* cnx, c
     return hnd;
 }
 
+void Loader::defer_gles1_api(std::function<void*()> load) {
+    std::lock_guard<std::mutex> lock(gles1Mutex);
+    loadGles1 = std::move(load);
+}
+
+void Loader::init_gles1_api(egl_connection_t* cnx) {
+    std::lock_guard<std::mutex> lock(gles1Mutex);
+    if (!loadGles1) {
+        return;
+    }
+
+    ATRACE_CALL();
+    void* dso = loadGles1();
+    loadGles1 = nullptr;
+    initialize_api(dso, cnx, GLESv1_CM);
+
+    // A driver in a single library already holds it
+    driver_t* hnd = (driver_t*)cnx->dso;
+    if (hnd && dso != hnd->dso[0]) {
+        hnd->set(dso, GLESv1_CM);
+    }
+}
+
 void Loader::initialize_api(void* dso, egl_connection_t* cnx, uint32_t mask) {
     if (mask & EGL) {
         getProcAddress = (getProcAddressType)dlsym(dso, "eglGetProcAddress");
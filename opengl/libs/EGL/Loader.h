@@ -20,6 +20,9 @@
 #include <EGL/egl.h>
 #include <stdint.h>
 
+#include <functional>
+#include <mutex>
+
 namespace android {
 
 struct egl_connection_t;
@@ -43,6 +46,10 @@ class Loader {
 
     getProcAddressType getProcAddress;
 
+    // Loads the GLESv1_CM library of the current driver, until its entry points are resolved.
+    std::mutex gles1Mutex;
+    std::function<void*()> loadGles1;
+
 public:
     static Loader& getInstance();
     ~Loader();
@@ -50,6 +57,10 @@ public:
     void* open(egl_connection_t* cnx);
     void close(egl_connection_t* cnx);
 
+    // open() leaves out the GLESv1_CM entry points, which most apps never use. This loads and
+    // resolves them the first time it is called, before a GLESv1 context is used.
+    void init_gles1_api(egl_connection_t* cnx);
+
 private:
     Loader();
     driver_t* attempt_to_load_angle(egl_connection_t* cnx);
@@ -57,6 +68,7 @@ private:
     driver_t* attempt_to_load_system_driver(egl_connection_t* cnx, const char* suffix, const bool exact);
     void unload_system_driver(egl_connection_t* cnx);
     void initialize_api(void* dso, egl_connection_t* cnx, uint32_t mask);
+    void defer_gles1_api(std::function<void*()> load);
     void attempt_to_init_angle_backend(void* dso, egl_connection_t* cnx);
 
     static __attribute__((noinline)) void init_api(void* dso, const char* const* api,
@@ -43,6 +43,12 @@ using namespace std::literals;
 constexpr uint32_t kMultifileMagic = 'MFB$';
 constexpr uint32_t kCrcPlaceholder = 0;
 
+// Entries in the pack file start at this alignment, so their header can be read in place
+constexpr size_t kPackAlignment = alignof(android::MultifileHeader);
+
+// The pack is written again at init once this fraction of the cache is outside of it
+constexpr size_t kPackRewriteDivisor = 4;
+
 namespace {
 
 // Helper function to close entries or free them
@@ -66,6 +72,9 @@ MultifileBlobCache::MultifileBlobCache(size_t maxKeySize, size_t maxValueSize, s
                                        size_t maxTotalEntries, const std::string& baseDir)
       : mInitialized(false),
         mCacheVersion(0),
+        mPackBuffer(nullptr),
+        mPackSize(0),
+        mUnpackedSize(0),
         mMaxKeySize(maxKeySize),
         mMaxValueSize(maxValueSize),
         mMaxTotalSize(maxTotalSize),
@@ -103,6 +112,18 @@ MultifileBlobCache::MultifileBlobCache(size_t maxKeySize, size_t maxValueSize, s
     // Establish the name of our multifile directory
     mMultifileDirName = baseDir + ".multifile";
 
+    // Look for a system cache shared by all apps, override if debug value set
+    std::string systemDirName = base::GetProperty("ro.egl.blobcache.system_dir", "");
+    std::string debugSystemDirName = base::GetProperty("debug.egl.blobcache.system_dir", "");
+    if (!debugSystemDirName.empty()) {
+        ALOGV("INIT: Using %s as system cache instead of %s", debugSystemDirName.c_str(),
+              systemDirName.c_str());
+        systemDirName = debugSystemDirName;
+    }
+    if (!systemDirName.empty()) {
+        initSystemCache(systemDirName);
+    }
+
     // Set the hotcache limit to be large enough to contain one max entry
     // This ensure the hot cache is always large enough for single entry
     mHotCacheLimit = mMaxKeySize + mMaxValueSize + sizeof(MultifileHeader);
@@ -134,13 +155,19 @@ MultifileBlobCache::MultifileBlobCache(size_t maxKeySize, size_t maxValueSize, s
     }
 
     if (statusGood) {
+        // Map the pack first, so entries it holds don't need to be read from their own files
+        time_t packTime = 0;
+        openPack(&packTime);
+
         // Read all the files and gather details, then preload their contents
         DIR* dir;
         struct dirent* entry;
         if ((dir = opendir(mMultifileDirName.c_str())) != nullptr) {
             while ((entry = readdir(dir)) != nullptr) {
                 if (entry->d_name == "."s || entry->d_name == ".."s ||
-                    strcmp(entry->d_name, kMultifileBlobCacheStatusFile) == 0) {
+                    strcmp(entry->d_name, kMultifileBlobCacheStatusFile) == 0 ||
+                    strncmp(entry->d_name, kMultifileBlobCachePackFile,
+                            strlen(kMultifileBlobCachePackFile)) == 0) {
                     continue;
                 }
 
@@ -201,6 +228,25 @@ MultifileBlobCache::MultifileBlobCache(size_t maxKeySize, size_t maxValueSize, s
                 // Note: Converting from off_t (signed) to size_t (unsigned)
                 size_t fileSize = static_cast<size_t>(st.st_size);
 
+                // If the pack holds the same entry, use it from there and drop this file
+                auto packedIter = mPackedEntries.find(entryHash);
+                if (packedIter != mPackedEntries.end()) {
+                    const MultifilePackEntry* packEntry = packedIter->second.packEntry;
+                    if (packEntry->entryCrc == header.crc && packEntry->entrySize == fileSize) {
+                        ALOGV("INIT: Entry %u is in the pack, removing its file.", entryHash);
+                        if (remove(fullPath.c_str()) != 0) {
+                            ALOGE("INIT: Error removing %s: %s", fullPath.c_str(),
+                                  std::strerror(errno));
+                        }
+                        close(fd);
+                        continue;
+                    }
+
+                    // The entry was set again after the pack was written
+                    ALOGV("INIT: Entry %u in the pack is out of date.", entryHash);
+                    mPackedEntries.erase(packedIter);
+                }
+
                 // Memory map the file
                 uint8_t* mappedEntry = reinterpret_cast<uint8_t*>(
                         mmap(nullptr, fileSize, PROT_READ, MAP_PRIVATE, fd, 0));
@@ -243,6 +289,7 @@ MultifileBlobCache::MultifileBlobCache(size_t maxKeySize, size_t maxValueSize, s
 
                 // Track the total size
                 increaseTotalCacheSize(fileSize);
+                mUnpackedSize += fileSize;
 
                 // Preload the entry for fast retrieval
                 if ((mHotCacheSize + fileSize) < mHotCacheLimit) {
@@ -265,6 +312,19 @@ MultifileBlobCache::MultifileBlobCache(size_t maxKeySize, size_t maxValueSize, s
         } else {
             ALOGE("Unable to open filename: %s", mMultifileDirName.c_str());
         }
+
+        // Track the entries that are only in the pack
+        for (const auto& [entryHash, packedEntry] : mPackedEntries) {
+            ALOGV("INIT: Entry %u is in the pack, tracking it now.", entryHash);
+            trackEntry(entryHash, packedEntry.packEntry->valueSize,
+                       packedEntry.packEntry->entrySize, packTime);
+            increaseTotalCacheSize(packedEntry.packEntry->entrySize);
+        }
+
+        // Pack the entries again if enough of them are in their own files
+        if (mUnpackedSize > 0 && mUnpackedSize * kPackRewriteDivisor >= getTotalSize()) {
+            queueWritePack();
+        }
     } else {
         // If the multifile directory does not exist, create it and start from scratch
         if (mkdir(mMultifileDirName.c_str(), 0755) != 0 && (errno != EEXIST)) {
@@ -299,6 +359,9 @@ MultifileBlobCache::~MultifileBlobCache() {
     if (mTaskThread.joinable()) {
         mTaskThread.join();
     }
+
+    closePack();
+    unmapSystemCache();
 }
 
 // Set will add the entry to hot cache and start a deferred process to write it to disk
@@ -320,6 +383,10 @@ void MultifileBlobCache::set(const void* key, EGLsizeiANDROID keySize, const voi
 
     size_t fileSize = sizeof(MultifileHeader) + keySize + valueSize;
 
+    // The new value goes to its own file, stop using the one in the pack
+    mPackedEntries.erase(entryHash);
+    mUnpackedSize += fileSize;
+
     // If we're going to be over the cache limit, kick off a trim to clear space
     if (getTotalSize() + fileSize > mMaxTotalSize || getTotalEntries() + 1 > mMaxTotalEntries) {
         ALOGV("SET: Cache is full, calling trimCache to clear space");
@@ -390,6 +457,14 @@ EGLsizeiANDROID MultifileBlobCache::get(const void* key, EGLsizeiANDROID keySize
     // Generate a hash of the key and use it to track this entry
     uint32_t entryHash = android::JenkinsHashMixBytes(0, static_cast<const uint8_t*>(key), keySize);
 
+    // Check the system cache before our own
+    bool foundInSystemCache = false;
+    EGLsizeiANDROID systemValueSize =
+            getFromSystemCache(entryHash, key, keySize, value, valueSize, &foundInSystemCache);
+    if (foundInSystemCache) {
+        return systemValueSize;
+    }
+
     // See if we have this file
     if (!contains(entryHash)) {
         ALOGV("GET: Cache MISS - cache does not contain entry: %u", entryHash);
@@ -428,6 +503,12 @@ EGLsizeiANDROID MultifileBlobCache::get(const void* key, EGLsizeiANDROID keySize
     if (mHotCache.find(entryHash) != mHotCache.end()) {
         ALOGV("GET: HotCache HIT for entry %u", entryHash);
         cacheEntry = mHotCache[entryHash].entryBuffer;
+    } else if (mPackedEntries.find(entryHash) != mPackedEntries.end()) {
+        ALOGV("GET: Pack HIT for entry %u", entryHash);
+        cacheEntry = getPackedEntry(entryHash);
+        if (cacheEntry == nullptr) {
+            return 0;
+        }
     } else {
         ALOGV("GET: HotCache MISS for entry: %u", entryHash);
 
@@ -518,6 +599,367 @@ void MultifileBlobCache::finish() {
 
         mHotCache.erase(hotCacheIter++);
     }
+
+    // Release the pack and the system cache entries
+    closePack();
+    unmapSystemCache();
+}
+
+// Map the pack file and index the entries it holds
+bool MultifileBlobCache::openPack(time_t* packTime) {
+    std::string packPath = mMultifileDirName + "/" + kMultifileBlobCachePackFile;
+    int fd = open(packPath.c_str(), O_RDONLY);
+    if (fd == -1) {
+        ALOGV("PACK: No pack file (%s)", packPath.c_str());
+        return false;
+    }
+
+    struct stat st;
+    if (fstat(fd, &st) != 0 || static_cast<size_t>(st.st_size) < sizeof(MultifilePackHeader)) {
+        ALOGE("PACK: Pack file has invalid stats! Removing.");
+        close(fd);
+        remove(packPath.c_str());
+        return false;
+    }
+
+    // Note: Converting from off_t (signed) to size_t (unsigned)
+    size_t packSize = static_cast<size_t>(st.st_size);
+
+    // Memory map the whole pack, entries are only read from disk once they are used
+    uint8_t* packBuffer =
+            reinterpret_cast<uint8_t*>(mmap(nullptr, packSize, PROT_READ, MAP_PRIVATE, fd, 0));
+
+    // We can close the file now and the mmap will remain
+    close(fd);
+
+    if (packBuffer == MAP_FAILED) {
+        ALOGE("PACK: Failed to mmap pack, error: %s", std::strerror(errno));
+        return false;
+    }
+
+    // Verify the header and the index, the entries are checked when they are first used
+    const MultifilePackHeader* header = reinterpret_cast<const MultifilePackHeader*>(packBuffer);
+    size_t maxEntryCount = (packSize - sizeof(MultifilePackHeader)) / sizeof(MultifilePackEntry);
+    if (header->magic != kMultifileMagic || header->entryCount > maxEntryCount) {
+        ALOGE("PACK: Pack file has a bad header! Removing.");
+        munmap(packBuffer, packSize);
+        remove(packPath.c_str());
+        return false;
+    }
+    size_t indexEnd =
+            sizeof(MultifilePackHeader) + header->entryCount * sizeof(MultifilePackEntry);
+    if (header->crc !=
+        crc32c(packBuffer + offsetof(MultifilePackHeader, entryCount),
+               indexEnd - offsetof(MultifilePackHeader, entryCount))) {
+        ALOGE("PACK: Pack file failed CRC check! Removing.");
+        munmap(packBuffer, packSize);
+        remove(packPath.c_str());
+        return false;
+    }
+
+    const MultifilePackEntry* index =
+            reinterpret_cast<const MultifilePackEntry*>(packBuffer + sizeof(MultifilePackHeader));
+    for (size_t i = 0; i < header->entryCount; i++) {
+        const MultifilePackEntry& packEntry = index[i];
+        if (packEntry.offset < indexEnd || packEntry.offset % kPackAlignment != 0 ||
+            packEntry.entrySize < sizeof(MultifileHeader) || packEntry.valueSize == 0 ||
+            packEntry.offset > packSize || packEntry.entrySize > packSize - packEntry.offset) {
+            ALOGE("PACK: Entry %u has a bad index, skipping it.", packEntry.entryHash);
+            continue;
+        }
+        mPackedEntries[packEntry.entryHash] = {&packEntry, false};
+    }
+
+    ALOGV("PACK: Mapped %zu entries from %s", mPackedEntries.size(), packPath.c_str());
+    mPackBuffer = packBuffer;
+    mPackSize = packSize;
+    *packTime = st.st_mtime;
+    return true;
+}
+
+void MultifileBlobCache::closePack() {
+    if (mPackBuffer != nullptr) {
+        munmap(mPackBuffer, mPackSize);
+        mPackBuffer = nullptr;
+        mPackSize = 0;
+    }
+    mPackedEntries.clear();
+}
+
+// Return an entry from the pack, checking its CRC the first time
+uint8_t* MultifileBlobCache::getPackedEntry(uint32_t entryHash) {
+    auto packedIter = mPackedEntries.find(entryHash);
+    if (packedIter == mPackedEntries.end()) {
+        return nullptr;
+    }
+
+    MultifilePackedEntry& packedEntry = packedIter->second;
+    uint8_t* cacheEntry = mPackBuffer + packedEntry.packEntry->offset;
+    if (!packedEntry.verified) {
+        size_t entrySize = packedEntry.packEntry->entrySize;
+        MultifileHeader* header = reinterpret_cast<MultifileHeader*>(cacheEntry);
+        if (header->magic != kMultifileMagic || header->crc != packedEntry.packEntry->entryCrc ||
+            header->crc !=
+                    crc32c(cacheEntry + sizeof(MultifileHeader),
+                           entrySize - sizeof(MultifileHeader))) {
+            ALOGE("PACK: Entry %u failed CRC check! Removing.", entryHash);
+            mPackedEntries.erase(packedIter);
+            decreaseTotalCacheSize(getEntryStats(entryHash).fileSize);
+            mEntryStats.erase(entryHash);
+            mEntries.erase(entryHash);
+            return nullptr;
+        }
+        packedEntry.verified = true;
+    }
+
+    return cacheEntry;
+}
+
+// Ask the worker thread to write all the entries to a new pack
+void MultifileBlobCache::queueWritePack() {
+    std::vector<MultifilePackSource> sources;
+    sources.reserve(mEntryStats.size());
+    for (const auto& [entryHash, entryStats] : mEntryStats) {
+        // The current pack stays mapped until the worker thread is done with it
+        auto packedIter = mPackedEntries.find(entryHash);
+        if (packedIter != mPackedEntries.end()) {
+            const MultifilePackEntry* packEntry = packedIter->second.packEntry;
+            sources.push_back({entryHash, mPackBuffer + packEntry->offset, packEntry->entrySize});
+        } else {
+            sources.push_back({entryHash, nullptr, entryStats.fileSize});
+        }
+    }
+
+    ALOGV("PACK: Adding task to write %zu entries to the pack.", sources.size());
+    DeferredTask task(TaskCommand::WritePack);
+    task.initWritePack(mMultifileDirName + "/" + kMultifileBlobCachePackFile, std::move(sources));
+    queueTask(std::move(task));
+
+    // Don't write it again until the next init
+    mUnpackedSize = 0;
+}
+
+// Runs on the worker thread, after the writes of every entry it packs
+void MultifileBlobCache::writePack(const std::string& packPath,
+                                   const std::vector<MultifilePackSource>& sources) {
+    // Write the pack next to the current one, which may still be in use
+    std::string tempPath = packPath + ".tmp";
+    int fd = open(tempPath.c_str(), O_WRONLY | O_CREAT | O_TRUNC, S_IRUSR | S_IWUSR);
+    if (fd == -1) {
+        ALOGE("PACK: Failed to open %s, error: %s", tempPath.c_str(), std::strerror(errno));
+        return;
+    }
+
+    // The entries go after room for an index of all of them, which is written last
+    std::vector<uint8_t> indexBuffer(sizeof(MultifilePackHeader) +
+                                     sources.size() * sizeof(MultifilePackEntry));
+    MultifilePackEntry* index =
+            reinterpret_cast<MultifilePackEntry*>(indexBuffer.data() + sizeof(MultifilePackHeader));
+    size_t entryCount = 0;
+    size_t offset = indexBuffer.size();
+
+    std::vector<uint8_t> entryBuffer;
+    for (const MultifilePackSource& source : sources) {
+        const uint8_t* buffer = source.buffer;
+        size_t entrySize = source.entrySize;
+        if (buffer == nullptr) {
+            // Read the entry from its own file, which may have been removed since
+            std::string fullPath = mMultifileDirName + "/" + std::to_string(source.entryHash);
+            int entryFd = open(fullPath.c_str(), O_RDONLY);
+            if (entryFd == -1) {
+                ALOGV("PACK: Entry %u is gone, skipping it.", source.entryHash);
+                continue;
+            }
+            struct stat st;
+            if (fstat(entryFd, &st) != 0 ||
+                static_cast<size_t>(st.st_size) < sizeof(MultifileHeader)) {
+                close(entryFd);
+                continue;
+            }
+            entrySize = static_cast<size_t>(st.st_size);
+            entryBuffer.resize(entrySize);
+            ssize_t result = read(entryFd, entryBuffer.data(), entrySize);
+            close(entryFd);
+            if (result != entrySize) {
+                ALOGE("PACK: Error reading %s: %s", fullPath.c_str(), std::strerror(errno));
+                continue;
+            }
+            buffer = entryBuffer.data();
+        }
+
+        const MultifileHeader* header = reinterpret_cast<const MultifileHeader*>(buffer);
+        if (header->magic != kMultifileMagic || header->valueSize <= 0) {
+            ALOGV("PACK: Entry %u has a bad header, skipping it.", source.entryHash);
+            continue;
+        }
+
+        offset = (offset + kPackAlignment - 1) / kPackAlignment * kPackAlignment;
+        ssize_t result = pwrite(fd, buffer, entrySize, offset);
+        if (result != entrySize) {
+            ALOGE("PACK: Error writing entry %u to %s: %s", source.entryHash, tempPath.c_str(),
+                  std::strerror(errno));
+            close(fd);
+            remove(tempPath.c_str());
+            return;
+        }
+
+        index[entryCount++] = {source.entryHash, header->crc, static_cast<uint32_t>(entrySize),
+                               static_cast<uint32_t>(header->valueSize), offset};
+        offset += entrySize;
+    }
+
+    // Finally write the index, covered by its own CRC
+    MultifilePackHeader* header = reinterpret_cast<MultifilePackHeader*>(indexBuffer.data());
+    header->magic = kMultifileMagic;
+    header->entryCount = entryCount;
+    size_t indexEnd = sizeof(MultifilePackHeader) + entryCount * sizeof(MultifilePackEntry);
+    header->crc = crc32c(indexBuffer.data() + offsetof(MultifilePackHeader, entryCount),
+                         indexEnd - offsetof(MultifilePackHeader, entryCount));
+    ssize_t result = pwrite(fd, indexBuffer.data(), indexBuffer.size(), 0);
+    close(fd);
+    if (result != indexBuffer.size()) {
+        ALOGE("PACK: Error writing index to %s: %s", tempPath.c_str(), std::strerror(errno));
+        remove(tempPath.c_str());
+        return;
+    }
+
+    if (rename(tempPath.c_str(), packPath.c_str()) != 0) {
+        ALOGE("PACK: Error renaming %s: %s", tempPath.c_str(), std::strerror(errno));
+        remove(tempPath.c_str());
+        return;
+    }
+
+    ALOGV("PACK: Wrote %zu entries to %s", entryCount, packPath.c_str());
+}
+
+// Track the entries of the system cache, without reading them yet
+void MultifileBlobCache::initSystemCache(const std::string& systemDirName) {
+    // The system cache must have been created for this build and cache version
+    if (!checkStatus(systemDirName)) {
+        ALOGV("SYSTEM: Status of system cache (%s) does not match, ignoring it",
+              systemDirName.c_str());
+        return;
+    }
+
+    DIR* dir = opendir(systemDirName.c_str());
+    if (dir == nullptr) {
+        ALOGE("SYSTEM: Unable to open system cache dir: %s", systemDirName.c_str());
+        return;
+    }
+
+    struct dirent* entry;
+    while ((entry = readdir(dir)) != nullptr) {
+        if (entry->d_name == "."s || entry->d_name == ".."s ||
+            strcmp(entry->d_name, kMultifileBlobCacheStatusFile) == 0 ||
+            strncmp(entry->d_name, kMultifileBlobCachePackFile,
+                    strlen(kMultifileBlobCachePackFile)) == 0) {
+            continue;
+        }
+
+        // The filename is the same as the entryHash
+        uint32_t entryHash = static_cast<uint32_t>(strtoul(entry->d_name, nullptr, 10));
+        mSystemEntries[entryHash] = {nullptr, 0};
+    }
+    closedir(dir);
+
+    ALOGV("SYSTEM: Tracking %zu entries from system cache %s", mSystemEntries.size(),
+          systemDirName.c_str());
+    mSystemDirName = systemDirName;
+}
+
+// Look up an entry in the system cache, mapping and verifying it the first time
+EGLsizeiANDROID MultifileBlobCache::getFromSystemCache(uint32_t entryHash, const void* key,
+                                                       EGLsizeiANDROID keySize, void* value,
+                                                       EGLsizeiANDROID valueSize, bool* found) {
+    *found = false;
+
+    auto entryIter = mSystemEntries.find(entryHash);
+    if (entryIter == mSystemEntries.end()) {
+        return 0;
+    }
+    MultifileSystemEntry& systemEntry = entryIter->second;
+
+    std::string fullPath = mSystemDirName + "/" + std::to_string(entryHash);
+    if (systemEntry.entryBuffer == nullptr) {
+        int fd = open(fullPath.c_str(), O_RDONLY);
+        if (fd == -1) {
+            ALOGE("SYSTEM: Failed to open %s, error: %s", fullPath.c_str(), std::strerror(errno));
+            mSystemEntries.erase(entryIter);
+            return 0;
+        }
+
+        struct stat st;
+        if (fstat(fd, &st) != 0 || static_cast<size_t>(st.st_size) < sizeof(MultifileHeader)) {
+            ALOGE("SYSTEM: Entry %u has invalid stats, ignoring it", entryHash);
+            close(fd);
+            mSystemEntries.erase(entryIter);
+            return 0;
+        }
+
+        // Note: Converting from off_t (signed) to size_t (unsigned)
+        size_t fileSize = static_cast<size_t>(st.st_size);
+
+        // Memory map the file, the pages are shared with every other app using it
+        uint8_t* mappedEntry = reinterpret_cast<uint8_t*>(
+                mmap(nullptr, fileSize, PROT_READ, MAP_PRIVATE, fd, 0));
+
+        // We can close the file now and the mmap will remain
+        close(fd);
+
+        if (mappedEntry == MAP_FAILED) {
+            ALOGE("SYSTEM: Failed to mmap %s, error: %s", fullPath.c_str(), std::strerror(errno));
+            mSystemEntries.erase(entryIter);
+            return 0;
+        }
+
+        // Verify the entry once, it can't change while we have it
+        MultifileHeader* header = reinterpret_cast<MultifileHeader*>(mappedEntry);
+        if (header->magic != kMultifileMagic ||
+            header->crc !=
+                    crc32c(mappedEntry + sizeof(MultifileHeader),
+                           fileSize - sizeof(MultifileHeader)) ||
+            header->keySize <= 0 || header->valueSize <= 0 ||
+            sizeof(MultifileHeader) + header->keySize + header->valueSize != fileSize) {
+            ALOGE("SYSTEM: Entry %u is damaged, ignoring it", entryHash);
+            munmap(mappedEntry, fileSize);
+            mSystemEntries.erase(entryIter);
+            return 0;
+        }
+
+        systemEntry = {mappedEntry, fileSize};
+    }
+
+    // A different key with the same hash is left to our own cache
+    MultifileHeader* header = reinterpret_cast<MultifileHeader*>(systemEntry.entryBuffer);
+    uint8_t* cachedKey = systemEntry.entryBuffer + sizeof(MultifileHeader);
+    if (header->keySize != keySize || memcmp(cachedKey, key, keySize) != 0) {
+        ALOGV("SYSTEM: Key mismatch for entry %u", entryHash);
+        return 0;
+    }
+
+    ALOGV("SYSTEM: Cache HIT for entry %u", entryHash);
+    *found = true;
+
+    size_t cachedValueSize = header->valueSize;
+    if (cachedValueSize > valueSize) {
+        ALOGV("SYSTEM: valueSize not large enough (%lu) for entry %u, returning required size "
+              "(%zu)",
+              valueSize, entryHash, cachedValueSize);
+        return cachedValueSize;
+    }
+
+    // Remaining entry following the key is the value
+    memcpy(value, cachedKey + keySize, cachedValueSize);
+    return cachedValueSize;
+}
+
+void MultifileBlobCache::unmapSystemCache() {
+    for (auto& [entryHash, systemEntry] : mSystemEntries) {
+        if (systemEntry.entryBuffer != nullptr) {
+            munmap(systemEntry.entryBuffer, systemEntry.entrySize);
+            systemEntry = {nullptr, 0};
+        }
+    }
 }
 
 bool MultifileBlobCache::createStatus(const std::string& baseDir) {
@@ -730,11 +1172,14 @@ bool MultifileBlobCache::applyLRU(size_t cacheSizeLimit, size_t cacheEntryLimit)
         // Remove it from hot cache if present
         removeFromHotCache(entryHash);
 
-        // Remove it from the system
-        std::string entryPath = mMultifileDirName + "/" + std::to_string(entryHash);
-        if (remove(entryPath.c_str()) != 0) {
-            ALOGE("LRU: Error removing %s: %s", entryPath.c_str(), std::strerror(errno));
-            return false;
+        // Remove it from the system, entries in the pack stay there until it is written again
+        if (mPackedEntries.erase(entryHash) == 0) {
+            std::string entryPath = mMultifileDirName + "/" + std::to_string(entryHash);
+            if (remove(entryPath.c_str()) != 0) {
+                ALOGE("LRU: Error removing %s: %s", entryPath.c_str(), std::strerror(errno));
+                return false;
+            }
+            mUnpackedSize -= std::min(mUnpackedSize, entryStats.fileSize);
         }
 
         // Increment the iterator before clearing the entry
@@ -808,10 +1253,17 @@ void MultifileBlobCache::trimCache() {
 
     ALOGV("TRIM: Reducing multifile cache size to %zu, entries %zu",
           mMaxTotalSize / kCacheLimitDivisor, mMaxTotalEntries / kCacheLimitDivisor);
+    size_t packedEntries = mPackedEntries.size();
     if (!applyLRU(mMaxTotalSize / kCacheLimitDivisor, mMaxTotalEntries / kCacheLimitDivisor)) {
         ALOGE("Error when clearing multifile shader cache");
         return;
     }
+
+    // Drop the removed entries from the pack as well
+    if (mPackedEntries.size() != packedEntries) {
+        ALOGV("TRIM: Entries were removed from the pack, writing it again");
+        queueWritePack();
+    }
 }
 
 // This function performs a task.  It only knows how to write files to disk,
@@ -872,6 +1324,10 @@ void MultifileBlobCache::processTask(DeferredTask& task) {
 
             return;
         }
+        case TaskCommand::WritePack: {
+            writePack(task.getFullPath(), task.getPackSources());
+            return;
+        }
         default: {
             ALOGE("DEFERRED: Unhandled task type");
             return;
@@ -29,6 +29,7 @@
 #include <thread>
 #include <unordered_map>
 #include <unordered_set>
+#include <vector>
 
 #include "FileBlobCache.h"
 
@@ -36,6 +37,7 @@ namespace android {
 
 constexpr uint32_t kMultifileBlobCacheVersion = 1;
 constexpr char kMultifileBlobCacheStatusFile[] = "cache.status";
+constexpr char kMultifileBlobCachePackFile[] = "cache.pack";
 
 struct MultifileHeader {
     uint32_t magic;
@@ -63,12 +65,50 @@ struct MultifileHotCache {
     size_t entrySize;
 };
 
+// The pack file holds a copy of the entries one after the other, so they can all be mapped at once.
+// It starts with a MultifilePackHeader, followed by entryCount MultifilePackEntry, followed by
+// the entries, laid out as in their own files.
+struct MultifilePackHeader {
+    uint32_t magic;
+    uint32_t crc;
+    uint64_t entryCount;
+};
+
+struct MultifilePackEntry {
+    uint32_t entryHash;
+    uint32_t entryCrc;
+    uint32_t entrySize;
+    uint32_t valueSize;
+    uint64_t offset;
+};
+
+struct MultifilePackedEntry {
+    const MultifilePackEntry* packEntry;
+    // Whether the CRC of the entry has been checked
+    bool verified;
+};
+
+// An entry of the read-only system cache, mapped the first time it is looked up
+struct MultifileSystemEntry {
+    uint8_t* entryBuffer;
+    size_t entrySize;
+};
+
 enum class TaskCommand {
     Invalid = 0,
     WriteToDisk,
+    WritePack,
     Exit,
 };
 
+// Where the worker thread finds an entry to put in the pack file, either in the current pack
+// or in its own file when buffer is null
+struct MultifilePackSource {
+    uint32_t entryHash;
+    const uint8_t* buffer;
+    size_t entrySize;
+};
+
 class DeferredTask {
 public:
     DeferredTask(TaskCommand command)
@@ -85,10 +125,17 @@ public:
         mBufferSize = bufferSize;
     }
 
+    void initWritePack(std::string fullPath, std::vector<MultifilePackSource> packSources) {
+        mCommand = TaskCommand::WritePack;
+        mFullPath = std::move(fullPath);
+        mPackSources = std::move(packSources);
+    }
+
     uint32_t getEntryHash() { return mEntryHash; }
     std::string& getFullPath() { return mFullPath; }
     uint8_t* getBuffer() { return mBuffer; }
     size_t getBufferSize() { return mBufferSize; };
+    std::vector<MultifilePackSource>& getPackSources() { return mPackSources; }
 
 private:
     TaskCommand mCommand;
@@ -98,6 +145,9 @@ private:
     std::string mFullPath;
     uint8_t* mBuffer;
     size_t mBufferSize;
+
+    // Parameters for WritePack
+    std::vector<MultifilePackSource> mPackSources;
 };
 
 class MultifileBlobCache {
@@ -145,6 +195,18 @@ private:
     void trimCache();
     bool applyLRU(size_t cacheSizeLimit, size_t cacheEntryLimit);
 
+    bool openPack(time_t* packTime);
+    void closePack();
+    uint8_t* getPackedEntry(uint32_t entryHash);
+    void queueWritePack();
+    void writePack(const std::string& packPath, const std::vector<MultifilePackSource>& sources);
+
+    void initSystemCache(const std::string& systemDirName);
+    EGLsizeiANDROID getFromSystemCache(uint32_t entryHash, const void* key,
+                                       EGLsizeiANDROID keySize, void* value,
+                                       EGLsizeiANDROID valueSize, bool* found);
+    void unmapSystemCache();
+
     bool mInitialized;
     std::string mMultifileDirName;
 
@@ -155,6 +217,19 @@ private:
     std::unordered_map<uint32_t, MultifileEntryStats> mEntryStats;
     std::unordered_map<uint32_t, MultifileHotCache> mHotCache;
 
+    // The pack file mapped at init, and the entries still read from it. Entries that are set
+    // again or removed are dropped from mPackedEntries, and the pack is written again by the
+    // worker thread once enough of the cache is outside of it.
+    uint8_t* mPackBuffer;
+    size_t mPackSize;
+    std::unordered_map<uint32_t, MultifilePackedEntry> mPackedEntries;
+    size_t mUnpackedSize;
+
+    // The read-only system cache is a multifile directory shared by all apps, which is looked up
+    // before the cache of the app. Its entries are never written, trimmed or removed.
+    std::string mSystemDirName;
+    std::unordered_map<uint32_t, MultifileSystemEntry> mSystemEntries;
+
     size_t mMaxKeySize;
     size_t mMaxValueSize;
     size_t mMaxTotalSize;
@@ -67,6 +67,9 @@ void MultifileBlobCacheTest::clearProperties() {
 
     base::SetProperty("debug.egl.blobcache.build_id", "");
     base::WaitForProperty("debug.egl.blobcache.build_id", "");
+
+    base::SetProperty("debug.egl.blobcache.system_dir", "");
+    base::WaitForProperty("debug.egl.blobcache.system_dir", "");
 }
 
 TEST_F(MultifileBlobCacheTest, CacheSingleValueSucceeds) {
@@ -325,6 +328,10 @@ std::vector<std::string> MultifileBlobCacheTest::getCacheEntries() {
                 if (strcmp(entry->d_name, kMultifileBlobCacheStatusFile) == 0) {
                     continue;
                 }
+                if (strncmp(entry->d_name, kMultifileBlobCachePackFile,
+                            strlen(kMultifileBlobCachePackFile)) == 0) {
+                    continue;
+                }
                 cacheEntries.push_back(multifileDirName + "/" + entry->d_name);
             }
         } else {
@@ -503,4 +510,151 @@ TEST_F(MultifileBlobCacheTest, MismatchedBuildIdClears) {
     ASSERT_EQ(getCacheEntries().size(), 0);
 }
 
+// Verify entries of the system cache are returned before the app's own
+TEST_F(MultifileBlobCacheTest, SystemCacheHitsBeforeAppCache) {
+    // Use the current cache as the system cache
+    mMBC->set("abcd", 4, "efgh", 4);
+    mMBC->finish();
+    mMBC.reset();
+
+    std::string systemDirName = &mTempFile->path[0] + ".multifile"s;
+    ASSERT_TRUE(base::SetProperty("debug.egl.blobcache.system_dir", systemDirName));
+    ASSERT_TRUE(base::WaitForProperty("debug.egl.blobcache.system_dir", systemDirName));
+
+    // Open a cache for another app
+    TemporaryFile appFile;
+    mMBC.reset(new MultifileBlobCache(kMaxKeySize, kMaxValueSize, kMaxTotalSize, kMaxTotalEntries,
+                                      &appFile.path[0]));
+
+    unsigned char buf[4] = {0xee, 0xee, 0xee, 0xee};
+    ASSERT_EQ(size_t(4), mMBC->get("abcd", 4, buf, 4));
+    ASSERT_EQ('e', buf[0]);
+    ASSERT_EQ('f', buf[1]);
+    ASSERT_EQ('g', buf[2]);
+    ASSERT_EQ('h', buf[3]);
+
+    // The app's own cache is still used for other entries
+    mMBC->set("ijkl", 4, "mnop", 4);
+    ASSERT_EQ(size_t(4), mMBC->get("ijkl", 4, buf, 4));
+    ASSERT_EQ('m', buf[0]);
+    ASSERT_EQ(mMBC->getTotalEntries(), 1);
+
+    // And the system cache is left alone
+    mMBC->finish();
+    mMBC.reset();
+    ASSERT_EQ(getCacheEntries().size(), 1);
+}
+
+// Verify a system cache created for another build is not used
+TEST_F(MultifileBlobCacheTest, MismatchedSystemCacheIgnored) {
+    // Use the current cache as the system cache
+    mMBC->set("abcd", 4, "efgh", 4);
+    mMBC->finish();
+    mMBC.reset();
+
+    std::string systemDirName = &mTempFile->path[0] + ".multifile"s;
+    ASSERT_TRUE(base::SetProperty("debug.egl.blobcache.system_dir", systemDirName));
+    ASSERT_TRUE(base::WaitForProperty("debug.egl.blobcache.system_dir", systemDirName));
+
+    // Set a debug buildId
+    base::SetProperty("debug.egl.blobcache.build_id", "foo");
+    base::WaitForProperty("debug.egl.blobcache.build_id", "foo");
+
+    // Open a cache for another app and ensure no cache hits
+    TemporaryFile appFile;
+    mMBC.reset(new MultifileBlobCache(kMaxKeySize, kMaxValueSize, kMaxTotalSize, kMaxTotalEntries,
+                                      &appFile.path[0]));
+
+    unsigned char buf[4] = {0xee, 0xee, 0xee, 0xee};
+    ASSERT_EQ(size_t(0), mMBC->get("abcd", 4, buf, 4));
+
+    // Ensure the system cache was not cleared
+    mMBC->finish();
+    mMBC.reset();
+    ASSERT_EQ(getCacheEntries().size(), 1);
+}
+
+// Verify entries are moved to the pack and still returned from there
+TEST_F(MultifileBlobCacheTest, EntriesMovedToPack) {
+    std::stringstream packFile;
+    packFile << &mTempFile->path[0] << ".multifile/" << kMultifileBlobCachePackFile;
+
+    for (int i = 0; i < kMaxTotalEntries / 2; i++) {
+        mMBC->set(&i, sizeof(i), &i, sizeof(i));
+    }
+
+    // Close the cache so everything writes out
+    mMBC->finish();
+    mMBC.reset();
+
+    // Open the cache again, which writes the pack
+    mMBC.reset(new MultifileBlobCache(kMaxKeySize, kMaxValueSize, kMaxTotalSize, kMaxTotalEntries,
+                                      &mTempFile->path[0]));
+    mMBC->finish();
+    mMBC.reset();
+
+    struct stat info;
+    ASSERT_TRUE(stat(packFile.str().c_str(), &info) == 0);
+    ASSERT_EQ(getCacheEntries().size(), kMaxTotalEntries / 2);
+
+    // Open the cache again, the entries should now only be in the pack
+    mMBC.reset(new MultifileBlobCache(kMaxKeySize, kMaxValueSize, kMaxTotalSize, kMaxTotalEntries,
+                                      &mTempFile->path[0]));
+    ASSERT_EQ(getCacheEntries().size(), 0);
+    ASSERT_EQ(mMBC->getTotalEntries(), kMaxTotalEntries / 2);
+
+    for (int i = 0; i < kMaxTotalEntries / 2; i++) {
+        int result = 0;
+        ASSERT_EQ(sizeof(i), mMBC->get(&i, sizeof(i), &result, sizeof(result)));
+        ASSERT_EQ(i, result);
+    }
+
+    // Setting an entry again takes precedence over the pack
+    int key = 0;
+    int value = 42;
+    mMBC->set(&key, sizeof(key), &value, sizeof(value));
+    mMBC->finish();
+    mMBC.reset();
+
+    mMBC.reset(new MultifileBlobCache(kMaxKeySize, kMaxValueSize, kMaxTotalSize, kMaxTotalEntries,
+                                      &mTempFile->path[0]));
+    int result = 0;
+    ASSERT_EQ(sizeof(value), mMBC->get(&key, sizeof(key), &result, sizeof(result)));
+    ASSERT_EQ(value, result);
+}
+
+// Verify a damaged pack is dropped without returning its entries
+TEST_F(MultifileBlobCacheTest, ModifiedPackClears) {
+    std::stringstream packFile;
+    packFile << &mTempFile->path[0] << ".multifile/" << kMultifileBlobCachePackFile;
+
+    mMBC->set("abcd", 4, "efgh", 4);
+    mMBC->finish();
+    mMBC.reset();
+
+    // Open the cache twice, to write the pack and then use it
+    for (int i = 0; i < 2; i++) {
+        mMBC.reset(new MultifileBlobCache(kMaxKeySize, kMaxValueSize, kMaxTotalSize,
+                                          kMaxTotalEntries, &mTempFile->path[0]));
+        mMBC->finish();
+        mMBC.reset();
+    }
+    ASSERT_EQ(getCacheEntries().size(), 0);
+
+    // Stomp on the END of the pack, modifying the entry
+    const char* stomp = "BADF00D";
+    std::fstream fs(packFile.str());
+    fs.seekp(-strlen(stomp), std::ios_base::end);
+    fs.write(stomp, strlen(stomp));
+    fs.flush();
+    fs.close();
+
+    // Open the cache again and ensure no cache hits
+    mMBC.reset(new MultifileBlobCache(kMaxKeySize, kMaxValueSize, kMaxTotalSize, kMaxTotalEntries,
+                                      &mTempFile->path[0]));
+    unsigned char buf[4] = {0xee, 0xee, 0xee, 0xee};
+    ASSERT_EQ(size_t(0), mMBC->get("abcd", 4, buf, 4));
+    ASSERT_EQ(mMBC->getTotalEntries(), 0);
+}
+
 } // namespace android
@@ -41,6 +41,7 @@
 #include "../egl_impl.h"
 #include "EGL/egl.h"
 #include "EGL/eglext.h"
+#include "EGL/Loader.h"
 #include "EGL/eglext_angle.h"
 #include "egl_display.h"
 #include "egl_layers.h"
@@ -984,6 +985,7 @@ EGLContext eglCreateContextImpl(EGLDisplay dpy, EGLConfig config, EGLContext sha
             if (version == egl_connection_t::GLESv1_INDEX) {
                 android::GraphicsEnv::getInstance().setTargetStats(
                         android::GpuStatsInfo::Stats::GLES_1_IN_USE);
+                Loader::getInstance().init_gles1_api(cnx);
             }
             if (!skip_telemetry) {
                 android::GraphicsEnv::getInstance().setTargetStats(
@@ -17,6 +17,7 @@
 #include "egl_tls.h"
 
 #include <android-base/properties.h>
+#include <bionic/tls.h>
 #include <log/log.h>
 #include <stdlib.h>
 
@@ -28,6 +29,14 @@ namespace android {
 pthread_key_t egl_tls_t::sKey = TLS_KEY_NOT_INITIALIZED;
 pthread_once_t egl_tls_t::sOnceKey = PTHREAD_ONCE_INIT;
 
+// The egl_tls_t of the thread is also kept in the bionic TLS slot reserved for EGL, so that
+// eglGetCurrentContext() and eglGetError() find it with a single load. The pthread key is only
+// there to have eglReleaseThread() called when the thread exits.
+static inline void* volatile* getTLSSlot() {
+    void* volatile* tls_base = reinterpret_cast<void* volatile*>(__get_tls());
+    return &tls_base[TLS_SLOT_OPENGL];
+}
+
 egl_tls_t::egl_tls_t() : error(EGL_SUCCESS), ctx(nullptr), logCallWithNoContext(true) {}
 
 const char* egl_tls_t::egl_strerror(EGLint err) {
@@ -96,6 +105,7 @@ void egl_tls_t::destructTLSData(void* data) {
     // call the destructor again, but eventually gives up and just leaks the data rather than
     // enter an infinite loop.
     pthread_setspecific(sKey, tls);
+    *getTLSSlot() = tls;
     eglReleaseThread();
     ALOGE_IF(pthread_getspecific(sKey) != nullptr,
              "EGL TLS data still exists after eglReleaseThread");
@@ -125,21 +135,22 @@ bool egl_tls_t::logNoContextCall() {
 }
 
 egl_tls_t* egl_tls_t::getTLS() {
-    egl_tls_t* tls = (egl_tls_t*)pthread_getspecific(sKey);
+    egl_tls_t* tls = static_cast<egl_tls_t*>(*getTLSSlot());
     if (tls == nullptr) {
+        validateTLSKey();
         tls = new egl_tls_t;
         pthread_setspecific(sKey, tls);
+        *getTLSSlot() = tls;
     }
     return tls;
 }
 
 void egl_tls_t::clearTLS() {
-    if (sKey != TLS_KEY_NOT_INITIALIZED) {
-        egl_tls_t* tls = (egl_tls_t*)pthread_getspecific(sKey);
-        if (tls) {
-            pthread_setspecific(sKey, nullptr);
-            delete tls;
-        }
+    egl_tls_t* tls = static_cast<egl_tls_t*>(*getTLSSlot());
+    if (tls) {
+        *getTLSSlot() = nullptr;
+        pthread_setspecific(sKey, nullptr);
+        delete tls;
     }
 }
 
@@ -150,10 +161,7 @@ void egl_tls_t::clearError() {
 }
 
 EGLint egl_tls_t::getError() {
-    if (sKey == TLS_KEY_NOT_INITIALIZED) {
-        return EGL_SUCCESS;
-    }
-    egl_tls_t* tls = (egl_tls_t*)pthread_getspecific(sKey);
+    egl_tls_t* tls = static_cast<egl_tls_t*>(*getTLSSlot());
     if (!tls) {
         return EGL_SUCCESS;
     }
@@ -168,10 +176,7 @@ void egl_tls_t::setContext(EGLContext ctx) {
 }
 
 EGLContext egl_tls_t::getContext() {
-    if (sKey == TLS_KEY_NOT_INITIALIZED) {
-        return EGL_NO_CONTEXT;
-    }
-    egl_tls_t* tls = (egl_tls_t*)pthread_getspecific(sKey);
+    egl_tls_t* tls = static_cast<egl_tls_t*>(*getTLSSlot());
     if (!tls) return EGL_NO_CONTEXT;
     return tls->ctx;
 }
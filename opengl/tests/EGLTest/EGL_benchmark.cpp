@@ -0,0 +1,126 @@
+/*
+ * Copyright (C) 2024 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <benchmark/benchmark.h>
+
+#include <EGL/egl.h>
+#include <GLES2/gl2.h>
+
+namespace android {
+namespace {
+
+// Makes a GLES 2 context on a 1x1 pbuffer current on the calling thread for the scope of a
+// benchmark, so that the GL entry points go through the hooks of the driver.
+class CurrentContext {
+public:
+    CurrentContext() {
+        mDisplay = eglGetDisplay(EGL_DEFAULT_DISPLAY);
+        if (!eglInitialize(mDisplay, nullptr, nullptr)) return;
+
+        const EGLint configAttribs[] = {EGL_SURFACE_TYPE, EGL_PBUFFER_BIT, EGL_RENDERABLE_TYPE,
+                                        EGL_OPENGL_ES2_BIT, EGL_NONE};
+        EGLConfig config;
+        EGLint numConfigs = 0;
+        if (!eglChooseConfig(mDisplay, configAttribs, &config, 1, &numConfigs) ||
+            numConfigs == 0) {
+            return;
+        }
+
+        const EGLint surfaceAttribs[] = {EGL_WIDTH, 1, EGL_HEIGHT, 1, EGL_NONE};
+        mSurface = eglCreatePbufferSurface(mDisplay, config, surfaceAttribs);
+        const EGLint contextAttribs[] = {EGL_CONTEXT_CLIENT_VERSION, 2, EGL_NONE};
+        mContext = eglCreateContext(mDisplay, config, EGL_NO_CONTEXT, contextAttribs);
+        mCurrent = mSurface != EGL_NO_SURFACE && mContext != EGL_NO_CONTEXT &&
+                eglMakeCurrent(mDisplay, mSurface, mSurface, mContext);
+    }
+
+    ~CurrentContext() {
+        if (mDisplay == EGL_NO_DISPLAY) return;
+        eglMakeCurrent(mDisplay, EGL_NO_SURFACE, EGL_NO_SURFACE, EGL_NO_CONTEXT);
+        if (mContext != EGL_NO_CONTEXT) eglDestroyContext(mDisplay, mContext);
+        if (mSurface != EGL_NO_SURFACE) eglDestroySurface(mDisplay, mSurface);
+        eglTerminate(mDisplay);
+    }
+
+    bool isCurrent() const { return mCurrent; }
+
+private:
+    EGLDisplay mDisplay = EGL_NO_DISPLAY;
+    EGLSurface mSurface = EGL_NO_SURFACE;
+    EGLContext mContext = EGL_NO_CONTEXT;
+    bool mCurrent = false;
+};
+
+void BM_eglGetCurrentContext(benchmark::State& state) {
+    CurrentContext context;
+    if (!context.isCurrent()) {
+        state.SkipWithError("Failed to make a context current");
+        return;
+    }
+    for (auto _ : state) {
+        benchmark::DoNotOptimize(eglGetCurrentContext());
+    }
+}
+BENCHMARK(BM_eglGetCurrentContext);
+
+void BM_eglGetCurrentContext_NoContext(benchmark::State& state) {
+    for (auto _ : state) {
+        benchmark::DoNotOptimize(eglGetCurrentContext());
+    }
+}
+BENCHMARK(BM_eglGetCurrentContext_NoContext);
+
+void BM_eglGetError(benchmark::State& state) {
+    CurrentContext context;
+    if (!context.isCurrent()) {
+        state.SkipWithError("Failed to make a context current");
+        return;
+    }
+    for (auto _ : state) {
+        benchmark::DoNotOptimize(eglGetError());
+    }
+}
+BENCHMARK(BM_eglGetError);
+
+// The cost of a GL call through the wrapper, with about as little as possible done by the driver.
+void BM_glGetError(benchmark::State& state) {
+    CurrentContext context;
+    if (!context.isCurrent()) {
+        state.SkipWithError("Failed to make a context current");
+        return;
+    }
+    for (auto _ : state) {
+        benchmark::DoNotOptimize(glGetError());
+    }
+}
+BENCHMARK(BM_glGetError);
+
+void BM_glGetIntegerv(benchmark::State& state) {
+    CurrentContext context;
+    if (!context.isCurrent()) {
+        state.SkipWithError("Failed to make a context current");
+        return;
+    }
+    GLint value = 0;
+    for (auto _ : state) {
+        glGetIntegerv(GL_ACTIVE_TEXTURE, &value);
+        benchmark::DoNotOptimize(value);
+    }
+}
+BENCHMARK(BM_glGetIntegerv);
+
+} // namespace
+} // namespace android
@@ -106,6 +106,20 @@ void GpuService::addVulkanEngineName(const std::string& appPackageName,
     mGpuStats->addVulkanEngineName(appPackageName, driverVersionCode, engineName);
 }
 
+void GpuService::setTargetStatsBatch(const std::string& appPackageName,
+                                     const uint64_t driverVersionCode,
+                                     const std::vector<GpuStatsInfo::TargetStats>& stats,
+                                     const std::vector<std::string>& engineNames) {
+    for (const auto& targetStats : stats) {
+        mGpuStats->insertTargetStatsArray(appPackageName, driverVersionCode, targetStats.stats,
+                                          targetStats.values.data(),
+                                          static_cast<uint32_t>(targetStats.values.size()));
+    }
+    for (const auto& engineName : engineNames) {
+        mGpuStats->addVulkanEngineName(appPackageName, driverVersionCode, engineName.c_str());
+    }
+}
+
 void GpuService::toggleAngleAsSystemDriver(bool enabled) {
     IPCThreadState* ipc = IPCThreadState::self();
     const int pid = ipc->getCallingPid();
@@ -149,6 +163,25 @@ std::string GpuService::getUpdatableDriverPath() {
     return mDeveloperDriverPath;
 }
 
+uint64_t GpuService::getGpuActiveDuration(uint32_t uid) {
+    IPCThreadState* ipc = IPCThreadState::self();
+    const int pid = ipc->getCallingPid();
+    const int callingUid = ipc->getCallingUid();
+
+    // only system services are allowed to follow the GPU work of apps
+    if (callingUid != AID_SYSTEM) {
+        ALOGE("Permission Denial: can't get GPU active duration from pid=%d, uid=%d\n", pid,
+              callingUid);
+        return 0;
+    }
+
+    uint64_t activeDurationNs = 0;
+    if (!mGpuWork->getActiveDuration(uid, &activeDurationNs)) {
+        return 0;
+    }
+    return activeDurationNs;
+}
+
 status_t GpuService::shellCommand(int /*in*/, int out, int err, std::vector<String16>& args) {
     ATRACE_CALL();
 
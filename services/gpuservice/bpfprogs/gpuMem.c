@@ -14,6 +14,8 @@
  * limitations under the License.
  */
 
+#include "include/gpumem/gpuMem.h"
+
 #include <bpf_helpers.h>
 
 /*
@@ -32,6 +34,14 @@
 DEFINE_BPF_MAP_GRO(gpu_mem_total_map, HASH, uint64_t, uint64_t, GPU_MEM_TOTAL_MAP_SIZE,
                    AID_GRAPHICS);
 
+/*
+ * Every change of the totals is also written to this ring buffer, so that
+ * gpuservice can follow them without traversing the map. Ring buffers need
+ * kernel 5.8, older kernels only get the map.
+ */
+DEFINE_BPF_RINGBUF(gpu_mem_event_ringbuf, GpuMemEvent, kGpuMemEventRingbufSize, AID_ROOT,
+                   AID_GRAPHICS, 0440);
+
 /* This struct aligns with the fields offsets of the raw tracepoint format */
 struct gpu_mem_total_args {
     uint64_t ignore;
@@ -42,14 +52,12 @@ struct gpu_mem_total_args {
 };
 
 /*
- * This program parses the gpu_mem/gpu_mem_total tracepoint's data into
- * {KEY, VAL} pair used to update the corresponding bpf map.
+ * Parses the gpu_mem/gpu_mem_total tracepoint's data into {KEY, VAL} pair
+ * used to update the corresponding bpf map.
  *
- * Pass AID_GRAPHICS as gid since gpuservice is in the graphics group.
  * Upon seeing size 0, the corresponding KEY needs to be cleaned up.
  */
-DEFINE_BPF_PROG("tracepoint/gpu_mem/gpu_mem_total", AID_ROOT, AID_GRAPHICS, tp_gpu_mem_total)
-(struct gpu_mem_total_args* args) {
+static inline __always_inline void update_gpu_mem_total(struct gpu_mem_total_args* args) {
     uint64_t key = 0;
     uint64_t cur_val = 0;
     uint64_t* prev_val = NULL;
@@ -60,7 +68,7 @@ DEFINE_BPF_PROG("tracepoint/gpu_mem/gpu_mem_total", AID_ROOT, AID_GRAPHICS, tp_g
 
     if (!cur_val) {
         bpf_gpu_mem_total_map_delete_elem(&key);
-        return 0;
+        return;
     }
 
     prev_val = bpf_gpu_mem_total_map_lookup_elem(&key);
@@ -69,6 +77,35 @@ DEFINE_BPF_PROG("tracepoint/gpu_mem/gpu_mem_total", AID_ROOT, AID_GRAPHICS, tp_g
     } else {
         bpf_gpu_mem_total_map_update_elem(&key, &cur_val, BPF_NOEXIST);
     }
+}
+
+/*
+ * Pass AID_GRAPHICS as gid since gpuservice is in the graphics group.
+ * Only one of the two programs below is loaded, depending on whether the
+ * kernel supports ring buffers.
+ */
+DEFINE_BPF_PROG_KVER_RANGE("tracepoint/gpu_mem/gpu_mem_total", AID_ROOT, AID_GRAPHICS,
+                           tp_gpu_mem_total, KVER_NONE, KVER(5, 8, 0))
+(struct gpu_mem_total_args* args) {
+    update_gpu_mem_total(args);
+    return 0;
+}
+
+DEFINE_BPF_PROG_KVER("tracepoint/gpu_mem/gpu_mem_total", AID_ROOT, AID_GRAPHICS,
+                     tp_gpu_mem_total_events, KVER(5, 8, 0))
+(struct gpu_mem_total_args* args) {
+    GpuMemEvent* event;
+
+    update_gpu_mem_total(args);
+
+    /* A full ring buffer drops the event, the map still has the total. */
+    event = bpf_gpu_mem_event_ringbuf_reserve();
+    if (!event) return 0;
+    event->timestamp_ns = bpf_ktime_get_ns();
+    event->gpu_id = args->gpu_id;
+    event->pid = args->pid;
+    event->size = args->size;
+    bpf_gpu_mem_event_ringbuf_submit(event);
     return 0;
 }
 
@@ -0,0 +1,45 @@
+/*
+ * Copyright 2024 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include <stdint.h>
+
+#ifdef __cplusplus
+namespace android {
+namespace gpumem {
+#endif
+
+// A change of the global or per process gpu memory total, as reported by the
+// gpu_mem/gpu_mem_total tracepoint.
+typedef struct {
+    // CLOCK_MONOTONIC time of the change, in nanoseconds.
+    uint64_t timestamp_ns;
+    uint32_t gpu_id;
+    // 0 for the global total of the gpu.
+    uint32_t pid;
+    // The new total in bytes, 0 once the process freed all its gpu memory.
+    uint64_t size;
+} GpuMemEvent;
+
+// The size of the ring buffer of |GpuMemEvent|s. Must be a power of 2 multiple
+// of the page size.
+static const uint32_t kGpuMemEventRingbufSize = 64 * 1024;
+
+#ifdef __cplusplus
+} // namespace gpumem
+} // namespace android
+#endif
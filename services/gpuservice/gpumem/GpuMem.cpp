@@ -75,6 +75,15 @@ void GpuMem::initialize() {
     }
     setGpuMemTotalMap(map);
 
+    // The ring buffer is only there on kernels that support it, the map is enough otherwise.
+    auto ringbuf = bpf::BpfRingbuf<gpumem::GpuMemEvent>::Create(kGpuMemEventRingbufPath);
+    if (ringbuf.ok()) {
+        mGpuMemEventRingbuf = std::move(ringbuf.value());
+    } else {
+        ALOGI("No gpu memory events from %s: %s", kGpuMemEventRingbufPath,
+              ringbuf.error().message().c_str());
+    }
+
     mInitialized.store(true);
 }
 
@@ -155,4 +164,16 @@ void GpuMem::traverseGpuMemTotals(const std::function<void(int64_t ts, uint32_t
     }
 }
 
+int GpuMem::consumeGpuMemEvents(
+        const std::function<void(const gpumem::GpuMemEvent&)>& callback) {
+    if (!mGpuMemEventRingbuf) return -1;
+
+    auto res = mGpuMemEventRingbuf->ConsumeAll(callback);
+    if (!res.ok()) {
+        ALOGE("Failed to consume gpu memory events: %s", res.error().message().c_str());
+        return -1;
+    }
+    return res.value();
+}
+
 } // namespace android
@@ -17,10 +17,13 @@
 #pragma once
 
 #include <bpf/BpfMap.h>
+#include <bpf/BpfRingbuf.h>
+#include <gpumem/gpuMem.h>
 #include <utils/String16.h>
 #include <utils/Vector.h>
 
 #include <functional>
+#include <memory>
 
 namespace android {
 
@@ -40,6 +43,13 @@ public:
     void traverseGpuMemTotals(const std::function<void(int64_t ts, uint32_t gpuId, uint32_t pid,
                                                        uint64_t size)>& callback);
 
+    // Whether the changes of the gpu memory totals can be followed with
+    // consumeGpuMemEvents(), which needs kernel support for bpf ring buffers.
+    bool hasGpuMemEvents() { return mGpuMemEventRingbuf != nullptr; }
+    // Feeds the callback with the changes of the gpu memory totals since the last call, in the
+    // order they happened. Returns the number of changes, or -1 on failure.
+    int consumeGpuMemEvents(const std::function<void(const gpumem::GpuMemEvent&)>& callback);
+
 private:
     // Friend class for testing.
     friend class TestableGpuMem;
@@ -56,6 +66,9 @@ private:
     // bpf map for GPU memory total data
     android::bpf::BpfMapRO<uint64_t, uint64_t> mGpuMemTotalMap;
 
+    // bpf ring buffer of the GPU memory total changes, null if not supported
+    std::unique_ptr<android::bpf::BpfRingbuf<gpumem::GpuMemEvent>> mGpuMemEventRingbuf;
+
     // gpu memory tracepoint event category
     static constexpr char kGpuMemTraceGroup[] = "gpu_mem";
     // gpu memory total tracepoint
@@ -65,6 +78,9 @@ private:
             "/sys/fs/bpf/prog_gpuMem_tracepoint_gpu_mem_gpu_mem_total";
     // pinned gpu memory total bpf map path in bpf sysfs
     static constexpr char kGpuMemTotalMapPath[] = "/sys/fs/bpf/map_gpuMem_gpu_mem_total_map";
+    // pinned gpu memory event ring buffer path in bpf sysfs
+    static constexpr char kGpuMemEventRingbufPath[] =
+            "/sys/fs/bpf/map_gpuMem_gpu_mem_event_ringbuf";
     // 30 seconds timeout for trying to attach bpf program to tracepoint
     static constexpr int kGpuWaitTimeout = 30;
 };
@@ -94,17 +94,23 @@ inline int32_t bitcast_int32<uint32_t>(uint32_t source) {
 using base::StringAppendF;
 
 GpuWork::~GpuWork() {
-    // If we created our clearer thread, then we must stop it and join it.
-    if (mMapClearerThread.joinable()) {
-        // Tell the thread to terminate.
+    // If we created our clearer or period reader threads, then we must stop
+    // them and join them.
+    if (mMapClearerThread.joinable() || mPeriodReaderThread.joinable()) {
+        // Tell the threads to terminate.
         {
             std::scoped_lock<std::mutex> lock(mMutex);
             mIsTerminating = true;
             mIsTerminatingConditionVariable.notify_all();
         }
 
-        // Now, we can join it.
-        mMapClearerThread.join();
+        // Now, we can join them.
+        if (mMapClearerThread.joinable()) {
+            mMapClearerThread.join();
+        }
+        if (mPeriodReaderThread.joinable()) {
+            mPeriodReaderThread.join();
+        }
     }
 
     {
@@ -153,6 +159,18 @@ void GpuWork::initialize() {
 
     mMapClearerThread.swap(thread);
 
+    // GPU work periods are only streamed on kernels that support BPF ring
+    // buffers.
+    auto ringbuf = bpf::BpfRingbuf<GpuWorkPeriod>::Create(
+            "/sys/fs/bpf/map_gpuWork_gpu_work_period_ringbuf");
+    if (ringbuf.ok()) {
+        mGpuWorkPeriodRingbuf = std::move(ringbuf.value());
+        std::thread readerThread([this]() { readPeriods(); });
+        mPeriodReaderThread.swap(readerThread);
+    } else {
+        ALOGI("GPU work periods will not be streamed: %s", ringbuf.error().message().c_str());
+    }
+
     {
         std::lock_guard<std::mutex> lock(mMutex);
         AStatsManager_setPullAtomCallback(int32_t{android::util::GPU_WORK_PER_UID}, nullptr,
@@ -460,6 +478,55 @@ void GpuWork::periodicallyClearMap() {
     }
 }
 
+void GpuWork::readPeriods() {
+    std::unique_lock<std::mutex> lock(mMutex);
+
+    while (!mIsTerminating) {
+        mIsTerminatingConditionVariable.wait_for(lock,
+                                                 std::chrono::milliseconds{
+                                                         kPeriodReaderIntervalMilliseconds});
+        lock.unlock();
+        {
+            std::lock_guard<std::mutex> listenerLock(mListenerMutex);
+            auto result = mGpuWorkPeriodRingbuf->ConsumeAll([this](const GpuWorkPeriod& period) {
+                mActiveDurationsNs[period.uid] += period.active_duration_ns;
+                for (const auto& [id, listener] : mPeriodListeners) {
+                    listener(period);
+                }
+            });
+            if (!result.ok()) {
+                ALOGW("Failed to read GPU work periods: %s", result.error().message().c_str());
+            }
+        }
+        lock.lock();
+    }
+}
+
+int32_t GpuWork::addPeriodListener(PeriodListener listener) {
+    if (!mInitialized.load() || !mGpuWorkPeriodRingbuf) {
+        return 0;
+    }
+    std::lock_guard<std::mutex> lock(mListenerMutex);
+    const int32_t id = mNextPeriodListenerId++;
+    mPeriodListeners.emplace(id, std::move(listener));
+    return id;
+}
+
+void GpuWork::removePeriodListener(int32_t id) {
+    std::lock_guard<std::mutex> lock(mListenerMutex);
+    mPeriodListeners.erase(id);
+}
+
+bool GpuWork::getActiveDuration(Uid uid, uint64_t* activeDurationNs) {
+    if (!mInitialized.load() || !mGpuWorkPeriodRingbuf) {
+        return false;
+    }
+    std::lock_guard<std::mutex> lock(mListenerMutex);
+    auto it = mActiveDurationsNs.find(uid);
+    *activeDurationNs = it != mActiveDurationsNs.end() ? it->second : 0;
+    return true;
+}
+
 void GpuWork::clearMapIfNeeded() {
     if (!mInitialized.load() || !mGpuWorkMap.isValid() || !mGpuWorkGlobalDataMap.isValid()) {
         ALOGW("Map clearing could not occur because we are not initialized properly");
@@ -17,6 +17,7 @@
 #include "include/gpuwork/gpuWork.h"
 
 #include <linux/bpf.h>
+#include <stdbool.h>
 #include <stddef.h>
 #include <stdint.h>
 
@@ -36,6 +37,11 @@ DEFINE_BPF_MAP_GRW(gpu_work_map, HASH, GpuIdUid, UidTrackingInfo, kMaxTrackedGpu
 // A map containing a single entry of |GlobalData|.
 DEFINE_BPF_MAP_GRW(gpu_work_global_data, ARRAY, uint32_t, GlobalData, 1, AID_GRAPHICS);
 
+// The GPU work periods that |gpu_work_map| was updated with, for |GpuWork| to
+// stream to its listeners.
+DEFINE_BPF_RINGBUF(gpu_work_period_ringbuf, GpuWorkPeriod, kGpuWorkPeriodRingbufSize, AID_ROOT,
+                   AID_GRAPHICS, 0440);
+
 // Defines the structure of the kernel tracepoint:
 //
 //  /sys/kernel/tracing/events/power/gpu_work_period/
@@ -178,14 +184,12 @@ _Static_assert(offsetof(GpuWorkPeriodEvent, gpu_id) == 8 &&
                "must match the tracepoint field offsets found via adb shell cat "
                "/sys/kernel/tracing/events/power/gpu_work_period/format");
 
-DEFINE_BPF_PROG("tracepoint/power/gpu_work_period", AID_ROOT, AID_GRAPHICS, tp_gpu_work_period)
-(GpuWorkPeriodEvent* const period) {
-    // Note: In eBPF programs, |__sync_fetch_and_add| is translated to an atomic
-    // add.
-
-    // Return 1 to avoid blocking simpleperf from receiving events.
-    const int ALLOW = 1;
-
+// Updates the |UidTrackingInfo| of the period's |uid|. Returns whether the
+// period added GPU work to it.
+//
+// Note: In eBPF programs, |__sync_fetch_and_add| is translated to an atomic
+// add.
+static inline __always_inline bool track_period(GpuWorkPeriodEvent* const period) {
     GpuIdUid gpu_id_and_uid;
     __builtin_memset(&gpu_id_and_uid, 0, sizeof(gpu_id_and_uid));
     gpu_id_and_uid.gpu_id = period->gpu_id;
@@ -213,7 +217,7 @@ DEFINE_BPF_PROG("tracepoint/power/gpu_work_period", AID_ROOT, AID_GRAPHICS, tp_g
         if (!uid_tracking_info) {
             // This should never happen, unless entries are getting deleted at
             // this moment. If so, we just give up.
-            return ALLOW;
+            return false;
         }
     }
 
@@ -223,13 +227,13 @@ DEFINE_BPF_PROG("tracepoint/power/gpu_work_period", AID_ROOT, AID_GRAPHICS, tp_g
             // The period duration must be at most 1 second.
             (period->end_time_ns - period->start_time_ns) > S_IN_NS) {
         __sync_fetch_and_add(&uid_tracking_info->error_count, 1);
-        return ALLOW;
+        return false;
     }
 
     // If |total_active_duration_ns| is 0 then no GPU work occurred and there is
     // nothing to do.
     if (period->total_active_duration_ns == 0) {
-        return ALLOW;
+        return false;
     }
 
     // Update |uid_tracking_info->total_active_duration_ns|.
@@ -282,6 +286,40 @@ DEFINE_BPF_PROG("tracepoint/power/gpu_work_period", AID_ROOT, AID_GRAPHICS, tp_g
                              small_gap_time_ns + period_total_inactive_time_ns);
     }
 
+    return true;
+}
+
+
+// Return 1 to avoid blocking simpleperf from receiving events.
+#define ALLOW 1
+
+// Only one of the two programs below is loaded, depending on whether the
+// kernel supports ring buffers (5.8+).
+DEFINE_BPF_PROG_KVER_RANGE("tracepoint/power/gpu_work_period", AID_ROOT, AID_GRAPHICS,
+                           tp_gpu_work_period, KVER_NONE, KVER(5, 8, 0))
+(GpuWorkPeriodEvent* const period) {
+    track_period(period);
+    return ALLOW;
+}
+
+DEFINE_BPF_PROG_KVER("tracepoint/power/gpu_work_period", AID_ROOT, AID_GRAPHICS,
+                     tp_gpu_work_period_stream, KVER(5, 8, 0))
+(GpuWorkPeriodEvent* const period) {
+    if (!track_period(period)) {
+        return ALLOW;
+    }
+
+    // If |GpuWork| does not keep up, the period is dropped from the stream; it
+    // was still counted in |gpu_work_map|.
+    GpuWorkPeriod* streamed = bpf_gpu_work_period_ringbuf_reserve();
+    if (!streamed) {
+        return ALLOW;
+    }
+    streamed->gpu_id = period->gpu_id;
+    streamed->uid = period->uid;
+    streamed->end_time_ns = period->end_time_ns;
+    streamed->active_duration_ns = period->total_active_duration_ns;
+    bpf_gpu_work_period_ringbuf_submit(streamed);
     return ALLOW;
 }
 
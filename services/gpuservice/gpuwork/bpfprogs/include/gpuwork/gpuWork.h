@@ -63,6 +63,24 @@ typedef struct {
 // The maximum number of tracked GPU ID and UID pairs (|GpuIdUid|).
 static const uint32_t kMaxTrackedGpuIdUids = 512;
 
+// A GPU work period of a UID, streamed to userspace as soon as the driver has
+// reported it.
+typedef struct {
+    uint32_t gpu_id;
+    uint32_t uid;
+
+    // The end time of the period in nanoseconds, in CLOCK_MONOTONIC_RAW.
+    uint64_t end_time_ns;
+
+    // The amount of time the GPU was running work for |uid| during the period,
+    // in nanoseconds.
+    uint64_t active_duration_ns;
+} GpuWorkPeriod;
+
+// The size of the ring buffer of |GpuWorkPeriod|s. Must be a power of 2
+// multiple of the page size.
+static const uint32_t kGpuWorkPeriodRingbufSize = 256 * 1024;
+
 #ifdef __cplusplus
 } // namespace gpuwork
 } // namespace android
@@ -17,6 +17,7 @@
 #pragma once
 
 #include <bpf/BpfMap.h>
+#include <bpf/BpfRingbuf.h>
 #include <stats_pull_atom_callback.h>
 #include <utils/Mutex.h>
 #include <utils/String16.h>
@@ -25,7 +26,10 @@
 #include <condition_variable>
 #include <cstdint>
 #include <functional>
+#include <map>
+#include <memory>
 #include <thread>
+#include <unordered_map>
 
 #include "gpuwork/gpuWork.h"
 
@@ -45,6 +49,21 @@ public:
     // Dumps the GPU work information.
     void dump(const Vector<String16>& args, std::string* result);
 
+    using PeriodListener = std::function<void(const GpuWorkPeriod&)>;
+
+    // Adds a listener that gets the GPU work periods of all UIDs, on the period
+    // reader thread, at most ~|kPeriodReaderIntervalMilliseconds| after the
+    // driver reported them. The listener must not add or remove listeners.
+    // Returns an ID for |removePeriodListener|, or 0 if GPU work periods cannot
+    // be streamed, which needs kernel support for BPF ring buffers.
+    int32_t addPeriodListener(PeriodListener listener);
+    void removePeriodListener(int32_t id);
+
+    // Gets the total GPU active time of |uid| on all GPUs since GPU work
+    // periods started to be streamed, in nanoseconds. Returns false if they
+    // cannot be streamed.
+    bool getActiveDuration(Uid uid, uint64_t* activeDurationNs);
+
 private:
     // Attaches tracepoint |tracepoint_group|/|tracepoint_name| to BPF program at path
     // |program_path|. The tracepoint is also enabled.
@@ -73,6 +92,10 @@ private:
     // Clears the |mGpuWorkMap| map.
     void clearMap() REQUIRES(mMutex);
 
+    // Periodically streams the GPU work periods from |mGpuWorkPeriodRingbuf|
+    // to the listeners, until we are being destructed.
+    void readPeriods() NO_THREAD_SAFETY_ANALYSIS;
+
     // Waits for required permissions to become set. This seems to be needed
     // because platform service permissions might not be set when a service
     // first starts. See b/214085769.
@@ -97,8 +120,25 @@ private:
     // BPF map containing a single element for global data.
     bpf::BpfMap<uint32_t, GlobalData> mGpuWorkGlobalDataMap GUARDED_BY(mMutex);
 
+    // BPF ring buffer of GPU work periods; null if not supported.
+    std::unique_ptr<bpf::BpfRingbuf<GpuWorkPeriod>> mGpuWorkPeriodRingbuf;
+
+    // A thread that streams the GPU work periods to the listeners.
+    std::thread mPeriodReaderThread;
+
+    // Mutex for the listeners and the streamed active durations. Never taken
+    // before |mMutex|.
+    std::mutex mListenerMutex;
+
+    std::map<int32_t, PeriodListener> mPeriodListeners GUARDED_BY(mListenerMutex);
+
+    int32_t mNextPeriodListenerId GUARDED_BY(mListenerMutex) = 1;
+
+    // The total GPU active time of each UID, from the streamed periods.
+    std::unordered_map<Uid, uint64_t> mActiveDurationsNs GUARDED_BY(mListenerMutex);
+
     // When true, we are being destructed, so |mMapClearerThread| should stop.
-    bool mIsTerminating GUARDED_BY(mMutex);
+    bool mIsTerminating GUARDED_BY(mMutex) = false;
 
     // A condition variable for |mIsTerminating|.
     std::condition_variable mIsTerminatingConditionVariable GUARDED_BY(mMutex);
@@ -110,6 +150,9 @@ private:
     // every ~1 hour.
     static constexpr uint32_t kMapClearerWaitDurationSeconds = 60 * 60;
 
+    // How often the period reader thread streams the GPU work periods.
+    static constexpr uint32_t kPeriodReaderIntervalMilliseconds = 20;
+
     // Whether our |pullAtomCallback| function is registered.
     bool mStatsdRegistered GUARDED_BY(mMutex) = false;
 
@@ -64,8 +64,12 @@ private:
     void setUpdatableDriverPath(const std::string& driverPath) override;
     std::string getUpdatableDriverPath() override;
     void toggleAngleAsSystemDriver(bool enabled) override;
+    uint64_t getGpuActiveDuration(uint32_t uid) override;
     void addVulkanEngineName(const std::string& appPackageName, const uint64_t driverVersionCode,
                              const char *engineName) override;
+    void setTargetStatsBatch(const std::string& appPackageName, const uint64_t driverVersionCode,
+                             const std::vector<GpuStatsInfo::TargetStats>& stats,
+                             const std::vector<std::string>& engineNames) override;
 
     /*
      * IBinder interface
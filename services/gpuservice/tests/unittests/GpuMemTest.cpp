@@ -92,6 +92,13 @@ TEST_F(GpuMemTest, validGpuMemTotalBpfPaths) {
     EXPECT_EQ(mTestableGpuMem.getGpuMemTotalMapPath(), "/sys/fs/bpf/map_gpuMem_gpu_mem_total_map");
 }
 
+TEST_F(GpuMemTest, noGpuMemEventsWithoutRingbuf) {
+    EXPECT_EQ(mTestableGpuMem.getGpuMemEventRingbufPath(),
+              "/sys/fs/bpf/map_gpuMem_gpu_mem_event_ringbuf");
+    EXPECT_FALSE(mGpuMem->hasGpuMemEvents());
+    EXPECT_EQ(mGpuMem->consumeGpuMemEvents([](const gpumem::GpuMemEvent&) {}), -1);
+}
+
 TEST_F(GpuMemTest, bpfInitializationFailed) {
     EXPECT_EQ(dumpsys(), "Failed to initialize GPU memory eBPF\n");
 }
@@ -40,6 +40,8 @@ public:
 
     std::string getGpuMemTotalMapPath() { return mGpuMem->kGpuMemTotalMapPath; }
 
+    std::string getGpuMemEventRingbufPath() { return mGpuMem->kGpuMemEventRingbufPath; }
+
 private:
     GpuMem *mGpuMem;
 };
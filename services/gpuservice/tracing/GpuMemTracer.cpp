@@ -33,6 +33,7 @@ namespace android {
 std::mutex GpuMemTracer::sTraceMutex;
 std::condition_variable GpuMemTracer::sCondition;
 bool GpuMemTracer::sTraceStarted;
+bool GpuMemTracer::sTraceStopped;
 
 void GpuMemTracer::initialize(std::shared_ptr<GpuMem> gpuMem) {
     if (!gpuMem->isInitialized()) {
@@ -89,7 +90,14 @@ void GpuMemTracer::threadLoop(bool infiniteLoop) {
                 sCondition.wait(lock);
             }
         }
+        if (mGpuMem->hasGpuMemEvents()) {
+            // Changes from before the session are part of the initial counters.
+            mGpuMem->consumeGpuMemEvents([](const gpumem::GpuMemEvent&) {});
+        }
         traceInitialCounters();
+        if (mGpuMem->hasGpuMemEvents()) {
+            traceCounterChanges();
+        }
         {
             std::lock_guard<std::mutex> lock(GpuMemTracer::sTraceMutex);
             sTraceStarted = false;
@@ -123,4 +131,29 @@ void GpuMemTracer::traceInitialCounters() {
     GpuMemDataSource::Trace([](GpuMemDataSource::TraceContext ctx) { ctx.Flush(); });
 }
 
+void GpuMemTracer::traceCounterChanges() {
+    std::unique_lock<std::mutex> lock(GpuMemTracer::sTraceMutex);
+    while (!sTraceStopped) {
+        sCondition.wait_for(lock, kGpuMemEventPollInterval, [] { return sTraceStopped; });
+        lock.unlock();
+        const int count = mGpuMem->consumeGpuMemEvents([](const gpumem::GpuMemEvent& event) {
+            GpuMemDataSource::Trace([&](GpuMemDataSource::TraceContext ctx) {
+                auto packet = ctx.NewTracePacket();
+                packet->set_timestamp_clock_id(
+                        perfetto::protos::pbzero::BUILTIN_CLOCK_MONOTONIC);
+                packet->set_timestamp(event.timestamp_ns);
+                auto* totalEvent = packet->set_gpu_mem_total_event();
+                totalEvent->set_gpu_id(event.gpu_id);
+                totalEvent->set_pid(event.pid);
+                totalEvent->set_size(event.size);
+            });
+        });
+        if (count > 0) {
+            GpuMemDataSource::Trace([](GpuMemDataSource::TraceContext ctx) { ctx.Flush(); });
+        }
+        lock.lock();
+        if (count < 0) break;
+    }
+}
+
 } // namespace android
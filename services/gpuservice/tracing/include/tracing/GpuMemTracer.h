@@ -18,6 +18,7 @@
 
 #include <perfetto/tracing.h>
 
+#include <chrono>
 #include <mutex>
 
 namespace perfetto::protos {
@@ -35,9 +36,14 @@ public:
         virtual void OnStart(const StartArgs&) override {
             std::unique_lock<std::mutex> lock(GpuMemTracer::sTraceMutex);
             sTraceStarted = true;
+            sTraceStopped = false;
+            sCondition.notify_all();
+        }
+        virtual void OnStop(const StopArgs&) override {
+            std::unique_lock<std::mutex> lock(GpuMemTracer::sTraceMutex);
+            sTraceStopped = true;
             sCondition.notify_all();
         }
-        virtual void OnStop(const StopArgs&) override{};
     };
 
     ~GpuMemTracer() = default;
@@ -70,6 +76,7 @@ public:
     static std::condition_variable sCondition;
     static std::mutex sTraceMutex;
     static bool sTraceStarted;
+    static bool sTraceStopped;
 
 private:
     // Friend class for testing
@@ -77,9 +84,14 @@ private:
 
     void threadLoop(bool infiniteLoop);
     void traceInitialCounters();
+    // Trace the changes of the counters until the tracing session stops.
+    void traceCounterChanges();
     std::shared_ptr<GpuMem> mGpuMem;
     // Count of how many tracer threads are currently active. Useful for testing.
     std::atomic<int32_t> tracerThreadCount = 0;
+
+    // How often the changes of the counters are read while tracing.
+    static constexpr std::chrono::milliseconds kGpuMemEventPollInterval{10};
 };
 
 } // namespace android
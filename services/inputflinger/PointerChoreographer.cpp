@@ -226,10 +226,10 @@ NotifyMotionArgs PointerChoreographer::processMouseEventLocked(const NotifyMotio
                    << args.dump();
     }
 
-    mMouseDevices.emplace(args.deviceId);
-    auto [displayId, pc] = ensureMouseControllerLocked(args.displayId);
+    const MouseDisplayState& state = resolveMouseDisplayStateLocked(args);
+    PointerControllerInterface& pc = *state.controller;
     NotifyMotionArgs newArgs(args);
-    newArgs.displayId = displayId;
+    newArgs.displayId = state.displayId;
 
     if (MotionEvent::isValidCursorPosition(args.xCursorPosition, args.yCursorPosition)) {
         // This is an absolute mouse device that knows about the location of the cursor on the
@@ -251,24 +251,24 @@ NotifyMotionArgs PointerChoreographer::processMouseEventLocked(const NotifyMotio
         newArgs.xCursorPosition = x;
         newArgs.yCursorPosition = y;
     }
-    if (canUnfadeOnDisplay(displayId)) {
+    if (state.canUnfade) {
         pc.unfade(PointerControllerInterface::Transition::IMMEDIATE);
     }
     return newArgs;
 }
 
 NotifyMotionArgs PointerChoreographer::processTouchpadEventLocked(const NotifyMotionArgs& args) {
-    mMouseDevices.emplace(args.deviceId);
-    auto [displayId, pc] = ensureMouseControllerLocked(args.displayId);
+    const MouseDisplayState& state = resolveMouseDisplayStateLocked(args);
+    PointerControllerInterface& pc = *state.controller;
 
     NotifyMotionArgs newArgs(args);
-    newArgs.displayId = displayId;
+    newArgs.displayId = state.displayId;
     if (args.getPointerCount() == 1 && args.classification == MotionClassification::NONE) {
         // This is a movement of the mouse pointer.
         const float deltaX = args.pointerCoords[0].getAxisValue(AMOTION_EVENT_AXIS_RELATIVE_X);
         const float deltaY = args.pointerCoords[0].getAxisValue(AMOTION_EVENT_AXIS_RELATIVE_Y);
         pc.move(deltaX, deltaY);
-        if (canUnfadeOnDisplay(displayId)) {
+        if (state.canUnfade) {
             pc.unfade(PointerControllerInterface::Transition::IMMEDIATE);
         }
 
@@ -279,7 +279,7 @@ NotifyMotionArgs PointerChoreographer::processTouchpadEventLocked(const NotifyMo
         newArgs.yCursorPosition = y;
     } else {
         // This is a trackpad gesture with fake finger(s) that should not move the mouse pointer.
-        if (canUnfadeOnDisplay(displayId)) {
+        if (state.canUnfade) {
             pc.unfade(PointerControllerInterface::Transition::IMMEDIATE);
         }
 
@@ -441,6 +441,7 @@ void PointerChoreographer::processDeviceReset(const NotifyDeviceResetArgs& args)
 }
 
 void PointerChoreographer::onControllerAddedOrRemovedLocked() {
+    mMouseDisplayState.reset();
     if (!com::android::input::flags::hide_pointer_indicators_for_secure_windows()) {
         return;
     }
@@ -579,6 +580,22 @@ bool PointerChoreographer::canUnfadeOnDisplay(ui::LogicalDisplayId displayId) {
     return mDisplaysWithPointersHidden.find(displayId) == mDisplaysWithPointersHidden.end();
 }
 
+const PointerChoreographer::MouseDisplayState&
+PointerChoreographer::resolveMouseDisplayStateLocked(const NotifyMotionArgs& args) {
+    if (mMouseDisplayState && mMouseDisplayState->deviceId == args.deviceId &&
+        mMouseDisplayState->associatedDisplayId == args.displayId) {
+        return *mMouseDisplayState;
+    }
+    mMouseDevices.emplace(args.deviceId);
+    auto [displayId, pc] = ensureMouseControllerLocked(args.displayId);
+    mMouseDisplayState = MouseDisplayState{.deviceId = args.deviceId,
+                                           .associatedDisplayId = args.displayId,
+                                           .displayId = displayId,
+                                           .controller = &pc,
+                                           .canUnfade = canUnfadeOnDisplay(displayId)};
+    return *mMouseDisplayState;
+}
+
 PointerChoreographer::PointerDisplayChange PointerChoreographer::updatePointerControllersLocked() {
     std::set<ui::LogicalDisplayId /*displayId*/> mouseDisplaysToKeep;
     std::set<DeviceId> touchDevicesToKeep;
@@ -822,6 +839,7 @@ bool PointerChoreographer::setPointerIcon(
 
 void PointerChoreographer::setPointerIconVisibility(ui::LogicalDisplayId displayId, bool visible) {
     std::scoped_lock lock(mLock);
+    mMouseDisplayState.reset();
     if (visible) {
         mDisplaysWithPointersHidden.erase(displayId);
         // We do not unfade the icons here, because we don't know when the last event happened.
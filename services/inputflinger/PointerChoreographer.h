@@ -129,6 +129,17 @@ private:
     InputDeviceInfo* findInputDeviceLocked(DeviceId deviceId) REQUIRES(mLock);
     bool canUnfadeOnDisplay(ui::LogicalDisplayId displayId) REQUIRES(mLock);
 
+    // The display state resolved for the mouse or touchpad events of a device.
+    struct MouseDisplayState {
+        DeviceId deviceId;
+        ui::LogicalDisplayId associatedDisplayId;
+        ui::LogicalDisplayId displayId;
+        PointerControllerInterface* controller;
+        bool canUnfade;
+    };
+    const MouseDisplayState& resolveMouseDisplayStateLocked(const NotifyMotionArgs& args)
+            REQUIRES(mLock);
+
     void fadeMouseCursorOnKeyPress(const NotifyKeyArgs& args);
     NotifyMotionArgs processMotion(const NotifyMotionArgs& args);
     NotifyMotionArgs processMouseEventLocked(const NotifyMotionArgs& args) REQUIRES(mLock);
@@ -198,6 +209,11 @@ private:
     bool mShowTouchesEnabled GUARDED_BY(mLock);
     bool mStylusPointerIconEnabled GUARDED_BY(mLock);
     std::set<ui::LogicalDisplayId /*displayId*/> mDisplaysWithPointersHidden;
+    // The state resolved for the latest mouse or touchpad event. A high polling rate mouse sends
+    // thousands of events per second, so the display, the controller and the pointer visibility
+    // are only looked up again when the device or its display changes. It is cleared whenever
+    // pointer controllers are added or removed, or the pointer visibility of a display changes.
+    std::optional<MouseDisplayState> mMouseDisplayState GUARDED_BY(mLock);
     ui::LogicalDisplayId mCurrentFocusedDisplay GUARDED_BY(mLock);
 
 protected:
@@ -484,6 +484,11 @@ void UnwantedInteractionBlocker::monitor() {
 
 UnwantedInteractionBlocker::~UnwantedInteractionBlocker() {}
 
+SlotState::SlotState() {
+    mSlotsByPointerId.fill(NO_VALUE);
+    mPointerIdsBySlot.fill(NO_VALUE);
+}
+
 void SlotState::update(const NotifyMotionArgs& args) {
     for (size_t i = 0; i < args.getPointerCount(); i++) {
         const int32_t pointerId = args.pointerProperties[i].id;
@@ -493,18 +498,15 @@ void SlotState::update(const NotifyMotionArgs& args) {
 }
 
 size_t SlotState::findUnusedSlot() const {
-    size_t unusedSlot = 0;
-    // Since the collection is ordered, we can rely on the in-order traversal
-    for (const auto& [slot, trackingId] : mPointerIdsBySlot) {
-        if (unusedSlot != slot) {
-            break;
-        }
-        unusedSlot++;
-    }
-    return unusedSlot;
+    const auto it = std::find(mPointerIdsBySlot.begin(), mPointerIdsBySlot.end(), NO_VALUE);
+    LOG_ALWAYS_FATAL_IF(it == mPointerIdsBySlot.end(), "All %zu slots are in use",
+                        mPointerIdsBySlot.size());
+    return std::distance(mPointerIdsBySlot.begin(), it);
 }
 
 void SlotState::processPointerId(int pointerId, int32_t actionMasked) {
+    LOG_ALWAYS_FATAL_IF(pointerId < 0 || pointerId > MAX_POINTER_ID, "Invalid pointer id %d",
+                        pointerId);
     switch (MotionEvent::getActionMasked(actionMasked)) {
         case AMOTION_EVENT_ACTION_DOWN:
         case AMOTION_EVENT_ACTION_POINTER_DOWN:
@@ -523,12 +525,11 @@ void SlotState::processPointerId(int pointerId, int32_t actionMasked) {
         case AMOTION_EVENT_ACTION_POINTER_UP:
         case AMOTION_EVENT_ACTION_UP:
         case AMOTION_EVENT_ACTION_HOVER_EXIT: {
-            auto it = mSlotsByPointerId.find(pointerId);
-            LOG_ALWAYS_FATAL_IF(it == mSlotsByPointerId.end());
-            size_t slot = it->second;
+            const int32_t slot = mSlotsByPointerId[pointerId];
+            LOG_ALWAYS_FATAL_IF(slot == NO_VALUE);
             // Erase this pointer from both collections
-            mPointerIdsBySlot.erase(slot);
-            mSlotsByPointerId.erase(pointerId);
+            mPointerIdsBySlot[slot] = NO_VALUE;
+            mSlotsByPointerId[pointerId] = NO_VALUE;
             return;
         }
     }
@@ -537,18 +538,29 @@ void SlotState::processPointerId(int pointerId, int32_t actionMasked) {
 }
 
 std::optional<size_t> SlotState::getSlotForPointerId(int32_t pointerId) const {
-    auto it = mSlotsByPointerId.find(pointerId);
-    if (it == mSlotsByPointerId.end()) {
+    if (pointerId < 0 || pointerId > MAX_POINTER_ID || mSlotsByPointerId[pointerId] == NO_VALUE) {
         return std::nullopt;
     }
-    return it->second;
+    return mSlotsByPointerId[pointerId];
 }
 
 std::string SlotState::dump() const {
+    std::map<int32_t, size_t> slotsByPointerId;
+    for (size_t pointerId = 0; pointerId < mSlotsByPointerId.size(); pointerId++) {
+        if (mSlotsByPointerId[pointerId] != NO_VALUE) {
+            slotsByPointerId[pointerId] = mSlotsByPointerId[pointerId];
+        }
+    }
+    std::map<size_t, int32_t> pointerIdsBySlot;
+    for (size_t slot = 0; slot < mPointerIdsBySlot.size(); slot++) {
+        if (mPointerIdsBySlot[slot] != NO_VALUE) {
+            pointerIdsBySlot[slot] = mPointerIdsBySlot[slot];
+        }
+    }
     std::string out = "mSlotsByPointerId:\n";
-    out += addLinePrefix(dumpMap(mSlotsByPointerId), "  ") + "\n";
+    out += addLinePrefix(dumpMap(slotsByPointerId), "  ") + "\n";
     out += "mPointerIdsBySlot:\n";
-    out += addLinePrefix(dumpMap(mPointerIdsBySlot), "  ") + "\n";
+    out += addLinePrefix(dumpMap(pointerIdsBySlot), "  ") + "\n";
     return out;
 }
 
@@ -566,6 +578,7 @@ PalmRejector::PalmRejector(const AndroidPalmFilterDeviceInfo& info,
       : mSharedPalmState(std::make_unique<::ui::SharedPalmDetectionFilterState>()),
         mDeviceInfo(info),
         mPalmDetectionFilter(std::move(filter)) {
+    mTouches.reserve(MAX_POINTERS);
     if (mPalmDetectionFilter != nullptr) {
         // This path is used for testing. Non-testing invocations should let this constructor
         // create a real PalmDetectionFilter
@@ -582,7 +595,14 @@ std::vector<::ui::InProgressTouchEvdev> getTouches(const NotifyMotionArgs& args,
                                                    const SlotState& oldSlotState,
                                                    const SlotState& newSlotState) {
     std::vector<::ui::InProgressTouchEvdev> touches;
+    getTouches(args, deviceInfo, oldSlotState, newSlotState, touches);
+    return touches;
+}
 
+void getTouches(const NotifyMotionArgs& args, const AndroidPalmFilterDeviceInfo& deviceInfo,
+                const SlotState& oldSlotState, const SlotState& newSlotState,
+                std::vector<::ui::InProgressTouchEvdev>& touches) {
+    touches.clear();
     for (size_t i = 0; i < args.getPointerCount(); i++) {
         const int32_t pointerId = args.pointerProperties[i].id;
         touches.emplace_back(::ui::InProgressTouchEvdev());
@@ -641,7 +661,6 @@ std::vector<::ui::InProgressTouchEvdev> getTouches(const NotifyMotionArgs& args,
         // The field 'reported_tool_type' is not used for palm rejection
         touches.back().stylus_button = false;
     }
-    return touches;
 }
 
 std::set<int32_t> PalmRejector::detectPalmPointers(const NotifyMotionArgs& args) {
@@ -653,19 +672,18 @@ std::set<int32_t> PalmRejector::detectPalmPointers(const NotifyMotionArgs& args)
     SlotState oldSlotState = mSlotState;
     mSlotState.update(args);
 
-    std::vector<::ui::InProgressTouchEvdev> touches =
-            getTouches(args, mDeviceInfo, oldSlotState, mSlotState);
+    getTouches(args, mDeviceInfo, oldSlotState, mSlotState, mTouches);
     ::base::TimeTicks chromeTimestamp = toChromeTimestamp(args.eventTime);
 
     if (DEBUG_MODEL) {
         std::stringstream touchesStream;
-        for (const ::ui::InProgressTouchEvdev& touch : touches) {
+        for (const ::ui::InProgressTouchEvdev& touch : mTouches) {
             touchesStream << touch.tracking_id << " : " << touch << "\n";
         }
         ALOGD("Filter: touches = %s", touchesStream.str().c_str());
     }
 
-    mPalmDetectionFilter->Filter(touches, chromeTimestamp, &slotsToHold, &slotsToSuppress);
+    mPalmDetectionFilter->Filter(mTouches, chromeTimestamp, &slotsToHold, &slotsToSuppress);
 
     ALOGD_IF(DEBUG_MODEL, "Response: slotsToHold = %s, slotsToSuppress = %s",
              slotsToHold.to_string().c_str(), slotsToSuppress.to_string().c_str());
@@ -16,6 +16,7 @@
 
 #pragma once
 
+#include <array>
 #include <map>
 #include <set>
 
@@ -128,6 +129,7 @@ private:
 
 class SlotState {
 public:
+    SlotState();
     /**
      * Update the state using the new information provided in the NotifyMotionArgs
      */
@@ -136,17 +138,17 @@ public:
     std::string dump() const;
 
 private:
+    static constexpr int32_t NO_VALUE = -1;
     // Process a pointer with the provided action, and return the slot associated with it
     void processPointerId(int32_t pointerId, int32_t action);
     // The map from tracking id to slot state. Since the PalmRejectionFilter works close to the
     // evdev level, the only way to tell it about UP or CANCEL events is by sending tracking id = -1
     // to the appropriate touch slot. So we need to reconstruct the original slot.
-    // The two collections below must always be in-sync.
-    // Use std::map instead of std::unordered_map because we rely on these collections being
-    // ordered. It also has better space efficiency than unordered_map because we only have a few
-    // pointers most of the time.
-    std::map<int32_t /*pointerId*/, size_t /*slot*/> mSlotsByPointerId;
-    std::map<size_t /*slot*/, int32_t /*pointerId */> mPointerIdsBySlot;
+    // The two collections below must always be in-sync. Unused entries are set to NO_VALUE.
+    // They are fixed-size arrays, so that the state can be updated and copied for every event
+    // without allocating.
+    std::array<int32_t /*slot*/, MAX_POINTER_ID + 1> mSlotsByPointerId;
+    std::array<int32_t /*pointerId*/, ::ui::kNumTouchEvdevSlots> mPointerIdsBySlot;
 
     size_t findUnusedSlot() const;
 };
@@ -160,6 +162,14 @@ std::vector<::ui::InProgressTouchEvdev> getTouches(const NotifyMotionArgs& args,
                                                    const SlotState& oldSlotState,
                                                    const SlotState& newSlotState);
 
+/**
+ * Same as above, but the touches are written to the provided vector, so that its storage can be
+ * reused from one event to the next.
+ */
+void getTouches(const NotifyMotionArgs& args, const AndroidPalmFilterDeviceInfo& deviceInfo,
+                const SlotState& oldSlotState, const SlotState& newSlotState,
+                std::vector<::ui::InProgressTouchEvdev>& outTouches);
+
 class PalmRejector {
 public:
     explicit PalmRejector(const AndroidPalmFilterDeviceInfo& info,
@@ -189,6 +199,9 @@ private:
 
     // Used to help convert an Android touch stream to Linux input stream.
     SlotState mSlotState;
+    // The touches given to the palm detection filter. Kept here so that the conversion of every
+    // event reuses the same storage.
+    std::vector<::ui::InProgressTouchEvdev> mTouches;
 };
 
 } // namespace android
@@ -0,0 +1,404 @@
+/*
+ * Copyright (C) 2024 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/**
+ * Replays the events of an input trace through InputDispatcher, and reports the distribution of
+ * the time it takes for each event to be delivered to a window, as well as the time that the
+ * dispatch loop holds the dispatcher lock.
+ *
+ * Usage:
+ *   inputdispatcher_replay_benchmarks --trace=<perfetto trace> [--windows=<window layout>]
+ *       [benchmark flags]
+ *
+ * The trace is a Perfetto trace that was captured with the android.input.inputevent data source.
+ * Only the events that the dispatcher traced without redaction are replayed, because the others
+ * do not have their coordinates.
+ *
+ * The window layout is a text file with one window per line, from the top-most to the bottom-most
+ * window, in the format:
+ *   <name> <display id> <left> <top> <right> <bottom> [spy]
+ * Lines starting with '#' are ignored. The bottom-most window that is not a spy window of each
+ * display gets focus, so that key events can be replayed too. Without a window layout, a single
+ * window covers each display of the trace.
+ */
+
+#include <benchmark/benchmark.h>
+
+#include <poll.h>
+
+#include <fstream>
+#include <map>
+#include <set>
+#include <sstream>
+#include <string_view>
+#include <variant>
+
+#include <android-base/file.h>
+#include <android-base/logging.h>
+#include <input/Input.h>
+#include <perfetto/trace/android/android_input_event.pbzero.h>
+#include <perfetto/trace/android/winscope_extensions_impl.pbzero.h>
+#include <perfetto/trace/trace.pbzero.h>
+#include <perfetto/trace/trace_packet.pbzero.h>
+#include "../dispatcher/InputDispatcher.h"
+#include "../tests/FakeApplicationHandle.h"
+#include "../tests/FakeInputDispatcherPolicy.h"
+#include "../tests/FakeWindows.h"
+
+namespace android::inputdispatcher {
+
+namespace {
+
+namespace proto = perfetto::protos::pbzero;
+
+// How long to wait for an event to be delivered before considering that it went nowhere.
+constexpr std::chrono::milliseconds DELIVERY_TIMEOUT = 10ms;
+// A window that covers any display.
+const Rect FULL_SCREEN_FRAME(0, 0, 10000, 10000);
+
+using TracedInput = std::variant<NotifyMotionArgs, NotifyKeyArgs>;
+
+struct WindowLayout {
+    std::string name;
+    ui::LogicalDisplayId displayId;
+    Rect frame;
+    bool isSpy;
+};
+
+nsecs_t now() {
+    return systemTime(SYSTEM_TIME_MONOTONIC);
+}
+
+NotifyMotionArgs toMotionArgs(proto::AndroidMotionEvent::Decoder& event) {
+    std::vector<PointerProperties> pointerProperties;
+    std::vector<PointerCoords> pointerCoords;
+    for (auto pointerIt = event.pointer(); pointerIt; ++pointerIt) {
+        proto::AndroidMotionEvent::Pointer::Decoder pointer(*pointerIt);
+        PointerProperties& properties = pointerProperties.emplace_back();
+        properties.clear();
+        properties.id = pointer.pointer_id();
+        properties.toolType = static_cast<ToolType>(pointer.tool_type());
+
+        PointerCoords& coords = pointerCoords.emplace_back();
+        coords.clear();
+        for (auto axisIt = pointer.axis_value(); axisIt; ++axisIt) {
+            proto::AndroidMotionEvent::Pointer::AxisValue::Decoder axisValue(*axisIt);
+            coords.setAxisValue(axisValue.axis(), axisValue.value());
+        }
+    }
+    return NotifyMotionArgs(event.event_id(), event.event_time_nanos(), event.event_time_nanos(),
+                            event.device_id(), event.source(),
+                            ui::LogicalDisplayId{event.display_id()}, event.policy_flags(),
+                            event.action(), /*actionButton=*/0, event.flags(), event.meta_state(),
+                            /*buttonState=*/0,
+                            static_cast<MotionClassification>(event.classification()),
+                            AMOTION_EVENT_EDGE_FLAG_NONE, pointerProperties.size(),
+                            pointerProperties.data(), pointerCoords.data(), /*xPrecision=*/0,
+                            /*yPrecision=*/0, event.cursor_position_x(), event.cursor_position_y(),
+                            event.down_time_nanos(), /*videoFrames=*/{});
+}
+
+NotifyKeyArgs toKeyArgs(proto::AndroidKeyEvent::Decoder& event) {
+    return NotifyKeyArgs(event.event_id(), event.event_time_nanos(), event.event_time_nanos(),
+                         event.device_id(), event.source(),
+                         ui::LogicalDisplayId{event.display_id()}, event.policy_flags(),
+                         event.action(), event.flags(), event.key_code(), event.scan_code(),
+                         event.meta_state(), event.down_time_nanos());
+}
+
+std::vector<TracedInput> readTrace(const std::string& path) {
+    std::string data;
+    if (!base::ReadFileToString(path, &data)) {
+        PLOG(FATAL) << "Could not read the trace " << path;
+    }
+    std::vector<TracedInput> trace;
+    proto::Trace::Decoder traceDecoder(reinterpret_cast<const uint8_t*>(data.data()),
+                                       data.size());
+    for (auto packetIt = traceDecoder.packet(); packetIt; ++packetIt) {
+        proto::TracePacket::Decoder packet(*packetIt);
+        if (!packet.has_winscope_extensions()) {
+            continue;
+        }
+        proto::WinscopeExtensionsImpl::Decoder extensions(packet.winscope_extensions());
+        if (!extensions.has_android_input_event()) {
+            continue;
+        }
+        proto::AndroidInputEvent::Decoder inputEvent(extensions.android_input_event());
+        if (inputEvent.has_dispatcher_motion_event()) {
+            proto::AndroidMotionEvent::Decoder motion(inputEvent.dispatcher_motion_event());
+            trace.push_back(toMotionArgs(motion));
+        } else if (inputEvent.has_dispatcher_key_event()) {
+            proto::AndroidKeyEvent::Decoder key(inputEvent.dispatcher_key_event());
+            trace.push_back(toKeyArgs(key));
+        }
+    }
+    LOG(INFO) << "Read " << trace.size() << " events from " << path;
+    return trace;
+}
+
+std::vector<WindowLayout> readWindowLayout(const std::string& path) {
+    std::ifstream file(path);
+    if (!file) {
+        LOG(FATAL) << "Could not read the window layout " << path;
+    }
+    std::vector<WindowLayout> windows;
+    std::string line;
+    while (std::getline(file, line)) {
+        if (line.empty() || line[0] == '#') {
+            continue;
+        }
+        std::istringstream stream(line);
+        std::string name;
+        int32_t displayId;
+        Rect frame;
+        stream >> name >> displayId >> frame.left >> frame.top >> frame.right >> frame.bottom;
+        if (!stream) {
+            LOG(FATAL) << "Invalid window in " << path << ": '" << line << "'";
+        }
+        std::string option;
+        const bool isSpy = (stream >> option) && option == "spy";
+        windows.push_back({name, ui::LogicalDisplayId{displayId}, frame, isSpy});
+    }
+    return windows;
+}
+
+std::vector<WindowLayout> getDefaultWindowLayout(const std::vector<TracedInput>& trace) {
+    std::set<ui::LogicalDisplayId> displayIds;
+    for (const TracedInput& input : trace) {
+        std::visit([&](const auto& args) { displayIds.insert(args.displayId); }, input);
+    }
+    displayIds.erase(ui::LogicalDisplayId::INVALID);
+    if (displayIds.empty()) {
+        displayIds.insert(ui::LogicalDisplayId::DEFAULT);
+    }
+    std::vector<WindowLayout> windows;
+    for (ui::LogicalDisplayId displayId : displayIds) {
+        windows.push_back({"Window " + displayId.toString(), displayId, FULL_SCREEN_FRAME,
+                           /*isSpy=*/false});
+    }
+    return windows;
+}
+
+using Receivers = std::vector<std::unique_ptr<FakeInputReceiver>>;
+
+/**
+ * Create the windows of the layout, and give focus to the bottom-most window that is not a spy
+ * window of each display.
+ */
+Receivers createWindows(InputDispatcher& dispatcher, const std::vector<WindowLayout>& layout) {
+    std::shared_ptr<FakeApplicationHandle> application = std::make_shared<FakeApplicationHandle>();
+    application->updateInfo();
+    Receivers receivers;
+    std::vector<gui::WindowInfo> windowInfos;
+    std::set<ui::LogicalDisplayId> displayIds;
+    std::map<ui::LogicalDisplayId, gui::WindowInfo> focusedWindowInfos;
+    for (const WindowLayout& window : layout) {
+        base::Result<std::unique_ptr<InputChannel>> channel =
+                dispatcher.createInputChannel(window.name);
+        LOG_IF(FATAL, !channel.ok()) << "Could not create a channel for " << window.name;
+
+        gui::WindowInfo& info = windowInfos.emplace_back();
+        info.token = (*channel)->getConnectionToken();
+        info.id = static_cast<int32_t>(windowInfos.size());
+        info.name = window.name;
+        info.applicationInfo = *application->getInfo();
+        info.dispatchingTimeout = 5s;
+        info.alpha = 1.0;
+        info.frame = window.frame;
+        info.transform.set(-window.frame.left, -window.frame.top);
+        info.globalScaleFactor = 1.0;
+        info.addTouchableRegion(window.frame);
+        info.displayId = window.displayId;
+        displayIds.insert(window.displayId);
+        info.inputConfig = gui::WindowInfo::InputConfig::DEFAULT;
+        if (window.isSpy) {
+            info.setInputConfig(gui::WindowInfo::InputConfig::SPY, true);
+            info.setInputConfig(gui::WindowInfo::InputConfig::TRUSTED_OVERLAY, true);
+            info.setInputConfig(gui::WindowInfo::InputConfig::NOT_FOCUSABLE, true);
+        } else {
+            focusedWindowInfos[window.displayId] = info;
+        }
+        receivers.push_back(std::make_unique<FakeInputReceiver>(std::move(*channel), window.name));
+    }
+
+    std::vector<gui::DisplayInfo> displayInfos;
+    for (ui::LogicalDisplayId displayId : displayIds) {
+        gui::DisplayInfo& displayInfo = displayInfos.emplace_back();
+        displayInfo.displayId = displayId;
+    }
+    dispatcher.onWindowInfosChanged({windowInfos, displayInfos, /*vsyncId=*/0, /*timestamp=*/0});
+
+    for (const auto& [displayId, info] : focusedWindowInfos) {
+        dispatcher.setFocusedApplication(displayId, application);
+        gui::FocusRequest request;
+        request.token = info.token;
+        request.windowName = info.name;
+        request.timestamp = now();
+        request.displayId = displayId.val();
+        dispatcher.setFocusedWindow(request);
+    }
+    return receivers;
+}
+
+/**
+ * Consume and finish all the events that were delivered to the windows, until the dispatcher has
+ * nothing left to do.
+ */
+void drainWindows(InputDispatcher& dispatcher, Receivers& receivers) {
+    do {
+        for (std::unique_ptr<FakeInputReceiver>& receiver : receivers) {
+            while (receiver->consume(/*timeout=*/0ms, /*handled=*/true) != nullptr) {
+            }
+        }
+    } while (!dispatcher.waitForIdle());
+}
+
+/**
+ * Wait until an event is delivered to any of the windows. Returns false if none was delivered
+ * within DELIVERY_TIMEOUT.
+ */
+bool waitForDelivery(Receivers& receivers) {
+    std::vector<pollfd> fds;
+    for (std::unique_ptr<FakeInputReceiver>& receiver : receivers) {
+        fds.push_back({.fd = receiver->getChannelFd(), .events = POLLIN});
+    }
+    const int ready = poll(fds.data(), fds.size(), static_cast<int>(DELIVERY_TIMEOUT.count()));
+    return ready > 0;
+}
+
+/**
+ * Move the event to the current time, keeping its distance to the down time, so that the
+ * dispatcher does not drop it as stale.
+ */
+template <typename T>
+void retime(T& args, int32_t id) {
+    const nsecs_t eventTime = now();
+    args.id = id;
+    args.downTime = eventTime - (args.eventTime - args.downTime);
+    args.eventTime = eventTime;
+    args.readTime = eventTime;
+    // The events that were injected into the traced device are replayed as if they came from
+    // the reader.
+    args.policyFlags &= ~(POLICY_FLAG_INJECTED | POLICY_FLAG_FILTERED);
+    args.policyFlags |= POLICY_FLAG_PASS_TO_USER;
+}
+
+/**
+ * Replay one traced event per iteration. The time of an iteration is the time between the
+ * notification of the event and its delivery to the first window.
+ */
+void benchmarkReplayTrace(benchmark::State& state, const std::vector<TracedInput>& trace,
+                          const std::vector<WindowLayout>& layout) {
+    FakeInputDispatcherPolicy fakePolicy;
+    auto dispatcher = std::make_unique<InputDispatcher>(fakePolicy);
+    // Key repeats would keep the dispatcher from becoming idle between the events.
+    dispatcher->setKeyRepeatConfiguration(/*timeout=*/500ms, /*delay=*/50ms,
+                                          /*keyRepeatEnabled=*/false);
+    dispatcher->setInputDispatchMode(/*enabled=*/true, /*frozen=*/false);
+    dispatcher->start();
+    Receivers receivers = createWindows(*dispatcher, layout);
+    drainWindows(*dispatcher, receivers);
+
+    IdGenerator idGenerator(IdGenerator::Source::INPUT_READER);
+    LatencyHistogram deliveryLatencies;
+    int64_t undeliveredCount = 0;
+    size_t index = 0;
+    for (auto _ : state) {
+        TracedInput input = trace[index];
+        index = (index + 1) % trace.size();
+
+        const nsecs_t startTime = now();
+        std::visit(
+                [&](auto& args) {
+                    retime(args, idGenerator.nextId());
+                    using T = std::decay_t<decltype(args)>;
+                    if constexpr (std::is_same_v<T, NotifyMotionArgs>) {
+                        dispatcher->notifyMotion(args);
+                    } else {
+                        dispatcher->notifyKey(args);
+                    }
+                },
+                input);
+        const bool delivered = waitForDelivery(receivers);
+        const nsecs_t latency = now() - startTime;
+        state.SetIterationTime(latency * 1E-9);
+        if (delivered) {
+            deliveryLatencies.add(latency);
+        } else {
+            undeliveredCount++;
+        }
+
+        drainWindows(*dispatcher, receivers);
+    }
+
+    const LatencyHistogram lockHoldTimes = dispatcher->getDispatchLockHoldTimes();
+    for (float percentile : {50.f, 90.f, 99.f}) {
+        const std::string suffix = "p" + std::to_string(static_cast<int>(percentile)) + "_us";
+        state.counters["delivery_" + suffix] = ns2us(deliveryLatencies.getPercentile(percentile));
+        state.counters["lock_hold_" + suffix] = ns2us(lockHoldTimes.getPercentile(percentile));
+    }
+    state.counters["undelivered"] = undeliveredCount;
+    dispatcher->stop();
+}
+
+} // namespace
+
+} // namespace android::inputdispatcher
+
+int main(int argc, char** argv) {
+    using namespace android::inputdispatcher;
+
+    // Extract the flags of this benchmark before passing the others to the benchmark library.
+    std::string tracePath;
+    std::string windowsPath;
+    int benchmarkArgc = 1;
+    for (int i = 1; i < argc; i++) {
+        std::string_view arg(argv[i]);
+        if (arg.starts_with("--trace=")) {
+            tracePath = arg.substr(std::string_view("--trace=").size());
+        } else if (arg.starts_with("--windows=")) {
+            windowsPath = arg.substr(std::string_view("--windows=").size());
+        } else {
+            argv[benchmarkArgc++] = argv[i];
+        }
+    }
+    argc = benchmarkArgc;
+    benchmark::Initialize(&argc, argv);
+    if (benchmark::ReportUnrecognizedArguments(argc, argv)) {
+        return 1;
+    }
+    if (tracePath.empty()) {
+        LOG(ERROR) << "Usage: " << argv[0]
+                   << " --trace=<perfetto trace> [--windows=<window layout>] [benchmark flags]";
+        return 1;
+    }
+
+    const std::vector<TracedInput> trace = readTrace(tracePath);
+    if (trace.empty()) {
+        LOG(ERROR) << "There are no unredacted input events in " << tracePath;
+        return 1;
+    }
+    const std::vector<WindowLayout> layout =
+            windowsPath.empty() ? getDefaultWindowLayout(trace) : readWindowLayout(windowsPath);
+
+    benchmark::RegisterBenchmark("benchmarkReplayTrace",
+                                 [&](benchmark::State& state) {
+                                     benchmarkReplayTrace(state, trace, layout);
+                                 })
+            ->UseManualTime();
+    benchmark::RunSpecifiedBenchmarks();
+    return 0;
+}
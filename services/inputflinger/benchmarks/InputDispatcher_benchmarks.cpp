@@ -169,6 +169,58 @@ static void benchmarkInjectMotion(benchmark::State& state) {
     dispatcher->stop();
 }
 
+/**
+ * Touches a full screen window below state.range(0) small windows, none of which is at the
+ * touched location.
+ */
+static void benchmarkNotifyMotionWithManyWindows(benchmark::State& state) {
+    // Create dispatcher
+    FakeInputDispatcherPolicy fakePolicy;
+    auto dispatcher = std::make_unique<InputDispatcher>(fakePolicy);
+    dispatcher->setInputDispatchMode(/*enabled*/ true, /*frozen*/ false);
+    dispatcher->start();
+
+    std::shared_ptr<FakeApplicationHandle> application = std::make_shared<FakeApplicationHandle>();
+    std::vector<sp<FakeWindowHandle>> overlays;
+    std::vector<gui::WindowInfo> windowInfos;
+    for (int64_t i = 0; i < state.range(0); i++) {
+        sp<FakeWindowHandle> overlay =
+                sp<FakeWindowHandle>::make(application, dispatcher, "Fake Overlay", DISPLAY_ID);
+        const int32_t left = (i % 10) * 100;
+        const int32_t top = 400 + (i / 10) * 50;
+        overlay->setFrame(Rect(left, top, left + 100, top + 50));
+        windowInfos.push_back(*overlay->getInfo());
+        overlays.push_back(std::move(overlay));
+    }
+    // Create a window that will receive motion events
+    sp<FakeWindowHandle> window =
+            sp<FakeWindowHandle>::make(application, dispatcher, "Fake Window", DISPLAY_ID);
+    window->setFrame(Rect(0, 0, 1080, 2400));
+    windowInfos.push_back(*window->getInfo());
+
+    dispatcher->onWindowInfosChanged({windowInfos, {}, 0, 0});
+
+    NotifyMotionArgs motionArgs = generateMotionArgs();
+
+    for (auto _ : state) {
+        // Send ACTION_DOWN
+        motionArgs.action = AMOTION_EVENT_ACTION_DOWN;
+        motionArgs.downTime = now();
+        motionArgs.eventTime = motionArgs.downTime;
+        dispatcher->notifyMotion(motionArgs);
+
+        // Send ACTION_UP
+        motionArgs.action = AMOTION_EVENT_ACTION_UP;
+        motionArgs.eventTime = now();
+        dispatcher->notifyMotion(motionArgs);
+
+        window->consumeMotionEvent();
+        window->consumeMotionEvent();
+    }
+
+    dispatcher->stop();
+}
+
 static void benchmarkOnWindowInfosChanged(benchmark::State& state) {
     // Create dispatcher
     FakeInputDispatcherPolicy fakePolicy;
@@ -199,6 +251,7 @@ static void benchmarkOnWindowInfosChanged(benchmark::State& state) {
 
 BENCHMARK(benchmarkNotifyMotion);
 BENCHMARK(benchmarkInjectMotion);
+BENCHMARK(benchmarkNotifyMotionWithManyWindows)->Arg(50)->Arg(200);
 BENCHMARK(benchmarkOnWindowInfosChanged);
 
 } // namespace android::inputdispatcher
@@ -0,0 +1,186 @@
+/*
+ * Copyright (C) 2024 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <benchmark/benchmark.h>
+
+#include <linux/input.h>
+#include <math.h>
+
+#include "../tests/FakeEventHub.h"
+#include "../tests/FakeInputReaderPolicy.h"
+#include "../tests/InstrumentedInputReader.h"
+
+namespace android {
+
+namespace {
+
+constexpr int32_t EVENTHUB_ID = 1;
+constexpr int32_t DISPLAY_WIDTH = 1080;
+constexpr int32_t DISPLAY_HEIGHT = 2400;
+// A touch screen reporting at 240Hz.
+constexpr nsecs_t FRAME_INTERVAL = 4'166'667;
+constexpr size_t TRACE_FRAMES = 240;
+// A touchpad of about 100 by 60 mm, reporting at 125Hz.
+constexpr int32_t TOUCHPAD_WIDTH = 1200;
+constexpr int32_t TOUCHPAD_HEIGHT = 720;
+constexpr int32_t TOUCHPAD_RESOLUTION = 12;
+constexpr nsecs_t TOUCHPAD_FRAME_INTERVAL = 8'000'000;
+
+class NoopListener : public InputListenerInterface {
+public:
+    void notifyInputDevicesChanged(const NotifyInputDevicesChangedArgs&) override {}
+    void notifyKey(const NotifyKeyArgs&) override {}
+    void notifyMotion(const NotifyMotionArgs&) override {}
+    void notifySwitch(const NotifySwitchArgs&) override {}
+    void notifySensor(const NotifySensorArgs&) override {}
+    void notifyVibratorState(const NotifyVibratorStateArgs&) override {}
+    void notifyDeviceReset(const NotifyDeviceResetArgs&) override {}
+    void notifyPointerCaptureChanged(const NotifyPointerCaptureChangedArgs&) override {}
+};
+
+struct TouchFrame {
+    std::vector<std::pair<int32_t, int32_t>> positions;
+};
+
+// One second of fingers circling around their own point of the screen.
+std::vector<TouchFrame> createTouchTrace(size_t fingers) {
+    std::vector<TouchFrame> trace(TRACE_FRAMES);
+    for (size_t frame = 0; frame < TRACE_FRAMES; frame++) {
+        const float angle = 2 * M_PI * frame / TRACE_FRAMES;
+        for (size_t finger = 0; finger < fingers; finger++) {
+            const float centerX = DISPLAY_WIDTH * (finger % 5 + 1) / 6;
+            const float centerY = DISPLAY_HEIGHT * (finger / 5 + 1) / 3;
+            const int32_t x = centerX + 50 * cosf(angle + finger);
+            const int32_t y = centerY + 50 * sinf(angle + finger);
+            trace[frame].positions.emplace_back(x, y);
+        }
+    }
+    return trace;
+}
+
+void enqueueFrame(FakeEventHub& eventHub, nsecs_t when, const TouchFrame& frame) {
+    for (size_t slot = 0; slot < frame.positions.size(); slot++) {
+        eventHub.enqueueEvent(when, when, EVENTHUB_ID, EV_ABS, ABS_MT_SLOT, slot);
+        eventHub.enqueueEvent(when, when, EVENTHUB_ID, EV_ABS, ABS_MT_TRACKING_ID, slot);
+        eventHub.enqueueEvent(when, when, EVENTHUB_ID, EV_ABS, ABS_MT_POSITION_X,
+                              frame.positions[slot].first);
+        eventHub.enqueueEvent(when, when, EVENTHUB_ID, EV_ABS, ABS_MT_POSITION_Y,
+                              frame.positions[slot].second);
+        eventHub.enqueueEvent(when, when, EVENTHUB_ID, EV_ABS, ABS_MT_TOUCH_MAJOR, 10);
+        eventHub.enqueueEvent(when, when, EVENTHUB_ID, EV_ABS, ABS_MT_PRESSURE, 100);
+    }
+    eventHub.enqueueEvent(when, when, EVENTHUB_ID, EV_SYN, SYN_REPORT, 0);
+}
+
+// Reads a trace of multi-touch frames, from the raw events to the NotifyMotionArgs.
+static void benchmarkMultiTouchFrames(benchmark::State& state) {
+    const size_t fingers = state.range(0);
+    auto eventHub = std::make_shared<FakeEventHub>();
+    sp<FakeInputReaderPolicy> policy = sp<FakeInputReaderPolicy>::make();
+    NoopListener listener;
+    InstrumentedInputReader reader(eventHub, policy, listener);
+
+    policy->addDisplayViewport(ui::LogicalDisplayId::DEFAULT, DISPLAY_WIDTH, DISPLAY_HEIGHT,
+                               ui::ROTATION_0, /*isActive=*/true, "local:0",
+                               /*physicalPort=*/std::nullopt, ViewportType::INTERNAL);
+    eventHub->addDevice(EVENTHUB_ID, "touchscreen",
+                        InputDeviceClass::TOUCH | InputDeviceClass::TOUCH_MT);
+    eventHub->addConfigurationProperty(EVENTHUB_ID, "touch.deviceType", "touchScreen");
+    eventHub->addAbsoluteAxis(EVENTHUB_ID, ABS_MT_POSITION_X, 0, DISPLAY_WIDTH - 1, 0, 0);
+    eventHub->addAbsoluteAxis(EVENTHUB_ID, ABS_MT_POSITION_Y, 0, DISPLAY_HEIGHT - 1, 0, 0);
+    eventHub->addAbsoluteAxis(EVENTHUB_ID, ABS_MT_TOUCH_MAJOR, 0, 255, 0, 0);
+    eventHub->addAbsoluteAxis(EVENTHUB_ID, ABS_MT_PRESSURE, 0, 255, 0, 0);
+    eventHub->addAbsoluteAxis(EVENTHUB_ID, ABS_MT_TRACKING_ID, 0, 255, 0, 0);
+    eventHub->addAbsoluteAxis(EVENTHUB_ID, ABS_MT_SLOT, 0, 15, 0, 0);
+    eventHub->setAbsoluteAxisValue(EVENTHUB_ID, ABS_MT_SLOT, 0);
+    reader.loopOnce();
+    reader.requestRefreshConfiguration(InputReaderConfiguration::Change::DISPLAY_INFO);
+    reader.loopOnce();
+
+    const std::vector<TouchFrame> trace = createTouchTrace(fingers);
+    nsecs_t when = 0;
+    size_t frame = 0;
+    for (auto _ : state) {
+        enqueueFrame(*eventHub, when, trace[frame]);
+        reader.loopOnce();
+        when += FRAME_INTERVAL;
+        frame = (frame + 1) % trace.size();
+    }
+}
+
+// Two fingers scrolling up and down a touchpad, for one second.
+std::vector<TouchFrame> createTouchpadScrollTrace() {
+    std::vector<TouchFrame> trace(TRACE_FRAMES);
+    for (size_t frame = 0; frame < TRACE_FRAMES; frame++) {
+        const float angle = 2 * M_PI * frame / TRACE_FRAMES;
+        const int32_t y = TOUCHPAD_HEIGHT / 2 + TOUCHPAD_HEIGHT / 4 * sinf(angle);
+        trace[frame].positions.emplace_back(TOUCHPAD_WIDTH / 3, y);
+        trace[frame].positions.emplace_back(TOUCHPAD_WIDTH * 2 / 3, y);
+    }
+    return trace;
+}
+
+// Reads a trace of touchpad frames, through the gestures library to the NotifyMotionArgs.
+static void benchmarkTouchpadFrames(benchmark::State& state) {
+    auto eventHub = std::make_shared<FakeEventHub>();
+    sp<FakeInputReaderPolicy> policy = sp<FakeInputReaderPolicy>::make();
+    NoopListener listener;
+    InstrumentedInputReader reader(eventHub, policy, listener);
+
+    policy->addDisplayViewport(ui::LogicalDisplayId::DEFAULT, DISPLAY_WIDTH, DISPLAY_HEIGHT,
+                               ui::ROTATION_0, /*isActive=*/true, "local:0",
+                               /*physicalPort=*/std::nullopt, ViewportType::INTERNAL);
+    policy->setDefaultPointerDisplayId(ui::LogicalDisplayId::DEFAULT);
+    eventHub->addDevice(EVENTHUB_ID, "touchpad",
+                        InputDeviceClass::TOUCHPAD | InputDeviceClass::TOUCH_MT);
+    eventHub->addAbsoluteAxis(EVENTHUB_ID, ABS_MT_POSITION_X, 0, TOUCHPAD_WIDTH - 1, 0, 0,
+                              TOUCHPAD_RESOLUTION);
+    eventHub->addAbsoluteAxis(EVENTHUB_ID, ABS_MT_POSITION_Y, 0, TOUCHPAD_HEIGHT - 1, 0, 0,
+                              TOUCHPAD_RESOLUTION);
+    eventHub->addAbsoluteAxis(EVENTHUB_ID, ABS_MT_TOUCH_MAJOR, 0, 255, 0, 0);
+    eventHub->addAbsoluteAxis(EVENTHUB_ID, ABS_MT_PRESSURE, 0, 255, 0, 0);
+    eventHub->addAbsoluteAxis(EVENTHUB_ID, ABS_MT_TRACKING_ID, 0, 255, 0, 0);
+    eventHub->addAbsoluteAxis(EVENTHUB_ID, ABS_MT_SLOT, 0, 4, 0, 0);
+    eventHub->setAbsoluteAxisValue(EVENTHUB_ID, ABS_MT_SLOT, 0);
+    eventHub->addKey(EVENTHUB_ID, BTN_TOUCH, 0, AKEYCODE_UNKNOWN, 0);
+    eventHub->addKey(EVENTHUB_ID, BTN_TOOL_FINGER, 0, AKEYCODE_UNKNOWN, 0);
+    eventHub->addKey(EVENTHUB_ID, BTN_TOOL_DOUBLETAP, 0, AKEYCODE_UNKNOWN, 0);
+    reader.loopOnce();
+    reader.requestRefreshConfiguration(InputReaderConfiguration::Change::DISPLAY_INFO);
+    reader.loopOnce();
+
+    const std::vector<TouchFrame> trace = createTouchpadScrollTrace();
+    nsecs_t when = 0;
+    size_t frame = 0;
+    for (auto _ : state) {
+        // The key events are repeated on every frame, but only change the state on the first.
+        eventHub->enqueueEvent(when, when, EVENTHUB_ID, EV_KEY, BTN_TOUCH, 1);
+        eventHub->enqueueEvent(when, when, EVENTHUB_ID, EV_KEY, BTN_TOOL_DOUBLETAP, 1);
+        enqueueFrame(*eventHub, when, trace[frame]);
+        reader.loopOnce();
+        when += TOUCHPAD_FRAME_INTERVAL;
+        frame = (frame + 1) % trace.size();
+    }
+}
+
+} // namespace
+
+BENCHMARK(benchmarkMultiTouchFrames)->Arg(1)->Arg(10);
+BENCHMARK(benchmarkTouchpadFrames);
+
+} // namespace android
+
+BENCHMARK_MAIN();
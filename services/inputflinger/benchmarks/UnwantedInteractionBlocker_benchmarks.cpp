@@ -0,0 +1,156 @@
+/*
+ * Copyright (C) 2024 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <benchmark/benchmark.h>
+
+#include <math.h>
+
+#include "../UnwantedInteractionBlocker.h"
+
+namespace android {
+
+namespace {
+
+constexpr int32_t DEVICE_ID = 1;
+constexpr int32_t DISPLAY_WIDTH = 1600;
+constexpr int32_t DISPLAY_HEIGHT = 2560;
+constexpr int32_t RESOLUTION = 11;
+// A touch screen reporting at 240Hz.
+constexpr nsecs_t FRAME_INTERVAL = 4'166'667;
+// The touch major of the fingers, and of the palm that rests on the screen in some of the traces.
+constexpr float FINGER_MAJOR = 10;
+constexpr float PALM_MAJOR = 80;
+constexpr size_t TRACE_FRAMES = 240;
+
+int32_t getPointerAction(int32_t action, size_t pointerIndex) {
+    return action | (pointerIndex << AMOTION_EVENT_ACTION_POINTER_INDEX_SHIFT);
+}
+
+AndroidPalmFilterDeviceInfo createDeviceInfo() {
+    InputDeviceInfo info;
+    info.initialize(DEVICE_ID, /*generation=*/1, /*controllerNumber=*/1, InputDeviceIdentifier(),
+                    "touchscreen", /*isExternal=*/false, /*hasMic=*/false,
+                    ui::LogicalDisplayId::INVALID);
+    info.addSource(AINPUT_SOURCE_TOUCHSCREEN);
+    info.addMotionRange(AMOTION_EVENT_AXIS_X, AINPUT_SOURCE_TOUCHSCREEN, 0, DISPLAY_WIDTH - 1,
+                        /*flat=*/0, /*fuzz=*/0, RESOLUTION);
+    info.addMotionRange(AMOTION_EVENT_AXIS_Y, AINPUT_SOURCE_TOUCHSCREEN, 0, DISPLAY_HEIGHT - 1,
+                        /*flat=*/0, /*fuzz=*/0, RESOLUTION);
+    info.addMotionRange(AMOTION_EVENT_AXIS_TOUCH_MAJOR, AINPUT_SOURCE_TOUCHSCREEN, 0, 255,
+                        /*flat=*/0, /*fuzz=*/0, /*resolution=*/1);
+    return *createPalmFilterDeviceInfo(info);
+}
+
+NotifyMotionArgs createMotionArgs(nsecs_t downTime, nsecs_t eventTime, int32_t action,
+                                  size_t pointerCount, size_t frame, bool withPalm) {
+    PointerProperties pointerProperties[pointerCount];
+    PointerCoords pointerCoords[pointerCount];
+    const float angle = 2 * M_PI * frame / TRACE_FRAMES;
+    for (size_t i = 0; i < pointerCount; i++) {
+        pointerProperties[i].clear();
+        pointerProperties[i].id = i;
+        pointerProperties[i].toolType = ToolType::FINGER;
+
+        // The last pointer stays still, like the palm of a hand holding a stylus or a tablet.
+        const bool isPalm = withPalm && i == pointerCount - 1;
+        const float centerX = DISPLAY_WIDTH * (i % 5 + 1) / 6;
+        const float centerY = DISPLAY_HEIGHT * (i / 5 + 1) / 3;
+        pointerCoords[i].clear();
+        pointerCoords[i].setAxisValue(AMOTION_EVENT_AXIS_X,
+                                      isPalm ? centerX : centerX + 100 * cosf(angle + i));
+        pointerCoords[i].setAxisValue(AMOTION_EVENT_AXIS_Y,
+                                      isPalm ? centerY : centerY + 100 * sinf(angle + i));
+        pointerCoords[i].setAxisValue(AMOTION_EVENT_AXIS_TOUCH_MAJOR,
+                                      isPalm ? PALM_MAJOR : FINGER_MAJOR);
+    }
+    return NotifyMotionArgs(/*id=*/0, eventTime, /*readTime=*/eventTime, DEVICE_ID,
+                            AINPUT_SOURCE_TOUCHSCREEN, ui::LogicalDisplayId::DEFAULT,
+                            POLICY_FLAG_PASS_TO_USER, action, /*actionButton=*/0, /*flags=*/0,
+                            AMETA_NONE, /*buttonState=*/0, MotionClassification::NONE,
+                            AMOTION_EVENT_EDGE_FLAG_NONE, pointerCount, pointerProperties,
+                            pointerCoords, /*xPrecision=*/0, /*yPrecision=*/0,
+                            AMOTION_EVENT_INVALID_CURSOR_POSITION,
+                            AMOTION_EVENT_INVALID_CURSOR_POSITION, downTime, /*videoFrames=*/{});
+}
+
+/**
+ * A gesture of the given number of pointers going down one after the other, moving in circles for
+ * TRACE_FRAMES frames, and going up.
+ */
+std::vector<NotifyMotionArgs> createTrace(size_t pointerCount, bool withPalm) {
+    std::vector<NotifyMotionArgs> trace;
+    const nsecs_t downTime = 0;
+    nsecs_t eventTime = downTime;
+    for (size_t count = 1; count <= pointerCount; count++) {
+        const int32_t action = count == 1
+                ? AMOTION_EVENT_ACTION_DOWN
+                : getPointerAction(AMOTION_EVENT_ACTION_POINTER_DOWN, count - 1);
+        trace.push_back(createMotionArgs(downTime, eventTime, action, count, 0, withPalm));
+        eventTime += FRAME_INTERVAL;
+    }
+    for (size_t frame = 0; frame < TRACE_FRAMES; frame++) {
+        trace.push_back(createMotionArgs(downTime, eventTime, AMOTION_EVENT_ACTION_MOVE,
+                                         pointerCount, frame, withPalm));
+        eventTime += FRAME_INTERVAL;
+    }
+    for (size_t count = pointerCount; count >= 1; count--) {
+        const int32_t action = count == 1
+                ? AMOTION_EVENT_ACTION_UP
+                : getPointerAction(AMOTION_EVENT_ACTION_POINTER_UP, count - 1);
+        trace.push_back(createMotionArgs(downTime, eventTime, action, count, TRACE_FRAMES,
+                                         withPalm));
+        eventTime += FRAME_INTERVAL;
+    }
+    return trace;
+}
+
+// Runs the palm rejection model over a multi-touch trace, one event per iteration.
+void benchmarkPalmRejection(benchmark::State& state, bool withPalm) {
+    const size_t pointerCount = state.range(0);
+    const std::vector<NotifyMotionArgs> trace = createTrace(pointerCount, withPalm);
+    const nsecs_t traceDuration = trace.back().eventTime + FRAME_INTERVAL;
+    auto rejector = std::make_unique<PalmRejector>(createDeviceInfo());
+    size_t index = 0;
+    nsecs_t timeOffset = 0;
+    for (auto _ : state) {
+        NotifyMotionArgs args = trace[index];
+        args.downTime += timeOffset;
+        args.eventTime += timeOffset;
+        benchmark::DoNotOptimize(rejector->processMotion(args));
+        if (++index == trace.size()) {
+            // Replay the trace later in time, so that the model sees a new gesture.
+            index = 0;
+            timeOffset += traceDuration;
+        }
+    }
+}
+
+void BM_PalmRejection_Fingers(benchmark::State& state) {
+    benchmarkPalmRejection(state, /*withPalm=*/false);
+}
+
+void BM_PalmRejection_FingersAndPalm(benchmark::State& state) {
+    benchmarkPalmRejection(state, /*withPalm=*/true);
+}
+
+} // namespace
+
+BENCHMARK(BM_PalmRejection_Fingers)->Arg(1)->Arg(2)->Arg(5);
+BENCHMARK(BM_PalmRejection_FingersAndPalm)->Arg(2)->Arg(5);
+
+} // namespace android
+
+BENCHMARK_MAIN();
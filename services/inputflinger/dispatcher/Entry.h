@@ -75,6 +75,11 @@ struct EventEntry {
     EventEntry(const EventEntry&) = delete;
     EventEntry& operator=(const EventEntry&) = delete;
     virtual ~EventEntry() = default;
+
+    // Entries are allocated from the EntryPool, because one or more of them are created for
+    // every event.
+    static void* operator new(size_t size);
+    static void operator delete(void* ptr, size_t size);
 };
 
 struct DeviceResetEntry : EventEntry {
@@ -176,6 +181,7 @@ struct MotionEntry : EventEntry {
                 float yCursorPosition, nsecs_t downTime,
                 const std::vector<PointerProperties>& pointerProperties,
                 const std::vector<PointerCoords>& pointerCoords);
+    ~MotionEntry() override;
     std::string getDescription() const override;
 };
 
@@ -239,6 +245,10 @@ struct DispatchEntry {
     DispatchEntry(const DispatchEntry&) = delete;
     DispatchEntry& operator=(const DispatchEntry&) = delete;
 
+    // A dispatch entry is created for every target of every event, so they are pooled too.
+    static void* operator new(size_t size);
+    static void operator delete(void* ptr, size_t size);
+
     inline bool hasForegroundTarget() const {
         return targetFlags.test(InputTargetFlags::FOREGROUND);
     }
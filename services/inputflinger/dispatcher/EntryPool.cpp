@@ -0,0 +1,133 @@
+/*
+ * Copyright (C) 2024 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "EntryPool.h"
+
+#include <android-base/stringprintf.h>
+#include <inttypes.h>
+
+#include <algorithm>
+#include <new>
+
+using android::base::StringPrintf;
+
+namespace android::inputdispatcher {
+
+EntryPool& EntryPool::getInstance() {
+    // Never destroyed, because entries may still be released while static objects are destroyed.
+    static EntryPool* sInstance = new EntryPool();
+    return *sInstance;
+}
+
+size_t EntryPool::getBlockClass(size_t size) {
+    return size == 0 ? 0 : (size - 1) / BLOCK_ALIGNMENT;
+}
+
+void* EntryPool::allocate(size_t size) {
+    const size_t blockClass = getBlockClass(size);
+    if (blockClass >= NUM_BLOCK_CLASSES) {
+        return ::operator new(size);
+    }
+    {
+        std::scoped_lock lock(mLock);
+        std::vector<void*>& freeBlocks = mFreeBlocks[blockClass];
+        if (!freeBlocks.empty()) {
+            void* block = freeBlocks.back();
+            freeBlocks.pop_back();
+            mStats.blocksReused++;
+            return block;
+        }
+        mStats.blocksAllocated++;
+    }
+    return ::operator new((blockClass + 1) * BLOCK_ALIGNMENT);
+}
+
+void EntryPool::deallocate(void* block, size_t size) {
+    if (block == nullptr) {
+        return;
+    }
+    const size_t blockClass = getBlockClass(size);
+    if (blockClass < NUM_BLOCK_CLASSES) {
+        std::scoped_lock lock(mLock);
+        std::vector<void*>& freeBlocks = mFreeBlocks[blockClass];
+        if (freeBlocks.size() < MAX_POOLED_BLOCKS) {
+            freeBlocks.push_back(block);
+            return;
+        }
+    }
+    ::operator delete(block);
+}
+
+void EntryPool::obtainPointerArrays(size_t pointerCount,
+                                    std::vector<PointerProperties>& outProperties,
+                                    std::vector<PointerCoords>& outCoords) {
+    if (pointerCount == 0 || pointerCount > MAX_POINTERS) {
+        return;
+    }
+    {
+        std::scoped_lock lock(mLock);
+        std::vector<PointerArrays>& freeArrays = mFreePointerArrays[pointerCount - 1];
+        if (!freeArrays.empty()) {
+            outProperties = std::move(freeArrays.back().properties);
+            outCoords = std::move(freeArrays.back().coords);
+            freeArrays.pop_back();
+            mStats.pointerArraysReused++;
+            return;
+        }
+        mStats.pointerArraysAllocated++;
+    }
+    outProperties.reserve(pointerCount);
+    outCoords.reserve(pointerCount);
+}
+
+void EntryPool::recyclePointerArrays(std::vector<PointerProperties>&& properties,
+                                     std::vector<PointerCoords>&& coords) {
+    // The arrays are pooled by the number of pointers that both of them can hold.
+    const size_t pointerCount = std::min(properties.capacity(), coords.capacity());
+    if (pointerCount == 0 || pointerCount > MAX_POINTERS) {
+        return;
+    }
+    properties.clear();
+    coords.clear();
+    std::scoped_lock lock(mLock);
+    std::vector<PointerArrays>& freeArrays = mFreePointerArrays[pointerCount - 1];
+    if (freeArrays.size() < MAX_POOLED_ARRAYS) {
+        freeArrays.push_back({std::move(properties), std::move(coords)});
+    }
+}
+
+EntryPool::Stats EntryPool::getStats() const {
+    std::scoped_lock lock(mLock);
+    Stats stats = mStats;
+    for (const std::vector<void*>& freeBlocks : mFreeBlocks) {
+        stats.blocksPooled += freeBlocks.size();
+    }
+    for (const std::vector<PointerArrays>& freeArrays : mFreePointerArrays) {
+        stats.pointerArraysPooled += freeArrays.size();
+    }
+    return stats;
+}
+
+std::string EntryPool::dump() const {
+    const Stats stats = getStats();
+    return StringPrintf("blocks: allocated=%" PRIu64 ", reused=%" PRIu64 ", pooled=%zu; "
+                        "pointerArrays: allocated=%" PRIu64 ", reused=%" PRIu64 ", pooled=%zu",
+                        stats.blocksAllocated, stats.blocksReused, stats.blocksPooled,
+                        stats.pointerArraysAllocated, stats.pointerArraysReused,
+                        stats.pointerArraysPooled);
+}
+
+} // namespace android::inputdispatcher
@@ -0,0 +1,101 @@
+/*
+ * Copyright (C) 2024 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include <android-base/thread_annotations.h>
+#include <input/Input.h>
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <mutex>
+#include <string>
+#include <vector>
+
+namespace android::inputdispatcher {
+
+/**
+ * Keeps the memory of the entries that the dispatcher frees, so that it can be reused by the next
+ * events instead of going back to the allocator for every event and every target.
+ *
+ * Two kinds of memory are pooled:
+ *   - The blocks of the entry objects themselves, grouped in classes of BLOCK_ALIGNMENT bytes.
+ *   - The pointer arrays of the motion entries, grouped by pointer count.
+ *
+ * At most MAX_POOLED_BLOCKS blocks and MAX_POOLED_ARRAYS arrays are kept in each class. Anything
+ * above that is freed, so the memory held by the pool stays bounded after a burst of events.
+ *
+ * Entries can be released on any thread that holds the last reference to them, so the pool is
+ * thread-safe.
+ */
+class EntryPool {
+public:
+    static constexpr size_t BLOCK_ALIGNMENT = 64;
+    static constexpr size_t NUM_BLOCK_CLASSES = 8;
+    static constexpr size_t MAX_POOLED_BLOCKS = 256;
+    static constexpr size_t MAX_POOLED_ARRAYS = 32;
+
+    struct Stats {
+        uint64_t blocksAllocated = 0;
+        uint64_t blocksReused = 0;
+        size_t blocksPooled = 0;
+        uint64_t pointerArraysAllocated = 0;
+        uint64_t pointerArraysReused = 0;
+        size_t pointerArraysPooled = 0;
+    };
+
+    static EntryPool& getInstance();
+
+    /**
+     * Return a block of at least the given size. Blocks larger than the largest class are not
+     * pooled.
+     */
+    void* allocate(size_t size);
+    /**
+     * Give back a block returned by allocate. The size must be the one passed to allocate.
+     */
+    void deallocate(void* block, size_t size);
+
+    /**
+     * Return empty pointer arrays that can hold the given number of pointers without allocating.
+     */
+    void obtainPointerArrays(size_t pointerCount, std::vector<PointerProperties>& outProperties,
+                             std::vector<PointerCoords>& outCoords);
+    void recyclePointerArrays(std::vector<PointerProperties>&& properties,
+                              std::vector<PointerCoords>&& coords);
+
+    Stats getStats() const;
+    std::string dump() const;
+
+private:
+    struct PointerArrays {
+        std::vector<PointerProperties> properties;
+        std::vector<PointerCoords> coords;
+    };
+
+    EntryPool() = default;
+
+    static size_t getBlockClass(size_t size);
+
+    mutable std::mutex mLock;
+    std::array<std::vector<void*>, NUM_BLOCK_CLASSES> mFreeBlocks GUARDED_BY(mLock);
+    // Indexed by pointer count minus one.
+    std::array<std::vector<PointerArrays>, MAX_POINTERS> mFreePointerArrays GUARDED_BY(mLock);
+    Stats mStats GUARDED_BY(mLock);
+};
+
+} // namespace android::inputdispatcher
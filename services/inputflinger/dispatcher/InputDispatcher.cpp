@@ -51,6 +51,7 @@
 
 #include "Connection.h"
 #include "DebugConfig.h"
+#include "EntryPool.h"
 #include "InputDispatcher.h"
 #include "InputEventTimeline.h"
 #include "trace/InputTracer.h"
@@ -155,6 +156,10 @@ constexpr std::chrono::milliseconds SLOW_INTERCEPTION_THRESHOLD = 50ms;
 // Number of recent events to keep for debugging purposes.
 constexpr size_t RECENT_QUEUE_MAX_SIZE = 10;
 
+// Number of motions that can be notified without taking the dispatcher lock before the next ones
+// have to take it. This is larger than the bursts of events that the reader produces.
+constexpr size_t NOTIFIED_MOTIONS_CAPACITY = 512;
+
 // Event log tags. See EventLogTags.logtags for reference.
 constexpr int LOGTAG_INPUT_INTERACTION = 62000;
 constexpr int LOGTAG_INPUT_FOCUS = 62001;
@@ -935,6 +940,7 @@ InputDispatcher::InputDispatcher(InputDispatcherPolicyInterface& policy,
                                  std::unique_ptr<trace::InputTracingBackendInterface> traceBackend)
       : mPolicy(policy),
         mPendingEvent(nullptr),
+        mNotifiedMotions(NOTIFIED_MOTIONS_CAPACITY),
         mLastDropReason(DropReason::NOT_DROPPED),
         mIdGenerator(IdGenerator::Source::INPUT_DISPATCHER),
         mMinTimeBetweenUserActivityPokes(DEFAULT_USER_ACTIVITY_POKE_INTERVAL),
@@ -1001,8 +1007,12 @@ void InputDispatcher::dispatchOnce() {
     nsecs_t nextWakeupTime = LLONG_MAX;
     { // acquire lock
         std::scoped_lock _l(mLock);
+        const nsecs_t lockAcquiredTime = now();
         mDispatcherIsAlive.notify_all();
 
+        // Pick up the whole burst of motions that were notified since the last iteration.
+        drainNotifiedMotionsLocked();
+
         // Run a dispatch loop if there are no pending commands.
         // The dispatch loop might enqueue commands to run afterwards.
         if (!haveCommandsLocked()) {
@@ -1025,6 +1035,7 @@ void InputDispatcher::dispatchOnce() {
         if (nextWakeupTime == LLONG_MAX) {
             mDispatcherEnteredIdle.notify_all();
         }
+        mDispatchLockHoldTimes.add(now() - lockAcquiredTime);
     } // release lock
 
     // Wait for callback or timeout or wake.  (make sure we round up, not down)
@@ -1342,6 +1353,26 @@ bool InputDispatcher::shouldPruneInboundQueueLocked(const MotionEntry& motionEnt
 }
 
 bool InputDispatcher::enqueueInboundEventLocked(std::unique_ptr<EventEntry> newEntry) {
+    // The motions that were notified without taking the lock came first.
+    bool needWake = drainNotifiedMotionsLocked();
+    needWake |= pushInboundEventLocked(std::move(newEntry));
+    return needWake;
+}
+
+bool InputDispatcher::drainNotifiedMotionsLocked() {
+    // Clear the flag first: a motion pushed after this either gets drained below, or wakes the
+    // looper again.
+    mNotifiedMotionsWakePending = false;
+    bool needWake = false;
+    while (std::optional<NotifiedMotion> motion = mNotifiedMotions.pop()) {
+        const uint32_t policyFlags =
+                passOngoingGestureToUserLocked(motion->args, motion->policyFlags);
+        needWake |= pushInboundEventLocked(createMotionEntryLocked(motion->args, policyFlags));
+    }
+    return needWake;
+}
+
+bool InputDispatcher::pushInboundEventLocked(std::unique_ptr<EventEntry> newEntry) {
     bool needWake = mInboundQueue.empty();
     mInboundQueue.push_back(std::move(newEntry));
     const EventEntry& entry = *(mInboundQueue.back());
@@ -1434,7 +1465,8 @@ sp<WindowInfoHandle> InputDispatcher::findTouchedWindowAtLocked(ui::LogicalDispl
                                                                 bool ignoreDragWindow) const {
     // Traverse windows from front to back to find touched window.
     const auto& windowHandles = getWindowHandlesLocked(displayId);
-    for (const sp<WindowInfoHandle>& windowHandle : windowHandles) {
+    for (size_t i : getWindowHitIndexLocked(displayId).candidatesAt(x, y)) {
+        const sp<WindowInfoHandle>& windowHandle = windowHandles[i];
         if (ignoreDragWindow && haveSameToken(windowHandle, mDragState->dragWindow)) {
             continue;
         }
@@ -1481,7 +1513,8 @@ std::vector<sp<WindowInfoHandle>> InputDispatcher::findTouchedSpyWindowsAtLocked
     // Traverse windows from front to back and gather the touched spy windows.
     std::vector<sp<WindowInfoHandle>> spyWindows;
     const auto& windowHandles = getWindowHandlesLocked(displayId);
-    for (const sp<WindowInfoHandle>& windowHandle : windowHandles) {
+    for (size_t i : getWindowHitIndexLocked(displayId).candidatesAt(x, y)) {
+        const sp<WindowInfoHandle>& windowHandle = windowHandles[i];
         const WindowInfo& info = *windowHandle->getInfo();
         if (!windowAcceptsTouchAt(info, displayId, x, y, isStylus, getTransformLocked(displayId))) {
             // Generally, we would skip any pointer that's outside of the window. However, if the
@@ -1610,6 +1643,8 @@ void InputDispatcher::postCommandLocked(Command&& command) {
 }
 
 void InputDispatcher::drainInboundQueueLocked() {
+    // Drop the motions that are still waiting to be enqueued too.
+    drainNotifiedMotionsLocked();
     while (!mInboundQueue.empty()) {
         std::shared_ptr<const EventEntry> entry = mInboundQueue.front();
         mInboundQueue.pop_front();
@@ -1900,11 +1935,19 @@ bool InputDispatcher::dispatchKeyLocked(nsecs_t currentTime, std::shared_ptr<con
             sp<IBinder> focusedWindowToken =
                     mFocusResolver.getFocusedWindowToken(getTargetDisplayId(*entry));
 
-            auto command = [this, focusedWindowToken, entry]() REQUIRES(mLock) {
-                doInterceptKeyBeforeDispatchingCommand(focusedWindowToken, *entry);
-            };
-            postCommandLocked(std::move(command));
-            return false; // wait for the command to run
+            const std::optional<InterceptKeyCacheKey> cacheKey =
+                    getInterceptKeyCacheKey(focusedWindowToken, *entry);
+            if (mInterceptKeyCacheEnabled && cacheKey && mInterceptKeyCache.count(*cacheKey)) {
+                // The policy let this key through before, don't wait for it again.
+                mInterceptKeyCacheHits++;
+                entry->interceptKeyResult = KeyEntry::InterceptKeyResult::CONTINUE;
+            } else {
+                auto command = [this, focusedWindowToken, entry]() REQUIRES(mLock) {
+                    doInterceptKeyBeforeDispatchingCommand(focusedWindowToken, *entry);
+                };
+                postCommandLocked(std::move(command));
+                return false; // wait for the command to run
+            }
         } else {
             entry->interceptKeyResult = KeyEntry::InterceptKeyResult::CONTINUE;
         }
@@ -3141,26 +3184,23 @@ InputDispatcher::TouchOcclusionInfo InputDispatcher::computeTouchOcclusionInfoLo
     const WindowInfo* windowInfo = windowHandle->getInfo();
     ui::LogicalDisplayId displayId = windowInfo->displayId;
     const std::vector<sp<WindowInfoHandle>>& windowHandles = getWindowHandlesLocked(displayId);
+    const ui::Transform displayTransform = getTransformLocked(displayId);
     TouchOcclusionInfo info;
     info.hasBlockingOcclusion = false;
     info.obscuringOpacity = 0;
     info.obscuringUid = gui::Uid::INVALID;
     std::map<gui::Uid, float> opacityByUid;
-    for (const sp<WindowInfoHandle>& otherHandle : windowHandles) {
-        if (windowHandle == otherHandle) {
-            break; // All future windows are below us. Exit early.
-        }
-        const WindowInfo* otherInfo = otherHandle->getInfo();
-        if (canBeObscuredBy(windowHandle, otherHandle) &&
-            windowOccludesTouchAt(*otherInfo, displayId, x, y, getTransformLocked(displayId)) &&
-            !haveSameApplicationToken(windowInfo, otherInfo)) {
+    std::vector<size_t> uncachedObscuringWindows;
+    for (size_t i : getObscuringWindowsLocked(windowHandle, uncachedObscuringWindows)) {
+        const WindowInfo* otherInfo = windowHandles[i]->getInfo();
+        if (windowOccludesTouchAt(*otherInfo, displayId, x, y, displayTransform)) {
             if (DEBUG_TOUCH_OCCLUSION) {
                 info.debugInfo.push_back(
                         dumpWindowForTouchOcclusion(otherInfo, /*isTouchedWindow=*/false));
             }
-            // canBeObscuredBy() has returned true above, which means this window is untrusted, so
-            // we perform the checks below to see if the touch can be propagated or not based on the
-            // window's touch occlusion mode
+            // canBeObscuredBy() has returned true in getObscuringWindowsLocked(), which means this
+            // window is untrusted, so we perform the checks below to see if the touch can be
+            // propagated or not based on the window's touch occlusion mode
             if (otherInfo->touchOcclusionMode == TouchOcclusionMode::BLOCK_UNTRUSTED) {
                 info.hasBlockingOcclusion = true;
                 info.obscuringUid = otherInfo->ownerUid;
@@ -3189,6 +3229,40 @@ InputDispatcher::TouchOcclusionInfo InputDispatcher::computeTouchOcclusionInfoLo
     return info;
 }
 
+const std::vector<size_t>& InputDispatcher::getObscuringWindowsLocked(
+        const sp<WindowInfoHandle>& windowHandle, std::vector<size_t>& uncached) const {
+    const WindowInfo* windowInfo = windowHandle->getInfo();
+    const std::vector<sp<WindowInfoHandle>>& windowHandles =
+            getWindowHandlesLocked(windowInfo->displayId);
+    const size_t windowIndex =
+            getWindowHitIndexLocked(windowInfo->displayId).indexOf(windowHandle);
+    // Only windows of the display are cached, the others could be destroyed while in the cache.
+    const bool cacheable = windowIndex < windowHandles.size();
+    if (cacheable) {
+        auto& obscuringWindows = mObscuringWindowsByDisplay[windowInfo->displayId];
+        if (const auto it = obscuringWindows.find(windowHandle.get());
+            it != obscuringWindows.end()) {
+            return it->second;
+        }
+    }
+
+    std::vector<size_t> result;
+    for (size_t i = 0; i < windowIndex; i++) {
+        const sp<WindowInfoHandle>& otherHandle = windowHandles[i];
+        if (canBeObscuredBy(windowHandle, otherHandle) &&
+            !haveSameApplicationToken(windowInfo, otherHandle->getInfo())) {
+            result.push_back(i);
+        }
+    }
+    if (!cacheable) {
+        uncached = std::move(result);
+        return uncached;
+    }
+    return mObscuringWindowsByDisplay[windowInfo->displayId]
+            .emplace(windowHandle.get(), std::move(result))
+            .first->second;
+}
+
 std::string InputDispatcher::dumpWindowForTouchOcclusion(const WindowInfo* info,
                                                          bool isTouchedWindow) const {
     return StringPrintf(INDENT2 "* %spackage=%s/%s, id=%" PRId32 ", mode=%s, alpha=%.2f, "
@@ -3225,10 +3299,13 @@ bool InputDispatcher::isWindowObscuredAtPointLocked(const sp<WindowInfoHandle>&
                                                     float x, float y) const {
     ui::LogicalDisplayId displayId = windowHandle->getInfo()->displayId;
     const std::vector<sp<WindowInfoHandle>>& windowHandles = getWindowHandlesLocked(displayId);
-    for (const sp<WindowInfoHandle>& otherHandle : windowHandles) {
-        if (windowHandle == otherHandle) {
+    const WindowHitIndex& hitIndex = getWindowHitIndexLocked(displayId);
+    const size_t windowIndex = hitIndex.indexOf(windowHandle);
+    for (size_t i : hitIndex.candidatesAt(x, y)) {
+        if (i >= windowIndex) {
             break; // All future windows are below us. Exit early.
         }
+        const sp<WindowInfoHandle>& otherHandle = windowHandles[i];
         const WindowInfo* otherInfo = otherHandle->getInfo();
         if (canBeObscuredBy(windowHandle, otherHandle) &&
             windowOccludesTouchAt(*otherInfo, displayId, x, y, getTransformLocked(displayId))) {
@@ -3509,6 +3586,13 @@ void InputDispatcher::enqueueDispatchEntryLocked(const std::shared_ptr<Connectio
                 if (dispatchEntry->targetFlags.test(InputTarget::Flags::NO_FOCUS_CHANGE)) {
                     resolvedFlags |= AMOTION_EVENT_FLAG_NO_FOCUS_CHANGE;
                 }
+                if (inputTarget.windowHandle != nullptr &&
+                    inputTarget.windowHandle->getInfo()->inputConfig.test(
+                            WindowInfo::InputConfig::LOW_LATENCY_INPUT)) {
+                    // The window wants each sample as soon as possible, so tell the consumer not
+                    // to hold this event back until the next frame.
+                    resolvedFlags |= AMOTION_EVENT_PRIVATE_FLAG_UNBATCHED;
+                }
 
                 dispatchEntry->resolvedFlags = resolvedFlags;
                 if (resolvedAction != motionEntry.action) {
@@ -3790,11 +3874,18 @@ void InputDispatcher::startDispatchCycleLocked(nsecs_t currentTime,
         ALOGD("channel '%s' ~ startDispatchCycle", connection->getInputChannelName().c_str());
     }
 
+    // The timeout only depends on the connection, but looking it up scans the windows of all the
+    // displays, so only do it once per cycle.
+    std::optional<std::chrono::nanoseconds> timeout;
+    // The queue lengths are traced once the cycle is over, rather than for each event.
+    bool published = false;
     while (connection->status == Connection::Status::NORMAL && !connection->outboundQueue.empty()) {
         std::unique_ptr<DispatchEntry>& dispatchEntry = connection->outboundQueue.front();
         dispatchEntry->deliveryTime = currentTime;
-        const std::chrono::nanoseconds timeout = getDispatchingTimeoutLocked(connection);
-        dispatchEntry->timeoutTime = currentTime + timeout.count();
+        if (!timeout) {
+            timeout = getDispatchingTimeoutLocked(connection);
+        }
+        dispatchEntry->timeoutTime = currentTime + timeout->count();
 
         // Publish the event.
         status_t status;
@@ -3914,17 +4005,21 @@ void InputDispatcher::startDispatchCycleLocked(nsecs_t currentTime,
                       status);
                 abortBrokenDispatchCycleLocked(currentTime, connection, /*notify=*/true);
             }
-            return;
+            break;
         }
 
         // Re-enqueue the event on the wait queue.
         const nsecs_t timeoutTime = dispatchEntry->timeoutTime;
         connection->waitQueue.emplace_back(std::move(dispatchEntry));
         connection->outboundQueue.erase(connection->outboundQueue.begin());
-        traceOutboundQueueLength(*connection);
         if (connection->responsive) {
             mAnrTracker.insert(timeoutTime, connection->getToken());
         }
+        published = true;
+    }
+
+    if (published) {
+        traceOutboundQueueLength(*connection);
         traceWaitQueueLength(*connection);
     }
 }
@@ -4593,21 +4688,26 @@ void InputDispatcher::notifyMotion(const NotifyMotionArgs& args) {
               std::to_string(t.duration().count()).c_str());
     }
 
+    // Unless the input filter has to see the event first, hand it over without taking the lock, so
+    // that the reader never waits for the dispatcher. The looper is only woken up for the first
+    // motion of a burst, and the dispatcher enqueues the whole burst when it wakes up.
+    std::thread::id notifyMotionThread{};
+    const std::thread::id thisThread = std::this_thread::get_id();
+    const bool isNotifyMotionThread =
+            mNotifyMotionThread.compare_exchange_strong(notifyMotionThread, thisThread) ||
+            notifyMotionThread == thisThread;
+    if (isNotifyMotionThread && !mInputFilterEnabledForNotify &&
+        mNotifiedMotions.push(NotifiedMotion{args, policyFlags})) {
+        if (!mNotifiedMotionsWakePending.exchange(true)) {
+            mLooper->wake();
+        }
+        return;
+    }
+
     bool needWake = false;
     { // acquire lock
         mLock.lock();
-        if (!(policyFlags & POLICY_FLAG_PASS_TO_USER)) {
-            // Set the flag anyway if we already have an ongoing gesture. That would allow us to
-            // complete the processing of the current stroke.
-            const auto touchStateIt = mTouchStatesByDisplay.find(args.displayId);
-            if (touchStateIt != mTouchStatesByDisplay.end()) {
-                const TouchState& touchState = touchStateIt->second;
-                if (touchState.hasTouchingPointers(args.deviceId) ||
-                    touchState.hasHoveringPointers(args.deviceId)) {
-                    policyFlags |= POLICY_FLAG_PASS_TO_USER;
-                }
-            }
-        }
+        policyFlags = passOngoingGestureToUserLocked(args, policyFlags);
 
         if (shouldSendMotionToInputFilterLocked(args)) {
             ui::Transform displayTransform;
@@ -4635,28 +4735,7 @@ void InputDispatcher::notifyMotion(const NotifyMotionArgs& args) {
         }
 
         // Just enqueue a new motion event.
-        std::unique_ptr<MotionEntry> newEntry =
-                std::make_unique<MotionEntry>(args.id, /*injectionState=*/nullptr, args.eventTime,
-                                              args.deviceId, args.source, args.displayId,
-                                              policyFlags, args.action, args.actionButton,
-                                              args.flags, args.metaState, args.buttonState,
-                                              args.classification, args.edgeFlags, args.xPrecision,
-                                              args.yPrecision, args.xCursorPosition,
-                                              args.yCursorPosition, args.downTime,
-                                              args.pointerProperties, args.pointerCoords);
-        if (mTracer) {
-            newEntry->traceTracker = mTracer->traceInboundEvent(*newEntry);
-        }
-
-        if (args.id != android::os::IInputConstants::INVALID_INPUT_EVENT_ID &&
-            IdGenerator::getSource(args.id) == IdGenerator::Source::INPUT_READER &&
-            !mInputFilterEnabled) {
-            std::set<InputDeviceUsageSource> sources = getUsageSourcesForMotionArgs(args);
-            mLatencyTracker.trackListener(args.id, args.eventTime, args.readTime, args.deviceId,
-                                          sources, args.action, InputEventType::MOTION);
-        }
-
-        needWake = enqueueInboundEventLocked(std::move(newEntry));
+        needWake = enqueueInboundEventLocked(createMotionEntryLocked(args, policyFlags));
         mLock.unlock();
     } // release lock
 
@@ -4665,6 +4744,48 @@ void InputDispatcher::notifyMotion(const NotifyMotionArgs& args) {
     }
 }
 
+uint32_t InputDispatcher::passOngoingGestureToUserLocked(const NotifyMotionArgs& args,
+                                                         uint32_t policyFlags) const {
+    if (!(policyFlags & POLICY_FLAG_PASS_TO_USER)) {
+        // Set the flag anyway if we already have an ongoing gesture. That would allow us to
+        // complete the processing of the current stroke.
+        const auto touchStateIt = mTouchStatesByDisplay.find(args.displayId);
+        if (touchStateIt != mTouchStatesByDisplay.end()) {
+            const TouchState& touchState = touchStateIt->second;
+            if (touchState.hasTouchingPointers(args.deviceId) ||
+                touchState.hasHoveringPointers(args.deviceId)) {
+                policyFlags |= POLICY_FLAG_PASS_TO_USER;
+            }
+        }
+    }
+    return policyFlags;
+}
+
+std::unique_ptr<MotionEntry> InputDispatcher::createMotionEntryLocked(const NotifyMotionArgs& args,
+                                                                      uint32_t policyFlags) {
+    std::unique_ptr<MotionEntry> newEntry =
+            std::make_unique<MotionEntry>(args.id, /*injectionState=*/nullptr, args.eventTime,
+                                          args.deviceId, args.source, args.displayId, policyFlags,
+                                          args.action, args.actionButton, args.flags,
+                                          args.metaState, args.buttonState, args.classification,
+                                          args.edgeFlags, args.xPrecision, args.yPrecision,
+                                          args.xCursorPosition, args.yCursorPosition,
+                                          args.downTime, args.pointerProperties,
+                                          args.pointerCoords);
+    if (mTracer) {
+        newEntry->traceTracker = mTracer->traceInboundEvent(*newEntry);
+    }
+
+    if (args.id != android::os::IInputConstants::INVALID_INPUT_EVENT_ID &&
+        IdGenerator::getSource(args.id) == IdGenerator::Source::INPUT_READER &&
+        !mInputFilterEnabled) {
+        std::set<InputDeviceUsageSource> sources = getUsageSourcesForMotionArgs(args);
+        mLatencyTracker.trackListener(args.id, args.eventTime, args.readTime, args.deviceId,
+                                      sources, args.action, InputEventType::MOTION);
+    }
+    return newEntry;
+}
+
 void InputDispatcher::notifySensor(const NotifySensorArgs& args) {
     if (debugInboundEventDetails()) {
         ALOGD("notifySensor - id=%" PRIx32 " eventTime=%" PRId64 ", deviceId=%d, source=0x%x, "
@@ -5150,6 +5271,13 @@ const std::vector<sp<WindowInfoHandle>>& InputDispatcher::getWindowHandlesLocked
     return it != mWindowHandlesByDisplay.end() ? it->second : EMPTY_WINDOW_HANDLES;
 }
 
+const WindowHitIndex& InputDispatcher::getWindowHitIndexLocked(
+        ui::LogicalDisplayId displayId) const {
+    static const WindowHitIndex EMPTY_WINDOW_HIT_INDEX;
+    auto it = mWindowHitIndexByDisplay.find(displayId);
+    return it != mWindowHitIndexByDisplay.end() ? it->second : EMPTY_WINDOW_HIT_INDEX;
+}
+
 sp<WindowInfoHandle> InputDispatcher::getWindowHandleLocked(
         const sp<IBinder>& windowHandleToken, std::optional<ui::LogicalDisplayId> displayId) const {
     if (windowHandleToken == nullptr) {
@@ -5276,6 +5404,8 @@ void InputDispatcher::updateWindowHandlesForDisplayLocked(
     if (windowInfoHandles.empty()) {
         // Remove all handles on a display if there are no windows left.
         mWindowHandlesByDisplay.erase(displayId);
+        mWindowHitIndexByDisplay.erase(displayId);
+        mObscuringWindowsByDisplay.erase(displayId);
         return;
     }
 
@@ -5322,6 +5452,8 @@ void InputDispatcher::updateWindowHandlesForDisplayLocked(
 
     // Insert or replace
     mWindowHandlesByDisplay[displayId] = newHandles;
+    mWindowHitIndexByDisplay[displayId] = WindowHitIndex(newHandles, getTransformLocked(displayId));
+    mObscuringWindowsByDisplay.erase(displayId);
 }
 
 /**
@@ -5619,6 +5751,7 @@ void InputDispatcher::setInputFilterEnabled(bool enabled) {
         }
 
         mInputFilterEnabled = enabled;
+        mInputFilterEnabledForNotify = enabled;
         resetAndDropEverythingLocked("input filter is being enabled or disabled");
     } // release lock
 
@@ -6090,6 +6223,15 @@ void InputDispatcher::dumpDispatchStateLocked(std::string& dump) const {
                          ns2ms(mConfig.keyRepeatTimeout));
     dump += mLatencyTracker.dump(INDENT2);
     dump += mLatencyAggregator.dump(INDENT2);
+    dump += StringPrintf(INDENT "DispatchLockHoldTimes: count=%" PRIu32 ", p50=%" PRId64
+                                "us, p99=%" PRId64 "us\n",
+                         mDispatchLockHoldTimes.getCount(),
+                         ns2us(mDispatchLockHoldTimes.getPercentile(50)),
+                         ns2us(mDispatchLockHoldTimes.getPercentile(99)));
+    dump += INDENT "EntryPool: " + EntryPool::getInstance().dump() + "\n";
+    dump += StringPrintf(INDENT "InterceptKeyCache: %s, size=%zu, hits=%" PRIu64 "\n",
+                         mInterceptKeyCacheEnabled ? "enabled" : "disabled",
+                         mInterceptKeyCache.size(), mInterceptKeyCacheHits);
     dump += INDENT "InputTracer: ";
     dump += mTracer == nullptr ? "Disabled" : "Enabled";
 }
@@ -6421,8 +6563,11 @@ void InputDispatcher::doDispatchCycleFinishedCommand(nsecs_t finishTime,
                   ns2ms(eventDuration), dispatchEntry.eventEntry->getDescription().c_str());
         }
         if (shouldReportFinishedEvent(dispatchEntry, *connection)) {
+            const bool unbatched =
+                    (dispatchEntry.resolvedFlags & AMOTION_EVENT_PRIVATE_FLAG_UNBATCHED) != 0;
             mLatencyTracker.trackFinishedEvent(dispatchEntry.eventEntry->id, connection->getToken(),
-                                               dispatchEntry.deliveryTime, consumeTime, finishTime);
+                                               dispatchEntry.deliveryTime, consumeTime, finishTime,
+                                               unbatched);
         }
 
         if (dispatchEntry.eventEntry->type == EventEntry::Type::KEY) {
@@ -6567,6 +6712,7 @@ void InputDispatcher::updateLastAnrStateLocked(const std::string& windowLabel,
 void InputDispatcher::doInterceptKeyBeforeDispatchingCommand(const sp<IBinder>& focusedWindowToken,
                                                              const KeyEntry& entry) {
     const KeyEvent event = createKeyEvent(entry);
+    const uint32_t cacheGeneration = mInterceptKeyCacheGeneration;
     nsecs_t delay = 0;
     { // release lock
         scoped_unlock unlock(mLock);
@@ -6582,12 +6728,32 @@ void InputDispatcher::doInterceptKeyBeforeDispatchingCommand(const sp<IBinder>&
         entry.interceptKeyResult = KeyEntry::InterceptKeyResult::SKIP;
     } else if (delay == 0) {
         entry.interceptKeyResult = KeyEntry::InterceptKeyResult::CONTINUE;
+        const std::optional<InterceptKeyCacheKey> cacheKey =
+                getInterceptKeyCacheKey(focusedWindowToken, entry);
+        if (mInterceptKeyCacheEnabled && cacheKey &&
+            cacheGeneration == mInterceptKeyCacheGeneration) {
+            if (mInterceptKeyCache.size() >= MAX_INTERCEPT_KEY_CACHE_SIZE) {
+                mInterceptKeyCache.clear();
+            }
+            mInterceptKeyCache.insert(*cacheKey);
+        }
     } else {
         entry.interceptKeyResult = KeyEntry::InterceptKeyResult::TRY_AGAIN_LATER;
         entry.interceptKeyWakeupTime = now() + delay;
     }
 }
 
+std::optional<InputDispatcher::InterceptKeyCacheKey> InputDispatcher::getInterceptKeyCacheKey(
+        const sp<IBinder>& focusedWindowToken, const KeyEntry& entry) {
+    // The policy handles long presses and injected keys specially, always ask it about those.
+    if (entry.repeatCount != 0 || entry.isInjected() ||
+        (entry.flags & AKEY_EVENT_FLAG_LONG_PRESS)) {
+        return std::nullopt;
+    }
+    return InterceptKeyCacheKey{focusedWindowToken, entry.keyCode, entry.metaState, entry.action,
+                                entry.policyFlags};
+}
+
 void InputDispatcher::sendWindowUnresponsiveCommandLocked(const sp<IBinder>& token,
                                                           std::optional<gui::Pid> pid,
                                                           std::string reason) {
@@ -6903,6 +7069,11 @@ void InputDispatcher::monitor() {
  * this method can be safely called from any thread, as long as you've ensured that
  * the work you are interested in completing has already been queued.
  */
+LatencyHistogram InputDispatcher::getDispatchLockHoldTimes() const {
+    std::scoped_lock _l(mLock);
+    return mDispatchLockHoldTimes;
+}
+
 bool InputDispatcher::waitForIdle() const {
     /**
      * Timeout should represent the longest possible time that a device might spend processing
@@ -7277,4 +7448,17 @@ void InputDispatcher::setInputMethodConnectionIsActive(bool isActive) {
     }
 }
 
+void InputDispatcher::setInterceptKeyCacheEnabled(bool enabled) {
+    std::scoped_lock _l(mLock);
+    mInterceptKeyCacheEnabled = enabled;
+    mInterceptKeyCache.clear();
+    mInterceptKeyCacheGeneration++;
+}
+
+void InputDispatcher::invalidateInterceptKeyCache() {
+    std::scoped_lock _l(mLock);
+    mInterceptKeyCache.clear();
+    mInterceptKeyCacheGeneration++;
+}
+
 } // namespace android::inputdispatcher
@@ -28,10 +28,13 @@
 #include "InputTarget.h"
 #include "InputThread.h"
 #include "LatencyAggregator.h"
+#include "LatencyHistogram.h"
 #include "LatencyTracker.h"
 #include "Monitor.h"
+#include "SpscQueue.h"
 #include "TouchState.h"
 #include "TouchedWindow.h"
+#include "WindowHitIndex.h"
 #include "trace/InputTracerInterface.h"
 #include "trace/InputTracingBackendInterface.h"
 
@@ -48,10 +51,14 @@
 #include <utils/Looper.h>
 #include <utils/Timers.h>
 #include <utils/threads.h>
+#include <atomic>
 #include <bitset>
 #include <condition_variable>
 #include <deque>
 #include <optional>
+#include <set>
+#include <thread>
+#include <tuple>
 #include <unordered_map>
 #include <unordered_set>
 
@@ -161,6 +168,13 @@ public:
 
     void setInputMethodConnectionIsActive(bool isActive) override;
 
+    void setInterceptKeyCacheEnabled(bool enabled) override;
+    void invalidateInterceptKeyCache() override;
+
+    // Public so that benchmarks can report how long each iteration of the dispatch loop holds
+    // mLock.
+    LatencyHistogram getDispatchLockHoldTimes() const;
+
 private:
     enum class DropReason {
         NOT_DROPPED,
@@ -190,6 +204,23 @@ private:
     std::deque<std::shared_ptr<const EventEntry>> mInboundQueue GUARDED_BY(mLock);
     std::deque<std::shared_ptr<const EventEntry>> mRecentQueue GUARDED_BY(mLock);
 
+    // Motions that were notified without taking mLock, so that the reader never waits for the
+    // dispatcher. The next thread to take mLock moves them to mInboundQueue, in order, before
+    // anything else is enqueued.
+    struct NotifiedMotion {
+        NotifyMotionArgs args;
+        uint32_t policyFlags;
+    };
+    SpscQueue<NotifiedMotion> mNotifiedMotions;
+    // Whether the looper was woken up since mNotifiedMotions was last drained, so that a burst of
+    // motions only wakes the dispatcher once.
+    std::atomic<bool> mNotifiedMotionsWakePending{false};
+    // The thread that may push to mNotifiedMotions. This is the first thread to notify a motion.
+    // Motions notified by any other thread are enqueued under mLock.
+    std::atomic<std::thread::id> mNotifyMotionThread{};
+    // A copy of mInputFilterEnabled, for the checks that are made without taking mLock.
+    std::atomic<bool> mInputFilterEnabledForNotify{false};
+
     // A command entry captures state and behavior for an action to be performed in the
     // dispatch loop after the initial processing has taken place.  It is essentially
     // a kind of continuation used to postpone sensitive policy interactions to a point
@@ -230,6 +261,17 @@ private:
 
     // Enqueues an inbound event.  Returns true if mLooper->wake() should be called.
     bool enqueueInboundEventLocked(std::unique_ptr<EventEntry> entry) REQUIRES(mLock);
+    bool pushInboundEventLocked(std::unique_ptr<EventEntry> entry) REQUIRES(mLock);
+
+    // Moves the motions in mNotifiedMotions to the inbound queue. Returns true if mLooper->wake()
+    // should be called.
+    bool drainNotifiedMotionsLocked() REQUIRES(mLock);
+    // Returns the policy flags of a notified motion, with POLICY_FLAG_PASS_TO_USER added if the
+    // motion belongs to a gesture that is already being passed to the user.
+    uint32_t passOngoingGestureToUserLocked(const NotifyMotionArgs& args,
+                                            uint32_t policyFlags) const REQUIRES(mLock);
+    std::unique_ptr<MotionEntry> createMotionEntryLocked(const NotifyMotionArgs& args,
+                                                         uint32_t policyFlags) REQUIRES(mLock);
 
     // Cleans up input state when dropping an inbound event.
     void dropInboundEventLocked(const EventEntry& entry, DropReason dropReason) REQUIRES(mLock);
@@ -317,6 +359,32 @@ private:
     void resetKeyRepeatLocked() REQUIRES(mLock);
     std::shared_ptr<KeyEntry> synthesizeKeyRepeatLocked(nsecs_t currentTime) REQUIRES(mLock);
 
+    // Keys that interceptKeyBeforeDispatching let through, and that can be let through again
+    // without calling the policy.
+    struct InterceptKeyCacheKey {
+        sp<IBinder> focusedWindowToken;
+        int32_t keyCode;
+        int32_t metaState;
+        int32_t action;
+        uint32_t policyFlags;
+
+        bool operator<(const InterceptKeyCacheKey& other) const {
+            return std::tie(focusedWindowToken, keyCode, metaState, action, policyFlags) <
+                    std::tie(other.focusedWindowToken, other.keyCode, other.metaState,
+                             other.action, other.policyFlags);
+        }
+    };
+    static constexpr size_t MAX_INTERCEPT_KEY_CACHE_SIZE = 64;
+    bool mInterceptKeyCacheEnabled GUARDED_BY(mLock) = false;
+    // Incremented on every invalidation, so that a decision the policy made before an
+    // invalidation is not added to the cache after it.
+    uint32_t mInterceptKeyCacheGeneration GUARDED_BY(mLock) = 0;
+    std::set<InterceptKeyCacheKey> mInterceptKeyCache GUARDED_BY(mLock);
+    uint64_t mInterceptKeyCacheHits GUARDED_BY(mLock) = 0;
+
+    static std::optional<InterceptKeyCacheKey> getInterceptKeyCacheKey(
+            const sp<IBinder>& focusedWindowToken, const KeyEntry& entry);
+
     // Deferred command processing.
     bool haveCommandsLocked() const REQUIRES(mLock);
     bool runCommandsLockedInterruptable() REQUIRES(mLock);
@@ -363,6 +431,9 @@ private:
     std::unordered_map<ui::LogicalDisplayId /*displayId*/,
                        std::vector<sp<android::gui::WindowInfoHandle>>>
             mWindowHandlesByDisplay GUARDED_BY(mLock);
+    // Rebuilt with mWindowHandlesByDisplay, to hit test only the windows near a location.
+    std::unordered_map<ui::LogicalDisplayId /*displayId*/, WindowHitIndex> mWindowHitIndexByDisplay
+            GUARDED_BY(mLock);
     std::unordered_map<ui::LogicalDisplayId /*displayId*/, android::gui::DisplayInfo> mDisplayInfos
             GUARDED_BY(mLock);
     void setInputWindowsLocked(
@@ -371,6 +442,9 @@ private:
     // Get a reference to window handles by display, return an empty vector if not found.
     const std::vector<sp<android::gui::WindowInfoHandle>>& getWindowHandlesLocked(
             ui::LogicalDisplayId displayId) const REQUIRES(mLock);
+    // Get the spatial index of the window handles of a display, empty if there are none.
+    const WindowHitIndex& getWindowHitIndexLocked(ui::LogicalDisplayId displayId) const
+            REQUIRES(mLock);
     ui::Transform getTransformLocked(ui::LogicalDisplayId displayId) const REQUIRES(mLock);
 
     sp<android::gui::WindowInfoHandle> getWindowHandleLocked(
@@ -576,6 +650,17 @@ private:
     TouchOcclusionInfo computeTouchOcclusionInfoLocked(
             const sp<android::gui::WindowInfoHandle>& windowHandle, float x, float y) const
             REQUIRES(mLock);
+    // Positions in getWindowHandlesLocked() of the windows above the given one which obscure it
+    // wherever they overlap it, in z-order.
+    const std::vector<size_t>& getObscuringWindowsLocked(
+            const sp<android::gui::WindowInfoHandle>& windowHandle,
+            std::vector<size_t>& uncached) const REQUIRES(mLock);
+    // Cache of getObscuringWindowsLocked() for the windows of each display, filled as touched
+    // windows are checked, and cleared whenever the windows of the display change.
+    mutable std::unordered_map<
+            ui::LogicalDisplayId /*displayId*/,
+            std::unordered_map<const android::gui::WindowInfoHandle*, std::vector<size_t>>>
+            mObscuringWindowsByDisplay GUARDED_BY(mLock);
     bool isTouchTrustedLocked(const TouchOcclusionInfo& occlusionInfo) const REQUIRES(mLock);
     bool isWindowObscuredAtPointLocked(const sp<android::gui::WindowInfoHandle>& windowHandle,
                                        float x, float y) const REQUIRES(mLock);
@@ -699,6 +784,7 @@ private:
     // Statistics gathering.
     LatencyAggregator mLatencyAggregator GUARDED_BY(mLock);
     LatencyTracker mLatencyTracker GUARDED_BY(mLock);
+    LatencyHistogram mDispatchLockHoldTimes GUARDED_BY(mLock);
     void traceInboundQueueLengthLocked() REQUIRES(mLock);
     void traceOutboundQueueLength(const Connection& connection);
     void traceWaitQueueLength(const Connection& connection);
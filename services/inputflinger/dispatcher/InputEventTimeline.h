@@ -53,6 +53,11 @@ struct ConnectionTimeline {
      * True if all contained timestamps are valid, false otherwise.
      */
     bool isComplete() const;
+    /**
+     * True if the dispatching-related times are valid. This may be true for timelines that are
+     * not complete, when the app did not produce a frame for the event.
+     */
+    bool hasDispatchTimeline() const { return mHasDispatchTimeline; }
     /**
      * Set the dispatching-related times. Return true if the operation succeeded, false if the
      * dispatching times have already been set. If this function returns false, it likely indicates
@@ -20,6 +20,7 @@
 #include <inttypes.h>
 
 #include <android-base/stringprintf.h>
+#include <ftl/enum.h>
 #include <input/Input.h>
 #include <log/log.h>
 #include <server_configurable_flags/get_flags.h>
@@ -42,6 +43,16 @@ static inline int64_t ns2hus(nsecs_t nanos) {
 // The value here has been determined empirically.
 static constexpr size_t MAX_EVENTS_FOR_STATISTICS = 20000;
 
+// Names of the latency stages, indexed by SketchIndex
+static constexpr std::array<const char*, android::inputdispatcher::SketchIndex::SIZE>
+        SKETCH_NAMES = {"EVENT_TO_READ",
+                        "READ_TO_DELIVER",
+                        "DELIVER_TO_CONSUME",
+                        "CONSUME_TO_FINISH",
+                        "CONSUME_TO_GPU_COMPLETE",
+                        "GPU_COMPLETE_TO_PRESENT",
+                        "END_TO_END"};
+
 // Category (=namespace) name for the input settings that are applied at boot time
 static const char* INPUT_NATIVE_BOOT = "input_native_boot";
 // Feature flag name for the threshold of end-to-end touch latency that would trigger
@@ -127,6 +138,8 @@ void LatencyAggregator::processTimeline(const InputEventTimeline& timeline) {
 
 void LatencyAggregator::processStatistics(const InputEventTimeline& timeline) {
     std::scoped_lock lock(mLock);
+    processStreamingStatistics(timeline);
+
     // Before we do any processing, check that we have not yet exceeded MAX_SIZE
     if (mNumSketchEventsProcessed >= MAX_EVENTS_FOR_STATISTICS) {
         return;
@@ -169,6 +182,36 @@ void LatencyAggregator::processStatistics(const InputEventTimeline& timeline) {
     }
 }
 
+void LatencyAggregator::processStreamingStatistics(const InputEventTimeline& timeline) {
+    for (const InputDeviceUsageSource source : timeline.sources) {
+        std::array<LatencyHistogram, SketchIndex::SIZE>& histograms = mStreamingHistograms[source];
+        histograms[SketchIndex::EVENT_TO_READ].add(timeline.readTime - timeline.eventTime);
+
+        for (const auto& [_, connectionTimeline] : timeline.connectionTimelines) {
+            if (!connectionTimeline.hasDispatchTimeline()) {
+                continue;
+            }
+            histograms[SketchIndex::READ_TO_DELIVER].add(connectionTimeline.deliveryTime -
+                                                         timeline.readTime);
+            histograms[SketchIndex::DELIVER_TO_CONSUME].add(connectionTimeline.consumeTime -
+                                                            connectionTimeline.deliveryTime);
+            histograms[SketchIndex::CONSUME_TO_FINISH].add(connectionTimeline.finishTime -
+                                                           connectionTimeline.consumeTime);
+            if (!connectionTimeline.isComplete()) {
+                continue;
+            }
+            const nsecs_t gpuCompletedTime =
+                    connectionTimeline.graphicsTimeline[GraphicsTimeline::GPU_COMPLETED_TIME];
+            const nsecs_t presentTime =
+                    connectionTimeline.graphicsTimeline[GraphicsTimeline::PRESENT_TIME];
+            histograms[SketchIndex::CONSUME_TO_GPU_COMPLETE].add(gpuCompletedTime -
+                                                                 connectionTimeline.consumeTime);
+            histograms[SketchIndex::GPU_COMPLETE_TO_PRESENT].add(presentTime - gpuCompletedTime);
+            histograms[SketchIndex::END_TO_END].add(presentTime - timeline.eventTime);
+        }
+    }
+}
+
 AStatsManager_PullAtomCallbackReturn LatencyAggregator::pullData(AStatsEventList* data) {
     std::scoped_lock lock(mLock);
     std::array<std::unique_ptr<SafeBytesField>, SketchIndex::SIZE> serializedDownData;
@@ -278,7 +321,19 @@ std::string LatencyAggregator::dump(const char* prefix) const {
                              prefix, i, numDown, downBytesKb, i, numMove, moveBytesKb);
     }
 
-    return StringPrintf("%sLatencyAggregator:\n", prefix) + sketchDump +
+    std::string histogramDump = StringPrintf("%s  Latency percentiles:\n", prefix);
+    if (mStreamingHistograms.empty()) {
+        histogramDump += StringPrintf("%s    <none>\n", prefix);
+    }
+    for (const auto& [source, histograms] : mStreamingHistograms) {
+        histogramDump += StringPrintf("%s    %s:\n", prefix, ftl::enum_string(source).c_str());
+        for (size_t i = 0; i < SketchIndex::SIZE; i++) {
+            histogramDump += StringPrintf("%s      %s: %s\n", prefix, SKETCH_NAMES[i],
+                                          histograms[i].dump().c_str());
+        }
+    }
+
+    return StringPrintf("%sLatencyAggregator:\n", prefix) + sketchDump + histogramDump +
             StringPrintf("%s  mNumSketchEventsProcessed=%zu\n", prefix, mNumSketchEventsProcessed) +
             StringPrintf("%s  mLastSlowEventTime=%" PRId64 "\n", prefix, mLastSlowEventTime) +
             StringPrintf("%s  mNumEventsSinceLastSlowEventReport = %zu\n", prefix,
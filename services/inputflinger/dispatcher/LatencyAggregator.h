@@ -21,7 +21,10 @@
 #include <statslog.h>
 #include <utils/Timers.h>
 
+#include <map>
+
 #include "InputEventTimeline.h"
+#include "LatencyHistogram.h"
 
 namespace android::inputdispatcher {
 
@@ -47,7 +50,12 @@ enum SketchIndex : size_t {
 // GraphicsTimeline::PRESENT_TIME
 
 /**
- * Keep sketches of the provided events and report slow events
+ * Keep sketches of the provided events and report slow events.
+ *
+ * The sketches are only exported when statsd pulls them. In addition, the latencies are streamed
+ * into fixed-size histograms per input device usage source, so that their percentiles can be
+ * inspected through dumpsys at any time. Unlike the sketches, the histograms also account for the
+ * stages of timelines that are only partially complete, like events that did not produce a frame.
  */
 class LatencyAggregator final : public InputEventTimelineProcessor {
 public:
@@ -89,6 +97,13 @@ private:
             mMoveSketches GUARDED_BY(mLock);
     // How many events have been processed so far
     size_t mNumSketchEventsProcessed GUARDED_BY(mLock) = 0;
+
+    // ---------- Streaming statistics ----------
+    void processStreamingStatistics(const InputEventTimeline& timeline) REQUIRES(mLock);
+    // There is at most one entry per InputDeviceUsageSource, so the memory used is bounded
+    // regardless of the event rate.
+    std::map<InputDeviceUsageSource, std::array<LatencyHistogram, SketchIndex::SIZE>>
+            mStreamingHistograms GUARDED_BY(mLock);
 };
 
 } // namespace android::inputdispatcher
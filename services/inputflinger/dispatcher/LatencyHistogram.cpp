@@ -0,0 +1,88 @@
+/*
+ * Copyright (C) 2024 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "LatencyHistogram.h"
+
+#include <inttypes.h>
+
+#include <algorithm>
+#include <bit>
+#include <cmath>
+
+#include <android-base/stringprintf.h>
+
+using android::base::StringPrintf;
+
+namespace android::inputdispatcher {
+
+void LatencyHistogram::add(nsecs_t latency) {
+    const uint64_t micros = static_cast<uint64_t>(std::max(ns2us(latency), nsecs_t(0)));
+    mBuckets[getBucketIndex(micros)]++;
+    mCount++;
+    if (mCount < MAX_COUNT) {
+        return;
+    }
+    // Decay the old values, so that the counts never overflow.
+    mCount = 0;
+    for (uint32_t& bucket : mBuckets) {
+        bucket /= 2;
+        mCount += bucket;
+    }
+}
+
+nsecs_t LatencyHistogram::getPercentile(float percentile) const {
+    if (mCount == 0) {
+        return 0;
+    }
+    const uint32_t rank = std::clamp(static_cast<uint32_t>(std::ceil(percentile / 100 * mCount)),
+                                     1u, mCount);
+    uint32_t seen = 0;
+    for (size_t i = 0; i < NUM_BUCKETS; i++) {
+        seen += mBuckets[i];
+        if (seen >= rank) {
+            return us2ns(getBucketUpperBound(i));
+        }
+    }
+    return us2ns(getBucketUpperBound(NUM_BUCKETS - 1));
+}
+
+std::string LatencyHistogram::dump() const {
+    return StringPrintf("count=%" PRIu32 ", p50=%.1fms, p90=%.1fms, p99=%.1fms", mCount,
+                        getPercentile(50) * 1E-6, getPercentile(90) * 1E-6,
+                        getPercentile(99) * 1E-6);
+}
+
+size_t LatencyHistogram::getBucketIndex(uint64_t micros) {
+    micros = std::min(micros, (uint64_t(1) << MAX_VALUE_BITS) - 1);
+    if (micros < SUB_BUCKETS) {
+        return micros;
+    }
+    const size_t msb = std::bit_width(micros) - 1;
+    const size_t shift = msb - SUB_BUCKET_BITS;
+    const size_t subBucket = (micros >> shift) - SUB_BUCKETS;
+    return (shift + 1) * SUB_BUCKETS + subBucket;
+}
+
+uint64_t LatencyHistogram::getBucketUpperBound(size_t index) {
+    if (index < SUB_BUCKETS) {
+        return index;
+    }
+    const size_t shift = index / SUB_BUCKETS - 1;
+    const uint64_t lowerBound = uint64_t(SUB_BUCKETS + index % SUB_BUCKETS) << shift;
+    return lowerBound + (uint64_t(1) << shift) - 1;
+}
+
+} // namespace android::inputdispatcher
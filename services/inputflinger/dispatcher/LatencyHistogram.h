@@ -0,0 +1,69 @@
+/*
+ * Copyright (C) 2024 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include <array>
+#include <cstdint>
+#include <string>
+
+#include <utils/Timers.h>
+
+namespace android::inputdispatcher {
+
+/**
+ * A fixed-size histogram of latencies that can answer percentile queries at any time.
+ *
+ * Values are stored in log-linear buckets: every power of two is split into SUB_BUCKETS equal
+ * buckets, so that percentiles are reported with a relative error of at most 1 / SUB_BUCKETS.
+ * Latencies are tracked with a resolution of 1 microsecond, up to about 1 minute. Larger values
+ * are counted in the last bucket.
+ *
+ * The memory used by the histogram does not depend on the number of values added. Once
+ * MAX_COUNT values have been accumulated, all the buckets are halved, so that older values are
+ * gradually forgotten and the percentiles follow the recent behaviour of the system.
+ */
+class LatencyHistogram {
+public:
+    static constexpr uint32_t MAX_COUNT = 1 << 16;
+
+    void add(nsecs_t latency);
+    /**
+     * Return the latency below which the given percentage of the values fall. The value returned
+     * is the upper bound of the matching bucket. Returns 0 if the histogram is empty.
+     */
+    nsecs_t getPercentile(float percentile) const;
+    uint32_t getCount() const { return mCount; }
+    /**
+     * Print the count and the p50, p90 and p99 latencies, in milliseconds.
+     */
+    std::string dump() const;
+
+private:
+    static constexpr size_t SUB_BUCKET_BITS = 4;
+    static constexpr size_t SUB_BUCKETS = 1 << SUB_BUCKET_BITS;
+    // 2^26 microseconds is a bit over a minute.
+    static constexpr size_t MAX_VALUE_BITS = 26;
+    static constexpr size_t NUM_BUCKETS = (MAX_VALUE_BITS - SUB_BUCKET_BITS + 1) * SUB_BUCKETS;
+
+    static size_t getBucketIndex(uint64_t micros);
+    static uint64_t getBucketUpperBound(size_t index);
+
+    std::array<uint32_t, NUM_BUCKETS> mBuckets{};
+    uint32_t mCount = 0;
+};
+
+} // namespace android::inputdispatcher
@@ -18,6 +18,7 @@
 #include "LatencyTracker.h"
 #include "../InputDeviceMetricsSource.h"
 
+#include <algorithm>
 #include <inttypes.h>
 
 #include <android-base/properties.h>
@@ -42,6 +43,14 @@ const std::chrono::duration ANR_TIMEOUT = std::chrono::milliseconds(
         android::os::IInputConstants::UNMULTIPLIED_DEFAULT_DISPATCHING_TIMEOUT_MILLIS *
         HwTimeoutMultiplier());
 
+/**
+ * The maximum number of events for which we keep a timeline. When more events are tracked, because
+ * the event rate is high or because apps are slow to report their timelines, the oldest ones are
+ * reported right away with the data that is available so far. This bounds the memory used by the
+ * tracker regardless of the event rate.
+ */
+static constexpr size_t MAX_TRACKED_EVENTS = 2000;
+
 static bool isMatureEvent(nsecs_t eventTime, nsecs_t now) {
     std::chrono::duration age = std::chrono::nanoseconds(now) - std::chrono::nanoseconds(eventTime);
     return age > ANR_TIMEOUT;
@@ -138,11 +147,14 @@ void LatencyTracker::trackListener(int32_t inputEventId, nsecs_t eventTime, nsec
                        InputEventTimeline(eventTime, readTime, identifier->vendor,
                                           identifier->product, sources, inputEventActionType));
     mEventTimes.emplace(eventTime, inputEventId);
+    while (mTimelines.size() > MAX_TRACKED_EVENTS) {
+        reportAndPruneOldestRecord();
+    }
 }
 
 void LatencyTracker::trackFinishedEvent(int32_t inputEventId, const sp<IBinder>& connectionToken,
                                         nsecs_t deliveryTime, nsecs_t consumeTime,
-                                        nsecs_t finishTime) {
+                                        nsecs_t finishTime, bool unbatched) {
     const auto it = mTimelines.find(inputEventId);
     if (it == mTimelines.end()) {
         // This could happen if we erased this event when duplicate events were detected. It's
@@ -150,6 +162,10 @@ void LatencyTracker::trackFinishedEvent(int32_t inputEventId, const sp<IBinder>&
         // anything in its process. Just drop the report and move on.
         return;
     }
+    if (consumeTime >= deliveryTime) {
+        DeliveryStats& stats = unbatched ? mUnbatchedStats : mBatchedStats;
+        stats.add(consumeTime - deliveryTime);
+    }
 
     InputEventTimeline& timeline = it->second;
     const auto connectionIt = timeline.connectionTimelines.find(connectionToken);
@@ -205,17 +221,9 @@ void LatencyTracker::trackGraphicsLatency(
  */
 void LatencyTracker::reportAndPruneMatureRecords(nsecs_t newEventTime) {
     while (!mEventTimes.empty()) {
-        const auto& [oldestEventTime, oldestInputEventId] = *mEventTimes.begin();
+        const nsecs_t oldestEventTime = mEventTimes.begin()->first;
         if (isMatureEvent(oldestEventTime, /*now=*/newEventTime)) {
-            // Report and drop this event
-            const auto it = mTimelines.find(oldestInputEventId);
-            LOG_ALWAYS_FATAL_IF(it == mTimelines.end(),
-                                "Event %" PRId32 " is in mEventTimes, but not in mTimelines",
-                                oldestInputEventId);
-            const InputEventTimeline& timeline = it->second;
-            mTimelineProcessor->processTimeline(timeline);
-            mTimelines.erase(it);
-            mEventTimes.erase(mEventTimes.begin());
+            reportAndPruneOldestRecord();
         } else {
             // If the oldest event does not need to be pruned, no events should be pruned.
             return;
@@ -223,10 +231,40 @@ void LatencyTracker::reportAndPruneMatureRecords(nsecs_t newEventTime) {
     }
 }
 
+void LatencyTracker::reportAndPruneOldestRecord() {
+    const int32_t oldestInputEventId = mEventTimes.begin()->second;
+    const auto it = mTimelines.find(oldestInputEventId);
+    LOG_ALWAYS_FATAL_IF(it == mTimelines.end(),
+                        "Event %" PRId32 " is in mEventTimes, but not in mTimelines",
+                        oldestInputEventId);
+    const InputEventTimeline& timeline = it->second;
+    mTimelineProcessor->processTimeline(timeline);
+    mTimelines.erase(it);
+    mEventTimes.erase(mEventTimes.begin());
+}
+
+void LatencyTracker::DeliveryStats::add(nsecs_t deliveryToConsume) {
+    count++;
+    totalDeliveryToConsume += deliveryToConsume;
+    maxDeliveryToConsume = std::max(maxDeliveryToConsume, deliveryToConsume);
+}
+
+std::string LatencyTracker::DeliveryStats::dump() const {
+    if (count == 0) {
+        return "<none>";
+    }
+    return StringPrintf("count=%zu, avg=%.3fms, max=%.3fms", count,
+                        totalDeliveryToConsume / (count * 1E6), maxDeliveryToConsume / 1E6);
+}
+
 std::string LatencyTracker::dump(const char* prefix) const {
     return StringPrintf("%sLatencyTracker:\n", prefix) +
             StringPrintf("%s  mTimelines.size() = %zu\n", prefix, mTimelines.size()) +
-            StringPrintf("%s  mEventTimes.size() = %zu\n", prefix, mEventTimes.size());
+            StringPrintf("%s  mEventTimes.size() = %zu\n", prefix, mEventTimes.size()) +
+            StringPrintf("%s  Delivery to consume, batched: %s\n", prefix,
+                         mBatchedStats.dump().c_str()) +
+            StringPrintf("%s  Delivery to consume, low latency: %s\n", prefix,
+                         mUnbatchedStats.dump().c_str());
 }
 
 void LatencyTracker::setInputDevices(const std::vector<InputDeviceInfo>& inputDevices) {
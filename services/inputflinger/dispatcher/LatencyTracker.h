@@ -55,8 +55,14 @@ public:
     void trackListener(int32_t inputEventId, nsecs_t eventTime, nsecs_t readTime, DeviceId deviceId,
                        const std::set<InputDeviceUsageSource>& sources, int32_t inputEventAction,
                        InputEventType inputEventType);
+    /**
+     * Record the dispatch timeline of an event for the given connection. 'unbatched' should be set
+     * when the event was sent to a low-latency window, so that the time the event spent waiting
+     * in the app before being consumed is accounted separately from the batched events.
+     */
     void trackFinishedEvent(int32_t inputEventId, const sp<IBinder>& connectionToken,
-                            nsecs_t deliveryTime, nsecs_t consumeTime, nsecs_t finishTime);
+                            nsecs_t deliveryTime, nsecs_t consumeTime, nsecs_t finishTime,
+                            bool unbatched = false);
     void trackGraphicsLatency(int32_t inputEventId, const sp<IBinder>& connectionToken,
                               std::array<nsecs_t, GraphicsTimeline::SIZE> timeline);
 
@@ -81,9 +87,26 @@ private:
      */
     std::multimap<nsecs_t /*eventTime*/, int32_t /*inputEventId*/> mEventTimes;
 
+    /**
+     * Summary of the time between the delivery of an event to the app and its consumption, for
+     * one delivery mode.
+     */
+    struct DeliveryStats {
+        size_t count = 0;
+        nsecs_t totalDeliveryToConsume = 0;
+        nsecs_t maxDeliveryToConsume = 0;
+
+        void add(nsecs_t deliveryToConsume);
+        std::string dump() const;
+    };
+    DeliveryStats mBatchedStats;
+    DeliveryStats mUnbatchedStats;
+
     InputEventTimelineProcessor* mTimelineProcessor;
     std::vector<InputDeviceInfo> mInputDevices;
     void reportAndPruneMatureRecords(nsecs_t newEventTime);
+    // Report the timeline of the oldest tracked event, even if it is incomplete, and drop it.
+    void reportAndPruneOldestRecord();
 };
 
 } // namespace android::inputdispatcher
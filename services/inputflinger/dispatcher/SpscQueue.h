@@ -0,0 +1,84 @@
+/*
+ * Copyright (C) 2024 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <optional>
+#include <utility>
+#include <vector>
+
+namespace android::inputdispatcher {
+
+/**
+ * A bounded FIFO queue that one producer thread and one consumer thread can use at the same time
+ * without locking.
+ *
+ * Only one thread may push at a time, and only one thread may pop at a time. The consumer does not
+ * have to always be the same thread, as long as the consumers are otherwise synchronized with each
+ * other, for example by only popping while holding the same lock.
+ */
+template <class T>
+class SpscQueue {
+public:
+    explicit SpscQueue(size_t capacity) : mSlots(capacity + 1) {}
+
+    /**
+     * Add a new object to the queue. Must only be called by the producer.
+     * Return false if the queue is full.
+     */
+    template <class... Args>
+    bool push(Args&&... args) {
+        const size_t tail = mTail.load(std::memory_order_relaxed);
+        const size_t nextTail = next(tail);
+        if (nextTail == mHead.load(std::memory_order_acquire)) {
+            return false;
+        }
+        mSlots[tail].emplace(std::forward<Args>(args)...);
+        mTail.store(nextTail, std::memory_order_release);
+        return true;
+    }
+
+    /**
+     * Retrieve and remove the oldest object. Must only be called by the consumer.
+     * Returns std::nullopt if the queue is empty.
+     */
+    std::optional<T> pop() {
+        const size_t head = mHead.load(std::memory_order_relaxed);
+        if (head == mTail.load(std::memory_order_acquire)) {
+            return {};
+        }
+        T t = std::move(*mSlots[head]);
+        mSlots[head].reset();
+        mHead.store(next(head), std::memory_order_release);
+        return t;
+    }
+
+    size_t capacity() const { return mSlots.size() - 1; }
+
+private:
+    // One slot is always left empty, to tell a full queue from an empty one.
+    std::vector<std::optional<T>> mSlots;
+    // The head is written by the consumer and the tail by the producer. Keep them on separate
+    // cache lines so that the two threads do not keep invalidating each other's caches.
+    alignas(64) std::atomic<size_t> mHead{0};
+    alignas(64) std::atomic<size_t> mTail{0};
+
+    size_t next(size_t index) const { return index + 1 == mSlots.size() ? 0 : index + 1; }
+};
+
+} // namespace android::inputdispatcher
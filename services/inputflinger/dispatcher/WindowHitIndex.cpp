@@ -0,0 +1,101 @@
+/*
+ * Copyright (C) 2024 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "WindowHitIndex.h"
+
+#include <algorithm>
+#include <cmath>
+
+using android::gui::WindowInfo;
+using android::gui::WindowInfoHandle;
+
+namespace android::inputdispatcher {
+
+namespace {
+
+Rect unionOf(const Rect& a, const Rect& b) {
+    if (a.isEmpty()) return b;
+    if (b.isEmpty()) return a;
+    return Rect(std::min(a.left, b.left), std::min(a.top, b.top), std::max(a.right, b.right),
+                std::max(a.bottom, b.bottom));
+}
+
+} // namespace
+
+WindowHitIndex::WindowHitIndex(const std::vector<sp<WindowInfoHandle>>& windowHandles,
+                               const ui::Transform& displayTransform)
+      : mDisplayTransform(displayTransform), mWindowCount(windowHandles.size()) {
+    // Hit tests are done in the logical display space, see windowAcceptsTouchAt and
+    // windowOccludesTouchAt.
+    std::vector<Rect> windowBounds;
+    windowBounds.reserve(windowHandles.size());
+    for (size_t i = 0; i < windowHandles.size(); i++) {
+        const WindowInfo& info = *windowHandles[i]->getInfo();
+        mIndexByWindow.emplace(windowHandles[i].get(), i);
+        const Rect bounds =
+                unionOf(displayTransform.transform(info.touchableRegion).getBounds(),
+                        displayTransform.transform(info.frame));
+        mBounds = unionOf(mBounds, bounds);
+        windowBounds.push_back(bounds);
+    }
+
+    for (size_t i = 0; i < windowHandles.size(); i++) {
+        const Rect& bounds = windowBounds[i];
+        if (!windowHandles[i]->getInfo()->supportsSplitTouch()) {
+            for (std::vector<size_t>& cell : mCells) {
+                cell.push_back(i);
+            }
+            mUnboundedWindows.push_back(i);
+            continue;
+        }
+        if (bounds.isEmpty()) {
+            continue;
+        }
+        for (size_t y = cellY(bounds.top); y <= cellY(bounds.bottom - 1); y++) {
+            for (size_t x = cellX(bounds.left); x <= cellX(bounds.right - 1); x++) {
+                mCells[y * kGridSize + x].push_back(i);
+            }
+        }
+    }
+}
+
+size_t WindowHitIndex::cellX(int32_t x) const {
+    const int64_t offset = std::clamp<int64_t>(int64_t(x) - mBounds.left, 0, mBounds.width() - 1);
+    return offset * kGridSize / mBounds.width();
+}
+
+size_t WindowHitIndex::cellY(int32_t y) const {
+    const int64_t offset = std::clamp<int64_t>(int64_t(y) - mBounds.top, 0, mBounds.height() - 1);
+    return offset * kGridSize / mBounds.height();
+}
+
+const std::vector<size_t>& WindowHitIndex::candidatesAt(float x, float y) const {
+    const vec2 p = mDisplayTransform.transform(x, y);
+    const float px = std::floor(p.x);
+    const float py = std::floor(p.y);
+    if (mBounds.isEmpty() || px < mBounds.left || px >= mBounds.right || py < mBounds.top ||
+        py >= mBounds.bottom) {
+        return mUnboundedWindows;
+    }
+    return mCells[cellY(static_cast<int32_t>(py)) * kGridSize + cellX(static_cast<int32_t>(px))];
+}
+
+size_t WindowHitIndex::indexOf(const sp<WindowInfoHandle>& windowHandle) const {
+    const auto it = mIndexByWindow.find(windowHandle.get());
+    return it != mIndexByWindow.end() ? it->second : mWindowCount;
+}
+
+} // namespace android::inputdispatcher
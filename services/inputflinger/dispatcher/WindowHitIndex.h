@@ -0,0 +1,73 @@
+/*
+ * Copyright (C) 2024 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include <gui/WindowInfo.h>
+#include <ui/Rect.h>
+#include <ui/Transform.h>
+
+#include <array>
+#include <unordered_map>
+#include <vector>
+
+namespace android::inputdispatcher {
+
+/**
+ * Spatial index of the windows of one display, to find the windows which may be at a location
+ * without testing all of them.
+ *
+ * Windows are indexed by their position in the display's window list, which goes from front to
+ * back, and located by the bounds of their frame and touchable region in the logical display
+ * space. The display is split into a grid, and each cell lists the windows overlapping it, in
+ * z-order. A lookup only returns candidates, which the caller still has to hit test: it may
+ * return windows which don't contain the location, but never misses one which does.
+ *
+ * Windows which don't support split touch are returned at every location, since they can get
+ * pointers outside of their bounds.
+ *
+ * The index has to be rebuilt whenever the windows or the display transform change.
+ */
+class WindowHitIndex {
+public:
+    WindowHitIndex() = default;
+    WindowHitIndex(const std::vector<sp<gui::WindowInfoHandle>>& windowHandles,
+                   const ui::Transform& displayTransform);
+
+    // Positions in the window list of the windows which may be at (x, y), in display
+    // coordinates, in increasing order.
+    const std::vector<size_t>& candidatesAt(float x, float y) const;
+
+    // Position of the window in the window list, or the size of the list if it isn't there.
+    size_t indexOf(const sp<gui::WindowInfoHandle>& windowHandle) const;
+
+private:
+    static constexpr size_t kGridSize = 8;
+
+    size_t cellX(int32_t x) const;
+    size_t cellY(int32_t y) const;
+
+    ui::Transform mDisplayTransform;
+    size_t mWindowCount = 0;
+    // Union of the bounds of the windows in the logical display space.
+    Rect mBounds = Rect::EMPTY_RECT;
+    std::array<std::vector<size_t>, kGridSize * kGridSize> mCells;
+    // Candidates outside of mBounds.
+    std::vector<size_t> mUnboundedWindows;
+    std::unordered_map<const gui::WindowInfoHandle*, size_t> mIndexByWindow;
+};
+
+} // namespace android::inputdispatcher
@@ -243,6 +243,22 @@ public:
      * Notify the dispatcher that the state of the input method connection changed.
      */
     virtual void setInputMethodConnectionIsActive(bool isActive) = 0;
+
+    /*
+     * Allow the dispatcher to remember when interceptKeyBeforeDispatching lets a key through, and
+     * to let the same key through again without calling the policy. Decisions are remembered for
+     * the key code, meta state, action and policy flags of keys that are not repeats, and for the
+     * focused window. Decisions to consume or delay a key are never remembered.
+     *
+     * When enabled, the policy must call invalidateInterceptKeyCache whenever it could decide
+     * differently for a key it let through before, such as when a shortcut is registered.
+     */
+    virtual void setInterceptKeyCacheEnabled(bool enabled) = 0;
+
+    /*
+     * Forget all the interceptKeyBeforeDispatching decisions remembered so far.
+     */
+    virtual void invalidateInterceptKeyCache() = 0;
 };
 
 } // namespace android
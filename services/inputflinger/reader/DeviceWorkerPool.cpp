@@ -0,0 +1,83 @@
+/*
+ * Copyright (C) 2024 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "DeviceWorkerPool.h"
+
+#include <android-base/logging.h>
+
+namespace android {
+
+DeviceWorkerPool::DeviceWorkerPool(size_t threadCount) {
+    for (size_t i = 0; i < threadCount; i++) {
+        mThreads.push_back(std::make_unique<InputThread>(
+                "InputReaderWorker", [this]() { loopOnce(); }, [this]() { wake(); }));
+    }
+}
+
+DeviceWorkerPool::~DeviceWorkerPool() {
+    wake();
+    // Destroying the threads waits for them to exit.
+    mThreads.clear();
+}
+
+void DeviceWorkerPool::run(const std::vector<std::function<void()>>& tasks) {
+    std::unique_lock lock(mLock);
+    LOG_ALWAYS_FATAL_IF(mTasks != nullptr, "DeviceWorkerPool::run can't be nested");
+    mTasks = &tasks;
+    mNextTask = 0;
+    mTaskAvailable.notify_all();
+
+    while (runNextTaskLocked(lock)) {
+    }
+    mTasksDone.wait(lock, [this]() REQUIRES(mLock) { return mRunningTasks == 0; });
+    mTasks = nullptr;
+}
+
+void DeviceWorkerPool::loopOnce() {
+    std::unique_lock lock(mLock);
+    mTaskAvailable.wait(lock, [this]() REQUIRES(mLock) {
+        return mExiting || (mTasks != nullptr && mNextTask < mTasks->size());
+    });
+    if (mExiting) {
+        // The InputThread stops looping once it has been asked to exit.
+        return;
+    }
+    runNextTaskLocked(lock);
+}
+
+bool DeviceWorkerPool::runNextTaskLocked(std::unique_lock<std::mutex>& lock) {
+    if (mTasks == nullptr || mNextTask >= mTasks->size()) {
+        return false;
+    }
+    const std::function<void()>& task = (*mTasks)[mNextTask++];
+    mRunningTasks++;
+    lock.unlock();
+    task();
+    lock.lock();
+    if (--mRunningTasks == 0 && mNextTask >= mTasks->size()) {
+        mTasksDone.notify_all();
+    }
+    return true;
+}
+
+// Only called when the pool is being destroyed, so the threads don't need to wait anymore.
+void DeviceWorkerPool::wake() {
+    std::scoped_lock lock(mLock);
+    mExiting = true;
+    mTaskAvailable.notify_all();
+}
+
+} // namespace android
@@ -53,7 +53,9 @@
 #include <utils/Log.h>
 #include <utils/Timers.h>
 
+#include <atomic>
 #include <filesystem>
+#include <future>
 #include <optional>
 #include <regex>
 #include <utility>
@@ -85,6 +87,9 @@ static constexpr int32_t FF_WEAK_MAGNITUDE_CHANNEL_IDX = 1;
 
 static constexpr size_t EVENT_BUFFER_SIZE = 256;
 
+// Maximum number of threads that probe input devices while scanning for them.
+static constexpr size_t MAX_DEVICE_PROBE_THREADS = 4;
+
 // Mapping for input battery class node IDs lookup.
 // https://www.kernel.org/doc/Documentation/power/power_supply_class.txt
 static const std::unordered_map<std::string, InputBatteryClass> BATTERY_CLASSES =
@@ -680,26 +685,6 @@ bool EventHub::Device::hasKeycodeLocked(int keycode) const {
     return false;
 }
 
-void EventHub::Device::loadConfigurationLocked() {
-    configurationFile =
-            getInputDeviceConfigurationFilePathByDeviceIdentifier(identifier,
-                                                                  InputDeviceConfigurationFileType::
-                                                                          CONFIGURATION);
-    if (configurationFile.empty()) {
-        ALOGD("No input device configuration file found for device '%s'.", identifier.name.c_str());
-    } else {
-        android::base::Result<std::unique_ptr<PropertyMap>> propertyMap =
-                PropertyMap::load(configurationFile.c_str());
-        if (!propertyMap.ok()) {
-            ALOGE("Error loading input device configuration file for device '%s'.  "
-                  "Using default configuration.",
-                  identifier.name.c_str());
-        } else {
-            configuration = std::move(*propertyMap);
-        }
-    }
-}
-
 bool EventHub::Device::loadVirtualKeyMapLocked() {
     // The virtual key map is supplied by the kernel as a system board property file.
     std::string propPath = "/sys/board_properties/virtualkeys.";
@@ -1843,12 +1828,12 @@ std::optional<int32_t> EventHub::getBatteryStatus(int32_t deviceId, int32_t batt
     return std::nullopt;
 }
 
-std::vector<RawEvent> EventHub::getEvents(int timeoutMillis) {
+void EventHub::getEvents(int timeoutMillis, std::vector<RawEvent>& events) {
     std::scoped_lock _l(mLock);
 
     std::array<input_event, EVENT_BUFFER_SIZE> readBuffer;
 
-    std::vector<RawEvent> events;
+    events.clear();
     bool awoken = false;
     for (;;) {
         nsecs_t now = systemTime(SYSTEM_TIME_MONOTONIC);
@@ -2088,9 +2073,6 @@ std::vector<RawEvent> EventHub::getEvents(int timeoutMillis) {
             mPendingEventCount = size_t(pollResult);
         }
     }
-
-    // All done, return the number of events we read.
-    return events;
 }
 
 std::vector<TouchVideoFrame> EventHub::getVideoFrames(int32_t deviceId) {
@@ -2226,31 +2208,22 @@ void EventHub::reportDeviceAddedForStatisticsLocked(const InputDeviceIdentifier&
                                identifier.bus, obfuscatedId.c_str(), classes.get());
 }
 
-void EventHub::openDeviceLocked(const std::string& devicePath) {
-    // If an input device happens to register around the time when EventHub's constructor runs, it
-    // is possible that the same input event node (for example, /dev/input/event3) will be noticed
-    // in both 'inotify' callback and also in the 'scanDirLocked' pass. To prevent duplicate devices
-    // from getting registered, ensure that this path is not already covered by an existing device.
-    for (const auto& [deviceId, device] : mDevices) {
-        if (device->path == devicePath) {
-            return; // device was already registered
-        }
-    }
-
+std::optional<EventHub::ProbedDevice> EventHub::probeDevice(
+        const std::string& devicePath, const std::vector<std::string>& excludedDevices) {
     char buffer[80];
 
     ALOGV("Opening device: %s", devicePath.c_str());
 
-    int fd = open(devicePath.c_str(), O_RDWR | O_CLOEXEC | O_NONBLOCK);
-    if (fd < 0) {
+    base::unique_fd fd(open(devicePath.c_str(), O_RDWR | O_CLOEXEC | O_NONBLOCK));
+    if (!fd.ok()) {
         ALOGE("could not open %s, %s\n", devicePath.c_str(), strerror(errno));
-        return;
+        return std::nullopt;
     }
 
     InputDeviceIdentifier identifier;
 
     // Get device name.
-    if (ioctl(fd, EVIOCGNAME(sizeof(buffer) - 1), &buffer) < 1) {
+    if (ioctl(fd.get(), EVIOCGNAME(sizeof(buffer) - 1), &buffer) < 1) {
         ALOGE("Could not get device name for %s: %s", devicePath.c_str(), strerror(errno));
     } else {
         buffer[sizeof(buffer) - 1] = '\0';
@@ -2258,29 +2231,25 @@ void EventHub::openDeviceLocked(const std::string& devicePath) {
     }
 
     // Check to see if the device is on our excluded list
-    for (size_t i = 0; i < mExcludedDevices.size(); i++) {
-        const std::string& item = mExcludedDevices[i];
+    for (const std::string& item : excludedDevices) {
         if (identifier.name == item) {
             ALOGI("ignoring event id %s driver %s\n", devicePath.c_str(), item.c_str());
-            close(fd);
-            return;
+            return std::nullopt;
         }
     }
 
     // Get device driver version.
     int driverVersion;
-    if (ioctl(fd, EVIOCGVERSION, &driverVersion)) {
+    if (ioctl(fd.get(), EVIOCGVERSION, &driverVersion)) {
         ALOGE("could not get driver version for %s, %s\n", devicePath.c_str(), strerror(errno));
-        close(fd);
-        return;
+        return std::nullopt;
     }
 
     // Get device identifier.
     struct input_id inputId;
-    if (ioctl(fd, EVIOCGID, &inputId)) {
+    if (ioctl(fd.get(), EVIOCGID, &inputId)) {
         ALOGE("could not get device input id for %s, %s\n", devicePath.c_str(), strerror(errno));
-        close(fd);
-        return;
+        return std::nullopt;
     }
     identifier.bus = inputId.bustype;
     identifier.product = inputId.product;
@@ -2288,7 +2257,7 @@ void EventHub::openDeviceLocked(const std::string& devicePath) {
     identifier.version = inputId.version;
 
     // Get device physical location.
-    if (ioctl(fd, EVIOCGPHYS(sizeof(buffer) - 1), &buffer) < 1) {
+    if (ioctl(fd.get(), EVIOCGPHYS(sizeof(buffer) - 1), &buffer) < 1) {
         // fprintf(stderr, "could not get location for %s, %s\n", devicePath, strerror(errno));
     } else {
         buffer[sizeof(buffer) - 1] = '\0';
@@ -2296,7 +2265,7 @@ void EventHub::openDeviceLocked(const std::string& devicePath) {
     }
 
     // Get device unique id.
-    if (ioctl(fd, EVIOCGUNIQ(sizeof(buffer) - 1), &buffer) < 1) {
+    if (ioctl(fd.get(), EVIOCGUNIQ(sizeof(buffer) - 1), &buffer) < 1) {
         // fprintf(stderr, "could not get idstring for %s, %s\n", devicePath, strerror(errno));
     } else {
         buffer[sizeof(buffer) - 1] = '\0';
@@ -2314,11 +2283,61 @@ void EventHub::openDeviceLocked(const std::string& devicePath) {
         }
     }
 
+    // Load the configuration file for the device.
+    std::string configurationFile =
+            getInputDeviceConfigurationFilePathByDeviceIdentifier(identifier,
+                                                                  InputDeviceConfigurationFileType::
+                                                                          CONFIGURATION);
+    std::unique_ptr<PropertyMap> configuration;
+    if (configurationFile.empty()) {
+        ALOGD("No input device configuration file found for device '%s'.", identifier.name.c_str());
+    } else {
+        android::base::Result<std::unique_ptr<PropertyMap>> propertyMap =
+                PropertyMap::load(configurationFile.c_str());
+        if (!propertyMap.ok()) {
+            ALOGE("Error loading input device configuration file for device '%s'.  "
+                  "Using default configuration.",
+                  identifier.name.c_str());
+        } else {
+            configuration = std::move(*propertyMap);
+        }
+    }
+
+    return ProbedDevice{.path = devicePath,
+                        .fd = std::move(fd),
+                        .identifier = std::move(identifier),
+                        .driverVersion = driverVersion,
+                        .configurationFile = std::move(configurationFile),
+                        .configuration = std::move(configuration)};
+}
+
+void EventHub::openDeviceLocked(const std::string& devicePath) {
+    // If an input device happens to register around the time when EventHub's constructor runs, it
+    // is possible that the same input event node (for example, /dev/input/event3) will be noticed
+    // in both 'inotify' callback and also in the 'scanDirLocked' pass. To prevent duplicate devices
+    // from getting registered, ensure that this path is not already covered by an existing device.
+    for (const auto& [deviceId, device] : mDevices) {
+        if (device->path == devicePath) {
+            return; // device was already registered
+        }
+    }
+
+    if (std::optional<ProbedDevice> probedDevice = probeDevice(devicePath, mExcludedDevices)) {
+        openProbedDeviceLocked(std::move(*probedDevice));
+    }
+}
+
+void EventHub::openProbedDeviceLocked(ProbedDevice probedDevice) {
+    const std::string& devicePath = probedDevice.path;
+    InputDeviceIdentifier& identifier = probedDevice.identifier;
+    const int driverVersion = probedDevice.driverVersion;
+
     // Fill in the descriptor.
     assignDescriptorLocked(identifier);
 
     // Allocate device.  (The device object takes ownership of the fd at this point.)
     int32_t deviceId = mNextDeviceId++;
+    const int fd = probedDevice.fd.release();
     std::unique_ptr<Device> device =
             std::make_unique<Device>(fd, deviceId, devicePath, identifier,
                                      obtainAssociatedDeviceLocked(devicePath));
@@ -2336,8 +2355,8 @@ void EventHub::openDeviceLocked(const std::string& devicePath) {
     ALOGV("  driver:     v%d.%d.%d\n", driverVersion >> 16, (driverVersion >> 8) & 0xff,
           driverVersion & 0xff);
 
-    // Load the configuration file for the device.
-    device->loadConfigurationLocked();
+    device->configurationFile = std::move(probedDevice.configurationFile);
+    device->configuration = std::move(probedDevice.configuration);
 
     // Figure out the kinds of events the device reports.
     device->readDeviceBitMask(EVIOCGBIT(EV_KEY, 0), device->keyBitmask);
@@ -2808,8 +2827,39 @@ void EventHub::handleNotifyEventLocked(const inotify_event& event) {
 }
 
 status_t EventHub::scanDirLocked(const std::string& dirname) {
+    std::vector<std::string> devicePaths;
     for (const auto& entry : std::filesystem::directory_iterator(dirname)) {
-        openDeviceLocked(entry.path());
+        const std::string devicePath = entry.path();
+        if (std::none_of(mDevices.begin(), mDevices.end(),
+                         [&](const auto& pair) { return pair.second->path == devicePath; })) {
+            devicePaths.push_back(devicePath);
+        }
+    }
+
+    // Probing a device takes many ioctls and loads its configuration file, which adds up at boot
+    // on devices with many input nodes, so probe them on a few threads. The devices are still
+    // added in directory order on this thread, since that assigns their IDs.
+    std::vector<std::optional<ProbedDevice>> probedDevices(devicePaths.size());
+    std::atomic<size_t> nextIndex = 0;
+    const auto probeDevices = [&] {
+        for (size_t i = nextIndex++; i < devicePaths.size(); i = nextIndex++) {
+            probedDevices[i] = probeDevice(devicePaths[i], mExcludedDevices);
+        }
+    };
+    std::vector<std::future<void>> workers;
+    const size_t threadCount = std::min(devicePaths.size(), MAX_DEVICE_PROBE_THREADS);
+    for (size_t i = 1; i < threadCount; i++) {
+        workers.push_back(std::async(std::launch::async, probeDevices));
+    }
+    probeDevices();
+    for (auto& worker : workers) {
+        worker.wait();
+    }
+
+    for (auto& probedDevice : probedDevices) {
+        if (probedDevice) {
+            openProbedDeviceLocked(std::move(*probedDevice));
+        }
     }
     return 0;
 }
@@ -430,6 +430,14 @@ std::list<NotifyArgs> InputDevice::process(const RawEvent* rawEvents, size_t cou
     return out;
 }
 
+bool InputDevice::canProcessConcurrently() {
+    bool concurrent = getMapperCount() != 0;
+    for_each_mapper([&concurrent](InputMapper& mapper) {
+        concurrent = concurrent && mapper.canProcessConcurrently();
+    });
+    return concurrent;
+}
+
 void InputDevice::postProcess(std::list<NotifyArgs>& args) const {
     if (mIsWaking) {
         // Update policy flags to request wake for the `NotifyArgs` that come from waking devices.
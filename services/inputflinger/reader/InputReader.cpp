@@ -20,6 +20,8 @@
 
 #include <android-base/stringprintf.h>
 #include <errno.h>
+#include <algorithm>
+#include <functional>
 #include <input/Keyboard.h>
 #include <input/VirtualKeyMap.h>
 #include <inttypes.h>
@@ -29,6 +31,7 @@
 #include <stddef.h>
 #include <stdlib.h>
 #include <unistd.h>
+#include <thread>
 #include <utils/Errors.h>
 #include <utils/Thread.h>
 
@@ -39,6 +42,9 @@ using android::base::StringPrintf;
 
 namespace android {
 
+// The most threads that process the events of devices concurrently, besides the reader thread.
+static constexpr size_t MAX_DEVICE_WORKER_THREADS = 3;
+
 namespace {
 
 /**
@@ -159,14 +165,14 @@ void InputReader::loopOnce() {
         }
     } // release lock
 
-    std::vector<RawEvent> events = mEventHub->getEvents(timeoutMillis);
+    mEventHub->getEvents(timeoutMillis, mEventBuffer);
 
     { // acquire lock
         std::scoped_lock _l(mLock);
         mReaderIsAliveCondition.notify_all();
 
-        if (!events.empty()) {
-            mPendingArgs += processEventsLocked(events.data(), events.size());
+        if (!mEventBuffer.empty()) {
+            mPendingArgs += processEventsLocked(mEventBuffer.data(), mEventBuffer.size());
         }
 
         if (mNextTimeout != LLONG_MAX) {
@@ -231,18 +237,11 @@ std::list<NotifyArgs> InputReader::processEventsLocked(const RawEvent* rawEvents
         int32_t type = rawEvent->type;
         size_t batchSize = 1;
         if (type < EventHubInterface::FIRST_SYNTHETIC_EVENT) {
-            int32_t deviceId = rawEvent->deviceId;
-            while (batchSize < count) {
-                if (rawEvent[batchSize].type >= EventHubInterface::FIRST_SYNTHETIC_EVENT ||
-                    rawEvent[batchSize].deviceId != deviceId) {
-                    break;
-                }
+            while (batchSize < count &&
+                   rawEvent[batchSize].type < EventHubInterface::FIRST_SYNTHETIC_EVENT) {
                 batchSize += 1;
             }
-            if (debugRawEvents()) {
-                ALOGD("BatchSize: %zu Count: %zu", batchSize, count);
-            }
-            out += processEventsForDeviceLocked(deviceId, rawEvent, batchSize);
+            out += processDeviceEventsLocked(rawEvent, batchSize);
         } else {
             switch (rawEvent->type) {
                 case EventHubInterface::DEVICE_ADDED:
@@ -371,6 +370,102 @@ std::shared_ptr<InputDevice> InputReader::createDeviceLocked(
     return device;
 }
 
+std::list<NotifyArgs> InputReader::processDeviceEventsLocked(const RawEvent* rawEvents,
+                                                             size_t count) {
+    struct Batch {
+        int32_t eventHubId;
+        const RawEvent* rawEvents;
+        size_t count;
+        std::list<NotifyArgs> out;
+    };
+    // The batches of an InputDevice that can be processed concurrently.
+    struct DeviceWork {
+        InputDevice* device;
+        std::vector<Batch*> batches;
+    };
+
+    std::vector<Batch> batches;
+    for (size_t start = 0; start < count;) {
+        const int32_t eventHubId = rawEvents[start].deviceId;
+        size_t batchSize = 1;
+        while (start + batchSize < count && rawEvents[start + batchSize].deviceId == eventHubId) {
+            batchSize += 1;
+        }
+        if (debugRawEvents()) {
+            ALOGD("BatchSize: %zu Count: %zu", batchSize, count - start);
+        }
+        batches.push_back(Batch{eventHubId, rawEvents + start, batchSize, {}});
+        start += batchSize;
+    }
+
+    // Only the batches read before the first batch of a device that must be processed serially can
+    // be processed concurrently. The serial devices may change state that the others read, such as
+    // the global meta state, so everything from there on is processed in read order.
+    std::vector<DeviceWork> work;
+    size_t concurrentBatches = 0;
+    for (; concurrentBatches < batches.size(); concurrentBatches++) {
+        Batch& batch = batches[concurrentBatches];
+        auto deviceIt = mDevices.find(batch.eventHubId);
+        if (deviceIt == mDevices.end() || deviceIt->second->isIgnored() ||
+            !deviceIt->second->canProcessConcurrently()) {
+            break;
+        }
+        InputDevice* device = deviceIt->second.get();
+        auto workIt = std::find_if(work.begin(), work.end(),
+                                   [&](const DeviceWork& w) { return w.device == device; });
+        if (workIt == work.end()) {
+            workIt = work.insert(work.end(), DeviceWork{device, {}});
+        }
+        workIt->batches.push_back(&batch);
+    }
+
+    if (work.size() < 2) {
+        std::list<NotifyArgs> out;
+        for (const Batch& batch : batches) {
+            out += processEventsForDeviceLocked(batch.eventHubId, batch.rawEvents, batch.count);
+        }
+        return out;
+    }
+
+    if (mDeviceWorkerPool == nullptr) {
+        const size_t cpus = std::max(1u, std::thread::hardware_concurrency());
+        mDeviceWorkerPool = std::make_unique<DeviceWorkerPool>(
+                std::min<size_t>(cpus - 1, MAX_DEVICE_WORKER_THREADS));
+    }
+
+    // The devices that can be processed concurrently only use the state of the reader through
+    // the thread-safe parts of the context, so they run while the reader thread still holds mLock.
+    // Each device processes its own batches in read order.
+    std::vector<std::function<void()>> tasks;
+    for (DeviceWork& w : work) {
+        auto task = [&w]() {
+            for (Batch* batch : w.batches) {
+                batch->out = w.device->process(batch->rawEvents, batch->count);
+            }
+        };
+        if (mDeviceWorkerPool->getThreadCount() == 0) {
+            task();
+        } else {
+            tasks.push_back(std::move(task));
+        }
+    }
+    if (!tasks.empty()) {
+        mDeviceWorkerPool->run(tasks);
+    }
+
+    // The args are emitted in the order in which their events were read, whichever thread
+    // processed them.
+    std::list<NotifyArgs> out;
+    for (size_t i = 0; i < concurrentBatches; i++) {
+        out.splice(out.end(), batches[i].out);
+    }
+    for (size_t i = concurrentBatches; i < batches.size(); i++) {
+        const Batch& batch = batches[i];
+        out += processEventsForDeviceLocked(batch.eventHubId, batch.rawEvents, batch.count);
+    }
+    return out;
+}
+
 std::list<NotifyArgs> InputReader::processEventsForDeviceLocked(int32_t eventHubId,
                                                                 const RawEvent* rawEvents,
                                                                 size_t count) {
@@ -1038,17 +1133,20 @@ nsecs_t InputReader::ContextImpl::getLastKeyDownTimestamp() {
 
 void InputReader::ContextImpl::disableVirtualKeysUntil(nsecs_t time) {
     // lock is already held by the input loop
+    std::scoped_lock lock(mConcurrentCallsLock);
     mReader->disableVirtualKeysUntilLocked(time);
 }
 
 bool InputReader::ContextImpl::shouldDropVirtualKey(nsecs_t now, int32_t keyCode,
                                                     int32_t scanCode) {
     // lock is already held by the input loop
+    std::scoped_lock lock(mConcurrentCallsLock);
     return mReader->shouldDropVirtualKeyLocked(now, keyCode, scanCode);
 }
 
 void InputReader::ContextImpl::requestTimeoutAtTime(nsecs_t when) {
     // lock is already held by the input loop
+    std::scoped_lock lock(mConcurrentCallsLock);
     mReader->requestTimeoutAtTimeLocked(when);
 }
 
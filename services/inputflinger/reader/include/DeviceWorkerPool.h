@@ -0,0 +1,68 @@
+/*
+ * Copyright (C) 2024 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include <android-base/thread_annotations.h>
+
+#include <condition_variable>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+#include "InputThread.h"
+
+namespace android {
+
+/**
+ * A fixed set of threads used by the InputReader to process the events of several input devices
+ * at the same time.
+ *
+ * The threads are started when the pool is created and stopped when it is destroyed. They sleep
+ * while there is nothing to run.
+ */
+class DeviceWorkerPool {
+public:
+    explicit DeviceWorkerPool(size_t threadCount);
+    ~DeviceWorkerPool();
+
+    size_t getThreadCount() const { return mThreads.size(); }
+
+    /**
+     * Runs all of the tasks, on the calling thread as well as on the threads of the pool, and
+     * returns once they have all completed. Tasks can't call run.
+     */
+    void run(const std::vector<std::function<void()>>& tasks);
+
+private:
+    std::mutex mLock;
+    std::condition_variable mTaskAvailable;
+    std::condition_variable mTasksDone;
+    const std::vector<std::function<void()>>* mTasks GUARDED_BY(mLock){nullptr};
+    size_t mNextTask GUARDED_BY(mLock){0};
+    size_t mRunningTasks GUARDED_BY(mLock){0};
+    bool mExiting GUARDED_BY(mLock){false};
+
+    std::vector<std::unique_ptr<InputThread>> mThreads;
+
+    void loopOnce();
+    // Runs the next task that hasn't been started yet, returns false if there's none.
+    bool runNextTaskLocked(std::unique_lock<std::mutex>& lock) REQUIRES(mLock);
+    void wake();
+};
+
+} // namespace android
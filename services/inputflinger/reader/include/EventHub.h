@@ -28,6 +28,7 @@
 #include <utility>
 #include <vector>
 
+#include <android-base/unique_fd.h>
 #include <batteryservice/BatteryService.h>
 #include <ftl/flags.h>
 #include <input/Input.h>
@@ -304,9 +305,10 @@ public:
      * The timeout is advisory only.  If the device is asleep, it will not wake just to
      * service the timeout.
      *
-     * Returns the number of events obtained, or 0 if the timeout expired.
+     * The events obtained replace the content of outEvents, which is left empty if the timeout
+     * expired. Passing the same vector to each call lets its storage be reused.
      */
-    virtual std::vector<RawEvent> getEvents(int timeoutMillis) = 0;
+    virtual void getEvents(int timeoutMillis, std::vector<RawEvent>& outEvents) = 0;
     virtual std::vector<TouchVideoFrame> getVideoFrames(int32_t deviceId) = 0;
     virtual base::Result<std::pair<InputDeviceSensorType, int32_t>> mapSensor(
             int32_t deviceId, int32_t absCode) const = 0;
@@ -560,7 +562,7 @@ public:
     bool markSupportedKeyCodes(int32_t deviceId, const std::vector<int32_t>& keyCodes,
                                uint8_t* outFlags) const override final;
 
-    std::vector<RawEvent> getEvents(int timeoutMillis) override final;
+    void getEvents(int timeoutMillis, std::vector<RawEvent>& outEvents) override final;
     std::vector<TouchVideoFrame> getVideoFrames(int32_t deviceId) override final;
 
     bool hasScanCode(int32_t deviceId, int32_t scanCode) const override final;
@@ -680,7 +682,6 @@ private:
         void configureFd();
         void populateAbsoluteAxisStates();
         bool hasKeycodeLocked(int keycode) const;
-        void loadConfigurationLocked();
         bool loadVirtualKeyMapLocked();
         status_t loadKeyMapLocked();
         bool isExternalDeviceLocked();
@@ -694,10 +695,31 @@ private:
         void readDeviceState();
     };
 
+    /**
+     * The result of the steps of opening a device that do not depend on the state of the
+     * EventHub: opening the node, reading its identifier, and loading its configuration file.
+     */
+    struct ProbedDevice {
+        std::string path;
+        base::unique_fd fd;
+        InputDeviceIdentifier identifier;
+        int driverVersion;
+        std::string configurationFile;
+        std::unique_ptr<PropertyMap> configuration;
+    };
+
+    /**
+     * Probe the device at the provided path, unless it is excluded. Safe to call concurrently
+     * for different paths.
+     */
+    static std::optional<ProbedDevice> probeDevice(const std::string& devicePath,
+                                                   const std::vector<std::string>& excludedDevices);
+
     /**
      * Create a new device for the provided path.
      */
     void openDeviceLocked(const std::string& devicePath) REQUIRES(mLock);
+    void openProbedDeviceLocked(ProbedDevice probedDevice) REQUIRES(mLock);
     void openVideoDeviceLocked(const std::string& devicePath) REQUIRES(mLock);
     /**
      * Try to associate a video device with an input device. If the association succeeds,
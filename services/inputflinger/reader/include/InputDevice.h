@@ -93,6 +93,9 @@ public:
                                                   ConfigurationChanges changes);
     [[nodiscard]] std::list<NotifyArgs> reset(nsecs_t when);
     [[nodiscard]] std::list<NotifyArgs> process(const RawEvent* rawEvents, size_t count);
+    // Whether process can run at the same time as the processing of other devices. This is only
+    // the case when all of the mappers of the device support it.
+    bool canProcessConcurrently();
     [[nodiscard]] std::list<NotifyArgs> timeoutExpired(nsecs_t when);
     [[nodiscard]] std::list<NotifyArgs> updateExternalStylusState(const StylusState& state);
 
@@ -24,6 +24,7 @@
 #include <unordered_map>
 #include <vector>
 
+#include "DeviceWorkerPool.h"
 #include "EventHub.h"
 #include "InputListener.h"
 #include "InputReaderBase.h"
@@ -133,6 +134,9 @@ protected:
     class ContextImpl : public InputReaderContext {
         InputReader* mReader;
         IdGenerator mIdGenerator;
+        // Serializes the calls of the devices that are processed concurrently, see
+        // InputReader::processDeviceEventsLocked.
+        std::mutex mConcurrentCallsLock;
 
     public:
         explicit ContextImpl(InputReader* reader);
@@ -189,6 +193,12 @@ private:
     // sent to the 'mNextListener' without holding the lock.
     std::list<NotifyArgs> mPendingArgs GUARDED_BY(mLock);
 
+    // Events read by the last loopOnce, kept to reuse its storage. Only used on the reader thread.
+    std::vector<RawEvent> mEventBuffer;
+
+    // Threads processing the events of devices concurrently, created when first needed.
+    std::unique_ptr<DeviceWorkerPool> mDeviceWorkerPool GUARDED_BY(mLock);
+
     InputReaderConfiguration mConfig GUARDED_BY(mLock);
 
     // An input device can represent a collection of EventHub devices. This map provides a way
@@ -214,6 +224,9 @@ private:
     [[nodiscard]] std::list<NotifyArgs> processEventsLocked(const RawEvent* rawEvents, size_t count)
             REQUIRES(mLock);
 
+    [[nodiscard]] std::list<NotifyArgs> processDeviceEventsLocked(const RawEvent* rawEvents,
+                                                                  size_t count) REQUIRES(mLock);
+
     void addDeviceLocked(nsecs_t when, int32_t eventHubId) REQUIRES(mLock);
     void removeDeviceLocked(nsecs_t when, int32_t eventHubId) REQUIRES(mLock);
     [[nodiscard]] std::list<NotifyArgs> processEventsForDeviceLocked(int32_t eventHubId,
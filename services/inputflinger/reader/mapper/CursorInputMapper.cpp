@@ -141,6 +141,8 @@ std::list<NotifyArgs> CursorInputMapper::reconfigure(nsecs_t when,
                                                      const InputReaderConfiguration& readerConfig,
                                                      ConfigurationChanges changes) {
     std::list<NotifyArgs> out = InputMapper::reconfigure(when, readerConfig, changes);
+    // The held-back move was generated with the old configuration, so send it out first.
+    out += flushPendingMotion();
 
     if (!changes.any()) { // first time only
         configureBasicParams();
@@ -183,6 +185,17 @@ CursorInputMapper::Parameters CursorInputMapper::computeParameters(
 
     parameters.orientationAware = config.getBool("cursor.orientationAware").value_or(false);
 
+    parameters.motionCoalescingWindow = 0;
+    const std::optional<int32_t> coalescingWindowUs =
+            config.getInt("cursor.motionCoalescingWindowUs");
+    if (coalescingWindowUs.has_value()) {
+        if (*coalescingWindowUs >= 0) {
+            parameters.motionCoalescingWindow = us2ns(*coalescingWindowUs);
+        } else {
+            ALOGW("Invalid value for cursor.motionCoalescingWindowUs: %d", *coalescingWindowUs);
+        }
+    }
+
     parameters.hasAssociatedDisplay = false;
     if (parameters.mode == Parameters::Mode::POINTER || parameters.orientationAware) {
         parameters.hasAssociatedDisplay = true;
@@ -196,9 +209,13 @@ void CursorInputMapper::dumpParameters(std::string& dump) {
                          toString(mParameters.hasAssociatedDisplay));
     dump += StringPrintf(INDENT4 "Mode: %s\n", ftl::enum_string(mParameters.mode).c_str());
     dump += StringPrintf(INDENT4 "OrientationAware: %s\n", toString(mParameters.orientationAware));
+    dump += StringPrintf(INDENT4 "MotionCoalescingWindow: %" PRId64 "us\n",
+                         ns2us(mParameters.motionCoalescingWindow));
 }
 
 std::list<NotifyArgs> CursorInputMapper::reset(nsecs_t when) {
+    std::list<NotifyArgs> out = flushPendingMotion();
+
     mButtonState = 0;
     mDownTime = 0;
     mLastEventTime = std::numeric_limits<nsecs_t>::min();
@@ -212,7 +229,8 @@ std::list<NotifyArgs> CursorInputMapper::reset(nsecs_t when) {
     mCursorMotionAccumulator.reset(getDeviceContext());
     mCursorScrollAccumulator.reset(getDeviceContext());
 
-    return InputMapper::reset(when);
+    out += InputMapper::reset(when);
+    return out;
 }
 
 std::list<NotifyArgs> CursorInputMapper::process(const RawEvent& rawEvent) {
@@ -232,6 +250,19 @@ std::list<NotifyArgs> CursorInputMapper::process(const RawEvent& rawEvent) {
     return out;
 }
 
+std::list<NotifyArgs> CursorInputMapper::timeoutExpired(nsecs_t when) {
+    if (!mPendingMotion) {
+        return {};
+    }
+    const nsecs_t flushTime = mPendingMotionStartTime + mParameters.motionCoalescingWindow;
+    if (when < flushTime) {
+        // The timeout was requested by another device, so ours still needs to be scheduled.
+        getContext()->requestTimeoutAtTime(flushTime);
+        return {};
+    }
+    return flushPendingMotion();
+}
+
 std::list<NotifyArgs> CursorInputMapper::sync(nsecs_t when, nsecs_t readTime) {
     std::list<NotifyArgs> out;
     if (!mDisplayId) {
@@ -312,6 +343,11 @@ std::list<NotifyArgs> CursorInputMapper::sync(nsecs_t when, nsecs_t readTime) {
         policyFlags |= POLICY_FLAG_WAKE;
     }
 
+    // Anything other than a plain move must not overtake the move that is being held back.
+    if (downChanged || scrolled || buttonsChanged) {
+        out += flushPendingMotion();
+    }
+
     // Synthesize key down from buttons if needed.
     out += synthesizeButtonKeys(getContext(), AKEY_EVENT_ACTION_DOWN, when, readTime, getDeviceId(),
                                 mSource, *mDisplayId, policyFlags, lastButtonState,
@@ -346,13 +382,19 @@ std::list<NotifyArgs> CursorInputMapper::sync(nsecs_t when, nsecs_t readTime) {
             }
         }
 
-        out.push_back(NotifyMotionArgs(getContext()->getNextId(), when, readTime, getDeviceId(),
-                                       mSource, *mDisplayId, policyFlags, motionEventAction, 0, 0,
-                                       metaState, currentButtonState, MotionClassification::NONE,
-                                       AMOTION_EVENT_EDGE_FLAG_NONE, 1, &pointerProperties,
-                                       &pointerCoords, mXPrecision, mYPrecision, xCursorPosition,
-                                       yCursorPosition, downTime,
-                                       /*videoFrames=*/{}));
+        NotifyMotionArgs motionArgs(getContext()->getNextId(), when, readTime, getDeviceId(),
+                                    mSource, *mDisplayId, policyFlags, motionEventAction, 0, 0,
+                                    metaState, currentButtonState, MotionClassification::NONE,
+                                    AMOTION_EVENT_EDGE_FLAG_NONE, 1, &pointerProperties,
+                                    &pointerCoords, mXPrecision, mYPrecision, xCursorPosition,
+                                    yCursorPosition, downTime,
+                                    /*videoFrames=*/{});
+        if (mParameters.motionCoalescingWindow > 0 && !downChanged && !scrolled &&
+            !buttonsChanged) {
+            out += coalesceMotion(std::move(motionArgs));
+        } else {
+            out.push_back(std::move(motionArgs));
+        }
 
         if (buttonsPressed) {
             BitSet32 pressed(buttonsPressed);
@@ -410,6 +452,44 @@ std::list<NotifyArgs> CursorInputMapper::sync(nsecs_t when, nsecs_t readTime) {
     return out;
 }
 
+std::list<NotifyArgs> CursorInputMapper::coalesceMotion(NotifyMotionArgs&& args) {
+    std::list<NotifyArgs> out;
+    if (mPendingMotion) {
+        if (mPendingMotion->action == args.action &&
+            args.eventTime < mPendingMotionStartTime + mParameters.motionCoalescingWindow) {
+            // All of the axes of a move are relative, so the merged move is their sum.
+            PointerCoords& pendingCoords = mPendingMotion->pointerCoords[0];
+            const PointerCoords& coords = args.pointerCoords[0];
+            for (int32_t axis : {AMOTION_EVENT_AXIS_X, AMOTION_EVENT_AXIS_Y,
+                                 AMOTION_EVENT_AXIS_RELATIVE_X, AMOTION_EVENT_AXIS_RELATIVE_Y}) {
+                pendingCoords.setAxisValue(axis,
+                                           pendingCoords.getAxisValue(axis) +
+                                                   coords.getAxisValue(axis));
+            }
+            mPendingMotion->eventTime = args.eventTime;
+            mPendingMotion->readTime = args.readTime;
+            mPendingMotion->policyFlags |= args.policyFlags;
+            mPendingMotion->metaState = args.metaState;
+            return out;
+        }
+        out += flushPendingMotion();
+    }
+    mPendingMotionStartTime = args.eventTime;
+    mPendingMotion = std::move(args);
+    getContext()->requestTimeoutAtTime(mPendingMotionStartTime +
+                                       mParameters.motionCoalescingWindow);
+    return out;
+}
+
+std::list<NotifyArgs> CursorInputMapper::flushPendingMotion() {
+    std::list<NotifyArgs> out;
+    if (mPendingMotion) {
+        out.push_back(std::move(*mPendingMotion));
+        mPendingMotion.reset();
+    }
+    return out;
+}
+
 int32_t CursorInputMapper::getScanCodeState(uint32_t sourceMask, int32_t scanCode) {
     if (scanCode >= BTN_MOUSE && scanCode < BTN_JOYSTICK) {
         return getDeviceContext().getScanCodeState(scanCode);
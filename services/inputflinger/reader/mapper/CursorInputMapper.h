@@ -60,6 +60,8 @@ public:
                                                     ConfigurationChanges changes) override;
     [[nodiscard]] std::list<NotifyArgs> reset(nsecs_t when) override;
     [[nodiscard]] std::list<NotifyArgs> process(const RawEvent& rawEvent) override;
+    [[nodiscard]] std::list<NotifyArgs> timeoutExpired(nsecs_t when) override;
+    bool canProcessConcurrently() const override { return true; }
 
     virtual int32_t getScanCodeState(uint32_t sourceMask, int32_t scanCode) override;
 
@@ -87,6 +89,9 @@ private:
         Mode mode;
         bool hasAssociatedDisplay;
         bool orientationAware;
+        // Moves that arrive within this window of the first held-back move are merged into a
+        // single event, for mice that report at very high rates. Zero disables coalescing.
+        nsecs_t motionCoalescingWindow;
     } mParameters;
 
     CursorButtonAccumulator mCursorButtonAccumulator;
@@ -120,6 +125,11 @@ private:
     nsecs_t mDownTime;
     nsecs_t mLastEventTime;
 
+    // A move that is held back so that the moves following it within the coalescing window can be
+    // merged into it, and the event time of the first move that it contains.
+    std::optional<NotifyMotionArgs> mPendingMotion;
+    nsecs_t mPendingMotionStartTime{0};
+
     const bool mEnableNewMousePointerBallistics;
 
     explicit CursorInputMapper(InputDeviceContext& deviceContext,
@@ -131,6 +141,8 @@ private:
     void configureOnChangeDisplayInfo(const InputReaderConfiguration& config);
 
     [[nodiscard]] std::list<NotifyArgs> sync(nsecs_t when, nsecs_t readTime);
+    [[nodiscard]] std::list<NotifyArgs> coalesceMotion(NotifyMotionArgs&& args);
+    [[nodiscard]] std::list<NotifyArgs> flushPendingMotion();
 
     static Parameters computeParameters(const InputDeviceContext& deviceContext);
 };
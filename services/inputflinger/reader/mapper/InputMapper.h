@@ -81,6 +81,13 @@ public:
                                                             ConfigurationChanges changes);
     [[nodiscard]] virtual std::list<NotifyArgs> reset(nsecs_t when);
     [[nodiscard]] virtual std::list<NotifyArgs> process(const RawEvent& rawEvent) = 0;
+    /**
+     * Whether process() only changes the state of this mapper, so that it can run on a worker
+     * thread while other devices are processed. Such mappers may only call the InputReaderContext
+     * to get the global meta state, get the next id, request a timeout and check or disable
+     * virtual keys.
+     */
+    virtual bool canProcessConcurrently() const { return false; }
     [[nodiscard]] virtual std::list<NotifyArgs> timeoutExpired(nsecs_t when);
 
     virtual int32_t getKeyCodeState(uint32_t sourceMask, int32_t keyCode);
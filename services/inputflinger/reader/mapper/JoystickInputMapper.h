@@ -36,6 +36,7 @@ public:
                                                     ConfigurationChanges changes) override;
     [[nodiscard]] std::list<NotifyArgs> reset(nsecs_t when) override;
     [[nodiscard]] std::list<NotifyArgs> process(const RawEvent& rawEvent) override;
+    bool canProcessConcurrently() const override { return true; }
 
 private:
     struct Axis {
@@ -2246,8 +2246,30 @@ void TouchInputMapper::cookPointerData() {
         mCurrentCookedState.buttonState = mCurrentRawState.buttonState;
     }
 
-    // Walk through the the active pointers and map device coordinates onto
-    // display coordinates and adjust for display orientation.
+    // Adjust the X,Y coords of all pointers for device calibration and convert them to the
+    // natural display coordinates. This is the math of TouchAffineTransformation::applyTo followed
+    // by ui::Transform::transform, inlined over arrays so that the compiler can vectorize it.
+    std::array<float, MAX_POINTERS> xs;
+    std::array<float, MAX_POINTERS> ys;
+    for (uint32_t i = 0; i < currentPointerCount; i++) {
+        xs[i] = mCurrentRawState.rawPointerData.pointers[i].x;
+        ys[i] = mCurrentRawState.rawPointerData.pointers[i].y;
+    }
+    const TouchAffineTransformation& affine = mAffineTransform;
+    const vec3& col0 = mRawToDisplay[0];
+    const vec3& col1 = mRawToDisplay[1];
+    const vec3& col2 = mRawToDisplay[2];
+    for (uint32_t i = 0; i < currentPointerCount; i++) {
+        const float x = xs[i] * affine.x_scale + ys[i] * affine.x_ymix + affine.x_offset;
+        const float y = xs[i] * affine.y_xmix + ys[i] * affine.y_scale + affine.y_offset;
+        xs[i] = col0[0] * x + col1[0] * y + col2[0];
+        ys[i] = col0[1] * x + col1[1] * y + col2[1];
+    }
+
+    const uint32_t touchingCount = mCurrentRawState.rawPointerData.touchingIdBits.count();
+    const bool sizeIsSummed = mCalibration.sizeIsSummed && *mCalibration.sizeIsSummed;
+
+    // Walk through the the active pointers and map the other axes.
     for (uint32_t i = 0; i < currentPointerCount; i++) {
         const RawPointerData::Pointer& in = mCurrentRawState.rawPointerData.pointers[i];
 
@@ -2288,8 +2310,7 @@ void TouchInputMapper::cookPointerData() {
                     size = 0;
                 }
 
-                if (mCalibration.sizeIsSummed && *mCalibration.sizeIsSummed) {
-                    uint32_t touchingCount = mCurrentRawState.rawPointerData.touchingIdBits.count();
+                if (sizeIsSummed) {
                     if (touchingCount > 1) {
                         touchMajor /= touchingCount;
                         touchMinor /= touchingCount;
@@ -2393,12 +2414,10 @@ void TouchInputMapper::cookPointerData() {
                 distance = 0;
         }
 
-        // Adjust X,Y coords for device calibration and convert to the natural display coordinates.
-        vec2 transformed = {in.x, in.y};
-        mAffineTransform.applyTo(transformed.x /*byRef*/, transformed.y /*byRef*/);
-        transformed = mRawToDisplay.transform(transformed);
+        const vec2 transformed = {xs[i], ys[i]};
 
-        // Write output coords.
+        // Write output coords. The axes are set in increasing order, so that setAxisValue never
+        // has to move the values that are already set.
         PointerCoords& out = mCurrentCookedState.cookedPointerData.pointerCoords[i];
         out.clear();
         out.setAxisValue(AMOTION_EVENT_AXIS_X, transformed.x);
@@ -2407,11 +2426,11 @@ void TouchInputMapper::cookPointerData() {
         out.setAxisValue(AMOTION_EVENT_AXIS_SIZE, size);
         out.setAxisValue(AMOTION_EVENT_AXIS_TOUCH_MAJOR, touchMajor);
         out.setAxisValue(AMOTION_EVENT_AXIS_TOUCH_MINOR, touchMinor);
-        out.setAxisValue(AMOTION_EVENT_AXIS_ORIENTATION, orientation);
-        out.setAxisValue(AMOTION_EVENT_AXIS_TILT, tilt);
-        out.setAxisValue(AMOTION_EVENT_AXIS_DISTANCE, distance);
         out.setAxisValue(AMOTION_EVENT_AXIS_TOOL_MAJOR, toolMajor);
         out.setAxisValue(AMOTION_EVENT_AXIS_TOOL_MINOR, toolMinor);
+        out.setAxisValue(AMOTION_EVENT_AXIS_ORIENTATION, orientation);
+        out.setAxisValue(AMOTION_EVENT_AXIS_DISTANCE, distance);
+        out.setAxisValue(AMOTION_EVENT_AXIS_TILT, tilt);
 
         // Write output relative fields if applicable.
         uint32_t id = in.id;
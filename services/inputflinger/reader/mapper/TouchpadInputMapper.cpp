@@ -422,8 +422,8 @@ std::list<NotifyArgs> TouchpadInputMapper::process(const RawEvent& rawEvent) {
     if (mMotionAccumulator.getActiveSlotsCount() == 0) {
         mGestureStartTime = rawEvent.when;
     }
-    std::optional<SelfContainedHardwareState> state = mStateConverter.processRawEvent(rawEvent);
-    if (state) {
+    SelfContainedHardwareState* state = mStateConverter.processRawEvent(rawEvent);
+    if (state != nullptr) {
         if (mTouchpadHardwareStateNotificationsEnabled) {
             getPolicy()->notifyTouchpadHardwareState(*state, getDeviceId());
         }
@@ -435,33 +435,38 @@ std::list<NotifyArgs> TouchpadInputMapper::process(const RawEvent& rawEvent) {
 }
 
 void TouchpadInputMapper::updatePalmDetectionMetrics() {
-    std::set<int32_t> currentTrackingIds;
+    std::vector<int32_t>& currentTrackingIds = mCurrentFrameTrackingIds;
+    currentTrackingIds.clear();
     for (size_t i = 0; i < mMotionAccumulator.getSlotCount(); i++) {
         const MultiTouchMotionAccumulator::Slot& slot = mMotionAccumulator.getSlot(i);
         if (!slot.isInUse()) {
             continue;
         }
-        currentTrackingIds.insert(slot.getTrackingId());
+        currentTrackingIds.push_back(slot.getTrackingId());
         if (slot.getToolType() == ToolType::PALM) {
             mPalmTrackingIds.insert(slot.getTrackingId());
         }
     }
-    std::vector<int32_t> liftedTouches;
-    std::set_difference(mLastFrameTrackingIds.begin(), mLastFrameTrackingIds.end(),
-                        currentTrackingIds.begin(), currentTrackingIds.end(),
-                        std::inserter(liftedTouches, liftedTouches.begin()));
-    for (int32_t trackingId : liftedTouches) {
+    std::sort(currentTrackingIds.begin(), currentTrackingIds.end());
+    // Touches are usually only lifted every few frames, so walk both sorted lists rather than
+    // collecting the difference into a new container each frame.
+    auto current = currentTrackingIds.begin();
+    for (int32_t trackingId : mLastFrameTrackingIds) {
+        current = std::lower_bound(current, currentTrackingIds.end(), trackingId);
+        if (current != currentTrackingIds.end() && *current == trackingId) {
+            continue;
+        }
         if (mPalmTrackingIds.erase(trackingId) > 0) {
             MetricsAccumulator::getInstance().recordPalm(mMetricsId);
         } else {
             MetricsAccumulator::getInstance().recordFinger(mMetricsId);
         }
     }
-    mLastFrameTrackingIds = currentTrackingIds;
+    std::swap(mLastFrameTrackingIds, mCurrentFrameTrackingIds);
 }
 
 std::list<NotifyArgs> TouchpadInputMapper::sendHardwareState(nsecs_t when, nsecs_t readTime,
-                                                             SelfContainedHardwareState schs) {
+                                                             SelfContainedHardwareState& schs) {
     ALOGD_IF(DEBUG_TOUCHPAD_GESTURES, "New hardware state: %s", schs.state.String().c_str());
     mGestureInterpreter->PushHardwareState(&schs.state);
     return processGestures(when, readTime);
@@ -76,7 +76,7 @@ private:
                                  const InputReaderConfiguration& readerConfig);
     void updatePalmDetectionMetrics();
     [[nodiscard]] std::list<NotifyArgs> sendHardwareState(nsecs_t when, nsecs_t readTime,
-                                                          SelfContainedHardwareState schs);
+                                                          SelfContainedHardwareState& schs);
     [[nodiscard]] std::list<NotifyArgs> processGestures(nsecs_t when, nsecs_t readTime);
 
     std::unique_ptr<gestures::GestureInterpreter, void (*)(gestures::GestureInterpreter*)>
@@ -104,8 +104,10 @@ private:
         return std::make_tuple(id.bus, id.vendor, id.product, id.version);
     }
     const MetricsIdentifier mMetricsId;
-    // Tracking IDs for touches on the pad in the last evdev frame.
-    std::set<int32_t> mLastFrameTrackingIds;
+    // Sorted tracking IDs for touches on the pad in the last evdev frame.
+    std::vector<int32_t> mLastFrameTrackingIds;
+    // Storage for the tracking IDs of the current frame, kept to avoid reallocating it each frame.
+    std::vector<int32_t> mCurrentFrameTrackingIds;
     // Tracking IDs for touches that have at some point been reported as palms by the touchpad.
     std::set<int32_t> mPalmTrackingIds;
 
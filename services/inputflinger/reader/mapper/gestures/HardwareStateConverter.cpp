@@ -39,11 +39,11 @@ HardwareStateConverter::HardwareStateConverter(const InputDeviceContext& deviceC
     mTouchButtonAccumulator.configure();
 }
 
-std::optional<SelfContainedHardwareState> HardwareStateConverter::processRawEvent(
-        const RawEvent& rawEvent) {
-    std::optional<SelfContainedHardwareState> out;
+SelfContainedHardwareState* HardwareStateConverter::processRawEvent(const RawEvent& rawEvent) {
+    SelfContainedHardwareState* out = nullptr;
     if (rawEvent.type == EV_SYN && rawEvent.code == SYN_REPORT) {
-        out = produceHardwareState(rawEvent.when);
+        produceHardwareState(rawEvent.when);
+        out = &mState;
         mMotionAccumulator.finishSync();
         mMscTimestamp = 0;
     }
@@ -56,8 +56,8 @@ std::optional<SelfContainedHardwareState> HardwareStateConverter::processRawEven
     return out;
 }
 
-SelfContainedHardwareState HardwareStateConverter::produceHardwareState(nsecs_t when) {
-    SelfContainedHardwareState schs;
+void HardwareStateConverter::produceHardwareState(nsecs_t when) {
+    SelfContainedHardwareState& schs = mState;
     // The gestures library uses doubles to represent timestamps in seconds.
     schs.state.timestamp = std::chrono::duration<stime_t>(std::chrono::nanoseconds(when)).count();
     schs.state.msc_timestamp =
@@ -114,7 +114,6 @@ SelfContainedHardwareState HardwareStateConverter::produceHardwareState(nsecs_t
     schs.state.fingers = schs.fingers.data();
     schs.state.finger_cnt = schs.fingers.size();
     schs.state.touch_cnt = mTouchButtonAccumulator.getTouchCount() - numPalms;
-    return schs;
 }
 
 void HardwareStateConverter::reset() {
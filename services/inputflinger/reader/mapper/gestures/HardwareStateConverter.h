@@ -39,17 +39,21 @@ public:
     HardwareStateConverter(const InputDeviceContext& deviceContext,
                            MultiTouchMotionAccumulator& motionAccumulator);
 
-    std::optional<SelfContainedHardwareState> processRawEvent(const RawEvent& event);
+    // Returns the new hardware state when the event completes a frame, or nullptr otherwise. The
+    // state is owned by the converter, and is only valid until the next frame is processed.
+    SelfContainedHardwareState* processRawEvent(const RawEvent& event);
     void reset();
 
 private:
-    SelfContainedHardwareState produceHardwareState(nsecs_t when);
+    void produceHardwareState(nsecs_t when);
 
     const InputDeviceContext& mDeviceContext;
     CursorButtonAccumulator mCursorButtonAccumulator;
     MultiTouchMotionAccumulator& mMotionAccumulator;
     TouchButtonAccumulator mTouchButtonAccumulator;
     int32_t mMscTimestamp = 0;
+    // Reused for every frame, so that the finger states don't need to be allocated each time.
+    SelfContainedHardwareState mState;
 };
 
 } // namespace android
@@ -308,6 +308,94 @@ TEST_F(CursorInputMapperUnitTest, ProcessPointerCapture) {
                               WithRelativeMotion(10.0f, 20.0f)))));
 }
 
+/**
+ * With a coalescing window, the moves of a high polling rate mouse are held back and merged, and
+ * the merged move is sent when the window expires.
+ */
+TEST_F(CursorInputMapperUnitTest, CoalescesMovesWithinWindow) {
+    mPropertyMap.addProperty("cursor.motionCoalescingWindowUs", "1000");
+    createMapper();
+    // Pointer capture disables the velocity processing, so that the deltas are easy to check.
+    setPointerCapture(true);
+    EXPECT_CALL(mMockInputReaderContext, requestTimeoutAtTime(ARBITRARY_TIME + ms2ns(1)));
+    std::list<NotifyArgs> args;
+
+    // An 8kHz mouse reports every 125us.
+    for (int i = 0; i < 4; i++) {
+        const nsecs_t when = ARBITRARY_TIME + i * us2ns(125);
+        args += process(when, EV_REL, REL_X, 1);
+        args += process(when, EV_REL, REL_Y, 2);
+        args += process(when, EV_SYN, SYN_REPORT, 0);
+    }
+    ASSERT_THAT(args, testing::IsEmpty());
+
+    args += mMapper->timeoutExpired(ARBITRARY_TIME + ms2ns(1));
+    ASSERT_THAT(args,
+                ElementsAre(VariantWith<NotifyMotionArgs>(
+                        AllOf(WithMotionAction(ACTION_MOVE), WithCoords(4.0f, 8.0f),
+                              WithRelativeMotion(4.0f, 8.0f),
+                              WithEventTime(ARBITRARY_TIME + us2ns(375))))));
+
+    // Nothing is left to send.
+    args.clear();
+    args += mMapper->timeoutExpired(ARBITRARY_TIME + ms2ns(2));
+    ASSERT_THAT(args, testing::IsEmpty());
+}
+
+/**
+ * A move outside of the coalescing window is not merged into the held-back move, which is sent
+ * right away instead.
+ */
+TEST_F(CursorInputMapperUnitTest, MoveAfterCoalescingWindowSendsHeldBackMove) {
+    mPropertyMap.addProperty("cursor.motionCoalescingWindowUs", "1000");
+    createMapper();
+    setPointerCapture(true);
+    EXPECT_CALL(mMockInputReaderContext, requestTimeoutAtTime(ARBITRARY_TIME + ms2ns(1)));
+    EXPECT_CALL(mMockInputReaderContext, requestTimeoutAtTime(ARBITRARY_TIME + ms2ns(3)));
+    std::list<NotifyArgs> args;
+
+    args += process(ARBITRARY_TIME, EV_REL, REL_X, 1);
+    args += process(ARBITRARY_TIME, EV_SYN, SYN_REPORT, 0);
+    ASSERT_THAT(args, testing::IsEmpty());
+
+    args += process(ARBITRARY_TIME + ms2ns(2), EV_REL, REL_X, 2);
+    args += process(ARBITRARY_TIME + ms2ns(2), EV_SYN, SYN_REPORT, 0);
+    ASSERT_THAT(args,
+                ElementsAre(VariantWith<NotifyMotionArgs>(
+                        AllOf(WithMotionAction(ACTION_MOVE), WithRelativeMotion(1.0f, 0.0f),
+                              WithEventTime(ARBITRARY_TIME)))));
+}
+
+/**
+ * Button changes are never delayed, and the held-back move is sent before them so that the button
+ * edges happen where the pointer was at the time.
+ */
+TEST_F(CursorInputMapperUnitTest, ButtonPressSendsHeldBackMoveFirst) {
+    mPropertyMap.addProperty("cursor.motionCoalescingWindowUs", "1000");
+    createMapper();
+    setPointerCapture(true);
+    EXPECT_CALL(mMockInputReaderContext, requestTimeoutAtTime(ARBITRARY_TIME + ms2ns(1)));
+    std::list<NotifyArgs> args;
+
+    args += process(ARBITRARY_TIME, EV_REL, REL_X, 10);
+    args += process(ARBITRARY_TIME, EV_REL, REL_Y, 20);
+    args += process(ARBITRARY_TIME, EV_SYN, SYN_REPORT, 0);
+    ASSERT_THAT(args, testing::IsEmpty());
+
+    args += process(ARBITRARY_TIME + us2ns(125), EV_KEY, BTN_MOUSE, 1);
+    args += process(ARBITRARY_TIME + us2ns(125), EV_SYN, SYN_REPORT, 0);
+    ASSERT_THAT(args,
+                ElementsAre(VariantWith<NotifyMotionArgs>(
+                                    AllOf(WithMotionAction(ACTION_MOVE), WithCoords(10.0f, 20.0f),
+                                          WithEventTime(ARBITRARY_TIME))),
+                            VariantWith<NotifyMotionArgs>(
+                                    AllOf(WithMotionAction(ACTION_DOWN),
+                                          WithEventTime(ARBITRARY_TIME + us2ns(125)))),
+                            VariantWith<NotifyMotionArgs>(
+                                    AllOf(WithMotionAction(BUTTON_PRESS),
+                                          WithEventTime(ARBITRARY_TIME + us2ns(125))))));
+}
+
 TEST_F(CursorInputMapperUnitTest, PopulateDeviceInfoReturnsScaledRangeInNavigationMode) {
     mPropertyMap.addProperty("cursor.mode", "navigation");
     createMapper();
@@ -0,0 +1,95 @@
+/*
+ * Copyright (C) 2024 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "../dispatcher/EntryPool.h"
+#include "../dispatcher/Entry.h"
+
+#include <gtest/gtest.h>
+#include <memory>
+
+namespace android::inputdispatcher {
+
+namespace {
+
+std::unique_ptr<MotionEntry> createMotionEntry(size_t pointerCount) {
+    std::vector<PointerProperties> pointerProperties(pointerCount);
+    std::vector<PointerCoords> pointerCoords(pointerCount);
+    for (size_t i = 0; i < pointerCount; i++) {
+        pointerProperties[i].clear();
+        pointerProperties[i].id = i;
+        pointerProperties[i].toolType = ToolType::FINGER;
+        pointerCoords[i].clear();
+        pointerCoords[i].setAxisValue(AMOTION_EVENT_AXIS_X, 10 * i);
+        pointerCoords[i].setAxisValue(AMOTION_EVENT_AXIS_Y, 20 * i);
+    }
+    return std::make_unique<MotionEntry>(/*id=*/1, /*injectionState=*/nullptr, /*eventTime=*/0,
+                                         /*deviceId=*/1, AINPUT_SOURCE_TOUCHSCREEN,
+                                         ui::LogicalDisplayId::DEFAULT, /*policyFlags=*/0,
+                                         AMOTION_EVENT_ACTION_MOVE, /*actionButton=*/0,
+                                         /*flags=*/0, AMETA_NONE, /*buttonState=*/0,
+                                         MotionClassification::NONE, AMOTION_EVENT_EDGE_FLAG_NONE,
+                                         /*xPrecision=*/0, /*yPrecision=*/0,
+                                         AMOTION_EVENT_INVALID_CURSOR_POSITION,
+                                         AMOTION_EVENT_INVALID_CURSOR_POSITION, /*downTime=*/0,
+                                         pointerProperties, pointerCoords);
+}
+
+} // namespace
+
+// --- EntryPoolTest ---
+
+TEST(EntryPoolTest, ReusesFreedBlocks) {
+    EntryPool& pool = EntryPool::getInstance();
+    pool.deallocate(pool.allocate(100), 100);
+    const EntryPool::Stats before = pool.getStats();
+
+    // A freed block is reused for any size in the same class.
+    pool.deallocate(pool.allocate(120), 120);
+
+    ASSERT_EQ(before.blocksReused + 1, pool.getStats().blocksReused);
+}
+
+TEST(EntryPoolTest, DoesNotPoolLargeBlocks) {
+    EntryPool& pool = EntryPool::getInstance();
+    const size_t size = EntryPool::BLOCK_ALIGNMENT * EntryPool::NUM_BLOCK_CLASSES + 1;
+    const EntryPool::Stats before = pool.getStats();
+
+    pool.deallocate(pool.allocate(size), size);
+
+    const EntryPool::Stats after = pool.getStats();
+    ASSERT_EQ(before.blocksAllocated, after.blocksAllocated);
+    ASSERT_EQ(before.blocksPooled, after.blocksPooled);
+}
+
+TEST(EntryPoolTest, MotionEntriesReusePointerArrays) {
+    EntryPool& pool = EntryPool::getInstance();
+    // Release an entry with 3 pointers, so that the pool has arrays for them.
+    createMotionEntry(/*pointerCount=*/3).reset();
+    const EntryPool::Stats before = pool.getStats();
+
+    std::unique_ptr<MotionEntry> entry = createMotionEntry(/*pointerCount=*/3);
+
+    ASSERT_EQ(before.pointerArraysReused + 1, pool.getStats().pointerArraysReused);
+    ASSERT_EQ(3u, entry->getPointerCount());
+    ASSERT_EQ(3u, entry->pointerCoords.size());
+    for (size_t i = 0; i < 3; i++) {
+        ASSERT_EQ(static_cast<int32_t>(i), entry->pointerProperties[i].id);
+        ASSERT_EQ(10.f * i, entry->pointerCoords[i].getX());
+        ASSERT_EQ(20.f * i, entry->pointerCoords[i].getY());
+    }
+}
+
+} // namespace android::inputdispatcher
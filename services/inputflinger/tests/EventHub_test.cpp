@@ -103,6 +103,7 @@ protected:
 
 std::vector<RawEvent> EventHubTest::getEvents(std::optional<size_t> expectedEvents) {
     std::vector<RawEvent> events;
+    std::vector<RawEvent> newEvents;
 
     while (true) {
         std::chrono::milliseconds timeout = 0s;
@@ -110,7 +111,7 @@ std::vector<RawEvent> EventHubTest::getEvents(std::optional<size_t> expectedEven
             timeout = 2s;
         }
 
-        std::vector<RawEvent> newEvents = mEventHub->getEvents(timeout.count());
+        mEventHub->getEvents(timeout.count(), newEvents);
         if (newEvents.empty()) {
             break;
         }
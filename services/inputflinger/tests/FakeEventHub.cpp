@@ -355,14 +355,13 @@ void FakeEventHub::setExcludedDevices(const std::vector<std::string>& devices) {
     mExcludedDevices = devices;
 }
 
-std::vector<RawEvent> FakeEventHub::getEvents(int) {
+void FakeEventHub::getEvents(int, std::vector<RawEvent>& outEvents) {
     std::scoped_lock lock(mLock);
 
-    std::vector<RawEvent> buffer;
-    std::swap(buffer, mEvents);
+    outEvents.clear();
+    std::swap(outEvents, mEvents);
 
     mEventsCondition.notify_all();
-    return buffer;
 }
 
 std::vector<TouchVideoFrame> FakeEventHub::getVideoFrames(int32_t deviceId) {
@@ -179,7 +179,7 @@ private:
     base::Result<std::pair<InputDeviceSensorType, int32_t>> mapSensor(
             int32_t deviceId, int32_t absCode) const override;
     void setExcludedDevices(const std::vector<std::string>& devices) override;
-    std::vector<RawEvent> getEvents(int) override;
+    void getEvents(int, std::vector<RawEvent>& outEvents) override;
     std::vector<TouchVideoFrame> getVideoFrames(int32_t deviceId) override;
     int32_t getScanCodeState(int32_t deviceId, int32_t scanCode) const override;
     std::optional<RawLayoutInfo> getRawLayoutInfo(int32_t deviceId) const override;
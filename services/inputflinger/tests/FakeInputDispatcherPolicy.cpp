@@ -200,6 +200,11 @@ void FakeInputDispatcherPolicy::setInterceptKeyTimeout(std::chrono::milliseconds
     mInterceptKeyTimeout = timeout;
 }
 
+size_t FakeInputDispatcherPolicy::getInterceptKeyBeforeDispatchingCount() {
+    std::scoped_lock lock(mLock);
+    return mInterceptKeyBeforeDispatchingCount;
+}
+
 std::chrono::nanoseconds FakeInputDispatcherPolicy::getKeyWaitingForEventsTimeout() {
     return 500ms;
 }
@@ -411,6 +416,10 @@ void FakeInputDispatcherPolicy::interceptMotionBeforeQueueing(ui::LogicalDisplay
 
 nsecs_t FakeInputDispatcherPolicy::interceptKeyBeforeDispatching(const sp<IBinder>&,
                                                                  const KeyEvent&, uint32_t) {
+    {
+        std::scoped_lock lock(mLock);
+        mInterceptKeyBeforeDispatchingCount++;
+    }
     if (mConsumeKeyBeforeDispatching) {
         return -1;
     }
@@ -98,6 +98,7 @@ public:
      * Set policy timeout. A value of zero means next key will not be intercepted.
      */
     void setInterceptKeyTimeout(std::chrono::milliseconds timeout);
+    size_t getInterceptKeyBeforeDispatchingCount();
     std::chrono::nanoseconds getKeyWaitingForEventsTimeout() override;
     void setStaleEventTimeout(std::chrono::nanoseconds timeout);
     void assertUserActivityNotPoked();
@@ -144,6 +145,7 @@ private:
     std::queue<UserActivityPokeEvent> mUserActivityPokeEvents;
 
     std::chrono::milliseconds mInterceptKeyTimeout = 0ms;
+    size_t mInterceptKeyBeforeDispatchingCount GUARDED_BY(mLock) = 0;
 
     std::chrono::nanoseconds mStaleEventTimeout = 1000ms;
 
@@ -192,6 +192,10 @@ public:
         mInfo.setInputConfig(InputConfig::GLOBAL_STYLUS_BLOCKS_TOUCH, shouldGlobalStylusBlockTouch);
     }
 
+    inline void setLowLatencyInput(bool lowLatencyInput) {
+        mInfo.setInputConfig(InputConfig::LOW_LATENCY_INPUT, lowLatencyInput);
+    }
+
     inline void setAlpha(float alpha) { mInfo.alpha = alpha; }
 
     inline void setTouchOcclusionMode(gui::TouchOcclusionMode mode) {
@@ -684,6 +684,51 @@ TEST_F(InputDispatcherTest, SetInputWindow_SingleWindowTouch) {
     window->consumeMotionDown(ui::LogicalDisplayId::DEFAULT);
 }
 
+/**
+ * Motion events sent to a window that requested low-latency input are marked as unbatched, so that
+ * the consumer delivers every sample as soon as it arrives. Other windows are not affected.
+ */
+TEST_F(InputDispatcherTest, LowLatencyWindow_ReceivesUnbatchedMotions) {
+    std::shared_ptr<FakeApplicationHandle> application = std::make_shared<FakeApplicationHandle>();
+    sp<FakeWindowHandle> lowLatencyWindow =
+            sp<FakeWindowHandle>::make(application, mDispatcher, "Low latency",
+                                       ui::LogicalDisplayId::DEFAULT);
+    lowLatencyWindow->setFrame(Rect(0, 0, 100, 100));
+    lowLatencyWindow->setLowLatencyInput(true);
+    sp<FakeWindowHandle> window = sp<FakeWindowHandle>::make(application, mDispatcher, "Regular",
+                                                             ui::LogicalDisplayId::DEFAULT);
+    window->setFrame(Rect(100, 0, 200, 100));
+
+    mDispatcher->onWindowInfosChanged(
+            {{*lowLatencyWindow->getInfo(), *window->getInfo()}, {}, 0, 0});
+
+    mDispatcher->notifyMotion(MotionArgsBuilder(ACTION_DOWN, AINPUT_SOURCE_TOUCHSCREEN)
+                                      .deviceId(1)
+                                      .pointer(PointerBuilder(0, ToolType::FINGER).x(50).y(50))
+                                      .build());
+    lowLatencyWindow->consumeMotionEvent(
+            AllOf(WithMotionAction(ACTION_DOWN), WithFlags(AMOTION_EVENT_PRIVATE_FLAG_UNBATCHED)));
+    mDispatcher->notifyMotion(MotionArgsBuilder(ACTION_MOVE, AINPUT_SOURCE_TOUCHSCREEN)
+                                      .deviceId(1)
+                                      .pointer(PointerBuilder(0, ToolType::FINGER).x(51).y(50))
+                                      .build());
+    lowLatencyWindow->consumeMotionEvent(
+            AllOf(WithMotionAction(ACTION_MOVE), WithFlags(AMOTION_EVENT_PRIVATE_FLAG_UNBATCHED)));
+
+    mDispatcher->notifyMotion(MotionArgsBuilder(ACTION_UP, AINPUT_SOURCE_TOUCHSCREEN)
+                                      .deviceId(1)
+                                      .pointer(PointerBuilder(0, ToolType::FINGER).x(51).y(50))
+                                      .build());
+    lowLatencyWindow->consumeMotionEvent(
+            AllOf(WithMotionAction(ACTION_UP), WithFlags(AMOTION_EVENT_PRIVATE_FLAG_UNBATCHED)));
+
+    mDispatcher->notifyMotion(MotionArgsBuilder(ACTION_DOWN, AINPUT_SOURCE_TOUCHSCREEN)
+                                      .deviceId(1)
+                                      .pointer(PointerBuilder(0, ToolType::FINGER).x(150).y(50))
+                                      .build());
+    window->consumeMotionEvent(AllOf(WithMotionAction(ACTION_DOWN), WithFlags(0)));
+}
+
 using InputDispatcherDeathTest = InputDispatcherTest;
 
 /**
@@ -5487,6 +5532,71 @@ TEST_F(InputDispatcherTest, InterceptKeyByPolicy) {
                 std::chrono::nanoseconds(interceptKeyTimeout).count());
 }
 
+/**
+ * When the policy enables the intercept key cache, keys that it let through before are dispatched
+ * without asking it again, until the cache is invalidated.
+ */
+TEST_F(InputDispatcherTest, InterceptKeyCacheSkipsPolicyForRepeatedKeys) {
+    std::shared_ptr<FakeApplicationHandle> application = std::make_shared<FakeApplicationHandle>();
+    sp<FakeWindowHandle> window =
+            sp<FakeWindowHandle>::make(application, mDispatcher, "Fake Window",
+                                       ui::LogicalDisplayId::DEFAULT);
+    window->setFocusable(true);
+
+    mDispatcher->onWindowInfosChanged({{*window->getInfo()}, {}, 0, 0});
+    setFocusedWindow(window);
+
+    window->consumeFocusEvent(true);
+    mDispatcher->setInterceptKeyCacheEnabled(true);
+
+    auto pressKey = [&]() {
+        mDispatcher->notifyKey(
+                generateKeyArgs(AKEY_EVENT_ACTION_DOWN, ui::LogicalDisplayId::DEFAULT));
+        window->consumeKeyDown(ui::LogicalDisplayId::DEFAULT);
+        mDispatcher->notifyKey(
+                generateKeyArgs(AKEY_EVENT_ACTION_UP, ui::LogicalDisplayId::DEFAULT));
+        window->consumeKeyUp(ui::LogicalDisplayId::DEFAULT);
+    };
+
+    // The policy is asked once about the down and once about the up.
+    pressKey();
+    ASSERT_EQ(2u, mFakePolicy->getInterceptKeyBeforeDispatchingCount());
+    pressKey();
+    ASSERT_EQ(2u, mFakePolicy->getInterceptKeyBeforeDispatchingCount());
+
+    mDispatcher->invalidateInterceptKeyCache();
+    pressKey();
+    ASSERT_EQ(4u, mFakePolicy->getInterceptKeyBeforeDispatchingCount());
+}
+
+/**
+ * Keys that the policy consumed are never cached.
+ */
+TEST_F(InputDispatcherTest, InterceptKeyCacheDoesNotCacheConsumedKeys) {
+    std::shared_ptr<FakeApplicationHandle> application = std::make_shared<FakeApplicationHandle>();
+    sp<FakeWindowHandle> window =
+            sp<FakeWindowHandle>::make(application, mDispatcher, "Fake Window",
+                                       ui::LogicalDisplayId::DEFAULT);
+    window->setFocusable(true);
+
+    mDispatcher->onWindowInfosChanged({{*window->getInfo()}, {}, 0, 0});
+    setFocusedWindow(window);
+
+    window->consumeFocusEvent(true);
+    mDispatcher->setInterceptKeyCacheEnabled(true);
+
+    mFakePolicy->setConsumeKeyBeforeDispatching(true);
+    for (int i = 0; i < 2; i++) {
+        mDispatcher->notifyKey(
+                generateKeyArgs(AKEY_EVENT_ACTION_DOWN, ui::LogicalDisplayId::DEFAULT));
+        mDispatcher->notifyKey(
+                generateKeyArgs(AKEY_EVENT_ACTION_UP, ui::LogicalDisplayId::DEFAULT));
+        mDispatcher->waitForIdle();
+        window->assertNoEvents();
+    }
+    ASSERT_EQ(4u, mFakePolicy->getInterceptKeyBeforeDispatchingCount());
+}
+
 /**
  * Keys with ACTION_UP are delivered immediately, even if a long 'intercept key timeout' is set.
  */
@@ -12007,6 +12117,24 @@ TEST_F(InputDispatcherUntrustedTouchesTest, WindowWithAllowOcclusionMode_AllowsT
     mTouchWindow->consumeAnyMotionDown();
 }
 
+TEST_F(InputDispatcherUntrustedTouchesTest, OcclusionModeChangedByUpdate_BlocksNextTouch) {
+    const sp<FakeWindowHandle>& w = getOccludingWindow(APP_B_UID, "B", TouchOcclusionMode::ALLOW);
+    mDispatcher->onWindowInfosChanged({{*w->getInfo(), *mTouchWindow->getInfo()}, {}, 0, 0});
+    touch();
+    mTouchWindow->consumeAnyMotionDown();
+    mDispatcher->notifyMotion(generateMotionArgs(AMOTION_EVENT_ACTION_UP,
+                                                 AINPUT_SOURCE_TOUCHSCREEN,
+                                                 ui::LogicalDisplayId::DEFAULT, {PointF{100, 200}}));
+    mTouchWindow->consumeMotionEvent(WithMotionAction(AMOTION_EVENT_ACTION_UP));
+
+    // The occlusion computed for the first touch doesn't outlive the window update.
+    w->setTouchOcclusionMode(TouchOcclusionMode::BLOCK_UNTRUSTED);
+    mDispatcher->onWindowInfosChanged({{*w->getInfo(), *mTouchWindow->getInfo()}, {}, 0, 0});
+    touch();
+
+    mTouchWindow->assertNoEvents();
+}
+
 TEST_F(InputDispatcherUntrustedTouchesTest, TouchOutsideOccludingWindow_AllowsTouch) {
     const sp<FakeWindowHandle>& w =
             getOccludingWindow(APP_B_UID, "B", TouchOcclusionMode::BLOCK_UNTRUSTED);
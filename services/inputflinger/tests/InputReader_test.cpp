@@ -164,6 +164,7 @@ class FakeInputMapper : public InputMapper {
     std::unordered_map<int32_t, int32_t> mKeyCodeMapping;
     std::vector<int32_t> mSupportedKeyCodes;
     std::list<NotifyArgs> mProcessResult;
+    bool mCanProcessConcurrently = false;
 
     std::mutex mLock;
     std::condition_variable mStateChangedCondition;
@@ -202,6 +203,8 @@ public:
         }
     }
 
+    void setCanProcessConcurrently(bool concurrent) { mCanProcessConcurrently = concurrent; }
+
     void assertConfigureWasCalled() {
         std::unique_lock<std::mutex> lock(mLock);
         base::ScopedLockAssertion assumeLocked(mLock);
@@ -315,6 +318,8 @@ private:
         return mProcessResult;
     }
 
+    bool canProcessConcurrently() const override { return mCanProcessConcurrently; }
+
     int32_t getKeyCodeState(uint32_t, int32_t keyCode) override {
         ssize_t index = mKeyCodeStates.indexOfKey(keyCode);
         return index >= 0 ? mKeyCodeStates.valueAt(index) : AKEY_STATE_UNKNOWN;
@@ -1165,6 +1170,94 @@ TEST_F(InputReaderTest, ChangingPointerCaptureNotifiesInputListener) {
     mFakeListener->assertNotifyCaptureWasNotCalled();
 }
 
+TEST_F(InputReaderTest, ConcurrentlyProcessedDevices_ArgsKeepReadOrder) {
+    constexpr int32_t FIRST_DEVICE_ID = END_RESERVED_ID + 1000;
+    constexpr int32_t SECOND_DEVICE_ID = FIRST_DEVICE_ID + 1;
+    FakeInputMapper& firstMapper =
+            addDeviceWithFakeInputMapper(FIRST_DEVICE_ID, FIRST_DEVICE_ID, "first",
+                                         InputDeviceClass::TOUCH_MT, AINPUT_SOURCE_TOUCHSCREEN,
+                                         /*configuration=*/nullptr);
+    FakeInputMapper& secondMapper =
+            addDeviceWithFakeInputMapper(SECOND_DEVICE_ID, SECOND_DEVICE_ID, "second",
+                                         InputDeviceClass::JOYSTICK, AINPUT_SOURCE_JOYSTICK,
+                                         /*configuration=*/nullptr);
+    firstMapper.setCanProcessConcurrently(true);
+    secondMapper.setCanProcessConcurrently(true);
+
+    // The events of the first device are read first, so its args come first even though the
+    // second device produces args with an earlier event time.
+    firstMapper.setProcessResult({MotionArgsBuilder(AMOTION_EVENT_ACTION_DOWN,
+                                                    AINPUT_SOURCE_TOUCHSCREEN)
+                                          .deviceId(FIRST_DEVICE_ID)
+                                          .eventTime(ARBITRARY_TIME + 2)
+                                          .pointer(PointerBuilder(/*id=*/0, ToolType::FINGER))
+                                          .build()});
+    secondMapper.setProcessResult(
+            {MotionArgsBuilder(AMOTION_EVENT_ACTION_MOVE, AINPUT_SOURCE_JOYSTICK)
+                     .deviceId(SECOND_DEVICE_ID)
+                     .eventTime(ARBITRARY_TIME + 1)
+                     .pointer(PointerBuilder(/*id=*/0, ToolType::UNKNOWN))
+                     .build()});
+    mFakeEventHub->enqueueEvent(ARBITRARY_TIME, ARBITRARY_TIME, FIRST_DEVICE_ID, 0, 0, 0);
+    mFakeEventHub->enqueueEvent(ARBITRARY_TIME, ARBITRARY_TIME, SECOND_DEVICE_ID, 0, 0, 0);
+    mReader->loopOnce();
+
+    ASSERT_NO_FATAL_FAILURE(firstMapper.assertProcessWasCalled());
+    ASSERT_NO_FATAL_FAILURE(secondMapper.assertProcessWasCalled());
+    mFakeListener->assertNotifyMotionWasCalled(WithDeviceId(FIRST_DEVICE_ID));
+    mFakeListener->assertNotifyMotionWasCalled(WithDeviceId(SECOND_DEVICE_ID));
+}
+
+TEST_F(InputReaderTest, ConcurrentlyProcessedDevices_SerialDeviceKeepsReadOrder) {
+    constexpr int32_t TOUCH_DEVICE_ID = END_RESERVED_ID + 1000;
+    constexpr int32_t KEYBOARD_DEVICE_ID = TOUCH_DEVICE_ID + 1;
+    constexpr int32_t JOYSTICK_DEVICE_ID = TOUCH_DEVICE_ID + 2;
+    FakeInputMapper& touchMapper =
+            addDeviceWithFakeInputMapper(TOUCH_DEVICE_ID, TOUCH_DEVICE_ID, "touch",
+                                         InputDeviceClass::TOUCH_MT, AINPUT_SOURCE_TOUCHSCREEN,
+                                         /*configuration=*/nullptr);
+    FakeInputMapper& keyboardMapper =
+            addDeviceWithFakeInputMapper(KEYBOARD_DEVICE_ID, KEYBOARD_DEVICE_ID, "keyboard",
+                                         InputDeviceClass::KEYBOARD, AINPUT_SOURCE_KEYBOARD,
+                                         /*configuration=*/nullptr);
+    FakeInputMapper& joystickMapper =
+            addDeviceWithFakeInputMapper(JOYSTICK_DEVICE_ID, JOYSTICK_DEVICE_ID, "joystick",
+                                         InputDeviceClass::JOYSTICK, AINPUT_SOURCE_JOYSTICK,
+                                         /*configuration=*/nullptr);
+    touchMapper.setCanProcessConcurrently(true);
+    joystickMapper.setCanProcessConcurrently(true);
+
+    // The joystick is read after the keyboard, which may change state it reads, so it is
+    // processed after it. The event times don't change the order either.
+    touchMapper.setProcessResult({MotionArgsBuilder(AMOTION_EVENT_ACTION_DOWN,
+                                                    AINPUT_SOURCE_TOUCHSCREEN)
+                                          .deviceId(TOUCH_DEVICE_ID)
+                                          .eventTime(ARBITRARY_TIME + 3)
+                                          .pointer(PointerBuilder(/*id=*/0, ToolType::FINGER))
+                                          .build()});
+    keyboardMapper.setProcessResult({KeyArgsBuilder(AKEY_EVENT_ACTION_DOWN, AINPUT_SOURCE_KEYBOARD)
+                                             .deviceId(KEYBOARD_DEVICE_ID)
+                                             .eventTime(ARBITRARY_TIME + 2)
+                                             .build()});
+    joystickMapper.setProcessResult(
+            {MotionArgsBuilder(AMOTION_EVENT_ACTION_MOVE, AINPUT_SOURCE_JOYSTICK)
+                     .deviceId(JOYSTICK_DEVICE_ID)
+                     .eventTime(ARBITRARY_TIME + 1)
+                     .pointer(PointerBuilder(/*id=*/0, ToolType::UNKNOWN))
+                     .build()});
+    mFakeEventHub->enqueueEvent(ARBITRARY_TIME, ARBITRARY_TIME, TOUCH_DEVICE_ID, 0, 0, 0);
+    mFakeEventHub->enqueueEvent(ARBITRARY_TIME, ARBITRARY_TIME, KEYBOARD_DEVICE_ID, 0, 0, 0);
+    mFakeEventHub->enqueueEvent(ARBITRARY_TIME, ARBITRARY_TIME, JOYSTICK_DEVICE_ID, 0, 0, 0);
+    mReader->loopOnce();
+
+    ASSERT_NO_FATAL_FAILURE(touchMapper.assertProcessWasCalled());
+    ASSERT_NO_FATAL_FAILURE(keyboardMapper.assertProcessWasCalled());
+    ASSERT_NO_FATAL_FAILURE(joystickMapper.assertProcessWasCalled());
+    mFakeListener->assertNotifyMotionWasCalled(WithDeviceId(TOUCH_DEVICE_ID));
+    mFakeListener->assertNotifyKeyWasCalled(WithDeviceId(KEYBOARD_DEVICE_ID));
+    mFakeListener->assertNotifyMotionWasCalled(WithDeviceId(JOYSTICK_DEVICE_ID));
+}
+
 TEST_F(InputReaderTest, GetLastUsedInputDeviceId) {
     constexpr int32_t FIRST_DEVICE_ID = END_RESERVED_ID + 1000;
     constexpr int32_t SECOND_DEVICE_ID = FIRST_DEVICE_ID + 1;
@@ -0,0 +1,77 @@
+/*
+ * Copyright (C) 2024 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "../dispatcher/LatencyHistogram.h"
+
+#include <gtest/gtest.h>
+
+namespace android::inputdispatcher {
+
+namespace {
+
+constexpr nsecs_t MILLIS = 1'000'000;
+
+// The percentiles are reported with a relative error of at most 1/16.
+void assertNearLatency(nsecs_t expected, nsecs_t actual) {
+    ASSERT_GE(actual, expected);
+    ASSERT_LE(actual, expected + expected / 16);
+}
+
+} // namespace
+
+TEST(LatencyHistogramTest, Empty_ReportsZero) {
+    LatencyHistogram histogram;
+    ASSERT_EQ(0u, histogram.getCount());
+    ASSERT_EQ(0, histogram.getPercentile(50));
+    ASSERT_EQ(0, histogram.getPercentile(99));
+}
+
+TEST(LatencyHistogramTest, UniformValues_PercentilesAreAccurate) {
+    LatencyHistogram histogram;
+    for (nsecs_t i = 1; i <= 100; i++) {
+        histogram.add(i * MILLIS);
+    }
+    ASSERT_EQ(100u, histogram.getCount());
+    assertNearLatency(50 * MILLIS, histogram.getPercentile(50));
+    assertNearLatency(90 * MILLIS, histogram.getPercentile(90));
+    assertNearLatency(99 * MILLIS, histogram.getPercentile(99));
+}
+
+TEST(LatencyHistogramTest, NegativeAndHugeValues_AreClamped) {
+    LatencyHistogram histogram;
+    histogram.add(-5 * MILLIS);
+    histogram.add(1000 * 1000 * MILLIS);
+    ASSERT_EQ(0, histogram.getPercentile(50));
+    ASSERT_GT(histogram.getPercentile(100), 60'000 * MILLIS);
+}
+
+/**
+ * The histogram never grows, and old values are forgotten over time so that the percentiles
+ * reflect the recent latencies.
+ */
+TEST(LatencyHistogramTest, ManyValues_OldValuesDecay) {
+    LatencyHistogram histogram;
+    for (uint32_t i = 0; i < LatencyHistogram::MAX_COUNT; i++) {
+        histogram.add(100 * MILLIS);
+    }
+    ASSERT_LT(histogram.getCount(), LatencyHistogram::MAX_COUNT);
+    for (uint32_t i = 0; i < 4 * LatencyHistogram::MAX_COUNT; i++) {
+        histogram.add(2 * MILLIS);
+    }
+    assertNearLatency(2 * MILLIS, histogram.getPercentile(99));
+}
+
+} // namespace android::inputdispatcher
@@ -218,6 +218,32 @@ TEST_F(LatencyTrackerTest, TrackAllParameters_ReportsFullTimeline) {
     assertReceivedTimeline(expected);
 }
 
+/**
+ * The delivery to consume time of events sent to low-latency windows is reported separately from
+ * the batched events.
+ */
+TEST_F(LatencyTrackerTest, UnbatchedEvents_AreDumpedSeparately) {
+    mTracker->trackListener(/*inputEventId=*/1, /*eventTime=*/2, /*readTime=*/3, DEVICE_ID,
+                            {InputDeviceUsageSource::TOUCHSCREEN}, AMOTION_EVENT_ACTION_MOVE,
+                            InputEventType::MOTION);
+    mTracker->trackListener(/*inputEventId=*/2, /*eventTime=*/2, /*readTime=*/3, DEVICE_ID,
+                            {InputDeviceUsageSource::TOUCHSCREEN}, AMOTION_EVENT_ACTION_MOVE,
+                            InputEventType::MOTION);
+    mTracker->trackFinishedEvent(/*inputEventId=*/1, connection1, /*deliveryTime=*/4,
+                                 /*consumeTime=*/8'000'004, /*finishTime=*/9'000'000);
+    mTracker->trackFinishedEvent(/*inputEventId=*/2, connection1, /*deliveryTime=*/4,
+                                 /*consumeTime=*/1'000'004, /*finishTime=*/2'000'000,
+                                 /*unbatched=*/true);
+
+    const std::string dump = mTracker->dump("");
+    EXPECT_NE(std::string::npos,
+              dump.find("Delivery to consume, batched: count=1, avg=8.000ms, max=8.000ms"))
+            << dump;
+    EXPECT_NE(std::string::npos,
+              dump.find("Delivery to consume, low latency: count=1, avg=1.000ms, max=1.000ms"))
+            << dump;
+}
+
 /**
  * Send 2 events with the same inputEventId, but different eventTime's. Ensure that no crash occurs,
  * and that the tracker drops such events completely.
@@ -328,6 +354,24 @@ TEST_F(LatencyTrackerTest, IncompleteEvents_AreHandledConsistently) {
     assertReceivedTimelines(expectedTimelines);
 }
 
+/**
+ * The number of timelines kept in memory is bounded. Once too many events are tracked, the oldest
+ * ones are reported right away, even though they are not yet mature.
+ */
+TEST_F(LatencyTrackerTest, TooManyTrackedEvents_OldestIsReportedEarly) {
+    constexpr size_t numEvents = 5000;
+    for (size_t i = 1; i <= numEvents; i++) {
+        mTracker->trackListener(/*inputEventId=*/i, /*eventTime=*/i, /*readTime=*/i + 1,
+                                DEVICE_ID, /*sources=*/{InputDeviceUsageSource::UNKNOWN},
+                                AMOTION_EVENT_ACTION_MOVE, InputEventType::MOTION);
+    }
+    // The first event has been reported with the data that was available.
+    assertReceivedTimeline(InputEventTimeline{/*eventTime=*/1, /*readTime=*/2, /*vendorId=*/0,
+                                              /*productId=*/0,
+                                              /*sources=*/{InputDeviceUsageSource::UNKNOWN},
+                                              InputEventActionType::MOTION_ACTION_MOVE});
+}
+
 /**
  * For simplicity of the implementation, LatencyTracker only starts tracking an event when
  * 'trackListener' is invoked.
@@ -2231,6 +2231,34 @@ TEST_F(PointerChoreographerTest, SetPointerIconVisibilityHidesPointerWhenDeviceC
     ASSERT_FALSE(mousePc->isPointerShown());
 }
 
+TEST_F(PointerChoreographerTest, SetPointerIconVisibilityHidesPointerOfMovingMouse) {
+    mChoreographer.setDisplayViewports(createViewports({DISPLAY_ID}));
+    mChoreographer.setDefaultMouseDisplayId(DISPLAY_ID);
+    mChoreographer.notifyInputDevicesChanged(
+            {/*id=*/0,
+             {generateTestDeviceInfo(DEVICE_ID, AINPUT_SOURCE_MOUSE,
+                                     ui::LogicalDisplayId::INVALID)}});
+    auto mousePc = assertPointerControllerCreated(ControllerType::MOUSE);
+    const auto mouseMove = MotionArgsBuilder(AMOTION_EVENT_ACTION_HOVER_MOVE, AINPUT_SOURCE_MOUSE)
+                                   .pointer(MOUSE_POINTER)
+                                   .deviceId(DEVICE_ID)
+                                   .displayId(ui::LogicalDisplayId::INVALID)
+                                   .build();
+    mChoreographer.notifyMotion(mouseMove);
+    ASSERT_TRUE(mousePc->isPointerShown());
+
+    // Hide the pointer while the mouse is moving. The next events must not show it again.
+    mChoreographer.setPointerIconVisibility(DISPLAY_ID, false);
+    ASSERT_FALSE(mousePc->isPointerShown());
+    mChoreographer.notifyMotion(mouseMove);
+    ASSERT_FALSE(mousePc->isPointerShown());
+
+    // Once the pointer is allowed to be visible, the next movement shows it.
+    mChoreographer.setPointerIconVisibility(DISPLAY_ID, true);
+    mChoreographer.notifyMotion(mouseMove);
+    ASSERT_TRUE(mousePc->isPointerShown());
+}
+
 TEST_F(PointerChoreographerTest, SetPointerIconVisibilityHidesPointerForTouchpad) {
     mChoreographer.setDisplayViewports(createViewports({DISPLAY_ID}));
     mChoreographer.setDefaultMouseDisplayId(DISPLAY_ID);
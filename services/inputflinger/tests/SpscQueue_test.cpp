@@ -0,0 +1,111 @@
+/*
+ * Copyright (C) 2024 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "../dispatcher/SpscQueue.h"
+
+#include <gtest/gtest.h>
+#include <memory>
+#include <thread>
+
+namespace android::inputdispatcher {
+
+// --- SpscQueueTest ---
+
+TEST(SpscQueueTest, AddAndRemove) {
+    SpscQueue<int> queue(/*capacity=*/4);
+
+    ASSERT_TRUE(queue.push(1));
+    ASSERT_EQ(queue.pop(), 1);
+
+    ASSERT_TRUE(queue.push(3));
+    ASSERT_EQ(queue.pop(), 3);
+
+    ASSERT_EQ(std::nullopt, queue.pop());
+}
+
+// Add more elements than the capacity over time, so that the indices wrap around.
+TEST(SpscQueueTest, IsFIFO) {
+    SpscQueue<int> queue(/*capacity=*/4);
+
+    for (int i = 0; i < 10; i++) {
+        ASSERT_TRUE(queue.push(2 * i));
+        ASSERT_TRUE(queue.push(2 * i + 1));
+        ASSERT_EQ(queue.pop(), 2 * i);
+        ASSERT_EQ(queue.pop(), 2 * i + 1);
+    }
+    ASSERT_EQ(std::nullopt, queue.pop());
+}
+
+TEST(SpscQueueTest, QueueReachesCapacity) {
+    constexpr size_t capacity = 3;
+    SpscQueue<int> queue(capacity);
+    ASSERT_EQ(capacity, queue.capacity());
+
+    ASSERT_TRUE(queue.push(1));
+    ASSERT_TRUE(queue.push(2));
+    ASSERT_TRUE(queue.push(3));
+    ASSERT_FALSE(queue.push(4)) << "Queue should reach capacity at size " << capacity;
+
+    // Popping makes room again.
+    ASSERT_EQ(queue.pop(), 1);
+    ASSERT_TRUE(queue.push(4));
+    ASSERT_EQ(queue.pop(), 2);
+    ASSERT_EQ(queue.pop(), 3);
+    ASSERT_EQ(queue.pop(), 4);
+}
+
+// The objects are moved in and out of the queue, and released as soon as they are popped.
+TEST(SpscQueueTest, MovesObjects) {
+    SpscQueue<std::unique_ptr<int>> queue(/*capacity=*/2);
+    ASSERT_TRUE(queue.push(std::make_unique<int>(5)));
+    std::optional<std::unique_ptr<int>> popped = queue.pop();
+    ASSERT_TRUE(popped);
+    ASSERT_EQ(5, **popped);
+
+    SpscQueue<std::shared_ptr<int>> sharedQueue(/*capacity=*/2);
+    std::shared_ptr<int> shared = std::make_shared<int>(1);
+    ASSERT_TRUE(sharedQueue.push(shared));
+    ASSERT_EQ(2, shared.use_count());
+    sharedQueue.pop();
+    ASSERT_EQ(1, shared.use_count());
+}
+
+TEST(SpscQueueTest, AllowsProducerAndConsumerThreads) {
+    // A small queue with many items, so that the producer often finds the queue full.
+    SpscQueue<int> queue(/*capacity=*/8);
+    constexpr int numItems = 10000;
+
+    std::thread producer([&queue]() {
+        for (int i = 0; i < numItems; i++) {
+            while (!queue.push(i)) {
+                std::this_thread::yield();
+            }
+        }
+    });
+
+    // Make sure all elements are received in correct order.
+    for (int i = 0; i < numItems; i++) {
+        std::optional<int> popped;
+        do {
+            popped = queue.pop();
+        } while (!popped);
+        ASSERT_EQ(popped, i);
+    }
+
+    producer.join();
+}
+
+} // namespace android::inputdispatcher
@@ -0,0 +1,118 @@
+/*
+ * Copyright (C) 2024 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <gmock/gmock.h>
+#include <gtest/gtest.h>
+
+#include "../dispatcher/WindowHitIndex.h"
+
+// atest inputflinger_tests:WindowHitIndexTest
+
+using android::gui::WindowInfo;
+using android::gui::WindowInfoHandle;
+using testing::ElementsAre;
+using testing::IsEmpty;
+
+namespace android::inputdispatcher {
+
+namespace {
+
+sp<WindowInfoHandle> makeWindow(const Rect& frame, bool supportsSplitTouch = true) {
+    WindowInfo info;
+    info.frame = frame;
+    info.touchableRegion = Region(frame);
+    info.setInputConfig(WindowInfo::InputConfig::PREVENT_SPLITTING, !supportsSplitTouch);
+    return sp<WindowInfoHandle>::make(info);
+}
+
+} // namespace
+
+TEST(WindowHitIndexTest, EmptyIndexHasNoCandidates) {
+    WindowHitIndex index;
+    EXPECT_THAT(index.candidatesAt(10, 10), IsEmpty());
+}
+
+TEST(WindowHitIndexTest, CandidatesAreInZOrder) {
+    std::vector<sp<WindowInfoHandle>> windows{makeWindow(Rect(0, 0, 100, 100)),
+                                              makeWindow(Rect(0, 0, 1000, 1000)),
+                                              makeWindow(Rect(900, 900, 1000, 1000))};
+    WindowHitIndex index(windows, ui::Transform());
+
+    EXPECT_THAT(index.candidatesAt(10, 10), ElementsAre(0, 1));
+    EXPECT_THAT(index.candidatesAt(950, 950), ElementsAre(1, 2));
+    EXPECT_THAT(index.candidatesAt(500, 500), ElementsAre(1));
+    EXPECT_THAT(index.candidatesAt(2000, 2000), IsEmpty());
+}
+
+TEST(WindowHitIndexTest, CandidatesIncludeWindowsContainingTheLocation) {
+    std::vector<sp<WindowInfoHandle>> windows;
+    for (int32_t i = 0; i < 50; i++) {
+        windows.push_back(makeWindow(Rect(i * 20, i * 20, i * 20 + 100, i * 20 + 100)));
+    }
+    WindowHitIndex index(windows, ui::Transform());
+
+    for (float x = 0; x < 1200; x += 7) {
+        for (float y = 0; y < 1200; y += 13) {
+            std::vector<size_t> expected;
+            for (size_t i = 0; i < windows.size(); i++) {
+                if (windows[i]->getInfo()->frame.contains(int32_t(x), int32_t(y))) {
+                    expected.push_back(i);
+                }
+            }
+            const std::vector<size_t>& candidates = index.candidatesAt(x, y);
+            for (size_t i : expected) {
+                EXPECT_NE(std::find(candidates.begin(), candidates.end(), i), candidates.end())
+                        << "window " << i << " missing at " << x << ", " << y;
+            }
+        }
+    }
+}
+
+TEST(WindowHitIndexTest, UsesDisplayTransform) {
+    std::vector<sp<WindowInfoHandle>> windows{makeWindow(Rect(0, 0, 100, 100)),
+                                              makeWindow(Rect(900, 0, 1000, 100))};
+    // Mirrors the x axis, the windows and locations are transformed the same way.
+    ui::Transform transform;
+    transform.set(-1, 0, 0, 1);
+    transform.set(1000, 0);
+    WindowHitIndex index(windows, transform);
+
+    EXPECT_THAT(index.candidatesAt(50, 50), ElementsAre(0));
+    EXPECT_THAT(index.candidatesAt(950, 50), ElementsAre(1));
+    EXPECT_THAT(index.candidatesAt(-50, 50), IsEmpty());
+}
+
+TEST(WindowHitIndexTest, WindowsPreventingSplitsAreAlwaysCandidates) {
+    std::vector<sp<WindowInfoHandle>> windows{makeWindow(Rect(0, 0, 100, 100),
+                                                         /*supportsSplitTouch=*/false),
+                                              makeWindow(Rect(0, 0, 1000, 1000))};
+    WindowHitIndex index(windows, ui::Transform());
+
+    EXPECT_THAT(index.candidatesAt(500, 500), ElementsAre(0, 1));
+    EXPECT_THAT(index.candidatesAt(2000, 2000), ElementsAre(0));
+}
+
+TEST(WindowHitIndexTest, IndexOf) {
+    std::vector<sp<WindowInfoHandle>> windows{makeWindow(Rect(0, 0, 100, 100)),
+                                              makeWindow(Rect(0, 0, 1000, 1000))};
+    WindowHitIndex index(windows, ui::Transform());
+
+    EXPECT_EQ(0u, index.indexOf(windows[0]));
+    EXPECT_EQ(1u, index.indexOf(windows[1]));
+    EXPECT_EQ(2u, index.indexOf(makeWindow(Rect(0, 0, 100, 100))));
+}
+
+} // namespace android::inputdispatcher
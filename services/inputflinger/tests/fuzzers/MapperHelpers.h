@@ -152,13 +152,12 @@ public:
         return mFdp->ConsumeIntegral<status_t>();
     }
     void setExcludedDevices(const std::vector<std::string>& devices) override {}
-    std::vector<RawEvent> getEvents(int timeoutMillis) override {
-        std::vector<RawEvent> events;
+    void getEvents(int timeoutMillis, std::vector<RawEvent>& outEvents) override {
+        outEvents.clear();
         const size_t count = mFdp->ConsumeIntegralInRange<size_t>(0, kMaxSize);
         for (size_t i = 0; i < count; ++i) {
-            events.push_back(getFuzzedRawEvent(*mFdp));
+            outEvents.push_back(getFuzzedRawEvent(*mFdp));
         }
-        return events;
     }
     std::vector<TouchVideoFrame> getVideoFrames(int32_t deviceId) override { return mVideoFrames; }
 
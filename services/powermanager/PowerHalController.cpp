@@ -70,15 +70,20 @@ void PowerHalController::init() {
 // Check validity of current handle to the power HAL service, and create a new
 // one if necessary.
 std::shared_ptr<HalWrapper> PowerHalController::initHal() {
+    if (std::shared_ptr<HalWrapper> handle = std::atomic_load(&mConnectedHal)) {
+        return handle;
+    }
     std::lock_guard<std::mutex> lock(mConnectedHalMutex);
-    if (mConnectedHal == nullptr) {
-        mConnectedHal = mHalConnector->connect();
-        if (mConnectedHal == nullptr) {
+    std::shared_ptr<HalWrapper> handle = std::atomic_load(&mConnectedHal);
+    if (handle == nullptr) {
+        handle = mHalConnector->connect();
+        if (handle == nullptr) {
             // Unable to connect to Power HAL service. Fallback to default.
             return mDefaultHal;
         }
+        std::atomic_store(&mConnectedHal, handle);
     }
-    return mConnectedHal;
+    return handle;
 }
 
 // Using statement expression macro instead of a method lets the static be
@@ -105,7 +110,7 @@ HalResult<T> PowerHalController::processHalResult(HalResult<T>&& result, const c
         ALOGE("%s failed: %s", fnName, result.errorMessage());
         std::lock_guard<std::mutex> lock(mConnectedHalMutex);
         // Drop Power HAL handle. This will force future api calls to reconnect.
-        mConnectedHal = nullptr;
+        std::atomic_store(&mConnectedHal, std::shared_ptr<HalWrapper>());
         mHalConnector->reset();
     }
     return std::move(result);
@@ -187,11 +187,21 @@ HalResult<void> HidlHalWrapperV1_3::sendPowerHint(V1_3::PowerHint hintId, uint32
 // -------------------------------------------------------------------------------------------------
 
 HalResult<void> AidlHalWrapper::setBoost(Aidl::Boost boost, int32_t durationMs) {
-    std::unique_lock<std::mutex> lock(mBoostMutex);
     size_t idx = static_cast<size_t>(boost);
 
     // Quick return if boost is not supported by HAL
-    if (idx >= mBoostSupportedArray.size() || mBoostSupportedArray[idx] == HalSupport::OFF) {
+    if (idx >= mBoostSupportedArray.size() ||
+        mBoostSupportedArray[idx].load(std::memory_order_relaxed) == HalSupport::OFF) {
+        ALOGV("Skipped setBoost %s because %s", toString(boost).c_str(), getUnsupportedMessage());
+        return HalResult<void>::unsupported();
+    }
+
+    // Only take the lock to check support the first time.
+    std::unique_lock<std::mutex> lock(mBoostMutex, std::defer_lock);
+    if (mBoostSupportedArray[idx].load(std::memory_order_relaxed) == HalSupport::UNKNOWN) {
+        lock.lock();
+    }
+    if (mBoostSupportedArray[idx] == HalSupport::OFF) {
         ALOGV("Skipped setBoost %s because %s", toString(boost).c_str(), getUnsupportedMessage());
         return HalResult<void>::unsupported();
     }
@@ -213,17 +223,27 @@ HalResult<void> AidlHalWrapper::setBoost(Aidl::Boost boost, int32_t durationMs)
             return HalResult<void>::unsupported();
         }
     }
-    lock.unlock();
+    if (lock.owns_lock()) lock.unlock();
 
     return HalResult<void>::fromStatus(mHandle->setBoost(boost, durationMs));
 }
 
 HalResult<void> AidlHalWrapper::setMode(Aidl::Mode mode, bool enabled) {
-    std::unique_lock<std::mutex> lock(mModeMutex);
     size_t idx = static_cast<size_t>(mode);
 
     // Quick return if mode is not supported by HAL
-    if (idx >= mModeSupportedArray.size() || mModeSupportedArray[idx] == HalSupport::OFF) {
+    if (idx >= mModeSupportedArray.size() ||
+        mModeSupportedArray[idx].load(std::memory_order_relaxed) == HalSupport::OFF) {
+        ALOGV("Skipped setMode %s because %s", toString(mode).c_str(), getUnsupportedMessage());
+        return HalResult<void>::unsupported();
+    }
+
+    // Only take the lock to check support the first time.
+    std::unique_lock<std::mutex> lock(mModeMutex, std::defer_lock);
+    if (mModeSupportedArray[idx].load(std::memory_order_relaxed) == HalSupport::UNKNOWN) {
+        lock.lock();
+    }
+    if (mModeSupportedArray[idx] == HalSupport::OFF) {
         ALOGV("Skipped setMode %s because %s", toString(mode).c_str(), getUnsupportedMessage());
         return HalResult<void>::unsupported();
     }
@@ -241,7 +261,7 @@ HalResult<void> AidlHalWrapper::setMode(Aidl::Mode mode, bool enabled) {
             return HalResult<void>::unsupported();
         }
     }
-    lock.unlock();
+    if (lock.owns_lock()) lock.unlock();
 
     return HalResult<void>::fromStatus(mHandle->setMode(mode, enabled));
 }
@@ -69,6 +69,35 @@ FWD_CALL(4, sendHint, (SessionHint in_hint), (in_hint));
 FWD_CALL(4, setThreads, (const std::vector<int32_t>& in_threadIds), (in_threadIds));
 FWD_CALL(5, setMode, (SessionMode in_type, bool in_enabled), (in_type, in_enabled));
 
+HalResult<void> PowerHintSessionWrapper::queueActualWorkDuration(const WorkDuration& duration,
+                                                                 size_t maxBatchSize) {
+    std::vector<WorkDuration> durations;
+    {
+        std::lock_guard<std::mutex> lock(mQueueMutex);
+        mQueuedDurations.push_back(duration);
+        if (mQueuedDurations.size() < maxBatchSize) {
+            return HalResult<void>::ok();
+        }
+        // Swap out the queue so that the call is made without holding the lock.
+        durations.swap(mQueuedDurations);
+        mQueuedDurations.reserve(durations.size());
+    }
+    return reportActualWorkDuration(durations);
+}
+
+HalResult<void> PowerHintSessionWrapper::flushActualWorkDurations() {
+    std::vector<WorkDuration> durations;
+    {
+        std::lock_guard<std::mutex> lock(mQueueMutex);
+        if (mQueuedDurations.empty()) {
+            return HalResult<void>::ok();
+        }
+        durations.swap(mQueuedDurations);
+        mQueuedDurations.reserve(durations.size());
+    }
+    return reportActualWorkDuration(durations);
+}
+
 HalResult<SessionConfig> PowerHintSessionWrapper::getSessionConfig() {
     CHECK_SESSION(SessionConfig);
     SessionConfig config;
@@ -25,7 +25,10 @@
 
 using aidl::android::hardware::power::Boost;
 using aidl::android::hardware::power::Mode;
+using android::power::EmptyHalWrapper;
+using android::power::HalConnector;
 using android::power::HalResult;
+using android::power::HalWrapper;
 using android::power::PowerHalController;
 
 using namespace android;
@@ -71,6 +74,24 @@ static void runCachedBenchmark(benchmark::State& state,
     }
 }
 
+// Connects to a HAL wrapper that makes no binder calls, to measure the overhead of the
+// controller itself.
+class EmptyHalConnector : public HalConnector {
+public:
+    std::unique_ptr<HalWrapper> connect() override { return std::make_unique<EmptyHalWrapper>(); }
+    void reset() override {}
+    int32_t getAidlVersion() override { return 0; }
+};
+
+static void BM_PowerHalControllerBenchmarks_setBoostOverhead(benchmark::State& state) {
+    // Shared by all threads, and connected on first use.
+    static PowerHalController controller(std::make_unique<EmptyHalConnector>());
+
+    while (state.KeepRunning()) {
+        benchmark::DoNotOptimize(controller.setBoost(Boost::INTERACTION, 0));
+    }
+}
+
 static void BM_PowerHalControllerBenchmarks_init(benchmark::State& state) {
     while (state.KeepRunning()) {
         PowerHalController controller;
@@ -108,6 +129,7 @@ static void BM_PowerHalControllerBenchmarks_setModeCached(benchmark::State& stat
     runCachedBenchmark(state, &PowerHalController::setMode, mode, false);
 }
 
+BENCHMARK(BM_PowerHalControllerBenchmarks_setBoostOverhead)->ThreadRange(1, 8);
 BENCHMARK(BM_PowerHalControllerBenchmarks_init);
 BENCHMARK(BM_PowerHalControllerBenchmarks_initCached);
 BENCHMARK(BM_PowerHalControllerBenchmarks_setBoost)->DenseRange(FIRST_BOOST, LAST_BOOST, 1);
@@ -138,3 +138,19 @@ TEST_F(PowerHintSessionWrapperTest, getSessionConfig) {
     auto status = mSession->getSessionConfig();
     ASSERT_TRUE(status.isOk());
 }
+
+TEST_F(PowerHintSessionWrapperTest, queueActualWorkDurationSendsBatches) {
+    ::aidl::android::hardware::power::WorkDuration duration;
+    EXPECT_CALL(*mMockSession.get(), reportActualWorkDuration(SizeIs(3)))
+            .WillOnce(Return(ndk::ScopedAStatus::ok()));
+    EXPECT_CALL(*mMockSession.get(), reportActualWorkDuration(SizeIs(1)))
+            .WillOnce(Return(ndk::ScopedAStatus::ok()));
+
+    for (int i = 0; i < 4; i++) {
+        duration.durationNanos = i;
+        ASSERT_TRUE(mSession->queueActualWorkDuration(duration, 3).isOk());
+    }
+    ASSERT_TRUE(mSession->flushActualWorkDurations().isOk());
+    // Nothing is left to send.
+    ASSERT_TRUE(mSession->flushActualWorkDurations().isOk());
+}
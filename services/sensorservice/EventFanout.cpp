@@ -0,0 +1,138 @@
+/*
+ * Copyright (C) 2024 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "EventFanout.h"
+
+#include <log/log.h>
+#include <sched.h>
+#include <utils/String8.h>
+#include <utils/Thread.h>
+
+namespace android {
+namespace SensorServiceUtil {
+
+class EventFanout::Worker : public Thread {
+public:
+    Worker(EventFanout& fanout, size_t scratchSize, int schedFifoPriority)
+          : Thread(/*canCallJava=*/false),
+            mFanout(fanout),
+            mScratch(new sensors_event_t[scratchSize]),
+            mSchedFifoPriority(schedFifoPriority) {}
+
+private:
+    status_t readyToRun() override {
+        struct sched_param param = {0};
+        param.sched_priority = mSchedFifoPriority;
+        if (sched_setscheduler(0, SCHED_FIFO | SCHED_RESET_ON_FORK, &param) != 0) {
+            ALOGE("Couldn't set SCHED_FIFO for event fan-out thread");
+        }
+        return NO_ERROR;
+    }
+
+    bool threadLoop() override { return mFanout.waitAndRunTasks(mLastGeneration, mScratch.get()); }
+
+    EventFanout& mFanout;
+    std::unique_ptr<sensors_event_t[]> mScratch;
+    const int mSchedFifoPriority;
+    uint64_t mLastGeneration = 0;
+};
+
+EventFanout::EventFanout(size_t workerCount, size_t scratchSize, int schedFifoPriority) {
+    for (size_t i = 0; i < workerCount; i++) {
+        sp<Worker> worker = sp<Worker>::make(*this, scratchSize, schedFifoPriority);
+        if (worker->run(String8::format("SensorFanout%zu", i), PRIORITY_URGENT_DISPLAY) !=
+            NO_ERROR) {
+            ALOGE("Couldn't start event fan-out thread %zu", i);
+            break;
+        }
+        mWorkers.push_back(std::move(worker));
+    }
+}
+
+EventFanout::~EventFanout() {
+    for (const sp<Worker>& worker : mWorkers) {
+        worker->requestExit();
+    }
+    {
+        std::scoped_lock lock(mLock);
+        mExiting = true;
+    }
+    mWorkAvailable.notify_all();
+    for (const sp<Worker>& worker : mWorkers) {
+        worker->join();
+    }
+}
+
+void EventFanout::run(size_t count, sensors_event_t* scratch, const Task& task) {
+    if (count == 0) {
+        return;
+    }
+    {
+        std::unique_lock lock(mLock);
+        mWorkDone.wait(lock, [this]() { return mBusyWorkers == 0; });
+        mTask = &task;
+        mCount = count;
+        mNextIndex = 0;
+        mRemaining = count;
+        mGeneration++;
+    }
+    mWorkAvailable.notify_all();
+
+    runTasks(scratch);
+
+    std::unique_lock lock(mLock);
+    mWorkDone.wait(lock, [this]() { return mRemaining == 0; });
+    mTask = nullptr;
+}
+
+bool EventFanout::waitAndRunTasks(uint64_t& lastGeneration, sensors_event_t* scratch) {
+    {
+        std::unique_lock lock(mLock);
+        mWorkAvailable.wait(lock,
+                            [&]() { return mExiting || mGeneration != lastGeneration; });
+        if (mExiting) {
+            return false;
+        }
+        lastGeneration = mGeneration;
+        mBusyWorkers++;
+    }
+
+    runTasks(scratch);
+
+    {
+        std::scoped_lock lock(mLock);
+        mBusyWorkers--;
+    }
+    mWorkDone.notify_all();
+    return true;
+}
+
+void EventFanout::runTasks(sensors_event_t* scratch) {
+    for (size_t index = mNextIndex++; index < mCount; index = mNextIndex++) {
+        (*mTask)(index, scratch);
+        bool done;
+        {
+            std::scoped_lock lock(mLock);
+            done = --mRemaining == 0;
+        }
+        if (done) {
+            mWorkDone.notify_all();
+        }
+    }
+}
+
+} // namespace SensorServiceUtil
+} // namespace android
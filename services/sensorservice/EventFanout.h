@@ -0,0 +1,82 @@
+/*
+ * Copyright (C) 2024 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef ANDROID_SENSOR_SERVICE_UTIL_EVENT_FANOUT_H
+#define ANDROID_SENSOR_SERVICE_UTIL_EVENT_FANOUT_H
+
+#include <hardware/sensors.h>
+#include <utils/StrongPointer.h>
+
+#include <atomic>
+#include <condition_variable>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+namespace android {
+namespace SensorServiceUtil {
+
+// Runs the same task for many clients at once on a small pool of worker threads, so that sending
+// a batch of events to every connection does not take the sum of the time of every connection.
+//
+// Each worker owns a scratch buffer that it hands to the task, so tasks that filter the events
+// into a scratch buffer can run at the same time. The thread calling run() runs tasks too, using
+// the scratch buffer it passes in.
+class EventFanout {
+public:
+    using Task = std::function<void(size_t index, sensors_event_t* scratch)>;
+
+    // The workers use SCHED_FIFO with the given priority, so that the thread waiting for them is
+    // not held back by lower priority threads.
+    EventFanout(size_t workerCount, size_t scratchSize, int schedFifoPriority);
+    ~EventFanout();
+
+    // Run the task for each index in [0, count), and return once all of them have finished.
+    // Must not be called by more than one thread at a time.
+    void run(size_t count, sensors_event_t* scratch, const Task& task);
+
+    size_t getWorkerCount() const { return mWorkers.size(); }
+
+private:
+    class Worker;
+
+    // Wait for the next run and take part in it. Returns false when the fan-out is destroyed.
+    bool waitAndRunTasks(uint64_t& lastGeneration, sensors_event_t* scratch);
+    void runTasks(sensors_event_t* scratch);
+
+    std::mutex mLock;
+    std::condition_variable mWorkAvailable;
+    std::condition_variable mWorkDone;
+    // Incremented for every run, so that the workers know that there is new work.
+    uint64_t mGeneration = 0;
+    const Task* mTask = nullptr;
+    size_t mCount = 0;
+    std::atomic<size_t> mNextIndex = 0;
+    // The number of tasks of the current run that have not finished yet.
+    size_t mRemaining = 0;
+    // The number of workers that are taking part in a run. A new run can only start once this is
+    // zero, so that a late worker does not pick up an index of the new run with the old count.
+    size_t mBusyWorkers = 0;
+    bool mExiting = false;
+
+    std::vector<sp<Worker>> mWorkers;
+};
+
+} // namespace SensorServiceUtil
+} // namespace android
+
+#endif // ANDROID_SENSOR_SERVICE_UTIL_EVENT_FANOUT_H
@@ -23,6 +23,9 @@
 
 #include <inttypes.h>
 
+#include <algorithm>
+#include <thread>
+
 namespace android {
 namespace SensorServiceUtil {
 
@@ -33,37 +36,88 @@ namespace {
 }// unnamed namespace
 
 RecentEventLogger::RecentEventLogger(int sensorType) :
-        mSensorType(sensorType), mEventSize(eventSizeBySensorType(mSensorType)),
-        mRecentEvents(logSizeBySensorType(sensorType)), mMaskData(false),
-        mIsLastEventCurrent(false) {
+        mSensorType(sensorType), mEventSize(eventSizeBySensorType(mSensorType)), mSequence(0),
+        mRecentEvents(logSizeBySensorType(sensorType)), mCount(0),
+        mLatestIndex(mRecentEvents.size() - 1), mIsLastEventCurrent(false), mMaskData(false) {
     // blank
 }
 
 void RecentEventLogger::addEvent(const sensors_event_t& event) {
-    std::lock_guard<std::mutex> lk(mLock);
-    mRecentEvents.emplace(event);
-    mIsLastEventCurrent = true;
+    // Read the wall time before entering the write section, to keep it short.
+    const SensorEventLog log(event);
+    const size_t index = (mLatestIndex.load(std::memory_order_relaxed) + 1) % mRecentEvents.size();
+
+    const uint32_t sequence = beginWrite();
+    mRecentEvents[index] = log;
+    mLatestIndex.store(index, std::memory_order_relaxed);
+    mCount.store(std::min(mCount.load(std::memory_order_relaxed) + 1, mRecentEvents.size()),
+                 std::memory_order_relaxed);
+    mIsLastEventCurrent.store(true, std::memory_order_relaxed);
+    endWrite(sequence);
 }
 
 bool RecentEventLogger::isEmpty() const {
-    return mRecentEvents.size() == 0;
+    return mCount.load(std::memory_order_relaxed) == 0;
 }
 
 void RecentEventLogger::setLastEventStale() {
-    std::lock_guard<std::mutex> lk(mLock);
-    mIsLastEventCurrent = false;
+    const uint32_t sequence = beginWrite();
+    mIsLastEventCurrent.store(false, std::memory_order_relaxed);
+    endWrite(sequence);
+}
+
+uint32_t RecentEventLogger::beginWrite() {
+    const uint32_t sequence = mSequence.load(std::memory_order_relaxed) + 1;
+    mSequence.store(sequence, std::memory_order_relaxed);
+    // Readers that see any of the writes below also see the odd sequence count.
+    std::atomic_thread_fence(std::memory_order_release);
+    return sequence;
+}
+
+void RecentEventLogger::endWrite(uint32_t sequence) {
+    mSequence.store(sequence + 1, std::memory_order_release);
+}
+
+uint32_t RecentEventLogger::beginRead() const {
+    uint32_t sequence;
+    while ((sequence = mSequence.load(std::memory_order_acquire)) & 1) {
+        std::this_thread::yield();
+    }
+    return sequence;
+}
+
+bool RecentEventLogger::endRead(uint32_t sequence) const {
+    std::atomic_thread_fence(std::memory_order_acquire);
+    return mSequence.load(std::memory_order_relaxed) == sequence;
+}
+
+std::vector<RecentEventLogger::SensorEventLog> RecentEventLogger::getRecentEvents() const {
+    std::vector<SensorEventLog> events;
+    events.reserve(mRecentEvents.size());
+    uint32_t sequence;
+    do {
+        events.clear();
+        sequence = beginRead();
+        const size_t count = mCount.load(std::memory_order_relaxed);
+        const size_t latestIndex = mLatestIndex.load(std::memory_order_relaxed);
+        for (size_t i = 0; i < count; i++) {
+            events.push_back(
+                    mRecentEvents[(latestIndex + mRecentEvents.size() - i) % mRecentEvents.size()]);
+        }
+    } while (!endRead(sequence));
+    return events;
 }
 
 std::string RecentEventLogger::dump() const {
-    std::lock_guard<std::mutex> lk(mLock);
+    const std::vector<SensorEventLog> recentEvents = getRecentEvents();
 
     //TODO: replace String8 with std::string completely in this function
     String8 buffer;
 
-    buffer.appendFormat("last %zu events\n", mRecentEvents.size());
+    buffer.appendFormat("last %zu events\n", recentEvents.size());
     int j = 0;
-    for (int i = mRecentEvents.size() - 1; i >= 0; --i) {
-        const auto& ev = mRecentEvents[i];
+    for (int i = recentEvents.size() - 1; i >= 0; --i) {
+        const auto& ev = recentEvents[i];
         struct tm * timeinfo = localtime(&(ev.mWallTime.tv_sec));
         buffer.appendFormat("\t%2d (ts=%.9f, wall=%02d:%02d:%02d.%03d) ",
                 ++j, ev.mEvent.timestamp/1e9, timeinfo->tm_hour, timeinfo->tm_min, timeinfo->tm_sec,
@@ -95,11 +149,11 @@ std::string RecentEventLogger::dump() const {
  */
 void RecentEventLogger::dump(util::ProtoOutputStream* proto) const {
     using namespace service::SensorEventsProto;
-    std::lock_guard<std::mutex> lk(mLock);
+    const std::vector<SensorEventLog> recentEvents = getRecentEvents();
 
-    proto->write(RecentEventsLog::RECENT_EVENTS_COUNT, int(mRecentEvents.size()));
-    for (int i = mRecentEvents.size() - 1; i >= 0; --i) {
-        const auto& ev = mRecentEvents[i];
+    proto->write(RecentEventsLog::RECENT_EVENTS_COUNT, int(recentEvents.size()));
+    for (int i = recentEvents.size() - 1; i >= 0; --i) {
+        const auto& ev = recentEvents[i];
         const uint64_t token = proto->start(RecentEventsLog::EVENTS);
         proto->write(Event::TIMESTAMP_SEC, float(ev.mEvent.timestamp) / 1e9f);
         proto->write(Event::WALL_TIMESTAMP_MS, ev.mWallTime.tv_sec * 1000LL
@@ -129,15 +183,17 @@ void RecentEventLogger::setFormat(std::string format) {
 }
 
 bool RecentEventLogger::populateLastEventIfCurrent(sensors_event_t *event) const {
-    std::lock_guard<std::mutex> lk(mLock);
-
-    if (mIsLastEventCurrent && mRecentEvents.size()) {
-        // Index 0 contains the latest event emplace()'ed
-        *event = mRecentEvents[0].mEvent;
-        return true;
-    } else {
-        return false;
-    }
+    bool isCurrent;
+    uint32_t sequence;
+    do {
+        sequence = beginRead();
+        isCurrent = mIsLastEventCurrent.load(std::memory_order_relaxed) &&
+                mCount.load(std::memory_order_relaxed) > 0;
+        if (isCurrent) {
+            *event = mRecentEvents[mLatestIndex.load(std::memory_order_relaxed)].mEvent;
+        }
+    } while (!endRead(sequence));
+    return isCurrent;
 }
 
 
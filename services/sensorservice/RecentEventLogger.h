@@ -17,13 +17,13 @@
 #ifndef ANDROID_SENSOR_SERVICE_UTIL_RECENT_EVENT_LOGGER_H
 #define ANDROID_SENSOR_SERVICE_UTIL_RECENT_EVENT_LOGGER_H
 
-#include "RingBuffer.h"
 #include "SensorServiceUtils.h"
 
 #include <hardware/sensors.h>
 #include <utils/String8.h>
 
-#include <mutex>
+#include <atomic>
+#include <vector>
 
 namespace android {
 namespace SensorServiceUtil {
@@ -33,6 +33,10 @@ namespace SensorServiceUtil {
 // generated from the sensor are stored in this buffer.  The buffer is NOT cleared when the sensor
 // unregisters and as a result very old data in the dumpsys output can be seen, which is an intended
 // behavior.
+//
+// The buffer is guarded by a seqlock, so that reading it never blocks the thread recording the
+// events. addEvent() and setLastEventStale() must not be called concurrently with each other; the
+// other methods can be called from any thread.
 class RecentEventLogger : public Dumpable {
 public:
     explicit RecentEventLogger(int sensorType);
@@ -53,22 +57,37 @@ public:
 
 protected:
     struct SensorEventLog {
+        SensorEventLog() = default;
         explicit SensorEventLog(const sensors_event_t& e);
         timespec mWallTime;
         sensors_event_t mEvent;
     };
 
+    // Copy of the recorded events, the latest one first.
+    std::vector<SensorEventLog> getRecentEvents() const;
+
     const int mSensorType;
     const size_t mEventSize;
 
-    mutable std::mutex mLock;
-    RingBuffer<SensorEventLog> mRecentEvents;
+    // Sequence count of the seqlock guarding the fields below. It is odd while they are written.
+    std::atomic<uint32_t> mSequence;
+    // Fixed size circular buffer of the events, of which mCount are recorded and the latest one is
+    // at mLatestIndex.
+    std::vector<SensorEventLog> mRecentEvents;
+    std::atomic<size_t> mCount;
+    std::atomic<size_t> mLatestIndex;
+    std::atomic<bool> mIsLastEventCurrent;
 
     bool mMaskData;
-    bool mIsLastEventCurrent;
 
 private:
     static size_t logSizeBySensorType(int sensorType);
+
+    uint32_t beginWrite();
+    void endWrite(uint32_t sequence);
+    uint32_t beginRead() const;
+    // Returns false if the fields were written since beginRead(), and have to be read again.
+    bool endRead(uint32_t sequence) const;
 };
 
 } // namespace SensorServiceUtil
@@ -167,6 +167,11 @@ void SensorDevice::reconnect() {
 
     mActivationCount.clear();
     mSensorList.clear();
+    {
+        // The flushes sent to the previous HAL instance will not complete.
+        std::lock_guard<std::mutex> lock(mPendingFlushesMutex);
+        mPendingFlushes.clear();
+    }
     if (sensorservice_flags::dynamic_sensor_hal_reconnect_handling()) {
         mConnectedDynamicSensors.clear();
     }
@@ -301,9 +306,14 @@ std::string SensorDevice::dump() const {
                                                                                   : "",
                                 (j < info.batchParams.size() - 1) ? ", " : "");
         }
-        result.appendFormat("}, selected = %.2f ms\n", info.bestBatchParams.mTBatch / 1e6f);
+        result.appendFormat("}, selected = %.2f ms; hal_batch_calls = %" PRIu32 "\n",
+                            info.bestBatchParams.mTBatch / 1e6f, info.halBatchCalls);
     }
 
+    result.appendFormat("Wake-up polls = %" PRIu64 ", wake-up events = %" PRIu64
+                        ", internal flushes = %" PRIu64 "\n",
+                        mWakeUpPolls.load(), mWakeUpEvents.load(), mInternalFlushes.load());
+
     return result.c_str();
 }
 
@@ -381,6 +391,7 @@ ssize_t SensorDevice::poll(sensors_event_t* buffer, size_t count) {
     }
 
     if (eventsRead > 0) {
+        eventsRead = removeInternalFlushCompleteEvents(buffer, eventsRead);
         for (ssize_t i = 0; i < eventsRead; i++) {
             float resolution = getResolutionForSensor(buffer[i].sensor);
             android::SensorDeviceUtils::quantizeSensorEventValues(&buffer[i], resolution);
@@ -445,6 +456,8 @@ void SensorDevice::cleanupDisconnectedDynamicSensor(int handle) {
 }
 
 void SensorDevice::writeWakeLockHandled(uint32_t count) {
+    mWakeUpPolls++;
+    mWakeUpEvents += count;
     if (mHalWrapper != nullptr && mHalWrapper->supportsMessageQueues()) {
         mHalWrapper->writeWakeLockHandled(count);
     }
@@ -530,6 +543,7 @@ status_t SensorDevice::activateLocked(void* ident, int handle, int enabled) {
                          handle, info.bestBatchParams.mTSample, info.bestBatchParams.mTBatch);
                 mHalWrapper->batch(handle, info.bestBatchParams.mTSample,
                                    info.bestBatchParams.mTBatch);
+                info.halBatchCalls++;
             }
         } else {
             // sensor wasn't enabled for this ident
@@ -631,11 +645,87 @@ status_t SensorDevice::updateBatchParamsLocked(int handle, Info& info) {
                  info.bestBatchParams.mTSample, info.bestBatchParams.mTBatch);
         err = mHalWrapper->batch(handle, info.bestBatchParams.mTSample,
                                  info.bestBatchParams.mTBatch);
+        info.halBatchCalls++;
+
+        // The HAL may hold events batched with the previous report latency for longer than the
+        // new one allows. Flush them so that the client asking for the lower latency gets them now.
+        if (err == NO_ERROR && info.isActive &&
+            sensorservice_flags::sensor_device_latency_classes() &&
+            prevBestBatchParams.mTBatch > info.bestBatchParams.mTBatch) {
+            ALOGD_IF(DEBUG_CONNECTIONS, "\t>>> actuating internal h/w flush %d", handle);
+            if (flushHal(handle, /*internal=*/true) == NO_ERROR) {
+                mInternalFlushes++;
+            }
+        }
     }
 
     return err;
 }
 
+nsecs_t SensorDevice::getLatencyClass(nsecs_t maxBatchReportLatencyNs) {
+    static constexpr nsecs_t kLatencyClasses[] = {
+            ms2ns(20), ms2ns(50), ms2ns(100), ms2ns(200), ms2ns(500), s2ns(1),
+            s2ns(2),   s2ns(5),   s2ns(10),   s2ns(30),   s2ns(60),
+    };
+    // Round down, so that no client gets its events later than it asked for.
+    nsecs_t latencyClass = 0;
+    for (nsecs_t boundary : kLatencyClasses) {
+        if (boundary > maxBatchReportLatencyNs) break;
+        latencyClass = boundary;
+    }
+    return latencyClass;
+}
+
+status_t SensorDevice::flushHal(int handle, bool internal) {
+    uint64_t id;
+    {
+        std::lock_guard<std::mutex> lock(mPendingFlushesMutex);
+        id = mNextFlushId++;
+        mPendingFlushes[handle].push_back({id, internal});
+    }
+
+    status_t err = mHalWrapper->flush(handle);
+    if (err != NO_ERROR) {
+        // No flush complete event will come for this flush.
+        std::lock_guard<std::mutex> lock(mPendingFlushesMutex);
+        std::deque<PendingFlush>& flushes = mPendingFlushes[handle];
+        flushes.erase(std::remove_if(flushes.begin(), flushes.end(),
+                                     [id](const PendingFlush& flush) { return flush.id == id; }),
+                      flushes.end());
+    }
+    return err;
+}
+
+ssize_t SensorDevice::removeInternalFlushCompleteEvents(sensors_event_t* buffer, ssize_t count) {
+    std::lock_guard<std::mutex> lock(mPendingFlushesMutex);
+    if (mPendingFlushes.empty()) return count;
+
+    ssize_t kept = 0;
+    for (ssize_t i = 0; i < count; i++) {
+        if (buffer[i].type == SENSOR_TYPE_META_DATA &&
+            buffer[i].meta_data.what == META_DATA_FLUSH_COMPLETE) {
+            auto it = mPendingFlushes.find(buffer[i].meta_data.sensor);
+            if (it != mPendingFlushes.end() && !it->second.empty()) {
+                const bool internal = it->second.front().internal;
+                it->second.pop_front();
+                if (it->second.empty()) {
+                    mPendingFlushes.erase(it);
+                }
+                if (internal) {
+                    // Nobody is waiting for this flush, SensorService must not attribute it to
+                    // a client.
+                    continue;
+                }
+            }
+        }
+        if (kept != i) {
+            buffer[kept] = buffer[i];
+        }
+        kept++;
+    }
+    return kept;
+}
+
 status_t SensorDevice::setDelay(void* ident, int handle, int64_t samplingPeriodNs) {
     return batch(ident, handle, 0, samplingPeriodNs, 0);
 }
@@ -649,7 +739,7 @@ status_t SensorDevice::flush(void* ident, int handle) {
     if (mHalWrapper == nullptr) return NO_INIT;
     if (isClientDisabled(ident)) return INVALID_OPERATION;
     ALOGD_IF(DEBUG_CONNECTIONS, "\t>>> actuating h/w flush %d", handle);
-    return mHalWrapper->flush(handle);
+    return flushHal(handle, /*internal=*/false);
 }
 
 bool SensorDevice::isClientDisabled(void* ident) const {
@@ -749,6 +839,7 @@ void SensorDevice::enableAllSensors() {
                  sensor_handle);
         status_t err = mHalWrapper->batch(sensor_handle, info.bestBatchParams.mTSample,
                                           info.bestBatchParams.mTBatch);
+        info.halBatchCalls++;
         ALOGE_IF(err, "Error calling batch on sensor %d (%s)", sensor_handle, strerror(-err));
 
         if (err == NO_ERROR) {
@@ -893,6 +984,9 @@ void SensorDevice::Info::selectBatchParams() {
         }
         bestParams.merge(batchParams[i]);
     }
+    if (sensorservice_flags::sensor_device_latency_classes()) {
+        bestParams.mTBatch = getLatencyClass(bestParams.mTBatch);
+    }
     // if mTBatch <= mTSample, it is in streaming mode. set mTbatch to 0 to demand this explicitly.
     if (bestParams.mTBatch <= bestParams.mTSample) {
         bestParams.mTBatch = 0;
@@ -35,7 +35,9 @@
 #include <utils/Timers.h>
 
 #include <algorithm> //std::max std::min
+#include <atomic>
 #include <condition_variable>
+#include <deque>
 #include <mutex>
 #include <queue>
 #include <string>
@@ -171,6 +173,9 @@ private:
         // Flag to track if the sensor is active
         bool isActive = false;
 
+        // The number of batch calls made to the HAL for this sensor, for dumpsys.
+        uint32_t halBatchCalls = 0;
+
         // Sets batch parameters for this ident. Returns error if this ident is not already present
         // in the KeyedVector above.
         status_t setBatchParamsForIdent(void* ident, int flags, int64_t samplingPeriodNs,
@@ -227,6 +232,34 @@ private:
                          int64_t maxBatchReportLatencyNs);
 
     status_t updateBatchParamsLocked(int handle, Info& info);
+
+    // The batch report latencies that the latency selected for a sensor is rounded down to. Rounding
+    // keeps the HAL configuration stable when clients ask for slightly different latencies, and
+    // gives sensors with similar latencies the same one, so that the HAL can deliver their batches
+    // in the same AP wakeup.
+    static nsecs_t getLatencyClass(nsecs_t maxBatchReportLatencyNs);
+
+    // Flushes in the order they were sent to the HAL for a sensor, so that the flush complete
+    // events of the flushes that SensorDevice makes itself can be told apart from the ones
+    // requested by clients.
+    struct PendingFlush {
+        uint64_t id;
+        bool internal;
+    };
+    std::mutex mPendingFlushesMutex;
+    std::unordered_map<int, std::deque<PendingFlush>> mPendingFlushes;
+    uint64_t mNextFlushId = 0;
+
+    // Send a flush to the HAL, and remember it in mPendingFlushes.
+    status_t flushHal(int handle, bool internal);
+    // Remove the flush complete events of internal flushes from the buffer. Returns the new count.
+    ssize_t removeInternalFlushCompleteEvents(sensors_event_t* buffer, ssize_t count);
+
+    // Power metrics, for dumpsys.
+    std::atomic<uint64_t> mInternalFlushes = 0;
+    std::atomic<uint64_t> mWakeUpPolls = 0;
+    std::atomic<uint64_t> mWakeUpEvents = 0;
+
     status_t doActivateHardwareLocked(int handle, bool enable);
 
     bool isClientDisabled(void* ident) const;
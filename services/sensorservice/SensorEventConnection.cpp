@@ -15,10 +15,12 @@
  */
 
 #include <log/log.h>
+#include <string.h>
 #include <sys/socket.h>
 #include <utils/threads.h>
 
 #include <android/util/ProtoOutputStream.h>
+#include <com_android_frameworks_sensorservice_flags.h>
 #include <frameworks/base/core/proto/android/service/sensor_service.proto.h>
 #include <sensor/SensorEventQueue.h>
 
@@ -30,6 +32,9 @@
 #define UNUSED(x) (void)(x)
 
 namespace android {
+
+namespace sensorservice_flags = com::android::frameworks::sensorservice::flags;
+
 namespace {
 
 // Used as the default value for the target SDK until it's obtained via getTargetSdkVersion.
@@ -296,6 +301,11 @@ status_t SensorService::SensorEventConnection::sendEvents(
 
     int count = 0;
     Mutex::Autolock _l(mConnectionLock);
+    // The events of this connection can be written to the socket straight from the buffer, without
+    // copying them into the scratch buffer first.
+    bool gather = scratch != nullptr &&
+            sensorservice_flags::sensor_event_connection_gathered_write();
+    mGatheredEvents.clear();
     if (scratch) {
         size_t i=0;
         while (i<numEvents) {
@@ -341,13 +351,13 @@ status_t SensorService::SensorEventConnection::sendEvents(
                 // corresponding flush_complete_event.
                 if (buffer[i].type == SENSOR_TYPE_META_DATA) {
                     if (mapFlushEventsToConnections[i] == this) {
-                        scratch[count++] = buffer[i];
+                        acceptEventLocked(buffer[i], scratch, count++, gather);
                     }
                 } else {
                     // Regular sensor event, just copy it to the scratch buffer after checking
                     // the AppOp.
                     if (hasSensorAccess() && noteOpIfRequired(buffer[i])) {
-                        scratch[count++] = buffer[i];
+                        acceptEventLocked(buffer[i], scratch, count++, gather);
                     }
                 }
                 i++;
@@ -380,6 +390,13 @@ status_t SensorService::SensorEventConnection::sendEvents(
 #if DEBUG_CONNECTIONS
      mEventsReceived += count;
 #endif
+    // Events that are cached or that need the wake up flag set have to be in the scratch buffer.
+    if (gather &&
+        (mCacheSize != 0 || (hasSensorAccess() && hasGatheredWakeUpSensorEventLocked()))) {
+        copyGatheredEventsLocked(scratch);
+        gather = false;
+    }
+
     if (mCacheSize != 0) {
         // There are some events in the cache which need to be sent first. Copy this buffer to
         // the end of cache.
@@ -388,7 +405,7 @@ status_t SensorService::SensorEventConnection::sendEvents(
     }
 
     int index_wake_up_event = -1;
-    if (hasSensorAccess()) {
+    if (hasSensorAccess() && !gather) {
         index_wake_up_event = findWakeUpSensorEventLocked(scratch, count);
         if (index_wake_up_event >= 0) {
             BatteryService::noteWakeupSensorEvent(scratch[index_wake_up_event].timestamp,
@@ -402,9 +419,15 @@ status_t SensorService::SensorEventConnection::sendEvents(
     }
 
     // NOTE: ASensorEvent and sensors_event_t are the same type.
-    ssize_t size = SensorEventQueue::write(mChannel,
-                                    reinterpret_cast<ASensorEvent const*>(scratch), count);
+    ssize_t size = gather
+            ? BitTube::sendGatheredObjects(mChannel, mGatheredEvents.data(),
+                                           mGatheredEvents.size(), sizeof(ASensorEvent))
+            : SensorEventQueue::write(mChannel, reinterpret_cast<ASensorEvent const*>(scratch),
+                                      count);
     if (size < 0) {
+        if (gather) {
+            copyGatheredEventsLocked(scratch);
+        }
         // Write error, copy events to local cache.
         if (index_wake_up_event >= 0) {
             // If there was a wake_up sensor_event, reset the flag.
@@ -439,6 +462,45 @@ status_t SensorService::SensorEventConnection::sendEvents(
     return size < 0 ? status_t(size) : status_t(NO_ERROR);
 }
 
+void SensorService::SensorEventConnection::acceptEventLocked(sensors_event_t const& event,
+                                                            sensors_event_t* scratch, int count,
+                                                            bool gather) {
+    if (!gather) {
+        scratch[count] = event;
+        return;
+    }
+    if (!mGatheredEvents.empty()) {
+        struct iovec& last = mGatheredEvents.back();
+        if (static_cast<char*>(last.iov_base) + last.iov_len ==
+            reinterpret_cast<char const*>(&event)) {
+            last.iov_len += sizeof(sensors_event_t);
+            return;
+        }
+    }
+    mGatheredEvents.push_back({const_cast<sensors_event_t*>(&event), sizeof(sensors_event_t)});
+}
+
+void SensorService::SensorEventConnection::copyGatheredEventsLocked(
+        sensors_event_t* scratch) const {
+    char* dest = reinterpret_cast<char*>(scratch);
+    for (const struct iovec& events : mGatheredEvents) {
+        memcpy(dest, events.iov_base, events.iov_len);
+        dest += events.iov_len;
+    }
+}
+
+bool SensorService::SensorEventConnection::hasGatheredWakeUpSensorEventLocked() const {
+    for (const struct iovec& events : mGatheredEvents) {
+        sensors_event_t const* event = static_cast<sensors_event_t const*>(events.iov_base);
+        for (size_t i = 0; i < events.iov_len / sizeof(sensors_event_t); i++) {
+            if (mService->isWakeUpSensorEvent(event[i])) {
+                return true;
+            }
+        }
+    }
+    return false;
+}
+
 bool SensorService::SensorEventConnection::hasSensorAccess() {
     return mService->isUidActive(mUid)
         && !mService->mSensorPrivacyPolicy->isSensorPrivacyEnabled();
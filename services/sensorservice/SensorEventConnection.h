@@ -21,7 +21,9 @@
 #include <optional>
 #include <stdint.h>
 #include <sys/types.h>
+#include <sys/uio.h>
 #include <unordered_map>
+#include <vector>
 
 #include <utils/Vector.h>
 #include <utils/SortedVector.h>
@@ -96,6 +98,17 @@ private:
     // flag set. SOCK_SEQPACKET ensures that either the entire packet is read or dropped.
     int findWakeUpSensorEventLocked(sensors_event_t const* scratch, int count);
 
+    // Add an event of the buffer passed to sendEvents to the events sent to this connection. When
+    // gathering, the event is not copied but referenced from mGatheredEvents.
+    void acceptEventLocked(sensors_event_t const& event, sensors_event_t* scratch, int count,
+                           bool gather);
+
+    // Copy the events referenced by mGatheredEvents into the scratch buffer.
+    void copyGatheredEventsLocked(sensors_event_t* scratch) const;
+
+    // Returns true if one of the events referenced by mGatheredEvents is from a wake up sensor.
+    bool hasGatheredWakeUpSensorEventLocked() const;
+
     // Send pending flush_complete events. There may have been flush_complete_events that are
     // dropped which need to be sent separately before other events. On older HALs (1_0) this method
     // emulates the behavior of flush().
@@ -181,6 +194,10 @@ private:
 
     sensors_event_t *mEventCache;
     int mCacheSize, mMaxCacheSize;
+    // protected by mConnectionLock. The runs of consecutive events of the buffer passed to
+    // sendEvents that are sent to this connection, when they are written to the socket straight
+    // from that buffer. Kept between calls so that it is not allocated for every batch of events.
+    std::vector<struct iovec> mGatheredEvents;
     int64_t mTimeOfLastEventDrop;
     int mEventsDropped;
     String8 mPackageName;
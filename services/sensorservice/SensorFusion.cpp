@@ -39,6 +39,7 @@ SensorFusion::SensorFusion()
     mEnabled[FUSION_9AXIS] = false;
     mEnabled[FUSION_NOMAG] = false;
     mEnabled[FUSION_NOGYRO] = false;
+    invalidateRotationMatrices();
 
     if (count > 0) {
         for (size_t i=0 ; i<size_t(count) ; i++) {
@@ -77,7 +78,27 @@ SensorFusion::SensorFusion()
     }
 }
 
+void SensorFusion::invalidateRotationMatrices() {
+    for (int i = 0; i<NUM_FUSION_MODE; ++i) {
+        mRotationMatrixValid[i] = false;
+    }
+}
+
+void SensorFusion::process(const sensors_event_t* events, size_t count) {
+    for (size_t i = 0; i < count; i++) {
+        const int32_t type = events[i].type;
+        // Skip the events of the sensors that don't feed the fusion without going through the
+        // per-type handling below.
+        if (type == mGyro.getType() || type == SENSOR_TYPE_MAGNETIC_FIELD ||
+            type == SENSOR_TYPE_ACCELEROMETER) {
+            process(events[i]);
+        }
+    }
+}
+
 void SensorFusion::process(const sensors_event_t& event) {
+    // Any of the events below may change the state of the fusions.
+    invalidateRotationMatrices();
 
     if (event.type == mGyro.getType()) {
         float dT;
@@ -151,6 +172,7 @@ status_t SensorFusion::activate(int mode, void* ident, bool enabled) {
         mEnabled[mode] = newState;
         if (newState) {
             mFusions[mode].init(mode);
+            mRotationMatrixValid[mode] = false;
         }
     }
 
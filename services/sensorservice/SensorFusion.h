@@ -50,6 +50,11 @@ class SensorFusion : public Singleton<SensorFusion> {
     vec4_t &mAttitude;
     vec4_t mAttitudes[NUM_FUSION_MODE];
 
+    // The rotation matrix of each fusion mode is shared by all the virtual sensors using it, and
+    // only computed again after the fusion has processed new events.
+    mutable mat33_t mRotationMatrices[NUM_FUSION_MODE];
+    mutable bool mRotationMatrixValid[NUM_FUSION_MODE];
+
     SortedVector<void*> mClients[3];
 
     float mEstimatedGyroRate;
@@ -60,8 +65,12 @@ class SensorFusion : public Singleton<SensorFusion> {
 
     SensorFusion();
 
+    void invalidateRotationMatrices();
+
 public:
     void process(const sensors_event_t& event);
+    // Process a batch of events from the HAL, in order.
+    void process(const sensors_event_t* events, size_t count);
 
     bool isEnabled() const {
         return mEnabled[FUSION_9AXIS] ||
@@ -74,7 +83,11 @@ public:
     }
 
     mat33_t getRotationMatrix(int mode = FUSION_9AXIS) const {
-        return mFusions[mode].getRotationMatrix();
+        if (!mRotationMatrixValid[mode]) {
+            mRotationMatrices[mode] = mFusions[mode].getRotationMatrix();
+            mRotationMatrixValid[mode] = true;
+        }
+        return mRotationMatrices[mode];
     }
 
     vec4_t getAttitude(int mode = FUSION_9AXIS) const {
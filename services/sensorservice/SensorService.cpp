@@ -478,6 +478,11 @@ void SensorService::onFirstRef() {
             mSensorEventScratch = new sensors_event_t[minBufferSize];
             mRuntimeSensorEventBuffer = nullptr;
             mMapFlushEventsToConnections = new wp<const SensorEventConnection> [minBufferSize];
+            if (sensorservice_flags::sensor_service_parallel_event_fanout()) {
+                mEventFanout = std::make_unique<SensorServiceUtil::EventFanout>(
+                        SENSOR_SERVICE_EVENT_FANOUT_THREADS, minBufferSize,
+                        SENSOR_SERVICE_SCHED_FIFO_PRIORITY);
+            }
             mCurrentOperatingMode = NORMAL;
 
             mNextSensorRegIndex = 0;
@@ -653,6 +658,8 @@ status_t SensorService::dump(int fd, const Vector<String16>& args) {
 
             result.appendFormat("Socket Buffer size = %zd events\n",
                                 mSocketBufferSize/sizeof(sensors_event_t));
+            result.appendFormat("Event fan-out threads = %zu\n",
+                                mEventFanout != nullptr ? mEventFanout->getWorkerCount() : 0);
             result.appendFormat("WakeLock Status: %s \n", mWakeLockAcquired ? "acquired" :
                     "not held");
             result.appendFormat("Mode :");
@@ -1066,9 +1073,23 @@ void SensorService::sendEventsToAllClients(
    // Send our events to clients. Check the state of wake lock for each client
    // and release the lock if none of the clients need it.
    bool needsWakeLock = false;
+   const bool fanout = mEventFanout != nullptr &&
+           activeConnections.size() >= SENSOR_SERVICE_MIN_CONNECTIONS_FOR_EVENT_FANOUT;
+   if (fanout) {
+       // Each connection filters the events into the scratch buffer of the thread sending them,
+       // and only takes its own lock, so the connections can be served at the same time.
+       mEventFanout->run(activeConnections.size(), mSensorEventScratch,
+                         [&](size_t index, sensors_event_t* scratch) {
+                             activeConnections[index]->sendEvents(mSensorEventBuffer, count,
+                                                                  scratch,
+                                                                  mMapFlushEventsToConnections);
+                         });
+   }
    for (const sp<SensorEventConnection>& connection : activeConnections) {
-       connection->sendEvents(mSensorEventBuffer, count, mSensorEventScratch,
-                              mMapFlushEventsToConnections);
+       if (!fanout) {
+           connection->sendEvents(mSensorEventBuffer, count, mSensorEventScratch,
+                                  mMapFlushEventsToConnections);
+       }
        needsWakeLock |= connection->needsWakeLock();
        // If the connection has one-shot sensors, it may be cleaned up after
        // first trigger. Early check for one-shot sensors.
@@ -1180,12 +1201,22 @@ bool SensorService::threadLoop() {
                 size_t k = 0;
                 SensorFusion& fusion(SensorFusion::getInstance());
                 if (fusion.isEnabled()) {
-                    for (size_t i=0 ; i<size_t(count) ; i++) {
-                        fusion.process(event[i]);
+                    fusion.process(event, size_t(count));
+                }
+                // Look the virtual sensors up once for the whole batch rather than for every
+                // event.
+                mActiveVirtualSensorInterfaces.clear();
+                for (int handle : mActiveVirtualSensors) {
+                    std::shared_ptr<SensorInterface> si = getSensorInterfaceFromHandle(handle);
+                    if (si == nullptr) {
+                        ALOGE("handle %d is not an valid virtual sensor", handle);
+                        continue;
                     }
+                    mActiveVirtualSensorInterfaces.push_back(std::move(si));
                 }
                 for (size_t i=0 ; i<size_t(count) && k<minBufferSize ; i++) {
-                    for (int handle : mActiveVirtualSensors) {
+                    for (const std::shared_ptr<SensorInterface>& si :
+                            mActiveVirtualSensorInterfaces) {
                         if (count + k >= minBufferSize) {
                             ALOGE("buffer too small to hold all events: "
                                     "count=%zd, k=%zu, size=%zu",
@@ -1193,12 +1224,6 @@ bool SensorService::threadLoop() {
                             break;
                         }
                         sensors_event_t out;
-                        std::shared_ptr<SensorInterface> si = getSensorInterfaceFromHandle(handle);
-                        if (si == nullptr) {
-                            ALOGE("handle %d is not an valid virtual sensor", handle);
-                            continue;
-                        }
-
                         if (si->process(&out, event[i])) {
                             mSensorEventBuffer[count + k] = out;
                             k++;
@@ -44,6 +44,7 @@
 #include <unordered_set>
 #include <vector>
 
+#include "EventFanout.h"
 #include "RecentEventLogger.h"
 #include "SensorList.h"
 #include "android/hardware/BnSensorPrivacyListener.h"
@@ -64,6 +65,11 @@
 
 #define SENSOR_REGISTRATIONS_BUF_SIZE 500
 
+// When events are sent to at least this many connections at once, they are sent in parallel on
+// SENSOR_SERVICE_EVENT_FANOUT_THREADS worker threads plus the sensor service thread.
+#define SENSOR_SERVICE_MIN_CONNECTIONS_FOR_EVENT_FANOUT 8
+#define SENSOR_SERVICE_EVENT_FANOUT_THREADS 3
+
 // Apps that targets S+ and do not have HIGH_SAMPLING_RATE_SENSORS permission will be capped
 // at 200 Hz. The cap also applies to all requests when the mic toggle is flipped to on, regardless
 // of their target SDKs and permission.
@@ -561,12 +567,17 @@ private:
     mutable Mutex mLock;
     DefaultKeyedVector<int, SensorRecord*> mActiveSensors;
     std::unordered_set<int> mActiveVirtualSensors;
+    // The interfaces of mActiveVirtualSensors, looked up once per batch of events by threadLoop.
+    std::vector<std::shared_ptr<SensorInterface>> mActiveVirtualSensorInterfaces;
     SensorConnectionHolder mConnectionHolder;
     bool mWakeLockAcquired;
     sensors_event_t *mSensorEventBuffer, *mSensorEventScratch, *mRuntimeSensorEventBuffer;
     // WARNING: these SensorEventConnection instances must not be promoted to sp, except via
     // modification to add support for them in ConnectionSafeAutolock
     wp<const SensorEventConnection> * mMapFlushEventsToConnections;
+    // Sends the events to the connections in parallel when there are many of them. Null if the
+    // fan-out is disabled.
+    std::unique_ptr<SensorServiceUtil::EventFanout> mEventFanout;
     std::unordered_map<int, SensorServiceUtil::RecentEventLogger*> mRecentEvent;
     Mode mCurrentOperatingMode;
     std::queue<sensors_event_t> mRuntimeSensorEventQueue;
@@ -19,10 +19,15 @@
 #define LOG_TAG "BackgroundExecutor"
 #define ATRACE_TAG ATRACE_TAG_GRAPHICS
 
+#include <android-base/properties.h>
+#include <android-base/stringprintf.h>
+#include <ftl/enum.h>
 #include <processgroup/sched_policy.h>
 #include <pthread.h>
 #include <sched.h>
 #include <utils/Log.h>
+#include <array>
+#include <cinttypes>
 #include <mutex>
 
 #include "BackgroundExecutor.h"
@@ -31,6 +36,25 @@ namespace android {
 
 namespace {
 
+struct LaneConfig {
+    const char* threadName;
+    bool highPriority;
+};
+
+LaneConfig getLaneConfig(BackgroundExecutor::Lane lane) {
+    using Lane = BackgroundExecutor::Lane;
+    switch (lane) {
+        case Lane::Input:
+            return {"BckgrndExec HP", true};
+        case Lane::Callbacks:
+            return {"BckgrndExec CB", true};
+        case Lane::LowPriority:
+            return {"BckgrndExec LP", false};
+        case Lane::Teardown:
+            return {"BckgrndExec TD", false};
+    }
+}
+
 void set_thread_priority(bool highPriority) {
     set_sched_policy(0, highPriority ? SP_FOREGROUND : SP_BACKGROUND);
     struct sched_param param = {0};
@@ -38,34 +62,94 @@ void set_thread_priority(bool highPriority) {
     sched_setscheduler(gettid(), highPriority ? SCHED_FIFO : SCHED_NORMAL, &param);
 }
 
+// Pins the calling thread to the CPUs in debug.sf.background_executor.<lane>.cpu_mask, if set.
+void set_thread_affinity(BackgroundExecutor::Lane lane) {
+    const std::string property = "debug.sf.background_executor." + ftl::enum_string(lane) +
+            ".cpu_mask";
+    const auto mask = base::GetUintProperty<uint64_t>(property, 0);
+    if (mask == 0) {
+        return;
+    }
+
+    cpu_set_t cpuSet;
+    CPU_ZERO(&cpuSet);
+    for (size_t cpu = 0; cpu < 64; cpu++) {
+        if (mask & (uint64_t{1} << cpu)) {
+            CPU_SET(cpu, &cpuSet);
+        }
+    }
+    if (sched_setaffinity(0, sizeof(cpuSet), &cpuSet) != 0) {
+        ALOGW("Failed to set the affinity of the %s lane to 0x%" PRIx64 " (%d)",
+              ftl::enum_string(lane).c_str(), mask, errno);
+    }
+}
+
+void updateMax(std::atomic<nsecs_t>& max, nsecs_t value) {
+    nsecs_t current = max.load(std::memory_order_relaxed);
+    while (value > current && !max.compare_exchange_weak(current, value)) {
+    }
+}
+
 } // anonymous namespace
 
-BackgroundExecutor::BackgroundExecutor(bool highPriority) {
+std::atomic<BackgroundExecutor*>& BackgroundExecutor::getLaneInstance(Lane lane) {
+    static std::array<std::atomic<BackgroundExecutor*>, ftl::enum_size_v<Lane>> instances{};
+    return instances[static_cast<size_t>(lane)];
+}
+
+BackgroundExecutor& BackgroundExecutor::getInstance(Lane lane) {
+    // The lanes are created on first use, and live for the lifetime of the process.
+    switch (lane) {
+        case Lane::Input: {
+            static BackgroundExecutor instance(Lane::Input);
+            return instance;
+        }
+        case Lane::Callbacks: {
+            static BackgroundExecutor instance(Lane::Callbacks);
+            return instance;
+        }
+        case Lane::LowPriority: {
+            static BackgroundExecutor instance(Lane::LowPriority);
+            return instance;
+        }
+        case Lane::Teardown: {
+            static BackgroundExecutor instance(Lane::Teardown);
+            return instance;
+        }
+    }
+}
+
+BackgroundExecutor::BackgroundExecutor(Lane lane) : mLane(lane) {
+    const LaneConfig config = getLaneConfig(lane);
     // mSemaphore must be initialized before any calls to
     // BackgroundExecutor::sendCallbacks. For this reason, we initialize it
     // within the constructor instead of within mThread.
     LOG_ALWAYS_FATAL_IF(sem_init(&mSemaphore, 0, 0), "sem_init failed");
-    mThread = std::thread([&, highPriority]() {
+    mThread = std::thread([&, lane, highPriority = config.highPriority]() {
         set_thread_priority(highPriority);
+        set_thread_affinity(lane);
         while (!mDone) {
             LOG_ALWAYS_FATAL_IF(sem_wait(&mSemaphore), "sem_wait failed (%d)", errno);
-            auto callbacks = mCallbacksQueue.pop();
-            if (!callbacks) {
+            auto task = mCallbacksQueue.pop();
+            if (!task) {
                 continue;
             }
-            for (auto& callback : *callbacks) {
+            const nsecs_t latency = systemTime() - task->queueTime;
+            mTotalLatency.fetch_add(latency, std::memory_order_relaxed);
+            updateMax(mMaxLatency, latency);
+            for (auto& callback : task->callbacks) {
                 callback();
             }
+            mPendingTasks.fetch_sub(1, std::memory_order_relaxed);
+            mExecutedTasks.fetch_add(1, std::memory_order_relaxed);
         }
     });
-    if (highPriority) {
-        pthread_setname_np(mThread.native_handle(), "BckgrndExec HP");
-    } else {
-        pthread_setname_np(mThread.native_handle(), "BckgrndExec LP");
-    }
+    pthread_setname_np(mThread.native_handle(), config.threadName);
+    getLaneInstance(lane) = this;
 }
 
 BackgroundExecutor::~BackgroundExecutor() {
+    getLaneInstance(mLane) = nullptr;
     mDone = true;
     LOG_ALWAYS_FATAL_IF(sem_post(&mSemaphore), "sem_post failed");
     if (mThread.joinable()) {
@@ -75,7 +159,13 @@ BackgroundExecutor::~BackgroundExecutor() {
 }
 
 void BackgroundExecutor::sendCallbacks(Callbacks&& tasks) {
-    mCallbacksQueue.push(std::move(tasks));
+    // Counted before the push so that the lane thread never sees a negative depth.
+    const size_t pendingTasks = mPendingTasks.fetch_add(1, std::memory_order_relaxed) + 1;
+    size_t maxPendingTasks = mMaxPendingTasks.load(std::memory_order_relaxed);
+    while (pendingTasks > maxPendingTasks &&
+           !mMaxPendingTasks.compare_exchange_weak(maxPendingTasks, pendingTasks)) {
+    }
+    mCallbacksQueue.push({std::move(tasks), systemTime()});
     LOG_ALWAYS_FATAL_IF(sem_post(&mSemaphore), "sem_post failed");
 }
 
@@ -92,4 +182,33 @@ void BackgroundExecutor::flushQueue() {
     cv.wait(lock, [&]() { return flushComplete; });
 }
 
+BackgroundExecutor::Stats BackgroundExecutor::getStats() const {
+    return {.pendingTasks = mPendingTasks.load(std::memory_order_relaxed),
+            .maxPendingTasks = mMaxPendingTasks.load(std::memory_order_relaxed),
+            .executedTasks = mExecutedTasks.load(std::memory_order_relaxed),
+            .totalLatency = mTotalLatency.load(std::memory_order_relaxed),
+            .maxLatency = mMaxLatency.load(std::memory_order_relaxed)};
+}
+
+void BackgroundExecutor::dumpAll(std::string& result) {
+    result.append("BackgroundExecutor lanes:\n");
+    for (const Lane lane : ftl::enum_range<Lane>()) {
+        const BackgroundExecutor* executor = getLaneInstance(lane);
+        if (!executor) {
+            continue;
+        }
+        const Stats stats = executor->getStats();
+        const nsecs_t averageLatency = stats.executedTasks
+                ? stats.totalLatency / static_cast<nsecs_t>(stats.executedTasks)
+                : 0;
+        base::StringAppendF(&result,
+                            "  %s: pending %zu (max %zu), executed %" PRIu64
+                            ", latency avg %.3fms max %.3fms\n",
+                            ftl::enum_string(lane).c_str(), stats.pendingTasks,
+                            stats.maxPendingTasks, stats.executedTasks,
+                            static_cast<double>(averageLatency) / 1e6,
+                            static_cast<double>(stats.maxLatency) / 1e6);
+    }
+}
+
 } // namespace android
@@ -18,25 +18,40 @@
 
 #include <ftl/small_vector.h>
 #include <semaphore.h>
+#include <utils/Timers.h>
+#include <atomic>
+#include <string>
 #include <thread>
 
 #include "LocklessQueue.h"
 
 namespace android {
 
-// Executes tasks off the main thread.
+// Executes tasks off the main thread. Each lane is a separate thread with its own queue, so that
+// slow work on one lane does not delay the work queued on another.
 class BackgroundExecutor {
 public:
+    enum class Lane {
+        // Window infos and input updates, which are latency sensitive.
+        Input,
+        // Transaction completed callbacks to clients.
+        Callbacks,
+        // Work nobody waits on, such as jank data and releasing the last reference to objects.
+        LowPriority,
+        // Freeing the buffers and other resources of destroyed layers, which can come in large
+        // batches when an app closes, without delaying the work on the LowPriority lane.
+        Teardown,
+        ftl_last = Teardown
+    };
+
     ~BackgroundExecutor();
 
-    static BackgroundExecutor& getInstance() {
-        static BackgroundExecutor instance(true);
-        return instance;
-    }
+    static BackgroundExecutor& getInstance(Lane lane);
+
+    static BackgroundExecutor& getInstance() { return getInstance(Lane::Input); }
 
     static BackgroundExecutor& getLowPriorityInstance() {
-        static BackgroundExecutor instance(false);
-        return instance;
+        return getInstance(Lane::LowPriority);
     }
 
     using Callbacks = ftl::SmallVector<std::function<void()>, 10>;
@@ -45,14 +60,42 @@ public:
     void sendCallbacks(Callbacks&& tasks);
     void flushQueue();
 
+    struct Stats {
+        // Batches of callbacks queued but not yet run.
+        size_t pendingTasks = 0;
+        size_t maxPendingTasks = 0;
+        uint64_t executedTasks = 0;
+        // Time between a batch being queued and starting to run.
+        nsecs_t totalLatency = 0;
+        nsecs_t maxLatency = 0;
+    };
+    Stats getStats() const;
+
+    // Dumps the stats of every lane that has been used.
+    static void dumpAll(std::string& result);
+
 private:
-    BackgroundExecutor(bool highPriority);
+    explicit BackgroundExecutor(Lane lane);
+
+    static std::atomic<BackgroundExecutor*>& getLaneInstance(Lane lane);
 
+    struct Task {
+        Callbacks callbacks;
+        nsecs_t queueTime;
+    };
+
+    const Lane mLane;
     sem_t mSemaphore;
     std::atomic_bool mDone = false;
 
-    LocklessQueue<Callbacks> mCallbacksQueue;
+    LocklessQueue<Task> mCallbacksQueue;
     std::thread mThread;
+
+    std::atomic<size_t> mPendingTasks = 0;
+    std::atomic<size_t> mMaxPendingTasks = 0;
+    std::atomic<uint64_t> mExecutedTasks = 0;
+    std::atomic<nsecs_t> mTotalLatency = 0;
+    std::atomic<nsecs_t> mMaxLatency = 0;
 };
 
 } // namespace android
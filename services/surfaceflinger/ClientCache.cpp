@@ -33,15 +33,17 @@ ANDROID_SINGLETON_STATIC_INSTANCE(ClientCache);
 
 ClientCache::ClientCache() : mDeathRecipient(sp<CacheDeathRecipient>::make()) {}
 
-bool ClientCache::getBuffer(const client_cache_t& cacheId,
+ClientCache::Shard& ClientCache::getShard(const wp<IBinder>& processToken) {
+    // Binder objects are heap allocated, so the low bits of their address carry no information.
+    const auto address = reinterpret_cast<uintptr_t>(processToken.unsafe_get());
+    return mShards[(address >> 4) % kShardCount];
+}
+
+bool ClientCache::getBuffer(Shard& shard, const client_cache_t& cacheId,
                             ClientCacheBuffer** outClientCacheBuffer) {
     auto& [processToken, id] = cacheId;
-    if (processToken == nullptr) {
-        ALOGE_AND_TRACE("ClientCache::getBuffer - invalid (nullptr) process token");
-        return false;
-    }
-    auto it = mBuffers.find(processToken);
-    if (it == mBuffers.end()) {
+    auto it = shard.buffers.find(processToken);
+    if (it == shard.buffers.end()) {
         ALOGE_AND_TRACE("ClientCache::getBuffer - invalid process token");
         return false;
     }
@@ -72,13 +74,14 @@ ClientCache::add(const client_cache_t& cacheId, const sp<GraphicBuffer>& buffer)
         return base::unexpected(AddError::Unspecified);
     }
 
-    std::lock_guard lock(mMutex);
+    Shard& shard = getShard(processToken);
+    std::lock_guard lock(shard.mutex);
     sp<IBinder> token;
 
     // If this is a new process token, set a death recipient. If the client process dies, we will
     // get a callback through binderDied.
-    auto it = mBuffers.find(processToken);
-    if (it == mBuffers.end()) {
+    auto it = shard.buffers.find(processToken);
+    if (it == shard.buffers.end()) {
         token = processToken.promote();
         if (!token) {
             ALOGE_AND_TRACE("ClientCache::add - invalid token");
@@ -94,9 +97,10 @@ ClientCache::add(const client_cache_t& cacheId, const sp<GraphicBuffer>& buffer)
             }
         }
         auto [itr, success] =
-                mBuffers.emplace(processToken,
-                                 std::make_pair(token,
-                                                std::unordered_map<uint64_t, ClientCacheBuffer>()));
+                shard.buffers.emplace(processToken,
+                                      std::make_pair(token,
+                                                     std::unordered_map<uint64_t,
+                                                                        ClientCacheBuffer>()));
         LOG_ALWAYS_FATAL_IF(!success, "failed to insert new process into client cache");
         it = itr;
     }
@@ -121,11 +125,16 @@ ClientCache::add(const client_cache_t& cacheId, const sp<GraphicBuffer>& buffer)
 sp<GraphicBuffer> ClientCache::erase(const client_cache_t& cacheId) {
     sp<GraphicBuffer> buffer;
     auto& [processToken, id] = cacheId;
+    if (processToken == nullptr) {
+        ALOGE("failed to erase buffer, invalid (nullptr) process token");
+        return nullptr;
+    }
     std::vector<sp<ErasedRecipient>> pendingErase;
     {
-        std::lock_guard lock(mMutex);
+        Shard& shard = getShard(processToken);
+        std::lock_guard lock(shard.mutex);
         ClientCacheBuffer* buf = nullptr;
-        if (!getBuffer(cacheId, &buf)) {
+        if (!getBuffer(shard, cacheId, &buf)) {
             ALOGE("failed to erase buffer, could not retrieve buffer");
             return nullptr;
         }
@@ -139,8 +148,9 @@ sp<GraphicBuffer> ClientCache::erase(const client_cache_t& cacheId) {
             }
         }
 
-        mBuffers[processToken].second.erase(id);
+        shard.buffers[processToken].second.erase(id);
     }
+    mEvictions.fetch_add(1, std::memory_order_relaxed);
 
     for (auto& recipient : pendingErase) {
         recipient->bufferErased(cacheId);
@@ -149,23 +159,36 @@ sp<GraphicBuffer> ClientCache::erase(const client_cache_t& cacheId) {
 }
 
 std::shared_ptr<renderengine::ExternalTexture> ClientCache::get(const client_cache_t& cacheId) {
-    std::lock_guard lock(mMutex);
+    if (cacheId.token == nullptr) {
+        ALOGE_AND_TRACE("ClientCache::get - invalid (nullptr) process token");
+        mMisses.fetch_add(1, std::memory_order_relaxed);
+        return nullptr;
+    }
+    Shard& shard = getShard(cacheId.token);
+    std::shared_lock lock(shard.mutex);
 
     ClientCacheBuffer* buf = nullptr;
-    if (!getBuffer(cacheId, &buf)) {
+    if (!getBuffer(shard, cacheId, &buf)) {
         ALOGE("failed to get buffer, could not retrieve buffer");
+        mMisses.fetch_add(1, std::memory_order_relaxed);
         return nullptr;
     }
 
+    mHits.fetch_add(1, std::memory_order_relaxed);
     return buf->buffer;
 }
 
 bool ClientCache::registerErasedRecipient(const client_cache_t& cacheId,
                                           const wp<ErasedRecipient>& recipient) {
-    std::lock_guard lock(mMutex);
+    if (cacheId.token == nullptr) {
+        ALOGV("failed to register erased recipient, invalid (nullptr) process token");
+        return false;
+    }
+    Shard& shard = getShard(cacheId.token);
+    std::lock_guard lock(shard.mutex);
 
     ClientCacheBuffer* buf = nullptr;
-    if (!getBuffer(cacheId, &buf)) {
+    if (!getBuffer(shard, cacheId, &buf)) {
         ALOGV("failed to register erased recipient, could not retrieve buffer");
         return false;
     }
@@ -175,10 +198,15 @@ bool ClientCache::registerErasedRecipient(const client_cache_t& cacheId,
 
 void ClientCache::unregisterErasedRecipient(const client_cache_t& cacheId,
                                             const wp<ErasedRecipient>& recipient) {
-    std::lock_guard lock(mMutex);
+    if (cacheId.token == nullptr) {
+        ALOGE("failed to unregister erased recipient, invalid (nullptr) process token");
+        return;
+    }
+    Shard& shard = getShard(cacheId.token);
+    std::lock_guard lock(shard.mutex);
 
     ClientCacheBuffer* buf = nullptr;
-    if (!getBuffer(cacheId, &buf)) {
+    if (!getBuffer(shard, cacheId, &buf)) {
         ALOGE("failed to unregister erased recipient");
         return;
     }
@@ -188,14 +216,16 @@ void ClientCache::unregisterErasedRecipient(const client_cache_t& cacheId,
 
 void ClientCache::removeProcess(const wp<IBinder>& processToken) {
     std::vector<std::pair<sp<ErasedRecipient>, client_cache_t>> pendingErase;
+    size_t erasedCount;
     {
         if (processToken == nullptr) {
             ALOGE("failed to remove process, invalid (nullptr) process token");
             return;
         }
-        std::lock_guard lock(mMutex);
-        auto itr = mBuffers.find(processToken);
-        if (itr == mBuffers.end()) {
+        Shard& shard = getShard(processToken);
+        std::lock_guard lock(shard.mutex);
+        auto itr = shard.buffers.find(processToken);
+        if (itr == shard.buffers.end()) {
             ALOGE("failed to remove process, could not find process");
             return;
         }
@@ -209,8 +239,10 @@ void ClientCache::removeProcess(const wp<IBinder>& processToken) {
                 }
             }
         }
-        mBuffers.erase(itr);
+        erasedCount = itr->second.second.size();
+        shard.buffers.erase(itr);
     }
+    mEvictions.fetch_add(erasedCount, std::memory_order_relaxed);
 
     for (auto& [recipient, cacheId] : pendingErase) {
         recipient->bufferErased(cacheId);
@@ -221,15 +253,27 @@ void ClientCache::CacheDeathRecipient::binderDied(const wp<IBinder>& who) {
     ClientCache::getInstance().removeProcess(who);
 }
 
+ClientCache::Stats ClientCache::getStats() const {
+    return {.hits = mHits.load(std::memory_order_relaxed),
+            .misses = mMisses.load(std::memory_order_relaxed),
+            .evictions = mEvictions.load(std::memory_order_relaxed)};
+}
+
 void ClientCache::dump(std::string& result) {
-    std::lock_guard lock(mMutex);
-    for (const auto& [_, cache] : mBuffers) {
-        base::StringAppendF(&result, " Cache owner: %p\n", cache.first.get());
-
-        for (const auto& [id, entry] : cache.second) {
-            const auto& buffer = entry.buffer->getBuffer();
-            base::StringAppendF(&result, "\tID: %" PRIu64 ", size: %ux%u\n", id, buffer->getWidth(),
-                                buffer->getHeight());
+    const Stats stats = getStats();
+    base::StringAppendF(&result,
+                        " Hits: %" PRIu64 ", misses: %" PRIu64 ", evictions: %" PRIu64 "\n",
+                        stats.hits, stats.misses, stats.evictions);
+    for (Shard& shard : mShards) {
+        std::shared_lock lock(shard.mutex);
+        for (const auto& [_, cache] : shard.buffers) {
+            base::StringAppendF(&result, " Cache owner: %p\n", cache.first.get());
+
+            for (const auto& [id, entry] : cache.second) {
+                const auto& buffer = entry.buffer->getBuffer();
+                base::StringAppendF(&result, "\tID: %" PRIu64 ", size: %ux%u\n", id,
+                                    buffer->getWidth(), buffer->getHeight());
+            }
         }
     }
 }
@@ -24,9 +24,12 @@
 #include <utils/RefBase.h>
 #include <utils/Singleton.h>
 
+#include <array>
+#include <atomic>
 #include <map>
 #include <mutex>
 #include <set>
+#include <shared_mutex>
 #include <unordered_map>
 
 // 4096 is based on 64 buffers * 64 layers. Once this limit is reached, the least recently used
@@ -46,6 +49,9 @@ namespace android {
 // both the SurfaceFlinger side of this other cache, as well as Composer HAL's
 // side of the cache.
 //
+// Processes are spread over shards with their own lock, so that binder threads looking up buffers
+// for different processes don't contend, and lookups only take their shard's lock for reading.
+//
 class ClientCache : public Singleton<ClientCache> {
 public:
     ClientCache();
@@ -75,19 +81,33 @@ public:
     void unregisterErasedRecipient(const client_cache_t& cacheId,
                                    const wp<ErasedRecipient>& recipient);
 
+    struct Stats {
+        uint64_t hits = 0;
+        uint64_t misses = 0;
+        // Buffers uncached by their client or dropped with their process.
+        uint64_t evictions = 0;
+    };
+    Stats getStats() const;
+
     void dump(std::string& result);
 
 private:
-    std::mutex mMutex;
-
     struct ClientCacheBuffer {
         std::shared_ptr<renderengine::ExternalTexture> buffer;
         std::set<wp<ErasedRecipient>> recipients;
     };
-    std::map<wp<IBinder> /*caching process*/,
-             std::pair<sp<IBinder> /*strong ref to caching process*/,
-                       std::unordered_map<uint64_t /*cache id*/, ClientCacheBuffer>>>
-            mBuffers GUARDED_BY(mMutex);
+
+    static constexpr size_t kShardCount = 8;
+    struct Shard {
+        std::shared_mutex mutex;
+        std::map<wp<IBinder> /*caching process*/,
+                 std::pair<sp<IBinder> /*strong ref to caching process*/,
+                           std::unordered_map<uint64_t /*cache id*/, ClientCacheBuffer>>>
+                buffers GUARDED_BY(mutex);
+    };
+    std::array<Shard, kShardCount> mShards;
+
+    Shard& getShard(const wp<IBinder>& processToken);
 
     class CacheDeathRecipient : public IBinder::DeathRecipient {
     public:
@@ -97,8 +117,12 @@ private:
     sp<CacheDeathRecipient> mDeathRecipient;
     renderengine::RenderEngine* mRenderEngine = nullptr;
 
-    bool getBuffer(const client_cache_t& cacheId, ClientCacheBuffer** outClientCacheBuffer)
-            REQUIRES(mMutex);
+    std::atomic<uint64_t> mHits = 0;
+    std::atomic<uint64_t> mMisses = 0;
+    std::atomic<uint64_t> mEvictions = 0;
+
+    static bool getBuffer(Shard& shard, const client_cache_t& cacheId,
+                          ClientCacheBuffer** outClientCacheBuffer) REQUIRES_SHARED(shard.mutex);
 };
 
 }; // namespace android
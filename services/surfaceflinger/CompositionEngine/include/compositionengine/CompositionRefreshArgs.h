@@ -101,6 +101,11 @@ struct CompositionRefreshArgs {
 
     // System time for when frame refresh starts. Used for stats.
     nsecs_t refreshStartTime = 0;
+
+    // If true, outputs that do not share layers with other outputs are presented on worker
+    // threads concurrently with the rest. Requires a RenderEngine that is safe to call from
+    // multiple threads.
+    bool presentOutputsInParallel = false;
 };
 
 } // namespace android::compositionengine
@@ -153,6 +153,9 @@ public:
         Region aboveOpaqueLayers;
         // The region of the output which should be considered dirty
         Region dirtyRegion;
+        // Set once aboveOpaqueLayers covers the entire output, after which no layer beneath can
+        // be visible
+        bool outputOccluded = false;
         // The region of the output which is covered by layers, excluding display overlays. This
         // only has a value if there's something needing it, like when a TrustedPresentationListener
         // is set
@@ -274,6 +277,10 @@ public:
     // Make the next call to `present` run asynchronously.
     virtual void offloadPresentNextFrame() = 0;
 
+    // Whether the whole present pipeline of this output may run concurrently with the pipelines
+    // of other outputs that do not share any layers with it.
+    virtual bool supportsParallelPresent() const = 0;
+
     // Enables predicting composition strategy to run client composition earlier
     virtual void setPredictCompositionStrategy(bool) = 0;
 
@@ -328,6 +335,7 @@ protected:
     virtual bool isPowerHintSessionEnabled() = 0;
     virtual bool isPowerHintSessionGpuReportingEnabled() = 0;
     virtual void cacheClientCompositionRequests(uint32_t cacheSize) = 0;
+    virtual void trackClientCompositionDamage(uint32_t bufferCount) = 0;
     virtual bool canPredictCompositionStrategy(const CompositionRefreshArgs&) = 0;
 };
 
@@ -18,10 +18,13 @@
 
 #include <cstdint>
 #include <deque>
+#include <optional>
+#include <string>
 
 #include <compositionengine/LayerFE.h>
 #include <renderengine/DisplaySettings.h>
 #include <renderengine/LayerSettings.h>
+#include <ui/Region.h>
 
 namespace android {
 
@@ -37,6 +40,9 @@ namespace compositionengine::impl {
 // the composition request. We need to make sure the request, including the order of the
 // layers, do not change from call to call. The snapshot removes strong references to the
 // client buffer id so we don't extend the lifetime of the buffer by storing it in the cache.
+//
+// Each entry also keeps a hash of its request contents, so that a lookup only compares the
+// full request when the hashes match.
 class ClientCompositionRequestCache {
 public:
     explicit ClientCompositionRequestCache(uint32_t cacheSize) : mMaxCacheSize(cacheSize){};
@@ -46,21 +52,84 @@ public:
     void add(uint64_t bufferId, const renderengine::DisplaySettings& display,
              const std::vector<LayerFE::LayerSettings>& layerSettings);
     void remove(uint64_t bufferId);
+    void dump(std::string& out) const;
+
+    // Hash of the request contents. Client buffers are only hashed through their buffer id and
+    // frame number, so that equal requests hash equally.
+    static size_t getRequestHash(const renderengine::DisplaySettings& display,
+                                 const std::vector<LayerFE::LayerSettings>& layerSettings);
 
 private:
     uint32_t mMaxCacheSize;
     struct ClientCompositionRequest {
         renderengine::DisplaySettings display;
         std::vector<LayerFE::LayerSettings> layerSettings;
+        size_t hash;
         ClientCompositionRequest(const renderengine::DisplaySettings& _display,
-                                 const std::vector<LayerFE::LayerSettings>& _layerSettings);
+                                 const std::vector<LayerFE::LayerSettings>& _layerSettings,
+                                 size_t _hash);
         bool equals(const renderengine::DisplaySettings& _display,
-                    const std::vector<LayerFE::LayerSettings>& _layerSettings) const;
+                    const std::vector<LayerFE::LayerSettings>& _layerSettings,
+                    size_t _hash) const;
     };
 
+    // Lookup statistics, reported in dumpsys.
+    mutable uint64_t mHits = 0;
+    mutable uint64_t mMisses = 0;
+
     // Cache of requests, keyed by corresponding GraphicBuffer ID.
     std::deque<std::pair<uint64_t /* bufferId */, ClientCompositionRequest>> mCache;
 };
 
+// Tracks what changed in the client composition since each RenderSurface buffer was last
+// rendered into, so that composing into a buffer that still holds a composition from a few frames
+// ago (its buffer age) only needs to redraw the damage accumulated over those frames.
+//
+// Damage comes from the output's dirty region, which accounts for changes to layer contents and
+// visible regions. That only describes the difference between two compositions if the layers were
+// composed the same way, so the damage is only accumulated across compositions with equal display
+// and layer settings, ignoring client buffers. Any other change, a frame whose damage was not
+// recorded, or a blur, which spreads changes beyond the damage, makes the next composition into
+// each buffer a full redraw.
+class ClientCompositionDamageTracker {
+public:
+    explicit ClientCompositionDamageTracker(uint32_t bufferCount);
+
+    // Records a composition into bufferId, where damage is the region of the buffer that changed
+    // since the previous frame. Returns the region of the buffer that needs to be redrawn, or
+    // nullopt if all of it does.
+    std::optional<Region> onComposition(uint64_t bufferId, const Region& damage,
+                                        const renderengine::DisplaySettings& display,
+                                        const std::vector<LayerFE::LayerSettings>& layerSettings);
+    // Forgets the contents of the buffer, e.g. because rendering into it failed.
+    void remove(uint64_t bufferId);
+    // Called once per frame when its damage is reset. A damaged frame that was not composed
+    // leaves the damage of every buffer unknown.
+    void onFrameFinished(bool damaged);
+    // Makes the next composition into each buffer a full redraw.
+    void invalidate();
+    void dump(std::string& out) const;
+
+private:
+    struct Composition {
+        uint64_t bufferId;
+        Region damage;
+        renderengine::DisplaySettings display;
+        std::vector<LayerFE::LayerSettings> layerSettings;
+    };
+
+    static bool composedAlike(const Composition& composition,
+                              const renderengine::DisplaySettings& display,
+                              const std::vector<LayerFE::LayerSettings>& layerSettings);
+
+    const size_t mMaxCompositions;
+    // Most recent last.
+    std::deque<Composition> mCompositions;
+    bool mComposedThisFrame = false;
+
+    uint64_t mPartialRedraws = 0;
+    uint64_t mFullRedraws = 0;
+};
+
 } // namespace compositionengine::impl
 } // namespace android
@@ -17,9 +17,17 @@
 #pragma once
 
 #include <compositionengine/CompositionEngine.h>
+#include <ftl/future.h>
+#include <ui/DisplayMap.h>
+
+#include <memory>
+#include <variant>
+#include <vector>
 
 namespace android::compositionengine::impl {
 
+class HwcAsyncWorker;
+
 class CompositionEngine : public compositionengine::CompositionEngine {
 public:
     CompositionEngine();
@@ -59,11 +67,16 @@ public:
     void setNeedsAnotherUpdateForTest(bool);
 
 private:
+    // Presents the outputs, running those that can be composed independently on worker threads.
+    void presentOutputsInParallel(CompositionRefreshArgs&,
+                                  ui::DisplayVector<ftl::Future<std::monostate>>& presentFutures);
+
     std::unique_ptr<HWComposer> mHwComposer;
     renderengine::RenderEngine* mRenderEngine;
     std::shared_ptr<TimeStats> mTimeStats;
     bool mNeedsAnotherUpdate = false;
     nsecs_t mRefreshStartTime = 0;
+    std::vector<std::unique_ptr<HwcAsyncWorker>> mPresentWorkers;
 };
 
 std::unique_ptr<compositionengine::CompositionEngine> createCompositionEngine();
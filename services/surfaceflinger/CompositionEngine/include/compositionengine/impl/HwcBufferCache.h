@@ -18,6 +18,7 @@
 
 #include <cstdint>
 #include <stack>
+#include <string>
 #include <unordered_map>
 
 // TODO(b/129481165): remove the #pragma below and fix conversion issues
@@ -56,6 +57,10 @@ struct HwcSlotAndBuffer {
 // since it eliminates the overhead to transfer the buffer handle over IPC and
 // the overhead for the HAL to clone the handle.
 //
+// Each layer uses up to a fixed number of slots, set by debug.sf.hwc_buffer_cache_size and
+// capped to the BufferQueue slot count. Once all slots are used, the least recently used buffer
+// is evicted to make room for a new one.
+//
 class HwcBufferCache {
 private:
     static const constexpr size_t kMaxLayerBufferCount = BufferQueue::NUM_BUFFER_SLOTS;
@@ -66,7 +71,19 @@ public:
     // buffers from the cache. We add an extra slot at the end for the override buffers.
     static const constexpr size_t kOverrideBufferSlot = kMaxLayerBufferCount;
 
+    // Counters reported in dumpsys to tune the slot budget.
+    struct Stats {
+        // Lookups of a buffer already in the cache, which only send the slot to HWC.
+        uint64_t hits = 0;
+        // Lookups of a new buffer, which send the buffer handle to HWC.
+        uint64_t misses = 0;
+        // Buffers evicted to make room for a new buffer.
+        uint64_t evictions = 0;
+    };
+
     HwcBufferCache();
+    // Uses up to capacity slots, clamped to [1, kMaxLayerBufferCount].
+    explicit HwcBufferCache(size_t capacity);
 
     //
     // Given a buffer, return the HWC cache slot and buffer to send to HWC.
@@ -92,6 +109,13 @@ public:
     //
     uint32_t uncache(uint64_t graphicBufferId);
 
+    size_t getCapacity() const { return mCapacity; }
+    const Stats& getStats() const { return mStats; }
+    void dump(std::string& out) const;
+
+    // The slot budget used by default constructed caches.
+    static size_t getDefaultCapacity();
+
 private:
     uint32_t cache(const sp<GraphicBuffer>& buffer);
     uint32_t getLeastRecentlyUsedSlot();
@@ -100,14 +124,16 @@ private:
         sp<GraphicBuffer> buffer;
         uint32_t slot;
         // Cache entries are evicted according to least-recently-used when more than
-        // kMaxLayerBufferCount unique buffers have been sent to a layer.
+        // mCapacity unique buffers have been sent to a layer.
         uint64_t lruCounter;
     };
 
+    size_t mCapacity;
     std::unordered_map<uint64_t, Cache> mCacheByBufferId;
     sp<GraphicBuffer> mLastOverrideBuffer;
     std::stack<uint32_t> mFreeSlots;
-    uint64_t mLeastRecentlyUsedCounter;
+    uint64_t mLeastRecentlyUsedCounter = 0;
+    Stats mStats;
 };
 
 } // namespace compositionengine::impl
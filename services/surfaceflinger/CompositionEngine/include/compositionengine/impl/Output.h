@@ -83,6 +83,7 @@ public:
     ftl::Future<std::monostate> present(const CompositionRefreshArgs&) override;
     bool supportsOffloadPresent() const override { return false; }
     void offloadPresentNextFrame() override;
+    bool supportsParallelPresent() const override { return true; }
 
     void uncacheBuffers(const std::vector<uint64_t>& bufferIdsToUncache) override;
     void rebuildLayerStacks(const CompositionRefreshArgs&, LayerFESet&) override;
@@ -107,6 +108,7 @@ public:
     void presentFrameAndReleaseLayers(bool flushEvenWhenDisabled) override;
     void renderCachedSets(const CompositionRefreshArgs&) override;
     void cacheClientCompositionRequests(uint32_t) override;
+    void trackClientCompositionDamage(uint32_t) override;
     bool canPredictCompositionStrategy(const CompositionRefreshArgs&) override;
     void setPredictCompositionStrategy(bool) override;
     void setTreat170mAsSrgb(bool) override;
@@ -174,6 +176,8 @@ private:
             const compositionengine::CompositionRefreshArgs&) const;
     void updateHwcAsyncWorker();
     float getHdrSdrRatio(const std::shared_ptr<renderengine::ExternalTexture>& buffer) const;
+    // The dirty region in framebuffer space.
+    Region getClientCompositionDamage() const;
 
     std::string mName;
     std::string mNamePlusId;
@@ -184,6 +188,7 @@ private:
     ReleasedLayers mReleasedLayers;
     OutputLayer* mLayerRequestingBackgroundBlur = nullptr;
     std::unique_ptr<ClientCompositionRequestCache> mClientCompositionRequestCache;
+    std::unique_ptr<ClientCompositionDamageTracker> mClientCompositionDamageTracker;
     std::unique_ptr<planner::Planner> mPlanner;
     std::unique_ptr<HwcAsyncWorker> mHwComposerAsyncWorker;
 
@@ -0,0 +1,88 @@
+/*
+ * Copyright 2024 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include <compositionengine/impl/planner/CachedSet.h>
+
+#include <chrono>
+#include <cstdint>
+#include <optional>
+#include <string>
+#include <vector>
+
+namespace android::compositionengine::impl::planner {
+
+// Estimates whether flattening a run of cached sets into a single buffer saves display
+// bandwidth. The Flattener uses it to pick between candidate runs, and never flattens a run with
+// no estimated savings.
+class CostModel {
+public:
+    // A run of cached sets that may be flattened.
+    struct Candidate {
+        // The cached sets in the run, in composition order.
+        std::vector<const CachedSet*> sets;
+        // Set if the run punches a hole for a layer that would otherwise be client composited.
+        const CachedSet* holePunchLayer = nullptr;
+        // Number of planes sent to the display for the whole output, if the run is not flattened.
+        size_t outputPlaneCount = 0;
+    };
+
+    virtual ~CostModel() = default;
+
+    // Returns the estimated bandwidth saved per frame, in pixels, by flattening the candidate.
+    // Values not greater than zero mean that the run is not worth flattening.
+    virtual int64_t estimateSavings(const Candidate&) const = 0;
+
+    // Reports how long RenderEngine took to render a cached set, measured from its draw fence.
+    virtual void onCachedSetRendered(const CachedSet&, std::chrono::nanoseconds renderTime) = 0;
+
+    virtual void dump(std::string& result) const = 0;
+};
+
+// Cost model based on the pixel area read and written by the display and by RenderEngine.
+class DefaultCostModel : public CostModel {
+public:
+    struct Tunables {
+        // Number of planes the display can compose without falling back to client composition.
+        // Zero if unknown, in which case plane savings are not accounted for.
+        size_t maxHwcPlanes = 0;
+        // Number of idle frames over which the cost of rendering a cached set is amortized.
+        size_t amortizationFrames = 60;
+        // Runs predicted to take longer than this to render are not flattened. Zero for no limit.
+        std::chrono::nanoseconds maxRenderDuration = std::chrono::nanoseconds::zero();
+    };
+
+    explicit DefaultCostModel(const Tunables& tunables) : mTunables(tunables) {}
+
+    int64_t estimateSavings(const Candidate&) const override;
+    void onCachedSetRendered(const CachedSet&, std::chrono::nanoseconds renderTime) override;
+    void dump(std::string& result) const override;
+
+    // Predicted RenderEngine time to render the candidate, once a render has been measured.
+    std::optional<std::chrono::nanoseconds> predictRenderDuration(const Candidate&) const;
+
+private:
+    static size_t getCreationCost(const Candidate&);
+
+    const Tunables mTunables;
+
+    // Exponential moving average of the measured render time per pixel of creation cost.
+    std::optional<double> mRenderNsPerPixel;
+    size_t mRenderSamples = 0;
+};
+
+} // namespace android::compositionengine::impl::planner
@@ -18,9 +18,11 @@
 
 #include <compositionengine/Output.h>
 #include <compositionengine/impl/planner/CachedSet.h>
+#include <compositionengine/impl/planner/CostModel.h>
 #include <compositionengine/impl/planner/LayerState.h>
 
 #include <chrono>
+#include <memory>
 #include <numeric>
 #include <vector>
 
@@ -74,6 +76,8 @@ public:
 
         static const constexpr bool kDefaultEnableHolePunch = true;
 
+        static const constexpr std::chrono::milliseconds kDefaultPrerenderLayerTimeout = 0ms;
+
         // Threshold for determing whether a layer is active. A layer whose properties, including
         // the buffer, have not changed in at least this time is considered inactive and is
         // therefore a candidate for flattening.
@@ -85,6 +89,12 @@ public:
 
         // True if the hole punching feature should be enabled.
         const bool mEnableHolePunch;
+
+        // Threshold after which a run of idle layers is flattened speculatively, so that the
+        // cached set can be rendered in the background before the layers are considered
+        // inactive. The cached set is only used once its layers pass mActiveLayerTimeout and is
+        // dropped if any of them updates before then. Zero disables prerendering.
+        const std::chrono::milliseconds mPrerenderLayerTimeout = kDefaultPrerenderLayerTimeout;
     };
 
     // Constants not yet backed by a sysprop
@@ -111,6 +121,10 @@ public:
 
     void setTexturePoolEnabled(bool enabled) { mTexturePool.setEnabled(enabled); }
 
+    // Picks the run to flatten by its estimated savings instead of taking the first candidate,
+    // and skips flattening when no run saves bandwidth. Null restores the default behavior.
+    void setCostModel(std::unique_ptr<CostModel> costModel) { mCostModel = std::move(costModel); }
+
     void dump(std::string& result) const;
     void dumpLayers(std::string& result) const;
 
@@ -223,14 +237,24 @@ private:
         friend class Builder;
     };
 
-    std::vector<Run> findCandidateRuns(std::chrono::steady_clock::time_point now) const;
+    std::vector<Run> findCandidateRuns(std::chrono::steady_clock::time_point now,
+                                       std::chrono::milliseconds activeLayerTimeout) const;
 
     std::optional<Run> findBestRun(std::vector<Run>& runs) const;
 
     void buildCachedSets(std::chrono::steady_clock::time_point now);
 
+    // True if mNewCachedSet was built speculatively and its layers are not inactive yet.
+    bool isNewCachedSetPending(std::chrono::steady_clock::time_point now) const;
+
+    CostModel::Candidate makeCostModelCandidate(const Run& run) const;
+
+    // Feeds the measured render time of mNewCachedSet to the cost model, once it is ready.
+    void reportRenderTime();
+
     renderengine::RenderEngine& mRenderEngine;
     const Tunables mTunables;
+    std::unique_ptr<CostModel> mCostModel;
 
     TexturePool mTexturePool;
 
@@ -239,6 +263,13 @@ protected:
     std::optional<CachedSet> mNewCachedSet;
 
 private:
+    // Set when mNewCachedSet was built from layers that were idle for mPrerenderLayerTimeout but
+    // not yet for mActiveLayerTimeout, along with the time at which they become inactive.
+    bool mNewCachedSetIsSpeculative = false;
+    std::chrono::steady_clock::time_point mNewCachedSetInactiveTime;
+    // Time at which mNewCachedSet was submitted to RenderEngine, cleared once reported.
+    std::optional<std::chrono::steady_clock::time_point> mNewCachedSetRenderStart;
+
     ui::Size mDisplaySize;
 
     NonBufferHash mCurrentGeometry;
@@ -253,6 +284,8 @@ private:
     std::unordered_map<size_t, size_t> mFinalLayerCounts;
     size_t mCachedSetCreationCount = 0;
     size_t mCachedSetCreationCost = 0;
+    size_t mSpeculativeCachedSetCreationCount = 0;
+    size_t mSpeculativeCachedSetUseCount = 0;
     std::unordered_map<size_t, size_t> mInvalidatedCachedSetAges;
 };
 
@@ -249,6 +249,8 @@ public:
 
     ui::Dataspace getDataspace() const { return mOutputDataspace.get(); }
 
+    hardware::graphics::composer::hal::BlendMode getBlendMode() const { return mBlendMode.get(); }
+
     hardware::graphics::composer::hal::PixelFormat getPixelFormat() const {
         return mPixelFormat.get();
     }
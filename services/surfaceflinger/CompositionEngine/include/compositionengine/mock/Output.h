@@ -84,6 +84,7 @@ public:
                  ftl::Future<std::monostate>(const compositionengine::CompositionRefreshArgs&));
     MOCK_CONST_METHOD0(supportsOffloadPresent, bool());
     MOCK_METHOD(void, offloadPresentNextFrame, ());
+    MOCK_CONST_METHOD0(supportsParallelPresent, bool());
 
     MOCK_METHOD1(uncacheBuffers, void(const std::vector<uint64_t>&));
     MOCK_METHOD2(rebuildLayerStacks,
@@ -132,6 +133,7 @@ public:
                  void(const Region&, std::vector<LayerFE::LayerSettings>&));
     MOCK_METHOD1(setExpensiveRenderingExpected, void(bool));
     MOCK_METHOD1(cacheClientCompositionRequests, void(uint32_t));
+    MOCK_METHOD1(trackClientCompositionDamage, void(uint32_t));
     MOCK_METHOD1(canPredictCompositionStrategy, bool(const CompositionRefreshArgs&));
     MOCK_METHOD1(setPredictCompositionStrategy, void(bool));
     MOCK_METHOD1(setTreat170mAsSrgb, void(bool));
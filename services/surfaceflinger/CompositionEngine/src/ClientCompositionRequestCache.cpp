@@ -15,8 +15,11 @@
  */
 
 #include <algorithm>
+#include <cinttypes>
 
+#include <android-base/stringprintf.h>
 #include <compositionengine/impl/ClientCompositionRequestCache.h>
+#include <math/HashCombine.h>
 #include <renderengine/DisplaySettings.h>
 #include <renderengine/LayerSettings.h>
 
@@ -65,12 +68,50 @@ bool layerSettingsAreEqual(const LayerFE::LayerSettings& lhs, const LayerFE::Lay
             equalIgnoringBuffer(lhs, rhs);
 }
 
+size_t getLayerSettingsHash(const LayerFE::LayerSettings& settings) {
+    // Only fields compared by layerSettingsAreEqual may contribute to the hash.
+    const auto& geometry = settings.geometry;
+    const auto& buffer = settings.source.buffer;
+    return hashCombine(settings.bufferId, settings.frameNumber, geometry.boundaries,
+                       geometry.positionTransform, geometry.roundedCornersRadius,
+                       geometry.roundedCornersCrop, settings.source.solidColor,
+                       buffer.useTextureFiltering, buffer.textureTransform,
+                       buffer.usePremultipliedAlpha, buffer.isOpaque, buffer.maxLuminanceNits,
+                       settings.alpha, static_cast<int32_t>(settings.sourceDataspace),
+                       settings.colorTransform, settings.disableBlending,
+                       settings.backgroundBlurRadius);
+}
+
+bool layerSettingsAreAlike(const LayerFE::LayerSettings& lhs, const LayerFE::LayerSettings& rhs) {
+    return equalIgnoringBuffer(lhs, rhs) && lhs.whitePointNits == rhs.whitePointNits &&
+            lhs.skipContentDraw == rhs.skipContentDraw;
+}
+
+bool spreadsDamage(const LayerFE::LayerSettings& settings) {
+    return settings.backgroundBlurRadius > 0 || !settings.blurRegions.empty() ||
+            settings.stretchEffect.hasEffect();
+}
+
 } // namespace
 
+size_t ClientCompositionRequestCache::getRequestHash(
+        const renderengine::DisplaySettings& display,
+        const std::vector<LayerFE::LayerSettings>& layerSettings) {
+    size_t hash = hashCombine(display.physicalDisplay, display.clip, display.maxLuminance,
+                              display.currentLuminanceNits,
+                              static_cast<int32_t>(display.outputDataspace),
+                              display.colorTransform, display.orientation,
+                              display.targetLuminanceNits);
+    for (const LayerFE::LayerSettings& settings : layerSettings) {
+        hashCombineSingleHashed(hash, getLayerSettingsHash(settings));
+    }
+    return hash;
+}
+
 ClientCompositionRequestCache::ClientCompositionRequest::ClientCompositionRequest(
         const renderengine::DisplaySettings& initDisplay,
-        const std::vector<LayerFE::LayerSettings>& initLayerSettings)
-      : display(initDisplay) {
+        const std::vector<LayerFE::LayerSettings>& initLayerSettings, size_t initHash)
+      : display(initDisplay), hash(initHash) {
     layerSettings.reserve(initLayerSettings.size());
     for (const LayerFE::LayerSettings& settings : initLayerSettings) {
         layerSettings.push_back(getLayerSettingsSnapshot(settings));
@@ -79,8 +120,8 @@ ClientCompositionRequestCache::ClientCompositionRequest::ClientCompositionReques
 
 bool ClientCompositionRequestCache::ClientCompositionRequest::equals(
         const renderengine::DisplaySettings& newDisplay,
-        const std::vector<LayerFE::LayerSettings>& newLayerSettings) const {
-    return newDisplay == display &&
+        const std::vector<LayerFE::LayerSettings>& newLayerSettings, size_t newHash) const {
+    return newHash == hash && newDisplay == display &&
             std::equal(layerSettings.begin(), layerSettings.end(), newLayerSettings.begin(),
                        newLayerSettings.end(), layerSettingsAreEqual);
 }
@@ -90,16 +131,21 @@ bool ClientCompositionRequestCache::exists(
         const std::vector<LayerFE::LayerSettings>& layerSettings) const {
     for (const auto& [cachedBufferId, cachedRequest] : mCache) {
         if (cachedBufferId == bufferId) {
-            return cachedRequest.equals(display, layerSettings);
+            const bool hit = cachedRequest.equals(display, layerSettings,
+                                                  getRequestHash(display, layerSettings));
+            (hit ? mHits : mMisses)++;
+            return hit;
         }
     }
+    mMisses++;
     return false;
 }
 
 void ClientCompositionRequestCache::add(uint64_t bufferId,
                                         const renderengine::DisplaySettings& display,
                                         const std::vector<LayerFE::LayerSettings>& layerSettings) {
-    const ClientCompositionRequest request(display, layerSettings);
+    const ClientCompositionRequest request(display, layerSettings,
+                                           getRequestHash(display, layerSettings));
     for (auto& [cachedBufferId, cachedRequest] : mCache) {
         if (cachedBufferId == bufferId) {
             cachedRequest = std::move(request);
@@ -123,4 +169,88 @@ void ClientCompositionRequestCache::remove(uint64_t bufferId) {
     }
 }
 
+void ClientCompositionRequestCache::dump(std::string& out) const {
+    const uint64_t lookups = mHits + mMisses;
+    base::StringAppendF(&out,
+                        "   Client composition cache: %zu/%u entries, %" PRIu64 " hits, %" PRIu64
+                        " misses (%.1f%% hit rate)\n",
+                        mCache.size(), mMaxCacheSize, mHits, mMisses,
+                        lookups ? 100.0 * static_cast<double>(mHits) / static_cast<double>(lookups)
+                                : 0.0);
+}
+
+ClientCompositionDamageTracker::ClientCompositionDamageTracker(uint32_t bufferCount)
+      // Strategy prediction misses compose twice in a frame, so keep enough compositions for
+      // every buffer to be reached even then.
+      : mMaxCompositions(2 * (static_cast<size_t>(bufferCount) + 1)) {}
+
+std::optional<Region> ClientCompositionDamageTracker::onComposition(
+        uint64_t bufferId, const Region& damage, const renderengine::DisplaySettings& display,
+        const std::vector<LayerFE::LayerSettings>& layerSettings) {
+    mComposedThisFrame = true;
+
+    std::optional<Region> redraw;
+    if (std::none_of(layerSettings.begin(), layerSettings.end(), spreadsDamage)) {
+        Region accumulated(damage);
+        for (auto it = mCompositions.rbegin(); it != mCompositions.rend(); it++) {
+            if (!composedAlike(*it, display, layerSettings)) {
+                break;
+            }
+            if (it->bufferId == bufferId) {
+                redraw = std::move(accumulated);
+                break;
+            }
+            accumulated.orSelf(it->damage);
+        }
+    }
+    (redraw ? mPartialRedraws : mFullRedraws)++;
+
+    Composition composition{.bufferId = bufferId, .damage = damage, .display = display};
+    composition.display.damage.clear();
+    composition.layerSettings.reserve(layerSettings.size());
+    for (const LayerFE::LayerSettings& settings : layerSettings) {
+        composition.layerSettings.push_back(getLayerSettingsSnapshot(settings));
+    }
+    if (mCompositions.size() >= mMaxCompositions) {
+        mCompositions.pop_front();
+    }
+    mCompositions.push_back(std::move(composition));
+    return redraw;
+}
+
+void ClientCompositionDamageTracker::remove(uint64_t bufferId) {
+    // Keep the composition itself, since its damage still applies to the other buffers.
+    for (auto& composition : mCompositions) {
+        if (composition.bufferId == bufferId) {
+            composition.bufferId = 0;
+        }
+    }
+}
+
+void ClientCompositionDamageTracker::onFrameFinished(bool damaged) {
+    if (damaged && !mComposedThisFrame) {
+        invalidate();
+    }
+    mComposedThisFrame = false;
+}
+
+void ClientCompositionDamageTracker::invalidate() {
+    mCompositions.clear();
+}
+
+void ClientCompositionDamageTracker::dump(std::string& out) const {
+    base::StringAppendF(&out,
+                        "   Client composition damage: %" PRIu64 " partial redraws, %" PRIu64
+                        " full redraws\n",
+                        mPartialRedraws, mFullRedraws);
+}
+
+bool ClientCompositionDamageTracker::composedAlike(
+        const Composition& composition, const renderengine::DisplaySettings& display,
+        const std::vector<LayerFE::LayerSettings>& layerSettings) {
+    return composition.display == display &&
+            std::equal(composition.layerSettings.begin(), composition.layerSettings.end(),
+                       layerSettings.begin(), layerSettings.end(), layerSettingsAreAlike);
+}
+
 } // namespace android::compositionengine::impl
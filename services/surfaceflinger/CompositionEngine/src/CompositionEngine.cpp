@@ -21,8 +21,12 @@
 #include <compositionengine/OutputLayer.h>
 #include <compositionengine/impl/CompositionEngine.h>
 #include <compositionengine/impl/Display.h>
+#include <compositionengine/impl/HwcAsyncWorker.h>
 #include <ui/DisplayMap.h>
 
+#include <unordered_map>
+#include <vector>
+
 #include <renderengine/RenderEngine.h>
 
 // TODO(b/129481165): remove the #pragma below and fix conversion issues
@@ -125,6 +129,40 @@ void offloadOutputs(Outputs& outputs) {
         output->offloadPresentNextFrame();
     }
 }
+
+// Returns, for each output, whether it can be presented concurrently with the others. An output
+// qualifies when it supports it and none of its layers are composed by another output, since
+// LayerFE composition state is shared between all the outputs that compose it. The first output
+// is always presented on the calling thread.
+std::vector<bool> findParallelOutputs(const Outputs& outputs) {
+    std::vector<bool> parallel(outputs.size(), false);
+    if (outputs.size() < 2) {
+        return parallel;
+    }
+
+    std::unordered_map<const LayerFE*, size_t> layerOutputCounts;
+    for (const auto& output : outputs) {
+        for (const auto* outputLayer : output->getOutputLayersOrderedByZ()) {
+            layerOutputCounts[&outputLayer->getLayerFE()]++;
+        }
+    }
+
+    for (size_t i = 1; i < outputs.size(); i++) {
+        const auto& output = outputs[i];
+        if (!output->supportsParallelPresent()) {
+            continue;
+        }
+        bool sharesLayers = false;
+        for (const auto* outputLayer : output->getOutputLayersOrderedByZ()) {
+            if (layerOutputCounts[&outputLayer->getLayerFE()] > 1) {
+                sharesLayers = true;
+                break;
+            }
+        }
+        parallel[i] = !sharesLayers;
+    }
+    return parallel;
+}
 } // namespace
 
 void CompositionEngine::present(CompositionRefreshArgs& args) {
@@ -150,8 +188,12 @@ void CompositionEngine::present(CompositionRefreshArgs& args) {
     offloadOutputs(args.outputs);
 
     ui::DisplayVector<ftl::Future<std::monostate>> presentFutures;
-    for (const auto& output : args.outputs) {
-        presentFutures.push_back(output->present(args));
+    if (args.presentOutputsInParallel) {
+        presentOutputsInParallel(args, presentFutures);
+    } else {
+        for (const auto& output : args.outputs) {
+            presentFutures.push_back(output->present(args));
+        }
     }
 
     {
@@ -165,6 +207,42 @@ void CompositionEngine::present(CompositionRefreshArgs& args) {
     postComposition(args);
 }
 
+void CompositionEngine::presentOutputsInParallel(
+        CompositionRefreshArgs& args,
+        ui::DisplayVector<ftl::Future<std::monostate>>& presentFutures) {
+    SFTRACE_CALL();
+    const std::vector<bool> parallel = findParallelOutputs(args.outputs);
+
+    // Kick off the independent outputs first so that they overlap with the ones presented on
+    // this thread. Each worker waits for its output's (possibly offloaded) present to finish.
+    size_t workerIndex = 0;
+    std::vector<std::future<bool>> workerResults;
+    for (size_t i = 0; i < args.outputs.size(); i++) {
+        if (!parallel[i]) {
+            continue;
+        }
+        if (workerIndex == mPresentWorkers.size()) {
+            mPresentWorkers.push_back(std::make_unique<HwcAsyncWorker>());
+        }
+        compositionengine::Output* output = args.outputs[i].get();
+        workerResults.push_back(mPresentWorkers[workerIndex++]->send([output, &args]() {
+            output->present(args).get();
+            return true;
+        }));
+    }
+
+    for (size_t i = 0; i < args.outputs.size(); i++) {
+        if (!parallel[i]) {
+            presentFutures.push_back(args.outputs[i]->present(args));
+        }
+    }
+
+    SFTRACE_NAME("Waiting on parallel outputs");
+    for (auto& result : workerResults) {
+        result.get();
+    }
+}
+
 void CompositionEngine::updateCursorAsync(CompositionRefreshArgs& args) {
 
     for (const auto& output : args.outputs) {
@@ -459,4 +459,9 @@ bool Display::supportsOffloadPresent() const {
     return false;
 }
 
+bool Display::supportsParallelPresent() const {
+    // The power advisor tracks per display timings without locking.
+    return mPowerAdvisor == nullptr || !mPowerAdvisor->usePowerHintSession();
+}
+
 } // namespace android::compositionengine::impl
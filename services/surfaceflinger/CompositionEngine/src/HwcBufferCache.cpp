@@ -16,13 +16,28 @@
 
 #include <compositionengine/impl/HwcBufferCache.h>
 
+#include <algorithm>
+#include <cinttypes>
+
+#include <android-base/properties.h>
+#include <android-base/stringprintf.h>
 #include <gui/BufferQueue.h>
 #include <ui/GraphicBuffer.h>
 
 namespace android::compositionengine::impl {
 
-HwcBufferCache::HwcBufferCache() {
-    for (uint32_t i = kMaxLayerBufferCount; i-- > 0;) {
+size_t HwcBufferCache::getDefaultCapacity() {
+    static const size_t sCapacity = static_cast<size_t>(
+            base::GetIntProperty<int32_t>(std::string("debug.sf.hwc_buffer_cache_size"),
+                                          static_cast<int32_t>(kMaxLayerBufferCount)));
+    return sCapacity;
+}
+
+HwcBufferCache::HwcBufferCache() : HwcBufferCache(getDefaultCapacity()) {}
+
+HwcBufferCache::HwcBufferCache(size_t capacity)
+      : mCapacity(std::clamp<size_t>(capacity, 1, kMaxLayerBufferCount)) {
+    for (uint32_t i = static_cast<uint32_t>(mCapacity); i-- > 0;) {
         mFreeSlots.push(i);
     }
 }
@@ -32,8 +47,10 @@ HwcSlotAndBuffer HwcBufferCache::getHwcSlotAndBuffer(const sp<GraphicBuffer>& bu
         Cache& cache = i->second;
         // mark this cache slot as more recently used so it won't get evicted anytime soon
         cache.lruCounter = mLeastRecentlyUsedCounter++;
+        mStats.hits++;
         return {cache.slot, nullptr};
     }
+    mStats.misses++;
     return {cache(buffer), buffer};
 }
 
@@ -59,6 +76,18 @@ uint32_t HwcBufferCache::uncache(uint64_t bufferId) {
     return UINT32_MAX;
 }
 
+void HwcBufferCache::dump(std::string& out) const {
+    const uint64_t lookups = mStats.hits + mStats.misses;
+    base::StringAppendF(&out,
+                        "slots=%zu/%zu hits=%" PRIu64 " misses=%" PRIu64 " evictions=%" PRIu64
+                        " hitRate=%.1f%% ",
+                        mCacheByBufferId.size(), mCapacity, mStats.hits, mStats.misses,
+                        mStats.evictions,
+                        lookups ? 100.0 * static_cast<double>(mStats.hits) /
+                                        static_cast<double>(lookups)
+                                : 0.0);
+}
+
 uint32_t HwcBufferCache::cache(const sp<GraphicBuffer>& buffer) {
     Cache cache;
     cache.slot = getLeastRecentlyUsedSlot();
@@ -81,6 +110,7 @@ uint32_t HwcBufferCache::getLeastRecentlyUsedSlot() {
         uint32_t slot = cacheToErase->second.slot;
         mCacheByBufferId.erase(cacheToErase);
         mFreeSlots.push(slot);
+        mStats.evictions++;
     }
     uint32_t slot = mFreeSlots.top();
     mFreeSlots.pop();
@@ -322,6 +322,14 @@ void Output::dumpBase(std::string& out) const {
         out.append("    No render surface!\n");
     }
 
+    if (mClientCompositionRequestCache) {
+        mClientCompositionRequestCache->dump(out);
+    }
+
+    if (mClientCompositionDamageTracker) {
+        mClientCompositionDamageTracker->dump(out);
+    }
+
     base::StringAppendF(&out, "\n   %zu Layers\n", getOutputLayerCount());
     for (const auto* outputLayer : getOutputLayersOrderedByZ()) {
         if (!outputLayer) {
@@ -379,6 +387,15 @@ void Output::cacheClientCompositionRequests(uint32_t cacheSize) {
     }
 };
 
+void Output::trackClientCompositionDamage(uint32_t bufferCount) {
+    if (bufferCount == 0) {
+        mClientCompositionDamageTracker.reset();
+    } else {
+        mClientCompositionDamageTracker =
+                std::make_unique<ClientCompositionDamageTracker>(bufferCount);
+    }
+}
+
 void Output::setRenderSurfaceForTest(std::unique_ptr<compositionengine::RenderSurface> surface) {
     mRenderSurface = std::move(surface);
 }
@@ -388,6 +405,18 @@ Region Output::getDirtyRegion() const {
     return outputState.dirtyRegion.intersect(outputState.layerStackSpace.getContent());
 }
 
+Region Output::getClientCompositionDamage() const {
+    const auto& outputState = getState();
+    const Region damage = outputState.layerStackSpace.getTransform(outputState.framebufferSpace)
+                                  .transform(getDirtyRegion());
+    // Grow each rect by a pixel to cover filtering across the edges of scaled layers.
+    Region grownDamage;
+    for (const Rect& rect : damage) {
+        grownDamage.orSelf(Rect(rect.left - 1, rect.top - 1, rect.right + 1, rect.bottom + 1));
+    }
+    return grownDamage.intersect(outputState.framebufferSpace.getBoundsAsRect());
+}
+
 bool Output::includesLayer(ui::LayerFilter filter) const {
     return getState().layerFilter.includes(filter);
 }
@@ -543,11 +572,16 @@ void Output::collectVisibleLayers(const compositionengine::CompositionRefreshArg
     // also incrementally calculates the coverage information for each layer as
     // well as the entire output.
     for (auto layer : reversed(refreshArgs.layers)) {
+        if (coverage.outputOccluded) {
+            // The output is completely covered by opaque layers, so nothing below them could
+            // be visible. Skip the region math for the rest of the stack, e.g. everything
+            // behind an opaque fullscreen app.
+            coverage.latchedLayers.insert(layer);
+            continue;
+        }
+
         // Incrementally process the coverage for each layer
         ensureOutputLayerIfVisible(layer, coverage);
-
-        // TODO(b/121291683): Stop early if the output is completely covered and
-        // no more layers could even be visible underneath the ones on top.
     }
 
     setReleasedLayers(refreshArgs);
@@ -761,12 +795,20 @@ void Output::ensureOutputLayerIfVisible(sp<compositionengine::LayerFE>& layerFE,
     // Update accumAboveOpaqueLayers for next (lower) layer
     coverage.aboveOpaqueLayers.orSelf(opaqueRegion);
 
+    const auto& outputState = getState();
+    if (!opaqueRegion.isEmpty()) {
+        // Mirrors the undefinedRegion computation in rebuildLayerStacks.
+        coverage.outputOccluded = Region(outputState.displaySpace.getBoundsAsRect())
+                                          .subtractSelf(outputState.transform.transform(
+                                                  coverage.aboveOpaqueLayers))
+                                          .isEmpty();
+    }
+
     // Compute the visible non-transparent region
     Region visibleNonTransparentRegion = visibleRegion.subtract(transparentRegion);
 
     // Perform the final check to see if this layer is visible on this output
     // TODO(b/121291683): Why does this not use visibleRegion? (see outputSpaceVisibleRegion below)
-    const auto& outputState = getState();
     Region drawRegion(outputState.transform.transform(visibleNonTransparentRegion));
     drawRegion.andSelf(outputState.displaySpace.getBoundsAsRect());
     if (drawRegion.isEmpty()) {
@@ -1323,6 +1365,17 @@ std::optional<base::unique_fd> Output::composeSurfaces(
                                               clientCompositionLayersFE);
     appendRegionFlashRequests(debugRegion, clientCompositionLayers);
 
+    // Find out how much of the buffer changed since it was last composed into. This is recorded
+    // even if the composition is skipped below, since later frames accumulate the damage.
+    std::optional<Region> clientCompositionDamage;
+    if (mClientCompositionDamageTracker) {
+        clientCompositionDamage =
+                mClientCompositionDamageTracker->onComposition(tex->getBuffer()->getId(),
+                                                               getClientCompositionDamage(),
+                                                               clientCompositionDisplay,
+                                                               clientCompositionLayers);
+    }
+
     OutputCompositionState& outputCompositionState = editState();
     // Check if the client composition requests were rendered into the provided graphic buffer. If
     // so, we can reuse the buffer and avoid client composition.
@@ -1356,6 +1409,13 @@ std::optional<base::unique_fd> Output::composeSurfaces(
         setExpensiveRenderingExpected(true);
     }
 
+    // An empty damage means nothing changed, which still has to be drawn in full since
+    // RenderEngine treats an empty damage as the whole buffer.
+    if (clientCompositionDamage && !clientCompositionDamage->isEmpty()) {
+        SFTRACE_NAME("PartialClientComposition");
+        clientCompositionDisplay.damage = std::move(*clientCompositionDamage);
+    }
+
     std::vector<renderengine::LayerSettings> clientRenderEngineLayers;
     clientRenderEngineLayers.reserve(clientCompositionLayers.size());
     std::transform(clientCompositionLayers.begin(), clientCompositionLayers.end(),
@@ -1370,9 +1430,14 @@ std::optional<base::unique_fd> Output::composeSurfaces(
                                            std::move(fd))
                                .get();
 
-    if (mClientCompositionRequestCache && fenceStatus(fenceResult) != NO_ERROR) {
-        // If rendering was not successful, remove the request from the cache.
-        mClientCompositionRequestCache->remove(tex->getBuffer()->getId());
+    if (fenceStatus(fenceResult) != NO_ERROR) {
+        // If rendering was not successful, the buffer contents are unknown.
+        if (mClientCompositionRequestCache) {
+            mClientCompositionRequestCache->remove(tex->getBuffer()->getId());
+        }
+        if (mClientCompositionDamageTracker) {
+            mClientCompositionDamageTracker->remove(tex->getBuffer()->getId());
+        }
     }
     const auto fence = std::move(fenceResult).value_or(Fence::NO_FENCE);
     if (isPowerHintSessionEnabled()) {
@@ -1597,6 +1662,9 @@ void Output::presentFrameAndReleaseLayers(bool flushEvenWhenDisabled) {
     }
 
     auto& outputState = editState();
+    if (mClientCompositionDamageTracker) {
+        mClientCompositionDamageTracker->onFrameFinished(!outputState.dirtyRegion.isEmpty());
+    }
     outputState.dirtyRegion.clear();
 
     auto frame = presentFrame();
@@ -1661,6 +1729,10 @@ void Output::renderCachedSets(const CompositionRefreshArgs& refreshArgs) {
 }
 
 void Output::dirtyEntireOutput() {
+    if (mClientCompositionDamageTracker) {
+        // The dirty region is set in display space, which the damage can't be derived from.
+        mClientCompositionDamageTracker->invalidate();
+    }
     auto& outputState = editState();
     outputState.dirtyRegion.set(outputState.displaySpace.getBoundsAsRect());
 }
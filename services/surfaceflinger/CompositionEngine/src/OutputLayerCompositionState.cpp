@@ -40,6 +40,9 @@ void dumpHwc(const OutputLayerCompositionState::Hwc& hwc, std::string& out) {
     }
 
     dumpVal(out, "composition", toString(hwc.hwcCompositionType), hwc.hwcCompositionType);
+
+    out.append("\n      hwc buffer cache: ");
+    hwc.hwcBufferCache.dump(out);
 }
 
 } // namespace
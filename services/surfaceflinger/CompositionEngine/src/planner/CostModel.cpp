@@ -0,0 +1,147 @@
+/*
+ * Copyright 2024 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#undef LOG_TAG
+#define LOG_TAG "Planner"
+
+#include <algorithm>
+
+#include <android-base/stringprintf.h>
+#include <compositionengine/impl/planner/CostModel.h>
+#include <compositionengine/impl/planner/LayerState.h>
+
+namespace android::compositionengine::impl::planner {
+
+namespace {
+
+// Weight of the latest render time measurement in the moving average.
+constexpr double kRenderTimeSmoothing = 0.2;
+
+int64_t getArea(const Rect& rect) {
+    return static_cast<int64_t>(rect.width()) * static_cast<int64_t>(rect.height());
+}
+
+} // namespace
+
+size_t DefaultCostModel::getCreationCost(const Candidate& candidate) {
+    Region bounds;
+    size_t creationCost = 0;
+    for (const CachedSet* set : candidate.sets) {
+        bounds.orSelf(set->getBounds());
+        creationCost += set->getComponentDisplayCost();
+    }
+    return creationCost + static_cast<size_t>(getArea(bounds.getBounds()));
+}
+
+int64_t DefaultCostModel::estimateSavings(const Candidate& candidate) const {
+    if (candidate.sets.empty()) {
+        return 0;
+    }
+
+    using hardware::graphics::composer::hal::BlendMode;
+    const ui::Dataspace runDataspace =
+            candidate.sets.front()->getFirstLayer().getState()->getDataspace();
+
+    Region bounds;
+    int64_t unflattenedCost = 0;
+    for (const CachedSet* set : candidate.sets) {
+        bounds.orSelf(set->getBounds());
+        if (set->getLayerCount() > 1) {
+            // Already flattened, the display reads a single buffer.
+            unflattenedCost += static_cast<int64_t>(set->getDisplayCost());
+            continue;
+        }
+
+        const LayerState* layer = set->getFirstLayer().getState();
+        const int64_t area = getArea(layer->getDisplayFrame());
+        unflattenedCost += area;
+        // Blended layers also read the pixels they are composed onto.
+        if (layer->getBlendMode() != BlendMode::NONE) {
+            unflattenedCost += area;
+        }
+        // Layers in a different dataspace than the rest of the run are converted on every frame,
+        // where the flattened buffer pays for the conversion once.
+        if (layer->getDataspace() != runDataspace) {
+            unflattenedCost += area;
+        }
+    }
+
+    const int64_t flattenedArea = getArea(bounds.getBounds());
+    int64_t savings = unflattenedCost - flattenedArea;
+
+    // Freeing enough planes to fit within the display budget avoids writing and reading back the
+    // client target.
+    const size_t planesSaved = candidate.sets.size() - 1;
+    if (mTunables.maxHwcPlanes > 0 && candidate.outputPlaneCount > mTunables.maxHwcPlanes &&
+        candidate.outputPlaneCount - planesSaved <= mTunables.maxHwcPlanes) {
+        savings += 2 * flattenedArea;
+    }
+
+    // A hole punch lets a layer that needs rounded corners skip client composition.
+    if (candidate.holePunchLayer && candidate.holePunchLayer->requiresHolePunch()) {
+        savings += 2 * static_cast<int64_t>(candidate.holePunchLayer->getDisplayCost());
+    }
+
+    const size_t amortizationFrames = std::max<size_t>(mTunables.amortizationFrames, 1);
+    savings -= static_cast<int64_t>(getCreationCost(candidate) / amortizationFrames);
+
+    if (mTunables.maxRenderDuration > std::chrono::nanoseconds::zero()) {
+        if (const auto renderDuration = predictRenderDuration(candidate);
+            renderDuration && *renderDuration > mTunables.maxRenderDuration) {
+            return 0;
+        }
+    }
+
+    return savings;
+}
+
+std::optional<std::chrono::nanoseconds> DefaultCostModel::predictRenderDuration(
+        const Candidate& candidate) const {
+    if (!mRenderNsPerPixel) {
+        return std::nullopt;
+    }
+    const double creationCost = static_cast<double>(getCreationCost(candidate));
+    return std::chrono::nanoseconds(static_cast<int64_t>(*mRenderNsPerPixel * creationCost));
+}
+
+void DefaultCostModel::onCachedSetRendered(const CachedSet& set,
+                                           std::chrono::nanoseconds renderTime) {
+    const size_t creationCost = set.getCreationCost();
+    if (creationCost == 0 || renderTime <= std::chrono::nanoseconds::zero()) {
+        return;
+    }
+
+    const double nsPerPixel =
+            static_cast<double>(renderTime.count()) / static_cast<double>(creationCost);
+    mRenderNsPerPixel = mRenderNsPerPixel
+            ? (1.0 - kRenderTimeSmoothing) * *mRenderNsPerPixel + kRenderTimeSmoothing * nsPerPixel
+            : nsPerPixel;
+    mRenderSamples++;
+}
+
+void DefaultCostModel::dump(std::string& result) const {
+    result.append("  Cost model:\n");
+    base::StringAppendF(&result, "    Max HWC planes: %zu, amortization frames: %zu\n",
+                        mTunables.maxHwcPlanes, mTunables.amortizationFrames);
+    if (mRenderNsPerPixel) {
+        base::StringAppendF(&result, "    Render time: %.3f ns/pixel over %zu samples\n",
+                            *mRenderNsPerPixel, mRenderSamples);
+    } else {
+        result.append("    Render time: not measured\n");
+    }
+}
+
+} // namespace android::compositionengine::impl::planner
@@ -19,6 +19,8 @@
 // #define LOG_NDEBUG 0
 #define ATRACE_TAG ATRACE_TAG_GRAPHICS
 
+#include <cinttypes>
+
 #include <android-base/properties.h>
 #include <common/FlagManager.h>
 #include <common/trace.h>
@@ -133,6 +135,13 @@ void Flattener::renderCachedSets(
         if (const auto estimatedRenderFinish =
                     now + mTunables.mRenderScheduling->cachedSetRenderDuration;
             estimatedRenderFinish > *renderDeadline) {
+            // Speculative cached sets are only rendered on frames with time to spare, they are
+            // never forced through since they may be dropped before being used.
+            if (mNewCachedSetIsSpeculative) {
+                SFTRACE_NAME("DeadlinePassed: speculative cached set");
+                return;
+            }
+
             mNewCachedSet->incrementSkipCount();
 
             if (mNewCachedSet->getSkipCount() <=
@@ -148,9 +157,25 @@ void Flattener::renderCachedSets(
         }
     }
 
+    mNewCachedSetRenderStart = std::chrono::steady_clock::now();
     mNewCachedSet->render(mRenderEngine, mTexturePool, outputState, deviceHandlesColorTransform);
 }
 
+void Flattener::reportRenderTime() {
+    if (!mCostModel || !mNewCachedSetRenderStart || !mNewCachedSet->getDrawFence()) {
+        return;
+    }
+
+    // steady_clock and the fence timestamps are both based on CLOCK_MONOTONIC.
+    const nsecs_t signalTime = mNewCachedSet->getDrawFence()->getSignalTime();
+    if (signalTime != Fence::SIGNAL_TIME_INVALID && signalTime != Fence::SIGNAL_TIME_PENDING) {
+        const auto renderTime = std::chrono::nanoseconds(signalTime) -
+                mNewCachedSetRenderStart->time_since_epoch();
+        mCostModel->onCachedSetRendered(*mNewCachedSet, renderTime);
+    }
+    mNewCachedSetRenderStart = std::nullopt;
+}
+
 void Flattener::dumpLayers(std::string& result) const {
     result.append("  Current layers:");
     for (const CachedSet& layer : mLayers) {
@@ -199,6 +224,8 @@ void Flattener::dump(std::string& result) const {
     base::StringAppendF(&result, "\n    Cached sets created: %zd\n", mCachedSetCreationCount);
     base::StringAppendF(&result, "    Cost: %.2f\n",
                         static_cast<float>(mCachedSetCreationCost) / displayArea);
+    base::StringAppendF(&result, "    Speculative cached sets created: %zd, used: %zd\n",
+                        mSpeculativeCachedSetCreationCount, mSpeculativeCachedSetUseCount);
 
     const auto lastUpdate =
             std::chrono::duration_cast<std::chrono::milliseconds>(now - mLastGeometryUpdate);
@@ -208,6 +235,9 @@ void Flattener::dump(std::string& result) const {
     dumpLayers(result);
 
     base::StringAppendF(&result, "\n");
+    if (mCostModel) {
+        mCostModel->dump(result);
+    }
     mTexturePool.dump(result);
 }
 
@@ -314,8 +344,13 @@ bool Flattener::mergeWithCachedSets(const std::vector<const LayerState*>& layers
                 ALOGV("[%s] Dropping new cached set", __func__);
                 ++mInvalidatedCachedSetAges[0];
                 mNewCachedSet = std::nullopt;
-            } else if (mNewCachedSet->hasReadyBuffer()) {
+            } else if (mNewCachedSet->hasReadyBuffer() && !isNewCachedSetPending(now)) {
                 ALOGV("[%s] Found ready buffer", __func__);
+                if (mNewCachedSetIsSpeculative) {
+                    ++mSpeculativeCachedSetUseCount;
+                    mNewCachedSetIsSpeculative = false;
+                }
+                reportRenderTime();
                 size_t skipCount = mNewCachedSet->getLayerCount();
                 while (skipCount != 0) {
                     auto* peekThroughLayer = mNewCachedSet->getHolePunchLayer();
@@ -413,7 +448,8 @@ bool Flattener::mergeWithCachedSets(const std::vector<const LayerState*>& layers
     return true;
 }
 
-std::vector<Flattener::Run> Flattener::findCandidateRuns(time_point now) const {
+std::vector<Flattener::Run> Flattener::findCandidateRuns(
+        time_point now, std::chrono::milliseconds activeLayerTimeout) const {
     SFTRACE_CALL();
     std::vector<Run> runs;
     bool isPartOfRun = false;
@@ -422,7 +458,7 @@ std::vector<Flattener::Run> Flattener::findCandidateRuns(time_point now) const {
     bool runHasFirstLayer = false;
 
     for (auto currentSet = mLayers.cbegin(); currentSet != mLayers.cend(); ++currentSet) {
-        bool layerIsInactive = now - currentSet->getLastUpdate() > mTunables.mActiveLayerTimeout;
+        bool layerIsInactive = now - currentSet->getLastUpdate() > activeLayerTimeout;
         const bool layerHasBlur = currentSet->hasBlurBehind();
         const bool layerDeniedFromCaching = currentSet->cachingHintExcludesLayers();
 
@@ -488,8 +524,33 @@ std::optional<Flattener::Run> Flattener::findBestRun(std::vector<Flattener::Run>
         return std::nullopt;
     }
 
-    // TODO (b/181192467): Choose the best run, instead of just the first.
-    return runs[0];
+    if (!mCostModel) {
+        // TODO (b/181192467): Choose the best run, instead of just the first.
+        return runs[0];
+    }
+
+    std::optional<Run> bestRun;
+    int64_t bestSavings = 0;
+    for (const Run& run : runs) {
+        const int64_t savings = mCostModel->estimateSavings(makeCostModelCandidate(run));
+        ALOGV("[%s] Run of %zu layers saves %" PRId64, __func__, run.getLayerLength(), savings);
+        if (savings > bestSavings) {
+            bestSavings = savings;
+            bestRun.emplace(run);
+        }
+    }
+    return bestRun;
+}
+
+CostModel::Candidate Flattener::makeCostModelCandidate(const Run& run) const {
+    CostModel::Candidate candidate{.holePunchLayer = run.getHolePunchCandidate(),
+                                   .outputPlaneCount = mLayers.size()};
+    size_t layerCount = 0;
+    for (auto set = run.getStart(); layerCount < run.getLayerLength(); ++set) {
+        candidate.sets.push_back(&(*set));
+        layerCount += set->getLayerCount();
+    }
+    return candidate;
 }
 
 void Flattener::buildCachedSets(time_point now) {
@@ -512,10 +573,20 @@ void Flattener::buildCachedSets(time_point now) {
         }
     }
 
-    std::vector<Run> runs = findCandidateRuns(now);
+    std::vector<Run> runs = findCandidateRuns(now, mTunables.mActiveLayerTimeout);
 
     std::optional<Run> bestRun = findBestRun(runs);
 
+    // Nothing is inactive yet, look for a run that is likely to become inactive so that it can be
+    // rendered ahead of time.
+    bool speculative = false;
+    if (!bestRun && mTunables.mPrerenderLayerTimeout > 0ms &&
+        mTunables.mPrerenderLayerTimeout < mTunables.mActiveLayerTimeout) {
+        runs = findCandidateRuns(now, mTunables.mPrerenderLayerTimeout);
+        bestRun = findBestRun(runs);
+        speculative = bestRun.has_value();
+    }
+
     if (!bestRun) {
         return;
     }
@@ -523,9 +594,19 @@ void Flattener::buildCachedSets(time_point now) {
     mNewCachedSet.emplace(*bestRun->getStart());
     mNewCachedSet->setLastUpdate(now);
     auto currentSet = bestRun->getStart();
+    time_point lastLayerUpdate = currentSet->getLastUpdate();
     while (mNewCachedSet->getLayerCount() < bestRun->getLayerLength()) {
         ++currentSet;
         mNewCachedSet->append(*currentSet);
+        lastLayerUpdate = std::max(lastLayerUpdate, currentSet->getLastUpdate());
+    }
+
+    mNewCachedSetIsSpeculative = speculative;
+    mNewCachedSetRenderStart = std::nullopt;
+    if (speculative) {
+        mNewCachedSetInactiveTime = lastLayerUpdate + mTunables.mActiveLayerTimeout;
+        ++mSpeculativeCachedSetCreationCount;
+        SFTRACE_INSTANT("Speculative cached set");
     }
 
     if (bestRun->getBlurringLayer()) {
@@ -555,4 +636,8 @@ void Flattener::buildCachedSets(time_point now) {
     ALOGV("[%s] Added new cached set:\n%s", __func__, dumper().c_str());
 }
 
+bool Flattener::isNewCachedSetPending(time_point now) const {
+    return mNewCachedSetIsSpeculative && now <= mNewCachedSetInactiveTime;
+}
+
 } // namespace android::compositionengine::impl::planner
@@ -61,13 +61,40 @@ Flattener::Tunables buildFlattenerTuneables() {
     const auto enableHolePunch =
             base::GetBoolProperty(std::string("debug.sf.enable_hole_punch_pip"),
                                   Flattener::Tunables::kDefaultEnableHolePunch);
+    const auto prerenderLayerTimeout = std::chrono::milliseconds(base::GetIntProperty<
+            int32_t>(std::string("debug.sf.layer_caching_prerender_timeout_ms"),
+                     Flattener::Tunables::kDefaultPrerenderLayerTimeout.count()));
     return Flattener::Tunables{
             .mActiveLayerTimeout = activeLayerTimeout,
             .mRenderScheduling = buildRenderSchedulingTunables(),
             .mEnableHolePunch = enableHolePunch,
+            .mPrerenderLayerTimeout = prerenderLayerTimeout,
     };
 }
 
+std::unique_ptr<CostModel> buildCostModel() {
+    if (!base::GetBoolProperty(std::string("debug.sf.layer_caching_cost_model"), false)) {
+        return nullptr;
+    }
+
+    const DefaultCostModel::Tunables defaults;
+    const auto maxHwcPlanes =
+            base::GetUintProperty<size_t>(std::string("debug.sf.layer_caching_max_hwc_planes"),
+                                          defaults.maxHwcPlanes);
+    const auto amortizationFrames = base::GetUintProperty<
+            size_t>(std::string("debug.sf.layer_caching_amortization_frames"),
+                    defaults.amortizationFrames);
+    const auto maxRenderDuration = std::chrono::nanoseconds(base::GetUintProperty<
+            uint64_t>(std::string("debug.sf.layer_caching_max_render_duration_ns"),
+                      static_cast<uint64_t>(defaults.maxRenderDuration.count())));
+
+    return std::make_unique<DefaultCostModel>(DefaultCostModel::Tunables{
+            .maxHwcPlanes = maxHwcPlanes,
+            .amortizationFrames = amortizationFrames,
+            .maxRenderDuration = maxRenderDuration,
+    });
+}
+
 } // namespace
 
 Planner::Planner(renderengine::RenderEngine& renderEngine)
@@ -75,6 +102,7 @@ Planner::Planner(renderengine::RenderEngine& renderEngine)
                    buildFlattenerTuneables()) {
     mPredictorEnabled =
             base::GetBoolProperty(std::string("debug.sf.enable_planner_prediction"), false);
+    mFlattener.setCostModel(buildCostModel());
 }
 
 void Planner::setDisplaySize(ui::Size size) {
@@ -0,0 +1,130 @@
+/*
+ * Copyright 2024 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <compositionengine/impl/ClientCompositionRequestCache.h>
+#include <gtest/gtest.h>
+
+namespace android::compositionengine {
+namespace {
+
+using impl::ClientCompositionDamageTracker;
+
+constexpr uint64_t kBufferA = 1;
+constexpr uint64_t kBufferB = 2;
+constexpr uint64_t kBufferC = 3;
+
+const Region kDamage1(Rect(0, 0, 10, 10));
+const Region kDamage2(Rect(20, 20, 30, 30));
+const Region kDamage3(Rect(40, 40, 50, 50));
+
+class ClientCompositionDamageTrackerTest : public testing::Test {
+public:
+    ClientCompositionDamageTrackerTest() {
+        mDisplay.physicalDisplay = Rect(100, 100);
+        mDisplay.clip = Rect(100, 100);
+        LayerFE::LayerSettings layer;
+        layer.geometry.boundaries = FloatRect(0, 0, 100, 100);
+        mLayers.push_back(layer);
+    }
+
+    std::optional<Region> compose(uint64_t bufferId, const Region& damage) {
+        auto redraw = mTracker.onComposition(bufferId, damage, mDisplay, mLayers);
+        mTracker.onFrameFinished(!damage.isEmpty());
+        return redraw;
+    }
+
+protected:
+    ClientCompositionDamageTracker mTracker{3};
+    renderengine::DisplaySettings mDisplay;
+    std::vector<LayerFE::LayerSettings> mLayers;
+};
+
+TEST_F(ClientCompositionDamageTrackerTest, firstCompositionIntoBufferIsFullRedraw) {
+    EXPECT_EQ(std::nullopt, compose(kBufferA, kDamage1));
+    EXPECT_EQ(std::nullopt, compose(kBufferB, kDamage2));
+}
+
+TEST_F(ClientCompositionDamageTrackerTest, accumulatesDamageSinceBufferWasComposed) {
+    compose(kBufferA, kDamage1);
+    compose(kBufferB, kDamage2);
+    compose(kBufferC, kDamage3);
+
+    const auto redraw = compose(kBufferA, kDamage1);
+    ASSERT_TRUE(redraw);
+    EXPECT_TRUE(kDamage1.merge(kDamage2).merge(kDamage3).subtract(*redraw).isEmpty());
+    EXPECT_TRUE(redraw->subtract(kDamage1.merge(kDamage2).merge(kDamage3)).isEmpty());
+}
+
+TEST_F(ClientCompositionDamageTrackerTest, changedLayersRedrawInFull) {
+    compose(kBufferA, kDamage1);
+    compose(kBufferB, kDamage2);
+
+    mLayers[0].alpha = 0.5f;
+    EXPECT_EQ(std::nullopt, compose(kBufferA, kDamage3));
+}
+
+TEST_F(ClientCompositionDamageTrackerTest, changedBufferContentsOnlyRedrawDamage) {
+    compose(kBufferA, kDamage1);
+    compose(kBufferB, kDamage2);
+
+    mLayers[0].bufferId = 42;
+    mLayers[0].frameNumber = 7;
+    EXPECT_TRUE(compose(kBufferA, kDamage3));
+}
+
+TEST_F(ClientCompositionDamageTrackerTest, blurRedrawsInFull) {
+    mLayers[0].backgroundBlurRadius = 10;
+    compose(kBufferA, kDamage1);
+    compose(kBufferB, kDamage2);
+
+    EXPECT_EQ(std::nullopt, compose(kBufferA, kDamage3));
+}
+
+TEST_F(ClientCompositionDamageTrackerTest, damagedFrameWithoutCompositionRedrawsInFull) {
+    compose(kBufferA, kDamage1);
+    compose(kBufferB, kDamage2);
+    mTracker.onFrameFinished(/*damaged*/ true);
+
+    EXPECT_EQ(std::nullopt, compose(kBufferA, kDamage3));
+}
+
+TEST_F(ClientCompositionDamageTrackerTest, undamagedFrameWithoutCompositionKeepsDamage) {
+    compose(kBufferA, kDamage1);
+    compose(kBufferB, kDamage2);
+    mTracker.onFrameFinished(/*damaged*/ false);
+
+    EXPECT_TRUE(compose(kBufferA, kDamage3));
+}
+
+TEST_F(ClientCompositionDamageTrackerTest, removedBufferRedrawsInFull) {
+    compose(kBufferA, kDamage1);
+    compose(kBufferB, kDamage2);
+    mTracker.remove(kBufferA);
+
+    EXPECT_EQ(std::nullopt, compose(kBufferA, kDamage3));
+    EXPECT_TRUE(compose(kBufferB, kDamage1));
+}
+
+TEST_F(ClientCompositionDamageTrackerTest, invalidateRedrawsInFull) {
+    compose(kBufferA, kDamage1);
+    compose(kBufferB, kDamage2);
+    mTracker.invalidate();
+
+    EXPECT_EQ(std::nullopt, compose(kBufferA, kDamage3));
+}
+
+} // namespace
+} // namespace android::compositionengine
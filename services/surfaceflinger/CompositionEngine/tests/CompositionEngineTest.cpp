@@ -30,6 +30,7 @@
 #include "TimeStats/TimeStats.h"
 #include "gmock/gmock.h"
 
+#include <thread>
 #include <variant>
 
 using namespace com::android::graphics::surfaceflinger;
@@ -136,6 +137,86 @@ TEST_F(CompositionEnginePresentTest, worksAsExpected) {
     mEngine.present(mRefreshArgs);
 }
 
+struct CompositionEngineParallelPresentTest : public CompositionEnginePresentTest {
+    struct Layer {
+        Layer() { EXPECT_CALL(outputLayer, getLayerFE()).WillRepeatedly(ReturnRef(*layerFE)); }
+
+        StrictMock<mock::OutputLayer> outputLayer;
+        sp<StrictMock<mock::LayerFE>> layerFE = sp<StrictMock<mock::LayerFE>>::make();
+    };
+
+    CompositionEngineParallelPresentTest() {
+        // mOutput1 and mOutput3 mirror the same layer, mOutput2 has a layer of its own.
+        EXPECT_CALL(*mOutput1, getOutputLayerCount()).WillRepeatedly(Return(1u));
+        EXPECT_CALL(*mOutput1, getOutputLayerOrderedByZByIndex(0))
+                .WillRepeatedly(Return(&mSharedLayer.outputLayer));
+        EXPECT_CALL(*mOutput2, getOutputLayerCount()).WillRepeatedly(Return(1u));
+        EXPECT_CALL(*mOutput2, getOutputLayerOrderedByZByIndex(0))
+                .WillRepeatedly(Return(&mOutput2Layer.outputLayer));
+        EXPECT_CALL(*mOutput3, getOutputLayerCount()).WillRepeatedly(Return(1u));
+        EXPECT_CALL(*mOutput3, getOutputLayerOrderedByZByIndex(0))
+                .WillRepeatedly(Return(&mSharedLayerMirror.outputLayer));
+        EXPECT_CALL(mSharedLayerMirror.outputLayer, getLayerFE())
+                .WillRepeatedly(ReturnRef(*mSharedLayer.layerFE));
+
+        EXPECT_CALL(mEngine, preComposition(Ref(mRefreshArgs)));
+        EXPECT_CALL(mEngine, postComposition(Ref(mRefreshArgs)));
+        EXPECT_CALL(*mOutput1, prepare(Ref(mRefreshArgs), _));
+        EXPECT_CALL(*mOutput2, prepare(Ref(mRefreshArgs), _));
+        EXPECT_CALL(*mOutput3, prepare(Ref(mRefreshArgs), _));
+
+        mRefreshArgs.outputs = {mOutput1, mOutput2, mOutput3};
+        mRefreshArgs.presentOutputsInParallel = true;
+    }
+
+    void expectPresent(mock::Output& output, std::thread::id& outThreadId) {
+        EXPECT_CALL(output, present(Ref(mRefreshArgs))).WillOnce([&outThreadId](const auto&) {
+            outThreadId = std::this_thread::get_id();
+            return ftl::yield<std::monostate>({});
+        });
+    }
+
+    Layer mSharedLayer;
+    Layer mSharedLayerMirror;
+    Layer mOutput2Layer;
+};
+
+TEST_F(CompositionEngineParallelPresentTest, presentsIndependentOutputsOnWorkers) {
+    SET_FLAG_FOR_TEST(flags::multithreaded_present, false);
+    EXPECT_CALL(*mOutput2, supportsParallelPresent()).WillRepeatedly(Return(true));
+    EXPECT_CALL(*mOutput3, supportsParallelPresent()).WillRepeatedly(Return(true));
+
+    std::thread::id output1Thread, output2Thread, output3Thread;
+    expectPresent(*mOutput1, output1Thread);
+    expectPresent(*mOutput2, output2Thread);
+    expectPresent(*mOutput3, output3Thread);
+
+    mEngine.present(mRefreshArgs);
+
+    EXPECT_EQ(std::this_thread::get_id(), output1Thread);
+    // mOutput3 shares a layer with mOutput1 so it stays on the calling thread.
+    EXPECT_EQ(std::this_thread::get_id(), output3Thread);
+    EXPECT_NE(std::thread::id(), output2Thread);
+    EXPECT_NE(std::this_thread::get_id(), output2Thread);
+}
+
+TEST_F(CompositionEngineParallelPresentTest, dependsOnSupport) {
+    SET_FLAG_FOR_TEST(flags::multithreaded_present, false);
+    EXPECT_CALL(*mOutput2, supportsParallelPresent()).WillRepeatedly(Return(false));
+    EXPECT_CALL(*mOutput3, supportsParallelPresent()).WillRepeatedly(Return(false));
+
+    std::thread::id output1Thread, output2Thread, output3Thread;
+    expectPresent(*mOutput1, output1Thread);
+    expectPresent(*mOutput2, output2Thread);
+    expectPresent(*mOutput3, output3Thread);
+
+    mEngine.present(mRefreshArgs);
+
+    EXPECT_EQ(std::this_thread::get_id(), output1Thread);
+    EXPECT_EQ(std::this_thread::get_id(), output2Thread);
+    EXPECT_EQ(std::this_thread::get_id(), output3Thread);
+}
+
 /*
  * CompositionEngine::updateCursorAsync
  */
@@ -85,6 +85,36 @@ TEST_F(HwcBufferCacheTest, getHwcSlotAndBuffer_whenSlotsFull_evictsOldestCachedB
     EXPECT_EQ(cache.uncache(graphicBuffers[0]->getId()), UINT32_MAX);
 }
 
+TEST_F(HwcBufferCacheTest, getHwcSlotAndBuffer_withCapacity_evictsLeastRecentlyUsedBuffer) {
+    HwcBufferCache cache(3);
+    EXPECT_EQ(cache.getCapacity(), 3u);
+
+    sp<GraphicBuffer> buffer3 = sp<GraphicBuffer>::make(1u, 1u, HAL_PIXEL_FORMAT_RGBA_8888, 1u, 0u);
+    sp<GraphicBuffer> buffer4 = sp<GraphicBuffer>::make(1u, 1u, HAL_PIXEL_FORMAT_RGBA_8888, 1u, 0u);
+
+    HwcSlotAndBuffer slotAndBufferFor1 = cache.getHwcSlotAndBuffer(mBuffer1);
+    HwcSlotAndBuffer slotAndBufferFor2 = cache.getHwcSlotAndBuffer(mBuffer2);
+    cache.getHwcSlotAndBuffer(buffer3);
+    // using the 1st buffer again makes the 2nd buffer the least recently used one
+    EXPECT_EQ(cache.getHwcSlotAndBuffer(mBuffer1).buffer, nullptr);
+
+    HwcSlotAndBuffer slotAndBufferFor4 = cache.getHwcSlotAndBuffer(buffer4);
+    EXPECT_EQ(slotAndBufferFor4.buffer, buffer4);
+    EXPECT_EQ(slotAndBufferFor4.slot, slotAndBufferFor2.slot);
+    EXPECT_EQ(cache.uncache(mBuffer2->getId()), UINT32_MAX);
+    EXPECT_EQ(cache.uncache(mBuffer1->getId()), slotAndBufferFor1.slot);
+
+    EXPECT_EQ(cache.getStats().hits, 1u);
+    EXPECT_EQ(cache.getStats().misses, 4u);
+    EXPECT_EQ(cache.getStats().evictions, 1u);
+}
+
+TEST_F(HwcBufferCacheTest, capacity_isClampedToBufferQueueSlots) {
+    EXPECT_EQ(HwcBufferCache(0).getCapacity(), 1u);
+    EXPECT_EQ(HwcBufferCache(1000).getCapacity(),
+              static_cast<size_t>(BufferQueue::NUM_BUFFER_SLOTS));
+}
+
 TEST_F(HwcBufferCacheTest, uncache_whenCached_returnsSlotNumber) {
     HwcBufferCache cache;
     sp<GraphicBuffer> outBuffer;
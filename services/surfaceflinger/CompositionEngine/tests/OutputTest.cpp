@@ -1413,6 +1413,24 @@ TEST_F(OutputCollectVisibleLayersTest, processesCandidateLayersReversedAndSetsOu
     mOutput.collectVisibleLayers(mRefreshArgs, mCoverageState);
 }
 
+TEST_F(OutputCollectVisibleLayersTest, skipsLayersBeneathAnOccludingLayer) {
+    InSequence seq;
+
+    EXPECT_CALL(mOutput, ensureOutputLayerIfVisible(Eq(mLayer3.layerFE), Ref(mCoverageState)))
+            .WillOnce([](sp<compositionengine::LayerFE>&,
+                         compositionengine::Output::CoverageState& coverage) {
+                coverage.outputOccluded = true;
+            });
+
+    EXPECT_CALL(mOutput, setReleasedLayers(Ref(mRefreshArgs)));
+    EXPECT_CALL(mOutput, finalizePendingOutputLayers());
+
+    mOutput.collectVisibleLayers(mRefreshArgs, mCoverageState);
+
+    EXPECT_EQ(1u, mGeomSnapshots.count(mLayer1.layerFE));
+    EXPECT_EQ(1u, mGeomSnapshots.count(mLayer2.layerFE));
+}
+
 /*
  * Output::ensureOutputLayerIfVisible()
  */
@@ -1800,6 +1818,27 @@ TEST_F(OutputEnsureOutputLayerIfVisibleTest,
     EXPECT_THAT(mLayer.outputLayerState.outputSpaceVisibleRegion, RegionEq(kRegionClipped));
 }
 
+TEST_F(OutputEnsureOutputLayerIfVisibleTest, opaqueLayerCoveringOutputOccludesIt) {
+    mLayer.layerFEState.geomLayerBounds = FloatRect{0, 0, 200, 300};
+    mLayer.layerFEState.geomLayerTransform = ui::Transform(TR_IDENT, 200, 300);
+
+    EXPECT_CALL(mOutput, ensureOutputLayer(Eq(0u), Eq(mLayer.layerFE)))
+            .WillOnce(Return(&mLayer.outputLayer));
+
+    ensureOutputLayerIfVisible();
+
+    EXPECT_TRUE(mCoverageState.outputOccluded);
+}
+
+TEST_F(OutputEnsureOutputLayerIfVisibleTest, partiallyCoveringOpaqueLayerDoesNotOccludeOutput) {
+    EXPECT_CALL(mOutput, ensureOutputLayer(Eq(0u), Eq(mLayer.layerFE)))
+            .WillOnce(Return(&mLayer.outputLayer));
+
+    ensureOutputLayerIfVisible();
+
+    EXPECT_FALSE(mCoverageState.outputOccluded);
+}
+
 TEST_F(OutputEnsureOutputLayerIfVisibleTest, coverageAccumulatesTest) {
     mLayer.layerFEState.isOpaque = false;
     mLayer.layerFEState.contentDirty = true;
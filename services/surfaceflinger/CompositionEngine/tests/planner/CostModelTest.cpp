@@ -0,0 +1,144 @@
+/*
+ * Copyright 2024 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <compositionengine/impl/OutputLayerCompositionState.h>
+#include <compositionengine/impl/planner/CachedSet.h>
+#include <compositionengine/impl/planner/CostModel.h>
+#include <compositionengine/impl/planner/LayerState.h>
+#include <compositionengine/mock/LayerFE.h>
+#include <compositionengine/mock/OutputLayer.h>
+#include <gtest/gtest.h>
+#include <memory>
+
+namespace android::compositionengine {
+using namespace std::chrono_literals;
+
+using testing::Return;
+using testing::ReturnRef;
+
+using impl::planner::CachedSet;
+using impl::planner::CostModel;
+using impl::planner::DefaultCostModel;
+using impl::planner::LayerState;
+
+namespace {
+
+class CostModelTest : public testing::Test {
+protected:
+    struct TestLayer {
+        mock::OutputLayer outputLayer;
+        impl::OutputLayerCompositionState outputLayerCompositionState;
+        // LayerFE inherits from RefBase and must be held by an sp<>
+        sp<mock::LayerFE> layerFE;
+        LayerFECompositionState layerFECompositionState;
+        std::unique_ptr<LayerState> layerState;
+    };
+
+    // Adds a layer covering the given frame and returns it as a single layer cached set.
+    const CachedSet& addLayer(const Rect& displayFrame,
+                              hal::BlendMode blendMode = hal::BlendMode::NONE,
+                              ui::Dataspace dataspace = ui::Dataspace::SRGB) {
+        auto testLayer = std::make_unique<TestLayer>();
+        testLayer->outputLayerCompositionState.displayFrame = displayFrame;
+        testLayer->outputLayerCompositionState.visibleRegion = Region(displayFrame);
+        testLayer->outputLayerCompositionState.dataspace = dataspace;
+        testLayer->layerFECompositionState.blendMode = blendMode;
+        testLayer->layerFE = sp<mock::LayerFE>::make();
+
+        EXPECT_CALL(*testLayer->layerFE, getSequence)
+                .WillRepeatedly(Return(static_cast<int32_t>(mTestLayers.size())));
+        EXPECT_CALL(*testLayer->layerFE, getDebugName).WillRepeatedly(Return("testLayer"));
+        EXPECT_CALL(*testLayer->layerFE, getCompositionState)
+                .WillRepeatedly(Return(&testLayer->layerFECompositionState));
+        EXPECT_CALL(testLayer->outputLayer, getLayerFE)
+                .WillRepeatedly(ReturnRef(*testLayer->layerFE));
+        EXPECT_CALL(testLayer->outputLayer, getState)
+                .WillRepeatedly(ReturnRef(testLayer->outputLayerCompositionState));
+
+        testLayer->layerState = std::make_unique<LayerState>(&testLayer->outputLayer);
+        mCachedSets.push_back(std::make_unique<CachedSet>(testLayer->layerState.get(), kStartTime));
+        mTestLayers.emplace_back(std::move(testLayer));
+        return *mCachedSets.back();
+    }
+
+    const std::chrono::steady_clock::time_point kStartTime = std::chrono::steady_clock::now();
+    std::vector<std::unique_ptr<TestLayer>> mTestLayers;
+    std::vector<std::unique_ptr<CachedSet>> mCachedSets;
+};
+
+TEST_F(CostModelTest, overlappingLayersSaveBandwidth) {
+    DefaultCostModel costModel({.amortizationFrames = 1000});
+    const CachedSet& set1 = addLayer(Rect(0, 0, 100, 100));
+    const CachedSet& set2 = addLayer(Rect(0, 0, 100, 100));
+
+    EXPECT_GT(costModel.estimateSavings({.sets = {&set1, &set2}, .outputPlaneCount = 2}), 0);
+}
+
+TEST_F(CostModelTest, disjointLayersDoNotSaveBandwidth) {
+    DefaultCostModel costModel({.amortizationFrames = 1000});
+    const CachedSet& set1 = addLayer(Rect(0, 0, 10, 10));
+    const CachedSet& set2 = addLayer(Rect(90, 90, 100, 100));
+
+    // The flattened buffer covers the bounding box of both layers, which is read every frame.
+    EXPECT_LE(costModel.estimateSavings({.sets = {&set1, &set2}, .outputPlaneCount = 2}), 0);
+}
+
+TEST_F(CostModelTest, blendingAndDataspaceConversionsIncreaseSavings) {
+    DefaultCostModel costModel({.amortizationFrames = 1000});
+    const CachedSet& opaque1 = addLayer(Rect(0, 0, 10, 10));
+    const CachedSet& opaque2 = addLayer(Rect(90, 90, 100, 100));
+    const CachedSet& blended = addLayer(Rect(90, 90, 100, 100), hal::BlendMode::PREMULTIPLIED);
+    const CachedSet& converted =
+            addLayer(Rect(90, 90, 100, 100), hal::BlendMode::NONE, ui::Dataspace::BT2020);
+
+    const int64_t opaqueSavings =
+            costModel.estimateSavings({.sets = {&opaque1, &opaque2}, .outputPlaneCount = 2});
+    EXPECT_GT(costModel.estimateSavings({.sets = {&opaque1, &blended}, .outputPlaneCount = 2}),
+              opaqueSavings);
+    EXPECT_GT(costModel.estimateSavings({.sets = {&opaque1, &converted}, .outputPlaneCount = 2}),
+              opaqueSavings);
+}
+
+TEST_F(CostModelTest, freeingHwcPlanesSavesClientComposition) {
+    DefaultCostModel unlimitedPlanes({.maxHwcPlanes = 0, .amortizationFrames = 1000});
+    DefaultCostModel fourPlanes({.maxHwcPlanes = 4, .amortizationFrames = 1000});
+    const CachedSet& set1 = addLayer(Rect(0, 0, 10, 10));
+    const CachedSet& set2 = addLayer(Rect(90, 90, 100, 100));
+
+    const CostModel::Candidate candidate{.sets = {&set1, &set2}, .outputPlaneCount = 5};
+    EXPECT_LE(unlimitedPlanes.estimateSavings(candidate), 0);
+    EXPECT_GT(fourPlanes.estimateSavings(candidate), 0);
+}
+
+TEST_F(CostModelTest, rejectsRunsPredictedToRenderTooSlowly) {
+    DefaultCostModel costModel({.amortizationFrames = 1000, .maxRenderDuration = 1ms});
+    const CachedSet& set1 = addLayer(Rect(0, 0, 100, 100));
+    const CachedSet& set2 = addLayer(Rect(0, 0, 100, 100));
+    const CostModel::Candidate candidate{.sets = {&set1, &set2}, .outputPlaneCount = 2};
+
+    // Nothing measured yet, the run is accepted.
+    EXPECT_EQ(std::nullopt, costModel.predictRenderDuration(candidate));
+    EXPECT_GT(costModel.estimateSavings(candidate), 0);
+
+    CachedSet flattened(set1);
+    flattened.append(set2);
+    costModel.onCachedSetRendered(flattened, 5ms);
+    ASSERT_NE(std::nullopt, costModel.predictRenderDuration(candidate));
+    EXPECT_EQ(0, costModel.estimateSavings(candidate));
+}
+
+} // namespace
+} // namespace android::compositionengine
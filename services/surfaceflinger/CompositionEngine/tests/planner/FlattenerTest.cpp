@@ -284,6 +284,55 @@ TEST_F(FlattenerTest, flattenLayers_basicFlatten) {
     expectAllLayersFlattened(layers);
 }
 
+TEST_F(FlattenerTest, flattenLayers_costModelSkipsRunsWithoutSavings) {
+    mFlattener->setCostModel(std::make_unique<impl::planner::DefaultCostModel>(
+            impl::planner::DefaultCostModel::Tunables{}));
+
+    auto& layerState1 = mTestLayers[0]->layerState;
+    const auto& overrideBuffer1 = layerState1->getOutputLayer()->getState().overrideInfo.buffer;
+    auto& layerState2 = mTestLayers[1]->layerState;
+    auto& layerState3 = mTestLayers[2]->layerState;
+
+    const std::vector<const LayerState*> layers = {
+            layerState1.get(),
+            layerState2.get(),
+            layerState3.get(),
+    };
+
+    initializeFlattener(layers);
+
+    // The layers are inactive but do not overlap, so flattening them into their bounding box
+    // would read more pixels than it saves.
+    mTime += 200ms;
+    EXPECT_CALL(mRenderEngine, drawLayers(_, _, _, _)).Times(0);
+    initializeOverrideBuffer(layers);
+    EXPECT_EQ(getNonBufferHash(layers),
+              mFlattener->flattenLayers(layers, getNonBufferHash(layers), mTime));
+    mFlattener->renderCachedSets(mOutputState, std::nullopt, true);
+    EXPECT_EQ(std::nullopt, mFlattener->getNewCachedSetForTesting());
+    EXPECT_EQ(nullptr, overrideBuffer1);
+}
+
+TEST_F(FlattenerTest, flattenLayers_costModelFlattensOverlappingLayers) {
+    mFlattener->setCostModel(std::make_unique<impl::planner::DefaultCostModel>(
+            impl::planner::DefaultCostModel::Tunables{}));
+
+    const std::vector<const LayerState*> layers = {
+            mTestLayers[0]->layerState.get(),
+            mTestLayers[1]->layerState.get(),
+            mTestLayers[2]->layerState.get(),
+    };
+    for (size_t i = 0; i < layers.size(); i++) {
+        mTestLayers[i]->outputLayerCompositionState.displayFrame = Rect(0, 0, 10, 10);
+        mTestLayers[i]->layerState->update(&mTestLayers[i]->outputLayer);
+    }
+
+    initializeFlattener(layers);
+
+    mTime += 200ms;
+    expectAllLayersFlattened(layers);
+}
+
 TEST_F(FlattenerTest, flattenLayers_FlattenedLayersStayFlattenWhenNoUpdate) {
     auto& layerState1 = mTestLayers[0]->layerState;
     const auto& overrideBuffer1 = layerState1->getOutputLayer()->getState().overrideInfo.buffer;
@@ -1140,6 +1189,90 @@ TEST_F(FlattenerRenderSchedulingTest, flattenLayers_renderCachedSets_defersUpToM
                                  true);
 }
 
+class FlattenerPrerenderTest : public FlattenerTest {
+public:
+    FlattenerPrerenderTest()
+          : FlattenerTest(Flattener::Tunables{.mActiveLayerTimeout = 100ms,
+                                              .mRenderScheduling = std::nullopt,
+                                              .mEnableHolePunch = true,
+                                              .mPrerenderLayerTimeout = 50ms}) {}
+};
+
+TEST_F(FlattenerPrerenderTest, flattenLayers_prerendersBeforeLayersAreInactive) {
+    auto& layerState1 = mTestLayers[0]->layerState;
+    const auto& overrideBuffer1 = layerState1->getOutputLayer()->getState().overrideInfo.buffer;
+    auto& layerState2 = mTestLayers[1]->layerState;
+    const auto& overrideBuffer2 = layerState2->getOutputLayer()->getState().overrideInfo.buffer;
+
+    const std::vector<const LayerState*> layers = {
+            layerState1.get(),
+            layerState2.get(),
+    };
+
+    initializeFlattener(layers);
+
+    // The layers are idle but still active, the cached set is rendered ahead of time.
+    mTime += 60ms;
+    EXPECT_CALL(mRenderEngine, drawLayers(_, _, _, _))
+            .WillOnce(Return(ByMove(ftl::yield<FenceResult>(Fence::NO_FENCE))));
+    initializeOverrideBuffer(layers);
+    EXPECT_EQ(getNonBufferHash(layers),
+              mFlattener->flattenLayers(layers, getNonBufferHash(layers), mTime));
+    mFlattener->renderCachedSets(mOutputState, std::nullopt, true);
+    EXPECT_EQ(nullptr, overrideBuffer1);
+    EXPECT_EQ(nullptr, overrideBuffer2);
+
+    // The rendered buffer is not used until the layers become inactive.
+    initializeOverrideBuffer(layers);
+    EXPECT_EQ(getNonBufferHash(layers),
+              mFlattener->flattenLayers(layers, getNonBufferHash(layers), mTime));
+    mFlattener->renderCachedSets(mOutputState, std::nullopt, true);
+    EXPECT_EQ(nullptr, overrideBuffer1);
+    EXPECT_EQ(nullptr, overrideBuffer2);
+
+    // Once inactive, the prerendered buffer is used without rendering again.
+    mTime += 60ms;
+    EXPECT_CALL(mRenderEngine, drawLayers(_, _, _, _)).Times(0);
+    initializeOverrideBuffer(layers);
+    EXPECT_NE(getNonBufferHash(layers),
+              mFlattener->flattenLayers(layers, getNonBufferHash(layers), mTime));
+    mFlattener->renderCachedSets(mOutputState, std::nullopt, true);
+    EXPECT_NE(nullptr, overrideBuffer1);
+    EXPECT_EQ(overrideBuffer1, overrideBuffer2);
+}
+
+TEST_F(FlattenerPrerenderTest, flattenLayers_dropsPrerenderedSetOnBufferUpdate) {
+    auto& layerState1 = mTestLayers[0]->layerState;
+    const auto& overrideBuffer1 = layerState1->getOutputLayer()->getState().overrideInfo.buffer;
+    auto& layerState2 = mTestLayers[1]->layerState;
+    const auto& overrideBuffer2 = layerState2->getOutputLayer()->getState().overrideInfo.buffer;
+
+    const std::vector<const LayerState*> layers = {
+            layerState1.get(),
+            layerState2.get(),
+    };
+
+    initializeFlattener(layers);
+
+    mTime += 60ms;
+    EXPECT_CALL(mRenderEngine, drawLayers(_, _, _, _))
+            .WillOnce(Return(ByMove(ftl::yield<FenceResult>(Fence::NO_FENCE))));
+    initializeOverrideBuffer(layers);
+    EXPECT_EQ(getNonBufferHash(layers),
+              mFlattener->flattenLayers(layers, getNonBufferHash(layers), mTime));
+    mFlattener->renderCachedSets(mOutputState, std::nullopt, true);
+    EXPECT_NE(std::nullopt, mFlattener->getNewCachedSetForTesting());
+
+    // A layer posts a buffer before the stack goes inactive, the speculative set is dropped.
+    layerState1->resetFramesSinceBufferUpdate();
+    initializeOverrideBuffer(layers);
+    EXPECT_EQ(getNonBufferHash(layers),
+              mFlattener->flattenLayers(layers, getNonBufferHash(layers), mTime));
+    EXPECT_EQ(std::nullopt, mFlattener->getNewCachedSetForTesting());
+    EXPECT_EQ(nullptr, overrideBuffer1);
+    EXPECT_EQ(nullptr, overrideBuffer2);
+}
+
 TEST_F(FlattenerTest, flattenLayers_skipsLayersDisabledFromCaching) {
     auto& layerState1 = mTestLayers[0]->layerState;
     const auto& overrideBuffer1 = layerState1->getOutputLayer()->getState().overrideInfo.buffer;
@@ -26,6 +26,7 @@
 
 #include "HWC2.h"
 
+#include <android-base/properties.h>
 #include <android/configuration.h>
 #include <common/FlagManager.h>
 #include <ui/Fence.h>
@@ -69,6 +70,13 @@ inline bool hasMetadataKey(const std::set<Hwc2::PerFrameMetadataKey>& keys,
     return keys.find(key) != keys.end();
 }
 
+bool skipUnchangedLayerState() {
+    static const bool sSkipUnchangedLayerState =
+            android::base::GetBoolProperty(std::string("debug.sf.hwc_skip_unchanged_layer_state"),
+                                           false);
+    return sSkipUnchangedLayerState;
+}
+
 } // namespace anonymous
 
 // Display methods
@@ -139,7 +147,8 @@ base::expected<std::shared_ptr<HWC2::Layer>, hal::Error> Display::createLayer()
         return base::unexpected(error);
     }
 
-    auto layer = std::make_shared<impl::Layer>(mComposer, mCapabilities, *this, layerId);
+    auto layer = std::make_shared<impl::Layer>(mComposer, mCapabilities, *this, layerId,
+                                               skipUnchangedLayerState());
     mLayers.emplace(layerId, layer);
     return layer;
 }
@@ -697,6 +706,18 @@ std::vector<Hwc2::IComposerClient::Rect> convertRegionToHwcRects(const Region& r
     }
     return hwcRects;
 }
+
+// Returns true if value was already sent successfully and does not need to be sent again.
+template <typename T>
+bool isUnchanged(bool skipUnchangedState, const std::optional<T>& sent, const T& value) {
+    return skipUnchangedState && sent == value;
+}
+
+// Records value as sent, or forgets the last value if the command failed so that it is retried.
+template <typename T>
+void updateSent(std::optional<T>& sent, const T& value, Hwc2::Error error) {
+    sent = error == Hwc2::Error::NONE ? std::make_optional(value) : std::nullopt;
+}
 } // namespace
 
 Layer::~Layer() = default;
@@ -705,12 +726,13 @@ namespace impl {
 
 Layer::Layer(android::Hwc2::Composer& composer,
              const std::unordered_set<AidlCapability>& capabilities, HWC2::Display& display,
-             HWLayerId layerId)
+             HWLayerId layerId, bool skipUnchangedState)
       : mComposer(composer),
         mCapabilities(capabilities),
         mDisplay(&display),
         mId(layerId),
-        mColorMatrix(android::mat4()) {
+        mColorMatrix(android::mat4()),
+        mSkipUnchangedState(skipUnchangedState) {
     ALOGV("Created layer %" PRIu64 " on display %" PRIu64, layerId, display.getId());
 }
 
@@ -813,7 +835,11 @@ Error Layer::setBlendMode(BlendMode mode)
         return Error::BAD_DISPLAY;
     }
 
+    if (isUnchanged(mSkipUnchangedState, mBlendMode, mode)) {
+        return Error::NONE;
+    }
     auto intError = mComposer.setLayerBlendMode(mDisplay->getId(), mId, mode);
+    updateSent(mBlendMode, mode, intError);
     return static_cast<Error>(intError);
 }
 
@@ -822,7 +848,11 @@ Error Layer::setColor(Color color) {
         return Error::BAD_DISPLAY;
     }
 
+    if (isUnchanged(mSkipUnchangedState, mColor, color)) {
+        return Error::NONE;
+    }
     auto intError = mComposer.setLayerColor(mDisplay->getId(), mId, color);
+    updateSent(mColor, color, intError);
     return static_cast<Error>(intError);
 }
 
@@ -922,9 +952,13 @@ Error Layer::setDisplayFrame(const Rect& frame)
         return Error::BAD_DISPLAY;
     }
 
+    if (isUnchanged(mSkipUnchangedState, mDisplayFrame, frame)) {
+        return Error::NONE;
+    }
     Hwc2::IComposerClient::Rect hwcRect{frame.left, frame.top,
         frame.right, frame.bottom};
     auto intError = mComposer.setLayerDisplayFrame(mDisplay->getId(), mId, hwcRect);
+    updateSent(mDisplayFrame, frame, intError);
     return static_cast<Error>(intError);
 }
 
@@ -934,7 +968,11 @@ Error Layer::setPlaneAlpha(float alpha)
         return Error::BAD_DISPLAY;
     }
 
+    if (isUnchanged(mSkipUnchangedState, mPlaneAlpha, alpha)) {
+        return Error::NONE;
+    }
     auto intError = mComposer.setLayerPlaneAlpha(mDisplay->getId(), mId, alpha);
+    updateSent(mPlaneAlpha, alpha, intError);
     return static_cast<Error>(intError);
 }
 
@@ -959,9 +997,13 @@ Error Layer::setSourceCrop(const FloatRect& crop)
         return Error::BAD_DISPLAY;
     }
 
+    if (isUnchanged(mSkipUnchangedState, mSourceCrop, crop)) {
+        return Error::NONE;
+    }
     Hwc2::IComposerClient::FRect hwcRect{
         crop.left, crop.top, crop.right, crop.bottom};
     auto intError = mComposer.setLayerSourceCrop(mDisplay->getId(), mId, hwcRect);
+    updateSent(mSourceCrop, crop, intError);
     return static_cast<Error>(intError);
 }
 
@@ -971,8 +1013,12 @@ Error Layer::setTransform(Transform transform)
         return Error::BAD_DISPLAY;
     }
 
+    if (isUnchanged(mSkipUnchangedState, mTransform, transform)) {
+        return Error::NONE;
+    }
     auto intTransform = static_cast<Hwc2::Transform>(transform);
     auto intError = mComposer.setLayerTransform(mDisplay->getId(), mId, intTransform);
+    updateSent(mTransform, transform, intError);
     return static_cast<Error>(intError);
 }
 
@@ -998,7 +1044,11 @@ Error Layer::setZOrder(uint32_t z)
         return Error::BAD_DISPLAY;
     }
 
+    if (isUnchanged(mSkipUnchangedState, mZOrder, z)) {
+        return Error::NONE;
+    }
     auto intError = mComposer.setLayerZOrder(mDisplay->getId(), mId, z);
+    updateSent(mZOrder, z, intError);
     return static_cast<Error>(intError);
 }
 
@@ -1038,7 +1088,11 @@ Error Layer::setBrightness(float brightness) {
         return Error::BAD_DISPLAY;
     }
 
+    if (isUnchanged(mSkipUnchangedState, mBrightness, brightness)) {
+        return Error::NONE;
+    }
     auto intError = mComposer.setLayerBrightness(mDisplay->getId(), mId, brightness);
+    updateSent(mBrightness, brightness, intError);
     return static_cast<Error>(intError);
 }
 
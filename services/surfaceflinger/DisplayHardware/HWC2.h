@@ -30,6 +30,7 @@
 #include <utils/Timers.h>
 
 #include <functional>
+#include <optional>
 #include <string>
 #include <unordered_map>
 #include <unordered_set>
@@ -381,7 +382,7 @@ public:
     Layer(android::Hwc2::Composer& composer,
           const std::unordered_set<aidl::android::hardware::graphics::composer3::Capability>&
                   capabilities,
-          HWC2::Display& display, hal::HWLayerId layerId);
+          HWC2::Display& display, hal::HWLayerId layerId, bool skipUnchangedState = false);
     ~Layer() override;
 
     void onOwningDisplayDestroyed();
@@ -443,6 +444,19 @@ private:
     android::HdrMetadata mHdrMetadata;
     android::mat4 mColorMatrix;
     uint32_t mBufferSlot;
+
+    // When set, layer state that matches what was last sent successfully is not sent again, so
+    // that the per frame command buffer only carries the fields that changed. Composer keeps
+    // layer state across frames, so the skipped commands would have been no-ops.
+    const bool mSkipUnchangedState;
+    std::optional<hal::BlendMode> mBlendMode;
+    std::optional<aidl::android::hardware::graphics::composer3::Color> mColor;
+    std::optional<android::Rect> mDisplayFrame;
+    std::optional<float> mPlaneAlpha;
+    std::optional<android::FloatRect> mSourceCrop;
+    std::optional<hal::Transform> mTransform;
+    std::optional<uint32_t> mZOrder;
+    std::optional<float> mBrightness;
 };
 
 } // namespace impl
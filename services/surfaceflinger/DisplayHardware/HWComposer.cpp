@@ -546,6 +546,7 @@ status_t HWComposer::getDeviceCompositionChanges(
     displayData.validateWasSkipped = false;
     SFTRACE_FORMAT("NextFrameInterval %d_Hz", frameInterval.getIntValue());
     if (canSkipValidate) {
+        displayData.presentOrValidateCount++;
         sp<Fence> outPresentFence = Fence::NO_FENCE;
         uint32_t state = UINT32_MAX;
         error = hwcDisplay->presentOrValidate(expectedPresentTime, frameInterval.getPeriodNsecs(),
@@ -560,6 +561,7 @@ status_t HWComposer::getDeviceCompositionChanges(
             displayData.lastPresentFence = outPresentFence;
             displayData.validateWasSkipped = true;
             displayData.presentError = error;
+            displayData.validateSkippedCount++;
             return NO_ERROR;
         }
         // Present failed but Validate ran.
@@ -567,6 +569,7 @@ status_t HWComposer::getDeviceCompositionChanges(
         error = hwcDisplay->validate(expectedPresentTime, frameInterval.getPeriodNsecs(), &numTypes,
                                      &numRequests);
     }
+    displayData.validateCount++;
     ALOGV("SkipValidate failed, Falling back to SLOW validate/present");
     if (!hasChangesError(error)) {
         RETURN_IF_HWC_ERROR_FOR("validate", error, displayId, BAD_INDEX);
@@ -1075,6 +1078,16 @@ void HWComposer::dumpOverlayProperties(std::string& result) const {
 void HWComposer::dump(std::string& result) const {
     result.append(mComposer->dumpDebugInfo());
     dumpOverlayProperties(result);
+
+    result.append("Validation:\n");
+    for (const auto& [displayId, displayData] : mDisplayData) {
+        base::StringAppendF(&result,
+                            "    %s: presentOrValidate=%" PRIu64 " validateSkipped=%" PRIu64
+                            " validate=%" PRIu64 "\n",
+                            to_string(displayId).c_str(), displayData.presentOrValidateCount.load(),
+                            displayData.validateSkippedCount.load(),
+                            displayData.validateCount.load());
+    }
 }
 
 std::optional<PhysicalDisplayId> HWComposer::toPhysicalDisplayId(
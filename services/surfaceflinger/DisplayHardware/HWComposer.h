@@ -16,6 +16,7 @@
 
 #pragma once
 
+#include <atomic>
 #include <cstdint>
 #include <memory>
 #include <mutex>
@@ -524,6 +525,12 @@ private:
         bool validateWasSkipped;
         hal::Error presentError;
 
+        // Frames for which presentOrValidate was attempted, of which the composer presented
+        // without validating, and frames that were validated. Read when dumping.
+        std::atomic<uint64_t> presentOrValidateCount = 0;
+        std::atomic<uint64_t> validateSkippedCount = 0;
+        std::atomic<uint64_t> validateCount = 0;
+
         bool vsyncTraceToggle = false;
 
         std::mutex vsyncEnabledLock;
@@ -83,7 +83,10 @@ void traceExpensiveRendering(bool enabled) {
 } // namespace
 
 PowerAdvisor::PowerAdvisor(SurfaceFlinger& flinger)
-      : mPowerHal(std::make_unique<power::PowerHalController>()), mFlinger(flinger) {
+      : mPowerHal(std::make_unique<power::PowerHalController>()),
+        mFlinger(flinger),
+        mPredictiveLoadHints(
+                base::GetBoolProperty(std::string("debug.sf.adpf_predictive_load_hints"), false)) {
     if (getUpdateTimeout() > 0ms) {
         mScreenUpdateTimer.emplace("UpdateImminentTimer", getUpdateTimeout(),
                                    /* resetCallback */ nullptr,
@@ -521,7 +524,13 @@ void PowerAdvisor::setSkippedValidate(DisplayId displayId, bool skipped) {
 }
 
 void PowerAdvisor::setRequiresRenderEngine(DisplayId displayId, bool requiresRenderEngine) {
-    mDisplayTimingData[displayId].requiresRenderEngine = requiresRenderEngine;
+    auto& timingData = mDisplayTimingData[displayId];
+    // This is reported before RenderEngine draws, so the hint lands ahead of the GPU composition.
+    if (mPredictiveLoadHints && requiresRenderEngine && !timingData.requiresRenderEngine) {
+        SFTRACE_NAME("Predicted RenderEngine load");
+        notifyCpuLoadUp();
+    }
+    timingData.requiresRenderEngine = requiresRenderEngine;
 }
 
 void PowerAdvisor::setExpectedPresentTime(TimePoint expectedPresentTime) {
@@ -557,6 +566,28 @@ void PowerAdvisor::setTotalFrameTargetWorkDuration(Duration targetDuration) {
     mTotalFrameTargetDuration = targetDuration;
 }
 
+void PowerAdvisor::setCompositionLayerCount(size_t layerCount) {
+    if (!mPredictiveLoadHints) {
+        return;
+    }
+
+    const float count = static_cast<float>(layerCount);
+    const bool isSpike = mAverageLayerCount &&
+            count >= *mAverageLayerCount + static_cast<float>(kMinLayerCountSpike) &&
+            count >= *mAverageLayerCount * kLayerCountSpikeRatio;
+    mAverageLayerCount = mAverageLayerCount
+            ? (1.f - kLayerCountSmoothing) * *mAverageLayerCount + kLayerCountSmoothing * count
+            : count;
+    if (sTraceHintSessionData) {
+        SFTRACE_INT("Average layer count", static_cast<int>(*mAverageLayerCount));
+    }
+
+    if (isSpike) {
+        SFTRACE_NAME("Predicted layer count spike");
+        notifyCpuLoadUp();
+    }
+}
+
 std::vector<DisplayId> PowerAdvisor::getOrderedDisplayIds(
         std::optional<TimePoint> DisplayTimingData::*sortBy) {
     std::vector<DisplayId> sortedDisplays;
@@ -101,6 +101,8 @@ public:
     virtual void setDisplays(std::vector<DisplayId>& displayIds) = 0;
     // Sets the target duration for the entire pipeline including the gpu
     virtual void setTotalFrameTargetWorkDuration(Duration targetDuration) = 0;
+    // Reports the number of layers about to be composited, before composition starts
+    virtual void setCompositionLayerCount(size_t layerCount) = 0;
 
     // --- The following methods may run on threads besides SF main ---
     // Send a hint about an upcoming increase in the CPU workload
@@ -145,6 +147,7 @@ public:
     void setCompositeEnd(TimePoint compositeEndTime) override;
     void setDisplays(std::vector<DisplayId>& displayIds) override;
     void setTotalFrameTargetWorkDuration(Duration targetDuration) override;
+    void setCompositionLayerCount(size_t layerCount) override;
 
     // --- The following methods may run on threads besides SF main ---
     void notifyCpuLoadUp() override;
@@ -257,6 +260,17 @@ private:
     // Updated list of display IDs
     std::vector<DisplayId> mDisplayIds;
 
+    // Whether to send CPU_LOAD_UP ahead of frames predicted to be heavier than recent ones, i.e.
+    // frames with a layer count spike, or the first frame to need RenderEngine on a display.
+    // The target and actual durations only catch up once such a frame has been reported.
+    bool mPredictiveLoadHints;
+    // Moving average of the number of layers composited per frame
+    std::optional<float> mAverageLayerCount;
+    // Predictor tunables. A spike must exceed both thresholds over the average.
+    static constexpr float kLayerCountSmoothing = 0.1f;
+    static constexpr float kLayerCountSpikeRatio = 1.5f;
+    static constexpr size_t kMinLayerCountSpike = 4;
+
     // Ensure powerhal connection is initialized
     power::PowerHalController& getPowerHal();
 
@@ -689,9 +689,12 @@ std::string VirtualDisplaySurface::toString(CompositionType type) {
 
 /* Helper to update the output usage when the display is secure */
 
-void VirtualDisplaySurface::setOutputUsage(uint64_t /*flag*/) {
-
-    mOutputUsage = mSinkUsage;
+void VirtualDisplaySurface::setOutputUsage(uint64_t flag) {
+    // Keep the usage requested by the GPU driver along with the sink usage. Otherwise the sink
+    // buffers never get it, and every GPU frame after an HWC frame has to cancel the output
+    // buffer and dequeue another one. Buffers usable by both are reused when the composition type
+    // changes.
+    mOutputUsage = mSinkUsage | flag;
     if (mSecure && (mOutputUsage & GRALLOC_USAGE_HW_VIDEO_ENCODER)) {
         /*TODO: Currently, the framework can only say whether the display
          * and its subsequent session are secure or not. However, there is
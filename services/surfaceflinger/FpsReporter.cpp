@@ -20,6 +20,8 @@
 
 #include <algorithm>
 
+#include <common/trace.h>
+
 #include "FpsReporter.h"
 #include "Layer.h"
 #include "SurfaceFlinger.h"
@@ -41,15 +43,37 @@ void FpsReporter::dispatchLayerFps(const frontend::LayerHierarchy& layerHierarch
     {
         std::scoped_lock lock(mMutex);
         if (mListeners.empty()) {
+            mReports.clear();
             return;
         }
 
-        std::transform(mListeners.begin(), mListeners.end(), std::back_inserter(localListeners),
-                       [](const std::pair<wp<IBinder>, TrackedListener>& entry) {
-                           return entry.second;
-                       });
+        if (mListenersChanged || mHierarchyChanged) {
+            std::transform(mListeners.begin(), mListeners.end(),
+                           std::back_inserter(localListeners),
+                           [](const std::pair<wp<IBinder>, TrackedListener>& entry) {
+                               return entry.second;
+                           });
+            mListenersChanged = false;
+        }
+    }
+
+    if (!localListeners.empty()) {
+        updateReports(layerHierarchy, localListeners);
+        mHierarchyChanged = false;
+    }
+
+    for (const auto& [listener, layerIds] : mReports) {
+        listener.listener->onFpsReported(mFrameTimeline.computeFps(layerIds));
     }
 
+    mLastDispatch = now;
+}
+
+void FpsReporter::updateReports(const frontend::LayerHierarchy& layerHierarchy,
+                                const std::vector<TrackedListener>& listeners) {
+    SFTRACE_CALL();
+    mReports.clear();
+
     std::unordered_set<int32_t> seenTasks;
     std::vector<std::pair<TrackedListener, const frontend::LayerHierarchy*>>
             listenersAndLayersToReport;
@@ -63,8 +87,8 @@ void FpsReporter::dispatchLayerFps(const frontend::LayerHierarchy& layerHierarch
         if (metadata.has(gui::METADATA_TASK_ID)) {
             int32_t taskId = metadata.getInt32(gui::METADATA_TASK_ID, 0);
             if (seenTasks.count(taskId) == 0) {
-                // localListeners is expected to be tiny
-                for (TrackedListener& listener : localListeners) {
+                // listeners is expected to be tiny
+                for (const TrackedListener& listener : listeners) {
                     if (listener.taskId == taskId) {
                         seenTasks.insert(taskId);
                         listenersAndLayersToReport.push_back({listener, &hierarchy});
@@ -88,15 +112,14 @@ void FpsReporter::dispatchLayerFps(const frontend::LayerHierarchy& layerHierarch
             return true;
         });
 
-        listener.listener->onFpsReported(mFrameTimeline.computeFps(layerIds));
+        mReports.push_back({listener, std::move(layerIds)});
     }
-
-    mLastDispatch = now;
 }
 
 void FpsReporter::binderDied(const wp<IBinder>& who) {
     std::scoped_lock lock(mMutex);
     mListeners.erase(who);
+    mListenersChanged = true;
 }
 
 void FpsReporter::addListener(const sp<gui::IFpsListener>& listener, int32_t taskId) {
@@ -104,11 +127,13 @@ void FpsReporter::addListener(const sp<gui::IFpsListener>& listener, int32_t tas
     asBinder->linkToDeath(sp<DeathRecipient>::fromExisting(this));
     std::lock_guard lock(mMutex);
     mListeners.emplace(wp<IBinder>(asBinder), TrackedListener{listener, taskId});
+    mListenersChanged = true;
 }
 
 void FpsReporter::removeListener(const sp<gui::IFpsListener>& listener) {
     std::lock_guard lock(mMutex);
     mListeners.erase(wp<IBinder>(IInterface::asBinder(listener)));
+    mListenersChanged = true;
 }
 
 } // namespace android
@@ -21,6 +21,8 @@
 #include <binder/IBinder.h>
 
 #include <unordered_map>
+#include <unordered_set>
+#include <vector>
 
 #include "Clock.h"
 #include "FrameTimeline/FrameTimeline.h"
@@ -40,8 +42,14 @@ public:
     // Dispatches updated layer fps values for the registered listeners
     // This method promotes Layer weak pointers and performs layer stack traversals, so mStateLock
     // must be held when calling this method.
+    // The layers of each listener's task are looked up in the hierarchy again only after it changed
+    // or a listener was added.
     void dispatchLayerFps(const frontend::LayerHierarchy&) EXCLUDES(mMutex);
 
+    // Notifies that layers were added, removed, reparented or had their metadata changed, so that
+    // the layers of each task are looked up again on the next dispatch.
+    void onHierarchyChanged() { mHierarchyChanged = true; }
+
     // Override for IBinder::DeathRecipient
     void binderDied(const wp<IBinder>&) override;
 
@@ -58,12 +66,24 @@ private:
         int32_t taskId;
     };
 
+    struct Report {
+        TrackedListener listener;
+        std::unordered_set<int32_t> layerIds;
+    };
+
+    void updateReports(const frontend::LayerHierarchy&, const std::vector<TrackedListener>&);
+
     frametimeline::FrameTimeline& mFrameTimeline;
     static const constexpr std::chrono::steady_clock::duration kMinDispatchDuration =
             std::chrono::milliseconds(500);
     std::unique_ptr<Clock> mClock;
     std::chrono::steady_clock::time_point mLastDispatch;
     std::unordered_map<wp<IBinder>, TrackedListener, WpHash> mListeners GUARDED_BY(mMutex);
+    bool mListenersChanged GUARDED_BY(mMutex) = false;
+
+    // Only accessed by the thread dispatching the fps.
+    bool mHierarchyChanged = true;
+    std::vector<Report> mReports;
 };
 
 } // namespace android
\ No newline at end of file
@@ -971,6 +971,23 @@ FrameTimeline::DisplayFrame::DisplayFrame(std::shared_ptr<TimeStats> timeStats,
     mSurfaceFrames.reserve(kNumSurfaceFramesInitial);
 }
 
+void FrameTimeline::DisplayFrame::recycle() {
+    mToken = FrameTimelineInfo::INVALID_VSYNC_ID;
+    mSurfaceFlingerPredictions = TimelineItem();
+    mSurfaceFlingerActuals = TimelineItem();
+    // clear() keeps the capacity of the vector around for the next frame.
+    mSurfaceFrames.clear();
+    mPredictionState = PredictionState::None;
+    mJankType = JankType::None;
+    mJankSeverityType = JankSeverityType::None;
+    mGpuFence = FenceTime::NO_FENCE;
+    mFramePresentMetadata = FramePresentMetadata::UnknownPresent;
+    mFrameReadyMetadata = FrameReadyMetadata::UnknownFinish;
+    mFrameStartMetadata = FrameStartMetadata::UnknownStart;
+    mRefreshRate = Fps();
+    mRenderRate = Fps();
+}
+
 void FrameTimeline::addSurfaceFrame(std::shared_ptr<SurfaceFrame> surfaceFrame) {
     SFTRACE_CALL();
     std::scoped_lock lock(mMutex);
@@ -1194,47 +1211,92 @@ void FrameTimeline::DisplayFrame::onCommitNotComposited() {
     }
 }
 
-void FrameTimeline::DisplayFrame::tracePredictions(pid_t surfaceFlingerPid, nsecs_t monoBootOffset,
-                                                   bool filterFramesBeforeTraceStarts) const {
-    int64_t expectedTimelineCookie = mTraceCookieCounter.getCookieForTracing();
-    bool traced = false;
+void FrameTimeline::DisplayFrame::traceTimelines(pid_t surfaceFlingerPid, nsecs_t monoBootOffset,
+                                                 bool filterFramesBeforeTraceStarts) const {
+    // Expired and unknown predictions have zeroed timestamps. This cannot be used in any
+    // meaningful way in a trace.
+    const bool tracePredictions = mPredictionState == PredictionState::Valid;
+    const int64_t expectedTimelineCookie =
+            tracePredictions ? mTraceCookieCounter.getCookieForTracing() : 0;
+    const int64_t actualTimelineCookie = mTraceCookieCounter.getCookieForTracing();
 
-    // Expected timeline start
     FrameTimelineDataSource::Trace([&](FrameTimelineDataSource::TraceContext ctx) {
-        const auto timestamp = mSurfaceFlingerPredictions.startTime;
-        if (filterFramesBeforeTraceStarts && !shouldTraceForDataSource(ctx, timestamp)) {
-            // Do not trace packets started before tracing starts.
+        // Do not trace packets started before tracing starts.
+        if (tracePredictions &&
+            (!filterFramesBeforeTraceStarts ||
+             shouldTraceForDataSource(ctx, mSurfaceFlingerPredictions.startTime))) {
+            // Expected timeline start
+            {
+                auto packet = ctx.NewTracePacket();
+                packet->set_timestamp_clock_id(perfetto::protos::pbzero::BUILTIN_CLOCK_BOOTTIME);
+                packet->set_timestamp(static_cast<uint64_t>(mSurfaceFlingerPredictions.startTime +
+                                                            monoBootOffset));
+
+                auto* event = packet->set_frame_timeline_event();
+                auto* expectedDisplayFrameStartEvent = event->set_expected_display_frame_start();
+
+                expectedDisplayFrameStartEvent->set_cookie(expectedTimelineCookie);
+
+                expectedDisplayFrameStartEvent->set_token(mToken);
+                expectedDisplayFrameStartEvent->set_pid(surfaceFlingerPid);
+            }
+
+            // Expected timeline end
+            {
+                auto packet = ctx.NewTracePacket();
+                packet->set_timestamp_clock_id(perfetto::protos::pbzero::BUILTIN_CLOCK_BOOTTIME);
+                packet->set_timestamp(
+                        static_cast<uint64_t>(mSurfaceFlingerPredictions.endTime + monoBootOffset));
+
+                auto* event = packet->set_frame_timeline_event();
+                auto* expectedDisplayFrameEndEvent = event->set_frame_end();
+
+                expectedDisplayFrameEndEvent->set_cookie(expectedTimelineCookie);
+            }
+        }
+
+        if (filterFramesBeforeTraceStarts &&
+            !shouldTraceForDataSource(ctx, mSurfaceFlingerActuals.startTime)) {
             return;
         }
-        traced = true;
 
-        auto packet = ctx.NewTracePacket();
-        packet->set_timestamp_clock_id(perfetto::protos::pbzero::BUILTIN_CLOCK_BOOTTIME);
-        packet->set_timestamp(static_cast<uint64_t>(timestamp + monoBootOffset));
+        // Actual timeline start
+        {
+            auto packet = ctx.NewTracePacket();
+            packet->set_timestamp_clock_id(perfetto::protos::pbzero::BUILTIN_CLOCK_BOOTTIME);
+            packet->set_timestamp(
+                    static_cast<uint64_t>(mSurfaceFlingerActuals.startTime + monoBootOffset));
 
-        auto* event = packet->set_frame_timeline_event();
-        auto* expectedDisplayFrameStartEvent = event->set_expected_display_frame_start();
+            auto* event = packet->set_frame_timeline_event();
+            auto* actualDisplayFrameStartEvent = event->set_actual_display_frame_start();
 
-        expectedDisplayFrameStartEvent->set_cookie(expectedTimelineCookie);
+            actualDisplayFrameStartEvent->set_cookie(actualTimelineCookie);
 
-        expectedDisplayFrameStartEvent->set_token(mToken);
-        expectedDisplayFrameStartEvent->set_pid(surfaceFlingerPid);
-    });
+            actualDisplayFrameStartEvent->set_token(mToken);
+            actualDisplayFrameStartEvent->set_pid(surfaceFlingerPid);
 
-    if (traced) {
-        // Expected timeline end
-        FrameTimelineDataSource::Trace([&](FrameTimelineDataSource::TraceContext ctx) {
+            actualDisplayFrameStartEvent->set_present_type(toProto(mFramePresentMetadata));
+            actualDisplayFrameStartEvent->set_on_time_finish(mFrameReadyMetadata ==
+                                                             FrameReadyMetadata::OnTimeFinish);
+            actualDisplayFrameStartEvent->set_gpu_composition(mGpuFence != FenceTime::NO_FENCE);
+            actualDisplayFrameStartEvent->set_jank_type(jankTypeBitmaskToProto(mJankType));
+            actualDisplayFrameStartEvent->set_prediction_type(toProto(mPredictionState));
+            actualDisplayFrameStartEvent->set_jank_severity_type(toProto(mJankSeverityType));
+        }
+
+        // Actual timeline end
+        {
             auto packet = ctx.NewTracePacket();
             packet->set_timestamp_clock_id(perfetto::protos::pbzero::BUILTIN_CLOCK_BOOTTIME);
             packet->set_timestamp(
-                    static_cast<uint64_t>(mSurfaceFlingerPredictions.endTime + monoBootOffset));
+                    static_cast<uint64_t>(mSurfaceFlingerActuals.presentTime + monoBootOffset));
 
             auto* event = packet->set_frame_timeline_event();
-            auto* expectedDisplayFrameEndEvent = event->set_frame_end();
+            auto* actualDisplayFrameEndEvent = event->set_frame_end();
 
-            expectedDisplayFrameEndEvent->set_cookie(expectedTimelineCookie);
-        });
-    }
+            actualDisplayFrameEndEvent->set_cookie(actualTimelineCookie);
+        }
+    });
 }
 
 void FrameTimeline::DisplayFrame::addSkippedFrame(pid_t surfaceFlingerPid, nsecs_t monoBootOffset,
@@ -1313,57 +1375,6 @@ void FrameTimeline::DisplayFrame::addSkippedFrame(pid_t surfaceFlingerPid, nsecs
     }
 }
 
-void FrameTimeline::DisplayFrame::traceActuals(pid_t surfaceFlingerPid, nsecs_t monoBootOffset,
-                                               bool filterFramesBeforeTraceStarts) const {
-    int64_t actualTimelineCookie = mTraceCookieCounter.getCookieForTracing();
-    bool traced = false;
-
-    // Actual timeline start
-    FrameTimelineDataSource::Trace([&](FrameTimelineDataSource::TraceContext ctx) {
-        const auto timestamp = mSurfaceFlingerActuals.startTime;
-        if (filterFramesBeforeTraceStarts && !shouldTraceForDataSource(ctx, timestamp)) {
-            // Do not trace packets started before tracing starts.
-            return;
-        }
-        traced = true;
-
-        auto packet = ctx.NewTracePacket();
-        packet->set_timestamp_clock_id(perfetto::protos::pbzero::BUILTIN_CLOCK_BOOTTIME);
-        packet->set_timestamp(static_cast<uint64_t>(timestamp + monoBootOffset));
-
-        auto* event = packet->set_frame_timeline_event();
-        auto* actualDisplayFrameStartEvent = event->set_actual_display_frame_start();
-
-        actualDisplayFrameStartEvent->set_cookie(actualTimelineCookie);
-
-        actualDisplayFrameStartEvent->set_token(mToken);
-        actualDisplayFrameStartEvent->set_pid(surfaceFlingerPid);
-
-        actualDisplayFrameStartEvent->set_present_type(toProto(mFramePresentMetadata));
-        actualDisplayFrameStartEvent->set_on_time_finish(mFrameReadyMetadata ==
-                                                         FrameReadyMetadata::OnTimeFinish);
-        actualDisplayFrameStartEvent->set_gpu_composition(mGpuFence != FenceTime::NO_FENCE);
-        actualDisplayFrameStartEvent->set_jank_type(jankTypeBitmaskToProto(mJankType));
-        actualDisplayFrameStartEvent->set_prediction_type(toProto(mPredictionState));
-        actualDisplayFrameStartEvent->set_jank_severity_type(toProto(mJankSeverityType));
-    });
-
-    if (traced) {
-        // Actual timeline end
-        FrameTimelineDataSource::Trace([&](FrameTimelineDataSource::TraceContext ctx) {
-            auto packet = ctx.NewTracePacket();
-            packet->set_timestamp_clock_id(perfetto::protos::pbzero::BUILTIN_CLOCK_BOOTTIME);
-            packet->set_timestamp(
-                    static_cast<uint64_t>(mSurfaceFlingerActuals.presentTime + monoBootOffset));
-
-            auto* event = packet->set_frame_timeline_event();
-            auto* actualDisplayFrameEndEvent = event->set_frame_end();
-
-            actualDisplayFrameEndEvent->set_cookie(actualTimelineCookie);
-        });
-    }
-}
-
 nsecs_t FrameTimeline::DisplayFrame::trace(pid_t surfaceFlingerPid, nsecs_t monoBootOffset,
                                            nsecs_t previousPredictionPresentTime,
                                            bool filterFramesBeforeTraceStarts) const {
@@ -1379,12 +1390,7 @@ nsecs_t FrameTimeline::DisplayFrame::trace(pid_t surfaceFlingerPid, nsecs_t mono
         return previousPredictionPresentTime;
     }
 
-    if (mPredictionState == PredictionState::Valid) {
-        // Expired and unknown predictions have zeroed timestamps. This cannot be used in any
-        // meaningful way in a trace.
-        tracePredictions(surfaceFlingerPid, monoBootOffset, filterFramesBeforeTraceStarts);
-    }
-    traceActuals(surfaceFlingerPid, monoBootOffset, filterFramesBeforeTraceStarts);
+    traceTimelines(surfaceFlingerPid, monoBootOffset, filterFramesBeforeTraceStarts);
 
     for (auto& surfaceFrame : mSurfaceFrames) {
         surfaceFrame->trace(mToken, monoBootOffset, filterFramesBeforeTraceStarts);
@@ -1457,9 +1463,17 @@ float FrameTimeline::computeFps(const std::unordered_set<int32_t>& layerIds) {
 }
 
 std::optional<size_t> FrameTimeline::getFirstSignalFenceIndex() const {
+    // Poll all the pending fences at once rather than querying each of them.
+    std::vector<FenceTime*> fences;
+    fences.reserve(mPendingPresentFences.size());
+    for (const auto& [fence, _] : mPendingPresentFences) {
+        fences.push_back(fence.get());
+    }
+    FenceTime::updateSignalTimes(fences);
+
     for (size_t i = 0; i < mPendingPresentFences.size(); i++) {
         const auto& [fence, _] = mPendingPresentFences[i];
-        if (fence && fence->getSignalTime() != Fence::SIGNAL_TIME_PENDING) {
+        if (fence && fence->getCachedSignalTime() != Fence::SIGNAL_TIME_PENDING) {
             return i;
         }
     }
@@ -1515,14 +1529,24 @@ void FrameTimeline::flushPendingPresentFences() {
 }
 
 void FrameTimeline::finalizeCurrentDisplayFrame() {
+    std::shared_ptr<DisplayFrame> recycledDisplayFrame;
     while (mDisplayFrames.size() >= mMaxDisplayFrames) {
-        // We maintain only a fixed number of frames' data. Pop older frames
+        // We maintain only a fixed number of frames' data. Pop older frames, and reuse one that is
+        // no longer referenced elsewhere rather than allocating a new DisplayFrame every frame.
+        if (mDisplayFrames.front().use_count() == 1) {
+            recycledDisplayFrame = std::move(mDisplayFrames.front());
+        }
         mDisplayFrames.pop_front();
     }
-    mDisplayFrames.push_back(mCurrentDisplayFrame);
-    mCurrentDisplayFrame.reset();
-    mCurrentDisplayFrame = std::make_shared<DisplayFrame>(mTimeStats, mJankClassificationThresholds,
-                                                          &mTraceCookieCounter);
+    mDisplayFrames.push_back(std::move(mCurrentDisplayFrame));
+    if (recycledDisplayFrame) {
+        recycledDisplayFrame->recycle();
+        mCurrentDisplayFrame = std::move(recycledDisplayFrame);
+    } else {
+        mCurrentDisplayFrame =
+                std::make_shared<DisplayFrame>(mTimeStats, mJankClassificationThresholds,
+                                               &mTraceCookieCounter);
+    }
 }
 
 nsecs_t FrameTimeline::DisplayFrame::getBaseTime() const {
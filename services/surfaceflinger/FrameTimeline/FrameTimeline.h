@@ -401,6 +401,8 @@ public:
         nsecs_t trace(pid_t surfaceFlingerPid, nsecs_t monoBootOffset,
                       nsecs_t previousPredictionPresentTime,
                       bool filterFramesBeforeTraceStarts) const;
+        // Clears all the state so that the DisplayFrame can be reused for a new frame.
+        void recycle();
         // Sets the token, vsyncPeriod, predictions and SF start time.
         void onSfWakeUp(int64_t token, Fps refreshRate, Fps renderRate,
                         std::optional<TimelineItem> predictions, nsecs_t wakeUpTime);
@@ -434,10 +436,10 @@ public:
 
     private:
         void dump(std::string& result, nsecs_t baseTime) const;
-        void tracePredictions(pid_t surfaceFlingerPid, nsecs_t monoBootOffset,
-                              bool filterFramesBeforeTraceStarts) const;
-        void traceActuals(pid_t surfaceFlingerPid, nsecs_t monoBootOffset,
-                          bool filterFramesBeforeTraceStarts) const;
+        // Writes the expected and actual timeline packets of the DisplayFrame in a single pass
+        // over the data source instances.
+        void traceTimelines(pid_t surfaceFlingerPid, nsecs_t monoBootOffset,
+                            bool filterFramesBeforeTraceStarts) const;
         void addSkippedFrame(pid_t surfaceFlingerPid, nsecs_t monoBootOffset,
                              nsecs_t previousActualPresentTime,
                              bool filterFramesBeforeTraceStarts) const;
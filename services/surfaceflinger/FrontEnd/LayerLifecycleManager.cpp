@@ -122,6 +122,12 @@ void LayerLifecycleManager::onHandlesDestroyed(
 
         RequestedLayerState& layer = it->second.owner;
 
+        if (layer.parentId != UNASSIGNED_LAYER_ID) {
+            mLayersWithRemovedChildren.emplace_back(layer.parentId);
+        }
+        if (layer.relativeParentId != UNASSIGNED_LAYER_ID) {
+            mLayersWithRemovedChildren.emplace_back(layer.relativeParentId);
+        }
         layer.parentId = unlinkLayer(layer.parentId, layer.id);
         layer.relativeParentId = unlinkLayer(layer.relativeParentId, layer.id);
         if (layer.layerStackToMirror != ui::INVALID_LAYER_STACK) {
@@ -259,6 +265,9 @@ void LayerLifecycleManager::applyTransactions(const std::vector<TransactionState
             }
 
             if (oldParentId != layer->parentId) {
+                if (oldParentId != UNASSIGNED_LAYER_ID) {
+                    mLayersWithRemovedChildren.emplace_back(oldParentId);
+                }
                 unlinkLayer(oldParentId, layer->id);
                 layer->parentId = linkLayer(layer->parentId, layer->id);
                 if (oldParentId == UNASSIGNED_LAYER_ID) {
@@ -269,6 +278,9 @@ void LayerLifecycleManager::applyTransactions(const std::vector<TransactionState
                 updateDisplayMirrorLayers(*layer);
             }
             if (oldRelativeParentId != layer->relativeParentId) {
+                if (oldRelativeParentId != UNASSIGNED_LAYER_ID) {
+                    mLayersWithRemovedChildren.emplace_back(oldRelativeParentId);
+                }
                 unlinkLayer(oldRelativeParentId, layer->id);
                 layer->relativeParentId = linkLayer(layer->relativeParentId, layer->id);
             }
@@ -301,6 +313,7 @@ void LayerLifecycleManager::commitChanges() {
     }
     mDestroyedLayers.clear();
     mChangedLayers.clear();
+    mLayersWithRemovedChildren.clear();
     mGlobalChanges.clear();
 }
 
@@ -325,6 +338,10 @@ const std::vector<RequestedLayerState*>& LayerLifecycleManager::getChangedLayers
     return mChangedLayers;
 }
 
+const std::vector<uint32_t>& LayerLifecycleManager::getLayersWithRemovedChildren() const {
+    return mLayersWithRemovedChildren;
+}
+
 const ftl::Flags<RequestedLayerState::Changes> LayerLifecycleManager::getGlobalChanges() const {
     return mGlobalChanges;
 }
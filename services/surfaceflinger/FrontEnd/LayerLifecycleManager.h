@@ -78,6 +78,9 @@ public:
     const std::vector<std::unique_ptr<RequestedLayerState>>& getLayers() const;
     const std::vector<std::unique_ptr<RequestedLayerState>>& getDestroyedLayers() const;
     const std::vector<RequestedLayerState*>& getChangedLayers() const;
+    // Returns the ids of layers that lost a child or a relative child since the last commit,
+    // either because the child was reparented or destroyed.
+    const std::vector<uint32_t>& getLayersWithRemovedChildren() const;
     const ftl::Flags<RequestedLayerState::Changes> getGlobalChanges() const;
     const RequestedLayerState* getLayerFromId(uint32_t) const;
     bool isLayerSecure(uint32_t) const;
@@ -117,6 +120,8 @@ private:
     std::vector<RequestedLayerState*> mAddedLayers;
     // Keeps track of new and layers with states changes since last commit.
     std::vector<RequestedLayerState*> mChangedLayers;
+    // Keeps track of layers that lost a child or relative child since last commit.
+    std::vector<uint32_t> mLayersWithRemovedChildren;
 };
 
 } // namespace android::surfaceflinger::frontend
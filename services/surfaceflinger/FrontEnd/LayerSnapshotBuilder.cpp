@@ -311,6 +311,13 @@ void updateMetadataAndGameMode(LayerSnapshot& snapshot, const RequestedLayerStat
     }
 }
 
+// Changes that are propagated from a parent snapshot to its children.
+constexpr ftl::Flags<RequestedLayerState::Changes> kChangesInheritedFromParent =
+        RequestedLayerState::Changes::Hierarchy | RequestedLayerState::Changes::Geometry |
+        RequestedLayerState::Changes::Visibility | RequestedLayerState::Changes::Metadata |
+        RequestedLayerState::Changes::AffectsChildren | RequestedLayerState::Changes::Input |
+        RequestedLayerState::Changes::FrameRate | RequestedLayerState::Changes::GameMode;
+
 void clearChanges(LayerSnapshot& snapshot) {
     snapshot.changes.clear();
     snapshot.clientChanges = 0;
@@ -370,6 +377,7 @@ LayerSnapshotBuilder::LayerSnapshotBuilder() {}
 LayerSnapshotBuilder::LayerSnapshotBuilder(Args args) : LayerSnapshotBuilder() {
     args.forceUpdate = ForceUpdateFlags::ALL;
     updateSnapshots(args);
+    updateSnapshotTable();
 }
 
 bool LayerSnapshotBuilder::tryFastUpdate(const Args& args) {
@@ -433,9 +441,20 @@ void LayerSnapshotBuilder::updateSnapshots(const Args& args) {
         rootSnapshot.clientChanges |= layer_state_t::eReparent;
     }
 
-    for (auto& snapshot : mSnapshots) {
-        if (snapshot->reachablilty == LayerSnapshot::Reachablilty::Reachable) {
-            snapshot->reachablilty = LayerSnapshot::Reachablilty::Unreachable;
+    mIncrementalUpdate = args.incrementalUpdates && collectDirtyLayers(args);
+    // Unless layers were reparented or destroyed, the set of reachable snapshots does not change
+    // and the reachability of skipped subtrees can be left as is.
+    mResetReachability = !mIncrementalUpdate ||
+            args.layerLifecycleManager.getGlobalChanges().any(
+                    RequestedLayerState::Changes::Parent |
+                    RequestedLayerState::Changes::RelativeParent) ||
+            !args.layerLifecycleManager.getDestroyedLayers().empty() ||
+            !args.layerLifecycleManager.getLayersWithRemovedChildren().empty();
+    if (mResetReachability) {
+        for (auto& snapshot : mSnapshots) {
+            if (snapshot->reachablilty == LayerSnapshot::Reachablilty::Reachable) {
+                snapshot->reachablilty = LayerSnapshot::Reachablilty::Unreachable;
+            }
         }
     }
 
@@ -446,6 +465,8 @@ void LayerSnapshotBuilder::updateSnapshots(const Args& args) {
         LayerHierarchy::ScopedAddToTraversalPath addChildToPath(root, args.root.getLayer()->id,
                                                                 LayerHierarchy::Variant::Attached);
         updateSnapshotsInHierarchy(args, args.root, root, rootSnapshot, /*depth=*/0);
+    } else if (args.parallelSubtreeWorkers > 0 && args.root.mChildren.size() > 1) {
+        updateRootSubtreesInParallel(args, root, rootSnapshot);
     } else {
         for (auto& [childHierarchy, variant] : args.root.mChildren) {
             LayerHierarchy::ScopedAddToTraversalPath addChildToPath(root,
@@ -455,6 +476,9 @@ void LayerSnapshotBuilder::updateSnapshots(const Args& args) {
         }
     }
 
+    mIncrementalUpdate = false;
+    mDirtyLayerIds.clear();
+
     // Update touchable region crops outside the main update pass. This is because a layer could be
     // cropped by any other layer and it requires both snapshots to be updated.
     updateTouchableRegionCrop(args);
@@ -489,6 +513,9 @@ void LayerSnapshotBuilder::updateSnapshots(const Args& args) {
         }
 
         mPathToSnapshot.erase(traversalPath);
+        if (isClone) {
+            mNumCloneSnapshots--;
+        }
 
         auto range = mIdToSnapshots.equal_range(traversalPath.id);
         auto matchingSnapshot =
@@ -496,22 +523,181 @@ void LayerSnapshotBuilder::updateSnapshots(const Args& args) {
                     return snapshotWithId.second->path == traversalPath;
                 });
         mIdToSnapshots.erase(matchingSnapshot);
-        mNeedsTouchableRegionCrop.erase(traversalPath);
+        {
+            std::scoped_lock lock(mNeedsTouchableRegionCropMutex);
+            mNeedsTouchableRegionCrop.erase(traversalPath);
+        }
         mSnapshots.back()->globalZ = it->get()->globalZ;
         std::iter_swap(it, mSnapshots.end() - 1);
         mSnapshots.erase(mSnapshots.end() - 1);
     }
 }
 
+void LayerSnapshotBuilder::updateRootSubtreesInParallel(const Args& args,
+                                                        LayerHierarchy::TraversalPath& root,
+                                                        const LayerSnapshot& rootSnapshot) {
+    SFTRACE_CALL();
+    // Subtrees with relative or detached layers may update snapshots reached from other subtrees.
+    // Keep these on the main thread and update them in the original order after the independent
+    // subtrees have been updated.
+    std::vector<std::pair<LayerHierarchy*, LayerHierarchy::Variant>> serialSubtrees;
+    std::vector<std::function<void()>> tasks;
+    tasks.reserve(args.root.mChildren.size());
+
+    // New snapshots are created serially in traversal order so the containers are never modified
+    // by the workers and the initial z-order of the new snapshots is deterministic.
+    for (auto& [childHierarchy, variant] : args.root.mChildren) {
+        LayerHierarchy::ScopedAddToTraversalPath addChildToPath(root,
+                                                                childHierarchy->getLayer()->id,
+                                                                variant);
+        const bool isolated = variant != LayerHierarchy::Variant::Relative &&
+                variant != LayerHierarchy::Variant::Detached;
+        if (!createSnapshotsInHierarchy(args, *childHierarchy, root, rootSnapshot,
+                                        /*depth=*/0) ||
+            !isolated) {
+            serialSubtrees.emplace_back(childHierarchy, variant);
+            continue;
+        }
+        tasks.emplace_back([this, &args, &rootSnapshot, childPath = root,
+                            hierarchy = childHierarchy]() mutable {
+            updateSnapshotsInHierarchy(args, *hierarchy, childPath, rootSnapshot, /*depth=*/0);
+        });
+    }
+
+    if (tasks.size() > 1) {
+        if (!mWorkerPool || mWorkerPool->getNumWorkers() != args.parallelSubtreeWorkers) {
+            mWorkerPool = std::make_unique<WorkerPool>(args.parallelSubtreeWorkers);
+        }
+        mWorkerPool->run(tasks);
+    } else {
+        for (auto& task : tasks) {
+            task();
+        }
+    }
+
+    for (auto& [childHierarchy, variant] : serialSubtrees) {
+        LayerHierarchy::ScopedAddToTraversalPath addChildToPath(root,
+                                                                childHierarchy->getLayer()->id,
+                                                                variant);
+        updateSnapshotsInHierarchy(args, *childHierarchy, root, rootSnapshot, /*depth=*/0);
+    }
+}
+
+bool LayerSnapshotBuilder::createSnapshotsInHierarchy(
+        const Args& args, const LayerHierarchy& hierarchy,
+        LayerHierarchy::TraversalPath& traversalPath, const LayerSnapshot& parentSnapshot,
+        int depth) {
+    LLOG_ALWAYS_FATAL_WITH_TRACE_IF(depth > 50,
+                                    "Cycle detected in LayerSnapshotBuilder. See "
+                                    "builder_stack_overflow_transactions.winscope");
+    const RequestedLayerState* layer = hierarchy.getLayer();
+    LayerSnapshot* snapshot = getSnapshot(traversalPath);
+    if (!snapshot) {
+        snapshot = createSnapshot(traversalPath, *layer, parentSnapshot);
+        snapshot->merge(*layer, /*forceUpdate=*/true, /*displayChanges=*/true, args.forceFullDamage,
+                        getPrimaryDisplayRotationFlags(args.displays));
+        snapshot->changes |= RequestedLayerState::Changes::Created;
+    }
+
+    bool isolated = true;
+    for (auto& [childHierarchy, variant] : hierarchy.mChildren) {
+        if (variant == LayerHierarchy::Variant::Relative ||
+            variant == LayerHierarchy::Variant::Detached) {
+            isolated = false;
+        }
+        LayerHierarchy::ScopedAddToTraversalPath addChildToPath(traversalPath,
+                                                                childHierarchy->getLayer()->id,
+                                                                variant);
+        isolated &= createSnapshotsInHierarchy(args, *childHierarchy, traversalPath, *snapshot,
+                                               depth + 1);
+    }
+    return isolated;
+}
+
+bool LayerSnapshotBuilder::collectDirtyLayers(const Args& args) {
+    mDirtyLayerIds.clear();
+    if (args.forceUpdate != ForceUpdateFlags::NONE || args.displayChanges || args.parentCrop ||
+        args.root.getLayer() || !args.excludeLayerIds.empty() || mSnapshots.empty() ||
+        mNumCloneSnapshots > 0 ||
+        args.layerLifecycleManager.getGlobalChanges().test(RequestedLayerState::Changes::Mirror)) {
+        return false;
+    }
+
+    std::vector<uint32_t> pendingLayerIds =
+            args.layerLifecycleManager.getLayersWithRemovedChildren();
+    for (const RequestedLayerState* layer : args.layerLifecycleManager.getChangedLayers()) {
+        pendingLayerIds.emplace_back(layer->id);
+    }
+
+    // A change affects the layer's subtree and every node on the way to the layer, through both
+    // its parent and relative parent.
+    while (!pendingLayerIds.empty()) {
+        const uint32_t layerId = pendingLayerIds.back();
+        pendingLayerIds.pop_back();
+        if (layerId == UNASSIGNED_LAYER_ID || !mDirtyLayerIds.insert(layerId).second) {
+            continue;
+        }
+        const RequestedLayerState* layer = args.layerLifecycleManager.getLayerFromId(layerId);
+        if (!layer) {
+            continue;
+        }
+        pendingLayerIds.emplace_back(layer->parentId);
+        pendingLayerIds.emplace_back(layer->relativeParentId);
+    }
+    return true;
+}
+
+bool LayerSnapshotBuilder::canSkipSubtree(const LayerSnapshot& snapshot,
+                                          const LayerSnapshot& parentSnapshot) const {
+    return !parentSnapshot.changes.any(kChangesInheritedFromParent) &&
+            (parentSnapshot.clientChanges & layer_state_t::AFFECTS_CHILDREN) == 0 &&
+            mDirtyLayerIds.find(snapshot.path.id) == mDirtyLayerIds.end();
+}
+
+void LayerSnapshotBuilder::updateReachabilityInHierarchy(
+        const LayerHierarchy& hierarchy, LayerHierarchy::TraversalPath& traversalPath,
+        int depth) {
+    LLOG_ALWAYS_FATAL_WITH_TRACE_IF(depth > 50,
+                                    "Cycle detected in LayerSnapshotBuilder. See "
+                                    "builder_stack_overflow_transactions.winscope");
+    LayerSnapshot* snapshot = getSnapshot(traversalPath);
+    if (!snapshot) {
+        return;
+    }
+    if (!traversalPath.isRelative()) {
+        snapshot->reachablilty = LayerSnapshot::Reachablilty::Reachable;
+    } else if (snapshot->reachablilty == LayerSnapshot::Reachablilty::Unreachable) {
+        snapshot->reachablilty = LayerSnapshot::Reachablilty::ReachableByRelativeParent;
+    }
+    for (auto& [childHierarchy, variant] : hierarchy.mChildren) {
+        LayerHierarchy::ScopedAddToTraversalPath addChildToPath(traversalPath,
+                                                                childHierarchy->getLayer()->id,
+                                                                variant);
+        updateReachabilityInHierarchy(*childHierarchy, traversalPath, depth + 1);
+    }
+}
+
 void LayerSnapshotBuilder::update(const Args& args) {
     for (auto& snapshot : mSnapshots) {
         clearChanges(*snapshot);
     }
 
-    if (tryFastUpdate(args)) {
-        return;
+    const bool hasChanges = args.layerLifecycleManager.getGlobalChanges().get() != 0 ||
+            args.forceUpdate != ForceUpdateFlags::NONE || args.displayChanges;
+    if (!tryFastUpdate(args)) {
+        updateSnapshots(args);
+    }
+    if (hasChanges) {
+        updateSnapshotTable();
+    }
+}
+
+void LayerSnapshotBuilder::updateSnapshotTable() {
+    mSnapshotTable.clear();
+    mSnapshotTable.reserve(static_cast<size_t>(mNumInterestingSnapshots));
+    for (int i = 0; i < mNumInterestingSnapshots; i++) {
+        mSnapshotTable.append(*mSnapshots[(size_t)i]);
     }
-    updateSnapshots(args);
 }
 
 const LayerSnapshot& LayerSnapshotBuilder::updateSnapshotsInHierarchy(
@@ -531,8 +717,14 @@ const LayerSnapshot& LayerSnapshotBuilder::updateSnapshotsInHierarchy(
         snapshot->merge(*layer, /*forceUpdate=*/true, /*displayChanges=*/true, args.forceFullDamage,
                         primaryDisplayRotationFlags);
         snapshot->changes |= RequestedLayerState::Changes::Created;
+    } else if (mIncrementalUpdate && canSkipSubtree(*snapshot, parentSnapshot)) {
+        if (mResetReachability) {
+            updateReachabilityInHierarchy(hierarchy, traversalPath, depth);
+        }
+        return *snapshot;
     }
 
+    const scheduler::LayerInfo::FrameRate oldFrameRate = snapshot->frameRate;
     if (traversalPath.isRelative()) {
         bool parentIsRelative = traversalPath.variant == LayerHierarchy::Variant::Relative;
         updateRelativeState(*snapshot, parentSnapshot, parentIsRelative, args);
@@ -555,6 +747,11 @@ const LayerSnapshot& LayerSnapshotBuilder::updateSnapshotsInHierarchy(
                                          args, &childHasValidFrameRate);
     }
 
+    // Incremental updates only flag inherited frame rate changes before visiting the children so
+    // unchanged subtrees can be skipped. Flag the final frame rate here if it has changed.
+    if (mIncrementalUpdate && snapshot->frameRate != oldFrameRate) {
+        snapshot->changes |= RequestedLayerState::Changes::FrameRate;
+    }
     return *snapshot;
 }
 
@@ -583,6 +780,9 @@ LayerSnapshot* LayerSnapshotBuilder::createSnapshot(const LayerHierarchy::Traver
     snapshot->ignoreLocalTransform =
             path.isClone() && path.variant == LayerHierarchy::Variant::Detached_Mirror;
     mPathToSnapshot[path] = snapshot;
+    if (path.isClone()) {
+        mNumCloneSnapshots++;
+    }
 
     mIdToSnapshots.emplace(path.id, snapshot);
     return snapshot;
@@ -715,11 +915,8 @@ void LayerSnapshotBuilder::updateSnapshot(LayerSnapshot& snapshot, const Args& a
                                           const LayerSnapshot& parentSnapshot,
                                           const LayerHierarchy::TraversalPath& path) {
     // Always update flags and visibility
-    ftl::Flags<RequestedLayerState::Changes> parentChanges = parentSnapshot.changes &
-            (RequestedLayerState::Changes::Hierarchy | RequestedLayerState::Changes::Geometry |
-             RequestedLayerState::Changes::Visibility | RequestedLayerState::Changes::Metadata |
-             RequestedLayerState::Changes::AffectsChildren | RequestedLayerState::Changes::Input |
-             RequestedLayerState::Changes::FrameRate | RequestedLayerState::Changes::GameMode);
+    ftl::Flags<RequestedLayerState::Changes> parentChanges =
+            parentSnapshot.changes & kChangesInheritedFromParent;
     snapshot.changes |= parentChanges;
     if (args.displayChanges) snapshot.changes |= RequestedLayerState::Changes::Geometry;
     snapshot.reachablilty = LayerSnapshot::Reachablilty::Reachable;
@@ -867,6 +1064,7 @@ void LayerSnapshotBuilder::updateSnapshot(LayerSnapshot& snapshot, const Args& a
                 scheduler::LayerInfo::FrameRateSelectionStrategy::OverrideChildren;
         const bool propagationAllowed = parentSnapshot.frameRateSelectionStrategy !=
                 scheduler::LayerInfo::FrameRateSelectionStrategy::Self;
+        const scheduler::LayerInfo::FrameRate oldInheritedFrameRate = snapshot.inheritedFrameRate;
         if ((!requested.requestedFrameRate.isValid() && propagationAllowed) ||
             shouldOverrideChildren) {
             snapshot.inheritedFrameRate = parentSnapshot.inheritedFrameRate;
@@ -876,7 +1074,12 @@ void LayerSnapshotBuilder::updateSnapshot(LayerSnapshot& snapshot, const Args& a
         // Set the framerate as the inherited frame rate and allow children to override it if
         // needed.
         snapshot.frameRate = snapshot.inheritedFrameRate;
-        snapshot.changes |= RequestedLayerState::Changes::FrameRate;
+        // When updating incrementally, only propagate the change to the children if the inherited
+        // frame rate has changed so unaffected subtrees can be skipped.
+        if (!mIncrementalUpdate || forceUpdate ||
+            oldInheritedFrameRate != snapshot.inheritedFrameRate) {
+            snapshot.changes |= RequestedLayerState::Changes::FrameRate;
+        }
     }
 
     if (forceUpdate || snapshot.clientChanges & layer_state_t::eFrameRateSelectionStrategyChanged) {
@@ -1176,6 +1379,7 @@ void LayerSnapshotBuilder::updateInput(LayerSnapshot& snapshot,
     }
 
     if (requested.touchCropId != UNASSIGNED_LAYER_ID || path.isClone()) {
+        std::scoped_lock lock(mNeedsTouchableRegionCropMutex);
         mNeedsTouchableRegionCrop.insert(path);
     }
     auto cropLayerSnapshot = getSnapshot(requested.touchCropId);
@@ -1209,10 +1413,9 @@ std::vector<std::unique_ptr<LayerSnapshot>>& LayerSnapshotBuilder::getSnapshots(
 }
 
 void LayerSnapshotBuilder::forEachVisibleSnapshot(const ConstVisitor& visitor) const {
-    for (int i = 0; i < mNumInterestingSnapshots; i++) {
-        LayerSnapshot& snapshot = *mSnapshots[(size_t)i];
-        if (!snapshot.isVisible) continue;
-        visitor(snapshot);
+    for (size_t i = 0; i < mSnapshotTable.size(); i++) {
+        if (!mSnapshotTable.hasFlags(i, LayerSnapshotTable::kVisible)) continue;
+        visitor(mSnapshotTable.getSnapshot(i));
     }
 }
 
@@ -1231,10 +1434,9 @@ void LayerSnapshotBuilder::forEachVisibleSnapshot(const ConstVisitor& visitor,
 }
 
 void LayerSnapshotBuilder::forEachVisibleSnapshot(const Visitor& visitor) {
-    for (int i = 0; i < mNumInterestingSnapshots; i++) {
-        std::unique_ptr<LayerSnapshot>& snapshot = mSnapshots.at((size_t)i);
-        if (!snapshot->isVisible) continue;
-        visitor(snapshot);
+    for (size_t i = 0; i < mSnapshotTable.size(); i++) {
+        if (!mSnapshotTable.hasFlags(i, LayerSnapshotTable::kVisible)) continue;
+        visitor(mSnapshots.at(i));
     }
 }
 
@@ -1262,6 +1464,7 @@ void LayerSnapshotBuilder::forEachInputSnapshot(const ConstVisitor& visitor) con
 }
 
 void LayerSnapshotBuilder::updateTouchableRegionCrop(const Args& args) {
+    std::scoped_lock lock(mNeedsTouchableRegionCropMutex);
     if (mNeedsTouchableRegionCrop.empty()) {
         return;
     }
@@ -16,10 +16,17 @@
 
 #pragma once
 
+#include <atomic>
+#include <mutex>
+
+#include <android-base/thread_annotations.h>
+
 #include "FrontEnd/DisplayInfo.h"
 #include "FrontEnd/LayerLifecycleManager.h"
+#include "FrontEnd/WorkerPool.h"
 #include "LayerHierarchy.h"
 #include "LayerSnapshot.h"
+#include "LayerSnapshotTable.h"
 #include "RequestedLayerState.h"
 
 namespace android::surfaceflinger::frontend {
@@ -59,6 +66,11 @@ public:
         const std::unordered_map<std::string, uint32_t>& genericLayerMetadataKeyMap;
         bool skipRoundCornersWhenProtected = false;
         LayerSnapshot rootSnapshot = getRootSnapshot();
+        // Number of worker threads used to update independent root subtrees of the hierarchy in
+        // parallel. Zero disables parallel updates.
+        size_t parallelSubtreeWorkers = 0;
+        // If set, hierarchy walks skip subtrees that are not affected by any layer changes.
+        bool incrementalUpdates = false;
     };
     LayerSnapshotBuilder();
 
@@ -73,6 +85,9 @@ public:
     std::vector<std::unique_ptr<LayerSnapshot>>& getSnapshots();
     LayerSnapshot* getSnapshot(uint32_t layerId) const;
     LayerSnapshot* getSnapshot(const LayerHierarchy::TraversalPath& id) const;
+    // Returns the hot fields of the visible and input snapshots in z-order. The table is valid
+    // until the next update.
+    const LayerSnapshotTable& getSnapshotTable() const { return mSnapshotTable; }
 
     typedef std::function<void(const LayerSnapshot& snapshot)> ConstVisitor;
 
@@ -106,6 +121,28 @@ private:
 
     void updateSnapshots(const Args& args);
 
+    // Collects the layers whose snapshots, or the snapshots of their descendants, need to be
+    // updated. Returns false if the changes cannot be tracked and the full hierarchy must be
+    // walked.
+    bool collectDirtyLayers(const Args& args);
+    // Returns true if the snapshot and its subtree are not affected by any changes and do not
+    // need to be updated.
+    bool canSkipSubtree(const LayerSnapshot& snapshot, const LayerSnapshot& parentSnapshot) const;
+    // Marks all the snapshots in an unchanged subtree as reachable without updating them.
+    void updateReachabilityInHierarchy(const LayerHierarchy& hierarchy,
+                                       LayerHierarchy::TraversalPath& traversalPath, int depth);
+
+    // Updates the children of the root hierarchy, spreading subtrees that do not share any
+    // snapshots with other subtrees across the worker pool.
+    void updateRootSubtreesInParallel(const Args& args, LayerHierarchy::TraversalPath& root,
+                                      const LayerSnapshot& rootSnapshot);
+    // Creates any missing snapshots in the subtree so that the update pass does not need to
+    // modify the snapshot containers. Returns false if the subtree has relative or detached
+    // children, which means its snapshots can be modified while updating other subtrees.
+    bool createSnapshotsInHierarchy(const Args&, const LayerHierarchy& hierarchy,
+                                    LayerHierarchy::TraversalPath& traversalPath,
+                                    const LayerSnapshot& parentSnapshot, int depth);
+
     const LayerSnapshot& updateSnapshotsInHierarchy(const Args&, const LayerHierarchy& hierarchy,
                                                     LayerHierarchy::TraversalPath& traversalPath,
                                                     const LayerSnapshot& parentSnapshot, int depth);
@@ -137,6 +174,7 @@ private:
                                           const RequestedLayerState& requestedCHildState,
                                           const Args& args, bool* outChildHasValidFrameRate);
     void updateTouchableRegionCrop(const Args& args);
+    void updateSnapshotTable();
 
     std::unordered_map<LayerHierarchy::TraversalPath, LayerSnapshot*,
                        LayerHierarchy::TraversalPathHash>
@@ -144,11 +182,25 @@ private:
     std::multimap<uint32_t, LayerSnapshot*> mIdToSnapshots;
 
     // Track snapshots that needs touchable region crop from other snapshots
+    std::mutex mNeedsTouchableRegionCropMutex;
     std::unordered_set<LayerHierarchy::TraversalPath, LayerHierarchy::TraversalPathHash>
-            mNeedsTouchableRegionCrop;
+            mNeedsTouchableRegionCrop GUARDED_BY(mNeedsTouchableRegionCropMutex);
     std::vector<std::unique_ptr<LayerSnapshot>> mSnapshots;
-    bool mResortSnapshots = false;
+    std::atomic_bool mResortSnapshots = false;
     int mNumInterestingSnapshots = 0;
+    LayerSnapshotTable mSnapshotTable;
+    std::unique_ptr<WorkerPool> mWorkerPool;
+
+    // Number of snapshots with a cloned traversal path. Incremental updates are disabled while
+    // clones exist since a change can affect snapshots outside of the layer's ancestors.
+    size_t mNumCloneSnapshots = 0;
+    // Layers that have changed or have changed descendants. Only valid while
+    // mIncrementalUpdate is set.
+    std::unordered_set<uint32_t> mDirtyLayerIds;
+    bool mIncrementalUpdate = false;
+    // Set if reachability of all snapshots has been reset and needs to be recomputed, including
+    // the snapshots of skipped subtrees.
+    bool mResetReachability = false;
 };
 
 } // namespace android::surfaceflinger::frontend
@@ -0,0 +1,100 @@
+/*
+ * Copyright 2024 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include <vector>
+
+#include <ui/FloatRect.h>
+#include <ui/LayerStack.h>
+#include <ui/Transform.h>
+
+#include "LayerSnapshot.h"
+
+namespace android::surfaceflinger::frontend {
+
+// Structure of arrays copy of the snapshot fields that are read every frame when iterating
+// through the visible snapshots. LayerSnapshot interleaves these fields with strings, buffers
+// and other rarely read state, so walking the snapshots touches many cache lines per layer.
+// The table is rebuilt by LayerSnapshotBuilder after each update and contains the
+// snapshots that are visible or have input info, indexed by their global z-order.
+class LayerSnapshotTable {
+public:
+    enum Flags : uint8_t {
+        kVisible = 1 << 0,
+        kHasInputInfo = 1 << 1,
+        kHasSomethingToDraw = 1 << 2,
+        kContentOpaque = 1 << 3,
+        kSecure = 1 << 4,
+    };
+
+    size_t size() const { return mSnapshots.size(); }
+    bool empty() const { return mSnapshots.empty(); }
+
+    void clear() {
+        mSnapshots.clear();
+        mLayerStacks.clear();
+        mTransforms.clear();
+        mTransformedBounds.clear();
+        mAlphas.clear();
+        mFlags.clear();
+    }
+
+    void reserve(size_t size) {
+        mSnapshots.reserve(size);
+        mLayerStacks.reserve(size);
+        mTransforms.reserve(size);
+        mTransformedBounds.reserve(size);
+        mAlphas.reserve(size);
+        mFlags.reserve(size);
+    }
+
+    void append(LayerSnapshot& snapshot) {
+        uint8_t flags = 0;
+        if (snapshot.isVisible) flags |= kVisible;
+        if (snapshot.hasInputInfo()) flags |= kHasInputInfo;
+        if (snapshot.hasSomethingToDraw()) flags |= kHasSomethingToDraw;
+        if (snapshot.contentOpaque) flags |= kContentOpaque;
+        if (snapshot.isSecure) flags |= kSecure;
+
+        mSnapshots.push_back(&snapshot);
+        mLayerStacks.push_back(snapshot.outputFilter.layerStack);
+        mTransforms.push_back(snapshot.geomLayerTransform);
+        mTransformedBounds.push_back(snapshot.transformedBounds);
+        mAlphas.push_back(snapshot.alpha);
+        mFlags.push_back(flags);
+    }
+
+    // Snapshot in global z-order position i.
+    LayerSnapshot& getSnapshot(size_t i) const { return *mSnapshots[i]; }
+    bool hasFlags(size_t i, uint8_t flags) const { return (mFlags[i] & flags) == flags; }
+
+    const std::vector<ui::LayerStack>& getLayerStacks() const { return mLayerStacks; }
+    const std::vector<ui::Transform>& getTransforms() const { return mTransforms; }
+    const std::vector<FloatRect>& getTransformedBounds() const { return mTransformedBounds; }
+    const std::vector<float>& getAlphas() const { return mAlphas; }
+    const std::vector<uint8_t>& getFlags() const { return mFlags; }
+
+private:
+    std::vector<LayerSnapshot*> mSnapshots;
+    std::vector<ui::LayerStack> mLayerStacks;
+    std::vector<ui::Transform> mTransforms;
+    std::vector<FloatRect> mTransformedBounds;
+    std::vector<float> mAlphas;
+    std::vector<uint8_t> mFlags;
+};
+
+} // namespace android::surfaceflinger::frontend
@@ -19,6 +19,12 @@
 #define LOG_TAG "SurfaceFlinger"
 #define ATRACE_TAG ATRACE_TAG_GRAPHICS
 
+#include <algorithm>
+#include <cerrno>
+#include <cinttypes>
+#include <cstring>
+
+#include <android-base/stringprintf.h>
 #include <common/trace.h>
 #include <cutils/trace.h>
 #include <utils/Log.h>
@@ -35,21 +41,22 @@ void TransactionHandler::queueTransaction(TransactionState&& state) {
 }
 
 void TransactionHandler::collectTransactions() {
-    while (!mLocklessTransactionQueue.isEmpty()) {
-        auto maybeTransaction = mLocklessTransactionQueue.pop();
-        if (!maybeTransaction.has_value()) {
-            break;
-        }
-        auto transaction = maybeTransaction.value();
+    mLocklessTransactionQueue.popAll(mCollectedTransactions);
+    for (auto& transaction : mCollectedTransactions) {
         mPendingTransactionQueues[transaction.applyToken].emplace(std::move(transaction));
     }
+    // Keeps the capacity around for the next frame.
+    mCollectedTransactions.clear();
 }
 
 std::vector<TransactionState> TransactionHandler::flushTransactions() {
     // Collect transaction that are ready to be applied.
-    std::vector<TransactionState> transactions;
+    std::vector<TransactionState> transactions = std::move(mRecycledTransactions);
+    mRecycledTransactions.clear();
+    transactions.clear();
     TransactionFlushState flushState;
     flushState.queueProcessTime = systemTime();
+    sampleAcquireFences(flushState);
     // Transactions with a buffer pending on a barrier may be on a different applyToken
     // than the transaction which satisfies our barrier. In fact this is the exact use case
     // that the primitive is designed for. This means we may first process
@@ -75,6 +82,122 @@ std::vector<TransactionState> TransactionHandler::flushTransactions() {
     return transactions;
 }
 
+void TransactionHandler::sampleAcquireFences(TransactionFlushState& flushState) {
+    mFencePollFds.clear();
+    mPolledFences.clear();
+    for (auto& [_, queue] : mPendingTransactionQueues) {
+        if (queue.empty()) continue;
+        queue.front().traverseStatesWithBuffers([&](const layer_state_t& state) {
+            if (!state.bufferData ||
+                !state.bufferData->flags.test(BufferData::BufferDataChange::fenceChanged)) {
+                return;
+            }
+            const sp<Fence>& fence = state.bufferData->acquireFence;
+            // Fences without a file descriptor are left to Fence::getStatus.
+            if (!fence || fence->get() < 0) return;
+            mFencePollFds.push_back({.fd = fence->get(), .events = POLLIN, .revents = 0});
+            mPolledFences.push_back(fence.get());
+        });
+    }
+    if (mFencePollFds.size() < 2) {
+        // Polling a single fence is no cheaper than letting the filter query it.
+        return;
+    }
+
+    SFTRACE_FORMAT("sampleAcquireFences %zu", mFencePollFds.size());
+    int result;
+    do {
+        result = poll(mFencePollFds.data(), mFencePollFds.size(), 0);
+    } while (result < 0 && errno == EINTR);
+    if (result < 0) {
+        ALOGW("Failed to poll %zu acquire fences: %s", mFencePollFds.size(), strerror(errno));
+        return;
+    }
+
+    for (size_t i = 0; i < mFencePollFds.size(); i++) {
+        const short revents = mFencePollFds[i].revents;
+        Fence::Status status = Fence::Status::Unsignaled;
+        if (revents & (POLLERR | POLLNVAL)) {
+            status = Fence::Status::Invalid;
+        } else if (revents & POLLIN) {
+            status = Fence::Status::Signaled;
+        }
+        flushState.acquireFenceStatuses.emplace_or_replace(mPolledFences[i], status);
+    }
+}
+
+Fence::Status TransactionHandler::TransactionFlushState::getAcquireFenceStatus(
+        const sp<Fence>& fence) const {
+    if (const auto status = acquireFenceStatuses.get(fence.get())) {
+        return status->get();
+    }
+    return fence->getStatus();
+}
+
+std::vector<ResolvedComposerState> TransactionHandler::acquireComposerStates(size_t count) {
+    std::vector<ResolvedComposerState> states;
+    {
+        std::scoped_lock lock(mRecycledStatesMutex);
+        if (!mRecycledStates.empty()) {
+            states = std::move(mRecycledStates.back());
+            mRecycledStates.pop_back();
+        }
+    }
+
+    if (states.capacity() >= count) {
+        mFrameReuses.fetch_add(1);
+    } else {
+        mFrameAllocations.fetch_add(1);
+        states.reserve(count);
+    }
+    return states;
+}
+
+void TransactionHandler::recycleTransactions(std::vector<TransactionState>&& transactions) {
+    SFTRACE_CALL();
+    {
+        std::scoped_lock lock(mRecycledStatesMutex);
+        for (auto& transaction : transactions) {
+            if (mRecycledStates.size() >= kMaxRecycledComposerStates) break;
+            if (transaction.states.capacity() == 0) continue;
+            transaction.states.clear();
+            mRecycledStates.emplace_back(std::move(transaction.states));
+        }
+    }
+    transactions.clear();
+    mRecycledTransactions = std::move(transactions);
+
+    const uint64_t allocations = mFrameAllocations.exchange(0);
+    const uint64_t reuses = mFrameReuses.exchange(0);
+    std::scoped_lock lock(mAllocationStatsMutex);
+    mAllocationStats.lastFrameAllocations = allocations;
+    mAllocationStats.lastFrameReuses = reuses;
+    mAllocationStats.maxFrameAllocations =
+            std::max(mAllocationStats.maxFrameAllocations, allocations);
+    mAllocationStats.totalAllocations += allocations;
+    mAllocationStats.totalReuses += reuses;
+    mAllocationStats.frames++;
+}
+
+TransactionHandler::AllocationStats TransactionHandler::getAllocationStats() const {
+    std::scoped_lock lock(mAllocationStatsMutex);
+    return mAllocationStats;
+}
+
+void TransactionHandler::dumpAllocationStats(std::string& result) const {
+    const AllocationStats stats = getAllocationStats();
+    base::StringAppendF(&result,
+                        "Transaction state allocations: last frame %" PRIu64 " (reused %" PRIu64
+                        "), max per frame %" PRIu64 ", total %" PRIu64 " (reused %" PRIu64
+                        ") over %" PRIu64 " frames\n",
+                        stats.lastFrameAllocations, stats.lastFrameReuses,
+                        stats.maxFrameAllocations, stats.totalAllocations, stats.totalReuses,
+                        stats.frames);
+    base::StringAppendF(&result, "Transaction queue: capacity %zu, max overflow %zu\n",
+                        mLocklessTransactionQueue.capacity(),
+                        mLocklessTransactionQueue.getOverflowPeak());
+}
+
 void TransactionHandler::applyUnsignaledBufferTransaction(
         std::vector<TransactionState>& transactions, TransactionFlushState& flushState) {
     if (!flushState.queueWithUnsignaledBuffer) {
@@ -16,9 +16,13 @@
 
 #pragma once
 
+#include <poll.h>
 #include <semaphore.h>
+#include <atomic>
 #include <cstdint>
+#include <mutex>
 #include <optional>
+#include <string>
 #include <vector>
 
 #include <LocklessQueue.h>
@@ -45,6 +49,12 @@ public:
         // LatchUnsignaledConfig::AutoSingleLayer to ensure we only apply an unsignaled buffer
         // if it's the only transaction that is ready to be applied.
         sp<IBinder> queueWithUnsignaledBuffer = nullptr;
+        // Status of the acquire fences at the front of each pending queue, sampled with a single
+        // poll at the start of the flush.
+        ftl::SmallMap<const Fence*, Fence::Status, 15> acquireFenceStatuses = {};
+
+        // Returns the sampled status of the fence, or queries it if it was not sampled.
+        Fence::Status getAcquireFenceStatus(const sp<Fence>& fence) const;
     };
     enum class TransactionReadiness {
         // Transaction is ready to be applied
@@ -65,6 +75,28 @@ public:
     void addTransactionReadyFilter(TransactionFilter&&);
     void queueTransaction(TransactionState&&);
 
+    // Returns an empty vector with room for at least `count` composer states. The storage is
+    // recycled from previously applied transactions when possible so that building a transaction
+    // does not allocate on every frame. Safe to call from any thread.
+    std::vector<ResolvedComposerState> acquireComposerStates(size_t count);
+    // Hands the storage of applied transactions back to the handler so it can be reused by later
+    // frames. This destroys the composer states, which may release the last reference to a layer
+    // handle, so it must not be called with the state lock held.
+    void recycleTransactions(std::vector<TransactionState>&&);
+
+    struct AllocationStats {
+        // Composer state vectors that had to be allocated or grown in the last frame.
+        uint64_t lastFrameAllocations = 0;
+        // Composer state vectors that were served from recycled storage in the last frame.
+        uint64_t lastFrameReuses = 0;
+        uint64_t maxFrameAllocations = 0;
+        uint64_t totalAllocations = 0;
+        uint64_t totalReuses = 0;
+        uint64_t frames = 0;
+    };
+    AllocationStats getAllocationStats() const;
+    void dumpAllocationStats(std::string& result) const;
+
     struct StalledTransactionInfo {
         pid_t pid;
         uint32_t layerId;
@@ -86,12 +118,34 @@ private:
     void popTransactionFromPending(std::vector<TransactionState>&, TransactionFlushState&,
                                    std::queue<TransactionState>&);
     TransactionReadiness applyFilters(TransactionFlushState&);
+    void sampleAcquireFences(TransactionFlushState&);
     std::unordered_map<sp<IBinder>, std::queue<TransactionState>, IListenerHash>
             mPendingTransactionQueues;
-    LocklessQueue<TransactionState> mLocklessTransactionQueue;
+    // Transactions queued by binder threads. The ring covers the bursts seen in practice and
+    // anything beyond spills over into heap allocated entries.
+    static constexpr size_t kTransactionQueueCapacity = 128;
+    BoundedLocklessQueue<TransactionState> mLocklessTransactionQueue{kTransactionQueueCapacity};
+    // Scratch storage for collectTransactions, only accessed from the main thread.
+    std::vector<TransactionState> mCollectedTransactions;
+    // Scratch storage for sampleAcquireFences, only accessed from the main thread.
+    std::vector<pollfd> mFencePollFds;
+    std::vector<const Fence*> mPolledFences;
     std::atomic<size_t> mPendingTransactionCount = 0;
     ftl::SmallVector<TransactionFilter, 2> mTransactionReadyFilters;
 
+    // Recycled composer state storage is bounded so a single burst of transactions does not keep
+    // memory alive forever.
+    static constexpr size_t kMaxRecycledComposerStates = 64;
+    std::mutex mRecycledStatesMutex;
+    std::vector<std::vector<ResolvedComposerState>> mRecycledStates
+            GUARDED_BY(mRecycledStatesMutex);
+    // Storage of the last flushed transaction list, only accessed from the main thread.
+    std::vector<TransactionState> mRecycledTransactions;
+    std::atomic<uint64_t> mFrameAllocations = 0;
+    std::atomic<uint64_t> mFrameReuses = 0;
+    mutable std::mutex mAllocationStatsMutex;
+    AllocationStats mAllocationStats GUARDED_BY(mAllocationStatsMutex);
+
     std::mutex mStalledMutex;
     std::unordered_map<uint64_t /* transactionId */, StalledTransactionInfo> mStalledTransactions
             GUARDED_BY(mStalledMutex);
@@ -0,0 +1,89 @@
+/*
+ * Copyright 2024 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#define ATRACE_TAG ATRACE_TAG_GRAPHICS
+#undef LOG_TAG
+#define LOG_TAG "SurfaceFlinger"
+
+#include <pthread.h>
+
+#include <common/trace.h>
+
+#include "WorkerPool.h"
+
+namespace android::surfaceflinger::frontend {
+
+WorkerPool::WorkerPool(size_t numWorkers) {
+    mThreads.reserve(numWorkers);
+    for (size_t i = 0; i < numWorkers; i++) {
+        mThreads.emplace_back([this, i]() {
+            const std::string name = "SfFrontEnd" + std::to_string(i);
+            pthread_setname_np(pthread_self(), name.c_str());
+            threadMain();
+        });
+    }
+}
+
+WorkerPool::~WorkerPool() {
+    {
+        std::scoped_lock lock(mMutex);
+        mDone = true;
+    }
+    mWorkAvailable.notify_all();
+    for (auto& thread : mThreads) {
+        thread.join();
+    }
+}
+
+void WorkerPool::run(std::vector<std::function<void()>>& tasks) {
+    if (tasks.empty()) return;
+    SFTRACE_CALL();
+
+    std::unique_lock lock(mMutex);
+    mTasks = &tasks;
+    mNextTask = 0;
+    mPendingTasks = tasks.size();
+    mWorkAvailable.notify_all();
+
+    drainLocked(lock);
+    mWorkDone.wait(lock, [this]() REQUIRES(mMutex) { return mPendingTasks == 0; });
+    mTasks = nullptr;
+}
+
+void WorkerPool::drainLocked(std::unique_lock<std::mutex>& lock) {
+    while (mTasks && mNextTask < mTasks->size()) {
+        std::function<void()>& task = (*mTasks)[mNextTask++];
+        lock.unlock();
+        task();
+        lock.lock();
+        if (--mPendingTasks == 0) {
+            mWorkDone.notify_all();
+        }
+    }
+}
+
+void WorkerPool::threadMain() {
+    std::unique_lock lock(mMutex);
+    while (true) {
+        mWorkAvailable.wait(lock, [this]() REQUIRES(mMutex) {
+            return mDone || (mTasks && mNextTask < mTasks->size());
+        });
+        if (mDone) return;
+        drainLocked(lock);
+    }
+}
+
+} // namespace android::surfaceflinger::frontend
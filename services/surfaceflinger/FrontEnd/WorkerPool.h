@@ -0,0 +1,59 @@
+/*
+ * Copyright 2024 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include <android-base/thread_annotations.h>
+#include <condition_variable>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace android::surfaceflinger::frontend {
+
+// A small fixed-size pool of threads used to run independent pieces of front end work, such as
+// updating snapshots for disjoint subtrees of the layer hierarchy, in parallel.
+//
+// The calling thread participates in running the tasks and run() only returns once every task
+// passed to it has completed, so callers can safely pass tasks that reference stack state.
+class WorkerPool {
+public:
+    explicit WorkerPool(size_t numWorkers);
+    ~WorkerPool();
+
+    // Runs all the tasks and blocks until they have completed. Tasks may run in any order and on
+    // any thread including the calling thread. This must not be called concurrently.
+    void run(std::vector<std::function<void()>>& tasks);
+
+    size_t getNumWorkers() const { return mThreads.size(); }
+
+private:
+    void threadMain();
+    // Runs tasks from the current batch until none are left. Returns with the lock held.
+    void drainLocked(std::unique_lock<std::mutex>& lock) REQUIRES(mMutex);
+
+    std::mutex mMutex;
+    std::condition_variable mWorkAvailable;
+    std::condition_variable mWorkDone;
+    std::vector<std::function<void()>>* mTasks GUARDED_BY(mMutex) = nullptr;
+    size_t mNextTask GUARDED_BY(mMutex) = 0;
+    size_t mPendingTasks GUARDED_BY(mMutex) = 0;
+    bool mDone GUARDED_BY(mMutex) = false;
+    std::vector<std::thread> mThreads;
+};
+
+} // namespace android::surfaceflinger::frontend
@@ -16,6 +16,11 @@
 
 #include "JankTracker.h"
 
+#include <fcntl.h>
+
+#include <algorithm>
+#include <string>
+
 #include <android/gui/IJankListener.h>
 #include "BackgroundExecutor.h"
 
@@ -25,23 +30,62 @@ namespace {
 
 constexpr size_t kJankDataBatchSize = 50;
 
+// Leaves room for several batches, in case the process is slow to read them.
+constexpr size_t kJankDataChannelCapacity = 512;
+
 } // anonymous namespace
 
+// Drops the jank data channel and the listeners of a process once it dies.
+class JankTracker::ChannelDeathRecipient : public IBinder::DeathRecipient {
+public:
+    explicit ChannelDeathRecipient(pid_t pid) : mPid(pid) {}
+
+    void binderDied(const wp<IBinder>& who) override {
+        getInstance().dropJankDataChannel(mPid, who.unsafe_get());
+    }
+
+private:
+    const pid_t mPid;
+};
+
 std::atomic<size_t> JankTracker::sListenerCount(0);
 std::atomic<bool> JankTracker::sCollectAllJankDataForTesting(false);
 
 JankTracker::~JankTracker() {}
 
-void JankTracker::addJankListener(int32_t layerId, sp<IBinder> listener) {
+base::unique_fd JankTracker::openJankDataChannel(pid_t pid, sp<IBinder> listener) {
+    std::unique_ptr<gui::JankDataChannel::Producer> producer;
+    if (gui::JankDataChannel::createProducer("JankDataChannel " + std::to_string(pid),
+                                             kJankDataChannelCapacity, producer) != OK) {
+        return {};
+    }
+    base::unique_fd fd(fcntl(producer->getFd().get(), F_DUPFD_CLOEXEC, 0));
+    if (!fd.ok()) {
+        return {};
+    }
+
+    // Linking fails for local listeners, which never die before SurfaceFlinger.
+    auto deathRecipient = sp<ChannelDeathRecipient>::make(pid);
+    listener->linkToDeath(deathRecipient);
+
+    JankTracker& tracker = getInstance();
+    const std::lock_guard<std::mutex> _l(tracker.mLock);
+    tracker.mChannels.insert_or_assign(pid,
+                                       Channel{std::move(producer), std::move(listener),
+                                               std::move(deathRecipient)});
+    return fd;
+}
+
+void JankTracker::addJankListener(int32_t layerId, sp<IBinder> listener, pid_t pid) {
     // Increment right away, so that if an onJankData call comes in before the background thread has
     // added this listener, it will not drop the data.
     sListenerCount++;
 
     BackgroundExecutor::getLowPriorityInstance().sendCallbacks(
-            {[layerId, listener = std::move(listener)]() {
+            {[layerId, listener = std::move(listener), pid]() {
                 JankTracker& tracker = getInstance();
                 const std::lock_guard<std::mutex> _l(tracker.mLock);
-                tracker.addJankListenerLocked(layerId, listener);
+                tracker.addJankListenerLocked(layerId, listener, pid);
             }});
 }
 
@@ -65,29 +109,10 @@ void JankTracker::onJankData(int32_t layerId, gui::JankData data) {
     }
 
     BackgroundExecutor::getLowPriorityInstance().sendCallbacks(
-            {[layerId, data = std::move(data)]() {
-                JankTracker& tracker = getInstance();
-
-                tracker.mLock.lock();
-                bool hasListeners = tracker.mJankListeners.count(layerId) > 0;
-                tracker.mLock.unlock();
-
-                if (!hasListeners && !sCollectAllJankDataForTesting) {
-                    return;
-                }
-
-                tracker.mJankDataLock.lock();
-                tracker.mJankData.emplace(layerId, data);
-                size_t count = tracker.mJankData.count(layerId);
-                tracker.mJankDataLock.unlock();
-
-                if (count >= kJankDataBatchSize && !sCollectAllJankDataForTesting) {
-                    tracker.doFlushJankData(layerId);
-                }
-            }});
+            {[layerId, data = std::move(data)]() { getInstance().doOnJankData(layerId, data); }});
 }
 
-void JankTracker::addJankListenerLocked(int32_t layerId, sp<IBinder> listener) {
+void JankTracker::addJankListenerLocked(int32_t layerId, sp<IBinder> listener, pid_t pid) {
     for (auto it = mJankListeners.find(layerId); it != mJankListeners.end(); it++) {
         if (it->second.mListener == listener) {
             // Undo the duplicate increment in addJankListener.
@@ -96,7 +121,74 @@ void JankTracker::addJankListenerLocked(int32_t layerId, sp<IBinder> listener) {
         }
     }
 
-    mJankListeners.emplace(layerId, std::move(listener));
+    mJankListeners.emplace(layerId, Listener(std::move(listener), pid));
+}
+
+void JankTracker::doOnJankData(int32_t layerId, const gui::JankData& data) {
+    std::vector<sp<IBinder>> toPublish;
+
+    mLock.lock();
+    bool hasListeners = writeToChannelsLocked(layerId, data, toPublish);
+    mLock.unlock();
+
+    publishToChannels(toPublish);
+
+    if (!hasListeners && !sCollectAllJankDataForTesting) {
+        return;
+    }
+
+    mJankDataLock.lock();
+    mJankData.emplace(layerId, data);
+    size_t count = mJankData.count(layerId);
+    mJankDataLock.unlock();
+
+    if (count >= kJankDataBatchSize && !sCollectAllJankDataForTesting) {
+        doFlushJankData(layerId);
+    }
+}
+
+bool JankTracker::writeToChannelsLocked(int32_t layerId, const gui::JankData& data,
+                                        std::vector<sp<IBinder>>& outToPublish) {
+    bool hasListenersWithoutChannel = false;
+    // A process has a single channel for all its listeners.
+    std::vector<pid_t> written;
+
+    auto range = mJankListeners.equal_range(layerId);
+    for (auto it = range.first; it != range.second;) {
+        Listener& listener = it->second;
+        const auto channelIt = mChannels.find(listener.mPid);
+        if (channelIt == mChannels.end()) {
+            hasListenersWithoutChannel = true;
+            it++;
+            continue;
+        }
+
+        if (std::find(written.begin(), written.end(), listener.mPid) == written.end()) {
+            written.push_back(listener.mPid);
+            Channel& channel = channelIt->second;
+            channel.mProducer->write(layerId, data);
+            if (++channel.mUnpublished >= kJankDataBatchSize) {
+                channel.mUnpublished = 0;
+                outToPublish.push_back(channel.mListener);
+            }
+        }
+
+        listener.mLastVsync = std::max(listener.mLastVsync, data.frameVsyncId);
+        if (listener.mRemoveAfter != -1 && listener.mRemoveAfter <= listener.mLastVsync) {
+            it = mJankListeners.erase(it);
+            sListenerCount--;
+        } else {
+            it++;
+        }
+    }
+    return hasListenersWithoutChannel;
+}
+
+void JankTracker::publishToChannels(const std::vector<sp<IBinder>>& toPublish) {
+    for (const auto& listener : toPublish) {
+        // Listeners that went away are dropped by ChannelDeathRecipient.
+        interface_cast<gui::IJankListener>(listener)->onJankDataPublished();
+    }
 }
 
 void JankTracker::doFlushJankData(int32_t layerId) {
@@ -104,15 +196,26 @@ void JankTracker::doFlushJankData(int32_t layerId) {
     int64_t maxVsync = transferAvailableJankData(layerId, jankData);
 
     std::vector<sp<IBinder>> toSend;
+    std::vector<sp<IBinder>> toPublish;
 
     mLock.lock();
-    for (auto it = mJankListeners.find(layerId); it != mJankListeners.end();) {
-        if (!jankData.empty()) {
+    auto range = mJankListeners.equal_range(layerId);
+    for (auto it = range.first; it != range.second;) {
+        int64_t lastVsync = maxVsync;
+        if (const auto channelIt = mChannels.find(it->second.mPid);
+            channelIt != mChannels.end()) {
+            Channel& channel = channelIt->second;
+            if (channel.mUnpublished > 0) {
+                channel.mUnpublished = 0;
+                toPublish.push_back(channel.mListener);
+            }
+            lastVsync = it->second.mLastVsync;
+        } else if (!jankData.empty()) {
             toSend.emplace_back(it->second.mListener);
         }
 
         int64_t removeAfter = it->second.mRemoveAfter;
-        if (removeAfter != -1 && removeAfter <= maxVsync) {
+        if (removeAfter != -1 && removeAfter <= lastVsync) {
             it = mJankListeners.erase(it);
             sListenerCount--;
         } else {
@@ -121,6 +224,8 @@ void JankTracker::doFlushJankData(int32_t layerId) {
     }
     mLock.unlock();
 
+    publishToChannels(toPublish);
+
     for (const auto& listener : toSend) {
         binder::Status status = interface_cast<gui::IJankListener>(listener)->onJankData(jankData);
         if (status.exceptionCode() == binder::Status::EX_NULL_POINTER) {
@@ -165,6 +270,25 @@ void JankTracker::dropJankListener(int32_t layerId, sp<IBinder> listener) {
     }
 }
 
+void JankTracker::dropJankDataChannel(pid_t pid, const IBinder* listener) {
+    const std::lock_guard<std::mutex> _l(mLock);
+    const auto channelIt = mChannels.find(pid);
+    if (channelIt == mChannels.end() || channelIt->second.mListener.get() != listener) {
+        // The process opened another channel since.
+        return;
+    }
+    mChannels.erase(channelIt);
+
+    for (auto it = mJankListeners.begin(); it != mJankListeners.end();) {
+        if (it->second.mPid == pid) {
+            it = mJankListeners.erase(it);
+            sListenerCount--;
+        } else {
+            it++;
+        }
+    }
+}
+
 void JankTracker::clearAndStartCollectingAllJankDataForTesting() {
     BackgroundExecutor::getLowPriorityInstance().flushQueue();
 
@@ -16,12 +16,17 @@
 
 #pragma once
 
+#include <sys/types.h>
+
 #include <cstdint>
+#include <memory>
 #include <mutex>
 #include <unordered_map>
 
+#include <android-base/unique_fd.h>
 #include <android/gui/JankData.h>
 #include <binder/IBinder.h>
+#include <gui/JankDataChannel.h>
 #include <utils/Mutex.h>
 
 namespace android {
@@ -32,12 +37,21 @@ class FrameTimelineTest;
 /**
  * JankTracker maintains a backlog of frame jank classification and manages and notififies any
  * registered jank data listeners.
+ *
+ * The jank data of listeners registered by a process that opened a jank data channel is written to
+ * the shared memory ring of that channel instead, and the process is only notified once per batch.
  */
 class JankTracker {
 public:
     ~JankTracker();
 
-    static void addJankListener(int32_t layerId, sp<IBinder> listener);
+    // Opens the jank data channel of the given process, replacing any previous one, and returns the
+    // file descriptor to read it from, or an invalid one if the channel could not be created.
+    static base::unique_fd openJankDataChannel(pid_t pid, sp<IBinder> listener);
+
+    // The pid is that of the process that registered the listener, which receives its jank data
+    // through the jank data channel of that process, if there is one.
+    static void addJankListener(int32_t layerId, sp<IBinder> listener, pid_t pid = -1);
     static void flushJankData(int32_t layerId);
     static void removeJankListener(int32_t layerId, sp<IBinder> listener, int64_t afterVysnc);
 
@@ -67,7 +81,8 @@ private:
         return instance;
     }
 
-    void addJankListenerLocked(int32_t layerId, sp<IBinder> listener) REQUIRES(mLock);
+    void addJankListenerLocked(int32_t layerId, sp<IBinder> listener, pid_t pid) REQUIRES(mLock);
+    void doOnJankData(int32_t layerId, const gui::JankData& data);
     void doFlushJankData(int32_t layerId);
     void markJankListenerForRemovalLocked(int32_t layerId, sp<IBinder> listener, int64_t afterVysnc)
             REQUIRES(mLock);
@@ -75,11 +90,32 @@ private:
     int64_t transferAvailableJankData(int32_t layerId, std::vector<gui::JankData>& jankData);
     void dropJankListener(int32_t layerId, sp<IBinder> listener);
 
+    // Writes the jank data to the channels of the listeners of the layer, and returns whether the
+    // layer has listeners without a channel.
+    bool writeToChannelsLocked(int32_t layerId, const gui::JankData& data,
+                               std::vector<sp<IBinder>>& outToPublish) REQUIRES(mLock);
+    void publishToChannels(const std::vector<sp<IBinder>>& toPublish);
+    void dropJankDataChannel(pid_t pid, const IBinder* listener);
+
+    class ChannelDeathRecipient;
+
     struct Listener {
         sp<IBinder> mListener;
         int64_t mRemoveAfter;
+        pid_t mPid;
+        // Highest VSync ID of the jank data written to the channel of the listener.
+        int64_t mLastVsync = 0;
+
+        Listener(sp<IBinder>&& listener, pid_t pid)
+              : mListener(listener), mRemoveAfter(-1), mPid(pid) {}
+    };
 
-        Listener(sp<IBinder>&& listener) : mListener(listener), mRemoveAfter(-1) {}
+    struct Channel {
+        std::unique_ptr<gui::JankDataChannel::Producer> mProducer;
+        sp<IBinder> mListener;
+        sp<IBinder::DeathRecipient> mDeathRecipient;
+        // Number of entries written since the listener was last notified.
+        size_t mUnpublished = 0;
     };
 
     // We keep track of the current listener count, so that the onJankData call, which is on the
@@ -90,6 +126,7 @@ private:
 
     std::mutex mLock;
     std::unordered_multimap<int32_t, Listener> mJankListeners GUARDED_BY(mLock);
+    std::unordered_map<pid_t, Channel> mChannels GUARDED_BY(mLock);
     std::mutex mJankDataLock;
     std::unordered_multimap<int32_t, gui::JankData> mJankData GUARDED_BY(mJankDataLock);
 
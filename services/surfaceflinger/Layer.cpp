@@ -193,6 +193,34 @@ Layer::~Layer() {
         mFlinger->mNumTrustedPresentationListeners--;
         updateTrustedPresentationState(nullptr, nullptr, -1 /* time_in_ms */, true /* leaveState*/);
     }
+
+    // Only the bookkeeping above needs the main thread. Freeing the buffers, and dropping the
+    // fences and binder objects that may be the last references to them, is left to a background
+    // lane, as it adds up to long frames when an app with many layers is closed.
+    ftl::FakeGuard mainThreadGuard(kMainThreadContext);
+    mFlinger->deferLayerTeardown([buffer = std::move(mBufferInfo.mBuffer),
+                                  fence = std::move(mBufferInfo.mFence),
+                                  fenceTime = std::move(mBufferInfo.mFenceTime),
+                                  drawingBuffer = std::move(mDrawingState.buffer),
+                                  acquireFence = std::move(mDrawingState.acquireFence),
+                                  acquireFenceTime = std::move(mDrawingState.acquireFenceTime),
+                                  sidebandStream = std::move(mDrawingState.sidebandStream),
+                                  callbackHandles = std::move(mDrawingState.callbackHandles),
+                                  releaseBufferListener =
+                                          std::move(mDrawingState.releaseBufferListener),
+                                  layerFEs = std::move(mLayerFEs)]() mutable {
+        SFTRACE_NAME("Layer::teardown");
+        layerFEs.clear();
+        callbackHandles.clear();
+        releaseBufferListener.clear();
+        sidebandStream.clear();
+        acquireFenceTime.reset();
+        acquireFence.clear();
+        drawingBuffer.reset();
+        fenceTime.reset();
+        fence.clear();
+        buffer.reset();
+    });
 }
 
 // ---------------------------------------------------------------------------
@@ -682,12 +710,16 @@ void Layer::callReleaseBufferCallback(const sp<ITransactionCompletedListener>& l
     uint32_t currentMaxAcquiredBufferCount =
             mFlinger->getMaxAcquiredBufferCountForCurrentRefreshRate(mOwnerUid);
 
-    if (listener) {
-        listener->onReleaseBuffer(callbackId, fence, currentMaxAcquiredBufferCount);
+    // Clients with a release channel get their releases through it alone, which saves a binder
+    // call per buffer. The listener is only used if the channel can't be written to.
+    if (mBufferReleaseChannel &&
+        mBufferReleaseChannel->writeReleaseFence(callbackId, fence,
+                                                 currentMaxAcquiredBufferCount) == OK) {
+        return;
     }
 
-    if (mBufferReleaseChannel) {
-        mBufferReleaseChannel->writeReleaseFence(callbackId, fence, currentMaxAcquiredBufferCount);
+    if (listener) {
+        listener->onReleaseBuffer(callbackId, fence, currentMaxAcquiredBufferCount);
     }
 }
 
@@ -951,8 +983,8 @@ bool Layer::setBuffer(std::shared_ptr<renderengine::ExternalTexture>& buffer,
     setTransactionFlags(eTransactionNeeded);
 
     const int32_t layerId = getSequence();
-    mFlinger->mTimeStats->setPostTime(layerId, mDrawingState.frameNumber, getName().c_str(),
-                                      mOwnerUid, postTime, gameMode);
+    mFlinger->mTimeStats->setPostTime(layerId, mDrawingState.frameNumber, getName(), mOwnerUid,
+                                      postTime, gameMode);
 
     setFrameTimelineVsyncForBufferTransaction(info, postTime, gameMode);
 
@@ -23,6 +23,7 @@
 #include <gui/GLConsumer.h>
 #include <math/vec3.h>
 #include <system/window.h>
+#include <utility>
 
 #include "LayerFE.h"
 #include "SurfaceFlinger.h"
@@ -84,9 +85,10 @@ LayerFE::~LayerFE() {
     // Ensures that no promise is left unfulfilled before the LayerFE is destroyed.
     // An unfulfilled promise could occur when a screenshot is attempted, but the
     // render area is invalid and there is no memory for the capture result.
+    std::scoped_lock lock(mCompositionResultMutex);
     if (FlagManager::getInstance().ce_fence_promise() &&
         mReleaseFencePromiseStatus == ReleaseFencePromiseStatus::INITIALIZED) {
-        setReleaseFence(Fence::NO_FENCE);
+        setReleaseFenceLocked(Fence::NO_FENCE);
     }
 }
 
@@ -346,11 +348,13 @@ void LayerFE::prepareShadowClientComposition(LayerFE::LayerSettings& caster,
 
 void LayerFE::onLayerDisplayed(ftl::SharedFuture<FenceResult> futureFenceResult,
                                ui::LayerStack layerStack) {
+    std::scoped_lock lock(mCompositionResultMutex);
     mCompositionResult.releaseFences.emplace_back(std::move(futureFenceResult), layerStack);
 }
 
-CompositionResult&& LayerFE::stealCompositionResult() {
-    return std::move(mCompositionResult);
+CompositionResult LayerFE::stealCompositionResult() {
+    std::scoped_lock lock(mCompositionResultMutex);
+    return std::exchange(mCompositionResult, {});
 }
 
 const char* LayerFE::getDebugName() const {
@@ -374,6 +378,7 @@ bool LayerFE::hasRoundedCorners() const {
 }
 
 void LayerFE::setWasClientComposed(const sp<Fence>& fence) {
+    std::scoped_lock lock(mCompositionResultMutex);
     mCompositionResult.lastClientCompositionFence = fence;
 }
 
@@ -401,6 +406,11 @@ const sp<GraphicBuffer> LayerFE::getBuffer() const {
 }
 
 void LayerFE::setReleaseFence(const FenceResult& releaseFence) {
+    std::scoped_lock lock(mCompositionResultMutex);
+    setReleaseFenceLocked(releaseFence);
+}
+
+void LayerFE::setReleaseFenceLocked(const FenceResult& releaseFence) {
     // Promises should not be fulfilled more than once. This case can occur if virtual
     // displays with the same layerstack ID are being created and destroyed in quick
     // succession, such as in tests. This would result in a race condition in which
@@ -414,6 +424,7 @@ void LayerFE::setReleaseFence(const FenceResult& releaseFence) {
 
 // LayerFEs are reused and a new fence needs to be created whevever a buffer is latched.
 ftl::Future<FenceResult> LayerFE::createReleaseFenceFuture() {
+    std::scoped_lock lock(mCompositionResultMutex);
     if (mReleaseFencePromiseStatus == ReleaseFencePromiseStatus::INITIALIZED) {
         LOG_ALWAYS_FATAL("Attempting to create a new promise while one is still unfulfilled.");
     }
@@ -423,6 +434,7 @@ ftl::Future<FenceResult> LayerFE::createReleaseFenceFuture() {
 }
 
 LayerFE::ReleaseFencePromiseStatus LayerFE::getReleaseFencePromiseStatus() {
+    std::scoped_lock lock(mCompositionResultMutex);
     return mReleaseFencePromiseStatus;
 }
 } // namespace android
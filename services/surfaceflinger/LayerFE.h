@@ -16,6 +16,7 @@
 
 #pragma once
 
+#include <android-base/thread_annotations.h>
 #include <android/gui/CachingHint.h>
 #include <gui/LayerMetadata.h>
 #include "FrontEnd/LayerSnapshot.h"
@@ -25,6 +26,7 @@
 #include "ui/LayerStack.h"
 
 #include <ftl/future.h>
+#include <mutex>
 
 namespace android {
 
@@ -50,7 +52,7 @@ public:
     const gui::LayerMetadata* getRelativeMetadata() const override;
     std::optional<compositionengine::LayerFE::LayerSettings> prepareClientComposition(
             compositionengine::LayerFE::ClientCompositionTargetSettings&) const;
-    CompositionResult&& stealCompositionResult();
+    CompositionResult stealCompositionResult();
     ftl::Future<FenceResult> createReleaseFenceFuture() override;
     void setReleaseFence(const FenceResult& releaseFence) override;
     LayerFE::ReleaseFencePromiseStatus getReleaseFencePromiseStatus() override;
@@ -81,10 +83,16 @@ private:
 
     const sp<GraphicBuffer> getBuffer() const;
 
-    CompositionResult mCompositionResult;
+    void setReleaseFenceLocked(const FenceResult& releaseFence) REQUIRES(mCompositionResultMutex);
+
+    // Outputs that do not share layers may be presented concurrently, and each of them reports
+    // its composition results and release fences back to the LayerFE.
+    mutable std::mutex mCompositionResultMutex;
+    CompositionResult mCompositionResult GUARDED_BY(mCompositionResultMutex);
     std::string mName;
-    std::promise<FenceResult> mReleaseFence;
-    ReleaseFencePromiseStatus mReleaseFencePromiseStatus = ReleaseFencePromiseStatus::UNINITIALIZED;
+    std::promise<FenceResult> mReleaseFence GUARDED_BY(mCompositionResultMutex);
+    ReleaseFencePromiseStatus mReleaseFencePromiseStatus GUARDED_BY(mCompositionResultMutex) =
+            ReleaseFencePromiseStatus::UNINITIALIZED;
 };
 
 } // namespace android
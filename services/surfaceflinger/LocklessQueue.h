@@ -16,8 +16,15 @@
 
 #pragma once
 
+#include <algorithm>
 #include <atomic>
+#include <bit>
+#include <cstdint>
+#include <iterator>
+#include <memory>
 #include <optional>
+#include <utility>
+#include <vector>
 
 // Single consumer multi producer queue. We can understand the two operations independently to see
 // why they are without race condition.
@@ -74,13 +81,218 @@ public:
         }
     }
 
+    // Appends every queued value to out, oldest first. The push list is taken with a single
+    // exchange rather than one pop at a time.
+    void popAll(std::vector<T>& out) {
+        while (auto value = popFromPopList()) {
+            out.push_back(std::move(*value));
+        }
+
+        Entry* grabbedList = mPush.exchange(nullptr /* , std::memory_order_acquire */);
+        const size_t first = out.size();
+        while (grabbedList) {
+            Entry* next = grabbedList->mNext;
+            out.push_back(std::move(grabbedList->mValue));
+            delete grabbedList;
+            grabbedList = next;
+        }
+        // The push list is newest first.
+        std::reverse(out.begin() + static_cast<std::ptrdiff_t>(first), out.end());
+    }
+
 private:
     class Entry {
     public:
         T mValue;
         std::atomic<Entry*> mNext;
-        Entry(T value) : mValue(value) {}
+        Entry(T value) : mValue(std::move(value)) {}
     };
+
+    std::optional<T> popFromPopList() {
+        Entry* popped = mPop.load(/*std::memory_order_acquire*/);
+        if (!popped) return std::nullopt;
+        mPop.store(popped->mNext /* , std::memory_order_release */);
+        auto value = std::move(popped->mValue);
+        delete popped;
+        return value;
+    }
+
     std::atomic<Entry*> mPush = nullptr;
     std::atomic<Entry*> mPop = nullptr;
 };
+
+// Single consumer multi producer queue backed by a preallocated ring, so that pushing does not
+// allocate as long as the consumer keeps up.
+//
+// Each slot carries a sequence number that tells producers and the consumer whose turn it is. A
+// producer claims the slot at mEnqueuePos with a compare_exchange, which only one producer can win
+// for a given position, writes the value and then publishes it by bumping the slot sequence. The
+// consumer walks the ring from mDequeuePos for as long as the slots are published and hands each
+// slot back to producers of the next lap.
+//
+// When the ring is full, values spill over into a LocklessQueue, so a push never blocks and never
+// fails. Values are tagged with a push order so that popAll can interleave the overflow back with
+// the ring and keep the order in which each thread pushed.
+//
+// A value that spilled over may only be popped once every value its thread pushed into the ring
+// before it has been drained. Those were claimed before the spilled value was pushed, so they all
+// sit below the enqueue position read after taking the overflow, and the spilled value is held
+// back until the consumer has drained that far. Values ordered after a held back value are held
+// back with it, as they may have been pushed by the same thread.
+template <typename T>
+class BoundedLocklessQueue {
+public:
+    explicit BoundedLocklessQueue(size_t capacity)
+          : mMask(std::bit_ceil(std::max<size_t>(capacity, 2)) - 1),
+            mSlots(std::make_unique<Slot[]>(mMask + 1)) {
+        for (size_t i = 0; i <= mMask; i++) {
+            mSlots[i].sequence.store(i, std::memory_order_relaxed);
+        }
+        mDrainedOrders.reserve(mMask + 1);
+    }
+
+    // Only meaningful on the consumer thread.
+    bool isEmpty() {
+        return mPoppedIndex == mPopped.size() && !isPublished(mDequeuePos) &&
+                mOverflowCount.load(std::memory_order_acquire) == 0 && mHeldBack.empty();
+    }
+
+    size_t capacity() const { return mMask + 1; }
+
+    void push(T value) {
+        const uint64_t order = mNextOrder.fetch_add(1, std::memory_order_relaxed);
+        size_t pos = mEnqueuePos.load(std::memory_order_relaxed);
+        while (true) {
+            Slot& slot = mSlots[pos & mMask];
+            const size_t sequence = slot.sequence.load(std::memory_order_acquire);
+            const auto delta = static_cast<intptr_t>(sequence) - static_cast<intptr_t>(pos);
+            if (delta == 0) {
+                if (mEnqueuePos.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed)) {
+                    slot.value.emplace(std::move(value));
+                    slot.order = order;
+                    slot.sequence.store(pos + 1, std::memory_order_release);
+                    return;
+                }
+            } else if (delta < 0) {
+                // The consumer has not released this slot yet, the ring is full.
+                mOverflow.push({order, std::move(value)});
+                mOverflowCount.fetch_add(1, std::memory_order_release);
+                return;
+            } else {
+                pos = mEnqueuePos.load(std::memory_order_relaxed);
+            }
+        }
+    }
+
+    // Pops a single value, for callers that do not batch.
+    std::optional<T> pop() {
+        if (mPoppedIndex == mPopped.size()) {
+            mPopped.clear();
+            mPoppedIndex = 0;
+            popAll(mPopped);
+            if (mPopped.empty()) return std::nullopt;
+        }
+        return std::move(mPopped[mPoppedIndex++]);
+    }
+
+    // Appends every published value to out, in push order. Does not allocate unless out needs to
+    // grow or the ring overflowed.
+    void popAll(std::vector<T>& out) {
+        // Values already taken out of the ring by pop() come first.
+        if (&out != &mPopped) {
+            std::move(mPopped.begin() + static_cast<std::ptrdiff_t>(mPoppedIndex), mPopped.end(),
+                      std::back_inserter(out));
+            mPopped.clear();
+            mPoppedIndex = 0;
+        }
+
+        const size_t first = out.size();
+        mDrainedOrders.clear();
+        for (; isPublished(mDequeuePos); mDequeuePos++) {
+            Slot& slot = mSlots[mDequeuePos & mMask];
+            mDrainedOrders.push_back(slot.order);
+            out.push_back(release(slot));
+        }
+
+        // The overflow is checked after draining the ring. A value that spilled over was counted
+        // before its thread pushed anything else, so any later value of that thread seen in the
+        // ring guarantees that the spilled value is seen here too.
+        const size_t overflowCount = mOverflowCount.exchange(0, std::memory_order_acquire);
+        if (overflowCount == 0 && mHeldBack.empty()) {
+            return;
+        }
+        if (overflowCount > mOverflowPeak.load(std::memory_order_relaxed)) {
+            mOverflowPeak.store(overflowCount, std::memory_order_relaxed);
+        }
+
+        for (size_t i = 0; i < mDrainedOrders.size(); i++) {
+            mHeldBack.push_back({mDrainedOrders[i], 0, std::move(out[first + i])});
+        }
+        out.erase(out.begin() + static_cast<std::ptrdiff_t>(first), out.end());
+
+        std::vector<std::pair<uint64_t, T>> overflow;
+        mOverflow.popAll(overflow);
+        if (!overflow.empty()) {
+            const size_t drainPos = mEnqueuePos.load(std::memory_order_acquire);
+            for (auto& [order, value] : overflow) {
+                mHeldBack.push_back({order, drainPos, std::move(value)});
+            }
+        }
+
+        // Pop every value ordered before the first spilled value whose thread may still have
+        // values in the ring, and keep the rest for the next popAll.
+        std::stable_sort(mHeldBack.begin(), mHeldBack.end(),
+                         [](const auto& lhs, const auto& rhs) { return lhs.order < rhs.order; });
+        const auto held = std::find_if(mHeldBack.begin(), mHeldBack.end(),
+                                       [this](const HeldBackValue& value) {
+                                           return value.drainPos > mDequeuePos;
+                                       });
+        for (auto it = mHeldBack.begin(); it != held; it++) {
+            out.push_back(std::move(it->value));
+        }
+        mHeldBack.erase(mHeldBack.begin(), held);
+    }
+
+    // The largest number of values that spilled over the ring between two popAll calls.
+    size_t getOverflowPeak() const { return mOverflowPeak.load(std::memory_order_relaxed); }
+
+private:
+    struct Slot {
+        std::atomic<size_t> sequence;
+        uint64_t order = 0;
+        std::optional<T> value;
+    };
+
+    struct HeldBackValue {
+        uint64_t order;
+        // The value may be popped once the ring has been drained up to this position.
+        size_t drainPos;
+        T value;
+    };
+
+    bool isPublished(size_t pos) const {
+        return mSlots[pos & mMask].sequence.load(std::memory_order_acquire) == pos + 1;
+    }
+
+    // Moves the value out of a published slot and hands the slot to the producers of the next lap.
+    T release(Slot& slot) {
+        T value = std::move(*slot.value);
+        slot.value.reset();
+        slot.sequence.store(mDequeuePos + mMask + 1, std::memory_order_release);
+        return value;
+    }
+
+    const size_t mMask;
+    const std::unique_ptr<Slot[]> mSlots;
+    std::atomic<size_t> mEnqueuePos = 0;
+    std::atomic<uint64_t> mNextOrder = 0;
+    std::atomic<size_t> mOverflowCount = 0;
+    LocklessQueue<std::pair<uint64_t, T>> mOverflow;
+    std::atomic<size_t> mOverflowPeak = 0;
+    // Only accessed by the consumer.
+    size_t mDequeuePos = 0;
+    std::vector<uint64_t> mDrainedOrders;
+    std::vector<HeldBackValue> mHeldBack;
+    std::vector<T> mPopped;
+    size_t mPoppedIndex = 0;
+};
@@ -35,7 +35,9 @@
 #include <gui/SyncScreenCaptureListener.h>
 #include <renderengine/impl/ExternalTexture.h>
 #include <ui/DisplayStatInfo.h>
+#include <ui/GraphicBufferAllocator.h>
 
+#include <algorithm>
 #include <string>
 
 #include "DisplayDevice.h"
@@ -64,6 +66,7 @@ constexpr auto defaultRegionSamplingWorkDuration = 3ms;
 constexpr auto defaultRegionSamplingPeriod = 100ms;
 constexpr auto defaultRegionSamplingTimerTimeout = 100ms;
 constexpr auto maxRegionSamplingDelay = 100ms;
+constexpr int32_t defaultRegionSamplingDownscale = 4;
 // TODO: (b/127403193) duration to string conversion could probably be constexpr
 template <typename Rep, typename Per>
 inline std::string toNsString(std::chrono::duration<Rep, Per> t) {
@@ -100,6 +103,9 @@ RegionSamplingThread::EnvironmentTimingTunables::EnvironmentTimingTunables() {
 RegionSamplingThread::RegionSamplingThread(SurfaceFlinger& flinger, const TimingTunables& tunables)
       : mFlinger(flinger),
         mTunables(tunables),
+        mDownscale(std::max(1,
+                            property_get_int32("debug.sf.region_sampling_downscale",
+                                               defaultRegionSamplingDownscale))),
         mIdleTimer(
                 "RegSampIdle",
                 std::chrono::duration_cast<std::chrono::milliseconds>(
@@ -225,6 +231,16 @@ float sampleArea(const uint32_t* data, int32_t width, int32_t height, int32_t st
     return accumulatedLuma / (255.0f * pixelCount);
 }
 
+Rect downscaleArea(const Rect& area, int32_t downscale) {
+    if (downscale <= 1) return area;
+    const auto roundDown = [downscale](int32_t value) {
+        return value >= 0 ? value / downscale : -((-value + downscale - 1) / downscale);
+    };
+    const auto roundUp = [&](int32_t value) { return -roundDown(-value); };
+    return Rect(roundDown(area.left), roundDown(area.top), roundUp(area.right),
+                roundUp(area.bottom));
+}
+
 std::vector<float> RegionSamplingThread::sampleBuffer(
         const sp<GraphicBuffer>& buffer, const Point& leftTop,
         const std::vector<RegionSamplingThread::Descriptor>& descriptors, uint32_t orientation) {
@@ -241,7 +257,7 @@ std::vector<float> RegionSamplingThread::sampleBuffer(
     std::transform(descriptors.begin(), descriptors.end(), lumas.begin(),
                    [&](auto const& descriptor) {
                        return sampleArea(data.get(), width, height, stride, orientation,
-                                         descriptor.area - leftTop);
+                                         downscaleArea(descriptor.area - leftTop, mDownscale));
                    });
     return lumas;
 }
@@ -277,6 +293,8 @@ void RegionSamplingThread::captureSample() {
     }
 
     const Rect sampledBounds = sampleRegion.bounds();
+    const ui::Size sampledBufferSize =
+            downscaleArea(Rect(sampledBounds.getSize()), mDownscale).getSize();
 
     std::unordered_set<sp<IRegionSamplingListener>, SpHash<IRegionSamplingListener>> listeners;
 
@@ -325,15 +343,26 @@ void RegionSamplingThread::captureSample() {
             mFlinger.getLayerSnapshotsForScreenshots(layerStack, CaptureArgs::UNSET_UID, filterFn);
 
     std::shared_ptr<renderengine::ExternalTexture> buffer = nullptr;
-    if (mCachedBuffer && mCachedBuffer->getBuffer()->getWidth() == sampledBounds.getWidth() &&
-        mCachedBuffer->getBuffer()->getHeight() == sampledBounds.getHeight()) {
+    if (mCachedBuffer && mCachedBuffer->getBuffer()->getWidth() == sampledBufferSize.width &&
+        mCachedBuffer->getBuffer()->getHeight() == sampledBufferSize.height) {
         buffer = mCachedBuffer;
     } else {
         const uint32_t usage =
                 GRALLOC_USAGE_SW_READ_OFTEN | GRALLOC_USAGE_HW_RENDER | GRALLOC_USAGE_HW_TEXTURE;
-        sp<GraphicBuffer> graphicBuffer =
-                sp<GraphicBuffer>::make(sampledBounds.getWidth(), sampledBounds.getHeight(),
-                                        PIXEL_FORMAT_RGBA_8888, 1, usage, "RegionSamplingThread");
+        // The sampled buffer size follows the sampled area, so recycle the buffers of previous
+        // sizes. They are only read back by this thread.
+        const GraphicBufferAllocator::AllocationRequest request = {
+                .importBuffer = true,
+                // Unlike the other constructors, requests fail rather than round up empty sizes.
+                .width = static_cast<uint32_t>(std::max(sampledBufferSize.width, 1)),
+                .height = static_cast<uint32_t>(std::max(sampledBufferSize.height, 1)),
+                .format = PIXEL_FORMAT_RGBA_8888,
+                .layerCount = 1,
+                .usage = usage,
+                .requestorName = "RegionSamplingThread",
+                .recyclable = true,
+        };
+        sp<GraphicBuffer> graphicBuffer = sp<GraphicBuffer>::make(request);
         const status_t bufferStatus = graphicBuffer->initCheck();
         LOG_ALWAYS_FATAL_IF(bufferStatus != OK, "captureSample: Buffer failed to allocate: %d",
                             bufferStatus);
@@ -350,7 +379,7 @@ void RegionSamplingThread::captureSample() {
 
     SurfaceFlinger::RenderAreaBuilderVariant
             renderAreaBuilder(std::in_place_type<DisplayRenderAreaBuilder>, sampledBounds,
-                              sampledBounds.getSize(), ui::Dataspace::V0_SRGB, displayWeak,
+                              sampledBufferSize, ui::Dataspace::V0_SRGB, displayWeak,
                               RenderArea::Options::CAPTURE_SECURE_LAYERS);
 
     FenceResult fenceResult;
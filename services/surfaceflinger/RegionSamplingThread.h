@@ -44,6 +44,9 @@ using gui::IRegionSamplingListener;
 
 float sampleArea(const uint32_t* data, int32_t width, int32_t height, int32_t stride,
                  uint32_t orientation, const Rect& area);
+// Maps an area to a buffer rendered at 1/downscale of its size, rounding outwards so that the
+// pixels the area partially covers are still sampled.
+Rect downscaleArea(const Rect& area, int32_t downscale);
 
 class RegionSamplingThread : public IBinder::DeathRecipient {
 public:
@@ -104,6 +107,10 @@ private:
 
     SurfaceFlinger& mFlinger;
     const TimingTunables mTunables;
+    // debug.sf.region_sampling_downscale
+    // The sampled region is rendered at 1/mDownscale of its size in each dimension, so that the
+    // GPU averages the pixels and the CPU only reads back and scans a fraction of them.
+    const int32_t mDownscale;
     scheduler::OneShotTimer mIdleTimer;
 
     std::thread mThread;
@@ -20,8 +20,10 @@
 
 #define ATRACE_TAG ATRACE_TAG_GRAPHICS
 
+#include <fcntl.h>
 #include <pthread.h>
 #include <sched.h>
+#include <sys/mman.h>
 #include <sys/types.h>
 
 #include <chrono>
@@ -34,7 +36,9 @@
 
 #include <binder/IPCThreadState.h>
 #include <common/trace.h>
+#include <cutils/ashmem.h>
 #include <cutils/compiler.h>
+#include <cutils/properties.h>
 #include <cutils/sched_policy.h>
 
 #include <gui/DisplayEventReceiver.h>
@@ -239,6 +243,17 @@ binder::Status EventThreadConnection::getLatestVsyncEventData(
     return binder::Status::ok();
 }
 
+binder::Status EventThreadConnection::getSharedVsyncEventData(
+        std::optional<os::ParcelFileDescriptor>* outMemory) {
+    SFTRACE_CALL();
+    if (base::unique_fd fd = mEventThread->getSharedVsyncEventData(); fd.ok()) {
+        outMemory->emplace(std::move(fd));
+    } else {
+        outMemory->reset();
+    }
+    return binder::Status::ok();
+}
+
 binder::Status EventThreadConnection::getSchedulingPolicy(gui::SchedulingPolicy* outPolicy) {
     return gui::getSchedulingPolicy(outPolicy);
 }
@@ -283,6 +298,12 @@ EventThread::EventThread(const char* name, std::shared_ptr<scheduler::VsyncSched
         mVsyncRegistration(mVsyncSchedule->getDispatch(), createDispatchCallback(), name),
         mTokenManager(tokenManager),
         mCallback(callback) {
+    static const bool kSharedVsyncEventData =
+            property_get_bool("debug.sf.vsync_shared_memory", false);
+    if (kSharedVsyncEventData) {
+        createSharedVsyncEventData();
+    }
+
     mThread = std::thread([this]() NO_THREAD_SAFETY_ANALYSIS {
         std::unique_lock<std::mutex> lock(mMutex);
         threadMain(lock);
@@ -310,6 +331,54 @@ EventThread::~EventThread() {
         mCondition.notify_all();
     }
     mThread.join();
+
+    if (mSharedVsyncEventData) {
+        munmap(mSharedVsyncEventData, sizeof(gui::SharedVsyncEventData));
+    }
+}
+
+void EventThread::createSharedVsyncEventData() {
+    base::unique_fd fd(ashmem_create_region(mThreadName, sizeof(gui::SharedVsyncEventData)));
+    if (!fd.ok()) {
+        ALOGE("%s: Failed to create shared vsync event data", mThreadName);
+        return;
+    }
+
+    void* address = mmap(nullptr, sizeof(gui::SharedVsyncEventData), PROT_READ | PROT_WRITE,
+                         MAP_SHARED, fd.get(), 0);
+    if (address == MAP_FAILED) {
+        ALOGE("%s: Failed to map shared vsync event data: %s", mThreadName, strerror(errno));
+        return;
+    }
+
+    // Later mappings, including those of clients, are read-only.
+    if (ashmem_set_prot_region(fd.get(), PROT_READ) != 0) {
+        ALOGE("%s: Failed to restrict shared vsync event data", mThreadName);
+        munmap(address, sizeof(gui::SharedVsyncEventData));
+        return;
+    }
+
+    // ashmem regions are zero filled, and a zero sequence number means nothing was published.
+    mSharedVsyncEventData = static_cast<gui::SharedVsyncEventData*>(address);
+    mSharedVsyncEventDataFd = std::move(fd);
+}
+
+base::unique_fd EventThread::getSharedVsyncEventData() const {
+    if (!mSharedVsyncEventDataFd.ok()) {
+        return {};
+    }
+    return base::unique_fd(fcntl(mSharedVsyncEventDataFd.get(), F_DUPFD_CLOEXEC, 0));
+}
+
+void EventThread::publishSharedVsyncEventData(const DisplayEventReceiver::Event& event) {
+    // Readers of the shared event have no uid specific frame interval, so it follows the display.
+    VsyncEventData vsyncData = event.vsync.vsyncData;
+    const nsecs_t frameInterval = mVsyncSchedule->period().ns();
+    vsyncData.frameInterval = frameInterval;
+    generateFrameTimeline(vsyncData, frameInterval, event.header.timestamp,
+                          event.vsync.vsyncData.preferredExpectedPresentationTime(),
+                          event.vsync.vsyncData.preferredDeadlineTimestamp());
+    mSharedVsyncEventData->write(event.header.timestamp, event.vsync.count, vsyncData);
 }
 
 void EventThread::setDuration(std::chrono::nanoseconds workDuration,
@@ -701,6 +770,10 @@ void EventThread::generateFrameTimeline(VsyncEventData& outVsyncEventData, nsecs
 
 void EventThread::dispatchEvent(const DisplayEventReceiver::Event& event,
                                 const DisplayEventConsumers& consumers) {
+    if (mSharedVsyncEventData && event.header.type == DisplayEventReceiver::DISPLAY_EVENT_VSYNC) {
+        publishSharedVsyncEventData(event);
+    }
+
     for (const auto& consumer : consumers) {
         DisplayEventReceiver::Event copy = event;
         if (event.header.type == DisplayEventReceiver::DISPLAY_EVENT_VSYNC) {
@@ -17,6 +17,7 @@
 #pragma once
 
 #include <android-base/thread_annotations.h>
+#include <android-base/unique_fd.h>
 #include <android/gui/BnDisplayEventConnection.h>
 #include <gui/DisplayEventReceiver.h>
 #include <private/gui/BitTube.h>
@@ -78,6 +79,8 @@ public:
     binder::Status setVsyncRate(int rate) override;
     binder::Status requestNextVsync() override; // asynchronous
     binder::Status getLatestVsyncEventData(ParcelableVsyncEventData* outVsyncEventData) override;
+    binder::Status getSharedVsyncEventData(
+            std::optional<os::ParcelFileDescriptor>* outMemory) override;
     binder::Status getSchedulingPolicy(gui::SchedulingPolicy* outPolicy) override;
 
     VSyncRequest vsyncRequest = VSyncRequest::None;
@@ -129,6 +132,9 @@ public:
     virtual void requestNextVsync(const sp<EventThreadConnection>& connection) = 0;
     virtual VsyncEventData getLatestVsyncEventData(const sp<EventThreadConnection>& connection,
                                                    nsecs_t now) const = 0;
+    // Returns a read-only descriptor to the memory where vsync events are published, or an
+    // invalid descriptor if they are only delivered through each connection's BitTube.
+    virtual base::unique_fd getSharedVsyncEventData() const = 0;
 
     virtual void onNewVsyncSchedule(std::shared_ptr<scheduler::VsyncSchedule>) = 0;
 
@@ -162,6 +168,7 @@ public:
     void requestNextVsync(const sp<EventThreadConnection>& connection) override;
     VsyncEventData getLatestVsyncEventData(const sp<EventThreadConnection>& connection,
                                            nsecs_t now) const override;
+    base::unique_fd getSharedVsyncEventData() const override;
 
     void enableSyntheticVsync(bool) override;
 
@@ -209,6 +216,9 @@ private:
 
     scheduler::VSyncDispatch::Callback createDispatchCallback();
 
+    void createSharedVsyncEventData();
+    void publishSharedVsyncEventData(const DisplayEventReceiver::Event& event) REQUIRES(mMutex);
+
     // Returns the old registration so it can be destructed outside the lock to
     // avoid deadlock.
     scheduler::VSyncCallbackRegistration onNewVsyncScheduleInternal(
@@ -226,6 +236,11 @@ private:
 
     IEventThreadCallback& mCallback;
 
+    // Memory shared with clients where the latest vsync event is published, if enabled by
+    // debug.sf.vsync_shared_memory. Written on the EventThread only.
+    base::unique_fd mSharedVsyncEventDataFd;
+    gui::SharedVsyncEventData* mSharedVsyncEventData = nullptr;
+
     std::thread mThread;
     mutable std::mutex mMutex;
     mutable std::condition_variable mCondition;
@@ -120,10 +120,12 @@ void LayerHistory::registerLayer(Layer* layer, bool contentDetectionEnabled,
     // The layer can be placed on either map, it is assumed that partitionLayers() will be called
     // to correct them.
     mInactiveLayerInfos.insert({layer->getSequence(), std::make_pair(layer, std::move(info))});
+    mChangedInactiveLayers.insert(layer->getSequence());
 }
 
 void LayerHistory::deregisterLayer(Layer* layer) {
     std::lock_guard lock(mLock);
+    mChangedInactiveLayers.erase(layer->getSequence());
     if (!mActiveLayerInfos.erase(layer->getSequence())) {
         if (!mInactiveLayerInfos.erase(layer->getSequence())) {
             LOG_ALWAYS_FATAL("%s: unknown layer %p", __FUNCTION__, layer);
@@ -149,6 +151,7 @@ void LayerHistory::record(int32_t id, const LayerProps& layerProps, nsecs_t pres
         mActiveLayerInfos.insert(
                 {id, std::make_pair(layerPair->first, std::move(layerPair->second))});
         mInactiveLayerInfos.erase(id);
+        mChangedInactiveLayers.erase(id);
     }
 }
 
@@ -186,6 +189,10 @@ void LayerHistory::setLayerProperties(int32_t id, const LayerProps& properties)
         mActiveLayerInfos.insert(
                 {id, std::make_pair(layerPair->first, std::move(layerPair->second))});
         mInactiveLayerInfos.erase(id);
+        mChangedInactiveLayers.erase(id);
+    } else if (found == LayerStatus::LayerInInactiveMap) {
+        // An explicit frame rate vote may still activate the layer.
+        mChangedInactiveLayers.insert(id);
     }
 }
 
@@ -196,6 +203,7 @@ auto LayerHistory::summarize(const RefreshRateSelector& selector, nsecs_t now) -
     std::lock_guard lock(mLock);
 
     partitionLayers(now, selector.isVrrDevice());
+    mLastSummarizeStats.activeLayersVisited = mActiveLayerInfos.size();
 
     for (const auto& [key, value] : mActiveLayerInfos) {
         auto& info = value.second;
@@ -237,27 +245,48 @@ auto LayerHistory::summarize(const RefreshRateSelector& selector, nsecs_t now) -
     return summary;
 }
 
+auto LayerHistory::partitionInactiveLayer(LayerInfos::iterator it, nsecs_t now, nsecs_t threshold,
+                                          bool isVrrDevice) -> LayerInfos::iterator {
+    auto& [layerUnsafe, info] = it->second;
+    if (isLayerActive(*info, threshold, isVrrDevice)) {
+        // move this to the active map
+        mActiveLayerInfos.insert({it->first, std::move(it->second)});
+        return mInactiveLayerInfos.erase(it);
+    }
+
+    if (CC_UNLIKELY(mTraceEnabled)) {
+        trace(*info, LayerVoteType::NoVote, 0);
+    }
+    info->onLayerInactive(now);
+    return std::next(it);
+}
+
 void LayerHistory::partitionLayers(nsecs_t now, bool isVrrDevice) {
     SFTRACE_CALL();
     const nsecs_t threshold = getActiveLayerThreshold(now);
 
-    // iterate over inactive map
-    LayerInfos::iterator it = mInactiveLayerInfos.begin();
-    while (it != mInactiveLayerInfos.end()) {
-        auto& [layerUnsafe, info] = it->second;
-        if (isLayerActive(*info, threshold, isVrrDevice)) {
-            // move this to the active map
+    // Inactive layers are traced on every frame, and their activity depends on the device type.
+    const bool visitAllInactiveLayers =
+            CC_UNLIKELY(mTraceEnabled) || mLastPartitionIsVrrDevice != isVrrDevice;
+    mLastPartitionIsVrrDevice = isVrrDevice;
 
-            mActiveLayerInfos.insert({it->first, std::move(it->second)});
-            it = mInactiveLayerInfos.erase(it);
-        } else {
-            if (CC_UNLIKELY(mTraceEnabled)) {
-                trace(*info, LayerVoteType::NoVote, 0);
+    // iterate over inactive map
+    LayerInfos::iterator it;
+    if (visitAllInactiveLayers) {
+        mLastSummarizeStats.inactiveLayersVisited = mInactiveLayerInfos.size();
+        it = mInactiveLayerInfos.begin();
+        while (it != mInactiveLayerInfos.end()) {
+            it = partitionInactiveLayer(it, now, threshold, isVrrDevice);
+        }
+    } else {
+        mLastSummarizeStats.inactiveLayersVisited = mChangedInactiveLayers.size();
+        for (const int32_t id : mChangedInactiveLayers) {
+            if (it = mInactiveLayerInfos.find(id); it != mInactiveLayerInfos.end()) {
+                partitionInactiveLayer(it, now, threshold, isVrrDevice);
             }
-            info->onLayerInactive(now);
-            it++;
         }
     }
+    mChangedInactiveLayers.clear();
 
     // iterate over active map
     it = mActiveLayerInfos.begin();
@@ -382,9 +411,13 @@ void LayerHistory::clear() {
 
 std::string LayerHistory::dump() const {
     std::lock_guard lock(mLock);
-    return base::StringPrintf("{size=%zu, active=%zu}\n\tGameFrameRateOverrides=\n\t\t%s",
+    return base::StringPrintf("{size=%zu, active=%zu, last summarize visited %zu active and %zu "
+                              "inactive}\n\tGameFrameRateOverrides=\n\t\t%s",
                               mActiveLayerInfos.size() + mInactiveLayerInfos.size(),
-                              mActiveLayerInfos.size(), dumpGameFrameRateOverridesLocked().c_str());
+                              mActiveLayerInfos.size(),
+                              mLastSummarizeStats.activeLayersVisited,
+                              mLastSummarizeStats.inactiveLayersVisited,
+                              dumpGameFrameRateOverridesLocked().c_str());
 }
 
 std::string LayerHistory::dumpGameFrameRateOverridesLocked() const {
@@ -23,7 +23,9 @@
 #include <map>
 #include <memory>
 #include <mutex>
+#include <optional>
 #include <string>
+#include <unordered_set>
 #include <utility>
 #include <vector>
 
@@ -114,11 +116,19 @@ private:
     // Iterates over layers maps moving all active layers to mActiveLayerInfos and all inactive
     // layers to mInactiveLayerInfos. Layer's active state is determined by multiple factors
     // such as update activity, visibility, and frame rate vote.
-    // worst case time complexity is O(2 * inactive + active)
+    // An inactive layer only becomes active after its state changes, so only the inactive layers
+    // in mChangedInactiveLayers are revisited, unless tracing or the device type changed.
+    // worst case time complexity is O(2 * changed inactive + active)
     // now: the current time (system time) when calling the method
     // isVrrDevice: true if the device has DisplayMode with VrrConfig specified.
     void partitionLayers(nsecs_t now, bool isVrrDevice) REQUIRES(mLock);
 
+    // Moves the inactive layer to mActiveLayerInfos if it became active, and returns the next
+    // inactive layer.
+    LayerInfos::iterator partitionInactiveLayer(LayerInfos::iterator, nsecs_t now,
+                                                nsecs_t threshold, bool isVrrDevice)
+            REQUIRES(mLock);
+
     enum class LayerStatus {
         NotFound,
         LayerInActiveMap,
@@ -143,6 +153,17 @@ private:
     LayerInfos mActiveLayerInfos GUARDED_BY(mLock);
     LayerInfos mInactiveLayerInfos GUARDED_BY(mLock);
 
+    // Inactive layers whose state changed since the last partitionLayers.
+    std::unordered_set<int32_t> mChangedInactiveLayers GUARDED_BY(mLock);
+    std::optional<bool> mLastPartitionIsVrrDevice GUARDED_BY(mLock);
+
+    // Number of layers visited by the last summarize, for dumpsys.
+    struct SummarizeStats {
+        size_t inactiveLayersVisited = 0;
+        size_t activeLayersVisited = 0;
+    };
+    SummarizeStats mLastSummarizeStats GUARDED_BY(mLock);
+
     uint32_t mDisplayArea = 0;
 
     // Whether to emit systrace output and debug logs.
@@ -15,11 +15,19 @@
  */
 
 #include "OneShotTimer.h"
+#include <android-base/thread_annotations.h>
+#include <android-base/unique_fd.h>
+#include <common/trace.h>
+#include <sys/timerfd.h>
+#include <unistd.h>
 #include <utils/Log.h>
 #include <utils/Timers.h>
+#include <algorithm>
 #include <chrono>
-#include <sstream>
+#include <condition_variable>
+#include <mutex>
 #include <thread>
+#include <unordered_map>
 
 namespace {
 using namespace std::chrono_literals;
@@ -29,8 +37,7 @@ constexpr int64_t kNsToSeconds = std::chrono::duration_cast<std::chrono::nanosec
 // The syscall interface uses a pair of integers for the timestamp. The first
 // (tv_sec) is the whole count of seconds. The second (tv_nsec) is the
 // nanosecond part of the count. This function takes care of translation.
-void calculateTimeoutTime(std::chrono::nanoseconds timestamp, timespec* spec) {
-    const nsecs_t timeout = systemTime(CLOCK_MONOTONIC) + timestamp.count();
+void calculateTimeoutTime(nsecs_t timeout, timespec* spec) {
     spec->tv_sec = static_cast<__kernel_time_t>(timeout / kNsToSeconds);
     spec->tv_nsec = timeout % kNsToSeconds;
 }
@@ -39,6 +46,133 @@ void calculateTimeoutTime(std::chrono::nanoseconds timestamp, timespec* spec) {
 namespace android {
 namespace scheduler {
 
+// Thread shared by all timers. It waits on a timerfd armed for the earliest deadline of the
+// started timers, and dispatches the timers that are due one at a time.
+class OneShotTimerQueue {
+public:
+    static OneShotTimerQueue& getInstance() {
+        // Intentionally leaked, so that timers may be stopped during static destruction.
+        static OneShotTimerQueue* const sInstance = new OneShotTimerQueue();
+        return *sInstance;
+    }
+
+    // Registers the timer, and dispatches it as soon as possible.
+    void add(OneShotTimer* timer) EXCLUDES(mMutex) {
+        std::lock_guard lock(mMutex);
+        mDeadlines.insert_or_assign(timer, systemTime(SYSTEM_TIME_MONOTONIC));
+        armLocked();
+    }
+
+    // Dispatches the timer as soon as possible, if it is registered.
+    void wake(OneShotTimer* timer) EXCLUDES(mMutex) {
+        std::lock_guard lock(mMutex);
+        if (const auto it = mDeadlines.find(timer); it != mDeadlines.end()) {
+            it->second = systemTime(SYSTEM_TIME_MONOTONIC);
+            armLocked();
+        }
+    }
+
+    // Unregisters the timer, and waits for it to finish being dispatched unless called from
+    // one of its callbacks.
+    void remove(OneShotTimer* timer) EXCLUDES(mMutex) {
+        std::unique_lock lock(mMutex);
+        mDeadlines.erase(timer);
+        if (std::this_thread::get_id() != mThread.get_id()) {
+            mDispatchDone.wait(lock, [&]() REQUIRES(mMutex) { return mDispatching != timer; });
+        }
+    }
+
+private:
+    OneShotTimerQueue() {
+        mTimerFd.reset(timerfd_create(CLOCK_MONOTONIC, TFD_CLOEXEC));
+        LOG_ALWAYS_FATAL_IF(!mTimerFd.ok(), "timerfd_create failed (%d)", errno);
+        mThread = std::thread(&OneShotTimerQueue::loop, this);
+    }
+
+    void loop() {
+        if (pthread_setname_np(pthread_self(), "OneShotTimer")) {
+            ALOGW("Failed to set thread name on dispatch thread");
+        }
+
+        while (true) {
+            uint64_t expirations;
+            if (read(mTimerFd.get(), &expirations, sizeof(expirations)) < 0) {
+                LOG_ALWAYS_FATAL_IF(errno != EINTR, "timerfd read failed (%d)", errno);
+                continue;
+            }
+            dispatch();
+        }
+    }
+
+    void dispatch() EXCLUDES(mMutex) {
+        std::unique_lock lock(mMutex);
+        mArmedTime = kDisarmed;
+
+        // Timers woken up while dispatching are handled on the next expiration, so that a timer
+        // that is reset in a loop does not starve the others.
+        const nsecs_t now = systemTime(SYSTEM_TIME_MONOTONIC);
+        while (true) {
+            const auto it = std::find_if(mDeadlines.begin(), mDeadlines.end(),
+                                         [now](const auto& pair) {
+                                             return pair.second && *pair.second <= now;
+                                         });
+            if (it == mDeadlines.end()) break;
+
+            OneShotTimer* const timer = it->first;
+            it->second.reset();
+            mDispatching = timer;
+
+            lock.unlock();
+            const std::optional<nsecs_t> deadline = timer->dispatch();
+            lock.lock();
+
+            mDispatching = nullptr;
+            mDispatchDone.notify_all();
+
+            // The timer may have been stopped or woken up by its callbacks.
+            if (const auto entry = mDeadlines.find(timer); entry != mDeadlines.end() && deadline) {
+                entry->second = std::min(entry->second.value_or(*deadline), *deadline);
+            }
+        }
+
+        armLocked();
+    }
+
+    // Arms the timerfd for the earliest deadline, if it changed.
+    void armLocked() REQUIRES(mMutex) {
+        nsecs_t earliest = kDisarmed;
+        for (const auto& [_, deadline] : mDeadlines) {
+            if (deadline && (earliest == kDisarmed || *deadline < earliest)) {
+                earliest = *deadline;
+            }
+        }
+        if (earliest == mArmedTime) return;
+
+        // Deadlines are armed at least one nanosecond past the epoch, as zero disarms the timerfd.
+        itimerspec spec = {};
+        if (earliest != kDisarmed) {
+            calculateTimeoutTime(std::max<nsecs_t>(earliest, 1), &spec.it_value);
+        }
+        LOG_ALWAYS_FATAL_IF(timerfd_settime(mTimerFd.get(), TFD_TIMER_ABSTIME, &spec, nullptr),
+                            "timerfd_settime failed (%d)", errno);
+        mArmedTime = earliest;
+    }
+
+    static constexpr nsecs_t kDisarmed = -1;
+
+    base::unique_fd mTimerFd;
+    std::thread mThread;
+
+    std::mutex mMutex;
+    std::condition_variable mDispatchDone;
+
+    // The registered timers, and when to dispatch them next, if at all. With only a handful
+    // of timers in the process, this is scanned rather than kept ordered.
+    std::unordered_map<OneShotTimer*, std::optional<nsecs_t>> mDeadlines GUARDED_BY(mMutex);
+    OneShotTimer* mDispatching GUARDED_BY(mMutex) = nullptr;
+    nsecs_t mArmedTime GUARDED_BY(mMutex) = kDisarmed;
+};
+
 OneShotTimer::OneShotTimer(std::string name, const Interval& interval,
                            const ResetCallback& resetCallback,
                            const TimeoutCallback& timeoutCallback, std::unique_ptr<Clock> clock)
@@ -56,141 +190,72 @@ OneShotTimer::~OneShotTimer() {
 }
 
 void OneShotTimer::start() {
-    int result = sem_init(&mSemaphore, 0, 0);
-    LOG_ALWAYS_FATAL_IF(result, "sem_init failed");
+    if (mStarted) return;
+    mStarted = true;
 
-    if (!mThread.joinable()) {
-        // Only create thread if it has not been created.
-        mThread = std::thread(&OneShotTimer::loop, this);
-    }
+    // The timer starts as if it was just reset from the idle state.
+    mState = TimerState::IDLE;
+    mResetTriggered = true;
+    mWaiting = false;
+    OneShotTimerQueue::getInstance().add(this);
 }
 
 void OneShotTimer::stop() {
-    mStopTriggered = true;
-    int result = sem_post(&mSemaphore);
-    LOG_ALWAYS_FATAL_IF(result, "sem_post failed");
-
-    if (mThread.joinable()) {
-        mThread.join();
-        result = sem_destroy(&mSemaphore);
-        LOG_ALWAYS_FATAL_IF(result, "sem_destroy failed");
-    }
-}
+    if (!mStarted) return;
+    mStarted = false;
 
-void OneShotTimer::loop() {
-    if (pthread_setname_np(pthread_self(), mName.c_str())) {
-        ALOGW("Failed to set thread name on dispatch thread");
-    }
+    OneShotTimerQueue::getInstance().remove(this);
+}
 
-    TimerState state = TimerState::RESET;
-    while (true) {
-        bool triggerReset = false;
-        bool triggerTimeout = false;
+std::optional<nsecs_t> OneShotTimer::dispatch() {
+    SFTRACE_NAME(mName.c_str());
 
-        state = checkForResetAndStop(state);
-        if (state == TimerState::STOPPED) {
-            break;
-        }
+    // Cleared before checking for a reset, so that later resets wake up the timer again.
+    mWaiting = false;
 
-        if (state == TimerState::IDLE) {
-            int result = sem_wait(&mSemaphore);
-            if (result && errno != EINTR) {
-                std::stringstream ss;
-                ss << "sem_wait failed (" << errno << ")";
-                LOG_ALWAYS_FATAL("%s", ss.str().c_str());
+    if (mResetTriggered.exchange(false)) {
+        if (mState == TimerState::IDLE) {
+            mState = TimerState::WAITING;
+            if (mResetCallback) {
+                mResetCallback();
             }
-            continue;
-        }
-
-        if (state == TimerState::RESET) {
-            triggerReset = true;
-        }
-
-        if (triggerReset && mResetCallback) {
-            mResetCallback();
+            mTriggerTime = mClock->now() + mInterval.load();
+        } else {
+            mTriggerTime = mLastResetTime.load() + mInterval.load();
         }
+    }
 
-        state = checkForResetAndStop(state);
-        if (state == TimerState::STOPPED) {
-            break;
-        }
-
-        auto triggerTime = mClock->now() + mInterval.load();
-        state = TimerState::WAITING;
-        while (true) {
-            if (mPaused) {
-                mWaiting = true;
-                int result = sem_wait(&mSemaphore);
-                if (result && errno != EINTR) {
-                    std::stringstream ss;
-                    ss << "sem_wait failed (" << errno << ")";
-                    LOG_ALWAYS_FATAL("%s", ss.str().c_str());
-                }
-
-                mWaiting = false;
-                state = checkForResetAndStop(state);
-                if (state == TimerState::STOPPED) {
-                    break;
-                }
-            }
-            // Wait until triggerTime time to check if we need to reset or drop into the idle state.
-            if (const auto triggerInterval = triggerTime - mClock->now(); triggerInterval > 0ns) {
-                mWaiting = true;
-                struct timespec ts;
-                calculateTimeoutTime(triggerInterval, &ts);
-                int result = sem_clockwait(&mSemaphore, CLOCK_MONOTONIC, &ts);
-                if (result && errno != ETIMEDOUT && errno != EINTR) {
-                    std::stringstream ss;
-                    ss << "sem_clockwait failed (" << errno << ")";
-                    LOG_ALWAYS_FATAL("%s", ss.str().c_str());
-                }
-            }
-
-            mWaiting = false;
-            state = checkForResetAndStop(state);
-            if (state == TimerState::STOPPED) {
-                break;
-            }
-
-            if (!mPaused && state == TimerState::WAITING && (triggerTime - mClock->now()) <= 0ns) {
-                triggerTimeout = true;
-                state = TimerState::IDLE;
-                break;
-            }
-
-            if (state == TimerState::RESET) {
-                triggerTime = mLastResetTime.load() + mInterval.load();
-                state = TimerState::WAITING;
-            }
-        }
+    if (mState == TimerState::IDLE) {
+        return {};
+    }
 
-        if (triggerTimeout && mTimeoutCallback) {
-            mTimeoutCallback();
-        }
+    // Wait for resume to wake up the timer.
+    if (mPaused) {
+        mWaiting = true;
+        return {};
     }
-}
 
-OneShotTimer::TimerState OneShotTimer::checkForResetAndStop(TimerState state) {
-    // Stop takes precedence of the reset.
-    if (mStopTriggered.exchange(false)) {
-        return TimerState::STOPPED;
+    // Wait until the trigger time to check if we need to reset or drop into the idle state.
+    if (const auto triggerInterval = mTriggerTime - mClock->now(); triggerInterval > 0ns) {
+        mWaiting = true;
+        return systemTime(SYSTEM_TIME_MONOTONIC) +
+                std::chrono::duration_cast<std::chrono::nanoseconds>(triggerInterval).count();
     }
-    // If the state was stopped, the thread was joined, and we cannot reset
-    // the timer anymore.
-    if (state != TimerState::STOPPED && mResetTriggered.exchange(false)) {
-        return TimerState::RESET;
+
+    mState = TimerState::IDLE;
+    if (mTimeoutCallback) {
+        mTimeoutCallback();
     }
-    return state;
+    return {};
 }
 
 void OneShotTimer::reset() {
     mLastResetTime = mClock->now();
     mResetTriggered = true;
-    // If mWaiting is true, then we are guaranteed to be in a block where we are waiting on
-    // mSemaphore for a timeout, rather than idling. So we can avoid a sem_post call since we can
-    // just check that we triggered a reset on timeout.
+    // If mWaiting is true, then the timer is scheduled to be dispatched at its trigger time,
+    // rather than idling. So we can avoid waking it up since the reset is checked then.
     if (!mWaiting) {
-        LOG_ALWAYS_FATAL_IF(sem_post(&mSemaphore), "sem_post failed");
+        OneShotTimerQueue::getInstance().wake(this);
     }
 }
 
@@ -200,7 +265,7 @@ void OneShotTimer::pause() {
 
 void OneShotTimer::resume() {
     if (mPaused.exchange(false)) {
-        LOG_ALWAYS_FATAL_IF(sem_post(&mSemaphore), "sem_post failed");
+        OneShotTimerQueue::getInstance().wake(this);
     }
 }
 
@@ -16,21 +16,28 @@
 
 #pragma once
 
-#include <semaphore.h>
+#include <atomic>
 #include <chrono>
-#include <condition_variable>
-#include <thread>
+#include <functional>
+#include <memory>
+#include <optional>
+#include <string>
 #include "../Clock.h"
 
-#include <android-base/thread_annotations.h>
 #include <scheduler/Time.h>
+#include <utils/Timers.h>
 
 namespace android {
 namespace scheduler {
 
+class OneShotTimerQueue;
+
 /*
  * Class that sets off a timer for a given interval, and fires a callback when the
  * interval expires.
+ *
+ * All timers share a single thread, which waits on a timerfd for the earliest deadline
+ * and fires the callbacks of timers in turn. Callbacks should therefore not block.
  */
 class OneShotTimer {
 public:
@@ -48,7 +55,7 @@ public:
 
     // Initializes and turns on the idle timer.
     void start();
-    // Stops the idle timer and any held resources.
+    // Stops the idle timer. No callbacks are fired once this returns.
     void stop();
     // Resets the wakeup time and fires the reset callback.
     void reset();
@@ -58,40 +65,26 @@ public:
     void resume();
 
 private:
+    friend class OneShotTimerQueue;
+
     // Enum to track in what state is the timer.
     enum class TimerState {
-        // The internal timer thread has been destroyed, and no state is
-        // tracked.
-        // Possible state transitions: RESET
-        STOPPED = 0,
-        // An external thread has just reset this timer.
-        // If there is a reset callback, then that callback is fired.
-        // Possible state transitions: STOPPED, WAITING
-        RESET = 1,
+        // The timeout interval has expired, or the timer was just started. The
+        // reset callback is fired on the next reset.
+        // Possible state transitions: WAITING
+        IDLE = 0,
         // This timer is waiting for the timeout interval to expire.
-        // Possible state transaitions: STOPPED, RESET, IDLE
-        WAITING = 2,
-        // The timeout interval has expired, so we are sleeping now.
-        // Possible state transaitions: STOPPED, RESET
-        IDLE = 3
+        // Possible state transitions: IDLE
+        WAITING = 1,
     };
 
-    // Function that loops until the condition for stopping is met.
-    void loop();
-
-    // Checks whether mResetTriggered and mStopTriggered were set and updates
-    // mState if so.
-    TimerState checkForResetAndStop(TimerState state);
-
-    // Thread waiting for timer to expire.
-    std::thread mThread;
+    // Called on the timer thread when the timer is due or woken up. Fires the callbacks
+    // and returns the CLOCK_MONOTONIC time at which to call it next, if any.
+    std::optional<nsecs_t> dispatch();
 
     // Clock object for the timer. Mocked in unit tests.
     std::unique_ptr<android::Clock> mClock;
 
-    // Semaphore to keep mThread synchronized.
-    sem_t mSemaphore;
-
     // Timer's name.
     std::string mName;
 
@@ -104,11 +97,18 @@ private:
     // Callback that happens when timer expires.
     const TimeoutCallback mTimeoutCallback;
 
-    // After removing lock guarding mState, the state can be now accessed at
-    // any time. Keep a bool if the reset or stop were requested, and occasionally
-    // check in the main loop if they were.
+    // Whether the timer is registered with the timer thread. Only accessed by the
+    // thread that starts and stops the timer.
+    bool mStarted = false;
+
+    // Only accessed on the timer thread while the timer is started.
+    TimerState mState = TimerState::IDLE;
+    std::chrono::steady_clock::time_point mTriggerTime;
+
+    // The state is not guarded by a lock, so that resetting the timer is cheap. Keep
+    // a bool if a reset was requested, and check it whenever the timer thread
+    // dispatches the timer.
     std::atomic<bool> mResetTriggered = false;
-    std::atomic<bool> mStopTriggered = false;
     std::atomic<bool> mWaiting = false;
     std::atomic<bool> mPaused = false;
     std::atomic<std::chrono::steady_clock::time_point> mLastResetTime;
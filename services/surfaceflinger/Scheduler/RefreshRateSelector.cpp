@@ -21,7 +21,9 @@
 #pragma clang diagnostic push
 #pragma clang diagnostic ignored "-Wextra"
 
+#include <algorithm>
 #include <chrono>
+#include <cinttypes>
 #include <cmath>
 #include <deque>
 #include <map>
@@ -33,6 +35,7 @@
 #include <ftl/fake_guard.h>
 #include <ftl/match.h>
 #include <ftl/unit.h>
+#include <math/HashCombine.h>
 #include <scheduler/FrameRateMode.h>
 
 #include "RefreshRateSelector.h"
@@ -481,14 +484,56 @@ auto RefreshRateSelector::getRankedFrameRates(const std::vector<LayerRequirement
     std::lock_guard lock(mLock);
 
     if (mGetRankedFrameRatesCache && mGetRankedFrameRatesCache->matches(cache)) {
+        mRankedFrameRatesHits++;
         return mGetRankedFrameRatesCache->result;
     }
 
-    cache.result = getRankedFrameRatesLocked(layers, signals, pacesetterFps);
+    const size_t hash = getRankedFrameRatesHash(cache);
+    const auto it = std::find_if(mRankedFrameRatesMemo.begin(), mRankedFrameRatesMemo.end(),
+                                 [&](const RankedFrameRatesMemo& memo) {
+                                     return memo.hash == hash && memo.entry.matches(cache);
+                                 });
+    if (it != mRankedFrameRatesMemo.end()) {
+        mRankedFrameRatesHits++;
+        cache.result = std::move(it->entry.result);
+        mRankedFrameRatesMemo.erase(it);
+    } else {
+        mRankedFrameRatesMisses++;
+        cache.result = getRankedFrameRatesLocked(layers, signals, pacesetterFps);
+    }
+
+    if (mGetRankedFrameRatesCache) {
+        mRankedFrameRatesMemo.push_front({getRankedFrameRatesHash(*mGetRankedFrameRatesCache),
+                                          std::move(*mGetRankedFrameRatesCache)});
+        if (mRankedFrameRatesMemo.size() > kRankedFrameRatesMemoSize) {
+            mRankedFrameRatesMemo.pop_back();
+        }
+    }
     mGetRankedFrameRatesCache = std::move(cache);
     return mGetRankedFrameRatesCache->result;
 }
 
+size_t RefreshRateSelector::getRankedFrameRatesHash(const GetRankedFrameRatesCache& cache) {
+    // Frame rates are compared approximately, so they are hashed at integer precision. Names are
+    // left out as they rarely tell votes apart, and matches() compares them anyway.
+    size_t hash = hashCombine(cache.signals.touch, cache.signals.idle,
+                              cache.signals.powerOnImminent, cache.pacesetterFps.getIntValue());
+    for (const auto& layer : cache.layers) {
+        hashCombineSingle(hash, layer.vote);
+        hashCombineSingle(hash, layer.desiredRefreshRate.getIntValue());
+        hashCombineSingle(hash, layer.seamlessness);
+        hashCombineSingle(hash, layer.weight);
+        hashCombineSingle(hash, layer.focused);
+        hashCombineSingle(hash, layer.frameRateCategory);
+    }
+    return hash;
+}
+
+void RefreshRateSelector::invalidateRankedFrameRatesLocked() {
+    mGetRankedFrameRatesCache.reset();
+    mRankedFrameRatesMemo.clear();
+}
+
 auto RefreshRateSelector::getRankedFrameRatesLocked(const std::vector<LayerRequirement>& layers,
                                                     GlobalSignals signals, Fps pacesetterFps) const
         -> RankedFrameRates {
@@ -1249,7 +1294,7 @@ void RefreshRateSelector::setActiveMode(DisplayModeId modeId, Fps renderFrameRat
 
     // Invalidate the cached invocation to getRankedFrameRates. This forces
     // the refresh rate to be recomputed on the next call to getRankedFrameRates.
-    mGetRankedFrameRatesCache.reset();
+    invalidateRankedFrameRatesLocked();
 
     const auto activeModeOpt = mDisplayModes.get(modeId);
     LOG_ALWAYS_FATAL_IF(!activeModeOpt);
@@ -1290,7 +1335,7 @@ void RefreshRateSelector::updateDisplayModes(DisplayModes modes, DisplayModeId a
 
     // Invalidate the cached invocation to getRankedFrameRates. This forces
     // the refresh rate to be recomputed on the next call to getRankedFrameRates.
-    mGetRankedFrameRatesCache.reset();
+    invalidateRankedFrameRatesLocked();
 
     mDisplayModes = std::move(modes);
     const auto activeModeOpt = mDisplayModes.get(activeModeId);
@@ -1390,7 +1435,7 @@ auto RefreshRateSelector::setPolicy(const PolicyVariant& policy) -> SetPolicyRes
             return SetPolicyResult::Invalid;
         }
 
-        mGetRankedFrameRatesCache.reset();
+        invalidateRankedFrameRatesLocked();
 
         const auto& idleScreenConfigOpt = getCurrentPolicyLocked()->idleScreenConfigOpt;
         if (idleScreenConfigOpt != oldPolicy.idleScreenConfigOpt) {
@@ -1616,6 +1661,14 @@ void RefreshRateSelector::dump(utils::Dumper& dumper) const {
 
     dumper.dump("frameRateOverrideConfig"sv, *ftl::enum_name(mFrameRateOverrideConfig));
 
+    const uint64_t lookups = mRankedFrameRatesHits + mRankedFrameRatesMisses;
+    dumper.dump("rankedFrameRatesCache"sv,
+                base::StringPrintf("%" PRIu64 " hits, %" PRIu64 " misses (%.1f%%)",
+                                   mRankedFrameRatesHits, mRankedFrameRatesMisses,
+                                   lookups ? 100.0 * static_cast<double>(mRankedFrameRatesHits) /
+                                                   static_cast<double>(lookups)
+                                           : 0.0));
+
     dumper.dump("idleTimer"sv);
     {
         utils::Dumper::Indent indent(dumper);
@@ -16,6 +16,7 @@
 
 #pragma once
 
+#include <deque>
 #include <type_traits>
 #include <utility>
 #include <variant>
@@ -581,6 +582,20 @@ private:
     };
     mutable std::optional<GetRankedFrameRatesCache> mGetRankedFrameRatesCache GUARDED_BY(mLock);
 
+    // Invocations of getRankedFrameRates before the cached one, most recent first, so that
+    // alternating inputs, e.g. while touch boost toggles, do not recompute the ranking.
+    struct RankedFrameRatesMemo {
+        size_t hash;
+        GetRankedFrameRatesCache entry;
+    };
+    static constexpr size_t kRankedFrameRatesMemoSize = 4;
+    mutable std::deque<RankedFrameRatesMemo> mRankedFrameRatesMemo GUARDED_BY(mLock);
+    mutable uint64_t mRankedFrameRatesHits GUARDED_BY(mLock) = 0;
+    mutable uint64_t mRankedFrameRatesMisses GUARDED_BY(mLock) = 0;
+
+    static size_t getRankedFrameRatesHash(const GetRankedFrameRatesCache&);
+    void invalidateRankedFrameRatesLocked() REQUIRES(mLock);
+
     // Declare mIdleTimer last to ensure its thread joins before the mutex/callbacks are destroyed.
     std::mutex mIdleTimerCallbacksMutex;
     std::optional<IdleTimerCallbacks> mIdleTimerCallbacks GUARDED_BY(mIdleTimerCallbacksMutex);
@@ -268,6 +268,10 @@ void Scheduler::onFrameSignal(ICompositor& compositor, VsyncId vsyncId,
         mPacesetterFrameDurationFractionToSkip = 0.f;
     }
 
+    // Composition runs right after commit on this thread, rather than being pipelined with the
+    // commit of the next frame: composite borrows the LayerSnapshots that commit builds, moving
+    // them into the CompositionRefreshArgs and back, and both stages read and update the same
+    // main thread state, e.g. the drawing state and the layers with queued frames.
     const auto resultsPerDisplay = compositor.composite(pacesetterPtr->displayId, targeters);
     if (FlagManager::getInstance().vrr_config()) {
         compositor.sendNotifyExpectedPresentHint(pacesetterPtr->displayId);
@@ -16,11 +16,10 @@
 
 #define ATRACE_TAG ATRACE_TAG_GRAPHICS
 
-#include <vector>
-
 #include <android-base/stringprintf.h>
 #include <common/trace.h>
 #include <ftl/concat.h>
+#include <ftl/small_vector.h>
 #include <log/log_main.h>
 
 #include <scheduler/TimeKeeper.h>
@@ -305,11 +304,12 @@ void VSyncDispatchTimerQueue::cancelTimer() {
     mTimeKeeper->alarmCancel();
 }
 
-void VSyncDispatchTimerQueue::setTimer(nsecs_t targetTime, nsecs_t /*now*/) {
+void VSyncDispatchTimerQueue::setTimer(nsecs_t targetTime, nsecs_t now) {
     mIntendedWakeupTime = targetTime;
     mTimeKeeper->alarmAt(std::bind(&VSyncDispatchTimerQueue::timerCallback, this),
                          mIntendedWakeupTime);
-    mLastTimerSchedule = mTimeKeeper->now();
+    // Reuse the caller's timestamp rather than reading the clock again while holding mMutex.
+    mLastTimerSchedule = now;
 }
 
 void VSyncDispatchTimerQueue::rearmTimer(nsecs_t now) {
@@ -358,7 +358,9 @@ void VSyncDispatchTimerQueue::timerCallback() {
         nsecs_t wakeupTimestamp;
         nsecs_t deadlineTimestamp;
     };
-    std::vector<Invocation> invocations;
+    // Sized like CallbackMap, so that collecting the invocations does not allocate while holding
+    // mMutex, which schedule() and cancel() contend on.
+    ftl::SmallVector<Invocation, 5> invocations;
     {
         std::lock_guard lock(mMutex);
         if (!mRunning) {
@@ -52,19 +52,56 @@ int numVsyncsPerFrame(const ftl::NonNull<DisplayModePtr>& displayModePtr) {
     return static_cast<int>(std::round(static_cast<float>(idealPeakRefreshPeriod) /
                                        static_cast<float>(idealRefreshPeriod)));
 }
+
+nsecs_t median(std::vector<nsecs_t>& values) {
+    const auto middle = values.begin() + static_cast<std::ptrdiff_t>(values.size() / 2);
+    std::nth_element(values.begin(), middle, values.end());
+    return *middle;
+}
+
+// Theil-Sen estimator of the model: the slope is the median of the slopes between every pair of
+// samples, and the intercept is the median of the residuals. Unlike least squares, a few samples
+// off the model, e.g. late HW vsync reports, do not skew the fit. The timestamps and the scaled
+// ordinals are expected as computed in addVsyncTimestamp, relative to the oldest timestamp.
+std::optional<VSyncPredictor::Model> fitTheilSen(const std::vector<nsecs_t>& vsyncTS,
+                                                 const std::vector<nsecs_t>& ordinals,
+                                                 int64_t scalingFactor) {
+    std::vector<nsecs_t> slopes;
+    slopes.reserve(vsyncTS.size() * (vsyncTS.size() - 1) / 2);
+    for (size_t i = 0; i < vsyncTS.size(); i++) {
+        for (size_t j = i + 1; j < vsyncTS.size(); j++) {
+            const auto ordinalDelta = ordinals[j] - ordinals[i];
+            if (ordinalDelta != 0) {
+                slopes.push_back((vsyncTS[j] - vsyncTS[i]) * scalingFactor / ordinalDelta);
+            }
+        }
+    }
+    if (slopes.empty()) {
+        return std::nullopt;
+    }
+
+    const nsecs_t slope = median(slopes);
+    std::vector<nsecs_t> intercepts(vsyncTS.size());
+    for (size_t i = 0; i < vsyncTS.size(); i++) {
+        intercepts[i] = vsyncTS[i] - slope * ordinals[i] / scalingFactor;
+    }
+    return VSyncPredictor::Model{slope, median(intercepts)};
+}
 } // namespace
 
 VSyncPredictor::~VSyncPredictor() = default;
 
 VSyncPredictor::VSyncPredictor(std::unique_ptr<Clock> clock, ftl::NonNull<DisplayModePtr> modePtr,
                                size_t historySize, size_t minimumSamplesForPrediction,
-                               uint32_t outlierTolerancePercent)
+                               uint32_t outlierTolerancePercent, bool adaptiveModel)
       : mClock(std::move(clock)),
         mId(modePtr->getPhysicalDisplayId()),
         mTraceOn(property_get_bool("debug.sf.vsp_trace", false)),
         kHistorySize(historySize),
         kMinimumSamplesForPrediction(minimumSamplesForPrediction),
         kOutlierTolerancePercent(std::min(outlierTolerancePercent, kMaxPercent)),
+        kMinimumSamplesForCachedModel(std::max<size_t>(2, minimumSamplesForPrediction / 2)),
+        mAdaptiveModel(adaptiveModel),
         mDisplayModePtr(modePtr),
         mNumVsyncsForFrame(numVsyncsPerFrame(mDisplayModePtr)) {
     resetModel();
@@ -181,7 +218,13 @@ bool VSyncPredictor::addVsyncTimestamp(nsecs_t timestamp) {
 
     const size_t numSamples = mTimestamps.size();
     if (numSamples < kMinimumSamplesForPrediction) {
-        mRateMap[idealPeriod()] = {idealPeriod(), 0};
+        if (hasCachedModelLocked()) {
+            // Keep the period learned the last time this mode was active while relearning the
+            // phase. The intercept is relative to the oldest timestamp, so it no longer applies.
+            mRateMap[idealPeriod()].intercept = 0;
+        } else {
+            mRateMap[idealPeriod()] = {idealPeriod(), 0};
+        }
         return true;
     }
 
@@ -227,33 +270,45 @@ bool VSyncPredictor::addVsyncTimestamp(nsecs_t timestamp) {
         meanOrdinal += ordinal;
     }
 
-    meanTS /= numSamples;
-    meanOrdinal /= numSamples;
+    std::optional<Model> fit;
+    if (mAdaptiveModel) {
+        fit = fitTheilSen(vsyncTS, ordinals, kScalingFactor);
+    } else {
+        meanTS /= numSamples;
+        meanOrdinal /= numSamples;
 
-    for (size_t i = 0; i < numSamples; i++) {
-        vsyncTS[i] -= meanTS;
-        ordinals[i] -= meanOrdinal;
-    }
+        for (size_t i = 0; i < numSamples; i++) {
+            vsyncTS[i] -= meanTS;
+            ordinals[i] -= meanOrdinal;
+        }
 
-    nsecs_t top = 0;
-    nsecs_t bottom = 0;
-    for (size_t i = 0; i < numSamples; i++) {
-        top += vsyncTS[i] * ordinals[i];
-        bottom += ordinals[i] * ordinals[i];
+        nsecs_t top = 0;
+        nsecs_t bottom = 0;
+        for (size_t i = 0; i < numSamples; i++) {
+            top += vsyncTS[i] * ordinals[i];
+            bottom += ordinals[i] * ordinals[i];
+        }
+
+        if (CC_LIKELY(bottom != 0)) {
+            nsecs_t const slope = top * kScalingFactor / bottom;
+            fit = Model{slope, meanTS - (slope * meanOrdinal / kScalingFactor)};
+        }
     }
 
-    if (CC_UNLIKELY(bottom == 0)) {
+    if (CC_UNLIKELY(!fit)) {
         it->second = {idealPeriod(), 0};
+        mCachedModelPeriods.erase(idealPeriod());
         clearTimestamps(/* clearTimelines */ true);
         return false;
     }
 
-    nsecs_t const anticipatedPeriod = top * kScalingFactor / bottom;
-    nsecs_t const intercept = meanTS - (anticipatedPeriod * meanOrdinal / kScalingFactor);
+    nsecs_t const anticipatedPeriod = fit->slope;
+    nsecs_t const intercept = fit->intercept;
 
     auto const percent = std::abs(anticipatedPeriod - idealPeriod()) * kMaxPercent / idealPeriod();
     if (percent >= kOutlierTolerancePercent) {
         it->second = {idealPeriod(), 0};
+        mCachedModelPeriods.erase(idealPeriod());
         clearTimestamps(/* clearTimelines */ true);
         return false;
     }
@@ -262,6 +317,9 @@ bool VSyncPredictor::addVsyncTimestamp(nsecs_t timestamp) {
     traceInt64If("VSP-intercept", intercept);
 
     it->second = {anticipatedPeriod, intercept};
+    if (mAdaptiveModel) {
+        mCachedModelPeriods.insert(idealPeriod());
+    }
 
     ALOGV("model update ts %" PRIu64 ": %" PRId64 " slope: %" PRId64 " intercept: %" PRId64,
           mId.value, timestamp, anticipatedPeriod, intercept);
@@ -443,6 +501,7 @@ void VSyncPredictor::setDisplayModePtr(ftl::NonNull<DisplayModePtr> modePtr) {
 
     static constexpr size_t kSizeLimit = 30;
     if (CC_UNLIKELY(mRateMap.size() == kSizeLimit)) {
+        mCachedModelPeriods.erase(mRateMap.begin()->first);
         mRateMap.erase(mRateMap.begin());
     }
 
@@ -610,13 +669,22 @@ void VSyncPredictor::clearTimestamps(bool clearTimelines) {
 
 bool VSyncPredictor::needsMoreSamples() const {
     std::lock_guard lock(mMutex);
-    return mTimestamps.size() < kMinimumSamplesForPrediction;
+    // With a period learned the last time this mode was active, only the phase needs to be found
+    // again.
+    const size_t minimumSamples =
+            hasCachedModelLocked() ? kMinimumSamplesForCachedModel : kMinimumSamplesForPrediction;
+    return mTimestamps.size() < minimumSamples;
+}
+
+bool VSyncPredictor::hasCachedModelLocked() const {
+    return mAdaptiveModel && mCachedModelPeriods.count(idealPeriod()) > 0;
 }
 
 void VSyncPredictor::resetModel() {
     SFTRACE_CALL();
     std::lock_guard lock(mMutex);
     mRateMap[idealPeriod()] = {idealPeriod(), 0};
+    mCachedModelPeriods.erase(idealPeriod());
     clearTimestamps(/* clearTimelines */ true);
 }
 
@@ -630,6 +698,8 @@ void VSyncPredictor::dump(std::string& result) const {
                       period / 1e6f, periodInterceptTuple.slope / 1e6f,
                       periodInterceptTuple.intercept);
     }
+    StringAppendF(&result, "\tAdaptive model: %s, %zu cached periods\n",
+                  mAdaptiveModel ? "true" : "false", mCachedModelPeriods.size());
     StringAppendF(&result, "\tmTimelines.size()=%zu\n", mTimelines.size());
 }
 
@@ -18,7 +18,9 @@
 
 #include <deque>
 #include <mutex>
+#include <optional>
 #include <unordered_map>
+#include <unordered_set>
 #include <vector>
 
 #include <android-base/thread_annotations.h>
@@ -40,9 +42,12 @@ public:
      * \param [in] minimumSamplesForPrediction The minimum number of samples to collect before
      * predicting. \param [in] outlierTolerancePercent a number 0 to 100 that will be used to filter
      * samples that fall outlierTolerancePercent from an anticipated vsync event.
+     * \param [in] adaptiveModel Fit the model with an estimator robust to outliers, and keep the
+     * period learned for each mode so that switching back to it needs fewer samples.
      */
     VSyncPredictor(std::unique_ptr<Clock>, ftl::NonNull<DisplayModePtr> modePtr, size_t historySize,
-                   size_t minimumSamplesForPrediction, uint32_t outlierTolerancePercent);
+                   size_t minimumSamplesForPrediction, uint32_t outlierTolerancePercent,
+                   bool adaptiveModel = false);
     ~VSyncPredictor();
 
     bool addVsyncTimestamp(nsecs_t timestamp) final EXCLUDES(mMutex);
@@ -144,11 +149,14 @@ private:
     void purgeTimelines(android::TimePoint now) REQUIRES(mMutex);
 
     nsecs_t idealPeriod() const REQUIRES(mMutex);
+    bool hasCachedModelLocked() const REQUIRES(mMutex);
 
     bool const mTraceOn;
     size_t const kHistorySize;
     size_t const kMinimumSamplesForPrediction;
     size_t const kOutlierTolerancePercent;
+    size_t const kMinimumSamplesForCachedModel;
+    bool const mAdaptiveModel;
     std::mutex mutable mMutex;
 
     std::optional<nsecs_t> mKnownTimestamp GUARDED_BY(mMutex);
@@ -156,6 +164,9 @@ private:
     // Map between ideal vsync period and the calculated model
     std::unordered_map<nsecs_t, Model> mutable mRateMap GUARDED_BY(mMutex);
 
+    // Ideal periods whose entry in mRateMap was learned from HW vsyncs, with the adaptive model.
+    std::unordered_set<nsecs_t> mCachedModelPeriods GUARDED_BY(mMutex);
+
     size_t mLastTimestampIndex GUARDED_BY(mMutex) = 0;
     std::vector<nsecs_t> mTimestamps GUARDED_BY(mMutex);
 
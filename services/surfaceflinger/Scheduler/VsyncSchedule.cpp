@@ -19,6 +19,7 @@
 #include <common/FlagManager.h>
 
 #include <common/trace.h>
+#include <cutils/properties.h>
 #include <ftl/fake_guard.h>
 #include <scheduler/Fps.h>
 #include <scheduler/Timer.h>
@@ -120,8 +121,11 @@ VsyncSchedule::TrackerPtr VsyncSchedule::createTracker(ftl::NonNull<DisplayModeP
     constexpr size_t kMinSamplesForPrediction = 6;
     constexpr uint32_t kDiscardOutlierPercent = 20;
 
+    static const bool kAdaptiveModel = property_get_bool("debug.sf.vsp_adaptive_model", false);
+
     return std::make_unique<VSyncPredictor>(std::make_unique<SystemClock>(), modePtr, kHistorySize,
-                                            kMinSamplesForPrediction, kDiscardOutlierPercent);
+                                            kMinSamplesForPrediction, kDiscardOutlierPercent,
+                                            kAdaptiveModel);
 }
 
 VsyncSchedule::DispatchPtr VsyncSchedule::createDispatch(TrackerPtr tracker) {
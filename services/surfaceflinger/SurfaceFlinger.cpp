@@ -27,6 +27,7 @@
 #include <aidl/android/hardware/power/Boost.h>
 #include <android-base/parseint.h>
 #include <android-base/properties.h>
+#include <android-base/scopeguard.h>
 #include <android-base/stringprintf.h>
 #include <android-base/strings.h>
 #include <android/configuration.h>
@@ -487,6 +488,13 @@ SurfaceFlinger::SurfaceFlinger(Factory& factory) : SurfaceFlinger(factory, SkipI
     mBackpressureGpuComposition = base::GetBoolProperty("debug.sf.enable_gl_backpressure"s, true);
     ALOGI_IF(mBackpressureGpuComposition, "Enabling backpressure for GPU composition");
 
+    mSnapshotParallelWorkers = base::GetUintProperty<size_t>("debug.sf.snapshot_parallel_workers"s, 0);
+    ALOGI_IF(mSnapshotParallelWorkers > 0, "Updating layer snapshots on %zu worker threads",
+             mSnapshotParallelWorkers);
+    mIncrementalSnapshotUpdates =
+            base::GetBoolProperty("debug.sf.incremental_snapshot_updates"s, false);
+    mParallelOutputPresent = base::GetBoolProperty("debug.sf.parallel_output_present"s, false);
+
     property_get("ro.surface_flinger.supports_background_blur", value, "0");
     bool supportsBlurs = atoi(value);
     mSupportsBlur = supportsBlurs;
@@ -498,6 +506,9 @@ SurfaceFlinger::SurfaceFlinger(Factory& factory) : SurfaceFlinger(factory, SkipI
     property_get("debug.sf.disable_client_composition_cache", value, "0");
     mDisableClientCompositionCache = atoi(value);
 
+    mPartialClientComposition =
+            base::GetBoolProperty("debug.sf.partial_client_composition"s, false);
+
     property_get("debug.sf.predict_hwc_composition_strategy", value, "1");
     mPredictCompositionStrategy = atoi(value);
 
@@ -871,6 +882,13 @@ void SurfaceFlinger::init() FTL_FAKE_GUARD(kMainThreadContext) {
     addTransactionReadyFilters();
     Mutex::Autolock lock(mStateLock);
 
+    // Connecting to the composer HAL, which may still be starting at boot, does not depend on
+    // RenderEngine, so overlap it with the creation of the RenderEngine context.
+    auto hwComposerFuture = std::async(std::launch::async, [this] {
+        SFTRACE_NAME("createHWComposer");
+        return getFactory().createHWComposer(mHwcServiceName);
+    });
+
     // Get a RenderEngine for the given display / config (can't fail)
     // TODO(b/77156734): We need to stop casting and use HAL types when possible.
     // Sending maxFrameBufferAcquiredBuffers as the cache size is tightly tuned to single-display.
@@ -897,7 +915,7 @@ void SurfaceFlinger::init() FTL_FAKE_GUARD(kMainThreadContext) {
 
     mCompositionEngine->setTimeStats(mTimeStats);
 
-    mCompositionEngine->setHwComposer(getFactory().createHWComposer(mHwcServiceName));
+    mCompositionEngine->setHwComposer(hwComposerFuture.get());
     auto& composer = mCompositionEngine->getHwComposer();
     composer.setCallback(*this);
     mDisplayModeController.setHwComposer(&composer);
@@ -912,6 +930,15 @@ void SurfaceFlinger::init() FTL_FAKE_GUARD(kMainThreadContext) {
     mAllowHwcForWFD = base::GetBoolProperty("vendor.display.vds_allow_hwc"s, false);
     mAllowHwcForVDS = mAllowHwcForWFD && base::GetBoolProperty("debug.sf.enable_hwc_vds"s, false);
     mFirstApiLevel = android::base::GetIntProperty("ro.product.first_api_level", 0);
+#ifndef QCOM_UM_FAMILY
+    // Let HWC write virtual displays straight into their sink buffers when it supports writeback,
+    // instead of always composing them with the GPU. Virtual displays still fall back to the GPU
+    // once the HWC virtual displays are exhausted or one fails to be created.
+    if (base::GetBoolProperty("debug.sf.enable_hwc_vds"s, false) &&
+        getHwComposer().getMaxVirtualDisplayCount() > 0) {
+        enableHalVirtualDisplays(true);
+    }
+#endif
 
     // Process hotplug for displays connected at boot.
     LOG_ALWAYS_FATAL_IF(!configureLocked(),
@@ -2369,6 +2396,12 @@ bool SurfaceFlinger::updateLayerSnapshots(VsyncId vsyncId, nsecs_t frameTimeNs,
     using Changes = frontend::RequestedLayerState::Changes;
     SFTRACE_CALL();
     frontend::Update update;
+    // Hand the transaction storage back for reuse once mStateLock has been released below, since
+    // destroying the composer states may drop the last reference to a layer handle.
+    const auto recycleTransactions = base::make_scope_guard([&]() {
+        ftl::FakeGuard guard(kMainThreadContext);
+        mTransactionHandler.recycleTransactions(std::move(update.transactions));
+    });
     if (flushTransactions) {
         SFTRACE_NAME("TransactionHandler:flushTransactions");
         // Locking:
@@ -2434,7 +2467,9 @@ bool SurfaceFlinger::updateLayerSnapshots(VsyncId vsyncId, nsecs_t frameTimeNs,
                              getHwComposer().getSupportedLayerGenericMetadata(),
                      .genericLayerMetadataKeyMap = getGenericLayerMetadataKeyMap(),
                      .skipRoundCornersWhenProtected =
-                             !getRenderEngine().supportsProtectedContent()};
+                             !getRenderEngine().supportsProtectedContent(),
+                     .parallelSubtreeWorkers = mSnapshotParallelWorkers,
+                     .incrementalUpdates = mIncrementalSnapshotUpdates};
         mLayerSnapshotBuilder.update(args);
     }
 
@@ -2451,6 +2486,12 @@ bool SurfaceFlinger::updateLayerSnapshots(VsyncId vsyncId, nsecs_t frameTimeNs,
         // FrameRate change (including when Hierarchy changes).
         mUpdateAttachedChoreographer = true;
     }
+    if (mFpsReporter &&
+        mLayerLifecycleManager.getGlobalChanges().any(Changes::Hierarchy | Changes::Metadata)) {
+        // Adding, removing and reparenting layers all change the Hierarchy, and the task of a
+        // layer is in its Metadata.
+        mFpsReporter->onHierarchyChanged();
+    }
     outTransactionsAreEmpty = mLayerLifecycleManager.getGlobalChanges().get() == 0;
     if (FlagManager::getInstance().vrr_bugfix_24q4()) {
         mustComposite |= mLayerLifecycleManager.getGlobalChanges().any(
@@ -2532,6 +2573,7 @@ bool SurfaceFlinger::updateLayerSnapshots(VsyncId vsyncId, nsecs_t frameTimeNs,
     for (auto& destroyedLayer : mLayerLifecycleManager.getDestroyedLayers()) {
         mLegacyLayers.erase(destroyedLayer->id);
     }
+    flushLayerTeardown();
 
     {
         SFTRACE_NAME("LLM:commitChanges");
@@ -2786,12 +2828,18 @@ CompositeResultsPerDisplay SurfaceFlinger::composite(
             : std::nullopt;
     refreshArgs.scheduledFrameTime = scheduledFrameTimeOpt;
     refreshArgs.hasTrustedPresentationListener = mNumTrustedPresentationListeners > 0;
+    // Outputs can only share RenderEngine across threads through its threaded queue.
+    refreshArgs.presentOutputsInParallel =
+            mParallelOutputPresent && getRenderEngine().isThreaded();
     // Store the present time just before calling to the composition engine so we could notify
     // the scheduler.
     const auto presentTime = systemTime();
 
     constexpr bool kCursorOnly = false;
     const auto layers = moveSnapshotsToCompositionArgs(refreshArgs, kCursorOnly);
+    if (mPowerHintSessionEnabled) {
+        mPowerAdvisor->setCompositionLayerCount(layers.size());
+    }
 
     if (!mVisibleRegionsDirty) {
         for (const auto& [token, display] : FTL_FAKE_GUARD(mStateLock, mDisplays)) {
@@ -2844,6 +2892,7 @@ CompositeResultsPerDisplay SurfaceFlinger::composite(
         }
 
         mCompositionEngine->present(refreshArgs);
+        recordLayerCompositionCosts(refreshArgs);
         moveSnapshotsFromCompositionArgs(refreshArgs, layers);
 
         for (auto& [layer, layerFE] : layers) {
@@ -2855,6 +2904,7 @@ CompositeResultsPerDisplay SurfaceFlinger::composite(
 
     } else {
         mCompositionEngine->present(refreshArgs);
+        recordLayerCompositionCosts(refreshArgs);
         moveSnapshotsFromCompositionArgs(refreshArgs, layers);
 
         for (auto [layer, layerFE] : layers) {
@@ -2938,6 +2988,7 @@ CompositeResultsPerDisplay SurfaceFlinger::composite(
 
     mLayersWithQueuedFrames.clear();
     mLayersIdsWithQueuedFrames.clear();
+    flushLayerTeardown();
     doActiveLayersTracingIfNeeded(true, mVisibleRegionsDirty, pacesetterTarget.frameBeginTime(),
                                   vsyncId);
 
@@ -3163,53 +3214,51 @@ void SurfaceFlinger::onCompositionPresented(PhysicalDisplayId pacesetterId,
         mAddingHDRLayerInfoListener = false;
     }
 
-    if (haveNewListeners || mHdrLayerInfoChanged) {
+    if ((haveNewListeners || mHdrLayerInfoChanged) && !hdrInfoListeners.empty()) {
+        // The HDR layers are looked up once and then matched against each display, rather than
+        // walking every visible snapshot for each display with listeners.
+        std::vector<std::pair<const frontend::LayerSnapshot*, sp<LayerFE>>> hdrLayers;
+        mLayerSnapshotBuilder.forEachVisibleSnapshot(
+                [&](std::unique_ptr<frontend::LayerSnapshot>& snapshot)
+                        FTL_FAKE_GUARD(kMainThreadContext) {
+                            if (!snapshot->isVisible || !isHdrLayer(*snapshot)) {
+                                return;
+                            }
+                            auto it = mLegacyLayers.find(snapshot->sequence);
+                            LLOG_ALWAYS_FATAL_WITH_TRACE_IF(it == mLegacyLayers.end(),
+                                                            "Couldnt find layer object for %s",
+                                                            snapshot->getDebugString().c_str());
+                            auto& legacyLayer = it->second;
+                            hdrLayers.emplace_back(snapshot.get(),
+                                                   legacyLayer->getCompositionEngineLayerFE(
+                                                           snapshot->path));
+                        });
+
         for (auto& [compositionDisplay, listener] : hdrInfoListeners) {
             HdrLayerInfoReporter::HdrLayerInfo info;
             int32_t maxArea = 0;
 
-            auto updateInfoFn =
-                    [&](const std::shared_ptr<compositionengine::Display>& compositionDisplay,
-                        const frontend::LayerSnapshot& snapshot, const sp<LayerFE>& layerFe) {
-                        if (snapshot.isVisible &&
-                            compositionDisplay->includesLayer(snapshot.outputFilter)) {
-                            if (isHdrLayer(snapshot)) {
-                                const auto* outputLayer =
-                                        compositionDisplay->getOutputLayerForLayer(layerFe);
-                                if (outputLayer) {
-                                    const float desiredHdrSdrRatio =
-                                            snapshot.desiredHdrSdrRatio < 1.f
-                                            ? std::numeric_limits<float>::infinity()
-                                            : snapshot.desiredHdrSdrRatio;
-                                    info.mergeDesiredRatio(desiredHdrSdrRatio);
-                                    info.numberOfHdrLayers++;
-                                    const auto displayFrame = outputLayer->getState().displayFrame;
-                                    const int32_t area =
-                                            displayFrame.width() * displayFrame.height();
-                                    if (area > maxArea) {
-                                        maxArea = area;
-                                        info.maxW = displayFrame.width();
-                                        info.maxH = displayFrame.height();
-                                    }
-                                }
-                            }
-                        }
-                    };
-
-            mLayerSnapshotBuilder.forEachVisibleSnapshot(
-                    [&, compositionDisplay = compositionDisplay](
-                            std::unique_ptr<frontend::LayerSnapshot>& snapshot)
-                            FTL_FAKE_GUARD(kMainThreadContext) {
-                                auto it = mLegacyLayers.find(snapshot->sequence);
-                                LLOG_ALWAYS_FATAL_WITH_TRACE_IF(it == mLegacyLayers.end(),
-                                                                "Couldnt find layer object for %s",
-                                                                snapshot->getDebugString().c_str());
-                                auto& legacyLayer = it->second;
-                                sp<LayerFE> layerFe =
-                                        legacyLayer->getCompositionEngineLayerFE(snapshot->path);
-
-                                updateInfoFn(compositionDisplay, *snapshot, layerFe);
-                            });
+            for (const auto& [snapshot, layerFe] : hdrLayers) {
+                if (!compositionDisplay->includesLayer(snapshot->outputFilter)) {
+                    continue;
+                }
+                const auto* outputLayer = compositionDisplay->getOutputLayerForLayer(layerFe);
+                if (!outputLayer) {
+                    continue;
+                }
+                const float desiredHdrSdrRatio = snapshot->desiredHdrSdrRatio < 1.f
+                        ? std::numeric_limits<float>::infinity()
+                        : snapshot->desiredHdrSdrRatio;
+                info.mergeDesiredRatio(desiredHdrSdrRatio);
+                info.numberOfHdrLayers++;
+                const auto displayFrame = outputLayer->getState().displayFrame;
+                const int32_t area = displayFrame.width() * displayFrame.height();
+                if (area > maxArea) {
+                    maxArea = area;
+                    info.maxW = displayFrame.width();
+                    info.maxH = displayFrame.height();
+                }
+            }
             listener->dispatchHdrLayerInfo(info);
         }
     }
@@ -4508,20 +4557,31 @@ TransactionHandler::TransactionReadiness SurfaceFlinger::transactionReadyBufferC
                     // barrier. This means the incoming buffer is older and we can release it here.
                     // We don't wait on the barrier since we know that's stale information.
                     if (layer->barrierProducerId > s.bufferData->producerId) {
-                        if (s.bufferData->releaseBufferListener) {
+                        if (s.bufferData->releaseBufferListener || layer->bufferReleaseChannel) {
                             uint32_t currentMaxAcquiredBufferCount =
                                     getMaxAcquiredBufferCountForCurrentRefreshRate(
                                             layer->ownerUid.val());
                             SFTRACE_FORMAT_INSTANT("callReleaseBufferCallback %s - %" PRIu64,
                                                    layer->name.c_str(), s.bufferData->frameNumber);
-                            s.bufferData->releaseBufferListener
-                                    ->onReleaseBuffer({resolvedState.externalTexture->getBuffer()
-                                                               ->getId(),
-                                                       s.bufferData->frameNumber},
-                                                      s.bufferData->acquireFence
-                                                              ? s.bufferData->acquireFence
-                                                              : Fence::NO_FENCE,
-                                                      currentMaxAcquiredBufferCount);
+                            const ReleaseCallbackId callbackId{resolvedState.externalTexture
+                                                                       ->getBuffer()
+                                                                       ->getId(),
+                                                               s.bufferData->frameNumber};
+                            const sp<Fence>& fence = s.bufferData->acquireFence
+                                    ? s.bufferData->acquireFence
+                                    : Fence::NO_FENCE;
+                            // As in Layer::callReleaseBufferCallback, prefer the release channel.
+                            if (!layer->bufferReleaseChannel ||
+                                layer->bufferReleaseChannel
+                                                ->writeReleaseFence(callbackId, fence,
+                                                                    currentMaxAcquiredBufferCount) !=
+                                        OK) {
+                                if (s.bufferData->releaseBufferListener) {
+                                    s.bufferData->releaseBufferListener
+                                            ->onReleaseBuffer(callbackId, fence,
+                                                              currentMaxAcquiredBufferCount);
+                                }
+                            }
                         }
 
                         // Delete the entire state at this point and not just release the buffer
@@ -4564,7 +4624,8 @@ TransactionHandler::TransactionReadiness SurfaceFlinger::transactionReadyBufferC
                         s.bufferData->flags.test(BufferData::BufferDataChange::fenceChanged) &&
                         s.bufferData->acquireFence;
                 const bool fenceSignaled = !acquireFenceAvailable ||
-                        s.bufferData->acquireFence->getStatus() != Fence::Status::Unsignaled;
+                        flushState.getAcquireFenceStatus(s.bufferData->acquireFence) !=
+                                Fence::Status::Unsignaled;
                 if (!fenceSignaled) {
                     // check fence status
                     const bool allowLatchUnsignaled =
@@ -4745,7 +4806,12 @@ status_t SurfaceFlinger::setTransactionState(
     }
 
     std::vector<ResolvedComposerState> resolvedStates;
-    resolvedStates.reserve(states.size());
+    {
+        // The recycled composer state storage has its own lock and does not need to be accessed
+        // from the main thread.
+        ftl::FakeGuard guard(kMainThreadContext);
+        resolvedStates = mTransactionHandler.acquireComposerStates(states.size());
+    }
     for (auto& state : states) {
         resolvedStates.emplace_back(std::move(state));
         auto& resolvedState = resolvedStates.back();
@@ -5539,13 +5605,15 @@ status_t SurfaceFlinger::doDump(int fd, const DumpArgs& args, bool asProto) {
         return NO_ERROR;
     }
 
-    // Collect debug data from main thread
+    // Collect debug data from main thread, and format it on this thread.
+    const VisibleFrontEndDump frontEndDump =
+            mScheduler
+                    ->schedule([&]() FTL_FAKE_GUARD(mStateLock) FTL_FAKE_GUARD(kMainThreadContext) {
+                        return copyVisibleFrontEnd();
+                    })
+                    .get();
     std::string compositionLayers;
-    mScheduler
-            ->schedule([&]() FTL_FAKE_GUARD(mStateLock) FTL_FAKE_GUARD(kMainThreadContext) {
-                dumpVisibleFrontEnd(compositionLayers);
-            })
-            .get();
+    dumpVisibleFrontEnd(frontEndDump, compositionLayers);
     // get window info listener data without the state lock
     auto windowInfosDebug = mWindowInfosListenerInvoker->getDebugInfo();
     compositionLayers.append("Window Infos:\n");
@@ -5793,36 +5861,48 @@ void SurfaceFlinger::dumpFrontEnd(std::string& result) {
     result.append(out.str());
 }
 
-void SurfaceFlinger::dumpVisibleFrontEnd(std::string& result) {
-    std::ostringstream out;
-    out << "\nComposition list\n";
-    ui::LayerStack lastPrintedLayerStackHeader = ui::INVALID_LAYER_STACK;
+auto SurfaceFlinger::copyVisibleFrontEnd() -> VisibleFrontEndDump {
+    VisibleFrontEndDump dump;
     mLayerSnapshotBuilder.forEachVisibleSnapshot(
             [&](std::unique_ptr<frontend::LayerSnapshot>& snapshot) {
                 if (snapshot->hasSomethingToDraw()) {
-                    if (lastPrintedLayerStackHeader != snapshot->outputFilter.layerStack) {
-                        lastPrintedLayerStackHeader = snapshot->outputFilter.layerStack;
-                        out << "LayerStack=" << lastPrintedLayerStackHeader.id << "\n";
-                    }
-                    out << "  " << *snapshot << "\n";
+                    dump.compositionSnapshots.push_back(*snapshot);
                 }
             });
-
-    out << "\nInput list\n";
-    lastPrintedLayerStackHeader = ui::INVALID_LAYER_STACK;
     mLayerSnapshotBuilder.forEachInputSnapshot([&](const frontend::LayerSnapshot& snapshot) {
-        if (lastPrintedLayerStackHeader != snapshot.outputFilter.layerStack) {
-            lastPrintedLayerStackHeader = snapshot.outputFilter.layerStack;
-            out << "LayerStack=" << lastPrintedLayerStackHeader.id << "\n";
-        }
-        out << "  " << snapshot << "\n";
+        dump.inputSnapshots.push_back(snapshot);
     });
 
+    // The hierarchy refers to the requested layer states, so it is formatted in place.
+    std::ostringstream out;
     out << "\nLayer Hierarchy\n"
         << mLayerHierarchyBuilder.getHierarchy() << "\nOffscreen Hierarchy\n"
         << mLayerHierarchyBuilder.getOffscreenHierarchy() << "\n\n";
+    dump.hierarchy = out.str();
+    dumpHwcLayersMinidump(dump.hierarchy);
+    return dump;
+}
+
+void SurfaceFlinger::dumpVisibleFrontEnd(const VisibleFrontEndDump& dump, std::string& result) {
+    const auto dumpSnapshots = [](std::ostringstream& out,
+                                  const std::vector<frontend::LayerSnapshot>& snapshots) {
+        ui::LayerStack lastPrintedLayerStackHeader = ui::INVALID_LAYER_STACK;
+        for (const auto& snapshot : snapshots) {
+            if (lastPrintedLayerStackHeader != snapshot.outputFilter.layerStack) {
+                lastPrintedLayerStackHeader = snapshot.outputFilter.layerStack;
+                out << "LayerStack=" << lastPrintedLayerStackHeader.id << "\n";
+            }
+            out << "  " << snapshot << "\n";
+        }
+    };
+
+    std::ostringstream out;
+    out << "\nComposition list\n";
+    dumpSnapshots(out, dump.compositionSnapshots);
+    out << "\nInput list\n";
+    dumpSnapshots(out, dump.inputSnapshots);
     result = out.str();
-    dumpHwcLayersMinidump(result);
+    result.append(dump.hierarchy);
 }
 
 perfetto::protos::LayersProto SurfaceFlinger::dumpDrawingStateProto(uint32_t traceFlags) const {
@@ -5996,6 +6076,12 @@ void SurfaceFlinger::dumpAll(const DumpArgs& args, const std::string& compositio
 
     result.append("ClientCache state:\n");
     ClientCache::getInstance().dump(result);
+    {
+        // The allocation stats have their own lock and do not need to be read from the main thread.
+        ftl::FakeGuard guard(kMainThreadContext);
+        mTransactionHandler.dumpAllocationStats(result);
+    }
+    BackgroundExecutor::dumpAll(result);
     DebugEGLImageTracker::getInstance()->dump(result);
 
     if (const auto display = getDefaultDisplayDeviceLocked()) {
@@ -7241,28 +7327,11 @@ void SurfaceFlinger::captureScreenCommon(RenderAreaBuilderVariant renderAreaBuil
             hasProtectedLayer = layersHasProtectedLayer(layerFEs);
         }
         const bool isProtected = hasProtectedLayer && allowProtected && supportsProtected;
-        const uint32_t usage = GRALLOC_USAGE_HW_COMPOSER | GRALLOC_USAGE_HW_RENDER |
-                GRALLOC_USAGE_HW_TEXTURE |
-                (isProtected ? GRALLOC_USAGE_PROTECTED
-                             : GRALLOC_USAGE_SW_READ_OFTEN | GRALLOC_USAGE_SW_WRITE_OFTEN);
-        sp<GraphicBuffer> buffer =
-                getFactory().createGraphicBuffer(bufferSize.getWidth(), bufferSize.getHeight(),
-                                                 static_cast<android_pixel_format>(reqPixelFormat),
-                                                 1 /* layerCount */, usage, "screenshot");
-
-        const status_t bufferStatus = buffer->initCheck();
-        if (bufferStatus != OK) {
-            // Animations may end up being really janky, but don't crash here.
-            // Otherwise an irreponsible process may cause an SF crash by allocating
-            // too much.
-            ALOGE("%s: Buffer failed to allocate: %d", __func__, bufferStatus);
-            invokeScreenCaptureError(bufferStatus, captureListener);
+        const std::shared_ptr<renderengine::ExternalTexture> texture =
+                createScreenshotTexture(bufferSize, reqPixelFormat, isProtected, captureListener);
+        if (!texture) {
             return;
         }
-        const std::shared_ptr<renderengine::ExternalTexture> texture = std::make_shared<
-                renderengine::impl::ExternalTexture>(buffer, getRenderEngine(),
-                                                     renderengine::impl::ExternalTexture::Usage::
-                                                             WRITEABLE);
         auto futureFence = captureScreenshot(renderAreaBuilder, texture, false /* regionSampling */,
                                              grayscale, isProtected, attachGainmap, captureListener,
                                              displayState, layerFEs);
@@ -7276,28 +7345,11 @@ void SurfaceFlinger::captureScreenCommon(RenderAreaBuilderVariant renderAreaBuil
             hasProtectedLayer = layersHasProtectedLayer(extractLayerFEs(layers));
         }
         const bool isProtected = hasProtectedLayer && allowProtected && supportsProtected;
-        const uint32_t usage = GRALLOC_USAGE_HW_COMPOSER | GRALLOC_USAGE_HW_RENDER |
-                GRALLOC_USAGE_HW_TEXTURE |
-                (isProtected ? GRALLOC_USAGE_PROTECTED
-                             : GRALLOC_USAGE_SW_READ_OFTEN | GRALLOC_USAGE_SW_WRITE_OFTEN);
-        sp<GraphicBuffer> buffer =
-                getFactory().createGraphicBuffer(bufferSize.getWidth(), bufferSize.getHeight(),
-                                                 static_cast<android_pixel_format>(reqPixelFormat),
-                                                 1 /* layerCount */, usage, "screenshot");
-
-        const status_t bufferStatus = buffer->initCheck();
-        if (bufferStatus != OK) {
-            // Animations may end up being really janky, but don't crash here.
-            // Otherwise an irreponsible process may cause an SF crash by allocating
-            // too much.
-            ALOGE("%s: Buffer failed to allocate: %d", __func__, bufferStatus);
-            invokeScreenCaptureError(bufferStatus, captureListener);
+        const std::shared_ptr<renderengine::ExternalTexture> texture =
+                createScreenshotTexture(bufferSize, reqPixelFormat, isProtected, captureListener);
+        if (!texture) {
             return;
         }
-        const std::shared_ptr<renderengine::ExternalTexture> texture = std::make_shared<
-                renderengine::impl::ExternalTexture>(buffer, getRenderEngine(),
-                                                     renderengine::impl::ExternalTexture::Usage::
-                                                             WRITEABLE);
         auto futureFence = captureScreenshotLegacy(renderAreaBuilder, getLayerSnapshotsFn, texture,
                                                    false /* regionSampling */, grayscale,
                                                    isProtected, attachGainmap, captureListener);
@@ -7305,6 +7357,33 @@ void SurfaceFlinger::captureScreenCommon(RenderAreaBuilderVariant renderAreaBuil
     }
 }
 
+std::shared_ptr<renderengine::ExternalTexture> SurfaceFlinger::createScreenshotTexture(
+        ui::Size bufferSize, ui::PixelFormat reqPixelFormat, bool isProtected,
+        const sp<IScreenCaptureListener>& captureListener) {
+    const uint32_t usage = GRALLOC_USAGE_HW_COMPOSER | GRALLOC_USAGE_HW_RENDER |
+            GRALLOC_USAGE_HW_TEXTURE |
+            (isProtected ? GRALLOC_USAGE_PROTECTED
+                         : GRALLOC_USAGE_SW_READ_OFTEN | GRALLOC_USAGE_SW_WRITE_OFTEN);
+    sp<GraphicBuffer> buffer =
+            getFactory().createGraphicBuffer(bufferSize.getWidth(), bufferSize.getHeight(),
+                                             static_cast<android_pixel_format>(reqPixelFormat),
+                                             1 /* layerCount */, usage, "screenshot");
+
+    const status_t bufferStatus = buffer->initCheck();
+    if (bufferStatus != OK) {
+        // Animations may end up being really janky, but don't crash here.
+        // Otherwise an irreponsible process may cause an SF crash by allocating
+        // too much.
+        ALOGE("%s: Buffer failed to allocate: %d", __func__, bufferStatus);
+        invokeScreenCaptureError(bufferStatus, captureListener);
+        return nullptr;
+    }
+    return std::make_shared<
+            renderengine::impl::ExternalTexture>(buffer, getRenderEngine(),
+                                                 renderengine::impl::ExternalTexture::Usage::
+                                                         WRITEABLE);
+}
+
 std::optional<SurfaceFlinger::OutputCompositionState>
 SurfaceFlinger::getDisplayStateFromRenderAreaBuilder(RenderAreaBuilderVariant& renderAreaBuilder) {
     sp<const DisplayDevice> display = nullptr;
@@ -7921,6 +8000,31 @@ void SurfaceFlinger::onLayerDestroyed(Layer* layer) {
     mScheduler->onLayerDestroyed(layer);
 }
 
+void SurfaceFlinger::deferLayerTeardown(std::function<void()>&& teardown) {
+    // The buffers may only be unmapped from RenderEngine's own thread without a threaded
+    // RenderEngine, which is the main thread.
+    if (!mRenderEngine || !mRenderEngine->isThreaded()) {
+        teardown();
+        return;
+    }
+
+    // Bounds the resources that wait for the next flush, if many layers die outside of a frame.
+    constexpr size_t kMaxLayerTeardownBatchSize = 64;
+    mLayerTeardown.push_back(std::move(teardown));
+    if (mLayerTeardown.size() >= kMaxLayerTeardownBatchSize) {
+        flushLayerTeardown();
+    }
+}
+
+void SurfaceFlinger::flushLayerTeardown() {
+    if (mLayerTeardown.empty()) {
+        return;
+    }
+    SFTRACE_FORMAT("%s (%zu layers)", __func__, mLayerTeardown.size());
+    BackgroundExecutor::getInstance(BackgroundExecutor::Lane::Teardown)
+            .sendCallbacks(std::exchange(mLayerTeardown, {}));
+}
+
 void SurfaceFlinger::onLayerUpdate() {
     scheduleCommit(FrameHint::kActive);
 }
@@ -8243,6 +8347,28 @@ void SurfaceFlinger::moveSnapshotsFromCompositionArgs(
     }
 }
 
+void SurfaceFlinger::recordLayerCompositionCosts(
+        const compositionengine::CompositionRefreshArgs& refreshArgs) {
+    if (!mTimeStats->isEnabled()) return;
+
+    std::vector<TimeStats::LayerCompositionCost> costs;
+    for (const auto& output : refreshArgs.outputs) {
+        for (const auto* outputLayer : output->getOutputLayersOrderedByZ()) {
+            const auto& layerFE = outputLayer->getLayerFE();
+            const auto* state = layerFE.getCompositionState();
+            uint64_t bufferBytes = 0;
+            if (state && state->buffer) {
+                bufferBytes = static_cast<uint64_t>(state->buffer->getStride()) *
+                        state->buffer->getHeight() * bytesPerPixel(state->buffer->getPixelFormat());
+            }
+            costs.push_back({.layerId = layerFE.getSequence(),
+                             .clientComposition = outputLayer->requiresClientComposition(),
+                             .bufferBytes = bufferBytes});
+        }
+    }
+    mTimeStats->recordLayerCompositionCosts(costs);
+}
+
 std::vector<std::pair<Layer*, LayerFE*>> SurfaceFlinger::moveSnapshotsToCompositionArgs(
         compositionengine::CompositionRefreshArgs& refreshArgs, bool cursorOnly) {
     std::vector<std::pair<Layer*, LayerFE*>> layers;
@@ -9318,7 +9444,8 @@ binder::Status SurfaceComposerAIDL::addJankListener(const sp<IBinder>& layerHand
     if (layer == nullptr) {
         return binder::Status::fromExceptionCode(binder::Status::EX_NULL_POINTER);
     }
-    JankTracker::addJankListener(layer->sequence, IInterface::asBinder(listener));
+    JankTracker::addJankListener(layer->sequence, IInterface::asBinder(listener),
+                                 IPCThreadState::self()->getCallingPid());
     return binder::Status::ok();
 }
 
@@ -9334,6 +9461,22 @@ binder::Status SurfaceComposerAIDL::removeJankListener(int32_t layerId,
     return binder::Status::ok();
 }
 
+binder::Status SurfaceComposerAIDL::openJankDataChannel(
+        const sp<gui::IJankListener>& listener,
+        std::optional<os::ParcelFileDescriptor>* outChannel) {
+    if (listener == nullptr) {
+        return binder::Status::fromExceptionCode(binder::Status::EX_NULL_POINTER);
+    }
+    const pid_t pid = IPCThreadState::self()->getCallingPid();
+    if (base::unique_fd fd = JankTracker::openJankDataChannel(pid, IInterface::asBinder(listener));
+        fd.ok()) {
+        outChannel->emplace(std::move(fd));
+    } else {
+        outChannel->reset();
+    }
+    return binder::Status::ok();
+}
+
 status_t SurfaceComposerAIDL::checkAccessPermission(bool usePermissionCache) {
     if (!mFlinger->callingThreadHasUnscopedSurfaceFlingerAccess(usePermissionCache)) {
         IPCThreadState* ipc = IPCThreadState::self();
@@ -66,6 +66,7 @@
 #include <ui/FenceResult.h>
 
 #include <common/FlagManager.h>
+#include "BackgroundExecutor.h"
 #include "Display/DisplayModeController.h"
 #include "Display/PhysicalDisplay.h"
 #include "DisplayDevice.h"
@@ -291,6 +292,12 @@ public:
 
     void onLayerFirstRef(Layer*);
     void onLayerDestroyed(Layer*);
+
+    // Queues the destruction of the resources that a destroyed layer held, such as its buffers,
+    // to run on the Teardown lane of BackgroundExecutor, in a batch with those of the other layers
+    // destroyed in the same frame.
+    void deferLayerTeardown(std::function<void()>&& teardown) REQUIRES(kMainThreadContext);
+    void flushLayerTeardown() REQUIRES(kMainThreadContext);
     void onLayerUpdate();
 
     // Called when all clients have released all their references to
@@ -306,6 +313,10 @@ public:
     // debug.sf.disable_client_composition_cache
     bool mDisableClientCompositionCache = false;
 
+    // If set, client composition only redraws what changed since the buffer was last rendered
+    // into. This can be set by debug.sf.partial_client_composition
+    bool mPartialClientComposition = false;
+
     // Disables expensive rendering for all displays
     // This is scheduled on the main thread
     void disableExpensiveRendering();
@@ -755,6 +766,10 @@ private:
     void moveSnapshotsFromCompositionArgs(compositionengine::CompositionRefreshArgs& refreshArgs,
                                           const std::vector<std::pair<Layer*, LayerFE*>>& layers)
             REQUIRES(kMainThreadContext);
+    // Reports how each layer was composited to TimeStats. Must be called before the snapshots are
+    // moved back from the composition args.
+    void recordLayerCompositionCosts(const compositionengine::CompositionRefreshArgs& refreshArgs)
+            REQUIRES(kMainThreadContext);
     // Return true if we must composite this frame
     bool updateLayerSnapshots(VsyncId vsyncId, nsecs_t frameTimeNs, bool transactionsFlushed,
                               bool& out) REQUIRES(kMainThreadContext);
@@ -863,6 +878,12 @@ private:
                              ui::Size bufferSize, ui::PixelFormat, bool allowProtected,
                              bool grayscale, bool attachGainmap, const sp<IScreenCaptureListener>&);
 
+    // Allocates the buffer a screenshot is rendered into, at the requested size. Returns nullptr
+    // and reports the error to the listener if the allocation fails.
+    std::shared_ptr<renderengine::ExternalTexture> createScreenshotTexture(
+            ui::Size bufferSize, ui::PixelFormat, bool isProtected,
+            const sp<IScreenCaptureListener>&);
+
     std::optional<OutputCompositionState> getDisplayStateFromRenderAreaBuilder(
             RenderAreaBuilderVariant& renderAreaBuilder) REQUIRES(kMainThreadContext);
 
@@ -1126,7 +1147,17 @@ private:
     void dumpWideColorInfo(std::string& result) const REQUIRES(mStateLock);
     void dumpHdrInfo(std::string& result) const REQUIRES(mStateLock);
     void dumpFrontEnd(std::string& result) REQUIRES(kMainThreadContext);
-    void dumpVisibleFrontEnd(std::string& result) REQUIRES(mStateLock, kMainThreadContext);
+
+    // Front end state copied on the main thread, so that the dumping thread formats it without
+    // stalling composition.
+    struct VisibleFrontEndDump {
+        std::vector<frontend::LayerSnapshot> compositionSnapshots;
+        std::vector<frontend::LayerSnapshot> inputSnapshots;
+        std::string hierarchy;
+    };
+
+    VisibleFrontEndDump copyVisibleFrontEnd() REQUIRES(mStateLock, kMainThreadContext);
+    static void dumpVisibleFrontEnd(const VisibleFrontEndDump&, std::string& result);
 
     perfetto::protos::LayersProto dumpDrawingStateProto(uint32_t traceFlags) const
             REQUIRES(kMainThreadContext);
@@ -1300,6 +1331,13 @@ private:
 
     bool mLayerCachingEnabled = false;
     bool mBackpressureGpuComposition = false;
+    // Number of threads used to update independent layer subtrees in parallel. Zero disables
+    // parallel snapshot updates.
+    size_t mSnapshotParallelWorkers = 0;
+    // If set, snapshot updates skip layer subtrees that are not affected by any changes.
+    bool mIncrementalSnapshotUpdates = false;
+    // If set, outputs that do not share layers are presented concurrently.
+    bool mParallelOutputPresent = false;
 
     LayerTracing mLayerTracing;
     std::optional<TransactionTracing> mTransactionTracing;
@@ -1441,6 +1479,7 @@ private:
     // These classes do not store any client state but help with managing transaction callbacks
     // and stats.
     std::unordered_map<uint32_t, sp<Layer>> mLegacyLayers GUARDED_BY(kMainThreadContext);
+    BackgroundExecutor::Callbacks mLayerTeardown GUARDED_BY(kMainThreadContext);
 
     TransactionHandler mTransactionHandler GUARDED_BY(kMainThreadContext);
     ui::DisplayMap<ui::LayerStack, frontend::DisplayInfo> mFrontEndDisplayInfos
@@ -1620,6 +1659,9 @@ public:
     binder::Status flushJankData(int32_t layerId) override;
     binder::Status removeJankListener(int32_t layerId, const sp<gui::IJankListener>& listener,
                                       int64_t afterVsync) override;
+    binder::Status openJankDataChannel(
+            const sp<gui::IJankListener>& listener,
+            std::optional<os::ParcelFileDescriptor>* outChannel) override;
 
 private:
     static const constexpr bool kUsePermissionCache = true;
@@ -25,6 +25,8 @@
 #include <utils/String8.h>
 #include <utils/Timers.h>
 
+#include <pthread.h>
+
 #include <algorithm>
 #include <chrono>
 #include <cmath>
@@ -93,6 +95,7 @@ SurfaceflingerStatsLayerInfo_SetFrameRateVote frameRateVoteToProto(
 
 bool TimeStats::populateGlobalAtom(std::vector<uint8_t>* pulledData) {
     std::lock_guard<std::mutex> lock(mMutex);
+    applyPendingEventsLocked();
 
     if (mTimeStats.statsStartLegacy == 0) {
         return false;
@@ -146,6 +149,7 @@ bool TimeStats::populateGlobalAtom(std::vector<uint8_t>* pulledData) {
 
 bool TimeStats::populateLayerAtom(std::vector<uint8_t>* pulledData) {
     std::lock_guard<std::mutex> lock(mMutex);
+    applyPendingEventsLocked();
 
     std::vector<TimeStatsHelper::TimeStatsLayer*> dumpStats;
     uint32_t numLayers = 0;
@@ -253,6 +257,69 @@ TimeStats::TimeStats(std::optional<size_t> maxPulledLayers,
     if (maxPulledHistogramBuckets) {
         mMaxPulledHistogramBuckets = *maxPulledHistogramBuckets;
     }
+
+    mAggregatorThread = std::thread(&TimeStats::aggregatorMain, this);
+    pthread_setname_np(mAggregatorThread.native_handle(), "TimeStats");
+}
+
+TimeStats::~TimeStats() {
+    {
+        std::lock_guard<std::mutex> lock(mAggregatorMutex);
+        mAggregatorDone = true;
+    }
+    mAggregatorCondition.notify_one();
+    mAggregatorThread.join();
+}
+
+void TimeStats::pushEvent(Event&& event) {
+    mPendingEvents.push(std::move(event));
+
+    // Only the first event since the aggregator last ran wakes it up. An event that races with the
+    // aggregator clearing the flag is applied with the next batch, or before the stats are read.
+    if (mAggregationPending.load(std::memory_order_relaxed) || mAggregationPending.exchange(true)) {
+        return;
+    }
+    {
+        // Taken so that the notification cannot fall between the aggregator checking the flag
+        // and starting to wait.
+        std::lock_guard<std::mutex> lock(mAggregatorMutex);
+    }
+    mAggregatorCondition.notify_one();
+}
+
+void TimeStats::aggregatorMain() {
+    // Long enough for the events of a frame to be applied in one batch.
+    constexpr auto kAggregationDelay = std::chrono::milliseconds(10);
+
+    while (true) {
+        {
+            std::unique_lock<std::mutex> lock(mAggregatorMutex);
+            mAggregatorCondition.wait(lock, [this] {
+                return mAggregatorDone || mAggregationPending.load();
+            });
+            // Waits on the condition rather than sleeping so that destruction is not held up.
+            if (mAggregatorCondition.wait_for(lock, kAggregationDelay,
+                                              [this] { return mAggregatorDone; })) {
+                return;
+            }
+        }
+
+        mAggregationPending.store(false);
+
+        std::lock_guard<std::mutex> lock(mMutex);
+        applyPendingEventsLocked();
+    }
+}
+
+void TimeStats::applyPendingEventsLocked() {
+    mPendingEvents.popAll(mAppliedEvents);
+    if (mAppliedEvents.empty()) return;
+
+    SFTRACE_CALL();
+    for (const Event& event : mAppliedEvents) {
+        std::visit([this](const auto& e) { applyEventLocked(e); }, event);
+    }
+    mAppliedEvents.clear();
 }
 
 bool TimeStats::onPullAtom(const int atomId, std::vector<uint8_t>* pulledData) {
@@ -308,6 +375,7 @@ std::string TimeStats::miniDump() {
 
     std::string result = "TimeStats miniDump:\n";
     std::lock_guard<std::mutex> lock(mMutex);
+    applyPendingEventsLocked();
     android::base::StringAppendF(&result, "Number of layers currently being tracked is %zu\n",
                                  mTimeStatsTracker.size());
     android::base::StringAppendF(&result, "Number of layers in the stats pool is %zu\n",
@@ -319,18 +387,28 @@ void TimeStats::incrementTotalFrames() {
     if (!mEnabled.load()) return;
 
     SFTRACE_CALL();
-
-    std::lock_guard<std::mutex> lock(mMutex);
-    mTimeStats.totalFramesLegacy++;
+    pushEvent(GlobalCounterEvent{GlobalCounterEvent::Counter::TotalFrames});
 }
 
 void TimeStats::incrementMissedFrames() {
     if (!mEnabled.load()) return;
 
     SFTRACE_CALL();
+    pushEvent(GlobalCounterEvent{GlobalCounterEvent::Counter::MissedFrames});
+}
 
-    std::lock_guard<std::mutex> lock(mMutex);
-    mTimeStats.missedFramesLegacy++;
+void TimeStats::applyEventLocked(const GlobalCounterEvent& event) {
+    switch (event.counter) {
+        case GlobalCounterEvent::Counter::TotalFrames:
+            mTimeStats.totalFramesLegacy++;
+            break;
+        case GlobalCounterEvent::Counter::MissedFrames:
+            mTimeStats.missedFramesLegacy++;
+            break;
+        case GlobalCounterEvent::Counter::RefreshRateSwitches:
+            mTimeStats.refreshRateSwitchesLegacy++;
+            break;
+    }
 }
 
 void TimeStats::pushCompositionStrategyState(const TimeStats::ClientCompositionRecord& record) {
@@ -339,8 +417,10 @@ void TimeStats::pushCompositionStrategyState(const TimeStats::ClientCompositionR
     }
 
     SFTRACE_CALL();
+    pushEvent(record);
+}
 
-    std::lock_guard<std::mutex> lock(mMutex);
+void TimeStats::applyEventLocked(const ClientCompositionRecord& record) {
     if (record.changed) mTimeStats.compositionStrategyChangesLegacy++;
     if (record.hadClientComposition) mTimeStats.clientCompositionFramesLegacy++;
     if (record.reused) mTimeStats.clientCompositionReusedFramesLegacy++;
@@ -348,13 +428,48 @@ void TimeStats::pushCompositionStrategyState(const TimeStats::ClientCompositionR
     if (record.predictionSucceeded) mTimeStats.compositionStrategyPredictionSucceededLegacy++;
 }
 
-void TimeStats::incrementRefreshRateSwitches() {
+void TimeStats::recordLayerCompositionCosts(const std::vector<LayerCompositionCost>& costs) {
     if (!mEnabled.load()) return;
 
     SFTRACE_CALL();
+    pushEvent(costs);
+}
 
-    std::lock_guard<std::mutex> lock(mMutex);
-    mTimeStats.refreshRateSwitchesLegacy++;
+void TimeStats::applyEventLocked(const LayerCompositionCosts& costs) {
+    std::vector<int32_t> clientLayerIds;
+    for (const auto& cost : costs) {
+        // Layers that aren't tracked, e.g. color layers, still take their share of RenderEngine.
+        if (cost.clientComposition) {
+            clientLayerIds.push_back(cost.layerId);
+        }
+        const auto it = mTimeStatsTracker.find(cost.layerId);
+        if (it == mTimeStatsTracker.end()) continue;
+        LayerRecord& layerRecord = it->second;
+
+        if (cost.clientComposition) {
+            layerRecord.clientCompositionFrames++;
+        } else {
+            layerRecord.deviceCompositionFrames++;
+        }
+        constexpr uint64_t kBytesPerMiB = 1024 * 1024;
+        layerRecord.bufferReadMiB.insert(static_cast<int32_t>(
+                std::min<uint64_t>((cost.bufferBytes + kBytesPerMiB / 2) / kBytesPerMiB,
+                                   INT32_MAX)));
+    }
+
+    // The RenderEngine durations recorded since the last call belong to this frame.
+    for (auto it = mGlobalRecord.renderEngineDurations.rbegin();
+         it != mGlobalRecord.renderEngineDurations.rend() && !it->attributed; ++it) {
+        it->clientLayerIds = clientLayerIds;
+        it->attributed = true;
+    }
+}
+
+void TimeStats::incrementRefreshRateSwitches() {
+    if (!mEnabled.load()) return;
+
+    SFTRACE_CALL();
+    pushEvent(GlobalCounterEvent{GlobalCounterEvent::Counter::RefreshRateSwitches});
 }
 
 static int32_t toMs(nsecs_t nanos) {
@@ -372,33 +487,34 @@ static int32_t msBetween(nsecs_t start, nsecs_t end) {
 void TimeStats::recordFrameDuration(nsecs_t startTime, nsecs_t endTime) {
     if (!mEnabled.load()) return;
 
-    std::lock_guard<std::mutex> lock(mMutex);
+    pushEvent(FrameDurationEvent{startTime, endTime});
+}
+
+void TimeStats::applyEventLocked(const FrameDurationEvent& event) {
     if (mPowerTime.powerMode == PowerMode::ON) {
-        mTimeStats.frameDurationLegacy.insert(msBetween(startTime, endTime));
+        mTimeStats.frameDurationLegacy.insert(msBetween(event.startTime, event.endTime));
     }
 }
 
 void TimeStats::recordRenderEngineDuration(nsecs_t startTime, nsecs_t endTime) {
     if (!mEnabled.load()) return;
 
-    std::lock_guard<std::mutex> lock(mMutex);
-    if (mGlobalRecord.renderEngineDurations.size() == MAX_NUM_TIME_RECORDS) {
-        ALOGE("RenderEngineTimes are already at its maximum size[%zu]", MAX_NUM_TIME_RECORDS);
-        mGlobalRecord.renderEngineDurations.pop_front();
-    }
-    mGlobalRecord.renderEngineDurations.push_back({startTime, endTime});
+    pushEvent(RenderEngineDuration{startTime, endTime});
 }
 
 void TimeStats::recordRenderEngineDuration(nsecs_t startTime,
                                            const std::shared_ptr<FenceTime>& endTime) {
     if (!mEnabled.load()) return;
 
-    std::lock_guard<std::mutex> lock(mMutex);
+    pushEvent(RenderEngineDuration{startTime, endTime});
+}
+
+void TimeStats::applyEventLocked(const RenderEngineDuration& duration) {
     if (mGlobalRecord.renderEngineDurations.size() == MAX_NUM_TIME_RECORDS) {
         ALOGE("RenderEngineTimes are already at its maximum size[%zu]", MAX_NUM_TIME_RECORDS);
         mGlobalRecord.renderEngineDurations.pop_front();
     }
-    mGlobalRecord.renderEngineDurations.push_back({startTime, endTime});
+    mGlobalRecord.renderEngineDurations.push_back(duration);
 }
 
 bool TimeStats::recordReadyLocked(int32_t layerId, TimeRecord* timeRecord) {
@@ -489,9 +605,18 @@ void TimeStats::flushAvailableRecordsToStatsLocked(int32_t layerId, Fps displayR
             timeStatsLayer.lateAcquireFrames += layerRecord.lateAcquireFrames;
             timeStatsLayer.badDesiredPresentFrames += layerRecord.badDesiredPresentFrames;
 
+            timeStatsLayer.deviceCompositionFrames += layerRecord.deviceCompositionFrames;
+            timeStatsLayer.clientCompositionFrames += layerRecord.clientCompositionFrames;
+            timeStatsLayer.deltas["renderEngineShare"].merge(layerRecord.renderEngineShareMs);
+            timeStatsLayer.deltas["bufferReadMiB"].merge(layerRecord.bufferReadMiB);
+
             layerRecord.droppedFrames = 0;
             layerRecord.lateAcquireFrames = 0;
             layerRecord.badDesiredPresentFrames = 0;
+            layerRecord.deviceCompositionFrames = 0;
+            layerRecord.clientCompositionFrames = 0;
+            layerRecord.renderEngineShareMs = {};
+            layerRecord.bufferReadMiB = {};
 
             const int32_t postToAcquireMs = msBetween(timeRecords[0].frameTime.postTime,
                                                       timeRecords[0].frameTime.acquireTime);
@@ -572,15 +697,36 @@ void TimeStats::setPostTime(int32_t layerId, uint64_t frameNumber, const std::st
     ALOGV("[%d]-[%" PRIu64 "]-[%s]-PostTime[%" PRId64 "]", layerId, frameNumber, layerName.c_str(),
           postTime);
 
-    std::lock_guard<std::mutex> lock(mMutex);
-    if (!canAddNewAggregatedStats(uid, layerName, gameMode)) {
+    // Empty slots hold 0, so a layer with id 0 always sends its name.
+    std::optional<std::string> name;
+    if (knownLayerNameSlot(layerId).load(std::memory_order_relaxed) != layerId || layerId == 0) {
+        name = layerName;
+    }
+    pushEvent(PostTimeEvent{layerId, frameNumber, std::move(name), uid, postTime, gameMode});
+}
+
+std::atomic<int32_t>& TimeStats::knownLayerNameSlot(int32_t layerId) {
+    return mKnownLayerNames[static_cast<uint32_t>(layerId) % KNOWN_LAYER_NAME_SLOTS];
+}
+
+void TimeStats::applyEventLocked(const PostTimeEvent& event) {
+    const int32_t layerId = event.layerId;
+    if (event.layerName) {
+        mLayerNames.insert_or_assign(layerId, *event.layerName);
+        knownLayerNameSlot(layerId).store(layerId, std::memory_order_relaxed);
+    }
+    const auto nameIt = mLayerNames.find(layerId);
+    if (nameIt == mLayerNames.end()) return;
+    const std::string& layerName = nameIt->second;
+
+    if (!canAddNewAggregatedStats(event.uid, layerName, event.gameMode)) {
         return;
     }
     if (!mTimeStatsTracker.count(layerId) && mTimeStatsTracker.size() < MAX_NUM_LAYER_RECORDS &&
         layerNameIsValid(layerName)) {
-        mTimeStatsTracker[layerId].uid = uid;
+        mTimeStatsTracker[layerId].uid = event.uid;
         mTimeStatsTracker[layerId].layerName = layerName;
-        mTimeStatsTracker[layerId].gameMode = gameMode;
+        mTimeStatsTracker[layerId].gameMode = event.gameMode;
     }
     if (!mTimeStatsTracker.count(layerId)) return;
     LayerRecord& layerRecord = mTimeStatsTracker[layerId];
@@ -596,11 +742,11 @@ void TimeStats::setPostTime(int32_t layerId, uint64_t frameNumber, const std::st
     TimeRecord timeRecord = {
             .frameTime =
                     {
-                            .frameNumber = frameNumber,
-                            .postTime = postTime,
-                            .latchTime = postTime,
-                            .acquireTime = postTime,
-                            .desiredTime = postTime,
+                            .frameNumber = event.frameNumber,
+                            .postTime = event.postTime,
+                            .latchTime = event.postTime,
+                            .acquireTime = event.postTime,
+                            .desiredTime = event.postTime,
                     },
     };
     layerRecord.timeRecords.push_back(timeRecord);
@@ -615,16 +761,7 @@ void TimeStats::setLatchTime(int32_t layerId, uint64_t frameNumber, nsecs_t latc
     SFTRACE_CALL();
     ALOGV("[%d]-[%" PRIu64 "]-LatchTime[%" PRId64 "]", layerId, frameNumber, latchTime);
 
-    std::lock_guard<std::mutex> lock(mMutex);
-    if (!mTimeStatsTracker.count(layerId)) return;
-    LayerRecord& layerRecord = mTimeStatsTracker[layerId];
-    if (layerRecord.waitData < 0 ||
-        layerRecord.waitData >= static_cast<int32_t>(layerRecord.timeRecords.size()))
-        return;
-    TimeRecord& timeRecord = layerRecord.timeRecords[layerRecord.waitData];
-    if (timeRecord.frameTime.frameNumber == frameNumber) {
-        timeRecord.frameTime.latchTime = latchTime;
-    }
+    pushEvent(FrameTimeEvent{FrameTimeEvent::Type::Latch, layerId, frameNumber, latchTime});
 }
 
 void TimeStats::incrementLatchSkipped(int32_t layerId, LatchSkipReason reason) {
@@ -634,11 +771,14 @@ void TimeStats::incrementLatchSkipped(int32_t layerId, LatchSkipReason reason) {
     ALOGV("[%d]-LatchSkipped-Reason[%d]", layerId,
           static_cast<std::underlying_type<LatchSkipReason>::type>(reason));
 
-    std::lock_guard<std::mutex> lock(mMutex);
-    if (!mTimeStatsTracker.count(layerId)) return;
-    LayerRecord& layerRecord = mTimeStatsTracker[layerId];
+    pushEvent(LatchSkippedEvent{layerId, reason});
+}
+
+void TimeStats::applyEventLocked(const LatchSkippedEvent& event) {
+    if (!mTimeStatsTracker.count(event.layerId)) return;
+    LayerRecord& layerRecord = mTimeStatsTracker[event.layerId];
 
-    switch (reason) {
+    switch (event.reason) {
         case LatchSkipReason::LateAcquire:
             layerRecord.lateAcquireFrames++;
             break;
@@ -651,9 +791,12 @@ void TimeStats::incrementBadDesiredPresent(int32_t layerId) {
     SFTRACE_CALL();
     ALOGV("[%d]-BadDesiredPresent", layerId);
 
-    std::lock_guard<std::mutex> lock(mMutex);
-    if (!mTimeStatsTracker.count(layerId)) return;
-    LayerRecord& layerRecord = mTimeStatsTracker[layerId];
+    pushEvent(BadDesiredPresentEvent{layerId});
+}
+
+void TimeStats::applyEventLocked(const BadDesiredPresentEvent& event) {
+    if (!mTimeStatsTracker.count(event.layerId)) return;
+    LayerRecord& layerRecord = mTimeStatsTracker[event.layerId];
     layerRecord.badDesiredPresentFrames++;
 }
 
@@ -663,16 +806,7 @@ void TimeStats::setDesiredTime(int32_t layerId, uint64_t frameNumber, nsecs_t de
     SFTRACE_CALL();
     ALOGV("[%d]-[%" PRIu64 "]-DesiredTime[%" PRId64 "]", layerId, frameNumber, desiredTime);
 
-    std::lock_guard<std::mutex> lock(mMutex);
-    if (!mTimeStatsTracker.count(layerId)) return;
-    LayerRecord& layerRecord = mTimeStatsTracker[layerId];
-    if (layerRecord.waitData < 0 ||
-        layerRecord.waitData >= static_cast<int32_t>(layerRecord.timeRecords.size()))
-        return;
-    TimeRecord& timeRecord = layerRecord.timeRecords[layerRecord.waitData];
-    if (timeRecord.frameTime.frameNumber == frameNumber) {
-        timeRecord.frameTime.desiredTime = desiredTime;
-    }
+    pushEvent(FrameTimeEvent{FrameTimeEvent::Type::Desired, layerId, frameNumber, desiredTime});
 }
 
 void TimeStats::setAcquireTime(int32_t layerId, uint64_t frameNumber, nsecs_t acquireTime) {
@@ -681,15 +815,28 @@ void TimeStats::setAcquireTime(int32_t layerId, uint64_t frameNumber, nsecs_t ac
     SFTRACE_CALL();
     ALOGV("[%d]-[%" PRIu64 "]-AcquireTime[%" PRId64 "]", layerId, frameNumber, acquireTime);
 
-    std::lock_guard<std::mutex> lock(mMutex);
-    if (!mTimeStatsTracker.count(layerId)) return;
-    LayerRecord& layerRecord = mTimeStatsTracker[layerId];
+    pushEvent(FrameTimeEvent{FrameTimeEvent::Type::Acquire, layerId, frameNumber, acquireTime});
+}
+
+void TimeStats::applyEventLocked(const FrameTimeEvent& event) {
+    if (!mTimeStatsTracker.count(event.layerId)) return;
+    LayerRecord& layerRecord = mTimeStatsTracker[event.layerId];
     if (layerRecord.waitData < 0 ||
         layerRecord.waitData >= static_cast<int32_t>(layerRecord.timeRecords.size()))
         return;
     TimeRecord& timeRecord = layerRecord.timeRecords[layerRecord.waitData];
-    if (timeRecord.frameTime.frameNumber == frameNumber) {
-        timeRecord.frameTime.acquireTime = acquireTime;
+    if (timeRecord.frameTime.frameNumber != event.frameNumber) return;
+
+    switch (event.type) {
+        case FrameTimeEvent::Type::Latch:
+            timeRecord.frameTime.latchTime = event.time;
+            break;
+        case FrameTimeEvent::Type::Desired:
+            timeRecord.frameTime.desiredTime = event.time;
+            break;
+        case FrameTimeEvent::Type::Acquire:
+            timeRecord.frameTime.acquireTime = event.time;
+            break;
     }
 }
 
@@ -701,15 +848,18 @@ void TimeStats::setAcquireFence(int32_t layerId, uint64_t frameNumber,
     ALOGV("[%d]-[%" PRIu64 "]-AcquireFenceTime[%" PRId64 "]", layerId, frameNumber,
           acquireFence->getSignalTime());
 
-    std::lock_guard<std::mutex> lock(mMutex);
-    if (!mTimeStatsTracker.count(layerId)) return;
-    LayerRecord& layerRecord = mTimeStatsTracker[layerId];
+    pushEvent(AcquireFenceEvent{layerId, frameNumber, acquireFence});
+}
+
+void TimeStats::applyEventLocked(const AcquireFenceEvent& event) {
+    if (!mTimeStatsTracker.count(event.layerId)) return;
+    LayerRecord& layerRecord = mTimeStatsTracker[event.layerId];
     if (layerRecord.waitData < 0 ||
         layerRecord.waitData >= static_cast<int32_t>(layerRecord.timeRecords.size()))
         return;
     TimeRecord& timeRecord = layerRecord.timeRecords[layerRecord.waitData];
-    if (timeRecord.frameTime.frameNumber == frameNumber) {
-        timeRecord.acquireFence = acquireFence;
+    if (timeRecord.frameTime.frameNumber == event.frameNumber) {
+        timeRecord.acquireFence = event.acquireFence;
     }
 }
 
@@ -721,21 +871,8 @@ void TimeStats::setPresentTime(int32_t layerId, uint64_t frameNumber, nsecs_t pr
     SFTRACE_CALL();
     ALOGV("[%d]-[%" PRIu64 "]-PresentTime[%" PRId64 "]", layerId, frameNumber, presentTime);
 
-    std::lock_guard<std::mutex> lock(mMutex);
-    if (!mTimeStatsTracker.count(layerId)) return;
-    LayerRecord& layerRecord = mTimeStatsTracker[layerId];
-    if (layerRecord.waitData < 0 ||
-        layerRecord.waitData >= static_cast<int32_t>(layerRecord.timeRecords.size()))
-        return;
-    TimeRecord& timeRecord = layerRecord.timeRecords[layerRecord.waitData];
-    if (timeRecord.frameTime.frameNumber == frameNumber) {
-        timeRecord.frameTime.presentTime = presentTime;
-        timeRecord.ready = true;
-        layerRecord.waitData++;
-    }
-
-    flushAvailableRecordsToStatsLocked(layerId, displayRefreshRate, renderRate, frameRateVote,
-                                       gameMode);
+    pushEvent(PresentEvent{layerId, frameNumber, presentTime, displayRefreshRate, renderRate,
+                           frameRateVote, gameMode});
 }
 
 void TimeStats::setPresentFence(int32_t layerId, uint64_t frameNumber,
@@ -748,21 +885,29 @@ void TimeStats::setPresentFence(int32_t layerId, uint64_t frameNumber,
     ALOGV("[%d]-[%" PRIu64 "]-PresentFenceTime[%" PRId64 "]", layerId, frameNumber,
           presentFence->getSignalTime());
 
-    std::lock_guard<std::mutex> lock(mMutex);
-    if (!mTimeStatsTracker.count(layerId)) return;
-    LayerRecord& layerRecord = mTimeStatsTracker[layerId];
+    pushEvent(PresentEvent{layerId, frameNumber, presentFence, displayRefreshRate, renderRate,
+                           frameRateVote, gameMode});
+}
+
+void TimeStats::applyEventLocked(const PresentEvent& event) {
+    if (!mTimeStatsTracker.count(event.layerId)) return;
+    LayerRecord& layerRecord = mTimeStatsTracker[event.layerId];
     if (layerRecord.waitData < 0 ||
         layerRecord.waitData >= static_cast<int32_t>(layerRecord.timeRecords.size()))
         return;
     TimeRecord& timeRecord = layerRecord.timeRecords[layerRecord.waitData];
-    if (timeRecord.frameTime.frameNumber == frameNumber) {
-        timeRecord.presentFence = presentFence;
+    if (timeRecord.frameTime.frameNumber == event.frameNumber) {
+        if (const auto presentTime = std::get_if<nsecs_t>(&event.present)) {
+            timeRecord.frameTime.presentTime = *presentTime;
+        } else {
+            timeRecord.presentFence = std::get<std::shared_ptr<FenceTime>>(event.present);
+        }
         timeRecord.ready = true;
         layerRecord.waitData++;
     }
 
-    flushAvailableRecordsToStatsLocked(layerId, displayRefreshRate, renderRate, frameRateVote,
-                                       gameMode);
+    flushAvailableRecordsToStatsLocked(event.layerId, event.displayRefreshRate, event.renderRate,
+                                       event.frameRateVote, event.gameMode);
 }
 
 static const constexpr int32_t kValidJankyReason = JankType::DisplayHAL |
@@ -806,7 +951,10 @@ void TimeStats::incrementJankyFrames(const JankyFramesInfo& info) {
     if (!mEnabled.load()) return;
 
     SFTRACE_CALL();
-    std::lock_guard<std::mutex> lock(mMutex);
+    pushEvent(info);
+}
+
+void TimeStats::applyEventLocked(const JankyFramesInfo& info) {
 
     // Only update layer stats if we're already tracking the layer in TimeStats.
     // Otherwise, continue tracking the statistic but use a default layer name instead.
@@ -863,8 +1011,16 @@ void TimeStats::incrementJankyFrames(const JankyFramesInfo& info) {
 void TimeStats::onDestroy(int32_t layerId) {
     SFTRACE_CALL();
     ALOGV("[%d]-onDestroy", layerId);
-    std::lock_guard<std::mutex> lock(mMutex);
-    mTimeStatsTracker.erase(layerId);
+    pushEvent(DestroyEvent{layerId});
+}
+
+void TimeStats::applyEventLocked(const DestroyEvent& event) {
+    mTimeStatsTracker.erase(event.layerId);
+    mLayerNames.erase(event.layerId);
+    auto& slot = knownLayerNameSlot(event.layerId);
+    if (slot.load(std::memory_order_relaxed) == event.layerId) {
+        slot.store(0, std::memory_order_relaxed);
+    }
 }
 
 void TimeStats::removeTimeRecord(int32_t layerId, uint64_t frameNumber) {
@@ -873,12 +1029,15 @@ void TimeStats::removeTimeRecord(int32_t layerId, uint64_t frameNumber) {
     SFTRACE_CALL();
     ALOGV("[%d]-[%" PRIu64 "]-removeTimeRecord", layerId, frameNumber);
 
-    std::lock_guard<std::mutex> lock(mMutex);
-    if (!mTimeStatsTracker.count(layerId)) return;
-    LayerRecord& layerRecord = mTimeStatsTracker[layerId];
+    pushEvent(RemoveTimeRecordEvent{layerId, frameNumber});
+}
+
+void TimeStats::applyEventLocked(const RemoveTimeRecordEvent& event) {
+    if (!mTimeStatsTracker.count(event.layerId)) return;
+    LayerRecord& layerRecord = mTimeStatsTracker[event.layerId];
     size_t removeAt = 0;
     for (const TimeRecord& record : layerRecord.timeRecords) {
-        if (record.frameTime.frameNumber == frameNumber) break;
+        if (record.frameTime.frameNumber == event.frameNumber) break;
         removeAt++;
     }
     if (removeAt == layerRecord.timeRecords.size()) return;
@@ -912,13 +1071,14 @@ void TimeStats::flushPowerTimeLocked() {
 }
 
 void TimeStats::setPowerMode(PowerMode powerMode) {
+    std::lock_guard<std::mutex> lock(mMutex);
+    // The frames recorded so far were recorded in the previous power mode.
+    applyPendingEventsLocked();
     if (!mEnabled.load()) {
-        std::lock_guard<std::mutex> lock(mMutex);
         mPowerTime.powerMode = powerMode;
         return;
     }
 
-    std::lock_guard<std::mutex> lock(mMutex);
     if (powerMode == mPowerTime.powerMode) return;
 
     flushPowerTimeLocked();
@@ -963,7 +1123,7 @@ void TimeStats::flushAvailableGlobalRecordsToStatsLocked() {
         mGlobalRecord.presentFences.pop_front();
     }
     while (!mGlobalRecord.renderEngineDurations.empty()) {
-        const auto duration = mGlobalRecord.renderEngineDurations.front();
+        const auto& duration = mGlobalRecord.renderEngineDurations.front();
         const auto& endTime = duration.endTime;
 
         nsecs_t endNs = -1;
@@ -985,6 +1145,18 @@ void TimeStats::flushAvailableGlobalRecordsToStatsLocked() {
         const int32_t renderEngineMs = msBetween(duration.startTime, endNs);
         mTimeStats.renderEngineTimingLegacy.insert(renderEngineMs);
 
+        if (!duration.clientLayerIds.empty()) {
+            const int32_t shareMs =
+                    toMs((endNs - duration.startTime) /
+                         static_cast<nsecs_t>(duration.clientLayerIds.size()));
+            for (int32_t layerId : duration.clientLayerIds) {
+                const auto it = mTimeStatsTracker.find(layerId);
+                if (it != mTimeStatsTracker.end()) {
+                    it->second.renderEngineShareMs.insert(shareMs);
+                }
+            }
+        }
+
         mGlobalRecord.renderEngineDurations.pop_front();
     }
 }
@@ -993,7 +1165,11 @@ void TimeStats::setPresentFenceGlobal(const std::shared_ptr<FenceTime>& presentF
     if (!mEnabled.load()) return;
 
     SFTRACE_CALL();
-    std::lock_guard<std::mutex> lock(mMutex);
+    pushEvent(PresentFenceGlobalEvent{presentFence});
+}
+
+void TimeStats::applyEventLocked(const PresentFenceGlobalEvent& event) {
+    const std::shared_ptr<FenceTime>& presentFence = event.presentFence;
     if (presentFence == nullptr || !presentFence->isValid()) {
         mGlobalRecord.prevPresentTime = 0;
         return;
@@ -1037,6 +1213,7 @@ void TimeStats::disable() {
     SFTRACE_CALL();
 
     std::lock_guard<std::mutex> lock(mMutex);
+    applyPendingEventsLocked();
     flushPowerTimeLocked();
     mEnabled.store(false);
     mTimeStats.statsEndLegacy = static_cast<int64_t>(std::time(0));
@@ -1045,6 +1222,7 @@ void TimeStats::disable() {
 
 void TimeStats::clearAll() {
     std::lock_guard<std::mutex> lock(mMutex);
+    applyPendingEventsLocked();
     mTimeStats.stats.clear();
     clearGlobalLocked();
     clearLayersLocked();
@@ -1096,6 +1274,7 @@ void TimeStats::dump(bool asProto, std::optional<uint32_t> maxLayers, std::strin
     SFTRACE_CALL();
 
     std::lock_guard<std::mutex> lock(mMutex);
+    applyPendingEventsLocked();
     if (mTimeStats.statsStartLegacy == 0) {
         return;
     }
@@ -16,10 +16,14 @@
 
 #pragma once
 
+#include <array>
+#include <atomic>
+#include <condition_variable>
 #include <cstdint>
 #include <deque>
 #include <mutex>
 #include <optional>
+#include <thread>
 #include <unordered_map>
 #include <variant>
 
@@ -34,6 +38,8 @@
 
 #include <scheduler/Fps.h>
 
+#include "../LocklessQueue.h"
+
 using android::gui::GameMode;
 using android::gui::LayerMetadata;
 using namespace android::surfaceflinger;
@@ -91,8 +97,8 @@ public:
     virtual void setAcquireTime(int32_t layerId, uint64_t frameNumber, nsecs_t acquireTime) = 0;
     virtual void setAcquireFence(int32_t layerId, uint64_t frameNumber,
                                  const std::shared_ptr<FenceTime>& acquireFence) = 0;
-    // SetPresent{Time, Fence} are not expected to be called in the critical
-    // rendering path, as they flush prior fences if those fences have fired.
+    // SetPresent{Time, Fence} also flush prior fences if those fences have fired,
+    // which implementations may defer off the calling thread.
     virtual void setPresentTime(int32_t layerId, uint64_t frameNumber, nsecs_t presentTime,
                                 Fps displayRefreshRate, std::optional<Fps> renderRate,
                                 SetFrameRateVote frameRateVote, GameMode) = 0;
@@ -169,6 +175,14 @@ public:
         }
     };
 
+    struct LayerCompositionCost {
+        int32_t layerId = 0;
+        // Layer was composited by RenderEngine rather than on a HWC plane
+        bool clientComposition = false;
+        // Bytes of buffer read to composite the layer, 0 if it has no buffer
+        uint64_t bufferBytes = 0;
+    };
+
     virtual void incrementJankyFrames(const JankyFramesInfo& info) = 0;
     // Clean up the layer record
     virtual void onDestroy(int32_t layerId) = 0;
@@ -181,6 +195,9 @@ public:
     virtual void recordRefreshRate(uint32_t fps, nsecs_t duration) = 0;
     virtual void setPresentFenceGlobal(const std::shared_ptr<FenceTime>& presentFence) = 0;
     virtual void pushCompositionStrategyState(const ClientCompositionRecord&) = 0;
+    // Records how each visible layer was composited in the last frame. The RenderEngine time of
+    // the frame is split evenly among its client composited layers once it is known.
+    virtual void recordLayerCompositionCosts(const std::vector<LayerCompositionCost>&) = 0;
 };
 
 namespace impl {
@@ -215,6 +232,11 @@ class TimeStats : public android::TimeStats {
         uint32_t droppedFrames = 0;
         uint32_t lateAcquireFrames = 0;
         uint32_t badDesiredPresentFrames = 0;
+        uint32_t deviceCompositionFrames = 0;
+        uint32_t clientCompositionFrames = 0;
+        // Per frame composition costs, moved to the layer stats with the next presented frame.
+        TimeStatsHelper::Histogram renderEngineShareMs;
+        TimeStatsHelper::Histogram bufferReadMiB;
         TimeRecord prevTimeRecord;
         std::optional<int32_t> prevPresentToPresentMs;
         std::deque<TimeRecord> timeRecords;
@@ -228,6 +250,9 @@ class TimeStats : public android::TimeStats {
     struct RenderEngineDuration {
         nsecs_t startTime;
         std::variant<nsecs_t, std::shared_ptr<FenceTime>> endTime;
+        // Layers that were composited by RenderEngine in this frame.
+        std::vector<int32_t> clientLayerIds;
+        bool attributed = false;
     };
 
     struct GlobalRecord {
@@ -236,11 +261,88 @@ class TimeStats : public android::TimeStats {
         std::deque<RenderEngineDuration> renderEngineDurations;
     };
 
+    // The recording calls only push one of the events below, which are applied to the stats in
+    // push order under mMutex, either by the aggregator thread or before the stats are read.
+    struct PostTimeEvent {
+        int32_t layerId;
+        uint64_t frameNumber;
+        // Only sent until the aggregator knows the name of the layer.
+        std::optional<std::string> layerName;
+        uid_t uid;
+        nsecs_t postTime;
+        GameMode gameMode;
+    };
+
+    struct FrameTimeEvent {
+        enum class Type { Latch, Desired, Acquire };
+        Type type;
+        int32_t layerId;
+        uint64_t frameNumber;
+        nsecs_t time;
+    };
+
+    struct AcquireFenceEvent {
+        int32_t layerId;
+        uint64_t frameNumber;
+        std::shared_ptr<FenceTime> acquireFence;
+    };
+
+    struct PresentEvent {
+        int32_t layerId;
+        uint64_t frameNumber;
+        std::variant<nsecs_t, std::shared_ptr<FenceTime>> present;
+        Fps displayRefreshRate;
+        std::optional<Fps> renderRate;
+        SetFrameRateVote frameRateVote;
+        GameMode gameMode;
+    };
+
+    struct LatchSkippedEvent {
+        int32_t layerId;
+        LatchSkipReason reason;
+    };
+
+    struct BadDesiredPresentEvent {
+        int32_t layerId;
+    };
+
+    struct DestroyEvent {
+        int32_t layerId;
+    };
+
+    struct RemoveTimeRecordEvent {
+        int32_t layerId;
+        uint64_t frameNumber;
+    };
+
+    struct GlobalCounterEvent {
+        enum class Counter { TotalFrames, MissedFrames, RefreshRateSwitches };
+        Counter counter;
+    };
+
+    struct FrameDurationEvent {
+        nsecs_t startTime;
+        nsecs_t endTime;
+    };
+
+    struct PresentFenceGlobalEvent {
+        std::shared_ptr<FenceTime> presentFence;
+    };
+
+    using LayerCompositionCosts = std::vector<LayerCompositionCost>;
+
+    using Event = std::variant<PostTimeEvent, FrameTimeEvent, AcquireFenceEvent, PresentEvent,
+                               LatchSkippedEvent, BadDesiredPresentEvent, DestroyEvent,
+                               RemoveTimeRecordEvent, JankyFramesInfo, GlobalCounterEvent,
+                               FrameDurationEvent, RenderEngineDuration, PresentFenceGlobalEvent,
+                               ClientCompositionRecord, LayerCompositionCosts>;
+
 public:
     TimeStats();
     // For testing only for injecting custom dependencies.
     TimeStats(std::optional<size_t> maxPulledLayers,
               std::optional<size_t> maxPulledHistogramBuckets);
+    ~TimeStats() override;
 
     bool onPullAtom(const int atomId, std::vector<uint8_t>* pulledData) override;
     void parseArgs(bool asProto, const Vector<String16>& args, std::string& result) override;
@@ -285,10 +387,30 @@ public:
     void setPresentFenceGlobal(const std::shared_ptr<FenceTime>& presentFence) override;
 
     void pushCompositionStrategyState(const ClientCompositionRecord&) override;
+    void recordLayerCompositionCosts(const std::vector<LayerCompositionCost>&) override;
 
     static const size_t MAX_NUM_TIME_RECORDS = 64;
 
 private:
+    void pushEvent(Event&& event);
+    void aggregatorMain();
+    void applyPendingEventsLocked();
+    void applyEventLocked(const PostTimeEvent&);
+    void applyEventLocked(const FrameTimeEvent&);
+    void applyEventLocked(const AcquireFenceEvent&);
+    void applyEventLocked(const PresentEvent&);
+    void applyEventLocked(const LatchSkippedEvent&);
+    void applyEventLocked(const BadDesiredPresentEvent&);
+    void applyEventLocked(const DestroyEvent&);
+    void applyEventLocked(const RemoveTimeRecordEvent&);
+    void applyEventLocked(const JankyFramesInfo&);
+    void applyEventLocked(const GlobalCounterEvent&);
+    void applyEventLocked(const FrameDurationEvent&);
+    void applyEventLocked(const RenderEngineDuration&);
+    void applyEventLocked(const PresentFenceGlobalEvent&);
+    void applyEventLocked(const ClientCompositionRecord&);
+    void applyEventLocked(const LayerCompositionCosts&);
+
     bool populateGlobalAtom(std::vector<uint8_t>* pulledData);
     bool populateLayerAtom(std::vector<uint8_t>* pulledData);
     bool recordReadyLocked(int32_t layerId, TimeRecord* timeRecord);
@@ -298,6 +420,7 @@ private:
     void flushPowerTimeLocked();
     void flushAvailableGlobalRecordsToStatsLocked();
     bool canAddNewAggregatedStats(uid_t uid, const std::string& layerName, GameMode);
+    std::atomic<int32_t>& knownLayerNameSlot(int32_t layerId);
 
     void enable();
     void disable();
@@ -314,6 +437,28 @@ private:
     PowerTime mPowerTime;
     GlobalRecord mGlobalRecord;
 
+    // Events pushed by the recording calls, only popped under mMutex.
+    BoundedLocklessQueue<Event> mPendingEvents{PENDING_EVENTS_CAPACITY};
+    std::vector<Event> mAppliedEvents;
+
+    // The names of the layers that posted a buffer, until they are destroyed, so that setPostTime
+    // does not copy the name into every event.
+    std::unordered_map<int32_t, std::string> mLayerNames;
+    // Layer ids in mLayerNames, each held in the slot its id maps to. Only written under mMutex,
+    // and read by setPostTime without a lock. A layer that lost its slot to another one sends its
+    // name again.
+    static const size_t KNOWN_LAYER_NAME_SLOTS = 512;
+    std::array<std::atomic<int32_t>, KNOWN_LAYER_NAME_SLOTS> mKnownLayerNames{};
+
+    // Set by the first event pushed since the aggregator thread last ran.
+    std::atomic<bool> mAggregationPending = false;
+    std::mutex mAggregatorMutex;
+    std::condition_variable mAggregatorCondition;
+    bool mAggregatorDone = false;
+    std::thread mAggregatorThread;
+
+    // Enough for the events of a few frames with every layer updating.
+    static const size_t PENDING_EVENTS_CAPACITY = 1024;
     static const size_t MAX_NUM_LAYER_RECORDS = 200;
 
     static const size_t REFRESH_RATE_BUCKET_WIDTH = 30;
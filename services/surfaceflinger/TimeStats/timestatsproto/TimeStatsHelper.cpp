@@ -49,6 +49,12 @@ void TimeStatsHelper::Histogram::insert(int32_t delta) {
     hist[*iter]++;
 }
 
+void TimeStatsHelper::Histogram::merge(const Histogram& other) {
+    for (const auto& [bucket, count] : other.hist) {
+        hist[bucket] += count;
+    }
+}
+
 int64_t TimeStatsHelper::Histogram::totalTime() const {
     int64_t ret = 0;
     for (const auto& ele : hist) {
@@ -113,6 +119,8 @@ std::string TimeStatsHelper::TimeStatsLayer::toString() const {
     StringAppendF(&result, "droppedFrames = %d\n", droppedFrames);
     StringAppendF(&result, "lateAcquireFrames = %d\n", lateAcquireFrames);
     StringAppendF(&result, "badDesiredPresentFrames = %d\n", badDesiredPresentFrames);
+    StringAppendF(&result, "deviceCompositionFrames = %d\n", deviceCompositionFrames);
+    StringAppendF(&result, "clientCompositionFrames = %d\n", clientCompositionFrames);
     result.append("Jank payload for this layer:\n");
     result.append(jankPayload.toString());
     result.append("SetFrameRate vote for this layer:\n");
@@ -198,6 +206,8 @@ SFTimeStatsLayerProto TimeStatsHelper::TimeStatsLayer::toProto() const {
     layerProto.set_package_name(packageName);
     layerProto.set_total_frames(totalFrames);
     layerProto.set_dropped_frames(droppedFrames);
+    layerProto.set_device_composition_frames(deviceCompositionFrames);
+    layerProto.set_client_composition_frames(clientCompositionFrames);
     for (const auto& ele : deltas) {
         SFTimeStatsDeltaProto* deltaProto = layerProto.add_deltas();
         deltaProto->set_delta_name(ele.first);
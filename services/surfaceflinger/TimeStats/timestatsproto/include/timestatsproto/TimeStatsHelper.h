@@ -39,6 +39,7 @@ public:
         std::unordered_map<int32_t, int32_t> hist;
 
         void insert(int32_t delta);
+        void merge(const Histogram& other);
         int64_t totalTime() const;
         float averageTime() const;
         std::string toString() const;
@@ -95,6 +96,9 @@ public:
         int32_t droppedFrames = 0;
         int32_t lateAcquireFrames = 0;
         int32_t badDesiredPresentFrames = 0;
+        // Frames in which the layer was composited on a HWC plane or by RenderEngine.
+        int32_t deviceCompositionFrames = 0;
+        int32_t clientCompositionFrames = 0;
         JankPayload jankPayload;
         SetFrameRateVote setFrameRateVote;
         std::unordered_map<std::string, Histogram> deltas;
@@ -174,7 +174,9 @@ void LayerTracing::writeSnapshotToStream(perfetto::protos::LayersSnapshotProto&&
 
 void LayerTracing::writeSnapshotToPerfetto(const perfetto::protos::LayersSnapshotProto& snapshot,
                                            Mode srcMode) {
-    const auto snapshotBytes = snapshot.SerializeAsString();
+    // Serialized on the first session the snapshot is written to, as snapshots are large and
+    // there may be none, e.g. when a generated snapshot was already written.
+    std::optional<std::string> snapshotBytes;
 
     LayerDataSource::Trace([&](LayerDataSource::TraceContext context) {
         auto dstMode = context.GetCustomTlsState()->mMode;
@@ -192,12 +194,15 @@ void LayerTracing::writeSnapshotToPerfetto(const perfetto::protos::LayersSnapsho
         if (!checkAndUpdateLastVsyncIdWrittenToPerfetto(srcMode, snapshot.vsync_id())) {
             return;
         }
+        if (!snapshotBytes) {
+            snapshotBytes = snapshot.SerializeAsString();
+        }
         {
             auto packet = context.NewTracePacket();
             packet->set_timestamp(static_cast<uint64_t>(snapshot.elapsed_realtime_nanos()));
             packet->set_timestamp_clock_id(perfetto::protos::pbzero::BUILTIN_CLOCK_MONOTONIC);
             auto* snapshotProto = packet->set_surfaceflinger_layers_snapshot();
-            snapshotProto->AppendRawProtoBytes(snapshotBytes.data(), snapshotBytes.size());
+            snapshotProto->AppendRawProtoBytes(snapshotBytes->data(), snapshotBytes->size());
         }
         {
             // TODO (b/162206162): remove empty packet when perfetto bug is fixed.
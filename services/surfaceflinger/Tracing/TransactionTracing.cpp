@@ -17,6 +17,7 @@
 #undef LOG_TAG
 #define LOG_TAG "TransactionTracing"
 
+#include <android-base/properties.h>
 #include <android-base/stringprintf.h>
 #include <log/log.h>
 #include <utils/SystemClock.h>
@@ -37,6 +38,11 @@ TransactionTracing::TransactionTracing()
 
     mStartingTimestamp = systemTime();
 
+    mElideUnchangedLayerState =
+            base::GetBoolProperty("debug.sf.transaction_trace_elide_unchanged", false);
+    setCpuBudget(std::chrono::microseconds(
+            base::GetIntProperty<int64_t>("debug.sf.transaction_trace_cpu_budget_us", 0)));
+
     {
         std::scoped_lock lock(mMainThreadLock);
         mThread = std::thread(&TransactionTracing::loop, this);
@@ -147,6 +153,10 @@ void TransactionTracing::setBufferSize(size_t bufferSizeInBytes) {
     mBuffer.setSize(bufferSizeInBytes);
 }
 
+void TransactionTracing::setCpuBudget(std::chrono::nanoseconds cpuTimePerSecond) {
+    mCpuBudgetPerSecond = cpuTimePerSecond.count();
+}
+
 perfetto::protos::TransactionTraceFile TransactionTracing::createTraceFileProto() const {
     perfetto::protos::TransactionTraceFile proto;
     proto.set_magic_number(
@@ -163,6 +173,11 @@ void TransactionTracing::dump(std::string& result) const {
     std::scoped_lock lock(mTraceLock);
     base::StringAppendF(&result, "  queued transactions=%zu created layers=%zu states=%zu\n",
                         mQueuedTransactions.size(), mCreatedLayers.size(), mStartingStates.size());
+    base::StringAppendF(&result,
+                        "  elided layer changes=%" PRIu64 " coalesced updates=%" PRIu64
+                        " cpu budget=%" PRId64 "us/s\n",
+                        mElidedLayerChanges, mCoalescedUpdates,
+                        static_cast<int64_t>(mCpuBudgetPerSecond.load() / 1000));
     mBuffer.dump(result);
 }
 
@@ -199,6 +214,7 @@ void TransactionTracing::addCommittedTransactions(int64_t vsyncId, nsecs_t commi
 }
 
 void TransactionTracing::loop() {
+    bool coalesce = false;
     while (true) {
         std::vector<CommittedUpdates> committedUpdates;
         std::vector<uint32_t> destroyedLayers;
@@ -220,14 +236,47 @@ void TransactionTracing::loop() {
             mUpdates.clear();
         } // unlock mMainThreadLock
 
-        if (!committedUpdates.empty() || !destroyedLayers.empty()) {
-            addEntry(committedUpdates, destroyedLayers);
+        if (committedUpdates.empty() && destroyedLayers.empty()) {
+            continue;
+        }
+
+        const nsecs_t cpuStartTime = systemTime(SYSTEM_TIME_THREAD);
+        addEntry(committedUpdates, destroyedLayers, coalesce);
+        const auto budgetRemaining =
+                consumeCpuBudget(systemTime(SYSTEM_TIME_THREAD) - cpuStartTime);
+        coalesce = budgetRemaining.has_value();
+        if (coalesce) {
+            // Over budget, let the updates accumulate until the budget window ends and write them
+            // as a single entry.
+            std::unique_lock<std::mutex> lock(mMainThreadLock);
+            base::ScopedLockAssertion assumeLocked(mMainThreadLock);
+            mTransactionsAvailableCv.wait_for(lock, *budgetRemaining,
+                                              [&]() REQUIRES(mMainThreadLock) { return mDone; });
         }
     }
 }
 
+std::optional<std::chrono::nanoseconds> TransactionTracing::consumeCpuBudget(nsecs_t cpuTime) {
+    const nsecs_t budget = mCpuBudgetPerSecond;
+    if (budget <= 0) {
+        return std::nullopt;
+    }
+
+    constexpr nsecs_t kWindow = std::chrono::nanoseconds(std::chrono::seconds(1)).count();
+    const nsecs_t now = systemTime();
+    if (now - mCpuBudgetWindowStart >= kWindow) {
+        mCpuBudgetWindowStart = now;
+        mCpuBudgetWindowCpuTime = 0;
+    }
+    mCpuBudgetWindowCpuTime += cpuTime;
+    if (mCpuBudgetWindowCpuTime <= budget) {
+        return std::nullopt;
+    }
+    return std::chrono::nanoseconds(mCpuBudgetWindowStart + kWindow - now);
+}
+
 void TransactionTracing::addEntry(const std::vector<CommittedUpdates>& committedUpdates,
-                                  const std::vector<uint32_t>& destroyedLayers) {
+                                  const std::vector<uint32_t>& destroyedLayers, bool coalesce) {
     std::scoped_lock lock(mTraceLock);
     std::vector<std::string> removedEntries;
     perfetto::protos::TransactionTraceEntry entryProto;
@@ -237,26 +286,36 @@ void TransactionTracing::addEntry(const std::vector<CommittedUpdates>& committed
         mQueuedTransactions[incomingTransaction->transaction_id()] = transaction;
         delete incomingTransaction;
     }
-    for (const CommittedUpdates& update : committedUpdates) {
+    for (size_t i = 0; i < committedUpdates.size(); i++) {
+        const CommittedUpdates& update = committedUpdates[i];
+        // A coalesced entry carries the destroyed layers once.
+        const bool firstInEntry = !coalesce || i == 0;
         entryProto.set_elapsed_realtime_nanos(update.timestamp);
         entryProto.set_vsync_id(update.vsyncId);
         entryProto.mutable_added_layers()->Reserve(
-                static_cast<int32_t>(update.createdLayers.size()));
+                entryProto.added_layers_size() + static_cast<int32_t>(update.createdLayers.size()));
 
         for (const auto& args : update.createdLayers) {
             entryProto.mutable_added_layers()->Add(mProtoParser.toProto(args));
         }
 
-        entryProto.mutable_destroyed_layers()->Reserve(
-                static_cast<int32_t>(destroyedLayers.size()));
-        for (auto& destroyedLayer : destroyedLayers) {
-            entryProto.mutable_destroyed_layers()->Add(destroyedLayer);
+        if (firstInEntry) {
+            entryProto.mutable_destroyed_layers()->Reserve(
+                    static_cast<int32_t>(destroyedLayers.size()));
+            for (auto& destroyedLayer : destroyedLayers) {
+                entryProto.mutable_destroyed_layers()->Add(destroyedLayer);
+                mLastLayerStates.erase(destroyedLayer);
+            }
         }
         entryProto.mutable_transactions()->Reserve(
+                entryProto.transactions_size() +
                 static_cast<int32_t>(update.transactionIds.size()));
         for (const uint64_t& id : update.transactionIds) {
             auto it = mQueuedTransactions.find(id);
             if (it != mQueuedTransactions.end()) {
+                if (mElideUnchangedLayerState) {
+                    elideUnchangedLayerStateLocked(it->second);
+                }
                 entryProto.mutable_transactions()->Add(std::move(it->second));
                 mQueuedTransactions.erase(it);
             } else {
@@ -265,13 +324,17 @@ void TransactionTracing::addEntry(const std::vector<CommittedUpdates>& committed
         }
 
         entryProto.mutable_destroyed_layer_handles()->Reserve(
+                entryProto.destroyed_layer_handles_size() +
                 static_cast<int32_t>(update.destroyedLayerHandles.size()));
         for (auto layerId : update.destroyedLayerHandles) {
             entryProto.mutable_destroyed_layer_handles()->Add(layerId);
         }
 
-        entryProto.set_displays_changed(update.displayInfoChanged);
+        entryProto.set_displays_changed(entryProto.displays_changed() ||
+                                        update.displayInfoChanged);
         if (update.displayInfoChanged) {
+            // Only the latest displays are kept in a coalesced entry.
+            entryProto.clear_displays();
             entryProto.mutable_displays()->Reserve(
                     static_cast<int32_t>(update.displayInfos.size()));
             for (auto& [layerStack, displayInfo] : update.displayInfos) {
@@ -280,6 +343,11 @@ void TransactionTracing::addEntry(const std::vector<CommittedUpdates>& committed
             }
         }
 
+        if (coalesce && i + 1 < committedUpdates.size()) {
+            mCoalescedUpdates++;
+            continue;
+        }
+
         std::string serializedProto;
         entryProto.SerializeToString(&serializedProto);
 
@@ -321,6 +389,88 @@ void TransactionTracing::addEntry(const std::vector<CommittedUpdates>& committed
     mTransactionsAddedToBufferCv.notify_one();
 }
 
+void TransactionTracing::elideUnchangedLayerStateLocked(
+        perfetto::protos::TransactionState& transaction) {
+    for (perfetto::protos::LayerState& layerState : *transaction.mutable_layer_changes()) {
+        perfetto::protos::LayerState& lastState = mLastLayerStates[layerState.layer_id()];
+        uint64_t what = layerState.what();
+        const auto elide = [&](uint64_t flag, bool unchanged, auto clear, auto update) {
+            if (!(what & flag)) {
+                return;
+            }
+            if (unchanged) {
+                what &= ~flag;
+                clear();
+                mElidedLayerChanges++;
+            } else {
+                update();
+            }
+        };
+
+        // A field can only be compared once a value has been traced for the layer, which is
+        // tracked through the flag in the last state.
+        const auto traced = [&](uint64_t flag) { return (lastState.what() & flag) != 0; };
+        const auto markTraced = [&](uint64_t flag) { lastState.set_what(lastState.what() | flag); };
+
+        elide(
+                layer_state_t::ePositionChanged,
+                traced(layer_state_t::ePositionChanged) && lastState.x() == layerState.x() &&
+                        lastState.y() == layerState.y(),
+                [&] {
+                    layerState.clear_x();
+                    layerState.clear_y();
+                },
+                [&] {
+                    lastState.set_x(layerState.x());
+                    lastState.set_y(layerState.y());
+                    markTraced(layer_state_t::ePositionChanged);
+                });
+        elide(
+                layer_state_t::eAlphaChanged,
+                traced(layer_state_t::eAlphaChanged) && lastState.alpha() == layerState.alpha(),
+                [&] { layerState.clear_alpha(); },
+                [&] {
+                    lastState.set_alpha(layerState.alpha());
+                    markTraced(layer_state_t::eAlphaChanged);
+                });
+        elide(
+                layer_state_t::eCornerRadiusChanged,
+                traced(layer_state_t::eCornerRadiusChanged) &&
+                        lastState.corner_radius() == layerState.corner_radius(),
+                [&] { layerState.clear_corner_radius(); },
+                [&] {
+                    lastState.set_corner_radius(layerState.corner_radius());
+                    markTraced(layer_state_t::eCornerRadiusChanged);
+                });
+        elide(
+                layer_state_t::eMatrixChanged,
+                traced(layer_state_t::eMatrixChanged) &&
+                        lastState.matrix().dsdx() == layerState.matrix().dsdx() &&
+                        lastState.matrix().dtdx() == layerState.matrix().dtdx() &&
+                        lastState.matrix().dtdy() == layerState.matrix().dtdy() &&
+                        lastState.matrix().dsdy() == layerState.matrix().dsdy(),
+                [&] { layerState.clear_matrix(); },
+                [&] {
+                    *lastState.mutable_matrix() = layerState.matrix();
+                    markTraced(layer_state_t::eMatrixChanged);
+                });
+        elide(
+                layer_state_t::eCropChanged,
+                traced(layer_state_t::eCropChanged) &&
+                        lastState.crop().left() == layerState.crop().left() &&
+                        lastState.crop().top() == layerState.crop().top() &&
+                        lastState.crop().right() == layerState.crop().right() &&
+                        lastState.crop().bottom() == layerState.crop().bottom(),
+                [&] { layerState.clear_crop(); },
+                [&] {
+                    *lastState.mutable_crop() = layerState.crop();
+                    markTraced(layer_state_t::eCropChanged);
+                });
+
+        layerState.set_what(what);
+    }
+}
+
 void TransactionTracing::flush() {
     {
         std::scoped_lock lock(mMainThreadLock);
@@ -22,10 +22,13 @@
 #include <utils/Singleton.h>
 #include <utils/Timers.h>
 
+#include <atomic>
+#include <chrono>
 #include <mutex>
 #include <optional>
 #include <set>
 #include <thread>
+#include <unordered_map>
 
 #include "FrontEnd/DisplayInfo.h"
 #include "FrontEnd/LayerCreationArgs.h"
@@ -75,6 +78,14 @@ class TransactionTracingTest;
  * committed transactions) is written to perfetto. On the receiver side, the data source is to be
  * configured with a dedicated buffer large enough to store all the flushed data.
  *
+ * Two knobs trade trace fidelity for tracing cost on busy devices:
+ * - debug.sf.transaction_trace_elide_unchanged drops layer changes that set a field to the value
+ *   the layer already has, so the trace only carries the fields that actually changed.
+ * - debug.sf.transaction_trace_cpu_budget_us limits the CPU time the tracing thread spends per
+ *   second. Once the budget is spent, the committed updates that arrive for the rest of the second
+ *   are coalesced into a single entry instead of one entry per vsync. No transaction is dropped,
+ *   only the vsync granularity is lost.
+ *
  *
  * E.g. start active mode tracing:
  *
@@ -141,6 +152,8 @@ public:
     // Return buffer contents as trace file proto
     perfetto::protos::TransactionTraceFile writeToProto() EXCLUDES(mMainThreadLock);
     void setBufferSize(size_t bufferSizeInBytes);
+    // Limits the CPU time the tracing thread spends per second, 0 for no limit.
+    void setCpuBudget(std::chrono::nanoseconds cpuTimePerSecond);
     void onLayerRemoved(int layerId);
     void dump(std::string&) const;
     // Wait until all the committed transactions for the specified vsync id are added to the buffer.
@@ -202,11 +215,29 @@ private:
     std::vector<uint32_t /* layerId */> mPendingDestroyedLayers; // only accessed by main thread
     int64_t mLastUpdatedVsyncId = -1;
 
+    // The last traced value of the fields that elideUnchangedLayerStateLocked compares, per layer.
+    std::unordered_map<uint32_t /* layerId */, perfetto::protos::LayerState> mLastLayerStates
+            GUARDED_BY(mTraceLock);
+    bool mElideUnchangedLayerState GUARDED_BY(mTraceLock) = false;
+    uint64_t mElidedLayerChanges GUARDED_BY(mTraceLock) = 0;
+
+    std::atomic<nsecs_t> mCpuBudgetPerSecond = 0;
+    nsecs_t mCpuBudgetWindowStart = 0;   // only accessed by tracing thread
+    nsecs_t mCpuBudgetWindowCpuTime = 0; // only accessed by tracing thread
+    uint64_t mCoalescedUpdates GUARDED_BY(mTraceLock) = 0;
+
     void writeRingBufferToPerfetto(TransactionTracing::Mode mode);
     perfetto::protos::TransactionTraceFile createTraceFileProto() const;
     void loop();
+    // When coalesce is set, all the committed updates are written as a single entry.
     void addEntry(const std::vector<CommittedUpdates>& committedTransactions,
-                  const std::vector<uint32_t>& removedLayers) EXCLUDES(mTraceLock);
+                  const std::vector<uint32_t>& removedLayers, bool coalesce = false)
+            EXCLUDES(mTraceLock);
+    void elideUnchangedLayerStateLocked(perfetto::protos::TransactionState& transaction)
+            REQUIRES(mTraceLock);
+    // Accounts for cpuTime spent by the tracing thread and returns the time left in the current
+    // budget window if the budget has been exceeded.
+    std::optional<std::chrono::nanoseconds> consumeCpuBudget(nsecs_t cpuTime);
     int32_t getLayerIdLocked(const sp<IBinder>& layerHandle) REQUIRES(mTraceLock);
     void tryPushToTracingThread() EXCLUDES(mMainThreadLock);
     std::optional<perfetto::protos::TransactionTraceEntry> createStartingStateProtoLocked()
@@ -165,12 +165,6 @@ void TransactionCallbackInvoker::addPresentFence(sp<Fence> presentFence) {
 }
 
 void TransactionCallbackInvoker::sendCallbacks(bool onCommitOnly) {
-    for (const auto& bufferRelease : mBufferReleases) {
-        bufferRelease.channel->writeReleaseFence(bufferRelease.callbackId, bufferRelease.fence,
-                                                 bufferRelease.currentMaxAcquiredBufferCount);
-    }
-    mBufferReleases.clear();
-
     // For each listener
     auto completedTransactionsItr = mCompletedTransactions.begin();
     ftl::SmallVector<ListenerStats, 10> listenerStatsToSend;
@@ -218,14 +212,27 @@ void TransactionCallbackInvoker::sendCallbacks(bool onCommitOnly) {
         mPresentFence.clear();
     }
 
-    BackgroundExecutor::getInstance().sendCallbacks(
-            {[listenerStatsToSend = std::move(listenerStatsToSend)]() {
+    // Most frames have nothing to send, so only wake up the background thread when needed.
+    if (mBufferReleases.empty() && listenerStatsToSend.empty()) {
+        return;
+    }
+
+    // The buffer releases and transaction callbacks of a frame are delivered in one batch, with
+    // the releases written first.
+    BackgroundExecutor::getInstance(BackgroundExecutor::Lane::Callbacks)
+            .sendCallbacks({[bufferReleases = std::move(mBufferReleases),
+                             listenerStatsToSend = std::move(listenerStatsToSend)]() {
                 SFTRACE_NAME("TransactionCallbackInvoker::sendCallbacks");
+                for (const auto& [channel, callbackId, fence, maxAcquiredBufferCount] :
+                     bufferReleases) {
+                    channel->writeReleaseFence(callbackId, fence, maxAcquiredBufferCount);
+                }
                 for (auto& stats : listenerStatsToSend) {
                     interface_cast<ITransactionCompletedListener>(stats.listener)
                             ->onTransactionCompleted(stats);
                 }
             }});
+    mBufferReleases.clear();
 }
 
 // -----------------------------------------------------------------------
@@ -52,7 +52,7 @@ public:
         // Hand the sp<SurfaceControl> to the helper thread to release the last
         // reference. This makes sure that the SurfaceControl is destructed without
         // SurfaceFlinger::mStateLock held.
-        BackgroundExecutor::getInstance().sendCallbacks(
+        BackgroundExecutor::getLowPriorityInstance().sendCallbacks(
                 {[sc = std::move(mSurfaceControl)]() mutable { sc.clear(); }});
     }
 
@@ -17,6 +17,7 @@
 #include <android/gui/BnWindowInfosPublisher.h>
 #include <android/gui/IWindowInfosPublisher.h>
 #include <android/gui/WindowInfosListenerInfo.h>
+#include <android-base/properties.h>
 #include <common/trace.h>
 #include <gui/ISurfaceComposer.h>
 #include <gui/WindowInfosUpdate.h>
@@ -34,6 +35,17 @@ using gui::DisplayInfo;
 using gui::IWindowInfosListener;
 using gui::WindowInfo;
 
+using namespace std::string_literals;
+
+namespace {
+
+bool deltaUpdatesEnabled() {
+    static const bool sEnabled = base::GetBoolProperty("debug.sf.window_infos_delta"s, true);
+    return sEnabled;
+}
+
+} // namespace
+
 void WindowInfosListenerInvoker::addWindowInfosListener(sp<IWindowInfosListener> listener,
                                                         gui::WindowInfosListenerInfo* outInfo) {
     int64_t listenerId = mNextListenerId++;
@@ -71,6 +83,7 @@ void WindowInfosListenerInvoker::eraseListenerAndAckMessages(const wp<IBinder>&
     auto it = mWindowInfosListeners.find(binder);
     int64_t listenerId = it->second.first;
     mWindowInfosListeners.erase(binder);
+    mDeltaBaseVersions.erase(listenerId);
 
     std::vector<int64_t> vsyncIds;
     for (auto& [vsyncId, state] : mUnackedState) {
@@ -133,14 +146,60 @@ void WindowInfosListenerInvoker::windowInfosChanged(
     mDelayInfo.reset();
     updateMaxSendDelay();
 
+    update.version = ++mVersion;
+    // Computed on first use, since it's only useful to listeners that got the last update.
+    std::optional<gui::WindowInfosUpdate> delta;
+    bool deltaCreated = false;
+
     // Call the listeners
     for (auto& pair : mWindowInfosListeners) {
         auto& [listenerId, listener] = pair.second;
-        auto status = listener->onWindowInfosChanged(update);
+        const gui::WindowInfosUpdate* listenerUpdate = &update;
+        auto baseVersion = mDeltaBaseVersions.find(listenerId);
+        if (baseVersion != mDeltaBaseVersions.end() && mLastUpdate &&
+            baseVersion->second == mLastUpdate->version) {
+            if (!deltaCreated) {
+                SFTRACE_NAME("WindowInfosListenerInvoker::createDelta");
+                delta = update.createDelta(*mLastUpdate);
+                deltaCreated = true;
+            }
+            if (delta) {
+                listenerUpdate = &*delta;
+            }
+        }
+
+        auto status = listener->onWindowInfosChanged(*listenerUpdate);
+        if (baseVersion != mDeltaBaseVersions.end()) {
+            // A listener that missed this update needs the next one in full.
+            baseVersion->second = status.isOk() ? update.version : 0;
+        }
         if (!status.isOk()) {
             ackWindowInfosReceived(update.vsyncId, listenerId);
         }
     }
+
+    if (mDeltaBaseVersions.empty()) {
+        mLastUpdate.reset();
+    } else {
+        mLastUpdate = std::move(update);
+    }
+}
+
+binder::Status WindowInfosListenerInvoker::enableDeltaUpdates(int64_t listenerId) {
+    if (!deltaUpdatesEnabled()) {
+        return binder::Status::ok();
+    }
+    BackgroundExecutor::getInstance().sendCallbacks({[this, listenerId]() {
+        SFTRACE_NAME("WindowInfosListenerInvoker::enableDeltaUpdates");
+        const bool isListener = std::any_of(mWindowInfosListeners.begin(),
+                                            mWindowInfosListeners.end(), [&](const auto& pair) {
+                                                return pair.second.first == listenerId;
+                                            });
+        if (isListener) {
+            mDeltaBaseVersions.insert_or_assign(listenerId, 0);
+        }
+    }});
+    return binder::Status::ok();
 }
 
 WindowInfosListenerInvoker::DebugInfo WindowInfosListenerInvoker::getDebugInfo() {
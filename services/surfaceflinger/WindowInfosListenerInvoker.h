@@ -17,6 +17,7 @@
 #pragma once
 
 #include <optional>
+#include <unordered_map>
 #include <unordered_set>
 
 #include <android/gui/BnWindowInfosPublisher.h>
@@ -47,6 +48,7 @@ public:
                             bool forceImmediateCall);
 
     binder::Status ackWindowInfosReceived(int64_t, int64_t) override;
+    binder::Status enableDeltaUpdates(int64_t listenerId) override;
 
     struct DebugInfo {
         VsyncId maxSendDelayVsyncId;
@@ -69,6 +71,14 @@ private:
     WindowInfosReportedListenerSet mReportedListeners;
     void eraseListenerAndAckMessages(const wp<IBinder>&);
 
+    // Version of the last update sent to the listeners.
+    int64_t mVersion = 0;
+    // The last update sent, kept as the base of deltas while any listener accepts them.
+    std::optional<gui::WindowInfosUpdate> mLastUpdate;
+    // Listeners that accept deltas, mapped to the version of the last update they were sent, or
+    // to 0 if the next one must be sent in full.
+    std::unordered_map<int64_t /* listenerId */, int64_t /* version */> mDeltaBaseVersions;
+
     struct UnackedState {
         ftl::SmallVector<int64_t, kStaticCapacity> unackedListenerIds;
         WindowInfosReportedListenerSet reportedListeners;
@@ -41,7 +41,7 @@
 #undef ATRACE_FORMAT
 #undef ATRACE_FORMAT_INSTANT
 
-#define SFTRACE_ENABLED() ::tracing_perfetto::isTagEnabled(ATRACE_TAG)
+#define SFTRACE_ENABLED() ::tracing_perfetto::isCategoryEnabled(ATRACE_TAG)
 #define SFTRACE_BEGIN(name) ::tracing_perfetto::traceBegin(ATRACE_TAG, name)
 #define SFTRACE_END() ::tracing_perfetto::traceEnd(ATRACE_TAG)
 #define SFTRACE_ASYNC_BEGIN(name, cookie) \
@@ -52,8 +52,12 @@
 #define SFTRACE_ASYNC_FOR_TRACK_END(track_name, cookie) \
     ::tracing_perfetto::traceAsyncEndForTrack(ATRACE_TAG, track_name, cookie)
 #define SFTRACE_INSTANT(name) ::tracing_perfetto::traceInstant(ATRACE_TAG, name)
-#define SFTRACE_FORMAT_INSTANT(fmt, ...) \
-    ::tracing_perfetto::traceFormatInstant(ATRACE_TAG, fmt, ##__VA_ARGS__)
+#define SFTRACE_FORMAT_INSTANT(fmt, ...)                                          \
+    do {                                                                          \
+        if (CC_UNLIKELY(SFTRACE_ENABLED())) {                                     \
+            ::tracing_perfetto::traceFormatInstant(ATRACE_TAG, fmt, ##__VA_ARGS__); \
+        }                                                                         \
+    } while (false)
 #define SFTRACE_INSTANT_FOR_TRACK(trackName, name) \
     ::tracing_perfetto::traceInstantForTrack(ATRACE_TAG, trackName, name)
 #define SFTRACE_INT(name, value) ::tracing_perfetto::traceCounter32(ATRACE_TAG, name, value)
@@ -69,6 +73,13 @@
 #define SFTRACE_FORMAT(fmt, ...) \
     ::android::ScopedTrace PASTE(___tracer, __LINE__)(fmt, ##__VA_ARGS__)
 
+// SFTRACE_NAME_WITH_ARGS is an SFTRACE_NAME with one or two integer arguments, which are recorded
+// as Perfetto debug annotations instead of being formatted into the name, e.g.
+//   SFTRACE_NAME_WITH_ARGS("commit", "vsyncId", vsyncId);
+#define SFTRACE_NAME_WITH_ARGS(name, ...)                                                   \
+    ::android::ScopedTrace PASTE(___tracer, __LINE__)(::android::ScopedTrace::WithArgs{}, \
+                                                      name, __VA_ARGS__)
+
 #define ALOGE_AND_TRACE(fmt, ...)                   \
     do {                                            \
         ALOGE(fmt, ##__VA_ARGS__);                  \
@@ -77,14 +88,33 @@
 
 namespace android {
 
+// Only traces if the category is enabled on construction, so that the name is not formatted and the
+// slice is not ended otherwise.
 class ScopedTrace {
 public:
+    struct WithArgs {};
+
+    template <typename... Args>
+    inline ScopedTrace(const char* fmt, Args&&... args) : mEnabled(SFTRACE_ENABLED()) {
+        if (CC_UNLIKELY(mEnabled)) {
+            ::tracing_perfetto::traceFormatBegin(ATRACE_TAG, fmt, std::forward<Args>(args)...);
+        }
+    }
+    inline ScopedTrace(const char* name) : mEnabled(SFTRACE_ENABLED()) {
+        if (CC_UNLIKELY(mEnabled)) SFTRACE_BEGIN(name);
+    }
     template <typename... Args>
-    inline ScopedTrace(const char* fmt, Args&&... args) {
-        ::tracing_perfetto::traceFormatBegin(ATRACE_TAG, fmt, std::forward<Args>(args)...);
+    inline ScopedTrace(WithArgs, const char* name, Args&&... args) : mEnabled(SFTRACE_ENABLED()) {
+        if (CC_UNLIKELY(mEnabled)) {
+            ::tracing_perfetto::traceBeginWithArgs(ATRACE_TAG, name, std::forward<Args>(args)...);
+        }
     }
-    inline ScopedTrace(const char* name) { SFTRACE_BEGIN(name); }
-    inline ~ScopedTrace() { SFTRACE_END(); }
+    inline ~ScopedTrace() {
+        if (CC_UNLIKELY(mEnabled)) SFTRACE_END();
+    }
+
+private:
+    const bool mEnabled;
 };
 
 } // namespace android
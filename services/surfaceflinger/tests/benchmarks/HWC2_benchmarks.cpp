@@ -0,0 +1,120 @@
+/*
+ * Copyright (C) 2024 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <memory>
+#include <vector>
+
+#include <benchmark/benchmark.h>
+
+#include <DisplayHardware/HWC2.h>
+#include "mock/DisplayHardware/MockComposer.h"
+#include "mock/DisplayHardware/MockHWC2.h"
+
+namespace android {
+
+namespace {
+
+using ::testing::_;
+using ::testing::NiceMock;
+using ::testing::Return;
+
+namespace aidl = aidl::android::hardware::graphics::composer3;
+
+// Counts the layer commands that reach the composer.
+class LayerCommandsFixture {
+public:
+    LayerCommandsFixture(size_t numLayers, bool skipUnchangedState) {
+        ON_CALL(mDisplay, getId()).WillByDefault(Return(kDisplayId));
+        ON_CALL(mComposer, setLayerDisplayFrame(_, _, _)).WillByDefault(countCommand());
+        ON_CALL(mComposer, setLayerSourceCrop(_, _, _)).WillByDefault(countCommand());
+        ON_CALL(mComposer, setLayerZOrder(_, _, _)).WillByDefault(countCommand());
+        ON_CALL(mComposer, setLayerTransform(_, _, _)).WillByDefault(countCommand());
+        ON_CALL(mComposer, setLayerBlendMode(_, _, _)).WillByDefault(countCommand());
+        ON_CALL(mComposer, setLayerPlaneAlpha(_, _, _)).WillByDefault(countCommand());
+        ON_CALL(mComposer, setLayerColor(_, _, _)).WillByDefault(countCommand());
+        ON_CALL(mComposer, setLayerBrightness(_, _, _)).WillByDefault(countCommand());
+
+        for (size_t i = 0; i < numLayers; i++) {
+            mLayers.push_back(std::make_unique<HWC2::impl::Layer>(mComposer, mCapabilities,
+                                                                  mDisplay, i + 1,
+                                                                  skipUnchangedState));
+        }
+    }
+
+    // Writes the geometry of every layer, as OutputLayer does when any layer on the output
+    // changed geometry. Only the first layer moves.
+    void writeFrame(int frame) {
+        for (size_t i = 0; i < mLayers.size(); i++) {
+            auto& layer = *mLayers[i];
+            const int32_t offset = i == 0 ? frame % 100 : 0;
+            const Rect displayFrame(offset, 0, offset + 100, 100);
+            (void)layer.setDisplayFrame(displayFrame);
+            (void)layer.setSourceCrop(FloatRect(0.f, 0.f, 100.f, 100.f));
+            (void)layer.setZOrder(static_cast<uint32_t>(i));
+            (void)layer.setTransform(hal::Transform::NONE);
+            (void)layer.setBlendMode(hal::BlendMode::PREMULTIPLIED);
+            (void)layer.setPlaneAlpha(1.f);
+            (void)layer.setColor(aidl::Color{1.f, 1.f, 1.f, 1.f});
+            (void)layer.setBrightness(1.f);
+        }
+    }
+
+    size_t takeCommandCount() { return std::exchange(mCommandCount, 0); }
+
+private:
+    static constexpr hal::HWDisplayId kDisplayId = 1;
+
+    auto countCommand() {
+        return [this](auto&&...) {
+            mCommandCount++;
+            return Hwc2::Error::NONE;
+        };
+    }
+
+    NiceMock<Hwc2::mock::Composer> mComposer;
+    NiceMock<HWC2::mock::Display> mDisplay;
+    const std::unordered_set<aidl::Capability> mCapabilities;
+    std::vector<std::unique_ptr<HWC2::impl::Layer>> mLayers;
+    size_t mCommandCount = 0;
+};
+
+static void writeLayerCommands(benchmark::State& state, bool skipUnchangedState) {
+    LayerCommandsFixture fixture(static_cast<size_t>(state.range(0)), skipUnchangedState);
+    fixture.writeFrame(0);
+    fixture.takeCommandCount();
+
+    int frame = 1;
+    size_t commands = 0;
+    for (auto _ : state) {
+        fixture.writeFrame(frame++);
+        commands += fixture.takeCommandCount();
+    }
+    state.counters["commandsPerFrame"] =
+            benchmark::Counter(static_cast<double>(commands), benchmark::Counter::kAvgIterations);
+}
+
+static void writeAllLayerCommands(benchmark::State& state) {
+    writeLayerCommands(state, /*skipUnchangedState*/ false);
+}
+BENCHMARK(writeAllLayerCommands)->Arg(10)->Arg(50)->Arg(100);
+
+static void writeChangedLayerCommands(benchmark::State& state) {
+    writeLayerCommands(state, /*skipUnchangedState*/ true);
+}
+BENCHMARK(writeChangedLayerCommands)->Arg(10)->Arg(50)->Arg(100);
+
+} // namespace
+} // namespace android
@@ -0,0 +1,125 @@
+/*
+ * Copyright (C) 2024 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <memory>
+#include <optional>
+
+#include <benchmark/benchmark.h>
+
+#include <Client.h> // temporarily needed for LayerCreationArgs
+#include <FrontEnd/LayerCreationArgs.h>
+#include <FrontEnd/LayerHierarchy.h>
+#include <FrontEnd/LayerLifecycleManager.h>
+#include <FrontEnd/LayerSnapshotBuilder.h>
+#include <LayerLifecycleManagerHelper.h>
+
+namespace android::surfaceflinger {
+
+namespace {
+
+using namespace android::surfaceflinger::frontend;
+
+// Builds a hierarchy of visible color layers, with ten children per root layer.
+class SnapshotFixture : public LayerLifecycleManagerHelper {
+public:
+    explicit SnapshotFixture(size_t numLayers) : LayerLifecycleManagerHelper(mLifecycleManager) {
+        uint32_t rootId = 0;
+        for (uint32_t id = 1; id <= numLayers; id++) {
+            if ((id - 1) % 10 == 0) {
+                createRootLayer(id);
+                rootId = id;
+            } else {
+                createLayer(id, rootId);
+            }
+            setColor(id);
+            setPosition(id, static_cast<float>(id % 100), static_cast<float>(id % 50));
+        }
+        mHierarchyBuilder.update(mLifecycleManager);
+        mSnapshotBuilder.update(getArgs());
+        mLifecycleManager.commitChanges();
+    }
+
+    LayerSnapshotBuilder::Args getArgs() {
+        return {.root = mHierarchyBuilder.getHierarchy(),
+                .layerLifecycleManager = mLifecycleManager,
+                .displays = mDisplays,
+                .globalShadowSettings = mShadowSettings,
+                .supportedLayerGenericMetadata = mSupportedLayerGenericMetadata,
+                .genericLayerMetadataKeyMap = mGenericLayerMetadataKeyMap};
+    }
+
+    LayerLifecycleManager mLifecycleManager;
+    LayerHierarchyBuilder mHierarchyBuilder;
+    LayerSnapshotBuilder mSnapshotBuilder;
+    DisplayInfos mDisplays;
+    ShadowSettings mShadowSettings;
+    std::unordered_map<std::string, bool> mSupportedLayerGenericMetadata;
+    std::unordered_map<std::string, uint32_t> mGenericLayerMetadataKeyMap;
+};
+
+// Reads the per-frame fields by walking the snapshots themselves.
+static void iterateVisibleSnapshots(benchmark::State& state) {
+    SnapshotFixture fixture(static_cast<size_t>(state.range(0)));
+    for (auto _ : state) {
+        float totalAlpha = 0.f;
+        float totalArea = 0.f;
+        fixture.mSnapshotBuilder.forEachSnapshot([&](const LayerSnapshot& snapshot) {
+            if (!snapshot.isVisible) return;
+            totalAlpha += snapshot.alpha;
+            totalArea += snapshot.transformedBounds.getWidth() *
+                    snapshot.transformedBounds.getHeight();
+        });
+        benchmark::DoNotOptimize(totalAlpha);
+        benchmark::DoNotOptimize(totalArea);
+    }
+}
+BENCHMARK(iterateVisibleSnapshots)->Arg(100)->Arg(500)->Arg(1000);
+
+// Reads the same fields from the structure of arrays side table.
+static void iterateVisibleSnapshotTable(benchmark::State& state) {
+    SnapshotFixture fixture(static_cast<size_t>(state.range(0)));
+    for (auto _ : state) {
+        const LayerSnapshotTable& table = fixture.mSnapshotBuilder.getSnapshotTable();
+        const auto& alphas = table.getAlphas();
+        const auto& bounds = table.getTransformedBounds();
+        const auto& flags = table.getFlags();
+        float totalAlpha = 0.f;
+        float totalArea = 0.f;
+        for (size_t i = 0; i < table.size(); i++) {
+            if (!(flags[i] & LayerSnapshotTable::kVisible)) continue;
+            totalAlpha += alphas[i];
+            totalArea += bounds[i].getWidth() * bounds[i].getHeight();
+        }
+        benchmark::DoNotOptimize(totalAlpha);
+        benchmark::DoNotOptimize(totalArea);
+    }
+}
+BENCHMARK(iterateVisibleSnapshotTable)->Arg(100)->Arg(500)->Arg(1000);
+
+// Cost of keeping the table in sync on a frame with a geometry change.
+static void updateSnapshotsWithGeometryChange(benchmark::State& state) {
+    SnapshotFixture fixture(static_cast<size_t>(state.range(0)));
+    int i = 0;
+    for (auto _ : state) {
+        fixture.setPosition(1, static_cast<float>(i++ % 100), 0.f);
+        fixture.mSnapshotBuilder.update(fixture.getArgs());
+        fixture.mLifecycleManager.commitChanges();
+    }
+}
+BENCHMARK(updateSnapshotsWithGeometryChange)->Arg(100)->Arg(500)->Arg(1000);
+
+} // namespace
+} // namespace android::surfaceflinger
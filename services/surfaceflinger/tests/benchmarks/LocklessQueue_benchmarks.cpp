@@ -16,6 +16,7 @@
 
 #include <memory>
 #include <optional>
+#include <vector>
 
 #include <benchmark/benchmark.h>
 
@@ -34,5 +35,33 @@ static void pushPop(benchmark::State& state) {
 }
 BENCHMARK(pushPop);
 
+// Pushes a frame worth of values and drains them in one batch, as collectTransactions does.
+template <typename Queue>
+static void pushPopAll(benchmark::State& state, Queue& queue) {
+    const auto batchSize = static_cast<size_t>(state.range(0));
+    std::vector<std::vector<uint32_t>> popped;
+    for (auto _ : state) {
+        for (size_t i = 0; i < batchSize; i++) {
+            queue.push({10, 5});
+        }
+        queue.popAll(popped);
+        benchmark::DoNotOptimize(popped);
+        popped.clear();
+    }
+}
+
+static void unboundedPushPopAll(benchmark::State& state) {
+    LocklessQueue<std::vector<uint32_t>> queue;
+    pushPopAll(state, queue);
+}
+BENCHMARK(unboundedPushPopAll)->Arg(8)->Arg(64);
+
+static void boundedPushPopAll(benchmark::State& state) {
+    // The 64 value batch overflows the ring.
+    BoundedLocklessQueue<std::vector<uint32_t>> queue(32);
+    pushPopAll(state, queue);
+}
+BENCHMARK(boundedPushPopAll)->Arg(8)->Arg(64);
+
 } // namespace
 } // namespace android::surfaceflinger
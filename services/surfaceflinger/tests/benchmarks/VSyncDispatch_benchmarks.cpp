@@ -0,0 +1,127 @@
+/*
+ * Copyright (C) 2024 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <memory>
+#include <thread>
+#include <vector>
+
+#include <benchmark/benchmark.h>
+
+#include <scheduler/Timer.h>
+
+#include "Scheduler/VSyncDispatchTimerQueue.h"
+#include "mock/MockVSyncTracker.h"
+
+namespace android::scheduler {
+
+namespace {
+
+using namespace std::chrono_literals;
+using ::testing::_;
+using ::testing::Invoke;
+using ::testing::NiceMock;
+
+constexpr nsecs_t kPeriod = std::chrono::nanoseconds(16ms).count();
+
+// Dispatches on a real timer thread, against a tracker with a fixed period.
+class DispatchFixture {
+public:
+    DispatchFixture() {
+        ON_CALL(*mTracker, nextAnticipatedVSyncTimeFrom(_, _))
+                .WillByDefault(Invoke([](nsecs_t timePoint, std::optional<nsecs_t>) {
+                    return (timePoint / kPeriod + 1) * kPeriod;
+                }));
+        ON_CALL(*mTracker, currentPeriod()).WillByDefault(Invoke([] { return kPeriod; }));
+        mDispatch = std::make_shared<VSyncDispatchTimerQueue>(std::make_unique<Timer>(), mTracker,
+                                                              /*timerSlack*/ 500'000,
+                                                              /*minVsyncDistance*/ 3'000'000);
+    }
+
+    std::shared_ptr<VSyncDispatchTimerQueue> getDispatch() const { return mDispatch; }
+
+private:
+    std::shared_ptr<NiceMock<android::mock::VSyncTracker>> mTracker =
+            std::make_shared<NiceMock<android::mock::VSyncTracker>>();
+    std::shared_ptr<VSyncDispatchTimerQueue> mDispatch;
+};
+
+// Registrations on other threads that keep rescheduling, as EventThreads and MessageQueue do,
+// with a short work duration so that the timer thread fires often.
+class Contenders {
+public:
+    Contenders(const std::shared_ptr<VSyncDispatchTimerQueue>& dispatch, int count) {
+        for (int i = 0; i < count; i++) {
+            mThreads.emplace_back([this, dispatch, i] {
+                VSyncCallbackRegistration registration(dispatch, [](nsecs_t, nsecs_t, nsecs_t) {},
+                                                       "contender" + std::to_string(i));
+                while (!mStop) {
+                    registration.schedule({.workDuration = kPeriod - 100'000,
+                                           .readyDuration = 0,
+                                           .lastVsync = systemTime()});
+                    if (i % 2) {
+                        registration.cancel();
+                    }
+                }
+            });
+        }
+    }
+
+    ~Contenders() {
+        mStop = true;
+        for (auto& thread : mThreads) {
+            thread.join();
+        }
+    }
+
+private:
+    std::atomic_bool mStop = false;
+    std::vector<std::thread> mThreads;
+};
+
+// Measures how long schedule() blocks the caller while the timer thread and other callers hold
+// the dispatch lock, and reports the tail latency.
+static void scheduleLatency(benchmark::State& state) {
+    DispatchFixture fixture;
+    Contenders contenders(fixture.getDispatch(), static_cast<int>(state.range(0)));
+    VSyncCallbackRegistration registration(fixture.getDispatch(), [](nsecs_t, nsecs_t, nsecs_t) {},
+                                           "benchmark");
+
+    std::vector<nsecs_t> latencies;
+    latencies.reserve(state.max_iterations);
+    for (auto _ : state) {
+        const nsecs_t start = systemTime();
+        const auto result = registration.schedule(
+                {.workDuration = 8'000'000, .readyDuration = 0, .lastVsync = start});
+        latencies.push_back(systemTime() - start);
+        benchmark::DoNotOptimize(result);
+    }
+
+    if (latencies.empty()) return;
+    std::sort(latencies.begin(), latencies.end());
+    const auto percentile = [&](double p) {
+        return static_cast<double>(latencies[static_cast<size_t>(p * (latencies.size() - 1))]);
+    };
+    state.counters["p50_ns"] = percentile(0.5);
+    state.counters["p99_ns"] = percentile(0.99);
+    state.counters["max_ns"] = static_cast<double>(latencies.back());
+}
+BENCHMARK(scheduleLatency)->Arg(0)->Arg(2)->Arg(4)->UseRealTime();
+
+} // namespace
+} // namespace android::scheduler
@@ -1,5 +1,6 @@
 #include <gtest/gtest.h>
 #include <condition_variable>
+#include <memory>
 
 #include "BackgroundExecutor.h"
 
@@ -52,6 +53,69 @@ TEST_F(BackgroundExecutorTest, multipleProducers) {
     ASSERT_EQ(backgroundTaskCount, backgroundTaskCompleteCount);
 }
 
+TEST_F(BackgroundExecutorTest, lanesRunIndependently) {
+    std::mutex mutex;
+    std::condition_variable condition_variable;
+    bool unblocked = false;
+
+    // Block the low priority lane, the callbacks lane should still make progress.
+    auto& lowPriority = BackgroundExecutor::getLowPriorityInstance();
+    lowPriority.sendCallbacks({[&]() {
+        std::unique_lock<std::mutex> lock{mutex};
+        condition_variable.wait(lock, [&unblocked]() { return unblocked; });
+    }});
+
+    auto& callbacks = BackgroundExecutor::getInstance(BackgroundExecutor::Lane::Callbacks);
+    const uint64_t executedTasks = callbacks.getStats().executedTasks;
+    callbacks.flushQueue();
+    EXPECT_GT(callbacks.getStats().executedTasks, executedTasks);
+    EXPECT_GE(lowPriority.getStats().pendingTasks, 1u);
+
+    {
+        std::lock_guard<std::mutex> lock{mutex};
+        unblocked = true;
+    }
+    condition_variable.notify_one();
+    lowPriority.flushQueue();
+
+    std::string dump;
+    BackgroundExecutor::dumpAll(dump);
+    EXPECT_NE(dump.find("Callbacks"), std::string::npos);
+    EXPECT_NE(dump.find("LowPriority"), std::string::npos);
+}
+
+TEST_F(BackgroundExecutorTest, teardownLaneIsNotBlockedByLowPriorityLane) {
+    std::mutex mutex;
+    std::condition_variable condition_variable;
+    bool unblocked = false;
+
+    auto& lowPriority = BackgroundExecutor::getLowPriorityInstance();
+    lowPriority.sendCallbacks({[&]() {
+        std::unique_lock<std::mutex> lock{mutex};
+        condition_variable.wait(lock, [&unblocked]() { return unblocked; });
+    }});
+
+    // A batch of layer teardowns runs while the low priority lane is blocked.
+    auto& teardown = BackgroundExecutor::getInstance(BackgroundExecutor::Lane::Teardown);
+    auto resource = std::make_shared<int>(0);
+    BackgroundExecutor::Callbacks batch;
+    for (int i = 0; i < 20; i++) {
+        batch.push_back([resource]() mutable { resource.reset(); });
+    }
+    std::weak_ptr<int> weakResource = resource;
+    resource.reset();
+    teardown.sendCallbacks(std::move(batch));
+    teardown.flushQueue();
+    EXPECT_TRUE(weakResource.expired());
+
+    {
+        std::lock_guard<std::mutex> lock{mutex};
+        unblocked = true;
+    }
+    condition_variable.notify_one();
+    lowPriority.flushQueue();
+}
+
 } // namespace
 
 } // namespace android
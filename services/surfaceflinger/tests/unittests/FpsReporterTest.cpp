@@ -210,5 +210,35 @@ TEST_F(FpsReporterTest, rateLimits) {
     EXPECT_EQ(secondFps, mFpsListener->lastReportedFps);
 }
 
+TEST_F(FpsReporterTest, looksUpLayersAgainAfterHierarchyChanged) {
+    constexpr int32_t kTaskId = 12;
+    LayerMetadata targetMetadata;
+    targetMetadata.setInt32(gui::METADATA_TASK_ID, kTaskId);
+
+    createRootLayer(1, targetMetadata);
+    createLayer(11, 1);
+
+    frontend::LayerHierarchyBuilder hierarchyBuilder;
+    hierarchyBuilder.update(mLifecycleManager);
+    mLifecycleManager.commitChanges();
+
+    EXPECT_CALL(mFrameTimeline, computeFps(UnorderedElementsAre(1, 11))).WillOnce(Return(44.f));
+    mFpsReporter->addListener(mFpsListener, kTaskId);
+    mClock->advanceTime(600ms);
+    mFpsReporter->dispatchLayerFps(hierarchyBuilder.getHierarchy());
+    Mock::VerifyAndClearExpectations(&mFrameTimeline);
+
+    createLayer(111, 11);
+    hierarchyBuilder.update(mLifecycleManager);
+    mLifecycleManager.commitChanges();
+    mFpsReporter->onHierarchyChanged();
+
+    EXPECT_CALL(mFrameTimeline, computeFps(UnorderedElementsAre(1, 11, 111)))
+            .WillOnce(Return(53.f));
+    mClock->advanceTime(600ms);
+    mFpsReporter->dispatchLayerFps(hierarchyBuilder.getHierarchy());
+    EXPECT_EQ(53.f, mFpsListener->lastReportedFps);
+}
+
 } // namespace
 } // namespace android
@@ -161,6 +161,11 @@ public:
         return mFrameTimeline->mDisplayFrames[idx];
     }
 
+    std::shared_ptr<impl::FrameTimeline::DisplayFrame> getCurrentDisplayFrame() {
+        std::lock_guard<std::mutex> lock(mFrameTimeline->mMutex);
+        return mFrameTimeline->mCurrentDisplayFrame;
+    }
+
     static bool compareTimelineItems(const TimelineItem& a, const TimelineItem& b) {
         return a.startTime == b.startTime && a.endTime == b.endTime &&
                 a.presentTime == b.presentTime;
@@ -501,6 +506,38 @@ TEST_F(FrameTimelineTest, surfaceFrameEndTimeAcquireFenceBeforeQueue) {
     EXPECT_EQ(surfaceFrame->getActuals().endTime, 456);
 }
 
+TEST_F(FrameTimelineTest, displayFramesAreRecycled) {
+    auto presentFence = fenceFactory.createFenceTimeForTest(Fence::NO_FENCE);
+    presentFence->signalForTest(2);
+
+    const auto addDisplayFrame = [&] {
+        auto surfaceFrame =
+                mFrameTimeline->createSurfaceFrameForToken({}, sPidOne, sUidOne, sLayerIdOne,
+                                                           sLayerNameOne, sLayerNameOne,
+                                                           /*isBuffer*/ true, sGameMode);
+        int64_t sfToken = mTokenManager->generateTokenForPredictions({22, 26, 30});
+        mFrameTimeline->setSfWakeUp(sfToken, 22, RR_11, RR_11);
+        surfaceFrame->setPresentState(SurfaceFrame::PresentState::Presented);
+        mFrameTimeline->addSurfaceFrame(surfaceFrame);
+        mFrameTimeline->setSfPresent(27, presentFence);
+    };
+
+    for (size_t i = 0; i < *maxDisplayFrames + 10; i++) {
+        addDisplayFrame();
+    }
+
+    const impl::FrameTimeline::DisplayFrame* oldestDisplayFrame = getDisplayFrame(0).get();
+    addDisplayFrame();
+
+    // The oldest DisplayFrame was reused for the next frame, with all of its state cleared.
+    const auto currentDisplayFrame = getCurrentDisplayFrame();
+    EXPECT_EQ(currentDisplayFrame.get(), oldestDisplayFrame);
+    EXPECT_TRUE(currentDisplayFrame->getSurfaceFrames().empty());
+    EXPECT_EQ(currentDisplayFrame->getFramePresentMetadata(),
+              FramePresentMetadata::UnknownPresent);
+    EXPECT_EQ(currentDisplayFrame->getJankType(), JankType::None);
+}
+
 TEST_F(FrameTimelineTest, setMaxDisplayFramesSetsSizeProperly) {
     auto presentFence = fenceFactory.createFenceTimeForTest(Fence::NO_FENCE);
     presentFence->signalForTest(2);
@@ -536,8 +536,9 @@ struct HWComposerLayerTest : public testing::Test {
     static constexpr hal::HWDisplayId kDisplayId = static_cast<hal::HWDisplayId>(1001);
     static constexpr hal::HWLayerId kLayerId = static_cast<hal::HWLayerId>(1002);
 
-    HWComposerLayerTest(const std::unordered_set<aidl::Capability>& capabilities)
-          : mCapabilies(capabilities) {
+    HWComposerLayerTest(const std::unordered_set<aidl::Capability>& capabilities,
+                        bool skipUnchangedState = false)
+          : mCapabilies(capabilities), mSkipUnchangedState(skipUnchangedState) {
         EXPECT_CALL(mDisplay, getId()).WillRepeatedly(Return(kDisplayId));
     }
 
@@ -548,8 +549,9 @@ struct HWComposerLayerTest : public testing::Test {
 
     std::unique_ptr<Hwc2::mock::Composer> mHal{new StrictMock<Hwc2::mock::Composer>()};
     const std::unordered_set<aidl::Capability> mCapabilies;
+    const bool mSkipUnchangedState;
     StrictMock<HWC2::mock::Display> mDisplay;
-    HWC2::impl::Layer mLayer{*mHal, mCapabilies, mDisplay, kLayerId};
+    HWC2::impl::Layer mLayer{*mHal, mCapabilies, mDisplay, kLayerId, mSkipUnchangedState};
 };
 
 struct HWComposerLayerGenericMetadataTest : public HWComposerLayerTest {
@@ -598,4 +600,36 @@ TEST_F(HWComposerLayerGenericMetadataTest, forwardsSupportedMetadata) {
     EXPECT_EQ(hal::Error::UNSUPPORTED, result);
 }
 
+struct HWComposerLayerSkipUnchangedStateTest : public HWComposerLayerTest {
+    HWComposerLayerSkipUnchangedStateTest() : HWComposerLayerTest({}, true) {}
+};
+
+TEST_F(HWComposerLayerSkipUnchangedStateTest, sendsOnlyChangedState) {
+    const Rect frame(0, 0, 100, 100);
+    EXPECT_CALL(*mHal, setLayerDisplayFrame(kDisplayId, kLayerId, _))
+            .Times(2)
+            .WillRepeatedly(Return(V2_4::Error::NONE));
+    EXPECT_CALL(*mHal, setLayerZOrder(kDisplayId, kLayerId, 1u))
+            .WillOnce(Return(V2_4::Error::NONE));
+
+    EXPECT_EQ(hal::Error::NONE, mLayer.setDisplayFrame(frame));
+    EXPECT_EQ(hal::Error::NONE, mLayer.setZOrder(1u));
+
+    // The same state on the next frame is not sent again.
+    EXPECT_EQ(hal::Error::NONE, mLayer.setDisplayFrame(frame));
+    EXPECT_EQ(hal::Error::NONE, mLayer.setZOrder(1u));
+
+    EXPECT_EQ(hal::Error::NONE, mLayer.setDisplayFrame(Rect(0, 0, 50, 50)));
+}
+
+TEST_F(HWComposerLayerSkipUnchangedStateTest, resendsStateAfterError) {
+    EXPECT_CALL(*mHal, setLayerPlaneAlpha(kDisplayId, kLayerId, 0.5f))
+            .WillOnce(Return(V2_4::Error::NO_RESOURCES))
+            .WillOnce(Return(V2_4::Error::NONE));
+
+    EXPECT_EQ(hal::Error::NO_RESOURCES, mLayer.setPlaneAlpha(0.5f));
+    EXPECT_EQ(hal::Error::NONE, mLayer.setPlaneAlpha(0.5f));
+    EXPECT_EQ(hal::Error::NONE, mLayer.setPlaneAlpha(0.5f));
+}
+
 } // namespace android
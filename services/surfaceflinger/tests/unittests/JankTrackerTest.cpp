@@ -16,6 +16,7 @@
 
 #include <android/gui/BnJankListener.h>
 #include <binder/IInterface.h>
+#include <gui/JankDataChannel.h>
 #include "BackgroundExecutor.h"
 #include "Jank/JankTracker.h"
 
@@ -35,8 +36,11 @@ public:
 
     MOCK_METHOD(binder::Status, onJankData, (const std::vector<gui::JankData>& jankData),
                 (override));
+    MOCK_METHOD(binder::Status, onJankDataPublished, (), (override));
 };
 
+constexpr pid_t kPid = 4321;
+
 } // anonymous namespace
 
 class JankTrackerTest : public Test {
@@ -49,6 +53,22 @@ public:
         JankTracker::addJankListener(layerId, IInterface::asBinder(mListener));
     }
 
+    void addChannelJankListener(int32_t layerId) {
+        JankTracker::addJankListener(layerId, IInterface::asBinder(mListener), kPid);
+    }
+
+    std::unique_ptr<gui::JankDataChannel::Consumer> openJankDataChannel() {
+        std::unique_ptr<gui::JankDataChannel::Consumer> consumer;
+        base::unique_fd fd =
+                JankTracker::openJankDataChannel(kPid, IInterface::asBinder(mListener));
+        EXPECT_EQ(OK, gui::JankDataChannel::createConsumer(std::move(fd), consumer));
+        return consumer;
+    }
+
+    void closeJankDataChannel() {
+        JankTracker::getInstance().dropJankDataChannel(kPid, IInterface::asBinder(mListener).get());
+    }
+
     void removeJankListener(int32_t layerId, int64_t after) {
         JankTracker::removeJankListener(layerId, IInterface::asBinder(mListener), after);
     }
@@ -199,6 +219,46 @@ TEST_F(JankTrackerTest, listenerCountTracksRegistrations) {
     EXPECT_EQ(listenerCount(), 0u);
 }
 
+TEST_F(JankTrackerTest, jankDataIsWrittenToChannelAndPublishedInBatches) {
+    ASSERT_EQ(listenerCount(), 0u);
+
+    // needs to be larger than kJankDataBatchSize in JankTracker.cpp.
+    constexpr size_t kNumberOfJankDataToSend = 123;
+
+    auto consumer = openJankDataChannel();
+    ASSERT_NE(consumer, nullptr);
+
+    std::vector<gui::JankDataChannel::Entry> entries;
+    EXPECT_CALL(*mListener.get(), onJankDataPublished()).WillRepeatedly([&]() {
+        EXPECT_EQ(consumer->read(entries), 0u);
+        return binder::Status::ok();
+    });
+
+    addChannelJankListener(123);
+    for (size_t i = 0; i < kNumberOfJankDataToSend; i++) {
+        addJankData(123, 1);
+    }
+
+    flushBackgroundThread();
+    // Check that some data was published, without explicitly flushing.
+    EXPECT_GT(entries.size(), 0u);
+    EXPECT_LT(entries.size(), kNumberOfJankDataToSend);
+
+    removeJankListener(123, 0);
+    JankTracker::flushJankData(123);
+    flushBackgroundThread();
+    EXPECT_EQ(listenerCount(), 0u);
+
+    ASSERT_EQ(entries.size(), kNumberOfJankDataToSend);
+    for (size_t i = 0; i < entries.size(); i++) {
+        EXPECT_EQ(entries[i].layerId, 123);
+        EXPECT_EQ(entries[i].data.frameVsyncId, static_cast<int64_t>(1000 + i));
+        EXPECT_EQ(entries[i].data.jankType, 1);
+    }
+
+    closeJankDataChannel();
+}
+
 TEST_F(JankTrackerTest, listenerCountIsAccurateOnDuplicateRegistration) {
     ASSERT_EQ(listenerCount(), 0u);
 
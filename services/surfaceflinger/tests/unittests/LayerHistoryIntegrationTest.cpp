@@ -98,6 +98,9 @@ protected:
     }
 
     size_t layerCount() const { return mScheduler->layerHistorySize(); }
+    size_t inactiveLayersVisited() const NO_THREAD_SAFETY_ANALYSIS {
+        return history().mLastSummarizeStats.inactiveLayersVisited;
+    }
     size_t activeLayerCount() const NO_THREAD_SAFETY_ANALYSIS {
         return history().mActiveLayerInfos.size();
     }
@@ -273,6 +276,33 @@ TEST_F(LayerHistoryIntegrationTest, oneLayer) {
     }
 }
 
+TEST_F(LayerHistoryIntegrationTest, summarizeSkipsUnchangedInactiveLayers) {
+    createLegacyAndFrontedEndLayer(1);
+    createLegacyAndFrontedEndLayer(2);
+    nsecs_t time = systemTime();
+    updateLayerSnapshotsAndLayerHistory(time);
+
+    // Newly registered layers are visited once.
+    EXPECT_TRUE(summarizeLayerHistory(time).empty());
+    EXPECT_EQ(2u, inactiveLayersVisited());
+    EXPECT_TRUE(summarizeLayerHistory(time).empty());
+    EXPECT_EQ(0u, inactiveLayersVisited());
+
+    // A layer that posts a buffer becomes active, and goes back to the inactive layers
+    // without being visited again once its history expires.
+    setBuffer(1);
+    updateLayerSnapshotsAndLayerHistory(time);
+    EXPECT_EQ(1u, summarizeLayerHistory(time).size());
+    EXPECT_EQ(1u, activeLayerCount());
+    EXPECT_EQ(0u, inactiveLayersVisited());
+
+    time += MAX_ACTIVE_LAYER_PERIOD_NS.count() + 1;
+    EXPECT_TRUE(summarizeLayerHistory(time).empty());
+    EXPECT_EQ(0u, activeLayerCount());
+    EXPECT_TRUE(summarizeLayerHistory(time).empty());
+    EXPECT_EQ(0u, inactiveLayersVisited());
+}
+
 TEST_F(LayerHistoryIntegrationTest, gameFrameRateOverrideMapping) {
     SET_FLAG_FOR_TEST(flags::game_default_frame_rate, true);
 
@@ -102,7 +102,8 @@ protected:
                                         .globalShadowSettings = globalShadowSettings,
                                         .supportsBlur = true,
                                         .supportedLayerGenericMetadata = {},
-                                        .genericLayerMetadataKeyMap = {}};
+                                        .genericLayerMetadataKeyMap = {},
+                                        .incrementalUpdates = mIncrementalUpdates};
         update(actualBuilder, args);
 
         // rebuild layer snapshots from scratch and verify that it matches the updated state.
@@ -117,6 +118,22 @@ protected:
                     actualVisibleLayerIdsInZOrder.push_back(snapshot.path.id);
                 });
         EXPECT_EQ(expectedVisibleLayerIdsInZOrder, actualVisibleLayerIdsInZOrder);
+
+        if (mIncrementalUpdates) {
+            // Skipped subtrees must end up in the same state as a full rebuild.
+            expectedBuilder.forEachSnapshot([&](const LayerSnapshot& expected) {
+                SCOPED_TRACE(expected.getDebugString());
+                const LayerSnapshot* actual = actualBuilder.getSnapshot(expected.path);
+                ASSERT_NE(actual, nullptr);
+                EXPECT_EQ(expected.reachablilty, actual->reachablilty);
+                EXPECT_EQ(expected.frameRate, actual->frameRate);
+                EXPECT_EQ(expected.inheritedFrameRate, actual->inheritedFrameRate);
+                EXPECT_EQ(expected.geomLayerTransform, actual->geomLayerTransform);
+                EXPECT_EQ(expected.geomLayerBounds, actual->geomLayerBounds);
+                EXPECT_EQ(expected.alpha, actual->alpha);
+                EXPECT_EQ(expected.isHiddenByPolicyFromParent, actual->isHiddenByPolicyFromParent);
+            });
+        }
     }
 
     LayerSnapshot* getSnapshot(uint32_t layerId) { return mSnapshotBuilder.getSnapshot(layerId); }
@@ -124,6 +141,7 @@ protected:
         return mSnapshotBuilder.getSnapshot(path);
     }
     LayerSnapshotBuilder mSnapshotBuilder;
+    bool mIncrementalUpdates = false;
     static const std::vector<uint32_t> STARTING_ZORDER;
 };
 const std::vector<uint32_t> LayerSnapshotTest::STARTING_ZORDER = {1,   11,   111, 12, 121,
@@ -1935,4 +1953,158 @@ TEST_F(LayerSnapshotTest, shouldUpdateInputWhenNoInputInfo) {
     EXPECT_FALSE(getSnapshot(2)->hasInputInfo());
 }
 
+TEST_F(LayerSnapshotTest, parallelSubtreeUpdateMatchesSerialUpdate) {
+    createRootLayer(3);
+    createLayer(31, 3);
+    createRootLayer(4);
+    createLayer(41, 4);
+    setLayerStack(3, 1);
+    setLayerStack(4, 2);
+    // 2 is relative to a layer in another subtree so both subtrees are updated serially.
+    reparentRelativeLayer(2, 11);
+    setPosition(31, 10, 20);
+    setAlpha(41, 0.5f);
+    mHierarchyBuilder.update(mLifecycleManager);
+
+    LayerSnapshotBuilder::Args args{.root = mHierarchyBuilder.getHierarchy(),
+                                    .layerLifecycleManager = mLifecycleManager,
+                                    .includeMetadata = false,
+                                    .displays = mFrontEndDisplayInfos,
+                                    .globalShadowSettings = globalShadowSettings,
+                                    .supportsBlur = true,
+                                    .supportedLayerGenericMetadata = {},
+                                    .genericLayerMetadataKeyMap = {},
+                                    .parallelSubtreeWorkers = 2};
+    LayerSnapshotBuilder parallelBuilder;
+    parallelBuilder.update(args);
+
+    args.parallelSubtreeWorkers = 0;
+    LayerSnapshotBuilder serialBuilder(args);
+    mLifecycleManager.commitChanges();
+
+    std::vector<uint32_t> parallelZOrder;
+    parallelBuilder.forEachVisibleSnapshot([&](const LayerSnapshot& snapshot) {
+        parallelZOrder.push_back(snapshot.path.id);
+    });
+    std::vector<uint32_t> serialZOrder;
+    serialBuilder.forEachVisibleSnapshot([&](const LayerSnapshot& snapshot) {
+        serialZOrder.push_back(snapshot.path.id);
+    });
+    EXPECT_EQ(serialZOrder, parallelZOrder);
+
+    for (uint32_t id : serialZOrder) {
+        SCOPED_TRACE(id);
+        const LayerSnapshot* expected = serialBuilder.getSnapshot(id);
+        const LayerSnapshot* actual = parallelBuilder.getSnapshot(id);
+        ASSERT_NE(actual, nullptr);
+        EXPECT_EQ(expected->globalZ, actual->globalZ);
+        EXPECT_EQ(expected->geomLayerTransform, actual->geomLayerTransform);
+        EXPECT_EQ(expected->geomLayerBounds, actual->geomLayerBounds);
+        EXPECT_EQ(expected->alpha, actual->alpha);
+        EXPECT_EQ(expected->outputFilter.layerStack, actual->outputFilter.layerStack);
+        EXPECT_EQ(expected->isHiddenByPolicyFromRelativeParent,
+                  actual->isHiddenByPolicyFromRelativeParent);
+    }
+
+    // Subsequent updates reuse the worker pool.
+    setPosition(41, 5, 5);
+    args.parallelSubtreeWorkers = 2;
+    update(parallelBuilder, args);
+    mLifecycleManager.commitChanges();
+    EXPECT_EQ(parallelBuilder.getSnapshot(41)->geomLayerTransform.tx(), 5.f);
+}
+
+TEST_F(LayerSnapshotTest, incrementalUpdateSkipsUnaffectedSubtrees) {
+    mIncrementalUpdates = true;
+
+    // ROOT
+    // ├── 1
+    // │   ├── 11
+    // │   │   └── 111
+    // │   ├── 12
+    // │   │   ├── 121
+    // │   │   └── 122
+    // │   │       └── 1221
+    // │   ├── 13
+    // │   └── 14 (new layer)
+    // └── 2
+    createLayer(14, 1);
+    UPDATE_AND_VERIFY(mSnapshotBuilder, {1, 11, 111, 12, 121, 122, 1221, 13, 14, 2});
+    EXPECT_TRUE(getSnapshot(14)->changes.test(RequestedLayerState::Changes::Created));
+    EXPECT_EQ(getSnapshot(1221)->changes.get(), 0u);
+    EXPECT_EQ(getSnapshot(2)->changes.get(), 0u);
+
+    reparentLayer(14, UNASSIGNED_LAYER_ID);
+    UPDATE_AND_VERIFY(mSnapshotBuilder, STARTING_ZORDER);
+    EXPECT_EQ(getSnapshot(14)->reachablilty, LayerSnapshot::Reachablilty::Unreachable);
+    EXPECT_EQ(getSnapshot(1221)->changes.get(), 0u);
+
+    setPosition(12, 10, 10);
+    UPDATE_AND_VERIFY(mSnapshotBuilder, STARTING_ZORDER);
+    EXPECT_TRUE(getSnapshot(1221)->changes.test(RequestedLayerState::Changes::Geometry));
+    EXPECT_EQ(getSnapshot(111)->changes.get(), 0u);
+}
+
+TEST_F(LayerSnapshotTest, incrementalUpdatePropagatesFrameRateToAncestors) {
+    mIncrementalUpdates = true;
+
+    createLayer(1222, 122);
+    setFrameRate(1222, 90.0, ANATIVEWINDOW_FRAME_RATE_EXACT,
+                 ANATIVEWINDOW_CHANGE_FRAME_RATE_ALWAYS);
+    UPDATE_AND_VERIFY(mSnapshotBuilder, {1, 11, 111, 12, 121, 122, 1221, 1222, 13, 2});
+    EXPECT_EQ(getSnapshot(1)->frameRate.vote.type, scheduler::FrameRateCompatibility::NoVote);
+    EXPECT_EQ(getSnapshot(122)->frameRate.vote.type, scheduler::FrameRateCompatibility::NoVote);
+    EXPECT_EQ(getSnapshot(13)->frameRate.vote.type, scheduler::FrameRateCompatibility::Default);
+
+    // Removing the only voting child resets the votes of its ancestors.
+    reparentLayer(1222, UNASSIGNED_LAYER_ID);
+    destroyLayerHandle(1222);
+    UPDATE_AND_VERIFY(mSnapshotBuilder, STARTING_ZORDER);
+    EXPECT_EQ(getSnapshot(1)->frameRate.vote.type, scheduler::FrameRateCompatibility::Default);
+    EXPECT_EQ(getSnapshot(122)->frameRate.vote.type, scheduler::FrameRateCompatibility::Default);
+}
+
+TEST_F(LayerSnapshotTest, incrementalUpdateHandlesRelativeLayers) {
+    mIncrementalUpdates = true;
+
+    reparentRelativeLayer(13, 11);
+    UPDATE_AND_VERIFY(mSnapshotBuilder, {1, 11, 13, 111, 12, 121, 122, 1221, 2});
+
+    hideLayer(11);
+    UPDATE_AND_VERIFY(mSnapshotBuilder, {1, 12, 121, 122, 1221, 2});
+
+    showLayer(11);
+    removeRelativeZ(13);
+    UPDATE_AND_VERIFY(mSnapshotBuilder, STARTING_ZORDER);
+}
+
+TEST_F(LayerSnapshotTest, snapshotTableMatchesVisibleSnapshots) {
+    setColor(11);
+    setColor(121);
+    setAlpha(121, 0.5f);
+    setPosition(121, 10, 20);
+    UPDATE_AND_VERIFY(mSnapshotBuilder, STARTING_ZORDER);
+
+    const LayerSnapshotTable& table = mSnapshotBuilder.getSnapshotTable();
+    size_t numVisible = 0;
+    for (size_t i = 0; i < table.size(); i++) {
+        const LayerSnapshot& snapshot = table.getSnapshot(i);
+        EXPECT_EQ(snapshot.globalZ, i);
+        EXPECT_EQ(table.hasFlags(i, LayerSnapshotTable::kVisible), snapshot.isVisible);
+        EXPECT_EQ(table.getAlphas()[i], snapshot.alpha);
+        EXPECT_EQ(table.getTransforms()[i], snapshot.geomLayerTransform);
+        EXPECT_EQ(table.getTransformedBounds()[i], snapshot.transformedBounds);
+        EXPECT_EQ(table.getLayerStacks()[i], snapshot.outputFilter.layerStack);
+        if (snapshot.isVisible) numVisible++;
+    }
+    EXPECT_EQ(numVisible, STARTING_ZORDER.size());
+
+    // The table is rebuilt when the visibility changes.
+    hideLayer(121);
+    UPDATE_AND_VERIFY(mSnapshotBuilder, {1, 11, 111, 12, 122, 1221, 13, 2});
+    const size_t z = getSnapshot(121)->globalZ;
+    ASSERT_LT(z, table.size());
+    EXPECT_FALSE(table.hasFlags(z, LayerSnapshotTable::kVisible));
+}
+
 } // namespace android::surfaceflinger::frontend
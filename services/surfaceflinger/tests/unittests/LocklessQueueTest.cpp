@@ -0,0 +1,222 @@
+/*
+ * Copyright 2024 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <gmock/gmock.h>
+#include <gtest/gtest.h>
+
+#include <condition_variable>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <utility>
+#include <vector>
+
+#include "LocklessQueue.h"
+
+namespace android {
+namespace {
+
+using testing::ElementsAre;
+using testing::IsEmpty;
+
+using Value = std::pair<int /*producer*/, int /*index*/>;
+
+TEST(LocklessQueueTest, popAllReturnsValuesInPushOrder) {
+    LocklessQueue<int> queue;
+    queue.push(1);
+    queue.push(2);
+    EXPECT_EQ(1, queue.pop());
+    queue.push(3);
+
+    std::vector<int> values;
+    queue.popAll(values);
+    EXPECT_THAT(values, ElementsAre(2, 3));
+    EXPECT_TRUE(queue.isEmpty());
+}
+
+TEST(BoundedLocklessQueueTest, popAllReturnsValuesInPushOrder) {
+    BoundedLocklessQueue<int> queue(4);
+    queue.push(1);
+    queue.push(2);
+    EXPECT_EQ(1, queue.pop());
+    queue.push(3);
+
+    std::vector<int> values;
+    queue.popAll(values);
+    EXPECT_THAT(values, ElementsAre(2, 3));
+    EXPECT_TRUE(queue.isEmpty());
+    EXPECT_EQ(0u, queue.getOverflowPeak());
+}
+
+TEST(BoundedLocklessQueueTest, overflowKeepsPushOrder) {
+    BoundedLocklessQueue<int> queue(2);
+    for (int i = 0; i < 7; i++) {
+        queue.push(i);
+    }
+
+    std::vector<int> values;
+    queue.popAll(values);
+    EXPECT_THAT(values, ElementsAre(0, 1, 2, 3, 4, 5, 6));
+    EXPECT_TRUE(queue.isEmpty());
+    EXPECT_EQ(5u, queue.getOverflowPeak());
+
+    // The ring is usable again once drained.
+    queue.push(7);
+    values.clear();
+    queue.popAll(values);
+    EXPECT_THAT(values, ElementsAre(7));
+}
+
+// A value whose first move, which happens once push has claimed a slot of the ring, waits for the
+// test to open its gate. This leaves the slot claimed but not published.
+struct GatedValue {
+    struct Gate {
+        std::mutex mutex;
+        std::condition_variable condition;
+        bool entered = false;
+        bool open = false;
+    };
+
+    GatedValue(int index, std::shared_ptr<Gate> gate = nullptr)
+          : index(index), gate(std::move(gate)) {}
+
+    GatedValue(GatedValue&& other) : index(other.index) {
+        if (const auto gate = std::move(other.gate)) {
+            std::unique_lock lock(gate->mutex);
+            gate->entered = true;
+            gate->condition.notify_all();
+            gate->condition.wait(lock, [&] { return gate->open; });
+        }
+    }
+
+    GatedValue& operator=(GatedValue&& other) {
+        index = other.index;
+        gate = std::move(other.gate);
+        return *this;
+    }
+
+    int index;
+    std::shared_ptr<Gate> gate;
+};
+
+std::vector<int> indices(const std::vector<GatedValue>& values) {
+    std::vector<int> out;
+    for (const auto& value : values) {
+        out.push_back(value.index);
+    }
+    return out;
+}
+
+TEST(BoundedLocklessQueueTest, spilledValueWaitsForEarlierValuesOfItsThread) {
+    BoundedLocklessQueue<GatedValue> queue(4);
+    const auto gate = std::make_shared<GatedValue::Gate>();
+
+    std::thread blocked([&] { queue.push(GatedValue(0, gate)); });
+    {
+        std::unique_lock lock(gate->mutex);
+        gate->condition.wait(lock, [&] { return gate->entered; });
+    }
+
+    // The first slot is claimed but not published, so 1 to 3 fill the rest of the ring, and 4
+    // spills over.
+    for (int i = 1; i <= 4; i++) {
+        queue.push(GatedValue(i));
+    }
+
+    // 4 must not be popped before 1 to 3, which are stuck behind the unpublished slot.
+    std::vector<GatedValue> values;
+    queue.popAll(values);
+    EXPECT_THAT(indices(values), IsEmpty());
+    EXPECT_FALSE(queue.isEmpty());
+
+    {
+        std::lock_guard lock(gate->mutex);
+        gate->open = true;
+        gate->condition.notify_all();
+    }
+    blocked.join();
+
+    queue.popAll(values);
+    EXPECT_THAT(indices(values), ElementsAre(0, 1, 2, 3, 4));
+    EXPECT_TRUE(queue.isEmpty());
+}
+
+TEST(BoundedLocklessQueueTest, concurrentProducersKeepTheirOrder) {
+    constexpr int kProducerCount = 4;
+    constexpr int kValuesPerProducer = 20000;
+    BoundedLocklessQueue<Value> queue(4);
+
+    std::vector<std::thread> producers;
+    for (int producer = 0; producer < kProducerCount; producer++) {
+        producers.emplace_back([&queue, producer] {
+            for (int i = 0; i < kValuesPerProducer; i++) {
+                queue.push({producer, i});
+            }
+        });
+    }
+
+    std::vector<int> nextIndex(kProducerCount, 0);
+    int received = 0;
+    std::vector<Value> values;
+    while (received < kProducerCount * kValuesPerProducer) {
+        values.clear();
+        queue.popAll(values);
+        for (const auto& [producer, index] : values) {
+            ASSERT_EQ(nextIndex[producer], index) << "producer " << producer;
+            nextIndex[producer]++;
+        }
+        received += static_cast<int>(values.size());
+    }
+
+    for (auto& producer : producers) {
+        producer.join();
+    }
+    EXPECT_TRUE(queue.isEmpty());
+    EXPECT_THAT(nextIndex, ElementsAre(kValuesPerProducer, kValuesPerProducer,
+                                       kValuesPerProducer, kValuesPerProducer));
+}
+
+TEST(BoundedLocklessQueueTest, concurrentProducersKeepTheirOrderWithPop) {
+    constexpr int kProducerCount = 3;
+    constexpr int kValuesPerProducer = 20000;
+    BoundedLocklessQueue<Value> queue(2);
+
+    std::vector<std::thread> producers;
+    for (int producer = 0; producer < kProducerCount; producer++) {
+        producers.emplace_back([&queue, producer] {
+            for (int i = 0; i < kValuesPerProducer; i++) {
+                queue.push({producer, i});
+            }
+        });
+    }
+
+    std::vector<int> nextIndex(kProducerCount, 0);
+    for (int received = 0; received < kProducerCount * kValuesPerProducer;) {
+        if (const auto value = queue.pop()) {
+            ASSERT_EQ(nextIndex[value->first], value->second) << "producer " << value->first;
+            nextIndex[value->first]++;
+            received++;
+        }
+    }
+
+    for (auto& producer : producers) {
+        producer.join();
+    }
+    EXPECT_TRUE(queue.isEmpty());
+}
+
+} // namespace
+} // namespace android
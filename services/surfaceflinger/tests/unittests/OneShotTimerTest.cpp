@@ -262,6 +262,37 @@ TEST_F(OneShotTimerTest, noCallbacksAfterStopTest) {
     EXPECT_FALSE(mResetTimerCallback.waitForUnexpectedCall().has_value());
 }
 
+TEST_F(OneShotTimerTest, timersExpireIndependentlyTest) {
+    fake::FakeClock* clock = new fake::FakeClock();
+    mIdleTimer = std::make_unique<scheduler::OneShotTimer>("TestTimer", 1ms,
+                                                           mResetTimerCallback.getInvocable(),
+                                                           mExpiredTimerCallback.getInvocable(),
+                                                           std::unique_ptr<fake::FakeClock>(clock));
+
+    AsyncCallRecorder<void (*)()> otherResetTimerCallback;
+    AsyncCallRecorder<void (*)()> otherExpiredTimerCallback;
+    fake::FakeClock* otherClock = new fake::FakeClock();
+    OneShotTimer otherTimer("OtherTimer", 1ms, otherResetTimerCallback.getInvocable(),
+                            otherExpiredTimerCallback.getInvocable(),
+                            std::unique_ptr<fake::FakeClock>(otherClock));
+
+    mIdleTimer->start();
+    otherTimer.start();
+    EXPECT_TRUE(mResetTimerCallback.waitForCall().has_value());
+    EXPECT_TRUE(otherResetTimerCallback.waitForCall().has_value());
+
+    clock->advanceTime(2ms);
+    EXPECT_TRUE(mExpiredTimerCallback.waitForCall().has_value());
+    EXPECT_FALSE(otherExpiredTimerCallback.waitForUnexpectedCall().has_value());
+
+    otherClock->advanceTime(2ms);
+    EXPECT_TRUE(otherExpiredTimerCallback.waitForCall().has_value());
+    EXPECT_FALSE(mExpiredTimerCallback.waitForUnexpectedCall().has_value());
+
+    otherTimer.stop();
+    mIdleTimer->stop();
+}
+
 } // namespace
 } // namespace scheduler
 } // namespace android
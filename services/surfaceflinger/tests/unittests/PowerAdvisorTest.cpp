@@ -52,6 +52,7 @@ public:
     Duration getFenceWaitDelayDuration(bool skipValidate);
     Duration getErrorMargin();
     void setTimingTestingMode(bool testinMode);
+    void setPredictiveLoadHints(bool enabled);
     void allowReportActualToAcquireMutex();
     bool sessionExists();
     int64_t toNanos(Duration d);
@@ -176,6 +177,10 @@ void PowerAdvisorTest::setTimingTestingMode(bool testingMode) {
     mPowerAdvisor->mTimingTestingMode = testingMode;
 }
 
+void PowerAdvisorTest::setPredictiveLoadHints(bool enabled) {
+    mPowerAdvisor->mPredictiveLoadHints = enabled;
+}
+
 void PowerAdvisorTest::allowReportActualToAcquireMutex() {
     mPowerAdvisor->mDelayReportActualMutexAcquisitonPromise.set_value(true);
 }
@@ -787,6 +792,34 @@ TEST_F(PowerAdvisorTest, fmq_sendTargetAndActualDuration_queueFull) {
     EXPECT_EQ(res.durationNanos, toNanos(110ms + getErrorMargin()));
 }
 
+TEST_F(PowerAdvisorTest, predictiveLoadHints) {
+    SET_FLAG_FOR_TEST(android::os::adpf_use_fmq_channel_fixed, false);
+    setPredictiveLoadHints(true);
+    mPowerAdvisor->onBootFinished();
+    startPowerHintSession();
+    const DisplayId display = PhysicalDisplayId::fromPort(42u);
+
+    // A steady layer count and device composition send no hints.
+    EXPECT_CALL(*mMockPowerHintSession, sendHint(_)).Times(0);
+    for (int i = 0; i < 10; i++) {
+        mPowerAdvisor->setCompositionLayerCount(10 + i % 2);
+        mPowerAdvisor->setRequiresRenderEngine(display, false);
+    }
+    Mock::VerifyAndClearExpectations(mMockPowerHintSession.get());
+
+    // A layer count spike boosts before the frame is composited.
+    EXPECT_CALL(*mMockPowerHintSession, sendHint(SessionHint::CPU_LOAD_UP))
+            .WillOnce(Return(testing::ByMove(HalResult<void>::ok())));
+    mPowerAdvisor->setCompositionLayerCount(30);
+    Mock::VerifyAndClearExpectations(mMockPowerHintSession.get());
+
+    // So does the first frame that needs RenderEngine, but not the following ones.
+    EXPECT_CALL(*mMockPowerHintSession, sendHint(SessionHint::CPU_LOAD_UP))
+            .WillOnce(Return(testing::ByMove(HalResult<void>::ok())));
+    mPowerAdvisor->setRequiresRenderEngine(display, true);
+    mPowerAdvisor->setRequiresRenderEngine(display, true);
+}
+
 TEST_F(PowerAdvisorTest, fmq_sendHint) {
     SET_FLAG_FOR_TEST(android::os::adpf_use_fmq_channel_fixed, true);
     mPowerAdvisor->onBootFinished();
@@ -101,6 +101,10 @@ struct TestableRefreshRateSelector : RefreshRateSelector {
 
     using RefreshRateSelector::GetRankedFrameRatesCache;
     auto& mutableGetRankedRefreshRatesCache() { return mGetRankedFrameRatesCache; }
+    std::pair<uint64_t, uint64_t> getRankedFrameRatesHitsAndMisses() const {
+        std::lock_guard lock(mLock);
+        return {mRankedFrameRatesHits, mRankedFrameRatesMisses};
+    }
 
     auto getRankedFrameRates(const std::vector<LayerRequirement>& layers,
                              GlobalSignals signals = {}, Fps pacesetterFps = {}) const {
@@ -3285,6 +3289,33 @@ TEST_P(RefreshRateSelectorTest, getBestFrameRateMode_WritesCache) {
     EXPECT_EQ(cache->result, result);
 }
 
+TEST_P(RefreshRateSelectorTest, getBestFrameRateMode_MemoizesAlternatingInputs) {
+    auto selector = createSelector(kModes_30_60_72_90_120, kModeId60);
+
+    std::vector<LayerRequirement> layers = {{.weight = 1.f}};
+    layers[0].vote = LayerVoteType::ExplicitDefault;
+    layers[0].desiredRefreshRate = 60_Hz;
+    const RefreshRateSelector::GlobalSignals touch{.touch = true};
+    const RefreshRateSelector::GlobalSignals noTouch{};
+
+    // Touch boost toggling between frames only computes each ranking once.
+    const auto touchResult = selector.getRankedFrameRates(layers, touch);
+    const auto noTouchResult = selector.getRankedFrameRates(layers, noTouch);
+    for (int i = 0; i < 10; i++) {
+        EXPECT_EQ(touchResult, selector.getRankedFrameRates(layers, touch));
+        EXPECT_EQ(noTouchResult, selector.getRankedFrameRates(layers, noTouch));
+    }
+    EXPECT_EQ(std::make_pair(uint64_t{20}, uint64_t{2}),
+              selector.getRankedFrameRatesHitsAndMisses());
+
+    // Changing the active mode invalidates every memoized ranking.
+    selector.setActiveMode(kModeId90, 90_Hz);
+    selector.getRankedFrameRates(layers, touch);
+    selector.getRankedFrameRates(layers, noTouch);
+    EXPECT_EQ(std::make_pair(uint64_t{20}, uint64_t{4}),
+              selector.getRankedFrameRatesHitsAndMisses());
+}
+
 TEST_P(RefreshRateSelectorTest, getBestFrameRateMode_ExplicitExactTouchBoost) {
     auto selector = createSelector(kModes_60_120, kModeId60);
 
@@ -106,6 +106,13 @@ TEST_F(RegionSamplingTest, bounds_checking) {
                 testing::Eq(0.0));
 }
 
+TEST_F(RegionSamplingTest, downscale_area_rounds_outwards) {
+    EXPECT_THAT(downscaleArea(whole_area, 1), testing::Eq(whole_area));
+    EXPECT_THAT(downscaleArea(whole_area, 4), testing::Eq(Rect{0, 0, 25, 8}));
+    EXPECT_THAT(downscaleArea(Rect{5, 3, 9, 4}, 4), testing::Eq(Rect{1, 0, 3, 1}));
+    EXPECT_THAT(downscaleArea(Rect{-5, -4, 4, 8}, 4), testing::Eq(Rect{-2, -1, 1, 2}));
+}
+
 } // namespace android
 
 // TODO(b/129481165): remove the #pragma below and fix conversion issues
@@ -32,6 +32,7 @@
 
 #include <chrono>
 #include <random>
+#include <thread>
 #include <unordered_set>
 
 #include "libsurfaceflinger_unittest_main.h"
@@ -289,6 +290,32 @@ TEST_F(TimeStatsTest, canIncreaseGlobalStats) {
     EXPECT_EQ(CLIENT_COMPOSITION_FRAMES, globalProto.client_composition_frames());
 }
 
+TEST_F(TimeStatsTest, countsFramesRecordedFromSeveralThreads) {
+    // More frames than fit in the pending events, while the aggregator drains them concurrently.
+    constexpr size_t NUM_THREADS = 4;
+    constexpr size_t FRAMES_PER_THREAD = 1000;
+
+    EXPECT_TRUE(inputCommand(InputCommand::ENABLE, FMT_STRING).empty());
+
+    std::vector<std::thread> threads;
+    for (size_t i = 0; i < NUM_THREADS; i++) {
+        threads.emplace_back([this] {
+            for (size_t frame = 0; frame < FRAMES_PER_THREAD; frame++) {
+                mTimeStats->incrementTotalFrames();
+            }
+        });
+    }
+    for (auto& thread : threads) {
+        thread.join();
+    }
+
+    SFTimeStatsGlobalProto globalProto;
+    ASSERT_TRUE(globalProto.ParseFromString(inputCommand(InputCommand::DUMP_ALL, FMT_PROTO)));
+
+    ASSERT_TRUE(globalProto.has_total_frames());
+    EXPECT_EQ(NUM_THREADS * FRAMES_PER_THREAD, globalProto.total_frames());
+}
+
 TEST_F(TimeStatsTest, canIncreaseLateAcquireFrames) {
     // this stat is not in the proto so verify by checking the string dump
     constexpr size_t LATE_ACQUIRE_FRAMES = 2;
@@ -324,6 +351,35 @@ TEST_F(TimeStatsTest, canIncreaseBadDesiredPresent) {
     EXPECT_THAT(result, HasSubstr(expectedResult));
 }
 
+TEST_F(TimeStatsTest, canRecordLayerCompositionCosts) {
+    // these stats are verified by checking the string dump
+    constexpr uint64_t kMiB = 1024 * 1024;
+    EXPECT_TRUE(inputCommand(InputCommand::ENABLE, FMT_STRING).empty());
+
+    insertTimeRecord(NORMAL_SEQUENCE, LAYER_ID_0, 1, 1000000);
+    mTimeStats->recordLayerCompositionCosts(
+            {{.layerId = LAYER_ID_0, .clientComposition = false, .bufferBytes = 2 * kMiB}});
+    mTimeStats->recordRenderEngineDuration(std::chrono::nanoseconds(4ms).count(),
+                                           std::chrono::nanoseconds(8ms).count());
+    mTimeStats->recordLayerCompositionCosts(
+            {{.layerId = LAYER_ID_0, .clientComposition = true, .bufferBytes = kMiB},
+             {.layerId = LAYER_ID_1, .clientComposition = true, .bufferBytes = kMiB}});
+
+    // Push a fake present fence to trigger flushing the RenderEngine timings.
+    mTimeStats->setPowerMode(PowerMode::ON);
+    mTimeStats->setPresentFenceGlobal(
+            std::make_shared<FenceTime>(std::chrono::nanoseconds(1ms).count()));
+    insertTimeRecord(NORMAL_SEQUENCE_2, LAYER_ID_0, 2, 2000000);
+
+    const std::string result(inputCommand(InputCommand::DUMP_ALL, FMT_STRING));
+    EXPECT_THAT(result, HasSubstr("deviceCompositionFrames = 1"));
+    EXPECT_THAT(result, HasSubstr("clientCompositionFrames = 1"));
+    // LAYER_ID_1 isn't tracked, so layer 0 is attributed half of the RenderEngine time.
+    EXPECT_THAT(result,
+                HasSubstr("renderEngineShare histogram is as below:\n0ms=0 1ms=0 2ms=1 "));
+    EXPECT_THAT(result, HasSubstr("bufferReadMiB histogram is as below:\n0ms=0 1ms=1 2ms=1 "));
+}
+
 TEST_F(TimeStatsTest, canIncreaseJankyFramesForLayer) {
     // this stat is not in the proto so verify by checking the string dump
     EXPECT_TRUE(inputCommand(InputCommand::ENABLE, FMT_STRING).empty());
@@ -892,6 +948,27 @@ TEST_F(TimeStatsTest, layerTimeStatsOnDestroy) {
     EXPECT_EQ(1, layerProto.total_frames());
 }
 
+TEST_F(TimeStatsTest, layerKeepsItsNameAfterClear) {
+    EXPECT_TRUE(inputCommand(InputCommand::ENABLE, FMT_STRING).empty());
+
+    insertTimeRecord(NORMAL_SEQUENCE, LAYER_ID_1, 1, 1000000);
+    insertTimeRecord(NORMAL_SEQUENCE, LAYER_ID_1, 2, 2000000);
+    EXPECT_TRUE(inputCommand(InputCommand::CLEAR, FMT_STRING).empty());
+
+    // The name of the layer is only sent with its first frames, and reused once the layer is
+    // tracked again.
+    insertTimeRecord(NORMAL_SEQUENCE, LAYER_ID_1, 3, 3000000);
+    insertTimeRecord(NORMAL_SEQUENCE_2, LAYER_ID_1, 4, 4000000);
+
+    SFTimeStatsGlobalProto globalProto;
+    ASSERT_TRUE(globalProto.ParseFromString(inputCommand(InputCommand::DUMP_ALL, FMT_PROTO)));
+
+    ASSERT_EQ(1, globalProto.stats_size());
+    const SFTimeStatsLayerProto& layerProto = globalProto.stats(0);
+    EXPECT_EQ(genLayerName(LAYER_ID_1), layerProto.layer_name());
+    EXPECT_EQ(1, layerProto.total_frames());
+}
+
 TEST_F(TimeStatsTest, canClearTimeStats) {
     EXPECT_TRUE(inputCommand(InputCommand::ENABLE, FMT_STRING).empty());
 
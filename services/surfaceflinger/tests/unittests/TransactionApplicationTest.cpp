@@ -1099,4 +1099,29 @@ TEST(TransactionHandlerTest, CanAddTransactionWithFullMergedIds) {
                            transaction1Id) > 0);
 }
 
+TEST(TransactionHandlerTest, RecyclesComposerStateStorage) {
+    TransactionHandler handler;
+    std::vector<ResolvedComposerState> states = handler.acquireComposerStates(4);
+    EXPECT_GE(states.capacity(), 4u);
+    states.resize(4);
+
+    std::vector<TransactionState> transactions(1);
+    transactions[0].states = std::move(states);
+    handler.recycleTransactions(std::move(transactions));
+    auto stats = handler.getAllocationStats();
+    EXPECT_EQ(stats.lastFrameAllocations, 1u);
+    EXPECT_EQ(stats.lastFrameReuses, 0u);
+
+    // The second frame reuses the storage of the first one.
+    states = handler.acquireComposerStates(2);
+    EXPECT_TRUE(states.empty());
+    EXPECT_GE(states.capacity(), 4u);
+    handler.recycleTransactions({});
+    stats = handler.getAllocationStats();
+    EXPECT_EQ(stats.lastFrameAllocations, 0u);
+    EXPECT_EQ(stats.lastFrameReuses, 1u);
+    EXPECT_EQ(stats.totalAllocations, 1u);
+    EXPECT_EQ(stats.frames, 2u);
+}
+
 } // namespace android
@@ -78,6 +78,27 @@ protected:
         }
     }
 
+    void setElideUnchangedLayerState(bool elide) {
+        std::scoped_lock lock(mTracing.mTraceLock);
+        mTracing.mElideUnchangedLayerState = elide;
+    }
+
+    // Commits one transaction per vsync, with the transaction id matching the vsync id, and
+    // writes them as a single coalesced entry.
+    void addCoalescedEntry(const std::vector<int64_t>& vsyncIds) {
+        std::vector<TransactionTracing::CommittedUpdates> updates;
+        for (const int64_t vsyncId : vsyncIds) {
+            TransactionState transaction;
+            transaction.id = static_cast<uint64_t>(vsyncId);
+            mTracing.addQueuedTransaction(transaction);
+            updates.push_back({.transactionIds = {transaction.id},
+                               .displayInfoChanged = false,
+                               .vsyncId = vsyncId,
+                               .timestamp = vsyncId});
+        }
+        mTracing.addEntry(updates, {}, /*coalesce*/ true);
+    }
+
     LayerCreationArgs getLayerCreationArgs(uint32_t layerId, uint32_t parentId,
                                            uint32_t layerIdToMirror, uint32_t flags,
                                            bool addToRoot) {
@@ -124,6 +145,53 @@ TEST_F(TransactionTracingTest, addTransactions) {
     verifyEntry(proto.entry(1), secondUpdate.transactions, secondTransactionSetVsyncId);
 }
 
+TEST_F(TransactionTracingTest, elidesUnchangedLayerState) {
+    setElideUnchangedLayerState(true);
+
+    const auto commitLayerChange = [&](int64_t vsyncId, float alpha) {
+        TransactionState transaction;
+        transaction.id = static_cast<uint64_t>(vsyncId);
+        ResolvedComposerState layerState;
+        layerState.layerId = 1;
+        layerState.state.what = layer_state_t::ePositionChanged | layer_state_t::eAlphaChanged;
+        layerState.state.x = 10;
+        layerState.state.y = 20;
+        layerState.state.color.a = alpha;
+        transaction.states.emplace_back(layerState);
+        mTracing.addQueuedTransaction(transaction);
+
+        frontend::Update update;
+        update.transactions.emplace_back(transaction);
+        mTracing.addCommittedTransactions(vsyncId, 0, update, {}, false);
+        flush();
+    };
+    commitLayerChange(1, 0.5f);
+    commitLayerChange(2, 0.25f);
+
+    perfetto::protos::TransactionTraceFile proto = writeToProto();
+    ASSERT_EQ(proto.entry().size(), 2);
+    const auto& firstChange = proto.entry(0).transactions(0).layer_changes(0);
+    EXPECT_EQ(firstChange.what(), layer_state_t::ePositionChanged | layer_state_t::eAlphaChanged);
+    EXPECT_EQ(firstChange.x(), 10);
+    // The position did not change, only the alpha is traced.
+    const auto& secondChange = proto.entry(1).transactions(0).layer_changes(0);
+    EXPECT_EQ(secondChange.what(), layer_state_t::eAlphaChanged);
+    EXPECT_EQ(secondChange.x(), 0);
+    EXPECT_EQ(secondChange.alpha(), 0.25f);
+}
+
+TEST_F(TransactionTracingTest, coalescesCommittedUpdates) {
+    addCoalescedEntry(/*vsyncIds*/ {1, 2});
+
+    // Both transactions are kept, in a single entry for the last vsync.
+    perfetto::protos::TransactionTraceFile proto = writeToProto();
+    ASSERT_EQ(proto.entry().size(), 1);
+    EXPECT_EQ(proto.entry(0).vsync_id(), 2);
+    ASSERT_EQ(proto.entry(0).transactions().size(), 2);
+    EXPECT_EQ(proto.entry(0).transactions(0).transaction_id(), 1u);
+    EXPECT_EQ(proto.entry(0).transactions(1).transaction_id(), 2u);
+}
+
 class TransactionTracingLayerHandlingTest : public TransactionTracingTest {
 protected:
     void SetUp() override {
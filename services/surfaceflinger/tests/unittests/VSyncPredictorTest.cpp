@@ -1086,6 +1086,51 @@ TEST_F(VSyncPredictorTest, adjustsOnlyMinFrameViolatingVrrTimeline) {
     // Enough time without adjusting vsync to present with new rate on time, no need of adjustment
     EXPECT_EQ(5500, vrrTracker.nextAnticipatedVSyncTimeFrom(4000, 3500));
 }
+
+TEST_F(VSyncPredictorTest, adaptiveModelIgnoresOutliers) {
+    VSyncPredictor adaptiveTracker{std::make_unique<ClockWrapper>(mClock), mMode, kHistorySize,
+                                   kMinimumSamplesForPrediction, kOutlierTolerancePercent,
+                                   /*adaptiveModel*/ true};
+    for (size_t i = 0; i < kHistorySize; i++) {
+        mNow += mPeriod;
+        // A late sample, still within the outlier tolerance.
+        const nsecs_t jitter = i == kHistorySize / 2 ? mPeriod * 15 / 100 : 0;
+        EXPECT_TRUE(adaptiveTracker.addVsyncTimestamp(mNow + jitter));
+    }
+
+    EXPECT_EQ(mPeriod, adaptiveTracker.getVSyncPredictionModel().slope);
+    EXPECT_EQ(0, adaptiveTracker.getVSyncPredictionModel().intercept);
+}
+
+TEST_F(VSyncPredictorTest, adaptiveModelRestoresPeriodOnModeSwitch) {
+    VSyncPredictor adaptiveTracker{std::make_unique<ClockWrapper>(mClock), mMode, kHistorySize,
+                                   kMinimumSamplesForPrediction, kOutlierTolerancePercent,
+                                   /*adaptiveModel*/ true};
+    const nsecs_t realPeriod = mPeriod + 10;
+    for (size_t i = 0; i < kMinimumSamplesForPrediction; i++) {
+        adaptiveTracker.addVsyncTimestamp(mNow += realPeriod);
+    }
+    EXPECT_EQ(realPeriod, adaptiveTracker.getVSyncPredictionModel().slope);
+
+    const nsecs_t changedPeriod = mPeriod * 2;
+    adaptiveTracker.setDisplayModePtr(displayMode(changedPeriod));
+    for (size_t i = 0; i < kMinimumSamplesForPrediction; i++) {
+        adaptiveTracker.addVsyncTimestamp(mNow += changedPeriod);
+    }
+    EXPECT_FALSE(adaptiveTracker.needsMoreSamples());
+
+    // Switching back only needs the phase to be relearned, the period is kept.
+    adaptiveTracker.setDisplayModePtr(mMode);
+    EXPECT_TRUE(adaptiveTracker.needsMoreSamples());
+    const size_t samplesWithCachedModel = kMinimumSamplesForPrediction / 2;
+    for (size_t i = 0; i < samplesWithCachedModel; i++) {
+        EXPECT_TRUE(adaptiveTracker.needsMoreSamples());
+        adaptiveTracker.addVsyncTimestamp(mNow += realPeriod);
+        EXPECT_EQ(realPeriod, adaptiveTracker.getVSyncPredictionModel().slope);
+    }
+    EXPECT_FALSE(adaptiveTracker.needsMoreSamples());
+}
+
 } // namespace android::scheduler
 
 // TODO(b/129481165): remove the #pragma below and fix conversion issues
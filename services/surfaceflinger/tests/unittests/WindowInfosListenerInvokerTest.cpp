@@ -283,4 +283,57 @@ TEST_F(WindowInfosListenerInvokerTest, removeListenerAcks) {
     EXPECT_EQ(callCount, 2);
 }
 
+
+// Test that a listener that enables delta updates receives the first update in full and then only
+// the windows that changed.
+TEST_F(WindowInfosListenerInvokerTest, sendsDeltaUpdates) {
+    std::mutex mutex;
+    std::condition_variable cv;
+    std::vector<gui::WindowInfosUpdate> updates;
+
+    gui::WindowInfosListenerInfo listenerInfo;
+    mInvoker->addWindowInfosListener(sp<Listener>::make([&](const gui::WindowInfosUpdate& update) {
+                                         std::scoped_lock lock{mutex};
+                                         updates.push_back(update);
+                                         cv.notify_one();
+                                         listenerInfo.windowInfosPublisher
+                                                 ->ackWindowInfosReceived(update.vsyncId,
+                                                                          listenerInfo.listenerId);
+                                     }),
+                                     &listenerInfo);
+    listenerInfo.windowInfosPublisher->enableDeltaUpdates(listenerInfo.listenerId);
+
+    std::vector<gui::WindowInfo> windowInfos(2);
+    windowInfos[0].id = 1;
+    windowInfos[0].alpha = 1.0f;
+    windowInfos[1].id = 2;
+    windowInfos[1].alpha = 1.0f;
+    BackgroundExecutor::getInstance().sendCallbacks({[this, windowInfos]() {
+        mInvoker->windowInfosChanged({windowInfos, {}, /* vsyncId= */ 0, 0}, {}, false);
+    }});
+    {
+        std::unique_lock lock{mutex};
+        cv.wait(lock, [&]() { return updates.size() == 1; });
+    }
+
+    windowInfos[1].frame = Rect(0, 0, 5, 5);
+    BackgroundExecutor::getInstance().sendCallbacks({[this, windowInfos]() {
+        mInvoker->windowInfosChanged({windowInfos, {}, /* vsyncId= */ 1, 0}, {}, false);
+    }});
+    {
+        std::unique_lock lock{mutex};
+        cv.wait(lock, [&]() { return updates.size() == 2; });
+    }
+
+    EXPECT_FALSE(updates[0].isDelta());
+    EXPECT_EQ(updates[0].windowInfos.size(), 2u);
+    EXPECT_TRUE(updates[1].isDelta());
+    EXPECT_EQ(updates[1].baseVersion, updates[0].version);
+    EXPECT_EQ(updates[1].windowIds, (std::vector<int32_t>{1, 2}));
+    ASSERT_EQ(updates[1].windowInfos.size(), 1u);
+    EXPECT_EQ(updates[1].windowInfos[0].id, 2);
+    EXPECT_EQ(OK, updates[1].applyDelta(updates[0]));
+    EXPECT_EQ(updates[1].windowInfos, windowInfos);
+}
+
 } // namespace android
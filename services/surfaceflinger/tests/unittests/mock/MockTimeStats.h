@@ -59,6 +59,8 @@ public:
                  void(hardware::graphics::composer::V2_4::IComposerClient::PowerMode));
     MOCK_METHOD2(recordRefreshRate, void(uint32_t, nsecs_t));
     MOCK_METHOD1(setPresentFenceGlobal, void(const std::shared_ptr<FenceTime>&));
+    MOCK_METHOD(void, recordLayerCompositionCosts,
+                (const std::vector<android::TimeStats::LayerCompositionCost>&), (override));
     MOCK_METHOD(void, pushCompositionStrategyState,
                 (const android::TimeStats::ClientCompositionRecord&), (override));
 };
@@ -19,6 +19,7 @@
 #include <aidl/android/hardware/vibrator/IVibrator.h>
 #include <android/hardware/vibrator/1.3/IVibrator.h>
 #include <hardware/vibrator.h>
+#include <algorithm>
 #include <cmath>
 
 #include <utils/Log.h>
@@ -133,11 +134,72 @@ HalResult<void> HalWrapper::composePwleV2(const std::vector<PwleV2Primitive>&,
     return HalResult<void>::unsupported();
 }
 
+HalResult<std::shared_ptr<const PreparedComposition>> HalWrapper::prepareComposedEffect(
+        const std::vector<CompositeEffect>& primitives) {
+    using Result = HalResult<std::shared_ptr<const PreparedComposition>>;
+    auto durations = getPrimitiveDurations();
+    if (durations.isUnsupported()) {
+        ALOGV("Skipped prepareComposedEffect because primitives are not available in Vibrator HAL");
+        return Result::unsupported();
+    }
+    if (durations.isFailed()) {
+        return durations.shouldRetry() ? Result::transactionFailed(durations.errorMessage())
+                                       : Result::failed(durations.errorMessage());
+    }
+
+    std::vector<CompositePrimitive> supportedPrimitives;
+    {
+        std::lock_guard<std::mutex> lock(mInfoMutex);
+        supportedPrimitives = mInfoCache.mSupportedPrimitives.valueOr({});
+    }
+    for (const auto& effect : primitives) {
+        if (std::find(supportedPrimitives.begin(), supportedPrimitives.end(), effect.primitive) ==
+            supportedPrimitives.end()) {
+            ALOGV("Skipped prepareComposedEffect because primitive %s is not supported",
+                  Aidl::toString(effect.primitive).c_str());
+            return Result::unsupported();
+        }
+    }
+
+    auto duration = getComposedEffectDuration(primitives, durations.value());
+    return Result::ok(std::make_shared<const PreparedComposition>(primitives, duration));
+}
+
+HalResult<milliseconds> HalWrapper::performPreparedEffect(const PreparedComposition&,
+                                                          const std::function<void()>&) {
+    ALOGV("Skipped performPreparedEffect because it's not available in Vibrator HAL");
+    return HalResult<milliseconds>::unsupported();
+}
+
+milliseconds HalWrapper::getComposedEffectDuration(const std::vector<CompositeEffect>& primitives,
+                                                   const std::vector<milliseconds>& durations) {
+    milliseconds duration(0);
+    for (const auto& effect : primitives) {
+        auto primitiveIdx = static_cast<size_t>(effect.primitive);
+        if (primitiveIdx < durations.size()) {
+            duration += durations[primitiveIdx];
+        } else {
+            // Make sure the returned duration is positive to indicate successful vibration.
+            duration += milliseconds(1);
+        }
+        duration += milliseconds(effect.delayMs);
+    }
+    return duration;
+}
+
 HalResult<Capabilities> HalWrapper::getCapabilities() {
+    // Capabilities are checked on every vibration, so skip the lock once they are loaded.
+    int32_t loadedCapabilities = mLoadedCapabilities.load(std::memory_order_relaxed);
+    if (loadedCapabilities >= 0) {
+        return HalResult<Capabilities>::ok(static_cast<Capabilities>(loadedCapabilities));
+    }
     std::lock_guard<std::mutex> lock(mInfoMutex);
     if (mInfoCache.mCapabilities.isFailed()) {
         mInfoCache.mCapabilities = getCapabilitiesInternal();
     }
+    if (mInfoCache.mCapabilities.isOk()) {
+        mLoadedCapabilities = static_cast<int32_t>(mInfoCache.mCapabilities.value());
+    }
     return mInfoCache.mCapabilities;
 }
 
@@ -326,22 +388,19 @@ HalResult<milliseconds> AidlHalWrapper::performComposedEffect(
     // This method should always support callbacks, so no need to double check.
     auto cb = ndk::SharedRefBase::make<HalCallbackWrapper>(completionCallback);
 
-    auto durations = getPrimitiveDurations().valueOr({});
-    milliseconds duration(0);
-    for (const auto& effect : primitives) {
-        auto primitiveIdx = static_cast<size_t>(effect.primitive);
-        if (primitiveIdx < durations.size()) {
-            duration += durations[primitiveIdx];
-        } else {
-            // Make sure the returned duration is positive to indicate successful vibration.
-            duration += milliseconds(1);
-        }
-        duration += milliseconds(effect.delayMs);
-    }
-
+    auto duration = getComposedEffectDuration(primitives, getPrimitiveDurations().valueOr({}));
     return HalResultFactory::fromStatus<milliseconds>(getHal()->compose(primitives, cb), duration);
 }
 
+HalResult<milliseconds> AidlHalWrapper::performPreparedEffect(
+        const PreparedComposition& composition, const std::function<void()>& completionCallback) {
+    // This method should always support callbacks, so no need to double check.
+    auto cb = ndk::SharedRefBase::make<HalCallbackWrapper>(completionCallback);
+    return HalResultFactory::fromStatus<milliseconds>(getHal()->compose(composition.primitives(),
+                                                                        cb),
+                                                      composition.duration());
+}
+
 HalResult<void> AidlHalWrapper::performPwleEffect(const std::vector<PrimitivePwle>& primitives,
                                                   const std::function<void()>& completionCallback) {
     // This method should always support callbacks, so no need to double check.
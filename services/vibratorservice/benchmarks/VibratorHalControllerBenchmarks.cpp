@@ -591,4 +591,54 @@ BENCHMARK_WRAPPER(SlowVibratorPrimitivesBench, performComposedEffect, {
     }
 });
 
+BENCHMARK_WRAPPER(SlowVibratorPrimitivesBench, performPreparedEffect, {
+    if (shouldSkipWithMissingCapabilityMessage(vibrator::Capabilities::COMPOSE_EFFECTS, state)) {
+        return;
+    }
+    if (!hasArgs(state)) {
+        state.SkipWithMessage("missing args");
+        return;
+    }
+
+    CompositeEffect effect;
+    effect.primitive = getPrimitive(state);
+    effect.scale = 1.0f;
+    effect.delayMs = static_cast<int32_t>(0);
+
+    auto prepareFn = [&](auto hal) { return hal->prepareComposedEffect({effect}); };
+    auto prepared = mController.doWithRetry<std::shared_ptr<const vibrator::PreparedComposition>>(
+            prepareFn, "prepareComposedEffect");
+    if (shouldSkipWithError(prepared, state)) {
+        return;
+    }
+    if (!prepared.isOk()) {
+        state.SkipWithMessage("prepareComposedEffect is unsupported");
+        return;
+    }
+    auto composition = prepared.value();
+
+    for (auto _ : state) {
+        // Setup
+        state.PauseTiming();
+        auto cb = mCallbacks.next();
+        auto performFn = [&](auto hal) {
+            return hal->performPreparedEffect(*composition, cb.completeFn());
+        };
+        state.ResumeTiming();
+
+        // Test
+        if (shouldSkipWithError<milliseconds>(performFn, "performPreparedEffect", state)) {
+            return;
+        }
+
+        // Cleanup
+        state.PauseTiming();
+        if (shouldSkipWithError(turnVibratorOff(), state)) {
+            return;
+        }
+        cb.waitForComplete();
+        state.ResumeTiming();
+    }
+});
+
 BENCHMARK_MAIN();
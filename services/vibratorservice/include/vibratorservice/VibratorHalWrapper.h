@@ -27,6 +27,8 @@
 
 #include <vibratorservice/VibratorCallbackScheduler.h>
 
+#include <atomic>
+
 namespace android {
 
 namespace vibrator {
@@ -363,6 +365,23 @@ private:
     friend class HalWrapper;
 };
 
+// Composed effect validated against the HAL once, to be performed repeatedly without loading
+// primitive durations or validating primitives again, e.g. for keyboard haptics.
+class PreparedComposition {
+public:
+    using CompositeEffect = aidl::android::hardware::vibrator::CompositeEffect;
+
+    PreparedComposition(std::vector<CompositeEffect> primitives, std::chrono::milliseconds duration)
+          : mPrimitives(std::move(primitives)), mDuration(duration) {}
+
+    const std::vector<CompositeEffect>& primitives() const { return mPrimitives; }
+    std::chrono::milliseconds duration() const { return mDuration; }
+
+private:
+    const std::vector<CompositeEffect> mPrimitives;
+    const std::chrono::milliseconds mDuration;
+};
+
 // Wrapper for Vibrator HAL handlers.
 class HalWrapper {
 public:
@@ -415,6 +434,16 @@ public:
     virtual HalResult<void> composePwleV2(const std::vector<PwleV2Primitive>& composite,
                                           const std::function<void()>& completionCallback);
 
+    /* Validates the primitives against the supported ones and computes the composition duration,
+     * so that the returned composition can be performed with a single HAL call.
+     */
+    HalResult<std::shared_ptr<const PreparedComposition>> prepareComposedEffect(
+            const std::vector<CompositeEffect>& primitives);
+
+    virtual HalResult<std::chrono::milliseconds> performPreparedEffect(
+            const PreparedComposition& composition,
+            const std::function<void()>& completionCallback);
+
 protected:
     // Shared pointer to allow CallbackScheduler to outlive this wrapper.
     const std::shared_ptr<CallbackScheduler> mCallbackScheduler;
@@ -443,7 +472,14 @@ protected:
     virtual HalResult<std::chrono::milliseconds> getMinEnvelopeEffectControlPointDurationInternal();
     virtual HalResult<std::chrono::milliseconds> getMaxEnvelopeEffectControlPointDurationInternal();
 
+    // Returns the duration of the composition, from the primitive durations loaded from the HAL.
+    static std::chrono::milliseconds getComposedEffectDuration(
+            const std::vector<CompositeEffect>& primitives,
+            const std::vector<std::chrono::milliseconds>& primitiveDurations);
+
 private:
+    // Capabilities once loaded successfully, or -1, read without locking mInfoMutex.
+    std::atomic<int32_t> mLoadedCapabilities = -1;
     std::mutex mInfoMutex;
     InfoCache mInfoCache GUARDED_BY(mInfoMutex);
 };
@@ -501,6 +537,10 @@ public:
     HalResult<void> composePwleV2(const std::vector<PwleV2Primitive>& composite,
                                   const std::function<void()>& completionCallback) override final;
 
+    HalResult<std::chrono::milliseconds> performPreparedEffect(
+            const PreparedComposition& composition,
+            const std::function<void()>& completionCallback) override final;
+
 protected:
     HalResult<Capabilities> getCapabilitiesInternal() override final;
     HalResult<std::vector<Effect>> getSupportedEffectsInternal() override final;
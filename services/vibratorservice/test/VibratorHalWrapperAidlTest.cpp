@@ -694,6 +694,57 @@ TEST_F(VibratorHalWrapperAidlTest, TestPerformComposedCachesPrimitiveDurationsAn
     ASSERT_EQ(3, *callbackCounter.get());
 }
 
+TEST_F(VibratorHalWrapperAidlTest, TestPrepareAndPerformPreparedEffect) {
+    std::vector<CompositePrimitive> supportedPrimitives = {CompositePrimitive::CLICK,
+                                                           CompositePrimitive::SPIN};
+    std::vector<CompositeEffect> supportedEffects, unsupportedEffects;
+    supportedEffects.push_back(
+            vibrator::TestFactory::createCompositeEffect(CompositePrimitive::CLICK, 10ms, 0.5f));
+    supportedEffects.push_back(
+            vibrator::TestFactory::createCompositeEffect(CompositePrimitive::SPIN, 100ms, 1.0f));
+    unsupportedEffects.push_back(
+            vibrator::TestFactory::createCompositeEffect(CompositePrimitive::THUD, 10ms, 1.0f));
+
+    {
+        InSequence seq;
+        EXPECT_CALL(*mMockHal.get(), getSupportedPrimitives(_))
+                .Times(Exactly(1))
+                .WillOnce(DoAll(SetArgPointee<0>(supportedPrimitives),
+                                Return(ndk::ScopedAStatus::ok())));
+        EXPECT_CALL(*mMockHal.get(), getPrimitiveDuration(Eq(CompositePrimitive::CLICK), _))
+                .Times(Exactly(1))
+                .WillOnce(DoAll(SetArgPointee<1>(1), Return(ndk::ScopedAStatus::ok())));
+        EXPECT_CALL(*mMockHal.get(), getPrimitiveDuration(Eq(CompositePrimitive::SPIN), _))
+                .Times(Exactly(1))
+                .WillOnce(DoAll(SetArgPointee<1>(2), Return(ndk::ScopedAStatus::ok())));
+        EXPECT_CALL(*mMockHal.get(), compose(Eq(supportedEffects), _))
+                .Times(Exactly(2))
+                .WillOnce(DoAll(WithArg<1>(vibrator::TriggerCallback()),
+                                Return(ndk::ScopedAStatus::ok())))
+                .WillOnce(Return(ndk::ScopedAStatus::fromExceptionCode(EX_SECURITY)));
+    }
+
+    auto unsupported = mWrapper->prepareComposedEffect(unsupportedEffects);
+    ASSERT_TRUE(unsupported.isUnsupported());
+
+    auto prepared = mWrapper->prepareComposedEffect(supportedEffects);
+    ASSERT_TRUE(prepared.isOk());
+    ASSERT_EQ(113ms, prepared.value()->duration());
+
+    std::unique_ptr<int32_t> callbackCounter = std::make_unique<int32_t>();
+    auto callback = vibrator::TestFactory::createCountingCallback(callbackCounter.get());
+
+    auto result = mWrapper->performPreparedEffect(*prepared.value(), callback);
+    ASSERT_TRUE(result.isOk());
+    ASSERT_EQ(113ms, result.value());
+    ASSERT_EQ(1, *callbackCounter.get());
+
+    result = mWrapper->performPreparedEffect(*prepared.value(), callback);
+    ASSERT_TRUE(result.isFailed());
+    // Callback not triggered on failure
+    ASSERT_EQ(1, *callbackCounter.get());
+}
+
 TEST_F(VibratorHalWrapperAidlTest, TestPerformPwleEffect) {
     std::vector<PrimitivePwle> emptyPrimitives, multiplePrimitives;
     multiplePrimitives.push_back(vibrator::TestFactory::createActivePwle(0, 1, 0, 1, 10ms));
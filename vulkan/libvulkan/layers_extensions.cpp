@@ -23,13 +23,16 @@
 #include <dlfcn.h>
 #include <string.h>
 #include <sys/prctl.h>
+#include <sys/stat.h>
 #include <unistd.h>
 
 #include <mutex>
 #include <string>
+#include <unordered_map>
 #include <vector>
 
 #include <android/dlext.h>
+#include <android-base/file.h>
 #include <android-base/strings.h>
 #include <cutils/properties.h>
 #include <graphicsenv/GraphicsEnv.h>
@@ -65,6 +68,9 @@ struct Layer {
 namespace {
 
 const char kSystemLayerLibraryDir[] = "/data/local/debug/vulkan";
+const char kLayerCacheFilename[] = "com.android.vulkan.layers_cache";
+const uint32_t kLayerCacheMagic = ('V' << 24) | ('K' << 16) | ('L' << 8) | 'C';
+const uint32_t kLayerCacheVersion = 1;
 
 class LayerLibrary {
    public:
@@ -101,6 +107,7 @@ class LayerLibrary {
     void* GetGPA(const Layer& layer, const std::string_view gpa_name) const;
 
     const std::string GetFilename() { return filename_; }
+    const std::string& GetPath() const { return path_; }
 
    private:
     // TODO(b/79940628): remove that adapter when we could use NativeBridgeGetTrampoline
@@ -338,21 +345,270 @@ void* LayerLibrary::GetGPA(const Layer& layer, const std::string_view gpa_name)
 
 // ----------------------------------------------------------------------------
 
+// Keeps the layers enumerated from each layer library in a file, so that
+// libraries that did not change since the last run of the app do not have to
+// be opened to discover their layers. They are only opened once one of their
+// layers is enabled. Libraries are identified by their path, size and
+// modification time, or the ones of the APK they are stored in.
+class LayerCache {
+   public:
+    void Load(const std::string& dir);
+    void Save() const;
+
+    bool Find(const std::string& library_path, std::vector<Layer>& layers);
+    void Add(const std::string& library_path, const std::vector<Layer>& layers);
+
+   private:
+    struct Stamp {
+        int64_t size;
+        int64_t mtime_ns;
+
+        bool operator==(const Stamp& other) const {
+            return size == other.size && mtime_ns == other.mtime_ns;
+        }
+    };
+
+    struct Entry {
+        Stamp stamp;
+        std::vector<Layer> layers;
+        // whether the library was found by this discovery
+        bool used;
+    };
+
+    static bool GetStamp(const std::string& library_path, Stamp& stamp);
+
+    std::string path_;
+    std::unordered_map<std::string, Entry> entries_;
+    bool dirty_ = false;
+};
+
+class CacheReader {
+   public:
+    explicit CacheReader(const std::string& data) : data_(data), offset_(0) {}
+
+    template <typename T>
+    bool Read(T& value) {
+        if (data_.size() - offset_ < sizeof(T))
+            return false;
+        memcpy(&value, data_.data() + offset_, sizeof(T));
+        offset_ += sizeof(T);
+        return true;
+    }
+
+    bool Read(std::string& value) {
+        uint32_t size;
+        if (!Read(size) || data_.size() - offset_ < size)
+            return false;
+        value.assign(data_, offset_, size);
+        offset_ += size;
+        return true;
+    }
+
+    template <typename T>
+    bool Read(std::vector<T>& values) {
+        uint32_t count;
+        if (!Read(count) || (data_.size() - offset_) / sizeof(T) < count)
+            return false;
+        values.resize(count);
+        memcpy(values.data(), data_.data() + offset_, count * sizeof(T));
+        offset_ += count * sizeof(T);
+        return true;
+    }
+
+    bool AtEnd() const { return offset_ == data_.size(); }
+
+   private:
+    const std::string& data_;
+    size_t offset_;
+};
+
+template <typename T>
+void CacheWrite(std::string& data, const T& value) {
+    data.append(reinterpret_cast<const char*>(&value), sizeof(T));
+}
+
+void CacheWrite(std::string& data, const std::string& value) {
+    CacheWrite(data, static_cast<uint32_t>(value.size()));
+    data.append(value);
+}
+
+template <typename T>
+void CacheWrite(std::string& data, const std::vector<T>& values) {
+    CacheWrite(data, static_cast<uint32_t>(values.size()));
+    data.append(reinterpret_cast<const char*>(values.data()),
+                values.size() * sizeof(T));
+}
+
+void LayerCache::Load(const std::string& dir) {
+    ATRACE_CALL();
+
+    path_ = dir + "/" + kLayerCacheFilename;
+    std::string data;
+    if (!android::base::ReadFileToString(path_, &data)) {
+        ALOGV("no layer cache at '%s'", path_.c_str());
+        return;
+    }
+
+    CacheReader reader(data);
+    uint32_t magic, version, num_entries;
+    if (!reader.Read(magic) || magic != kLayerCacheMagic ||
+        !reader.Read(version) || version != kLayerCacheVersion ||
+        !reader.Read(num_entries)) {
+        ALOGW("ignoring layer cache '%s' of unknown format", path_.c_str());
+        dirty_ = true;
+        return;
+    }
+    for (uint32_t i = 0; i < num_entries; i++) {
+        std::string library_path;
+        Entry entry = {};
+        uint32_t num_layers;
+        if (!reader.Read(library_path) || !reader.Read(entry.stamp) ||
+            !reader.Read(num_layers)) {
+            break;
+        }
+        entry.layers.resize(num_layers);
+        for (Layer& layer : entry.layers) {
+            uint8_t is_global;
+            if (!reader.Read(layer.properties) || !reader.Read(is_global) ||
+                !reader.Read(layer.instance_extensions) ||
+                !reader.Read(layer.device_extensions)) {
+                num_layers = 0;
+                break;
+            }
+            layer.is_global = is_global != 0;
+        }
+        if (num_layers != entry.layers.size())
+            break;
+        entries_.emplace(std::move(library_path), std::move(entry));
+    }
+    if (entries_.size() != num_entries || !reader.AtEnd()) {
+        ALOGW("ignoring truncated layer cache '%s'", path_.c_str());
+        entries_.clear();
+        dirty_ = true;
+    }
+}
+
+void LayerCache::Save() const {
+    if (path_.empty())
+        return;
+    // Libraries that went away are dropped from the cache.
+    bool stale = false;
+    for (const auto& it : entries_)
+        stale |= !it.second.used;
+    if (!dirty_ && !stale)
+        return;
+    ATRACE_CALL();
+
+    std::string data;
+    CacheWrite(data, kLayerCacheMagic);
+    CacheWrite(data, kLayerCacheVersion);
+    uint32_t num_entries = 0;
+    for (const auto& it : entries_)
+        num_entries += it.second.used;
+    CacheWrite(data, num_entries);
+    for (const auto& [library_path, entry] : entries_) {
+        if (!entry.used)
+            continue;
+        CacheWrite(data, library_path);
+        CacheWrite(data, entry.stamp);
+        CacheWrite(data, static_cast<uint32_t>(entry.layers.size()));
+        for (const Layer& layer : entry.layers) {
+            CacheWrite(data, layer.properties);
+            CacheWrite(data, static_cast<uint8_t>(layer.is_global));
+            CacheWrite(data, layer.instance_extensions);
+            CacheWrite(data, layer.device_extensions);
+        }
+    }
+
+    // Write to a temporary file first so that a concurrent process of the
+    // same app never reads a partially written cache.
+    std::string tmp_path = path_ + "." + std::to_string(getpid());
+    if (!android::base::WriteStringToFile(data, tmp_path)) {
+        ALOGW("failed to write layer cache '%s': %s", tmp_path.c_str(),
+              strerror(errno));
+        unlink(tmp_path.c_str());
+        return;
+    }
+    if (rename(tmp_path.c_str(), path_.c_str()) != 0) {
+        ALOGW("failed to rename layer cache to '%s': %s", path_.c_str(),
+              strerror(errno));
+        unlink(tmp_path.c_str());
+    }
+}
+
+bool LayerCache::GetStamp(const std::string& library_path, Stamp& stamp) {
+    // Libraries inside an APK change with the APK.
+    std::string file_path = library_path.substr(0, library_path.find("!/"));
+    struct stat st;
+    if (stat(file_path.c_str(), &st) != 0)
+        return false;
+    stamp.size = st.st_size;
+    stamp.mtime_ns = int64_t(st.st_mtim.tv_sec) * 1000000000 + st.st_mtim.tv_nsec;
+    return true;
+}
+
+bool LayerCache::Find(const std::string& library_path,
+                      std::vector<Layer>& layers) {
+    if (path_.empty())
+        return false;
+    auto it = entries_.find(library_path);
+    if (it == entries_.end())
+        return false;
+    Stamp stamp;
+    if (!GetStamp(library_path, stamp) || !(stamp == it->second.stamp)) {
+        entries_.erase(it);
+        dirty_ = true;
+        return false;
+    }
+    it->second.used = true;
+    layers = it->second.layers;
+    return true;
+}
+
+void LayerCache::Add(const std::string& library_path,
+                     const std::vector<Layer>& layers) {
+    if (path_.empty())
+        return;
+    Entry entry = {};
+    if (!GetStamp(library_path, entry.stamp))
+        return;
+    entry.layers = layers;
+    entry.used = true;
+    entries_[library_path] = std::move(entry);
+    dirty_ = true;
+}
+
 std::vector<LayerLibrary> g_layer_libraries;
 std::vector<Layer> g_instance_layers;
+LayerCache g_layer_cache;
 
 void AddLayerLibrary(const std::string& path, const std::string& filename) {
     LayerLibrary library(path + "/" + filename, filename);
-    if (!library.Open())
-        return;
+    const size_t library_idx = g_layer_libraries.size();
+
+    std::vector<Layer> layers;
+    if (g_layer_cache.Find(library.GetPath(), layers)) {
+        for (Layer& layer : layers) {
+            layer.library_idx = library_idx;
+            ALOGV("added %s layer '%s' from cache of library '%s'",
+                  (layer.is_global) ? "global" : "instance",
+                  layer.properties.layerName, library.GetPath().c_str());
+        }
+    } else {
+        if (!library.Open())
+            return;
+
+        if (!library.EnumerateLayers(library_idx, layers)) {
+            library.Close();
+            return;
+        }
 
-    if (!library.EnumerateLayers(g_layer_libraries.size(), g_instance_layers)) {
         library.Close();
-        return;
+        g_layer_cache.Add(library.GetPath(), layers);
     }
 
-    library.Close();
-
+    g_instance_layers.insert(g_instance_layers.end(), layers.begin(),
+                             layers.end());
     g_layer_libraries.emplace_back(std::move(library));
 }
 
@@ -479,11 +735,18 @@ void* GetLayerGetProcAddr(const Layer& layer,
 void DiscoverLayers() {
     ATRACE_CALL();
 
+    const std::string& cache_dir =
+        android::GraphicsEnv::getInstance().getLayerCacheDir();
+    if (!cache_dir.empty())
+        g_layer_cache.Load(cache_dir);
+
     if (android::GraphicsEnv::getInstance().isDebuggable()) {
         DiscoverLayersInPathList(kSystemLayerLibraryDir);
     }
     if (!android::GraphicsEnv::getInstance().getLayerPaths().empty())
         DiscoverLayersInPathList(android::GraphicsEnv::getInstance().getLayerPaths());
+
+    g_layer_cache.Save();
 }
 
 uint32_t GetLayerCount() {
@@ -21,6 +21,7 @@
 #include <aidl/android/hardware/graphics/common/PixelFormat.h>
 #include <android/hardware/graphics/common/1.0/types.h>
 #include <android/hardware_buffer.h>
+#include <com_android_graphics_libvulkan_flags.h>
 #include <grallocusage/GrallocUsageConversion.h>
 #include <graphicsenv/GraphicsEnv.h>
 #include <hardware/gralloc.h>
@@ -34,6 +35,12 @@
 #include <utils/Trace.h>
 
 #include <algorithm>
+#include <chrono>
+#include <condition_variable>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <thread>
 #include <unordered_set>
 #include <vector>
 
@@ -43,6 +50,8 @@ using PixelFormat = aidl::android::hardware::graphics::common::PixelFormat;
 using DataSpace = aidl::android::hardware::graphics::common::Dataspace;
 using android::hardware::graphics::common::V1_0::BufferUsage;
 
+using namespace com::android::graphics::libvulkan;
+
 namespace vulkan {
 namespace driver {
 
@@ -79,6 +88,10 @@ const VkSurfaceTransformFlagsKHR kSupportedTransforms =
     VK_SURFACE_TRANSFORM_HORIZONTAL_MIRROR_ROTATE_270_BIT_KHR |
     VK_SURFACE_TRANSFORM_INHERIT_BIT_KHR;
 
+// How long the window may block in dequeueBuffer when buffers are dequeued
+// ahead of time.
+constexpr nsecs_t kPreDequeueTimeout = ms2ns(100);
+
 VkSurfaceTransformFlagBitsKHR TranslateNativeToVulkanTransform(int native) {
     // Native and Vulkan transforms are isomorphic, but are represented
     // differently. Vulkan transforms are built up of an optional horizontal
@@ -275,6 +288,77 @@ bool IsSharedPresentMode(VkPresentModeKHR mode) {
         mode == VK_PRESENT_MODE_SHARED_CONTINUOUS_REFRESH_KHR;
 }
 
+// Queues the buffers of a swapchain to its window from a dedicated thread, so
+// that vkQueuePresentKHR returns as soon as the present is handed over.
+// Buffers are queued in the order they were presented, and a failure is
+// reported by the next vkQueuePresentKHR on the swapchain.
+//
+// With a non-zero max_dequeued, a second thread also keeps up to that many
+// buffers dequeued from the window, and vkAcquireNextImageKHR takes one of
+// them instead of calling dequeueBuffer itself.
+class PresentThread {
+   public:
+    PresentThread(ANativeWindow* window, uint32_t max_dequeued);
+    ~PresentThread();
+
+    bool PreDequeues() const { return max_dequeued_ != 0; }
+
+    // Takes a pre-dequeued buffer, waiting up to timeout ns for one.
+    VkResult Dequeue(uint64_t timeout,
+                     ANativeWindowBuffer** buffer,
+                     int* fence);
+    // Gives back a buffer taken with Dequeue() without presenting it.
+    void Cancel(ANativeWindowBuffer* buffer, int fence);
+    // Tells that a buffer taken with Dequeue() was queued to the window
+    // directly, without going through Queue().
+    void BufferReturned();
+
+    void Queue(const android::sp<ANativeWindowBuffer>& buffer,
+               int fence,
+               const VkPresentRegionKHR* region);
+
+    // Returns the worst result of the presents queued since the last call,
+    // WaitIdle() first waits for all of them to reach the window.
+    VkResult TakeResult();
+    VkResult WaitIdle();
+
+   private:
+    struct Present {
+        android::sp<ANativeWindowBuffer> buffer;
+        int fence;
+        bool has_damage;
+        std::vector<android_native_rect_t> damage;
+    };
+
+    struct DequeuedBuffer {
+        ANativeWindowBuffer* buffer;
+        int fence;
+    };
+
+    void Run();
+    void RunDequeue();
+
+    android::sp<ANativeWindow> window_;
+    const uint32_t max_dequeued_;
+    std::mutex mutex_;
+    std::condition_variable work_available_;
+    std::condition_variable idle_;
+    std::deque<Present> presents_;
+    bool busy_ = false;
+    bool stopping_ = false;
+    VkResult result_ = VK_SUCCESS;
+    std::condition_variable dequeue_needed_;
+    std::condition_variable buffer_available_;
+    std::deque<DequeuedBuffer> dequeued_buffers_;
+    // Buffers dequeued from the window and not queued or cancelled yet,
+    // including the ones being dequeued and the ones held by the app.
+    uint32_t window_dequeued_ = 0;
+    uint32_t dequeue_limit_;
+    VkResult dequeue_result_ = VK_SUCCESS;
+    std::thread thread_;
+    std::thread dequeue_thread_;
+};
+
 struct Swapchain {
     Swapchain(Surface& surface_,
               uint32_t num_images_,
@@ -339,6 +423,9 @@ struct Swapchain {
     } images[android::BufferQueueDefs::NUM_BUFFER_SLOTS];
 
     std::vector<TimingInfo> timing;
+
+    // Only set when buffers are queued from a dedicated thread.
+    std::unique_ptr<PresentThread> present_thread;
 };
 
 VkSwapchainKHR HandleFromSwapchain(Swapchain* swapchain) {
@@ -424,6 +511,9 @@ void ReleaseSwapchainImage(VkDevice device,
 void OrphanSwapchain(VkDevice device, Swapchain* swapchain) {
     if (swapchain->surface.swapchain_handle != HandleFromSwapchain(swapchain))
         return;
+    // Lets the presents in flight reach the window, and gives back the
+    // buffers dequeued ahead of time.
+    swapchain->present_thread.reset();
     for (uint32_t i = 0; i < swapchain->num_images; i++) {
         if (!swapchain->images[i].dequeued) {
             ReleaseSwapchainImage(device, swapchain->shared, nullptr, -1,
@@ -1389,6 +1479,10 @@ static void DestroySwapchainInternal(VkDevice device,
         return;
     }
 
+    // Let the presents still in flight reach the window before the buffers
+    // are released.
+    swapchain->present_thread.reset();
+
     bool active = swapchain->surface.swapchain_handle == swapchain_handle;
     ANativeWindow* window = active ? swapchain->surface.window.get() : nullptr;
 
@@ -2150,6 +2244,26 @@ VkResult CreateSwapchainKHR(VkDevice device,
     android::GraphicsEnv::getInstance().setTargetStats(
         android::GpuStatsInfo::Stats::CREATED_VULKAN_SWAPCHAIN);
 
+    // Shared buffers are dequeued again right after being queued, which has
+    // to stay on the presenting thread.
+    if (flags::swapchain_async_present() && !swapchain->shared) {
+        uint32_t max_dequeued = 0;
+        if (flags::swapchain_pre_dequeue()) {
+            // The app's acquire timeouts are waited for on the pre-dequeued
+            // buffers instead.
+            err = window->perform(window, NATIVE_WINDOW_SET_DEQUEUE_TIMEOUT,
+                                  kPreDequeueTimeout);
+            if (err == android::OK) {
+                max_dequeued = buffer_count - min_undequeued_buffers;
+            } else {
+                ALOGW("window->perform(SET_DEQUEUE_TIMEOUT) failed: %s (%d)",
+                      strerror(-err), err);
+            }
+        }
+        swapchain->present_thread =
+            std::make_unique<PresentThread>(window, max_dequeued);
+    }
+
     surface.used_by_swapchain = true;
     surface.swapchain_handle = HandleFromSwapchain(swapchain);
     *swapchain_handle = surface.swapchain_handle;
@@ -2220,9 +2334,23 @@ VkResult AcquireNextImageKHR(VkDevice device,
         return result;
     }
 
+    PresentThread* pre_dequeue =
+        swapchain.present_thread && swapchain.present_thread->PreDequeues()
+            ? swapchain.present_thread.get()
+            : nullptr;
+    auto cancel_buffer = [window, pre_dequeue](ANativeWindowBuffer* buffer,
+                                               int fence) {
+        if (pre_dequeue) {
+            pre_dequeue->Cancel(buffer, fence);
+        } else {
+            window->cancelBuffer(window, buffer, fence);
+        }
+    };
+
     const nsecs_t acquire_next_image_timeout =
         timeout > (uint64_t)std::numeric_limits<nsecs_t>::max() ? -1 : timeout;
-    if (acquire_next_image_timeout != swapchain.acquire_next_image_timeout) {
+    if (!pre_dequeue &&
+        acquire_next_image_timeout != swapchain.acquire_next_image_timeout) {
         // Cache the timeout to avoid the duplicate binder cost.
         err = window->perform(window, NATIVE_WINDOW_SET_DEQUEUE_TIMEOUT,
                               acquire_next_image_timeout);
@@ -2236,13 +2364,19 @@ VkResult AcquireNextImageKHR(VkDevice device,
 
     ANativeWindowBuffer* buffer;
     int fence_fd;
-    err = window->dequeueBuffer(window, &buffer, &fence_fd);
-    if (err == android::TIMED_OUT || err == android::INVALID_OPERATION) {
-        ALOGW("dequeueBuffer timed out: %s (%d)", strerror(-err), err);
-        return timeout ? VK_TIMEOUT : VK_NOT_READY;
-    } else if (err != android::OK) {
-        ALOGE("dequeueBuffer failed: %s (%d)", strerror(-err), err);
-        return VK_ERROR_SURFACE_LOST_KHR;
+    if (pre_dequeue) {
+        result = pre_dequeue->Dequeue(timeout, &buffer, &fence_fd);
+        if (result != VK_SUCCESS)
+            return result;
+    } else {
+        err = window->dequeueBuffer(window, &buffer, &fence_fd);
+        if (err == android::TIMED_OUT || err == android::INVALID_OPERATION) {
+            ALOGW("dequeueBuffer timed out: %s (%d)", strerror(-err), err);
+            return timeout ? VK_TIMEOUT : VK_NOT_READY;
+        } else if (err != android::OK) {
+            ALOGE("dequeueBuffer failed: %s (%d)", strerror(-err), err);
+            return VK_ERROR_SURFACE_LOST_KHR;
+        }
     }
 
     uint32_t idx;
@@ -2301,7 +2435,7 @@ VkResult AcquireNextImageKHR(VkDevice device,
                     // unrecoverably wrong with the swapchain and its images. Cancel
                     // the buffer and declare the swapchain broken.
                     ALOGE("failed to do deferred gralloc buffer bind");
-                    window->cancelBuffer(window, buffer, fence_fd);
+                    cancel_buffer(buffer, fence_fd);
                     return VK_ERROR_OUT_OF_DATE_KHR;
                 }
 
@@ -2318,7 +2452,7 @@ VkResult AcquireNextImageKHR(VkDevice device,
     // happens, just declare the swapchain to be broken and the app will recreate it.
     if (idx == swapchain.num_images) {
         ALOGE("dequeueBuffer returned unrecognized buffer");
-        window->cancelBuffer(window, buffer, fence_fd);
+        cancel_buffer(buffer, fence_fd);
         return VK_ERROR_OUT_OF_DATE_KHR;
     }
 
@@ -2342,7 +2476,7 @@ VkResult AcquireNextImageKHR(VkDevice device,
         // number between the time the driver closes it and the time we close
         // it. We must assume one of: the driver *always* closes it even on
         // failure, or *never* closes it on failure.
-        window->cancelBuffer(window, buffer, fence_fd);
+        cancel_buffer(buffer, fence_fd);
         swapchain.images[idx].dequeued = false;
         swapchain.images[idx].dequeue_fence = -1;
         return result;
@@ -2384,7 +2518,8 @@ static VkResult WorstPresentResult(VkResult a, VkResult b) {
 }
 
 // KHR_incremental_present aspect of QueuePresentKHR
-static void SetSwapchainSurfaceDamage(ANativeWindow *window, const VkPresentRegionKHR *pRegion) {
+static std::vector<android_native_rect_t> GetSwapchainSurfaceDamage(
+        const VkPresentRegionKHR *pRegion) {
     std::vector<android_native_rect_t> rects(pRegion->rectangleCount);
     for (auto i = 0u; i < pRegion->rectangleCount; i++) {
         auto const& rect = pRegion->pRectangles[i];
@@ -2398,9 +2533,190 @@ static void SetSwapchainSurfaceDamage(ANativeWindow *window, const VkPresentRegi
         rects[i].right = rect.offset.x + rect.extent.width;
         rects[i].top = rect.offset.y + rect.extent.height;
     }
+    return rects;
+}
+
+static void SetSwapchainSurfaceDamage(ANativeWindow *window, const VkPresentRegionKHR *pRegion) {
+    std::vector<android_native_rect_t> rects = GetSwapchainSurfaceDamage(pRegion);
     native_window_set_surface_damage(window, rects.data(), rects.size());
 }
 
+PresentThread::PresentThread(ANativeWindow* window, uint32_t max_dequeued)
+    : window_(window),
+      max_dequeued_(max_dequeued),
+      dequeue_limit_(max_dequeued),
+      thread_(&PresentThread::Run, this) {
+    if (PreDequeues())
+        dequeue_thread_ = std::thread(&PresentThread::RunDequeue, this);
+}
+
+PresentThread::~PresentThread() {
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        stopping_ = true;
+    }
+    work_available_.notify_one();
+    dequeue_needed_.notify_one();
+    thread_.join();
+    if (dequeue_thread_.joinable())
+        dequeue_thread_.join();
+
+    for (const DequeuedBuffer& dequeued : dequeued_buffers_) {
+        window_->cancelBuffer(window_.get(), dequeued.buffer, dequeued.fence);
+    }
+}
+
+VkResult PresentThread::Dequeue(uint64_t timeout,
+                                ANativeWindowBuffer** buffer,
+                                int* fence) {
+    ATRACE_CALL();
+    std::unique_lock<std::mutex> lock(mutex_);
+    auto ready = [this] {
+        return !dequeued_buffers_.empty() || dequeue_result_ != VK_SUCCESS;
+    };
+    if (timeout > (uint64_t)std::numeric_limits<int64_t>::max()) {
+        buffer_available_.wait(lock, ready);
+    } else if (!buffer_available_.wait_for(
+                   lock, std::chrono::nanoseconds(timeout), ready)) {
+        return timeout ? VK_TIMEOUT : VK_NOT_READY;
+    }
+    if (dequeued_buffers_.empty())
+        return dequeue_result_;
+
+    *buffer = dequeued_buffers_.front().buffer;
+    *fence = dequeued_buffers_.front().fence;
+    dequeued_buffers_.pop_front();
+    return VK_SUCCESS;
+}
+
+void PresentThread::Cancel(ANativeWindowBuffer* buffer, int fence) {
+    window_->cancelBuffer(window_.get(), buffer, fence);
+    BufferReturned();
+}
+
+void PresentThread::BufferReturned() {
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        window_dequeued_--;
+    }
+    dequeue_needed_.notify_one();
+}
+
+void PresentThread::Queue(const android::sp<ANativeWindowBuffer>& buffer,
+                          int fence,
+                          const VkPresentRegionKHR* region) {
+    Present present{buffer, fence, region != nullptr, {}};
+    if (region) {
+        present.damage = GetSwapchainSurfaceDamage(region);
+    }
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        presents_.push_back(std::move(present));
+    }
+    work_available_.notify_one();
+}
+
+VkResult PresentThread::TakeResult() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    VkResult result = result_;
+    result_ = VK_SUCCESS;
+    return result;
+}
+
+VkResult PresentThread::WaitIdle() {
+    ATRACE_CALL();
+    std::unique_lock<std::mutex> lock(mutex_);
+    idle_.wait(lock, [this] { return presents_.empty() && !busy_; });
+    VkResult result = result_;
+    result_ = VK_SUCCESS;
+    return result;
+}
+
+void PresentThread::Run() {
+    std::unique_lock<std::mutex> lock(mutex_);
+    while (true) {
+        work_available_.wait(
+            lock, [this] { return stopping_ || !presents_.empty(); });
+        // Presents still queued when stopping are queued to the window first.
+        if (presents_.empty())
+            return;
+
+        Present present = std::move(presents_.front());
+        presents_.pop_front();
+        busy_ = true;
+        lock.unlock();
+
+        ATRACE_BEGIN("queueBuffer");
+        if (present.has_damage) {
+            native_window_set_surface_damage(window_.get(),
+                                             present.damage.data(),
+                                             present.damage.size());
+        }
+        int err = window_->queueBuffer(window_.get(), present.buffer.get(),
+                                       present.fence);
+        ATRACE_END();
+        // queueBuffer always closes fence, even on error
+        if (err != android::OK) {
+            ALOGE("queueBuffer failed: %s (%d)", strerror(-err), err);
+        }
+
+        lock.lock();
+        if (err != android::OK) {
+            result_ = WorstPresentResult(result_, VK_ERROR_SURFACE_LOST_KHR);
+        }
+        busy_ = false;
+        if (presents_.empty())
+            idle_.notify_all();
+        if (PreDequeues()) {
+            window_dequeued_--;
+            dequeue_needed_.notify_one();
+        }
+    }
+}
+
+void PresentThread::RunDequeue() {
+    std::unique_lock<std::mutex> lock(mutex_);
+    while (true) {
+        // Dequeueing more buffers than the window allows would fail, or
+        // block until the app presents one, so wait for one to come back.
+        dequeue_needed_.wait(lock, [this] {
+            return stopping_ || (window_dequeued_ < dequeue_limit_ &&
+                                 dequeue_result_ == VK_SUCCESS);
+        });
+        if (stopping_)
+            return;
+
+        window_dequeued_++;
+        lock.unlock();
+
+        // The window's dequeue timeout is kept short in this mode, so that
+        // a consumer that stops releasing buffers does not keep the thread
+        // from stopping.
+        ATRACE_BEGIN("dequeueBuffer");
+        ANativeWindowBuffer* buffer;
+        int fence_fd;
+        int err = window_->dequeueBuffer(window_.get(), &buffer, &fence_fd);
+        ATRACE_END();
+
+        lock.lock();
+        if (err == android::OK) {
+            dequeued_buffers_.push_back({buffer, fence_fd});
+            buffer_available_.notify_one();
+            continue;
+        }
+
+        window_dequeued_--;
+        if (err == android::INVALID_OPERATION && window_dequeued_ > 0) {
+            // The window allows fewer dequeued buffers than expected.
+            dequeue_limit_ = window_dequeued_;
+        } else if (err != android::TIMED_OUT) {
+            ALOGE("dequeueBuffer failed: %s (%d)", strerror(-err), err);
+            dequeue_result_ = VK_ERROR_SURFACE_LOST_KHR;
+            buffer_available_.notify_all();
+        }
+    }
+}
+
 // GOOGLE_display_timing aspect of QueuePresentKHR
 static void SetSwapchainFrameTimestamp(Swapchain &swapchain, const VkPresentTimeGOOGLE *pTime) {
     ANativeWindow *window = swapchain.surface.window.get();
@@ -2513,30 +2829,61 @@ static VkResult PresentOneSwapchain(
                 }
             }
 
-            if (pRegion) {
-                SetSwapchainSurfaceDamage(window, pRegion);
-            }
-            if (pTime) {
-                SetSwapchainFrameTimestamp(swapchain, pTime);
-            }
-            if (pPresentMode) {
-                if (!SetSwapchainPresentMode(window, *pPresentMode))
-                    swapchain_result = WorstPresentResult(swapchain_result,
-                        VK_ERROR_SURFACE_LOST_KHR);
+            // Frame timestamps and present mode changes apply to the next
+            // buffer queued, so those presents are queued from here, once
+            // the present thread is done with the earlier ones.
+            bool async = swapchain.present_thread && !pTime && !pPresentMode;
+            VkResult queued_result = VK_SUCCESS;
+            if (swapchain.present_thread) {
+                queued_result = async
+                                    ? swapchain.present_thread->TakeResult()
+                                    : swapchain.present_thread->WaitIdle();
             }
 
-            err = window->queueBuffer(window, img.buffer.get(), fence);
-            // queueBuffer always closes fence, even on error
-            if (err != android::OK) {
-                ALOGE("queueBuffer failed: %s (%d)", strerror(-err), err);
-                swapchain_result = WorstPresentResult(
-                    swapchain_result, VK_ERROR_SURFACE_LOST_KHR);
-            } else {
+            if (queued_result != VK_SUCCESS) {
+                // An earlier present could not be queued, so the surface is
+                // lost and this one is dropped.
+                swapchain_result =
+                    WorstPresentResult(swapchain_result, queued_result);
+                if (fence >= 0)
+                    close(fence);
+            } else if (async) {
+                // The present thread takes ownership of fence
+                swapchain.present_thread->Queue(img.buffer, fence, pRegion);
                 if (img.dequeue_fence >= 0) {
                     close(img.dequeue_fence);
                     img.dequeue_fence = -1;
                 }
                 img.dequeued = false;
+            } else {
+                if (pRegion) {
+                    SetSwapchainSurfaceDamage(window, pRegion);
+                }
+                if (pTime) {
+                    SetSwapchainFrameTimestamp(swapchain, pTime);
+                }
+                if (pPresentMode) {
+                    if (!SetSwapchainPresentMode(window, *pPresentMode))
+                        swapchain_result = WorstPresentResult(swapchain_result,
+                            VK_ERROR_SURFACE_LOST_KHR);
+                }
+
+                err = window->queueBuffer(window, img.buffer.get(), fence);
+                if (swapchain.present_thread &&
+                    swapchain.present_thread->PreDequeues())
+                    swapchain.present_thread->BufferReturned();
+                // queueBuffer always closes fence, even on error
+                if (err != android::OK) {
+                    ALOGE("queueBuffer failed: %s (%d)", strerror(-err), err);
+                    swapchain_result = WorstPresentResult(
+                        swapchain_result, VK_ERROR_SURFACE_LOST_KHR);
+                } else {
+                    if (img.dequeue_fence >= 0) {
+                        close(img.dequeue_fence);
+                        img.dequeue_fence = -1;
+                    }
+                    img.dequeued = false;
+                }
             }
 
             // If the swapchain is in shared mode, immediately dequeue the
@@ -2764,6 +3111,10 @@ VKAPI_ATTR void SetHdrMetadataEXT(
 
         if (swapchain->surface.swapchain_handle != pSwapchains[idx]) continue;
 
+        // The metadata applies to the next buffer queued
+        if (swapchain->present_thread)
+            swapchain->present_thread->WaitIdle();
+
         ANativeWindow* window = swapchain->surface.window.get();
 
         VkHdrMetadataEXT vulkanMetadata = pHdrMetadataEXTs[idx];
@@ -2909,7 +3260,11 @@ VkResult ReleaseSwapchainImagesEXT(VkDevice /*device*/,
 
     for (uint32_t i = 0; i < pReleaseInfo->imageIndexCount; i++) {
         Swapchain::Image& img = swapchain.images[pReleaseInfo->pImageIndices[i]];
-        window->cancelBuffer(window, img.buffer.get(), img.dequeue_fence);
+        if (swapchain.present_thread && swapchain.present_thread->PreDequeues()) {
+            swapchain.present_thread->Cancel(img.buffer.get(), img.dequeue_fence);
+        } else {
+            window->cancelBuffer(window, img.buffer.get(), img.dequeue_fence);
+        }
 
         // cancelBuffer has taken ownership of the dequeue fence
         img.dequeue_fence = -1;